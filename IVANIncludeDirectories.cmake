@@ -2,6 +2,14 @@
 # Include directories for other projects installed on the system.
 SET( IVAN_INCLUDE_DIRS_SYSTEM "" )
 
+IF( IVAN_USE_MPI )
+  SET( IVAN_INCLUDE_DIRS_SYSTEM ${IVAN_INCLUDE_DIRS_SYSTEM} ${MPI_INCLUDE_PATH} )
+ENDIF( IVAN_USE_MPI )
+
+IF( IVAN_USE_GPU )
+  SET( IVAN_INCLUDE_DIRS_SYSTEM ${IVAN_INCLUDE_DIRS_SYSTEM} ${CUDA_INCLUDE_DIRS} )
+ENDIF( IVAN_USE_GPU )
+
 
 #-----------------------------------------------------------------------------
 # Include directories from the build tree.
@@ -15,6 +23,7 @@ SET( IVAN_INCLUDE_DIRS_BUILD_TREE
   ${IVAN_SOURCE_DIR}/Sources/Detection
   ${IVAN_SOURCE_DIR}/Sources/Experimental
   ${IVAN_SOURCE_DIR}/Sources/Extraction
+  ${IVAN_SOURCE_DIR}/Sources/IO
   ${IVAN_SOURCE_DIR}/Sources/ITK
   ${IVAN_SOURCE_DIR}/Sources/Modeling
   ${IVAN_SOURCE_DIR}/Sources/Quantification
@@ -41,6 +50,7 @@ SET( IVAN_INCLUDE_DIRS_INSTALL_TREE
   ${IVAN_INSTALL_INCLUDE_DIR}/Detection
   ${IVAN_INSTALL_INCLUDE_DIR}/Experimental
   ${IVAN_INSTALL_INCLUDE_DIR}/Extraction
+  ${IVAN_INSTALL_INCLUDE_DIR}/IO
   ${IVAN_INSTALL_INCLUDE_DIR}/ITK
   ${IVAN_INSTALL_INCLUDE_DIR}/Modeling
   ${IVAN_INSTALL_INCLUDE_DIR}/Quantification
@@ -0,0 +1,226 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanArenaAllocator.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: chunk-based allocator for graph nodes and sections
+// Date: 2012/11/05
+
+
+#include "ivanArenaAllocator.h"
+#include "ivanMacros.h"
+
+#include <new>
+
+
+namespace ivan
+{
+
+namespace
+{
+  /** Every thread has its own active arena, so activating one needs no lock and does not 
+    * affect the objects created by other threads. */
+  IVAN_THREAD_LOCAL ArenaAllocator  *activeArena = 0;
+  
+  /** Blocks are multiples of this, which is enough alignment for any member type. */
+  const size_t blockAlignment = 16;
+  
+  /** Objects are preceded by a header with their arena, padded to keep the alignment. */
+  const size_t objectHeaderSize = blockAlignment;
+  
+  inline size_t AlignSize( size_t size )
+    { return ( size + blockAlignment - 1 ) & ~( blockAlignment - 1 ); }
+}
+
+
+ArenaAllocator::ArenaAllocator() :
+  m_ChunkSize( 65536 ),
+  m_Next( 0 ),
+  m_End( 0 ),
+  m_NumberOfAllocations( 0 ),
+  m_NumberOfLiveAllocations( 0 ),
+  m_AllocatedBytes( 0 )
+{
+
+}
+
+
+ArenaAllocator::~ArenaAllocator()
+{
+  for( unsigned int i=0; i<m_Chunks.size(); ++i )
+    ::operator delete( m_Chunks[i] );
+}
+
+
+void * ArenaAllocator::Allocate( size_t size )
+{
+  size = AlignSize( size );
+  
+  m_Mutex.Lock();
+  
+  char *block;
+  
+  if( size > m_ChunkSize )
+  {
+    // Dedicated chunk, keeping the current one for further allocations
+    block = static_cast<char*>( ::operator new( size ) );
+    m_Chunks.push_back( block );
+  }
+  else
+  {
+    if( m_Next == 0 || (size_t)( m_End - m_Next ) < size )
+    {
+      m_Next = static_cast<char*>( ::operator new( AlignSize( m_ChunkSize ) ) );
+      m_End = m_Next + AlignSize( m_ChunkSize );
+      m_Chunks.push_back( m_Next );
+    }
+    
+    block = m_Next;
+    m_Next += size;
+  }
+  
+  ++m_NumberOfAllocations;
+  ++m_NumberOfLiveAllocations;
+  m_AllocatedBytes += size;
+  
+  m_Mutex.Unlock();
+  
+  return block;
+}
+
+
+void ArenaAllocator::Deallocate( void * p )
+{
+  if( !p )
+    return;
+    
+  m_Mutex.Lock();
+  --m_NumberOfLiveAllocations;
+  m_Mutex.Unlock();
+}
+
+
+unsigned long ArenaAllocator::GetNumberOfChunks() const
+{
+  m_Mutex.Lock();
+  const unsigned long numberOfChunks = m_Chunks.size();
+  m_Mutex.Unlock();
+  
+  return numberOfChunks;
+}
+
+
+unsigned long ArenaAllocator::GetNumberOfAllocations() const
+{
+  m_Mutex.Lock();
+  const unsigned long numberOfAllocations = m_NumberOfAllocations;
+  m_Mutex.Unlock();
+  
+  return numberOfAllocations;
+}
+
+
+unsigned long ArenaAllocator::GetNumberOfLiveAllocations() const
+{
+  m_Mutex.Lock();
+  const unsigned long numberOfLiveAllocations = m_NumberOfLiveAllocations;
+  m_Mutex.Unlock();
+  
+  return numberOfLiveAllocations;
+}
+
+
+size_t ArenaAllocator::GetAllocatedBytes() const
+{
+  m_Mutex.Lock();
+  const size_t allocatedBytes = m_AllocatedBytes;
+  m_Mutex.Unlock();
+  
+  return allocatedBytes;
+}
+
+
+void ArenaAllocator::SetActiveArena( ArenaAllocator * arena )
+{
+  activeArena = arena;
+}
+
+
+ArenaAllocator * ArenaAllocator::GetActiveArena()
+{
+  return activeArena;
+}
+
+
+void * ArenaAllocator::AllocateObject( size_t size )
+{
+  ArenaAllocator *arena = activeArena;
+  
+  char *block;
+  
+  if( arena )
+  {
+    // Only this thread can deactivate the arena, so it is still alive here
+    arena->Register();
+    block = static_cast<char*>( arena->Allocate( objectHeaderSize + size ) );
+  }
+  else
+    block = static_cast<char*>( ::operator new( objectHeaderSize + size ) );
+    
+  *reinterpret_cast<ArenaAllocator**>( block ) = arena;
+  
+  return block + objectHeaderSize;
+}
+
+
+void ArenaAllocator::DeallocateObject( void * p )
+{
+  if( !p )
+    return;
+    
+  char *block = static_cast<char*>( p ) - objectHeaderSize;
+  ArenaAllocator *arena = *reinterpret_cast<ArenaAllocator**>( block );
+  
+  if( arena )
+  {
+    arena->Deallocate( block );
+    arena->UnRegister(); // the chunks are freed with the last object
+  }
+  else
+    ::operator delete( block );
+}
+
+
+void ArenaAllocator::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "ChunkSize: " << m_ChunkSize << std::endl;
+  os << indent << "NumberOfChunks: " << this->GetNumberOfChunks() << std::endl;
+  os << indent << "NumberOfAllocations: " << this->GetNumberOfAllocations() << std::endl;
+  os << indent << "NumberOfLiveAllocations: " << this->GetNumberOfLiveAllocations() << std::endl;
+  os << indent << "AllocatedBytes: " << this->GetAllocatedBytes() << std::endl;
+}
+
+} // end namespace ivan
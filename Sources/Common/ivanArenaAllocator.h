@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanArenaAllocator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: chunk-based allocator for graph nodes and sections
+// Date: 2012/11/05
+
+#ifndef __ivanArenaAllocator_h
+#define __ivanArenaAllocator_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+#include <cstddef>
+
+
+/** Class-specific operator new and delete that allocate from the active ArenaAllocator, or
+  * from the heap if there is none. Subclasses inherit the allocation policy. */
+#define ivanArenaAllocationMacro() \
+  static void * operator new( size_t size ) \
+    { return ::ivan::ArenaAllocator::AllocateObject( size ); } \
+  static void operator delete( void * p ) \
+    { ::ivan::ArenaAllocator::DeallocateObject( p ); }
+
+
+namespace ivan
+{
+  
+/** \class ArenaAllocator
+ *  \brief Chunk-based allocator for objects with a common lifetime.
+ *
+ * The arena takes memory from chunks of ChunkSize bytes, so an allocation is a pointer bump.
+ * Memory is not reused when objects are deleted. All the chunks are freed at once when the
+ * arena is destroyed.
+ *
+ * Classes opt in with ivanArenaAllocationMacro(). Objects of these classes created while an
+ * arena is active, for example with a Scope, take their memory from that arena. Every such 
+ * object holds a reference to its arena, so the arena outlives the objects taken from it even
+ * when they are still referenced elsewhere. Objects created while no arena is active use 
+ * the heap, without any locking. The active arena is set per thread, so objects created by 
+ * other threads use the heap unless those threads activate an arena too. The caller must keep
+ * the active arena alive while it is active, which a Scope does. Allocation from an arena 
+ * shared by several threads is thread safe.
+ *
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT ArenaAllocator : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ArenaAllocator                  Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Makes an arena active during the lifetime of the scope, restoring the previous one 
+    * afterwards. */
+  class Scope
+  {
+  public:
+    Scope( ArenaAllocator * arena )
+      {
+        m_PreviousArena = ArenaAllocator::GetActiveArena();
+        ArenaAllocator::SetActiveArena( arena );
+      }
+    ~Scope()
+      { ArenaAllocator::SetActiveArena( m_PreviousArena ); }
+  
+  private:
+    Scope(const Scope&); //purposely not implemented
+    void operator=(const Scope&); //purposely not implemented
+    
+    ArenaAllocator::Pointer  m_PreviousArena;
+  };
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ArenaAllocator, itk::Object );
+  
+  /** Size of the chunks. Larger blocks get a chunk of their own. Default is 64 KB. */
+  itkSetMacro( ChunkSize, size_t );
+  itkGetConstMacro( ChunkSize, size_t );
+  
+  /** Get a block of the given size, aligned for any type. */
+  void * Allocate( size_t size );
+  
+  /** Account for a block being released. The memory is only freed with the arena. */
+  void Deallocate( void * p );
+  
+  unsigned long GetNumberOfChunks() const;
+  unsigned long GetNumberOfAllocations() const;
+  unsigned long GetNumberOfLiveAllocations() const;
+  size_t GetAllocatedBytes() const;
+  
+  /** Arena used by ivanArenaAllocationMacro() in the calling thread, or NULL to use the heap. */
+  static void SetActiveArena( ArenaAllocator * arena );
+  static ArenaAllocator * GetActiveArena();
+  
+  /** Allocation functions used by ivanArenaAllocationMacro(). */
+  static void * AllocateObject( size_t size );
+  static void DeallocateObject( void * p );
+		
+protected:
+
+  ArenaAllocator();
+  ~ArenaAllocator();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  ArenaAllocator(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  size_t                    m_ChunkSize;
+  
+  std::vector<char*>        m_Chunks;
+  
+  /** Free space in the current chunk. */
+  char                      *m_Next;
+  char                      *m_End;
+  
+  unsigned long             m_NumberOfAllocations;
+  unsigned long             m_NumberOfLiveAllocations;
+  size_t                    m_AllocatedBytes;
+  
+  mutable itk::SimpleFastMutexLock  m_Mutex;
+};
+
+} // end namespace ivan
+
+#endif
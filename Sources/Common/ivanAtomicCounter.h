@@ -0,0 +1,95 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAtomicCounter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: counter incremented atomically by several threads.
+// Date: 2012/11/05
+
+#ifndef __ivanAtomicCounter_h
+#define __ivanAtomicCounter_h
+
+#include "itkSimpleFastMutexLock.h"
+
+#if defined( _MSC_VER )
+  #include <intrin.h>
+#endif
+
+namespace ivan
+{
+/**
+ * \class AtomicCounter
+ * \brief Counter that several threads may increment concurrently without a lock.
+ *
+ * FetchAndAdd() returns the value before the addition, so each thread gets distinct values,
+ * for instance identifiers allocated in parallel. It is a single atomic instruction on GCC, 
+ * Clang and Visual C++, and falls back to a mutex on other compilers. Values are long integers.
+ */
+class AtomicCounter
+{
+public:
+
+  typedef long    ValueType;
+
+  explicit AtomicCounter( ValueType value = 0 ) : m_Value( value ) {}
+  
+  /** Add to the counter and return its previous value. */
+  ValueType FetchAndAdd( ValueType increment )
+    {
+#if defined( __GNUC__ )
+      return __sync_fetch_and_add( &m_Value, increment );
+#elif defined( _MSC_VER )
+      return _InterlockedExchangeAdd( &m_Value, increment );
+#else
+      m_Mutex.Lock();
+      const ValueType value = m_Value;
+      m_Value += increment;
+      m_Mutex.Unlock();
+      return value;
+#endif
+    }
+  
+  /** Current value. Not synchronized with concurrent additions. */
+  ValueType GetValue() const { return m_Value; }
+  
+  /** Set the value, when no other thread uses the counter. */
+  void SetValue( ValueType value ) { m_Value = value; }
+  
+private:
+
+  AtomicCounter( const AtomicCounter & ); // purposely not implemented
+  void operator=( const AtomicCounter & ); // purposely not implemented
+
+private:
+
+  volatile ValueType         m_Value;
+  
+#if !defined( __GNUC__ ) && !defined( _MSC_VER )
+  itk::SimpleFastMutexLock   m_Mutex;
+#endif
+};
+
+} // end namespace ivan
+
+#endif
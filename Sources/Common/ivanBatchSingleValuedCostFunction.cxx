@@ -0,0 +1,95 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBatchSingleValuedCostFunction.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: single-valued cost function that evaluates sets of parameters concurrently
+// Date: 2012/11/05
+
+#include "ivanBatchSingleValuedCostFunction.h"
+
+namespace ivan
+{
+
+BatchSingleValuedCostFunction::BatchSingleValuedCostFunction() :
+  m_NumberOfThreads( 1 )
+{
+  m_MultiThreader = itk::MultiThreader::New();
+}
+
+
+void
+BatchSingleValuedCostFunction::GetValues( const ParametersContainerType & parameters, 
+  MeasureContainerType & values ) const
+{
+  values.resize( parameters.size() );
+  
+  unsigned int numberOfThreads = this->m_NumberOfThreads;
+  
+  if( numberOfThreads > parameters.size() )
+    numberOfThreads = parameters.size();
+  
+  if( numberOfThreads <= 1 )
+  {
+    for( unsigned int i=0; i < parameters.size(); ++i )
+      values[i] = this->GetValue( parameters[i] );
+    
+    return;
+  }
+  
+  BatchStruct batch;
+  batch.CostFunction = this;
+  batch.Parameters = &parameters;
+  batch.Values = &values;
+  
+  this->m_MultiThreader->SetNumberOfThreads( numberOfThreads );
+  this->m_MultiThreader->SetSingleMethod( this->GetValuesThreaderCallback, &batch );
+  this->m_MultiThreader->SingleMethodExecute();
+}
+
+
+ITK_THREAD_RETURN_TYPE
+BatchSingleValuedCostFunction::GetValuesThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const unsigned int numberOfThreads = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  
+  BatchStruct *batch = (BatchStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  for( unsigned int i = threadId; i < batch->Parameters->size(); i += numberOfThreads )
+    (*batch->Values)[i] = batch->CostFunction->GetValue( (*batch->Parameters)[i] );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+void
+BatchSingleValuedCostFunction::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+}
+
+} // end namespace ivan
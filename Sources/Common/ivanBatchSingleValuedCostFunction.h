@@ -0,0 +1,116 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBatchSingleValuedCostFunction.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: single-valued cost function that evaluates sets of parameters concurrently
+// Date: 2012/11/05
+
+#ifndef __ivanBatchSingleValuedCostFunction_h
+#define __ivanBatchSingleValuedCostFunction_h
+
+#include "itkSingleValuedCostFunction.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+/**
+ * \class BatchSingleValuedCostFunction
+ * \brief Single-valued cost function that can evaluate a set of independent parameters at once.
+ *
+ * Optimizers such as simplex or pattern search evaluate several candidates per iteration that do 
+ * not depend on each other. GetValues() evaluates all of them, splitting the set among 
+ * NumberOfThreads threads, so GetValue() must be safe to call concurrently when more than one 
+ * thread is used. The default is a single thread, in which case the values are computed serially 
+ * in the calling thread.
+ *
+ * \sa ParallelPatternSearchOptimizer
+ */
+class ITK_EXPORT BatchSingleValuedCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BatchSingleValuedCostFunction   Self;
+  typedef itk::SingleValuedCostFunction   Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BatchSingleValuedCostFunction, itk::SingleValuedCostFunction );
+  
+  typedef Superclass::ParametersType      ParametersType;
+  typedef Superclass::MeasureType         MeasureType;
+  typedef Superclass::DerivativeType      DerivativeType;
+  
+  typedef std::vector<ParametersType>     ParametersContainerType;
+  typedef std::vector<MeasureType>        MeasureContainerType;
+  
+public:
+  
+  /** Evaluate the cost function for every set of parameters. The values are returned in the 
+    * same order. */
+  virtual void GetValues( const ParametersContainerType & parameters, 
+    MeasureContainerType & values ) const;
+  
+  /** Set/Get the number of threads used by GetValues(). Default is 1. */
+  itkSetClampMacro( NumberOfThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+protected:
+
+  BatchSingleValuedCostFunction();
+  virtual ~BatchSingleValuedCostFunction() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE GetValuesThreaderCallback( void *arg );
+  
+  /** Data of one GetValues() call shared by the threads. */
+  struct BatchStruct
+  {
+    const Self                      *CostFunction;
+    const ParametersContainerType   *Parameters;
+    MeasureContainerType            *Values;
+  };
+  
+private:
+
+  BatchSingleValuedCostFunction( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  unsigned int                        m_NumberOfThreads;
+  
+  itk::MultiThreader::Pointer         m_MultiThreader;
+};
+
+} // end namespace ivan
+
+#endif
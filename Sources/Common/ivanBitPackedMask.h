@@ -0,0 +1,235 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBitPackedMask.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: mask stored with one bit per pixel
+// Date: 2012/11/05
+
+#ifndef __ivanBitPackedMask_h
+#define __ivanBitPackedMask_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+
+#include "vxl_config.h"
+
+#include "ivanTaskPool.h"
+
+#include <vector>
+
+namespace ivan
+{
+/**
+ * \class BitPackedMask
+ * \brief Mask of the pixels of a region stored with one bit per pixel.
+ *
+ * Masks stored as images take the bytes of their pixel type for each pixel (often those of
+ * the input, short or float), although only one bit is used. This mask packs the pixels of
+ * each line along the first dimension in 64 bit words, and each line starts a new word. A mask 
+ * of a 512^3 image takes 16 MB instead of 256 MB of short pixels, and is read in far fewer 
+ * cache lines.
+ *
+ * GetRunsInRegion() builds the runs of consecutive mask pixels of a region a word at a time,
+ * so that 64 pixels outside the mask (or inside) are passed with a single test. 
+ * PackNonZeroPixels() packs the pixels with non-zero value of an image, such as a mask image
+ * or the input image of a filter that skips zero pixels, with the threads of the TaskPool.
+ * Since the lines do not share words, each thread packs whole lines.
+ *
+ * GetPixel() and SetPixel() do not check that the index is inside the region. SetPixel() is not 
+ * thread-safe for pixels of the same word.
+ *
+ * \sa MaskRunLengthEncoding
+ */
+template <unsigned int VDimension>
+class ITK_EXPORT BitPackedMask : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BitPackedMask                   Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BitPackedMask, Object );
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VDimension );
+  
+  typedef itk::ImageRegion<VDimension>            RegionType;
+  typedef typename RegionType::IndexType          IndexType;
+  typedef typename RegionType::SizeType           SizeType;
+  
+  /** Word of 64 pixels of a line. Bit b of word w is the pixel w*64+b from the start of the line. */
+  typedef vxl_uint_64                             WordType;
+  typedef std::vector<WordType>                   WordContainerType;
+  
+  itkStaticConstMacro( WordBits, unsigned int, 64 );
+  
+  /** A run of consecutive mask pixels along the first dimension. */
+  struct RunType
+  {
+    IndexType       Index;
+    unsigned long   Length;
+  };
+  
+  typedef std::vector<RunType>                    RunContainerType;
+  
+public:
+  
+  /** Allocate the mask for the given region, with all the pixels outside the mask. */
+  void Allocate( const RegionType& region );
+  
+  /** Get the region of the mask. */
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  bool IsInside( const IndexType& index ) const
+    { return this->m_Region.IsInside( index ); }
+  
+  /** Returns true if the pixel, which must be inside the region, is inside the mask. */
+  bool GetPixel( const IndexType& index ) const
+    {
+      const unsigned long x = static_cast<unsigned long>( index[0] - this->m_Region.GetIndex()[0] );
+      return ( this->m_Words[this->ComputeLineOffset( index ) + x / WordBits] >> ( x % WordBits ) ) & 1;
+    }
+  
+  /** Set a pixel inside the region in or out of the mask. */
+  void SetPixel( const IndexType& index, bool value )
+    {
+      const unsigned long x = static_cast<unsigned long>( index[0] - this->m_Region.GetIndex()[0] );
+      WordType & word = this->m_Words[this->ComputeLineOffset( index ) + x / WordBits];
+      const WordType bit = static_cast<WordType>( 1 ) << ( x % WordBits );
+      
+      if( value )
+        word |= bit;
+      else
+        word &= ~bit;
+    }
+  
+  /** Get the words of the line of the given index, which must be inside the region. */
+  const WordType * GetLineWords( const IndexType& index ) const
+    { return &this->m_Words[this->ComputeLineOffset( index )]; }
+  WordType * GetLineWords( const IndexType& index )
+    { return &this->m_Words[this->ComputeLineOffset( index )]; }
+  
+  /** Get the number of words of each line. */
+  itkGetConstMacro( NumberOfWordsPerLine, unsigned long );
+  
+  /** Allocate the mask for the given region, which must be inside the buffered region of the 
+    * image, and set the pixels with non-zero value inside the mask. The lines are packed with 
+    * the given number of threads of the TaskPool. */
+  template <class TImage>
+  void PackNonZeroPixels( const TImage *image, const RegionType& region, unsigned int numberOfThreads = 1 );
+  
+  /** Get the number of pixels inside the mask. */
+  unsigned long GetNumberOfPixels() const;
+  
+  /** Returns true if there are no pixels inside the mask. */
+  bool IsEmpty() const;
+  
+  /** Get the runs of mask pixels of the given region, which must be inside the region of the 
+    * mask, in raster order. */
+  void GetRunsInRegion( const RegionType& region, RunContainerType& runs ) const;
+  
+  /** Memory taken by the words in bytes. */
+  unsigned long GetMemorySize() const
+    { return this->m_Words.capacity() * sizeof( WordType ); }
+  
+  /** Number of bits set in a word. */
+  static unsigned int CountBits( WordType word )
+    {
+      unsigned int count = 0;
+      
+      for( ; word; ++count )
+        word &= word - 1;
+      
+      return count;
+    }
+  
+protected:
+
+  BitPackedMask();
+  ~BitPackedMask() {};
+  
+  /** Offset of the first word of the line of the given index. */
+  unsigned long ComputeLineOffset( const IndexType& index ) const
+    {
+      unsigned long line = 0;
+      
+      for( unsigned int i = VDimension - 1; i > 0; --i )
+        line = line * this->m_Region.GetSize()[i] + static_cast<unsigned long>( index[i] - this->m_Region.GetIndex()[i] );
+      
+      return line * this->m_NumberOfWordsPerLine;
+    }
+  
+  /** Index of the first pixel of the given line of a region. */
+  static IndexType GetLineIndex( const RegionType& region, unsigned long line )
+    {
+      IndexType index = region.GetIndex();
+      
+      for( unsigned int i=1; i < VDimension; ++i )
+      {
+        index[i] += static_cast<typename IndexType::IndexValueType>( line % region.GetSize()[i] );
+        line /= region.GetSize()[i];
+      }
+      
+      return index;
+    }
+  
+  /** Loop of PackNonZeroPixels() over the lines. */
+  template <class TImage>
+  struct PackLinesFunction : public TaskPool::RangeFunction
+  {
+    Self            *Mask;
+    const TImage    *Image;
+    
+    virtual void Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int threadId );
+  };
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  BitPackedMask( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  RegionType            m_Region;
+  unsigned long         m_NumberOfWordsPerLine;
+  WordContainerType     m_Words;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanBitPackedMask.hxx"
+#endif
+
+#endif
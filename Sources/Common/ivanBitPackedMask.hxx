@@ -0,0 +1,262 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBitPackedMask.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: mask stored with one bit per pixel
+// Date: 2012/11/05
+
+#ifndef __ivanBitPackedMask_hxx
+#define __ivanBitPackedMask_hxx
+
+#include "ivanBitPackedMask.h"
+
+#include "itkNumericTraits.h"
+
+#include "vnl/vnl_math.h"
+
+namespace ivan
+{
+
+template <unsigned int VDimension>
+BitPackedMask<VDimension>
+::BitPackedMask() :
+  m_NumberOfWordsPerLine( 0 )
+{
+  this->m_Region.SetIndex( IndexType() );
+  
+  SizeType size;
+  size.Fill( 0 );
+  this->m_Region.SetSize( size );
+}
+
+
+template <unsigned int VDimension>
+void
+BitPackedMask<VDimension>
+::Allocate( const RegionType& region )
+{
+  this->m_Region = region;
+  this->m_NumberOfWordsPerLine = ( region.GetSize()[0] + WordBits - 1 ) / WordBits;
+  
+  unsigned long numberOfLines = 1;
+  
+  for( unsigned int i=1; i<VDimension; ++i )
+    numberOfLines *= region.GetSize()[i];
+  
+  this->m_Words.assign( numberOfLines * this->m_NumberOfWordsPerLine, 0 );
+  
+  this->Modified();
+}
+
+
+template <unsigned int VDimension>
+template <class TImage>
+void
+BitPackedMask<VDimension>
+::PackNonZeroPixels( const TImage *image, const RegionType& region, unsigned int numberOfThreads )
+{
+  this->Allocate( region );
+  
+  if( !region.GetNumberOfPixels() )
+    return;
+  
+  unsigned long numberOfLines = 1;
+  
+  for( unsigned int i=1; i<VDimension; ++i )
+    numberOfLines *= region.GetSize()[i];
+  
+  PackLinesFunction<TImage> function;
+  function.Mask = this;
+  function.Image = image;
+  
+  TaskPool::GetInstance()->ParallelFor( 0, numberOfLines, &function, 0, numberOfThreads );
+}
+
+
+template <unsigned int VDimension>
+template <class TImage>
+void
+BitPackedMask<VDimension>::PackLinesFunction<TImage>
+::Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int )
+{
+  typedef typename TImage::PixelType    PixelType;
+  
+  const PixelType zero = itk::NumericTraits<PixelType>::Zero;
+  const unsigned long lineSize = this->Mask->GetRegion().GetSize()[0];
+  
+  for( TaskPool::IndexValueType line = begin; line < end; ++line )
+  {
+    const IndexType index = GetLineIndex( this->Mask->GetRegion(), line );
+    
+    // The lines of the image are contiguous along the first dimension
+    const PixelType *pixels = 
+      this->Image->GetBufferPointer() + this->Image->ComputeOffset( index );
+    WordType *words = this->Mask->GetLineWords( index );
+    
+    for( unsigned long x = 0; x < lineSize; x += WordBits )
+    {
+      const unsigned long wordSize = vnl_math_min( static_cast<unsigned long>( WordBits ), lineSize - x );
+      WordType word = 0;
+      
+      for( unsigned long b = 0; b < wordSize; ++b )
+        word |= static_cast<WordType>( pixels[x + b] != zero ) << b;
+      
+      words[x / WordBits] = word;
+    }
+  }
+}
+
+
+template <unsigned int VDimension>
+unsigned long
+BitPackedMask<VDimension>
+::GetNumberOfPixels() const
+{
+  unsigned long numberOfPixels = 0;
+  
+  for( typename WordContainerType::const_iterator it = this->m_Words.begin(); it != this->m_Words.end(); ++it )
+    numberOfPixels += CountBits( *it );
+  
+  return numberOfPixels;
+}
+
+
+template <unsigned int VDimension>
+bool
+BitPackedMask<VDimension>
+::IsEmpty() const
+{
+  for( typename WordContainerType::const_iterator it = this->m_Words.begin(); it != this->m_Words.end(); ++it )
+  {
+    if( *it )
+      return false;
+  }
+  
+  return true;
+}
+
+
+template <unsigned int VDimension>
+void
+BitPackedMask<VDimension>
+::GetRunsInRegion( const RegionType& region, RunContainerType& runs ) const
+{
+  runs.clear();
+  
+  if( !region.GetNumberOfPixels() )
+    return;
+  
+  unsigned long numberOfLines = 1;
+  
+  for( unsigned int i=1; i<VDimension; ++i )
+    numberOfLines *= region.GetSize()[i];
+  
+  // Bits of the region along the first dimension, from the start of the lines of the mask
+  const unsigned long regionBegin = 
+    static_cast<unsigned long>( region.GetIndex()[0] - this->m_Region.GetIndex()[0] );
+  const unsigned long regionEnd = regionBegin + region.GetSize()[0];
+  
+  const unsigned long firstWord = regionBegin / WordBits;
+  const unsigned long lastWord = ( regionEnd - 1 ) / WordBits;
+  
+  const WordType allBits = ~static_cast<WordType>( 0 );
+  
+  RunType run;
+  bool insideRun;
+  
+  for( unsigned long line = 0; line < numberOfLines; ++line )
+  {
+    IndexType index = GetLineIndex( region, line );
+    const WordType *words = this->GetLineWords( index );
+    
+    insideRun = false;
+    
+    for( unsigned long w = firstWord; w <= lastWord; ++w )
+    {
+      WordType word = words[w];
+      
+      // Bits of the word inside the region
+      const unsigned long begin = ( w == firstWord ) ? regionBegin % WordBits : 0;
+      const unsigned long end = ( w == lastWord ) ? ( regionEnd - 1 ) % WordBits + 1 : WordBits;
+      
+      if( begin > 0 )
+        word &= allBits << begin;
+      if( end < WordBits )
+        word &= allBits >> ( WordBits - end );
+      
+      // Whole words out of the mask or inside a run are passed with a single test
+      if( !word && !insideRun )
+        continue;
+      
+      if( word == allBits && insideRun )
+      {
+        run.Length += WordBits;
+        continue;
+      }
+      
+      for( unsigned long b = begin; b < end; ++b )
+      {
+        if( ( word >> b ) & 1 )
+        {
+          if( !insideRun )
+          {
+            run.Index = index;
+            run.Index[0] = this->m_Region.GetIndex()[0] + 
+              static_cast<typename IndexType::IndexValueType>( w * WordBits + b );
+            run.Length = 0;
+            insideRun = true;
+          }
+          
+          ++run.Length;
+        }
+        else if( insideRun )
+        {
+          runs.push_back( run );
+          insideRun = false;
+        }
+      }
+    }
+    
+    if( insideRun )
+      runs.push_back( run );
+  }
+}
+
+
+template <unsigned int VDimension>
+void
+BitPackedMask<VDimension>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "NumberOfWordsPerLine: " << this->m_NumberOfWordsPerLine << std::endl;
+  os << indent << "NumberOfWords: " << this->m_Words.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,307 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBrickedImageBuffer.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: read-only copy of an image stored in bricks for scattered neighborhood access
+// Date: 2012/11/05
+
+#ifndef __ivanBrickedImageBuffer_h
+#define __ivanBrickedImageBuffer_h
+
+#include "ivanPixelRowConverter.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+#include "itkContinuousIndex.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace ivan
+{
+
+/**
+ * \class BrickedImageBuffer
+ * \brief Read-only copy of an image whose pixels are stored brick by brick.
+ *
+ * Trackers and section estimators evaluate image functions at scattered locations along a 
+ * curve, gathering a neighborhood around each. In the raster layout of itk::Image each row of 
+ * the neighborhood along the last directions is a different cache line, and usually a different
+ * memory page. This class copies the buffered region of an image in bricks of VBrickSize pixels 
+ * per dimension (8x8x8 by default), stored contiguously, so that a neighborhood of radius r 
+ * touches about (2r/VBrickSize+2)^N bricks, each a few contiguous pages, instead of (2r+1)^(N-1)
+ * scattered rows. Bricks at the upper boundary are padded with replicated pixels.
+ *
+ * GatherRegion() and Gather() copy a region to a buffer with the first direction varying 
+ * fastest, replicating pixels outside the buffered region, exactly as 
+ * NeighborhoodInnerProduct::GatherRegion() does for an itk::Image, and 
+ * EvaluateLinearAtContinuousIndex() interpolates linearly. The copy is shared by the functions
+ * that operate on the same image, see for instance DiscreteHessianGaussianImageFunction::SetBrickedImage().
+ *
+ * After CopyImage() the object is not modified, so it can be read from several threads.
+ * With a power of two VBrickSize the brick arithmetic reduces to shifts and masks.
+ *
+ * \sa NeighborhoodInnerProduct
+ * \sa SparseBlockedImage
+ */
+template <class TImage, unsigned int VBrickSize = 8>
+class ITK_EXPORT BrickedImageBuffer : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BrickedImageBuffer                   Self;
+  typedef itk::Object                          Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BrickedImageBuffer, Object );
+  
+  typedef TImage                                  ImageType;
+  typedef typename ImageType::PixelType           PixelType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, ImageType::ImageDimension );
+  itkStaticConstMacro( BrickSize, unsigned int, VBrickSize );
+  
+  typedef typename ImageType::IndexType           IndexType;
+  typedef typename ImageType::SizeType            SizeType;
+  typedef typename ImageType::RegionType          RegionType;
+  typedef typename IndexType::IndexValueType      IndexValueType;
+  
+  typedef itk::ContinuousIndex<double,
+    itkGetStaticConstMacro(ImageDimension)>       ContinuousIndexType;
+  
+public:
+  
+  /** Copy the buffered region of the image to the bricks. */
+  void CopyImage( const ImageType *image );
+  
+  /** Returns true if the bricks are a copy of the current contents of the image, that is if 
+    * the image is the one given to CopyImage() and it has not been modified since. */
+  bool IsCopyOf( const ImageType *image ) const;
+  
+  /** Release the bricks. */
+  void ReleaseBricks();
+  
+  /** Get the buffered region of the copied image. */
+  const RegionType & GetBufferedRegion() const
+    { return this->m_BufferedRegion; }
+  
+  /** Get the pixel at the given index, which must be inside the buffered region. */
+  const PixelType & GetPixel( const IndexType & index ) const
+    {
+      unsigned long offset = 0;
+      
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        const unsigned long position = static_cast<unsigned long>( index[d] - this->m_Start[d] );
+        offset += ( position / VBrickSize ) * this->m_BrickStrides[d] + 
+          ( position % VBrickSize ) * this->m_PixelStrides[d];
+      }
+      
+      return this->m_Pixels[offset];
+    }
+  
+  /** Copy the neighborhood of the given radius around index to the buffer, with the first 
+    * direction varying fastest. The buffer is resized if needed. */
+  template <class TOutput>
+  void Gather( const IndexType & index, const SizeType & radius, std::vector<TOutput> & buffer ) const
+    {
+      this->GatherRegion( this->GetNeighborhoodRegion( index, radius ), buffer );
+    }
+  
+  /** Same as above, copying to an array with as many elements as the neighborhood. */
+  template <class TOutput>
+  void Gather( const IndexType & index, const SizeType & radius, TOutput *out ) const
+    {
+      this->GatherRegion( this->GetNeighborhoodRegion( index, radius ), out );
+    }
+  
+  /** Copy the pixels of a region, which may extend beyond the buffered region, to the buffer 
+    * with the first direction varying fastest. Pixels outside the buffered region are 
+    * replicated from the boundary. The buffer is resized if needed. */
+  template <class TOutput>
+  void GatherRegion( const RegionType & region, std::vector<TOutput> & buffer ) const
+    {
+      const unsigned long size = region.GetNumberOfPixels();
+      if( buffer.size() != size )
+        buffer.resize( size );
+      
+      this->GatherRegion( region, &buffer[0] );
+    }
+  
+  /** Same as above, copying to an array with as many elements as the region. */
+  template <class TOutput>
+  void GatherRegion( const RegionType & region, TOutput *out ) const
+    {
+      const unsigned long size = region.GetNumberOfPixels();
+
+      const IndexType & first = region.GetIndex();
+      const SizeType & extent = region.GetSize();
+      
+      bool inside = true;
+      
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        if( first[d] < this->m_Start[d] || 
+            first[d] + static_cast<IndexValueType>( extent[d] ) - 1 > this->m_End[d] )
+          inside = false;
+      }
+      
+      const long rowLength = extent[0];
+      const unsigned long numberOfRows = size / rowLength;
+      
+      // Position of the current row with respect to the first index
+      long offset[ImageDimension];
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+        offset[d] = 0;
+      
+      IndexType rowIndex;
+      
+      for( unsigned long row = 0; row < numberOfRows; ++row )
+      {
+        for( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+          rowIndex[d] = first[d] + offset[d];
+          if( rowIndex[d] < this->m_Start[d] )
+            rowIndex[d] = this->m_Start[d];
+          else if( rowIndex[d] > this->m_End[d] )
+            rowIndex[d] = this->m_End[d];
+        }
+        
+        if( inside )
+        {
+          // The row is split in the runs of contiguous pixels of each brick
+          long k = 0;
+          
+          while( k < rowLength )
+          {
+            rowIndex[0] = first[0] + k;
+            
+            const long positionInBrick = ( rowIndex[0] - this->m_Start[0] ) % VBrickSize;
+            const long runLength = std::min<long>( VBrickSize - positionInBrick, rowLength - k );
+            
+            PixelRowConverter<PixelType,TOutput>::Convert( &this->GetPixel( rowIndex ), runLength, out + k );
+
+            k += runLength;
+          }
+        }
+        else
+        {
+          for( long k = 0; k < rowLength; ++k )
+          {
+            rowIndex[0] = first[0] + k;
+            if( rowIndex[0] < this->m_Start[0] )
+              rowIndex[0] = this->m_Start[0];
+            else if( rowIndex[0] > this->m_End[0] )
+              rowIndex[0] = this->m_End[0];
+            
+            out[k] = static_cast<TOutput>( this->GetPixel( rowIndex ) );
+          }
+        }
+        
+        out += rowLength;
+        
+        // Next row, the first direction is traversed by the inner loop
+        for( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+          if( ++offset[d] < static_cast<long>( extent[d] ) )
+            break;
+          offset[d] = 0;
+        }
+      }
+    }
+  
+  /** Linear interpolation at the given continuous index. Neighbours outside the buffered region
+    * are replicated from the boundary. */
+  double EvaluateLinearAtContinuousIndex( const ContinuousIndexType & cindex ) const;
+  
+  /** Get the number of bricks. */
+  unsigned long GetNumberOfBricks() const;
+  
+  /** Get the memory used by the bricks, in bytes. */
+  unsigned long GetMemorySize() const
+    { return this->m_Pixels.size() * sizeof( PixelType ); }
+  
+protected:
+
+  BrickedImageBuffer();
+  virtual ~BrickedImageBuffer() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Region of the neighborhood of the given radius around index. */
+  static RegionType GetNeighborhoodRegion( const IndexType & index, const SizeType & radius )
+    {
+      RegionType neighborhoodRegion;
+      IndexType neighborhoodStart;
+      SizeType neighborhoodSize;
+
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        neighborhoodStart[d] = index[d] - static_cast<IndexValueType>( radius[d] );
+        neighborhoodSize[d] = 2 * radius[d] + 1;
+      }
+
+      neighborhoodRegion.SetIndex( neighborhoodStart );
+      neighborhoodRegion.SetSize( neighborhoodSize );
+
+      return neighborhoodRegion;
+    }
+  
+private:
+
+  BrickedImageBuffer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+  /** Pixels, brick after brick. */
+  std::vector<PixelType>      m_Pixels;
+  
+  /** Buffered region of the copied image, and its first and last indices. */
+  RegionType                  m_BufferedRegion;
+  IndexType                   m_Start;
+  IndexType                   m_End;
+  
+  /** Stride in pixels of the bricks and of the pixels in a brick along each dimension. */
+  unsigned long               m_BrickStrides[ImageDimension];
+  unsigned long               m_PixelStrides[ImageDimension];
+  
+  /** Copied image and its modification time at the copy. */
+  const ImageType            *m_SourceImage;
+  unsigned long               m_SourceImageMTime;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanBrickedImageBuffer.hxx"
+#endif
+
+#endif
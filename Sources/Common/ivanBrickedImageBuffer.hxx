@@ -0,0 +1,240 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBrickedImageBuffer.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: read-only copy of an image stored in bricks for scattered neighborhood access
+// Date: 2012/11/05
+
+#ifndef __ivanBrickedImageBuffer_hxx
+#define __ivanBrickedImageBuffer_hxx
+
+#include "ivanBrickedImageBuffer.h"
+
+#include <cmath>
+
+namespace ivan
+{
+
+template <class TImage, unsigned int VBrickSize>
+BrickedImageBuffer<TImage,VBrickSize>
+::BrickedImageBuffer() :
+  m_SourceImage( 0 ),
+  m_SourceImageMTime( 0 )
+{
+  this->m_Start.Fill( 0 );
+  this->m_End.Fill( -1 );
+  std::fill( this->m_BrickStrides, this->m_BrickStrides + ImageDimension, 0ul );
+  std::fill( this->m_PixelStrides, this->m_PixelStrides + ImageDimension, 0ul );
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+void
+BrickedImageBuffer<TImage,VBrickSize>
+::CopyImage( const ImageType *image )
+{
+  if( !image )
+  {
+    itkExceptionMacro( "No image to copy." );
+  }
+  
+  this->m_BufferedRegion = image->GetBufferedRegion();
+  this->m_Start = this->m_BufferedRegion.GetIndex();
+  
+  // Bricks are stored in raster order, and the pixels of each brick too
+  unsigned long pixelsPerBrick = 1;
+  unsigned long numberOfBricks = 1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    this->m_End[d] = this->m_Start[d] + 
+      static_cast<IndexValueType>( this->m_BufferedRegion.GetSize()[d] ) - 1;
+    this->m_PixelStrides[d] = pixelsPerBrick;
+    pixelsPerBrick *= VBrickSize;
+  }
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    this->m_BrickStrides[d] = numberOfBricks * pixelsPerBrick;
+    numberOfBricks *= ( this->m_BufferedRegion.GetSize()[d] + VBrickSize - 1 ) / VBrickSize;
+  }
+  
+  this->m_Pixels.resize( numberOfBricks * pixelsPerBrick );
+  
+  // Copy the buffered region and pad the bricks of the upper boundary with the closest pixels
+  RegionType paddedRegion;
+  SizeType paddedSize;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    paddedSize[d] = ( ( this->m_BufferedRegion.GetSize()[d] + VBrickSize - 1 ) / VBrickSize ) * VBrickSize;
+  
+  paddedRegion.SetIndex( this->m_Start );
+  paddedRegion.SetSize( paddedSize );
+  
+  IndexType index, sourceIndex;
+  
+  // Iterate over the padded region in raster order
+  const unsigned long numberOfPixels = paddedRegion.GetNumberOfPixels();
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    index[d] = this->m_Start[d];
+  
+  for( unsigned long i=0; i<numberOfPixels; ++i )
+  {
+    for( unsigned int d=0; d<ImageDimension; ++d )
+      sourceIndex[d] = std::min( index[d], this->m_End[d] );
+    
+    unsigned long offset = 0;
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      const unsigned long position = static_cast<unsigned long>( index[d] - this->m_Start[d] );
+      offset += ( position / VBrickSize ) * this->m_BrickStrides[d] + 
+        ( position % VBrickSize ) * this->m_PixelStrides[d];
+    }
+    
+    this->m_Pixels[offset] = image->GetPixel( sourceIndex );
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      if( ++index[d] < this->m_Start[d] + static_cast<IndexValueType>( paddedSize[d] ) )
+        break;
+      index[d] = this->m_Start[d];
+    }
+  }
+  
+  this->m_SourceImage = image;
+  this->m_SourceImageMTime = image->GetMTime();
+  
+  this->Modified();
+  
+  itkDebugMacro( "Copied " << numberOfBricks << " bricks, memory used: " << this->GetMemorySize() << " bytes" );
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+bool
+BrickedImageBuffer<TImage,VBrickSize>
+::IsCopyOf( const ImageType *image ) const
+{
+  return image && image == this->m_SourceImage && !this->m_Pixels.empty() && 
+    image->GetMTime() == this->m_SourceImageMTime && 
+    image->GetBufferedRegion() == this->m_BufferedRegion;
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+void
+BrickedImageBuffer<TImage,VBrickSize>
+::ReleaseBricks()
+{
+  std::vector<PixelType>().swap( this->m_Pixels );
+  
+  this->m_SourceImage = 0;
+  this->m_SourceImageMTime = 0;
+  this->Modified();
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+unsigned long
+BrickedImageBuffer<TImage,VBrickSize>
+::GetNumberOfBricks() const
+{
+  unsigned long pixelsPerBrick = 1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    pixelsPerBrick *= VBrickSize;
+  
+  return this->m_Pixels.size() / pixelsPerBrick;
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+double
+BrickedImageBuffer<TImage,VBrickSize>
+::EvaluateLinearAtContinuousIndex( const ContinuousIndexType & cindex ) const
+{
+  IndexValueType baseIndex[ImageDimension];
+  double distance[ImageDimension];
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    baseIndex[d] = static_cast<IndexValueType>( vcl_floor( cindex[d] ) );
+    distance[d] = cindex[d] - static_cast<double>( baseIndex[d] );
+  }
+  
+  const unsigned int numberOfNeighbors = 1 << ImageDimension;
+  
+  double value = 0.0;
+  IndexType neighIndex;
+  
+  for( unsigned int counter=0; counter<numberOfNeighbors; ++counter )
+  {
+    double overlap = 1.0;
+    unsigned int upper = counter; // each bit indicates upper/lower neighbour
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      if( upper & 1 )
+      {
+        neighIndex[d] = baseIndex[d] + 1;
+        overlap *= distance[d];
+      }
+      else
+      {
+        neighIndex[d] = baseIndex[d];
+        overlap *= 1.0 - distance[d];
+      }
+      
+      neighIndex[d] = std::max( this->m_Start[d], std::min( neighIndex[d], this->m_End[d] ) );
+      upper >>= 1;
+    }
+    
+    if( overlap )
+      value += overlap * static_cast<double>( this->GetPixel( neighIndex ) );
+  }
+  
+  return value;
+}
+
+
+template <class TImage, unsigned int VBrickSize>
+void
+BrickedImageBuffer<TImage,VBrickSize>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "BrickSize: " << VBrickSize << std::endl;
+  os << indent << "BufferedRegion: " << this->m_BufferedRegion << std::endl;
+  os << indent << "NumberOfBricks: " << this->GetNumberOfBricks() << std::endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << std::endl;
+  os << indent << "SourceImage: " << this->m_SourceImage << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,154 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBufferInteriorRegion.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: interior of the buffered region of an image where the samples around a center need
+//   no bounds checks.
+// Date: 2012/11/05
+
+#ifndef __ivanBufferInteriorRegion_h
+#define __ivanBufferInteriorRegion_h
+
+#include "itkMacro.h"
+#include "itkPoint.h"
+#include "itkContinuousIndex.h"
+
+namespace ivan
+{
+/**
+ * \class BufferInteriorRegion
+ * \brief Region of centers whose samples up to a given distance are all inside the image buffer.
+ *
+ * Ring and sphere based functions sample an image at many points around a center, and each
+ * sample is usually checked with IsInsideBuffer() and interpolated with an interpolator that
+ * checks its neighbors again. Far from the borders all of these checks pass. This class
+ * precomputes, for a given sampling radius (in physical units) and a margin (in pixels) read
+ * around each sample by the interpolation or the kernels, the box of continuous indices of the
+ * centers for which any sample within the radius, together with its margin, lies inside the
+ * buffered region. When the center is inside this region, the samples may skip the bounds 
+ * checks and use unchecked interpolation. Otherwise the checked path must be used.
+ *
+ * A displacement of unit physical length moves the continuous index along each direction at 
+ * most the norm of the corresponding row of the physical to index matrix, so the box is the 
+ * buffered region shrunk by the radius times these norms plus the margin. The bounds are those 
+ * of the pixel centers, from the first to the last index of the region, so the samples of an 
+ * interior center are also inside for itk::ImageFunction::IsInsideBuffer(). They are shrunk 
+ * by a small tolerance too, for the rounding of sample coordinates computed incrementally.
+ *
+ * Compute() must be called again if the radius, the margin or the buffered region change. The 
+ * inside tests are const and may be called from several threads.
+ *
+ * This class is templated over the image type and the coordinate representation type.
+ */
+template <class TImage, class TCoordRep = double>
+class BufferInteriorRegion
+{
+public:
+
+  typedef TImage                                         ImageType;
+  typedef TCoordRep                                      CoordRepType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+  
+  typedef typename ImageType::IndexType                    IndexType;
+  typedef itk::Point<TCoordRep,ImageDimension>             PointType;
+  typedef itk::ContinuousIndex<TCoordRep,ImageDimension>   ContinuousIndexType;
+  
+public:
+
+  BufferInteriorRegion();
+  
+  /** Set the image whose buffered region bounds the samples. */
+  void SetImage( const ImageType *image );
+  const ImageType * GetImage() const { return m_Image; }
+  
+  /** Compute the interior for samples up to the given physical distance from the center, 
+    * each of them reading up to margin pixels around it. The region is empty if no image is 
+    * set or if the image is too small. */
+  void Compute( double radius, double margin );
+  
+  /** Radius and margin of the last Compute(). The radius is negative before the first one. */
+  double GetRadius() const { return m_Radius; }
+  double GetMargin() const { return m_Margin; }
+  
+  /** True if there are no interior centers. */
+  bool IsEmpty() const { return m_Empty; }
+  
+  /** Test if the samples around the given center need no bounds checks. */
+  bool IsInside( const ContinuousIndexType & cindex ) const
+    {
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        if( !( cindex[d] >= m_StartContinuousIndex[d] && cindex[d] <= m_EndContinuousIndex[d] ) )
+          return false;
+      }
+      
+      return !m_Empty;
+    }
+    
+  bool IsInside( const IndexType & index ) const
+    {
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        const double value = static_cast<double>( index[d] );
+        
+        if( value < m_StartContinuousIndex[d] || value > m_EndContinuousIndex[d] )
+          return false;
+      }
+      
+      return !m_Empty;
+    }
+  
+  /** Same as above for a physical point, which is transformed to a continuous index. */
+  bool IsInside( const PointType & point ) const
+    {
+      if( m_Empty )
+        return false;
+      
+      ContinuousIndexType cindex;
+      m_Image->TransformPhysicalPointToContinuousIndex( point, cindex );
+      return this->IsInside( cindex );
+    }
+  
+private:
+
+  const ImageType   *m_Image;
+  
+  double             m_Radius;
+  double             m_Margin;
+  bool               m_Empty;
+  
+  /** Bounds of the interior centers, in continuous index. */
+  double             m_StartContinuousIndex[ImageDimension];
+  double             m_EndContinuousIndex[ImageDimension];
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanBufferInteriorRegion.hxx"
+#endif
+
+#endif
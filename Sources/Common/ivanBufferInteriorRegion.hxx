@@ -0,0 +1,130 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBufferInteriorRegion.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: interior of the buffered region of an image where the samples around a center need
+//   no bounds checks.
+// Date: 2012/11/05
+
+#ifndef __ivanBufferInteriorRegion_hxx
+#define __ivanBufferInteriorRegion_hxx
+
+#include "ivanBufferInteriorRegion.h"
+
+#include <cmath>
+
+namespace ivan
+{
+
+template <class TImage, class TCoordRep>
+BufferInteriorRegion<TImage,TCoordRep>
+::BufferInteriorRegion() :
+  m_Image( 0 ),
+  m_Radius( -1.0 ),
+  m_Margin( 0.0 ),
+  m_Empty( true )
+{
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    m_StartContinuousIndex[d] = 0.0;
+    m_EndContinuousIndex[d] = -1.0;
+  }
+}
+
+
+template <class TImage, class TCoordRep>
+void
+BufferInteriorRegion<TImage,TCoordRep>
+::SetImage( const ImageType *image )
+{
+  if( m_Image == image )
+    return;
+  
+  m_Image = image;
+  m_Radius = -1.0;
+  m_Empty = true;
+}
+
+
+template <class TImage, class TCoordRep>
+void
+BufferInteriorRegion<TImage,TCoordRep>
+::Compute( double radius, double margin )
+{
+  m_Radius = radius;
+  m_Margin = margin;
+  m_Empty = true;
+  
+  if( !m_Image )
+    return;
+  
+  // Tolerance for the rounding of the sample coordinates, in pixels
+  const double tolerance = 1e-6;
+  
+  // Columns of the physical to index matrix, from the displacements along the physical axes
+  const PointType origin = m_Image->GetOrigin();
+  ContinuousIndexType originIndex, axisIndex;
+  m_Image->TransformPhysicalPointToContinuousIndex( origin, originIndex );
+  
+  double squaredRowNorms[ImageDimension];
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    squaredRowNorms[d] = 0.0;
+  
+  for( unsigned int j=0; j<ImageDimension; ++j )
+  {
+    PointType axisPoint = origin;
+    axisPoint[j] += 1.0;
+    m_Image->TransformPhysicalPointToContinuousIndex( axisPoint, axisIndex );
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      const double element = axisIndex[d] - originIndex[d];
+      squaredRowNorms[d] += element * element;
+    }
+  }
+  
+  const typename ImageType::RegionType & region = m_Image->GetBufferedRegion();
+  bool empty = false;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    const double shrink = std::fabs( radius ) * std::sqrt( squaredRowNorms[d] ) + margin + tolerance;
+    const double first = static_cast<double>( region.GetIndex()[d] );
+    const double last = first + static_cast<double>( region.GetSize()[d] ) - 1.0;
+    
+    m_StartContinuousIndex[d] = first + shrink;
+    m_EndContinuousIndex[d] = last - shrink;
+    
+    if( !region.GetSize()[d] || m_StartContinuousIndex[d] > m_EndContinuousIndex[d] )
+      empty = true;
+  }
+  
+  m_Empty = empty;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,214 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCPUDispatch.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: selection of the kernels compiled for each instruction set at run time
+// Date: 2012/11/05
+
+#include "ivanCPUDispatch.h"
+#include "ivanTileConvolutionKernels.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#include <immintrin.h>
+#define IVAN_CPU_DISPATCH_MSVC_X86
+#elif ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define IVAN_CPU_DISPATCH_GNU_X86
+#endif
+
+namespace ivan
+{
+
+bool CPUDispatch::m_Supported[CPUDispatch::NumberOfInstructionSets];
+
+CPUDispatch::InstructionSetType CPUDispatch::m_MaximumInstructionSet = CPUDispatch::AVX512;
+
+CPUDispatch::KernelTable CPUDispatch::m_Kernels = 
+  { CPUDispatch::Generic, &ConvolveTileGeneric, &ConvolveTileGeneric, &ConvertRowGeneric, &ConvertRowGeneric, 
+    &ConvertHalfRowGeneric, &ConvertHalfRowGeneric };
+
+const bool CPUDispatch::m_Initialized = CPUDispatch::Initialize();
+
+
+bool
+CPUDispatch::Initialize()
+{
+  m_Supported[Generic] = true;
+  m_Supported[AVX2]    = false;
+  m_Supported[AVX512]  = false;
+
+#if defined( IVAN_CPU_DISPATCH_GNU_X86 )
+  // These also check that the operating system saves the wide registers
+  __builtin_cpu_init();
+  m_Supported[AVX2]   = __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) && 
+    __builtin_cpu_supports( "f16c" );
+  m_Supported[AVX512] = m_Supported[AVX2] && __builtin_cpu_supports( "avx512f" );
+#elif defined( IVAN_CPU_DISPATCH_MSVC_X86 )
+  int info[4];
+  __cpuid( info, 0 );
+  
+  if( info[0] >= 7 )
+  {
+    __cpuid( info, 1 );
+    const bool fma     = ( info[2] & ( 1 << 12 ) ) != 0;
+    const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    const bool f16c    = ( info[2] & ( 1 << 29 ) ) != 0;
+    
+    if( osxsave )
+    {
+      // Registers enabled by the operating system: XMM/YMM and opmask/ZMM
+      const unsigned long long xcr0 = _xgetbv( 0 );
+      const bool ymm = ( xcr0 & 0x06 ) == 0x06;
+      const bool zmm = ( xcr0 & 0xe6 ) == 0xe6;
+      
+      __cpuidex( info, 7, 0 );
+      m_Supported[AVX2]   = ymm && fma && f16c && ( info[1] & ( 1 << 5 ) ) != 0;
+      m_Supported[AVX512] = m_Supported[AVX2] && zmm && ( info[1] & ( 1 << 16 ) ) != 0;
+    }
+  }
+#endif
+
+  const char *maximum = std::getenv( "IVAN_MAXIMUM_INSTRUCTION_SET" );
+  
+  if( maximum )
+  {
+    std::string name( maximum );
+    
+    for( std::string::size_type i = 0; i < name.size(); ++i )
+      name[i] = static_cast<char>( std::tolower( name[i] ) );
+    
+    if( name == "generic" )
+      m_MaximumInstructionSet = Generic;
+    else if( name == "avx2" )
+      m_MaximumInstructionSet = AVX2;
+    else if( name == "avx512" )
+      m_MaximumInstructionSet = AVX512;
+  }
+  
+  SelectKernels();
+  
+  return true;
+}
+
+
+bool
+CPUDispatch::IsSupported( InstructionSetType instructionSet )
+{
+  if( instructionSet < Generic || instructionSet >= NumberOfInstructionSets )
+    return false;
+  
+  return m_Supported[instructionSet];
+}
+
+
+bool
+CPUDispatch::IsCompiled( InstructionSetType instructionSet )
+{
+  switch( instructionSet )
+  {
+  case Generic:
+    return true;
+#ifdef IVAN_CPU_DISPATCH_AVX2
+  case AVX2:
+    return true;
+#endif
+#ifdef IVAN_CPU_DISPATCH_AVX512
+  case AVX512:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+
+const char *
+CPUDispatch::GetInstructionSetName( InstructionSetType instructionSet )
+{
+  switch( instructionSet )
+  {
+  case Generic:
+#if defined( __aarch64__ ) || defined( _M_ARM64 ) || defined( __ARM_NEON )
+    return "NEON";
+#elif defined( __x86_64__ ) || defined( _M_X64 ) || defined( __SSE2__ )
+    return "SSE2";
+#else
+    return "Generic";
+#endif
+  case AVX2:
+    return "AVX2";
+  case AVX512:
+    return "AVX512";
+  default:
+    return "Unknown";
+  }
+}
+
+
+void
+CPUDispatch::SetMaximumInstructionSet( InstructionSetType instructionSet )
+{
+  if( instructionSet < Generic )
+    instructionSet = Generic;
+  else if( instructionSet >= NumberOfInstructionSets )
+    instructionSet = AVX512;
+  
+  m_MaximumInstructionSet = instructionSet;
+  SelectKernels();
+}
+
+
+void
+CPUDispatch::SelectKernels()
+{
+  KernelTable kernels = { Generic, &ConvolveTileGeneric, &ConvolveTileGeneric, 
+    &ConvertRowGeneric, &ConvertRowGeneric, &ConvertHalfRowGeneric, &ConvertHalfRowGeneric };
+  
+#ifdef IVAN_CPU_DISPATCH_AVX2
+  if( m_MaximumInstructionSet >= AVX2 && m_Supported[AVX2] )
+  {
+    KernelTable avx2 = { AVX2, &ConvolveTileAVX2, &ConvolveTileAVX2, &ConvertRowAVX2, &ConvertRowAVX2, 
+      &ConvertHalfRowAVX2, &ConvertHalfRowAVX2 };
+    kernels = avx2;
+  }
+#endif
+
+#ifdef IVAN_CPU_DISPATCH_AVX512
+  if( m_MaximumInstructionSet >= AVX512 && m_Supported[AVX512] )
+  {
+    KernelTable avx512 = { AVX512, &ConvolveTileAVX512, &ConvolveTileAVX512, 
+      &ConvertRowAVX512, &ConvertRowAVX512, &ConvertHalfRowAVX512, &ConvertHalfRowAVX512 };
+    kernels = avx512;
+  }
+#endif
+
+  m_Kernels = kernels;
+}
+
+} // end namespace ivan
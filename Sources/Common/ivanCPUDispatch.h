@@ -0,0 +1,152 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCPUDispatch.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: selection of the kernels compiled for each instruction set at run time
+// Date: 2012/11/05
+
+#ifndef __ivanCPUDispatch_h
+#define __ivanCPUDispatch_h
+
+#include "ivanConfigure.h"
+
+#include "itkMacro.h"
+
+namespace ivan
+{
+/**
+ * \class CPUDispatch
+ * \brief Selects at run time the fastest kernels supported by the processor.
+ *
+ * The innermost loops of the separable convolutions (see SeparableLineConvolution), the 
+ * conversion of rows of short pixels gathered by the image functions (see PixelRowConverter) 
+ * and the conversion of half-precision values (see HalfFloat) are compiled in separate 
+ * translation units for several instruction sets. The baseline kernels are always available. 
+ * They are SSE2 on x86-64 and NEON on AArch64. If the library is configured with 
+ * IVAN_USE_CPU_DISPATCH on x86, AVX2 (with FMA and F16C) and AVX-512 versions are also compiled. 
+ * On start up the processor (and operating system support for the wider registers) is probed, 
+ * and the table of kernels points to the widest supported version, so that a single binary 
+ * runs efficiently on different machines.
+ *
+ * GetActiveInstructionSet() reports which version is used. SetMaximumInstructionSet() restricts 
+ * the selection, for example to compare the results or the speed of the different versions, 
+ * and must not be called while kernels are running. If the IVAN_MAXIMUM_INSTRUCTION_SET 
+ * environment variable is set to the name of an instruction set (generic, avx2, avx512), it is 
+ * used as the initial maximum.
+ *
+ * The table is built on static initialization, so the selected kernels can be used from 
+ * several threads.
+ */
+class ITK_EXPORT CPUDispatch
+{
+public:
+
+  /** Instruction sets, from the narrowest to the widest. Generic is the baseline of the target
+    * architecture. */
+  typedef enum
+  {
+    Generic = 0,
+    AVX2,
+    AVX512,
+    NumberOfInstructionSets
+  } InstructionSetType;
+  
+  /** Number of adjacent lines of the tiles of the convolution kernels. */
+  itkStaticConstMacro( TileWidth, unsigned int, 16 );
+  
+  /** Convolution of an interleaved tile: for i in [0,length) and b in [0,TileWidth), 
+    * result[i*TileWidth+b] is the sum of kernel[k] * tile[(i+k)*TileWidth+b] over the kernel. */
+  typedef void (*TileConvolutionDoubleFunction)( const double *tile, unsigned long length, 
+    const double *kernel, unsigned int kernelSize, double *result );
+  typedef void (*TileConvolutionFloatFunction)( const float *tile, unsigned long length, 
+    const float *kernel, unsigned int kernelSize, float *result );
+  
+  /** Conversion of a row of length short pixels to real values. */
+  typedef void (*RowConversionDoubleFunction)( const short *row, unsigned long length, double *result );
+  typedef void (*RowConversionFloatFunction)( const short *row, unsigned long length, float *result );
+  
+  /** Conversion of a row of half-precision values (their bits) to float, and back. */
+  typedef void (*HalfToFloatRowFunction)( const unsigned short *row, unsigned long length, float *result );
+  typedef void (*FloatToHalfRowFunction)( const float *row, unsigned long length, unsigned short *result );
+  
+  /** Kernels of one instruction set. */
+  struct KernelTable
+  {
+    InstructionSetType              InstructionSet;
+    TileConvolutionDoubleFunction   ConvolveTileDouble;
+    TileConvolutionFloatFunction    ConvolveTileFloat;
+    RowConversionDoubleFunction     ConvertShortRowToDouble;
+    RowConversionFloatFunction      ConvertShortRowToFloat;
+    HalfToFloatRowFunction          ConvertHalfRowToFloat;
+    FloatToHalfRowFunction          ConvertFloatRowToHalf;
+  };
+
+public:
+  
+  /** Kernels of the active instruction set. */
+  static const KernelTable & GetKernels()
+    { return m_Kernels; }
+  
+  /** Whether the processor and the operating system support the instruction set. */
+  static bool IsSupported( InstructionSetType instructionSet );
+  
+  /** Whether kernels for the instruction set are compiled in the library. */
+  static bool IsCompiled( InstructionSetType instructionSet );
+  
+  /** Instruction set of the kernels in use. */
+  static InstructionSetType GetActiveInstructionSet()
+    { return m_Kernels.InstructionSet; }
+  static const char * GetActiveInstructionSetName()
+    { return GetInstructionSetName( m_Kernels.InstructionSet ); }
+  
+  /** Name of an instruction set. The generic one is named after the baseline of the target 
+    * (SSE2, NEON...). */
+  static const char * GetInstructionSetName( InstructionSetType instructionSet );
+  
+  /** Set/Get the widest instruction set that may be selected. The widest supported and 
+    * compiled set up to this one becomes active. */
+  static void SetMaximumInstructionSet( InstructionSetType instructionSet );
+  static InstructionSetType GetMaximumInstructionSet()
+    { return m_MaximumInstructionSet; }
+  
+private:
+
+  CPUDispatch(); // purposely not implemented
+  
+  /** Probe the processor and select the kernels. Called once on static initialization. */
+  static bool Initialize();
+  
+  /** Point the kernel table to the widest available set up to the maximum. */
+  static void SelectKernels();
+  
+  static bool                 m_Supported[NumberOfInstructionSets];
+  static InstructionSetType   m_MaximumInstructionSet;
+  static KernelTable          m_Kernels;
+  static const bool           m_Initialized;
+};
+
+} // end namespace ivan
+
+#endif
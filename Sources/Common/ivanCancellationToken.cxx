@@ -0,0 +1,82 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCancellationToken.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: cooperative cancellation and time budget for long computations
+// Date: 2012/11/05
+
+#include "ivanCancellationToken.h"
+
+namespace ivan
+{
+
+CancellationToken::CancellationToken() :
+  m_TimeBudget( 0.0 ),
+  m_StartTime( 0.0 ),
+  m_Cancelled( false )
+{
+  m_Clock = itk::RealTimeClock::New();
+  this->Start();
+}
+
+
+void
+CancellationToken::Start()
+{
+  m_StartTime = m_Clock->GetTimeStamp();
+  m_Cancelled = false;
+}
+
+
+double
+CancellationToken::GetElapsedTime() const
+{
+  return m_Clock->GetTimeStamp() - m_StartTime;
+}
+
+
+CancellationToken::StopReasonType
+CancellationToken::GetStopReason() const
+{
+  if( m_Cancelled )
+    return Cancelled;
+  else if( this->IsBudgetExceeded() )
+    return BudgetExceeded;
+  else
+    return NotStopped;
+}
+
+
+void
+CancellationToken::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "TimeBudget: " << m_TimeBudget << std::endl;
+  os << indent << "ElapsedTime: " << this->GetElapsedTime() << std::endl;
+  os << indent << "Cancelled: " << m_Cancelled << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,128 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCancellationToken.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: cooperative cancellation and time budget for long computations
+// Date: 2012/11/05
+
+#ifndef __ivanCancellationToken_h
+#define __ivanCancellationToken_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkRealTimeClock.h"
+
+
+namespace ivan
+{
+/**
+ * \class CancellationToken
+ * \brief Cooperative cancellation and wall-clock time budget for long computations.
+ *
+ * A token is shared by the objects doing the work of a request, such as a tracker, its section
+ * estimator and optimizer, or the network filters. They check IsStopRequested() at safe points
+ * (every tracking step, section or optimizer iteration) and stop, keeping the results computed 
+ * until then and flagging them as interrupted.
+ *
+ * Stop is requested when Cancel() is called from any thread, or when more than TimeBudget 
+ * seconds have elapsed since the token was created or Start() was last called. A zero budget 
+ * (the default) means no limit. IsStopRequested() may be called concurrently from several threads.
+ *
+ * \sa VesselTrackerFilter
+ * \sa VesselSectionEstimator
+ * \sa ParallelPatternSearchOptimizer
+ */
+class ITK_EXPORT CancellationToken : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef CancellationToken               Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CancellationToken, itk::Object );
+  
+  typedef enum { NotStopped = 0, Cancelled, BudgetExceeded } StopReasonType;
+  
+public:
+  
+  /** Set/Get the time budget in seconds, counted from Start(). Zero means no limit. */
+  itkSetMacro( TimeBudget, double );
+  itkGetConstMacro( TimeBudget, double );
+  
+  /** Restart the time budget and clear a previous cancellation. */
+  void Start();
+  
+  /** Request the computations using this token to stop. */
+  void Cancel()
+    { m_Cancelled = true; }
+  
+  bool IsCancelled() const
+    { return m_Cancelled; }
+  
+  /** Time in seconds since the token was started. */
+  double GetElapsedTime() const;
+  
+  bool IsBudgetExceeded() const
+    { return m_TimeBudget > 0.0 && this->GetElapsedTime() > m_TimeBudget; }
+  
+  /** Returns true if the computations must stop, either cancelled or out of time. */
+  bool IsStopRequested() const
+    { return m_Cancelled || this->IsBudgetExceeded(); }
+  
+  /** Get why stop is requested, if it is. */
+  StopReasonType GetStopReason() const;
+  
+protected:
+
+  CancellationToken();
+  virtual ~CancellationToken() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  CancellationToken( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  itk::RealTimeClock::Pointer   m_Clock;
+  
+  double            m_TimeBudget;
+  double            m_StartTime;
+  
+  volatile bool     m_Cancelled;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,222 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircleSampler.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: generates the samples of circles in an image, shared by ring-based functions
+// Date: 2012/11/05
+
+#ifndef __ivanCircleSampler_h
+#define __ivanCircleSampler_h
+
+#include "ivanScratchArray.h"
+#include "ivanMacros.h"
+
+#include "itkPoint.h"
+#include "itkContinuousIndex.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace ivan
+{
+/**
+ * \class CircleSampler
+ * \brief Generates the samples of circles in an image, in physical and index coordinates.
+ *
+ * Ring-based features (offset medialness, circular flux, ridge search...) evaluate a function at 
+ * a number of equally spaced points of a circle given by its center, radius and two orthonormal 
+ * vectors of its plane. This class precomputes the sin and cos of the sample angles once and, 
+ * for each circle, computes all the sample coordinates at once in a SampleSet. Coordinates are 
+ * stored by dimension (structure of arrays) so that the loops may be vectorized by the compiler.
+ *
+ * Since the physical to index transform is affine, only the center and the two base vectors are
+ * transformed to index space, and the continuous indices of the samples are obtained directly. 
+ * The inside buffer test is done for all samples in index space, with the same bounds as 
+ * itk::ImageFunction::IsInsideBuffer(). Functions may then be evaluated with 
+ * EvaluateAtContinuousIndex(), avoiding the transform from physical coordinates per sample.
+ *
+ * Functions usually gather a neighborhood of the image around each sample, and each gather
+ * waits for its memory before the next one is issued. With a prefetch distance, Prefetch() 
+ * hints the processor to load the first rows of the neighborhoods of the samples that follow,
+ * so that their memory latency overlaps with the evaluation of the current sample. This is 
+ * only useful when the image does not fit in the cache, and is disabled by default.
+ *
+ * SetImage() must be called again if the buffered region of the image changes. Sample() is 
+ * const and may be called from several threads with different sample sets.
+ *
+ * This class is templated over the image type and the coordinate representation type.
+ */
+template <class TImage, class TCoordRep = double>
+class CircleSampler
+{
+public:
+
+  typedef TImage                                         ImageType;
+  typedef TCoordRep                                      CoordRepType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+  
+  /** Maximum number of samples without memory allocation in SampleSet. */
+  itkStaticConstMacro( SampleSetCapacity, unsigned int, 128 );
+  
+  typedef itk::Point<TCoordRep,ImageDimension>             PointType;
+  typedef itk::ContinuousIndex<TCoordRep,ImageDimension>   ContinuousIndexType;
+  
+  typedef std::vector<double>                            AngularValuesContainerType;
+  
+  /** \class SampleSet
+   * \brief Coordinates and inside buffer flags of the samples of a circle.
+   *
+   * Storage is on the stack up to SampleSetCapacity samples. */
+  class SampleSet
+  {
+  public:
+  
+    explicit SampleSet( unsigned int numberOfSamples ) :
+      m_NumberOfSamples( numberOfSamples ),
+      m_NumberOfInsideSamples( 0 ),
+      m_Coordinates( 2 * ImageDimension * numberOfSamples ),
+      m_Inside( numberOfSamples )
+      {}
+      
+    unsigned int GetNumberOfSamples() const { return m_NumberOfSamples; }
+    
+    /** Number of samples inside the buffered region of the image. */
+    unsigned int GetNumberOfInsideSamples() const { return m_NumberOfInsideSamples; }
+    
+    bool IsInside( unsigned int i ) const { return m_Inside[i] != 0; }
+    
+    /** Continuous index coordinates of all samples in the given dimension. */
+    const double * GetIndexCoordinates( unsigned int dim ) const 
+      { return m_Coordinates.GetDataPointer() + dim * m_NumberOfSamples; }
+      
+    /** Physical coordinates of all samples in the given dimension. */
+    const double * GetPhysicalCoordinates( unsigned int dim ) const 
+      { return m_Coordinates.GetDataPointer() + ( ImageDimension + dim ) * m_NumberOfSamples; }
+    
+    void GetContinuousIndex( unsigned int i, ContinuousIndexType & cindex ) const
+      {
+        for( unsigned int d=0; d<ImageDimension; ++d )
+          cindex[d] = this->GetIndexCoordinates( d )[i];
+      }
+      
+    void GetPoint( unsigned int i, PointType & point ) const
+      {
+        for( unsigned int d=0; d<ImageDimension; ++d )
+          point[d] = this->GetPhysicalCoordinates( d )[i];
+      }
+      
+  private:
+  
+    friend class CircleSampler;
+    
+    unsigned int    m_NumberOfSamples;
+    unsigned int    m_NumberOfInsideSamples;
+    
+    ScratchArray<double,2*ImageDimension*SampleSetCapacity>   m_Coordinates;
+    ScratchArray<unsigned char,SampleSetCapacity>             m_Inside;
+  };
+  
+public:
+
+  CircleSampler();
+  
+  /** Set the number of samples, equally spaced in angle starting at zero. */
+  void SetNumberOfSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfSamples() const { return m_NumberOfSamples; }
+  
+  /** Cos and sin of the sample angles. */
+  const AngularValuesContainerType & GetCosArray() const { return m_CosArray; }
+  const AngularValuesContainerType & GetSinArray() const { return m_SinArray; }
+  
+  /** Set the image that defines the physical to index transform and the buffered region. */
+  void SetImage( const ImageType *image );
+  const ImageType * GetImage() const { return m_Image; }
+  
+  /** Compute the samples of the circle with the given center and radius, in the plane defined  
+   * by the two (orthonormal) base vectors. The sample i is at 
+   * center + radius * ( cos(i) * firstBaseVector + sin(i) * secondBaseVector ). 
+   * The sample set must have been created with GetNumberOfSamples() samples. */
+  template <class TVector>
+  void Sample( const PointType & center, double radius, const TVector & firstBaseVector, 
+    const TVector & secondBaseVector, SampleSet & samples ) const;
+  
+  /** Set/Get the number of samples ahead whose neighborhoods are prefetched by Prefetch(). 
+    * Zero disables prefetching. Default is 0. */
+  void SetPrefetchDistance( unsigned int distance ) { m_PrefetchDistance = distance; }
+  unsigned int GetPrefetchDistance() const { return m_PrefetchDistance; }
+  
+  /** Set/Get the number of rows of each neighborhood that are prefetched, in the order they are 
+    * gathered (first direction along the rows). Default is 4. */
+  void SetNumberOfPrefetchRows( unsigned int rows ) { m_NumberOfPrefetchRows = rows; }
+  unsigned int GetNumberOfPrefetchRows() const { return m_NumberOfPrefetchRows; }
+  
+  /** Radius in pixels of the neighborhood of a Gaussian derivative of the given standard 
+    * deviation (in physical units), to be used in Prefetch(). */
+  unsigned int ComputeNeighborhoodRadius( double sigma ) const;
+  
+  /** Prefetch the neighborhoods of the given radius of the samples that follow sample i. This
+    * is meant to be called before evaluating each sample i in increasing order: the call for the 
+    * first sample prefetches the first PrefetchDistance samples too. Samples outside the buffer 
+    * are ignored. Requires an image with a pixel buffer. */
+  void Prefetch( const SampleSet & samples, unsigned int i, unsigned int radius ) const
+    {
+      const unsigned int n = samples.GetNumberOfSamples();
+      
+      if( !m_PrefetchDistance || !n || ( i > 0 && i + m_PrefetchDistance >= n ) )
+        return;
+      
+      const unsigned int last = std::min( i + m_PrefetchDistance, n - 1 );
+      
+      for( unsigned int j = ( i == 0 ) ? 0 : last; j <= last; ++j )
+        this->PrefetchSample( samples, j, radius );
+    }
+  
+private:
+
+  /** Prefetch the first rows of the neighborhood of a sample. */
+  void PrefetchSample( const SampleSet & samples, unsigned int i, unsigned int radius ) const;
+
+  unsigned int                  m_NumberOfSamples;
+  AngularValuesContainerType    m_CosArray;
+  AngularValuesContainerType    m_SinArray;
+  
+  const ImageType              *m_Image;
+  
+  unsigned int                  m_PrefetchDistance;
+  unsigned int                  m_NumberOfPrefetchRows;
+  
+  /** Bounds of the buffered region for the inside test, in continuous index. */
+  double                        m_StartContinuousIndex[ImageDimension];
+  double                        m_EndContinuousIndex[ImageDimension];
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanCircleSampler.hxx"
+#endif
+
+#endif
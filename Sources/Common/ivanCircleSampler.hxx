@@ -0,0 +1,257 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircleSampler.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: generates the samples of circles in an image, shared by ring-based functions
+// Date: 2012/11/05
+
+#ifndef __ivanCircleSampler_hxx
+#define __ivanCircleSampler_hxx
+
+#include "ivanCircleSampler.h"
+
+#include "itkMacro.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+namespace ivan
+{
+
+template <class TImage, class TCoordRep>
+CircleSampler<TImage,TCoordRep>
+::CircleSampler() :
+  m_NumberOfSamples( 0 ),
+  m_Image( 0 ),
+  m_PrefetchDistance( 0 ),
+  m_NumberOfPrefetchRows( 4 )
+{
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    m_StartContinuousIndex[d] = 0.0;
+    m_EndContinuousIndex[d] = 0.0;
+  }
+}
+
+
+template <class TImage, class TCoordRep>
+void
+CircleSampler<TImage,TCoordRep>
+::SetNumberOfSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfSamples = numberOfSamples;
+  m_CosArray.resize( numberOfSamples );
+  m_SinArray.resize( numberOfSamples );
+  
+  const double angleInc = vnl_math::pi * 2.0 / static_cast<double>( numberOfSamples ); 
+  double angle = 0.0;
+  
+  for( unsigned int i=0; i<numberOfSamples; ++i )
+  {
+    m_SinArray[i] = std::sin( angle );
+    m_CosArray[i] = std::cos( angle );
+    angle += angleInc;
+  }
+}
+
+
+template <class TImage, class TCoordRep>
+void
+CircleSampler<TImage,TCoordRep>
+::SetImage( const ImageType *image )
+{
+  m_Image = image;
+  
+  if( !image )
+    return;
+  
+  const typename ImageType::RegionType & region = image->GetBufferedRegion();
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    m_StartContinuousIndex[d] = static_cast<double>( region.GetIndex()[d] ) - 0.5;
+    m_EndContinuousIndex[d] = m_StartContinuousIndex[d] + static_cast<double>( region.GetSize()[d] );
+  }
+}
+
+
+template <class TImage, class TCoordRep>
+template <class TVector>
+void
+CircleSampler<TImage,TCoordRep>
+::Sample( const PointType & center, double radius, const TVector & firstBaseVector, 
+  const TVector & secondBaseVector, SampleSet & samples ) const
+{
+  if( !m_Image )
+  {
+    itkGenericExceptionMacro( "CircleSampler: image not set." );
+  }
+  
+  if( samples.m_NumberOfSamples != m_NumberOfSamples )
+  {
+    itkGenericExceptionMacro( "CircleSampler: sample set has " << samples.m_NumberOfSamples 
+      << " samples, expected " << m_NumberOfSamples );
+  }
+  
+  const unsigned int n = m_NumberOfSamples;
+  samples.m_NumberOfInsideSamples = 0;
+  
+  if( !n )
+    return;
+  
+  // Transform the center and the base vectors to index space
+  ContinuousIndexType centerIndex, firstIndex, secondIndex;
+  PointType point;
+  
+  m_Image->TransformPhysicalPointToContinuousIndex( center, centerIndex );
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    point[d] = center[d] + firstBaseVector[d];
+  m_Image->TransformPhysicalPointToContinuousIndex( point, firstIndex );
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    point[d] = center[d] + secondBaseVector[d];
+  m_Image->TransformPhysicalPointToContinuousIndex( point, secondIndex );
+  
+  const double *cosArray = &m_CosArray[0];
+  const double *sinArray = &m_SinArray[0];
+  double *coordinates = samples.m_Coordinates.GetDataPointer();
+  unsigned char *inside = samples.m_Inside.GetDataPointer();
+  
+  for( unsigned int i=0; i<n; ++i )
+    inside[i] = 1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    double *indexCoordinates = coordinates + d * n;
+    double *physicalCoordinates = coordinates + ( ImageDimension + d ) * n;
+    
+    const double ic = centerIndex[d];
+    const double iu = radius * ( firstIndex[d] - centerIndex[d] );
+    const double iv = radius * ( secondIndex[d] - centerIndex[d] );
+    
+    const double pc = center[d];
+    const double pu = radius * firstBaseVector[d];
+    const double pv = radius * secondBaseVector[d];
+    
+    const double start = m_StartContinuousIndex[d];
+    const double end = m_EndContinuousIndex[d];
+    
+    for( unsigned int i=0; i<n; ++i )
+    {
+      indexCoordinates[i] = ic + iu * cosArray[i] + iv * sinArray[i];
+      physicalCoordinates[i] = pc + pu * cosArray[i] + pv * sinArray[i];
+      inside[i] &= static_cast<unsigned char>( ( indexCoordinates[i] >= start ) & ( indexCoordinates[i] < end ) );
+    }
+  }
+  
+  unsigned int numberOfInsideSamples = 0;
+  
+  for( unsigned int i=0; i<n; ++i )
+    numberOfInsideSamples += inside[i];
+    
+  samples.m_NumberOfInsideSamples = numberOfInsideSamples;
+}
+
+
+template <class TImage, class TCoordRep>
+unsigned int
+CircleSampler<TImage,TCoordRep>
+::ComputeNeighborhoodRadius( double sigma ) const
+{
+  if( !m_Image )
+    return 0;
+  
+  double minimumSpacing = m_Image->GetSpacing()[0];
+  
+  for( unsigned int d=1; d<ImageDimension; ++d )
+    minimumSpacing = std::min( minimumSpacing, static_cast<double>( m_Image->GetSpacing()[d] ) );
+  
+  // Discrete Gaussian kernels are truncated at about three standard deviations. Linear 
+  // interpolation reads one more pixel
+  return static_cast<unsigned int>( std::ceil( 3.0 * sigma / minimumSpacing ) ) + 1;
+}
+
+
+template <class TImage, class TCoordRep>
+void
+CircleSampler<TImage,TCoordRep>
+::PrefetchSample( const SampleSet & samples, unsigned int i, unsigned int radius ) const
+{
+  if( !m_Image || !samples.IsInside( i ) )
+    return;
+  
+  typedef typename ImageType::PixelType        PixelType;
+  typedef typename ImageType::OffsetValueType  OffsetValueType;
+  
+  const typename ImageType::RegionType & region = m_Image->GetBufferedRegion();
+  const OffsetValueType *offsetTable = m_Image->GetOffsetTable();
+  
+  const long width = 2 * static_cast<long>( radius ) + 1;
+  
+  long first[ImageDimension], last[ImageDimension];
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    const long center = static_cast<long>( std::floor( samples.GetIndexCoordinates( d )[i] + 0.5 ) );
+    const long start = region.GetIndex()[d];
+    const long end = start + static_cast<long>( region.GetSize()[d] ) - 1;
+    
+    first[d] = std::max( center - static_cast<long>( radius ), start ) - start;
+    last[d] = std::min( center + static_cast<long>( radius ), end ) - start;
+  }
+  
+  const PixelType *pixels = m_Image->GetBufferPointer();
+  const unsigned long rowBytes = ( last[0] - first[0] + 1 ) * sizeof( PixelType );
+  
+  for( unsigned int row=0; row<m_NumberOfPrefetchRows; ++row )
+  {
+    // Position of the row in the neighborhood, first direction excluded
+    long position = row;
+    OffsetValueType offset = first[0];
+    
+    for( unsigned int d=1; d<ImageDimension; ++d )
+    {
+      offset += std::min( first[d] + position % width, last[d] ) * offsetTable[d];
+      position /= width;
+    }
+    
+    if( position > 0 ) // all the rows of the neighborhood have been prefetched
+      break;
+    
+    // One prefetch per cache line of the row
+    const char *address = reinterpret_cast<const char *>( pixels + offset );
+    
+    for( unsigned long b=0; b<rowBytes; b+=64 )
+      ivanPrefetchMacro( address + b );
+    
+    ivanPrefetchMacro( address + rowBytes - 1 );
+  }
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,105 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanExplicitInstantiation.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: macros and types for the explicit instantiation of the library templates
+// Date: 2012/11/05
+
+#ifndef __ivanExplicitInstantiation_h
+#define __ivanExplicitInstantiation_h
+
+#include "ivanConfigure.h"
+
+#include "itkImage.h"
+
+/**
+ * Explicit instantiation of the library templates for the common types.
+ *
+ * If IVAN_USE_EXPLICIT_INSTANTIATION is set, the templates listed in the Templates/ directory of
+ * each library (ivanDetection, ivanExtraction and ivanModeling) are compiled once in the library 
+ * for the types of ivan::Templates: 3D float and short input images and double outputs. Every 
+ * other translation unit then sees an extern declaration of these specializations (through the 
+ * Templates/<class>+-.h header included at the end of the class header) and does not instantiate 
+ * them again, which reduces the compilation and link time of applications. Other types are 
+ * implicitly instantiated from the .hxx files as usual.
+ *
+ * The Templates/<class>+-.h headers apply the ITK_TEMPLATE_<class>(_, EXPORT, x, y) macro of the 
+ * class header with IVAN_TEMPLATE_INSTANTIATION, which is an explicit instantiation definition 
+ * in the Templates/<class>+.cxx file of the library (where IVAN_TEMPLATE_CXX is defined) and an 
+ * explicit instantiation declaration (extern template) elsewhere. The x argument is the 
+ * parenthesized list of template arguments and y the suffix of the typedef of the specialization 
+ * declared in the ivan::Templates namespace.
+ */
+
+#if defined( IVAN_USE_EXPLICIT_INSTANTIATION ) && !defined( IVAN_TEMPLATE_CXX )
+# define IVAN_TEMPLATE_EXPLICIT 1
+#else
+# define IVAN_TEMPLATE_EXPLICIT 0
+#endif
+
+// The count prefix produced by the ITK_TEMPLATE_<class> macros selects the macro that rejoins the 
+// arguments split by the commas of the template argument list
+#define IVAN_TEMPLATE_1(x1)                 x1
+#define IVAN_TEMPLATE_2(x1,x2)              x1,x2
+#define IVAN_TEMPLATE_3(x1,x2,x3)           x1,x2,x3
+#define IVAN_TEMPLATE_4(x1,x2,x3,x4)        x1,x2,x3,x4
+
+// Also needed by the ITK_TEMPLATE_<class> macros, in case ITK does not define them
+#ifndef ITK_TEMPLATE_1
+# define ITK_TEMPLATE_1(x1)                 x1
+# define ITK_TEMPLATE_2(x1,x2)              x1,x2
+# define ITK_TEMPLATE_3(x1,x2,x3)           x1,x2,x3
+# define ITK_TEMPLATE_4(x1,x2,x3,x4)        x1,x2,x3,x4
+#endif
+
+#define IVAN_TEMPLATE_EXPORT(x)             IVAN_TEMPLATE_EXPORT_DELAY(x)
+#define IVAN_TEMPLATE_EXPORT_DELAY(x)       template IVAN_TEMPLATE_##x;
+#define IVAN_TEMPLATE_IMPORT(x)             IVAN_TEMPLATE_IMPORT_DELAY(x)
+#define IVAN_TEMPLATE_IMPORT_DELAY(x)       extern template IVAN_TEMPLATE_##x;
+
+#ifdef IVAN_TEMPLATE_CXX
+# define IVAN_TEMPLATE_INSTANTIATION        IVAN_TEMPLATE_EXPORT
+#else
+# define IVAN_TEMPLATE_INSTANTIATION        IVAN_TEMPLATE_IMPORT
+#endif
+
+// Libraries are static unless IVAN_BUILD_SHARED_LIBS is set, in which case symbols are exported 
+// by default except on Windows, which is not supported for explicit instantiation
+#define IVAN_TEMPLATE_EXPORT_SPEC
+
+
+namespace ivan
+{
+namespace Templates
+{
+
+/** Image types with compiled specializations. */
+typedef itk::Image<float,3>     ImageF3;
+typedef itk::Image<short,3>     ImageSS3;
+
+} // end namespace Templates
+} // end namespace ivan
+
+#endif // __ivanExplicitInstantiation_h
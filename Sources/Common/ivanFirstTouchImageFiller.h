@@ -0,0 +1,99 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFirstTouchImageFiller.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: parallel fill of image buffers by the threads that will process them
+// Date: 2012/11/05
+
+#ifndef __ivanFirstTouchImageFiller_h
+#define __ivanFirstTouchImageFiller_h
+
+#include "itkMultiThreader.h"
+#include "itkImageRegion.h"
+
+
+namespace ivan
+{
+/**
+ * \class FirstTouchImageFiller
+ * \brief Fills the buffer of an image from several threads, each filling the slab that the 
+ * thread with the same id processes in itk::ImageSource.
+ *
+ * Operating systems with first-touch page placement (Linux, Windows) map each page of a newly 
+ * allocated buffer to the memory node of the thread that first writes it. An image allocated 
+ * and filled by the main thread lives in a single node, and the threads running on other 
+ * sockets pay remote memory latency for all their accesses. Filling the buffer with this class 
+ * right after Allocate() instead of FillBuffer() spreads the pages so that each slab is local
+ * to the thread that later processes it.
+ *
+ * The buffered region is divided with itk::ImageRegionSplitter, as in 
+ * itk::ImageSource::SplitRequestedRegion(). Placement only matches across passes if thread i
+ * runs on the same node in both of them, which is what the thread affinity option ensures 
+ * (see ScopedThreadAffinity). Pages that were already touched are not moved.
+ *
+ * This class is templated over the image type.
+ *
+ * \sa ScopedThreadAffinity
+ */
+template <class TImage>
+class ITK_EXPORT FirstTouchImageFiller
+{
+public:
+
+  typedef TImage                              ImageType;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::RegionType      RegionType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+  
+public:
+
+  /** Fill the buffered region of the image with the given value using the given number of 
+    * threads. If threadAffinity is true, each thread is pinned to its processor while filling. */
+  static void Fill( ImageType *image, const PixelType & value, unsigned int numberOfThreads, 
+    bool threadAffinity = false );
+  
+private:
+
+  FirstTouchImageFiller(); // purposely not implemented
+  
+  static ITK_THREAD_RETURN_TYPE FillThreaderCallback( void *arg );
+  
+  /** Data shared by the threads of Fill(). */
+  struct FillThreadStruct
+  {
+    ImageType     *Image;
+    PixelType     Value;
+    bool          ThreadAffinity;
+  };
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanFirstTouchImageFiller.hxx"
+#endif
+
+#endif
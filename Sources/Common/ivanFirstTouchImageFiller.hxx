@@ -0,0 +1,95 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFirstTouchImageFiller.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: parallel fill of image buffers by the threads that will process them
+// Date: 2012/11/05
+
+#ifndef __ivanFirstTouchImageFiller_hxx
+#define __ivanFirstTouchImageFiller_hxx
+
+#include "ivanFirstTouchImageFiller.h"
+#include "ivanThreadAffinity.h"
+
+#include "itkImageRegionSplitter.h"
+#include "itkImageRegionIterator.h"
+
+
+namespace ivan
+{
+
+template <class TImage>
+void
+FirstTouchImageFiller<TImage>
+::Fill( ImageType *image, const PixelType & value, unsigned int numberOfThreads, bool threadAffinity )
+{
+  if( !image )
+    return;
+  
+  FillThreadStruct str;
+  str.Image = image;
+  str.Value = value;
+  str.ThreadAffinity = threadAffinity;
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfThreads > 0 ? numberOfThreads : 1 );
+  threader->SetSingleMethod( FillThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+
+template <class TImage>
+ITK_THREAD_RETURN_TYPE
+FirstTouchImageFiller<TImage>
+::FillThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const unsigned int numberOfThreads = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  
+  FillThreadStruct *str = (FillThreadStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  ScopedThreadAffinity affinity( threadId, str->ThreadAffinity );
+  
+  // Same split as itk::ImageSource
+  typedef itk::ImageRegionSplitter<ImageDimension>  SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  
+  const RegionType region = str->Image->GetBufferedRegion();
+  const unsigned int total = splitter->GetNumberOfSplits( region, numberOfThreads );
+  
+  if( threadId < total )
+  {
+    itk::ImageRegionIterator<ImageType> it( str->Image, splitter->GetSplit( threadId, total, region ) );
+    
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      it.Set( str->Value );
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+} // end namespace ivan
+
+#endif
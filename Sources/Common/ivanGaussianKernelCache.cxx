@@ -0,0 +1,304 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianKernelCache.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide cache of Gaussian kernel coefficients with optional persistent file storage
+// Date: 2012/11/05
+
+#include "ivanGaussianKernelCache.h"
+
+#include <fstream>
+
+namespace ivan
+{
+
+namespace
+{
+/** Identifies the files written by Save(). */
+const char KernelCacheFileSignature[] = "IVANGKC1";
+}
+
+
+GaussianKernelCache::Pointer GaussianKernelCache::m_Instance;
+itk::SimpleFastMutexLock GaussianKernelCache::m_InstanceMutex;
+
+
+GaussianKernelCache::GaussianKernelCache() :
+  m_Enabled( false )
+{
+
+}
+
+
+GaussianKernelCache::Pointer
+GaussianKernelCache::GetInstance()
+{
+  m_InstanceMutex.Lock();
+  
+  if( m_Instance.IsNull() )
+  {
+    m_Instance = new Self;
+    m_Instance->UnRegister(); // the smart pointer holds the only reference
+  }
+  
+  Pointer instance = m_Instance;
+  
+  m_InstanceMutex.Unlock();
+  
+  return instance;
+}
+
+
+void
+GaussianKernelCache::SetEnabled( bool enabled )
+{
+  m_Mutex.Lock();
+  m_Enabled = enabled;
+  m_Mutex.Unlock();
+}
+
+
+bool
+GaussianKernelCache::GetEnabled() const
+{
+  m_Mutex.Lock();
+  bool enabled = m_Enabled;
+  m_Mutex.Unlock();
+  
+  return enabled;
+}
+
+
+bool
+GaussianKernelCache::Find( const std::string& name, const ParameterVectorType& parameters, 
+  CoefficientVectorType& coefficients ) const
+{
+  KeyType key;
+  key.Name = name;
+  key.Parameters = parameters;
+  
+  bool found = false;
+  
+  m_Mutex.Lock();
+  
+  if( m_Enabled )
+  {
+    KernelContainerType::const_iterator it = m_Kernels.find( key );
+    
+    if( it != m_Kernels.end() )
+    {
+      coefficients = it->second;
+      found = true;
+    }
+  }
+  
+  m_Mutex.Unlock();
+  
+  return found;
+}
+
+
+void
+GaussianKernelCache::Insert( const std::string& name, const ParameterVectorType& parameters, 
+  const CoefficientVectorType& coefficients )
+{
+  KeyType key;
+  key.Name = name;
+  key.Parameters = parameters;
+  
+  m_Mutex.Lock();
+  
+  if( m_Enabled )
+    m_Kernels[key] = coefficients;
+  
+  m_Mutex.Unlock();
+}
+
+
+void
+GaussianKernelCache::Clear()
+{
+  m_Mutex.Lock();
+  m_Kernels.clear();
+  m_Mutex.Unlock();
+}
+
+
+unsigned long
+GaussianKernelCache::GetNumberOfKernels() const
+{
+  m_Mutex.Lock();
+  unsigned long numberOfKernels = m_Kernels.size();
+  m_Mutex.Unlock();
+  
+  return numberOfKernels;
+}
+
+
+bool
+GaussianKernelCache::Save( const std::string& fileName ) const
+{
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  
+  if( !file )
+  {
+    itkWarningMacro( "Could not open kernel cache file " << fileName << " for writing." );
+    return false;
+  }
+  
+  m_Mutex.Lock();
+  
+  file.write( KernelCacheFileSignature, sizeof( KernelCacheFileSignature ) - 1 );
+  
+  unsigned long numberOfKernels = m_Kernels.size();
+  file.write( reinterpret_cast<const char*>( &numberOfKernels ), sizeof( numberOfKernels ) );
+  
+  for( KernelContainerType::const_iterator it = m_Kernels.begin(); it != m_Kernels.end(); ++it )
+  {
+    unsigned long size = it->first.Name.size();
+    file.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+    file.write( it->first.Name.data(), size );
+    
+    size = it->first.Parameters.size();
+    file.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+    
+    if( size )
+      file.write( reinterpret_cast<const char*>( &it->first.Parameters[0] ), size * sizeof( double ) );
+    
+    size = it->second.size();
+    file.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+    
+    if( size )
+      file.write( reinterpret_cast<const char*>( &it->second[0] ), size * sizeof( double ) );
+  }
+  
+  m_Mutex.Unlock();
+  
+  if( !file )
+  {
+    itkWarningMacro( "Error writing kernel cache file " << fileName << "." );
+    return false;
+  }
+  
+  return true;
+}
+
+
+bool
+GaussianKernelCache::Load( const std::string& fileName )
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+  {
+    itkWarningMacro( "Could not open kernel cache file " << fileName << " for reading." );
+    return false;
+  }
+  
+  char signature[sizeof( KernelCacheFileSignature ) - 1];
+  file.read( signature, sizeof( signature ) );
+  
+  if( !file || std::string( signature, sizeof( signature ) ) != KernelCacheFileSignature )
+  {
+    itkWarningMacro( "File " << fileName << " is not a valid kernel cache file." );
+    return false;
+  }
+  
+  // Read everything first so that the cache is not modified on failure
+  KernelContainerType kernels;
+  
+  unsigned long numberOfKernels = 0;
+  file.read( reinterpret_cast<char*>( &numberOfKernels ), sizeof( numberOfKernels ) );
+  
+  // Sizes are bounded to detect corrupt files before allocating
+  const unsigned long maximumSize = 1 << 28;
+  
+  for( unsigned long i=0; file && i < numberOfKernels; ++i )
+  {
+    KeyType key;
+    CoefficientVectorType coefficients;
+    unsigned long size = 0;
+    
+    file.read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+    
+    if( !file || size > maximumSize )
+      break;
+      
+    key.Name.resize( size );
+    
+    if( size )
+      file.read( &key.Name[0], size );
+    
+    file.read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+    
+    if( !file || size > maximumSize )
+      break;
+    
+    key.Parameters.resize( size );
+    
+    if( size )
+      file.read( reinterpret_cast<char*>( &key.Parameters[0] ), size * sizeof( double ) );
+    
+    file.read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+    
+    if( !file || size > maximumSize )
+      break;
+    
+    coefficients.resize( size );
+    
+    if( size )
+      file.read( reinterpret_cast<char*>( &coefficients[0] ), size * sizeof( double ) );
+    
+    if( file )
+      kernels[key] = coefficients;
+  }
+  
+  if( !file || kernels.size() != numberOfKernels )
+  {
+    itkWarningMacro( "Error reading kernel cache file " << fileName << "." );
+    return false;
+  }
+  
+  m_Mutex.Lock();
+  
+  for( KernelContainerType::const_iterator it = kernels.begin(); it != kernels.end(); ++it )
+    m_Kernels[it->first] = it->second;
+    
+  m_Mutex.Unlock();
+  
+  return true;
+}
+
+
+void
+GaussianKernelCache::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Enabled: " << this->GetEnabled() << std::endl;
+  os << indent << "NumberOfKernels: " << this->GetNumberOfKernels() << std::endl;
+}
+
+} // end namespace ivan
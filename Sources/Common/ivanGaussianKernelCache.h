@@ -0,0 +1,157 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianKernelCache.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide cache of Gaussian kernel coefficients with optional persistent file storage
+// Date: 2012/11/05
+
+#ifndef __ivanGaussianKernelCache_h
+#define __ivanGaussianKernelCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <map>
+#include <vector>
+#include <string>
+
+namespace ivan
+{
+/**
+ * \class GaussianKernelCache
+ * \brief Process-wide cache of Gaussian kernel coefficients, with optional persistent storage.
+ *
+ * Computing the coefficients of the Gaussian derivative operators (modified Bessel functions) 
+ * is costly at large scales, and is repeated every time a function is initialized. When the 
+ * cache is enabled, the operators look for the coefficients here first and store them after 
+ * computing them. The compound kernels of the Hessian function are outer products of these 
+ * operators and are not cached.
+ *
+ * Kernels are identified by a name (usually the class that generates them) and a vector of 
+ * parameters (variance, order, spacing, maximum error...). Coefficients are stored as doubles.
+ *
+ * There is a single instance per process, obtained with GetInstance(). The cache is disabled 
+ * by default. Its contents can be saved to and loaded from a binary file, so that other 
+ * processes do not have to recompute the same kernels. The file uses the native byte order.
+ *
+ * All methods can be called concurrently from several threads.
+ *
+ * \sa GaussianDerivativeOperator
+ */
+class ITK_EXPORT GaussianKernelCache : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef GaussianKernelCache             Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( GaussianKernelCache, Object );
+  
+  typedef std::vector<double>     ParameterVectorType;
+  typedef std::vector<double>     CoefficientVectorType;
+  
+  /** Key of the cached kernels. */
+  struct KeyType
+  {
+    std::string           Name;
+    ParameterVectorType   Parameters;
+    
+    bool operator<( const KeyType& other ) const
+      {
+        if( Name != other.Name )
+          return Name < other.Name;
+        
+        return Parameters < other.Parameters;
+      }
+  };
+  
+  typedef std::map<KeyType,CoefficientVectorType>    KernelContainerType;
+  
+public:
+  
+  /** Get the instance of the cache for this process. */
+  static Pointer GetInstance();
+  
+  /** Set/Get the flag for using the cache. Off by default. */
+  void SetEnabled( bool enabled );
+  bool GetEnabled() const;
+  itkBooleanMacro( Enabled );
+  
+  /** Look for the coefficients of the kernel with the given name and parameters. Returns true 
+    * if found. Always returns false if the cache is disabled. */
+  bool Find( const std::string& name, const ParameterVectorType& parameters, 
+    CoefficientVectorType& coefficients ) const;
+  
+  /** Store the coefficients of the kernel with the given name and parameters. Does nothing if 
+    * the cache is disabled. */
+  void Insert( const std::string& name, const ParameterVectorType& parameters, 
+    const CoefficientVectorType& coefficients );
+  
+  /** Remove all kernels. */
+  void Clear();
+  
+  /** Get the number of kernels stored. */
+  unsigned long GetNumberOfKernels() const;
+  
+  /** Save all the kernels to the given file. Returns false on failure. */
+  bool Save( const std::string& fileName ) const;
+  
+  /** Load the kernels stored in the given file, adding them to the current ones. Returns false 
+    * on failure, in which case the cache is not modified. */
+  bool Load( const std::string& fileName );
+  
+protected:
+
+  GaussianKernelCache();
+  ~GaussianKernelCache() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  GaussianKernelCache( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  KernelContainerType   m_Kernels;
+  
+  bool                  m_Enabled;
+  
+  /** Mutex for accessing the container from several threads. */
+  mutable itk::SimpleFastMutexLock    m_Mutex;
+  
+  static Pointer                      m_Instance;
+  static itk::SimpleFastMutexLock     m_InstanceMutex;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,60 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianWeightTable.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tabulated Gaussian weights exp(-x^2/2) with bounded relative error
+// Date: 2012/11/05
+
+#include "ivanGaussianWeightTable.h"
+
+namespace ivan
+{
+
+double GaussianWeightTable::m_Table[GaussianWeightTable::TableSize];
+
+const bool GaussianWeightTable::m_TableInitialized = GaussianWeightTable::InitializeTable();
+
+
+bool
+GaussianWeightTable::InitializeTable()
+{
+  for( unsigned int k = 0; k < TableSize; ++k )
+    m_Table[k] = vcl_exp( -static_cast<double>( k ) / static_cast<double>( Resolution ) );
+  
+  return true;
+}
+
+
+double
+GaussianWeightTable::GetMaximumRelativeError()
+{
+  // Remainder of the third order Taylor polynomial of exp( -r ) for r < 1 / Resolution,
+  // relative to exp( -r )
+  const double r = 1.0 / static_cast<double>( Resolution );
+  
+  return r * r * r * r / 24.0 * vcl_exp( r );
+}
+
+} // end namespace ivan
@@ -0,0 +1,103 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianWeightTable.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tabulated Gaussian weights exp(-x^2/2) with bounded relative error
+// Date: 2012/11/05
+
+#ifndef __ivanGaussianWeightTable_h
+#define __ivanGaussianWeightTable_h
+
+#include "itkMacro.h"
+
+#include "vcl_cmath.h"
+
+namespace ivan
+{
+/**
+ * \class GaussianWeightTable
+ * \brief Fast evaluation of the Gaussian weight exp( -x^2 / 2 ).
+ *
+ * The medialness functions weight every radial sample with exp( -x^2 / 2 ) when the symmetry 
+ * coefficient is not 1.0, which is dominated by the cost of the exponential. Here the exponent 
+ * t = x^2 / 2 is split as t = k / Resolution + r, 0 <= r < 1 / Resolution, and the weight is 
+ * computed as the tabulated exp( -k / Resolution ) times a third order polynomial of exp( -r ). 
+ * Since the polynomial error does not depend on k, the relative error is bounded everywhere 
+ * by GetMaximumRelativeError() (about 3e-9). Exponents larger than MaximumExponent, where the 
+ * weight is below 1e-13, fall back to vcl_exp().
+ *
+ * The table is built on static initialization, so evaluation is thread-safe.
+ */
+class ITK_EXPORT GaussianWeightTable
+{
+public:
+
+  /** Number of table entries per unit of the exponent. */
+  itkStaticConstMacro( Resolution, unsigned int, 64 );
+  
+  /** Largest tabulated exponent. */
+  itkStaticConstMacro( MaximumExponent, unsigned int, 32 );
+  
+  itkStaticConstMacro( TableSize, unsigned int, 64 * 32 + 1 );
+  
+  /** Return exp( -x^2 / 2 ). */
+  static double Evaluate( double x )
+    {
+      const double t = 0.5 * x * x;
+      
+      if( t >= static_cast<double>( MaximumExponent ) )
+        return vcl_exp( -t );
+      
+      const double scaled = t * static_cast<double>( Resolution );
+      const unsigned int k = static_cast<unsigned int>( scaled );
+      const double r = ( scaled - static_cast<double>( k ) ) / static_cast<double>( Resolution );
+      
+      return m_Table[k] * ( 1.0 - r * ( 1.0 - r * ( 0.5 - r * ( 1.0 / 6.0 ) ) ) );
+    }
+  
+  /** Compute the weights of n values at once, eg. all the samples of a ring. */
+  static void Evaluate( const double *x, double *weights, unsigned int n )
+    {
+      for( unsigned int i = 0; i < n; ++i )
+        weights[i] = Evaluate( x[i] );
+    }
+  
+  /** Bound of the relative error of Evaluate() with respect to vcl_exp(). */
+  static double GetMaximumRelativeError();
+  
+private:
+
+  GaussianWeightTable(); // purposely not implemented
+  
+  /** Fill the table. Called once on static initialization. */
+  static bool InitializeTable();
+
+  static double       m_Table[TableSize];
+  static const bool   m_TableInitialized;
+};
+
+} // end namespace ivan
+
+#endif
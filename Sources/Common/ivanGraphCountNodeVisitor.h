@@ -72,6 +72,12 @@ public:
     { m_Count = 0; }
     
   itkGetConstMacro( Count, unsigned int );
+  
+  /** Counters for parallel traversal, whose counts are added to this one. */
+  virtual GraphNodeVisitor::Pointer CreateTaskVisitor() const
+    { return Self::New().GetPointer(); }
+  virtual void MergeTaskVisitor( GraphNodeVisitor * taskVisitor )
+    { m_Count += static_cast<Self*>( taskVisitor )->m_Count; }
     
   /** Increment the counter for this node type only. */
   void Apply( NodeType * node );
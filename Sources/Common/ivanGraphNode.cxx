@@ -28,16 +28,27 @@ SUCH DAMAGE.
 
 #include "ivanGraphNode.h"
 #include "ivanGraphNodeVisitor.h"
+#include "ivanGraphNodeIndex.h"
+
+#include "itkSimpleFastMutexLock.h"
 
 
 namespace ivan
 {
 
 
+namespace
+{
+  itk::SimpleFastMutexLock       nodeTypeMutex;
+  GraphNode::NodeTypeIdentifier  numberOfNodeTypes = 0;
+}
+
+
 GraphNode::GraphNode() :
 	m_Mask( 0xffffffff ),
 	m_NodeId(0),
-	m_DepthLevel(0)
+	m_DepthLevel(0),
+	m_NodeIndex(0)
 {
 
 }
@@ -45,12 +56,31 @@ GraphNode::GraphNode() :
 
 GraphNode::~GraphNode()
 {
+  if( m_NodeIndex )
+    m_NodeIndex->RemoveNode( this );
+}
 
+
+void GraphNode::SetNodeId( NodeIdentifier id )
+{
+  if( m_NodeId == id )
+    return;
+    
+  const NodeIdentifier oldId = m_NodeId;
+  m_NodeId = id;
+  
+  if( m_NodeIndex )
+    m_NodeIndex->ChangeNodeId( this, oldId );
+    
+  this->Modified();
 }
 
 
 GraphNode * GraphNode::GetChildById( NodeIdentifier id )
 { 
+  if( m_NodeIndex )
+    return m_NodeIndex->FindChild( this, id );
+    
   for( unsigned int i=0; i<m_Children.size(); ++i )
   {
     if( m_Children[i]->GetNodeId() == id )
@@ -63,6 +93,9 @@ GraphNode * GraphNode::GetChildById( NodeIdentifier id )
 
 const GraphNode * GraphNode::GetChildById( NodeIdentifier id ) const
 { 
+  if( m_NodeIndex )
+    return m_NodeIndex->FindChild( this, id );
+    
   for( unsigned int i=0; i<m_Children.size(); ++i )
   {
     if( m_Children[i]->GetNodeId() == id )
@@ -105,6 +138,9 @@ void GraphNode::AddChild( GraphNode *child )
 	// Register as parent of child.
   child->AddParent( this );
   child->SetDepthLevel( this->GetDepthLevel() + 1 );
+  
+  if( m_NodeIndex )
+    m_NodeIndex->AttachSubtree( child );
 }
 
 
@@ -138,6 +174,9 @@ void GraphNode::InsertChild( unsigned int pos, GraphNode *child )
   // Register as parent of child.
   child->AddParent( this );
   child->SetDepthLevel( this->GetDepthLevel() + 1 );
+  
+  if( m_NodeIndex )
+    m_NodeIndex->AttachSubtree( child );
 }
 
 
@@ -160,6 +199,8 @@ void GraphNode::ReplaceChild( unsigned int pos, GraphNode *child )
 		return;
 	}
 	
+	Pointer oldChild;
+	
 	if( pos >= m_Children.size() )
 	{
 	  itkWarningMacro( "Inserting child at position past the end of the container." );
@@ -167,12 +208,20 @@ void GraphNode::ReplaceChild( unsigned int pos, GraphNode *child )
 	} 
   else
   {
+    oldChild = m_Children[pos];
     m_Children[pos]->RemoveParent( this );
     m_Children[pos] = child;
   }
  
   // Register as parent of child.
   child->AddParent( this );	
+  
+  if( m_NodeIndex )
+  {
+    m_NodeIndex->AttachSubtree( child );
+    if( oldChild.IsNotNull() )
+      m_NodeIndex->DetachSubtree( oldChild );
+  }
 }
 
 
@@ -195,10 +244,17 @@ bool GraphNode::ReplaceChild( GraphNode *oldChild, GraphNode *newChild )
 	{
 		if( it->GetPointer() == oldChild )
 		{
+		  Pointer removedChild = *it;
 		  (*it)->RemoveParent( this );
 			*it = newChild;
 			newChild->SetDepthLevel( this->GetDepthLevel() + 1 );
 			(*it)->AddParent( this );
+			
+			if( m_NodeIndex )
+			{
+			  m_NodeIndex->AttachSubtree( newChild );
+			  m_NodeIndex->DetachSubtree( removedChild );
+			}
 			return true;
 		}
 			
@@ -217,7 +273,11 @@ bool GraphNode::RemoveChild( GraphNode *child )
 	{
 		if( it->GetPointer() == child )
 		{
+		  Pointer removedChild = *it;
 			m_Children.erase( it );
+			
+			if( m_NodeIndex )
+			  m_NodeIndex->DetachSubtree( removedChild );
 			return true;
 		}
 			
@@ -236,7 +296,24 @@ void GraphNode::RemoveChild( unsigned int pos )
 		return;
 	}
 	
+	Pointer removedChild = m_Children[pos];
 	m_Children.erase( m_Children.begin() + pos );
+	
+	if( m_NodeIndex )
+	  m_NodeIndex->DetachSubtree( removedChild );
+}
+
+
+void GraphNode::RemoveAllChildren()
+{
+  NodeContainer removedChildren;
+  removedChildren.swap( m_Children );
+  
+  if( m_NodeIndex )
+  {
+    for( unsigned int i=0; i<removedChildren.size(); ++i )
+      m_NodeIndex->DetachSubtree( removedChildren[i] );
+  }
 }
 
 
@@ -461,32 +538,62 @@ bool GraphNode::RemoveParent( NodeIdentifier targetNodeId, GraphNode *parent )
 }
 
 
+void GraphNode::CopyInformation( const GraphNode * node )
+{
+  if( !node )
+    return;
+    
+  this->SetNodeId( node->GetNodeId() );
+  m_Mask = node->GetMask();
+  m_Name = node->GetName();
+  m_DepthLevel = node->GetDepthLevel();
+  
+  this->Modified();
+}
+
+
 void GraphNode::Accept( GraphNodeVisitor * visitor )
 {
-	if ( visitor->IsValidMask( this ) ) 
-  {
-    visitor->PushOntoNodePath( this );
-    visitor->Visit( this );
-    visitor->PopFromNodePath();
-  }
+  visitor->Start( this );
 }
 		
 
 void GraphNode::Traverse( GraphNodeVisitor * visitor )
 {
-	for( NodeContainer::iterator it = m_Children.begin();  it!= m_Children.end(); ++it )
-    (*it)->Accept( visitor );  
+  // Scheduled in reverse order so that children are visited in order
+	for( NodeContainer::reverse_iterator it = m_Children.rbegin();  it!= m_Children.rend(); ++it )
+    visitor->ScheduleNode( *it );  
 }
 
 
 void GraphNode::Ascend( GraphNodeVisitor * visitor )
 {
-	for( ParentNodeContainer::iterator it = m_Parents.begin();  it!= m_Parents.end(); ++it )
-    (*it)->Accept( visitor );  
+	for( ParentNodeContainer::reverse_iterator it = m_Parents.rbegin();  it!= m_Parents.rend(); ++it )
+    visitor->ScheduleNode( it->GetPointer() );  
 }
 
 
 
+GraphNode::NodeTypeIdentifier GraphNode::RegisterNodeType()
+{
+  nodeTypeMutex.Lock();
+  const NodeTypeIdentifier nodeTypeId = numberOfNodeTypes++;
+  nodeTypeMutex.Unlock();
+  
+  return nodeTypeId;
+}
+
+
+GraphNode::NodeTypeIdentifier GraphNode::GetNumberOfRegisteredNodeTypes()
+{
+  nodeTypeMutex.Lock();
+  const NodeTypeIdentifier count = numberOfNodeTypes;
+  nodeTypeMutex.Unlock();
+  
+  return count;
+}
+
+
 void GraphNode::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
@@ -495,6 +602,7 @@ void GraphNode::PrintSelf( std::ostream& os, itk::Indent indent ) const
   os << indent << "NodeId: " << m_NodeId << std::endl;
   os << indent << "DepthLevel: " << m_DepthLevel << std::endl;
   os << indent << "Name: " << m_Name << std::endl;
+  os << indent << "NodeTypeId: " << this->GetNodeTypeId() << std::endl;
 	os << indent << "Parents: " << std::endl;
   
   for( unsigned int i=0; i < m_Parents.size(); ++i )
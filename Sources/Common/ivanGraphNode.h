@@ -33,16 +33,29 @@ SUCH DAMAGE.
 #include "itkObjectFactory.h"
 #include "itkWeakPointer.h"
 
+#include "ivanArenaAllocator.h"
+
 #include <vector>
 #include <cassert>
 
 
 // NOTE: We need to declare some static methods for nodes
 // I miss this in the itkTypeMacro()
+//
+// Every node class also gets a dense integer type identifier, assigned the first time 
+// it is requested, that visitors use to index their dispatch tables.
 
 #define itkNodeTypeMacro( classType, superclassType ) \
   itkTypeMacro( classType, superclassType ); \
-  static const char * GetNameOfClassStatic() { return #classType; }
+  static const char * GetNameOfClassStatic() { return #classType; } \
+  static ::ivan::GraphNode::NodeTypeIdentifier GetNodeTypeIdStatic() \
+    { \
+      static const ::ivan::GraphNode::NodeTypeIdentifier nodeTypeId = \
+        ::ivan::GraphNode::RegisterNodeType(); \
+      return nodeTypeId; \
+    } \
+  virtual ::ivan::GraphNode::NodeTypeIdentifier GetNodeTypeId() const \
+    { return classType::GetNodeTypeIdStatic(); }
   
 
 namespace ivan
@@ -57,13 +70,13 @@ namespace ivan
  * one parent.
  * 
  * Operations on GraphNode objects can be performed through a GraphNodeVisitor
- * which recursively visits nodes of the graph and perform custom operations
- * via inheritance.
+ * which visits nodes of the graph and perform custom operations via inheritance.
  *
  * \ingroup 
  */
  
 class GraphNodeVisitor;
+class GraphNodeIndex;
  
 class ITK_EXPORT GraphNode : public itk::Object
 {
@@ -92,6 +105,9 @@ public:
   typedef NodeContainer    NodePathType;  
   typedef unsigned int     NodeIdentifier;  
   typedef unsigned int     NodeMaskType;
+  
+  /** Dense identifier of the node class, returned by GetNodeTypeId(). */
+  typedef unsigned int     NodeTypeIdentifier;
      
 public:
 
@@ -101,12 +117,20 @@ public:
   /** Run-time type information (and related methods). */
   itkNodeTypeMacro( GraphNode, itk::Object );
   
+  /** Nodes are taken from the active ArenaAllocator, if any. */
+  ivanArenaAllocationMacro();
+  
   itkSetMacro( Mask, NodeMaskType );
   itkGetConstMacro( Mask, NodeMaskType );
   
-  itkSetMacro( NodeId, NodeIdentifier );
+  /** Set the node identifier. The index of the graph, if any, is updated. */
+  virtual void SetNodeId( NodeIdentifier id );
   itkGetConstMacro( NodeId, NodeIdentifier );
   
+  /** Index of the graph this node belongs to, or NULL. This is set by the GraphNodeIndex. */
+  GraphNodeIndex * GetNodeIndex() const
+    { return m_NodeIndex; }
+  
   itkSetMacro( DepthLevel, int );
   itkGetConstMacro( DepthLevel, int );
   
@@ -125,7 +149,8 @@ public:
       return m_Children[pos];
     }
 
-  /** Get child at the given position by id. Returns NULL if not found. */
+  /** Get child at the given position by id. Returns NULL if not found. This is a hash lookup
+    * if the node belongs to a GraphNodeIndex. */
   virtual GraphNode * GetChildById( NodeIdentifier id );
   virtual const GraphNode * GetChildById( NodeIdentifier id ) const;
   
@@ -177,8 +202,7 @@ public:
 	virtual bool RemoveChild( NodeIdentifier targetNodeId, GraphNode *child );
 	
 	/** Remove all children of this node. */
-	inline virtual void RemoveAllChildren()
-		{	m_Children.clear();	}
+	virtual void RemoveAllChildren();
 			
 	/** Get the number of children. */
 	inline virtual unsigned int GetNumberOfChildren() const 
@@ -251,19 +275,31 @@ public:
 	inline unsigned int GetNumberOfParents() const 
 		{	return m_Parents.size();	}
 		
+	/** Copy the attributes of the given node, such as the identifier, mask, name and depth level,
+	  * but not its links. Subclasses copy their own data and share large members such as 
+	  * centerlines by reference. */
+	virtual void CopyInformation( const GraphNode * node );
+		
 	/** Visitor pattern. Accept a node visitor to start the traversal. This is called the first time to 
 	  * start the traversal on the current node. */
 	virtual void Accept( GraphNodeVisitor * visitor );
 		
-  /** Visitor pattern. Traverse downwards (this node and its children). This is called during the
-	  * traversal process which starts with a call to Visit using a GraphNodeVisitor. NOTE: this 
-	  * method is not intended to be called directly by the user. */
+  /** Visitor pattern. Traverse downwards, scheduling the children of this node in the visitor.
+	  * This is called during the traversal process which starts with a call to Accept(). NOTE: 
+	  * this method is not intended to be called directly by the user. */
 	virtual void Traverse( GraphNodeVisitor * visitor );
 	
-	/** Visitor pattern. Traverse upwards (this node and its parents). This is called during the
-	  * traversal process which starts with a call to Visit using a GraphNodeVisitor. NOTE: this 
-	  * method is not intended to be called directly by the user. */
+	/** Visitor pattern. Traverse upwards, scheduling the parents of this node in the visitor. 
+	  * This is called during the traversal process which starts with a call to Accept(). NOTE: 
+	  * this method is not intended to be called directly by the user. */
 	virtual void Ascend( GraphNodeVisitor * visitor );
+	
+	/** Get a new node type identifier. Identifiers are consecutive starting from zero. This is 
+	  * called once per node class by the itkNodeTypeMacro() and is thread safe. */
+	static NodeTypeIdentifier RegisterNodeType();
+	
+	/** Get the number of node types registered until now. */
+	static NodeTypeIdentifier GetNumberOfRegisteredNodeTypes();
 		
 protected:
   
@@ -276,6 +312,8 @@ private:
 
   GraphNode(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
+  
+  friend class GraphNodeIndex;
 
 protected:
 
@@ -298,6 +336,9 @@ protected:
 	/** This is an inverse order from root to the current node, that is, the
 	  * number of intermediate nodes. This is best assigned by a specific visitor. */	
 	int             m_DepthLevel;
+	
+	/** Index of the graph this node belongs to, not owned. */
+	GraphNodeIndex  *m_NodeIndex;
 };
 
 } // end namespace ivan
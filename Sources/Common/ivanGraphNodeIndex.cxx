@@ -0,0 +1,254 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGraphNodeIndex.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: hash index of the nodes of a graph by identifier
+// Date: 2012/11/05
+
+
+#include "ivanGraphNodeIndex.h"
+
+#include <vector>
+#include <set>
+
+
+namespace ivan
+{
+
+GraphNodeIndex::GraphNodeIndex()
+{
+
+}
+
+
+GraphNodeIndex::~GraphNodeIndex()
+{
+  this->Clear();
+}
+
+
+void GraphNodeIndex::Build( GraphNode * root )
+{
+  this->Clear();
+  
+  m_RootNode = root;
+  
+  if( root )
+    this->AttachSubtree( root );
+}
+
+
+void GraphNodeIndex::Clear()
+{
+  // Nodes must not keep a reference to the index once they are removed
+  for( NodeMapType::iterator it = m_Nodes.begin(); it != m_Nodes.end(); ++it )
+    it->second->m_NodeIndex = 0;
+  
+  m_Nodes.clear();
+  m_RootNode = 0;
+  
+  this->Modified();
+}
+
+
+GraphNode * GraphNodeIndex::FindNode( NodeIdentifier id ) const
+{
+  NodeMapType::const_iterator it = m_Nodes.find( id );
+  
+  if( it == m_Nodes.end() )
+    return 0;
+    
+  return it->second.GetPointer();
+}
+
+
+GraphNode * GraphNodeIndex::FindNode( NodeIdentifier id, const GraphNode * ancestor ) const
+{
+  std::pair<NodeMapType::const_iterator,NodeMapType::const_iterator> range = m_Nodes.equal_range( id );
+  
+  // Every indexed node descends from the root
+  if( ancestor == m_RootNode.GetPointer() )
+    return range.first != range.second ? range.first->second.GetPointer() : 0;
+  
+  for( NodeMapType::const_iterator it = range.first; it != range.second; ++it )
+  {
+    // Ascend from the candidate looking for the ancestor
+    std::vector<const GraphNode*> pendingNodes( 1, it->second.GetPointer() );
+    std::set<const GraphNode*> visitedNodes;
+    
+    while( !pendingNodes.empty() )
+    {
+      const GraphNode *node = pendingNodes.back();
+      pendingNodes.pop_back();
+      
+      if( !node || !visitedNodes.insert( node ).second )
+        continue;
+      
+      if( node == ancestor )
+        return it->second.GetPointer();
+        
+      for( unsigned int i=0; i<node->GetNumberOfParents(); ++i )
+        pendingNodes.push_back( node->GetParent(i) );
+    }
+  }
+  
+  return 0;
+}
+
+
+GraphNode * GraphNodeIndex::FindChild( const GraphNode * parent, NodeIdentifier id ) const
+{
+  std::pair<NodeMapType::const_iterator,NodeMapType::const_iterator> range = m_Nodes.equal_range( id );
+  
+  for( NodeMapType::const_iterator it = range.first; it != range.second; ++it )
+  {
+    if( parent->GetChildPosition( it->second.GetPointer() ) < parent->GetNumberOfChildren() )
+      return it->second.GetPointer();
+  }
+  
+  return 0;
+}
+
+
+void GraphNodeIndex::AttachSubtree( GraphNode * node )
+{
+  std::vector<GraphNode*> pendingNodes( 1, node );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *current = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    // Nodes already indexed have their descendants indexed too
+    if( !current || current->m_NodeIndex == this )
+      continue;
+      
+    if( current->m_NodeIndex )
+      current->m_NodeIndex->RemoveNode( current );
+      
+    this->InsertNode( current );
+    
+    for( unsigned int i=0; i<current->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( current->GetChild(i) );
+  }
+  
+  this->Modified();
+}
+
+
+void GraphNodeIndex::DetachSubtree( GraphNode * node )
+{
+  // A node shared by several parents is checked again whenever one of them is removed,
+  // so it is only removed once all of them have been
+  std::vector<GraphNode*> pendingNodes( 1, node );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *current = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !current || current->m_NodeIndex != this || current == m_RootNode.GetPointer() || 
+      this->IsReachable( current ) )
+      continue;
+      
+    this->RemoveNode( current );
+    
+    for( unsigned int i=0; i<current->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( current->GetChild(i) );
+  }
+  
+  this->Modified();
+}
+
+
+void GraphNodeIndex::InsertNode( GraphNode * node )
+{
+  m_Nodes.insert( NodeMapType::value_type( node->GetNodeId(), node ) );
+  node->m_NodeIndex = this;
+}
+
+
+void GraphNodeIndex::RemoveNode( GraphNode * node )
+{
+  std::pair<NodeMapType::iterator,NodeMapType::iterator> range = m_Nodes.equal_range( node->GetNodeId() );
+  
+  for( NodeMapType::iterator it = range.first; it != range.second; ++it )
+  {
+    if( it->second.GetPointer() == node )
+    {
+      m_Nodes.erase( it );
+      break;
+    }
+  }
+  
+  node->m_NodeIndex = 0;
+  
+  if( m_RootNode.GetPointer() == node )
+    m_RootNode = 0;
+}
+
+
+void GraphNodeIndex::ChangeNodeId( GraphNode * node, NodeIdentifier oldId )
+{
+  std::pair<NodeMapType::iterator,NodeMapType::iterator> range = m_Nodes.equal_range( oldId );
+  
+  for( NodeMapType::iterator it = range.first; it != range.second; ++it )
+  {
+    if( it->second.GetPointer() == node )
+    {
+      m_Nodes.erase( it );
+      break;
+    }
+  }
+  
+  m_Nodes.insert( NodeMapType::value_type( node->GetNodeId(), node ) );
+}
+
+
+bool GraphNodeIndex::IsReachable( const GraphNode * node ) const
+{
+  // Parent links are not always removed with the child links, so check both
+  for( unsigned int i=0; i<node->GetNumberOfParents(); ++i )
+  {
+    const GraphNode *parent = node->GetParent(i);
+    
+    if( parent && parent->m_NodeIndex == this && 
+      parent->GetChildPosition( node ) < parent->GetNumberOfChildren() )
+      return true;
+  }
+  
+  return false;
+}
+
+
+void GraphNodeIndex::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfNodes: " << m_Nodes.size() << std::endl;
+  os << indent << "RootNode: " << m_RootNode.GetPointer() << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,150 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGraphNodeIndex.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: hash index of the nodes of a graph by identifier
+// Date: 2012/11/05
+
+#ifndef __ivanGraphNodeIndex_h
+#define __ivanGraphNodeIndex_h
+
+#include "ivanGraphNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#if ITK_VERSION_MAJOR < 4
+ #include "itk_hash_map.h"
+  #define ITK_HASH_MULTIMAP itk::hash_multimap
+#else
+ #include "itksys/hash_map.hxx"
+  #define ITK_HASH_MULTIMAP itksys::hash_multimap
+#endif
+
+
+namespace ivan
+{
+  
+/** \class GraphNodeIndex
+ *  \brief Hash index of the nodes of a graph by node identifier.
+ *
+ * The index is built from a root node and contains the nodes reachable from it. Every 
+ * indexed node keeps a reference to its index, so the index is updated by the node itself 
+ * when children are added, inserted, replaced or removed, or when its identifier changes. 
+ * Nodes that become unreachable from an indexed node are removed from the index, and nodes
+ * added below an indexed node are added to it. A node belongs to a single index at a time.
+ *
+ * Lookups take constant time on average. Several nodes may share an identifier, in which
+ * case any of them may be returned.
+ *
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT GraphNodeIndex : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef GraphNodeIndex                  Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef GraphNode::NodeIdentifier       NodeIdentifier;
+  
+  typedef ITK_HASH_MULTIMAP<NodeIdentifier,GraphNode::WPointer>  NodeMapType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( GraphNodeIndex, itk::Object );
+  
+  /** Index the nodes reachable from the given root, removing the previous ones. */
+  void Build( GraphNode * root );
+  
+  /** Remove all the nodes from the index. */
+  void Clear();
+  
+  const GraphNode * GetRootNode() const
+    { return m_RootNode.GetPointer(); }
+  
+  /** Get a node with the given identifier, or NULL if there is none. */
+  GraphNode * FindNode( NodeIdentifier id ) const;
+  
+  /** Get a node with the given identifier that is the given node or one of its descendants,
+    * or NULL if there is none. */
+  GraphNode * FindNode( NodeIdentifier id, const GraphNode * ancestor ) const;
+    
+  /** Get a child of the given node with the given identifier, or NULL if there is none. */
+  GraphNode * FindChild( const GraphNode * parent, NodeIdentifier id ) const;
+  
+  unsigned long GetNumberOfNodes() const
+    { return m_Nodes.size(); }
+    
+  /** Add the given node and its descendants. This is called by the nodes. */
+  void AttachSubtree( GraphNode * node );
+  
+  /** Remove the given node and the descendants that are no longer reachable from an indexed 
+    * node. This is called by the nodes. */
+  void DetachSubtree( GraphNode * node );
+  
+  /** Remove a single node. This is called by the nodes. */
+  void RemoveNode( GraphNode * node );
+  
+  /** Update the identifier of an indexed node. This is called by the nodes. */
+  void ChangeNodeId( GraphNode * node, NodeIdentifier oldId );
+		
+protected:
+
+  GraphNodeIndex();
+  ~GraphNodeIndex();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Add a single node. */
+  void InsertNode( GraphNode * node );
+  
+  /** Returns true if an indexed parent of the node still has it as a child. */
+  bool IsReachable( const GraphNode * node ) const;
+
+private:
+
+  GraphNodeIndex(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  NodeMapType          m_Nodes;
+  
+  GraphNode::WPointer  m_RootNode;
+};
+
+} // end namespace ivan
+
+#endif
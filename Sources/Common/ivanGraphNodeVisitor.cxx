@@ -28,13 +28,22 @@ SUCH DAMAGE.
 
 #include "ivanGraphNodeVisitor.h"
 
+#include "vnl/vnl_math.h"
+
 
 namespace ivan
 {
 
 GraphNodeVisitor::GraphNodeVisitor() :
   m_TraversalMode( TraverseAllChildren ),
-  m_TraversalMask( 0xffffffff )
+  m_TraversalMask( 0xffffffff ),
+  m_TraverseThroughMaskedNodes( false ),
+  m_NumberOfThreads( 1 ),
+  m_MinimumParallelSize( 1000 ),
+  m_ParallelGrainSize( 0 ),
+  m_DeferSubtrees( false ),
+  m_GrainSize( 0 ),
+  m_NextSubtree( 0 )
 {
 
 }
@@ -50,17 +59,225 @@ void GraphNodeVisitor::Visit( GraphNode * node )
 {
   // Call the appropiate Apply() method via dispatcher
 
-  DispatcherMapType::iterator it = m_DispatcherMap.find( node->GetNameOfClass() );
+  const GraphNode::NodeTypeIdentifier nodeTypeId = node->GetNodeTypeId();
+
+  if( nodeTypeId < m_DispatcherTable.size() && m_DispatcherTable[nodeTypeId].IsNotNull() )
+    m_DispatcherTable[nodeTypeId]->Apply( this, node );
+}
+
 
-  if( it != m_DispatcherMap.end() )
-    it->second->Apply( this, node );
+
+void GraphNodeVisitor::Start( GraphNode * node )
+{
+  // The traversal may be started again from a Visit() call, so only the pending nodes
+  // and node path added from here are processed
+  const unsigned int pendingBase = m_PendingNodes.size();
+  const unsigned int pathBase = m_NodePath.size();
+  
+  if( m_NumberOfThreads > 1 && pendingBase == 0 && !m_DeferSubtrees && 
+    m_TraversalMode != TraverseNone && !this->IsTraversingParents() )
+  {
+    if( this->StartParallel( node ) )
+      return;
+  }
+  
+  this->ScheduleNode( node );
+  this->VisitPendingNodes( pendingBase, pathBase );
 }
 
 
+void GraphNodeVisitor::VisitPendingNodes( unsigned int pendingBase, unsigned int pathBase )
+{
+  while( m_PendingNodes.size() > pendingBase )
+  {
+    const PendingNode pending = m_PendingNodes.back();
+    m_PendingNodes.pop_back();
+    
+    // Nodes scheduled after this one have already been visited
+    this->UnwindNodePath( pending.Depth );
+    
+    if( this->IsValidMask( pending.Node ) )
+    {
+      this->PushOntoNodePath( pending.Node );
+      this->Visit( pending.Node );
+    }
+    else if( m_TraverseThroughMaskedNodes && 
+      ( m_TraversalMode == TraverseAllChildren || m_TraversalMode == TraverseAllParents ) )
+    {
+      this->Traverse( pending.Node );
+    }
+  }
+  
+  this->UnwindNodePath( pathBase );
+}
+
+
+bool GraphNodeVisitor::StartParallel( GraphNode * node )
+{
+  const unsigned long numberOfNodes = this->ComputeSubtreeSizes( node );
+  
+  if( numberOfNodes < m_MinimumParallelSize )
+  {
+    m_SubtreeSizes.clear();
+    m_SharedSubtrees.clear();
+    return false;
+  }
+  
+  // One visitor per thread
+  m_TaskVisitors.clear();
+  
+  for( unsigned int i=0; i<m_NumberOfThreads; ++i )
+  {
+    Pointer taskVisitor = this->CreateTaskVisitor();
+    
+    if( taskVisitor.IsNull() || taskVisitor.GetPointer() == this )
+    {
+      m_TaskVisitors.clear();
+      m_SubtreeSizes.clear();
+      m_SharedSubtrees.clear();
+      return false;
+    }
+    
+    taskVisitor->SetTraversalMode( m_TraversalMode );
+    taskVisitor->SetTraversalMask( m_TraversalMask );
+    taskVisitor->SetTraverseThroughMaskedNodes( m_TraverseThroughMaskedNodes );
+    taskVisitor->SetNumberOfThreads( 1 );
+    m_TaskVisitors.push_back( taskVisitor );
+  }
+  
+  m_GrainSize = m_ParallelGrainSize;
+  
+  if( m_GrainSize == 0 )
+    m_GrainSize = vnl_math_max( numberOfNodes / ( 8 * m_NumberOfThreads ), 1ul );
+  
+  // Visit the graph deferring the small subtrees
+  m_DeferredSubtrees.clear();
+  m_DeferSubtrees = true;
+  
+  this->ScheduleNode( node );
+  this->VisitPendingNodes( 0, 0 );
+  
+  m_DeferSubtrees = false;
+  m_SubtreeSizes.clear();
+  m_SharedSubtrees.clear();
+  
+  // Visit the deferred subtrees in parallel
+  if( !m_DeferredSubtrees.empty() )
+  {
+    m_NextSubtree = 0;
+    
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, 
+      (unsigned int)m_DeferredSubtrees.size() ) );
+    threader->SetSingleMethod( this->VisitSubtreesThreaderCallback, this );
+    threader->SingleMethodExecute();
+    
+    for( unsigned int i=0; i<m_TaskVisitors.size(); ++i )
+      this->MergeTaskVisitor( m_TaskVisitors[i] );
+  }
+  
+  m_DeferredSubtrees.clear();
+  m_TaskVisitors.clear();
+  
+  return true;
+}
+
+
+unsigned long GraphNodeVisitor::ComputeSubtreeSizes( GraphNode * node )
+{
+  m_SubtreeSizes.clear();
+  m_SharedSubtrees.clear();
+  
+  // Nodes in depth-first order, so every child comes after its parent
+  std::vector<GraphNode*> nodes;
+  std::vector<GraphNode*> pending( 1, node );
+  
+  while( !pending.empty() )
+  {
+    GraphNode *current = pending.back();
+    pending.pop_back();
+    nodes.push_back( current );
+    
+    for( unsigned int i=0; i<current->GetNumberOfChildren(); ++i )
+      pending.push_back( current->GetChild(i) );
+  }
+  
+  for( unsigned int i=nodes.size(); i>0; --i )
+  {
+    GraphNode *current = nodes[i-1];
+    unsigned long size = 1;
+    
+    // A node reached through several parents makes its ancestors shared too, since any of 
+    // their subtrees may be visited from another path
+    bool shared = ( current->GetNumberOfParents() > 1 );
+    
+    for( unsigned int j=0; j<current->GetNumberOfChildren(); ++j )
+    {
+      size += m_SubtreeSizes[ current->GetChild(j) ];
+      shared = shared || m_SharedSubtrees.count( current->GetChild(j) ) > 0;
+    }
+      
+    m_SubtreeSizes[ current ] = size;
+    
+    if( shared )
+      m_SharedSubtrees.insert( current );
+  }
+  
+  return m_SubtreeSizes[ node ];
+}
+
+
+bool GraphNodeVisitor::DeferSubtree( GraphNode * node )
+{
+  std::map<const GraphNode*,unsigned long>::const_iterator it = m_SubtreeSizes.find( node );
+  
+  if( it == m_SubtreeSizes.end() || it->second > m_GrainSize || 
+    m_SharedSubtrees.count( node ) > 0 )
+    return false;
+    
+  m_DeferredSubtrees.push_back( node );
+  return true;
+}
+
+
+ITK_THREAD_RETURN_TYPE GraphNodeVisitor::VisitSubtreesThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  
+  Self *visitor = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  GraphNodeVisitor *taskVisitor = visitor->m_TaskVisitors[threadId];
+  unsigned int subtree;
+  
+  while( true )
+  {
+    visitor->m_SubtreeMutex.Lock();
+    subtree = visitor->m_NextSubtree++;
+    visitor->m_SubtreeMutex.Unlock();
+    
+    if( subtree >= visitor->m_DeferredSubtrees.size() )
+      break;
+      
+    taskVisitor->Start( visitor->m_DeferredSubtrees[subtree] );
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+void GraphNodeVisitor::UnwindNodePath( unsigned int size )
+{
+  while( m_NodePath.size() > size )
+  {
+    this->Leave( this->IsTraversingParents() ? m_NodePath.front() : m_NodePath.back() );
+    this->PopFromNodePath();
+  }
+}
+
 
 void GraphNodeVisitor::Traverse( GraphNode * node )
 {	
-  if( m_TraversalMode == TraverseAllParents )
+  if( this->IsTraversingParents() )
     node->Ascend( this );
   else if( m_TraversalMode != TraverseNone )
     node->Traverse( this );
@@ -73,6 +290,10 @@ void GraphNodeVisitor::PrintSelf( std::ostream& os, itk::Indent indent ) const
 
   os << indent << "TraversalMode: " << m_TraversalMode << std::endl;
   os << indent << "TraversalMask: " << m_TraversalMask << std::endl;
+  os << indent << "TraverseThroughMaskedNodes: " << m_TraverseThroughMaskedNodes << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "MinimumParallelSize: " << m_MinimumParallelSize << std::endl;
+  os << indent << "ParallelGrainSize: " << m_ParallelGrainSize << std::endl;
 }
 
 } // end namespace ivan
@@ -33,8 +33,13 @@ SUCH DAMAGE.
 #include "ivanGraphNode.h"
 #include "ivanGraphNodeVisitorDispatcher.h"
 
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+#include <deque>
 #include <map>
-#include <string>
+#include <set>
 
 namespace ivan
 {
@@ -60,14 +65,36 @@ namespace ivan
  * an appropiate non-virtual Apply() method for the given node types, that must be defined 
  * on the specific visitor. There is a dispatcher object for every node type that the 
  * visitor may be applied to. These objects are declared and constructed when the visitor
- * is created and stored in a map. When the visitor receives a given node type, it checks
- * in the map if a dispatcher is available for that node type (since the visitor is the
- * current object) and if so, the corresponding method is applied.
+ * is created and stored in a table indexed by the node type identifier, which every node 
+ * class gets from the itkNodeTypeMacro(). When the visitor receives a given node type, it 
+ * checks in the table if a dispatcher is available for that node type (since the visitor 
+ * is the current object) and if so, the corresponding method is applied. The lookup costs 
+ * a virtual call and an array access per node. Dispatchers are registered for exact node 
+ * classes, so a node whose class has no dispatcher is not applied, even if a dispatcher 
+ * exists for a superclass.
  *
  * Alternatively, subclasses may use other mechanisms such as RTTI (dynamic_cast<> or 
  * typeid operators) in order to call the appropiate non-virtual Apply()�methods. In any
  * case, these calls must be performed from a reimplementation of Visit(). 
  *
+ * The traversal does not recurse. GraphNode::Accept() calls Start(), which keeps an explicit
+ * stack of pending nodes, so arbitrarily long chains of nodes can be traversed. Calling 
+ * Traverse() from Visit() or Apply() schedules the children (or parents) of the node, which 
+ * are visited in the same order as a recursive depth-first traversal, after the current
+ * Visit() returns. Code that needs the descendants to be visited first must be placed in 
+ * Leave(), which is called when the traversal of the nodes scheduled from a node has finished.
+ *
+ * If NumberOfThreads is larger than one, children are traversed and the visitor supports it, 
+ * the subtrees with at most ParallelGrainSize nodes are not visited when they are scheduled. 
+ * The rest of the graph is visited first, and then the deferred subtrees are distributed among 
+ * the threads. Every thread uses its own visitor, obtained from CreateTaskVisitor(), which 
+ * visits whole subtrees serially. When all of them finish, their state is accumulated in this 
+ * visitor through MergeTaskVisitor(), in thread order. Subtrees are thus visited after their 
+ * ancestors have been left, and the node path of a task visitor starts at the subtree root.
+ * Subtrees containing a node with several parents are never deferred, so nodes shared by 
+ * several paths of an acyclic graph are visited by this visitor only, as in a serial traversal, 
+ * and never by two threads at once.
+ *
  * \ingroup 
  */
 
@@ -84,16 +111,19 @@ public:
   
   /** List of nodes. */
   typedef std::vector<Pointer>		 NodeContainer;
-  typedef GraphNode::NodePathType  NodePathType;
+  typedef std::deque<GraphNode*>   NodePathType;
   typedef GraphNode::NodeMaskType  NodeMaskType;
   
-  /** Map that allows to call the appropiate Apply() method defined in subclasses
+  /** Table that allows to call the appropiate Apply() method defined in subclasses
     * depending on the node type. This avoids declaring all node types here and 
     * allows flexibility for operating with new node types in the double-dispatch
-    * mechanism. The cost is that, for every Apply() call, we need to search the 
-    * node type in the map. */
-  typedef std::map<std::string,GraphNodeVisitorDispatcherBase::Pointer>   DispatcherMapType;
+    * mechanism. It is indexed by the node type identifier, and entries of node 
+    * types without dispatcher are null. */
+  typedef std::vector<GraphNodeVisitorDispatcherBase::Pointer>   DispatcherTableType;
     
+  /** Nodes traversed from a visited node. Nodes whose mask does not match the traversal mask
+    * are not visited, and neither are their children or parents, unless 
+    * TraverseThroughMaskedNodes is on in the All modes (see SetTraverseThroughMaskedNodes()). */
   enum TraversalModeType
   {
     TraverseNone = 0,
@@ -113,25 +143,85 @@ public:
   
   itkSetMacro( TraversalMask, NodeMaskType );
   itkGetConstMacro( TraversalMask, NodeMaskType );
+  
+  itkSetMacro( TraversalMode, TraversalModeType );
+  itkGetConstMacro( TraversalMode, TraversalModeType );
+  
+  /** Set/Get whether the All modes go on to the children or parents of the nodes whose mask 
+    * does not match the traversal mask, without visiting those nodes. The Active modes always 
+    * stop at them. Default is off. */
+  itkSetMacro( TraverseThroughMaskedNodes, bool );
+  itkGetConstMacro( TraverseThroughMaskedNodes, bool );
+  itkBooleanMacro( TraverseThroughMaskedNodes );
     
   /** Reset the visitor. Useful to reuse the visitor if it accumulates state during 
     * a traversal and we plan to reuse it. */
   virtual void Reset() {}
+  
+  /** Set/Get the number of threads used to visit independent subtrees. Default is 1. */
+  itkSetClampMacro( NumberOfThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+  /** Set/Get the minimum number of nodes reachable from the start node to traverse them in 
+    * parallel. Default is 1000. */
+  itkSetMacro( MinimumParallelSize, unsigned int );
+  itkGetConstMacro( MinimumParallelSize, unsigned int );
+  
+  /** Set/Get the maximum number of nodes of the subtrees visited by a single task. Zero 
+    * (default) uses the number of reachable nodes divided by 8 times the number of threads. */
+  itkSetMacro( ParallelGrainSize, unsigned int );
+  itkGetConstMacro( ParallelGrainSize, unsigned int );
+  
+  /** Create a visitor for visiting subtrees in parallel with this one. It must have the same 
+    * configuration but no accumulated state, and may share with this visitor only thread-safe 
+    * objects. Visitors that return null (the default) are always traversed serially. */
+  virtual Pointer CreateTaskVisitor() const
+    { return 0; }
+  
+  /** Accumulate the state of a task visitor once its subtrees have been visited. This is the 
+    * reduction step of the parallel traversal. Default does nothing. */
+  virtual void MergeTaskVisitor( GraphNodeVisitor * taskVisitor ) {}
 
   /** Start visiting given node. */
 	virtual void Visit( GraphNode * node );
 	
 	/** Generic apply method. This is called from the dispatcher. */
   void Apply( GraphNode * node ) {}
+  
+  /** Called when the traversal of the nodes scheduled from a visited node has finished, just
+    * before the node is removed from the node path. Default does nothing. */
+  virtual void Leave( GraphNode * node ) {}
+  
+  /** Visit the given node and the nodes traversed from it. This is called by 
+    * GraphNode::Accept(). */
+  void Start( GraphNode * node );
+  
+  /** Schedule a node to be visited after the current one. This is called by GraphNode::Traverse()
+    * and GraphNode::Ascend(). Scheduled nodes are visited in reverse order. NOTE: this method 
+    * is not intended to be called directly by the user but internally during the traversal. */
+  inline void ScheduleNode( GraphNode * node )
+    {
+      if( m_DeferSubtrees && this->DeferSubtree( node ) )
+        return;
+        
+      PendingNode pending;
+      pending.Node = node;
+      pending.Depth = m_NodePath.size();
+      m_PendingNodes.push_back( pending );
+    }
+  
+  /** Get the current node path. */
+  const NodePathType & GetNodePath() const
+    { return m_NodePath; }
 	
-  /** Method called by GraphNode::Accept() method in order to visit or not the
+  /** Method called by Start() in order to visit or not the
     * current node and its descendants or ancestors, depending on the traversal mode.
     * It returns the result of the bit-wise operation between the visitor's traversal
     * mask and the node's node mask. */
   inline bool IsValidMask( const GraphNode * node ) const
     { return ( this->GetTraversalMask() & node->GetMask() ) != 0; }
 		
-	/** Method called by GraphNode::Accept() before a call to the GraphNodeVisitor::Visit()
+	/** Method called by Start() before a call to the GraphNodeVisitor::Visit()
 	  * method. The back of the path will be the current node being visited inside the 
 	  * Visit() method and the rest of the path will be the parental sequence of nodes 
     * from the top most node applied down the graph to the current node. NOTE: this 
@@ -139,21 +229,21 @@ public:
 	  * the traversal process. */
   inline void PushOntoNodePath( GraphNode* node ) 
     { 
-      if ( m_TraversalMode != TraverseAllParents && m_TraversalMode != TraverseActiveParents )
+      if ( !this->IsTraversingParents() )
         m_NodePath.push_back( node ); // push at the back
       else
-        m_NodePath.insert( m_NodePath.begin(), node ); // insert at the front
+        m_NodePath.push_front( node ); // insert at the front
     }
         
-  /** Method called by GraphNode::Accept() method after a call to GraphNodeVisitor::Visit().
-    * It pops the current node from the node path. NOTE: this method is not intended to 
-    * be called directly by the user but internally during the traversal process. */
+  /** Method called by Start() once the nodes traversed from the current node have been 
+    * visited. It pops the current node from the node path. NOTE: this method is not intended  
+    * to be called directly by the user but internally during the traversal process. */
   inline void PopFromNodePath()
     { 
-      if ( m_TraversalMode != TraverseAllParents && m_TraversalMode != TraverseActiveParents )
+      if ( !this->IsTraversingParents() )
         m_NodePath.pop_back();
       else 
-        m_NodePath.erase( m_NodePath.begin() );
+        m_NodePath.pop_front();
     }
       
 protected:
@@ -166,8 +256,32 @@ protected:
   template <class TVisitor, class TNode>
   void AddDispatcher();
   
-  /** Traverse the current node. */
+  /** Traverse the current node. This schedules its children or parents depending on the 
+    * traversal mode. */
 	virtual void Traverse( GraphNode * node );
+	
+	bool IsTraversingParents() const
+	  { return m_TraversalMode == TraverseAllParents || m_TraversalMode == TraverseActiveParents; }
+	
+	/** Leave and pop the nodes of the path until it has the given size. */
+	void UnwindNodePath( unsigned int size );
+	
+	/** Visit the pending nodes added after the given number of pending nodes. */
+	void VisitPendingNodes( unsigned int pendingBase, unsigned int pathBase );
+	
+	/** Visit the graph first, deferring small subtrees, and then visit them in parallel. 
+	  * Returns false if the graph is not traversed because it is too small. */
+	bool StartParallel( GraphNode * node );
+	
+	/** Store the number of nodes of every subtree reachable from the node, and return it. */
+	unsigned long ComputeSubtreeSizes( GraphNode * node );
+	
+	/** Add the node to the deferred subtrees if it is small enough and does not contain nodes 
+	  * with several parents. */
+	bool DeferSubtree( GraphNode * node );
+	
+	/** Visit the deferred subtrees taken from the shared counter until there are no more. */
+	static ITK_THREAD_RETURN_TYPE VisitSubtreesThreaderCallback( void *arg );
   
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
@@ -178,25 +292,56 @@ private:
 
 protected:
 
-  /** Help map that redirects calls to appropiate Apply() method depending on node type. 
+  /** Help table that redirects calls to appropiate Apply() method depending on node type. 
     * Subclasses must register their own visitor-node pair types here. */
-  DispatcherMapType    m_DispatcherMap;
+  DispatcherTableType  m_DispatcherTable;
 
   /** Traversal type. Default is TraverseAllChildren. */
   TraversalModeType    m_TraversalMode;
 
   /** Mask that can be used during traversal. */
   NodeMaskType         m_TraversalMask;
+  
+  bool                 m_TraverseThroughMaskedNodes;
     
   /** Current node path. */
   NodePathType         m_NodePath;
+  
+  /** Node waiting to be visited, with the size of the node path when it was scheduled. */
+  struct PendingNode
+  {
+    GraphNode     *Node;
+    unsigned int  Depth;
+  };
+  
+  /** Stack of the nodes waiting to be visited. */
+  std::vector<PendingNode>  m_PendingNodes;
+  
+  /** Parallel traversal. */
+  unsigned int         m_NumberOfThreads;
+  unsigned int         m_MinimumParallelSize;
+  unsigned int         m_ParallelGrainSize;
+  
+  bool                                    m_DeferSubtrees;
+  unsigned long                           m_GrainSize;
+  std::map<const GraphNode*,unsigned long>  m_SubtreeSizes;
+  std::set<const GraphNode*>              m_SharedSubtrees;
+  std::vector<GraphNode*>                 m_DeferredSubtrees;
+  std::vector<Pointer>                    m_TaskVisitors;
+  unsigned int                            m_NextSubtree;
+  itk::SimpleFastMutexLock                m_SubtreeMutex;
 };
 
 
 template <class TVisitor, class TNode>
 void GraphNodeVisitor::AddDispatcher()
 {
-  m_DispatcherMap[ TNode::GetNameOfClassStatic() ] = GraphNodeVisitorDispatcher<TVisitor,TNode>::New();
+  const GraphNode::NodeTypeIdentifier nodeTypeId = TNode::GetNodeTypeIdStatic();
+  
+  if( nodeTypeId >= m_DispatcherTable.size() )
+    m_DispatcherTable.resize( nodeTypeId + 1 );
+    
+  m_DispatcherTable[ nodeTypeId ] = GraphNodeVisitorDispatcher<TVisitor,TNode>::New();
 }
 
 
@@ -0,0 +1,113 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHalfFloat.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: half-precision storage of real values
+// Date: 2012/11/05
+
+#ifndef __ivanHalfFloat_h
+#define __ivanHalfFloat_h
+
+#include "ivanCPUDispatch.h"
+
+namespace ivan
+{
+/**
+ * \class HalfFloat
+ * \brief Storage of a real value in half precision (IEEE 754 binary16).
+ *
+ * Half-precision values take two bytes and keep an 11 bit significand, so the relative error
+ * of the storage is at most 2^-11 (about 4.9e-4) for magnitudes between 6.1e-5 and 65504. 
+ * Smaller magnitudes are stored as subnormals with an absolute error of 3e-8, and larger 
+ * ones become infinite. This suits caches of derivatives that are read many times, where
+ * halving the memory traffic matters more than the last digits. The values must be widened 
+ * to float before any arithmetic, and sums should be accumulated in float or double.
+ *
+ * The conversion of single values is done in software. ConvertToFloat() and ConvertFromFloat() 
+ * convert arrays with the conversion kernels of CPUDispatch, which use the F16C instructions 
+ * on x86 (with AVX2) and the NEON instructions on AArch64. All of them round to nearest even.
+ *
+ * HalfFloat only holds the 16 bits of the value, so arrays of HalfFloat can be converted in bulk.
+ *
+ * \sa CPUDispatch
+ */
+class ITK_EXPORT HalfFloat
+{
+public:
+
+  /** Bits of the half-precision value. */
+  typedef unsigned short BitsType;
+  
+  HalfFloat() : m_Bits( 0 ) {}
+  
+  explicit HalfFloat( float value ) : m_Bits( ToBits( value ) ) {}
+  
+  /** Widen to float. */
+  operator float() const
+    { return ToFloat( m_Bits ); }
+  
+  BitsType GetBits() const
+    { return m_Bits; }
+  
+  static HalfFloat FromBits( BitsType bits )
+    {
+      HalfFloat value;
+      value.m_Bits = bits;
+      return value;
+    }
+  
+  /** Conversion of single values. */
+  static BitsType ToBits( float value );
+  static float ToFloat( BitsType bits );
+  
+  /** Conversion of n values with the kernels of the active instruction set. */
+  static void ConvertToFloat( const HalfFloat *values, unsigned long n, float *result )
+    {
+      CPUDispatch::GetKernels().ConvertHalfRowToFloat( 
+        reinterpret_cast<const BitsType *>( values ), n, result );
+    }
+  
+  static void ConvertFromFloat( const float *values, unsigned long n, HalfFloat *result )
+    {
+      CPUDispatch::GetKernels().ConvertFloatRowToHalf( 
+        values, n, reinterpret_cast<BitsType *>( result ) );
+    }
+  
+  /** Largest finite half-precision value. */
+  static float GetMaximumValue()
+    { return 65504.0f; }
+  
+  /** Bound of the relative error of the storage of normal values. */
+  static float GetMaximumRelativeError()
+    { return 1.0f / 2048.0f; }
+
+private:
+
+  BitsType   m_Bits;
+};
+
+} // end namespace ivan
+
+#endif
@@ -34,6 +34,9 @@ SUCH DAMAGE.
 
 #include "itkVector.h"
 #include "itkPoint.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <list>
 
 
 namespace ivan
@@ -50,6 +53,15 @@ namespace ivan
  * This is intended to be used with ImageFunction values that are to be minimized or maximized in 
  * a given 3D plane.
  *
+ * Optimizers tend to query the same or very close parameters several times, for instance the
+ * simplex when it shrinks or the line searches of gradient-based methods. The last CacheSize values 
+ * are kept in a least recently used cache, so that these queries do not evaluate the image 
+ * function again. Parameters are quantized with CacheTolerance, that is, two queries whose 
+ * parameters round to the same multiple of the tolerance share the value. With a zero tolerance 
+ * (default) only identical parameters hit the cache. The cache is cleared when the plane or the 
+ * image function is modified. The number of evaluations and cache hits can be queried to measure 
+ * the cost of the optimization.
+ *
  * This works with single-valued images only.
  *
  * This class works for 3D images only.
@@ -80,6 +92,7 @@ public:
   /** Image function related typedefs. */
   typedef typename Superclass::ImageFunctionType             ImageFunctionType;
   typedef typename Superclass::ImageFunctionPointer          ImageFunctionPointer;
+  typedef typename Superclass::GradientType                  GradientType;
   
   typedef itk::Vector<double, ImageType::ImageDimension>     VectorType;
   typedef itk::Matrix<double, ImageType::ImageDimension, 
@@ -99,13 +112,14 @@ public:
     * P(X) = P0(X) + alpha * e1(X) + beta * e2(X). */
   virtual MeasureType GetValue( const ParametersType & parameters ) const;
   
-  virtual void GetDerivative( const ParametersType  &parameters, DerivativeType & derivative ) const
-    { itkWarningMacro( "Derivative not implemented yet." ); }
+  /** Get the derivatives with respect to alpha and beta, which are the projections of the image
+    * function gradient on the base vectors (see ImageFunctionToCostFunctionAdaptor). */
+  virtual void GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const;
     
   virtual unsigned int GetNumberOfParameters(void) const
     { return 2; }
     
-  itkSetMacro( PlaneCenter, PointType & );
+  virtual void SetPlaneCenter( const PointType & center );
   itkGetConstMacro( PlaneCenter, const PointType & );
     
   virtual void SetPlaneNormal( const VectorType & normal );
@@ -117,6 +131,47 @@ public:
   /** Get the base vectors of the current plane as a matrix. Columns represent the base 
     * vectors for the plane (2) and rows the coordinates (3). */
   BaseMatrixType GetPlaneBaseMatrix() const;
+  
+  /** Set/Get the maximum number of values kept in the cache. Zero disables the cache. 
+    * Default is 16. */
+  virtual void SetCacheSize( unsigned int size );
+  itkGetConstMacro( CacheSize, unsigned int );
+  
+  /** Set/Get the quantization step of the parameters for the cache, in physical units. 
+    * Default is 0.0, only identical parameters are matched. */
+  virtual void SetCacheTolerance( double tolerance );
+  itkGetConstMacro( CacheTolerance, double );
+  
+  /** Remove all the values of the cache. */
+  void ClearCache() const;
+  
+  /** Number of evaluations of the image function done by GetValue(). */
+  unsigned long GetNumberOfEvaluations() const;
+  
+  /** Number of GetValue() calls solved by the cache. */
+  unsigned long GetNumberOfCacheHits() const;
+  
+  /** Reset the evaluation and cache hit counters. */
+  void ResetCounters();
+  
+protected:
+  
+  /** Get the point of the plane for the given parameters. */
+  PointType GetPlanePoint( const ParametersType & parameters ) const;
+  
+  /** Value of the cache for the given parameters. */
+  struct CacheEntryType
+  {
+    double         Alpha;
+    double         Beta;
+    MeasureType    Value;
+  };
+  
+  /** Entries from the most to the least recently used. */
+  typedef std::list<CacheEntryType>   CacheContainerType;
+  
+  /** Quantize the parameters with the cache tolerance. */
+  void QuantizeParameters( const ParametersType & parameters, double & alpha, double & beta ) const;
 
 protected:
   
@@ -137,6 +192,20 @@ protected:
   
   VectorType       m_PlaneFirstBaseVector;
   VectorType       m_PlaneSecondBaseVector;
+  
+  unsigned int     m_CacheSize;
+  double           m_CacheTolerance;
+  
+  mutable CacheContainerType        m_Cache;
+  
+  /** Modified time of the image function when the cache was filled. */
+  mutable unsigned long             m_CacheImageFunctionMTime;
+  
+  mutable unsigned long             m_NumberOfEvaluations;
+  mutable unsigned long             m_NumberOfCacheHits;
+  
+  /** Mutex for accessing the cache and counters from several threads (see GetValues()). */
+  mutable itk::SimpleFastMutexLock  m_CacheMutex;
 };
 
 } // end namespace ivan
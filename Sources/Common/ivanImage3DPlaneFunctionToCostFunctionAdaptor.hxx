@@ -35,6 +35,8 @@ SUCH DAMAGE.
 
 #include "vnl/vnl_vector_fixed.h"
 
+#include <cmath>
+
 
 namespace ivan
 {
@@ -44,7 +46,12 @@ namespace ivan
  */
 template<class TImage>
 Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
-::Image3DPlaneFunctionToCostFunctionAdaptor()
+::Image3DPlaneFunctionToCostFunctionAdaptor() :
+  m_CacheSize( 16 ),
+  m_CacheTolerance( 0.0 ),
+  m_CacheImageFunctionMTime( 0 ),
+  m_NumberOfEvaluations( 0 ),
+  m_NumberOfCacheHits( 0 )
 {
   this->m_PlaneCenter.Fill( 0.0 );
   this->m_PlaneNormal.Fill( 0.0 );
@@ -83,11 +90,152 @@ Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
   this->m_PlaneSecondBaseVector[0] = secondBaseVector[0];
   this->m_PlaneSecondBaseVector[1] = secondBaseVector[1];
   this->m_PlaneSecondBaseVector[2] = secondBaseVector[2];
+  
+  this->ClearCache();
 
   this->Modified(); 
 }
 
 
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::SetPlaneCenter( const PointType & center )
+{
+  this->m_PlaneCenter = center;
+  
+  this->ClearCache();
+  
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::SetCacheSize( unsigned int size )
+{
+  if( this->m_CacheSize == size )
+    return;
+  
+  this->m_CacheSize = size;
+  
+  this->ClearCache();
+  
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::SetCacheTolerance( double tolerance )
+{
+  if( tolerance < 0.0 )
+    tolerance = 0.0;
+  
+  if( this->m_CacheTolerance == tolerance )
+    return;
+  
+  this->m_CacheTolerance = tolerance;
+  
+  this->ClearCache();
+  
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::ClearCache() const
+{
+  this->m_CacheMutex.Lock();
+  this->m_Cache.clear();
+  this->m_CacheMutex.Unlock();
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+unsigned long
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::GetNumberOfEvaluations() const
+{
+  this->m_CacheMutex.Lock();
+  unsigned long numberOfEvaluations = this->m_NumberOfEvaluations;
+  this->m_CacheMutex.Unlock();
+  
+  return numberOfEvaluations;
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+unsigned long
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::GetNumberOfCacheHits() const
+{
+  this->m_CacheMutex.Lock();
+  unsigned long numberOfCacheHits = this->m_NumberOfCacheHits;
+  this->m_CacheMutex.Unlock();
+  
+  return numberOfCacheHits;
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::ResetCounters()
+{
+  this->m_CacheMutex.Lock();
+  this->m_NumberOfEvaluations = 0;
+  this->m_NumberOfCacheHits = 0;
+  this->m_CacheMutex.Unlock();
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::QuantizeParameters( const ParametersType & parameters, double & alpha, double & beta ) const
+{
+  if( this->m_CacheTolerance > 0.0 )
+  {
+    alpha = std::floor( parameters[0] / this->m_CacheTolerance + 0.5 );
+    beta = std::floor( parameters[1] / this->m_CacheTolerance + 0.5 );
+  }
+  else
+  {
+    alpha = parameters[0];
+    beta = parameters[1];
+  }
+}
+
+
 /**
  *
  */
@@ -95,6 +243,115 @@ template<class TImage>
 typename Image3DPlaneFunctionToCostFunctionAdaptor<TImage>::MeasureType
 Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
 ::GetValue( const ParametersType & parameters ) const
+{
+  double alpha, beta;
+  
+  if( this->m_CacheSize > 0 )
+  {
+    this->QuantizeParameters( parameters, alpha, beta );
+    
+    this->m_CacheMutex.Lock();
+    
+    // Values of a previous image function (or of a modified one) are no longer valid
+    const unsigned long imageFunctionMTime = this->GetImageFunction()->GetMTime();
+    
+    if( imageFunctionMTime != this->m_CacheImageFunctionMTime )
+    {
+      this->m_Cache.clear();
+      this->m_CacheImageFunctionMTime = imageFunctionMTime;
+    }
+    
+    for( typename CacheContainerType::iterator it = this->m_Cache.begin(); 
+      it != this->m_Cache.end(); ++it )
+    {
+      if( it->Alpha == alpha && it->Beta == beta )
+      {
+        const MeasureType value = it->Value;
+        
+        // Move to the front as the most recently used
+        this->m_Cache.splice( this->m_Cache.begin(), this->m_Cache, it );
+        ++this->m_NumberOfCacheHits;
+        
+        this->m_CacheMutex.Unlock();
+        
+        return value;
+      }
+    }
+    
+    this->m_CacheMutex.Unlock();
+  }
+  
+  const PointType point = this->GetPlanePoint( parameters );
+  
+  MeasureType value;
+  
+  // Bounds check
+  if( this->GetImageFunction()->IsInsideBuffer( point ) )
+    value = static_cast<MeasureType>( this->GetImageFunction()->Evaluate( point ) );
+  else 
+    value = itk::NumericTraits<MeasureType>::min();
+  
+  this->m_CacheMutex.Lock();
+  
+  ++this->m_NumberOfEvaluations;
+  
+  if( this->m_CacheSize > 0 )
+  {
+    // Another thread may have stored the same parameters meanwhile, which is harmless
+    CacheEntryType entry;
+    entry.Alpha = alpha;
+    entry.Beta = beta;
+    entry.Value = value;
+    
+    this->m_Cache.push_front( entry );
+    
+    if( this->m_Cache.size() > this->m_CacheSize )
+      this->m_Cache.pop_back();
+  }
+  
+  this->m_CacheMutex.Unlock();
+  
+  return value;
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+void
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const
+{
+  GradientType gradient;
+  
+  derivative.SetSize( 2 );
+  
+  if( !this->EvaluateGradient( this->GetPlanePoint( parameters ), gradient ) )
+  {
+    derivative.Fill( 0.0 );
+    return;
+  }
+  
+  // Chain rule, dP/dalpha = e1 and dP/dbeta = e2
+  derivative[0] = 0.0;
+  derivative[1] = 0.0;
+  
+  for( unsigned int dim=0; dim < ImageType::GetImageDimension(); ++dim )
+  {
+    derivative[0] += gradient[dim] * this->m_PlaneFirstBaseVector[dim];
+    derivative[1] += gradient[dim] * this->m_PlaneSecondBaseVector[dim];
+  }
+}
+
+
+/**
+ *
+ */
+template<class TImage>
+typename Image3DPlaneFunctionToCostFunctionAdaptor<TImage>::PointType
+Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
+::GetPlanePoint( const ParametersType & parameters ) const
 {
   // P(X) = P0(X) + alpha * e1(X) + beta * e2(X) where alpha = parameters[0] and beta = parameters[1]
   
@@ -105,11 +362,7 @@ Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
       static_cast<typename PointType::ValueType>( parameters[0] ) * this->m_PlaneFirstBaseVector[dim] +
       static_cast<typename PointType::ValueType>( parameters[1] ) * this->m_PlaneSecondBaseVector[dim];
   
-  // Bounds check
-  if( this->GetImageFunction()->IsInsideBuffer( point ) )
-    return static_cast<MeasureType>( this->GetImageFunction()->Evaluate( point ) );
-  else 
-    return itk::NumericTraits<MeasureType>::min();
+  return point;
 }
 
 
@@ -143,6 +396,10 @@ Image3DPlaneFunctionToCostFunctionAdaptor<TImage>
   os << indent << "PlaneNormal: " << this->m_PlaneNormal << std::endl;
   os << indent << "PlaneFirstBaseVector: " << this->m_PlaneFirstBaseVector << std::endl;
   os << indent << "PlaneSecondBaseVector: " << this->m_PlaneSecondBaseVector << std::endl;
+  os << indent << "CacheSize: " << this->m_CacheSize << std::endl;
+  os << indent << "CacheTolerance: " << this->m_CacheTolerance << std::endl;
+  os << indent << "NumberOfEvaluations: " << this->GetNumberOfEvaluations() << std::endl;
+  os << indent << "NumberOfCacheHits: " << this->GetNumberOfCacheHits() << std::endl;
 }
 
 } // end namespace ivan
@@ -30,8 +30,9 @@ SUCH DAMAGE.
 #ifndef __ivanImageFunctionToCostFunctionAdaptor_h
 #define __ivanImageFunctionToCostFunctionAdaptor_h
 
-#include "itkSingleValuedCostFunction.h"
+#include "ivanBatchSingleValuedCostFunction.h"
 #include "itkImageFunction.h"
+#include "itkCovariantVector.h"
 
 
 namespace ivan
@@ -45,15 +46,26 @@ namespace ivan
  * as the N-dimensional point location in image space where the ImageFunction value is interpolated.
  * This works with single-valued images only.
  *
+ * Sets of positions can be evaluated concurrently with GetValues() (see 
+ * BatchSingleValuedCostFunction), as long as the Evaluate() method of the image function is 
+ * thread-safe, as is the case of the ITK interpolators.
+ *
+ * The derivative with respect to the position is the gradient of the image function. If a 
+ * GradientFunction is given, such as an itk::CentralDifferenceImageFunction of a vesselness
+ * image or a Gaussian derivative function of the input, it is used directly. Otherwise the 
+ * gradient is approximated with central differences of the image function, with
+ * DerivativeStepLength, which by default is half the minimum spacing of the image. This allows 
+ * gradient-based optimizers to be used.
+ *
  */
 
 template <class TImage>
-class ITK_EXPORT ImageFunctionToCostFunctionAdaptor : public itk::SingleValuedCostFunction
+class ITK_EXPORT ImageFunctionToCostFunctionAdaptor : public BatchSingleValuedCostFunction
 {
 public:
   /** Standard class typedefs. */
   typedef ImageFunctionToCostFunctionAdaptor<TImage>  Self;
-  typedef itk::SingleValuedCostFunction               Superclass;
+  typedef BatchSingleValuedCostFunction               Superclass;
   typedef itk::SmartPointer<Self>                     Pointer;
   typedef itk::SmartPointer<const Self>               ConstPointer;
   
@@ -71,21 +83,30 @@ public:
   typedef itk::ImageFunction<ImageType,MeasureType,MeasureType>  ImageFunctionType;
   typedef typename ImageFunctionType::Pointer                    ImageFunctionPointer;
   
+  /** Gradient of the image function with respect to the position. */
+  typedef itk::CovariantVector<MeasureType,
+    ImageType::ImageDimension>                                   GradientType;
+  typedef itk::ImageFunction<ImageType,GradientType,MeasureType> GradientFunctionType;
+  typedef typename GradientFunctionType::Pointer                 GradientFunctionPointer;
+  
 public:
 
   /** Method for creation through the object factory. */
   //itkNewMacro( Self );
   
   /** Run-time type information (and related methods). */
-  itkTypeMacro( ImageFunctionToCostFunctionAdaptor, itk::SingleValuedCostFunction );
+  itkTypeMacro( ImageFunctionToCostFunctionAdaptor, BatchSingleValuedCostFunction );
   
   /** Get the value at the desired point. If the point is out of image bounds, the minimum 
     * value NumericTraits<MeasureType>::min() is returned. The parameters represent the N-D point
     * coordinates. */
   virtual MeasureType GetValue( const ParametersType & parameters ) const;
   
-  //virtual void GetDerivative( const ParametersType  &parameters, DerivativeType & derivative ) const
-    //{ itkWarningMacro( "Derivative not implemented yet." ); }
+  /** Get the gradient at the desired point. The derivative is zero out of image bounds. */
+  virtual void GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const;
+  
+  virtual void GetValueAndDerivative( const ParametersType & parameters, MeasureType & value,
+    DerivativeType & derivative ) const;
     
   virtual unsigned int GetNumberOfParameters(void) const
     { return ImageType::GetImageDimension(); }
@@ -96,12 +117,28 @@ public:
     { return m_ImageFunction; }
   const ImageFunctionType * GetImageFunction() const
     { return m_ImageFunction; }
+  
+  /** Set/Get the function giving the gradient of the image function. If not set, central 
+    * differences are used. */
+  void SetGradientFunction( GradientFunctionType *func )
+    { m_GradientFunction = func; }
+  const GradientFunctionType * GetGradientFunction() const
+    { return m_GradientFunction; }
+  
+  /** Set/Get the step length for the central differences, in physical units. If not positive,
+    * half the minimum image spacing is used. Default is 0.0. */
+  itkSetMacro( DerivativeStepLength, double );
+  itkGetConstMacro( DerivativeStepLength, double );
 
 protected:
   
   ImageFunctionToCostFunctionAdaptor();
   virtual ~ImageFunctionToCostFunctionAdaptor() {}
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Compute the gradient of the image function at the given point. Returns false if the point is 
+    * out of image bounds. */
+  bool EvaluateGradient( const PointType & point, GradientType & gradient ) const;
       
 private:
   ImageFunctionToCostFunctionAdaptor(const Self&); //purposely not implemented
@@ -109,7 +146,11 @@ private:
   
 protected:
   
-  ImageFunctionPointer  m_ImageFunction;
+  ImageFunctionPointer     m_ImageFunction;
+  
+  GradientFunctionPointer  m_GradientFunction;
+  
+  double                   m_DerivativeStepLength;
 };
 
 } // end namespace ivan
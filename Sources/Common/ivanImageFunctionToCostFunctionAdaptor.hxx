@@ -32,6 +32,8 @@ SUCH DAMAGE.
 
 #include "ivanImageFunctionToCostFunctionAdaptor.h"
 
+#include <vnl/vnl_math.h>
+
 
 namespace ivan
 {
@@ -41,7 +43,8 @@ namespace ivan
  */
 template <class TImageFunction>
 ImageFunctionToCostFunctionAdaptor<TImageFunction>
-::ImageFunctionToCostFunctionAdaptor()
+::ImageFunctionToCostFunctionAdaptor() :
+  m_DerivativeStepLength( 0.0 )
 {
 
 }
@@ -68,6 +71,114 @@ ImageFunctionToCostFunctionAdaptor<TImageFunction>
 }
 
 
+/**
+ *
+ */
+template <class TImageFunction>
+void
+ImageFunctionToCostFunctionAdaptor<TImageFunction>
+::GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const
+{
+  PointType point;
+  
+  for( unsigned int i=0; i<ImageType::GetImageDimension(); ++i )
+    point[i] = static_cast<typename PointType::ValueType>( parameters[i] );
+  
+  GradientType gradient;
+  
+  if( !this->EvaluateGradient( point, gradient ) )
+    gradient.Fill( 0.0 );
+  
+  derivative.SetSize( ImageType::GetImageDimension() );
+  
+  for( unsigned int i=0; i<ImageType::GetImageDimension(); ++i )
+    derivative[i] = gradient[i];
+}
+
+
+/**
+ *
+ */
+template <class TImageFunction>
+void
+ImageFunctionToCostFunctionAdaptor<TImageFunction>
+::GetValueAndDerivative( const ParametersType & parameters, MeasureType & value,
+  DerivativeType & derivative ) const
+{
+  value = this->GetValue( parameters );
+  this->GetDerivative( parameters, derivative );
+}
+
+
+/**
+ *
+ */
+template <class TImageFunction>
+bool
+ImageFunctionToCostFunctionAdaptor<TImageFunction>
+::EvaluateGradient( const PointType & point, GradientType & gradient ) const
+{
+  if( !this->GetImageFunction()->IsInsideBuffer( point ) )
+    return false;
+  
+  if( this->m_GradientFunction.IsNotNull() )
+  {
+    if( !this->m_GradientFunction->IsInsideBuffer( point ) )
+      return false;
+    
+    gradient = this->m_GradientFunction->Evaluate( point );
+    return true;
+  }
+  
+  double stepLength = this->m_DerivativeStepLength;
+  
+  if( stepLength <= 0.0 )
+  {
+    const typename ImageType::SpacingType & spacing = 
+      this->GetImageFunction()->GetInputImage()->GetSpacing();
+    
+    stepLength = spacing[0];
+    
+    for( unsigned int i=1; i<ImageType::GetImageDimension(); ++i )
+      stepLength = vnl_math_min( stepLength, (double)spacing[i] );
+    
+    stepLength *= 0.5;
+  }
+  
+  // One-sided differences at the border of the buffer
+  for( unsigned int i=0; i<ImageType::GetImageDimension(); ++i )
+  {
+    PointType forwardPoint = point;
+    PointType backwardPoint = point;
+    
+    forwardPoint[i] += stepLength;
+    backwardPoint[i] -= stepLength;
+    
+    double distance = 2.0 * stepLength;
+    
+    if( !this->GetImageFunction()->IsInsideBuffer( forwardPoint ) )
+    {
+      forwardPoint = point;
+      distance -= stepLength;
+    }
+    
+    if( !this->GetImageFunction()->IsInsideBuffer( backwardPoint ) )
+    {
+      backwardPoint = point;
+      distance -= stepLength;
+    }
+    
+    if( distance > 0.0 )
+      gradient[i] = ( this->GetImageFunction()->Evaluate( forwardPoint ) - 
+        this->GetImageFunction()->Evaluate( backwardPoint ) ) / distance;
+    else
+      gradient[i] = 0.0;
+  }
+  
+  return true;
+}
+
+
 /**
  *
  */
@@ -77,6 +188,9 @@ ImageFunctionToCostFunctionAdaptor<TImageFunction>
 ::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
+  
+  os << indent << "GradientFunction: " << this->m_GradientFunction.GetPointer() << std::endl;
+  os << indent << "DerivativeStepLength: " << this->m_DerivativeStepLength << std::endl;
 }
 
 } // end namespace ivan
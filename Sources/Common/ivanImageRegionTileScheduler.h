@@ -0,0 +1,140 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageRegionTileScheduler.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe queue of tiles of an image region, pulled dynamically by threads
+// Date: 2012/11/05
+
+#ifndef __ivanImageRegionTileScheduler_h
+#define __ivanImageRegionTileScheduler_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+namespace ivan
+{
+/**
+ * \class ImageRegionTileScheduler
+ * \brief Thread-safe queue of the tiles of an image region, dynamically pulled by threads.
+ *
+ * The region is divided in tiles of TileSize pixels per dimension (smaller at the borders).
+ * Each thread repeatedly calls GetNextTile() and processes the returned tile until no tiles 
+ * are left. Threads that process cheap tiles (background) simply take more of them, so the 
+ * work is balanced when the cost per pixel varies much across the image, which is not the 
+ * case with the static slab splitting of itk::ImageSource.
+ *
+ * Call Initialize() after setting the region and the tile size, and before the threads start.
+ *
+ * This class is templated over the image dimension.
+ *
+ * \sa ImageFunctionBasedImageFilter
+ * \sa MultiscaleMedialnessImageFilter
+ */
+template <unsigned int VImageDimension>
+class ITK_EXPORT ImageRegionTileScheduler : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ImageRegionTileScheduler        Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageRegionTileScheduler, Object );
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VImageDimension );
+  
+  typedef itk::ImageRegion<VImageDimension>       RegionType;
+  typedef typename RegionType::IndexType          IndexType;
+  typedef typename RegionType::SizeType           SizeType;
+  
+  typedef std::vector<RegionType>                 TileContainerType;
+  
+public:
+  
+  /** Set/Get the region to divide. */
+  itkSetMacro( Region, RegionType );
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  /** Set/Get the size of the tiles. Default is 16 pixels in each dimension. */
+  itkSetMacro( TileSize, SizeType );
+  itkGetConstReferenceMacro( TileSize, SizeType );
+  
+  /** Set the same tile size for all the dimensions. */
+  void SetTileSize( unsigned long tileSize );
+  
+  /** Divide the region in tiles and rewind the queue. */
+  void Initialize();
+  
+  /** Get the next tile not yet given to any thread. Returns false if there are no tiles left.
+    * Can be called concurrently from several threads. */
+  bool GetNextTile( RegionType& tile );
+  
+  /** Get the number of tiles of the region. */
+  unsigned long GetNumberOfTiles() const
+    { return this->m_Tiles.size(); }
+  
+protected:
+
+  ImageRegionTileScheduler();
+  ~ImageRegionTileScheduler() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  ImageRegionTileScheduler( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  RegionType            m_Region;
+  SizeType              m_TileSize;
+  
+  TileContainerType     m_Tiles;
+  
+  /** Position of the next tile to give in the container. */
+  unsigned long         m_NextTile;
+  
+  /** Mutex for accessing the queue from several threads. */
+  itk::SimpleFastMutexLock    m_Mutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanImageRegionTileScheduler.hxx"
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageRegionTileScheduler.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe queue of tiles of an image region, pulled dynamically by threads
+// Date: 2012/11/05
+
+#ifndef __ivanImageRegionTileScheduler_hxx
+#define __ivanImageRegionTileScheduler_hxx
+
+#include "ivanImageRegionTileScheduler.h"
+
+#include "vnl/vnl_math.h"
+
+namespace ivan
+{
+
+template <unsigned int VImageDimension>
+ImageRegionTileScheduler<VImageDimension>
+::ImageRegionTileScheduler() :
+  m_NextTile( 0 )
+{
+  this->m_TileSize.Fill( 16 );
+}
+
+
+template <unsigned int VImageDimension>
+void
+ImageRegionTileScheduler<VImageDimension>
+::SetTileSize( unsigned long tileSize )
+{
+  SizeType size;
+  size.Fill( tileSize );
+  this->SetTileSize( size );
+}
+
+
+template <unsigned int VImageDimension>
+void
+ImageRegionTileScheduler<VImageDimension>
+::Initialize()
+{
+  this->m_Tiles.clear();
+  this->m_NextTile = 0;
+  
+  const IndexType regionIndex = this->m_Region.GetIndex();
+  const SizeType regionSize = this->m_Region.GetSize();
+  
+  // Number of tiles along each dimension
+  unsigned long numberOfTiles[VImageDimension];
+  unsigned long totalTiles = 1;
+  
+  for( unsigned int i=0; i<VImageDimension; ++i )
+  {
+    if( this->m_TileSize[i] == 0 )
+      itkExceptionMacro( "Tile size must be greater than zero." );
+    
+    numberOfTiles[i] = ( regionSize[i] + this->m_TileSize[i] - 1 ) / this->m_TileSize[i];
+    totalTiles *= numberOfTiles[i];
+  }
+  
+  this->m_Tiles.reserve( totalTiles );
+  
+  // Tiles in raster order, first dimension fastest, as they are in memory
+  unsigned long tilePosition[VImageDimension];
+  
+  for( unsigned int i=0; i<VImageDimension; ++i )
+    tilePosition[i] = 0;
+  
+  for( unsigned long t=0; t<totalTiles; ++t )
+  {
+    IndexType tileIndex;
+    SizeType tileSize;
+    
+    for( unsigned int i=0; i<VImageDimension; ++i )
+    {
+      const unsigned long offset = tilePosition[i] * this->m_TileSize[i];
+      tileIndex[i] = regionIndex[i] + static_cast<typename IndexType::IndexValueType>( offset );
+      tileSize[i] = vnl_math_min( static_cast<unsigned long>( this->m_TileSize[i] ), 
+        static_cast<unsigned long>( regionSize[i] ) - offset );
+    }
+    
+    this->m_Tiles.push_back( RegionType( tileIndex, tileSize ) );
+    
+    for( unsigned int i=0; i<VImageDimension; ++i )
+    {
+      if( ++tilePosition[i] < numberOfTiles[i] )
+        break;
+        
+      tilePosition[i] = 0;
+    }
+  }
+}
+
+
+template <unsigned int VImageDimension>
+bool
+ImageRegionTileScheduler<VImageDimension>
+::GetNextTile( RegionType& tile )
+{
+  m_Mutex.Lock();
+  
+  const bool found = this->m_NextTile < this->m_Tiles.size();
+  
+  if( found )
+    tile = this->m_Tiles[this->m_NextTile++];
+  
+  m_Mutex.Unlock();
+  
+  return found;
+}
+
+
+template <unsigned int VImageDimension>
+void
+ImageRegionTileScheduler<VImageDimension>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+  os << indent << "NumberOfTiles: " << this->m_Tiles.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
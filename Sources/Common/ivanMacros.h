@@ -40,5 +40,26 @@ SUCH DAMAGE.
     TImage::ImageDimension
 #endif
 
+/** Hint the processor to bring the cache line of the given address to the cache, for reading.
+  * It has no effect on compilers without a prefetch intrinsic. */
+#if defined( __GNUC__ )
+  #define ivanPrefetchMacro( address ) \
+    __builtin_prefetch( static_cast<const void *>( address ), 0, 3 )
+#elif defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+  #include <xmmintrin.h>
+  #define ivanPrefetchMacro( address ) \
+    _mm_prefetch( reinterpret_cast<const char *>( address ), _MM_HINT_T0 )
+#else
+  #define ivanPrefetchMacro( address )
+#endif
+
+/** Storage class of variables with a separate instance per thread. Only plain types without 
+  * constructors can be declared with it. */
+#if defined( _MSC_VER )
+  #define IVAN_THREAD_LOCAL __declspec( thread )
+#else
+  #define IVAN_THREAD_LOCAL __thread
+#endif
+
 #endif // __ivanMacros_h_
 
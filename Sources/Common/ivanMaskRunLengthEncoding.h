@@ -0,0 +1,172 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMaskRunLengthEncoding.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: run-length encoding of the pixels inside a mask image
+// Date: 2012/11/05
+
+#ifndef __ivanMaskRunLengthEncoding_h
+#define __ivanMaskRunLengthEncoding_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+
+#include "ivanBitPackedMask.h"
+
+#include <vector>
+
+namespace ivan
+{
+/**
+ * \class MaskRunLengthEncoding
+ * \brief Run-length encoding of the pixels inside a mask image, and their bounding box.
+ *
+ * The mask is scanned once in the given region and the pixels with non-zero value are stored 
+ * as runs of consecutive pixels along the first dimension, which is the fastest in memory. 
+ * This way filters that are computed only inside a mask can visit just the runs instead of 
+ * the whole region, and test no pixel individually. The bounding box of the mask pixels can 
+ * be used to restrict the regions where other images must be computed.
+ *
+ * Call Initialize() after setting the mask image and the region (the buffered region of the 
+ * mask by default), and before querying the runs. Runs are stored in raster order.
+ *
+ * A BitPackedMask can be set instead of the mask image, and then the runs are built from its 
+ * words, passing 64 pixels with each test, and the region of the packed mask is the default.
+ *
+ * This class is templated over the type of the mask image.
+ *
+ * \sa MultiscaleAnalysisImageFilter, BitPackedMask
+ */
+template <class TMaskImage>
+class ITK_EXPORT MaskRunLengthEncoding : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MaskRunLengthEncoding           Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MaskRunLengthEncoding, Object );
+  
+  typedef TMaskImage                              MaskImageType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, MaskImageType::ImageDimension );
+  
+  typedef itk::ImageRegion<itkGetStaticConstMacro(ImageDimension)>   RegionType;
+  typedef typename RegionType::IndexType          IndexType;
+  typedef typename RegionType::SizeType           SizeType;
+  
+  typedef BitPackedMask<itkGetStaticConstMacro(ImageDimension)>      PackedMaskType;
+  
+  /** A run of consecutive mask pixels along the first dimension. */
+  typedef typename PackedMaskType::RunType        RunType;
+  typedef typename PackedMaskType::RunContainerType   RunContainerType;
+  
+public:
+  
+  /** Set/Get the mask image. */
+  itkSetConstObjectMacro( MaskImage, MaskImageType );
+  itkGetConstObjectMacro( MaskImage, MaskImageType );
+  
+  /** Set/Get a packed mask, used instead of the mask image. */
+  itkSetConstObjectMacro( PackedMask, PackedMaskType );
+  itkGetConstObjectMacro( PackedMask, PackedMaskType );
+  
+  /** Set/Get the region of the mask to encode. If not set, the buffered region of the mask is used. */
+  void SetRegion( const RegionType& region )
+    {
+      this->m_Region = region;
+      this->m_RegionSet = true;
+      this->Modified();
+    }
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  /** Scan the mask and build the runs and the bounding box. */
+  void Initialize();
+  
+  /** Get all the runs. */
+  const RunContainerType & GetRuns() const
+    { return this->m_Runs; }
+  
+  /** Get the number of runs. */
+  unsigned long GetNumberOfRuns() const
+    { return this->m_Runs.size(); }
+  
+  /** Get the number of pixels inside the mask. */
+  itkGetConstMacro( NumberOfPixels, unsigned long );
+  
+  /** Get the bounding box of the pixels inside the mask. Its size is zero if the mask is empty. */
+  itkGetConstReferenceMacro( BoundingBox, RegionType );
+  
+  /** Returns true if there are no pixels inside the mask. */
+  bool IsEmpty() const
+    { return this->m_NumberOfPixels == 0; }
+  
+  /** Get the runs clipped to the given region, which is typically the piece of a region 
+    * given to a thread. Runs not intersecting the region are discarded. */
+  void GetRunsInRegion( const RegionType& region, RunContainerType& runs ) const;
+  
+protected:
+
+  MaskRunLengthEncoding();
+  ~MaskRunLengthEncoding() {};
+  
+  /** Build the runs scanning the pixels of the mask image. */
+  void ScanMaskImage();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  MaskRunLengthEncoding( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  typename MaskImageType::ConstPointer    m_MaskImage;
+  typename PackedMaskType::ConstPointer   m_PackedMask;
+  
+  RegionType            m_Region;
+  bool                  m_RegionSet;
+  
+  RunContainerType      m_Runs;
+  unsigned long         m_NumberOfPixels;
+  RegionType            m_BoundingBox;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanMaskRunLengthEncoding.hxx"
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMaskRunLengthEncoding.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: run-length encoding of the pixels inside a mask image
+// Date: 2012/11/05
+
+#ifndef __ivanMaskRunLengthEncoding_hxx
+#define __ivanMaskRunLengthEncoding_hxx
+
+#include "ivanMaskRunLengthEncoding.h"
+
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+
+#include "vnl/vnl_math.h"
+
+namespace ivan
+{
+
+template <class TMaskImage>
+MaskRunLengthEncoding<TMaskImage>
+::MaskRunLengthEncoding() :
+  m_RegionSet( false ),
+  m_NumberOfPixels( 0 )
+{
+
+}
+
+
+template <class TMaskImage>
+void
+MaskRunLengthEncoding<TMaskImage>
+::Initialize()
+{
+  if( !this->m_MaskImage && !this->m_PackedMask )
+  {
+    itkExceptionMacro( "Mask image not set." );
+  }
+  
+  if( !this->m_RegionSet )
+  {
+    this->m_Region = ( this->m_PackedMask )? 
+      this->m_PackedMask->GetRegion() : this->m_MaskImage->GetBufferedRegion();
+  }
+  
+  this->m_Runs.clear();
+  this->m_NumberOfPixels = 0;
+  
+  IndexType minimumIndex, maximumIndex;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+  {
+    minimumIndex[i] = itk::NumericTraits<typename IndexType::IndexValueType>::max();
+    maximumIndex[i] = itk::NumericTraits<typename IndexType::IndexValueType>::NonpositiveMin();
+  }
+  
+  if( this->m_PackedMask )
+  {
+    this->m_PackedMask->GetRunsInRegion( this->m_Region, this->m_Runs );
+  }
+  else
+  {
+    this->ScanMaskImage();
+  }
+  
+  // Bounding box of the runs
+  for( typename RunContainerType::const_iterator rit = this->m_Runs.begin(); rit != this->m_Runs.end(); ++rit )
+  {
+    this->m_NumberOfPixels += rit->Length;
+    
+    for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+      const typename IndexType::IndexValueType last = ( i == 0 ) ? 
+        rit->Index[0] + static_cast<typename IndexType::IndexValueType>( rit->Length ) - 1 : rit->Index[i];
+      
+      if( rit->Index[i] < minimumIndex[i] )
+        minimumIndex[i] = rit->Index[i];
+      if( last > maximumIndex[i] )
+        maximumIndex[i] = last;
+    }
+  }
+  
+  SizeType boundingBoxSize;
+  
+  if( this->m_NumberOfPixels )
+  {
+    for( unsigned int i=0; i<ImageDimension; ++i )
+      boundingBoxSize[i] = static_cast<typename SizeType::SizeValueType>( maximumIndex[i] - minimumIndex[i] + 1 );
+  }
+  else
+  {
+    minimumIndex = this->m_Region.GetIndex();
+    boundingBoxSize.Fill( 0 );
+  }
+  
+  this->m_BoundingBox.SetIndex( minimumIndex );
+  this->m_BoundingBox.SetSize( boundingBoxSize );
+}
+
+
+template <class TMaskImage>
+void
+MaskRunLengthEncoding<TMaskImage>
+::ScanMaskImage()
+{
+  typedef itk::ImageLinearConstIteratorWithIndex<MaskImageType>   LineIteratorType;
+  
+  LineIteratorType it( this->m_MaskImage, this->m_Region );
+  it.SetDirection( 0 );
+  
+  const typename MaskImageType::PixelType zero = 
+    itk::NumericTraits<typename MaskImageType::PixelType>::Zero;
+  
+  RunType run;
+  bool insideRun;
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+  {
+    insideRun = false;
+    
+    for( it.GoToBeginOfLine(); !it.IsAtEndOfLine(); ++it )
+    {
+      if( it.Get() != zero )
+      {
+        if( !insideRun )
+        {
+          run.Index = it.GetIndex();
+          run.Length = 0;
+          insideRun = true;
+        }
+        
+        ++run.Length;
+      }
+      else if( insideRun )
+      {
+        this->m_Runs.push_back( run );
+        insideRun = false;
+      }
+    }
+    
+    if( insideRun )
+      this->m_Runs.push_back( run );
+  }
+}
+
+
+template <class TMaskImage>
+void
+MaskRunLengthEncoding<TMaskImage>
+::GetRunsInRegion( const RegionType& region, RunContainerType& runs ) const
+{
+  runs.clear();
+  
+  const IndexType regionIndex = region.GetIndex();
+  const SizeType regionSize = region.GetSize();
+  
+  const typename IndexType::IndexValueType regionBegin = regionIndex[0];
+  const typename IndexType::IndexValueType regionEnd = 
+    regionIndex[0] + static_cast<typename IndexType::IndexValueType>( regionSize[0] );
+  
+  RunType clippedRun;
+  
+  for( typename RunContainerType::const_iterator rit = this->m_Runs.begin(); rit != this->m_Runs.end(); ++rit )
+  {
+    // The line of the run must be inside the region
+    bool insideRegion = true;
+    
+    for( unsigned int i=1; i<ImageDimension && insideRegion; ++i )
+    {
+      insideRegion = ( rit->Index[i] >= regionIndex[i] && 
+        rit->Index[i] < regionIndex[i] + static_cast<typename IndexType::IndexValueType>( regionSize[i] ) );
+    }
+    
+    if( !insideRegion )
+      continue;
+    
+    // Clip the run along the first dimension
+    const typename IndexType::IndexValueType runBegin = vnl_math_max( rit->Index[0], regionBegin );
+    const typename IndexType::IndexValueType runEnd = vnl_math_min( 
+      rit->Index[0] + static_cast<typename IndexType::IndexValueType>( rit->Length ), regionEnd );
+    
+    if( runBegin >= runEnd )
+      continue;
+    
+    clippedRun.Index = rit->Index;
+    clippedRun.Index[0] = runBegin;
+    clippedRun.Length = static_cast<unsigned long>( runEnd - runBegin );
+    
+    runs.push_back( clippedRun );
+  }
+}
+
+
+template <class TMaskImage>
+void
+MaskRunLengthEncoding<TMaskImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "NumberOfRuns: " << this->m_Runs.size() << std::endl;
+  os << indent << "NumberOfPixels: " << this->m_NumberOfPixels << std::endl;
+  os << indent << "BoundingBox: " << this->m_BoundingBox << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
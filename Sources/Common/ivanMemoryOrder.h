@@ -0,0 +1,107 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMemoryOrder.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: release stores and acquire loads to publish data to other threads.
+// Date: 2012/11/05
+
+#ifndef __ivanMemoryOrder_h
+#define __ivanMemoryOrder_h
+
+#include "itkMacro.h"
+
+#if defined( _MSC_VER )
+  #include <intrin.h>
+#endif
+
+namespace ivan
+{
+/**
+ * \class MemoryOrder
+ * \brief Release stores and acquire loads, to publish data written by one thread to others.
+ *
+ * A thread writes some data and then stores a pointer to it (or its size) with StoreRelease().
+ * Another thread that reads the stored value with LoadAcquire() is guaranteed to see the data 
+ * written before the store, without taking a lock. This is the double-checked publication used
+ * by PublishedArray and by the block table of SparseBlockedImage.
+ *
+ * The values must be pointers or integers. On GCC and Clang the atomic builtins are used, 
+ * which are plain moves on x86, or full barriers on older GCC versions. On Visual C++ (on x86) 
+ * only the compiler needs a barrier, since the processor does not reorder stores with older 
+ * stores nor loads with later loads. Other compilers fall back to a mutex, whose lock and 
+ * unlock act as a full barrier.
+ */
+class ITK_EXPORT MemoryOrder
+{
+public:
+
+  /** Store a value once the previous writes are visible to other threads. */
+  template <class T>
+  static void StoreRelease( volatile T & target, T value )
+    {
+#if defined( __GNUC__ ) && defined( __ATOMIC_RELEASE )
+      __atomic_store_n( &target, value, __ATOMIC_RELEASE );
+#elif defined( __GNUC__ )
+      __sync_synchronize();
+      target = value;
+#elif defined( _MSC_VER )
+      _ReadWriteBarrier();
+      target = value;
+#else
+      FullBarrier();
+      target = value;
+#endif
+    }
+  
+  /** Load a value before any later read. */
+  template <class T>
+  static T LoadAcquire( const volatile T & source )
+    {
+#if defined( __GNUC__ ) && defined( __ATOMIC_ACQUIRE )
+      return __atomic_load_n( &source, __ATOMIC_ACQUIRE );
+#elif defined( __GNUC__ )
+      const T value = source;
+      __sync_synchronize();
+      return value;
+#elif defined( _MSC_VER )
+      const T value = source;
+      _ReadWriteBarrier();
+      return value;
+#else
+      const T value = source;
+      FullBarrier();
+      return value;
+#endif
+    }
+  
+private:
+  
+  /** Lock and unlock a mutex, used as a barrier on compilers without builtins. */
+  static void FullBarrier();
+};
+
+} // end namespace ivan
+
+#endif
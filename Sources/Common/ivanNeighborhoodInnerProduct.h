@@ -0,0 +1,617 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanNeighborhoodInnerProduct.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: gathers image neighborhoods into contiguous buffers and computes inner products with kernels
+// Date: 2012/11/05
+
+#ifndef __ivanNeighborhoodInnerProduct_h
+#define __ivanNeighborhoodInnerProduct_h
+
+#include "ivanBrickedImageBuffer.h"
+#include "ivanPixelRowConverter.h"
+#include "ivanScratchArray.h"
+
+#include "itkImage.h"
+#include "itkNumericTraits.h"
+
+#include <vector>
+#include <algorithm>
+
+
+namespace ivan
+{
+
+/** VBase raised to VExponent, at compile time, e.g. the number of elements of a neighborhood 
+ * of a given radius. */
+template <unsigned int VBase, unsigned int VExponent>
+struct IntegerPower
+{
+  enum { Value = VBase * IntegerPower<VBase,VExponent-1>::Value };
+};
+
+template <unsigned int VBase>
+struct IntegerPower<VBase,0>
+{
+  enum { Value = 1 };
+};
+
+  
+/** \class NeighborhoodInnerProduct
+ * \brief Computes inner products of image neighborhoods with dense kernels.
+ *
+ * The neighborhood around an index is copied to a contiguous buffer, in the same order
+ * as the elements of an itk::Neighborhood (first direction varies fastest). When the
+ * neighborhood lies completely inside the buffered region, it is copied row by row
+ * directly from the pixel buffer, converting each row at once with PixelRowConverter.
+ * Otherwise, pixels outside the buffered region are replicated from the boundary, which
+ * is the same as the zero-flux Neumann condition used by 
+ * itk::NeighborhoodOperatorImageFunction.
+ *
+ * The buffer can then be reused for several kernels of the same size with 
+ * InnerProduct(), which avoids the iterator setup of NeighborhoodOperatorImageFunction
+ * for every kernel. The evaluation methods of the image functions gather into a 
+ * ScratchBufferType, which lives on the stack of the calling thread, so that no memory is 
+ * allocated per evaluation unless the neighborhood exceeds ScratchCapacity elements.
+ *
+ * The rows of short pixels are converted with the kernels of the widest instruction set of the
+ * processor (see PixelRowConverter and CPUDispatch). The inner products are short and their
+ * length depends on the scale, so they are not dispatched: they use several independent 
+ * accumulators over contiguous memory so that the compiler vectorizes them for the baseline 
+ * instruction set.
+ *
+ * TOutput is the type of the buffer, kernels and result, and TAccumulator the type of the 
+ * partial sums. Using float for the buffer and kernels halves the memory traffic and doubles 
+ * the vector width, while a double accumulator limits the loss of accuracy for large kernels.
+ *
+ * This class only contains static methods and is safe to use from several threads.
+ *
+ * \ingroup 
+ */
+template <class TInputImage, class TOutput, class TAccumulator = TOutput>
+class NeighborhoodInnerProduct
+{
+
+public:
+
+  typedef TInputImage                         InputImageType;
+  typedef typename InputImageType::IndexType  IndexType;
+  typedef typename InputImageType::SizeType   SizeType;
+  typedef typename InputImageType::RegionType RegionType;
+  typedef typename InputImageType::PixelType  InputPixelType;
+  
+  typedef TOutput                             OutputType;
+  typedef TAccumulator                        AccumulatorType;
+  typedef std::vector<OutputType>             BufferType;
+  
+  /** Elements kept on the stack by a ScratchBufferType, which covers the 3D neighborhoods up to 
+   * a radius of 7. Larger neighborhoods are allocated on the heap. */
+  itkStaticConstMacro( ScratchCapacity, unsigned int, 4096 );
+  
+  typedef ScratchArray<OutputType,ScratchCapacity>  ScratchBufferType;
+  
+  typedef BrickedImageBuffer<InputImageType>  BrickedImageType;
+
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
+
+public:
+
+  /** Number of elements of a neighborhood of the given radius. */
+  static unsigned int GetNeighborhoodSize( const SizeType & radius )
+    {
+      unsigned int size = 1;
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+        size *= 2 * radius[d] + 1;
+      return size;
+    }
+
+  /** Copy the neighborhood of the given radius around index to the buffer. The buffer 
+   * is resized if needed. */
+  static void Gather( const InputImageType *image, const IndexType & index, 
+    const SizeType & radius, BufferType & buffer )
+    {
+      GatherRegion( image, GetNeighborhoodRegion( index, radius ), buffer );
+    }
+
+  /** Same as above, copying to an array of GetNeighborhoodSize() elements, e.g. on the stack
+   * when the radius is known at compile time. */
+  static void Gather( const InputImageType *image, const IndexType & index, 
+    const SizeType & radius, OutputType *out )
+    {
+      GatherRegion( image, GetNeighborhoodRegion( index, radius ), out );
+    }
+
+  /** Copy the pixels of a region, which may extend beyond the buffered region, to the 
+   * buffer with the first direction varying fastest. The buffer is resized if needed. 
+   * This allows gathering boxes that are not centered on an index, e.g. the union of the
+   * neighborhoods of the corners of a voxel. */
+  static void GatherRegion( const InputImageType *image, const RegionType & neighborhoodRegion,
+    BufferType & buffer )
+    {
+      const unsigned int size = neighborhoodRegion.GetNumberOfPixels();
+      if( buffer.size() != size )
+        buffer.resize( size );
+
+      GatherRegion( image, neighborhoodRegion, &buffer[0] );
+    }
+
+  /** Same as above, copying to an array with as many elements as the region. */
+  static void GatherRegion( const InputImageType *image, const RegionType & neighborhoodRegion,
+    OutputType *out )
+    {
+      const unsigned int size = neighborhoodRegion.GetNumberOfPixels();
+
+      const IndexType & first = neighborhoodRegion.GetIndex();
+      const SizeType & extent = neighborhoodRegion.GetSize();
+
+      const RegionType & region = image->GetBufferedRegion();
+      const IndexType & start = region.GetIndex();
+
+      IndexType end;      
+      bool inside = true;
+
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        end[d] = start[d] + static_cast<typename IndexType::IndexValueType>( region.GetSize()[d] ) - 1;
+
+        if( first[d] < start[d] || 
+            first[d] + static_cast<long>( extent[d] ) - 1 > end[d] )
+          inside = false;
+      }
+
+      const long rowLength = extent[0];
+
+      // Offsets of the current row with respect to the first index, for directions 1..N-1
+      long offset[ImageDimension];
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+        offset[d] = 0;
+
+      const unsigned int numberOfRows = size / rowLength;
+
+      if( inside )
+      {
+        const InputPixelType *pixels = image->GetBufferPointer();
+        const typename InputImageType::OffsetValueType *offsetTable = image->GetOffsetTable();
+
+        IndexType rowStart;
+
+        for( unsigned int row = 0; row < numberOfRows; ++row )
+        {
+          for( unsigned int d = 0; d < ImageDimension; ++d )
+            rowStart[d] = first[d] + offset[d] - start[d];
+
+          long pixelOffset = 0;
+          for( unsigned int d = 0; d < ImageDimension; ++d )
+            pixelOffset += rowStart[d] * offsetTable[d];
+
+          PixelRowConverter<InputPixelType,OutputType>::Convert( pixels + pixelOffset, rowLength, out );
+
+          out += rowLength;
+          NextRow( offset, extent );
+        }
+      }
+      else
+      {
+        IndexType neighIndex;
+
+        for( unsigned int row = 0; row < numberOfRows; ++row )
+        {
+          for( unsigned int d = 1; d < ImageDimension; ++d )
+          {
+            neighIndex[d] = first[d] + offset[d];
+            if( neighIndex[d] < start[d] )
+              neighIndex[d] = start[d];
+            else if( neighIndex[d] > end[d] )
+              neighIndex[d] = end[d];
+          }
+
+          for( long k = 0; k < rowLength; ++k )
+          {
+            neighIndex[0] = first[0] + k;
+            if( neighIndex[0] < start[0] )
+              neighIndex[0] = start[0];
+            else if( neighIndex[0] > end[0] )
+              neighIndex[0] = end[0];
+
+            out[k] = static_cast<OutputType>( image->GetPixel( neighIndex ) );
+          }
+
+          out += rowLength;
+          NextRow( offset, extent );
+        }
+      }
+    }
+
+  /** Same as Gather() and GatherRegion() above, but reading from a bricked copy of the image
+   * when it is given and up to date, which is faster for scattered neighborhoods. */
+  static void Gather( const InputImageType *image, const BrickedImageType *bricked,
+    const IndexType & index, const SizeType & radius, BufferType & buffer )
+    {
+      if( bricked && bricked->IsCopyOf( image ) )
+        bricked->Gather( index, radius, buffer );
+      else
+        Gather( image, index, radius, buffer );
+    }
+  
+  static void GatherRegion( const InputImageType *image, const BrickedImageType *bricked,
+    const RegionType & neighborhoodRegion, BufferType & buffer )
+    {
+      if( bricked && bricked->IsCopyOf( image ) )
+        bricked->GatherRegion( neighborhoodRegion, buffer );
+      else
+        GatherRegion( image, neighborhoodRegion, buffer );
+    }
+
+  static void Gather( const InputImageType *image, const BrickedImageType *bricked,
+    const IndexType & index, const SizeType & radius, OutputType *out )
+    {
+      if( bricked && bricked->IsCopyOf( image ) )
+        bricked->Gather( index, radius, out );
+      else
+        Gather( image, index, radius, out );
+    }
+  
+  static void GatherRegion( const InputImageType *image, const BrickedImageType *bricked,
+    const RegionType & neighborhoodRegion, OutputType *out )
+    {
+      if( bricked && bricked->IsCopyOf( image ) )
+        bricked->GatherRegion( neighborhoodRegion, out );
+      else
+        GatherRegion( image, neighborhoodRegion, out );
+    }
+
+  /** Inner product of two contiguous arrays of n elements. */
+  static OutputType InnerProduct( const OutputType *kernel, const OutputType *values, unsigned int n )
+    {
+      AccumulatorType sum0 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum1 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum2 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum3 = itk::NumericTraits<AccumulatorType>::Zero;
+
+      unsigned int i = 0;
+      
+      for( ; i + 4 <= n; i += 4 )
+      {
+        sum0 += static_cast<AccumulatorType>( kernel[i] )   * values[i];
+        sum1 += static_cast<AccumulatorType>( kernel[i+1] ) * values[i+1];
+        sum2 += static_cast<AccumulatorType>( kernel[i+2] ) * values[i+2];
+        sum3 += static_cast<AccumulatorType>( kernel[i+3] ) * values[i+3];
+      }
+
+      for( ; i < n; ++i )
+        sum0 += static_cast<AccumulatorType>( kernel[i] ) * values[i];
+
+      return static_cast<OutputType>( ( sum0 + sum1 ) + ( sum2 + sum3 ) );
+    }
+
+  /** Same as above for a number of elements known at compile time, which the compiler unrolls
+   * for small kernels. The sums are taken in the same order, so the results only differ if the
+   * compiler fuses the multiply-adds differently. */
+  template <unsigned int VLength>
+  static OutputType FixedSizeInnerProduct( const OutputType *kernel, const OutputType *values )
+    {
+      AccumulatorType sum0 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum1 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum2 = itk::NumericTraits<AccumulatorType>::Zero;
+      AccumulatorType sum3 = itk::NumericTraits<AccumulatorType>::Zero;
+
+      unsigned int i = 0;
+
+      for( ; i + 4 <= VLength; i += 4 )
+      {
+        sum0 += static_cast<AccumulatorType>( kernel[i] )   * values[i];
+        sum1 += static_cast<AccumulatorType>( kernel[i+1] ) * values[i+1];
+        sum2 += static_cast<AccumulatorType>( kernel[i+2] ) * values[i+2];
+        sum3 += static_cast<AccumulatorType>( kernel[i+3] ) * values[i+3];
+      }
+
+      for( ; i < VLength; ++i )
+        sum0 += static_cast<AccumulatorType>( kernel[i] ) * values[i];
+
+      return static_cast<OutputType>( ( sum0 + sum1 ) + ( sum2 + sum3 ) );
+    }
+
+  /** Inner product of a kernel (any class with contiguous storage accessed through
+   * operator[], such as itk::Neighborhood) with a buffer obtained with Gather(). */
+  template <class TKernel>
+  static OutputType InnerProduct( const TKernel & kernel, const BufferType & buffer )
+    {
+      return InnerProduct( &kernel[0], &buffer[0], static_cast<unsigned int>( buffer.size() ) );
+    }
+
+  /** Same as above with a scratch buffer. */
+  template <class TKernel>
+  static OutputType InnerProduct( const TKernel & kernel, const ScratchBufferType & buffer )
+    {
+      return InnerProduct( &kernel[0], buffer.GetDataPointer(), buffer.Size() );
+    }
+
+  /** Interpolate a one-dimensional kernel between two unit-shifted positions. The result has
+   * one more element, (1-t)*kernel[j] + t*kernel[j-1], and applied to a box one pixel longer 
+   * gives the linear interpolation of the results of the kernel at the two positions. */
+  static void InterpolateKernel( const BufferType & kernel, double t, BufferType & interpolated )
+    {
+      const unsigned int size = kernel.size();
+      const OutputType lowerWeight = static_cast<OutputType>( 1.0 - t );
+      const OutputType upperWeight = static_cast<OutputType>( t );
+
+      interpolated.resize( size + 1 );
+      interpolated[0] = lowerWeight * kernel[0];
+
+      for( unsigned int j = 1; j < size; ++j )
+        interpolated[j] = lowerWeight * kernel[j] + upperWeight * kernel[j-1];
+
+      interpolated[size] = upperWeight * kernel[size-1];
+    }
+
+  /** Reduce a box gathered with Gather() or GatherRegion() with separable kernels, one
+   * direction at a time. kernels[N*order+d] is the one-dimensional kernel of the given order 
+   * (up to 2) in direction d, with as many elements as the box in that direction, and 
+   * componentOrders[c][d] the order of component c in direction d. The result of component c
+   * is stored in results[c]. At each step, the partial results are identified by the orders
+   * in the directions already reduced, so that results shared by several components (e.g. 
+   * the first-order reduction in x for dxy and dxz) are computed only once. */
+  template <class TKernelArray, class TOrderArray, class TResults>
+  static void ReduceSeparable( const BufferType & buffer, const TKernelArray & kernels,
+    const TOrderArray & componentOrders, unsigned int numberOfComponents, TResults & results )
+    {
+      ReduceSeparable( &buffer[0], static_cast<unsigned int>( buffer.size() ), kernels, 
+        componentOrders, numberOfComponents, results );
+    }
+
+  /** Same as above for a box of boxSize elements, such as a ScratchBufferType. The partial 
+   * results are kept in scratch buffers too, so nothing is allocated for the usual sizes. */
+  template <class TKernelArray, class TOrderArray, class TResults>
+  static void ReduceSeparable( const OutputType *box, unsigned int boxSize, 
+    const TKernelArray & kernels, const TOrderArray & componentOrders, 
+    unsigned int numberOfComponents, TResults & results )
+    {
+      // Every direction reduces the partials to at most one per component, written to the half 
+      // of the scratch buffer not read by that direction
+      const unsigned int maximumNumberOfPartials = std::max( numberOfComponents, 1u );
+      const unsigned int partialSize = boxSize / kernels[0].size();
+      const unsigned int halfSize = maximumNumberOfPartials * partialSize;
+
+      ScratchArray<OutputType,ScratchCapacity> partials( 2 * halfSize );
+      
+      ScratchArray<const OutputType*,16>  inputs( maximumNumberOfPartials );
+      ScratchArray<unsigned int,16>       inputKeys( maximumNumberOfPartials );
+      ScratchArray<unsigned int,16>       outputKeys( maximumNumberOfPartials );
+      unsigned int numberOfInputs = 1;
+
+      inputs[0] = box;
+      inputKeys[0] = 0;
+
+      unsigned int outputSize = boxSize;
+      unsigned int keyBase = 1; // 3^d
+
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        const unsigned int kernelSize = kernels[d].size();
+        outputSize /= kernelSize;
+        
+        OutputType *outputs = partials.GetDataPointer() + ( d % 2 ) * halfSize;
+        unsigned int numberOfOutputs = 0;
+
+        for( unsigned int c = 0; c < numberOfComponents; ++c )
+        {
+          unsigned int parentKey = 0;
+          unsigned int base = 1;
+          for( unsigned int e = 0; e < d; ++e )
+          {
+            parentKey += componentOrders[c][e] * base;
+            base *= 3;
+          }
+
+          const unsigned int order = componentOrders[c][d];
+          const unsigned int key = parentKey + order * keyBase;
+
+          bool computed = false;
+          for( unsigned int k = 0; k < numberOfOutputs && !computed; ++k )
+            computed = ( outputKeys[k] == key );
+
+          if( computed )
+            continue;
+
+          unsigned int parent = 0;
+          while( inputKeys[parent] != parentKey )
+            ++parent;
+
+          const OutputType *input = inputs[parent];
+          const OutputType *kernel = &kernels[ImageDimension * order + d][0];
+          OutputType *output = outputs + numberOfOutputs * partialSize;
+
+          for( unsigned int m = 0; m < outputSize; ++m )
+            output[m] = InnerProduct( kernel, input + m * kernelSize, kernelSize );
+
+          outputKeys[numberOfOutputs++] = key;
+        }
+
+        for( unsigned int k = 0; k < numberOfOutputs; ++k )
+        {
+          inputs[k] = outputs + k * partialSize;
+          inputKeys[k] = outputKeys[k];
+        }
+
+        numberOfInputs = numberOfOutputs;
+        keyBase *= 3;
+      }
+
+      // Each final partial result is a single value
+      for( unsigned int c = 0; c < numberOfComponents; ++c )
+      {
+        unsigned int key = 0;
+        unsigned int base = 1;
+        for( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+          key += componentOrders[c][d] * base;
+          base *= 3;
+        }
+
+        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+          if( inputKeys[k] == key )
+          {
+            results[c] = inputs[k][0];
+            break;
+          }
+        }
+      }
+    }
+
+  /** Same as ReduceSeparable() above for a box of VKernelSize elements in every direction,
+   * such as the neighborhood of a kernel radius known at compile time. The partial results 
+   * are kept in fixed arrays and the one-dimensional inner products have a fixed size, which 
+   * removes most of the loop overhead for small kernels, with the same results up to 
+   * rounding. At most ImageDimension * ( ImageDimension + 1 ) / 2 components are reduced, as
+   * for a Hessian. */
+  template <unsigned int VKernelSize, class TKernelArray, class TOrderArray, class TResults>
+  static void FixedSizeReduceSeparable( const OutputType *box, const TKernelArray & kernels,
+    const TOrderArray & componentOrders, unsigned int numberOfComponents, TResults & results )
+    {
+      const unsigned int maximumNumberOfPartials = ImageDimension * ( ImageDimension + 1 ) / 2;
+      const unsigned int partialSize = IntegerPower<VKernelSize,ImageDimension-1>::Value;
+
+      // The partials of each direction are written to the buffer not read by that direction
+      OutputType partials[2][maximumNumberOfPartials][partialSize];
+
+      const OutputType *inputs[maximumNumberOfPartials];
+      unsigned int inputKeys[maximumNumberOfPartials];
+      unsigned int numberOfInputs = 1;
+      unsigned int outputKeys[maximumNumberOfPartials];
+
+      inputs[0] = box;
+      inputKeys[0] = 0;
+
+      unsigned int outputSize = IntegerPower<VKernelSize,ImageDimension>::Value;
+      unsigned int keyBase = 1; // 3^d
+
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        outputSize /= VKernelSize;
+        unsigned int numberOfOutputs = 0;
+
+        for( unsigned int c = 0; c < numberOfComponents; ++c )
+        {
+          unsigned int parentKey = 0;
+          unsigned int base = 1;
+          for( unsigned int e = 0; e < d; ++e )
+          {
+            parentKey += componentOrders[c][e] * base;
+            base *= 3;
+          }
+
+          const unsigned int order = componentOrders[c][d];
+          const unsigned int key = parentKey + order * keyBase;
+
+          bool computed = false;
+          for( unsigned int k = 0; k < numberOfOutputs && !computed; ++k )
+            computed = ( outputKeys[k] == key );
+
+          if( computed )
+            continue;
+
+          unsigned int parent = 0;
+          while( inputKeys[parent] != parentKey )
+            ++parent;
+
+          const OutputType *input = inputs[parent];
+          const OutputType *kernel = &kernels[ImageDimension * order + d][0];
+          OutputType *output = partials[d % 2][numberOfOutputs];
+
+          for( unsigned int m = 0; m < outputSize; ++m )
+            output[m] = FixedSizeInnerProduct<VKernelSize>( kernel, input + m * VKernelSize );
+
+          outputKeys[numberOfOutputs++] = key;
+        }
+
+        for( unsigned int k = 0; k < numberOfOutputs; ++k )
+        {
+          inputs[k] = partials[d % 2][k];
+          inputKeys[k] = outputKeys[k];
+        }
+
+        numberOfInputs = numberOfOutputs;
+        keyBase *= 3;
+      }
+
+      // Each final partial result is a single value
+      for( unsigned int c = 0; c < numberOfComponents; ++c )
+      {
+        unsigned int key = 0;
+        unsigned int base = 1;
+        for( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+          key += componentOrders[c][d] * base;
+          base *= 3;
+        }
+
+        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+          if( inputKeys[k] == key )
+          {
+            results[c] = inputs[k][0];
+            break;
+          }
+        }
+      }
+    }
+
+private:
+
+  /** Region of the neighborhood of the given radius around index. */
+  static RegionType GetNeighborhoodRegion( const IndexType & index, const SizeType & radius )
+    {
+      RegionType neighborhoodRegion;
+      IndexType neighborhoodStart;
+      SizeType neighborhoodSize;
+
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        neighborhoodStart[d] = index[d] - static_cast<long>( radius[d] );
+        neighborhoodSize[d] = 2 * radius[d] + 1;
+      }
+
+      neighborhoodRegion.SetIndex( neighborhoodStart );
+      neighborhoodRegion.SetSize( neighborhoodSize );
+
+      return neighborhoodRegion;
+    }
+
+  /** Advance the offsetsto the next row of the neighborhood (direction 0 is not changed). */
+  static void NextRow( long *offset, const SizeType & extent )
+    {
+      for( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+        if( ++offset[d] < static_cast<long>( extent[d] ) )
+          break;
+        offset[d] = 0;
+      }
+    }
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanParallelPatternSearchOptimizer.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: pattern search optimizer that evaluates the pattern points of each iteration concurrently
+// Date: 2012/11/05
+
+#include "ivanParallelPatternSearchOptimizer.h"
+
+#include <sstream>
+
+namespace ivan
+{
+
+ParallelPatternSearchOptimizer::ParallelPatternSearchOptimizer() :
+  m_Maximize( false ),
+  m_InitialStepLength( 1.0 ),
+  m_MinimumStepLength( 0.01 ),
+  m_ContractionFactor( 0.5 ),
+  m_MaximumNumberOfIterations( 100 ),
+  m_CurrentValue( 0.0 ),
+  m_CurrentIteration( 0 ),
+  m_CurrentStepLength( 0.0 ),
+  m_NumberOfEvaluations( 0 ),
+  m_Interrupted( false )
+{
+
+}
+
+
+void
+ParallelPatternSearchOptimizer::StartOptimization()
+{
+  if( !this->GetCostFunction() )
+    itkExceptionMacro( "A cost function must be set." );
+  
+  const unsigned int numberOfParameters = this->GetCostFunction()->GetNumberOfParameters();
+  
+  if( this->GetInitialPosition().Size() != numberOfParameters )
+    itkExceptionMacro( "Initial position has " << this->GetInitialPosition().Size() 
+      << " parameters, and the cost function " << numberOfParameters << "." );
+  
+  ScalesType scales = this->GetScales();
+  
+  if( scales.Size() != numberOfParameters )
+  {
+    scales.SetSize( numberOfParameters );
+    scales.Fill( 1.0 );
+  }
+  
+  this->m_CurrentIteration = 0;
+  this->m_CurrentStepLength = this->m_InitialStepLength;
+  this->m_NumberOfEvaluations = 0;
+  this->m_StopConditionDescription = "";
+  this->m_Interrupted = false;
+  
+  ParametersType currentPosition = this->GetInitialPosition();
+  this->SetCurrentPosition( currentPosition );
+  
+  this->m_CurrentValue = this->GetCostFunction()->GetValue( currentPosition );
+  ++this->m_NumberOfEvaluations;
+  
+  this->InvokeEvent( itk::StartEvent() );
+  
+  BatchSingleValuedCostFunction::ParametersContainerType  pattern( 2 * numberOfParameters );
+  BatchSingleValuedCostFunction::MeasureContainerType     values;
+  
+  while( true )
+  {
+    if( this->m_CurrentStepLength < this->m_MinimumStepLength )
+    {
+      this->m_StopConditionDescription = "Step length below minimum.";
+      break;
+    }
+    
+    if( this->m_CurrentIteration >= this->m_MaximumNumberOfIterations )
+    {
+      this->m_StopConditionDescription = "Maximum number of iterations reached.";
+      break;
+    }
+    
+    if( this->m_CancellationToken.IsNotNull() && this->m_CancellationToken->IsStopRequested() )
+    {
+      this->m_StopConditionDescription = "Stopped by the cancellation token.";
+      this->m_Interrupted = true;
+      break;
+    }
+    
+    // Compass pattern around the current position
+    for( unsigned int i=0; i < numberOfParameters; ++i )
+    {
+      const double step = this->m_CurrentStepLength / scales[i];
+      
+      pattern[2*i] = currentPosition;
+      pattern[2*i][i] += step;
+      pattern[2*i+1] = currentPosition;
+      pattern[2*i+1][i] -= step;
+    }
+    
+    this->EvaluatePositions( pattern, values );
+    
+    int best = -1;
+    MeasureType bestValue = this->m_CurrentValue;
+    
+    for( unsigned int n=0; n < pattern.size(); ++n )
+    {
+      if( this->IsBetter( values[n], bestValue ) )
+      {
+        best = n;
+        bestValue = values[n];
+      }
+    }
+    
+    if( best >= 0 )
+    {
+      currentPosition = pattern[best];
+      this->m_CurrentValue = bestValue;
+      this->SetCurrentPosition( currentPosition );
+    }
+    else
+      this->m_CurrentStepLength *= this->m_ContractionFactor;
+    
+    ++this->m_CurrentIteration;
+    
+    this->InvokeEvent( itk::IterationEvent() );
+  }
+  
+  this->InvokeEvent( itk::EndEvent() );
+}
+
+
+void
+ParallelPatternSearchOptimizer::EvaluatePositions( 
+  const BatchSingleValuedCostFunction::ParametersContainerType & positions,
+  BatchSingleValuedCostFunction::MeasureContainerType & values )
+{
+  const BatchSingleValuedCostFunction *batchCostFunction = 
+    dynamic_cast<const BatchSingleValuedCostFunction*>( this->GetCostFunction() );
+  
+  if( batchCostFunction )
+    batchCostFunction->GetValues( positions, values );
+  else
+  {
+    values.resize( positions.size() );
+    
+    for( unsigned int n=0; n < positions.size(); ++n )
+      values[n] = this->GetCostFunction()->GetValue( positions[n] );
+  }
+  
+  this->m_NumberOfEvaluations += positions.size();
+}
+
+
+const std::string
+ParallelPatternSearchOptimizer::GetStopConditionDescription() const
+{
+  std::ostringstream description;
+  description << this->GetNameOfClass() << ": " << this->m_StopConditionDescription;
+  
+  return description.str();
+}
+
+
+void
+ParallelPatternSearchOptimizer::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Maximize: " << m_Maximize << std::endl;
+  os << indent << "InitialStepLength: " << m_InitialStepLength << std::endl;
+  os << indent << "MinimumStepLength: " << m_MinimumStepLength << std::endl;
+  os << indent << "ContractionFactor: " << m_ContractionFactor << std::endl;
+  os << indent << "MaximumNumberOfIterations: " << m_MaximumNumberOfIterations << std::endl;
+  os << indent << "CurrentValue: " << m_CurrentValue << std::endl;
+  os << indent << "CurrentIteration: " << m_CurrentIteration << std::endl;
+  os << indent << "CurrentStepLength: " << m_CurrentStepLength << std::endl;
+  os << indent << "NumberOfEvaluations: " << m_NumberOfEvaluations << std::endl;
+  os << indent << "Interrupted: " << m_Interrupted << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,170 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanParallelPatternSearchOptimizer.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: pattern search optimizer that evaluates the pattern points of each iteration concurrently
+// Date: 2012/11/05
+
+#ifndef __ivanParallelPatternSearchOptimizer_h
+#define __ivanParallelPatternSearchOptimizer_h
+
+#include "ivanBatchSingleValuedCostFunction.h"
+#include "ivanCancellationToken.h"
+
+#include "itkSingleValuedNonLinearOptimizer.h"
+
+#include <string>
+
+
+namespace ivan
+{
+/**
+ * \class ParallelPatternSearchOptimizer
+ * \brief Compass (pattern search) optimizer that evaluates its pattern as a batch.
+ *
+ * At each iteration the 2N points obtained by moving each parameter StepLength / Scale in both 
+ * directions around the current position are evaluated. The position moves to the best of them 
+ * if it improves the current value. Otherwise the step length is multiplied by the 
+ * ContractionFactor. The optimization stops when the step length falls below 
+ * MinimumStepLength or after MaximumNumberOfIterations iterations.
+ *
+ * The pattern points do not depend on each other. If the cost function is a 
+ * BatchSingleValuedCostFunction, they are evaluated with GetValues(), which can run 
+ * concurrently. Otherwise they are evaluated one by one. Ties are resolved in favour of the 
+ * first pattern point, so the result does not depend on the number of threads.
+ *
+ * By default the cost function is minimized. Set Maximize to maximize it instead, as with the 
+ * vesselness cost functions used by the trackers.
+ *
+ * If a CancellationToken is set, it is checked before every iteration. When stop is requested 
+ * the optimization ends at the best position found so far and GetInterrupted() returns true.
+ *
+ * \sa BatchSingleValuedCostFunction
+ */
+class ITK_EXPORT ParallelPatternSearchOptimizer : public itk::SingleValuedNonLinearOptimizer
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ParallelPatternSearchOptimizer      Self;
+  typedef itk::SingleValuedNonLinearOptimizer Superclass;
+  typedef itk::SmartPointer<Self>             Pointer;
+  typedef itk::SmartPointer<const Self>       ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ParallelPatternSearchOptimizer, itk::SingleValuedNonLinearOptimizer );
+  
+  typedef Superclass::ParametersType      ParametersType;
+  typedef Superclass::MeasureType         MeasureType;
+  
+public:
+  
+  /** Maximize instead of minimize the cost function. Default is false. */
+  itkSetMacro( Maximize, bool );
+  itkGetConstMacro( Maximize, bool );
+  itkBooleanMacro( Maximize );
+  
+  /** Set/Get the initial step length. Default is 1.0. */
+  itkSetMacro( InitialStepLength, double );
+  itkGetConstMacro( InitialStepLength, double );
+  
+  /** Set/Get the step length below which the optimization stops. Default is 0.01. */
+  itkSetMacro( MinimumStepLength, double );
+  itkGetConstMacro( MinimumStepLength, double );
+  
+  /** Set/Get the factor applied to the step length after an iteration without improvement.
+    * Default is 0.5. */
+  itkSetClampMacro( ContractionFactor, double, 0.0, 1.0 );
+  itkGetConstMacro( ContractionFactor, double );
+  
+  /** Set/Get the maximum number of iterations. Default is 100. */
+  itkSetMacro( MaximumNumberOfIterations, unsigned int );
+  itkGetConstMacro( MaximumNumberOfIterations, unsigned int );
+  
+  /** Get the value at the current position, the current iteration and step length, and the 
+    * number of cost function evaluations of the last optimization. */
+  itkGetConstMacro( CurrentValue, MeasureType );
+  itkGetConstMacro( CurrentIteration, unsigned int );
+  itkGetConstMacro( CurrentStepLength, double );
+  itkGetConstMacro( NumberOfEvaluations, unsigned long );
+  
+  /** Set/Get the token checked before every iteration. Default is NULL. */
+  itkSetObjectMacro( CancellationToken, CancellationToken );
+  itkGetConstObjectMacro( CancellationToken, CancellationToken );
+  
+  /** Returns true if the last optimization was stopped by the cancellation token. */
+  itkGetConstMacro( Interrupted, bool );
+  
+  /** Run the optimization from the initial position. */
+  virtual void StartOptimization();
+  
+  /** Get the reason for stopping. */
+  virtual const std::string GetStopConditionDescription() const;
+  
+protected:
+
+  ParallelPatternSearchOptimizer();
+  virtual ~ParallelPatternSearchOptimizer() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Evaluate all the given positions, as a batch if supported by the cost function. */
+  void EvaluatePositions( const BatchSingleValuedCostFunction::ParametersContainerType & positions,
+    BatchSingleValuedCostFunction::MeasureContainerType & values );
+  
+  /** Returns true if the first value is better than the second. */
+  bool IsBetter( MeasureType value, MeasureType reference ) const
+    { return m_Maximize ? ( value > reference ) : ( value < reference ); }
+  
+private:
+
+  ParallelPatternSearchOptimizer( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  bool            m_Maximize;
+  double          m_InitialStepLength;
+  double          m_MinimumStepLength;
+  double          m_ContractionFactor;
+  unsigned int    m_MaximumNumberOfIterations;
+  
+  MeasureType     m_CurrentValue;
+  unsigned int    m_CurrentIteration;
+  double          m_CurrentStepLength;
+  unsigned long   m_NumberOfEvaluations;
+  
+  CancellationToken::Pointer    m_CancellationToken;
+  bool                          m_Interrupted;
+  
+  std::string     m_StopConditionDescription;
+};
+
+} // end namespace ivan
+
+#endif
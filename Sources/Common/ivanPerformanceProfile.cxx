@@ -0,0 +1,536 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPerformanceProfile.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: per-run timing and counters of hot paths, removable at compile time
+// Date: 2012/11/05
+
+#include "ivanPerformanceProfile.h"
+#include "ivanMacros.h"
+
+#include <vcl_cmath.h>
+#include <algorithm>
+#include <map>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <cstring>
+#endif
+
+namespace ivan
+{
+
+namespace
+{
+  /** Serial numbers of the profiles, from 1 so that empty cache entries never match. */
+  AtomicCounter profileSerialNumbers( 1 );
+  
+  /** Statistics of the last profiles used by every thread, so that recording does not take 
+    * the lock of the profile. */
+  const unsigned int threadCacheSize = 4;
+  
+  struct ThreadCacheEntry
+  {
+    unsigned long   SerialNumber;
+    void           *Statistics;
+  };
+  
+  IVAN_THREAD_LOCAL ThreadCacheEntry  threadCache[threadCacheSize];
+  IVAN_THREAD_LOCAL unsigned int      threadCacheNext;
+}
+
+
+PerformanceProfile::PerformanceProfile()
+{
+  m_Clock = itk::RealTimeClock::New();
+  m_SerialNumber = static_cast<unsigned long>( profileSerialNumbers.FetchAndAdd( 1 ) );
+}
+
+
+PerformanceProfile::~PerformanceProfile()
+{
+  for( unsigned int i=0; i<m_ThreadStatistics.size(); ++i )
+    delete m_ThreadStatistics[i];
+}
+
+
+PerformanceProfile::ProbeIdType
+PerformanceProfile::RegisterProbe( const std::string & name )
+{
+  m_Mutex.Lock();
+  
+  for( unsigned int i=0; i<m_Probes.size(); ++i )
+  {
+    if( m_Probes[i].Name == name )
+    {
+      m_Mutex.Unlock();
+      return i;
+    }
+  }
+  
+  ProbeType probe;
+  probe.Name = name;
+  
+  m_Probes.push_back( probe );
+  
+  const ProbeIdType probeId = static_cast<ProbeIdType>( m_Probes.size() - 1 );
+  
+  m_Mutex.Unlock();
+  
+  return probeId;
+}
+
+
+bool
+PerformanceProfile::FindProbe( const std::string & name, ProbeIdType & probeId ) const
+{
+  for( unsigned int i=0; i<m_Probes.size(); ++i )
+  {
+    if( m_Probes[i].Name == name )
+    {
+      probeId = i;
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+
+unsigned int
+PerformanceProfile::GetHistogramBin( double seconds )
+{
+  const unsigned int numberOfBins = NumberOfOctaves * BinsPerOctave;
+  
+  if( seconds <= 0.0 )
+    return 0;
+  
+  const double bin = 
+    vcl_floor( ( vcl_log( seconds ) / vcl_log( 2.0 ) - MinimumExponent ) * BinsPerOctave );
+  
+  if( bin < 0.0 )
+    return 0;
+  else if( bin >= numberOfBins )
+    return numberOfBins - 1;
+  else
+    return static_cast<unsigned int>( bin );
+}
+
+
+PerformanceProfile::ThreadStatisticsType *
+PerformanceProfile::GetThreadStatistics()
+{
+  for( unsigned int i=0; i<threadCacheSize; ++i )
+  {
+    if( threadCache[i].SerialNumber == m_SerialNumber )
+      return static_cast<ThreadStatisticsType *>( threadCache[i].Statistics );
+  }
+  
+  // First call of the thread, or its entry was replaced by other profiles
+  const unsigned long threadId = GetCurrentThreadIdentifier();
+  ThreadStatisticsType *statistics = 0;
+  
+  m_Mutex.Lock();
+  
+  for( unsigned int i=0; i<m_ThreadStatistics.size() && !statistics; ++i )
+  {
+    if( m_ThreadStatistics[i]->ThreadId == threadId )
+      statistics = m_ThreadStatistics[i];
+  }
+  
+  if( !statistics )
+  {
+    statistics = new ThreadStatisticsType;
+    statistics->ThreadId = threadId;
+    m_ThreadStatistics.push_back( statistics );
+  }
+  
+  m_Mutex.Unlock();
+  
+  ThreadCacheEntry & entry = threadCache[threadCacheNext];
+  threadCacheNext = ( threadCacheNext + 1 ) % threadCacheSize;
+  
+  entry.SerialNumber = m_SerialNumber;
+  entry.Statistics = statistics;
+  
+  return statistics;
+}
+
+
+void
+PerformanceProfile::Record( ProbeIdType probeId, double seconds )
+{
+  const unsigned int bin = GetHistogramBin( seconds );
+  
+  ThreadStatisticsType *statistics = this->GetThreadStatistics();
+  
+  statistics->Mutex.Lock();
+  
+  if( statistics->Probes.size() <= probeId )
+    statistics->Probes.resize( probeId + 1 );
+  
+  ProbeStatisticsType & probe = statistics->Probes[probeId];
+  
+  if( probe.Histogram.empty() )
+    probe.Histogram.resize( NumberOfOctaves * BinsPerOctave, 0 );
+    
+  ++probe.Count;
+  ++probe.TimedCount;
+  probe.TotalTime += seconds;
+  ++probe.Histogram[bin];
+  
+  statistics->Mutex.Unlock();
+}
+
+
+void
+PerformanceProfile::RecordInterval( ProbeIdType probeId, double startTime, double endTime )
+{
+  this->Record( probeId, endTime - startTime );
+  
+  if( m_TraceEvents.empty() )
+    return;
+  
+  // Each call takes its own slot, so the event can be written without a lock
+  const unsigned long slot = static_cast<unsigned long>
+    ( m_NumberOfRecordedTraceEvents.FetchAndAdd( 1 ) ) % m_TraceEvents.size();
+  
+  TraceEvent & event = m_TraceEvents[slot];
+  event.ProbeId = probeId;
+  event.ThreadId = GetCurrentThreadIdentifier();
+  event.StartTime = startTime;
+  event.EndTime = endTime;
+}
+
+
+void
+PerformanceProfile::Increment( ProbeIdType probeId, unsigned long count )
+{
+  ThreadStatisticsType *statistics = this->GetThreadStatistics();
+  
+  statistics->Mutex.Lock();
+  
+  if( statistics->Probes.size() <= probeId )
+    statistics->Probes.resize( probeId + 1 );
+    
+  statistics->Probes[probeId].Count += count;
+  
+  statistics->Mutex.Unlock();
+}
+
+
+PerformanceProfile::ProbeStatisticsType
+PerformanceProfile::MergeStatistics( ProbeIdType probeId, bool withHistogram ) const
+{
+  ProbeStatisticsType merged;
+  
+  if( withHistogram )
+    merged.Histogram.resize( NumberOfOctaves * BinsPerOctave, 0 );
+  
+  m_Mutex.Lock();
+  
+  for( unsigned int i=0; i<m_ThreadStatistics.size(); ++i )
+  {
+    ThreadStatisticsType *statistics = m_ThreadStatistics[i];
+    
+    statistics->Mutex.Lock();
+    
+    if( probeId < statistics->Probes.size() )
+    {
+      const ProbeStatisticsType & probe = statistics->Probes[probeId];
+      
+      merged.Count += probe.Count;
+      merged.TimedCount += probe.TimedCount;
+      merged.TotalTime += probe.TotalTime;
+      
+      if( withHistogram )
+      {
+        for( unsigned int bin=0; bin<probe.Histogram.size(); ++bin )
+          merged.Histogram[bin] += probe.Histogram[bin];
+      }
+    }
+    
+    statistics->Mutex.Unlock();
+  }
+  
+  m_Mutex.Unlock();
+  
+  return merged;
+}
+
+
+unsigned long
+PerformanceProfile::GetCount( ProbeIdType probeId ) const
+{
+  return this->MergeStatistics( probeId, false ).Count;
+}
+
+
+double
+PerformanceProfile::GetTotalTime( ProbeIdType probeId ) const
+{
+  return this->MergeStatistics( probeId, false ).TotalTime;
+}
+
+
+double
+PerformanceProfile::GetMeanTime( ProbeIdType probeId ) const
+{
+  const ProbeStatisticsType probe = this->MergeStatistics( probeId, false );
+  
+  return ( probe.TimedCount > 0 ) ? probe.TotalTime / probe.TimedCount : 0.0;
+}
+
+
+double
+PerformanceProfile::GetPercentileTime( ProbeIdType probeId, double fraction ) const
+{
+  const ProbeStatisticsType probe = this->MergeStatistics( probeId, true );
+  
+  if( !probe.TimedCount )
+    return 0.0;
+  
+  if( fraction < 0.0 )
+    fraction = 0.0;
+  else if( fraction > 1.0 )
+    fraction = 1.0;
+    
+  // Number of calls at or below the percentile, at least one
+  unsigned long rank = static_cast<unsigned long>( vcl_ceil( fraction * probe.TimedCount ) );
+  
+  if( rank == 0 )
+    rank = 1;
+  
+  unsigned long accumulated = 0;
+  unsigned int bin = 0;
+  
+  for( ; bin < probe.Histogram.size(); ++bin )
+  {
+    accumulated += probe.Histogram[bin];
+    
+    if( accumulated >= rank )
+      break;
+  }
+  
+  // Geometric center of the bin
+  const double exponent = MinimumExponent + ( bin + 0.5 ) / BinsPerOctave;
+  
+  return vcl_pow( 2.0, exponent );
+}
+
+
+void
+PerformanceProfile::Reset()
+{
+  m_Mutex.Lock();
+  
+  for( unsigned int i=0; i<m_ThreadStatistics.size(); ++i )
+  {
+    ThreadStatisticsType *statistics = m_ThreadStatistics[i];
+    
+    statistics->Mutex.Lock();
+    
+    for( unsigned int j=0; j<statistics->Probes.size(); ++j )
+    {
+      ProbeStatisticsType & probe = statistics->Probes[j];
+      probe.Count = 0;
+      probe.TimedCount = 0;
+      probe.TotalTime = 0.0;
+      std::fill( probe.Histogram.begin(), probe.Histogram.end(), 0 );
+    }
+    
+    statistics->Mutex.Unlock();
+  }
+  
+  m_NumberOfRecordedTraceEvents.SetValue( 0 );
+  
+  m_Mutex.Unlock();
+}
+
+
+void
+PerformanceProfile::SetTraceCapacity( unsigned long capacity )
+{
+  m_Mutex.Lock();
+  
+  std::vector<TraceEvent>( capacity ).swap( m_TraceEvents );
+  m_NumberOfRecordedTraceEvents.SetValue( 0 );
+  
+  m_Mutex.Unlock();
+}
+
+
+unsigned long
+PerformanceProfile::GetNumberOfTraceEvents() const
+{
+  const unsigned long recorded =
+    static_cast<unsigned long>( m_NumberOfRecordedTraceEvents.GetValue() );
+  
+  return ( recorded < this->GetTraceCapacity() ) ? recorded : this->GetTraceCapacity();
+}
+
+
+unsigned long
+PerformanceProfile::GetNumberOfDroppedTraceEvents() const
+{
+  const unsigned long recorded =
+    static_cast<unsigned long>( m_NumberOfRecordedTraceEvents.GetValue() );
+  
+  return recorded - this->GetNumberOfTraceEvents();
+}
+
+
+const PerformanceProfile::TraceEvent &
+PerformanceProfile::GetTraceEvent( unsigned long i ) const
+{
+  // Once the buffer is full the oldest event is at the next slot to be written
+  const unsigned long recorded =
+    static_cast<unsigned long>( m_NumberOfRecordedTraceEvents.GetValue() );
+  const unsigned long first = ( recorded > m_TraceEvents.size() ) ? recorded : 0;
+  
+  return m_TraceEvents[ ( first + i ) % m_TraceEvents.size() ];
+}
+
+
+namespace
+{
+/** Write a string as a JSON string literal. */
+void WriteJSONString( std::ostream & os, const std::string & value )
+{
+  os << '"';
+  
+  for( std::string::const_iterator it = value.begin(); it != value.end(); ++it )
+  {
+    if( *it == '"' || *it == '\\' )
+      os << '\\' << *it;
+    else if( static_cast<unsigned char>( *it ) >= 0x20 )
+      os << *it;
+  }
+  
+  os << '"';
+}
+}
+
+
+void
+PerformanceProfile::WriteTrace( std::ostream & os, unsigned int processId,
+  const std::string & processName ) const
+{
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  
+  os.setf( std::ios::fixed, std::ios::floatfield );
+  os.precision( 3 );
+  
+  os << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+  os << "  { \"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << processId
+     << ", \"tid\": 0, \"args\": { \"name\": ";
+  WriteJSONString( os, processName );
+  os << " } }";
+  
+  // Small thread numbers in order of appearance, named after them
+  std::map<unsigned long,unsigned int> threadNumbers;
+  
+  const unsigned long numberOfEvents = this->GetNumberOfTraceEvents();
+  
+  for( unsigned long i=0; i<numberOfEvents; ++i )
+  {
+    const TraceEvent & event = this->GetTraceEvent( i );
+  
+    std::map<unsigned long,unsigned int>::iterator thread = threadNumbers.find( event.ThreadId );
+  
+    if( thread == threadNumbers.end() )
+    {
+      const unsigned int threadNumber = static_cast<unsigned int>( threadNumbers.size() + 1 );
+      thread = threadNumbers.insert( std::make_pair( event.ThreadId, threadNumber ) ).first;
+  
+      os << "," << std::endl << "  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": "
+         << processId << ", \"tid\": " << threadNumber
+         << ", \"args\": { \"name\": \"Thread " << threadNumber << "\" } }";
+    }
+  
+    os << "," << std::endl << "  { \"name\": ";
+    WriteJSONString( os, ( event.ProbeId < m_Probes.size() ) ? m_Probes[event.ProbeId].Name : "" );
+    os << ", \"cat\": \"ivan\", \"ph\": \"X\", \"pid\": " << processId
+       << ", \"tid\": " << thread->second
+       << ", \"ts\": " << 1e6 * event.StartTime
+       << ", \"dur\": " << 1e6 * ( event.EndTime - event.StartTime ) << " }";
+  }
+  
+  os << std::endl << "] }" << std::endl;
+  
+  os.flags( flags );
+  os.precision( precision );
+}
+
+
+unsigned long
+PerformanceProfile::GetCurrentThreadIdentifier()
+{
+#if defined( _WIN32 )
+  return static_cast<unsigned long>( GetCurrentThreadId() );
+#else
+  // pthread_t is an integer or a pointer depending on the system
+  const pthread_t thread = pthread_self();
+  unsigned long identifier = 0;
+  std::memcpy( &identifier, &thread, std::min( sizeof( identifier ), sizeof( thread ) ) );
+  
+  return identifier;
+#endif
+}
+
+
+void
+PerformanceProfile::Report( std::ostream & os ) const
+{
+  for( unsigned int i=0; i<m_Probes.size(); ++i )
+  {
+    os << m_Probes[i].Name << ": count " << this->GetCount(i) 
+       << ", total (s) " << this->GetTotalTime(i)
+       << ", mean (s) " << this->GetMeanTime(i) 
+       << ", p99 (s) " << this->GetPercentileTime( i, 0.99 ) << std::endl;
+  }
+}
+
+
+void
+PerformanceProfile::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfProbes: " << m_Probes.size() << std::endl;
+  os << indent << "TraceCapacity: " << m_TraceEvents.size() << std::endl;
+  os << indent << "NumberOfTraceEvents: " << this->GetNumberOfTraceEvents() << std::endl;
+  
+  for( unsigned int i=0; i<m_Probes.size(); ++i )
+  {
+    os << indent.GetNextIndent() << m_Probes[i].Name << ": " << this->GetCount(i) 
+       << " calls, " << this->GetTotalTime(i) << " s" << std::endl;
+  }
+}
+
+} // end namespace ivan
@@ -0,0 +1,281 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPerformanceProfile.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: per-run timing and counters of hot paths, removable at compile time
+// Date: 2012/11/05
+
+#ifndef __ivanPerformanceProfile_h
+#define __ivanPerformanceProfile_h
+
+#include "ivanConfigure.h"
+#include "ivanAtomicCounter.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkRealTimeClock.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+/**
+ * \class PerformanceProfile
+ * \brief Per-run timing and counters of the hot paths of a filter.
+ *
+ * A filter registers a probe per instrumented path (a stage, a scale, an image function call) 
+ * and records in it the duration of each call, usually through IVAN_PROFILE_SCOPE. For each 
+ * probe the count, total and mean time are kept, and percentiles such as p99 are estimated 
+ * from a logarithmic histogram with 8 bins per octave, so they are accurate to about 9%.
+ * IVAN_PROFILE_COUNT only counts the calls, without timing.
+ *
+ * The profile can also keep a trace of the timed calls, enabled with SetTraceCapacity(). Each
+ * call then records its probe, thread, and start and end times in a ring buffer that keeps
+ * the last events, and WriteTrace() writes them in the Chrome trace event format, which
+ * chrome://tracing and the Perfetto UI show as a timeline per thread. Writing an event takes
+ * a slot with an atomic increment and does not lock, so threads do not serialize on it.
+ *
+ * Record() may be called concurrently from several threads. Every thread accumulates its 
+ * calls in its own statistics, found through a small per-thread cache, so the threads do not 
+ * serialize on a lock of the profile. The statistics of the threads are merged when they are 
+ * read, so the getters cost time proportional to the number of threads that recorded. The 
+ * macros compile to nothing unless IVAN_USE_PROFILING is set at configure time, so the 
+ * instrumented filters pay no cost in normal builds, and their profile just stays empty.
+ *
+ * \sa MultiscaleAnalysisImageFilter
+ * \sa ImageFunctionBasedImageFilter
+ * \sa VesselTrackerFilter
+ */
+class ITK_EXPORT PerformanceProfile : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef PerformanceProfile              Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( PerformanceProfile, itk::Object );
+  
+  typedef unsigned int    ProbeIdType;
+  
+  /** Histogram of durations, from 2^MinimumExponent seconds, with BinsPerOctave bins per octave. */
+  itkStaticConstMacro( MinimumExponent, int, -30 );
+  itkStaticConstMacro( NumberOfOctaves, unsigned int, 38 );
+  itkStaticConstMacro( BinsPerOctave, unsigned int, 8 );
+  
+  /** Records the duration of its scope in a probe. Does nothing if the profile is NULL. */
+  class ScopedTimer
+  {
+  public:
+    ScopedTimer( PerformanceProfile *profile, ProbeIdType probeId ) :
+      m_Profile( profile ), m_ProbeId( probeId ), 
+      m_StartTime( profile ? profile->GetTimeStamp() : 0.0 ) {}
+      
+    ~ScopedTimer()
+      {
+        if( m_Profile )
+          m_Profile->RecordInterval( m_ProbeId, m_StartTime, m_Profile->GetTimeStamp() );
+      }
+      
+  private:
+    ScopedTimer( const ScopedTimer& ); // purposely not implemented
+    void operator=( const ScopedTimer& ); // purposely not implemented
+    
+    PerformanceProfile   *m_Profile;
+    ProbeIdType           m_ProbeId;
+    double                m_StartTime;
+  };
+  
+public:
+  
+  /** Register a probe with the given name and return its id. If a probe with that name 
+    * exists already, its id is returned. */
+  ProbeIdType RegisterProbe( const std::string & name );
+  
+  /** Get the id of the probe with the given name. Returns false if there is none. */
+  bool FindProbe( const std::string & name, ProbeIdType & probeId ) const;
+  
+  unsigned int GetNumberOfProbes() const
+    { return static_cast<unsigned int>( m_Probes.size() ); }
+  
+  const std::string & GetProbeName( ProbeIdType probeId ) const
+    { return m_Probes[probeId].Name; }
+  
+  /** Add a call of the given duration in seconds to a probe. */
+  void Record( ProbeIdType probeId, double seconds );
+  
+  /** Add a call that started and ended at the given time stamps to a probe, and to the trace
+    * if it is enabled. */
+  void RecordInterval( ProbeIdType probeId, double startTime, double endTime );
+  
+  /** Add calls to a probe without timing them. */
+  void Increment( ProbeIdType probeId, unsigned long count = 1 );
+  
+  /** Statistics of a probe. Times are in seconds and are zero for counter-only probes. */
+  unsigned long GetCount( ProbeIdType probeId ) const;
+  double GetTotalTime( ProbeIdType probeId ) const;
+  double GetMeanTime( ProbeIdType probeId ) const;
+  
+  /** Estimate the duration below which the given fraction (in [0,1], 0.99 for p99) of the 
+    * timed calls fall. */
+  double GetPercentileTime( ProbeIdType probeId, double fraction ) const;
+  
+  /** Clear the statistics of all the probes and the trace, keeping the probes registered.
+    * Filters call it at the beginning of each run. */
+  void Reset();
+  
+  /** Write a line per probe with its count, total, mean and p99 times. */
+  void Report( std::ostream & os ) const;
+  
+  /** Current time in seconds. */
+  double GetTimeStamp() const
+    { return m_Clock->GetTimeStamp(); }
+  
+  /** Timed call recorded in the trace. Times are time stamps in seconds. */
+  struct TraceEvent
+  {
+    ProbeIdType     ProbeId;
+    unsigned long   ThreadId;
+    double          StartTime;
+    double          EndTime;
+  };
+  
+  /** Set the number of events kept by the trace, discarding the current ones. Zero, the
+    * default, disables the trace. A million events take 24 MB. */
+  void SetTraceCapacity( unsigned long capacity );
+  unsigned long GetTraceCapacity() const
+    { return static_cast<unsigned long>( m_TraceEvents.size() ); }
+  
+  /** Get the number of events kept, at most the capacity. */
+  unsigned long GetNumberOfTraceEvents() const;
+  
+  /** Get the number of events overwritten by newer ones since the last reset. */
+  unsigned long GetNumberOfDroppedTraceEvents() const;
+  
+  /** Get an event kept in the trace, from 0 for the oldest. Call it when no thread is
+    * recording, e.g. after the run. */
+  const TraceEvent & GetTraceEvent( unsigned long i ) const;
+  
+  /** Write the events kept in the Chrome trace event format (JSON), as complete events with
+    * the probe names and times in microseconds, and threads numbered from 1 in order of
+    * appearance. Time stamps are absolute, so the traces of several profiles, given different
+    * process ids, can be merged in a timeline. Call it when no thread is recording. */
+  void WriteTrace( std::ostream & os, unsigned int processId = 1,
+    const std::string & processName = "ivan" ) const;
+  
+  /** Get an identifier of the calling thread, as given by the operating system. */
+  static unsigned long GetCurrentThreadIdentifier();
+
+protected:
+
+  PerformanceProfile();
+  virtual ~PerformanceProfile();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  PerformanceProfile( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+  
+  struct ProbeType
+  {
+    std::string                 Name;
+  };
+  
+  /** Statistics of a probe, of a single thread or merged. The histogram is allocated on the 
+    * first timed call. */
+  struct ProbeStatisticsType
+  {
+    ProbeStatisticsType() : Count( 0 ), TimedCount( 0 ), TotalTime( 0.0 ) {}
+    
+    unsigned long               Count;
+    unsigned long               TimedCount;
+    double                      TotalTime;
+    std::vector<unsigned long>  Histogram;
+  };
+  
+  /** Statistics of the probes recorded by a thread. The mutex is only contended by readers. */
+  struct ThreadStatisticsType
+  {
+    unsigned long                     ThreadId;
+    itk::SimpleFastMutexLock          Mutex;
+    std::vector<ProbeStatisticsType>  Probes;
+  };
+  
+  static unsigned int GetHistogramBin( double seconds );
+  
+  /** Get the statistics of the calling thread, creating them on its first call. */
+  ThreadStatisticsType * GetThreadStatistics();
+  
+  /** Merge the statistics of all the threads for the given probe. */
+  ProbeStatisticsType MergeStatistics( ProbeIdType probeId, bool withHistogram ) const;
+
+private:
+
+  itk::RealTimeClock::Pointer       m_Clock;
+  
+  /** Identifies the profile in the per-thread caches. Unlike the address, it is not reused. */
+  unsigned long                     m_SerialNumber;
+  
+  /** The mutex protects the probes and the list of threads. */
+  std::vector<ProbeType>            m_Probes;
+  std::vector<ThreadStatisticsType*>  m_ThreadStatistics;
+  mutable itk::SimpleFastMutexLock  m_Mutex;
+  
+  /** Ring buffer of the trace, and total number of events recorded in it. */
+  std::vector<TraceEvent>           m_TraceEvents;
+  AtomicCounter                     m_NumberOfRecordedTraceEvents;
+};
+
+} // end namespace ivan
+
+
+#define IVAN_PROFILE_CONCAT_DETAIL( a, b ) a##b
+#define IVAN_PROFILE_CONCAT( a, b ) IVAN_PROFILE_CONCAT_DETAIL( a, b )
+
+#ifdef IVAN_USE_PROFILING
+/** Time the rest of the enclosing scope in the given probe of the profile. */
+#define IVAN_PROFILE_SCOPE( profile, probeId ) \
+  ivan::PerformanceProfile::ScopedTimer IVAN_PROFILE_CONCAT( ivanProfileScopedTimer, __LINE__ ) \
+    ( profile, probeId )
+/** Count a call in the given probe of the profile. */
+#define IVAN_PROFILE_COUNT( profile, probeId ) \
+  ( profile )->Increment( probeId )
+#else
+#define IVAN_PROFILE_SCOPE( profile, probeId )
+#define IVAN_PROFILE_COUNT( profile, probeId )
+#endif
+
+#endif
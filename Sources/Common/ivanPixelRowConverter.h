@@ -0,0 +1,112 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPixelRowConverter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: converts rows of contiguous pixels to the real type of the kernels
+// Date: 2012/11/05
+
+#ifndef __ivanPixelRowConverter_h
+#define __ivanPixelRowConverter_h
+
+#include "ivanCPUDispatch.h"
+
+namespace ivan
+{
+/**
+ * \class PixelRowConverter
+ * \brief Converts a row of contiguous pixels to the real type of the kernels.
+ *
+ * The image functions gather the neighborhoods of the input into buffers of the type of their
+ * kernels (see NeighborhoodInnerProduct and BrickedImageBuffer) a row at a time. The generic
+ * version converts each pixel with a cast. CT studies are stored as signed short, so the rows of
+ * short pixels are given to the row conversion kernel of CPUDispatch, which widens and converts
+ * a register of pixels at a time with the widest instruction set of the processor. Rows shorter
+ * than PixelRowConverterMinimumDispatchLength, such as the runs of a brick, are converted 
+ * inline, since the call would cost more than it saves.
+ *
+ * This class only contains static methods and is safe to use from several threads.
+ *
+ * \sa CPUDispatch
+ */
+template <class TInput, class TOutput>
+class PixelRowConverter
+{
+public:
+
+  /** Convert length pixels starting at row to result. */
+  static void Convert( const TInput *row, unsigned long length, TOutput *result )
+    {
+      for( unsigned long i = 0; i < length; ++i )
+        result[i] = static_cast<TOutput>( row[i] );
+    }
+};
+
+
+/** Rows shorter than this are not given to the kernels of CPUDispatch. */
+const unsigned long PixelRowConverterMinimumDispatchLength = 16;
+
+
+template <>
+class PixelRowConverter<short,float>
+{
+public:
+
+  static void Convert( const short *row, unsigned long length, float *result )
+    {
+      if( length < PixelRowConverterMinimumDispatchLength )
+      {
+        for( unsigned long i = 0; i < length; ++i )
+          result[i] = static_cast<float>( row[i] );
+      }
+      else
+      {
+        CPUDispatch::GetKernels().ConvertShortRowToFloat( row, length, result );
+      }
+    }
+};
+
+
+template <>
+class PixelRowConverter<short,double>
+{
+public:
+
+  static void Convert( const short *row, unsigned long length, double *result )
+    {
+      if( length < PixelRowConverterMinimumDispatchLength )
+      {
+        for( unsigned long i = 0; i < length; ++i )
+          result[i] = static_cast<double>( row[i] );
+      }
+      else
+      {
+        CPUDispatch::GetKernels().ConvertShortRowToDouble( row, length, result );
+      }
+    }
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,196 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPublishedArray.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: array written by one thread and read by others without locks.
+// Date: 2012/11/05
+
+#ifndef __ivanPublishedArray_h
+#define __ivanPublishedArray_h
+
+#include "ivanMemoryOrder.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace ivan
+{
+/**
+ * \class PublishedArray
+ * \brief Array that one thread publishes and other threads read without locks.
+ *
+ * The writer keeps its values in its own container and calls Publish() whenever they are 
+ * consistent, for instance once per tracking step. Readers call GetView() and iterate the 
+ * values as they were at the last publication, while the writer goes on modifying its 
+ * container.
+ *
+ * Values are copied to blocks with spare capacity. When the writer only appended values since
+ * the last publication, they are written after the published ones and the new size is then 
+ * stored atomically, so views of the previous size still see the same values. Otherwise, or
+ * when the capacity is exhausted, the values are copied to a new block that replaces the 
+ * current one atomically, in the manner of read-copy-update. Replaced blocks are retired, not 
+ * freed, since readers may still iterate them, and they are freed by ReclaimRetiredBlocks() 
+ * once no reader holds a view, or when the array is destroyed. Blocks at least double their
+ * capacity, so retired blocks take less memory than the current one while appending. Telling
+ * appends from other edits compares the published values with the first values of the
+ * container, which for pointers is cheap compared to producing a value.
+ *
+ * Publication uses the release stores and acquire loads of MemoryOrder. Publish() and 
+ * ReclaimRetiredBlocks() must only be called from one thread at a time.
+ */
+template <class TValue>
+class PublishedArray
+{
+public:
+
+  typedef TValue          ValueType;
+  typedef unsigned long   SizeValueType;
+  
+  /** Values of a publication. Valid until ReclaimRetiredBlocks() or the array is destroyed. */
+  class View
+  {
+  public:
+  
+    View() : m_Values( 0 ), m_Size( 0 ) {}
+    
+    SizeValueType Size() const { return m_Size; }
+    bool Empty() const { return !m_Size; }
+    
+    const ValueType & operator[]( SizeValueType i ) const { return m_Values[i]; }
+    
+    const ValueType * Begin() const { return m_Values; }
+    const ValueType * End() const { return m_Values + m_Size; }
+    
+  private:
+  
+    friend class PublishedArray;
+    
+    View( const ValueType *values, SizeValueType size ) : m_Values( values ), m_Size( size ) {}
+    
+    const ValueType   *m_Values;
+    SizeValueType      m_Size;
+  };
+  
+  PublishedArray() : m_Block( 0 ), m_NumberOfPublications( 0 ) {}
+  
+  ~PublishedArray()
+    {
+      this->ReclaimRetiredBlocks();
+      delete m_Block;
+    }
+  
+  /** Publish the values in [first,last), reserving at least the given capacity if a new block
+    * is needed. Called from the writer thread. */
+  template <class TIterator>
+  void Publish( TIterator first, TIterator last, SizeValueType capacity = 0 )
+    {
+      const SizeValueType size = last - first;
+      Block *block = m_Block;
+      
+      ++m_NumberOfPublications;
+      
+      if( block && size >= block->Size && size <= block->Capacity && 
+          std::equal( first, first + block->Size, block->Values ) )
+      {
+        if( size == block->Size )
+          return;
+          
+        std::copy( first + block->Size, last, block->Values + block->Size );
+        MemoryOrder::StoreRelease( block->Size, size );
+        return;
+      }
+      
+      SizeValueType newCapacity = std::max( std::max( capacity, size ), SizeValueType( 16 ) );
+      
+      // Grow geometrically, so that appending copies each value a constant number of times
+      if( block && size > block->Capacity )
+        newCapacity = std::max( newCapacity, 2 * block->Capacity );
+        
+      Block *newBlock = new Block( newCapacity );
+      std::copy( first, last, newBlock->Values );
+      newBlock->Size = size;
+      
+      MemoryOrder::StoreRelease( m_Block, newBlock );
+      
+      if( block )
+        m_RetiredBlocks.push_back( block );
+    }
+  
+  /** Values of the last publication. Called from any thread. */
+  View GetView() const
+    {
+      Block *block = MemoryOrder::LoadAcquire( m_Block );
+      
+      if( !block )
+        return View();
+        
+      return View( block->Values, MemoryOrder::LoadAcquire( block->Size ) );
+    }
+    
+  /** Number of values of the last publication. Called from any thread. */
+  SizeValueType GetSize() const
+    { return this->GetView().Size(); }
+    
+  /** Free the replaced blocks. Called from the writer thread, when no reader holds a view. */
+  void ReclaimRetiredBlocks()
+    {
+      for( unsigned int i=0; i<m_RetiredBlocks.size(); ++i )
+        delete m_RetiredBlocks[i];
+        
+      m_RetiredBlocks.clear();
+    }
+    
+  unsigned int GetNumberOfRetiredBlocks() const
+    { return m_RetiredBlocks.size(); }
+    
+  unsigned long GetNumberOfPublications() const
+    { return m_NumberOfPublications; }
+  
+private:
+
+  PublishedArray( const PublishedArray & ); // purposely not implemented
+  void operator=( const PublishedArray & ); // purposely not implemented
+  
+  struct Block
+  {
+    explicit Block( SizeValueType capacity ) : 
+      Values( new ValueType[capacity] ), Capacity( capacity ), Size( 0 ) {}
+    ~Block() { delete [] Values; }
+    
+    ValueType              *Values;
+    SizeValueType           Capacity;
+    volatile SizeValueType  Size;
+  };
+  
+private:
+
+  Block * volatile         m_Block;
+  std::vector<Block*>      m_RetiredBlocks;
+  unsigned long            m_NumberOfPublications;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,137 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleContinuityPredictor.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Kalman filter predicting the scale of a vessel along its centerline
+// Date: 2012/11/05
+
+#include "ivanScaleContinuityPredictor.h"
+
+namespace ivan
+{
+
+ScaleContinuityPredictor::ScaleContinuityPredictor() :
+  m_ProcessNoise( 0.01 ),
+  m_MeasurementNoise( 0.25 )
+{
+  this->Reset();
+}
+
+
+void
+ScaleContinuityPredictor::Initialize( double scale )
+{
+  m_Scale = scale;
+  m_ScaleRate = 0.0;
+  
+  // The scale is known up to the measurement error while nothing is known yet about its rate
+  m_Covariance[0][0] = m_MeasurementNoise;
+  m_Covariance[0][1] = m_Covariance[1][0] = 0.0;
+  m_Covariance[1][1] = 1.0;
+  
+  m_Initialized = true;
+}
+
+
+void
+ScaleContinuityPredictor::Reset()
+{
+  m_Scale = 0.0;
+  m_ScaleRate = 0.0;
+  
+  m_Covariance[0][0] = m_Covariance[0][1] = m_Covariance[1][0] = m_Covariance[1][1] = 0.0;
+  
+  m_Initialized = false;
+}
+
+
+double
+ScaleContinuityPredictor::Predict( double arcLength )
+{
+  if( !m_Initialized )
+    itkExceptionMacro( "Predictor must be initialized before calling Predict()." );
+  
+  const double ds = arcLength;
+  
+  m_Scale += m_ScaleRate * ds;
+  
+  // P = F P F' + Q, with F = [1 ds; 0 1] and Q the discretized white noise acceleration
+  const double p00 = m_Covariance[0][0] + ds * ( m_Covariance[0][1] + m_Covariance[1][0] ) + 
+    ds * ds * m_Covariance[1][1];
+  const double p01 = m_Covariance[0][1] + ds * m_Covariance[1][1];
+  const double p11 = m_Covariance[1][1];
+  
+  m_Covariance[0][0] = p00 + m_ProcessNoise * ds * ds * ds / 3.0;
+  m_Covariance[0][1] = m_Covariance[1][0] = p01 + m_ProcessNoise * ds * ds / 2.0;
+  m_Covariance[1][1] = p11 + m_ProcessNoise * ds;
+  
+  return m_Scale;
+}
+
+
+void
+ScaleContinuityPredictor::Update( double scale )
+{
+  if( !m_Initialized )
+  {
+    this->Initialize( scale );
+    return;
+  }
+  
+  const double innovation = scale - m_Scale;
+  const double innovationCovariance = m_Covariance[0][0] + m_MeasurementNoise;
+  
+  if( innovationCovariance <= 0.0 )
+    return;
+  
+  const double gain0 = m_Covariance[0][0] / innovationCovariance;
+  const double gain1 = m_Covariance[1][0] / innovationCovariance;
+  
+  m_Scale += gain0 * innovation;
+  m_ScaleRate += gain1 * innovation;
+  
+  // P = ( I - K H ) P with H = [1 0]
+  const double p00 = m_Covariance[0][0];
+  const double p01 = m_Covariance[0][1];
+  
+  m_Covariance[0][0] = ( 1.0 - gain0 ) * p00;
+  m_Covariance[0][1] = m_Covariance[1][0] = ( 1.0 - gain0 ) * p01;
+  m_Covariance[1][1] -= gain1 * p01;
+}
+
+
+void
+ScaleContinuityPredictor::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "ProcessNoise: " << m_ProcessNoise << std::endl;
+  os << indent << "MeasurementNoise: " << m_MeasurementNoise << std::endl;
+  os << indent << "Initialized: " << m_Initialized << std::endl;
+  os << indent << "Scale: " << m_Scale << std::endl;
+  os << indent << "ScaleRate: " << m_ScaleRate << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,128 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleContinuityPredictor.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Kalman filter predicting the scale of a vessel along its centerline
+// Date: 2012/11/05
+
+#ifndef __ivanScaleContinuityPredictor_h
+#define __ivanScaleContinuityPredictor_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+
+namespace ivan
+{
+/**
+ * \class ScaleContinuityPredictor
+ * \brief One dimensional Kalman filter that predicts the scale of a vessel along its arclength.
+ *
+ * The state is the scale and its rate of change per unit of arclength, with a constant rate 
+ * model driven by white noise. Call Initialize() with the scale of the first section, then for 
+ * every following section call Predict() with the distance travelled from the previous one and 
+ * Update() with the scale finally measured at it.
+ *
+ * Since the radius is estimated proportionally to the scale, the predicted scale also predicts 
+ * the radius. This is used by the adaptive section estimators to start the search across scales 
+ * at the predicted one instead of the previous one.
+ *
+ * \sa MultiscaleAdaptiveHessianBasedVesselSectionEstimator
+ * \sa MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+ */
+class ITK_EXPORT ScaleContinuityPredictor : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ScaleContinuityPredictor        Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ScaleContinuityPredictor, itk::Object );
+  
+public:
+  
+  /** Spectral density of the noise driving the rate of change of the scale. Higher values 
+    * follow faster changes in scale. Default is 0.01. */
+  itkSetMacro( ProcessNoise, double );
+  itkGetConstMacro( ProcessNoise, double );
+  
+  /** Variance of the measured scales. Default is 0.25. */
+  itkSetMacro( MeasurementNoise, double );
+  itkGetConstMacro( MeasurementNoise, double );
+  
+  /** Reset the state to the given scale with zero rate of change. */
+  void Initialize( double scale );
+  
+  /** Forget the state. Initialize() must be called before predicting again. */
+  void Reset();
+  
+  itkGetConstMacro( Initialized, bool );
+  
+  /** Advance the state by the given arclength and return the predicted scale. */
+  double Predict( double arcLength );
+  
+  /** Correct the state with the measured scale. */
+  void Update( double scale );
+  
+  /** Get current estimate of the scale and its rate of change. */
+  itkGetConstMacro( Scale, double );
+  itkGetConstMacro( ScaleRate, double );
+  
+protected:
+
+  ScaleContinuityPredictor();
+  virtual ~ScaleContinuityPredictor() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  ScaleContinuityPredictor( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  double    m_ProcessNoise;
+  double    m_MeasurementNoise;
+  
+  bool      m_Initialized;
+  
+  double    m_Scale;
+  double    m_ScaleRate;
+  
+  /** Error covariance of the state. */
+  double    m_Covariance[2][2];
+};
+
+} // end namespace ivan
+
+#endif
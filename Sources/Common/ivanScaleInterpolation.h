@@ -0,0 +1,87 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleInterpolation.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: refinement of the scale of a maximum response between discrete scales
+// Date: 2012/11/05
+
+#ifndef __ivanScaleInterpolation_h
+#define __ivanScaleInterpolation_h
+
+#include "vcl_cmath.h"
+
+namespace ivan
+{
+/**
+ * \class ScaleInterpolation
+ * \brief Refinement of the scale of a maximum response between discrete scales.
+ *
+ * A maximum over a discrete set of scales is only as accurate as the spacing of the scales.
+ * Near its maximum, a response that is smooth across scale is well approximated by the parabola 
+ * through the responses at the selected scale and at its two neighbours, so the scale at the
+ * vertex of this parabola is a much better estimate, and fewer scales can be used for the 
+ * same accuracy. The parabola is fitted in the logarithm of the scale for logarithmically
+ * spaced scales, for which the response is closer to symmetric, and in the scale otherwise.
+ * The spacing of the three scales need not be uniform.
+ *
+ * The refined scale always lies between the midpoints of the selected scale and its 
+ * neighbours. The selected scale is returned unchanged if its response is below any of the
+ * neighbours, or equal to both, so that only a discrete maximum inside the range of scales is 
+ * refined. A maximum at the first or last scale cannot be refined.
+ */
+class ScaleInterpolation
+{
+public:
+
+  static double InterpolateMaximum( double lowerScale, double scale, double upperScale, 
+    double lowerValue, double value, double upperValue, bool logarithmic )
+    {
+      const double lowerDrop = value - lowerValue;
+      const double upperDrop = value - upperValue;
+      
+      if( lowerDrop < 0.0 || upperDrop < 0.0 || ( lowerDrop == 0.0 && upperDrop == 0.0 ) )
+        return scale;
+      
+      if( logarithmic && ( lowerScale <= 0.0 || scale <= 0.0 || upperScale <= 0.0 ) )
+        logarithmic = false;
+      
+      const double u0 = logarithmic ? vcl_log( lowerScale ) : lowerScale;
+      const double u1 = logarithmic ? vcl_log( scale ) : scale;
+      const double u2 = logarithmic ? vcl_log( upperScale ) : upperScale;
+      
+      const double lowerStep = u1 - u0;
+      const double upperStep = u2 - u1;
+      
+      // Vertex of the parabola through the three responses, the denominator is positive
+      const double vertex = u1 - 0.5 * ( lowerStep * lowerStep * upperDrop - upperStep * upperStep * lowerDrop ) /
+        ( lowerStep * upperDrop + upperStep * lowerDrop );
+      
+      return logarithmic ? vcl_exp( vertex ) : vertex;
+    }
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,99 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScratchArray.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: fixed-capacity array on the stack for temporary values in evaluation methods
+// Date: 2012/11/05
+
+#ifndef __ivanScratchArray_h
+#define __ivanScratchArray_h
+
+#include "itkMacro.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace ivan
+{
+/**
+ * \class ScratchArray
+ * \brief Array of temporary values with storage on the stack up to a fixed capacity.
+ *
+ * Evaluation methods of image functions are called once per pixel, often from several 
+ * threads at the same time. Allocating their temporary arrays on the heap (itk::Array, 
+ * std::vector) on every call is slow and the threads compete for the allocator. This array 
+ * uses an internal buffer of VCapacity elements instead, and only allocates memory when a 
+ * larger size is requested, which should be exceptional if the capacity is chosen for the 
+ * usual sizes (e.g. the number of radial samples).
+ *
+ * The size is given on construction and cannot be changed. Elements are not initialized.
+ */
+template <class TValue, unsigned int VCapacity>
+class ScratchArray
+{
+public:
+
+  typedef TValue   ValueType;
+  
+  itkStaticConstMacro( Capacity, unsigned int, VCapacity );
+
+  explicit ScratchArray( unsigned int size ) : m_Size( size ), m_Data( m_Buffer )
+    {
+      if( size > VCapacity )
+      {
+        m_HeapBuffer.resize( size );
+        m_Data = &m_HeapBuffer[0];
+      }
+    }
+  
+  unsigned int Size() const { return m_Size; }
+  
+  /** True if the elements are stored in the internal buffer. */
+  bool IsStoredInBuffer() const { return m_Data == m_Buffer; }
+  
+  void Fill( const ValueType & value ) { std::fill( m_Data, m_Data + m_Size, value ); }
+
+  ValueType & operator[]( unsigned int i ) { return m_Data[i]; }
+  const ValueType & operator[]( unsigned int i ) const { return m_Data[i]; }
+  
+  ValueType * GetDataPointer() { return m_Data; }
+  const ValueType * GetDataPointer() const { return m_Data; }
+  
+private:
+
+  ScratchArray( const ScratchArray & ); // purposely not implemented
+  void operator=( const ScratchArray & ); // purposely not implemented
+
+private:
+
+  unsigned int            m_Size;
+  ValueType               m_Buffer[VCapacity];
+  std::vector<ValueType>  m_HeapBuffer;
+  ValueType              *m_Data;
+};
+
+} // end namespace ivan
+
+#endif
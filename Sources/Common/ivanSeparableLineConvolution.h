@@ -0,0 +1,466 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSeparableLineConvolution.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: multithreaded one-dimensional convolutions of image buffers along an axis
+// Date: 2012/11/05
+
+#ifndef __ivanSeparableLineConvolution_h
+#define __ivanSeparableLineConvolution_h
+
+#include "ivanCPUDispatch.h"
+
+#include "itkMultiThreader.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace ivan
+{
+
+/** \class SeparableLineConvolution
+ * \brief Convolves image buffers with one-dimensional kernels along an axis, in parallel.
+ *
+ * This is the building block of separable filters. Each pass reads a source buffer and writes
+ * a destination buffer, both described by a BufferView (pointer to the first pixel, start 
+ * index, size and stride in pixels of each axis), so that the same code runs on image buffers
+ * and on internal arrays of intermediate results of any pixel type. The destination 
+ * value at index i is the sum of kernel[k] * source(i + (k - radius) * e) over the kernel, 
+ * where e is the unit vector of the axis, which is how itk::NeighborhoodOperatorImageFilter 
+ * applies an operator. Source pixels beyond the source region along the axis are replicated 
+ * from its boundary (zero-flux Neumann condition). In the other axes the source region must
+ * contain the destination region.
+ *
+ * Along the first axis, whose pixels are contiguous, each line is copied with its padding to a
+ * contiguous scratch line and convolved with several independent accumulators. Along the other 
+ * axes, whose pixels are strided, TileWidth adjacent lines are processed together: rows of 
+ * TileWidth contiguous pixels are copied to an interleaved tile, and the kernel is applied to 
+ * all the lines of the tile at once, so that memory is read in contiguous rows and the inner 
+ * loop runs over adjacent lines, which the compiler can vectorize. For float and double 
+ * kernels the tile is convolved by the kernel of the widest instruction set supported by the 
+ * processor (see CPUDispatch).
+ *
+ * The lines (or tiles) of a pass are split between the threads of an itk::MultiThreader.
+ *
+ * TKernel is the type of the kernel coefficients and of the accumulation. This class only 
+ * contains static methods and is safe to use from several threads.
+ *
+ * \ingroup 
+ */
+template <unsigned int VDimension, class TKernel = double>
+class SeparableLineConvolution
+{
+public:
+
+  typedef TKernel                        KernelValueType;
+  typedef std::vector<KernelValueType>   KernelType;
+
+  itkStaticConstMacro( Dimension, unsigned int, VDimension );
+  
+  /** Number of adjacent lines processed together along strided axes. */
+  itkStaticConstMacro( TileWidth, unsigned int, CPUDispatch::TileWidth );
+
+  /** Buffer of pixels of a region. Pointer points to the pixel at Index. */
+  template <class TPixel>
+  struct BufferView
+  {
+    TPixel          *Pointer;
+    long             Index[VDimension];
+    unsigned long    Size[VDimension];
+    long             Stride[VDimension];
+
+    /** Pointer to the pixel at the given index. */
+    TPixel * GetPixelPointer( const long *index ) const
+      {
+        long offset = 0;
+        for( unsigned int d = 0; d < VDimension; ++d )
+          offset += ( index[d] - Index[d] ) * Stride[d];
+        return Pointer + offset;
+      }
+  };
+
+public:
+
+  /** View of the buffered region of an image, or of a subregion of it. */
+  template <class TImage>
+  static BufferView<typename TImage::PixelType> GetImageView( TImage *image, 
+    const typename TImage::RegionType & region )
+    {
+      BufferView<typename TImage::PixelType> view;
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        view.Index[d] = region.GetIndex()[d];
+        view.Size[d] = region.GetSize()[d];
+      }
+      
+      SetContiguousStrides( view, image->GetBufferedRegion().GetSize() );
+      
+      typename TImage::PixelType *first = image->GetBufferPointer();
+      view.Pointer = first + image->ComputeOffset( region.GetIndex() );
+      
+      return view;
+    }
+  
+  template <class TImage>
+  static BufferView<const typename TImage::PixelType> GetImageView( const TImage *image, 
+    const typename TImage::RegionType & region )
+    {
+      BufferView<const typename TImage::PixelType> view;
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        view.Index[d] = region.GetIndex()[d];
+        view.Size[d] = region.GetSize()[d];
+      }
+      
+      SetContiguousStrides( view, image->GetBufferedRegion().GetSize() );
+      
+      const typename TImage::PixelType *first = image->GetBufferPointer();
+      view.Pointer = first + image->ComputeOffset( region.GetIndex() );
+      
+      return view;
+    }
+
+  /** View of one of the components of an image of fixed-length arrays (vectors, tensors...), 
+    * whose numberOfComponents values of type TValue are stored contiguously in each pixel. */
+  template <class TValue, class TImage>
+  static BufferView<TValue> GetImageComponentView( TImage *image, 
+    const typename TImage::RegionType & region, unsigned int component, 
+    unsigned int numberOfComponents )
+    {
+      BufferView<TValue> view;
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        view.Index[d] = region.GetIndex()[d];
+        view.Size[d] = region.GetSize()[d];
+      }
+      
+      SetContiguousStrides( view, image->GetBufferedRegion().GetSize() );
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+        view.Stride[d] *= numberOfComponents;
+      
+      typename TImage::PixelType *first = image->GetBufferPointer() + 
+        image->ComputeOffset( region.GetIndex() );
+      view.Pointer = reinterpret_cast<TValue *>( first ) + component;
+      
+      return view;
+    }
+
+  /** View of an array of contiguous pixels of the given region, such as an internal buffer
+    * of intermediate results, which must have at least region.GetNumberOfPixels() elements. */
+  template <class TPixel, class TRegion>
+  static BufferView<TPixel> GetArrayView( TPixel *pixels, const TRegion & region )
+    {
+      BufferView<TPixel> view;
+      view.Pointer = pixels;
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        view.Index[d] = region.GetIndex()[d];
+        view.Size[d] = region.GetSize()[d];
+      }
+      
+      SetContiguousStrides( view, region.GetSize() );
+      
+      return view;
+    }
+
+  /** Number of work units (lines, or tiles of lines along strided axes) of a pass over 
+    * the given destination. */
+  template <class TPixel>
+  static unsigned long GetNumberOfUnits( const BufferView<TPixel> & destination, unsigned int axis )
+    {
+      unsigned long units = ( axis == 0 ) ? 1 : 
+        ( destination.Size[0] + TileWidth - 1 ) / TileWidth;
+      
+      for( unsigned int d = 1; d < VDimension; ++d )
+      {
+        if( d != axis )
+          units *= destination.Size[d];
+      }
+      
+      return units;
+    }
+
+  /** Convolve the work units [firstUnit,lastUnit) of a pass. */
+  template <class TSource, class TDestination>
+  static void Convolve( const BufferView<TSource> & source, const BufferView<TDestination> & destination,
+    unsigned int axis, const KernelType & kernel, unsigned long firstUnit, unsigned long lastUnit )
+    {
+      if( axis == 0 )
+        ConvolveContiguous( source, destination, kernel, firstUnit, lastUnit );
+      else
+        ConvolveStrided( source, destination, axis, kernel, firstUnit, lastUnit );
+    }
+
+  /** Convolve a whole pass, splitting the work units between the threads. */
+  template <class TSource, class TDestination>
+  static void Convolve( const BufferView<TSource> & source, const BufferView<TDestination> & destination,
+    unsigned int axis, const KernelType & kernel, itk::MultiThreader *threader, 
+    unsigned int numberOfThreads )
+    {
+      ThreadStruct<TSource,TDestination> str;
+      str.Source = &source;
+      str.Destination = &destination;
+      str.Axis = axis;
+      str.Kernel = &kernel;
+      str.NumberOfUnits = GetNumberOfUnits( destination, axis );
+      
+      if( !threader || numberOfThreads <= 1 || str.NumberOfUnits < 2 )
+      {
+        Convolve( source, destination, axis, kernel, 0, str.NumberOfUnits );
+        return;
+      }
+      
+      threader->SetNumberOfThreads( numberOfThreads );
+      threader->SetSingleMethod( &Self::template ThreaderCallback<TSource,TDestination>, &str );
+      threader->SingleMethodExecute();
+    }
+
+private:
+
+  typedef SeparableLineConvolution   Self;
+
+  template <class TSource, class TDestination>
+  struct ThreadStruct
+  {
+    const BufferView<TSource>        *Source;
+    const BufferView<TDestination>   *Destination;
+    unsigned int                      Axis;
+    const KernelType                 *Kernel;
+    unsigned long                     NumberOfUnits;
+  };
+
+  template <class TSource, class TDestination>
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback( void *arg )
+    {
+      itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)( arg );
+      ThreadStruct<TSource,TDestination> *str = (ThreadStruct<TSource,TDestination> *)( info->UserData );
+      
+      const unsigned long firstUnit = str->NumberOfUnits * info->ThreadID / info->NumberOfThreads;
+      const unsigned long lastUnit = str->NumberOfUnits * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+      
+      Convolve( *str->Source, *str->Destination, str->Axis, *str->Kernel, firstUnit, lastUnit );
+      
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+  template <class TView, class TSize>
+  static void SetContiguousStrides( TView & view, const TSize & bufferSize )
+    {
+      long stride = 1;
+      
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        view.Stride[d] = stride;
+        stride *= static_cast<long>( bufferSize[d] );
+      }
+    }
+
+  /** Index of the first pixel of a work unit. Along the first axis units are lines, ordered 
+    * by the other axes. Along other axes units are tiles, ordered by the tile in the first 
+    * axis and then by the axes other than the first and the convolved one. */
+  template <class TPixel>
+  static void GetUnitIndex( const BufferView<TPixel> & destination, unsigned int axis, 
+    unsigned long unit, long *index )
+    {
+      if( axis == 0 )
+      {
+        index[0] = destination.Index[0];
+      }
+      else
+      {
+        const unsigned long numberOfTiles = ( destination.Size[0] + TileWidth - 1 ) / TileWidth;
+        index[0] = destination.Index[0] + static_cast<long>( ( unit % numberOfTiles ) * TileWidth );
+        unit /= numberOfTiles;
+      }
+      
+      for( unsigned int d = 1; d < VDimension; ++d )
+      {
+        if( d == axis )
+        {
+          index[d] = destination.Index[d];
+          continue;
+        }
+        
+        index[d] = destination.Index[d] + static_cast<long>( unit % destination.Size[d] );
+        unit /= destination.Size[d];
+      }
+    }
+
+  template <class TSource, class TDestination>
+  static void ConvolveContiguous( const BufferView<TSource> & source, 
+    const BufferView<TDestination> & destination, const KernelType & kernel, 
+    unsigned long firstUnit, unsigned long lastUnit )
+    {
+      const long radius = static_cast<long>( kernel.size() / 2 );
+      const long length = static_cast<long>( destination.Size[0] );
+      const long sourceFirst = source.Index[0];
+      const long sourceLast = source.Index[0] + static_cast<long>( source.Size[0] ) - 1;
+      
+      std::vector<KernelValueType> line( length + 2 * radius );
+      
+      long index[VDimension];
+      
+      for( unsigned long unit = firstUnit; unit < lastUnit; ++unit )
+      {
+        GetUnitIndex( destination, 0, unit, index );
+        
+        // Copy the line with its padding, replicating the boundary of the source
+        long sourceIndex[VDimension];
+        std::copy( index, index + VDimension, sourceIndex );
+        sourceIndex[0] = sourceFirst;
+        
+        const TSource *in = source.GetPixelPointer( sourceIndex );
+        
+        for( long j = 0; j < length + 2 * radius; ++j )
+        {
+          const long position = std::min( std::max( index[0] - radius + j, sourceFirst ), sourceLast );
+          line[j] = static_cast<KernelValueType>( in[ ( position - sourceFirst ) * source.Stride[0] ] );
+        }
+        
+        TDestination *out = destination.GetPixelPointer( index );
+        
+        for( long i = 0; i < length; ++i )
+        {
+          const KernelValueType *values = &line[i];
+          
+          KernelValueType sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+          unsigned int k = 0;
+          
+          for( ; k + 4 <= kernel.size(); k += 4 )
+          {
+            sum0 += kernel[k]   * values[k];
+            sum1 += kernel[k+1] * values[k+1];
+            sum2 += kernel[k+2] * values[k+2];
+            sum3 += kernel[k+3] * values[k+3];
+          }
+          for( ; k < kernel.size(); ++k )
+            sum0 += kernel[k] * values[k];
+          
+          out[ i * destination.Stride[0] ] = static_cast<TDestination>( ( sum0 + sum1 ) + ( sum2 + sum3 ) );
+        }
+      }
+    }
+
+  template <class TSource, class TDestination>
+  static void ConvolveStrided( const BufferView<TSource> & source, 
+    const BufferView<TDestination> & destination, unsigned int axis, const KernelType & kernel, 
+    unsigned long firstUnit, unsigned long lastUnit )
+    {
+      const long radius = static_cast<long>( kernel.size() / 2 );
+      const long length = static_cast<long>( destination.Size[axis] );
+      const long sourceFirst = source.Index[axis];
+      const long sourceLast = source.Index[axis] + static_cast<long>( source.Size[axis] ) - 1;
+      const long destinationEnd = destination.Index[0] + static_cast<long>( destination.Size[0] );
+      
+      if( length == 0 )
+        return;
+      
+      // Interleaved tile, TileWidth values per position along the axis
+      std::vector<KernelValueType> tile( ( length + 2 * radius ) * TileWidth );
+      std::vector<KernelValueType> result( length * TileWidth );
+      
+      long index[VDimension];
+      
+      for( unsigned long unit = firstUnit; unit < lastUnit; ++unit )
+      {
+        GetUnitIndex( destination, axis, unit, index );
+        
+        const long width = std::min( static_cast<long>( TileWidth ), destinationEnd - index[0] );
+        
+        // Copy the rows of the tile, replicating the boundary of the source along the axis
+        long sourceIndex[VDimension];
+        std::copy( index, index + VDimension, sourceIndex );
+        
+        for( long j = 0; j < length + 2 * radius; ++j )
+        {
+          sourceIndex[axis] = std::min( std::max( index[axis] - radius + j, sourceFirst ), sourceLast );
+          
+          const TSource *in = source.GetPixelPointer( sourceIndex );
+          KernelValueType *row = &tile[ j * TileWidth ];
+          
+          for( long b = 0; b < width; ++b )
+            row[b] = static_cast<KernelValueType>( in[ b * source.Stride[0] ] );
+        }
+        
+        ConvolveTile( &tile[0], length, &kernel[0], static_cast<unsigned int>( kernel.size() ), &result[0] );
+        
+        TDestination *out = destination.GetPixelPointer( index );
+        
+        for( long i = 0; i < length; ++i )
+        {
+          const KernelValueType *sums = &result[ i * TileWidth ];
+          TDestination *outRow = out + i * destination.Stride[axis];
+          
+          for( long b = 0; b < width; ++b )
+            outRow[ b * destination.Stride[0] ] = static_cast<TDestination>( sums[b] );
+        }
+      }
+    }
+  
+  /** Convolution of an interleaved tile (see CPUDispatch::TileConvolutionDoubleFunction). 
+    * Float and double use the kernels selected at run time. */
+  template <class TValue>
+  static void ConvolveTile( const TValue *tile, unsigned long length, const TValue *kernel, 
+    unsigned int kernelSize, TValue *result )
+    {
+      for( unsigned long i = 0; i < length; ++i )
+      {
+        TValue *sums = result + i * TileWidth;
+        
+        for( unsigned int b = 0; b < TileWidth; ++b )
+          sums[b] = 0;
+        
+        for( unsigned int k = 0; k < kernelSize; ++k )
+        {
+          const TValue coefficient = kernel[k];
+          const TValue *row = tile + ( i + k ) * TileWidth;
+          
+          for( unsigned int b = 0; b < TileWidth; ++b )
+            sums[b] += coefficient * row[b];
+        }
+      }
+    }
+  
+  static void ConvolveTile( const double *tile, unsigned long length, const double *kernel, 
+    unsigned int kernelSize, double *result )
+    {
+      CPUDispatch::GetKernels().ConvolveTileDouble( tile, length, kernel, kernelSize, result );
+    }
+  
+  static void ConvolveTile( const float *tile, unsigned long length, const float *kernel, 
+    unsigned int kernelSize, float *result )
+    {
+      CPUDispatch::GetKernels().ConvolveTileFloat( tile, length, kernel, kernelSize, result );
+    }
+};
+
+} // end namespace ivan
+
+#endif
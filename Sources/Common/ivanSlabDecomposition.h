@@ -0,0 +1,153 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSlabDecomposition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: division of an image region in slabs with halos for distributed processing
+// Date: 2012/11/05
+
+#ifndef __ivanSlabDecomposition_h
+#define __ivanSlabDecomposition_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+
+#include <vector>
+
+namespace ivan
+{
+/**
+ * \class SlabDecomposition
+ * \brief Divides an image region in slabs along one dimension, each with a halo region.
+ *
+ * Used to distribute the detection of a volume that does not fit in the memory of a single 
+ * machine among several processes (for example MPI ranks), each of which computes one slab.
+ * The slabs do not overlap and cover the region. Their sizes along SlabDimension differ by 
+ * one pixel at most, so that all the processes get the same work, which is not the case with 
+ * itk::ImageRegionSplitter. The padded slab is the slab grown by HaloRadius and cropped to the
+ * region, and is the part of the input a process needs to read.
+ *
+ * The multiscale filters already pad their input requested region by the support of the 
+ * largest scale (see MultiscaleAnalysisImageFilter::GetPaddedInputRegion()), as does 
+ * ImageFunctionBasedImageFilter with its InputPadding, so requesting a slab of their output 
+ * from a streaming reader only reads the padded slab.
+ *
+ * Call Initialize() after setting the region, the number of slabs and the halo.
+ *
+ * This class is templated over the image dimension.
+ *
+ * \sa ImageRegionTileScheduler
+ */
+template <unsigned int VImageDimension>
+class ITK_EXPORT SlabDecomposition : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef SlabDecomposition               Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SlabDecomposition, Object );
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VImageDimension );
+  
+  typedef itk::ImageRegion<VImageDimension>       RegionType;
+  typedef typename RegionType::IndexType          IndexType;
+  typedef typename RegionType::SizeType           SizeType;
+  
+  typedef std::vector<RegionType>                 RegionContainerType;
+  
+public:
+  
+  /** Set/Get the region to divide, usually the largest possible region of the image. */
+  itkSetMacro( Region, RegionType );
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  /** Set/Get the requested number of slabs. Fewer slabs are made if the region has fewer 
+    * pixels along SlabDimension. Default is 1. */
+  itkSetMacro( RequestedNumberOfSlabs, unsigned int );
+  itkGetConstMacro( RequestedNumberOfSlabs, unsigned int );
+  
+  /** Set/Get the dimension along which the region is divided. Default is the last one, so 
+    * that each slab is contiguous in memory and in the image file. */
+  itkSetClampMacro( SlabDimension, unsigned int, 0, VImageDimension - 1 );
+  itkGetConstMacro( SlabDimension, unsigned int );
+  
+  /** Set/Get the radius in pixels of the halo of each slab. Default is zero. */
+  itkSetMacro( HaloRadius, SizeType );
+  itkGetConstReferenceMacro( HaloRadius, SizeType );
+  
+  /** Set the same halo radius for all the dimensions. */
+  void SetHaloRadius( unsigned long radius );
+  
+  /** Divide the region in slabs. */
+  void Initialize();
+  
+  /** Get the number of slabs made by Initialize(). */
+  unsigned int GetNumberOfSlabs() const
+    { return this->m_Slabs.size(); }
+  
+  /** Get the i-th slab. */
+  const RegionType & GetSlab( unsigned int i ) const
+    { return this->m_Slabs[i]; }
+  
+  /** Get the i-th slab padded by the halo and cropped to the region. */
+  RegionType GetPaddedSlab( unsigned int i ) const;
+  
+protected:
+
+  SlabDecomposition();
+  ~SlabDecomposition() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  SlabDecomposition( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  RegionType            m_Region;
+  unsigned int          m_RequestedNumberOfSlabs;
+  unsigned int          m_SlabDimension;
+  SizeType              m_HaloRadius;
+  
+  RegionContainerType   m_Slabs;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanSlabDecomposition.hxx"
+#endif
+
+#endif
@@ -0,0 +1,125 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSlabDecomposition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: division of an image region in slabs with halos for distributed processing
+// Date: 2012/11/05
+
+#ifndef __ivanSlabDecomposition_hxx
+#define __ivanSlabDecomposition_hxx
+
+#include "ivanSlabDecomposition.h"
+
+#include "vnl/vnl_math.h"
+
+namespace ivan
+{
+
+template <unsigned int VImageDimension>
+SlabDecomposition<VImageDimension>
+::SlabDecomposition() :
+  m_RequestedNumberOfSlabs( 1 ),
+  m_SlabDimension( VImageDimension - 1 )
+{
+  this->m_HaloRadius.Fill( 0 );
+}
+
+
+template <unsigned int VImageDimension>
+void
+SlabDecomposition<VImageDimension>
+::SetHaloRadius( unsigned long radius )
+{
+  SizeType size;
+  size.Fill( radius );
+  this->SetHaloRadius( size );
+}
+
+
+template <unsigned int VImageDimension>
+void
+SlabDecomposition<VImageDimension>
+::Initialize()
+{
+  this->m_Slabs.clear();
+  
+  const unsigned long length = this->m_Region.GetSize()[this->m_SlabDimension];
+  
+  if( length == 0 )
+    return;
+  
+  const unsigned long numberOfSlabs = vnl_math_max( 1ul, 
+    vnl_math_min( static_cast<unsigned long>( this->m_RequestedNumberOfSlabs ), length ) );
+  
+  this->m_Slabs.reserve( numberOfSlabs );
+  
+  // Balanced split: the slab sizes differ by one pixel at most
+  for( unsigned long i=0; i<numberOfSlabs; ++i )
+  {
+    const unsigned long begin = ( length * i ) / numberOfSlabs;
+    const unsigned long end = ( length * ( i + 1 ) ) / numberOfSlabs;
+    
+    IndexType index = this->m_Region.GetIndex();
+    SizeType size = this->m_Region.GetSize();
+    
+    index[this->m_SlabDimension] += static_cast<typename IndexType::IndexValueType>( begin );
+    size[this->m_SlabDimension] = end - begin;
+    
+    this->m_Slabs.push_back( RegionType( index, size ) );
+  }
+}
+
+
+template <unsigned int VImageDimension>
+typename SlabDecomposition<VImageDimension>::RegionType
+SlabDecomposition<VImageDimension>
+::GetPaddedSlab( unsigned int i ) const
+{
+  RegionType slab = this->m_Slabs[i];
+  
+  slab.PadByRadius( this->m_HaloRadius );
+  slab.Crop( this->m_Region );
+  
+  return slab;
+}
+
+
+template <unsigned int VImageDimension>
+void
+SlabDecomposition<VImageDimension>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "RequestedNumberOfSlabs: " << this->m_RequestedNumberOfSlabs << std::endl;
+  os << indent << "SlabDimension: " << this->m_SlabDimension << std::endl;
+  os << indent << "HaloRadius: " << this->m_HaloRadius << std::endl;
+  os << indent << "NumberOfSlabs: " << this->m_Slabs.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
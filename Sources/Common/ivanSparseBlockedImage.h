@@ -0,0 +1,240 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSparseBlockedImage.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Image storing its pixels in blocks allocated on demand.
+// Date: 2012/11/05
+
+#ifndef __ivanSparseBlockedImage_h
+#define __ivanSparseBlockedImage_h
+
+#include "ivanMemoryOrder.h"
+
+#include "itkImageBase.h"
+#include "itkLightObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+namespace ivan
+{
+
+/**
+ * \class SparseBlockedImage
+ * \brief Image whose pixels are stored in blocks allocated on the first write of a value other
+ * than the background.
+ *
+ * Vesselness, scale and normal images are zero almost everywhere but the vessels, and storing 
+ * them densely takes most of the memory of a detection. This image divides the buffered region
+ * in blocks of VBlockSize pixels per dimension, which are only allocated (filled with the 
+ * background value) when a pixel with a value other than the background is set in them. A table
+ * with one pointer per block locates the pixels, so GetPixel() and SetPixel() take constant 
+ * time. Reading a pixel of an unallocated block returns the background value.
+ *
+ * The image has the geometry of itk::ImageBase, and the Allocate(), FillBuffer(), GetPixel() and 
+ * SetPixel() methods of itk::Image, so it can be the output of filters that write their output 
+ * with SetPixel(), such as FrontPropagationImageFunctionBasedImageFilter, and the input of image
+ * functions that read with GetPixel(), such as itk::LinearInterpolateImageFunction and 
+ * itk::NearestNeighborInterpolateImageFunction. It does not provide a pixel buffer, so image 
+ * iterators can't be used on it. FillBuffer() releases all the blocks and sets the background.
+ *
+ * SetPixel() may be called concurrently from several threads for different pixels. Blocks are
+ * allocated under a lock and their pointer is stored with a release store once they are filled,
+ * so threads that find the block without the lock (with an acquire load) see the background 
+ * values. Graft() shares the blocks with the grafted image.
+ *
+ * \sa itk::Image
+ */
+template <class TPixel, unsigned int VDimension = 3, unsigned int VBlockSize = 8>
+class ITK_EXPORT SparseBlockedImage : public itk::ImageBase<VDimension>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef SparseBlockedImage                   Self;
+  typedef itk::ImageBase<VDimension>           Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+  typedef itk::WeakPointer<const Self>         ConstWeakPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SparseBlockedImage, ImageBase );
+  
+  typedef TPixel                                  PixelType;
+  typedef TPixel                                  ValueType;
+  typedef TPixel                                  InternalPixelType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VDimension );
+  itkStaticConstMacro( BlockSize, unsigned int, VBlockSize );
+  
+  typedef typename Superclass::IndexType          IndexType;
+  typedef typename Superclass::SizeType           SizeType;
+  typedef typename Superclass::RegionType         RegionType;
+  typedef typename Superclass::SpacingType        SpacingType;
+  typedef typename Superclass::PointType          PointType;
+  
+  /** Table of blocks, shared by grafted images. */
+  class BlockContainer : public itk::LightObject
+  {
+  public:
+    typedef BlockContainer                    Self;
+    typedef itk::LightObject                  Superclass;
+    typedef itk::SmartPointer<Self>           Pointer;
+    
+    itkNewMacro( Self );
+    itkTypeMacro( BlockContainer, LightObject );
+    
+    /** Release all the blocks and resize the table. */
+    void Reset( unsigned long numberOfBlocks );
+    
+    /** Get the pixels of a block, null if not allocated, after they were published. */
+    PixelType * GetBlock( unsigned long block ) const
+      {
+        PixelType * const volatile & pixels = this->Blocks[block];
+        return MemoryOrder::LoadAcquire( pixels );
+      }
+    
+    /** Publish the pixels of a block once they are initialized. */
+    void PublishBlock( unsigned long block, PixelType *pixels )
+      {
+        PixelType * volatile & target = this->Blocks[block];
+        MemoryOrder::StoreRelease( target, pixels );
+      }
+    
+    /** Pointers to the pixels of each block, null if not allocated. */
+    std::vector<PixelType *>    Blocks;
+    unsigned long               NumberOfAllocatedBlocks;
+    itk::SimpleFastMutexLock    Mutex;
+    
+  protected:
+    BlockContainer() : NumberOfAllocatedBlocks( 0 ) {}
+    ~BlockContainer() { this->Reset( 0 ); }
+    
+  private:
+    BlockContainer(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+  };
+  
+public:
+  
+  /** Build the (empty) table of blocks of the buffered region. */
+  void Allocate();
+  
+  /** Restore the image to its initial state, releasing the blocks. */
+  virtual void Initialize();
+  
+  /** Release all the blocks and set the background to the given value. */
+  void FillBuffer( const PixelType & value );
+  
+  /** Get the pixel at the given index, which must be inside the buffered region. */
+  const PixelType & GetPixel( const IndexType & index ) const
+    {
+      unsigned long block, offset;
+      this->ComputeBlockAndOffset( index, block, offset );
+      
+      const PixelType *pixels = this->m_BlockContainer->GetBlock( block );
+      return pixels ? pixels[offset] : this->m_BackgroundValue;
+    }
+  
+  /** Set the pixel at the given index, allocating its block if the value is not the background. */
+  void SetPixel( const IndexType & index, const PixelType & value );
+  
+  /** Get the value of the pixels of unallocated blocks. Zero by default. */
+  itkGetConstReferenceMacro( BackgroundValue, PixelType );
+  
+  /** Get the number of blocks of the buffered region. */
+  unsigned long GetNumberOfBlocks() const
+    { return this->m_BlockContainer->Blocks.size(); }
+  
+  /** Get the number of allocated blocks. */
+  unsigned long GetNumberOfAllocatedBlocks() const
+    { return this->m_BlockContainer->NumberOfAllocatedBlocks; }
+  
+  /** Get the number of pixels of a block. */
+  static unsigned long GetNumberOfPixelsPerBlock();
+  
+  /** Get the memory used by the blocks and the table, in bytes. */
+  unsigned long GetMemorySize() const;
+  
+  /** Get the block container. */
+  BlockContainer * GetBlockContainer()
+    { return this->m_BlockContainer; }
+  const BlockContainer * GetBlockContainer() const
+    { return this->m_BlockContainer; }
+  
+  /** Copy the geometry and share the blocks of another SparseBlockedImage. */
+  virtual void Graft( const itk::DataObject *data );
+  
+protected:
+
+  SparseBlockedImage();
+  virtual ~SparseBlockedImage() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Index of the block of a pixel and offset of the pixel in the block. */
+  void ComputeBlockAndOffset( const IndexType & index, unsigned long & block, 
+    unsigned long & offset ) const
+    {
+      const IndexType & start = this->GetBufferedRegion().GetIndex();
+      
+      block = 0;
+      offset = 0;
+      
+      unsigned long pixelStride = 1;
+      
+      for( unsigned int d=0; d<VDimension; ++d )
+      {
+        const unsigned long position = static_cast<unsigned long>( index[d] - start[d] );
+        block += ( position / VBlockSize ) * this->m_BlockStrides[d];
+        offset += ( position % VBlockSize ) * pixelStride;
+        pixelStride *= VBlockSize;
+      }
+    }
+  
+private:
+
+  SparseBlockedImage(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+  typename BlockContainer::Pointer    m_BlockContainer;
+  
+  /** Stride of the blocks in the table along each dimension. */
+  unsigned long                       m_BlockStrides[VDimension];
+  
+  PixelType                           m_BackgroundValue;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanSparseBlockedImage.hxx"
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSparseBlockedImage.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Image storing its pixels in blocks allocated on demand.
+// Date: 2012/11/05
+
+#ifndef __ivanSparseBlockedImage_hxx
+#define __ivanSparseBlockedImage_hxx
+
+#include "ivanSparseBlockedImage.h"
+
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+namespace ivan
+{
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>::BlockContainer
+::Reset( unsigned long numberOfBlocks )
+{
+  for( unsigned long i=0; i<this->Blocks.size(); ++i )
+    delete [] this->Blocks[i];
+  
+  this->Blocks.assign( numberOfBlocks, static_cast<PixelType *>( 0 ) );
+  this->NumberOfAllocatedBlocks = 0;
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::SparseBlockedImage() :
+  m_BackgroundValue( itk::NumericTraits<PixelType>::Zero )
+{
+  this->m_BlockContainer = BlockContainer::New();
+  std::fill( this->m_BlockStrides, this->m_BlockStrides + VDimension, 0ul );
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+unsigned long
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::GetNumberOfPixelsPerBlock()
+{
+  unsigned long numberOfPixels = 1;
+  
+  for( unsigned int d=0; d<VDimension; ++d )
+    numberOfPixels *= VBlockSize;
+  
+  return numberOfPixels;
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::Allocate()
+{
+  const SizeType & size = this->GetBufferedRegion().GetSize();
+  
+  unsigned long numberOfBlocks = 1;
+  
+  for( unsigned int d=0; d<VDimension; ++d )
+  {
+    this->m_BlockStrides[d] = numberOfBlocks;
+    numberOfBlocks *= ( size[d] + VBlockSize - 1 ) / VBlockSize;
+  }
+  
+  // A new container, so that images this one was grafted to keep their blocks
+  this->m_BlockContainer = BlockContainer::New();
+  this->m_BlockContainer->Reset( numberOfBlocks );
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::Initialize()
+{
+  Superclass::Initialize();
+  
+  this->m_BlockContainer = BlockContainer::New();
+  std::fill( this->m_BlockStrides, this->m_BlockStrides + VDimension, 0ul );
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::FillBuffer( const PixelType & value )
+{
+  this->m_BlockContainer->Reset( this->m_BlockContainer->Blocks.size() );
+  this->m_BackgroundValue = value;
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::SetPixel( const IndexType & index, const PixelType & value )
+{
+  unsigned long block, offset;
+  this->ComputeBlockAndOffset( index, block, offset );
+  
+  BlockContainer *container = this->m_BlockContainer;
+  PixelType *pixels = container->GetBlock( block );
+  
+  if( !pixels )
+  {
+    // Nothing to store, the pixel already has the background value
+    if( value == this->m_BackgroundValue )
+      return;
+    
+    container->Mutex.Lock();
+    
+    pixels = container->Blocks[block];
+    
+    if( !pixels )
+    {
+      const unsigned long numberOfPixels = GetNumberOfPixelsPerBlock();
+      
+      pixels = new PixelType[numberOfPixels];
+      std::fill( pixels, pixels + numberOfPixels, this->m_BackgroundValue );
+      
+      // Other threads may read the pointer without the lock, so it is stored after the pixels
+      container->PublishBlock( block, pixels );
+      ++container->NumberOfAllocatedBlocks;
+    }
+    
+    container->Mutex.Unlock();
+  }
+  
+  pixels[offset] = value;
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+unsigned long
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::GetMemorySize() const
+{
+  return this->GetNumberOfAllocatedBlocks() * GetNumberOfPixelsPerBlock() * sizeof( PixelType ) +
+    this->GetNumberOfBlocks() * sizeof( PixelType * );
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::Graft( const itk::DataObject *data )
+{
+  Superclass::Graft( data );
+  
+  const Self *image = dynamic_cast<const Self *>( data );
+  
+  if( !image )
+  {
+    itkExceptionMacro( << "ivan::SparseBlockedImage::Graft() cannot cast " << typeid( data ).name() 
+      << " to " << typeid( const Self * ).name() );
+  }
+  
+  this->m_BlockContainer = const_cast<BlockContainer *>( image->GetBlockContainer() );
+  std::copy( image->m_BlockStrides, image->m_BlockStrides + VDimension, this->m_BlockStrides );
+  this->m_BackgroundValue = image->m_BackgroundValue;
+}
+
+
+template <class TPixel, unsigned int VDimension, unsigned int VBlockSize>
+void
+SparseBlockedImage<TPixel,VDimension,VBlockSize>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "BlockSize: " << VBlockSize << std::endl;
+  os << indent << "NumberOfBlocks: " << this->GetNumberOfBlocks() << std::endl;
+  os << indent << "NumberOfAllocatedBlocks: " << this->GetNumberOfAllocatedBlocks() << std::endl;
+  os << indent << "BackgroundValue: " 
+     << static_cast<typename itk::NumericTraits<PixelType>::PrintType>( this->m_BackgroundValue ) << std::endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,242 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSphereSamplingTableCache.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide cache of immutable unit sphere sampling tables
+// Date: 2012/11/05
+
+#include "ivanSphereSamplingTableCache.h"
+#include "ivanRegularSphereMeshSource2.h"
+
+#include "vnl/vnl_vector_fixed.h"
+#include "vnl/vnl_cross.h"
+
+#include <cmath>
+
+namespace ivan
+{
+
+namespace
+{
+/** Area of the spherical triangle with the given unit vertices. */
+double SphericalTriangleArea( const vnl_vector_fixed<double,3> & a, 
+  const vnl_vector_fixed<double,3> & b, const vnl_vector_fixed<double,3> & c )
+{
+  const double tripleProduct = dot_product( a, vnl_cross_3d( b, c ) );
+  return 2.0 * std::atan2( std::fabs( tripleProduct ), 
+    1.0 + dot_product( a, b ) + dot_product( b, c ) + dot_product( c, a ) );
+}
+}
+
+
+void
+SphereSamplingTable::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Decimation: " << m_Decimation << std::endl;
+  os << indent << "NumberOfPoints: " << m_NumberOfPoints << std::endl;
+}
+
+
+SphereSamplingTableCache::Pointer SphereSamplingTableCache::m_Instance;
+itk::SimpleFastMutexLock SphereSamplingTableCache::m_InstanceMutex;
+
+
+SphereSamplingTableCache::Pointer
+SphereSamplingTableCache::GetInstance()
+{
+  m_InstanceMutex.Lock();
+  
+  if( m_Instance.IsNull() )
+  {
+    m_Instance = new Self;
+    m_Instance->UnRegister(); // the smart pointer holds the only reference
+  }
+  
+  Pointer instance = m_Instance;
+  
+  m_InstanceMutex.Unlock();
+  
+  return instance;
+}
+
+
+SphereSamplingTable::ConstPointer
+SphereSamplingTableCache::GetTable( unsigned int decimation )
+{
+  m_Mutex.Lock();
+  
+  SphereSamplingTable::ConstPointer & table = m_Tables[decimation];
+  
+  if( table.IsNull() )
+    table = BuildTable( decimation ).GetPointer();
+    
+  SphereSamplingTable::ConstPointer result = table;
+  
+  m_Mutex.Unlock();
+  
+  return result;
+}
+
+
+void
+SphereSamplingTableCache::Clear()
+{
+  m_Mutex.Lock();
+  m_Tables.clear();
+  m_Mutex.Unlock();
+}
+
+
+unsigned long
+SphereSamplingTableCache::GetNumberOfTables() const
+{
+  m_Mutex.Lock();
+  unsigned long numberOfTables = m_Tables.size();
+  m_Mutex.Unlock();
+  
+  return numberOfTables;
+}
+
+
+SphereSamplingTable::Pointer
+SphereSamplingTableCache::BuildTable( unsigned int decimation )
+{
+  typedef RegularSphereMeshSource2<double>         SphereSourceType;
+  typedef SphereSourceType::OutputMeshType         SphereType;
+  typedef vnl_vector_fixed<double,3>               VectorType;
+  
+  SphereSourceType::Pointer sphereSource = SphereSourceType::New();
+  sphereSource->SetRadius( 1.0 );
+  sphereSource->SetDecimation( decimation );
+  sphereSource->Update();
+  
+  SphereType::Pointer sphere = sphereSource->GetOutput();
+  SphereType::PointsContainer *spherePoints = sphere->GetPoints();
+  
+  SphereSamplingTable::Pointer table = SphereSamplingTable::New();
+  
+  const unsigned int numberOfPoints = spherePoints->Size();
+  
+  table->m_Decimation = decimation;
+  table->m_NumberOfPoints = numberOfPoints;
+  table->m_NormalTable.assign( 3 * numberOfPoints, 0.0 );
+  table->m_WeightTable.assign( numberOfPoints, 1.0 );
+  table->m_UniformWeightTable.assign( numberOfPoints, 1.0 );
+  
+  // Normals, and position in the tables of each point identifier
+  std::vector<unsigned int> tablePositions;
+  unsigned int pointIdx = 0;
+  
+  for( SphereType::PointsContainerIterator pointIterator = spherePoints->Begin();
+       pointIterator != spherePoints->End(); ++pointIterator, ++pointIdx )
+  {
+    double norm = 0.0;
+    for( unsigned int dim = 0; dim < 3; ++dim )
+      norm += pointIterator.Value()[dim] * pointIterator.Value()[dim];
+    
+    norm = std::sqrt( norm );
+    
+    for( unsigned int dim = 0; dim < 3; ++dim )
+      table->m_NormalTable[dim * numberOfPoints + pointIdx] = 
+        ( norm > 0.0 ) ? pointIterator.Value()[dim] / norm : 0.0;
+        
+    if( pointIterator.Index() >= tablePositions.size() )
+      tablePositions.resize( pointIterator.Index() + 1, 0 );
+    
+    tablePositions[pointIterator.Index()] = pointIdx;
+  }
+  
+  std::vector<double> areas( numberOfPoints, 0.0 );
+  
+  // The Voronoi cell of a vertex inside a triangle is bounded by the bisectors of its two edges,
+  // which meet at the circumcenter, so each triangle contributes to each of its vertices the 
+  // two spherical triangles vertex-edge midpoint-circumcenter
+  typedef SphereType::CellsContainer::ConstIterator  CellIterator;
+  
+  for( CellIterator cellIterator = sphere->GetCells()->Begin(); 
+       cellIterator != sphere->GetCells()->End(); ++cellIterator )
+  {
+    const SphereType::CellType *cell = cellIterator.Value();
+    
+    if( cell->GetNumberOfPoints() != 3 )
+      continue;
+    
+    unsigned int positions[3];
+    VectorType vertices[3];
+    
+    for( unsigned int i=0; i<3; ++i )
+    {
+      positions[i] = tablePositions[ *( cell->PointIdsBegin() + i ) ];
+      
+      for( unsigned int dim=0; dim<3; ++dim )
+        vertices[i][dim] = table->m_NormalTable[dim * numberOfPoints + positions[i]];
+    }
+    
+    VectorType circumcenter = vnl_cross_3d( vertices[1] - vertices[0], vertices[2] - vertices[0] );
+    circumcenter.normalize();
+    
+    if( dot_product( circumcenter, vertices[0] + vertices[1] + vertices[2] ) < 0.0 )
+      circumcenter *= -1.0;
+    
+    for( unsigned int i=0; i<3; ++i )
+    {
+      const VectorType & vertex = vertices[i];
+      
+      VectorType firstMidpoint = vertex + vertices[(i+1)%3];
+      VectorType secondMidpoint = vertex + vertices[(i+2)%3];
+      firstMidpoint.normalize();
+      secondMidpoint.normalize();
+      
+      areas[positions[i]] += SphericalTriangleArea( vertex, firstMidpoint, circumcenter ) +
+        SphericalTriangleArea( vertex, circumcenter, secondMidpoint );
+    }
+  }
+  
+  double totalArea = 0.0;
+  
+  for( unsigned int i=0; i<numberOfPoints; ++i )
+    totalArea += areas[i];
+  
+  if( totalArea > 0.0 )
+  {
+    for( unsigned int i=0; i<numberOfPoints; ++i )
+      table->m_WeightTable[i] = numberOfPoints * areas[i] / totalArea;
+  }
+  
+  return table;
+}
+
+
+void
+SphereSamplingTableCache::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfTables: " << this->GetNumberOfTables() << std::endl;
+}
+
+} // end namespace ivan
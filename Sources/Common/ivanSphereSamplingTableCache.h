@@ -0,0 +1,191 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSphereSamplingTableCache.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide cache of immutable unit sphere sampling tables
+// Date: 2012/11/05
+
+#ifndef __ivanSphereSamplingTableCache_h
+#define __ivanSphereSamplingTableCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <map>
+#include <vector>
+
+namespace ivan
+{
+
+/**
+ * \class SphereSamplingTable
+ * \brief Immutable sampling of the unit sphere by the vertices of a decimated icosahedron.
+ *
+ * The table holds the unit normals at the vertices of the mesh of RegularSphereMeshSource2 
+ * with the given decimation, in a flat table with one contiguous block per dimension, so the
+ * element for point p in dimension d is at position d * N + p, where N is the number of 
+ * points. It also holds the areas of the spherical Voronoi cells of the points, normalized to 
+ * a mean of one, and a table of uniform weights.
+ *
+ * Tables are created by SphereSamplingTableCache and never modified afterwards, so they can be
+ * shared by any number of objects and threads.
+ *
+ * \sa SphereGridBasedImageFunction
+ */
+class ITK_EXPORT SphereSamplingTable : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef SphereSamplingTable             Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef std::vector<double>             TableType;
+  
+  /** Method for creation through the object factory. An empty table has no points. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SphereSamplingTable, Object );
+  
+  unsigned int GetDecimation() const
+    { return m_Decimation; }
+  unsigned int GetNumberOfPoints() const
+    { return m_NumberOfPoints; }
+  
+  /** Unit normals at the points, with one block per dimension. */
+  const TableType & GetNormalTable() const
+    { return m_NormalTable; }
+  
+  /** Normalized areas of the Voronoi cells of the points. */
+  const TableType & GetWeightTable() const
+    { return m_WeightTable; }
+    
+  /** Weights that are all one. */
+  const TableType & GetUniformWeightTable() const
+    { return m_UniformWeightTable; }
+  
+protected:
+
+  SphereSamplingTable() : m_Decimation(0), m_NumberOfPoints(0) {}
+  ~SphereSamplingTable() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  SphereSamplingTable( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+  
+  friend class SphereSamplingTableCache;
+
+private:
+
+  unsigned int    m_Decimation;
+  unsigned int    m_NumberOfPoints;
+  
+  TableType       m_NormalTable;
+  TableType       m_WeightTable;
+  TableType       m_UniformWeightTable;
+};
+
+
+/**
+ * \class SphereSamplingTableCache
+ * \brief Process-wide cache of the sphere sampling tables by decimation.
+ *
+ * Sphere-based image functions are created per scale, per thread and per estimator, and each 
+ * of them needs the same few samplings of the unit sphere. GetTable() builds the sphere mesh
+ * for a decimation only the first time it is requested, and returns the same immutable table
+ * afterwards, so initializing a function is a lookup and the tables are not stored per 
+ * function.
+ *
+ * There is a single instance per process, obtained with GetInstance(). All methods can be 
+ * called concurrently from several threads. A table being built blocks the other requests 
+ * until it is ready, so it is never built twice.
+ *
+ * \sa SphereSamplingTable, GaussianKernelCache
+ */
+class ITK_EXPORT SphereSamplingTableCache : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef SphereSamplingTableCache        Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SphereSamplingTableCache, Object );
+  
+  typedef std::map<unsigned int,SphereSamplingTable::ConstPointer>   TableContainerType;
+  
+public:
+  
+  /** Get the instance of the cache for this process. */
+  static Pointer GetInstance();
+  
+  /** Get the table of the given decimation, building it if it is not in the cache. */
+  SphereSamplingTable::ConstPointer GetTable( unsigned int decimation );
+  
+  /** Remove all the tables. Tables still referenced elsewhere stay valid. */
+  void Clear();
+  
+  /** Get the number of tables stored. */
+  unsigned long GetNumberOfTables() const;
+  
+  /** Build a new table of the given decimation without storing it. */
+  static SphereSamplingTable::Pointer BuildTable( unsigned int decimation );
+  
+protected:
+
+  SphereSamplingTableCache() {}
+  ~SphereSamplingTableCache() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  SphereSamplingTableCache( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  TableContainerType    m_Tables;
+  
+  /** Mutex for accessing the container from several threads. */
+  mutable itk::SimpleFastMutexLock    m_Mutex;
+  
+  static Pointer                      m_Instance;
+  static itk::SimpleFastMutexLock     m_InstanceMutex;
+};
+
+} // end namespace ivan
+
+#endif
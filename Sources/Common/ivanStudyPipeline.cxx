@@ -0,0 +1,450 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanStudyPipeline.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: driver of a queue of studies through processing stages on a shared pool of threads
+// Date: 2012/11/05
+
+#include "ivanStudyPipeline.h"
+
+#include "itkExceptionObject.h"
+#include "vnl/vnl_math.h"
+
+#include <exception>
+
+namespace ivan
+{
+
+StudyPipeline::Study::Study() :
+  m_MemoryEstimate( 0 ),
+  m_SubmissionNumber( 0 ),
+  m_NumberOfCompletedStages( 0 ),
+  m_Failed( false ),
+  m_SubmitTime( 0.0 ),
+  m_AdmitTime( 0.0 ),
+  m_FinishTime( 0.0 )
+{
+}
+
+
+void
+StudyPipeline::Study::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Name: " << m_Name << std::endl;
+  os << indent << "MemoryEstimate: " << m_MemoryEstimate << std::endl;
+  os << indent << "NumberOfCompletedStages: " << m_NumberOfCompletedStages << std::endl;
+  os << indent << "Failed: " << m_Failed << std::endl;
+  os << indent << "ErrorDescription: " << m_ErrorDescription << std::endl;
+}
+
+
+StudyPipeline::Stage::Stage() :
+  m_MaximumConcurrency( 0 ),
+  m_NumberOfThreads( 1 )
+{
+}
+
+
+void
+StudyPipeline::Stage::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Name: " << m_Name << std::endl;
+  os << indent << "MaximumConcurrency: " << m_MaximumConcurrency << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+}
+
+
+StudyPipeline::StudyPipeline() :
+  m_MemoryBudget( 0 ),
+  m_MaximumNumberOfQueuedStudies( 4 ),
+  m_Stopping( false ),
+  m_NumberOfBusyThreads( 0 ),
+  m_PeakNumberOfBusyThreads( 0 ),
+  m_NumberOfStudiesInFlight( 0 ),
+  m_NumberOfSubmittedStudies( 0 ),
+  m_NumberOfFinishedStudies( 0 ),
+  m_NumberOfFailedStudies( 0 ),
+  m_ReservedMemory( 0 ),
+  m_PeakReservedMemory( 0 )
+{
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  
+  m_Clock = itk::RealTimeClock::New();
+  m_Threader = itk::MultiThreader::New();
+  m_Condition = itk::ConditionVariable::New();
+}
+
+
+StudyPipeline::~StudyPipeline()
+{
+  this->Stop();
+}
+
+
+void
+StudyPipeline::AddStage( Stage *stage )
+{
+  m_Mutex.Lock();
+  m_Stages.push_back( stage );
+  m_NumberOfRunningStudies.push_back( 0 );
+  m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+void
+StudyPipeline::Submit( Study *study )
+{
+  m_Mutex.Lock();
+  
+  // Start the pool with the first study
+  if( m_ThreadIds.empty() )
+  {
+    for( unsigned int i=0; i<m_NumberOfThreads; ++i )
+      m_ThreadIds.push_back( m_Threader->SpawnThread( this->WorkerThreaderCallback, this ) );
+  }
+  
+  // Back-pressure
+  while( m_MaximumNumberOfQueuedStudies > 0 &&
+         m_QueuedStudies.size() >= m_MaximumNumberOfQueuedStudies )
+    m_Condition->Wait( &m_Mutex );
+  
+  study->m_SubmissionNumber = m_NumberOfSubmittedStudies++;
+  study->m_NumberOfCompletedStages = 0;
+  study->m_Failed = false;
+  study->m_ErrorDescription.clear();
+  study->m_SubmitTime = m_Clock->GetTimeStamp();
+  
+  m_QueuedStudies.push_back( study );
+  ++m_NumberOfStudiesInFlight;
+  
+  this->AdmitStudies();
+  
+  m_Condition->Broadcast();
+  m_Mutex.Unlock();
+}
+
+
+void
+StudyPipeline::Wait()
+{
+  m_Mutex.Lock();
+  
+  while( m_NumberOfStudiesInFlight > 0 )
+    m_Condition->Wait( &m_Mutex );
+  
+  m_Mutex.Unlock();
+}
+
+
+void
+StudyPipeline::Stop()
+{
+  this->Wait();
+  
+  m_Mutex.Lock();
+  m_Stopping = true;
+  m_Condition->Broadcast();
+  m_Mutex.Unlock();
+  
+  // This joins the threads
+  for( unsigned int i=0; i<m_ThreadIds.size(); ++i )
+    m_Threader->TerminateThread( m_ThreadIds[i] );
+  
+  m_Mutex.Lock();
+  m_ThreadIds.clear();
+  m_Stopping = false;
+  m_Mutex.Unlock();
+}
+
+
+void
+StudyPipeline::AdmitStudies()
+{
+  // In order, so that a large study is not starved by smaller ones behind it
+  while( !m_QueuedStudies.empty() )
+  {
+    Study *study = m_QueuedStudies.front();
+  
+    if( m_MemoryBudget > 0 && m_ReservedMemory > 0 &&
+        study->m_MemoryEstimate > m_MemoryBudget - vnl_math_min( m_ReservedMemory, m_MemoryBudget ) )
+      break;
+  
+    m_ReservedMemory += study->m_MemoryEstimate;
+    m_PeakReservedMemory = vnl_math_max( m_PeakReservedMemory, m_ReservedMemory );
+    study->m_AdmitTime = m_Clock->GetTimeStamp();
+  
+    if( m_Stages.empty() )
+      this->FinishStudy( study );
+    else
+      m_ReadyStudies.push_back( study );
+  
+    m_QueuedStudies.pop_front();
+  }
+}
+
+
+unsigned int
+StudyPipeline::GetNumberOfStageThreads( unsigned int stageIndex ) const
+{
+  return vnl_math_min( m_Stages[stageIndex]->GetNumberOfThreads(), m_NumberOfThreads );
+}
+
+
+bool
+StudyPipeline::SelectTask( Study::Pointer & study, unsigned int & stageIndex )
+{
+  int selected = -1;
+  
+  for( unsigned int i=0; i<m_ReadyStudies.size(); ++i )
+  {
+    const Study *candidate = m_ReadyStudies[i];
+    const unsigned int candidateStage = candidate->m_NumberOfCompletedStages;
+    const unsigned int maximumConcurrency = m_Stages[candidateStage]->GetMaximumConcurrency();
+  
+    if( maximumConcurrency > 0 && m_NumberOfRunningStudies[candidateStage] >= maximumConcurrency )
+      continue;
+  
+    if( m_NumberOfBusyThreads + this->GetNumberOfStageThreads( candidateStage ) > m_NumberOfThreads )
+      continue;
+  
+    if( selected < 0 )
+    {
+      selected = i;
+      continue;
+    }
+  
+    const Study *best = m_ReadyStudies[selected];
+  
+    if( candidateStage > best->m_NumberOfCompletedStages ||
+        ( candidateStage == best->m_NumberOfCompletedStages &&
+          candidate->m_SubmissionNumber < best->m_SubmissionNumber ) )
+      selected = i;
+  }
+  
+  if( selected < 0 )
+    return false;
+  
+  study = m_ReadyStudies[selected];
+  stageIndex = study->m_NumberOfCompletedStages;
+  m_ReadyStudies.erase( m_ReadyStudies.begin() + selected );
+  
+  return true;
+}
+
+
+void
+StudyPipeline::FinishStudy( Study *study )
+{
+  study->m_FinishTime = m_Clock->GetTimeStamp();
+  
+  m_ReservedMemory -= vnl_math_min( study->m_MemoryEstimate, m_ReservedMemory );
+  
+  ++m_NumberOfFinishedStudies;
+  
+  if( study->m_Failed )
+    ++m_NumberOfFailedStudies;
+  
+  --m_NumberOfStudiesInFlight;
+}
+
+
+void
+StudyPipeline::ProcessTasks()
+{
+  m_Mutex.Lock();
+  
+  while( true )
+  {
+    Study::Pointer study;
+    unsigned int stageIndex = 0;
+  
+    while( !m_Stopping && !this->SelectTask( study, stageIndex ) )
+      m_Condition->Wait( &m_Mutex );
+  
+    if( m_Stopping )
+      break;
+  
+    Stage *stage = m_Stages[stageIndex];
+    const unsigned int numberOfStageThreads = this->GetNumberOfStageThreads( stageIndex );
+  
+    ++m_NumberOfRunningStudies[stageIndex];
+    m_NumberOfBusyThreads += numberOfStageThreads;
+    m_PeakNumberOfBusyThreads = vnl_math_max( m_PeakNumberOfBusyThreads, m_NumberOfBusyThreads );
+  
+    m_Mutex.Unlock();
+  
+    bool failed = false;
+    std::string errorDescription;
+  
+    try
+    {
+      stage->Process( study );
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      failed = true;
+      errorDescription = excpt.GetDescription();
+    }
+    catch( std::exception & excpt )
+    {
+      failed = true;
+      errorDescription = excpt.what();
+    }
+    catch( ... )
+    {
+      failed = true;
+      errorDescription = "Unknown exception";
+    }
+  
+    m_Mutex.Lock();
+  
+    --m_NumberOfRunningStudies[stageIndex];
+    m_NumberOfBusyThreads -= numberOfStageThreads;
+  
+    if( failed )
+    {
+      study->m_Failed = true;
+      study->m_ErrorDescription = std::string( stage->GetName() ) + ": " + errorDescription;
+    }
+    else
+    {
+      ++study->m_NumberOfCompletedStages;
+    }
+  
+    if( failed || study->m_NumberOfCompletedStages == m_Stages.size() )
+      this->FinishStudy( study );
+    else
+      m_ReadyStudies.push_back( study );
+  
+    // The memory released may admit more studies, and the threads released run more stages
+    this->AdmitStudies();
+  
+    m_Condition->Broadcast();
+  }
+  
+  m_Mutex.Unlock();
+}
+
+
+ITK_THREAD_RETURN_TYPE
+StudyPipeline::WorkerThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  
+  static_cast<Self *>( threadInfo->UserData )->ProcessTasks();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+unsigned long
+StudyPipeline::GetNumberOfSubmittedStudies() const
+{
+  m_Mutex.Lock();
+  const unsigned long value = m_NumberOfSubmittedStudies;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+unsigned long
+StudyPipeline::GetNumberOfFinishedStudies() const
+{
+  m_Mutex.Lock();
+  const unsigned long value = m_NumberOfFinishedStudies;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+unsigned long
+StudyPipeline::GetNumberOfFailedStudies() const
+{
+  m_Mutex.Lock();
+  const unsigned long value = m_NumberOfFailedStudies;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+unsigned long
+StudyPipeline::GetReservedMemory() const
+{
+  m_Mutex.Lock();
+  const unsigned long value = m_ReservedMemory;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+unsigned long
+StudyPipeline::GetPeakReservedMemory() const
+{
+  m_Mutex.Lock();
+  const unsigned long value = m_PeakReservedMemory;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+unsigned int
+StudyPipeline::GetPeakNumberOfBusyThreads() const
+{
+  m_Mutex.Lock();
+  const unsigned int value = m_PeakNumberOfBusyThreads;
+  m_Mutex.Unlock();
+  
+  return value;
+}
+
+
+void
+StudyPipeline::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfStages: " << m_Stages.size() << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "MemoryBudget: " << m_MemoryBudget << std::endl;
+  os << indent << "MaximumNumberOfQueuedStudies: " << m_MaximumNumberOfQueuedStudies << std::endl;
+  os << indent << "NumberOfSubmittedStudies: " << m_NumberOfSubmittedStudies << std::endl;
+  os << indent << "NumberOfFinishedStudies: " << m_NumberOfFinishedStudies << std::endl;
+  os << indent << "NumberOfFailedStudies: " << m_NumberOfFailedStudies << std::endl;
+  os << indent << "PeakReservedMemory: " << m_PeakReservedMemory << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,317 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanStudyPipeline.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: driver of a queue of studies through processing stages on a shared pool of threads
+// Date: 2012/11/05
+
+#ifndef __ivanStudyPipeline_h
+#define __ivanStudyPipeline_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+#include "itkRealTimeClock.h"
+#include "itkNumericTraits.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+/**
+ * \class StudyPipeline
+ * \brief Runs a queue of studies through a sequence of stages, several studies at once, on a
+ * bounded pool of threads shared by all the stages.
+ *
+ * A production node processes many studies with the same stages, e.g. read, detect, track,
+ * quantify and export. Running them one after the other leaves the processors idle in the
+ * serial stages, while running a pipeline per study oversubscribes them, since each filter
+ * spawns its own threads on each Update(). The pipeline instead keeps NumberOfThreads threads
+ * and gives them to the stages of the studies in flight:
+ *
+ * - Each stage declares the NumberOfThreads its filters use for a study, which it passes to
+ * them with SetNumberOfThreads(). A stage runs only when that many threads of the pool are
+ * free, so the filters together never use more than the pool.
+ * - Each stage may limit the studies it processes at once with MaximumConcurrency, e.g. 1 for
+ * the reading stage to avoid disk contention, or for a stage that is not reentrant.
+ * - A submitted study is admitted only if its MemoryEstimate fits in the MemoryBudget left
+ * by the studies in flight, and it keeps its share until it leaves the pipeline. A study is
+ * always admitted when none is in flight, so a study larger than the budget runs alone.
+ * - Studies waiting for admission are kept in order, and Submit() blocks while there are
+ * MaximumNumberOfQueuedStudies of them, which gives back-pressure to the producer.
+ * - Free threads are given first to the studies in the later stages, so that the studies in
+ * flight finish and release their memory before the earlier stages take new ones.
+ *
+ * The filters are used unchanged: a stage is a subclass of Stage whose Process() runs them on
+ * the study, and a study is a subclass of Study holding its data. An exception thrown by a stage
+ * marks the study as failed and it skips the remaining stages.
+ *
+ * \sa VesselAnalysisSession
+ */
+class ITK_EXPORT StudyPipeline : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef StudyPipeline                   Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( StudyPipeline, itk::Object );
+  
+  /** A study going through the pipeline. Subclasses hold its input and the data the stages
+    * pass on to each other. */
+  class Study : public itk::Object
+  {
+  public:
+  
+    typedef Study                           Self;
+    typedef itk::Object                     Superclass;
+    typedef itk::SmartPointer<Self>         Pointer;
+    typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+    itkNewMacro( Self );
+    itkTypeMacro( Study, itk::Object );
+  
+    itkSetStringMacro( Name );
+    itkGetStringMacro( Name );
+  
+    /** Set/Get the memory in bytes the study takes while it is in the pipeline, for the
+      * admission control. */
+    itkSetMacro( MemoryEstimate, unsigned long );
+    itkGetConstMacro( MemoryEstimate, unsigned long );
+  
+    /** Whether a stage failed on the study, and the description of its exception. */
+    bool GetFailed() const
+      { return m_Failed; }
+    const std::string & GetErrorDescription() const
+      { return m_ErrorDescription; }
+  
+    /** Number of stages done on the study. */
+    unsigned int GetNumberOfCompletedStages() const
+      { return m_NumberOfCompletedStages; }
+  
+    /** Time in seconds from the submission of the study until it left the pipeline, and
+      * until it was admitted. */
+    double GetLatency() const
+      { return m_FinishTime - m_SubmitTime; }
+    double GetQueueTime() const
+      { return m_AdmitTime - m_SubmitTime; }
+  
+  protected:
+  
+    Study();
+    virtual ~Study() {}
+  
+    void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  private:
+  
+    Study( const Self& ); // purposely not implemented
+    void operator=( const Self& ); // purposely not implemented
+  
+    friend class StudyPipeline;
+  
+    std::string     m_Name;
+    unsigned long   m_MemoryEstimate;
+  
+    unsigned long   m_SubmissionNumber;
+    unsigned int    m_NumberOfCompletedStages;
+    bool            m_Failed;
+    std::string     m_ErrorDescription;
+  
+    double          m_SubmitTime;
+    double          m_AdmitTime;
+    double          m_FinishTime;
+  };
+  
+  /** A processing stage. Subclasses run the filters of the stage on a study in Process(). */
+  class Stage : public itk::Object
+  {
+  public:
+  
+    typedef Stage                           Self;
+    typedef itk::Object                     Superclass;
+    typedef itk::SmartPointer<Self>         Pointer;
+    typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+    itkTypeMacro( Stage, itk::Object );
+  
+    itkSetStringMacro( Name );
+    itkGetStringMacro( Name );
+  
+    /** Set/Get the maximum number of studies processed by the stage at once. Zero, the
+      * default, means no limit other than the threads of the pool. */
+    itkSetMacro( MaximumConcurrency, unsigned int );
+    itkGetConstMacro( MaximumConcurrency, unsigned int );
+  
+    /** Set/Get the number of threads the stage uses for a study, given to its filters. One by
+      * default. It is clamped to the threads of the pool. */
+    itkSetClampMacro( NumberOfThreads, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+    itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+    /** Process a study. Called from the threads of the pipeline, concurrently for different
+      * studies unless MaximumConcurrency is 1. Throw an exception to mark the study as failed. */
+    virtual void Process( Study *study ) = 0;
+  
+  protected:
+  
+    Stage();
+    virtual ~Stage() {}
+  
+    void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  private:
+  
+    Stage( const Self& ); // purposely not implemented
+    void operator=( const Self& ); // purposely not implemented
+  
+    std::string     m_Name;
+    unsigned int    m_MaximumConcurrency;
+    unsigned int    m_NumberOfThreads;
+  };
+
+public:
+
+  /** Append a stage. Stages must be added before the first study is submitted. */
+  void AddStage( Stage *stage );
+  
+  unsigned int GetNumberOfStages() const
+    { return static_cast<unsigned int>( m_Stages.size() ); }
+  
+  Stage * GetStage( unsigned int i ) const
+    { return m_Stages[i]; }
+  
+  /** Set/Get the number of threads of the pool. By default, the global default number of
+    * threads of ITK. Set it before the first study is submitted. */
+  itkSetClampMacro( NumberOfThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+  /** Set/Get the memory in bytes of the studies in flight. Zero, the default, means no limit. */
+  itkSetMacro( MemoryBudget, unsigned long );
+  itkGetConstMacro( MemoryBudget, unsigned long );
+  
+  /** Set/Get the number of submitted studies waiting for admission before Submit() blocks.
+    * Zero means no limit. Four by default. */
+  itkSetMacro( MaximumNumberOfQueuedStudies, unsigned int );
+  itkGetConstMacro( MaximumNumberOfQueuedStudies, unsigned int );
+  
+  /** Add a study at the end of the queue, starting the threads of the pool if needed. Blocks
+    * while the queue is full. */
+  void Submit( Study *study );
+  
+  /** Block until all the submitted studies have left the pipeline. */
+  void Wait();
+  
+  /** Wait for the submitted studies and stop the threads of the pool. Called on destruction. */
+  void Stop();
+  
+  /** Statistics since the pipeline was created. */
+  unsigned long GetNumberOfSubmittedStudies() const;
+  unsigned long GetNumberOfFinishedStudies() const;
+  unsigned long GetNumberOfFailedStudies() const;
+  
+  /** Memory estimate of the studies in flight, and its maximum. */
+  unsigned long GetReservedMemory() const;
+  unsigned long GetPeakReservedMemory() const;
+  
+  /** Maximum number of threads the stages used at once. At most NumberOfThreads. */
+  unsigned int GetPeakNumberOfBusyThreads() const;
+
+protected:
+
+  StudyPipeline();
+  virtual ~StudyPipeline();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Admit the queued studies that fit in the memory budget. The mutex must be locked. */
+  void AdmitStudies();
+  
+  /** Take the ready study of the latest stage that can run on the free threads, the oldest
+    * among equals. Returns false if none can run. The mutex must be locked. */
+  bool SelectTask( Study::Pointer & study, unsigned int & stageIndex );
+  
+  /** Remove a study from the pipeline. The mutex must be locked. */
+  void FinishStudy( Study *study );
+  
+  /** Loop of the threads of the pool. */
+  void ProcessTasks();
+  
+  static ITK_THREAD_RETURN_TYPE WorkerThreaderCallback( void *arg );
+
+private:
+
+  StudyPipeline( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+  
+  /** Threads a stage takes from the pool. */
+  unsigned int GetNumberOfStageThreads( unsigned int stageIndex ) const;
+
+private:
+
+  std::vector<Stage::Pointer>       m_Stages;
+  
+  unsigned int      m_NumberOfThreads;
+  unsigned long     m_MemoryBudget;
+  unsigned int      m_MaximumNumberOfQueuedStudies;
+  
+  itk::RealTimeClock::Pointer       m_Clock;
+  itk::MultiThreader::Pointer       m_Threader;
+  std::vector<int>                  m_ThreadIds;
+  bool                              m_Stopping;
+  
+  /** Studies waiting for admission, and studies admitted waiting for their next stage. */
+  std::deque<Study::Pointer>        m_QueuedStudies;
+  std::vector<Study::Pointer>       m_ReadyStudies;
+  
+  std::vector<unsigned int>         m_NumberOfRunningStudies;
+  unsigned int                      m_NumberOfBusyThreads;
+  unsigned int                      m_PeakNumberOfBusyThreads;
+  unsigned long                     m_NumberOfStudiesInFlight;
+  
+  unsigned long                     m_NumberOfSubmittedStudies;
+  unsigned long                     m_NumberOfFinishedStudies;
+  unsigned long                     m_NumberOfFailedStudies;
+  unsigned long                     m_ReservedMemory;
+  unsigned long                     m_PeakReservedMemory;
+  
+  mutable itk::SimpleMutexLock      m_Mutex;
+  itk::ConditionVariable::Pointer   m_Condition;
+};
+
+} // end namespace ivan
+
+#endif
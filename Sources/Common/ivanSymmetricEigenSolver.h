@@ -0,0 +1,156 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSymmetricEigenSolver.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: eigen-analysis of symmetric second rank tensors, closed-form in 3D
+// Date: 2012/11/05
+
+#ifndef __ivanSymmetricEigenSolver_h
+#define __ivanSymmetricEigenSolver_h
+
+#include "itkSymmetricSecondRankTensor.h"
+
+namespace ivan
+{
+/**
+ * \class SymmetricEigenSolver
+ * \brief Computes eigenvalues and eigenvectors of symmetric second rank tensors.
+ *
+ * The results follow the conventions of itk::SymmetricSecondRankTensor::ComputeEigenAnalysis(): 
+ * eigenvalues are sorted in ascending order and the rows of the eigenvector matrix are the 
+ * (unit) eigenvectors, in the same order as the eigenvalues. Eigenvector signs are arbitrary.
+ *
+ * The generic version simply calls the iterative solver of the tensor. The specialization for 
+ * 3D tensors uses a non-iterative closed-form solution: eigenvalues are the roots of the 
+ * characteristic polynomial (trigonometric Cardano form) and eigenvectors are obtained from 
+ * cross products of the rows of (A - lambda I), the most separated eigenvalue first, and 
+ * then in its orthogonal complement, which is robust for repeated eigenvalues. 
+ * See D. Eberly, "A Robust Eigensolver for 3x3 Symmetric Matrices", Geometric Tools, 2014.
+ *
+ * Computations are done in double precision regardless of the tensor component type.
+ *
+ * All methods are static, so the solver can be used concurrently without any local copy.
+ *
+ * \sa itk::SymmetricEigenAnalysis
+ */
+template <class TTensor, unsigned int VDimension = TTensor::Dimension>
+class SymmetricEigenSolver
+{
+public:
+
+  typedef TTensor                                       TensorType;
+  typedef typename TensorType::EigenValuesArrayType     EigenValuesArrayType;
+  typedef typename TensorType::EigenVectorsMatrixType   EigenVectorsMatrixType;
+  
+  itkStaticConstMacro( Dimension, unsigned int, VDimension );
+  
+  /** Compute the eigenvalues only, in ascending order. */
+  static void ComputeEigenValues( const TensorType & tensor, EigenValuesArrayType & eigenValues );
+  
+  /** Compute eigenvalues, in ascending order, and the corresponding eigenvectors (rows). */
+  static void ComputeEigenAnalysis( const TensorType & tensor, EigenValuesArrayType & eigenValues, 
+    EigenVectorsMatrixType & eigenVectors );
+  
+  /** Compute the eigenvalues of several contiguous tensors. */
+  static void ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues );
+  
+  /** Compute the eigen-analysis of several contiguous tensors. */
+  static void ComputeEigenAnalysis( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues, EigenVectorsMatrixType * eigenVectors );
+  
+  /** Reorder eigenvalues in ascending order of magnitude, as required by some measures 
+   * (Frangi, objectness). */
+  static void OrderEigenValuesByMagnitude( EigenValuesArrayType & eigenValues );
+};
+
+
+/** Closed-form specialization for 3D tensors. */
+template <class TTensor>
+class SymmetricEigenSolver<TTensor,3>
+{
+public:
+
+  typedef TTensor                                       TensorType;
+  typedef typename TensorType::EigenValuesArrayType     EigenValuesArrayType;
+  typedef typename TensorType::EigenVectorsMatrixType   EigenVectorsMatrixType;
+  
+  itkStaticConstMacro( Dimension, unsigned int, 3 );
+  
+  /** Compute the eigenvalues only, in ascending order. */
+  static void ComputeEigenValues( const TensorType & tensor, EigenValuesArrayType & eigenValues );
+  
+  /** Compute eigenvalues, in ascending order, and the corresponding eigenvectors (rows). */
+  static void ComputeEigenAnalysis( const TensorType & tensor, EigenValuesArrayType & eigenValues, 
+    EigenVectorsMatrixType & eigenVectors );
+  
+  /** Compute the eigenvalues of several contiguous tensors. */
+  static void ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues );
+  
+  /** Compute the eigen-analysis of several contiguous tensors. */
+  static void ComputeEigenAnalysis( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues, EigenVectorsMatrixType * eigenVectors );
+  
+  /** Reorder eigenvalues in ascending order of magnitude, as required by some measures 
+   * (Frangi, objectness). */
+  static void OrderEigenValuesByMagnitude( EigenValuesArrayType & eigenValues );
+  
+private:
+
+  /** Upper triangle of the tensor, scaled, and the scaling factor. Returns false for a zero tensor. */
+  static bool GetScaledComponents( const TensorType & tensor, double a[6], double & scale );
+  
+  /** Eigenvalues of the scaled tensor in ascending order. Returns the half determinant of the 
+   * normalized deviatoric tensor, which tells which eigenvalue is the most separated. */
+  static double ComputeScaledEigenValues( const double a[6], double eval[3] );
+  
+  /** Eigenvector for an eigenvalue of multiplicity 1. */
+  static void ComputeEigenVector0( const double a[6], double eval, double evec[3] );
+  
+  /** Eigenvector for the eigenvalue eval, orthogonal to the unit vector evec0. */
+  static void ComputeEigenVector1( const double a[6], const double evec0[3], double eval, 
+    double evec1[3] );
+  
+  static void ComputeOrthogonalComplement( const double w[3], double u[3], double v[3] );
+  
+  static void Cross( const double u[3], const double v[3], double w[3] )
+  {
+    w[0] = u[1] * v[2] - u[2] * v[1];
+    w[1] = u[2] * v[0] - u[0] * v[2];
+    w[2] = u[0] * v[1] - u[1] * v[0];
+  }
+  
+  static double Dot( const double u[3], const double v[3] )
+    { return u[0] * v[0] + u[1] * v[1] + u[2] * v[2]; }
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanSymmetricEigenSolver.hxx"
+#endif
+
+#endif
@@ -0,0 +1,432 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSymmetricEigenSolver.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: eigen-analysis of symmetric second rank tensors, closed-form in 3D
+// Date: 2012/11/05
+
+#ifndef __ivanSymmetricEigenSolver_hxx
+#define __ivanSymmetricEigenSolver_hxx
+
+#include "ivanSymmetricEigenSolver.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ivan
+{
+
+template <class TTensor, unsigned int VDimension>
+void
+SymmetricEigenSolver<TTensor,VDimension>
+::ComputeEigenValues( const TensorType & tensor, EigenValuesArrayType & eigenValues )
+{
+  tensor.ComputeEigenValues( eigenValues );
+}
+
+
+template <class TTensor, unsigned int VDimension>
+void
+SymmetricEigenSolver<TTensor,VDimension>
+::ComputeEigenAnalysis( const TensorType & tensor, EigenValuesArrayType & eigenValues, 
+  EigenVectorsMatrixType & eigenVectors )
+{
+  tensor.ComputeEigenAnalysis( eigenValues, eigenVectors );
+}
+
+
+template <class TTensor, unsigned int VDimension>
+void
+SymmetricEigenSolver<TTensor,VDimension>
+::ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+  EigenValuesArrayType * eigenValues )
+{
+  for( unsigned long i=0; i<numberOfTensors; ++i )
+    tensors[i].ComputeEigenValues( eigenValues[i] );
+}
+
+
+template <class TTensor, unsigned int VDimension>
+void
+SymmetricEigenSolver<TTensor,VDimension>
+::ComputeEigenAnalysis( const TensorType * tensors, unsigned long numberOfTensors,
+  EigenValuesArrayType * eigenValues, EigenVectorsMatrixType * eigenVectors )
+{
+  for( unsigned long i=0; i<numberOfTensors; ++i )
+    tensors[i].ComputeEigenAnalysis( eigenValues[i], eigenVectors[i] );
+}
+
+
+template <class TTensor, unsigned int VDimension>
+void
+SymmetricEigenSolver<TTensor,VDimension>
+::OrderEigenValuesByMagnitude( EigenValuesArrayType & eigenValues )
+{
+  // Insertion sort, stable for values of equal magnitude
+  for( unsigned int i=1; i<VDimension; ++i )
+  {
+    const typename EigenValuesArrayType::ValueType value = eigenValues[i];
+    unsigned int j = i;
+    
+    for( ; j > 0 && vnl_math_abs( eigenValues[j-1] ) > vnl_math_abs( value ); --j )
+      eigenValues[j] = eigenValues[j-1];
+    
+    eigenValues[j] = value;
+  }
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenValues( const TensorType & tensor, EigenValuesArrayType & eigenValues )
+{
+  double a[6], eval[3], scale;
+  
+  if( !GetScaledComponents( tensor, a, scale ) )
+  {
+    eigenValues.Fill( 0.0 );
+    return;
+  }
+  
+  ComputeScaledEigenValues( a, eval );
+  
+  for( unsigned int i=0; i<3; ++i )
+    eigenValues[i] = eval[i] * scale;
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenAnalysis( const TensorType & tensor, EigenValuesArrayType & eigenValues, 
+  EigenVectorsMatrixType & eigenVectors )
+{
+  double a[6], eval[3], evec[3][3], scale;
+  
+  eigenVectors.SetIdentity();
+  
+  if( !GetScaledComponents( tensor, a, scale ) )
+  {
+    eigenValues.Fill( 0.0 );
+    return;
+  }
+  
+  const double halfDet = ComputeScaledEigenValues( a, eval );
+  
+  if( eval[0] == eval[2] )
+  {
+    // Multiple of the identity, any orthonormal basis is valid
+    for( unsigned int i=0; i<3; ++i )
+      eigenValues[i] = eval[i] * scale;
+    return;
+  }
+  
+  // Start with the most separated eigenvalue, which has multiplicity 1
+  if( halfDet >= 0.0 )
+  {
+    ComputeEigenVector0( a, eval[2], evec[2] );
+    ComputeEigenVector1( a, evec[2], eval[1], evec[1] );
+    Cross( evec[1], evec[2], evec[0] );
+  }
+  else
+  {
+    ComputeEigenVector0( a, eval[0], evec[0] );
+    ComputeEigenVector1( a, evec[0], eval[1], evec[1] );
+    Cross( evec[0], evec[1], evec[2] );
+  }
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    eigenValues[i] = eval[i] * scale;
+    
+    for( unsigned int j=0; j<3; ++j )
+      eigenVectors( i, j ) = evec[i][j];
+  }
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+  EigenValuesArrayType * eigenValues )
+{
+  for( unsigned long i=0; i<numberOfTensors; ++i )
+    ComputeEigenValues( tensors[i], eigenValues[i] );
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenAnalysis( const TensorType * tensors, unsigned long numberOfTensors,
+  EigenValuesArrayType * eigenValues, EigenVectorsMatrixType * eigenVectors )
+{
+  for( unsigned long i=0; i<numberOfTensors; ++i )
+    ComputeEigenAnalysis( tensors[i], eigenValues[i], eigenVectors[i] );
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::OrderEigenValuesByMagnitude( EigenValuesArrayType & eigenValues )
+{
+  // Sorting network for three values, stable for values of equal magnitude
+  if( vnl_math_abs( eigenValues[0] ) > vnl_math_abs( eigenValues[1] ) )
+    std::swap( eigenValues[0], eigenValues[1] );
+  
+  if( vnl_math_abs( eigenValues[1] ) > vnl_math_abs( eigenValues[2] ) )
+    std::swap( eigenValues[1], eigenValues[2] );
+  
+  if( vnl_math_abs( eigenValues[0] ) > vnl_math_abs( eigenValues[1] ) )
+    std::swap( eigenValues[0], eigenValues[1] );
+}
+
+
+template <class TTensor>
+bool
+SymmetricEigenSolver<TTensor,3>
+::GetScaledComponents( const TensorType & tensor, double a[6], double & scale )
+{
+  // Scale by the maximum absolute component to avoid overflow and underflow
+  scale = 0.0;
+  
+  for( unsigned int i=0; i<6; ++i )
+  {
+    a[i] = static_cast<double>( tensor[i] );
+    scale = std::max( scale, std::fabs( a[i] ) );
+  }
+  
+  if( scale == 0.0 )
+    return false;
+  
+  const double invScale = 1.0 / scale;
+  
+  for( unsigned int i=0; i<6; ++i )
+    a[i] *= invScale;
+    
+  return true;
+}
+
+
+template <class TTensor>
+double
+SymmetricEigenSolver<TTensor,3>
+::ComputeScaledEigenValues( const double a[6], double eval[3] )
+{
+  // Components are stored as [ a00 a01 a02 a11 a12 a22 ]
+  const double offDiagonal = a[1] * a[1] + a[2] * a[2] + a[4] * a[4];
+  
+  // B = ( A - q I ) / p, where q is the mean eigenvalue and p the deviation
+  const double q = ( a[0] + a[3] + a[5] ) / 3.0;
+  const double b00 = a[0] - q;
+  const double b11 = a[3] - q;
+  const double b22 = a[5] - q;
+  const double p = std::sqrt( ( b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * offDiagonal ) / 6.0 );
+  
+  if( p == 0.0 )
+  {
+    // Multiple of the identity
+    eval[0] = eval[1] = eval[2] = q;
+    return 0.0;
+  }
+  
+  const double det = b00 * ( b11 * b22 - a[4] * a[4] ) - a[1] * ( a[1] * b22 - a[4] * a[2] ) 
+    + a[2] * ( a[1] * a[4] - b11 * a[2] );
+  
+  double halfDet = 0.5 * det / ( p * p * p );
+  halfDet = std::min( std::max( halfDet, -1.0 ), 1.0 );
+  
+  // The eigenvalues of B are 2 cos( phi + 2 k pi / 3 ), with phi in [0,pi/3]
+  const double phi = std::acos( halfDet ) / 3.0;
+  const double twoThirdsPi = 2.0 * vnl_math::pi / 3.0;
+  
+  eval[2] = q + 2.0 * p * std::cos( phi );
+  eval[0] = q + 2.0 * p * std::cos( phi + twoThirdsPi );
+  eval[1] = 3.0 * q - eval[0] - eval[2];
+  
+  // Roundoff may break the order of the middle eigenvalue
+  eval[1] = std::min( std::max( eval[1], eval[0] ), eval[2] );
+  
+  return halfDet;
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenVector0( const double a[6], double eval, double evec[3] )
+{
+  // The eigenvector is orthogonal to the rows of A - eval I, which span a plane. Take the 
+  // cross product of two rows with the largest magnitude for numerical robustness
+  const double row0[3] = { a[0] - eval, a[1], a[2] };
+  const double row1[3] = { a[1], a[3] - eval, a[4] };
+  const double row2[3] = { a[2], a[4], a[5] - eval };
+  
+  double r0xr1[3], r0xr2[3], r1xr2[3];
+  Cross( row0, row1, r0xr1 );
+  Cross( row0, row2, r0xr2 );
+  Cross( row1, row2, r1xr2 );
+  
+  const double d0 = Dot( r0xr1, r0xr1 );
+  const double d1 = Dot( r0xr2, r0xr2 );
+  const double d2 = Dot( r1xr2, r1xr2 );
+  
+  const double *best = r0xr1;
+  double dmax = d0;
+  
+  if( d1 > dmax )
+  {
+    best = r0xr2;
+    dmax = d1;
+  }
+  
+  if( d2 > dmax )
+  {
+    best = r1xr2;
+    dmax = d2;
+  }
+  
+  if( dmax == 0.0 )
+  {
+    evec[0] = 1.0;
+    evec[1] = 0.0;
+    evec[2] = 0.0;
+    return;
+  }
+  
+  const double invLength = 1.0 / std::sqrt( dmax );
+  
+  for( unsigned int i=0; i<3; ++i )
+    evec[i] = best[i] * invLength;
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeEigenVector1( const double a[6], const double evec0[3], double eval, double evec1[3] )
+{
+  // Solve the 2x2 problem restricted to the orthogonal complement { u, v } of evec0
+  double u[3], v[3];
+  ComputeOrthogonalComplement( evec0, u, v );
+  
+  const double au[3] = { a[0] * u[0] + a[1] * u[1] + a[2] * u[2],
+                         a[1] * u[0] + a[3] * u[1] + a[4] * u[2],
+                         a[2] * u[0] + a[4] * u[1] + a[5] * u[2] };
+  const double av[3] = { a[0] * v[0] + a[1] * v[1] + a[2] * v[2],
+                         a[1] * v[0] + a[3] * v[1] + a[4] * v[2],
+                         a[2] * v[0] + a[4] * v[1] + a[5] * v[2] };
+  
+  double m00 = Dot( u, au ) - eval;
+  double m01 = Dot( u, av );
+  double m11 = Dot( v, av ) - eval;
+  
+  const double absM00 = std::fabs( m00 );
+  const double absM01 = std::fabs( m01 );
+  const double absM11 = std::fabs( m11 );
+  
+  // Null vector ( x, y ) of the 2x2 matrix, taken from its row with the largest component
+  double x = 1.0, y = 0.0;
+  
+  if( absM00 >= absM11 )
+  {
+    if( std::max( absM00, absM01 ) > 0.0 )
+    {
+      if( absM00 >= absM01 )
+      {
+        m01 /= m00;
+        m00 = 1.0 / std::sqrt( 1.0 + m01 * m01 );
+        m01 *= m00;
+      }
+      else
+      {
+        m00 /= m01;
+        m01 = 1.0 / std::sqrt( 1.0 + m00 * m00 );
+        m00 *= m01;
+      }
+      
+      x = m01;
+      y = -m00;
+    }
+  }
+  else
+  {
+    if( std::max( absM11, absM01 ) > 0.0 )
+    {
+      if( absM11 >= absM01 )
+      {
+        m01 /= m11;
+        m11 = 1.0 / std::sqrt( 1.0 + m01 * m01 );
+        m01 *= m11;
+      }
+      else
+      {
+        m11 /= m01;
+        m01 = 1.0 / std::sqrt( 1.0 + m11 * m11 );
+        m11 *= m01;
+      }
+      
+      x = m11;
+      y = -m01;
+    }
+  }
+  
+  for( unsigned int i=0; i<3; ++i )
+    evec1[i] = x * u[i] + y * v[i];
+}
+
+
+template <class TTensor>
+void
+SymmetricEigenSolver<TTensor,3>
+::ComputeOrthogonalComplement( const double w[3], double u[3], double v[3] )
+{
+  // w is a unit vector. Zero the component of u matching the smaller of |w0| and |w1|
+  if( std::fabs( w[0] ) > std::fabs( w[1] ) )
+  {
+    const double invLength = 1.0 / std::sqrt( w[0] * w[0] + w[2] * w[2] );
+    u[0] = -w[2] * invLength;
+    u[1] = 0.0;
+    u[2] = w[0] * invLength;
+  }
+  else
+  {
+    const double invLength = 1.0 / std::sqrt( w[1] * w[1] + w[2] * w[2] );
+    u[0] = 0.0;
+    u[1] = w[2] * invLength;
+    u[2] = -w[1] * invLength;
+  }
+  
+  Cross( w, u, v );
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,384 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTaskPool.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide pool of persistent threads running parallel loops over index ranges
+// Date: 2012/11/05
+
+#include "ivanTaskPool.h"
+
+#include "itkExceptionObject.h"
+#include "vnl/vnl_math.h"
+
+#include <exception>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ivan
+{
+
+namespace
+{
+/** Number of processors online, or zero if it is not known. */
+unsigned int GetNumberOfProcessors()
+{
+#if defined( _WIN32 )
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo( &systemInfo );
+  return static_cast<unsigned int>( systemInfo.dwNumberOfProcessors );
+#elif defined( _SC_NPROCESSORS_ONLN )
+  const long numberOfProcessors = sysconf( _SC_NPROCESSORS_ONLN );
+  return ( numberOfProcessors > 0 ) ? static_cast<unsigned int>( numberOfProcessors ) : 0;
+#else
+  return 0;
+#endif
+}
+}
+
+TaskPool::Pointer TaskPool::m_Instance;
+itk::SimpleFastMutexLock TaskPool::m_InstanceMutex;
+
+
+TaskPool::TaskPool() :
+  m_SpinCount( 20000 ),
+  m_Stopping( false ),
+  m_Function( 0 ),
+  m_Begin( 0 ),
+  m_End( 0 ),
+  m_GrainSize( 1 ),
+  m_NumberOfChunks( 0 ),
+  m_NumberOfLoopThreads( 0 ),
+  m_Failed( false ),
+  m_NumberOfSleepingThreads( 0 ),
+  m_CallerSleeping( false )
+{
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  
+  const unsigned int numberOfProcessors = GetNumberOfProcessors();
+  m_Oversubscribed = ( numberOfProcessors > 0 && m_NumberOfThreads > numberOfProcessors );
+  
+  m_Threader = itk::MultiThreader::New();
+  m_WorkCondition = itk::ConditionVariable::New();
+  m_DoneCondition = itk::ConditionVariable::New();
+}
+
+
+TaskPool::~TaskPool()
+{
+  this->StopThreads();
+}
+
+
+TaskPool::Pointer
+TaskPool::GetInstance()
+{
+  m_InstanceMutex.Lock();
+  
+  if( m_Instance.IsNull() )
+  {
+    m_Instance = new Self;
+    m_Instance->UnRegister(); // the smart pointer holds the only reference
+  }
+  
+  Pointer instance = m_Instance;
+  
+  m_InstanceMutex.Unlock();
+  
+  return instance;
+}
+
+
+void
+TaskPool::SetNumberOfThreads( unsigned int numberOfThreads )
+{
+  numberOfThreads = vnl_math_max( 1u, vnl_math_min( numberOfThreads,
+    static_cast<unsigned int>( ITK_MAX_THREADS ) ) );
+  
+  if( numberOfThreads == m_NumberOfThreads )
+    return;
+  
+  // The new threads are created by the next loop
+  this->StopThreads();
+  m_NumberOfThreads = numberOfThreads;
+  
+  const unsigned int numberOfProcessors = GetNumberOfProcessors();
+  m_Oversubscribed = ( numberOfProcessors > 0 && m_NumberOfThreads > numberOfProcessors );
+
+  this->Modified();
+}
+
+
+void
+TaskPool::StartThreads()
+{
+  if( m_Threads.size() + 1 >= m_NumberOfThreads )
+    return;
+  
+  for( unsigned int i = m_Threads.size() + 1; i < m_NumberOfThreads; ++i )
+  {
+    ThreadType *thread = new ThreadType;
+    thread->Pool = this;
+    thread->ThreadId = i;
+    thread->ThreaderId = m_Threader->SpawnThread( this->ThreaderCallback, thread );
+  
+    m_Threads.push_back( thread );
+  }
+}
+
+
+void
+TaskPool::StopThreads()
+{
+  if( m_Threads.empty() )
+    return;
+  
+  m_Mutex.Lock();
+  m_Stopping = true;
+  m_WorkCondition->Broadcast();
+  m_Mutex.Unlock();
+  
+  // This joins the threads
+  for( unsigned int i=0; i<m_Threads.size(); ++i )
+  {
+    m_Threader->TerminateThread( m_Threads[i]->ThreaderId );
+    delete m_Threads[i];
+  }
+  
+  m_Threads.clear();
+  m_Stopping = false;
+}
+
+
+void
+TaskPool::ParallelFor( IndexValueType begin, IndexValueType end, RangeFunction *function,
+  IndexValueType grainSize, unsigned int maximumNumberOfThreads )
+{
+  if( end <= begin )
+    return;
+  
+  const IndexValueType size = end - begin;
+  
+  unsigned int numberOfThreads = m_NumberOfThreads;
+  
+  if( maximumNumberOfThreads > 0 && maximumNumberOfThreads < numberOfThreads )
+    numberOfThreads = maximumNumberOfThreads;
+  
+  if( grainSize == 0 )
+    grainSize = vnl_math_max( size / ( 8 * numberOfThreads ), IndexValueType( 1 ) );
+  
+  const IndexValueType numberOfChunks = ( size + grainSize - 1 ) / grainSize;
+  
+  if( numberOfChunks < numberOfThreads )
+    numberOfThreads = static_cast<unsigned int>( numberOfChunks );
+  
+  // Another loop is running, maybe the one calling this
+  if( numberOfThreads <= 1 || m_Busy.FetchAndAdd( 1 ) != 0 )
+  {
+    if( numberOfThreads > 1 )
+      m_Busy.FetchAndAdd( -1 );
+  
+    m_NumberOfSerialLoops.FetchAndAdd( 1 );
+    function->Execute( begin, end, 0 );
+    return;
+  }
+  
+  this->StartThreads();
+  
+  m_Function = function;
+  m_Begin = begin;
+  m_End = end;
+  m_GrainSize = grainSize;
+  m_NumberOfChunks = numberOfChunks;
+  m_NumberOfLoopThreads = numberOfThreads;
+  m_NextChunk.SetValue( 0 );
+  m_Failed = false;
+  m_ErrorDescription.clear();
+  
+  // The atomic additions publish the loop to the threads that poll their flag
+  for( unsigned int i=1; i<numberOfThreads; ++i )
+    m_Threads[i-1]->Pending.FetchAndAdd( 1 );
+  
+  m_Mutex.Lock();
+  
+  if( m_NumberOfSleepingThreads > 0 )
+    m_WorkCondition->Broadcast();
+  
+  m_Mutex.Unlock();
+  
+  this->ProcessChunks( 0 );
+  
+  // Wait for the threads still running their last chunk
+  const unsigned int spinCount = this->GetEffectiveSpinCount();
+  for( unsigned int i=1; i<numberOfThreads; ++i )
+  {
+    ThreadType *thread = m_Threads[i-1];
+  
+    for( unsigned int spin = 0; spin < spinCount && thread->Pending.GetValue(); ++spin )
+      ;
+  
+    if( thread->Pending.GetValue() )
+    {
+      m_Mutex.Lock();
+      m_CallerSleeping = true;
+  
+      while( thread->Pending.GetValue() )
+        m_DoneCondition->Wait( &m_Mutex );
+  
+      m_CallerSleeping = false;
+      m_Mutex.Unlock();
+    }
+  }
+  
+  const bool failed = m_Failed;
+  const std::string errorDescription = m_ErrorDescription;
+  
+  m_Function = 0;
+  m_NumberOfParallelLoops.FetchAndAdd( 1 );
+  m_Busy.FetchAndAdd( -1 );
+  
+  if( failed )
+    itkExceptionMacro( << "Parallel loop failed: " << errorDescription );
+}
+
+
+void
+TaskPool::ProcessChunks( unsigned int threadId )
+{
+  while( !m_Failed )
+  {
+    const IndexValueType chunk = static_cast<IndexValueType>( m_NextChunk.FetchAndAdd( 1 ) );
+  
+    if( chunk >= m_NumberOfChunks )
+      break;
+  
+    const IndexValueType chunkBegin = m_Begin + chunk * m_GrainSize;
+    const IndexValueType chunkEnd = vnl_math_min( chunkBegin + m_GrainSize, m_End );
+  
+    std::string errorDescription;
+  
+    try
+    {
+      m_Function->Execute( chunkBegin, chunkEnd, threadId );
+      continue;
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      errorDescription = excpt.GetDescription();
+    }
+    catch( std::exception & excpt )
+    {
+      errorDescription = excpt.what();
+    }
+    catch( ... )
+    {
+      errorDescription = "Unknown exception";
+    }
+  
+    // Keep the first error
+    m_Mutex.Lock();
+  
+    if( !m_Failed )
+    {
+      m_ErrorDescription = errorDescription;
+      m_Failed = true;
+    }
+  
+    m_Mutex.Unlock();
+  }
+}
+
+
+void
+TaskPool::ProcessLoops( ThreadType *thread )
+{
+  const unsigned int spinCount = this->GetEffectiveSpinCount();
+  
+  while( true )
+  {
+    for( unsigned int spin = 0; spin < spinCount && !thread->Pending.GetValue() && !m_Stopping; ++spin )
+      ;
+  
+    if( !thread->Pending.GetValue() && !m_Stopping )
+    {
+      m_Mutex.Lock();
+      ++m_NumberOfSleepingThreads;
+  
+      while( !thread->Pending.GetValue() && !m_Stopping )
+        m_WorkCondition->Wait( &m_Mutex );
+  
+      --m_NumberOfSleepingThreads;
+      m_Mutex.Unlock();
+    }
+  
+    if( m_Stopping )
+      break;
+  
+    // Full barrier, so the loop published before the flag is seen
+    thread->Pending.FetchAndAdd( 0 );
+  
+    this->ProcessChunks( thread->ThreadId );
+  
+    thread->Pending.FetchAndAdd( -1 );
+  
+    m_Mutex.Lock();
+  
+    if( m_CallerSleeping )
+      m_DoneCondition->Broadcast();
+  
+    m_Mutex.Unlock();
+  }
+}
+
+
+ITK_THREAD_RETURN_TYPE
+TaskPool::ThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  ThreadType *thread = static_cast<ThreadType *>( threadInfo->UserData );
+  
+  thread->Pool->ProcessLoops( thread );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+void
+TaskPool::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "SpinCount: " << m_SpinCount << std::endl;
+  os << indent << "Oversubscribed: " << m_Oversubscribed << std::endl;
+  os << indent << "NumberOfParallelLoops: " << this->GetNumberOfParallelLoops() << std::endl;
+  os << indent << "NumberOfSerialLoops: " << this->GetNumberOfSerialLoops() << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,210 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTaskPool.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: process-wide pool of persistent threads running parallel loops over index ranges
+// Date: 2012/11/05
+
+#ifndef __ivanTaskPool_h
+#define __ivanTaskPool_h
+
+#include "ivanAtomicCounter.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+/**
+ * \class TaskPool
+ * \brief Process-wide pool of persistent threads that run parallel loops over index ranges.
+ *
+ * itk::MultiThreader creates and joins its threads on every call, which costs tens of
+ * microseconds: more than the work itself in the small parallel operations the trackers repeat
+ * thousands of times, such as the initialization of the scaled functions or the branches of a
+ * graph. The threads of the pool are created once, the first time they are needed, and wait
+ * for work between loops, spinning for SpinCount polls before sleeping, so a loop issued soon
+ * after the previous one starts within a microsecond.
+ *
+ * ParallelFor() splits [begin,end) in chunks of GrainSize indices that the threads take in
+ * order until there are none left, so uneven chunks are balanced. The calling thread takes
+ * part as thread 0, and the pool threads are 1 to NumberOfThreads-1, so the thread ids can
+ * index per-thread data. The call returns when all the chunks are done.
+ *
+ * There is a single instance per process, obtained with GetInstance(). It runs one loop at a
+ * time: a loop issued while another one runs, from another thread or from inside a chunk, is
+ * run serially by its calling thread, so nested and concurrent loops are safe and never wait.
+ *
+ * \sa ImageRegionTileScheduler
+ */
+class ITK_EXPORT TaskPool : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef TaskPool                        Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TaskPool, itk::Object );
+  
+  typedef unsigned long   IndexValueType;
+  
+  /** Body of a parallel loop. */
+  class RangeFunction
+  {
+  public:
+  
+    virtual ~RangeFunction() {}
+  
+    /** Process the indices in [begin,end). Called concurrently from several threads, with
+      * threadId in [0,NumberOfThreads). */
+    virtual void Execute( IndexValueType begin, IndexValueType end, unsigned int threadId ) = 0;
+  };
+
+public:
+
+  /** Get the instance of the pool for this process. */
+  static Pointer GetInstance();
+  
+  /** Set/Get the number of threads of the loops, including the calling thread. By default,
+    * the global default number of threads of ITK. Changing it stops the current threads,
+    * so it must not be called while a loop runs. */
+  void SetNumberOfThreads( unsigned int numberOfThreads );
+  unsigned int GetNumberOfThreads() const
+    { return m_NumberOfThreads; }
+  
+  /** Set/Get the number of polls for work or for the end of a loop before sleeping. A few
+    * microseconds by default. Zero makes the threads sleep right away, which they always do
+    * when there are more threads than processors, since polling would take the processor
+    * from the thread that has the work. */
+  itkSetMacro( SpinCount, unsigned int );
+  itkGetConstMacro( SpinCount, unsigned int );
+  
+  /** Run the function over [begin,end) in chunks of grainSize indices, on at most
+    * maximumNumberOfThreads threads (zero for all of them). A zero grain size splits the
+    * range in about eight chunks per thread. An exception in a chunk stops the chunks not
+    * started yet and is thrown again, as an itk::ExceptionObject, when the loop ends. */
+  void ParallelFor( IndexValueType begin, IndexValueType end, RangeFunction *function,
+    IndexValueType grainSize = 0, unsigned int maximumNumberOfThreads = 0 );
+  
+  /** Number of loops run by the pool threads, and run serially because they had a single
+    * chunk or thread, or another loop was running. */
+  unsigned long GetNumberOfParallelLoops() const
+    { return static_cast<unsigned long>( m_NumberOfParallelLoops.GetValue() ); }
+  unsigned long GetNumberOfSerialLoops() const
+    { return static_cast<unsigned long>( m_NumberOfSerialLoops.GetValue() ); }
+
+protected:
+
+  TaskPool();
+  ~TaskPool();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** A pool thread. Pending is set by the calling thread when the thread takes part in a
+    * loop, and cleared by the thread when it has no more chunks to take. */
+  struct ThreadType
+  {
+    TaskPool       *Pool;
+    unsigned int    ThreadId;
+    int             ThreaderId;
+    AtomicCounter   Pending;
+  };
+  
+  /** Number of polls before sleeping, zero if there are more threads than processors. */
+  unsigned int GetEffectiveSpinCount() const
+    { return m_Oversubscribed ? 0 : m_SpinCount; }
+  
+  /** Create the pool threads if they do not exist. */
+  void StartThreads();
+  
+  /** Stop and join the pool threads. */
+  void StopThreads();
+  
+  /** Take and run the chunks of the current loop until there are none left. */
+  void ProcessChunks( unsigned int threadId );
+  
+  /** Loop of the pool threads. */
+  void ProcessLoops( ThreadType *thread );
+  
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback( void *arg );
+
+private:
+
+  TaskPool( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  unsigned int                      m_NumberOfThreads;
+  unsigned int                      m_SpinCount;
+  bool                              m_Oversubscribed;
+
+  itk::MultiThreader::Pointer       m_Threader;
+  std::vector<ThreadType *>         m_Threads;
+  volatile bool                     m_Stopping;
+  
+  /** Current loop. */
+  RangeFunction                    *m_Function;
+  IndexValueType                    m_Begin;
+  IndexValueType                    m_End;
+  IndexValueType                    m_GrainSize;
+  IndexValueType                    m_NumberOfChunks;
+  unsigned int                      m_NumberOfLoopThreads;
+  AtomicCounter                     m_NextChunk;
+  volatile bool                     m_Failed;
+  std::string                       m_ErrorDescription;
+  
+  /** Set while a loop runs. */
+  AtomicCounter                     m_Busy;
+  
+  AtomicCounter                     m_NumberOfParallelLoops;
+  AtomicCounter                     m_NumberOfSerialLoops;
+  
+  /** Sleeping threads wait for work, and the calling thread for the end of the loop. */
+  itk::SimpleMutexLock              m_Mutex;
+  itk::ConditionVariable::Pointer   m_WorkCondition;
+  itk::ConditionVariable::Pointer   m_DoneCondition;
+  unsigned int                      m_NumberOfSleepingThreads;
+  bool                              m_CallerSleeping;
+  
+  static Pointer                    m_Instance;
+  static itk::SimpleFastMutexLock   m_InstanceMutex;
+};
+
+} // end namespace ivan
+
+#endif
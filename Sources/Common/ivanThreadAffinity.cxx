@@ -0,0 +1,156 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanThreadAffinity.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: pinning of the calling thread to a processor
+// Date: 2012/11/05
+
+#include "ivanThreadAffinity.h"
+
+#if defined( _WIN32 )
+#include <windows.h>
+#define IVAN_THREAD_AFFINITY_WINDOWS
+#elif defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#define IVAN_THREAD_AFFINITY_LINUX
+#endif
+
+
+namespace ivan
+{
+
+ScopedThreadAffinity::ScopedThreadAffinity( unsigned int threadId, bool enabled ) :
+  m_Pinned( false ),
+  m_PreviousAffinity( 0 )
+{
+  if( !enabled )
+    return;
+
+#if defined( IVAN_THREAD_AFFINITY_LINUX )
+  cpu_set_t *previous = new cpu_set_t;
+  
+  if( pthread_getaffinity_np( pthread_self(), sizeof( cpu_set_t ), previous ) != 0 )
+  {
+    delete previous;
+    return;
+  }
+  
+  const unsigned int numberOfProcessors = CPU_COUNT( previous );
+  
+  if( numberOfProcessors == 0 )
+  {
+    delete previous;
+    return;
+  }
+  
+  // Find the threadId-th processor of the mask
+  unsigned int k = threadId % numberOfProcessors;
+  int processor = 0;
+  
+  for( ; processor < CPU_SETSIZE; ++processor )
+  {
+    if( CPU_ISSET( processor, previous ) && k-- == 0 )
+      break;
+  }
+  
+  cpu_set_t affinity;
+  CPU_ZERO( &affinity );
+  CPU_SET( processor, &affinity );
+  
+  if( pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &affinity ) != 0 )
+  {
+    delete previous;
+    return;
+  }
+  
+  m_PreviousAffinity = previous;
+  m_Pinned = true;
+#elif defined( IVAN_THREAD_AFFINITY_WINDOWS )
+  DWORD_PTR processAffinity, systemAffinity;
+  
+  if( !GetProcessAffinityMask( GetCurrentProcess(), &processAffinity, &systemAffinity ) || 
+    !processAffinity )
+    return;
+  
+  unsigned int numberOfProcessors = 0;
+  
+  for( unsigned int i=0; i < 8 * sizeof( DWORD_PTR ); ++i )
+  {
+    if( processAffinity & ( static_cast<DWORD_PTR>( 1 ) << i ) )
+      ++numberOfProcessors;
+  }
+  
+  unsigned int k = threadId % numberOfProcessors;
+  unsigned int processor = 0;
+  
+  for( ; processor < 8 * sizeof( DWORD_PTR ); ++processor )
+  {
+    if( ( processAffinity & ( static_cast<DWORD_PTR>( 1 ) << processor ) ) && k-- == 0 )
+      break;
+  }
+  
+  const DWORD_PTR previous = SetThreadAffinityMask( GetCurrentThread(), 
+    static_cast<DWORD_PTR>( 1 ) << processor );
+  
+  if( !previous )
+    return;
+  
+  m_PreviousAffinity = new DWORD_PTR( previous );
+  m_Pinned = true;
+#else
+  (void)threadId;
+#endif
+}
+
+
+ScopedThreadAffinity::~ScopedThreadAffinity()
+{
+  if( !m_Pinned )
+    return;
+
+#if defined( IVAN_THREAD_AFFINITY_LINUX )
+  cpu_set_t *previous = static_cast<cpu_set_t *>( m_PreviousAffinity );
+  pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), previous );
+  delete previous;
+#elif defined( IVAN_THREAD_AFFINITY_WINDOWS )
+  DWORD_PTR *previous = static_cast<DWORD_PTR *>( m_PreviousAffinity );
+  SetThreadAffinityMask( GetCurrentThread(), *previous );
+  delete previous;
+#endif
+}
+
+
+bool
+ScopedThreadAffinity::IsSupported()
+{
+#if defined( IVAN_THREAD_AFFINITY_LINUX ) || defined( IVAN_THREAD_AFFINITY_WINDOWS )
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // end namespace ivan
@@ -0,0 +1,86 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanThreadAffinity.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: pinning of the calling thread to a processor
+// Date: 2012/11/05
+
+#ifndef __ivanThreadAffinity_h
+#define __ivanThreadAffinity_h
+
+#include "itkMacro.h"
+
+
+namespace ivan
+{
+/**
+ * \class ScopedThreadAffinity
+ * \brief Pins the calling thread to a processor for the lifetime of the object.
+ *
+ * The threads of the multithreaded filters are not bound to processors, so on machines with 
+ * several memory nodes the thread that evaluates a region in one pass may run on a different 
+ * node than the one that first touched its memory. Creating a ScopedThreadAffinity with the 
+ * thread id at the beginning of each threaded method pins thread i to the same processor in
+ * all the passes, so that the pages initialized by a thread stay local to it.
+ *
+ * Thread i is pinned to the i-th processor (modulo their number) of the affinity mask the
+ * thread had on construction, which respects the processors given to the process (taskset, 
+ * cgroups...). The previous affinity is restored on destruction, since the first thread of 
+ * itk::MultiThreader is the calling thread. Supported on Linux and Windows, elsewhere it
+ * does nothing.
+ */
+class ITK_EXPORT ScopedThreadAffinity
+{
+public:
+
+  /** Pin the calling thread to the processor of the given thread id, if enabled. */
+  ScopedThreadAffinity( unsigned int threadId, bool enabled = true );
+  
+  /** Restore the previous affinity of the thread. */
+  ~ScopedThreadAffinity();
+  
+  /** Whether the thread was actually pinned. */
+  bool IsPinned() const
+    { return m_Pinned; }
+  
+  /** Whether thread affinity is supported on this platform. */
+  static bool IsSupported();
+  
+private:
+
+  ScopedThreadAffinity( const ScopedThreadAffinity& ); // purposely not implemented
+  void operator=( const ScopedThreadAffinity& ); // purposely not implemented
+  
+private:
+
+  bool    m_Pinned;
+  
+  /** Previous affinity, in the format of the platform. */
+  void   *m_PreviousAffinity;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,100 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTileConvolutionKernels.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: baseline convolution kernels of interleaved tiles
+// Date: 2012/11/05
+
+#include "ivanTileConvolutionKernels.h"
+
+namespace ivan
+{
+
+void ConvolveTileGeneric( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result )
+{
+  ConvolveTile<double,16>( tile, length, kernel, kernelSize, result );
+}
+
+
+void ConvolveTileGeneric( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result )
+{
+  ConvolveTile<float,16>( tile, length, kernel, kernelSize, result );
+}
+
+
+void ConvertRowGeneric( const short *row, unsigned long length, float *result )
+{
+  ConvertRow( row, length, result );
+}
+
+
+void ConvertRowGeneric( const short *row, unsigned long length, double *result )
+{
+  ConvertRow( row, length, result );
+}
+
+
+#if defined( __aarch64__ ) && defined( __GNUC__ )
+
+// The conversions of __fp16 are vectorized with the NEON instructions of the baseline
+typedef __fp16 HalfAliasType __attribute__(( __may_alias__ ));
+
+void ConvertHalfRowGeneric( const unsigned short *row, unsigned long length, float *result )
+{
+  const HalfAliasType *values = reinterpret_cast<const HalfAliasType *>( row );
+  
+  for( unsigned long i = 0; i < length; ++i )
+    result[i] = static_cast<float>( values[i] );
+}
+
+
+void ConvertHalfRowGeneric( const float *row, unsigned long length, unsigned short *result )
+{
+  HalfAliasType *values = reinterpret_cast<HalfAliasType *>( result );
+  
+  for( unsigned long i = 0; i < length; ++i )
+    values[i] = static_cast<HalfAliasType>( row[i] );
+}
+
+#else
+
+void ConvertHalfRowGeneric( const unsigned short *row, unsigned long length, float *result )
+{
+  for( unsigned long i = 0; i < length; ++i )
+    result[i] = HalfToFloat( row[i] );
+}
+
+
+void ConvertHalfRowGeneric( const float *row, unsigned long length, unsigned short *result )
+{
+  for( unsigned long i = 0; i < length; ++i )
+    result[i] = FloatToHalf( row[i] );
+}
+
+#endif
+
+} // end namespace ivan
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTileConvolutionKernels.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: convolution kernels of interleaved tiles, compiled once per instruction set
+// Date: 2012/11/05
+
+#ifndef __ivanTileConvolutionKernels_h
+#define __ivanTileConvolutionKernels_h
+
+// This header is only included by the ivanTileConvolutionKernels*.cxx files, each of which is 
+// compiled with the flags of one instruction set. It must not include other headers: their inline
+// functions would be compiled with these flags too, and the linker could keep a version that
+// the processor does not support for the whole library.
+
+namespace ivan
+{
+
+/** Kernel entry points of each instruction set (see CPUDispatch::KernelTable). */
+void ConvolveTileGeneric( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result );
+void ConvolveTileGeneric( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result );
+
+void ConvolveTileAVX2( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result );
+void ConvolveTileAVX2( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result );
+
+void ConvolveTileAVX512( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result );
+void ConvolveTileAVX512( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result );
+
+/** Conversion of rows of integer pixels (the signed short of CT studies) to real values. */
+void ConvertRowGeneric( const short *row, unsigned long length, float *result );
+void ConvertRowGeneric( const short *row, unsigned long length, double *result );
+
+void ConvertRowAVX2( const short *row, unsigned long length, float *result );
+void ConvertRowAVX2( const short *row, unsigned long length, double *result );
+
+void ConvertRowAVX512( const short *row, unsigned long length, float *result );
+void ConvertRowAVX512( const short *row, unsigned long length, double *result );
+
+/** Conversion of rows of half-precision values (the bits of IEEE 754 binary16) to float, and
+  * from float rounding to nearest even. */
+void ConvertHalfRowGeneric( const unsigned short *row, unsigned long length, float *result );
+void ConvertHalfRowGeneric( const float *row, unsigned long length, unsigned short *result );
+
+void ConvertHalfRowAVX2( const unsigned short *row, unsigned long length, float *result );
+void ConvertHalfRowAVX2( const float *row, unsigned long length, unsigned short *result );
+
+void ConvertHalfRowAVX512( const unsigned short *row, unsigned long length, float *result );
+void ConvertHalfRowAVX512( const float *row, unsigned long length, unsigned short *result );
+
+// Internal linkage, so that each translation unit keeps its own copy
+namespace
+{
+
+/** The loop over the lines of the tile is innermost and of fixed length, so that it is 
+  * vectorized with the registers of the instruction set of the translation unit. */
+template <class T, unsigned int VWidth>
+inline void ConvolveTile( const T *tile, unsigned long length, const T *kernel, 
+  unsigned int kernelSize, T *result )
+{
+  for( unsigned long i = 0; i < length; ++i )
+  {
+    T sums[VWidth];
+    
+    for( unsigned int b = 0; b < VWidth; ++b )
+      sums[b] = 0;
+    
+    for( unsigned int k = 0; k < kernelSize; ++k )
+    {
+      const T coefficient = kernel[k];
+      const T *row = tile + ( i + k ) * VWidth;
+      
+      for( unsigned int b = 0; b < VWidth; ++b )
+        sums[b] += coefficient * row[b];
+    }
+    
+    T *out = result + i * VWidth;
+    
+    for( unsigned int b = 0; b < VWidth; ++b )
+      out[b] = sums[b];
+  }
+}
+
+/** Float with the bits of a half-precision value. Used where the processor has no conversion
+  * instructions, and for the ends of the rows converted by the vector instructions. */
+inline float HalfToFloat( unsigned short half )
+{
+  const unsigned int sign = static_cast<unsigned int>( half & 0x8000u ) << 16;
+  const unsigned int exponent = ( half >> 10 ) & 0x1fu;
+  unsigned int mantissa = half & 0x03ffu;
+  
+  union { unsigned int Bits; float Value; } result;
+  
+  if( exponent == 0x1fu )
+    result.Bits = sign | 0x7f800000u | ( mantissa << 13 );
+  else if( exponent )
+    result.Bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+  else if( mantissa )
+  {
+    // Subnormal half, normal float
+    unsigned int floatExponent = 113;
+    
+    while( !( mantissa & 0x0400u ) )
+    {
+      mantissa <<= 1;
+      --floatExponent;
+    }
+    
+    result.Bits = sign | ( floatExponent << 23 ) | ( ( mantissa & 0x03ffu ) << 13 );
+  }
+  else
+    result.Bits = sign;
+  
+  return result.Value;
+}
+
+
+/** Bits of the half-precision value nearest to a float, ties to even. Values beyond the 
+  * largest half (65504) become infinite. */
+inline unsigned short FloatToHalf( float value )
+{
+  union { float Value; unsigned int Bits; } input;
+  input.Value = value;
+  
+  const unsigned int sign = ( input.Bits >> 16 ) & 0x8000u;
+  const unsigned int magnitude = input.Bits & 0x7fffffffu;
+  unsigned int half;
+  
+  if( magnitude >= 0x7f800000u )
+  {
+    // Infinity, or a quiet NaN
+    half = ( magnitude > 0x7f800000u ) ? 0x7e00u : 0x7c00u;
+  }
+  else if( magnitude >= 0x477ff000u )
+  {
+    half = 0x7c00u;
+  }
+  else if( magnitude >= 0x38800000u )
+  {
+    // Normal half: rebias the exponent and round the 13 dropped bits
+    const unsigned int rebiased = magnitude - 0x38000000u;
+    half = ( rebiased + 0x0fffu + ( ( rebiased >> 13 ) & 1u ) ) >> 13;
+  }
+  else if( magnitude >= 0x33000000u )
+  {
+    // Subnormal half, in units of 2^-24
+    const unsigned int shift = 126 - ( magnitude >> 23 );
+    const unsigned int mantissa = ( magnitude & 0x007fffffu ) | 0x00800000u;
+    const unsigned int rounded = mantissa >> shift;
+    const unsigned int remainder = mantissa & ( ( 1u << shift ) - 1 );
+    const unsigned int halfway = 1u << ( shift - 1 );
+    
+    half = rounded + ( ( remainder > halfway || ( remainder == halfway && ( rounded & 1u ) ) ) ? 1u : 0u );
+  }
+  else
+  {
+    half = 0;
+  }
+  
+  return static_cast<unsigned short>( sign | half );
+}
+
+
+/** A plain loop, vectorized to widen and convert a register of pixels at a time. */
+template <class TInput, class TOutput>
+inline void ConvertRow( const TInput *row, unsigned long length, TOutput *result )
+{
+  for( unsigned long i = 0; i < length; ++i )
+    result[i] = static_cast<TOutput>( row[i] );
+}
+
+} // end anonymous namespace
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,94 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTileConvolutionKernelsAVX512.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: AVX-512 convolution kernels of interleaved tiles
+// Date: 2012/11/05
+
+// Compiled with the AVX-512F flags of the compiler when IVAN_USE_CPU_DISPATCH is set
+
+#include "ivanTileConvolutionKernels.h"
+
+#include <immintrin.h>
+
+namespace ivan
+{
+
+void ConvolveTileAVX512( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result )
+{
+  ConvolveTile<double,16>( tile, length, kernel, kernelSize, result );
+}
+
+
+void ConvolveTileAVX512( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result )
+{
+  ConvolveTile<float,16>( tile, length, kernel, kernelSize, result );
+}
+
+
+void ConvertRowAVX512( const short *row, unsigned long length, float *result )
+{
+  ConvertRow( row, length, result );
+}
+
+
+void ConvertRowAVX512( const short *row, unsigned long length, double *result )
+{
+  ConvertRow( row, length, result );
+}
+
+
+void ConvertHalfRowAVX512( const unsigned short *row, unsigned long length, float *result )
+{
+  unsigned long i = 0;
+  
+  for( ; i + 16 <= length; i += 16 )
+  {
+    const __m256i halves = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( row + i ) );
+    _mm512_storeu_ps( result + i, _mm512_cvtph_ps( halves ) );
+  }
+  
+  for( ; i < length; ++i )
+    result[i] = HalfToFloat( row[i] );
+}
+
+
+void ConvertHalfRowAVX512( const float *row, unsigned long length, unsigned short *result )
+{
+  unsigned long i = 0;
+  
+  for( ; i + 16 <= length; i += 16 )
+  {
+    const __m256i halves = _mm512_cvtps_ph( _mm512_loadu_ps( row + i ), _MM_FROUND_TO_NEAREST_INT );
+    _mm256_storeu_si256( reinterpret_cast<__m256i *>( result + i ), halves );
+  }
+  
+  for( ; i < length; ++i )
+    result[i] = FloatToHalf( row[i] );
+}
+
+} // end namespace ivan
@@ -30,6 +30,8 @@ SUCH DAMAGE.
 #ifndef __ivanVesselDataObject_h
 #define __ivanVesselDataObject_h
 
+#include "ivanVesselRegion.h"
+
 #include "itkDataObject.h"
 
 namespace ivan
@@ -42,6 +44,13 @@ namespace ivan
  * These objects may be structured differently, for example in the form of a graph or in
  * the form of a set of branches that has not been yet connected.
  *
+ * The requested and buffered regions of a vessel data object are VesselRegions, or the whole
+ * object. Filters downstream may request only some branches or sections, and the request is 
+ * propagated to the sources upstream, which may generate only that region. When the source has
+ * generated the data, its requested region becomes the buffered region, and the source executes
+ * again when a region outside of it is requested. Objects not generated by a pipeline are 
+ * wholly buffered.
+ *
  * \ingroup 
  */
  
@@ -67,13 +76,87 @@ public:
   /** Check if this is a vessel graph or not. */
   virtual bool IsGraph()
     { return false; }
+  
+  /** Set/Get the region requested from the source of this object. By default the whole object
+    * is requested. */
+  void SetRequestedRegion( const VesselRegion & region )
+    { m_RequestedRegion = region; m_RequestedRegionIsWhole = false; }
+  const VesselRegion & GetRequestedRegion() const
+    { return m_RequestedRegion; }
+  bool IsRequestedRegionWhole() const
+    { return m_RequestedRegionIsWhole; }
+  
+  /** Set/Get the region that holds valid data. */
+  void SetBufferedRegion( const VesselRegion & region )
+    { m_BufferedRegion = region; m_BufferedRegionIsWhole = false; }
+  const VesselRegion & GetBufferedRegion() const
+    { return m_BufferedRegion; }
+  void SetBufferedRegionToWhole()
+    { m_BufferedRegion.Clear(); m_BufferedRegionIsWhole = true; }
+  bool IsBufferedRegionWhole() const
+    { return m_BufferedRegionIsWhole; }
+  
+  /** Request the whole object. */
+  virtual void SetRequestedRegionToLargestPossibleRegion()
+    { m_RequestedRegion.Clear(); m_RequestedRegionIsWhole = true; }
+  
+  /** Check if the source has to execute again to provide the requested region. */
+  virtual bool RequestedRegionIsOutsideOfTheBufferedRegion()
+    {
+      if( m_BufferedRegionIsWhole )
+        return false;
+      if( m_RequestedRegionIsWhole )
+        return true;
+      return !m_BufferedRegion.IsInside( m_RequestedRegion );
+    }
+  
+  /** Any region is valid. Branches that do not exist are not generated. */
+  virtual bool VerifyRequestedRegion()
+    { return true; }
+  
+  /** Copy the requested region of another vessel data object. This is used by the pipeline. */
+#if ITK_VERSION_MAJOR < 4
+  virtual void SetRequestedRegion( itk::DataObject *data )
+#else
+  virtual void SetRequestedRegion( const itk::DataObject *data )
+#endif
+    {
+      const Self *vessel = dynamic_cast<const Self*>( data );
+      if( vessel )
+      {
+        m_RequestedRegion = vessel->m_RequestedRegion;
+        m_RequestedRegionIsWhole = vessel->m_RequestedRegionIsWhole;
+      }
+    }
+  
+  /** Called by the source when it has generated the data. The requested region becomes the 
+    * buffered region. */
+  virtual void DataHasBeenGenerated()
+    {
+      Superclass::DataHasBeenGenerated();
+      m_BufferedRegion = m_RequestedRegion;
+      m_BufferedRegionIsWhole = m_RequestedRegionIsWhole;
+    }
   		
 protected:
   
-  VesselDataObject() {}
+  VesselDataObject() :
+    m_RequestedRegionIsWhole( true ),
+    m_BufferedRegionIsWhole( true ) 
+    {}
   ~VesselDataObject() {}
     
-  //void PrintSelf( std::ostream& os, itk::Indent indent ) const {}
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const
+    {
+      Superclass::PrintSelf( os, indent );
+      
+      os << indent << "RequestedRegionIsWhole: " << m_RequestedRegionIsWhole << std::endl;
+      if( !m_RequestedRegionIsWhole )
+        m_RequestedRegion.Print( os, indent.GetNextIndent() );
+      os << indent << "BufferedRegionIsWhole: " << m_BufferedRegionIsWhole << std::endl;
+      if( !m_BufferedRegionIsWhole )
+        m_BufferedRegion.Print( os, indent.GetNextIndent() );
+    }
 
 private:
 
@@ -82,7 +165,11 @@ private:
 
 protected:
 
+  VesselRegion    m_RequestedRegion;
+  bool            m_RequestedRegionIsWhole;
   
+  VesselRegion    m_BufferedRegion;
+  bool            m_BufferedRegionIsWhole;
 };
 
 } // end namespace ivan
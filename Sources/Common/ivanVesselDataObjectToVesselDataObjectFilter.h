@@ -0,0 +1,108 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselDataObjectToVesselDataObjectFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselDataObjectToVesselDataObjectFilter_h
+#define __ivanVesselDataObjectToVesselDataObjectFilter_h
+
+#include "ivanVesselDataObjectSource.h"
+#include "ivanVesselDataObject.h"
+
+
+namespace ivan
+{
+  
+/** \class VesselDataObjectToVesselDataObjectFilter
+ * \brief Base class for filters that take a VesselDataObject as input and produce a VesselDataObject as output.
+ *
+ * VesselDataObjectToVesselDataObjectFilter is the base class for all process objects that 
+ * output VesselDataObject data and require a VesselDataObject as input. Specifically, this class
+ * defines the SetInput() method for defining the input to a filter.
+ *
+ * The region requested from the output is requested from the input too, so the filters 
+ * upstream only generate the branches and sections needed downstream. Subclasses that need 
+ * more of the input, or all of it, override GenerateInputRequestedRegion().
+ *
+ */
+
+template <class TInputVessel, class TOutputVessel>
+class ITK_EXPORT VesselDataObjectToVesselDataObjectFilter : public VesselDataObjectSource<TOutputVessel>
+{
+public:
+	
+  /** Standard class typedefs. */
+  typedef VesselDataObjectToVesselDataObjectFilter  Self;
+  typedef VesselDataObjectSource<TOutputVessel>     Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+  
+  /** Some convenient typedefs. */
+  typedef TInputVessel                            InputVesselType;
+  typedef typename InputVesselType::Pointer       InputVesselPointer;
+  typedef typename InputVesselType::ConstPointer  InputVesselConstPointer;
+  	
+  /** Some convenient typedefs. */
+  typedef TOutputVessel                           OutputVesselType;
+  typedef typename OutputVesselType::Pointer      OutputVesselPointer;
+  
+public:
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselDataObjectToVesselDataObjectFilter, VesselDataObjectSource );
+
+  /** Set/Get the vessel input of this process object.  */
+  virtual void SetInput( const InputVesselType *vessel );
+  virtual void SetInput( unsigned int, const InputVesselType * vessel );
+  const InputVesselType * GetInput(void);
+  const InputVesselType * GetInput(unsigned int idx);
+
+protected:
+  
+  VesselDataObjectToVesselDataObjectFilter();
+  ~VesselDataObjectToVesselDataObjectFilter() {}
+  
+  /** Request the region requested from the output from every vessel input. */
+  virtual void GenerateInputRequestedRegion();
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+  VesselDataObjectToVesselDataObjectFilter(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanVesselDataObjectToVesselDataObjectFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselDataObjectToVesselDataObjectFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselDataObjectToVesselDataObjectFilter_hxx
+#define __ivanVesselDataObjectToVesselDataObjectFilter_hxx
+
+#include "ivanVesselDataObjectToVesselDataObjectFilter.h"
+
+namespace ivan
+{
+  
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::VesselDataObjectToVesselDataObjectFilter()
+{
+  // Modify superclass default values, can be overridden by subclasses
+  this->SetNumberOfRequiredInputs(1);
+}
+
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+void 
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::SetInput(const InputVesselType *vessel)
+{
+  // Process object is not const-correct so the const_cast is required here
+  this->itk::ProcessObject::SetNthInput( 0, const_cast< InputVesselType * >( vessel ) );
+}
+
+
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+void 
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::SetInput( unsigned int index, const TInputVessel * vessel ) 
+{
+  // Process object is not const-correct so the const_cast is required here
+  this->itk::ProcessObject::SetNthInput( index, const_cast< TInputVessel *>( vessel ) );
+}
+
+
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+const typename VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>::InputVesselType *
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::GetInput(void) 
+{
+  if ( this->GetNumberOfInputs() < 1)
+    {
+    return 0;
+    }
+  
+  return static_cast<const TInputVessel * >
+    ( this->itk::ProcessObject::GetInput(0) );
+}
+  
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+const typename VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>::InputVesselType *
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::GetInput(unsigned int idx)
+{
+  return static_cast< const TInputVessel * >( this->itk::ProcessObject::GetInput(idx) );
+}
+
+
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+void 
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::GenerateInputRequestedRegion()
+{
+  OutputVesselType *output = this->GetOutput();
+  
+  for( unsigned int i=0; i<this->GetNumberOfInputs(); ++i )
+  {
+    // Inputs of other types, such as images, are requested whole
+    VesselDataObject *input = dynamic_cast<VesselDataObject*>( this->itk::ProcessObject::GetInput(i) );
+    
+    if( input && output )
+      input->SetRequestedRegion( output );
+    else if( this->itk::ProcessObject::GetInput(i) )
+      this->itk::ProcessObject::GetInput(i)->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputVessel, class TOutputVessel>
+void 
+VesselDataObjectToVesselDataObjectFilter<TInputVessel,TOutputVessel>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,201 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselRegion.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description : generic node of an acyclic graph structure
+// Date: 2009/02/06
+
+
+#include "ivanVesselRegion.h"
+
+#include <algorithm>
+#include <map>
+
+
+namespace ivan
+{
+
+VesselRegion::VesselRegion()
+{
+
+}
+
+
+VesselRegion::~VesselRegion()
+{
+
+}
+
+
+VesselRegion::VesselRegion( BranchIdType branchId )
+{
+   m_BranchRegions.insert( BranchRegionContainerType::value_type( branchId, VesselRegion::GetFullBranchRange() ) );
+}
+
+
+VesselRegion::VesselRegion( const std::vector<BranchIdType> & branchIds )
+{
+  m_BranchRegions.resize( branchIds.size() );
+  for( unsigned int i=0; i<branchIds.size(); ++i )
+    m_BranchRegions.insert_noresize( BranchRegionContainerType::value_type( branchIds[i], 
+      VesselRegion::GetFullBranchRange() ) );
+}
+
+
+void VesselRegion::Insert( BranchIdType branchId )
+{
+  m_BranchRegions.insert( BranchRegionContainerType::value_type( branchId, VesselRegion::GetFullBranchRange() ) );
+}
+
+  
+void VesselRegion::Insert( BranchIdType branchId, PointIdType startPoint, PointIdType endPoint )
+{
+  m_BranchRegions.insert( BranchRegionContainerType::value_type
+    ( branchId, std::make_pair( startPoint, endPoint ) ) );
+}
+ 
+
+void VesselRegion::Insert( const std::vector<BranchIdType> & branchIds )
+{
+  m_BranchRegions.resize( m_BranchRegions.size() + branchIds.size() );
+  for( unsigned int i=0; i<branchIds.size(); ++i )
+    m_BranchRegions.insert_noresize( BranchRegionContainerType::value_type( branchIds[i], 
+      VesselRegion::GetFullBranchRange() ) );
+}
+
+
+void VesselRegion::MakeConsistent()
+{
+  typedef std::map<BranchIdType,std::vector<BranchRegionType> >  BranchRangesType;
+  
+  BranchRangesType branchRanges;
+  
+  for( BranchRegionContainerType::const_iterator it = m_BranchRegions.begin(); 
+    it != m_BranchRegions.end(); ++it )
+    branchRanges[it->first].push_back( it->second );
+  
+  m_BranchRegions.clear();
+  
+  for( BranchRangesType::iterator it = branchRanges.begin(); it != branchRanges.end(); ++it )
+  {
+    std::vector<BranchRegionType> & ranges = it->second;
+    
+    // The full range covers the others
+    bool full = false;
+    for( unsigned int i=0; i<ranges.size() && !full; ++i )
+      full = IsFullBranchRange( ranges[i] );
+    
+    if( full )
+    {
+      this->Insert( it->first );
+      continue;
+    }
+    
+    // Merge overlapping and adjacent ranges in order of start
+    std::sort( ranges.begin(), ranges.end() );
+    
+    BranchRegionType current = ranges[0];
+    
+    for( unsigned int i=1; i<ranges.size(); ++i )
+    {
+      if( current.second == itk::NumericTraits<PointIdType>::max() || 
+        ranges[i].first <= current.second + 1 )
+      {
+        current.second = std::max( current.second, ranges[i].second );
+      }
+      else
+      {
+        this->Insert( it->first, current.first, current.second );
+        current = ranges[i];
+      }
+    }
+    
+    this->Insert( it->first, current.first, current.second );
+  }
+}
+
+
+void VesselRegion::Union( const Self & region )
+{
+  for( BranchRegionContainerType::const_iterator it = region.m_BranchRegions.begin(); 
+    it != region.m_BranchRegions.end(); ++it )
+    m_BranchRegions.insert( *it );
+  
+  this->MakeConsistent();
+}
+
+
+bool VesselRegion::IsInside( BranchIdType branchId, PointIdType startPoint, PointIdType endPoint ) const
+{
+  const bool full = IsFullBranchRange( BranchRegionType( startPoint, endPoint ) );
+  
+  std::pair<BranchRegionContainerType::const_iterator,BranchRegionContainerType::const_iterator> 
+    range = m_BranchRegions.equal_range( branchId );
+  
+  for( BranchRegionContainerType::const_iterator it = range.first; it != range.second; ++it )
+  {
+    if( IsFullBranchRange( it->second ) )
+      return true;
+    
+    if( !full && it->second.first <= startPoint && endPoint <= it->second.second )
+      return true;
+  }
+  
+  return false;
+}
+
+
+bool VesselRegion::IsInside( const Self & region ) const
+{
+  for( BranchRegionContainerType::const_iterator it = region.m_BranchRegions.begin(); 
+    it != region.m_BranchRegions.end(); ++it )
+  {
+    if( !this->IsInside( it->first, it->second.first, it->second.second ) )
+      return false;
+  }
+  
+  return true;
+}
+
+
+void VesselRegion::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "BranchRegions:" << std::endl;
+  
+  for( BranchRegionContainerType::const_iterator it = m_BranchRegions.begin(); 
+    it != m_BranchRegions.end(); ++it )
+  {
+    os << indent.GetNextIndent() << "Branch " << it->first << ": ";
+    
+    if( IsFullBranchRange( it->second ) )
+      os << "full" << std::endl;
+    else
+      os << "[" << it->second.first << "," << it->second.second << "]" << std::endl;
+  }
+}
+
+} // end namespace ivan
@@ -59,6 +59,9 @@ namespace ivan
  * region (both start and end index inclusive). Several subregions can
  * be defined for each branch.
  *
+ * VesselRegion is also the requested and buffered region of a VesselDataObject, so pipeline
+ * stages can request only some branches or sections of their input.
+ *
  * \ingroup 
  */
  
@@ -133,6 +136,28 @@ public:
   /** Make the defined branch regions consistent, so for each branch there is no overlapping
     * and branch regions become merged accordingly. */
   void MakeConsistent();
+  
+  /** Add the branch regions of another region and make the result consistent. */
+  void Union( const Self & region );
+  
+  /** Check if there are no branch regions. */
+  bool IsEmpty() const
+    { return m_BranchRegions.empty(); }
+  
+  /** Check if a branch has any region. */
+  bool ContainsBranch( BranchIdType branchId ) const
+    { return m_BranchRegions.find( branchId ) != m_BranchRegions.end(); }
+  
+  /** Check if the points [startPoint,endPoint] of a branch are covered by a single branch 
+    * region. The full range is only covered by itself. */
+  bool IsInside( BranchIdType branchId, PointIdType startPoint, PointIdType endPoint ) const;
+  
+  /** Check if all the branch regions of another region are inside this one. */
+  bool IsInside( const Self & region ) const;
+  
+  /** Check if a branch range is the full range of the branch. */
+  static bool IsFullBranchRange( const BranchRegionType & range )
+    { return range.first == itk::NumericTraits<PointIdType>::max(); }
 
   /** Static method that returns a pair specifying the full range of a branch. This is useful
     * since we don't need to know the real size of the branch. */
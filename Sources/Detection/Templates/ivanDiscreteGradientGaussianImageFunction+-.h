@@ -0,0 +1,43 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGradientGaussianImageFunction+-.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: explicit instantiations of DiscreteGradientGaussianImageFunction compiled in ivanDetection
+// Date: 2012/11/05
+
+// Included at the end of ivanDiscreteGradientGaussianImageFunction.h when IVAN_TEMPLATE_EXPLICIT is set, and by 
+// ivanDiscreteGradientGaussianImageFunction+.cxx for the compiled specializations (see ivanExplicitInstantiation.h)
+
+#ifndef __ivanDiscreteGradientGaussianImageFunctionTemplates_h
+#define __ivanDiscreteGradientGaussianImageFunctionTemplates_h
+
+#include "ivanExplicitInstantiation.h"
+
+ITK_TEMPLATE_DiscreteGradientGaussianImageFunction( IVAN_TEMPLATE_INSTANTIATION, IVAN_TEMPLATE_EXPORT_SPEC, 
+  (Templates::ImageF3, double), F3D )
+ITK_TEMPLATE_DiscreteGradientGaussianImageFunction( IVAN_TEMPLATE_INSTANTIATION, IVAN_TEMPLATE_EXPORT_SPEC, 
+  (Templates::ImageSS3, double), SS3D )
+
+#endif
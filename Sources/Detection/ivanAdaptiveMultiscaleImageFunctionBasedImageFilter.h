@@ -0,0 +1,190 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: applies a multiscale image function to an image, refining the evaluation only where the response is not smooth
+// Date: 2012/11/05
+
+#ifndef __ivanAdaptiveMultiscaleImageFunctionBasedImageFilter_h
+#define __ivanAdaptiveMultiscaleImageFunctionBasedImageFilter_h
+
+#include "ivanImageFunctionBasedImageFilter.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class AdaptiveMultiscaleImageFunctionBasedImageFilter
+ *  \brief Applies a multiscale image function to the whole input image, evaluating each scale 
+ *  only at the pixels where its response is not smooth.
+ *
+ * Responses at large scales vary slowly, and evaluating them at every pixel wastes work. In 
+ * adaptive mode, the region of each thread is covered, for each scale, by cells of about 
+ * GridSpacingFactor * scale (in physical units) along each axis. The scaled function is 
+ * evaluated at the corners of each cell, and the cell is split in halves along each axis 
+ * (as in an octree) if the maximum of the corners is above RefinementThreshold or the 
+ * difference between the maximum and the minimum is above RefinementTolerance. Splitting 
+ * continues until cells are one pixel wide, where all the pixels are evaluated, and the pixels
+ * of the cells that are not split are linearly interpolated from their corners. The output
+ * is the maximum over scales, and pixels of the input below Threshold are set to zero, as 
+ * in ImageFunctionBasedImageFilter.
+ *
+ * With the default parameters, cells are only interpolated when the response is zero at all
+ * their corners, as in the background of most vesselness measures.
+ *
+ * TImageFunction must be a MultiscaleImageFunction (or provide GetScales() and 
+ * GetScaledImageFunction()), and is created and initialized with the ImageFunctionInitializer 
+ * as in the superclass. The ScaleSearchMethod of the function is ignored, all the scales are
+ * evaluated. Sparse evaluation is not supported in adaptive mode.
+ *
+ * The scaled functions are evaluated with TScaledEvaluator, in adaptive mode and otherwise, with
+ * the virtual interface by default. With ScaledImageFunctionEvaluator or 
+ * EigenValueVesselnessEvaluator the calls are bound at compile time (see ImageFunctionEvaluator).
+ *
+ * \sa ImageFunctionBasedImageFilter
+ * \sa MultiscaleImageFunction
+ */
+template <class TInputImage, class TOutputImage, class TImageFunction, 
+  class TScaledEvaluator = ImageFunctionEvaluator<typename TImageFunction::ScaledImageFunctionType> >
+class ITK_EXPORT AdaptiveMultiscaleImageFunctionBasedImageFilter : 
+  public ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,
+    StaticMultiscaleImageFunctionEvaluator<TImageFunction,TScaledEvaluator> >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef AdaptiveMultiscaleImageFunctionBasedImageFilter      Self;
+  typedef ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,
+    StaticMultiscaleImageFunctionEvaluator<TImageFunction,TScaledEvaluator> >   Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  typedef typename Superclass::InputImageType          InputImageType;
+  typedef typename Superclass::OutputImageType         OutputImageType;
+  typedef typename Superclass::InputImageIndexType     InputImageIndexType;
+  typedef typename Superclass::OutputImageRegionType   OutputImageRegionType;
+  typedef typename Superclass::ImageFunctionType       ImageFunctionType;
+  
+  typedef typename OutputImageType::PixelType          OutputPixelType;
+  typedef typename ImageFunctionType::ScaledImageFunctionType   ScaledImageFunctionType;
+  
+  /** Type of the responses of the scaled functions. */
+  typedef typename ScaledImageFunctionType::OutputType          ResponseType;
+  
+  /** Evaluation policy of the scaled functions. */
+  typedef TScaledEvaluator                                      ScaledEvaluatorType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, Superclass::ImageDimension );
+       
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( AdaptiveMultiscaleImageFunctionBasedImageFilter, ImageFunctionBasedImageFilter );
+  
+  /** Set/Get the flag for adaptive evaluation. If off, the multiscale function is evaluated at 
+    * every pixel as in the superclass. On by default. */
+  itkSetMacro( AdaptiveEvaluation, bool );
+  itkGetConstMacro( AdaptiveEvaluation, bool );
+  itkBooleanMacro( AdaptiveEvaluation );
+  
+  /** Set/Get the size of the initial cells relative to the scale. Default is 1. */
+  itkSetMacro( GridSpacingFactor, double );
+  itkGetConstMacro( GridSpacingFactor, double );
+  
+  /** Set/Get the response above which cells are refined. Default is zero. */
+  itkSetMacro( RefinementThreshold, double );
+  itkGetConstMacro( RefinementThreshold, double );
+  
+  /** Set/Get the variation of the response among the corners of a cell above which it is 
+    * refined. Default is the maximum double, which disables this criterion. */
+  itkSetMacro( RefinementTolerance, double );
+  itkGetConstMacro( RefinementTolerance, double );
+  
+  /** Get the number of evaluations of the scaled functions in the last execution. */
+  unsigned long GetNumberOfScaledEvaluations() const;
+  
+  /** Get the fraction of the evaluations of an exhaustive evaluation (every scale at every 
+    * pixel of the output region) done in the last execution. */
+  double GetEvaluationRatio() const;
+  
+protected:
+
+  AdaptiveMultiscaleImageFunctionBasedImageFilter();
+  ~AdaptiveMultiscaleImageFunctionBasedImageFilter() {};
+  
+  /** Check the parameters and reset the evaluation counters. */
+  virtual void BeforeThreadedGenerateData();
+  
+  /** Evaluate the scales adaptively in the given region. */
+  virtual unsigned long GenerateDataInRegion( const OutputImageRegionType& region, int threadId );
+  
+  /** Responses of a scale in a region, and whether each was evaluated or interpolated. */
+  struct ScaleResponses
+  {
+    const ScaledImageFunctionType   *Function;
+    long                             Index[ImageDimension];
+    long                             Size[ImageDimension];
+    long                             Stride[ImageDimension];
+    std::vector<ResponseType>        Values;
+    std::vector<unsigned char>       Evaluated;
+    unsigned long                    NumberOfEvaluations;
+  };
+  
+  /** Get the response at the given index of the region, evaluating it if necessary. */
+  ResponseType EvaluateNode( ScaleResponses & responses, const long *index ) const;
+  
+  /** Evaluate the corners of the cell [first,last] and refine or interpolate it. */
+  void ProcessCell( ScaleResponses & responses, const long *first, const long *last ) const;
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  AdaptiveMultiscaleImageFunctionBasedImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  bool                          m_AdaptiveEvaluation;
+  double                        m_GridSpacingFactor;
+  double                        m_RefinementThreshold;
+  double                        m_RefinementTolerance;
+  
+  /** Evaluations of the scaled functions done by each thread. */
+  std::vector<unsigned long>    m_ThreadScaledEvaluations;
+};
+  
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.hxx"
+#endif
+  
+#endif
@@ -0,0 +1,387 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: applies a multiscale image function to an image, refining the evaluation only where the response is not smooth
+// Date: 2012/11/05
+
+#ifndef __ivanAdaptiveMultiscaleImageFunctionBasedImageFilter_hxx
+#define __ivanAdaptiveMultiscaleImageFunctionBasedImageFilter_hxx
+
+#include "ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::AdaptiveMultiscaleImageFunctionBasedImageFilter() :
+  m_AdaptiveEvaluation( true ),
+  m_GridSpacingFactor( 1.0 ),
+  m_RefinementThreshold( 0.0 ),
+  m_RefinementTolerance( itk::NumericTraits<double>::max() )
+{
+
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+void 
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::BeforeThreadedGenerateData()
+{
+  if( this->m_AdaptiveEvaluation && this->m_SparseEvaluation )
+  {
+    itkExceptionMacro( "Sparse evaluation is not supported in adaptive mode." );
+  }
+  
+  if( this->m_GridSpacingFactor <= 0.0 )
+  {
+    itkExceptionMacro( "GridSpacingFactor must be positive." );
+  }
+  
+  Superclass::BeforeThreadedGenerateData();
+  
+  this->m_ThreadScaledEvaluations.assign( this->GetNumberOfThreads(), 0 );
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+unsigned long
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::GetNumberOfScaledEvaluations() const
+{
+  unsigned long total = 0;
+  
+  for( unsigned int i=0; i<this->m_ThreadScaledEvaluations.size(); ++i )
+    total += this->m_ThreadScaledEvaluations[i];
+    
+  return total;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+double
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::GetEvaluationRatio() const
+{
+  if( this->m_ImageFunctionContainer.empty() )
+    return 0.0;
+  
+  const double exhaustive = static_cast<double>( this->m_ImageFunctionContainer[0]->GetScales().size() ) *
+    static_cast<double>( this->m_TotalPixels );
+    
+  return ( exhaustive > 0.0 ) ? this->GetNumberOfScaledEvaluations() / exhaustive : 0.0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+typename AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>::ResponseType
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::EvaluateNode( ScaleResponses & responses, const long *index ) const
+{
+  long offset = 0;
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    offset += ( index[d] - responses.Index[d] ) * responses.Stride[d];
+  
+  if( !responses.Evaluated[offset] )
+  {
+    InputImageIndexType imageIndex;
+    for( unsigned int d=0; d<ImageDimension; ++d )
+      imageIndex[d] = index[d];
+    
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_EvaluateProbe );
+    responses.Values[offset] = ScaledEvaluatorType::EvaluateAtIndex( responses.Function, imageIndex );
+    responses.Evaluated[offset] = 1;
+    ++responses.NumberOfEvaluations;
+  }
+  
+  return responses.Values[offset];
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+void
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::ProcessCell( ScaleResponses & responses, const long *first, const long *last ) const
+{
+  const unsigned int numberOfCorners = 1 << ImageDimension;
+  
+  // Evaluate the corners, the bit d of the corner selects the last index along axis d
+  ResponseType corners[1 << ImageDimension];
+  long index[ImageDimension];
+  
+  bool isLeaf = true;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    if( last[d] - first[d] > 1 )
+      isLeaf = false;
+  }
+  
+  for( unsigned int c=0; c<numberOfCorners; ++c )
+  {
+    for( unsigned int d=0; d<ImageDimension; ++d )
+      index[d] = ( c & ( 1 << d ) ) ? last[d] : first[d];
+    
+    corners[c] = this->EvaluateNode( responses, index );
+  }
+  
+  // All the pixels of the cell are corners
+  if( isLeaf )
+    return;
+  
+  const ResponseType maximum = *std::max_element( corners, corners + numberOfCorners );
+  const ResponseType minimum = *std::min_element( corners, corners + numberOfCorners );
+  
+  if( maximum > this->m_RefinementThreshold || maximum - minimum > this->m_RefinementTolerance )
+  {
+    // Split in halves along the axes wider than one pixel
+    long middle[ImageDimension];
+    unsigned int splitMask = 0;
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      middle[d] = ( first[d] + last[d] ) / 2;
+      
+      if( last[d] - first[d] > 1 )
+        splitMask |= ( 1 << d );
+    }
+    
+    long childFirst[ImageDimension], childLast[ImageDimension];
+    
+    for( unsigned int c=0; c<numberOfCorners; ++c )
+    {
+      if( c & ~splitMask )
+        continue;
+      
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        if( !( splitMask & ( 1 << d ) ) )
+        {
+          childFirst[d] = first[d];
+          childLast[d] = last[d];
+        }
+        else if( c & ( 1 << d ) )
+        {
+          childFirst[d] = middle[d];
+          childLast[d] = last[d];
+        }
+        else
+        {
+          childFirst[d] = first[d];
+          childLast[d] = middle[d];
+        }
+      }
+      
+      this->ProcessCell( responses, childFirst, childLast );
+    }
+    
+    return;
+  }
+  
+  // Interpolate the pixels of the cell not evaluated yet, which are not overwritten later 
+  // since evaluated values are always kept
+  std::copy( first, first + ImageDimension, index );
+  
+  while( true )
+  {
+    long offset = 0;
+    for( unsigned int d=0; d<ImageDimension; ++d )
+      offset += ( index[d] - responses.Index[d] ) * responses.Stride[d];
+    
+    if( !responses.Evaluated[offset] )
+    {
+      double value = 0.0;
+      
+      for( unsigned int c=0; c<numberOfCorners; ++c )
+      {
+        double weight = 1.0;
+        
+        for( unsigned int d=0; d<ImageDimension; ++d )
+        {
+          const double t = ( last[d] > first[d] ) ? 
+            static_cast<double>( index[d] - first[d] ) / static_cast<double>( last[d] - first[d] ) : 0.0;
+          weight *= ( c & ( 1 << d ) ) ? t : 1.0 - t;
+        }
+        
+        value += weight * corners[c];
+      }
+      
+      responses.Values[offset] = static_cast<ResponseType>( value );
+    }
+    
+    unsigned int d = 0;
+    for( ; d<ImageDimension; ++d )
+    {
+      if( ++index[d] <= last[d] )
+        break;
+      
+      index[d] = first[d];
+    }
+    
+    if( d == ImageDimension )
+      break;
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+unsigned long
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::GenerateDataInRegion( const OutputImageRegionType& region, int threadId )
+{
+  if( !this->m_AdaptiveEvaluation )
+    return Superclass::GenerateDataInRegion( region, threadId );
+  
+  const ImageFunctionType *imageFunction = this->m_ImageFunctionContainer[threadId];
+  const typename InputImageType::SpacingType & spacing = this->GetInput()->GetSpacing();
+  
+  const unsigned long numberOfPixels = region.GetNumberOfPixels();
+  
+  if( !numberOfPixels )
+    return 0;
+  
+  ScaleResponses responses;
+  long stride = 1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    responses.Index[d] = region.GetIndex()[d];
+    responses.Size[d] = static_cast<long>( region.GetSize()[d] );
+    responses.Stride[d] = stride;
+    stride *= responses.Size[d];
+  }
+  
+  // Maximum over scales
+  std::vector<ResponseType> maximum( numberOfPixels );
+  unsigned long scaledEvaluations = 0;
+  
+  const unsigned int numberOfScales = imageFunction->GetScales().size();
+  
+  for( unsigned int i=0; i<numberOfScales; ++i )
+  {
+    responses.Function = imageFunction->GetScaledImageFunction( i );
+    responses.Values.assign( numberOfPixels, itk::NumericTraits<ResponseType>::Zero );
+    responses.Evaluated.assign( numberOfPixels, 0 );
+    responses.NumberOfEvaluations = 0;
+    
+    // Nodes of the initial cells along each axis, the last index of the region always included
+    long cellSize[ImageDimension], numberOfCells[ImageDimension];
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      cellSize[d] = std::max( 1L, static_cast<long>( this->m_GridSpacingFactor * 
+        imageFunction->GetScales()[i] / spacing[d] ) );
+      numberOfCells[d] = std::max( 1L, ( responses.Size[d] - 1 + cellSize[d] - 1 ) / cellSize[d] );
+    }
+    
+    long cell[ImageDimension], first[ImageDimension], last[ImageDimension];
+    std::fill( cell, cell + ImageDimension, 0L );
+    
+    while( true )
+    {
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        first[d] = responses.Index[d] + cell[d] * cellSize[d];
+        last[d] = std::min( first[d] + cellSize[d], responses.Index[d] + responses.Size[d] - 1 );
+      }
+      
+      this->ProcessCell( responses, first, last );
+      
+      unsigned int d = 0;
+      for( ; d<ImageDimension; ++d )
+      {
+        if( ++cell[d] < numberOfCells[d] )
+          break;
+        
+        cell[d] = 0;
+      }
+      
+      if( d == ImageDimension )
+        break;
+    }
+    
+    for( unsigned long p=0; p<numberOfPixels; ++p )
+    {
+      if( i == 0 || responses.Values[p] > maximum[p] )
+        maximum[p] = responses.Values[p];
+    }
+    
+    scaledEvaluations += responses.NumberOfEvaluations;
+  }
+  
+  this->m_ThreadScaledEvaluations[threadId] += scaledEvaluations;
+  
+  // Copy to the output, keeping the pixels below the threshold at zero
+  typedef itk::ImageRegionConstIterator<InputImageType>   ConstIteratorType;
+  typedef itk::ImageRegionIterator<OutputImageType>       IteratorType;
+  
+  ConstIteratorType it( this->GetInput(), region );
+  IteratorType      oit( this->GetOutput(), region );
+  
+  unsigned long evaluatedPixels = 0;
+  unsigned long p = 0;
+  
+  for( it.GoToBegin(), oit.GoToBegin(); !it.IsAtEnd(); ++it, ++oit, ++p )
+  {
+    if( it.Get() > this->m_Threshold )
+    {
+      oit.Set( static_cast<OutputPixelType>( maximum[p] ) );
+      ++evaluatedPixels;
+    }
+    else
+      oit.Set( itk::NumericTraits<OutputPixelType>::Zero );
+  }
+  
+  this->ReportProgress( threadId, numberOfPixels );
+  
+  return evaluatedPixels;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TScaledEvaluator>
+void
+AdaptiveMultiscaleImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TScaledEvaluator>
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "AdaptiveEvaluation: " << this->m_AdaptiveEvaluation << std::endl;
+  os << indent << "GridSpacingFactor: " << this->m_GridSpacingFactor << std::endl;
+  os << indent << "RefinementThreshold: " << this->m_RefinementThreshold << std::endl;
+  os << indent << "RefinementTolerance: " << this->m_RefinementTolerance << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -30,7 +30,9 @@ SUCH DAMAGE.
 #ifndef __ivanCircularSectionFluxImageFunction_h
 #define __ivanCircularSectionFluxImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanFluxBasedVesselnessImageFunction.h"
+#include "ivanCircleSampler.h"
 
 
 namespace ivan
@@ -44,6 +46,11 @@ namespace ivan
  * a vesselness feature. A non-linear penalization can be used in order to reduce the contribution 
  * of non-assymetric flux to the final response. 
  *
+ * Callers that have already computed the Hessian at a point (or the section plane, for instance
+ * from the eigenvectors of an oriented flux matrix) may use EvaluateWithHessian() or 
+ * EvaluateInSection() so that the Hessian is not computed again. All evaluation methods keep 
+ * their temporaries on the stack, so they can be called concurrently from several threads.
+ *
  * The Initialize() method must be called after setting the parameters and before
  * evaluating the function.
  *
@@ -91,6 +98,10 @@ public:
   typedef typename Superclass::InterpolationModeType     InterpolationModeType;
     
   typedef itk::Vector<double,InputImageType::ImageDimension>   VectorType;
+  
+  /** Generation of the circle samples. */
+  typedef CircleSampler<InputImageType>                        CircleSamplerType;
+  typedef typename CircleSamplerType::SampleSet                CircleSampleSetType;
     
   enum NonLinearFluxFunction
   {
@@ -131,6 +142,27 @@ public:
   itkSetMacro( NonLinearFluxFunction, NonLinearFluxFunction );
   itkGetConstMacro( NonLinearFluxFunction, NonLinearFluxFunction );
   
+  /** Set/Get the number of circle samples ahead whose neighborhoods are prefetched while 
+    * evaluating each sample (see CircleSampler::SetPrefetchDistance()). This helps when the 
+    * image does not fit in the cache. Zero disables prefetching. Default is 0. */
+  void SetPrefetchDistance( unsigned int distance )
+    { this->m_CircleSampler.SetPrefetchDistance( distance ); }
+  unsigned int GetPrefetchDistance() const
+    { return this->m_CircleSampler.GetPrefetchDistance(); }
+  
+  /** Set the input image. Reimplemented to set the image of the circle sampler. */
+  virtual void SetInputImage( const InputImageType * ptr );
+  
+  /** Evaluate the flux at a physical point given the Hessian matrix at that point, previously 
+    * computed by the caller with the same scale. The section plane is given by the eigenvectors 
+    * of the two lowest eigenvalues. */
+  OutputType EvaluateWithHessian( const HessianTensorType & hessian, const PointType & point ) const;
+  
+  /** Evaluate the flux at a physical point in the section plane given by two orthonormal 
+    * vectors. No Hessian is computed. */
+  OutputType EvaluateInSection( const PointType & point, const VectorType & firstBaseVector,
+    const VectorType & secondBaseVector ) const;
+  
 protected:
 
   CircularSectionFluxImageFunction();
@@ -165,9 +197,8 @@ protected:
   /** Defines how the opposite circular values are combined when using NonLinearFlux. */
   NonLinearFluxFunction  m_NonLinearFluxFunction;
   
-  /** Cached angular values. */
-  itk::Array<double>     m_CosArray;
-  itk::Array<double>     m_SinArray;
+  /** Circle sampler, with cached angular values. */
+  CircleSamplerType      m_CircleSampler;
 };
 
 } // namespace ivan
@@ -179,7 +210,7 @@ protected:
                                                   CircularSectionFluxImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanCircularSectionFluxImageFunction+-.h"
 #endif
 
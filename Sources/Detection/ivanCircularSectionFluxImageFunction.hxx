@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #define __ivanCircularSectionFluxImageFunction_hxx
 
 #include "ivanCircularSectionFluxImageFunction.h"
+#include "ivanSymmetricEigenSolver.h"
 
 #include "itkNumericTraits.h"
 
@@ -72,6 +73,7 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
   os << indent << "UseNonLinearFlux: " << m_UseNonLinearFlux << std::endl;
   os << indent << "NonLinearFluxFunction: " << m_NonLinearFluxFunction << std::endl;
   os << indent << "RadialResolution: " << m_RadialResolution << std::endl;
+  os << indent << "PrefetchDistance: " << this->GetPrefetchDistance() << std::endl;
 }
 
 
@@ -143,8 +145,6 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
   if( this->m_Sigma == sigma )
     return;
     
-  this->m_Sigma = sigma;
-
   Superclass::SetSigma( sigma );
     
   if( this->GetAdaptativeSampling() )
@@ -155,6 +155,17 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
 }
 
 
+template <class TInputImage, class TOutput>
+void
+CircularSectionFluxImageFunction<TInputImage,TOutput>
+::SetInputImage( const InputImageType * ptr )
+{
+  Superclass::SetInputImage( ptr );
+  
+  this->m_CircleSampler.SetImage( ptr );
+}
+
+
 template <class TInputImage, class TOutput>
 void
 CircularSectionFluxImageFunction<TInputImage,TOutput>
@@ -166,21 +177,8 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
       ( vnl_math_rnd( 2.0 * vnl_math::pi * this->m_Sigma + 1.0 ) );
   }
   
-  // Set the size of the arrays for storing radial boundariness values depending on the number of samples
-  m_SinArray.SetSize( this->m_RadialResolution );
-  m_CosArray.SetSize( this->m_RadialResolution );
-    
   // Precalculate sin and cos values as these calculations are costly
-  
-  double angle = 0.0;
-  double angleInc = vnl_math::pi * 2.0 / static_cast<double>( this->m_RadialResolution ); 
-  
-  for ( unsigned int i=0; i < this->m_RadialResolution; ++i )
-  {
-    m_SinArray[i] = sin( angle );
-    m_CosArray[i] = cos( angle );
-    angle += angleInc;
-  }  
+  this->m_CircleSampler.SetNumberOfSamples( this->m_RadialResolution );
 }
 
 
@@ -189,6 +187,20 @@ typename CircularSectionFluxImageFunction<TInputImage,TOutput>::OutputType
 CircularSectionFluxImageFunction<TInputImage,TOutput>
 ::EvaluateVesselnessAtContinuousIndex( const HessianTensorType & hessian,
   const ContinuousIndexType & cindex ) const
+{
+  PointType currentPoint;
+  
+  // Get the physical coordinates of the current index
+  this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( cindex, currentPoint );
+  
+  return this->EvaluateWithHessian( hessian, currentPoint );
+}
+
+
+template <class TInputImage, class TOutput>
+typename CircularSectionFluxImageFunction<TInputImage,TOutput>::OutputType
+CircularSectionFluxImageFunction<TInputImage,TOutput>
+::EvaluateWithHessian( const HessianTensorType & hessian, const PointType & point ) const
 {
   typedef typename HessianTensorType::EigenVectorsMatrixType EigenVectorsMatrixType;
   typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
@@ -197,10 +209,7 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
   EigenValuesArrayType   eigenValues;
   
   // We need the arrays in the form of an itk::Vector
-  VectorType  firstEigenVector, secondEigenVector, thirdEigenVector;
-  
-  // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
-  hessian.ComputeEigenAnalysis( eigenValues, eigenVectors );
+  VectorType  firstEigenVector, secondEigenVector;
   
   // Check that the hessian matrix is not a zero matrix. This avoids problems with NaN eigenvalues and eigenvectors
   double trace = 0.0;
@@ -227,50 +236,62 @@ CircularSectionFluxImageFunction<TInputImage,TOutput>
   
   if( zeroTrace )
   	return itk::NumericTraits<OutputType>::Zero;
+  
+  // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenAnalysis( hessian, eigenValues, eigenVectors );
     
   // Recover eigenvectors from the matrix (first two rows)
   for( unsigned int i=0; i < TInputImage::GetImageDimension(); ++i )
   {
     firstEigenVector[i]  = eigenVectors( 0, i );
     secondEigenVector[i] = eigenVectors( 1, i );
-    thirdEigenVector[i]  = eigenVectors( 2, i );
   }
   
-  
-  // Now comes the vesselness calculation
-  
-  unsigned int        calculatedSamples = 0; // samples calculated for each circle
-  PointType           currentPoint, currentCirclePoint;
+  return this->EvaluateInSection( point, firstEigenVector, secondEigenVector );
+}
+
+
+template <class TInputImage, class TOutput>
+typename CircularSectionFluxImageFunction<TInputImage,TOutput>::OutputType
+CircularSectionFluxImageFunction<TInputImage,TOutput>
+::EvaluateInSection( const PointType & point, const VectorType & firstBaseVector,
+  const VectorType & secondBaseVector ) const
+{
+  ContinuousIndexType currentCircleIndex;
   OutputType          finalFlux = 0.0;
-  itk::Array<double>  radialFlux;
   const double        radius = this->m_RadiusFactor * this->m_Sigma;
-    
-  radialFlux.SetSize( this->m_RadialResolution );
   
-  typedef typename GradientFunctionType::OutputType VectorType;
+  // Stores the flux values in the circle, on the stack  
+  ScratchArray<double,CircleSamplerType::SampleSetCapacity> radialFlux( this->m_RadialResolution );
+  
   VectorType gradientVector, inwardVector;
   
-  // Get the physical coordinates of the current index
-  this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( cindex, currentPoint );
+  // Calculate the points of the circle defined by the two base vectors, all at once and in index space
+  CircleSampleSetType circleSamples( this->m_RadialResolution );
+  this->m_CircleSampler.Sample( point, radius, firstBaseVector, secondBaseVector, circleSamples );
   
-  // In this case we evaluate at the center only once
-  //gradientVector = this->m_GradientFunction->Evaluate( currentPoint );
+  const double *cosArray = &this->m_CircleSampler.GetCosArray()[0];
+  const double *sinArray = &this->m_CircleSampler.GetSinArray()[0];
   
-  // Calculate flux values in a circle defined by the two eigenvectors
+  // Neighborhoods of the gradient function, the gradient image is not prefetched
+  const unsigned int prefetchRadius = ( this->m_UseGradientImage || !this->GetPrefetchDistance() ) ? 0 :
+    this->m_CircleSampler.ComputeNeighborhoodRadius( this->m_Sigma );
+  
+  // Calculate flux values in the circle
   for( unsigned int i=0; i<this->m_RadialResolution; ++i )
   {
     radialFlux[i] = 0.0;
     
-    for( unsigned int k=0; k<TInputImage::ImageDimension; ++k )
-    {
-      currentCirclePoint[k] = currentPoint[k] + radius * 
-        ( this->m_CosArray[i] * firstEigenVector[k] + this->m_SinArray[i] * secondEigenVector[k] );
-      inwardVector[k] = -this->m_CosArray[i] * firstEigenVector[k] - this->m_SinArray[i] * secondEigenVector[k];
-    }
+    if( !this->m_UseGradientImage )
+      this->m_CircleSampler.Prefetch( circleSamples, i, prefetchRadius );
     
-    if( this->m_GradientFunction->IsInsideBuffer( currentCirclePoint ) )
+    if( circleSamples.IsInside( i ) )
     {
-      gradientVector = this->m_GradientFunction->Evaluate( currentCirclePoint );
+      for( unsigned int k=0; k<TInputImage::ImageDimension; ++k )
+        inwardVector[k] = -cosArray[i] * firstBaseVector[k] - sinArray[i] * secondBaseVector[k];
+      
+      circleSamples.GetContinuousIndex( i, currentCircleIndex );
+      this->EvaluateGradientAtContinuousIndex( currentCircleIndex, gradientVector );
       
       for( unsigned int k=0; k<TInputImage::ImageDimension; ++k )
         radialFlux[i] += gradientVector[k] * inwardVector[k];
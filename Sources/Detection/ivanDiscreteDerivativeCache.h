@@ -0,0 +1,267 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteDerivativeCache.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe cache of discrete derivative values indexed by scale and pixel index
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteDerivativeCache_h
+#define __ivanDiscreteDerivativeCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIndex.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkFixedArray.h"
+#include "itkVector.h"
+#include "itkCovariantVector.h"
+#include "itkSymmetricSecondRankTensor.h"
+
+#include "ivanHalfFloat.h"
+
+#include <map>
+#include <deque>
+
+
+namespace ivan
+{
+/** Access to the real components of the values stored in a DiscreteDerivativeCache, used for 
+  * half-precision storage. The generic version is for scalar values. */
+template <class TValue>
+struct DiscreteDerivativeCacheComponents
+{
+  itkStaticConstMacro( NumberOfComponents, unsigned int, 1 );
+  
+  static void ToFloat( const TValue& value, float *components )
+    { components[0] = static_cast<float>( value ); }
+  
+  static void FromFloat( const float *components, TValue& value )
+    { value = static_cast<TValue>( components[0] ); }
+};
+
+
+/** Components of fixed arrays and the derived vectors and tensors. */
+template <class TComponent, unsigned int VLength>
+struct DiscreteDerivativeCacheArrayComponents
+{
+  itkStaticConstMacro( NumberOfComponents, unsigned int, VLength );
+  
+  template <class TArray>
+  static void ToFloat( const TArray& value, float *components )
+    {
+      for( unsigned int i=0; i<VLength; ++i )
+        components[i] = static_cast<float>( value[i] );
+    }
+  
+  template <class TArray>
+  static void FromFloat( const float *components, TArray& value )
+    {
+      for( unsigned int i=0; i<VLength; ++i )
+        value[i] = static_cast<TComponent>( components[i] );
+    }
+};
+
+
+template <class TComponent, unsigned int VLength>
+struct DiscreteDerivativeCacheComponents< itk::FixedArray<TComponent,VLength> > :
+  public DiscreteDerivativeCacheArrayComponents<TComponent,VLength> {};
+
+template <class TComponent, unsigned int VLength>
+struct DiscreteDerivativeCacheComponents< itk::Vector<TComponent,VLength> > :
+  public DiscreteDerivativeCacheArrayComponents<TComponent,VLength> {};
+
+template <class TComponent, unsigned int VLength>
+struct DiscreteDerivativeCacheComponents< itk::CovariantVector<TComponent,VLength> > :
+  public DiscreteDerivativeCacheArrayComponents<TComponent,VLength> {};
+
+/** Only the upper triangle of symmetric tensors is stored. */
+template <class TComponent, unsigned int VDimension>
+struct DiscreteDerivativeCacheComponents< itk::SymmetricSecondRankTensor<TComponent,VDimension> > :
+  public DiscreteDerivativeCacheArrayComponents<TComponent,VDimension*(VDimension+1)/2> {};
+
+
+/**
+ * \class DiscreteDerivativeCache
+ * \brief Thread-safe cache that stores derivative values (gradient vectors, Hessian matrices...)
+ * computed at given pixel indices and scales.
+ *
+ * Image functions such as DiscreteHessianGaussianImageFunction or DiscreteGradientGaussianImageFunction
+ * may share one of these caches so the same convolution at the same point and scale is only computed 
+ * once. This is useful in tracking, where the same voxels are revisited many times. 
+ *
+ * A cache must only be shared between functions that use the same input image and the same
+ * parameters other than the scale. The cache stores at most MaximumNumberOfEntries values. When this 
+ * number is exceeded, the oldest entries are evicted first.
+ *
+ * Multiscale caches of gradients and Hessians (3 and 6 components per voxel and scale) quickly 
+ * take a large part of the memory. With HalfPrecisionStorage on, the components are stored as
+ * HalfFloat, which takes a quarter of the bytes of a double, and widened to float when found. 
+ * The relative error of each component is then at most HalfFloat::GetMaximumRelativeError() 
+ * (about 5e-4), which hardly changes the vesselness measures computed from the values. 
+ * Components larger than HalfFloat::GetMaximumValue() (65504) are not representable, so this is 
+ * only suitable for derivatives of normalized or scale-normalized images. Changing the storage 
+ * clears the cache.
+ *
+ * This class is templated over the type of the cached value and the image dimension.
+ *
+ * \sa DiscreteHessianGaussianImageFunction
+ * \sa DiscreteGradientGaussianImageFunction
+ */
+template <class TValue, unsigned int VImageDimension>
+class ITK_EXPORT DiscreteDerivativeCache : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef DiscreteDerivativeCache         Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( DiscreteDerivativeCache, Object );
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VImageDimension );
+  
+  typedef TValue                                  ValueType;
+  typedef itk::Index<VImageDimension>             IndexType;
+  
+  /** Key of the cached values. */
+  struct KeyType
+  {
+    double      Scale;
+    IndexType   Index;
+  };
+  
+  /** Strict weak ordering of keys, first by scale then lexicographically by index. */
+  struct KeyCompare
+  {
+    bool operator()( const KeyType& a, const KeyType& b ) const
+      {
+        if( a.Scale != b.Scale )
+          return a.Scale < b.Scale;
+        
+        for( unsigned int i=0; i<VImageDimension; ++i )
+        {
+          if( a.Index[i] != b.Index[i] )
+            return a.Index[i] < b.Index[i];
+        }
+        
+        return false;
+      }
+  };
+  
+  typedef DiscreteDerivativeCacheComponents<ValueType>   ComponentsType;
+  
+  itkStaticConstMacro( NumberOfComponents, unsigned int, ComponentsType::NumberOfComponents );
+  
+  /** Stored value in half-precision storage. */
+  struct HalfValueType
+  {
+    HalfFloat   Components[NumberOfComponents];
+  };
+  
+  typedef std::map<KeyType,ValueType,KeyCompare>      ValueContainerType;
+  typedef std::map<KeyType,HalfValueType,KeyCompare>  HalfValueContainerType;
+  typedef std::deque<KeyType>                         KeyQueueType;
+  
+public:
+  
+  /** Set/Get the maximum number of values stored. Zero means no limit. Default is 1000000. */
+  virtual void SetMaximumNumberOfEntries( unsigned long maximum );
+  itkGetConstMacro( MaximumNumberOfEntries, unsigned long );
+  
+  /** Set/Get whether the values are stored in half precision. Clears the cache when changed. 
+    * Default is off. */
+  virtual void SetHalfPrecisionStorage( bool half );
+  itkGetConstMacro( HalfPrecisionStorage, bool );
+  itkBooleanMacro( HalfPrecisionStorage );
+  
+  /** Look for the value at the given scale and index. Returns true if found. */
+  bool Find( double scale, const IndexType& index, ValueType& value ) const;
+  
+  /** Store the value at the given scale and index. */
+  void Insert( double scale, const IndexType& index, const ValueType& value );
+  
+  /** Remove all values. */
+  void Clear();
+  
+  /** Get the current number of values stored. */
+  unsigned long GetNumberOfEntries() const;
+  
+  /** Get an estimate of the memory taken by the stored values, their keys and the containers, 
+    * in bytes. */
+  unsigned long GetMemorySize() const;
+  
+  /** Get the number of successful and unsuccessful calls to Find(). */
+  unsigned long GetNumberOfHits() const
+    { return m_NumberOfHits; }
+  unsigned long GetNumberOfMisses() const
+    { return m_NumberOfMisses; }
+  
+protected:
+
+  DiscreteDerivativeCache();
+  ~DiscreteDerivativeCache() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Evict the oldest values until the maximum number of entries is satisfied. 
+    * The mutex must be locked by the caller. */
+  void Evict();
+  
+private:
+
+  DiscreteDerivativeCache( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  ValueContainerType        m_Values;
+  HalfValueContainerType    m_HalfValues;
+  
+  /** Keys in order of insertion, used for eviction. */
+  KeyQueueType          m_InsertionQueue;
+  
+  unsigned long         m_MaximumNumberOfEntries;
+  bool                  m_HalfPrecisionStorage;
+  
+  mutable unsigned long   m_NumberOfHits;
+  mutable unsigned long   m_NumberOfMisses;
+  
+  /** Mutex for accessing the containers from several threads. */
+  mutable itk::SimpleFastMutexLock    m_Mutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanDiscreteDerivativeCache.hxx"
+#endif
+
+#endif
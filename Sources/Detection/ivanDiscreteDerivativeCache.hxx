@@ -0,0 +1,250 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteDerivativeCache.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe cache of discrete derivative values indexed by scale and pixel index
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteDerivativeCache_hxx
+#define __ivanDiscreteDerivativeCache_hxx
+
+#include "ivanDiscreteDerivativeCache.h"
+
+namespace ivan
+{
+
+template <class TValue, unsigned int VImageDimension>
+DiscreteDerivativeCache<TValue,VImageDimension>
+::DiscreteDerivativeCache() :
+  m_MaximumNumberOfEntries( 1000000 ),
+  m_HalfPrecisionStorage( false ),
+m_NumberOfHits( 0 ),
+  m_NumberOfMisses( 0 )
+{
+
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::SetMaximumNumberOfEntries( unsigned long maximum )
+{
+  m_Mutex.Lock();
+  this->m_MaximumNumberOfEntries = maximum;
+  this->Evict();
+  m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::SetHalfPrecisionStorage( bool half )
+{
+  if( this->m_HalfPrecisionStorage == half )
+    return;
+  
+  m_Mutex.Lock();
+  m_Values.clear();
+  m_HalfValues.clear();
+  m_InsertionQueue.clear();
+  this->m_HalfPrecisionStorage = half;
+  m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+bool
+DiscreteDerivativeCache<TValue,VImageDimension>
+::Find( double scale, const IndexType& index, ValueType& value ) const
+{
+  KeyType key;
+  key.Scale = scale;
+  key.Index = index;
+  
+  bool found = false;
+  
+  m_Mutex.Lock();
+  
+  if( m_HalfPrecisionStorage )
+  {
+    typename HalfValueContainerType::const_iterator it = m_HalfValues.find( key );
+    
+    if( it != m_HalfValues.end() )
+    {
+      float components[NumberOfComponents];
+      HalfFloat::ConvertToFloat( it->second.Components, NumberOfComponents, components );
+      ComponentsType::FromFloat( components, value );
+      found = true;
+    }
+  }
+  else
+  {
+    typename ValueContainerType::const_iterator it = m_Values.find( key );
+    
+    if( it != m_Values.end() )
+    {
+      value = it->second;
+      found = true;
+    }
+  }
+  
+  if( found )
+    ++m_NumberOfHits;
+  else
+    ++m_NumberOfMisses;
+    
+  m_Mutex.Unlock();
+  
+  return found;
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::Insert( double scale, const IndexType& index, const ValueType& value )
+{
+  KeyType key;
+  key.Scale = scale;
+  key.Index = index;
+  
+  m_Mutex.Lock();
+  
+  bool inserted;
+  
+  if( m_HalfPrecisionStorage )
+  {
+    float components[NumberOfComponents];
+    ComponentsType::ToFloat( value, components );
+    
+    HalfValueType halfValue;
+    HalfFloat::ConvertFromFloat( components, NumberOfComponents, halfValue.Components );
+    
+    inserted = m_HalfValues.insert( typename HalfValueContainerType::value_type( key, halfValue ) ).second;
+  }
+  else
+    inserted = m_Values.insert( typename ValueContainerType::value_type( key, value ) ).second;
+  
+  // Another thread may have inserted the same value meanwhile
+  if( inserted )
+  {
+    m_InsertionQueue.push_back( key );
+    this->Evict();
+  }
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::Evict()
+{
+  if( !m_MaximumNumberOfEntries )
+    return;
+  
+  // Only the container of the current storage holds values
+  while( m_InsertionQueue.size() > m_MaximumNumberOfEntries )
+  {
+    if( m_HalfPrecisionStorage )
+      m_HalfValues.erase( m_InsertionQueue.front() );
+    else
+      m_Values.erase( m_InsertionQueue.front() );
+    
+    m_InsertionQueue.pop_front();
+  }
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::Clear()
+{
+  m_Mutex.Lock();
+  
+  m_Values.clear();
+  m_HalfValues.clear();
+  m_InsertionQueue.clear();
+  m_NumberOfHits = 0;
+  m_NumberOfMisses = 0;
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+unsigned long
+DiscreteDerivativeCache<TValue,VImageDimension>
+::GetNumberOfEntries() const
+{
+  m_Mutex.Lock();
+  unsigned long numberOfEntries = m_InsertionQueue.size();
+  m_Mutex.Unlock();
+  
+  return numberOfEntries;
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+unsigned long
+DiscreteDerivativeCache<TValue,VImageDimension>
+::GetMemorySize() const
+{
+  // Each entry is a tree node (three links and a color) with its key and value, and a copy of 
+  // the key in the insertion queue
+  const unsigned long valueSize = m_HalfPrecisionStorage ? 
+    sizeof( typename HalfValueContainerType::value_type ) : 
+    sizeof( typename ValueContainerType::value_type );
+  const unsigned long entrySize = valueSize + 4 * sizeof( void * ) + sizeof( KeyType );
+  
+  return this->GetNumberOfEntries() * entrySize;
+}
+
+
+template <class TValue, unsigned int VImageDimension>
+void
+DiscreteDerivativeCache<TValue,VImageDimension>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "MaximumNumberOfEntries: " << m_MaximumNumberOfEntries << std::endl;
+  os << indent << "HalfPrecisionStorage: " << m_HalfPrecisionStorage << std::endl;
+  os << indent << "NumberOfEntries: " << m_InsertionQueue.size() << std::endl;
+  os << indent << "NumberOfHits: " << m_NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << m_NumberOfMisses << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
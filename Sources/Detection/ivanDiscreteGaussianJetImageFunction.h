@@ -0,0 +1,294 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGaussianJetImageFunction.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes value, gradient and hessian from a single neighborhood with separable Gaussian derivatives
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteGaussianJetImageFunction_h
+#define __ivanDiscreteGaussianJetImageFunction_h
+
+#include "ivanMacros.h"
+#include "ivanGaussianJet.h"
+#include "ivanGaussianDerivativeOperator.h"
+#include "ivanNeighborhoodInnerProduct.h"
+
+#include "itkImageFunction.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+/**
+ * \class DiscreteGaussianJetImageFunction
+ * \brief Compute the Gaussian-smoothed value, gradient and hessian of an image at a specific 
+ *        location in space from a single neighborhood.
+ *
+ * Functions that need the gradient and the hessian at the same points and scale, such as the
+ * medialness and vesselness functions, otherwise gather the neighborhood twice, once in 
+ * DiscreteGradientGaussianImageFunction and once in DiscreteHessianGaussianImageFunction. This 
+ * function gathers it once and reduces it one direction at a time with the one-dimensional 
+ * Gaussian derivative operators of orders zero to two, sharing the partial results between the 
+ * 1 + N + N(N+1)/2 components, and returns them in a GaussianJet.
+ *
+ * The parameters are those of DiscreteHessianGaussianImageFunction. With NormalizeAcrossScale 
+ * each derivative is multiplied by the scale to the power of Gamma times its order, so the 
+ * hessian equals that of DiscreteHessianGaussianImageFunction and, with Gamma = 1, the gradient 
+ * equals that of DiscreteGradientGaussianImageFunction, up to rounding.
+ *
+ * In LinearInterpolation mode, the jet at a continuous index is obtained with a single 
+ * reduction of the box covering the neighborhoods of the 2^N surrounding indices, with the 
+ * kernels interpolated at the fractional offsets, which is equivalent to interpolating the jets
+ * at those indices.
+ *
+ * The Initialize() method must be called after setting the parameters and before
+ * evaluating the function.
+ *
+ * \sa DiscreteHessianGaussianImageFunction
+ * \sa DiscreteGradientGaussianImageFunction
+ * \sa GaussianJet
+ */
+template< class TInputImage, class TOutput = double, class TAccumulator = TOutput >
+class ITK_EXPORT DiscreteGaussianJetImageFunction:
+  public itk::ImageFunction< TInputImage,
+  GaussianJet< TOutput, ITKImageDimensionMacro( TInputImage ) >, TOutput >
+{
+public:
+
+  /**Standard "Self" typedef */
+  typedef DiscreteGaussianJetImageFunction   Self;
+
+  /** Standard "Superclass" typedef */
+  typedef itk::ImageFunction< TInputImage,
+    GaussianJet< TOutput, ITKImageDimensionMacro( TInputImage ) >,
+    TOutput >                                    Superclass;
+
+  /** Smart pointer typedef support */
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods) */
+  itkTypeMacro( DiscreteGaussianJetImageFunction, ImageFunction );
+
+  /** Image dependent types */
+  typedef typename Superclass::InputImageType      InputImageType;
+  typedef typename Superclass::InputPixelType      InputPixelType;
+  typedef typename Superclass::IndexType           IndexType;
+  typedef typename Superclass::IndexValueType      IndexValueType;
+  typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
+  typedef typename Superclass::PointType           PointType;
+
+  /** Dimension of the underlying image */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+
+  /** Number of components of the jet: value, gradient and hessian */
+  itkStaticConstMacro(NumberOfComponents, unsigned int,
+                      1 + ImageDimension + ImageDimension * ( ImageDimension + 1 ) / 2);
+
+  /** Output type */
+  typedef typename Superclass::OutputType                           OutputType;
+  typedef typename OutputType::GradientType                         GradientType;
+  typedef typename OutputType::HessianType                          HessianType;
+
+  typedef itk::FixedArray< double, 
+    itkGetStaticConstMacro(ImageDimension) >                       VarianceArrayType;
+
+  typedef ivan::GaussianDerivativeOperator< TOutput,
+    itkGetStaticConstMacro(ImageDimension) >                       GaussianDerivativeOperatorType;
+
+  /** Array to store gaussian derivative operators from zero to second order
+    * (3*ImageDimension operators) */
+  typedef itk::FixedArray< GaussianDerivativeOperatorType,
+    3 * itkGetStaticConstMacro(ImageDimension) >                   GaussianDerivativeOperatorArrayType;
+
+  /** One-dimensional kernels (coefficients of the operators padded to the 
+   * maximum radius), stored in the same order as the operators */
+  typedef std::vector< TOutput >                                   SeparableKernelType;
+  typedef itk::FixedArray< SeparableKernelType, 
+    3 * itkGetStaticConstMacro(ImageDimension) >                   SeparableKernelArrayType;
+
+  /** Helper for contiguous neighborhood gathering and inner products */
+  typedef TAccumulator                                             AccumulatorType;
+  typedef NeighborhoodInnerProduct< InputImageType, TOutput, 
+    TAccumulator >                                                 InnerProductType;
+
+  /** Derivative order in each direction for each of the components of the jet */
+  typedef itk::FixedArray< unsigned int, 
+    itkGetStaticConstMacro(ImageDimension) >                       OrderArrayType;
+  typedef itk::FixedArray< OrderArrayType, 
+    itkGetStaticConstMacro(NumberOfComponents) >                   ComponentOrderArrayType;
+  typedef itk::FixedArray< TOutput, 
+    itkGetStaticConstMacro(NumberOfComponents) >                   ComponentArrayType;
+
+  /** Interpolation modes */
+  enum InterpolationModeType { NearestNeighbourInterpolation, LinearInterpolation };
+  
+  /** Bricked copy of the input image for scattered evaluations. */
+  typedef typename InnerProductType::BrickedImageType              BrickedImageType;
+  
+  /** Neighborhood gathered on the stack of the evaluating thread. */
+  typedef typename InnerProductType::ScratchBufferType             ScratchBufferType;
+
+public:
+
+  /** Evalutate the function at specified point */
+  virtual OutputType Evaluate(const PointType & point) const;
+
+  /** Evaluate the function at specified Index position */
+  virtual OutputType EvaluateAtIndex(const IndexType & index) const;
+
+  /** Evaluate the function at specified ContinousIndex position */
+  virtual OutputType EvaluateAtContinuousIndex(
+    const ContinuousIndexType & index) const;
+
+  /** Set/Get the variance for the discrete Gaussian kernel.
+   * Sets the variance for individual dimensions. The default is 1.0 in each dimension.
+   * If UseImageSpacing is true, the units are the physical units of your image.
+   * If UseImageSpacing is false then the units are pixels. */
+  itkSetMacro(Variance, VarianceArrayType);
+  itkGetConstMacro(Variance, const VarianceArrayType);
+  itkSetVectorMacro(Variance, double, VarianceArrayType::Length);
+
+  /** Convenience method for setting the variance for all dimensions */
+  virtual void SetVariance(double variance)
+  {
+    m_Variance.Fill(variance);
+    this->Modified();
+  }
+
+  /** Convenience method for setting the variance through the standard deviation */
+  void SetSigma(const double sigma)
+  {
+    SetVariance(sigma * sigma);
+  }
+
+  /** Set/Get the desired maximum error of the gaussian approximation. The value is 
+   * clamped between 0.00001 and 0.99999. */
+  itkSetClampMacro(MaximumError, double, 0.00001, 0.99999);
+  itkGetConstMacro(MaximumError, double);
+
+  /** Set/Get the flag for calculating scale-space normalized derivatives. */
+  itkSetMacro(NormalizeAcrossScale, bool);
+  itkGetConstMacro(NormalizeAcrossScale, bool);
+  itkBooleanMacro(NormalizeAcrossScale);
+  
+  /** Set/Get the normalization factor for derivatives. */
+  itkSetMacro(Gamma, double);
+  itkGetConstMacro(Gamma, double);
+
+  /** Set/Get the flag for using image spacing when calculating derivatives. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get a limit for growth of the kernel. */
+  itkSetMacro(MaximumKernelWidth, unsigned int);
+  itkGetConstMacro(MaximumKernelWidth, unsigned int);
+
+  /** Set/Get the interpolation mode. */
+  itkSetMacro(InterpolationMode, InterpolationModeType);
+  itkGetConstMacro(InterpolationMode, InterpolationModeType);
+  
+  /** Set/Get a bricked copy of the input image. If set, and while it is a copy of the current 
+   * contents of the input (see BrickedImageBuffer::IsCopyOf()), neighborhoods are gathered from 
+   * it instead of the input. See DiscreteHessianGaussianImageFunction::SetBrickedImage(). */
+  itkSetObjectMacro(BrickedImage, BrickedImageType);
+  itkGetObjectMacro(BrickedImage, BrickedImageType);
+
+  /** Initialize the Gaussian kernels. Call this method before evaluating the function.
+   * This method MUST be called after any changes to function parameters. */
+  virtual void Initialize() { RecomputeGaussianKernel(); }
+
+protected:
+
+  DiscreteGaussianJetImageFunction();
+  ~DiscreteGaussianJetImageFunction(){}
+
+  void PrintSelf(std::ostream & os, itk::Indent indent) const;
+
+  void RecomputeGaussianKernel();
+
+  /** Reduce a gathered box with the given one-dimensional kernels and store the 
+   * components in the jet. */
+  OutputType ReduceSeparable(const ScratchBufferType & buffer, 
+    const SeparableKernelArrayType & kernels) const;
+
+private:
+
+  DiscreteGaussianJetImageFunction(const Self &); //purposely not implemented
+  void operator=(const Self &); //purposely not implemented
+
+  /** Desired variance of the discrete Gaussian function */
+  VarianceArrayType m_Variance;
+
+  /** Difference between the areas under the curves of the continuous and
+   * discrete Gaussian functions */
+  double m_MaximumError;
+
+  /** Maximum kernel size allowed */
+  unsigned int m_MaximumKernelWidth;
+
+  /** Array of derivative operators, one for each dimension and order. First N 
+    * zero-order operators are stored, then N first-order and then N second-order. */
+  GaussianDerivativeOperatorArrayType m_OperatorArray;
+
+  /** Array of one-dimensional kernels */
+  SeparableKernelArrayType m_SeparableKernelArray;
+
+  /** Derivative orders of each component: value, gradient and hessian in the order of 
+    * SymmetricSecondRankTensor */
+  ComponentOrderArrayType m_ComponentOrders;
+
+  /** Radius of the kernels */
+  unsigned int m_KernelRadius;
+
+  /** Flag for scale-space normalization of derivatives */
+  bool m_NormalizeAcrossScale;
+  
+  /** Normalization factor for derivatives, typically between 0.0 and 1.0. */
+  double m_Gamma;
+
+  /** Flag to indicate whether to use image spacing */
+  bool m_UseImageSpacing;
+
+  /** Interpolation mode */
+  InterpolationModeType m_InterpolationMode;
+  
+  /** Optional bricked copy of the input */
+  typename BrickedImageType::Pointer m_BrickedImage;
+};
+
+} // namespace ivan
+
+#if ITK_TEMPLATE_TXX
+#include "ivanDiscreteGaussianJetImageFunction.hxx"
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGaussianJetImageFunction.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes value, gradient and hessian from a single neighborhood with separable Gaussian derivatives
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteGaussianJetImageFunction_hxx
+#define __ivanDiscreteGaussianJetImageFunction_hxx
+
+#include "ivanDiscreteGaussianJetImageFunction.h"
+
+namespace ivan
+{
+
+template< class TInputImage, class TOutput, class TAccumulator >
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::DiscreteGaussianJetImageFunction():
+  m_MaximumError(0.005),
+  m_MaximumKernelWidth(30),
+  m_KernelRadius(0),
+  m_NormalizeAcrossScale(true),
+  m_Gamma(1.0),
+  m_UseImageSpacing(true),
+  m_InterpolationMode(NearestNeighbourInterpolation)
+{
+  m_Variance.Fill(1.0);
+
+  // Value, gradient and hessian components. The hessian components are ordered as in
+  // SymmetricSecondRankTensor (in 3D dxx, dxy, dxz, dyy, dyz, dzz)
+  unsigned int component = 0;
+
+  m_ComponentOrders[component++].Fill(0);
+
+  for ( unsigned int i = 0; i < itkGetStaticConstMacro(ImageDimension); ++i )
+    {
+    m_ComponentOrders[component].Fill(0);
+    ++m_ComponentOrders[component++][i];
+    }
+
+  for ( unsigned int i = 0; i < itkGetStaticConstMacro(ImageDimension); ++i )
+    {
+    for ( unsigned int j = i; j < itkGetStaticConstMacro(ImageDimension); ++j )
+      {
+      m_ComponentOrders[component].Fill(0);
+      ++m_ComponentOrders[component][i];
+      ++m_ComponentOrders[component++][j];
+      }
+    }
+}
+
+/** Print self method */
+template< class TInputImage, class TOutput, class TAccumulator >
+void
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  os << indent << "NormalizeAcrossScale: " << m_NormalizeAcrossScale << std::endl;
+  os << indent << "Gamma: " << m_Gamma << std::endl;
+  os << indent << "Variance: " << m_Variance << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
+  os << indent << "KernelRadius: " << m_KernelRadius << std::endl;
+  os << indent << "InterpolationMode: " << m_InterpolationMode << std::endl;
+  os << indent << "BrickedImage: " << m_BrickedImage.GetPointer() << std::endl;
+}
+
+/** Recompute the one-dimensional kernels of orders zero to two */
+template< class TInputImage, class TOutput, class TAccumulator >
+void
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::RecomputeGaussianKernel()
+{
+  const unsigned int dimension = itkGetStaticConstMacro(ImageDimension);
+  unsigned int maxRadius = 0;
+
+  for ( unsigned int direction = 0; direction < dimension; direction++ )
+    {
+    for ( unsigned int order = 0; order <= 2; ++order )
+      {
+      const unsigned int idx = dimension * order + direction;
+      m_OperatorArray[idx].SetDirection(direction);
+      m_OperatorArray[idx].SetMaximumKernelWidth(m_MaximumKernelWidth);
+      m_OperatorArray[idx].SetMaximumError(m_MaximumError);
+
+      if ( ( m_UseImageSpacing == true ) && ( this->GetInputImage() ) )
+        {
+        if ( this->GetInputImage()->GetSpacing()[direction] == 0.0 )
+          {
+          itkExceptionMacro(<< "Pixel spacing cannot be zero");
+          }
+        else
+          {
+          m_OperatorArray[idx].SetSpacing(this->GetInputImage()->GetSpacing()[direction]);
+          }
+        }
+
+      // NOTE: GaussianDerivativeOperator modifies the variance when
+      // setting image spacing
+      m_OperatorArray[idx].SetVariance(m_Variance[direction]);
+      m_OperatorArray[idx].SetOrder(order);
+      m_OperatorArray[idx].SetNormalizeAcrossScale(m_NormalizeAcrossScale);
+      m_OperatorArray[idx].SetGamma(m_Gamma);
+      m_OperatorArray[idx].CreateDirectional();
+
+      if ( m_OperatorArray[idx].GetRadius()[direction] > maxRadius )
+        {
+        maxRadius = m_OperatorArray[idx].GetRadius()[direction];
+        }
+      }
+    }
+
+  m_KernelRadius = maxRadius;
+
+  // Store the coefficients of the operators padded to the maximum radius, reversed as in 
+  // DiscreteHessianGaussianImageFunction
+  const unsigned int kernelSize = 2 * maxRadius + 1;
+
+  for ( unsigned int idx = 0; idx < m_OperatorArray.Size(); ++idx )
+    {
+    const unsigned int direction = idx % dimension;
+    const int operatorRadius = m_OperatorArray[idx].GetRadius()[direction];
+
+    m_SeparableKernelArray[idx].assign( kernelSize, itk::NumericTraits< TOutput >::Zero );
+
+    for ( int k = -operatorRadius; k <= operatorRadius; ++k )
+      {
+      m_SeparableKernelArray[idx][maxRadius + k] = m_OperatorArray[idx][operatorRadius - k];
+      }
+    }
+}
+
+/** Reduce a gathered box and store the components in the jet */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::ReduceSeparable(const ScratchBufferType & buffer, const SeparableKernelArrayType & kernels) const
+{
+  ComponentArrayType components;
+  InnerProductType::ReduceSeparable( buffer.GetDataPointer(), buffer.Size(), kernels, 
+    m_ComponentOrders, m_ComponentOrders.Size(), components );
+
+  OutputType jet;
+  unsigned int component = 0;
+
+  jet.Value = components[component++];
+
+  for ( unsigned int i = 0; i < itkGetStaticConstMacro(ImageDimension); ++i )
+    {
+    jet.Gradient[i] = components[component++];
+    }
+
+  for ( unsigned int i = 0; i < jet.Hessian.Size(); ++i )
+    {
+    jet.Hessian[i] = components[component++];
+    }
+
+  return jet;
+}
+
+/** Evaluate the function at the specifed index */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateAtIndex(const IndexType & index) const
+{
+  typename InnerProductType::SizeType radiusSize;
+  radiusSize.Fill( m_KernelRadius );
+
+  typename InnerProductType::ScratchBufferType buffer( 
+    InnerProductType::GetNeighborhoodSize( radiusSize ) );
+  InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, radiusSize, 
+    buffer.GetDataPointer() );
+
+  return this->ReduceSeparable( buffer, m_SeparableKernelArray );
+}
+
+/** Evaluate the function at the specifed point */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::Evaluate(const PointType & point) const
+{
+  if ( m_InterpolationMode == NearestNeighbourInterpolation )
+    {
+    IndexType index;
+    this->ConvertPointToNearestIndex(point, index);
+    return this->EvaluateAtIndex(index);
+    }
+  else
+    {
+    ContinuousIndexType cindex;
+    this->ConvertPointToContinuousIndex(point, cindex);
+    return this->EvaluateAtContinuousIndex(cindex);
+    }
+}
+
+/** Evaluate the function at specified ContinousIndex position.*/
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteGaussianJetImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateAtContinuousIndex(const ContinuousIndexType & cindex) const
+{
+  if ( m_InterpolationMode == NearestNeighbourInterpolation )
+    {
+    IndexType index;
+    this->ConvertContinuousIndexToNearestIndex(cindex, index);
+    return this->EvaluateAtIndex(index);
+    }
+
+  // The box covering the neighborhoods of the 2^N surrounding indices is reduced with the
+  // kernels interpolated at the fractional offsets, which gives the interpolated jet
+  const unsigned int dimension = itkGetStaticConstMacro(ImageDimension);
+  const unsigned int kernelSize = 2 * m_KernelRadius + 1;
+
+  typename InnerProductType::RegionType region;
+  typename InnerProductType::IndexType  regionIndex;
+  typename InnerProductType::SizeType   regionSize;
+
+  SeparableKernelArrayType kernels;
+
+  for ( unsigned int d = 0; d < dimension; ++d )
+    {
+    const IndexValueType baseIndex = static_cast< IndexValueType >( vcl_floor( cindex[d] ) );
+    const double distance = cindex[d] - static_cast< double >( baseIndex );
+    const bool shifted = ( distance > 0.0 );
+
+    regionIndex[d] = baseIndex - static_cast< IndexValueType >( m_KernelRadius );
+    regionSize[d] = kernelSize + ( shifted ? 1 : 0 );
+
+    for ( unsigned int order = 0; order <= 2; ++order )
+      {
+      const unsigned int idx = dimension * order + d;
+
+      if ( shifted )
+        {
+        InnerProductType::InterpolateKernel( m_SeparableKernelArray[idx], distance, kernels[idx] );
+        }
+      else
+        {
+        kernels[idx] = m_SeparableKernelArray[idx];
+        }
+      }
+    }
+
+  region.SetIndex( regionIndex );
+  region.SetSize( regionSize );
+
+  typename InnerProductType::ScratchBufferType buffer( region.GetNumberOfPixels() );
+  InnerProductType::GatherRegion( this->GetInputImage(), m_BrickedImage.GetPointer(), region, 
+    buffer.GetDataPointer() );
+
+  return this->ReduceSeparable( buffer, kernels );
+}
+
+} // end namespace ivan
+
+#endif
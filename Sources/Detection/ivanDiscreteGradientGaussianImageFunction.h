@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanDiscreteGradientGaussianImageFunction_h
 #define __ivanDiscreteGradientGaussianImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanMacros.h"
 
 #include "itkNeighborhoodOperatorImageFunction.h"
@@ -38,6 +39,9 @@ SUCH DAMAGE.
 #include "itkGaussianDerivativeOperator.h"
 #include "itkVector.h"
 
+#include "ivanDiscreteDerivativeCache.h"
+#include "ivanBrickedImageBuffer.h"
+
 namespace ivan
 {
 
@@ -95,6 +99,9 @@ public:
 
   /** Dimension of the underlying image */
   itkStaticConstMacro( ImageDimension2, unsigned int, InputImageType::ImageDimension );
+  
+  /** Largest kernel radius evaluated by code specialized for the radius */
+  itkStaticConstMacro( MaximumFixedKernelRadius, unsigned int, 5 );
 
   /** Output type */
   typedef typename Superclass::OutputType     OutputType;
@@ -123,6 +130,13 @@ public:
 
   /** Interpolation modes */
   enum InterpolationModeType { NearestNeighbourInterpolation, LinearInterpolation };
+  
+  /** Cache of gradient values that can be shared among several functions. */
+  typedef DiscreteDerivativeCache<OutputType,
+    itkGetStaticConstMacro(ImageDimension2)>             DerivativeCacheType;
+  
+  /** Bricked copy of the input image for scattered evaluations. */
+  typedef BrickedImageBuffer<InputImageType>             BrickedImageType;
 
 public:
 
@@ -187,6 +201,27 @@ public:
   /** Set/Get the interpolation mode. */
   itkSetMacro( InterpolationMode, InterpolationModeType );
   itkGetConstMacro( InterpolationMode, InterpolationModeType );
+  
+  /** Set/Get the flag for fixed radius evaluation at indices. If true, kernels of radius up to
+   * MaximumFixedKernelRadius are evaluated by code instantiated for each radius, with the same 
+   * results up to rounding. See DiscreteHessianGaussianImageFunction::SetUseFixedRadiusKernels(). True by 
+   * default. */
+  itkSetMacro( UseFixedRadiusKernels, bool );
+  itkGetConstMacro( UseFixedRadiusKernels, bool );
+  itkBooleanMacro( UseFixedRadiusKernels );
+  
+  /** Set/Get the derivative cache. If set, values computed at indices are stored in the cache
+   * and reused in later evaluations, possibly by other functions sharing the cache. Values are 
+   * keyed by the standard deviation of the first dimension, so the cache must only be shared 
+   * between functions with the same input image and parameters other than the variance. */
+  itkSetObjectMacro( DerivativeCache, DerivativeCacheType );
+  itkGetObjectMacro( DerivativeCache, DerivativeCacheType );
+  
+  /** Set/Get a bricked copy of the input image. If set, and while it is a copy of the current 
+   * contents of the input (see BrickedImageBuffer::IsCopyOf()), neighborhoods are gathered from 
+   * it instead of the input. See DiscreteHessianGaussianImageFunction::SetBrickedImage(). */
+  itkSetObjectMacro( BrickedImage, BrickedImageType );
+  itkGetObjectMacro( BrickedImage, BrickedImageType );
 
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
@@ -211,6 +246,15 @@ protected:
   void RecomputeGaussianKernel();
  // void RecomputeContinuousGaussianKernel(
    //        const double* offset) const;
+  
+  /** Evaluate the gradient at the given index, without the spacing, with the code of the 
+   * current kernel radius, which must be between 1 and MaximumFixedKernelRadius. */
+  OutputType EvaluateSmallKernelAtIndex( const IndexType & index ) const;
+  
+  /** Evaluate the gradient at the given index, without the spacing, for kernels of radius 
+   * VRadius. */
+  template <unsigned int VRadius>
+  OutputType EvaluateFixedRadiusAtIndex( const IndexType & index ) const;
 
 private:
 
@@ -233,6 +277,12 @@ private:
 
   /** Array of N-dimensional kernels used to calculate gradient components */
   KernelArrayType  m_KernelArray;
+  
+  /** Radius of the N-dimensional kernels */
+  unsigned int  m_KernelRadius;
+  
+  /** Flag for the evaluation specialized for small kernel radii */
+  bool  m_UseFixedRadiusKernels;
 
   /** OperatorImageFunction */
   OperatorImageFunctionPointer  m_OperatorImageFunction;
@@ -245,6 +295,12 @@ private:
 
   /** Interpolation mode */
   InterpolationModeType  m_InterpolationMode;
+  
+  /** Optional cache of computed values */
+  typename DerivativeCacheType::Pointer  m_DerivativeCache;
+  
+  /** Optional bricked copy of the input */
+  typename BrickedImageType::Pointer     m_BrickedImage;
 
 };
 
@@ -257,7 +313,7 @@ private:
                         DiscreteGradientGaussianImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanDiscreteGradientGaussianImageFunction+-.h"
 #endif
 
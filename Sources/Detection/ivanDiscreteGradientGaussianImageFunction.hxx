@@ -33,6 +33,7 @@ SUCH DAMAGE.
 #include "ivanDiscreteGradientGaussianImageFunction.h"
 
 #include "itkNeighborhoodOperatorImageFilter.h"
+#include "ivanNeighborhoodInnerProduct.h"
 
 namespace ivan
 {
@@ -45,7 +46,9 @@ DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
   m_MaximumKernelWidth( 30 ),
   m_NormalizeAcrossScale( true ),
   m_UseImageSpacing( true ),
-  m_InterpolationMode( NearestNeighbourInterpolation )
+  m_InterpolationMode( NearestNeighbourInterpolation ),
+  m_KernelRadius( 0 ),
+  m_UseFixedRadiusKernels( true )
 {
   m_Variance.Fill( 1.0 );
   m_OperatorImageFunction = OperatorImageFunctionType::New();
@@ -65,9 +68,12 @@ DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
   os << indent << "MaximumError: " << m_MaximumError << std::endl;
   os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
   os << indent << "InterpolationMode: " << m_InterpolationMode << std::endl;
+  os << indent << "UseFixedRadiusKernels: " << m_UseFixedRadiusKernels << std::endl;
   os << indent << "OperatorArray: " << m_OperatorArray << std::endl;
   os << indent << "KernelArray: " << m_KernelArray << std::endl;
   os << indent << "OperatorImageFunction: " << m_OperatorImageFunction << std::endl;
+  os << indent << "DerivativeCache: " << m_DerivativeCache.GetPointer() << std::endl;
+  os << indent << "BrickedImage: " << m_BrickedImage.GetPointer() << std::endl;
 }
 
 
@@ -132,6 +138,8 @@ DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
       }
     }
 
+  m_KernelRadius = maxRadius;
+  
   // Now precompute the N-dimensional kernel. This fastest as we don't have to perform
   // N convolutions for each point we calculate but only one.
 
@@ -210,16 +218,98 @@ DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
 {
   OutputType gradientVector;
   
-  for( unsigned int i=0; i<m_KernelArray.Size(); ++i )
+  const double scale = vcl_sqrt( m_Variance[0] );
+  
+  if( m_DerivativeCache.IsNotNull() && m_DerivativeCache->Find( scale, index, gradientVector ) )
+    {
+    return gradientVector;
+    }
+  
+  if( m_UseFixedRadiusKernels && m_KernelRadius >= 1 && 
+      m_KernelRadius <= itkGetStaticConstMacro(MaximumFixedKernelRadius) )
     {
-    m_OperatorImageFunction->SetOperator( m_KernelArray[i] );
-    gradientVector[i] = m_OperatorImageFunction->EvaluateAtIndex( index );
-    if( m_UseImageSpacing )
+    gradientVector = this->EvaluateSmallKernelAtIndex( index );
+    }
+  else
+    {
+    typedef NeighborhoodInnerProduct<InputImageType,TCoordRep> InnerProductType;
+    
+    // Gather the neighborhood once for all kernels. This does not modify the function state,
+    // unlike setting the operator to m_OperatorImageFunction, so it can be called concurrently
+    typename InnerProductType::BufferType buffer;
+    InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, 
+      m_KernelArray[0].GetRadius(), buffer );
+    
+    for( unsigned int i=0; i<m_KernelArray.Size(); ++i )
+      {
+      gradientVector[i] = InnerProductType::InnerProduct( m_KernelArray[i], buffer );
+      }
+    }
+  
+  if( m_UseImageSpacing )
+    {
+    for( unsigned int i=0; i<m_KernelArray.Size(); ++i )
       {
       gradientVector[i] /= this->GetInputImage()->GetSpacing()[i];
       }
     }
+  
+  if( m_DerivativeCache.IsNotNull() )
+    {
+    m_DerivativeCache->Insert( scale, index, gradientVector );
+    }
+
+  return gradientVector;
+}
+
+
+/** Evaluate the function at the specifed index with the code of the kernel radius */
+template <class TInputImage, class TCoordRep>
+typename DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>::OutputType
+DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
+::EvaluateSmallKernelAtIndex( const IndexType & index ) const
+{
+  switch( m_KernelRadius )
+    {
+    case 1:
+      return this->template EvaluateFixedRadiusAtIndex<1>( index );
+    case 2:
+      return this->template EvaluateFixedRadiusAtIndex<2>( index );
+    case 3:
+      return this->template EvaluateFixedRadiusAtIndex<3>( index );
+    case 4:
+      return this->template EvaluateFixedRadiusAtIndex<4>( index );
+    default: // MaximumFixedKernelRadius
+      return this->template EvaluateFixedRadiusAtIndex<5>( index );
+    }
+}
+
 
+/** Evaluate the function at the specifed index for kernels of a fixed radius */
+template <class TInputImage, class TCoordRep>
+template <unsigned int VRadius>
+typename DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>::OutputType
+DiscreteGradientGaussianImageFunction<TInputImage,TCoordRep>
+::EvaluateFixedRadiusAtIndex( const IndexType & index ) const
+{
+  typedef NeighborhoodInnerProduct<InputImageType,TCoordRep> InnerProductType;
+  
+  const unsigned int neighborhoodSize = 
+    IntegerPower<2 * VRadius + 1, itkGetStaticConstMacro(ImageDimension2)>::Value;
+  
+  typename InnerProductType::SizeType radiusSize;
+  radiusSize.Fill( VRadius );
+  
+  TCoordRep box[neighborhoodSize];
+  InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, radiusSize, box );
+  
+  OutputType gradientVector;
+  
+  for( unsigned int i=0; i<m_KernelArray.Size(); ++i )
+    {
+    gradientVector[i] = InnerProductType::template FixedSizeInnerProduct<neighborhoodSize>( &m_KernelArray[i][0], box );
+    }
+  
   return gradientVector;
 }
 
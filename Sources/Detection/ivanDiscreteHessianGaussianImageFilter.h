@@ -0,0 +1,234 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteHessianGaussianImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes all the components of the Hessian with a tree of one-dimensional Gaussian derivative passes
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteHessianGaussianImageFilter_h
+#define __ivanDiscreteHessianGaussianImageFilter_h
+
+#include "ivanGaussianDerivativeOperator.h"
+#include "ivanSeparableLineConvolution.h"
+
+#include "itkImageToImageFilter.h"
+#include "itkImage.h"
+#include "itkSymmetricSecondRankTensor.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class DiscreteHessianGaussianImageFilter
+ *  \brief Computes the Hessian of an image with discrete Gaussian derivative kernels.
+ *
+ * Whole-image counterpart of DiscreteHessianGaussianImageFunction, with the same parameters.
+ * Instead of running a separable derivative filter for each of the N(N+1)/2 components, 
+ * which repeats the smoothing along the axes not being differentiated, the one-dimensional
+ * passes are organized as a tree: the input is convolved along the first axis with the 
+ * kernels of order 0, 1 and 2, each of those results along the second axis with the kernels
+ * that keep the total order at most 2, and so on, the last axis completing each component to
+ * order 2. In 3D this takes 15 passes instead of 18, and the passes saved are those along the
+ * first axis, which are done on the largest regions (padded along the other axes). Passes are 
+ * done with SeparableLineConvolution, threaded over lines of the image.
+ *
+ * The output requested region is processed in InternalNumberOfStreamDivisions pieces along the
+ * last axis, so only the intermediate results of a piece are kept, one for each axis but the 
+ * last, since the tree is traversed depth-first.
+ * 
+ * \sa DiscreteHessianGaussianImageFunction
+ * \sa itk::DiscreteGaussianDerivativeImageFilter
+ */
+template <class TInputImage, class TOutputImage = itk::Image< itk::SymmetricSecondRankTensor< 
+  double, TInputImage::ImageDimension >, TInputImage::ImageDimension > >
+class ITK_EXPORT DiscreteHessianGaussianImageFilter : 
+  public itk::ImageToImageFilter<TInputImage,TOutputImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef DiscreteHessianGaussianImageFilter                Self;
+  typedef itk::ImageToImageFilter<TInputImage,TOutputImage> Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  typedef TInputImage                              InputImageType;
+  typedef TOutputImage                             OutputImageType;
+  
+  typedef typename InputImageType::PixelType       InputPixelType;
+  typedef typename OutputImageType::PixelType      OutputPixelType;
+  typedef typename OutputPixelType::ValueType      OutputValueType;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+  
+  /** Number of components of the hessian. */
+  itkStaticConstMacro( NumberOfComponents, unsigned int, 
+    TInputImage::ImageDimension * ( TInputImage::ImageDimension + 1 ) / 2 );
+  
+  /** Type of the kernels, the accumulation and the intermediate results. */
+  typedef typename itk::NumericTraits<OutputValueType>::RealType   RealType;
+  
+  typedef itk::FixedArray< double, 
+    itkGetStaticConstMacro(ImageDimension) >                       VarianceArrayType;
+  
+  typedef ivan::GaussianDerivativeOperator< RealType,
+    itkGetStaticConstMacro(ImageDimension) >                       GaussianDerivativeOperatorType;
+  
+  typedef SeparableLineConvolution< itkGetStaticConstMacro(ImageDimension), 
+    RealType >                                                     ConvolutionType;
+  
+  /** One-dimensional kernels, for each order from zero to two and direction, 
+    * stored at index ImageDimension * order + direction. */
+  typedef typename ConvolutionType::KernelType                     KernelType;
+  typedef std::vector<KernelType>                                  KernelArrayType;
+  
+  /** Derivative order along each direction. */
+  typedef itk::FixedArray< unsigned int, 
+    itkGetStaticConstMacro(ImageDimension) >                       OrderArrayType;
+       
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( DiscreteHessianGaussianImageFilter, itk::ImageToImageFilter );
+  
+  /** Set/Get the variance for the discrete Gaussian kernel.
+   * If UseImageSpacing is true, the units are the physical units of your image.
+   * If UseImageSpacing is false then the units are pixels. */
+  itkSetMacro(Variance, VarianceArrayType);
+  itkGetConstMacro(Variance, const VarianceArrayType);
+  
+  /** Convenience method for setting the variance for all dimensions */
+  virtual void SetVariance(double variance)
+  {
+    m_Variance.Fill(variance);
+    this->Modified();
+  }
+
+  /** Convenience method for setting the variance through the standard deviation */
+  void SetSigma(const double sigma)
+  {
+    SetVariance(sigma * sigma);
+  }
+  
+  /** Set/Get the desired maximum error of the gaussian approximation. See 
+   * DiscreteHessianGaussianImageFunction. */
+  itkSetClampMacro(MaximumError, double, 0.00001, 0.99999);
+  itkGetConstMacro(MaximumError, double);
+  
+  /** Set/Get a limit for growth of the kernel. */
+  itkSetMacro(MaximumKernelWidth, unsigned int);
+  itkGetConstMacro(MaximumKernelWidth, unsigned int);
+  
+  /** Set/Get the flag for calculating scale-space normalized derivatives. */
+  itkSetMacro(NormalizeAcrossScale, bool);
+  itkGetConstMacro(NormalizeAcrossScale, bool);
+  itkBooleanMacro(NormalizeAcrossScale);
+  
+  /** Set/Get the normalization factor for derivatives. */
+  itkSetMacro(Gamma, double);
+  itkGetConstMacro(Gamma, double);
+  
+  /** Set/Get the flag for using image spacing when calculating derivatives. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+  
+  /** Set/Get the number of pieces the output requested region is divided into along
+   * the last axis. The default value is ImageDimension^2. */
+  itkSetMacro(InternalNumberOfStreamDivisions, unsigned int);
+  itkGetConstMacro(InternalNumberOfStreamDivisions, unsigned int);
+  
+protected:
+
+  DiscreteHessianGaussianImageFilter();
+  ~DiscreteHessianGaussianImageFilter() {};
+  
+  /** The input requested region is the output requested region padded by the radius
+    * of the kernels. */
+  virtual void GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError );
+  
+  /** Compute the hessian, one piece of the output requested region at a time. */
+  virtual void GenerateData();
+  
+  /** Compute the one-dimensional kernels and the largest radius in each direction. */
+  void ComputeKernels( KernelArrayType & kernels, 
+    typename OutputImageRegionType::SizeType & radius ) const;
+  
+  /** Convolve along the given axis the result of the previous axes, whose orders are 
+    * given, and recurse to the next axes. At the last axis the result is written to 
+    * the component of the output given by the orders. */
+  void ConvolveAxis( unsigned int axis, unsigned int totalOrder, OrderArrayType & orders, 
+    const KernelArrayType & kernels, const std::vector<OutputImageRegionType> & regions,
+    std::vector< std::vector<RealType> > & buffers );
+  
+  /** Index of the hessian component with the given derivative orders. */
+  static unsigned int GetComponentIndex( const OrderArrayType & orders );
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  DiscreteHessianGaussianImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  /** Variance of the discrete Gaussian function. */
+  VarianceArrayType m_Variance;
+  
+  /** Difference between the areas under the curves of the continuous and
+   * discrete Gaussian functions. */
+  double m_MaximumError;
+  
+  /** Maximum kernel size allowed. */
+  unsigned int m_MaximumKernelWidth;
+  
+  /** Flag for scale-space normalization of derivatives. */
+  bool m_NormalizeAcrossScale;
+  
+  /** Normalization factor for derivatives. */
+  double m_Gamma;
+  
+  /** Flag for using image spacing when calculating derivatives. */
+  bool m_UseImageSpacing;
+  
+  /** Number of pieces of the output requested region. */
+  unsigned int m_InternalNumberOfStreamDivisions;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanDiscreteHessianGaussianImageFilter.hxx"
+#endif
+  
+#endif
@@ -0,0 +1,303 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteHessianGaussianImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes all the components of the Hessian with a tree of one-dimensional Gaussian derivative passes
+// Date: 2012/11/05
+
+#ifndef __ivanDiscreteHessianGaussianImageFilter_hxx
+#define __ivanDiscreteHessianGaussianImageFilter_hxx
+
+#include "ivanDiscreteHessianGaussianImageFilter.h"
+
+#include <algorithm>
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage>
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::DiscreteHessianGaussianImageFilter() :
+  m_MaximumError(0.005),
+  m_MaximumKernelWidth(30),
+  m_NormalizeAcrossScale(true),
+  m_Gamma(1.0),
+  m_UseImageSpacing(true),
+  m_InternalNumberOfStreamDivisions(ImageDimension * ImageDimension)
+{
+  m_Variance.Fill(1.0);
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::ComputeKernels( KernelArrayType & kernels, typename OutputImageRegionType::SizeType & radius ) const
+{
+  kernels.resize( 3 * ImageDimension );
+  radius.Fill( 0 );
+  
+  for( unsigned int direction = 0; direction < ImageDimension; ++direction )
+  {
+    for( unsigned int order = 0; order <= 2; ++order )
+    {
+      GaussianDerivativeOperatorType oper;
+      oper.SetDirection( direction );
+      oper.SetMaximumKernelWidth( m_MaximumKernelWidth );
+      oper.SetMaximumError( m_MaximumError );
+      
+      if( m_UseImageSpacing )
+      {
+        if( this->GetInput()->GetSpacing()[direction] == 0.0 )
+        {
+          itkExceptionMacro( "Pixel spacing cannot be zero" );
+        }
+        
+        oper.SetSpacing( this->GetInput()->GetSpacing()[direction] );
+      }
+      
+      // NOTE: GaussianDerivativeOperator modifies the variance when
+      // setting image spacing
+      oper.SetVariance( m_Variance[direction] );
+      oper.SetOrder( order );
+      oper.SetNormalizeAcrossScale( m_NormalizeAcrossScale );
+      oper.SetGamma( m_Gamma );
+      oper.CreateDirectional();
+      
+      radius[direction] = std::max( radius[direction], 
+        static_cast<typename OutputImageRegionType::SizeType::SizeValueType>( oper.GetRadius( direction ) ) );
+      
+      KernelType & kernel = kernels[ ImageDimension * order + direction ];
+      kernel.resize( oper.Size() );
+      
+      for( unsigned int k = 0; k < oper.Size(); ++k )
+        kernel[k] = oper[k];
+    }
+  }
+}
+
+
+template <class TInputImage, class TOutputImage>
+unsigned int 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::GetComponentIndex( const OrderArrayType & orders )
+{
+  // Directions of the two derivatives, i <= j
+  unsigned int directions[2] = { 0, 0 };
+  unsigned int found = 0;
+  
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    for( unsigned int k = 0; k < orders[d] && found < 2; ++k )
+      directions[found++] = d;
+  }
+  
+  // Upper triangle stored by rows, as in itk::SymmetricSecondRankTensor
+  const unsigned int i = directions[0];
+  const unsigned int j = directions[1];
+  
+  return i * ImageDimension - i * ( i - 1 ) / 2 + ( j - i );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError )
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  typename InputImageType::Pointer input = const_cast<InputImageType *>( this->GetInput() );
+  
+  if( !input )
+    return;
+  
+  KernelArrayType kernels;
+  typename OutputImageRegionType::SizeType radius;
+  this->ComputeKernels( kernels, radius );
+  
+  typename InputImageType::RegionType inputRequestedRegion = input->GetRequestedRegion();
+  inputRequestedRegion.PadByRadius( radius );
+  
+  if( inputRequestedRegion.Crop( input->GetLargestPossibleRegion() ) )
+  {
+    input->SetRequestedRegion( inputRequestedRegion );
+  }
+  else
+  {
+    input->SetRequestedRegion( inputRequestedRegion );
+    
+    itk::InvalidRequestedRegionError e( __FILE__, __LINE__ );
+    e.SetLocation( ITK_LOCATION );
+    e.SetDescription( "Requested region is (at least partially) outside the largest possible region." );
+    e.SetDataObject( input );
+    throw e;
+  }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::GenerateData()
+{
+  OutputImageType *output = this->GetOutput();
+  
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
+  
+  KernelArrayType kernels;
+  typename OutputImageRegionType::SizeType radius;
+  this->ComputeKernels( kernels, radius );
+  
+  const OutputImageRegionType inputRegion = this->GetInput()->GetBufferedRegion();
+  const OutputImageRegionType outputRegion = output->GetRequestedRegion();
+  
+  const unsigned int  lastAxis = ImageDimension - 1;
+  const unsigned long lastSize = outputRegion.GetSize()[lastAxis];
+  const unsigned long numberOfPieces = std::max( 1ul, 
+    std::min( static_cast<unsigned long>( m_InternalNumberOfStreamDivisions ), lastSize ) );
+  
+  // Results of the passes along each axis but the last for the current branch of the tree
+  std::vector< std::vector<RealType> > buffers( ImageDimension );
+  std::vector<OutputImageRegionType> regions( ImageDimension );
+  
+  for( unsigned long piece = 0; piece < numberOfPieces; ++piece )
+  {
+    OutputImageRegionType pieceRegion = outputRegion;
+    pieceRegion.SetIndex( lastAxis, outputRegion.GetIndex()[lastAxis] + 
+      static_cast<long>( lastSize * piece / numberOfPieces ) );
+    pieceRegion.SetSize( lastAxis, lastSize * ( piece + 1 ) / numberOfPieces - 
+      lastSize * piece / numberOfPieces );
+    
+    // The result of the pass along an axis covers the piece padded by the radius 
+    // of the remaining axes
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      typename OutputImageRegionType::SizeType passRadius;
+      for( unsigned int a = 0; a < ImageDimension; ++a )
+        passRadius[a] = ( a > d ) ? radius[a] : 0;
+      
+      regions[d] = pieceRegion;
+      regions[d].PadByRadius( passRadius );
+      regions[d].Crop( inputRegion );
+    }
+    
+    OrderArrayType orders;
+    orders.Fill( 0 );
+    
+    this->ConvolveAxis( 0, 0, orders, kernels, regions, buffers );
+    
+    this->UpdateProgress( static_cast<float>( piece + 1 ) / static_cast<float>( numberOfPieces ) );
+  }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::ConvolveAxis( unsigned int axis, unsigned int totalOrder, OrderArrayType & orders, 
+  const KernelArrayType & kernels, const std::vector<OutputImageRegionType> & regions,
+  std::vector< std::vector<RealType> > & buffers )
+{
+  const unsigned int lastAxis = ImageDimension - 1;
+  
+  itk::MultiThreader *threader = this->GetMultiThreader();
+  const unsigned int numberOfThreads = this->GetNumberOfThreads();
+  
+  // The last axis completes the order of the component to two
+  const unsigned int firstOrder = ( axis == lastAxis ) ? 2 - totalOrder : 0;
+  
+  for( unsigned int order = firstOrder; order + totalOrder <= 2; ++order )
+  {
+    orders[axis] = order;
+    
+    const KernelType & kernel = kernels[ ImageDimension * order + axis ];
+    
+    if( axis == lastAxis )
+    {
+      typename ConvolutionType::template BufferView<OutputValueType> destination = 
+        ConvolutionType::template GetImageComponentView<OutputValueType>( this->GetOutput(), 
+          regions[axis], GetComponentIndex( orders ), NumberOfComponents );
+      
+      if( axis == 0 )
+      {
+        ConvolutionType::Convolve( ConvolutionType::GetImageView( this->GetInput(), 
+          this->GetInput()->GetBufferedRegion() ), destination, axis, kernel, threader, numberOfThreads );
+      }
+      else
+      {
+        ConvolutionType::Convolve( ConvolutionType::GetArrayView( 
+          static_cast<const RealType *>( &buffers[axis-1][0] ), regions[axis-1] ), destination, 
+          axis, kernel, threader, numberOfThreads );
+      }
+    }
+    else
+    {
+      buffers[axis].resize( regions[axis].GetNumberOfPixels() );
+      
+      typename ConvolutionType::template BufferView<RealType> destination = 
+        ConvolutionType::GetArrayView( &buffers[axis][0], regions[axis] );
+      
+      if( axis == 0 )
+      {
+        ConvolutionType::Convolve( ConvolutionType::GetImageView( this->GetInput(), 
+          this->GetInput()->GetBufferedRegion() ), destination, axis, kernel, threader, numberOfThreads );
+      }
+      else
+      {
+        ConvolutionType::Convolve( ConvolutionType::GetArrayView( 
+          static_cast<const RealType *>( &buffers[axis-1][0] ), regions[axis-1] ), destination, 
+          axis, kernel, threader, numberOfThreads );
+      }
+      
+      this->ConvolveAxis( axis + 1, totalOrder + order, orders, kernels, regions, buffers );
+    }
+  }
+  
+  orders[axis] = 0;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+DiscreteHessianGaussianImageFilter<TInputImage,TOutputImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Variance: " << m_Variance << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
+  os << indent << "NormalizeAcrossScale: " << m_NormalizeAcrossScale << std::endl;
+  os << indent << "Gamma: " << m_Gamma << std::endl;
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  os << indent << "InternalNumberOfStreamDivisions: " << m_InternalNumberOfStreamDivisions << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
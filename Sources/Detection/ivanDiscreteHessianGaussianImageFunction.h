@@ -30,11 +30,16 @@ SUCH DAMAGE.
 #ifndef __ivanDiscreteHessianGaussianImageFunction_h
 #define __ivanDiscreteHessianGaussianImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanMacros.h"
 #include "ivanGaussianDerivativeOperator.h"
+#include "ivanDiscreteDerivativeCache.h"
 
 #include "itkNeighborhoodOperatorImageFunction.h"
 #include "itkSymmetricSecondRankTensor.h"
+#include "ivanNeighborhoodInnerProduct.h"
+
+#include <vector>
 
 
 namespace ivan
@@ -43,7 +48,11 @@ namespace ivan
  * \class DiscreteHessianGaussianImageFunction
  * \brief Compute the Hessian Gaussian of an image at a specific location in space
           by calculating discrete second-order gaussian derivatives.
- * This class is templated over the input image type.
+ * This class is templated over the input image type, the precision of the kernels and of 
+ * the output tensor (TOutput) and the precision of the sums of the convolutions (TAccumulator).
+ * With TOutput = float the kernels and the tensors use half the memory, which is relevant for 
+ * Hessian images (6 components per voxel in 3D). A double TAccumulator keeps most of the 
+ * accuracy of the double path in that case.
  *
  * The Initialize() method must be called after setting the parameters and before
  * evaluating the function.
@@ -56,7 +65,7 @@ namespace ivan
  * \sa NeighborhoodOperator
  * \sa ImageFunction
  */
-template< class TInputImage, class TOutput = double >
+template< class TInputImage, class TOutput = double, class TAccumulator = TOutput >
 class ITK_EXPORT DiscreteHessianGaussianImageFunction:
   public itk::ImageFunction< TInputImage,
   itk::SymmetricSecondRankTensor< TOutput, ITKImageDimensionMacro( TInputImage ) >, TOutput >
@@ -94,6 +103,9 @@ public:
   itkStaticConstMacro(ImageDimension, unsigned int,
                       InputImageType::ImageDimension);
 
+  /** Largest kernel radius evaluated by code specialized for the radius */
+  itkStaticConstMacro(MaximumFixedKernelRadius, unsigned int, 5);
+
   /** Output type */
   typedef itk::SymmetricSecondRankTensor< TOutput,
     ITKImageDimensionMacro( TInputImage ) >                         TensorType;
@@ -118,6 +130,23 @@ public:
   typedef itk::FixedArray< KernelType, itkGetStaticConstMacro(ImageDimension)
                       * ( itkGetStaticConstMacro(ImageDimension) + 1 ) / 2 >      KernelArrayType;
 
+  /** One-dimensional kernels (coefficients of the operators padded to the 
+   * maximum radius) used in the separable evaluation */
+  typedef std::vector< TOutput >                                   SeparableKernelType;
+  typedef itk::FixedArray< SeparableKernelType, 
+    3 * itkGetStaticConstMacro(ImageDimension) >                   SeparableKernelArrayType;
+
+  /** Helper for contiguous neighborhood gathering and inner products */
+  typedef TAccumulator                                             AccumulatorType;
+  typedef NeighborhoodInnerProduct< InputImageType, TOutput, 
+    TAccumulator >                                                 InnerProductType;
+
+  /** Derivative order in each direction for each of the hessian components */
+  typedef itk::FixedArray< unsigned int, 
+    itkGetStaticConstMacro(ImageDimension) >                       OrderArrayType;
+  typedef itk::FixedArray< OrderArrayType, itkGetStaticConstMacro(ImageDimension)
+                      * ( itkGetStaticConstMacro(ImageDimension) + 1 ) / 2 >      ComponentOrderArrayType;
+
   /** Image function that performs convolution with the neighborhood
    * operator  */
   typedef itk::NeighborhoodOperatorImageFunction
@@ -126,6 +155,16 @@ public:
 
   /** Interpolation modes */
   enum InterpolationModeType { NearestNeighbourInterpolation, LinearInterpolation };
+  
+  /** Cache of Hessian values that can be shared among several functions. */
+  typedef DiscreteDerivativeCache< TensorType, 
+    itkGetStaticConstMacro(ImageDimension) >             DerivativeCacheType;
+  
+  /** Bricked copy of the input image for scattered evaluations. */
+  typedef typename InnerProductType::BrickedImageType    BrickedImageType;
+  
+  /** Neighborhood gathered on the stack of the evaluating thread. */
+  typedef typename InnerProductType::ScratchBufferType   ScratchBufferType;
 
 public:
 
@@ -192,10 +231,51 @@ public:
   itkSetMacro(MaximumKernelWidth, unsigned int);
   itkGetConstMacro(MaximumKernelWidth, unsigned int);
 
-  /** Set/Get the interpolation mode. */
+  /** Set/Get the interpolation mode. In LinearInterpolation mode, if there is no derivative
+   * cache, the hessian at a continuous index is computed with a single separable convolution
+   * of the box covering the neighborhoods of the 2^N surrounding indices, with the 
+   * one-dimensional kernels interpolated at the fractional offsets. This is equivalent to 
+   * interpolating the hessians of the 2^N indices, except outside the range of indices of 
+   * the image, where those are clamped to the range. With a derivative cache the hessians of the
+   * indices are computed and interpolated, so that they can be reused. */
   itkSetMacro(InterpolationMode, InterpolationModeType);
   itkGetConstMacro(InterpolationMode, InterpolationModeType);
 
+  /** Set/Get the flag for separable evaluation at indices. If true, instead of computing
+   * the inner product of the neighborhood with each of the N(N+1)/2 precomputed
+   * N-dimensional kernels, the neighborhood is reduced one direction at a time with the
+   * one-dimensional operators, reusing the partial results shared by several components.
+   * Results are the same as with the N-dimensional kernels up to rounding. The N-dimensional
+   * kernels are only built while this is false. False by default. */
+  void SetUseSeparableEvaluation(bool useSeparableEvaluation);
+  itkGetConstMacro(UseSeparableEvaluation, bool);
+  itkBooleanMacro(UseSeparableEvaluation);
+  
+  /** Set/Get the flag for fixed radius evaluation at indices. If true, kernels of radius up to
+   * MaximumFixedKernelRadius, those of the small scales (about 1.5 voxels and below with the
+   * default MaximumError), are evaluated by code instantiated for each radius: the neighborhood
+   * is gathered in a fixed array and the inner products have a size known at compile time, 
+   * which removes most of the loop overhead of the generic code. This applies to
+   * both the separable and the N-dimensional evaluation, and results are the same up to 
+   * rounding. True by default. */
+  itkSetMacro(UseFixedRadiusKernels, bool);
+  itkGetConstMacro(UseFixedRadiusKernels, bool);
+  itkBooleanMacro(UseFixedRadiusKernels);
+
+  /** Set/Get the derivative cache. If set, values computed at indices are stored in the cache
+   * and reused in later evaluations, possibly by other functions sharing the cache. Values are 
+   * keyed by the standard deviation of the first dimension, so the cache must only be shared 
+   * between functions with the same input image and parameters other than the variance. */
+  itkSetObjectMacro(DerivativeCache, DerivativeCacheType);
+  itkGetObjectMacro(DerivativeCache, DerivativeCacheType);
+  
+  /** Set/Get a bricked copy of the input image. If set, and while it is a copy of the current 
+   * contents of the input (see BrickedImageBuffer::IsCopyOf()), neighborhoods are gathered from 
+   * it instead of the input. This improves the cache behaviour of evaluations at scattered 
+   * locations, as done by trackers, and may be shared by all the functions on the same input. */
+  itkSetObjectMacro(BrickedImage, BrickedImageType);
+  itkGetObjectMacro(BrickedImage, BrickedImageType);
+
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
    * If the BufferedRegion has changed, user must call
@@ -217,6 +297,28 @@ protected:
 
   void RecomputeGaussianKernel();
 
+  /** Evaluate the hessian at the given index using the one-dimensional operators. */
+  OutputType EvaluateSeparableAtIndex(const IndexType & index) const;
+
+  /** Evaluate the hessian at the given index with the code of the current kernel radius,
+   * which must be between 1 and MaximumFixedKernelRadius. */
+  OutputType EvaluateSmallKernelAtIndex(const IndexType & index) const;
+
+  /** Evaluate the hessian at the given index for kernels of radius VRadius. */
+  template< unsigned int VRadius >
+  OutputType EvaluateFixedRadiusAtIndex(const IndexType & index) const;
+
+  /** Evaluate the linearly interpolated hessian at baseIndex plus the given fractional 
+   * distances, gathering the neighborhoods of all the corners at once and reducing them 
+   * with the one-dimensional kernels interpolated at the distances. */
+  OutputType EvaluateInterpolatedAtContinuousIndex(const IndexType & baseIndex, 
+    const double *distance) const;
+
+  /** Reduce a gathered box with the given one-dimensional kernels, whose sizes must match 
+   * the size of the box in each direction. */
+  OutputType ReduceSeparable(const ScratchBufferType & buffer, 
+    const SeparableKernelArrayType & kernels) const;
+
 private:
 
   /** Desired variance of the discrete Gaussian function */
@@ -242,6 +344,25 @@ private:
    * derivatives */
   KernelArrayType m_KernelArray;
 
+  /** Array of one-dimensional kernels for separable evaluation, stored in the
+   * same order as m_OperatorArray */
+  SeparableKernelArrayType m_SeparableKernelArray;
+
+  /** Derivative orders of each hessian component */
+  ComponentOrderArrayType m_ComponentOrders;
+
+  /** Radius of the N-dimensional kernels */
+  unsigned int m_KernelRadius;
+
+  /** Flag for separable evaluation */
+  bool m_UseSeparableEvaluation;
+
+  /** Flag for the evaluation specialized for small kernel radii */
+  bool m_UseFixedRadiusKernels;
+
+  /** Flag for N-dimensional kernels built with the current operators */
+  bool m_KernelArrayUpToDate;
+
   /** OperatorImageFunction */
   OperatorImageFunctionPointer m_OperatorImageFunction;
 
@@ -256,14 +377,20 @@ private:
 
   /** Interpolation mode */
   InterpolationModeType m_InterpolationMode;
+  
+  /** Optional cache of computed values */
+  typename DerivativeCacheType::Pointer m_DerivativeCache;
+  
+  /** Optional bricked copy of the input */
+  typename BrickedImageType::Pointer m_BrickedImage;
 };
 
 } // namespace ivan
 
-#if 0 //HACK:  Not yet implemented
-// Define instantiation macro for this template.
-#define ITK_TEMPLATE_DiscreteHessianGaussianImageFunction(_, EXPORT, TypeX, TypeY)     \
-  namespace itk                                                                        \
+// Define instantiation macro for this template. Not named ITK_TEMPLATE_ as the one of
+// itk::DiscreteHessianGaussianImageFunction, which may be included in the same unit.
+#define IVAN_TEMPLATE_DiscreteHessianGaussianImageFunction(_, EXPORT, TypeX, TypeY)    \
+  namespace ivan                                                                       \
   {                                                                                    \
   _( 2 ( class EXPORT DiscreteHessianGaussianImageFunction< ITK_TEMPLATE_2 TypeX > ) ) \
   namespace Templates                                                                  \
@@ -273,9 +400,8 @@ private:
   }                                                                                    \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
-#include "Templates/ivanDiscreteHessianGaussianImageFunction+-.h"
-#endif
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanDiscreteHessianGaussianImageFunction+-.h"
 #endif
 
 #if ITK_TEMPLATE_TXX
@@ -32,30 +32,32 @@ SUCH DAMAGE.
 
 #include "ivanDiscreteHessianGaussianImageFunction.h"
 
-#include "itkNeighborhoodOperatorImageFilter.h"
-
 namespace ivan
 {
 
 /** Set the Input Image */
-template< class TInputImage, class TOutput >
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::DiscreteHessianGaussianImageFunction():
   m_MaximumError(0.005),
   m_MaximumKernelWidth(30),
   m_NormalizeAcrossScale(true),
   m_Gamma(1.0),
   m_UseImageSpacing(true),
-  m_InterpolationMode(NearestNeighbourInterpolation)
+  m_InterpolationMode(NearestNeighbourInterpolation),
+  m_KernelRadius(0),
+  m_UseSeparableEvaluation(false),
+  m_UseFixedRadiusKernels(true),
+  m_KernelArrayUpToDate(false)
 {
   m_Variance.Fill(1.0);
   m_OperatorImageFunction = OperatorImageFunctionType::New();
 }
 
 /** Print self method */
-template< class TInputImage, class TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
 void
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::PrintSelf(std::ostream & os, itk::Indent indent) const
 {
   this->Superclass::PrintSelf(os, indent);
@@ -69,12 +71,16 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
   os << indent << "KernelArray: " << m_KernelArray << std::endl;
   os << indent << "OperatorImageFunction: " << m_OperatorImageFunction << std::endl;
   os << indent << "InterpolationMode: " << m_InterpolationMode << std::endl;
+  os << indent << "UseSeparableEvaluation: " << m_UseSeparableEvaluation << std::endl;
+  os << indent << "UseFixedRadiusKernels: " << m_UseFixedRadiusKernels << std::endl;
+  os << indent << "DerivativeCache: " << m_DerivativeCache.GetPointer() << std::endl;
+  os << indent << "BrickedImage: " << m_BrickedImage.GetPointer() << std::endl;
 }
 
 /** Set the input image */
-template< class TInputImage, class TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
 void
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::SetInputImage(const InputImageType *ptr)
 {
   Superclass::SetInputImage(ptr);
@@ -83,9 +89,9 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
 
 /** Recompute the gaussian kernel used to evaluate indexes
  *  This should use a fastest Derivative Gaussian operator */
-template< class TInputImage, class TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
 void
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::RecomputeGaussianKernel()
 {
   /* Create 3*N operators (N=ImageDimension) where the
@@ -135,40 +141,31 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
       }
     }
 
-  // Now precompute the N-dimensional kernel. This fastest as we don't
-  // have to perform N convolutions for each point we calculate but
-  // only one.
-
-  typedef itk::Image< TOutput, itkGetStaticConstMacro(ImageDimension) > KernelImageType;
-  typename KernelImageType::Pointer kernelImage = KernelImageType::New();
-
-  typedef typename KernelImageType::RegionType RegionType;
-  RegionType region;
+  m_KernelRadius = maxRadius;
 
-  typename RegionType::SizeType size;
-  size.Fill(4 * maxRadius + 1);
-  region.SetSize(size);
+  // Store the coefficients of the operators padded to the maximum radius for the
+  // separable evaluation. Coefficients are stored reversed, since a kernel obtained
+  // by correlating an impulse with an operator is the reversed operator
+  const unsigned int kernelSize = 2 * maxRadius + 1;
 
-  kernelImage->SetRegions(region);
-  kernelImage->Allocate();
-  kernelImage->FillBuffer(itk::NumericTraits< TOutput >::Zero);
+  for ( idx = 0; idx < m_OperatorArray.Size(); ++idx )
+    {
+    const unsigned int direction = idx % itkGetStaticConstMacro(ImageDimension);
+    const int operatorRadius = m_OperatorArray[idx].GetRadius()[direction];
 
-  // Initially the kernel image will be an impulse at the center
-  typename KernelImageType::IndexType centerIndex;
-  centerIndex.Fill(2 * maxRadius);   // include also boundaries
+    m_SeparableKernelArray[idx].assign( kernelSize, itk::NumericTraits< TOutput >::Zero );
 
-  // Create an image region to be used later that does not include boundaries
-  RegionType kernelRegion;
-  size.Fill(2 * maxRadius + 1);
-  typename RegionType::IndexType origin;
-  origin.Fill(maxRadius);
-  kernelRegion.SetSize(size);
-  kernelRegion.SetIndex(origin);
+    for ( int k = -operatorRadius; k <= operatorRadius; ++k )
+      {
+      m_SeparableKernelArray[idx][maxRadius + k] = m_OperatorArray[idx][operatorRadius - k];
+      }
+    }
 
-  // Now create an image filter to perform sucessive convolutions
-  typedef itk::NeighborhoodOperatorImageFilter< KernelImageType, KernelImageType >
-  NeighborhoodFilterType;
-  typename NeighborhoodFilterType::Pointer convolutionFilter = NeighborhoodFilterType::New();
+  // Now precompute the N-dimensional kernels. This is fastest as we don't
+  // have to perform N convolutions for each point we calculate but
+  // only one. Since the operators are separable, each kernel is the outer
+  // product of the one-dimensional kernels of its orders. The kernels are
+  // not needed by the separable evaluation, and built when it is turned off
 
   // Array that stores the current order for each direction
   typedef itk::FixedArray< unsigned int, itkGetStaticConstMacro(ImageDimension) > OrderArrayType;
@@ -178,7 +175,7 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
   // The order of calculation in the 3D case is: dxx, dxy, dxz, dyy,
   // dyz, dzz
 
-  unsigned int opidx; // current operator index in m_OperatorArray
+  itk::FixedArray< const TOutput *, itkGetStaticConstMacro(ImageDimension) > kernels;
   unsigned int kernelidx = 0;
 
   for ( unsigned int i = 0; i < itkGetStaticConstMacro(ImageDimension); ++i )
@@ -189,59 +186,250 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
       ++orderArray[i];
       ++orderArray[j];
 
-      // Reset kernel image
-      kernelImage->FillBuffer(itk::NumericTraits< TOutput >::Zero);
-      kernelImage->SetPixel(centerIndex, itk::NumericTraits< TOutput >::One);
-
       for ( unsigned int direction = 0; direction < itkGetStaticConstMacro(ImageDimension); ++direction )
         {
-        opidx = itkGetStaticConstMacro(ImageDimension) * orderArray[direction] + direction;
-        convolutionFilter->SetInput(kernelImage);
-        convolutionFilter->SetOperator(m_OperatorArray[opidx]);
-        convolutionFilter->Update();
-        kernelImage = convolutionFilter->GetOutput();
-        kernelImage->DisconnectPipeline();
+        m_ComponentOrders[kernelidx][direction] = orderArray[direction];
+        kernels[direction] = &m_SeparableKernelArray[itkGetStaticConstMacro(ImageDimension) *
+                                                     orderArray[direction] + direction][0];
         }
 
-      // Set the size of the current kernel
-      m_KernelArray[kernelidx].SetRadius(maxRadius);
+      if ( !m_UseSeparableEvaluation )
+        {
+        // Set the size of the current kernel
+        m_KernelArray[kernelidx].SetRadius(maxRadius);
 
-      // Copy kernel image to neighborhood. Do not copy boundaries.
-      itk::ImageRegionConstIterator< KernelImageType > it(kernelImage, kernelRegion);
-      it.GoToBegin();
-      idx = 0;
+        // The first direction varies fastest in the neighborhood. The products are taken in
+        // the same order as the successive convolutions of an impulse with the operators
+        for ( idx = 0; idx < m_KernelArray[kernelidx].Size(); ++idx )
+          {
+          TOutput      value = itk::NumericTraits< TOutput >::One;
+          unsigned int offset = idx;
 
-      while ( !it.IsAtEnd() )
-        {
-        m_KernelArray[kernelidx][idx] = it.Get();
-        ++idx;
-        ++it;
+          for ( unsigned int direction = 0; direction < itkGetStaticConstMacro(ImageDimension); ++direction )
+            {
+            value *= kernels[direction][offset % kernelSize];
+            offset /= kernelSize;
+            }
+
+          m_KernelArray[kernelidx][idx] = value;
+          }
         }
       kernelidx++;
       }
     }
+
+  m_KernelArrayUpToDate = !m_UseSeparableEvaluation;
+}
+
+/** Set the flag for separable evaluation */
+template< class TInputImage, class TOutput, class TAccumulator >
+void
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::SetUseSeparableEvaluation(bool useSeparableEvaluation)
+{
+  if ( m_UseSeparableEvaluation == useSeparableEvaluation )
+    {
+    return;
+    }
+
+  m_UseSeparableEvaluation = useSeparableEvaluation;
+
+  if ( !m_UseSeparableEvaluation && !m_KernelArrayUpToDate )
+    {
+    this->RecomputeGaussianKernel();
+    }
+
+  this->Modified();
 }
 
 /** Evaluate the function at the specifed index */
-template< class TInputImage, class TOutput >
-typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput >::OutputType
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::EvaluateAtIndex(const IndexType & index) const
 {
   OutputType hessian;
 
-  for ( unsigned int i = 0; i < m_KernelArray.Size(); ++i )
+  const double scale = vcl_sqrt( m_Variance[0] );
+
+  if ( m_DerivativeCache.IsNotNull() && m_DerivativeCache->Find( scale, index, hessian ) )
+    {
+    return hessian;
+    }
+
+  if ( m_UseFixedRadiusKernels && m_KernelRadius >= 1 &&
+       m_KernelRadius <= itkGetStaticConstMacro(MaximumFixedKernelRadius) )
+    {
+    hessian = this->EvaluateSmallKernelAtIndex(index);
+    }
+  else if ( m_UseSeparableEvaluation )
+    {
+    hessian = this->EvaluateSeparableAtIndex(index);
+    }
+  else
+    {
+    // All the kernelshave the same radius, so the neighborhood is gathered only once
+    typename InnerProductType::ScratchBufferType buffer( m_KernelArray[0].Size() );
+    InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, 
+      m_KernelArray[0].GetRadius(), buffer.GetDataPointer() );
+
+    for ( unsigned int i = 0; i < m_KernelArray.Size(); ++i )
+      {
+      hessian[i] = InnerProductType::InnerProduct( m_KernelArray[i], buffer );
+      }
+    }
+
+  if ( m_DerivativeCache.IsNotNull() )
     {
-    m_OperatorImageFunction->SetOperator(m_KernelArray[i]);
-    hessian[i] = m_OperatorImageFunction->EvaluateAtIndex(index);
+    m_DerivativeCache->Insert( scale, index, hessian );
     }
+
   return hessian;
 }
 
+/** Evaluate the function at the specifed index using the one-dimensional operators */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateSeparableAtIndex(const IndexType & index) const
+{
+  // Gather the neighborhood in a buffer where the first direction varies fastest
+  typename InnerProductType::SizeType radiusSize;
+  radiusSize.Fill( m_KernelRadius );
+
+  typename InnerProductType::ScratchBufferType buffer( 
+    InnerProductType::GetNeighborhoodSize( radiusSize ) );
+  InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, radiusSize, 
+    buffer.GetDataPointer() );
+
+  return this->ReduceSeparable( buffer, m_SeparableKernelArray );
+}
+
+/** Evaluate the function at the specifed index with the code of the kernel radius */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateSmallKernelAtIndex(const IndexType & index) const
+{
+  switch ( m_KernelRadius )
+    {
+    case 1:
+      return this->template EvaluateFixedRadiusAtIndex< 1 >(index);
+    case 2:
+      return this->template EvaluateFixedRadiusAtIndex< 2 >(index);
+    case 3:
+      return this->template EvaluateFixedRadiusAtIndex< 3 >(index);
+    case 4:
+      return this->template EvaluateFixedRadiusAtIndex< 4 >(index);
+    default: // MaximumFixedKernelRadius
+      return this->template EvaluateFixedRadiusAtIndex< 5 >(index);
+    }
+}
+
+/** Evaluate the function at the specifed index for kernels of a fixed radius */
+template< class TInputImage, class TOutput, class TAccumulator >
+template< unsigned int VRadius >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateFixedRadiusAtIndex(const IndexType & index) const
+{
+  const unsigned int kernelSize = 2 * VRadius + 1;
+  const unsigned int neighborhoodSize = 
+    IntegerPower< kernelSize, itkGetStaticConstMacro(ImageDimension) >::Value;
+
+  typename InnerProductType::SizeType radiusSize;
+  radiusSize.Fill( VRadius );
+
+  TOutput box[neighborhoodSize];
+  InnerProductType::Gather( this->GetInputImage(), m_BrickedImage.GetPointer(), index, radiusSize, box );
+
+  OutputType hessian;
+
+  if ( m_UseSeparableEvaluation )
+    {
+    InnerProductType::template FixedSizeReduceSeparable< kernelSize >( box, m_SeparableKernelArray, 
+      m_ComponentOrders, m_ComponentOrders.Size(), hessian );
+    }
+  else
+    {
+    for ( unsigned int i = 0; i < m_KernelArray.Size(); ++i )
+      {
+      hessian[i] = InnerProductType::template FixedSizeInnerProduct< neighborhoodSize >( &m_KernelArray[i][0], box );
+      }
+    }
+
+  return hessian;
+}
+
+/** Reduce a gathered box with one-dimensional kernels, one direction at a time */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::ReduceSeparable(const ScratchBufferType & buffer, const SeparableKernelArrayType & kernels) const
+{
+  OutputType hessian;
+  InnerProductType::ReduceSeparable( buffer.GetDataPointer(), buffer.Size(), kernels, 
+    m_ComponentOrders, m_ComponentOrders.Size(), hessian );
+
+  return hessian;
+}
+
+/** Evaluate the linearly interpolated hessian with a single gather and separable reduction */
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
+::EvaluateInterpolatedAtContinuousIndex(const IndexType & baseIndex, const double *distance) const
+{
+  const unsigned int dimension = itkGetStaticConstMacro(ImageDimension);
+  const unsigned int kernelSize = 2 * m_KernelRadius + 1;
+
+  // The interpolated hessian is the sum of the convolutions at the corners weighted by 
+  // their overlaps, which is the convolution with the same sum of shifted kernels. Both 
+  // the weights and the kernels are separable, so in each direction with a non-zero 
+  // distance the kernel becomes (1-t)*k[j] + t*k[j-1], one element longer
+  typename InnerProductType::RegionType region;
+  typename InnerProductType::IndexType  regionIndex;
+  typename InnerProductType::SizeType   regionSize;
+
+  SeparableKernelArrayType kernels;
+
+  for ( unsigned int d = 0; d < dimension; ++d )
+    {
+    const bool shifted = ( distance[d] > 0.0 );
+
+    regionIndex[d] = baseIndex[d] - static_cast< IndexValueType >( m_KernelRadius );
+    regionSize[d] = kernelSize + ( shifted ? 1 : 0 );
+
+    for ( unsigned int order = 0; order <= 2; ++order )
+      {
+      const unsigned int idx = dimension * order + d;
+      const SeparableKernelType & kernel = m_SeparableKernelArray[idx];
+
+      if ( shifted )
+        {
+        InnerProductType::InterpolateKernel( kernel, distance[d], kernels[idx] );
+        }
+      else
+        {
+        kernels[idx] = kernel;
+        }
+      }
+    }
+
+  region.SetIndex( regionIndex );
+  region.SetSize( regionSize );
+
+  typename InnerProductType::ScratchBufferType buffer( region.GetNumberOfPixels() );
+  InnerProductType::GatherRegion( this->GetInputImage(), m_BrickedImage.GetPointer(), region, 
+    buffer.GetDataPointer() );
+
+  return this->ReduceSeparable( buffer, kernels );
+}
+
 /** Evaluate the function at the specifed point */
-template< class TInputImage, class TOutput >
-typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput >::OutputType
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::Evaluate(const PointType & point) const
 {
   if ( m_InterpolationMode == NearestNeighbourInterpolation )
@@ -259,9 +447,9 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
 }
 
 /** Evaluate the function at specified ContinousIndex position.*/
-template< class TInputImage, class TOutput >
-typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput >::OutputType
-DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
+template< class TInputImage, class TOutput, class TAccumulator >
+typename DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >::OutputType
+DiscreteHessianGaussianImageFunction< TInputImage, TOutput, TAccumulator >
 ::EvaluateAtContinuousIndex(const ContinuousIndexType & cindex) const
 {
   // TODO: we should think on resuing code latest code of itk::LinearInterpolateImageFunction for this
@@ -290,6 +478,13 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
       distance[dim] = cindex[dim] - static_cast< double >( baseIndex[dim] );
       }
 
+    // Without a cache the corners can not be reused, so convolve once with the 
+    // interpolated kernels instead
+    if ( m_DerivativeCache.IsNull() )
+      {
+      return this->EvaluateInterpolatedAtContinuousIndex(baseIndex, distance);
+      }
+
     // Interpolated value is the weighted sum of each of the surrounding
     // neighbors. The weight for each neighbor is the fraction overlap
     // of the neighbor pixel with respect to a pixel centered on point.
@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanFilterByEigenValuesVesselnessImageFunction_h
 #define __ivanFilterByEigenValuesVesselnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianOnlyBasedVesselnessImageFunction.h"
 
 
@@ -61,10 +62,7 @@ public:
   
   inline bool operator() ( const EigenValuesArrayType & eigenValues ) const
   {
-    if( eigenValues[0] < 0.0 && eigenValues[1] < 0.0 )
-      return true;
-    else
-      return false;
+    return ( eigenValues[0] < 0.0 ) & ( eigenValues[1] < 0.0 );
   }
 };
 
@@ -118,6 +116,8 @@ public:
     <TInputImage,TCoordRep>                          HessianFunctionType;
   typedef typename HessianFunctionType::Pointer      HessianFunctionPointer;
   typedef typename HessianFunctionType::TensorType   HessianTensorType;
+  typedef typename Superclass::EigenValuesArrayType  EigenValuesArrayType;
+  typedef typename Superclass::EigenValueType        EigenValueType;
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType InterpolationModeType;
@@ -163,6 +163,13 @@ public:
       }
     }
   
+  /** Evaluate vesselness from the eigenvalues of the Hessian matrix, in ascending order. */
+  virtual OutputType EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const;
+  
+  /** Evaluate vesselness from the eigenvalues stored by component, without branches. */
+  virtual void EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+    unsigned long numberOfValues, OutputType * vesselness ) const;
+  
 protected:
 
   FilterByEigenValuesVesselnessImageFunction();
@@ -193,7 +200,7 @@ private:
                                                   FilterByEigenValuesVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanFilterByEigenValuesVesselnessImageFunction+-.h"
 #endif
 
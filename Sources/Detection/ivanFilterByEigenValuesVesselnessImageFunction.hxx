@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #define __ivanFilterByEigenValuesVesselnessImageFunction_hxx
 
 #include "ivanFilterByEigenValuesVesselnessImageFunction.h"
+#include "ivanSymmetricEigenSolver.h"
 
 
 namespace ivan
@@ -70,18 +71,48 @@ typename FilterByEigenValuesVesselnessImageFunction<TInputImage,TOutput,TFunctor
 FilterByEigenValuesVesselnessImageFunction<TInputImage,TOutput,TFunctor,TCoordRep>
 ::EvaluateVesselness( const HessianTensorType & hessian ) const
 {
-  typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
   EigenValuesArrayType   eigenValues;
   
   // Calculate eigenvalues of Hessian matrix at the current location
-  hessian.ComputeEigenValues( eigenValues );
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
   
+  return this->EvaluateVesselnessFromEigenValues( eigenValues );
+}
+
+
+template <class TInputImage, class TOutput, class TFunctor, class TCoordRep>
+typename FilterByEigenValuesVesselnessImageFunction<TInputImage,TOutput,TFunctor,TCoordRep>::OutputType
+FilterByEigenValuesVesselnessImageFunction<TInputImage,TOutput,TFunctor,TCoordRep>
+::EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const
+{
   if( m_Functor( eigenValues ) )
     return m_OutputValue;
   else
     return 0.0;
 }
 
+
+template <class TInputImage, class TOutput, class TFunctor, class TCoordRep>
+void
+FilterByEigenValuesVesselnessImageFunction<TInputImage,TOutput,TFunctor,TCoordRep>
+::EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+  unsigned long numberOfValues, OutputType * vesselness ) const
+{
+  const OutputType outputValue = static_cast<OutputType>( m_OutputValue );
+  const OutputType zero = itk::NumericTraits<OutputType>::Zero;
+  
+  // The functor is inlined in the loop, so a functor made of comparisons becomes a mask
+  EigenValuesArrayType set;
+  
+  for( unsigned long k=0; k<numberOfValues; ++k )
+  {
+    for( unsigned int i=0; i<EigenValuesArrayType::Dimension; ++i )
+      set[i] = eigenValues[i][k];
+    
+    vesselness[k] = m_Functor( set ) ? outputValue : zero;
+  }
+}
+
 } // end namespace ivan
 
 #endif
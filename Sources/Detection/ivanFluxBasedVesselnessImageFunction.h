@@ -30,9 +30,13 @@ SUCH DAMAGE.
 #ifndef __ivanFluxBasedVesselnessImageFunction_h
 #define __ivanFluxBasedVesselnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianBasedVesselnessImageFunction.h"
 #include "ivanDiscreteGradientGaussianImageFunction.h"
 
+#include "itkGradientRecursiveGaussianImageFilter.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
+#include "itkCovariantVector.h"
 #include "itkArray.h"
 #include "itkVector.h"
 
@@ -50,6 +54,12 @@ namespace ivan
  * of the surface normals and a proper scale, the flux will be maximum.
  *
  * Subclasses differ in how this flux is calculated, the number of samples an linearity or not.
+ *
+ * First order Gaussian derivatives are steerable, so the derivative along any direction is the
+ * dot product of that direction with the x/y/z derivatives. If UseGradientImage is on, these 
+ * basis derivatives are precomputed once per scale for the whole image and directional 
+ * derivatives at the sampled points are obtained by linear interpolation in this image instead 
+ * of a Gaussian derivative convolution per point (see EvaluateDirectionalDerivative()).
  * 
  * The Initialize() method must be called after setting the parameters and before
  * evaluating the function.
@@ -91,6 +101,17 @@ public:
   typedef DiscreteGradientGaussianImageFunction
     <TInputImage,TOutput>                                 GradientFunctionType;
   typedef typename GradientFunctionType::Pointer          GradientFunctionPointer;
+  typedef typename GradientFunctionType::DerivativeCacheType   GradientCacheType;
+  
+  /** Types for the precomputed gradient (steerable basis) image. */
+  typedef itk::CovariantVector<TOutput,
+    InputImageType::ImageDimension>                       GradientPixelType;
+  typedef itk::Image<GradientPixelType,
+    InputImageType::ImageDimension>                       GradientImageType;
+  typedef typename GradientImageType::Pointer             GradientImagePointer;
+  typedef itk::VectorLinearInterpolateImageFunction
+    <GradientImageType,TCoordRep>                         GradientInterpolatorType;
+  typedef typename GradientInterpolatorType::Pointer      GradientInterpolatorPointer;
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType      InterpolationModeType;
@@ -113,6 +134,31 @@ public:
     * the scale to the gradient function too. */
   virtual void SetSigma( double sigma );
   
+  /** Set/Get a cache for gradient vectors that may be shared with other functions operating on the 
+    * same image with the same gradient parameters (except the scale). */
+  virtual void SetGradientCache( GradientCacheType *cache )
+    { m_GradientFunction->SetDerivativeCache( cache ); }
+  virtual GradientCacheType * GetGradientCache()
+    { return m_GradientFunction->GetDerivativeCache(); }
+  
+  /** Set/Get the flag for using a precomputed gradient image. If set, Initialize() computes the 
+    * gradient of the whole image at the current scale once with recursive Gaussian filters and
+    * directional derivatives at shifted points are steered from the linearly interpolated basis 
+    * gradient. This is much faster for whole-image evaluation but needs a vector image of the 
+    * size of the input per scale (see GetGradientImageMemorySize()). Default is false. */
+  itkSetMacro( UseGradientImage, bool );
+  itkGetConstMacro( UseGradientImage, bool );
+  itkBooleanMacro( UseGradientImage );
+  
+  /** Set/Get the precomputed gradient image. A gradient image computed by another function with 
+    * the same input and Sigma may be set here so that it is shared. If not set, it is 
+    * computed in Initialize() when UseGradientImage is on. */
+  virtual void SetGradientImage( GradientImageType *image );
+  itkGetObjectMacro( GradientImage, GradientImageType );
+  
+  /** Memory used by the gradient image in bytes (zero if there is no gradient image). */
+  unsigned long GetGradientImageMemorySize() const;
+  
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
    * If the BufferedRegion has changed, user must call
@@ -128,6 +174,22 @@ protected:
   ~FluxBasedVesselnessImageFunction();
   
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Compute the gradient image at the current scale. */
+  virtual void ComputeGradientImage();
+  
+  /** Evaluate the first derivative along the given (unit) direction at a physical point. This
+    * is steered from the precomputed gradient image if UseGradientImage is on, or computed with 
+    * the gradient function otherwise. Returns false if the point is outside the buffer, in which 
+    * case derivative is set to zero. */
+  bool EvaluateDirectionalDerivative( const PointType & point, const VectorType & direction, 
+    double & derivative ) const;
+  
+  /** Evaluate the gradient at a continuous index, interpolated from the precomputed gradient 
+    * image if UseGradientImage is on, or computed with the gradient function otherwise. The
+    * index must be inside the buffer. */
+  void EvaluateGradientAtContinuousIndex( const ContinuousIndexType & cindex, 
+    VectorType & gradient ) const;
 
 private:
   
@@ -138,6 +200,12 @@ protected:
   
   /** Image function used to calculate gradients. */
   GradientFunctionPointer  m_GradientFunction;
+  
+  /** Precomputed gradient image and its interpolator. */
+  bool                          m_UseGradientImage;
+  GradientImagePointer          m_GradientImage;
+  double                        m_GradientImageSigma;
+  GradientInterpolatorPointer   m_GradientInterpolator;
 
   /** Radius factor. This value is multiplied by the current scale to obtain the distance 
     * (radius) at which points are sampled in a circle (by default sqrt(3.0) which gives the 
@@ -154,7 +222,7 @@ protected:
                                                   FluxBasedVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanFluxBasedVesselnessImageFunction+-.h"
 #endif
 
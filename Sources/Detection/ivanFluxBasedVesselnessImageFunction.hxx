@@ -39,13 +39,17 @@ namespace ivan
 template <class TInputImage, class TOutput, class TCoordRep>
 FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::FluxBasedVesselnessImageFunction() :
-  m_RadiusFactor( 1.7320508 ) // = sqrt(3.0)
+  m_RadiusFactor( 1.7320508 ), // = sqrt(3.0)
+  m_UseGradientImage( false ),
+  m_GradientImageSigma( 0.0 )
 {
   m_GradientFunction = GradientFunctionType::New();
   m_GradientFunction->NormalizeAcrossScaleOn();
   m_GradientFunction->UseImageSpacingOn();
   m_GradientFunction->SetInterpolationMode( GradientFunctionType::LinearInterpolation );
   m_GradientFunction->SetSigma( this->m_Sigma );
+  
+  m_GradientInterpolator = GradientInterpolatorType::New();
 }
 
 
@@ -66,6 +70,9 @@ FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   Superclass::PrintSelf( os, indent );
     
   os << indent << "RadiusFactor: " << m_RadiusFactor << std::endl;
+  os << indent << "UseGradientImage: " << m_UseGradientImage << std::endl;
+  os << indent << "GradientImageSigma: " << m_GradientImageSigma << std::endl;
+  os << indent << "GradientImageMemorySize: " << this->GetGradientImageMemorySize() << std::endl;
 }
 
 
@@ -78,6 +85,9 @@ FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
     return;
     
   Superclass::SetSigma( sigma );
+  
+  // The superclass only passes the scale to the Hessian function
+  this->m_Sigma = sigma;
     
   this->m_GradientFunction->SetSigma( sigma );
 }
@@ -89,6 +99,9 @@ void
 FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::SetInputImage( const InputImageType * ptr )
 {
+  if( ptr != this->GetInputImage() )
+    this->m_GradientImage = 0;
+  
   Superclass::SetInputImage( ptr );
   
   this->m_GradientFunction->SetInputImage( ptr ); 
@@ -103,6 +116,128 @@ FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   Superclass::Initialize();
   
   this->m_GradientFunction->Initialize();
+  
+  if( this->m_UseGradientImage )
+  {
+    if( this->m_GradientImage.IsNull() || this->m_GradientImageSigma != this->m_Sigma )
+      this->ComputeGradientImage();
+      
+    this->m_GradientInterpolator->SetInputImage( this->m_GradientImage );
+  }
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::SetGradientImage( GradientImageType *image )
+{
+  if( this->m_GradientImage == image )
+    return;
+  
+  // The image is assumed to be computed with the current scale
+  this->m_GradientImage = image;
+  this->m_GradientImageSigma = this->m_Sigma;
+  this->Modified();
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+unsigned long
+FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::GetGradientImageMemorySize() const
+{
+  if( this->m_GradientImage.IsNull() )
+    return 0;
+  
+  return this->m_GradientImage->GetBufferedRegion().GetNumberOfPixels() * sizeof( GradientPixelType );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::ComputeGradientImage()
+{
+  if( !this->GetInputImage() )
+  {
+    itkExceptionMacro( "Input image must be set before computing the gradient image." );
+  }
+  
+  // Same normalization as the gradient function so both modes give comparable fluxes
+  typedef itk::GradientRecursiveGaussianImageFilter<InputImageType,GradientImageType>  GradientFilterType;
+  
+  typename GradientFilterType::Pointer gradientFilter = GradientFilterType::New();
+  gradientFilter->SetInput( this->GetInputImage() );
+  gradientFilter->SetSigma( this->m_Sigma );
+  gradientFilter->SetNormalizeAcrossScale( true );
+  gradientFilter->Update();
+  
+  this->m_GradientImage = gradientFilter->GetOutput();
+  this->m_GradientImage->DisconnectPipeline();
+  this->m_GradientImageSigma = this->m_Sigma;
+  
+  itkDebugMacro( "Gradient image computed with sigma " << this->m_Sigma << ", memory used: " 
+    << this->GetGradientImageMemorySize() << " bytes" );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+bool
+FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateDirectionalDerivative( const PointType & point, const VectorType & direction, 
+  double & derivative ) const
+{
+  derivative = 0.0;
+  
+  if( this->m_UseGradientImage )
+  {
+    if( !this->m_GradientInterpolator->IsInsideBuffer( point ) )
+      return false;
+    
+    const typename GradientInterpolatorType::OutputType gradient = 
+      this->m_GradientInterpolator->Evaluate( point );
+    
+    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
+      derivative += gradient[i] * direction[i];
+  }
+  else
+  {
+    if( !this->m_GradientFunction->IsInsideBuffer( point ) )
+      return false;
+    
+    const typename GradientFunctionType::OutputType gradient = 
+      this->m_GradientFunction->Evaluate( point );
+    
+    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
+      derivative += gradient[i] * direction[i];
+  }
+  
+  return true;
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+FluxBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradientAtContinuousIndex( const ContinuousIndexType & cindex, VectorType & gradient ) const
+{
+  if( this->m_UseGradientImage )
+  {
+    const typename GradientInterpolatorType::OutputType value = 
+      this->m_GradientInterpolator->EvaluateAtContinuousIndex( cindex );
+    
+    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
+      gradient[i] = value[i];
+  }
+  else
+  {
+    const typename GradientFunctionType::OutputType value = 
+      this->m_GradientFunction->EvaluateAtContinuousIndex( cindex );
+    
+    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
+      gradient[i] = value[i];
+  }
 }
   
 } // end namespace ivan
@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanFrangiVesselnessImageFunction_h
 #define __ivanFrangiVesselnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianOnlyBasedVesselnessImageFunction.h"
 
 
@@ -77,6 +78,8 @@ public:
     <TInputImage,TCoordRep>                          HessianFunctionType;
   typedef typename HessianFunctionType::Pointer      HessianFunctionPointer;
   typedef typename HessianFunctionType::TensorType   HessianTensorType;
+  typedef typename Superclass::EigenValuesArrayType  EigenValuesArrayType;
+  typedef typename Superclass::EigenValueType        EigenValueType;
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType InterpolationModeType;
@@ -95,6 +98,13 @@ public:
   itkSetMacro( Beta, double );
   itkGetConstMacro( Beta, double );
   
+  /** Evaluate vesselness from the eigenvalues of the Hessian matrix, in ascending order. */
+  virtual OutputType EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const;
+  
+  /** Evaluate vesselness from the eigenvalues stored by component, without branches. */
+  virtual void EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+    unsigned long numberOfValues, OutputType * vesselness ) const;
+  
 protected:
 
   FrangiVesselnessImageFunction();
@@ -131,7 +141,7 @@ private:
                                                   FrangiVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanFrangiVesselnessImageFunction+-.h"
 #endif
 
@@ -32,7 +32,7 @@ SUCH DAMAGE.
 
 #include "ivanFrangiVesselnessImageFunction.h"
 
-#include "itkSymmetricEigenAnalysis.h"
+#include "ivanSymmetricEigenSolver.h"
 
 
 namespace ivan
@@ -76,31 +76,23 @@ typename FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputTyp
 FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::EvaluateVesselness( const HessianTensorType & hessian ) const
 {
-  typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
   EigenValuesArrayType   eigenValues;
   
   // Calculate eigenvalues of Hessian matrix at the current location
-  // We cannot use SymmetricSecondRankTensor::ComputeEigenValues() since currently it computes
-  // eigenvalues ordering by value and not by absolute value which is required by this filter
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
   
-  //hessian.ComputeEigenValues( eigenValues );
-  
-  typedef typename HessianTensorType::SymmetricEigenAnalysisType EigenAnalysisType;
-  typedef typename HessianTensorType::MatrixType                 MatrixType;
-    
-  EigenAnalysisType eigenAnalysis = EigenAnalysisType( HessianTensorType::Dimension );
-    
-  MatrixType hessianMatrix;
-  for( unsigned int row=0; row < HessianTensorType::Dimension; row++ )
-  {
-    for( unsigned int col=0; col < HessianTensorType::Dimension; col++ )
-    {
-      hessianMatrix[row][col] = hessian(row,col);
-    }
-  }
-  
-  eigenAnalysis.SetOrderEigenMagnitudes( true );
-  eigenAnalysis.ComputeEigenValues( hessianMatrix, eigenValues );     
+  return this->EvaluateVesselnessFromEigenValues( eigenValues );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & ascendingEigenValues ) const
+{
+  // This measure requires the eigenvalues ordered by magnitude and not by value
+  EigenValuesArrayType eigenValues = ascendingEigenValues;
+  SymmetricEigenSolver<HessianTensorType>::OrderEigenValuesByMagnitude( eigenValues );
   
   if( vnl_math_abs( eigenValues[2] ) < 1e-3 )
     return 0.0;
@@ -131,6 +123,57 @@ FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   return lineMeasure;   
 }
 
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+FrangiVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+  unsigned long numberOfValues, OutputType * vesselness ) const
+{
+  const EigenValueType *l0 = eigenValues[0];
+  const EigenValueType *l1 = eigenValues[1];
+  const EigenValueType *l2 = eigenValues[2];
+  
+  const double alpha = m_Alpha;
+  const double beta = m_Beta;
+  const double gamma = m_Gamma;
+  
+  // Same terms as EvaluateVesselnessFromEigenValues(), with selects instead of branches
+  for( unsigned long k=0; k<numberOfValues; ++k )
+  {
+    double e0 = l0[k];
+    double e1 = l1[k];
+    double e2 = l2[k];
+    
+    // Order by magnitude with three compare-exchanges
+    double t;
+    bool swap;
+    
+    swap = vnl_math_abs( e0 ) > vnl_math_abs( e1 );
+    t = swap ? e0 : e1;  e0 = swap ? e1 : e0;  e1 = t;
+    swap = vnl_math_abs( e1 ) > vnl_math_abs( e2 );
+    t = swap ? e1 : e2;  e1 = swap ? e2 : e1;  e2 = t;
+    swap = vnl_math_abs( e0 ) > vnl_math_abs( e1 );
+    t = swap ? e0 : e1;  e0 = swap ? e1 : e0;  e1 = t;
+    
+    const double a1 = vnl_math_abs( e1 );
+    const double a2 = vnl_math_abs( e2 );
+    
+    // The denominators of the discarded sets are replaced so that no division by zero occurs
+    const bool valid = ( a2 >= 1e-3 );
+    const double safeA2 = valid ? a2 : 1.0;
+    
+    const double ra = a1 / ( alpha * safeA2 );
+    const double rb = e0 / ( beta * vcl_sqrt( a1 * safeA2 ) );
+    const double s = vcl_sqrt( e0 * e0 + e1 * e1 + e2 * e2 ) / gamma;
+    
+    const double lineMeasure = ( 1.0 - vcl_exp( - 0.5 * vnl_math_sqr( ra ) ) ) * 
+      vcl_exp( - 0.5 * vnl_math_sqr( rb ) ) * ( 1.0 - vcl_exp( - 0.5 * vnl_math_sqr( s ) ) );
+    
+    vesselness[k] = static_cast<OutputType>( valid ? lineMeasure : 0.0 );
+  }
+}
+
 } // end namespace ivan
 
 #endif
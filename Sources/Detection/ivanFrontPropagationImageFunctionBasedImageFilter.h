@@ -0,0 +1,214 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrontPropagationImageFunctionBasedImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: evaluates an image function only on the region connected to a set of seeds, propagating a front
+// Date: 2012/11/05
+
+#ifndef __ivanFrontPropagationImageFunctionBasedImageFilter_h
+#define __ivanFrontPropagationImageFunctionBasedImageFilter_h
+
+#include "ivanImageFunctionInitializerBase.h"
+
+#include "itkImageToImageFilter.h"
+#include "itkImageFunction.h"
+
+#if ITK_VERSION_MAJOR < 4
+ #include "itk_hash_map.h"
+  #define ITK_HASH_MAP itk::hash_map
+#else
+ #include "itksys/hash_map.hxx"
+  #define ITK_HASH_MAP itksys::hash_map
+#endif
+
+#include <vector>
+#include <utility>
+
+
+namespace ivan
+{
+
+/** \class FrontPropagationImageFunctionBasedImageFilter
+ *  \brief Evaluates an image function only on the region connected to a set of seeds where
+ *  its response is above a threshold.
+ *
+ * For seeded workflows only the response on the vessels connected to the seeds is needed. 
+ * Starting from the seeds, a front is propagated to the neighbours of the accepted pixels 
+ * (face neighbours, or all the 3^N-1 neighbours if FullyConnected is on), evaluating the 
+ * image function only at the pixels reached by the front. Pixels with a response above or
+ * equal to ResponseThreshold are accepted and expanded, the others stop the front. The front 
+ * is kept in a priority queue, so that the pixels with the highest response are expanded 
+ * first, which makes the result meaningful when MaximumNumberOfAcceptedPixels is reached.
+ *
+ * The responses of all the evaluated pixels are kept in a hash map indexed by their offset
+ * in the output requested region, so memory is proportional to the number of evaluated 
+ * pixels. The accepted pixels are listed in acceptance order by GetAcceptedPixels(), and 
+ * written to the output image, which is zero elsewhere.
+ *
+ * The image function is created and initialized with the ImageFunctionInitializer, as in 
+ * ImageFunctionBasedImageFilter. The propagation is sequential.
+ *
+ * \sa ImageFunctionBasedImageFilter
+ */
+template <class TInputImage, class TOutputImage, class TImageFunction>
+class ITK_EXPORT FrontPropagationImageFunctionBasedImageFilter : 
+  public itk::ImageToImageFilter<TInputImage,TOutputImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef FrontPropagationImageFunctionBasedImageFilter        Self;
+  typedef itk::ImageToImageFilter<TInputImage,TOutputImage>   Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  typedef TInputImage   InputImageType;
+  typedef TOutputImage  OutputImageType;
+  
+  typedef typename InputImageType::IndexType     IndexType;
+  typedef typename OutputImageType::PixelType    OutputPixelType;
+  typedef typename OutputImageType::RegionType   OutputImageRegionType;
+  
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, ITKImageDimensionMacro( InputImageType ) );
+  
+  /** Image function type. */
+  typedef TImageFunction                               ImageFunctionType;
+  typedef typename ImageFunctionType::Pointer          ImageFunctionPointer;
+  typedef typename ImageFunctionType::OutputType       ResponseType;
+  
+  typedef ImageFunctionInitializerBase<TImageFunction,TInputImage>   ImageFunctionInitializerType; 
+  typedef typename ImageFunctionInitializerType::Pointer             ImageFunctionInitializerPointer;
+  
+  /** Container of seeds. */
+  typedef std::vector<IndexType>                       SeedContainerType;
+  
+  /** Accepted pixels and their responses, in acceptance order. */
+  typedef std::pair<IndexType,ResponseType>            AcceptedPixelType;
+  typedef std::vector<AcceptedPixelType>               AcceptedPixelContainerType;
+  
+  /** Responses of the evaluated pixels, by offset in the output requested region. */
+  typedef ITK_HASH_MAP<unsigned long,ResponseType>     ResponseMapType;
+       
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrontPropagationImageFunctionBasedImageFilter, itk::ImageToImageFilter );
+  
+  /** Add a seed of the propagation. Seeds outside the output requested region are ignored. */
+  void AddSeed( const IndexType & seed );
+  
+  /** Remove all the seeds. */
+  void ClearSeeds();
+  
+  /** Get the seeds. */
+  const SeedContainerType & GetSeeds() const
+    { return this->m_Seeds; }
+  
+  /** Set/Get the response below which the front stops. Default is zero. */
+  itkSetMacro( ResponseThreshold, ResponseType );
+  itkGetConstMacro( ResponseThreshold, ResponseType );
+  
+  /** Set/Get the flag for propagating to all the 3^N-1 neighbours instead of the 2N face 
+    * neighbours. Off by default. */
+  itkSetMacro( FullyConnected, bool );
+  itkGetConstMacro( FullyConnected, bool );
+  itkBooleanMacro( FullyConnected );
+  
+  /** Set/Get the maximum number of accepted pixels, zero for no limit. Default is zero. */
+  itkSetMacro( MaximumNumberOfAcceptedPixels, unsigned long );
+  itkGetConstMacro( MaximumNumberOfAcceptedPixels, unsigned long );
+  
+  itkSetObjectMacro( ImageFunctionInitializer, ImageFunctionInitializerType );
+  itkGetObjectMacro( ImageFunctionInitializer, ImageFunctionInitializerType );
+  itkGetConstObjectMacro( ImageFunctionInitializer, ImageFunctionInitializerType );
+  
+  /** Get the accepted pixels of the last execution, in acceptance order. */
+  const AcceptedPixelContainerType & GetAcceptedPixels() const
+    { return this->m_AcceptedPixels; }
+  
+  /** Get the responses of all the pixels evaluated in the last execution. */
+  const ResponseMapType & GetResponses() const
+    { return this->m_Responses; }
+  
+  /** Get the number of pixels where the image function was evaluated in the last execution. */
+  unsigned long GetNumberOfEvaluatedPixels() const
+    { return static_cast<unsigned long>( this->m_Responses.size() ); }
+  
+  /** Get the fraction of the pixels of the output requested region evaluated in the last 
+    * execution. */
+  double GetEvaluatedFraction() const;
+  
+protected:
+
+  FrontPropagationImageFunctionBasedImageFilter();
+  ~FrontPropagationImageFunctionBasedImageFilter() {};
+  
+  /** The whole input is needed, since the front may reach any pixel. */
+  virtual void GenerateInputRequestedRegion();
+  
+  /** Propagate the front from the seeds. */
+  virtual void GenerateData();
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  FrontPropagationImageFunctionBasedImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  /** Element of the front, ordered by response. */
+  struct FrontElement
+  {
+    ResponseType    Response;
+    IndexType       Index;
+    
+    bool operator<( const FrontElement & other ) const
+      { return this->Response < other.Response; }
+  };
+
+protected:
+
+  SeedContainerType                   m_Seeds;
+  ResponseType                        m_ResponseThreshold;
+  bool                                m_FullyConnected;
+  unsigned long                       m_MaximumNumberOfAcceptedPixels;
+  
+  ImageFunctionInitializerPointer     m_ImageFunctionInitializer;
+  
+  AcceptedPixelContainerType          m_AcceptedPixels;
+  ResponseMapType                     m_Responses;
+};
+  
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanFrontPropagationImageFunctionBasedImageFilter.hxx"
+#endif
+  
+#endif
@@ -0,0 +1,257 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrontPropagationImageFunctionBasedImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: evaluates an image function only on the region connected to a set of seeds, propagating a front
+// Date: 2012/11/05
+
+#ifndef __ivanFrontPropagationImageFunctionBasedImageFilter_hxx
+#define __ivanFrontPropagationImageFunctionBasedImageFilter_hxx
+
+#include "ivanFrontPropagationImageFunctionBasedImageFilter.h"
+
+#include "itkNumericTraits.h"
+#include "itkProgressReporter.h"
+
+#include <queue>
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::FrontPropagationImageFunctionBasedImageFilter() :
+  m_ResponseThreshold( itk::NumericTraits<ResponseType>::Zero ),
+  m_FullyConnected( false ),
+  m_MaximumNumberOfAcceptedPixels( 0 )
+{
+  this->m_ImageFunctionInitializer = ImageFunctionInitializerType::New();
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+void 
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::AddSeed( const IndexType & seed )
+{
+  this->m_Seeds.push_back( seed );
+  this->Modified();
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+void 
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::ClearSeeds()
+{
+  if( !this->m_Seeds.empty() )
+  {
+    this->m_Seeds.clear();
+    this->Modified();
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+double
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::GetEvaluatedFraction() const
+{
+  const double numberOfPixels = static_cast<double>( 
+    const_cast<Self *>( this )->GetOutput()->GetRequestedRegion().GetNumberOfPixels() );
+  
+  return ( numberOfPixels > 0.0 ) ? this->GetNumberOfEvaluatedPixels() / numberOfPixels : 0.0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+void 
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  if( this->GetInput() )
+  {
+    typename InputImageType::Pointer input = const_cast<InputImageType *>( this->GetInput() );
+    input->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+void 
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::GenerateData()
+{
+  typename OutputImageType::Pointer output = this->GetOutput();
+  
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
+  output->FillBuffer( itk::NumericTraits<OutputPixelType>::Zero );
+  
+  this->m_AcceptedPixels.clear();
+  this->m_Responses.clear();
+  
+  if( this->m_ImageFunctionInitializer.IsNull() )
+  {
+    itkExceptionMacro( "ImageFunctionInitializer is NULL." );
+  }
+  
+  ImageFunctionPointer imageFunction = ImageFunctionType::New();
+  this->m_ImageFunctionInitializer->Initialize( imageFunction.GetPointer(), this->GetInput() );
+  
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  
+  // Offsets of the neighbours
+  std::vector<typename IndexType::OffsetType> neighbours;
+  
+  if( this->m_FullyConnected )
+  {
+    typename IndexType::OffsetType offset;
+    offset.Fill( -1 );
+    
+    while( true )
+    {
+      bool isCenter = true;
+      for( unsigned int d=0; d<ImageDimension; ++d )
+        isCenter = isCenter && ( offset[d] == 0 );
+      
+      if( !isCenter )
+        neighbours.push_back( offset );
+      
+      unsigned int d = 0;
+      for( ; d<ImageDimension; ++d )
+      {
+        if( ++offset[d] <= 1 )
+          break;
+        
+        offset[d] = -1;
+      }
+      
+      if( d == ImageDimension )
+        break;
+    }
+  }
+  else
+  {
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      typename IndexType::OffsetType offset;
+      offset.Fill( 0 );
+      
+      offset[d] = -1;
+      neighbours.push_back( offset );
+      offset[d] = 1;
+      neighbours.push_back( offset );
+    }
+  }
+  
+  std::priority_queue<FrontElement> front;
+  
+  // Keys of the pixels in the response map
+  unsigned long strides[ImageDimension];
+  strides[0] = 1;
+  for( unsigned int d=1; d<ImageDimension; ++d )
+    strides[d] = strides[d-1] * region.GetSize()[d-1];
+  
+  std::vector<IndexType> candidates( this->m_Seeds );
+  
+  const unsigned long maximumAccepted = this->m_MaximumNumberOfAcceptedPixels ?
+    this->m_MaximumNumberOfAcceptedPixels : region.GetNumberOfPixels();
+  
+  itk::ProgressReporter progress( this, 0, maximumAccepted );
+  
+  while( true )
+  {
+    // Evaluate the candidates the first time the front reaches them, and add them to the 
+    // front if their response is above the threshold
+    for( unsigned int i=0; i<candidates.size(); ++i )
+    {
+      const IndexType & index = candidates[i];
+      
+      if( !region.IsInside( index ) )
+        continue;
+      
+      unsigned long key = 0;
+      for( unsigned int d=0; d<ImageDimension; ++d )
+        key += ( index[d] - region.GetIndex()[d] ) * strides[d];
+      
+      if( this->m_Responses.find( key ) != this->m_Responses.end() )
+        continue;
+      
+      const ResponseType response = imageFunction->EvaluateAtIndex( index );
+      this->m_Responses[key] = response;
+      
+      if( response >= this->m_ResponseThreshold )
+      {
+        FrontElement element;
+        element.Response = response;
+        element.Index = index;
+        front.push( element );
+      }
+    }
+    
+    candidates.clear();
+    
+    if( front.empty() || this->m_AcceptedPixels.size() >= maximumAccepted )
+      break;
+    
+    // Accept the pixel of the front with the highest response and add its neighbours
+    const FrontElement element = front.top();
+    front.pop();
+    
+    this->m_AcceptedPixels.push_back( AcceptedPixelType( element.Index, element.Response ) );
+    output->SetPixel( element.Index, static_cast<OutputPixelType>( element.Response ) );
+    progress.CompletedPixel();
+    
+    for( unsigned int n=0; n<neighbours.size(); ++n )
+      candidates.push_back( element.Index + neighbours[n] );
+  }
+  
+  itkDebugMacro(<< "Accepted " << this->m_AcceptedPixels.size() << " pixels, evaluated " 
+    << this->m_Responses.size() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction>
+void
+FrontPropagationImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Seeds: " << this->m_Seeds.size() << std::endl;
+  os << indent << "ResponseThreshold: " << this->m_ResponseThreshold << std::endl;
+  os << indent << "FullyConnected: " << this->m_FullyConnected << std::endl;
+  os << indent << "MaximumNumberOfAcceptedPixels: " << this->m_MaximumNumberOfAcceptedPixels << std::endl;
+  os << indent << "AcceptedPixels: " << this->m_AcceptedPixels.size() << std::endl;
+  os << indent << "EvaluatedPixels: " << this->m_Responses.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
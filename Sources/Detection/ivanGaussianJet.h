@@ -0,0 +1,84 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianJet.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: value, gradient and hessian of a Gaussian-smoothed image
+// Date: 2012/11/05
+
+#ifndef __ivanGaussianJet_h
+#define __ivanGaussianJet_h
+
+#include "itkVector.h"
+#include "itkSymmetricSecondRankTensor.h"
+#include "itkNumericTraits.h"
+
+#include <iostream>
+
+
+namespace ivan
+{
+
+/**
+ * \class GaussianJet
+ * \brief Value, gradient and hessian of a Gaussian-smoothed image at a location.
+ *
+ * This is the output of DiscreteGaussianJetImageFunction. The value is the Gaussian-smoothed
+ * intensity, and the gradient and hessian are its first and second order derivatives.
+ *
+ * \sa DiscreteGaussianJetImageFunction
+ */
+template< class T, unsigned int VDimension >
+class GaussianJet
+{
+public:
+
+  typedef GaussianJet                                Self;
+  typedef T                                          ValueType;
+  typedef itk::Vector< T, VDimension >               GradientType;
+  typedef itk::SymmetricSecondRankTensor< T, VDimension >  HessianType;
+
+  GaussianJet():
+    Value( itk::NumericTraits< T >::Zero )
+  {
+    Gradient.Fill( itk::NumericTraits< T >::Zero );
+    Hessian.Fill( itk::NumericTraits< T >::Zero );
+  }
+
+  ValueType     Value;
+  GradientType  Gradient;
+  HessianType   Hessian;
+};
+
+
+template< class T, unsigned int VDimension >
+std::ostream & operator<<( std::ostream & os, const GaussianJet< T, VDimension > & jet )
+{
+  os << "[" << jet.Value << ", " << jet.Gradient << ", " << jet.Hessian << "]";
+  return os;
+}
+
+} // end namespace ivan
+
+#endif
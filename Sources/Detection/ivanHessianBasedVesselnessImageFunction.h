@@ -31,9 +31,12 @@ SUCH DAMAGE.
 #define __ivanHessianBasedVesselnessImageFunction_h
 
 
+#include "ivanExplicitInstantiation.h"
 #include "itkImageFunction.h"
 #include "ivanDiscreteHessianGaussianImageFunction.h"
 
+#include <vector>
+
 
 namespace ivan
 {
@@ -83,6 +86,9 @@ public:
   typedef typename Superclass::IndexType            IndexType;
   typedef typename Superclass::ContinuousIndexType  ContinuousIndexType;
   typedef typename Superclass::PointType            PointType;
+  
+  /** Container of points for batch evaluation. */
+  typedef std::vector<PointType>                    PointContainerType;
     
   /** Types for Hessian function/matrix. */
   typedef ivan::DiscreteHessianGaussianImageFunction
@@ -92,6 +98,9 @@ public:
   
   /** Necessary for multi-scale compatibility. */
   typedef HessianTensorType                         TensorType;
+  
+  /** Cache for Hessian values. */
+  typedef typename HessianFunctionType::DerivativeCacheType   HessianCacheType;
     
   /** Interpolation modes */
   typedef typename HessianFunctionType::InterpolationModeType 
@@ -163,6 +172,25 @@ public:
     { m_HessianFunction->SetInterpolationMode( mode ); }
   virtual InterpolationModeType GetInterpolationMode() const
     { return m_HessianFunction->GetInterpolationMode(); } 
+    
+  /** Set/Get the flag for separable evaluation of the Hessian at indices. */
+  virtual void SetUseSeparableEvaluation( bool separable )
+    { m_HessianFunction->SetUseSeparableEvaluation( separable ); }
+  virtual bool GetUseSeparableEvaluation() const
+    { return m_HessianFunction->GetUseSeparableEvaluation(); }
+  itkBooleanMacro( UseSeparableEvaluation );
+    
+  /** Set/Get a cache for Hessian values that may be shared with other functions operating on the 
+   * same image with the same Hessian parameters (except the scale). */
+  virtual void SetHessianCache( HessianCacheType *cache )
+    { m_HessianFunction->SetDerivativeCache( cache ); }
+  virtual HessianCacheType * GetHessianCache()
+    { return m_HessianFunction->GetDerivativeCache(); }
+  
+  /** Get the function that computes the Hessian, eg. to evaluate it without virtual calls 
+    * (see EigenValueVesselnessEvaluator). */
+  const HessianFunctionType * GetHessianFunction() const
+    { return m_HessianFunction; }
 
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
@@ -183,6 +211,12 @@ public:
   /** Evaluate the function at specified ContinousIndex position */
   virtual OutputType EvaluateAtContinuousIndex( const ContinuousIndexType & index ) const;
   
+  /** Evaluate the function at all the given points and store the results in values, which must 
+    * have room for points.size() elements. The result is the same as calling Evaluate() for each 
+    * point. The interpolation mode is checked once for the whole batch. Subclasses may reimplement
+    * this to amortize other setup costs over the points. */
+  virtual void EvaluateBatch( const PointContainerType& points, OutputType* values ) const;
+  
 protected:
 
   HessianBasedVesselnessImageFunction();
@@ -236,7 +270,7 @@ protected:
                                                   HessianBasedVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanHessianBasedVesselnessImageFunction+-.h"
 #endif
 
@@ -105,6 +105,38 @@ HessianBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 }
 
 
+/** Evaluate the function at the given points */
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+HessianBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateBatch( const PointContainerType& points, OutputType* values ) const
+{
+  const unsigned long numberOfPoints = points.size();
+  
+  if( m_HessianFunction->GetInterpolationMode() == 
+    HessianFunctionType::NearestNeighbourInterpolation )
+    {
+    IndexType index;
+    
+    for( unsigned long i=0; i < numberOfPoints; ++i )
+      {
+      this->ConvertPointToNearestIndex( points[i], index );
+      values[i] = this->EvaluateVesselness( this->EvaluateHessianAtIndex( index ), points[i] );
+      }
+    }
+  else // linear interpolation
+    {
+    ContinuousIndexType cindex;
+    
+    for( unsigned long i=0; i < numberOfPoints; ++i )
+      {
+      this->ConvertPointToContinuousIndex( points[i], cindex );
+      values[i] = this->EvaluateVesselness( this->EvaluateHessianAtContinuousIndex( cindex ), points[i] );
+      }
+    }
+}
+
+
 /** Evaluate the function at the specifed index */
 template <class TInputImage, class TOutput, class TCoordRep>
 typename HessianBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::HessianTensorType
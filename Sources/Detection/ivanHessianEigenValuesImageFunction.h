@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanHessianEigenValuesImageFunction_h
 #define __ivanHessianEigenValuesImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanMacros.h"
 #include "ivanHessianOnlyBasedVesselnessImageFunction.h"
 
@@ -131,7 +132,7 @@ private:
                                                   HessianEigenValuesImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanHessianEigenValuesImageFunction+-.h"
 #endif
 
@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #define __ivanHessianEigenValuesImageFunction_hxx
 
 #include "ivanHessianEigenValuesImageFunction.h"
+#include "ivanSymmetricEigenSolver.h"
 
 
 namespace ivan
@@ -72,7 +73,7 @@ HessianEigenValuesImageFunction<TInputImage,TCoordRep>
   EigenValuesArrayType   eigenValues;
   
   // Calculate eigenvalues of Hessian matrix at the current location
-  hessian.ComputeEigenValues( eigenValues );
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
   
   return eigenValues;
 }
@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #define __ivanHessianOnlyBasedVesselnessImageFunction_h
 
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianBasedVesselnessImageFunction.h"
 
 
@@ -84,6 +85,9 @@ public:
     <TInputImage,TCoordRep>                         HessianFunctionType;
   typedef typename HessianFunctionType::Pointer     HessianFunctionPointer;
   typedef typename HessianFunctionType::TensorType  HessianTensorType;
+  typedef typename HessianTensorType::EigenValuesArrayType
+                                                    EigenValuesArrayType;
+  typedef typename EigenValuesArrayType::ValueType  EigenValueType;
     
   /** Interpolation modes */
   typedef typename HessianFunctionType::InterpolationModeType 
@@ -97,6 +101,26 @@ public:
   /** Run-time type information (and related methods) */
   itkTypeMacro( HessianOnlyBasedVesselnessImageFunction, HessianBasedVesselnessImageFunction );
   
+  /** Evaluate vesselness from the eigenvalues of the Hessian matrix, in ascending order. This 
+    * allows whole-image filters to share one eigen-analysis among several measures. Subclasses 
+    * that depend on the eigenvalues only should reimplement this method; by default an 
+    * exception is thrown. */
+  virtual OutputType EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const;
+  
+  /** Evaluate vesselness for several contiguous sets of eigenvalues, such as those of a run of 
+    * pixels. Filters evaluate one measure over a whole run at once so that the measure 
+    * parameters and code stay hot. By default this calls EvaluateVesselnessFromEigenValues() 
+    * for each set. */
+  virtual void EvaluateVesselnessFromEigenValuesInBatch( const EigenValuesArrayType * eigenValues,
+    unsigned long numberOfValues, OutputType * vesselness ) const;
+  
+  /** Same as above with the eigenvalues stored by component: eigenValues[i][k] is the i-th 
+    * smallest eigenvalue of set k. With one contiguous array per component, subclasses can 
+    * evaluate the measure with a loop over the sets without branches, which the compiler 
+    * vectorizes. By default the sets are rebuilt and given to EvaluateVesselnessFromEigenValues(). */
+  virtual void EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+    unsigned long numberOfValues, OutputType * vesselness ) const;
+  
 protected:
 
   HessianOnlyBasedVesselnessImageFunction();
@@ -135,7 +159,7 @@ protected:
                                                   HessianOnlyBasedVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanHessianOnlyBasedVesselnessImageFunction+-.h"
 #endif
 
@@ -82,6 +82,45 @@ HessianOnlyBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   return this->EvaluateVesselness( hessian );
 }
 
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename HessianOnlyBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+HessianOnlyBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const
+{
+  itkExceptionMacro( "Evaluation from eigenvalues is not supported by " << this->GetNameOfClass() );
+  return itk::NumericTraits<OutputType>::Zero;
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+HessianOnlyBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValuesInBatch( const EigenValuesArrayType * eigenValues,
+  unsigned long numberOfValues, OutputType * vesselness ) const
+{
+  for( unsigned long i=0; i<numberOfValues; ++i )
+    vesselness[i] = this->EvaluateVesselnessFromEigenValues( eigenValues[i] );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+HessianOnlyBasedVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+  unsigned long numberOfValues, OutputType * vesselness ) const
+{
+  EigenValuesArrayType set;
+  
+  for( unsigned long k=0; k<numberOfValues; ++k )
+  {
+    for( unsigned int i=0; i<EigenValuesArrayType::Dimension; ++i )
+      set[i] = eigenValues[i][k];
+    
+    vesselness[k] = this->EvaluateVesselnessFromEigenValues( set );
+  }
+}
+
 } // end namespace ivan
 
 #endif
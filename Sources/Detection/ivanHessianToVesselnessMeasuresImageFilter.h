@@ -0,0 +1,152 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHessianToVesselnessMeasuresImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes Hessian-based vesselness measures from a precomputed Hessian image
+// Date: 2012/11/05
+
+#ifndef __ivanHessianToVesselnessMeasuresImageFilter_h
+#define __ivanHessianToVesselnessMeasuresImageFilter_h
+
+#include "ivanHessianOnlyBasedVesselnessImageFunction.h"
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkImageToImageFilter.h"
+#include "itkImage.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class HessianToVesselnessMeasuresImageFilter
+ *  \brief Computes one or several Hessian-based vesselness measures from a Hessian image.
+ *
+ * Whole-image counterpart of the point-wise Hessian only based vesselness functions (Frangi, 
+ * Sato, objectness...). Instead of computing the Hessian by convolution at every pixel as when
+ * the functions are evaluated through ImageFunctionBasedImageFilter, the input is a tensor image 
+ * such as the output of itk::HessianRecursiveGaussianImageFilter, computed once for the whole 
+ * image (as done in MultiscaleAnalysisImageFilter).
+ *
+ * The measures are added with AddMeasure(), and each of them produces an output, in the same 
+ * order. The eigen-analysis is done only once per pixel and shared by all the measures, which 
+ * are evaluated a row at a time with EvaluateVesselnessFromEigenValueComponents(), so the 
+ * parameters of each measure are those set on the corresponding image function.Initialize() need not be called on them since 
+ * their Hessian function is not used.
+ *
+ * TMeasureFunction is the common base class of the measures to compute, and must be a subclass 
+ * of HessianOnlyBasedVesselnessImageFunction.
+ * 
+ */
+template <class TTensorImage, class TOutputImage, class TMeasureFunction = 
+  HessianOnlyBasedVesselnessImageFunction<itk::Image<float,TTensorImage::ImageDimension>, 
+    typename TOutputImage::PixelType> >
+class ITK_EXPORT HessianToVesselnessMeasuresImageFilter : 
+  public itk::ImageToImageFilter<TTensorImage,TOutputImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef HessianToVesselnessMeasuresImageFilter              Self;
+  typedef itk::ImageToImageFilter<TTensorImage,TOutputImage>  Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  typedef TTensorImage                             TensorImageType;
+  typedef TOutputImage                             OutputImageType;
+  
+  typedef typename TensorImageType::PixelType      TensorPixelType;
+  typedef typename OutputImageType::PixelType      OutputPixelType;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  
+  /** Image dimension = 3. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TTensorImage::ImageDimension );
+  
+  /** Type of the measures. */
+  typedef TMeasureFunction                             MeasureFunctionType;
+  typedef typename MeasureFunctionType::Pointer        MeasureFunctionPointer;
+  typedef typename MeasureFunctionType::EigenValuesArrayType  
+                                                       MeasureEigenValuesArrayType;
+  typedef typename MeasureFunctionType::EigenValueType MeasureEigenValueType;
+  typedef typename MeasureFunctionType::OutputType     MeasureOutputType;
+typedef std::vector<MeasureFunctionPointer>          MeasureFunctionContainerType;
+  
+  /** Types for eigenanalysis. */
+  typedef SymmetricEigenSolver<TensorPixelType>        EigenAnalysisType;
+  typedef typename EigenAnalysisType::EigenValuesArrayType  
+                                                       EigenValuesArrayType;
+       
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( HessianToVesselnessMeasuresImageFilter, itk::ImageToImageFilter );
+  
+  /** Add a measure to compute. Its values will be in the output with the same index as the 
+    * measure, in the order measures were added. */
+  void AddMeasure( MeasureFunctionType *measure );
+  
+  /** Get the number of measures. */
+  unsigned int GetNumberOfMeasures() const
+    { return static_cast<unsigned int>( this->m_Measures.size() ); }
+  
+  /** Get the given measure. */
+  MeasureFunctionType * GetMeasure( unsigned int i )
+    { return this->m_Measures[i].GetPointer(); }
+  
+protected:
+
+  HessianToVesselnessMeasuresImageFilter();
+  ~HessianToVesselnessMeasuresImageFilter() {};
+  
+  /** Check that there is at least one measure. */
+  virtual void BeforeThreadedGenerateData();
+  
+  /** Compute all the measures in the region of each thread. */
+  virtual void ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId );
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  HessianToVesselnessMeasuresImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  /** Measures to compute, one per output. */
+  MeasureFunctionContainerType    m_Measures;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanHessianToVesselnessMeasuresImageFilter.hxx"
+#endif
+  
+#endif
@@ -0,0 +1,184 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHessianToVesselnessMeasuresImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes Hessian-based vesselness measures from a precomputed Hessian image
+// Date: 2012/11/05
+
+#ifndef __ivanHessianToVesselnessMeasuresImageFilter_hxx
+#define __ivanHessianToVesselnessMeasuresImageFilter_hxx
+
+#include "ivanHessianToVesselnessMeasuresImageFilter.h"
+
+#include "itkProgressReporter.h"
+
+
+namespace ivan
+{
+
+template <class TTensorImage, class TOutputImage, class TMeasureFunction>
+HessianToVesselnessMeasuresImageFilter<TTensorImage,TOutputImage,TMeasureFunction>
+::HessianToVesselnessMeasuresImageFilter()
+{
+
+}
+
+
+template <class TTensorImage, class TOutputImage, class TMeasureFunction>
+void 
+HessianToVesselnessMeasuresImageFilter<TTensorImage,TOutputImage,TMeasureFunction>
+::AddMeasure( MeasureFunctionType *measure )
+{
+  if( !measure )
+  {
+    itkExceptionMacro( "Measure is NULL." );
+  }
+  
+  this->m_Measures.push_back( measure );
+  
+  // The first output already exists
+  const unsigned int numberOfMeasures = this->GetNumberOfMeasures();
+  
+  if( numberOfMeasures > 1 )
+  {
+    this->itk::ProcessObject::SetNumberOfRequiredOutputs( numberOfMeasures );
+    
+    typename OutputImageType::Pointer output = OutputImageType::New();
+    this->itk::ProcessObject::SetNthOutput( numberOfMeasures-1, output.GetPointer() );
+  }
+  
+  this->Modified();
+}
+
+
+template <class TTensorImage, class TOutputImage, class TMeasureFunction>
+void 
+HessianToVesselnessMeasuresImageFilter<TTensorImage,TOutputImage,TMeasureFunction>
+::BeforeThreadedGenerateData()
+{
+  if( this->m_Measures.empty() )
+  {
+    itkExceptionMacro( "No measures were added." );
+  }
+}
+
+
+template <class TTensorImage, class TOutputImage, class TMeasureFunction>
+void 
+HessianToVesselnessMeasuresImageFilter<TTensorImage,TOutputImage,TMeasureFunction>
+::ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId )
+{
+  typedef typename OutputImageRegionType::IndexType   IndexType;
+  
+  const unsigned int numberOfMeasures = this->GetNumberOfMeasures();
+  
+  itk::ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+  
+  if( outputRegionForThread.GetNumberOfPixels() == 0 )
+    return;
+  
+  const TensorImageType *input = this->GetInput();
+  
+  // Raw pointers to avoid smart pointer overhead in the inner loop
+  std::vector<const MeasureFunctionType *> measures( numberOfMeasures );
+  std::vector<OutputImageType *> outputs( numberOfMeasures );
+  
+  for( unsigned int m=0; m<numberOfMeasures; ++m )
+  {
+    measures[m] = this->m_Measures[m].GetPointer();
+    outputs[m] = this->GetOutput( m );
+  }
+  
+  // Each row is processed in stages: the eigenvalues of the whole row first, stored by 
+  // component, and then each measure over the row
+  const unsigned long rowLength = outputRegionForThread.GetSize()[0];
+  const unsigned long numberOfRows = outputRegionForThread.GetNumberOfPixels() / rowLength;
+  
+  std::vector<EigenValuesArrayType>    eigenValues( rowLength );
+  std::vector<MeasureEigenValueType>   measureEigenValues( ImageDimension * rowLength );
+  std::vector<MeasureOutputType>       values( rowLength );
+  
+  const MeasureEigenValueType *measureEigenValueComponents[ImageDimension];
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    measureEigenValueComponents[i] = &measureEigenValues[ i * rowLength ];
+  
+  IndexType rowIndex = outputRegionForThread.GetIndex();
+  
+  for( unsigned long row=0; row<numberOfRows; ++row )
+  {
+    // One eigen-analysis for all the measures
+    const TensorPixelType *tensors = input->GetBufferPointer() + input->ComputeOffset( rowIndex );
+    EigenAnalysisType::ComputeEigenValues( tensors, rowLength, &eigenValues[0] );
+    
+    for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+      MeasureEigenValueType *component = &measureEigenValues[ i * rowLength ];
+      
+      for( unsigned long k=0; k<rowLength; ++k )
+        component[k] = eigenValues[k][i];
+    }
+    
+    for( unsigned int m=0; m<numberOfMeasures; ++m )
+    {
+      measures[m]->EvaluateVesselnessFromEigenValueComponents( measureEigenValueComponents, rowLength, &values[0] );
+      
+      OutputPixelType *outputPixel = outputs[m]->GetBufferPointer() + outputs[m]->ComputeOffset( rowIndex );
+      
+      for( unsigned long k=0; k<rowLength; ++k )
+        outputPixel[k] = static_cast<OutputPixelType>( values[k] );
+    }
+    
+    for( unsigned long k=0; k<rowLength; ++k )
+      progress.CompletedPixel();
+    
+    // Next row, the first direction is traversed by the loops above
+    for( unsigned int d=1; d<ImageDimension; ++d )
+    {
+      if( ++rowIndex[d] < outputRegionForThread.GetIndex()[d] + 
+          static_cast<typename IndexType::IndexValueType>( outputRegionForThread.GetSize()[d] ) )
+        break;
+      rowIndex[d] = outputRegionForThread.GetIndex()[d];
+    }
+  }
+}
+
+
+template <class TTensorImage, class TOutputImage, class TMeasureFunction>
+void 
+HessianToVesselnessMeasuresImageFilter<TTensorImage,TOutputImage,TMeasureFunction>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfMeasures: " << this->m_Measures.size() << std::endl;
+  
+  for( unsigned int m=0; m<this->m_Measures.size(); ++m )
+    os << indent << "Measure " << m << ": " << this->m_Measures[m]->GetNameOfClass() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,114 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHessianVesselnessMeasuresBackend.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: backend of the per-voxel stages of the multi-measure vesselness filter
+// Date: 2012/11/05
+
+#ifndef __ivanHessianVesselnessMeasuresBackend_h
+#define __ivanHessianVesselnessMeasuresBackend_h
+
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkLightObject.h"
+#include "itkObjectFactory.h"
+
+
+namespace ivan
+{
+  
+/** \class HessianVesselnessMeasuresBackend
+ *  \brief Runs the per-voxel stages of MultiscaleHessianVesselnessMeasuresImageFilter.
+ *
+ * The filter computes, for each run of pixels, the eigenvalues of the Hessian of the whole run 
+ * and then each measure over the run. This class implements both stages on the CPU, with 
+ * SymmetricEigenSolver and EvaluateVesselnessFromEigenValueComponents(). Other devices derive 
+ * from this class and reimplement ComputeEigenValues() and EvaluateMeasure(), and are given to 
+ * the filter with SetBackend(). Since it is created with the object factory, a backend may also 
+ * be overridden for every filter by registering a factory. Backends for GPUs are built with the 
+ * IVAN_USE_GPU option, which finds the CUDA toolkit. 
+ *
+ * Both methods are called concurrently from the threads of the filter, so they must not modify
+ * the backend. The buffers are given by the filter and have room for the number of values.
+ *
+ * \sa MultiscaleHessianVesselnessMeasuresImageFilter
+ */
+template <class TTensor, class TMeasureFunction>
+class ITK_EXPORT HessianVesselnessMeasuresBackend : public itk::LightObject
+{
+public:
+  
+  typedef HessianVesselnessMeasuresBackend
+    <TTensor,TMeasureFunction>             Self;
+  typedef itk::LightObject                 Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+
+  typedef TTensor                                       TensorType;
+  typedef SymmetricEigenSolver<TensorType>              EigenAnalysisType;
+  typedef typename EigenAnalysisType::EigenValuesArrayType  
+                                                        EigenValuesArrayType;
+  
+  typedef TMeasureFunction                              MeasureFunctionType;
+  typedef typename MeasureFunctionType::EigenValueType  MeasureEigenValueType;
+  typedef typename MeasureFunctionType::OutputType      MeasureOutputType;
+  
+public:
+  
+  itkNewMacro( Self );
+  itkTypeMacro( HessianVesselnessMeasuresBackend, itk::LightObject );
+  
+  /** Compute the eigenvalues, in ascending order, of several contiguous tensors. */
+  virtual void ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues ) const
+    {
+      if( numberOfTensors > 0 )
+        EigenAnalysisType::ComputeEigenValues( tensors, numberOfTensors, eigenValues );
+    }
+  
+  /** Evaluate the measure for several sets of eigenvalues stored by component, as in 
+    * HessianOnlyBasedVesselnessImageFunction::EvaluateVesselnessFromEigenValueComponents(). */
+  virtual void EvaluateMeasure( const MeasureFunctionType * measure, 
+    const MeasureEigenValueType * const * eigenValues, unsigned long numberOfValues, 
+    MeasureOutputType * vesselness ) const
+    {
+      if( numberOfValues > 0 )
+        measure->EvaluateVesselnessFromEigenValueComponents( eigenValues, numberOfValues, vesselness );
+    }
+  
+protected:
+  
+  HessianVesselnessMeasuresBackend() {}
+  virtual ~HessianVesselnessMeasuresBackend() {}
+  
+private:
+  
+  HessianVesselnessMeasuresBackend(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented  
+};
+
+} // end namespace ivan
+
+#endif
@@ -33,6 +33,15 @@ SUCH DAMAGE.
 
 #include "itkImageToImageFilter.h"
 #include "itkImageFunction.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkTimeProbe.h"
+
+#include "ivanImageRegionTileScheduler.h"
+#include "ivanPerformanceProfile.h"
+#include "ivanFirstTouchImageFiller.h"
+#include "ivanThreadAffinity.h"
+#include "ivanImageFunctionEvaluator.h"
+#include "ivanBitPackedMask.h"
 
 #include <vector>
 
@@ -43,10 +52,15 @@ namespace ivan
 /** \class ImageFunctionBasedImageFilter
  *  \brief Applies an image function to the whole input image as an image filter, allowing parallelization.
  *
+ * The function is evaluated at each pixel with TEvaluator. The default ImageFunctionEvaluator
+ * calls the virtual EvaluateAtIndex() of the function. With the static policies of 
+ * ivanImageFunctionEvaluator.h, such as StaticMultiscaleImageFunctionEvaluator, the evaluation
+ * chain is bound at compile time and can be inlined in the loops of the filter.
  * 
- * 
+ * \sa ImageFunctionEvaluator
  */
-template <class TInputImage, class TOutputImage, class TImageFunction>
+template <class TInputImage, class TOutputImage, class TImageFunction, 
+  class TEvaluator = ImageFunctionEvaluator<TImageFunction> >
 class ITK_EXPORT ImageFunctionBasedImageFilter : public itk::ImageToImageFilter<TInputImage,TOutputImage>
 {
 public:
@@ -61,15 +75,31 @@ public:
   typedef TOutputImage  OutputImageType;
   
   typedef typename InputImageType::PixelType     InputImagePixelType;
+  typedef typename InputImageType::IndexType     InputImageIndexType;
+  typedef typename InputImageType::RegionType    InputImageRegionType;
+  typedef typename InputImageType::SizeType      InputImageSizeType;
   typedef typename OutputImageType::RegionType   OutputImageRegionType;
   
+  /** Container for the indices of the pixels to evaluate in sparse mode. */
+  typedef std::vector<InputImageIndexType>       IndexContainerType;
+  
   /** Image dimension = 3. */
   itkStaticConstMacro( ImageDimension, unsigned int, ITKImageDimensionMacro( InputImageType ) );
+  
+  /** Scheduler of the tiles of the output region, in dynamic scheduling mode. */
+  typedef ImageRegionTileScheduler<itkGetStaticConstMacro(ImageDimension)>   TileSchedulerType;
+  typedef typename TileSchedulerType::Pointer                                TileSchedulerPointer;
+  
+  /** Mask of the pixels to evaluate, packed with one bit per pixel. */
+  typedef BitPackedMask<itkGetStaticConstMacro(ImageDimension)>              PackedMaskType;
                       
   /** Image Function type. */
   typedef TImageFunction			                   ImageFunctionType;
   typedef typename ImageFunctionType::Pointer    ImageFunctionPointer;
   
+  /** Evaluation policy of the image function at each pixel. */
+  typedef TEvaluator                             EvaluatorType;
+  
   typedef std::vector<ImageFunctionPointer>      ImageFunctionContainerType;
   
   typedef ImageFunctionInitializerBase<TImageFunction,TInputImage>   ImageFunctionInitializerType; 
@@ -86,6 +116,95 @@ public:
   itkSetMacro( Threshold, InputImagePixelType );
   itkGetConstMacro( Threshold, InputImagePixelType );
   
+  /** Set/Get an optional mask of the pixels to evaluate. The pixels outside the mask are set to
+    * zero without reading the input, and the runs of mask pixels are found a word of 64 pixels 
+    * at a time, so that large background areas are passed quickly. The pixels inside the mask
+    * must also be above the threshold. NULL by default. */
+  itkSetConstObjectMacro( PackedMask, PackedMaskType );
+  itkGetConstObjectMacro( PackedMask, PackedMaskType );
+  
+  /** Set/Get the flag for sharing a single image function between all the threads. If off,
+    * one image function is created and initialized for each thread. This can only be used 
+    * with reentrant image functions, whose evaluation methods do not modify their state. 
+    * Off by default. */
+  itkSetMacro( ShareImageFunction, bool );
+  itkGetConstMacro( ShareImageFunction, bool );
+  itkBooleanMacro( ShareImageFunction );
+  
+  /** Set/Get the flag for sparse evaluation. If on, the indices of the pixels above the threshold
+    * are first collected in a list, which is then divided in chunks of the same size for each 
+    * thread. This balances the work among threads when only a small fraction of the pixels is
+    * above the threshold, instead of dividing the output region in slabs. Off by default. */
+  itkSetMacro( SparseEvaluation, bool );
+  itkGetConstMacro( SparseEvaluation, bool );
+  itkBooleanMacro( SparseEvaluation );
+  
+  /** Set/Get the flag for dynamic scheduling. If on, the output region is divided in small tiles
+    * of TileSize pixels per dimension that the threads pull from a shared queue until none is left,
+    * instead of giving a single slab to each thread. This balances the work when the cost per pixel 
+    * varies much across the image (background vs vessels). Ignored in sparse mode. Off by default. */
+  itkSetMacro( DynamicScheduling, bool );
+  itkGetConstMacro( DynamicScheduling, bool );
+  itkBooleanMacro( DynamicScheduling );
+  
+  /** Set/Get the size of the tiles in each dimension for dynamic scheduling. Default is 16. */
+  itkSetMacro( TileSize, unsigned long );
+  itkGetConstMacro( TileSize, unsigned long );
+  
+  /** Set/Get the radius in pixels by which the output requested region is padded to obtain the 
+    * input requested region. When only a part of the output is requested (streaming, or a slab 
+    * of a distributed computation, see SlabDecomposition) this must cover the support of the 
+    * image function, otherwise the function sees the border of the requested part as the border 
+    * of the image. Zero by default, which requests the same region as the output. */
+  itkSetMacro( InputPadding, InputImageSizeType );
+  itkGetConstReferenceMacro( InputPadding, InputImageSizeType );
+  
+  /** Set the same input padding for all the dimensions. */
+  void SetInputPadding( unsigned long padding )
+    {
+      InputImageSizeType size;
+      size.Fill( padding );
+      this->SetInputPadding( size );
+    }
+  
+  /** Set/Get the flag for initializing the output buffer from the threads, each one writing the 
+    * slab of the static split, instead of from the main thread. With first-touch page placement
+    * this keeps the output pages in the memory node of the thread that writes them on machines
+    * with several sockets. In dense mode without dynamic scheduling each thread already writes
+    * its slab first, so it only applies to sparse evaluation and dynamic scheduling. Use it with 
+    * ThreadAffinity. Off by default. */
+  itkSetMacro( FirstTouchInitialization, bool );
+  itkGetConstMacro( FirstTouchInitialization, bool );
+  itkBooleanMacro( FirstTouchInitialization );
+  
+  /** Set/Get the flag for pinning each thread to a processor while it runs, so that the thread 
+    * with a given id runs on the same processor (and memory node) in all the passes. 
+    * See ScopedThreadAffinity. Off by default. */
+  itkSetMacro( ThreadAffinity, bool );
+  itkGetConstMacro( ThreadAffinity, bool );
+  itkBooleanMacro( ThreadAffinity );
+  
+  /** Get the number of pixels where the image function was evaluated in the last execution. */
+  unsigned long GetNumberOfEvaluatedPixels() const;
+  
+  /** Get the time (in seconds) of the last execution, including the initialization of the 
+    * image functions. */
+  itkGetConstMacro( ElapsedTime, double );
+  
+  /** Get the number of evaluated pixels per second in the last execution. */
+  double GetThroughput() const;
+  
+  /** Get the time (in seconds) each thread spent evaluating in the last execution. */
+  const std::vector<double> & GetThreadBusyTimes() const
+    { return this->m_ThreadBusyTimes; }
+  
+  /** Print the timing summary of the last execution. */
+  void PrintTimingSummary( std::ostream & os ) const;
+  
+  /** Timing of the image function evaluations in the last execution. Empty unless built 
+    * with IVAN_USE_PROFILING. */
+  itkGetObjectMacro( Profile, PerformanceProfile );
+  
   /** Set the image input of this process object. Overriden from ImageToImageFilter.
     * Sets the input also to the existing scale filters. */
   //virtual void SetInput( const InputImageType *image );
@@ -100,6 +219,9 @@ protected:
   ImageFunctionBasedImageFilter();
   ~ImageFunctionBasedImageFilter() {};
   
+  /** Pad the input requested region by InputPadding. */
+  virtual void GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError );
+  
   /** Compute image function in each thread. */
   virtual void ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId );
 
@@ -107,8 +229,30 @@ protected:
   /** Compute image function for each of the threads. */
   virtual void BeforeThreadedGenerateData();
   
-  /**  */
-  virtual void AfterThreadedGenerateData() {}
+  /** Release the list of active pixels. */
+  virtual void AfterThreadedGenerateData();
+  
+  /** Evaluate the image function in the chunk of the active pixels list for the given thread. */
+  virtual void ThreadedGenerateSparseData( int threadId );
+  
+  /** Evaluate the image function in the given region from the given thread. Returns the number 
+    * of pixels where the function was evaluated. */
+  virtual unsigned long GenerateDataInRegion( const OutputImageRegionType& region, int threadId );
+  
+  /** Evaluate the image function in the runs of the packed mask inside the given region, and set
+    * the rest of the region to zero. Returns the number of pixels where the function was evaluated. */
+  virtual unsigned long GenerateMaskedDataInRegion( const OutputImageRegionType& region, int threadId );
+  
+  /** In sparse evaluation and dynamic scheduling, all the threads are used whatever the size of 
+    * the output region, since work is split by the list of active pixels or the tiles. */
+  virtual int SplitRequestedRegion( int i, int num, OutputImageRegionType& splitRegion );
+  
+  /** Add the given number of processed pixels to the progress counter. Progress events are only
+    * invoked from the first thread. */
+  void ReportProgress( int threadId, unsigned long numberOfPixels );
+  
+  /** Number of pixels processed by a thread between progress updates. */
+  itkStaticConstMacro( ProgressBlockSize, unsigned long, 1024 );
   
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
   
@@ -126,6 +270,43 @@ protected:
   ImageFunctionInitializerPointer       m_ImageFunctionInitializer;
   
   InputImagePixelType                   m_Threshold;
+  
+  typename PackedMaskType::ConstPointer m_PackedMask;
+  
+  bool                                  m_ShareImageFunction;
+  
+  bool                                  m_SparseEvaluation;
+  
+  /** Indices of the pixels above the threshold, in sparse mode. */
+  IndexContainerType                    m_ActiveIndices;
+  
+  /** Number of threads among which the active pixels are divided. */
+  int                                   m_NumberOfSparseThreads;
+  
+  bool                                  m_DynamicScheduling;
+  unsigned long                         m_TileSize;
+  
+  /** Queue of tiles of the output region, in dynamic scheduling mode. */
+  TileSchedulerPointer                  m_TileScheduler;
+  
+  InputImageSizeType                    m_InputPadding;
+  
+  bool                                  m_FirstTouchInitialization;
+  bool                                  m_ThreadAffinity;
+  
+  /** Progress counter shared by the threads. */
+  unsigned long                         m_ProcessedPixels;
+  unsigned long                         m_TotalPixels;
+  itk::SimpleFastMutexLock              m_ProgressMutex;
+  
+  /** Timing of the last execution. */
+  itk::TimeProbe                        m_TimeProbe;
+  double                                m_ElapsedTime;
+  std::vector<double>                   m_ThreadBusyTimes;
+  std::vector<unsigned long>            m_ThreadEvaluatedPixels;
+  
+  PerformanceProfile::Pointer           m_Profile;
+  PerformanceProfile::ProbeIdType       m_EvaluateProbe;
 };
 
   
@@ -32,94 +32,462 @@ SUCH DAMAGE.
 
 #include "ivanImageFunctionBasedImageFilter.h"
 
+#include "itkImageRegionIterator.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
 #include "itkNumericTraits.h"
 
 
 namespace ivan
 {
 
-template <class TInputImage, class TOutputImage, class TImageFunction>
-ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
 ::ImageFunctionBasedImageFilter() :
-  m_Threshold( itk::NumericTraits<InputImagePixelType>::Zero )
+  m_Threshold( itk::NumericTraits<InputImagePixelType>::Zero ),
+  m_ShareImageFunction( false ),
+  m_SparseEvaluation( false ),
+  m_NumberOfSparseThreads( 1 ),
+  m_DynamicScheduling( false ),
+  m_TileSize( 16 ),
+  m_FirstTouchInitialization( false ),
+  m_ThreadAffinity( false ),
+  m_ProcessedPixels( 0 ),
+  m_TotalPixels( 0 ),
+  m_ElapsedTime( 0.0 )
 {
+  m_Profile = PerformanceProfile::New();
+  m_EvaluateProbe = m_Profile->RegisterProbe( "Evaluate" );
+  
+  m_InputPadding.Fill( 0 );
+}
 
 
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+void 
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError )
+{
+  // Copies the output requested region to the input requested region
+  Superclass::GenerateInputRequestedRegion();
+  
+  typename TInputImage::Pointer image = const_cast<TInputImage *>( this->GetInput() );
+  
+  if( !image )
+    return;
+  
+  InputImageRegionType region = image->GetRequestedRegion();
+  region.PadByRadius( this->m_InputPadding );
+  region.Crop( image->GetLargestPossibleRegion() );
+  
+  image->SetRequestedRegion( region );
 }
 
 
-template <class TInputImage, class TOutputImage, class TImageFunction>
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
 void 
-ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
 ::BeforeThreadedGenerateData()
 {
+  this->m_TimeProbe = itk::TimeProbe();
+  this->m_TimeProbe.Start();
+  this->m_Profile->Reset();
+  
   typename TInputImage::Pointer inputImage = const_cast<TInputImage*>( this->GetInput() );
 
-  for( unsigned int i=0; i<this->GetNumberOfThreads(); ++i )
+  this->m_ImageFunctionContainer.clear();
+  
+  if( this->m_ShareImageFunction )
   {
+    // A single function (and its precomputed kernels) is used by all the threads
     ImageFunctionPointer imageFunction = ImageFunctionType::New();
     this->m_ImageFunctionInitializer->Initialize( imageFunction.GetPointer(), inputImage );
-    this->m_ImageFunctionContainer.push_back( imageFunction );
+    this->m_ImageFunctionContainer.resize( this->GetNumberOfThreads(), imageFunction );
+  }
+  else
+  {
+    for( unsigned int i=0; i<this->GetNumberOfThreads(); ++i )
+    {
+      ImageFunctionPointer imageFunction = ImageFunctionType::New();
+      this->m_ImageFunctionInitializer->Initialize( imageFunction.GetPointer(), inputImage );
+      this->m_ImageFunctionContainer.push_back( imageFunction );
+    }
   }
+  
+  this->m_ActiveIndices.clear();
+  
+  if( this->m_SparseEvaluation )
+  {
+    // Pixels not in the list are not visited by the threads, so they are set to zero here
+    typename TOutputImage::Pointer output = this->GetOutput();
+    
+    if( this->m_FirstTouchInitialization )
+    {
+      FirstTouchImageFiller<TOutputImage>::Fill( output, itk::NumericTraits<typename TOutputImage::PixelType>::Zero,
+        this->GetNumberOfThreads(), this->m_ThreadAffinity );
+    }
+    else
+      output->FillBuffer( itk::NumericTraits<typename TOutputImage::PixelType>::Zero );
+    
+    // Compact the pixels above the threshold, only in the runs of the mask if there is one
+    if( this->m_PackedMask )
+    {
+      typename PackedMaskType::RunContainerType runs;
+      OutputImageRegionType maskedRegion = output->GetRequestedRegion();
+      
+      if( maskedRegion.Crop( this->m_PackedMask->GetRegion() ) )
+        this->m_PackedMask->GetRunsInRegion( maskedRegion, runs );
+      
+      for( unsigned int i=0; i<runs.size(); ++i )
+      {
+        InputImageIndexType index = runs[i].Index;
+        
+        for( unsigned long j=0; j<runs[i].Length; ++j, ++index[0] )
+        {
+          if( inputImage->GetPixel( index ) > this->m_Threshold )
+            this->m_ActiveIndices.push_back( index );
+        }
+      }
+    }
+    else
+    {
+      itk::ImageRegionConstIteratorWithIndex<TInputImage> it( inputImage, output->GetRequestedRegion() );
+      
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+        if( it.Get() > this->m_Threshold )
+          this->m_ActiveIndices.push_back( it.GetIndex() );
+      }
+    }
+    
+    // Same number of threads that the multithreader will use
+    this->m_NumberOfSparseThreads = vnl_math_min( static_cast<int>( this->GetNumberOfThreads() ), 
+      static_cast<int>( itk::MultiThreader::GetGlobalMaximumNumberOfThreads() ) );
+    
+    itkDebugMacro(<<"Sparse evaluation of " << this->m_ActiveIndices.size() << " pixels");
+  }
+  else if( this->m_DynamicScheduling )
+  {
+    if( this->m_TileScheduler.IsNull() )
+      this->m_TileScheduler = TileSchedulerType::New();
+    
+    this->m_TileScheduler->SetRegion( this->GetOutput()->GetRequestedRegion() );
+    this->m_TileScheduler->SetTileSize( this->m_TileSize );
+    this->m_TileScheduler->Initialize();
+    
+    itkDebugMacro(<<"Dynamic scheduling of " << this->m_TileScheduler->GetNumberOfTiles() << " tiles");
+    
+    // Tiles are taken by any thread, but the pages are at least spread among the nodes
+    if( this->m_FirstTouchInitialization )
+    {
+      FirstTouchImageFiller<TOutputImage>::Fill( this->GetOutput(), 
+        itk::NumericTraits<typename TOutputImage::PixelType>::Zero, this->GetNumberOfThreads(), 
+        this->m_ThreadAffinity );
+    }
+  }
+  
+  // Progress and timing
+  this->m_ProcessedPixels = 0;
+  
+  if( this->m_SparseEvaluation )
+    this->m_TotalPixels = this->m_ActiveIndices.size();
+  else
+    this->m_TotalPixels = this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
+  
+  this->m_ThreadBusyTimes.assign( this->GetNumberOfThreads(), 0.0 );
+  this->m_ThreadEvaluatedPixels.assign( this->GetNumberOfThreads(), 0 );
+  this->m_ElapsedTime = 0.0;
 }
 
 
-template <class TInputImage, class TOutputImage, class TImageFunction>
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
 void 
-ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::AfterThreadedGenerateData()
+{
+  IndexContainerType().swap( this->m_ActiveIndices );
+  
+  this->m_TimeProbe.Stop();
+  this->m_ElapsedTime = this->m_TimeProbe.GetMeanTime();
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+int
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::SplitRequestedRegion( int i, int num, OutputImageRegionType& splitRegion )
+{
+  if( !this->m_SparseEvaluation && !this->m_DynamicScheduling )
+    return Superclass::SplitRequestedRegion( i, num, splitRegion );
+  
+  // The region is not used by the threads in sparse mode or with dynamic scheduling
+  splitRegion = this->GetOutput()->GetRequestedRegion();
+  return num;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+void 
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::ThreadedGenerateSparseData( int threadId )
+{
+  typename TOutputImage::Pointer output = this->GetOutput();
+  
+  const unsigned long numberOfIndices = this->m_ActiveIndices.size();
+  const unsigned long numberOfThreads = vnl_math_max( this->m_NumberOfSparseThreads, 1 );
+  
+  // Contiguous chunk of the list for this thread
+  const unsigned long begin = ( numberOfIndices * threadId ) / numberOfThreads;
+  const unsigned long end = ( numberOfIndices * ( threadId + 1 ) ) / numberOfThreads;
+  
+  ImageFunctionType *imageFunction = this->m_ImageFunctionContainer[threadId];
+  
+  itk::TimeProbe probe;
+  probe.Start();
+  
+  unsigned long blockCount = 0;
+  
+  for( unsigned long i = begin; i < end; ++i )
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_EvaluateProbe );
+    output->SetPixel( this->m_ActiveIndices[i], EvaluatorType::EvaluateAtIndex( imageFunction, this->m_ActiveIndices[i] ) );
+    
+    if( ++blockCount == ProgressBlockSize )
+    {
+      this->ReportProgress( threadId, blockCount );
+      blockCount = 0;
+    }
+  }
+  
+  this->ReportProgress( threadId, blockCount );
+  
+  probe.Stop();
+  this->m_ThreadBusyTimes[threadId] = probe.GetMeanTime();
+  this->m_ThreadEvaluatedPixels[threadId] = ( end > begin ) ? end - begin : 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+void 
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::ReportProgress( int threadId, unsigned long numberOfPixels )
+{
+  if( !numberOfPixels && threadId != 0 )
+    return;
+    
+  this->m_ProgressMutex.Lock();
+  this->m_ProcessedPixels += numberOfPixels;
+  const unsigned long processedPixels = this->m_ProcessedPixels;
+  this->m_ProgressMutex.Unlock();
+  
+  // As in itk::ProgressReporter, only the first thread invokes the progress events
+  if( threadId == 0 && this->m_TotalPixels > 0 )
+    this->UpdateProgress( static_cast<float>( processedPixels ) / static_cast<float>( this->m_TotalPixels ) );
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+unsigned long
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::GetNumberOfEvaluatedPixels() const
+{
+  unsigned long total = 0;
+  
+  for( unsigned int i=0; i<this->m_ThreadEvaluatedPixels.size(); ++i )
+    total += this->m_ThreadEvaluatedPixels[i];
+    
+  return total;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+double
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::GetThroughput() const
+{
+  if( this->m_ElapsedTime <= 0.0 )
+    return 0.0;
+    
+  return static_cast<double>( this->GetNumberOfEvaluatedPixels() ) / this->m_ElapsedTime;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+void
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::PrintTimingSummary( std::ostream & os ) const
+{
+  os << "Evaluated pixels: " << this->GetNumberOfEvaluatedPixels() << std::endl;
+  os << "Elapsed time (s): " << this->m_ElapsedTime << std::endl;
+  os << "Throughput (pixels/s): " << this->GetThroughput() << std::endl;
+  
+  for( unsigned int i=0; i<this->m_ThreadBusyTimes.size(); ++i )
+  {
+    os << "Thread " << i << ": busy time (s) " << this->m_ThreadBusyTimes[i] 
+       << ", evaluated pixels " << this->m_ThreadEvaluatedPixels[i] << std::endl;
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+void 
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
 ::ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId )
 {
+  ScopedThreadAffinity affinity( threadId, this->m_ThreadAffinity );
+  
+  if( this->m_SparseEvaluation )
+  {
+    this->ThreadedGenerateSparseData( threadId );
+    return;
+  }
+  
+  itk::TimeProbe probe;
+  probe.Start();
+  
+  unsigned long evaluatedPixels = 0;
+  
+  if( this->m_DynamicScheduling )
+  {
+    // Keep pulling tiles until the queue is empty
+    OutputImageRegionType tile;
+    
+    while( this->m_TileScheduler->GetNextTile( tile ) )
+      evaluatedPixels += this->GenerateDataInRegion( tile, threadId );
+  }
+  else
+    evaluatedPixels = this->GenerateDataInRegion( outputRegionForThread, threadId );
+  
+  probe.Stop();
+  this->m_ThreadBusyTimes[threadId] = probe.GetMeanTime();
+  this->m_ThreadEvaluatedPixels[threadId] = evaluatedPixels;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+unsigned long
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::GenerateDataInRegion( const OutputImageRegionType& region, int threadId )
+{
+  if( this->m_PackedMask )
+    return this->GenerateMaskedDataInRegion( region, threadId );
+  
   typedef itk::ImageRegionConstIterator<TInputImage>       ConstIteratorType;
   typedef itk::ImageRegionIteratorWithIndex<TInputImage>   IteratorType;
   
   typename TInputImage::Pointer  input = const_cast<TInputImage*>( this->GetInput() );
   typename TOutputImage::Pointer output = this->GetOutput();
 
-  ConstIteratorType it ( input,  outputRegionForThread );
-  IteratorType      oit( output, outputRegionForThread );
+  ConstIteratorType it ( input,  region );
+  IteratorType      oit( output, region );
 
   it.GoToBegin();
   oit.GoToBegin();
-
-  typename TInputImage::IndexType currentIndex;
-  unsigned long z = 0;
+  
+  unsigned long blockCount = 0;
+  unsigned long evaluatedPixels = 0;
 
   while( !it.IsAtEnd() )
   { 
-    currentIndex = it.GetIndex();
-
-    //if( currentIndex[0] == 20 && currentIndex[1] == 7 && currentIndex[2] == 5 ) // for cylinders
-    //if( currentIndex[0] == 82 && currentIndex[1] == 131 && currentIndex[2] == 13 ) // for liver MRI
-    //{
-      //std::cout << "Value: " << it.Get() << std::endl;
-    //}
-
-    if( currentIndex[2] != z )
+    if( it.Get() > this->m_Threshold )
     {
-      z = currentIndex[2];
-      std::cout << "Z = " << z << std::endl;
+      IVAN_PROFILE_SCOPE( this->m_Profile, this->m_EvaluateProbe );
+      oit.Set( EvaluatorType::EvaluateAtIndex( this->m_ImageFunctionContainer[threadId].GetPointer(), it.GetIndex() ) );
+      ++evaluatedPixels;
     }
-
-    if( it.Get() > this->m_Threshold )
-      oit.Set( this->m_ImageFunctionContainer[threadId]->EvaluateAtIndex( it.GetIndex() ) );
     else
       oit.Set(0);
+      
+    if( ++blockCount == ProgressBlockSize )
+    {
+      this->ReportProgress( threadId, blockCount );
+      blockCount = 0;
+    }
 
     ++it;
     ++oit;
   }
+  
+  this->ReportProgress( threadId, blockCount );
+  
+  return evaluatedPixels;
+}
+
+
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
+unsigned long
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
+::GenerateMaskedDataInRegion( const OutputImageRegionType& region, int threadId )
+{
+  typedef itk::ImageRegionIterator<TOutputImage>   IteratorType;
+  
+  typename TInputImage::Pointer  input = const_cast<TInputImage*>( this->GetInput() );
+  typename TOutputImage::Pointer output = this->GetOutput();
+  
+  // The pixels outside the mask are not read
+  IteratorType oit( output, region );
+  
+  for( oit.GoToBegin(); !oit.IsAtEnd(); ++oit )
+    oit.Set( itk::NumericTraits<typename TOutputImage::PixelType>::Zero );
+  
+  typename PackedMaskType::RunContainerType runs;
+  OutputImageRegionType maskedRegion = region;
+  
+  if( maskedRegion.Crop( this->m_PackedMask->GetRegion() ) )
+    this->m_PackedMask->GetRunsInRegion( maskedRegion, runs );
+  
+  unsigned long blockCount = 0;
+  unsigned long evaluatedPixels = 0;
+  unsigned long runPixels = 0;
+  
+  for( unsigned int i=0; i<runs.size(); ++i )
+  {
+    InputImageIndexType index = runs[i].Index;
+    
+    for( unsigned long j=0; j<runs[i].Length; ++j, ++index[0] )
+    {
+      if( input->GetPixel( index ) > this->m_Threshold )
+      {
+        IVAN_PROFILE_SCOPE( this->m_Profile, this->m_EvaluateProbe );
+        output->SetPixel( index, EvaluatorType::EvaluateAtIndex( this->m_ImageFunctionContainer[threadId].GetPointer(), index ) );
+        ++evaluatedPixels;
+      }
+      
+      if( ++blockCount == ProgressBlockSize )
+      {
+        this->ReportProgress( threadId, blockCount );
+        blockCount = 0;
+      }
+    }
+    
+    runPixels += runs[i].Length;
+  }
+  
+  // The pixels outside the mask count as processed
+  this->ReportProgress( threadId, blockCount + region.GetNumberOfPixels() - runPixels );
+  
+  return evaluatedPixels;
 }
 
 
-template <class TInputImage, class TOutputImage, class TImageFunction>
+template <class TInputImage, class TOutputImage, class TImageFunction, class TEvaluator>
 void
-ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction>
+ImageFunctionBasedImageFilter<TInputImage,TOutputImage,TImageFunction,TEvaluator>
 ::PrintSelf(std::ostream & os, itk::Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
 
-  // MISSING
+  os << indent << "Threshold: " << this->m_Threshold << std::endl;
+  os << indent << "PackedMask: " << this->m_PackedMask.GetPointer() << std::endl;
+  os << indent << "ShareImageFunction: " << this->m_ShareImageFunction << std::endl;
+  os << indent << "SparseEvaluation: " << this->m_SparseEvaluation << std::endl;
+  os << indent << "DynamicScheduling: " << this->m_DynamicScheduling << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+  os << indent << "InputPadding: " << this->m_InputPadding << std::endl;
+  os << indent << "FirstTouchInitialization: " << this->m_FirstTouchInitialization << std::endl;
+  os << indent << "ThreadAffinity: " << this->m_ThreadAffinity << std::endl;
 }
 
 } // end namespace ivan
@@ -0,0 +1,245 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageFunctionEvaluator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: evaluation policies of the image functions in the whole-image filters
+// Date: 2012/11/05
+
+#ifndef __ivanImageFunctionEvaluator_h
+#define __ivanImageFunctionEvaluator_h
+
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkNumericTraits.h"
+
+namespace ivan
+{
+/**
+ * \class ImageFunctionEvaluator
+ * \brief Evaluates an image function at an index through its virtual interface.
+ *
+ * The whole-image filters (see ImageFunctionBasedImageFilter) take the evaluation at each pixel
+ * from a policy class given as a template parameter. This is the default one, which calls the 
+ * virtual EvaluateAtIndex() and so works with any image function. 
+ *
+ * The other policies of this file compose the evaluation at compile time: the scaled functions 
+ * of a MultiscaleImageFunction, the vesselness measure and the reduction over scales are template 
+ * parameters, and their methods are called with qualified names, which binds them statically. 
+ * The compiler can then inline the chain from the filter to the measure at each pixel, instead of 
+ * going through the virtual calls of the multiscale function, the vesselness function and the 
+ * Hessian function for every scale.
+ *
+ * The static policies require the exact types of the functions created by the filter, and give 
+ * the same results as the virtual interface. The virtual interface is still used where these 
+ * policies do not apply.
+ *
+ * \sa StaticMultiscaleImageFunctionEvaluator
+ */
+template <class TImageFunction>
+class ImageFunctionEvaluator
+{
+public:
+
+  typedef TImageFunction                            ImageFunctionType;
+  typedef typename ImageFunctionType::OutputType    OutputType;
+  typedef typename ImageFunctionType::IndexType     IndexType;
+  
+  static OutputType EvaluateAtIndex( const ImageFunctionType *function, const IndexType& index )
+    { return function->EvaluateAtIndex( index ); }
+};
+
+
+/**
+ * \class ScaledImageFunctionEvaluator
+ * \brief Evaluates an image function of known type without a virtual call.
+ *
+ * The call to EvaluateAtIndex() of TImageFunction is bound statically, so the function must be 
+ * of this exact type (and not a subclass). The calls made inside EvaluateAtIndex() are unchanged.
+ */
+template <class TImageFunction>
+class ScaledImageFunctionEvaluator
+{
+public:
+
+  typedef TImageFunction                            ImageFunctionType;
+  typedef typename ImageFunctionType::OutputType    OutputType;
+  typedef typename ImageFunctionType::IndexType     IndexType;
+  
+  static OutputType EvaluateAtIndex( const ImageFunctionType *function, const IndexType& index )
+    { return function->TImageFunction::EvaluateAtIndex( index ); }
+};
+
+
+/**
+ * \class EigenValueVesselnessEvaluator
+ * \brief Evaluates a vesselness measure of the Hessian eigenvalues without virtual calls.
+ *
+ * For the measures of HessianOnlyBasedVesselnessImageFunction that only depend on the eigenvalues
+ * of the Hessian (Frangi, Sato, FilterByEigenValues), the Hessian at the index is computed with 
+ * the Hessian function, its eigenvalues with SymmetricEigenSolver and the measure with 
+ * EvaluateVesselnessFromEigenValues() of TVesselnessFunction, all with static calls. This is the 
+ * same computation as EvaluateAtIndex() of the measure, including the zero Hessian outside the 
+ * buffer.
+ */
+template <class TVesselnessFunction>
+class EigenValueVesselnessEvaluator
+{
+public:
+
+  typedef TVesselnessFunction                                   ImageFunctionType;
+  typedef typename ImageFunctionType::OutputType                OutputType;
+  typedef typename ImageFunctionType::IndexType                 IndexType;
+  typedef typename ImageFunctionType::HessianFunctionType       HessianFunctionType;
+  typedef typename ImageFunctionType::HessianTensorType         HessianTensorType;
+  typedef typename ImageFunctionType::EigenValuesArrayType      EigenValuesArrayType;
+  
+  static OutputType EvaluateAtIndex( const ImageFunctionType *function, const IndexType& index )
+    {
+      const HessianFunctionType *hessianFunction = function->GetHessianFunction();
+      
+      HessianTensorType hessian;
+      
+      if( hessianFunction->IsInsideBuffer( index ) )
+        hessian = hessianFunction->HessianFunctionType::EvaluateAtIndex( index );
+      else
+        hessian.Fill( 0.0 );
+      
+      EigenValuesArrayType eigenValues;
+      SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
+      
+      return function->TVesselnessFunction::EvaluateVesselnessFromEigenValues( eigenValues );
+    }
+};
+
+
+/**
+ * \class MaximumScaleReduction
+ * \brief Selects the maximum response over scales.
+ *
+ * Reductions give the initial value of the selection and update it with the response of each 
+ * scale, returning true when the response is selected. This one is the reduction of 
+ * MultiscaleImageFunction, with the same initial value.
+ */
+template <class TOutput>
+class MaximumScaleReduction
+{
+public:
+
+  static TOutput GetInitialValue()
+    { return itk::NumericTraits<TOutput>::min(); }
+  
+  static bool Update( const TOutput& response, TOutput& value )
+    {
+      if( response > value )
+      {
+        value = response;
+        return true;
+      }
+      
+      return false;
+    }
+};
+
+
+/**
+ * \class MinimumScaleReduction
+ * \brief Selects the minimum response over scales, for measures that are negative on vessels.
+ */
+template <class TOutput>
+class MinimumScaleReduction
+{
+public:
+
+  static TOutput GetInitialValue()
+    { return itk::NumericTraits<TOutput>::max(); }
+  
+  static bool Update( const TOutput& response, TOutput& value )
+    {
+      if( response < value )
+      {
+        value = response;
+        return true;
+      }
+      
+      return false;
+    }
+};
+
+
+/**
+ * \class StaticMultiscaleImageFunctionEvaluator
+ * \brief Evaluates a MultiscaleImageFunction with the scaled functions and the reduction known at
+ * compile time.
+ *
+ * Each scale is evaluated with TScaledEvaluator (see ScaledImageFunctionEvaluator and 
+ * EigenValueVesselnessEvaluator) and the responses are combined with TReduction. With the default
+ * MaximumScaleReduction the result is the same as EvaluateAtIndex() of the multiscale function. 
+ * The scale searches other than the exhaustive one are delegated to EvaluateAtIndex(), which 
+ * selects the maximum whatever the reduction.
+ *
+ * For example, a whole-image filter of the multiscale Frangi measure without virtual calls per 
+ * pixel is:
+ *
+ * \code
+ * typedef ivan::FrangiVesselnessImageFunction<ImageType,double>                    VesselnessType;
+ * typedef ivan::MultiscaleImageFunction<VesselnessType,ImageType,double>           MultiscaleType;
+ * typedef ivan::StaticMultiscaleImageFunctionEvaluator
+ *   <MultiscaleType,ivan::EigenValueVesselnessEvaluator<VesselnessType> >          EvaluatorType;
+ * typedef ivan::ImageFunctionBasedImageFilter
+ *   <ImageType,ImageType,MultiscaleType,EvaluatorType>                             FilterType;
+ * \endcode
+ */
+template <class TMultiscaleImageFunction, 
+  class TScaledEvaluator = ScaledImageFunctionEvaluator<typename TMultiscaleImageFunction::ScaledImageFunctionType>,
+  class TReduction = MaximumScaleReduction<typename TMultiscaleImageFunction::OutputType> >
+class StaticMultiscaleImageFunctionEvaluator
+{
+public:
+
+  typedef TMultiscaleImageFunction                  ImageFunctionType;
+  typedef typename ImageFunctionType::OutputType    OutputType;
+  typedef typename ImageFunctionType::IndexType     IndexType;
+  typedef TScaledEvaluator                          ScaledEvaluatorType;
+  typedef TReduction                                ReductionType;
+  
+  static OutputType EvaluateAtIndex( const ImageFunctionType *function, const IndexType& index )
+    {
+      const unsigned int numberOfScales = function->GetScales().size();
+      
+      if( function->GetScaleSearchMethod() != ImageFunctionType::ExhaustiveScaleSearch && numberOfScales > 3 )
+        return function->EvaluateAtIndex( index );
+      
+      OutputType value = ReductionType::GetInitialValue();
+      
+      for( unsigned int i=0; i < numberOfScales; ++i )
+        ReductionType::Update( ScaledEvaluatorType::EvaluateAtIndex( function->GetScaledImageFunction( i ), index ), value );
+      
+      return value;
+    }
+};
+
+} // end namespace ivan
+
+#endif
@@ -37,12 +37,26 @@ SUCH DAMAGE.
 #include "itkGradientRecursiveGaussianImageFilter.h"
 #include "itkHessianRecursiveGaussianImageFilter.h"
 #include "itkLaplacianRecursiveGaussianImageFilter.h"
+#include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "ivanMaskRunLengthEncoding.h"
+#include "ivanPerformanceProfile.h"
+#include "ivanFirstTouchImageFiller.h"
+#include "ivanThreadAffinity.h"
+#include "ivanTaskPool.h"
+#include "itkEventObject.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
 #include <vector>
 
 
 namespace ivan
 {
 
+/** Event invoked by MultiscaleAnalysisImageFilter after computing a scale (in each slab if 
+  * FusedScales is on). Observers get the statistics of the scale with GetLastScaleStatistics(). */
+itkEventMacro( ScaleCompletedEvent, itk::AnyEvent );
+
 /** \class MultiscaleAnalysisImageFilter
  *  \brief Base class for filters that perform analysis in scale-space at multiple scales
  *
@@ -64,12 +78,25 @@ public:
   
   typedef TInputImage		InputImageType;
   typedef TOutputImage  OutputImageType;
+  
+  typedef typename Superclass::OutputImageRegionType   OutputImageRegionType;
+  typedef typename Superclass::InputImageRegionType    InputImageRegionType;
+  
+  typedef std::vector<OutputImageRegionType>          RegionContainerType;
 
 	/** Image dimension = 3. */
   itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
                       
   /** Mask image types. */
   typedef TMaskImage			MaskImageType;
+  
+  /** Run-length encoding of the mask, built once per execution. */
+  typedef MaskRunLengthEncoding<MaskImageType>                MaskRunLengthEncodingType;
+  typedef typename MaskRunLengthEncodingType::RunType         MaskRunType;
+  typedef typename MaskRunLengthEncodingType::RunContainerType  MaskRunContainerType;
+  
+  /** Mask packed with one bit per pixel, built once per execution. */
+  typedef typename MaskRunLengthEncodingType::PackedMaskType  PackedMaskType;
  
  	/** Scale pixel types. */
   typedef TScalePixel		                                    ScalePixelType;
@@ -92,6 +119,39 @@ public:
     <TInputImage,VectorScaleImageType>	  GradientFilterType;
   typedef itk::HessianRecursiveGaussianImageFilter
     <TInputImage,TensorScaleImageType>	  HessianFilterType;  
+    
+  /** Timings in seconds and pixel counts of the computation of a scale. ScaleFiltersTime is the
+    * update of the scale filters or of the cascade, and ComputeTime is GenerateDataAtScale(), 
+    * where the values of each pixel are computed and merged with the maximum over the previous 
+    * scales. NumberOfScaleFiltersPixels is the number of pixels computed by each scale filter
+    * (or by the smoothing of the cascade). The other counts are given by the subclasses that skip 
+    * pixels before computing their values, with one count per rejection test. With FusedScales 
+    * on the values are accumulated over the slabs computed so far. */
+  struct ScaleStatistics
+  {
+    ScaleStatistics() : Scale( 0 ), ScaleFiltersTime( 0.0 ), ComputeTime( 0.0 ), 
+      NumberOfProcessedPixels( 0 ), NumberOfZeroTraceSkippedPixels( 0 ), 
+      NumberOfEigenValueSkippedPixels( 0 ), NumberOfIntensitySkippedPixels( 0 ),
+      NumberOfBoundSkippedPixels( 0 ), NumberOfScaleFiltersPixels( 0 ) {}
+    
+    ScalePixelType   Scale;
+    double           ScaleFiltersTime;
+    double           ComputeTime;
+    unsigned long    NumberOfProcessedPixels;
+    unsigned long    NumberOfZeroTraceSkippedPixels;
+    unsigned long    NumberOfEigenValueSkippedPixels;
+    unsigned long    NumberOfIntensitySkippedPixels;
+    unsigned long    NumberOfBoundSkippedPixels;
+    unsigned long    NumberOfScaleFiltersPixels;
+  };
+  
+  typedef std::vector<ScaleStatistics>   ScaleStatisticsContainerType;
+    
+  /** Smoothing filters used for the scale-space cascade. */
+  typedef itk::SmoothingRecursiveGaussianImageFilter
+    <TInputImage,ScaleImageType>	        CascadeInputSmoothingFilterType;
+  typedef itk::SmoothingRecursiveGaussianImageFilter
+    <ScaleImageType,ScaleImageType>	      CascadeSmoothingFilterType;
       
 public:
 
@@ -122,8 +182,8 @@ public:
   void SetNormalizeAcrossScale( bool normalizeInScaleSpace );
   itkGetMacro( NormalizeAcrossScale, bool );
   
-  /** Set if we want to make computations in pixels with zero value. If true, a mask is created
-  	* with the pixels that have zero value and is assigned as the mask image. */
+  /** Set if we want to make computations in pixels with zero value. If true and no mask image 
+  	* is set, the pixels of the input with non-zero value are packed as the mask of the execution. */
   void SetDoNotComputeZeroPixels( bool computeZeroPixels )
     { 
       m_DoNotComputeZeroPixels = computeZeroPixels;
@@ -131,6 +191,114 @@ public:
     }
   itkGetMacro( DoNotComputeZeroPixels, bool );
   
+  /** Set if all scales must be processed in a single sweep over the output. If true, the output 
+    * requested region is divided in slabs and, for each slab and scale, the scale filters are 
+    * computed on a crop of the input around the slab (the region of GetScaleFiltersRegion() padded 
+    * by KernelRadiusFactor times the scale) before computing the scale there. This way each scale 
+    * is filtered once per slab, the max-over-scales reduction for each slab is done while the 
+    * output, scales and derivative buffers are still hot, and the scale filter outputs only hold 
+    * a padded slab instead of the whole volume. As with CropToMaskBoundingBox, values near the 
+    * slab borders may differ slightly from those computed with the whole input. 
+    * False by default. */
+  itkSetMacro( FusedScales, bool );
+  itkGetConstMacro( FusedScales, bool );
+  itkBooleanMacro( FusedScales );
+  
+  /** Set/Get the number of slabs in which the output is divided when FusedScales is on. */
+  itkSetMacro( NumberOfSlabs, unsigned int );
+  itkGetConstMacro( NumberOfSlabs, unsigned int );
+  
+  /** Set if the scale-space must be built as a cascade. If true, scales are processed in 
+    * increasing order and the image at scale s(k+1) is obtained by smoothing the image at scale 
+    * s(k) with the incremental sigma sqrt( s(k+1)^2 - s(k)^2 ). Derivatives are then taken from 
+    * the smoothed image with central differences instead of running the recursive derivative 
+    * filters from the input at every scale. The same normalization factors (sigma^order) 
+    * used by each scale filter when its NormalizeAcrossScale flag is on are applied. 
+    * This is not compatible with FusedScales, which takes precedence. False by default. */
+  itkSetMacro( ScaleSpaceCascade, bool );
+  itkGetConstMacro( ScaleSpaceCascade, bool );
+  itkBooleanMacro( ScaleSpaceCascade );
+  
+  /** Set if, when a mask is used, the input of the scale filters must be cropped to the bounding 
+    * box of the mask padded by KernelRadiusFactor times the largest scale, the same padding used
+    * for streaming. The scale filters are then computed only around the mask, but values near 
+    * the mask border may differ slightly from those computed with the whole input. Regardless of 
+    * this flag, scales are only computed in the bounding box of the mask, and subclasses can 
+    * iterate only the runs of mask pixels with GetMaskRuns(). False by default. */
+  itkSetMacro( CropToMaskBoundingBox, bool );
+  itkGetConstMacro( CropToMaskBoundingBox, bool );
+  itkBooleanMacro( CropToMaskBoundingBox );
+  
+  /** Set/Get the factor that multiplied by the largest scale gives the radius (in physical units)
+    * by which the output requested region is padded to obtain the input requested region. 
+    * Default is 4.0. */
+  itkSetMacro( KernelRadiusFactor, double );
+  itkGetConstMacro( KernelRadiusFactor, double );
+  
+  /** Set if the outputs of the scale filters must keep their buffers from one scale to the next. 
+    * If true, the scale filters are updated with their ReleaseDataBeforeUpdateFlag off, so that 
+    * an update at a new scale writes in the buffers already allocated (which only grow with the 
+    * region) instead of freeing and allocating them again. True by default. */
+  itkSetMacro( ReuseScaleFiltersBuffers, bool );
+  itkGetConstMacro( ReuseScaleFiltersBuffers, bool );
+  itkBooleanMacro( ReuseScaleFiltersBuffers );
+  
+  /** Set if the outputs of the scale filters must be released at the end of GenerateData(), 
+    * as for an output with the ReleaseDataFlag on. Then only the outputs of this filter hold 
+    * memory between executions, at the cost of computing the scale filters again if executed 
+    * with the same scales. The images of the scale-space cascade are always released. 
+    * False by default. */
+  itkSetMacro( ReleaseScaleFiltersData, bool );
+  itkGetConstMacro( ReleaseScaleFiltersData, bool );
+  itkBooleanMacro( ReleaseScaleFiltersData );
+  
+  /** Set if the output buffers must be filled with zeros from the threads, each one writing the 
+    * slab it processes, instead of from the main thread. With first-touch page placement this 
+    * keeps the pages in the memory node of the thread that uses them on machines with several 
+    * sockets. Use it with ThreadAffinity. False by default. */
+  itkSetMacro( FirstTouchInitialization, bool );
+  itkGetConstMacro( FirstTouchInitialization, bool );
+  itkBooleanMacro( FirstTouchInitialization );
+  
+  /** Set if each thread must be pinned to a processor while it runs, so that the thread with a 
+    * given id runs on the same memory node in all the passes. See ScopedThreadAffinity. 
+    * False by default. */
+  itkSetMacro( ThreadAffinity, bool );
+  itkGetConstMacro( ThreadAffinity, bool );
+  itkBooleanMacro( ThreadAffinity );
+  
+  /** Set if the outputs must be updated incrementally after local changes of the input or the 
+    * mask. If true, copies of the input and the mask are kept between executions and, when only 
+    * their pixel values have changed, the outputs of the last execution are kept and only the 
+    * pixels within the padding of GetPaddedInputRegion() of the changed pixels are computed 
+    * again. As the slabs of FusedScales, each of these regions is filtered from a padded crop of
+    * the input, so the cost depends on the size of the changed regions and not on the size of 
+    * the input. The input and the mask must be edited in place (calling Modified() on them). Any 
+    * other change, such as new scales or parameters, a new mask, a different output requested 
+    * region, a different input geometry (for example after cropping) or released outputs, 
+    * computes everything again, as does ScaleSpaceCascade unless FusedScales is on. Since the 
+    * recursive gaussian filters have an infinite support, the pixels beyond the padding may 
+    * differ from a complete execution by the tail of the kernel beyond KernelRadiusFactor 
+    * times the largest scale. The ReleaseDataBeforeUpdateFlag is set off with this flag.
+    * False by default. */
+  virtual void SetIncrementalUpdate( bool incremental );
+  itkGetConstMacro( IncrementalUpdate, bool );
+  itkBooleanMacro( IncrementalUpdate );
+  
+  /** Regions of the output computed in the last execution. This is the output requested region 
+    * unless the last execution was incremental, in which case it may be empty if nothing 
+    * changed. */
+  const RegionContainerType & GetUpdatedRegions() const
+    { return this->m_UpdatedRegions; }
+  
+  /** Memory in bytes of the outputs and of the internal buffers (outputs of the scale filters, 
+    * images of the scale-space cascade, cropped input of the scale filters, zero pixels mask and 
+    * copies of the input and mask kept for IncrementalUpdate). 
+    * GetMemorySize() gives the current value and GetPeakMemorySize() the largest value of the 
+    * last execution, sampled after updating the scale filters at each scale. */
+  unsigned long GetMemorySize() const;
+  itkGetConstMacro( PeakMemorySize, unsigned long );
+  
   /** Get the current number of scales. */
   unsigned int GetNumberOfScales() const;
   
@@ -153,10 +321,26 @@ public:
   /** Clear all scales. */
   void ClearScales();   
   
-  /** This filter needs all of the input to produce an output.
-   * Therefore, MultiscaleAnalysisImageFilter needs to provide
+  /** Timing of the last execution, with a probe for the update of the scale filters and a 
+    * probe per scale, named "Scale " and the scale value. Empty unless built with 
+    * IVAN_USE_PROFILING. */
+  itkGetObjectMacro( Profile, PerformanceProfile );
+  
+  /** Statistics of each scale in the last execution, in the order in which the scales are 
+    * computed. Unlike the profile, they are always recorded. Progress events are invoked after 
+    * each scale (and each slab if FusedScales is on), followed by a ScaleCompletedEvent. */
+  const ScaleStatisticsContainerType & GetScaleStatistics() const
+    { return this->m_ScaleStatistics; }
+  
+  /** Statistics of the scale being computed or last computed. Only valid during an execution
+    * or after it, for example from a ScaleCompletedEvent observer. */
+  const ScaleStatistics & GetLastScaleStatistics() const
+    { return this->m_ScaleStatistics[this->m_CurrentStatisticsIndex]; }
+  
+  /** This filter needs the output requested region padded by the support of the largest 
+   * scale to produce an output. Therefore, MultiscaleAnalysisImageFilter needs to provide
    * an implementation for GenerateInputRequestedRegion in order to inform
-   * the pipeline execution model.
+   * the pipeline execution model. This allows streaming the filter in tiles.
    * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
   virtual void GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError );
   
@@ -167,19 +351,163 @@ protected:
   
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
   
-  /** Override since the filter produces the entire dataset and has one 
-    * more output than MultiscaleAnalysisImageFilter. */  
+  /** Override since the filter has one more output than ImageToImageFilter, which
+    * must be produced in the same region as the main output. */  
   virtual void EnlargeOutputRequestedRegion( itk::DataObject *output );
 
 	/** Prepare output images. Overriden from MultiscaleAnalysisImageFilter. */
 	virtual void PrepareData();
+	
+	/** Fill an allocated output or internal buffer, from the threads if FirstTouchInitialization 
+	  * is on. */
+	template <class TImage>
+	void FillBuffer( TImage *image, const typename TImage::PixelType & value )
+	  {
+	    if( this->m_FirstTouchInitialization )
+	      FirstTouchImageFiller<TImage>::Fill( image, value, this->GetNumberOfThreads(), this->m_ThreadAffinity );
+	    else
+	      image->FillBuffer( value );
+	  }
+	
+	/** Fill a region of an output, if it is buffered. Does nothing for a released output. */
+	template <class TImage>
+	static void FillRegion( TImage *image, const OutputImageRegionType & region, 
+	  const typename TImage::PixelType & value )
+	  {
+	    if( !image || !image->GetBufferedRegion().IsInside( region ) )
+	      return;
+	    
+	    itk::ImageRegionIterator<TImage> it( image, region );
+	    
+	    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+	      it.Set( value );
+	  }
+	
+	/** Reset the outputs in the given region to the values given by PrepareData(), before 
+	  * computing the region again in an incremental update. Subclasses with more outputs must 
+	  * reimplement it. */
+	virtual void ResetOutputsInRegion( const OutputImageRegionType & region );
+	
+	/** Compare the input and the mask with the copies kept from the last execution, updating them, 
+	  * and give the regions of the output that must be computed again, cropped to the output 
+	  * requested region and merged when they overlap. Returns false if everything must be 
+	  * computed, either because something else than the pixel values changed or there are no 
+	  * copies. Called by GenerateData() if IncrementalUpdate is on. */
+	virtual bool ComputeModifiedRegions( const MaskImageType *mask, RegionContainerType & regions );
+	
+	/** Keep the state of the filter and its outputs for the next incremental update, and copies 
+	  * of the input and the mask if copyImages is true. Otherwise the copies must have been 
+	  * updated by ComputeModifiedRegions(). */
+	virtual void StoreIncrementalState( const MaskImageType *mask, bool copyImages );
+	
+	/** Copy an image in the given region, with the information of the image. */
+	template <class TImage>
+	static typename TImage::Pointer CopyImageRegion( const TImage *image, const OutputImageRegionType & region )
+	  {
+	    typename TImage::Pointer copy = TImage::New();
+	    copy->CopyInformation( image );
+	    copy->SetBufferedRegion( region );
+	    copy->SetRequestedRegion( region );
+	    copy->Allocate();
+	    
+	    itk::ImageRegionConstIterator<TImage> it( image, region );
+	    itk::ImageRegionIterator<TImage> cit( copy, region );
+	    
+	    for( it.GoToBegin(), cit.GoToBegin(); !it.IsAtEnd(); ++it, ++cit )
+	      cit.Set( it.Get() );
+	    
+	    return copy;
+	  }
+	
+	/** Compare an image with its copy in the given region, copying the changed pixels, and add 
+	  * their bounding boxes to the given container. A changed pixel extends a box if it is 
+	  * within the given radius of it, otherwise it starts a new one. */
+	template <class TImage>
+	static void AddModifiedPixels( const TImage *image, TImage *copy, const OutputImageRegionType & region,
+	  const typename OutputImageRegionType::SizeType & radius, RegionContainerType & boxes );
+	
+	/** Merge the regions of the container that overlap into their bounding box. */
+	static void MergeOverlappingRegions( RegionContainerType & regions );
 
 	/** Reimplemented to generate data once at each scale. */
   virtual void GenerateData();
   
-  /** Generate a mask with the pixels which have zero value in the image. Then assign this
-    * as the mask image. This is called in GenerateData() when no mask is assigned and
-    * m_DoNotComputeZeroPixels is true. */
+  /** Returns the input region needed to compute the given output region. This is the region
+    * given by GetScaleFiltersRegion() at the largest scale padded by KernelRadiusFactor times
+    * the largest scale. */
+  virtual InputImageRegionType GetPaddedInputRegion( const OutputImageRegionType& outputRegion ) const;
+  
+  /** Connects the scale filters to an image that shares the input buffer but whose largest
+    * possible region is the buffered region of the input. */
+  virtual void PrepareScaleFiltersInput();
+  
+  /** Connect the allocated scale filters to the given image. */
+  void SetScaleFiltersInput( const InputImageType *image );
+  
+  /** Copy the given region of the image to a new image whose largest possible region is that 
+    * region, keeping the index and physical space of the image. */
+  static typename InputImageType::Pointer CropImage( const InputImageType *image, 
+    const InputImageRegionType & region );
+  
+  /** Number of pixels computed by the scale filters in their last update, the buffered region 
+    * of their outputs, or of the smoothed image if the scale-space cascade is in use. */
+  unsigned long GetNumberOfScaleFiltersPixels() const;
+  
+  /** Pack the pixels of the mask image with non-zero value in its buffered region, with the 
+    * threads of the filter. This is called in GenerateData() once per execution when there is 
+    * a mask image. */
+  virtual void PackMaskImage( const MaskImageType *mask );
+  
+  /** Build the run-length encoding of the packed mask in the output requested region. This is 
+    * called in GenerateData() once per execution when there is a mask. */
+  virtual void InitializeMaskRuns();
+  
+  /** Get the mask of the execution packed with one bit per pixel, either the mask image or the 
+    * non-zero pixels of the input. Only valid during the execution when a mask is used, NULL 
+    * otherwise. Subclasses should read the mask pixels from it instead of the mask image. */
+  const PackedMaskType * GetPackedMask() const
+    { return this->m_PackedMask.GetPointer(); }
+  
+  /** Get the run-length encoding of the mask in the output requested region. Only valid during
+    * the execution when a mask is used, NULL otherwise. All the runs are inside the current 
+    * output region, use MaskRunLengthEncoding::GetRunsInRegion() for the region of a thread. */
+  const MaskRunLengthEncodingType * GetMaskRuns() const
+    { return this->m_MaskRuns.GetPointer(); }
+  
+  /** Add pixel counts to the statistics of the current scale. May be called from several threads
+    * in GenerateDataAtScale(). */
+  void AddScalePixelCounts( unsigned long processed, unsigned long zeroTraceSkipped, 
+    unsigned long eigenValueSkipped, unsigned long intensitySkipped = 0, 
+    unsigned long boundSkipped = 0 );
+  
+  /** Generate the data of a scale in the current output region, recording its statistics, 
+    * and report the completion of a unit of work. Called by GenerateData(). */
+  void ComputeScale( const ScalePixelType currentScale, unsigned int statisticsIndex, bool useMask, 
+    unsigned int completedUnits, unsigned int numberOfUnits );
+  
+  /** Update the peak memory with the current memory size. */
+  void UpdatePeakMemorySize();
+  
+  /** Memory allocated by the buffer of an image in bytes (zero for a NULL image). */
+  template <class TImage>
+  static unsigned long GetImageMemorySize( const TImage *image )
+    {
+      if( !image || !image->GetPixelContainer() )
+        return 0;
+      
+      return image->GetPixelContainer()->Capacity() * sizeof( typename TImage::PixelType );
+    }
+  
+  /** Release the outputs of the scale filters. Called at the end of GenerateData() if 
+    * ReleaseScaleFiltersData is on. */
+  virtual void ReleaseScaleFiltersOutputs();
+  
+  /** Get the profile probe of the given scale, registering it the first time. */
+  PerformanceProfile::ProbeIdType GetScaleProbe( const ScalePixelType scale );
+  
+  /** Pack the pixels of the input requested region with non-zero value as the mask of the 
+    * execution, with the threads of the filter. This is called in GenerateData() when no mask
+    * is assigned and m_DoNotComputeZeroPixels is true. The mask image is not modified. */
   virtual void GenerateZeroPixelsMask();
   
   /** Called by GenerateData to generate data for the current scale. Must be reimplemented by subclasses. */
@@ -191,8 +519,74 @@ protected:
     */
   virtual void GenerateDataUsingMaskAtScale( const ScalePixelType currentScale );
   
+  /** Give the order in which the scales are computed, as a permutation of the given scales. 
+    * Subclasses that reject pixels against the maximum of the previous scales can compute the 
+    * most likely scales first. Not called if ScaleSpaceCascade is on, which needs the scales in 
+    * increasing order. Does nothing by default. */
+  virtual void OrderScales( ScaleContainerType & scales ) {}
+  
   /** Updates allocated scale filters at the current scale. */
   virtual void UpdateScaleFiltersAtScale( const ScalePixelType currentScale );
+  
+  /** Updates allocated scale filters at the current scale, but only in the given region. */
+  virtual void UpdateScaleFiltersAtScaleInRegion( const ScalePixelType currentScale, 
+    const OutputImageRegionType& region );
+  
+  /** Updates allocated scale filters at the current scale for computing a slab, or a modified 
+    * region of an incremental update, from a crop of their input padded by KernelRadiusFactor 
+    * times the scale around the given region. The recursive gaussian filters compute whole lines
+    * of their input, so the crop avoids filtering the whole input for every slab. */
+  virtual void UpdateScaleFiltersAtScaleInSlab( const ScalePixelType currentScale, 
+    const OutputImageRegionType& region );
+  
+  /** Returns the region where scale filters must be computed in order to generate the given
+    * output region at the given scale. By default this is the same region, which is valid for 
+    * filters that only need scale filter values at the pixel being computed. Subclasses that 
+    * sample neighbouring values must pad the region accordingly. */
+  virtual OutputImageRegionType GetScaleFiltersRegion( const ScalePixelType currentScale, 
+    const OutputImageRegionType& outputRegion ) const;
+  
+  /** Get the output region being currently computed by GenerateDataAtScale() and 
+    * GenerateDataUsingMaskAtScale(). This is the whole output requested region unless 
+    * FusedScales is on, in which case it is the current slab. */
+  const OutputImageRegionType& GetCurrentOutputRegion() const
+    { return m_CurrentOutputRegion; }
+  
+  /** Split the current output region (instead of the output requested region) so that 
+    * subclasses can use the standard multithreading machinery at each scale. */
+  virtual int SplitRequestedRegion( int i, int num, OutputImageRegionType& splitRegion );
+  
+  /** Updates the scale-space cascade at the current scale and computes the derivative 
+    * images of the allocated scale filters from it. Scales must be given in increasing order. 
+    * The derivatives are computed by the threads of the TaskPool, a chunk of lines each. */
+  virtual void UpdateScaleSpaceCascadeAtScale( const ScalePixelType currentScale );
+  
+  /** Loop of UpdateScaleSpaceCascadeAtScale() over the lines of the smoothed image along the
+    * first dimension. The derivative images are written through their buffers, which have the 
+    * region of the smoothed image, and those that are null are not computed. */
+  struct CascadeDerivativesFunction : public TaskPool::RangeFunction
+  {
+    const ScaleImageType    *SmoothedImage;
+    ScaleImageType          *GradientMagnitudeImage;
+    VectorScaleImageType    *GradientImage;
+    TensorScaleImageType    *HessianImage;
+    ScaleImageType          *LaplacianImage;
+    
+    double    GradientMagnitudeNormalization;
+    double    GradientNormalization;
+    double    HessianNormalization;
+    double    LaplacianNormalization;
+    
+    virtual void Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int threadId );
+  };
+  
+  /** Get the derivative images at the current scale. These are the outputs of the scale filters 
+    * or the images computed from the scale-space cascade if ScaleSpaceCascade is on. 
+    * Subclasses must use these instead of accessing the scale filter outputs directly. */
+  const ScaleImageType* GetGradientMagnitudeImage() const;
+  const VectorScaleImageType* GetGradientImage() const;
+  const TensorScaleImageType* GetHessianImage() const;
+  const ScaleImageType* GetLaplacianImage() const;
 
 private:
 
@@ -225,8 +619,78 @@ protected:
   /** Flag for computing pixels with zero value. */
   bool		 m_DoNotComputeZeroPixels;
   
-  /** Mask with zero pixels. */
-  typename MaskImageType::Pointer		m_ZeroPixelsMaskImage;
+  /** Mask of the execution, packed from the mask image or the non-zero pixels of the input. */
+  typename PackedMaskType::Pointer		m_PackedMask;
+  
+  /** Runs of the mask in the output requested region. */
+  typename MaskRunLengthEncodingType::Pointer		m_MaskRuns;
+  
+  /** Flag for cropping the input of the scale filters to the mask. */
+  bool		 m_CropToMaskBoundingBox;
+  
+  /** Flag for processing all scales in a single sweep over output slabs. */
+  bool		 m_FusedScales;
+  
+  /** Number of slabs used when m_FusedScales is true. */
+  unsigned int		m_NumberOfSlabs;
+  
+  /** Flags for the placement of the buffers on machines with several memory nodes. */
+  bool		m_FirstTouchInitialization;
+  bool		m_ThreadAffinity;
+  
+  /** Flag for incremental updates and the state of the last execution they compare with. */
+  bool		m_IncrementalUpdate;
+  typename InputImageType::Pointer		m_IncrementalInput;
+  typename MaskImageType::Pointer		  m_IncrementalMask;
+  OutputImageRegionType		m_IncrementalOutputRegion;
+  OutputImageRegionType		m_IncrementalMaskBoundingBox;
+  RegionContainerType		  m_IncrementalBufferedRegions;
+  unsigned long		        m_IncrementalMTime;
+  
+  /** Output regions computed in the last execution. */
+  RegionContainerType		m_UpdatedRegions;
+  
+  /** Output region currently being computed. */
+  OutputImageRegionType		m_CurrentOutputRegion;
+  
+  /** Factor for padding the requested region. */
+  double		m_KernelRadiusFactor;
+  
+  /** Input of the scale filters. Shares the buffer with the input. */
+  typename InputImageType::Pointer		m_ScaleFiltersInput;
+  
+  /** Crop of the input of the scale filters for the current slab and scale. */
+  typename InputImageType::Pointer		m_SlabScaleFiltersInput;
+  
+  /** Flag for computing the scale-space as a cascade of incremental smoothings. */
+  bool		 m_ScaleSpaceCascade;
+  
+  /** Scale of the current smoothed image in the cascade (zero if none). */
+  ScalePixelType		m_CascadeScale;
+  
+  /** Filters and images of the scale-space cascade. */
+  typename CascadeInputSmoothingFilterType::Pointer		m_CascadeInputSmoothingFilter;
+  typename CascadeSmoothingFilterType::Pointer		    m_CascadeSmoothingFilter;
+  typename ScaleImageType::Pointer		      m_CascadeSmoothedImage;
+  typename ScaleImageType::Pointer		      m_CascadeGradientMagnitudeImage;
+  typename VectorScaleImageType::Pointer		m_CascadeGradientImage;
+  typename TensorScaleImageType::Pointer		m_CascadeHessianImage;
+  typename ScaleImageType::Pointer		      m_CascadeLaplacianImage;
+  
+  /** Flags for the memory of the scale filters. */
+  bool		 m_ReuseScaleFiltersBuffers;
+  bool		 m_ReleaseScaleFiltersData;
+  
+  /** Peak memory of the last execution. */
+  unsigned long		m_PeakMemorySize;
+  
+  /** Statistics of the scales of the last execution. */
+  ScaleStatisticsContainerType		m_ScaleStatistics;
+  unsigned int		m_CurrentStatisticsIndex;
+  itk::SimpleFastMutexLock		m_StatisticsMutex;
+  
+  PerformanceProfile::Pointer		      m_Profile;
+  PerformanceProfile::ProbeIdType		  m_ScaleFiltersProbe;
     
 };
 
@@ -11,6 +11,11 @@
 #include "itkDataObject.h"
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
+#include "itkImageRegionSplitter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+#include <algorithm>
+#include <sstream>
 
 
 namespace ivan
@@ -20,11 +25,29 @@ template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskI
 MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 ::MultiscaleAnalysisImageFilter() :
 	m_NormalizeAcrossScale(false),
-	m_DoNotComputeZeroPixels(false)
+	m_DoNotComputeZeroPixels(false),
+	m_FusedScales(false),
+	m_NumberOfSlabs(16),
+	m_ScaleSpaceCascade(false),
+	m_KernelRadiusFactor(4.0),
+	m_CropToMaskBoundingBox(false),
+	m_ReuseScaleFiltersBuffers(true),
+	m_ReleaseScaleFiltersData(false),
+	m_FirstTouchInitialization(false),
+	m_ThreadAffinity(false),
+	m_IncrementalUpdate(false),
+	m_IncrementalMTime(0),
+	m_PeakMemorySize(0),
+	m_CurrentStatisticsIndex(0)
 {
+	this->m_CascadeScale = itk::NumericTraits<ScalePixelType>::Zero;
+
 	typename ScaleImageType::Pointer scalesOutput = ScaleImageType::New();
 	this->itk::ProcessObject::SetNumberOfRequiredOutputs(2);
 	this->itk::ProcessObject::SetNthOutput(1, scalesOutput.GetPointer());
+	
+	this->m_Profile = PerformanceProfile::New();
+	this->m_ScaleFiltersProbe = this->m_Profile->RegisterProbe( "ScaleFilters" );
 }
 
 
@@ -114,6 +137,28 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 }
 
 
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::SetIncrementalUpdate( bool incremental )
+{
+	if( this->m_IncrementalUpdate == incremental )
+		return;
+	
+	// The outputs must keep their buffers until GenerateData() to be updated incrementally
+	this->m_IncrementalUpdate = incremental;
+	this->SetReleaseDataBeforeUpdateFlag( !incremental );
+	
+	if( !incremental )
+	{
+		this->m_IncrementalInput = 0;
+		this->m_IncrementalMask = 0;
+	}
+	
+	this->Modified();
+}
+
+
 template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
 unsigned int 
 MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
@@ -237,6 +282,18 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
   os << "ScalesModified" << this->m_ScalesModified << std::endl;
 	os << "NormalizeAcrossScale: " << this->m_NormalizeAcrossScale << std::endl;
 	os << "DoNotComputeZeroPixels: " << this->m_DoNotComputeZeroPixels << std::endl;
+	os << indent << "FusedScales: " << this->m_FusedScales << std::endl;
+	os << indent << "NumberOfSlabs: " << this->m_NumberOfSlabs << std::endl;
+	os << indent << "FirstTouchInitialization: " << this->m_FirstTouchInitialization << std::endl;
+	os << indent << "ThreadAffinity: " << this->m_ThreadAffinity << std::endl;
+	os << indent << "IncrementalUpdate: " << this->m_IncrementalUpdate << std::endl;
+	os << indent << "NumberOfUpdatedRegions: " << this->m_UpdatedRegions.size() << std::endl;
+	os << indent << "ScaleSpaceCascade: " << this->m_ScaleSpaceCascade << std::endl;
+	os << indent << "KernelRadiusFactor: " << this->m_KernelRadiusFactor << std::endl;
+	os << indent << "CropToMaskBoundingBox: " << this->m_CropToMaskBoundingBox << std::endl;
+	os << indent << "ReuseScaleFiltersBuffers: " << this->m_ReuseScaleFiltersBuffers << std::endl;
+	os << indent << "ReleaseScaleFiltersData: " << this->m_ReleaseScaleFiltersData << std::endl;
+	os << indent << "PeakMemorySize: " << this->m_PeakMemorySize << std::endl;
 	
 	for( int i=0; i < this->m_Scales.size(); ++ i )
 	{
@@ -258,32 +315,69 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
   // copy the output requested region to the input requested region
   Superclass::GenerateInputRequestedRegion();
 
-  // This filter needs all of the input
+  // This filter needs the output requested region padded by the support of the largest scale
 
   typename InputImageType::Pointer image = const_cast<InputImageType *>( this->GetInput() );
-  image->SetRequestedRegion( this->GetInput()->GetLargestPossibleRegion() );
+  
+  if( !image )
+    return;
+  
+  const InputImageRegionType inputRegion = 
+    this->GetPaddedInputRegion( this->GetOutput()->GetRequestedRegion() );
+  
+  image->SetRequestedRegion( inputRegion );
 
 	typename MaskImageType::Pointer maskImage = dynamic_cast<TMaskImage*>( this->itk::ProcessObject::GetInput(1) );
 	if( maskImage )
-		maskImage->SetRequestedRegion( this->GetInput()->GetLargestPossibleRegion() );
+		maskImage->SetRequestedRegion( inputRegion );
 
 }
 
 
 template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
-void
+typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::InputImageRegionType
 MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
-::EnlargeOutputRequestedRegion( itk::DataObject *output )
+::GetPaddedInputRegion( const OutputImageRegionType& outputRegion ) const
 {
-  TOutputImage *out = dynamic_cast<TOutputImage*>(output);
+  const InputImageType *image = this->GetInput();
+  
+  if( !this->m_Scales.size() )
+    return outputRegion;
+  
+  const ScalePixelType maximumScale = this->GetMaximumScale();
+  
+  // Region needed by the subclass at the largest scale (with no padding by default)
+  InputImageRegionType region = this->GetScaleFiltersRegion( maximumScale, outputRegion );
+  
+  // Now add the support of the gaussian kernel at the largest scale
+  typename InputImageType::SpacingType spacing = image->GetSpacing();
+  typename InputImageRegionType::SizeType padding;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+  {
+    padding[i] = static_cast<typename InputImageRegionType::SizeValueType>
+      ( ceil( this->m_KernelRadiusFactor * maximumScale / spacing[i] ) );
+  }
+  
+  region.PadByRadius( padding );
+  region.Crop( image->GetLargestPossibleRegion() );
+  
+  return region;
+}
 
-  if (out)
-    out->SetRequestedRegion( out->GetLargestPossibleRegion() );
-      
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::EnlargeOutputRequestedRegion( itk::DataObject *itkNotUsed( output ) )
+{
+  // All outputs are produced for the requested region of the main output
+  TOutputImage *out = this->GetOutput();
+  
   ScaleImageType *scaleOutput = this->GetOutputScales();
   
-  if( scaleOutput )
-  	scaleOutput->SetRequestedRegion( out->GetLargestPossibleRegion() );  
+  if( out && scaleOutput )
+  	scaleOutput->SetRequestedRegion( out->GetRequestedRegion() );  
 }
 
 
@@ -298,13 +392,13 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 	typename OutputImageType::Pointer outputPtr = this->GetOutput(0);
   outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
   outputPtr->Allocate();
-	outputPtr->FillBuffer( itk::NumericTraits<typename OutputImageType::PixelType>::Zero );
+	this->FillBuffer( outputPtr.GetPointer(), itk::NumericTraits<typename OutputImageType::PixelType>::Zero );
 	
 	typename ScaleImageType::Pointer scalesPtr = dynamic_cast< ScaleImageType * >
 		( this->itk::ProcessObject::GetOutput(1) );
 	scalesPtr->SetBufferedRegion( scalesPtr->GetRequestedRegion() );
   scalesPtr->Allocate();
-	scalesPtr->FillBuffer( itk::NumericTraits<ScalePixelType>::Zero );
+	this->FillBuffer( scalesPtr.GetPointer(), itk::NumericTraits<ScalePixelType>::Zero );
 
 }
 
@@ -323,32 +417,531 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 	}
 
 
-	// Do not call AllocateOutputs() here
-	// Allocate memory for the outputs  
- 	this->PrepareData();
+	this->m_Profile->Reset();
+	this->m_PeakMemorySize = 0;
+	
+	this->m_ScaleStatistics.clear();
+	this->m_ScaleStatistics.resize( this->m_Scales.size() );
+	this->m_CurrentStatisticsIndex = 0;
 	
 	typename MaskImageType::ConstPointer mask = this->GetMaskImage();
 	
-	if( !mask && this->m_DoNotComputeZeroPixels )
-	{
+	// The mask is packed and encoded once for all the scales, which are only computed in its 
+	// bounding box. Without a mask image, the non-zero pixels of the input may be the mask
+	this->m_MaskRuns = 0;
+	this->m_PackedMask = 0;
+	
+	if( mask )
+		this->PackMaskImage( mask );
+	else if( this->m_DoNotComputeZeroPixels )
 		this->GenerateZeroPixelsMask();
-		mask = this->GetMaskImage();
+	
+	const bool useMask = this->m_PackedMask.IsNotNull();
+	
+	if( useMask )
+		this->InitializeMaskRuns();
+	
+	// An incremental update keeps the outputs of the last execution and only resets the regions 
+	// affected by the changes of the input and the mask
+	this->m_UpdatedRegions.clear();
+	
+	const bool incremental = this->m_IncrementalUpdate && 
+		this->ComputeModifiedRegions( mask, this->m_UpdatedRegions );
+	
+	if( incremental )
+	{
+		itkDebugMacro(<<"Incremental update of " << this->m_UpdatedRegions.size() << " regions");
+		
+		for( unsigned int i=0; i < this->m_UpdatedRegions.size(); ++i )
+			this->ResetOutputsInRegion( this->m_UpdatedRegions[i] );
+	}
+	else
+	{
+		// Do not call AllocateOutputs() here
+		// Allocate memory for the outputs  
+		this->PrepareData();
+		this->m_UpdatedRegions.push_back( this->GetOutput()->GetRequestedRegion() );
+	}
+	
+	if( this->m_IncrementalUpdate )
+		this->StoreIncrementalState( mask, !incremental );
+	else
+	{
+		this->m_IncrementalInput = 0;
+		this->m_IncrementalMask = 0;
 	}
 	
+	if( this->m_MaskRuns.IsNotNull() && this->m_MaskRuns->IsEmpty() )
+	{
+		itkDebugMacro(<<"No pixels inside the mask. Nothing to compute");
+		this->m_MaskRuns = 0;
+		this->m_PackedMask = 0;
+		return;
+	}
+	
+	const OutputImageRegionType computedRegion = ( useMask )? 
+		this->m_MaskRuns->GetBoundingBox() : this->GetOutput()->GetRequestedRegion();
+	
+	// Regions computed in an incremental update, inside the computed region
+	RegionContainerType modifiedRegions;
+	
+	for( unsigned int i=0; incremental && i < this->m_UpdatedRegions.size(); ++i )
+	{
+		OutputImageRegionType region = this->m_UpdatedRegions[i];
+		
+		if( region.Crop( computedRegion ) )
+			modifiedRegions.push_back( region );
+	}
+	
+	if( incremental && modifiedRegions.empty() )
+	{
+		itkDebugMacro(<<"No changes since the last execution. Nothing to compute");
+		this->m_MaskRuns = 0;
+		this->m_PackedMask = 0;
+		return;
+	}
+	
+	// Scale filters are computed in the buffered input only (the padded requested region)
+	this->PrepareScaleFiltersInput();
 	   	
- 	typename ScaleContainerType::const_iterator it = m_Scales.begin();
+	typename ScaleContainerType::const_iterator it;
 	
-	while( it != this->m_Scales.end() )
+	if( !this->m_FusedScales && !incremental )
 	{
-		this->UpdateScaleFiltersAtScale( *it );
-
-		if (!mask)
-			this->GenerateDataAtScale( *it );
+		this->m_CurrentOutputRegion = computedRegion;
+		
+		// The cascade needs the scales in increasing order 
+		ScaleContainerType scales = this->m_Scales;
+		
+		if( this->m_ScaleSpaceCascade )
+		{
+			std::sort( scales.begin(), scales.end() );
+			this->m_CascadeScale = itk::NumericTraits<ScalePixelType>::Zero;
+		}
 		else
-			this->GenerateDataUsingMaskAtScale( *it );
-		++it;		
+			this->OrderScales( scales );
+		
+		it = scales.begin();
+		
+		for( unsigned int k=0; it != scales.end(); ++k, ++it )
+		{
+			IVAN_PROFILE_SCOPE( this->m_Profile, this->GetScaleProbe( *it ) );
+			
+			itk::TimeProbe scaleFiltersProbe;
+			scaleFiltersProbe.Start();
+			
+			{
+				IVAN_PROFILE_SCOPE( this->m_Profile, this->m_ScaleFiltersProbe );
+				
+				if( this->m_ScaleSpaceCascade )
+					this->UpdateScaleSpaceCascadeAtScale( *it );
+				else
+					this->UpdateScaleFiltersAtScale( *it );
+			}
+			
+			scaleFiltersProbe.Stop();
+			this->m_ScaleStatistics[k].ScaleFiltersTime += scaleFiltersProbe.GetMeanTime();
+			this->m_ScaleStatistics[k].NumberOfScaleFiltersPixels += this->GetNumberOfScaleFiltersPixels();
+			
+			this->UpdatePeakMemorySize();
+			
+			this->ComputeScale( *it, k, useMask, k + 1, scales.size() );
+		}
 	}
-   
+	else
+	{
+		if( this->m_ScaleSpaceCascade && this->m_FusedScales )
+			itkWarningMacro(<<"ScaleSpaceCascade is not compatible with FusedScales. Ignoring cascade");
+		
+		// Divide the output in slabs and compute all the scales in each slab before going to the next.
+		// The modified regions of an incremental update are computed in the same way
+		RegionContainerType slabs = modifiedRegions;
+		
+		if( !incremental )
+		{
+			typedef itk::ImageRegionSplitter<ImageDimension>  SplitterType;
+			typename SplitterType::Pointer splitter = SplitterType::New();
+			
+			const unsigned int numberOfSplits = 
+				splitter->GetNumberOfSplits( computedRegion, vnl_math_max( this->m_NumberOfSlabs, 1u ) );
+			
+			for( unsigned int i=0; i<numberOfSplits; ++i )
+				slabs.push_back( splitter->GetSplit( i, numberOfSplits, computedRegion ) );
+		}
+		
+		const unsigned int numberOfSlabs = slabs.size();
+		
+		itkDebugMacro(<<"Computing fused scales in " << numberOfSlabs << " slabs");
+		
+		// The same order is used in all the slabs
+		ScaleContainerType scales = this->m_Scales;
+		this->OrderScales( scales );
+		
+		for( unsigned int i=0; i<numberOfSlabs; ++i )
+		{
+			this->m_CurrentOutputRegion = slabs[i];
+			
+			it = scales.begin();
+			
+			for( unsigned int k=0; it != scales.end(); ++k, ++it )
+			{
+				IVAN_PROFILE_SCOPE( this->m_Profile, this->GetScaleProbe( *it ) );
+				
+				OutputImageRegionType scaleFiltersRegion = this->GetScaleFiltersRegion( *it, this->m_CurrentOutputRegion );
+				scaleFiltersRegion.Crop( this->m_ScaleFiltersInput->GetLargestPossibleRegion() );
+				
+				itk::TimeProbe scaleFiltersProbe;
+				scaleFiltersProbe.Start();
+				
+				{
+					IVAN_PROFILE_SCOPE( this->m_Profile, this->m_ScaleFiltersProbe );
+					this->UpdateScaleFiltersAtScaleInSlab( *it, scaleFiltersRegion );
+				}
+				
+				scaleFiltersProbe.Stop();
+				this->m_ScaleStatistics[k].ScaleFiltersTime += scaleFiltersProbe.GetMeanTime();
+				this->m_ScaleStatistics[k].NumberOfScaleFiltersPixels += this->GetNumberOfScaleFiltersPixels();
+				
+				this->UpdatePeakMemorySize();
+				
+				this->ComputeScale( *it, k, useMask, i * scales.size() + k + 1, 
+					numberOfSlabs * scales.size() );
+			}
+		}
+	}
+	
+	this->m_CurrentOutputRegion = this->GetOutput()->GetRequestedRegion();
+	
+	// Release the mask, the cascade images and the input of the scale filters
+	this->m_MaskRuns = 0;
+	this->m_PackedMask = 0;
+	this->m_ScaleFiltersInput = 0;
+	this->m_SlabScaleFiltersInput = 0;
+	this->m_CascadeSmoothedImage = 0;
+	this->m_CascadeGradientMagnitudeImage = 0;
+	this->m_CascadeGradientImage = 0;
+	this->m_CascadeHessianImage = 0;
+	this->m_CascadeLaplacianImage = 0;
+	
+	if( this->m_ReleaseScaleFiltersData )
+		this->ReleaseScaleFiltersOutputs();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ComputeScale( const ScalePixelType currentScale, unsigned int statisticsIndex, bool useMask, 
+	unsigned int completedUnits, unsigned int numberOfUnits )
+{
+	this->m_CurrentStatisticsIndex = statisticsIndex;
+	this->m_ScaleStatistics[statisticsIndex].Scale = currentScale;
+	
+	itk::TimeProbe computeProbe;
+	computeProbe.Start();
+	
+	if( !useMask )
+		this->GenerateDataAtScale( currentScale );
+	else
+		this->GenerateDataUsingMaskAtScale( currentScale );
+	
+	computeProbe.Stop();
+	this->m_ScaleStatistics[statisticsIndex].ComputeTime += computeProbe.GetMeanTime();
+	
+	this->UpdateProgress( static_cast<float>( completedUnits ) / static_cast<float>( numberOfUnits ) );
+	this->InvokeEvent( ScaleCompletedEvent() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::AddScalePixelCounts( unsigned long processed, unsigned long zeroTraceSkipped, 
+	unsigned long eigenValueSkipped, unsigned long intensitySkipped, unsigned long boundSkipped )
+{
+	this->m_StatisticsMutex.Lock();
+	
+	ScaleStatistics & statistics = this->m_ScaleStatistics[this->m_CurrentStatisticsIndex];
+	statistics.NumberOfProcessedPixels += processed;
+	statistics.NumberOfZeroTraceSkippedPixels += zeroTraceSkipped;
+	statistics.NumberOfEigenValueSkippedPixels += eigenValueSkipped;
+	statistics.NumberOfIntensitySkippedPixels += intensitySkipped;
+	statistics.NumberOfBoundSkippedPixels += boundSkipped;
+	
+	this->m_StatisticsMutex.Unlock();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ReleaseScaleFiltersOutputs()
+{
+	if( this->m_GradientMagnitudeGaussian.IsNotNull() )
+		this->m_GradientMagnitudeGaussian->GetOutput()->ReleaseData();
+	
+	if( this->m_GradientGaussian.IsNotNull() )
+		this->m_GradientGaussian->GetOutput()->ReleaseData();
+	
+	if( this->m_HessianGaussian.IsNotNull() )
+		this->m_HessianGaussian->GetOutput()->ReleaseData();
+	
+	if( this->m_LaplacianGaussian.IsNotNull() )
+		this->m_LaplacianGaussian->GetOutput()->ReleaseData();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+unsigned long
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetMemorySize() const
+{
+	unsigned long size = GetImageMemorySize( this->GetOutput() ) + 
+		GetImageMemorySize( dynamic_cast<const ScaleImageType *>( this->itk::ProcessObject::GetOutput(1) ) );
+	
+	if( this->m_GradientMagnitudeGaussian.IsNotNull() )
+		size += GetImageMemorySize( this->m_GradientMagnitudeGaussian->GetOutput() );
+	
+	if( this->m_GradientGaussian.IsNotNull() )
+		size += GetImageMemorySize( this->m_GradientGaussian->GetOutput() );
+	
+	if( this->m_HessianGaussian.IsNotNull() )
+		size += GetImageMemorySize( this->m_HessianGaussian->GetOutput() );
+	
+	if( this->m_LaplacianGaussian.IsNotNull() )
+		size += GetImageMemorySize( this->m_LaplacianGaussian->GetOutput() );
+	
+	size += GetImageMemorySize( this->m_CascadeSmoothedImage.GetPointer() );
+	size += GetImageMemorySize( this->m_CascadeGradientMagnitudeImage.GetPointer() );
+	size += GetImageMemorySize( this->m_CascadeGradientImage.GetPointer() );
+	size += GetImageMemorySize( this->m_CascadeHessianImage.GetPointer() );
+	size += GetImageMemorySize( this->m_CascadeLaplacianImage.GetPointer() );
+	size += GetImageMemorySize( this->m_IncrementalInput.GetPointer() );
+	size += GetImageMemorySize( this->m_IncrementalMask.GetPointer() );
+	
+	if( this->m_PackedMask.IsNotNull() )
+		size += this->m_PackedMask->GetMemorySize();
+	
+	// The input of the scale filters only has its own buffer when cropped
+	const InputImageType *input = this->GetInput();
+	
+	if( this->m_ScaleFiltersInput.IsNotNull() && 
+		( !input || this->m_ScaleFiltersInput->GetPixelContainer() != input->GetPixelContainer() ) )
+	{
+		size += GetImageMemorySize( this->m_ScaleFiltersInput.GetPointer() );
+	}
+	
+	if( this->m_SlabScaleFiltersInput.IsNotNull() && this->m_SlabScaleFiltersInput != this->m_ScaleFiltersInput )
+		size += GetImageMemorySize( this->m_SlabScaleFiltersInput.GetPointer() );
+	
+	return size;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::UpdatePeakMemorySize()
+{
+	this->m_PeakMemorySize = vnl_math_max( this->m_PeakMemorySize, this->GetMemorySize() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+PerformanceProfile::ProbeIdType
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetScaleProbe( const ScalePixelType scale )
+{
+	std::ostringstream name;
+	name << "Scale " << static_cast<typename itk::NumericTraits<ScalePixelType>::PrintType>( scale );
+	
+	return this->m_Profile->RegisterProbe( name.str() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+int
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::SplitRequestedRegion( int i, int num, OutputImageRegionType& splitRegion )
+{
+	typedef itk::ImageRegionSplitter<ImageDimension>  SplitterType;
+	typename SplitterType::Pointer splitter = SplitterType::New();
+	
+	const int total = splitter->GetNumberOfSplits( this->m_CurrentOutputRegion, num );
+	
+	if( i < total )
+		splitRegion = splitter->GetSplit( i, total, this->m_CurrentOutputRegion );
+	
+	return total;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::OutputImageRegionType
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetScaleFiltersRegion( const ScalePixelType itkNotUsed( currentScale ), 
+	const OutputImageRegionType& outputRegion ) const
+{
+	return outputRegion;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::PrepareScaleFiltersInput()
+{
+	// Create an image that shares the buffer of the input but whose largest possible region is the 
+	// buffered region. This way the scale filters, which request their whole input, do not trigger  
+	// the upstream pipeline to produce the whole image when streaming
+	typename InputImageType::ConstPointer inputPtr  = this->GetInput();
+	
+	InputImageRegionType scaleFiltersInputRegion = inputPtr->GetBufferedRegion();
+	
+	// With a mask, the scale filters may only need the padded bounding box of the mask
+	if( this->m_CropToMaskBoundingBox && this->m_MaskRuns.IsNotNull() )
+	{
+		InputImageRegionType cropRegion = this->GetPaddedInputRegion( this->m_MaskRuns->GetBoundingBox() );
+		
+		if( cropRegion.Crop( scaleFiltersInputRegion ) )
+			scaleFiltersInputRegion = cropRegion;
+	}
+	
+	this->m_ScaleFiltersInput = InputImageType::New();
+	this->m_ScaleFiltersInput->CopyInformation( inputPtr );
+	this->m_ScaleFiltersInput->SetRegions( scaleFiltersInputRegion );
+	
+	if( scaleFiltersInputRegion == inputPtr->GetBufferedRegion() )
+	{
+		this->m_ScaleFiltersInput->SetPixelContainer( 
+			const_cast<typename InputImageType::PixelContainer *>( inputPtr->GetPixelContainer() ) );
+	}
+	else
+	{
+		// The buffer cannot be shared with a smaller region, so copy the cropped input
+		itkDebugMacro(<<"Cropping the input of the scale filters to " << scaleFiltersInputRegion);
+		
+		this->m_ScaleFiltersInput = CropImage( inputPtr, scaleFiltersInputRegion );
+	}
+	
+	// Updates at a new scale write in the buffers of the previous scale instead of reallocating them
+	const bool releaseBeforeUpdate = !this->m_ReuseScaleFiltersBuffers;
+	
+	if( m_GradientMagnitudeGaussian.IsNotNull() )
+		m_GradientMagnitudeGaussian->SetReleaseDataBeforeUpdateFlag( releaseBeforeUpdate );
+	
+	if( m_GradientGaussian.IsNotNull() )
+		m_GradientGaussian->SetReleaseDataBeforeUpdateFlag( releaseBeforeUpdate );
+	
+	if( m_HessianGaussian.IsNotNull() )
+		m_HessianGaussian->SetReleaseDataBeforeUpdateFlag( releaseBeforeUpdate );
+	
+	if( m_LaplacianGaussian.IsNotNull() )
+		m_LaplacianGaussian->SetReleaseDataBeforeUpdateFlag( releaseBeforeUpdate );
+	
+	this->m_SlabScaleFiltersInput = 0;
+	this->SetScaleFiltersInput( this->m_ScaleFiltersInput );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::SetScaleFiltersInput( const InputImageType *image )
+{
+	if( m_GradientMagnitudeGaussian.IsNotNull() )
+		m_GradientMagnitudeGaussian->SetInput( image );
+	
+	if( m_GradientGaussian.IsNotNull() )
+		m_GradientGaussian->SetInput( image );
+	
+	if( m_HessianGaussian.IsNotNull() )
+		m_HessianGaussian->SetInput( image );
+	
+	if( m_LaplacianGaussian.IsNotNull() )
+		m_LaplacianGaussian->SetInput( image );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::InputImageType::Pointer
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::CropImage( const InputImageType *image, const InputImageRegionType & region )
+{
+	typename InputImageType::Pointer crop = InputImageType::New();
+	crop->CopyInformation( image );
+	crop->SetRegions( region );
+	crop->Allocate();
+	
+	itk::ImageRegionConstIterator<InputImageType> inputIt( image, region );
+	itk::ImageRegionIterator<InputImageType> cropIt( crop, region );
+	
+	for( inputIt.GoToBegin(), cropIt.GoToBegin(); !inputIt.IsAtEnd(); ++inputIt, ++cropIt )
+		cropIt.Set( inputIt.Get() );
+	
+	return crop;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+unsigned long
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetNumberOfScaleFiltersPixels() const
+{
+	// All the scale filters compute the same region
+	if( this->m_ScaleSpaceCascade && !this->m_FusedScales && this->m_CascadeSmoothedImage.IsNotNull() )
+		return this->m_CascadeSmoothedImage->GetBufferedRegion().GetNumberOfPixels();
+	
+	if( this->m_GradientMagnitudeGaussian.IsNotNull() )
+		return this->m_GradientMagnitudeGaussian->GetOutput()->GetBufferedRegion().GetNumberOfPixels();
+	
+	if( this->m_GradientGaussian.IsNotNull() )
+		return this->m_GradientGaussian->GetOutput()->GetBufferedRegion().GetNumberOfPixels();
+	
+	if( this->m_HessianGaussian.IsNotNull() )
+		return this->m_HessianGaussian->GetOutput()->GetBufferedRegion().GetNumberOfPixels();
+	
+	if( this->m_LaplacianGaussian.IsNotNull() )
+		return this->m_LaplacianGaussian->GetOutput()->GetBufferedRegion().GetNumberOfPixels();
+	
+	return 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::PackMaskImage( const MaskImageType *mask )
+{
+	this->m_PackedMask = PackedMaskType::New();
+	this->m_PackedMask->PackNonZeroPixels( mask, mask->GetBufferedRegion(), this->GetNumberOfThreads() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::InitializeMaskRuns()
+{
+	if( this->m_MaskRuns.IsNull() )
+		this->m_MaskRuns = MaskRunLengthEncodingType::New();
+	
+	// Only the mask pixels of the output requested region are computed
+	OutputImageRegionType region = this->GetOutput()->GetRequestedRegion();
+	
+	if( !region.Crop( this->m_PackedMask->GetRegion() ) )
+	{
+		typename OutputImageRegionType::SizeType emptySize;
+		emptySize.Fill( 0 );
+		region.SetSize( emptySize );
+	}
+	
+	this->m_MaskRuns->SetPackedMask( this->m_PackedMask );
+	this->m_MaskRuns->SetRegion( region );
+	this->m_MaskRuns->Initialize();
+	
+	itkDebugMacro(<<"Mask has " << this->m_MaskRuns->GetNumberOfPixels() << " pixels in " 
+		<< this->m_MaskRuns->GetNumberOfRuns() << " runs, bounding box " << this->m_MaskRuns->GetBoundingBox());
 }
 
 
@@ -359,31 +952,266 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 {
 	typename InputImageType::ConstPointer inputPtr  = this->GetInput();
 	
-	this->m_ZeroPixelsMaskImage = MaskImageType::New();
-	this->m_ZeroPixelsMaskImage->SetRegions( inputPtr->GetRequestedRegion() );
-	this->m_ZeroPixelsMaskImage->SetOrigin( inputPtr->GetOrigin() );
-	this->m_ZeroPixelsMaskImage->SetSpacing( inputPtr->GetSpacing() );
-	this->m_ZeroPixelsMaskImage->SetDirection( inputPtr->GetDirection() );
-	this->m_ZeroPixelsMaskImage->Allocate();
+	// The lines of the input are packed in parallel, a bit per pixel
+	this->m_PackedMask = PackedMaskType::New();
+	this->m_PackedMask->PackNonZeroPixels( inputPtr.GetPointer(), inputPtr->GetRequestedRegion(), 
+		this->GetNumberOfThreads() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ResetOutputsInRegion( const OutputImageRegionType & region )
+{
+	this->FillRegion( this->GetOutput(), region, itk::NumericTraits<typename OutputImageType::PixelType>::Zero );
+	this->FillRegion( this->GetOutputScales(), region, itk::NumericTraits<ScalePixelType>::Zero );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+bool 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ComputeModifiedRegions( const MaskImageType *mask, RegionContainerType & regions )
+{
+	const InputImageType *input = this->GetInput();
+	const OutputImageRegionType outputRegion = this->GetOutput()->GetRequestedRegion();
+	
+	// Only the pixel values of the input and the mask may have changed since the last execution
+	if( this->m_IncrementalInput.IsNull() || this->GetMTime() > this->m_IncrementalMTime ||
+		( mask != 0 ) != this->m_IncrementalMask.IsNotNull() ||
+		outputRegion != this->m_IncrementalOutputRegion )
+	{
+		return false;
+	}
+	
+	// The derivatives of the cascade cannot be computed in a region only
+	if( this->m_ScaleSpaceCascade && !this->m_FusedScales )
+		return false;
+	
+	if( input->GetBufferedRegion() != this->m_IncrementalInput->GetBufferedRegion() ||
+		input->GetLargestPossibleRegion() != this->m_IncrementalInput->GetLargestPossibleRegion() ||
+		input->GetSpacing() != this->m_IncrementalInput->GetSpacing() ||
+		input->GetOrigin() != this->m_IncrementalInput->GetOrigin() )
+	{
+		itkDebugMacro(<<"The geometry of the input has changed. Computing everything");
+		return false;
+	}
+	
+	// The outputs must still hold the values of the last execution
+	if( this->GetNumberOfOutputs() != this->m_IncrementalBufferedRegions.size() )
+		return false;
+	
+	for( unsigned int i=0; i < this->GetNumberOfOutputs(); ++i )
+	{
+		const itk::ImageBase<ImageDimension> *output = 
+			dynamic_cast<const itk::ImageBase<ImageDimension> *>( this->itk::ProcessObject::GetOutput(i) );
+		
+		if( !output || output->GetBufferedRegion() != this->m_IncrementalBufferedRegions[i] )
+		{
+			itkDebugMacro(<<"Output " << i << " has been released. Computing everything");
+			return false;
+		}
+	}
+	
+	OutputImageRegionType maskRegion;
+	
+	if( mask )
+	{
+		maskRegion = this->m_MaskRuns->GetRegion();
+		
+		if( maskRegion != this->m_IncrementalMask->GetBufferedRegion() )
+			return false;
+	}
+	
+	// With a cropped input the scale filters depend on the bounding box of the mask, which for 
+	// the non-zero pixels of the input changes with the input 
+	if( this->m_CropToMaskBoundingBox && this->m_MaskRuns.IsNotNull() && 
+		this->m_MaskRuns->GetBoundingBox() != this->m_IncrementalMaskBoundingBox )
+	{
+		return false;
+	}
+	
+	// Changed pixels closer than the kernel radius share their box
+	const ScalePixelType maximumScale = this->GetMaximumScale();
+	const typename InputImageType::SpacingType spacing = input->GetSpacing();
+	typename OutputImageRegionType::SizeType radius;
+	
+	for( unsigned int i=0; i<ImageDimension; ++i )
+	{
+		radius[i] = static_cast<typename OutputImageRegionType::SizeValueType>
+			( ceil( this->m_KernelRadiusFactor * maximumScale / spacing[i] ) );
+	}
+	
+	RegionContainerType boxes;
+	
+	AddModifiedPixels( input, this->m_IncrementalInput.GetPointer(), input->GetBufferedRegion(), radius, boxes );
+	
+	if( mask )
+		AddModifiedPixels( mask, this->m_IncrementalMask.GetPointer(), maskRegion, radius, boxes );
+	
+	// Output pixels within the padding of a changed pixel are affected by it
+	regions.clear();
+	
+	for( unsigned int i=0; i < boxes.size(); ++i )
+	{
+		OutputImageRegionType region = this->GetPaddedInputRegion( boxes[i] );
+		
+		if( region.Crop( outputRegion ) )
+			regions.push_back( region );
+	}
+	
+	MergeOverlappingRegions( regions );
+	
+	itkDebugMacro(<<"Found " << boxes.size() << " boxes of modified pixels, " << regions.size() 
+		<< " regions to update");
 	
-	// Initialize the mask with ones
-	m_ZeroPixelsMaskImage->FillBuffer( itk::NumericTraits<typename MaskImageType::PixelType>::One );
+	return true;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::StoreIncrementalState( const MaskImageType *mask, bool copyImages )
+{
+	if( copyImages )
+	{
+		const InputImageType *input = this->GetInput();
+		this->m_IncrementalInput = CopyImageRegion( input, input->GetBufferedRegion() );
+		
+		if( mask )
+			this->m_IncrementalMask = CopyImageRegion( mask, this->m_MaskRuns->GetRegion() );
+		else
+			this->m_IncrementalMask = 0;
+	}
 	
-	typedef itk::ImageRegionConstIterator<InputImageType> 		ConstIteratorType;
-	typedef itk::ImageRegionIterator<MaskImageType> 					IteratorType;
+	if( this->m_MaskRuns.IsNotNull() )
+		this->m_IncrementalMaskBoundingBox = this->m_MaskRuns->GetBoundingBox();
 	
-	ConstIteratorType it( inputPtr, inputPtr->GetRequestedRegion() );
-	IteratorType out( this->m_ZeroPixelsMaskImage, inputPtr->GetRequestedRegion() );
+	this->m_IncrementalOutputRegion = this->GetOutput()->GetRequestedRegion();
+	this->m_IncrementalMTime = this->GetMTime();
 	
-	// If a pixel has zero value set it to zero in the mask too
-	for( it.GoToBegin(), out.GoToBegin(); !it.IsAtEnd(); ++it, ++out )
+	this->m_IncrementalBufferedRegions.clear();
+	
+	for( unsigned int i=0; i < this->GetNumberOfOutputs(); ++i )
 	{
-		if( !it.Get() )
-			out.Set( itk::NumericTraits<typename MaskImageType::PixelType>::Zero );
+		const itk::ImageBase<ImageDimension> *output = 
+			dynamic_cast<const itk::ImageBase<ImageDimension> *>( this->itk::ProcessObject::GetOutput(i) );
+		
+		this->m_IncrementalBufferedRegions.push_back( output ? output->GetBufferedRegion() : OutputImageRegionType() );
 	}
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+template <class TImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::AddModifiedPixels( const TImage *image, TImage *copy, const OutputImageRegionType & region,
+	const typename OutputImageRegionType::SizeType & radius, RegionContainerType & boxes )
+{
+	itk::ImageRegionConstIteratorWithIndex<TImage> it( image, region );
+	itk::ImageRegionIterator<TImage> cit( copy, region );
+	
+	// Box extended by the last changed pixel, which usually contains the next one too
+	unsigned int last = 0;
 	
-	this->SetMaskImage( m_ZeroPixelsMaskImage );
+	for( it.GoToBegin(), cit.GoToBegin(); !it.IsAtEnd(); ++it, ++cit )
+	{
+		if( it.Get() == cit.Get() )
+			continue;
+		
+		cit.Set( it.Get() );
+		
+		const typename OutputImageRegionType::IndexType & index = it.GetIndex();
+		
+		bool found = false;
+		
+		for( unsigned int k=0; k < boxes.size() && !found; ++k )
+		{
+			const unsigned int b = ( last + k ) % boxes.size();
+			
+			OutputImageRegionType neighbourhood = boxes[b];
+			neighbourhood.PadByRadius( radius );
+			
+			if( !neighbourhood.IsInside( index ) )
+				continue;
+			
+			// Extend the box to the pixel
+			typename OutputImageRegionType::IndexType boxIndex = boxes[b].GetIndex();
+			typename OutputImageRegionType::SizeType boxSize = boxes[b].GetSize();
+			
+			for( unsigned int i=0; i<ImageDimension; ++i )
+			{
+				const long upper = vnl_math_max( static_cast<long>( boxIndex[i] + boxSize[i] ) - 1, 
+					static_cast<long>( index[i] ) );
+				
+				boxIndex[i] = vnl_math_min( boxIndex[i], index[i] );
+				boxSize[i] = upper - boxIndex[i] + 1;
+			}
+			
+			boxes[b].SetIndex( boxIndex );
+			boxes[b].SetSize( boxSize );
+			
+			last = b;
+			found = true;
+		}
+		
+		if( !found )
+		{
+			typename OutputImageRegionType::SizeType unitSize;
+			unitSize.Fill( 1 );
+			
+			boxes.push_back( OutputImageRegionType( index, unitSize ) );
+			last = boxes.size() - 1;
+		}
+	}
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::MergeOverlappingRegions( RegionContainerType & regions )
+{
+	bool merged = true;
 	
+	while( merged )
+	{
+		merged = false;
+		
+		for( unsigned int a=0; a < regions.size() && !merged; ++a )
+		{
+			for( unsigned int b=a+1; b < regions.size() && !merged; ++b )
+			{
+				OutputImageRegionType intersection = regions[a];
+				
+				if( !intersection.Crop( regions[b] ) )
+					continue;
+				
+				// Replace both regions by their bounding box
+				typename OutputImageRegionType::IndexType index;
+				typename OutputImageRegionType::SizeType size;
+				
+				for( unsigned int i=0; i<ImageDimension; ++i )
+				{
+					const long upper = vnl_math_max( 
+						static_cast<long>( regions[a].GetIndex(i) + regions[a].GetSize(i) ),
+						static_cast<long>( regions[b].GetIndex(i) + regions[b].GetSize(i) ) );
+					
+					index[i] = vnl_math_min( regions[a].GetIndex(i), regions[b].GetIndex(i) );
+					size[i] = upper - index[i];
+				}
+				
+				regions[a].SetIndex( index );
+				regions[a].SetSize( size );
+				regions.erase( regions.begin() + b );
+				
+				merged = true;
+			}
+		}
+	}
 }
 
 
@@ -406,31 +1234,345 @@ MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 {
   itkDebugMacro(<<"Updating scale filters at scale" << currentScale);
 
+	// The requested region of the scale filters could have been reduced in a previous fused execution
+	OutputImageRegionType region = this->m_ScaleFiltersInput->GetLargestPossibleRegion();
+	
+	// With a mask only the region needed for its bounding box is computed. Values are the same 
+	// since recursive gaussian filters request the whole extent along the filtered direction
+	if( this->m_MaskRuns.IsNotNull() )
+	{
+		OutputImageRegionType maskRegion = this->GetScaleFiltersRegion( currentScale, this->m_CurrentOutputRegion );
+		
+		if( maskRegion.Crop( region ) )
+			region = maskRegion;
+	}
+	
+	this->UpdateScaleFiltersAtScaleInRegion( currentScale, region );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::UpdateScaleFiltersAtScaleInRegion( const ScalePixelType currentScale, 
+	const OutputImageRegionType& region )
+{
+  itkDebugMacro(<<"Updating scale filters at scale " << currentScale << " in region " << region);
+  
+  // Recursive gaussian filters always request the whole extent along the direction being filtered, 
+  // so values computed in a region are the same as those obtained for the whole image
+
   if( this->m_GradientMagnitudeGaussian.IsNotNull() )
   {
   	this->m_GradientMagnitudeGaussian->SetSigma( currentScale );
+  	this->m_GradientMagnitudeGaussian->GetOutput()->SetRequestedRegion( region );
   	this->m_GradientMagnitudeGaussian->Update();
   }
   	
   if( this->m_GradientGaussian.IsNotNull() )
   {
   	this->m_GradientGaussian->SetSigma( currentScale );
+  	this->m_GradientGaussian->GetOutput()->SetRequestedRegion( region );
   	this->m_GradientGaussian->Update();
   }
 	
 	if( this->m_HessianGaussian.IsNotNull() )
 	{
   	this->m_HessianGaussian->SetSigma( currentScale );
+  	this->m_HessianGaussian->GetOutput()->SetRequestedRegion( region );
   	this->m_HessianGaussian->Update();
   }
   
   if( this->m_LaplacianGaussian.IsNotNull() )
   {
   	this->m_LaplacianGaussian->SetSigma( currentScale );
+  	this->m_LaplacianGaussian->GetOutput()->SetRequestedRegion( region );
   	this->m_LaplacianGaussian->Update();
   }  
 }
 
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::UpdateScaleFiltersAtScaleInSlab( const ScalePixelType currentScale, 
+	const OutputImageRegionType& region )
+{
+	// Only the crop of the input within the kernel support of this scale is filtered
+	const typename InputImageType::SpacingType spacing = this->m_ScaleFiltersInput->GetSpacing();
+	typename InputImageRegionType::SizeType padding;
+	
+	for( unsigned int i=0; i<ImageDimension; ++i )
+	{
+		padding[i] = static_cast<typename InputImageRegionType::SizeValueType>
+			( ceil( this->m_KernelRadiusFactor * currentScale / spacing[i] ) );
+	}
+	
+	InputImageRegionType cropRegion = region;
+	cropRegion.PadByRadius( padding );
+	cropRegion.Crop( this->m_ScaleFiltersInput->GetLargestPossibleRegion() );
+	
+	// The crop is kept while it does not change, for example when it covers the whole input
+	if( this->m_SlabScaleFiltersInput.IsNull() || 
+		this->m_SlabScaleFiltersInput->GetLargestPossibleRegion() != cropRegion )
+	{
+		if( cropRegion == this->m_ScaleFiltersInput->GetLargestPossibleRegion() )
+			this->m_SlabScaleFiltersInput = this->m_ScaleFiltersInput;
+		else
+			this->m_SlabScaleFiltersInput = CropImage( this->m_ScaleFiltersInput, cropRegion );
+		
+		this->SetScaleFiltersInput( this->m_SlabScaleFiltersInput );
+	}
+	
+	this->UpdateScaleFiltersAtScaleInRegion( currentScale, cropRegion );
+}
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::UpdateScaleSpaceCascadeAtScale( const ScalePixelType currentScale )
+{
+  itkDebugMacro(<<"Updating scale-space cascade at scale " << currentScale);
+  
+  // Smooth the image of the previous scale with the incremental sigma, or the input at the first scale
+  if( this->m_CascadeSmoothedImage.IsNull() || currentScale <= this->m_CascadeScale )
+  {
+    if( this->m_CascadeInputSmoothingFilter.IsNull() )
+      this->m_CascadeInputSmoothingFilter = CascadeInputSmoothingFilterType::New();
+    
+    this->m_CascadeInputSmoothingFilter->SetInput( this->m_ScaleFiltersInput );
+    this->m_CascadeInputSmoothingFilter->SetSigma( currentScale );
+    this->m_CascadeInputSmoothingFilter->Update();
+    
+    this->m_CascadeSmoothedImage = this->m_CascadeInputSmoothingFilter->GetOutput();
+    this->m_CascadeSmoothedImage->DisconnectPipeline();
+  }
+  else if( currentScale > this->m_CascadeScale )
+  {
+    if( this->m_CascadeSmoothingFilter.IsNull() )
+      this->m_CascadeSmoothingFilter = CascadeSmoothingFilterType::New();
+      
+    this->m_CascadeSmoothingFilter->SetInput( this->m_CascadeSmoothedImage );
+    this->m_CascadeSmoothingFilter->SetSigma( 
+      vcl_sqrt( currentScale * currentScale - this->m_CascadeScale * this->m_CascadeScale ) );
+    this->m_CascadeSmoothingFilter->Update();
+    
+    this->m_CascadeSmoothedImage = this->m_CascadeSmoothingFilter->GetOutput();
+    this->m_CascadeSmoothedImage->DisconnectPipeline();
+  }
+  
+  this->m_CascadeScale = currentScale;
+  
+  // Allocate the derivative images for the scale filters in use
+  typename ScaleImageType::ConstPointer smoothedImage = this->m_CascadeSmoothedImage.GetPointer();
+  const typename ScaleImageType::RegionType region = smoothedImage->GetBufferedRegion();
+  
+  if( this->m_GradientMagnitudeGaussian.IsNotNull() && this->m_CascadeGradientMagnitudeImage.IsNull() )
+  {
+    this->m_CascadeGradientMagnitudeImage = ScaleImageType::New();
+    this->m_CascadeGradientMagnitudeImage->CopyInformation( smoothedImage );
+    this->m_CascadeGradientMagnitudeImage->SetRegions( region );
+    this->m_CascadeGradientMagnitudeImage->Allocate();
+  }
+  
+  if( this->m_GradientGaussian.IsNotNull() && this->m_CascadeGradientImage.IsNull() )
+  {
+    this->m_CascadeGradientImage = VectorScaleImageType::New();
+    this->m_CascadeGradientImage->CopyInformation( smoothedImage );
+    this->m_CascadeGradientImage->SetRegions( region );
+    this->m_CascadeGradientImage->Allocate();
+  }
+  
+  if( this->m_HessianGaussian.IsNotNull() && this->m_CascadeHessianImage.IsNull() )
+  {
+    this->m_CascadeHessianImage = TensorScaleImageType::New();
+    this->m_CascadeHessianImage->CopyInformation( smoothedImage );
+    this->m_CascadeHessianImage->SetRegions( region );
+    this->m_CascadeHessianImage->Allocate();
+  }
+  
+  if( this->m_LaplacianGaussian.IsNotNull() && this->m_CascadeLaplacianImage.IsNull() )
+  {
+    this->m_CascadeLaplacianImage = ScaleImageType::New();
+    this->m_CascadeLaplacianImage->CopyInformation( smoothedImage );
+    this->m_CascadeLaplacianImage->SetRegions( region );
+    this->m_CascadeLaplacianImage->Allocate();
+  }
+  
+  // Same normalization factors as the ones applied by the recursive gaussian filters
+  const double firstOrderFactor = static_cast<double>( currentScale );
+  const double secondOrderFactor = static_cast<double>( currentScale * currentScale );
+  
+  const double gradientMagnitudeNormalization = ( this->m_GradientMagnitudeGaussian.IsNotNull() && 
+    this->m_GradientMagnitudeGaussian->GetNormalizeAcrossScale() )? firstOrderFactor : 1.0;
+  const double gradientNormalization = ( this->m_GradientGaussian.IsNotNull() && 
+    this->m_GradientGaussian->GetNormalizeAcrossScale() )? firstOrderFactor : 1.0;
+  const double hessianNormalization = ( this->m_HessianGaussian.IsNotNull() && 
+    this->m_HessianGaussian->GetNormalizeAcrossScale() )? secondOrderFactor : 1.0;
+  const double laplacianNormalization = ( this->m_LaplacianGaussian.IsNotNull() && 
+    this->m_LaplacianGaussian->GetNormalizeAcrossScale() )? secondOrderFactor : 1.0;
+  
+  // Compute derivatives with central differences, a chunk of lines per thread
+  CascadeDerivativesFunction function;
+  function.SmoothedImage = smoothedImage;
+  function.GradientMagnitudeImage = this->m_CascadeGradientMagnitudeImage;
+  function.GradientImage = this->m_CascadeGradientImage;
+  function.HessianImage = this->m_CascadeHessianImage;
+  function.LaplacianImage = this->m_CascadeLaplacianImage;
+  function.GradientMagnitudeNormalization = gradientMagnitudeNormalization;
+  function.GradientNormalization = gradientNormalization;
+  function.HessianNormalization = hessianNormalization;
+  function.LaplacianNormalization = laplacianNormalization;
+  
+  const unsigned long numberOfLines = ( region.GetSize()[0] > 0 )? 
+    region.GetNumberOfPixels() / region.GetSize()[0] : 0;
+  
+  TaskPool::GetInstance()->ParallelFor( 0, numberOfLines, &function, 0, this->GetNumberOfThreads() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::CascadeDerivativesFunction
+::Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int )
+{
+  typedef typename ScaleImageType::OffsetValueType   OffsetValueType;
+  
+  const typename ScaleImageType::RegionType region = this->SmoothedImage->GetBufferedRegion();
+  const typename ScaleImageType::IndexType start = region.GetIndex();
+  const typename ScaleImageType::SizeType size = region.GetSize();
+  const typename ScaleImageType::SpacingType spacing = this->SmoothedImage->GetSpacing();
+  const OffsetValueType *offsetTable = this->SmoothedImage->GetOffsetTable();
+  
+  // Offsets to the previous and next pixels along each dimension. At the boundary they are zero, 
+  // which replicates the boundary pixel as the zero-flux Neumann condition of the neighborhood 
+  // iterators
+  OffsetValueType previous[ImageDimension];
+  OffsetValueType next[ImageDimension];
+  
+  double firstDerivatives[ImageDimension];
+  TensorScalePixelType hessian;
+  VectorScalePixelType gradient;
+  
+  for( TaskPool::IndexValueType line = begin; line < end; ++line )
+  {
+    typename ScaleImageType::IndexType index = start;
+    TaskPool::IndexValueType remainder = line;
+    
+    for( unsigned int i=1; i<ImageDimension; ++i )
+    {
+      index[i] += static_cast<typename ScaleImageType::IndexValueType>( remainder % size[i] );
+      remainder /= size[i];
+      
+      previous[i] = ( index[i] > start[i] )? offsetTable[i] : 0;
+      next[i] = ( index[i] + 1 < start[i] + static_cast<OffsetValueType>( size[i] ) )? offsetTable[i] : 0;
+    }
+    
+    // All the images have the region of the smoothed image, so the lines are at the same offset
+    const OffsetValueType lineOffset = this->SmoothedImage->ComputeOffset( index );
+    const ScalePixelType *pixels = this->SmoothedImage->GetBufferPointer() + lineOffset;
+    
+    for( unsigned long x = 0; x < size[0]; ++x )
+    {
+      const ScalePixelType *pixel = pixels + x;
+      
+      previous[0] = ( x > 0 )? 1 : 0;
+      next[0] = ( x + 1 < size[0] )? 1 : 0;
+      
+      const double centralValue = *pixel;
+      double laplacian = 0.0;
+      double gradientMagnitude = 0.0;
+      
+      for( unsigned int i=0; i<ImageDimension; ++i )
+      {
+        firstDerivatives[i] = 0.5 * ( pixel[next[i]] - pixel[-previous[i]] ) / spacing[i];
+        gradientMagnitude += firstDerivatives[i] * firstDerivatives[i];
+        
+        const double secondDerivative = ( pixel[next[i]] - 2.0 * centralValue + pixel[-previous[i]] ) / 
+          ( spacing[i] * spacing[i] );
+        hessian( i, i ) = this->HessianNormalization * secondDerivative;
+        laplacian += secondDerivative;
+        
+        for( unsigned int j=i+1; j<ImageDimension; ++j )
+        {
+          hessian( i, j ) = this->HessianNormalization * 0.25 * 
+            ( pixel[next[i] + next[j]] - pixel[next[i] - previous[j]] -
+              pixel[next[j] - previous[i]] + pixel[-previous[i] - previous[j]] ) / 
+            ( spacing[i] * spacing[j] );
+        }
+      }
+      
+      if( this->GradientMagnitudeImage )
+      {
+        this->GradientMagnitudeImage->GetBufferPointer()[lineOffset + x] = 
+          this->GradientMagnitudeNormalization * vcl_sqrt( gradientMagnitude );
+      }
+      
+      if( this->GradientImage )
+      {
+        for( unsigned int i=0; i<ImageDimension; ++i )
+          gradient[i] = this->GradientNormalization * firstDerivatives[i];
+        
+        this->GradientImage->GetBufferPointer()[lineOffset + x] = gradient;
+      }
+      
+      if( this->HessianImage )
+        this->HessianImage->GetBufferPointer()[lineOffset + x] = hessian;
+      
+      if( this->LaplacianImage )
+        this->LaplacianImage->GetBufferPointer()[lineOffset + x] = this->LaplacianNormalization * laplacian;
+    }
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+const typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::ScaleImageType *
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetGradientMagnitudeImage() const
+{
+  if( this->m_CascadeGradientMagnitudeImage.IsNotNull() )
+    return this->m_CascadeGradientMagnitudeImage;
+  
+  return ( this->m_GradientMagnitudeGaussian.IsNotNull() )? this->m_GradientMagnitudeGaussian->GetOutput() : 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+const typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::VectorScaleImageType *
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetGradientImage() const
+{
+  if( this->m_CascadeGradientImage.IsNotNull() )
+    return this->m_CascadeGradientImage;
+  
+  return ( this->m_GradientGaussian.IsNotNull() )? this->m_GradientGaussian->GetOutput() : 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+const typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::TensorScaleImageType *
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetHessianImage() const
+{
+  if( this->m_CascadeHessianImage.IsNotNull() )
+    return this->m_CascadeHessianImage;
+  
+  return ( this->m_HessianGaussian.IsNotNull() )? this->m_HessianGaussian->GetOutput() : 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+const typename MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::ScaleImageType *
+MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetLaplacianImage() const
+{
+  if( this->m_CascadeLaplacianImage.IsNotNull() )
+    return this->m_CascadeLaplacianImage;
+  
+  return ( this->m_LaplacianGaussian.IsNotNull() )? this->m_LaplacianGaussian->GetOutput() : 0;
+}
+
 } // end namespace ivan
 
 #endif
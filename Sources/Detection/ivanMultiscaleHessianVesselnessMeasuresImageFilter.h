@@ -0,0 +1,228 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleHessianVesselnessMeasuresImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: maximum over scales of several Hessian-based vesselness measures
+// Date: 2012/11/05
+
+#ifndef __ivanMultiscaleHessianVesselnessMeasuresImageFilter_h
+#define __ivanMultiscaleHessianVesselnessMeasuresImageFilter_h
+
+#include "ivanMultiscaleAnalysisImageFilter.h"
+#include "ivanHessianOnlyBasedVesselnessImageFunction.h"
+#include "ivanHessianVesselnessMeasuresBackend.h"
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class MultiscaleHessianVesselnessMeasuresImageFilter
+ *  \brief Computes the maximum over scales of several Hessian-based vesselness measures at once.
+ *
+ * Multiscale counterpart of HessianToVesselnessMeasuresImageFilter. At each scale the Hessian 
+ * is computed once for the whole image by MultiscaleAnalysisImageFilter, and the eigen-analysis
+ * is done once per pixel and shared by all the measures added with AddMeasure(). Each measure 
+ * keeps its own maximum over scales, so computing Frangi, Sato and eigenvalue filtering on the 
+ * same image costs a single Hessian and eigen-analysis per scale.
+ *
+ * The first measure is written to the first output, and the scale at which it was maximum to
+ * GetOutputScales() (second output), as in the rest of multiscale filters. The rest of measures 
+ * are written to the outputs that follow, use GetMeasureOutput() to get the output of a measure.
+ *
+ * The measures are evaluated with EvaluateVesselnessFromEigenValueComponents() over each run of 
+ * pixels, so the parameters of each measure are those set on the corresponding image function. The Hessian is normalized across 
+ * scales since the maximum response is searched for.
+ *
+ * The eigen-analysis and the measures of each run are done by a HessianVesselnessMeasuresBackend,
+ * which runs on the CPU by default. Use SetBackend() to run them on another device.
+ * 
+ * \sa HessianToVesselnessMeasuresImageFilter
+ * \ingroup IntensityImageFilters
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel = double, class TMaskImage = TInputImage,
+  class TMeasureFunction = HessianOnlyBasedVesselnessImageFunction<itk::Image<float,TInputImage::ImageDimension>, 
+    typename TOutputImage::PixelType> >
+class ITK_EXPORT MultiscaleHessianVesselnessMeasuresImageFilter : 
+  public MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MultiscaleHessianVesselnessMeasuresImageFilter   Self;
+  typedef MultiscaleAnalysisImageFilter<TInputImage,
+    TOutputImage,TScalePixel,TMaskImage>                   Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  /** Typedefs for image types. */
+  typedef TInputImage                                   InputImageType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef TMaskImage                                    MaskImageType;
+ 
+  typedef TScalePixel                                   ScalePixelType;
+  typedef typename OutputImageType::PixelType           OutputImagePixelType;
+  typedef typename OutputImageType::RegionType          OutputImageRegionType;
+
+  /** Scale image types. */
+  typedef typename Superclass::ScaleImageType           ScaleImageType;
+  typedef typename Superclass::TensorScalePixelType     TensorScalePixelType;
+  typedef typename Superclass::TensorScaleImageType     TensorScaleImageType;
+  
+  /** Image dimension = 3. */
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension);
+  
+  /** Type of the measures. */
+  typedef TMeasureFunction                              MeasureFunctionType;
+  typedef typename MeasureFunctionType::Pointer         MeasureFunctionPointer;
+  typedef typename MeasureFunctionType::EigenValuesArrayType  
+                                                        MeasureEigenValuesArrayType;
+  typedef typename MeasureFunctionType::EigenValueType  MeasureEigenValueType;
+typedef typename MeasureFunctionType::OutputType     MeasureOutputType;
+  typedef std::vector<MeasureFunctionPointer>           MeasureFunctionContainerType;
+  
+  /** Types for eigenanalysis. */
+  typedef SymmetricEigenSolver<TensorScalePixelType>    EigenAnalysisType;
+  typedef typename EigenAnalysisType::EigenValuesArrayType  
+                                                        EigenValuesArrayType;
+  
+  /** Type of the backend of the eigen-analysis and the measures. */
+  typedef HessianVesselnessMeasuresBackend<TensorScalePixelType,
+    MeasureFunctionType>                                BackendType;
+  
+  typedef typename Superclass::HessianFilterType        HessianFilterType;
+  
+  typedef typename Superclass::MaskRunLengthEncodingType  MaskRunLengthEncodingType;
+  typedef typename Superclass::MaskRunType              MaskRunType;
+  typedef typename Superclass::MaskRunContainerType     MaskRunContainerType;
+      
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiscaleHessianVesselnessMeasuresImageFilter, MultiscaleAnalysisImageFilter );
+  
+  /** Add a measure to compute. Its maximum over scales will be in GetMeasureOutput() with
+    * the same index as the measure, in the order measures were added. */
+  void AddMeasure( MeasureFunctionType *measure );
+  
+  /** Get the number of measures. */
+  unsigned int GetNumberOfMeasures() const
+    { return static_cast<unsigned int>( this->m_Measures.size() ); }
+  
+  /** Get the given measure. */
+  MeasureFunctionType * GetMeasure( unsigned int i )
+    { return this->m_Measures[i].GetPointer(); }
+  
+  /** Get the output of the given measure. This is the first output for the first measure and 
+    * the output with index i+1 for the rest, since the second output is the scales image. */
+  OutputImageType * GetMeasureOutput( unsigned int i )
+    { 
+      return dynamic_cast< OutputImageType * >
+        ( this->itk::ProcessObject::GetOutput( this->GetMeasureOutputIndex( i ) ) );
+    }
+  
+  /** Set/Get the backend that computes the eigenvalues and the measures of each run of pixels. 
+    * By default the CPU one. */
+  itkSetObjectMacro( Backend, BackendType );
+  itkGetObjectMacro( Backend, BackendType );
+  
+protected:
+
+  MultiscaleHessianVesselnessMeasuresImageFilter();
+  ~MultiscaleHessianVesselnessMeasuresImageFilter() {};
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Override since the outputs of the measures must be produced in the same region as the 
+    * main output. */
+  virtual void EnlargeOutputRequestedRegion( itk::DataObject *output );
+
+  /** Prepare output images. Also checks that there is at least one measure and a backend. */
+  virtual void PrepareData();
+  
+  /** Reset also the outputs of the measures. */
+  virtual void ResetOutputsInRegion( const OutputImageRegionType & region );
+
+  /** Called by GenerateData to generate data for the current scale. */
+  virtual void GenerateDataAtScale( const ScalePixelType currentScale );
+  
+  /** Called by GenerateData to generate data for the current scale using the provided mask. */
+  virtual void GenerateDataUsingMaskAtScale( const ScalePixelType currentScale );
+  
+  /** Computes all the measures at the current scale for the given piece of the current output 
+    * region, and updates their maximum over scales. With a mask, only the runs of mask pixels 
+    * are visited. Each run is processed in data-parallel stages: the eigenvalues of the whole 
+    * run, then each measure in batch, then the max-over-scales update. */
+  virtual void ThreadedGenerateDataAtScale( const OutputImageRegionType& outputRegionForThread, 
+    int threadId );
+  
+  /** Splits the current output region and calls ThreadedGenerateDataAtScale() with each piece. */
+  void MultiThreadedGenerateDataAtScale( const ScalePixelType currentScale, bool useMask );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ScaleThreaderCallback( void *arg );
+
+  /** Internal structure used for passing the filter to the threader callback. */
+  struct ScaleThreadStruct
+  {
+    Pointer Filter;
+  };
+  
+  /** Index of the output of the given measure. */
+  static unsigned int GetMeasureOutputIndex( unsigned int i )
+    { return ( i == 0 ) ? 0 : i + 1; }
+  
+private:
+
+  MultiscaleHessianVesselnessMeasuresImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+protected:
+
+  /** Measures to compute, one per output. */
+  MeasureFunctionContainerType    m_Measures;
+  
+  /** Backend of the per-pixel stages. */
+  typename BackendType::Pointer   m_Backend;
+  
+  /** State of the scale being currently processed, shared (read-only) by all threads. */
+  ScalePixelType        m_CurrentScale;
+  bool                  m_UseMaskAtCurrentScale;
+};
+  
+} // end namespace ivan
+  
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.hxx"
+#endif
+  
+#endif
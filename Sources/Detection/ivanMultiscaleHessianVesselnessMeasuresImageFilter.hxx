@@ -0,0 +1,347 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleHessianVesselnessMeasuresImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: maximum over scales of several Hessian-based vesselness measures
+// Date: 2012/11/05
+
+#ifndef __ivanMultiscaleHessianVesselnessMeasuresImageFilter_hxx
+#define __ivanMultiscaleHessianVesselnessMeasuresImageFilter_hxx
+
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::MultiscaleHessianVesselnessMeasuresImageFilter()
+{
+  // The only scale filter we need
+  this->m_HessianGaussian = HessianFilterType::New();
+  this->m_HessianGaussian->SetNormalizeAcrossScale( true );
+  
+  this->m_CurrentScale = itk::NumericTraits<ScalePixelType>::Zero;
+  this->m_UseMaskAtCurrentScale = false;
+  
+  this->m_Backend = BackendType::New();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::AddMeasure( MeasureFunctionType *measure )
+{
+  if( !measure )
+  {
+    itkExceptionMacro( "Measure is NULL." );
+  }
+  
+  this->m_Measures.push_back( measure );
+  
+  // The outputs of the first measure and the scales already exist
+  const unsigned int numberOfMeasures = this->GetNumberOfMeasures();
+  
+  if( numberOfMeasures > 1 )
+  {
+    const unsigned int outputIndex = this->GetMeasureOutputIndex( numberOfMeasures-1 );
+    
+    this->itk::ProcessObject::SetNumberOfRequiredOutputs( outputIndex+1 );
+    
+    typename OutputImageType::Pointer output = OutputImageType::New();
+    this->itk::ProcessObject::SetNthOutput( outputIndex, output.GetPointer() );
+  }
+  
+  this->Modified();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::EnlargeOutputRequestedRegion( itk::DataObject *output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  
+  TOutputImage *out = this->GetOutput();
+  
+  if( !out )
+    return;
+  
+  for( unsigned int m=1; m<this->GetNumberOfMeasures(); ++m )
+  {
+    OutputImageType *measureOutput = this->GetMeasureOutput( m );
+    
+    if( measureOutput )
+      measureOutput->SetRequestedRegion( out->GetRequestedRegion() );
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::PrepareData()
+{
+  if( this->m_Measures.empty() )
+  {
+    itkExceptionMacro( "No measures were added." );
+  }
+  
+  if( this->m_Backend.IsNull() )
+  {
+    itkExceptionMacro( "Backend is NULL." );
+  }
+  
+  Superclass::PrepareData();
+  
+  for( unsigned int m=1; m<this->GetNumberOfMeasures(); ++m )
+  {
+    typename OutputImageType::Pointer measureOutput = this->GetMeasureOutput( m );
+    measureOutput->SetBufferedRegion( measureOutput->GetRequestedRegion() );
+    measureOutput->Allocate();
+    this->FillBuffer( measureOutput.GetPointer(), itk::NumericTraits<OutputImagePixelType>::Zero );
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::ResetOutputsInRegion( const OutputImageRegionType & region )
+{
+  Superclass::ResetOutputsInRegion( region );
+  
+  for( unsigned int m=1; m<this->GetNumberOfMeasures(); ++m )
+    this->FillRegion( this->GetMeasureOutput( m ), region, itk::NumericTraits<OutputImagePixelType>::Zero );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::GenerateDataAtScale( const ScalePixelType currentScale )
+{
+  itkDebugMacro(<< "MultiscaleHessianVesselnessMeasuresImageFilter generating data at scale " << currentScale);
+  
+  this->MultiThreadedGenerateDataAtScale( currentScale, false );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::GenerateDataUsingMaskAtScale( const ScalePixelType currentScale )
+{
+  itkDebugMacro(<< "MultiscaleHessianVesselnessMeasuresImageFilter generating data using mask at scale " 
+    << currentScale);
+  
+  this->MultiThreadedGenerateDataAtScale( currentScale, true );
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::MultiThreadedGenerateDataAtScale( const ScalePixelType currentScale, bool useMask )
+{
+  this->m_CurrentScale = currentScale;
+  this->m_UseMaskAtCurrentScale = useMask;
+  
+  ScaleThreadStruct str;
+  str.Filter = this;
+  
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->ScaleThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+ITK_THREAD_RETURN_TYPE
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::ScaleThreaderCallback( void *arg )
+{
+  ScaleThreadStruct *str;
+  int total, threadId, threadCount;
+
+  threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  threadCount = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  str = (ScaleThreadStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  ScopedThreadAffinity affinity( threadId, str->Filter->GetThreadAffinity() );
+
+  // Split the current output region
+  OutputImageRegionType splitRegion;
+  total = str->Filter->SplitRequestedRegion( threadId, threadCount, splitRegion );
+
+  if( threadId < total )
+    str->Filter->ThreadedGenerateDataAtScale( splitRegion, threadId );
+  
+  // else don't use this thread. Threads were not split conveniently.
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::ThreadedGenerateDataAtScale( const OutputImageRegionType& outputRegionForThread, int itkNotUsed( threadId ) )
+{
+  const ScalePixelType currentScale = this->m_CurrentScale;
+  const unsigned int numberOfMeasures = this->GetNumberOfMeasures();
+  
+  // Pixels are visited in runs along the first dimension, which are contiguous in memory
+  MaskRunContainerType runs;
+  
+  const MaskRunLengthEncodingType *maskRuns = this->GetMaskRuns();
+  
+  if( this->m_UseMaskAtCurrentScale && maskRuns )
+  {
+    // Only the runs of mask pixels, so no pixel has to be tested
+    maskRuns->GetRunsInRegion( outputRegionForThread, runs );
+  }
+  else
+  {
+    // One run per line of the region
+    typedef itk::ImageLinearConstIteratorWithIndex<ScaleImageType>  LineIteratorType;
+    
+    LineIteratorType lineIt( this->GetOutputScales(), outputRegionForThread );
+    lineIt.SetDirection( 0 );
+    
+    MaskRunType run;
+    run.Length = outputRegionForThread.GetSize()[0];
+    
+    for( lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine() )
+    {
+      run.Index = lineIt.GetIndex();
+      runs.push_back( run );
+    }
+  }
+  
+  const TensorScaleImageType *hessianImage = this->GetHessianImage();
+  ScaleImageType *scalesImage = this->GetOutputScales();
+  
+  // Raw pointers to avoid smart pointer overhead in the inner loop
+  std::vector<const MeasureFunctionType *> measures( numberOfMeasures );
+  std::vector<OutputImageType *> outputImages( numberOfMeasures );
+  
+  for( unsigned int m=0; m<numberOfMeasures; ++m )
+  {
+    measures[m] = this->m_Measures[m].GetPointer();
+    outputImages[m] = this->GetMeasureOutput( m );
+  }
+  
+  // Each run is processed in stages: all the eigenvalues first, then each measure for the
+  // whole run. Buffers are sized for the longest run in the region of this thread
+  const unsigned long maximumRunLength = outputRegionForThread.GetSize()[0];
+  
+  if( runs.empty() || maximumRunLength == 0 )
+    return;
+  
+  const BackendType *backend = this->m_Backend.GetPointer();
+  
+  std::vector<EigenValuesArrayType>         eigenValues( maximumRunLength );
+  std::vector<MeasureEigenValueType>        measureEigenValues( ImageDimension * maximumRunLength );
+  std::vector<MeasureOutputType>            values( maximumRunLength );
+  
+  // The measures take the eigenvalues by component, one contiguous array each
+  const MeasureEigenValueType *measureEigenValueComponents[ImageDimension];
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    measureEigenValueComponents[i] = &measureEigenValues[ i * maximumRunLength ];
+
+  for( typename MaskRunContainerType::const_iterator rit = runs.begin(); rit != runs.end(); ++rit )
+  {
+    const unsigned long runLength = rit->Length;
+    
+    if( runLength == 0 )
+      continue;
+    
+    const TensorScalePixelType *hessianPixel = 
+      hessianImage->GetBufferPointer() + hessianImage->ComputeOffset( rit->Index );
+    ScalePixelType *scalesPixel = scalesImage->GetBufferPointer() + scalesImage->ComputeOffset( rit->Index );
+    
+    // One eigen-analysis for all the measures
+    backend->ComputeEigenValues( hessianPixel, runLength, &eigenValues[0] );
+    
+    for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+      MeasureEigenValueType *component = &measureEigenValues[ i * maximumRunLength ];
+      
+      for( unsigned long k=0; k<runLength; ++k )
+        component[k] = eigenValues[k][i];
+    }
+    
+    for( unsigned int m=0; m<numberOfMeasures; ++m )
+    {
+      backend->EvaluateMeasure( measures[m], measureEigenValueComponents, runLength, &values[0] );
+      
+      OutputImagePixelType *outputPixel = 
+        outputImages[m]->GetBufferPointer() + outputImages[m]->ComputeOffset( rit->Index );
+      
+      for( unsigned long k=0; k<runLength; ++k )
+      {
+        const OutputImagePixelType value = static_cast<OutputImagePixelType>( values[k] );
+        
+        if( value > outputPixel[k] )
+        {
+          outputPixel[k] = value;
+          
+          // The scales image belongs to the first measure
+          if( m == 0 )
+            scalesPixel[k] = currentScale;
+        }
+      }
+    }
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage, class TMeasureFunction>
+void 
+MultiscaleHessianVesselnessMeasuresImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage,TMeasureFunction>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfMeasures: " << this->m_Measures.size() << std::endl;
+  
+  for( unsigned int m=0; m<this->m_Measures.size(); ++m )
+    os << indent << "Measure " << m << ": " << this->m_Measures[m]->GetNameOfClass() << std::endl;
+  
+  os << indent << "Backend: " << this->m_Backend.GetPointer() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -33,6 +33,15 @@ SUCH DAMAGE.
 #include "itkImageFunction.h"
 
 #include "ivanImageFunctionInitializerBase.h"
+#include "ivanScaledImageFunctionCache.h"
+#include "ivanTaskPool.h"
+#include "ivanScaleInterpolation.h"
+
+#include "itkSimpleFastMutexLock.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+#include <string>
 
 
 namespace ivan
@@ -50,7 +59,22 @@ namespace ivan
  * evaluating the function.
  *
  * The class uses an ImageFunctionInitializerBase (or subclass) for the user to provide a means of 
- * initializing each scaled image function. This is called in Initialize().
+ * initializing each scaled image function. This is called in Initialize(), or the first time
+ * the function of each scale is used if LazyInitialization is on. Several multiscale objects
+ * may share their initialized scaled functions through a ScaledImageFunctionCache.
+ *
+ * EvaluateBatch() evaluates the function at a set of points, such as the samples of a circle or
+ * a sphere, calling the EvaluateBatch() method of each scaled function once for all the points.
+ * The scaled image function type must provide this method, as HessianBasedVesselnessImageFunction
+ * and SphereGridBasedImageFunction do.
+ *
+ * By default, all the scales are evaluated and the maximum response is returned. For responses 
+ * that are unimodal across scale, such as normalized Hessian-based vesselness, the ScaleSearchMethod
+ * can be set to GoldenSectionScaleSearch or CoarseToFineScaleSearch, which evaluate only some of 
+ * the scales. The Evaluate*AndSelectScale() methods also return the scale of the selected response.
+ * If InterpolateSelectedScale is on, this scale is refined between the discrete scales with the
+ * parabola through the responses at the selected scale and its neighbours (see ScaleInterpolation),
+ * so that fewer scales give the same accuracy of the scale. The response is not interpolated.
  *
  * \sa ImageFunction
  */
@@ -79,6 +103,9 @@ public:
   typedef typename Superclass::IndexType               IndexType;
   typedef typename Superclass::ContinuousIndexType     ContinuousIndexType;
   typedef typename Superclass::PointType               PointType;
+  
+  /** Container of points for batch evaluation. */
+  typedef std::vector<PointType>                       PointContainerType;
     
   
   typedef std::vector<double>                          ScaleVectorType;
@@ -90,12 +117,22 @@ public:
     
   typedef ImageFunctionInitializerBase<TScaledImageFunction,TInputImage>   ScaledImageFunctionInitializerType; 
   typedef typename ScaledImageFunctionInitializerType::Pointer             ScaledImageFunctionInitializerPointer;
+  
+  typedef ScaledImageFunctionCache<TScaledImageFunction>    ScaledImageFunctionCacheType;
+  typedef typename ScaledImageFunctionCacheType::Pointer    ScaledImageFunctionCachePointer;
     
   enum ScaleStepMethodType
   { 
     EquispacedScaleSteps = 0,
     LogarithmicScaleSteps = 1
   };
+  
+  enum ScaleSearchMethodType
+  {
+    ExhaustiveScaleSearch = 0,
+    GoldenSectionScaleSearch = 1,
+    CoarseToFineScaleSearch = 2
+  };
     
 public:
 
@@ -128,12 +165,61 @@ public:
   /**Set logartihmic sigma step method */
   void SetScaleStepMethodToLogarithmic();
   
+  /** Set/Get the method used to search the maximum response over scales. Default is exhaustive. */
+  itkSetMacro( ScaleSearchMethod, ScaleSearchMethodType );
+  itkGetConstMacro( ScaleSearchMethod, ScaleSearchMethodType );
+  
+  void SetScaleSearchMethodToExhaustive()
+    { this->SetScaleSearchMethod( Self::ExhaustiveScaleSearch ); }
+  void SetScaleSearchMethodToGoldenSection()
+    { this->SetScaleSearchMethod( Self::GoldenSectionScaleSearch ); }
+  void SetScaleSearchMethodToCoarseToFine()
+    { this->SetScaleSearchMethod( Self::CoarseToFineScaleSearch ); }
+  
+  /** Set/Get the step (in number of scales) of the coarse pass of the coarse-to-fine search. 
+    * Zero means automatic (square root of the number of scales). */
+  itkSetMacro( CoarseScaleStep, unsigned int );
+  itkGetConstMacro( CoarseScaleStep, unsigned int );
+  
+  /** Set/Get the flag for the refinement of the selected scale between the discrete scales. The 
+    * parabola is fitted in the logarithm of the scale with LogarithmicScaleSteps. Off by default. */
+  itkSetMacro( InterpolateSelectedScale, bool );
+  itkGetConstMacro( InterpolateSelectedScale, bool );
+  itkBooleanMacro( InterpolateSelectedScale );
+  
+  /** Get the scales computed in Initialize(). */
+  const ScaleVectorType & GetScales() const
+    { return this->m_Scales; }
+  
   itkSetObjectMacro( ScaledImageFunctionInitializer, ScaledImageFunctionInitializerType );
   itkGetObjectMacro( ScaledImageFunctionInitializer, ScaledImageFunctionInitializerType );
   itkGetConstObjectMacro( ScaledImageFunctionInitializer, ScaledImageFunctionInitializerType );
   
   void SetInputImage( const InputImageType *inputImage );
   
+  /** Set/Get the flag for lazy initialization. If on, Initialize() only computes the scales, and 
+    * the function of each scale is created and initialized the first time it is evaluated. This 
+    * is thread-safe. Off by default. */
+  itkSetMacro( LazyInitialization, bool );
+  itkGetConstMacro( LazyInitialization, bool );
+  itkBooleanMacro( LazyInitialization );
+  
+  /** Set/Get the cache used to share the initialized scaled functions with other objects. The 
+    * functions are taken from the cache if already there and inserted otherwise. Null by default. */
+  itkSetObjectMacro( ScaledImageFunctionCache, ScaledImageFunctionCacheType );
+  itkGetObjectMacro( ScaledImageFunctionCache, ScaledImageFunctionCacheType );
+  
+  /** Set/Get the number of threads used by Initialize() to create and initialize the scaled 
+    * functions. The scales are independent, so the threads of the TaskPool take them one at a 
+    * time, from the largest, into the already sized container. The ScaledImageFunctionInitializer 
+    * must be thread-safe to use more than one thread. Not used with LazyInitialization on. Default is 1. */
+  itkSetClampMacro( NumberOfInitializationThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfInitializationThreads, unsigned int );
+  
+  /** Get the scaled function of the given scale index, creating it if lazy initialization is on
+    * and it was not used before. */
+  ScaledImageFunctionType * GetScaledImageFunction( unsigned int i ) const;
+  
   /** Initialize the Gaussian kernel. Call this method before evaluating the function.
     * This method MUST be called after any changes to function parameters. */
   virtual void Initialize();
@@ -146,6 +232,21 @@ public:
 
   /** Evaluate the function at specified ContinousIndex position */
   virtual OutputType EvaluateAtContinuousIndex( const ContinuousIndexType & index ) const;
+  
+  /** Evaluate the function at the given position and return in scale the scale of the selected
+    * response. The scale is zero if there are no scaled functions. */
+  OutputType EvaluateAndSelectScale( const PointType& point, double& scale ) const;
+  OutputType EvaluateAtIndexAndSelectScale( const IndexType& index, double& scale ) const;
+  OutputType EvaluateAtContinuousIndexAndSelectScale( const ContinuousIndexType& cindex, 
+    double& scale ) const;
+  
+  /** Evaluate the function at all the given points and store the maximum over scales in values, 
+    * which must have room for points.size() elements. If scales is not null, the scale at which 
+    * the maximum was found, refined if InterpolateSelectedScale is on, is stored for each point. The scalesare processed one after the other 
+    * so that the kernels of each scaled function are reused for all the points. All the scales 
+    * are evaluated whatever the ScaleSearchMethod. */
+  virtual void EvaluateBatch( const PointContainerType& points, OutputType* values, 
+    double* scales = 0 ) const;
 
 protected:
 
@@ -156,11 +257,56 @@ protected:
 
   void operator=( const Self& ){};
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Evaluate the scaled function of the given scale index at the given position. */
+  OutputType EvaluateAtScale( unsigned int i, const PointType& point ) const
+    { return this->GetScaledImageFunction( i )->Evaluate( point ); }
+  OutputType EvaluateAtScale( unsigned int i, const IndexType& index ) const
+    { return this->GetScaledImageFunction( i )->EvaluateAtIndex( index ); }
+  OutputType EvaluateAtScale( unsigned int i, const ContinuousIndexType& cindex ) const
+    { return this->GetScaledImageFunction( i )->EvaluateAtContinuousIndex( cindex ); }
+  
+  /** Create and initialize the scaled function for the given scale, or take it from the cache. */
+  ScaledImageFunctionPointer CreateScaledImageFunction( double scale ) const;
+  
+  /** Create and initialize the scaled functions of all the scales, with NumberOfInitializationThreads 
+    * threads. Called by Initialize() if LazyInitialization is off. */
+  void CreateScaledImageFunctions();
+  
+  /** Loop of CreateScaledImageFunctions() over the scales, with the error of each scale. */
+  struct InitializeScalesFunction : public TaskPool::RangeFunction
+  {
+    Self                      *Object;
+    std::vector<std::string>  Errors;
+    
+    virtual void Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int threadId );
+  };
+  
+  /** Search the maximum response over scales at the given position with the current 
+    * ScaleSearchMethod. Returns the response and the index of the selected scale. If neighbourValues
+    * is not null, the responses of the scales below and above the selected one are also stored in
+    * it, unless this is the first or last scale. */
+  template <class TPosition>
+  OutputType SearchScales( const TPosition& position, unsigned int& scaleIndex, 
+    OutputType *neighbourValues = 0 ) const;
+  
+  /** Scale of the given selected scale index, refined with the responses of the neighbour scales
+    * if InterpolateSelectedScale is on. Zero if there are no scaled functions. */
+  double GetSelectedScale( unsigned int scaleIndex, OutputType value, const OutputType *neighbourValues ) const;
 
 private:
 
-  /** Contains the different hessian function for the different scales. */  
-  ScaledImageFunctionContainerType        m_ScaledImageFunctionContainer;
+  /** Contains the different hessian function for the different scales. With lazy initialization,
+    * entries are null until first used. */  
+  mutable ScaledImageFunctionContainerType    m_ScaledImageFunctionContainer;
+  
+  bool                                        m_LazyInitialization;
+  ScaledImageFunctionCachePointer             m_ScaledImageFunctionCache;
+  
+  /** Mutex for creating the scaled functions from several threads. */
+  mutable itk::SimpleFastMutexLock            m_ScaledImageFunctionMutex;
+  
+  unsigned int                                m_NumberOfInitializationThreads;
   
   /** Provide a means to initialize the scaled image function for each scale. This is called at 
     * initialization for the image functions of all scales. */
@@ -174,6 +320,11 @@ private:
   unsigned int              m_NumberOfScales;
   ScaleStepMethodType       m_ScaleStepMethod;
   
+  ScaleSearchMethodType     m_ScaleSearchMethod;
+  unsigned int              m_CoarseScaleStep;
+  
+  bool                      m_InterpolateSelectedScale;
+  
   /** Sigmas calculated internally. */
   ScaleVectorType           m_Scales;
 };
@@ -44,7 +44,12 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
   m_MinimumScale( 1.0),
   m_MaximumScale( 5.0 ),
   m_NumberOfScales( 5 ),
-  m_ScaleStepMethod( LogarithmicScaleSteps )
+  m_ScaleStepMethod( LogarithmicScaleSteps ),
+  m_ScaleSearchMethod( ExhaustiveScaleSearch ),
+  m_CoarseScaleStep( 0 ),
+  m_InterpolateSelectedScale( false ),
+  m_LazyInitialization( false ),
+  m_NumberOfInitializationThreads( 1 )
 {
   this->m_ScaledImageFunctionInitializer = ScaledImageFunctionInitializerType::New(); // provide at least default implementation
 }
@@ -76,7 +81,9 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
   
   double stepSize = 0.0, scaleValue = 0.0;
   
-  if( this->GetNumberOfScales() > 1 )
+  if( this->GetNumberOfScales() == 1 )
+    this->m_Scales.push_back( this->m_MinimumScale );
+  else
   {
     switch( this->m_ScaleStepMethod )
     {
@@ -87,12 +94,6 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
         for( unsigned int i=0; i < this->GetNumberOfScales(); ++i )
         {
           scaleValue = this->m_MinimumScale + stepSize * (double)i;
-          
-          ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
-            
-          this->m_ScaledImageFunctionInitializer->Initialize
-            ( scaledFunction.GetPointer(), this->m_InputImage, scaleValue );                    
-          this->m_ScaledImageFunctionContainer.push_back( scaledFunction );
           this->m_Scales.push_back( scaleValue );
         }
         
@@ -106,12 +107,6 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
         for( unsigned int i=0; i < this->GetNumberOfScales(); ++i )
         {
           scaleValue = vcl_exp( vcl_log ( this->m_MinimumScale ) + stepSize * (double)i );
-          
-          ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
-            
-          this->m_ScaledImageFunctionInitializer->Initialize
-            ( scaledFunction.GetPointer(), this->m_InputImage, scaleValue );                    
-          this->m_ScaledImageFunctionContainer.push_back( scaledFunction );
           this->m_Scales.push_back( scaleValue );
         }
                  
@@ -122,29 +117,132 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
         break;
     }
   }
+  
+  // With lazy initialization the functions are created in GetScaledImageFunction()
+  this->m_ScaledImageFunctionContainer.resize( this->m_Scales.size() );
+  
+  if( !this->m_LazyInitialization )
+    this->CreateScaledImageFunctions();
 }
 
 
-/** Evaluate the function at the specifed index */
 template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
-typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+void 
 MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
-::EvaluateAtIndex( const IndexType& index ) const
+::CreateScaledImageFunctions()
 {
-  // For now we simply select the maximum
+  const unsigned int numberOfScales = this->m_Scales.size();
+  const unsigned int numberOfThreads = vnl_math_min( this->m_NumberOfInitializationThreads, numberOfScales );
+  
+  if( numberOfThreads <= 1 )
+  {
+    for( unsigned int i=0; i < numberOfScales; ++i )
+      this->m_ScaledImageFunctionContainer[i] = this->CreateScaledImageFunction( this->m_Scales[i] );
+    
+    return;
+  }
+  
+  InitializeScalesFunction function;
+  function.Object = this;
+  function.Errors.resize( numberOfScales );
+  
+  TaskPool::GetInstance()->ParallelFor( 0, numberOfScales, &function, 1, numberOfThreads );
+  
+  for( unsigned int i=0; i < numberOfScales; ++i )
+  {
+    if( !function.Errors[i].empty() )
+      itkExceptionMacro( "Error initializing the function of scale " << this->m_Scales[i] << ": " << function.Errors[i] );
+  }
+}
 
-  OutputType value = itk::NumericTraits<OutputType>::min();
-  OutputType tempValue;
 
-  for( unsigned int i=0; i < this->m_ScaledImageFunctionContainer.size(); ++i )
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+void
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::InitializeScalesFunction
+::Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int )
+{
+  // Largest scales first, since the size of the kernels grows with the scale
+  for( TaskPool::IndexValueType j = begin; j < end; ++j )
   {
-    tempValue = this->m_ScaledImageFunctionContainer[i]->EvaluateAtIndex( index );
+    const unsigned int i = static_cast<unsigned int>( this->Object->m_Scales.size() - 1 - j );
+    
+    try
+    {
+      this->Object->m_ScaledImageFunctionContainer[i] = this->Object->CreateScaledImageFunction( this->Object->m_Scales[i] );
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      this->Errors[i] = excpt.GetDescription();
+    }
+    catch( std::exception & excpt )
+    {
+      this->Errors[i] = excpt.what();
+    }
+  }
+}
+
+
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::ScaledImageFunctionPointer
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::CreateScaledImageFunction( double scale ) const
+{
+  if( this->m_ScaledImageFunctionCache.IsNotNull() )
+  {
+    ScaledImageFunctionPointer cachedFunction = this->m_ScaledImageFunctionCache->Find( scale );
+    
+    if( cachedFunction.IsNotNull() )
+      return cachedFunction;
+  }
+  
+  ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
+  this->m_ScaledImageFunctionInitializer->Initialize( scaledFunction.GetPointer(), this->m_InputImage, scale );
   
-    if( tempValue > value )
-      value = tempValue;
+  if( this->m_ScaledImageFunctionCache.IsNotNull() )
+    scaledFunction = this->m_ScaledImageFunctionCache->Insert( scale, scaledFunction );
+  
+  return scaledFunction;
+}
+
+
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::ScaledImageFunctionType *
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::GetScaledImageFunction( unsigned int i ) const
+{
+  // The container does not change after Initialize() in this case
+  if( !this->m_LazyInitialization )
+    return this->m_ScaledImageFunctionContainer[i];
+  
+  this->m_ScaledImageFunctionMutex.Lock();
+  
+  try
+  {
+    if( this->m_ScaledImageFunctionContainer[i].IsNull() )
+      this->m_ScaledImageFunctionContainer[i] = this->CreateScaledImageFunction( this->m_Scales[i] );
+  }
+  catch( ... )
+  {
+    this->m_ScaledImageFunctionMutex.Unlock();
+    throw;
   }
+  
+  ScaledImageFunctionType *scaledFunction = this->m_ScaledImageFunctionContainer[i];
+  
+  this->m_ScaledImageFunctionMutex.Unlock();
+  
+  return scaledFunction;
+}
 
-  return value;
+
+/** Evaluate the function at the specifed index */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::EvaluateAtIndex( const IndexType& index ) const
+{
+  unsigned int scaleIndex;
+  return this->SearchScales( index, scaleIndex );
 }
 
 
@@ -154,46 +252,334 @@ typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoord
 MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
 ::Evaluate( const PointType& point ) const
 {
-  // For now we simply select the maximum
+  unsigned int scaleIndex;
+  return this->SearchScales( point, scaleIndex );
+}
 
-  OutputType value = itk::NumericTraits<OutputType>::min();
-  OutputType tempValue;
 
-  for( unsigned int i=0; i < this->m_ScaledImageFunctionContainer.size(); ++i )
-  {
-    tempValue = this->m_ScaledImageFunctionContainer[i]->Evaluate( point );
+/** Evaluate the function at specified ContinousIndex position.*/
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::EvaluateAtContinuousIndex( const ContinuousIndexType & cindex ) const
+{
+  unsigned int scaleIndex;
+  return this->SearchScales( cindex, scaleIndex );
+}
+
+
+/** Evaluate the function at the specifed point and return the selected scale */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::EvaluateAndSelectScale( const PointType& point, double& scale ) const
+{
+  unsigned int scaleIndex;
+  OutputType neighbourValues[2];
+  OutputType value = this->SearchScales( point, scaleIndex, 
+    this->m_InterpolateSelectedScale ? neighbourValues : 0 );
   
-    if( tempValue > value )
-      value = tempValue;
-  }
+  scale = this->GetSelectedScale( scaleIndex, value, neighbourValues );
+  return value;
+}
+
 
+/** Evaluate the function at the specifed index and return the selected scale */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::EvaluateAtIndexAndSelectScale( const IndexType& index, double& scale ) const
+{
+  unsigned int scaleIndex;
+  OutputType neighbourValues[2];
+  OutputType value = this->SearchScales( index, scaleIndex, 
+    this->m_InterpolateSelectedScale ? neighbourValues : 0 );
+  
+  scale = this->GetSelectedScale( scaleIndex, value, neighbourValues );
   return value;
 }
 
 
-/** Evaluate the function at specified ContinousIndex position.*/
+/** Evaluate the function at the specifed continuous index and return the selected scale */
 template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
 typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
 MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
-::EvaluateAtContinuousIndex( const ContinuousIndexType & cindex ) const
+::EvaluateAtContinuousIndexAndSelectScale( const ContinuousIndexType& cindex, double& scale ) const
 {
-  // For now we simply select the maximum
+  unsigned int scaleIndex;
+  OutputType neighbourValues[2];
+  OutputType value = this->SearchScales( cindex, scaleIndex, 
+    this->m_InterpolateSelectedScale ? neighbourValues : 0 );
+  
+  scale = this->GetSelectedScale( scaleIndex, value, neighbourValues );
+  return value;
+}
 
-  OutputType value = itk::NumericTraits<OutputType>::min();
-  OutputType tempValue;
 
-  for( unsigned int i=0; i < this->m_ScaledImageFunctionContainer.size(); ++i )
+/** Scale of the selected scale index */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+double
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::GetSelectedScale( unsigned int scaleIndex, OutputType value, const OutputType *neighbourValues ) const
+{
+  if( this->m_ScaledImageFunctionContainer.empty() )
+    return 0.0;
+  
+  if( !this->m_InterpolateSelectedScale || scaleIndex == 0 || 
+      scaleIndex + 1 >= this->m_ScaledImageFunctionContainer.size() )
+    return this->m_Scales[scaleIndex];
+  
+  return ScaleInterpolation::InterpolateMaximum( this->m_Scales[scaleIndex-1], this->m_Scales[scaleIndex],
+    this->m_Scales[scaleIndex+1], neighbourValues[0], value, neighbourValues[1], 
+    this->m_ScaleStepMethod == Self::LogarithmicScaleSteps );
+}
+
+
+/** Search the maximum response over scales */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+template <class TPosition>
+typename MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>::OutputType
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::SearchScales( const TPosition& position, unsigned int& scaleIndex, OutputType *neighbourValues ) const
+{
+  const unsigned int numberOfScales = this->m_ScaledImageFunctionContainer.size();
+  
+  OutputType value = itk::NumericTraits<OutputType>::min();
+  scaleIndex = 0;
+  
+  if( this->m_ScaleSearchMethod == Self::ExhaustiveScaleSearch || numberOfScales <= 3 )
   {
-    tempValue = this->m_ScaledImageFunctionContainer[i]->EvaluateAtContinuousIndex( cindex );
+    OutputType tempValue, previousValue = value;
+    
+    for( unsigned int i=0; i < numberOfScales; ++i )
+    {
+      tempValue = this->EvaluateAtScale( i, position );
+      
+      // The scale following the current maximum is its upper neighbour
+      if( neighbourValues && i == scaleIndex + 1 )
+        neighbourValues[1] = tempValue;
+    
+      if( tempValue > value )
+      {
+        value = tempValue;
+        scaleIndex = i;
+        
+        if( neighbourValues )
+          neighbourValues[0] = previousValue;
+      }
+      
+      previousValue = tempValue;
+    }
+    
+    return value;
+  }
+  
+  // Responses already computed at this position, so that no scale is evaluated twice
+  std::vector<OutputType> values( numberOfScales );
+  std::vector<char> evaluated( numberOfScales, 0 );
+  
+  unsigned int lower = 0, upper = numberOfScales - 1;
+  
+  switch( this->m_ScaleSearchMethod )
+  {
+    case Self::GoldenSectionScaleSearch:
+    {
+      // Shrink the bracket [lower,upper] while it contains more than three scales
+      const double goldenFraction = 0.381966011250105; // 2 - golden ratio
+      
+      while( upper - lower > 2 )
+      {
+        const unsigned int span = upper - lower;
+        unsigned int first = lower + vnl_math_max( 1u, 
+          static_cast<unsigned int>( span * goldenFraction + 0.5 ) );
+        unsigned int second = upper - ( first - lower );
+        
+        if( second <= first )
+          second = first + 1;
+        
+        if( !evaluated[first] )
+        {
+          values[first] = this->EvaluateAtScale( first, position );
+          evaluated[first] = 1;
+        }
+        
+        if( !evaluated[second] )
+        {
+          values[second] = this->EvaluateAtScale( second, position );
+          evaluated[second] = 1;
+        }
+        
+        if( values[first] < values[second] )
+          lower = first + 1;
+        else
+          upper = second - 1;
+      }
+      
+      break;
+    }
+    case Self::CoarseToFineScaleSearch:
+    {
+      unsigned int step = this->m_CoarseScaleStep;
+      
+      if( step == 0 )
+        step = static_cast<unsigned int>( vcl_sqrt( static_cast<double>( numberOfScales ) ) );
+      
+      step = vnl_math_max( 1u, step );
+      
+      // Coarse pass, always including the last scale
+      unsigned int coarseIndex = 0;
+      
+      for( unsigned int i=0; i < numberOfScales; i += step )
+      {
+        values[i] = this->EvaluateAtScale( i, position );
+        evaluated[i] = 1;
+        
+        if( values[i] > values[coarseIndex] )
+          coarseIndex = i;
+      }
+      
+      if( !evaluated[numberOfScales-1] )
+      {
+        values[numberOfScales-1] = this->EvaluateAtScale( numberOfScales-1, position );
+        evaluated[numberOfScales-1] = 1;
+        
+        if( values[numberOfScales-1] > values[coarseIndex] )
+          coarseIndex = numberOfScales-1;
+      }
+      
+      // The fine pass visits the scales between the neighbours of the best coarse scale
+      lower = ( coarseIndex >= step ) ? coarseIndex - step + 1 : 0;
+      upper = vnl_math_min( coarseIndex + step - 1, numberOfScales - 1 );
+      
+      break;
+    }
+    default:
+      itkExceptionMacro( "Invalid ScaleSearchMethod." );
+      break;
+  }
   
-    if( tempValue > value )
-      value = tempValue;
+  for( unsigned int i=lower; i <= upper; ++i )
+  {
+    if( !evaluated[i] )
+    {
+      values[i] = this->EvaluateAtScale( i, position );
+      evaluated[i] = 1;
+    }
   }
-
+  
+  // Select the maximum among all the evaluated scales
+  for( unsigned int i=0; i < numberOfScales; ++i )
+  {
+    if( evaluated[i] && values[i] > value )
+    {
+      value = values[i];
+      scaleIndex = i;
+    }
+  }
+  
+  // The neighbours of the selected scale may be outside the scales visited by the search
+  if( neighbourValues && scaleIndex > 0 && scaleIndex + 1 < numberOfScales )
+  {
+    for( unsigned int i = scaleIndex - 1; i <= scaleIndex + 1; i += 2 )
+    {
+      if( !evaluated[i] )
+      {
+        values[i] = this->EvaluateAtScale( i, position );
+        evaluated[i] = 1;
+      }
+    }
+    
+    neighbourValues[0] = values[scaleIndex-1];
+    neighbourValues[1] = values[scaleIndex+1];
+  }
+  
   return value;
 }
 
 
+/** Evaluate the function at the given points */
+template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
+void
+MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
+::EvaluateBatch( const PointContainerType& points, OutputType* values, double* scales ) const
+{
+  const unsigned long numberOfPoints = points.size();
+  
+  if( numberOfPoints == 0 )
+    return;
+  
+  // Same initial value as the single point methods so that results are identical
+  for( unsigned long j=0; j < numberOfPoints; ++j )
+    values[j] = itk::NumericTraits<OutputType>::min();
+    
+  if( scales )
+  {
+    for( unsigned long j=0; j < numberOfPoints; ++j )
+      scales[j] = 0.0;
+  }
+  
+  const unsigned int numberOfScales = this->m_ScaledImageFunctionContainer.size();
+  
+  std::vector<OutputType> tempValues( numberOfPoints );
+  
+  // Responses of the previous scale and of the neighbours of the maximum, to refine the scales
+  const bool interpolate = scales && this->m_InterpolateSelectedScale && numberOfScales > 2;
+  
+  std::vector<OutputType> previousValues, lowerValues, upperValues;
+  std::vector<unsigned int> scaleIndices;
+  
+  if( interpolate )
+  {
+    previousValues.assign( numberOfPoints, values[0] );
+    lowerValues.resize( numberOfPoints );
+    upperValues.resize( numberOfPoints );
+    scaleIndices.assign( numberOfPoints, 0 );
+  }
+  
+  for( unsigned int i=0; i < numberOfScales; ++i )
+  {
+    this->GetScaledImageFunction( i )->EvaluateBatch( points, &tempValues[0] );
+    
+    for( unsigned long j=0; j < numberOfPoints; ++j )
+    {
+      if( interpolate && i == scaleIndices[j] + 1 )
+        upperValues[j] = tempValues[j];
+      
+      if( tempValues[j] > values[j] )
+      {
+        values[j] = tempValues[j];
+        
+        if( scales )
+          scales[j] = this->m_Scales[i];
+        
+        if( interpolate )
+        {
+          scaleIndices[j] = i;
+          lowerValues[j] = previousValues[j];
+        }
+      }
+    }
+    
+    if( interpolate )
+      previousValues.swap( tempValues );
+  }
+  
+  if( interpolate )
+  {
+    OutputType neighbourValues[2];
+    
+    for( unsigned long j=0; j < numberOfPoints; ++j )
+    {
+      neighbourValues[0] = lowerValues[j];
+      neighbourValues[1] = upperValues[j];
+      
+      if( scaleIndices[j] > 0 )
+        scales[j] = this->GetSelectedScale( scaleIndices[j], values[j], neighbourValues );
+    }
+  }
+}
+
+
 /** Print self method */
 template <class TScaledImageFunction, class TInputImage, class TOutput, class TCoordRep>
 void
@@ -207,6 +593,12 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
   os << indent << "MaximumScale: " << this->m_MaximumScale << std::endl;
   os << indent << "NumberOfScales: " << this->m_NumberOfScales << std::endl;
   os << indent << "ScaleStepMethod: " << this->m_ScaleStepMethod << std::endl;
+  os << indent << "ScaleSearchMethod: " << this->m_ScaleSearchMethod << std::endl;
+  os << indent << "CoarseScaleStep: " << this->m_CoarseScaleStep << std::endl;
+  os << indent << "InterpolateSelectedScale: " << this->m_InterpolateSelectedScale << std::endl;
+  os << indent << "LazyInitialization: " << this->m_LazyInitialization << std::endl;
+  os << indent << "NumberOfInitializationThreads: " << this->m_NumberOfInitializationThreads << std::endl;
+  os << indent << "ScaledImageFunctionCache: " << this->m_ScaledImageFunctionCache.GetPointer() << std::endl;
   os << indent << "ScaledImageFunctionContainer:" << std::endl;
   
   os << indent << "Scales: ";
@@ -215,7 +607,10 @@ MultiscaleImageFunction<TScaledImageFunction,TInputImage,TOutput,TCoordRep>
     
   for( typename ScaledImageFunctionContainerType::const_iterator it = m_ScaledImageFunctionContainer.begin();
     it != m_ScaledImageFunctionContainer.end(); ++it )
-    (*it)->Print( os, indent.GetNextIndent() );
+  {
+    if( it->IsNotNull() )
+      (*it)->Print( os, indent.GetNextIndent() );
+  }
   
   os << std::endl;    
 }
@@ -32,10 +32,17 @@ SUCH DAMAGE.
 
 
 #include "ivanMultiscaleAnalysisImageFilter.h"
+#include "ivanImageRegionTileScheduler.h"
+#include "ivanSymmetricEigenSolver.h"
+#include "ivanCircleSampler.h"
+#include "ivanGaussianWeightTable.h"
 
-#include "itkSymmetricEigenAnalysis.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkVector.h"
+#include "itkMultiThreader.h"
+#include "itkArray.h"
+
+#include <vector>
 
 
 namespace ivan
@@ -65,9 +72,11 @@ public:
   typedef TInputImage		                                InputImageType;
   typedef TOutputImage                                  OutputImageType;
   typedef TMaskImage	                                 	MaskImageType;
+  typedef typename Superclass::PackedMaskType           PackedMaskType;
  
   typedef TScalePixel	                                	ScalePixelType;
   typedef typename OutputImageType::PixelType		        OutputImagePixelType;
+  typedef typename OutputImageType::RegionType		      OutputImageRegionType;
   typedef typename Superclass::TensorScalePixelType	  	TensorScalePixelType;
   
   typedef typename Superclass::ScaleContainerType	      ScaleContainerType;
@@ -83,10 +92,15 @@ public:
   typedef itk::Vector<TScalePixel,ImageDimension>     VectorPixelType;
   typedef itk::Image<VectorPixelType,ImageDimension>  VectorImageType;
   
+  /** Image types for the memory-lean outputs: scale indices and octahedral-encoded normals. */
+  typedef unsigned char                                        ScaleIndexPixelType;
+  typedef itk::Image<ScaleIndexPixelType,ImageDimension>       ScaleIndexImageType;
+  typedef itk::Vector<short,2>                                 EncodedNormalPixelType;
+  typedef itk::Image<EncodedNormalPixelType,ImageDimension>    EncodedNormalImageType;
+  
   /** Iterators. */
   typedef itk::ImageRegionConstIterator<InputImageType>        InputConstIterator;
   typedef itk::ImageRegionIterator<OutputImageType>            OutputIterator;
-  typedef itk::ImageRegionConstIterator<MaskImageType>         MaskImageIterator;
   typedef itk::ImageRegionConstIterator<ScaleImageType>        GradientImageIterator;
   typedef itk::ImageRegionIterator<ScaleImageType>             ScalesImageIterator;
   typedef	itk::ImageRegionConstIterator<TensorScaleImageType>	 TensorImageIterator;
@@ -94,11 +108,18 @@ public:
   
   /** Interpolator used for calculations. */
   typedef	itk::LinearInterpolateImageFunction<ScaleImageType,double>		InterpolatorType;
+  typedef std::vector<typename InterpolatorType::Pointer>           InterpolatorContainerType;
+  
+  /** Generation of the circle samples in the gradient magnitude image. */
+  typedef CircleSampler<ScaleImageType,double>                      CircleSamplerType;
+  typedef typename CircleSamplerType::SampleSet                     CircleSampleSetType;
   
   /** Types for eigenanalysis. */
-  typedef	itk::SymmetricEigenAnalysis< TensorScalePixelType, 
-		typename TensorScalePixelType::EigenValuesArrayType, 
-		typename TensorScalePixelType::EigenVectorsMatrixType >		EigenAnalysisType;
+  typedef SymmetricEigenSolver<TensorScalePixelType>    EigenAnalysisType;
+		
+  /** Scheduler of the tiles of the current output region, in dynamic scheduling mode. */
+  typedef ImageRegionTileScheduler<itkGetStaticConstMacro(ImageDimension)>   TileSchedulerType;
+  typedef typename TileSchedulerType::Pointer                                TileSchedulerPointer;
 		
 	typedef typename Superclass::GradientMagnitudeFilterType  GradientMagnitudeFilterType;
   typedef typename Superclass::HessianFilterType  					HessianFilterType;
@@ -119,6 +140,12 @@ public:
   itkSetMacro( SymmetryCoefficient, double );
   itkGetMacro( SymmetryCoefficient, double );
   
+  /** Get/set whether the symmetry weights are looked up in a precomputed
+    * Gaussian table instead of calling exp(). Off by default. */
+  itkSetMacro( UseFastGaussianWeights, bool );
+  itkGetMacro( UseFastGaussianWeights, bool );
+  itkBooleanMacro( UseFastGaussianWeights );
+  
    /** Get/set the radius factor. */
   itkSetMacro( RadiusFactor, double );
   itkGetMacro( RadiusFactor, double );
@@ -127,10 +154,114 @@ public:
 	void SetFilterByEigenValues( bool filterByEigenValues );
   itkBooleanMacro( FilterByEigenValues );
   
-  /** Get the normals image. This is the normal of the section estimated as the third eigenvalue. */
+  /** Set/Get if the pixels are rejected with cheap tests before the eigenanalysis and the 
+    * sampling of the circle. With FilterByEigenValues on, the signs of the sum of the principal 
+    * minors and of the determinant of the Hessian discard the pixels that cannot have two 
+    * negative eigenvalues. The circle is not sampled when the maximum of the gradient magnitude 
+    * at the current scale, which bounds the medialness, cannot give a value above the output 
+    * threshold and the current output. The output is the same as with this flag off. On by default. */
+  itkSetMacro( EarlyRejection, bool );
+  itkGetConstMacro( EarlyRejection, bool );
+  itkBooleanMacro( EarlyRejection );
+  
+  /** Set/Get if the medialness bound of the early rejection is local. The bound at each pixel is 
+    * then the maximum of the gradient magnitude in the box that contains the sampled circle (and 
+    * the pixels used to interpolate it), computed with a separable maximum filter at each scale. 
+    * Tighter than the maximum of the whole image, at the cost of an image of the size of the 
+    * gradient magnitude. Only used with EarlyRejection on. Off by default. */
+  itkSetMacro( LocalRejectionBound, bool );
+  itkGetConstMacro( LocalRejectionBound, bool );
+  itkBooleanMacro( LocalRejectionBound );
+  
+  /** Set/Get if the scales are computed starting with the most likely one. The order is given by 
+    * the number of pixels at which each scale gives the maximum in a coarse pass over the input 
+    * shrunk by CoarsePassShrinkFactor, without mask. Then the first scales give high outputs early 
+    * and the rejection against the current output discards more pixels at the remaining scales.
+    * Where two scales give the same medialness, the output scale may differ from the one of the 
+    * default order. Not used with ScaleSpaceCascade on or more than 255 scales. Off by default. */
+  itkSetMacro( OrderScalesByCoarsePass, bool );
+  itkGetConstMacro( OrderScalesByCoarsePass, bool );
+  itkBooleanMacro( OrderScalesByCoarsePass );
+  
+  /** Set/Get the shrink factor of the input for the coarse pass. Default is 2. */
+  itkSetMacro( CoarsePassShrinkFactor, unsigned int );
+  itkGetConstMacro( CoarsePassShrinkFactor, unsigned int );
+  
+  /** Set/Get if the pixels whose input value is below IntensityThreshold are skipped, before 
+    * any other test. Useful for bright vessels over a darker background. Off by default. */
+  itkSetMacro( UseIntensityThreshold, bool );
+  itkGetConstMacro( UseIntensityThreshold, bool );
+  itkBooleanMacro( UseIntensityThreshold );
+  
+  /** Set/Get the minimum input value of the computed pixels if UseIntensityThreshold is on. */
+  itkSetMacro( IntensityThreshold, double );
+  itkGetConstMacro( IntensityThreshold, double );
+  
+  /** Set/Get the flag for dynamic scheduling. If on, the current output region is divided in 
+    * small tiles of TileSize pixels per dimension that the threads pull from a shared queue at 
+    * each scale, instead of giving a single slab to each thread. This balances the work since 
+    * medialness is only computed at vessel pixels. Off by default. */
+  itkSetMacro( DynamicScheduling, bool );
+  itkGetConstMacro( DynamicScheduling, bool );
+  itkBooleanMacro( DynamicScheduling );
+  
+  /** Set/Get the size of the tiles in each dimension for dynamic scheduling. Default is 16. */
+  itkSetMacro( TileSize, unsigned long );
+  itkGetConstMacro( TileSize, unsigned long );
+  
+  /** Get the normals image. This is the normal of the section estimated as the third eigenvalue. 
+    * Only produced if ComputeNormals is on and EncodeNormals is off. */
 	VectorImageType* GetOutputNormals()
 		{ return dynamic_cast< VectorImageType* >( this->itk::ProcessObject::GetOutput(2) );	}
   
+  /** Get the scale indices image. Each pixel has the position plus one of the scale at which the
+    * output was obtained in the scales container, or zero if no scale gave a response. Only 
+    * produced if StoreScaleIndices is on, and then GetOutputScales() is not produced. */
+  ScaleIndexImageType* GetOutputScaleIndices()
+    { return dynamic_cast< ScaleIndexImageType* >( this->itk::ProcessObject::GetOutput(3) ); }
+  
+  /** Get the encoded normals image. Only produced if ComputeNormals and EncodeNormals are on, 
+    * and then GetOutputNormals() is not produced. Use DecodeNormal() to recover the normals. */
+  EncodedNormalImageType* GetOutputEncodedNormals()
+    { return dynamic_cast< EncodedNormalImageType* >( this->itk::ProcessObject::GetOutput(4) ); }
+  
+  /** Set/Get if the normals must be computed. If off, no normals image is allocated. On by default. */
+  itkSetMacro( ComputeNormals, bool );
+  itkGetConstMacro( ComputeNormals, bool );
+  itkBooleanMacro( ComputeNormals );
+  
+  /** Set/Get if the normals must be stored octahedral-encoded as two 16-bit integers per pixel
+    * in GetOutputEncodedNormals(), instead of three ScalePixelType values in GetOutputNormals().
+    * The angular error is below 1e-4 radians. Off by default. */
+  itkSetMacro( EncodeNormals, bool );
+  itkGetConstMacro( EncodeNormals, bool );
+  itkBooleanMacro( EncodeNormals );
+  
+  /** Set/Get if the scales must be stored as 8-bit indices in GetOutputScaleIndices() instead 
+    * of as ScalePixelType values in GetOutputScales(). At most 255 scales can be used. 
+    * Use GetScaleFromIndex() to recover the scales. Off by default. */
+  itkSetMacro( StoreScaleIndices, bool );
+  itkGetConstMacro( StoreScaleIndices, bool );
+  itkBooleanMacro( StoreScaleIndices );
+  
+  /** Set/Get if the Hessian image must be released after each scale. The tensor image is the 
+    * largest of the scale filter images, so this lowers the peak memory while the gradient 
+    * magnitude of the next scale is computed, at the cost of allocating it again. Off by default. */
+  itkSetMacro( ReleaseHessianBetweenScales, bool );
+  itkGetConstMacro( ReleaseHessianBetweenScales, bool );
+  itkBooleanMacro( ReleaseHessianBetweenScales );
+  
+  /** Get the scale corresponding to a value of GetOutputScaleIndices(). Returns zero for index zero. */
+  ScalePixelType GetScaleFromIndex( ScaleIndexPixelType index ) const
+    { return ( index && index <= this->m_Scales.size() )? this->m_Scales[index-1] : 
+       itk::NumericTraits<ScalePixelType>::Zero; }
+  
+  /** Encode a unit 3D normal in two 16-bit integers with the octahedral mapping. */
+  static void EncodeNormal( const VectorPixelType& normal, EncodedNormalPixelType& encodedNormal );
+  
+  /** Decode an octahedral-encoded normal. The result has unit norm. */
+  static void DecodeNormal( const EncodedNormalPixelType& encodedNormal, VectorPixelType& normal );
+  
 
 protected:
 
@@ -139,19 +270,60 @@ protected:
   
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
   
-  /** Override since the filter produces the entire dataset. */  
+  /** Override since the normals and scale indices outputs must be produced in the same region 
+    * as the main output. */
   virtual void EnlargeOutputRequestedRegion( itk::DataObject *output );
 
-	/** Prepare output images. */
+	/** Prepare output images. Only the outputs enabled by the memory-lean options are allocated. */
 	virtual void PrepareData();
+	
+	/** Reset also the normals and scale indices outputs that are produced. */
+	virtual void ResetOutputsInRegion( const OutputImageRegionType & region );
 
   /** Called by GenerateData to generate data for the current scale. */
   virtual void GenerateDataAtScale( const ScalePixelType currentScale );
   
+  /** Order the scales by the results of a coarse pass if OrderScalesByCoarsePass is on. */
+  virtual void OrderScales( ScaleContainerType & scales );
+  
+  /** Release also the local maximum of the gradient magnitude. */
+  virtual void ReleaseScaleFiltersOutputs();
+  
+  /** Compute the maximum of the image in a box of the given radius around each pixel of the 
+    * buffered region, separably. The output must have the same buffered region as the image. */
+  static void ComputeLocalMaximum( const ScaleImageType *image, 
+    const typename ScaleImageType::SizeType & radius, ScaleImageType *output );
+  
   /** Called by GenerateData to generate data for the current scale using the provided mask. 
     * Overriden to speed-up computations using the provided mask.*/
   virtual void GenerateDataUsingMaskAtScale( const ScalePixelType currentScale );
   
+  /** Pad the region by the radius at which the gradient is sampled, so that results 
+    * computed in slabs (FusedScales on) are the same as those for the whole image. */
+  virtual OutputImageRegionType GetScaleFiltersRegion( const ScalePixelType currentScale, 
+    const OutputImageRegionType& outputRegion ) const;
+  
+  /** Computes the medialness at the current scale for the given region. The region is a
+    * piece of the current output region and is processed by a single thread. Each thread 
+    * uses its own gradient interpolator and eigenanalysis calculator. As regions of different 
+    * threads do not overlap, the max-over-scales update of the outputs is deterministic. */
+  virtual void ThreadedGenerateDataAtScale( const OutputImageRegionType& outputRegionForThread, 
+    int threadId );
+  
+  /** Splits the output requested region and calls ThreadedGenerateDataAtScale() with
+    * each of the pieces (or the tiles, in dynamic scheduling mode). The sampling tables 
+    * for the given scale are precomputed first. */
+  void MultiThreadedGenerateDataAtScale( const ScalePixelType currentScale, bool useMask );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ScaleThreaderCallback( void *arg );
+
+  /** Internal structure used for passing the filter to the threader callback. */
+  struct ScaleThreadStruct
+  {
+    Pointer Filter;
+  };
+  
   
 private:
 
@@ -166,6 +338,9 @@ private:
   /** Coefficient for taking into account the simmetry in the medialness. */
   double		m_SymmetryCoefficient;
   
+  /** Use the tabulated Gaussian for the symmetry weights. */
+  bool		m_UseFastGaussianWeights;
+  
   /** Radius factor. This is multiplied by the current scale to obtain the distance (radius) 
     * at which points are sampled in a circle (by default sqrt(3.0) which gives the maximum
     * value for medialness. */
@@ -174,11 +349,35 @@ private:
   /** Flag for filtering pixels by eigenvalue. */
   bool      m_FilterByEigenValues;
   
-  /** Eigenanalysis calculator. */
-  EigenAnalysisType  m_EigenAnalysis;
+  /** Rejection tests before the eigenanalysis and the circle sampling. */
+  bool      m_EarlyRejection;
+  bool      m_LocalRejectionBound;
+  bool      m_OrderScalesByCoarsePass;
+  unsigned int  m_CoarsePassShrinkFactor;
+  bool      m_UseIntensityThreshold;
+  double    m_IntensityThreshold;
   
-  /** Interpolator used to estimate gradient at non-index positions. */
-	typename InterpolatorType::Pointer 	m_GradientInterpolator;
+  /** Interpolators used to estimate gradient at non-index positions (one per thread). */
+	InterpolatorContainerType 	m_GradientInterpolatorContainer;
+	
+	/** State of the scale being currently processed, shared (read-only) by all threads. */
+	ScalePixelType        m_CurrentScale;
+	ScaleIndexPixelType   m_CurrentScaleIndex;
+	bool                  m_UseMaskAtCurrentScale;
+	double                m_CurrentMaximumBoundariness;
+	typename ScaleImageType::Pointer   m_LocalMaximumBoundariness;
+	CircleSamplerType     m_CircleSampler;
+	
+	/** Dynamic scheduling of the tiles of the current output region. */
+	bool                  m_DynamicScheduling;
+	unsigned long         m_TileSize;
+	TileSchedulerPointer  m_TileScheduler;
+	
+	/** Memory-lean output options. */
+	bool                  m_ComputeNormals;
+	bool                  m_EncodeNormals;
+	bool                  m_StoreScaleIndices;
+	bool                  m_ReleaseHessianBetweenScales;
   
 
 };
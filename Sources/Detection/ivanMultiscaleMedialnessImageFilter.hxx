@@ -11,6 +11,12 @@
 #include "itkProgressReporter.h"
 #include "itkArray.h"
 #include "itkNeighborhoodAlgorithm.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkShrinkImageFilter.h"
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <deque>
 
 
 namespace ivan
@@ -23,12 +29,25 @@ template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskI
 MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 ::MultiscaleMedialnessImageFilter() :
   m_FilterByEigenValues(false),
-  m_RadiusFactor(1.7320508) // = sqrt(3.0)
+  m_EarlyRejection(true),
+  m_LocalRejectionBound(false),
+  m_OrderScalesByCoarsePass(false),
+  m_CoarsePassShrinkFactor(2),
+  m_UseIntensityThreshold(false),
+  m_IntensityThreshold(0.0),
+  m_RadiusFactor(1.7320508), // = sqrt(3.0)
+  m_DynamicScheduling(false),
+  m_TileSize(16),
+  m_ComputeNormals(true),
+  m_EncodeNormals(false),
+  m_StoreScaleIndices(false),
+  m_ReleaseHessianBetweenScales(false)
 {
   this->m_DoNotComputeZeroPixels = true; // this filter is computationally quite expensive
   
   this->m_OutputThreshold = itk::NumericTraits<OutputImagePixelType>::Zero;
   this->m_SymmetryCoefficient = itk::NumericTraits<double>::One;
+  this->m_UseFastGaussianWeights = false;
   
   
   // Allocate here the scale filter we need to use
@@ -43,17 +62,25 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
   // See a detailed description of the problem here
   // http://public.kitware.com/pipermail/insight-users/2006-May/017900.html
     
-  this->m_EigenAnalysis.SetOrderEigenValues(true);
-  this->m_EigenAnalysis.SetDimension(ImageDimension); 
   
-  this->m_GradientInterpolator = InterpolatorType::New();
+  this->m_CurrentScale = itk::NumericTraits<ScalePixelType>::Zero;
+  this->m_CurrentScaleIndex = 0;
+  this->m_UseMaskAtCurrentScale = false;
+  this->m_CurrentMaximumBoundariness = 0.0;
   
-  // This filter has 3 outputs instead of 2
-  this->itk::ProcessObject::SetNumberOfRequiredOutputs(3);
+  // This filter has 5 outputs instead of 2. Outputs 3 and 4 replace outputs 1 and 2 in the 
+  // memory-lean modes, and are not produced otherwise
+  this->itk::ProcessObject::SetNumberOfRequiredOutputs(5);
   
   // Create the vector image that will be used as output for the estimated normals 
   typename  VectorImageType::Pointer normalsImage = VectorImageType::New();
   this->itk::ProcessObject::SetNthOutput( 2, normalsImage.GetPointer() );  
+  
+  typename ScaleIndexImageType::Pointer scaleIndicesImage = ScaleIndexImageType::New();
+  this->itk::ProcessObject::SetNthOutput( 3, scaleIndicesImage.GetPointer() );
+  
+  typename EncodedNormalImageType::Pointer encodedNormalsImage = EncodedNormalImageType::New();
+  this->itk::ProcessObject::SetNthOutput( 4, encodedNormalsImage.GetPointer() );
     
 }
 
@@ -87,12 +114,25 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
   os << indent << "SymmetryCoefficient: "
      << static_cast<typename itk::NumericTraits<double>::PrintType>( this->m_SymmetryCoefficient )
      << std::endl;
+  os << indent << "UseFastGaussianWeights: " << this->m_UseFastGaussianWeights << std::endl;
   os << indent << "RadiusFactor: "
      << static_cast<typename itk::NumericTraits<double>::PrintType>( this->m_RadiusFactor )
      << std::endl; 
   os << indent << "FilterByEigenValues: "
      << static_cast<typename itk::NumericTraits<bool>::PrintType>( this->m_FilterByEigenValues )
      << std::endl;
+  os << indent << "EarlyRejection: " << this->m_EarlyRejection << std::endl;
+  os << indent << "LocalRejectionBound: " << this->m_LocalRejectionBound << std::endl;
+  os << indent << "OrderScalesByCoarsePass: " << this->m_OrderScalesByCoarsePass << std::endl;
+  os << indent << "CoarsePassShrinkFactor: " << this->m_CoarsePassShrinkFactor << std::endl;
+  os << indent << "UseIntensityThreshold: " << this->m_UseIntensityThreshold << std::endl;
+  os << indent << "IntensityThreshold: " << this->m_IntensityThreshold << std::endl;
+  os << indent << "DynamicScheduling: " << this->m_DynamicScheduling << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+  os << indent << "ComputeNormals: " << this->m_ComputeNormals << std::endl;
+  os << indent << "EncodeNormals: " << this->m_EncodeNormals << std::endl;
+  os << indent << "StoreScaleIndices: " << this->m_StoreScaleIndices << std::endl;
+  os << indent << "ReleaseHessianBetweenScales: " << this->m_ReleaseHessianBetweenScales << std::endl;
  
 }
 
@@ -108,12 +148,25 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 {
   Superclass::EnlargeOutputRequestedRegion(output);
   
-  TOutputImage *out = dynamic_cast<TOutputImage*>(output);
+  TOutputImage *out = this->GetOutput();
+  
+  if( !out )
+    return;
   
   VectorImageType *normalsOutput = this->GetOutputNormals();
   
   if( normalsOutput )
-    normalsOutput->SetRequestedRegion( out->GetLargestPossibleRegion() ); 
+    normalsOutput->SetRequestedRegion( out->GetRequestedRegion() ); 
+  
+  ScaleIndexImageType *scaleIndicesOutput = this->GetOutputScaleIndices();
+  
+  if( scaleIndicesOutput )
+    scaleIndicesOutput->SetRequestedRegion( out->GetRequestedRegion() ); 
+  
+  EncodedNormalImageType *encodedNormalsOutput = this->GetOutputEncodedNormals();
+  
+  if( encodedNormalsOutput )
+    encodedNormalsOutput->SetRequestedRegion( out->GetRequestedRegion() ); 
 }
 
 
@@ -126,105 +179,166 @@ void
 MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
 ::PrepareData()
 {
-  Superclass::PrepareData();
+  if( this->m_StoreScaleIndices && this->m_Scales.size() > 
+    static_cast<unsigned int>( itk::NumericTraits<ScaleIndexPixelType>::max() ) )
+  {
+    itkExceptionMacro( "At most " << static_cast<unsigned int>( itk::NumericTraits<ScaleIndexPixelType>::max() ) 
+      << " scales can be stored as scale indices." );
+  }
   
-  typename VectorImageType::Pointer normalsPtr = dynamic_cast< VectorImageType * >
-    ( this->itk::ProcessObject::GetOutput(2) );
-  normalsPtr->SetBufferedRegion(normalsPtr->GetRequestedRegion());
-  normalsPtr->Allocate();
-  normalsPtr->FillBuffer( itk::NumericTraits<ScalePixelType>::Zero ); 
+  // Allocate and fill with zeros only the outputs that are produced, the others are released
+  // Superclass::PrepareData() is not called since it allocates the scales output
+  typename OutputImageType::Pointer outputPtr = this->GetOutput(0);
+  outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+  outputPtr->Allocate();
+  this->FillBuffer( outputPtr.GetPointer(), itk::NumericTraits<OutputImagePixelType>::Zero );
+  
+  typename ScaleImageType::Pointer scalesPtr = this->GetOutputScales();
+  typename ScaleIndexImageType::Pointer scaleIndicesPtr = this->GetOutputScaleIndices();
+  
+  if( !this->m_StoreScaleIndices )
+  {
+    scalesPtr->SetBufferedRegion( scalesPtr->GetRequestedRegion() );
+    scalesPtr->Allocate();
+    this->FillBuffer( scalesPtr.GetPointer(), itk::NumericTraits<ScalePixelType>::Zero );
+    scaleIndicesPtr->ReleaseData();
+  }
+  else
+  {
+    scaleIndicesPtr->SetBufferedRegion( scaleIndicesPtr->GetRequestedRegion() );
+    scaleIndicesPtr->Allocate();
+    this->FillBuffer( scaleIndicesPtr.GetPointer(), itk::NumericTraits<ScaleIndexPixelType>::Zero );
+    scalesPtr->ReleaseData();
+  }
+  
+  typename VectorImageType::Pointer normalsPtr = this->GetOutputNormals();
+  typename EncodedNormalImageType::Pointer encodedNormalsPtr = this->GetOutputEncodedNormals();
+  
+  if( this->m_ComputeNormals && !this->m_EncodeNormals )
+  {
+    normalsPtr->SetBufferedRegion( normalsPtr->GetRequestedRegion() );
+    normalsPtr->Allocate();
+    this->FillBuffer( normalsPtr.GetPointer(), itk::NumericTraits<ScalePixelType>::Zero ); 
+  }
+  else
+    normalsPtr->ReleaseData();
+  
+  if( this->m_ComputeNormals && this->m_EncodeNormals )
+  {
+    EncodedNormalPixelType zeroNormal;
+    zeroNormal.Fill( 0 );
+    
+    encodedNormalsPtr->SetBufferedRegion( encodedNormalsPtr->GetRequestedRegion() );
+    encodedNormalsPtr->Allocate();
+    this->FillBuffer( encodedNormalsPtr.GetPointer(), zeroNormal );
+  }
+  else
+    encodedNormalsPtr->ReleaseData();
 }
 
 
 
-
 /**
  *
  */
 template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
 void 
 MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
-::GenerateDataAtScale( const ScalePixelType currentScale )
+::ResetOutputsInRegion( const OutputImageRegionType & region )
 {
-  itkDebugMacro(<< "MultiscaleMedialnessImageFilter generating data at scale " << currentScale);
-
-  // Get the input and output pointers
-  typename InputImageType::ConstPointer inputPtr  = this->GetInput();
-  typename OutputImageType::Pointer outputPtr = this->GetOutput(0);
-  typename ScaleImageType::Pointer scalesPtr = dynamic_cast< ScaleImageType * >
-    ( this->itk::ProcessObject::GetOutput(1) );
-  typename VectorImageType::Pointer normalsPtr = dynamic_cast< VectorImageType * >
-    ( this->itk::ProcessObject::GetOutput(2) );
+  // Released outputs are not filled
+  Superclass::ResetOutputsInRegion( region );
   
-  this->m_GradientInterpolator->SetInputImage( this->m_GradientMagnitudeGaussian->GetOutput() );    
+  this->FillRegion( this->GetOutputScaleIndices(), region, itk::NumericTraits<ScaleIndexPixelType>::Zero );
   
-  // Current eigenvalues, eigenvectors and related variables
-  typename TensorScalePixelType::EigenVectorsMatrixType   eigenVectors; // current eigenvalues
-  typename TensorScalePixelType::EigenValuesArrayType     eigenValues; // current eigenvectors
-  itk::Array<double>    firstEigenVector;
-  itk::Array<double>    secondEigenVector;
-  firstEigenVector.SetSize(ImageDimension);
-  secondEigenVector.SetSize(ImageDimension);
+  typename VectorImageType::PixelType zeroNormal;
+  zeroNormal.Fill( 0 );
+  this->FillRegion( this->GetOutputNormals(), region, zeroNormal );
   
-  // The estimated normal will be the third eigenvector but we need it in the form of an itk::Vector
-  VectorPixelType thirdEigenVector;
-    
-  // Arrays for medialness calculations
-  itk::Array<double>  sinArray; // store sin values
-  itk::Array<double>  cosArray; // store cos values
-  itk::Array<double>  radialMedialness; // this stores all values of gradient in the circle with given radius
-  itk::Array<double>  radialMedialnessWeights;  // this stores all weighting factors in the circle with given radius
-      
-  // Variables involved in medialness calculation
-  double radius; // current radius for medialness calculation
-  unsigned int samples; // number of samples in a circle
-  unsigned int calculatedSamples; // number of calculated samples in a circle
-  double angleInc; // angle increment
-  double angle; // current angle
-  double medialness; // calculated medialness at current point and scale
-  double weightExponent; // exponent of weighting factors for medialness calculations
-  double averageRadialMedialness; // measure of average medialness without weighting
-  double centralBoundariness; // boundariness at the current point
-  typename InterpolatorType::PointType currentCirclePoint;
-  typename InterpolatorType::IndexType currentCircleIndex;
+  EncodedNormalPixelType zeroEncodedNormal;
+  zeroEncodedNormal.Fill( 0 );
+  this->FillRegion( this->GetOutputEncodedNormals(), region, zeroEncodedNormal );
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::EncodeNormal( const VectorPixelType& normal, EncodedNormalPixelType& encodedNormal )
+{
+  // Project on the octahedron |x|+|y|+|z| = 1 and unfold the lower half over the corners
+  const double norm1 = vcl_abs( normal[0] ) + vcl_abs( normal[1] ) + vcl_abs( normal[2] );
   
-  // Some other necessary variables
-  long pixelCount = 0;
-  typename InputImageType::IndexType currentIndex;
-  typename InputImageType::PointType currentPoint;
-  typename InputImageType::SpacingType spacing = inputPtr->GetSpacing();
-      
-  // Current radius 
-  radius = m_RadiusFactor * currentScale;
+  if( norm1 == 0.0 )
+  {
+    encodedNormal.Fill( 0 );
+    return;
+  }
   
-  // Set the number of samples in  a circle depending on the current scale
-  samples = static_cast<unsigned int>( floor( 2.0 * vnl_math::pi * currentScale + 1.0 + 0.5 ) ); // +0.5 and floor used for rounding
-      
-  // Set the angle increment depending on the number of samples
-  angleInc = vnl_math::pi * 2.0 / static_cast<double>( samples ); 
+  double u = normal[0] / norm1;
+  double v = normal[1] / norm1;
   
-  // Set the size of the arrays for storing radial boundariness values depending on the number of samples
-  sinArray.SetSize( samples );
-  cosArray.SetSize( samples );
-  radialMedialness.SetSize( samples );
-  radialMedialnessWeights.SetSize( samples );
+  if( normal[2] < 0.0 )
+  {
+    const double foldedU = ( 1.0 - vcl_abs( v ) ) * ( ( u >= 0.0 )? 1.0 : -1.0 );
+    const double foldedV = ( 1.0 - vcl_abs( u ) ) * ( ( v >= 0.0 )? 1.0 : -1.0 );
+    u = foldedU;
+    v = foldedV;
+  }
   
-  // Initialize the arrays
-  radialMedialness.Fill( 0.0f );
-  radialMedialnessWeights.Fill( 0.0f );
+  const double maximum = static_cast<double>( itk::NumericTraits<short>::max() );
   
-  // Precalculate sin and cos values as these calculations are costly
+  encodedNormal[0] = static_cast<short>( vnl_math_rnd( u * maximum ) );
+  encodedNormal[1] = static_cast<short>( vnl_math_rnd( v * maximum ) );
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::DecodeNormal( const EncodedNormalPixelType& encodedNormal, VectorPixelType& normal )
+{
+  const double maximum = static_cast<double>( itk::NumericTraits<short>::max() );
   
-  angle = 0.0;
+  double u = encodedNormal[0] / maximum;
+  double v = encodedNormal[1] / maximum;
+  const double w = 1.0 - vcl_abs( u ) - vcl_abs( v );
   
-  for ( unsigned int i=0; i<samples; ++i )
+  if( w < 0.0 )
   {
-    sinArray[i] = sin( angle );
-    cosArray[i] = cos( angle );
-    angle += angleInc;
-  }     
+    const double unfoldedU = ( 1.0 - vcl_abs( v ) ) * ( ( u >= 0.0 )? 1.0 : -1.0 );
+    const double unfoldedV = ( 1.0 - vcl_abs( u ) ) * ( ( v >= 0.0 )? 1.0 : -1.0 );
+    u = unfoldedU;
+    v = unfoldedV;
+  }
+  
+  const double norm = vcl_sqrt( u * u + v * v + w * w );
+  
+  normal[0] = static_cast<ScalePixelType>( u / norm );
+  normal[1] = static_cast<ScalePixelType>( v / norm );
+  normal[2] = static_cast<ScalePixelType>( w / norm );
+}
 
-  // Get the minimum spacing
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+typename MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>::OutputImageRegionType
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GetScaleFiltersRegion( const ScalePixelType currentScale, const OutputImageRegionType& outputRegion ) const
+{
+  typename InputImageType::SpacingType spacing = this->GetInput()->GetSpacing();
   
   double minSpacing = itk::NumericTraits<double>::max();
   
@@ -234,206 +348,401 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
       minSpacing = spacing[i];
   }
   
-  // Create a list of boundary faces. This is to avoid bounds checking in the inner region
-    
-  typedef typename itk::NeighborhoodIterator<TInputImage>::RadiusType  RadiusType;
-  RadiusType faceListRadius;
-  typename RadiusType::SizeValueType faceListRadiusSize = 
-    static_cast<typename RadiusType::SizeValueType>( ceil( radius / minSpacing ) ) ;
+  // Same radius as the one used for the face list plus one pixel for linear interpolation
+  typename OutputImageRegionType::SizeType padding;
+  padding.Fill( static_cast<typename OutputImageRegionType::SizeValueType>
+    ( ceil( m_RadiusFactor * currentScale / minSpacing ) ) + 1 );
+  
+  OutputImageRegionType region = outputRegion;
+  region.PadByRadius( padding );
+  region.Crop( this->GetInput()->GetLargestPossibleRegion() );
+  
+  return region;
+}
 
-  faceListRadius.Fill( static_cast<typename RadiusType::SizeValueType>( faceListRadiusSize ) );
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GenerateDataAtScale( const ScalePixelType currentScale )
+{
+  itkDebugMacro(<< "MultiscaleMedialnessImageFilter generating data at scale " << currentScale);
   
-  typedef itk::NeighborhoodAlgorithm::
-    ImageBoundaryFacesCalculator<TInputImage>   FaceCalculatorType;
+  this->MultiThreadedGenerateDataAtScale( currentScale, false );
+}
+
+
+
+/** Here the mask is used in two ways : 
+ *  - Pixels outside the mask are directly not processed.
+ *  - At the time of calculating the radial medialness of a pixel, the contributions of pixels 
+ *    outside the mask are not considered
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::GenerateDataUsingMaskAtScale( const ScalePixelType currentScale )
+{
+  itkDebugMacro(<< "MultiscaleMedialnessImageFilter generating data using mask at scale " << currentScale);
   
-  FaceCalculatorType faceCalculator;
-  typename FaceCalculatorType::FaceListType            faceList;
-  typename FaceCalculatorType::FaceListType::iterator  fit;
-  bool checkBounds;
-      
-  faceList = faceCalculator( inputPtr, outputPtr->GetRequestedRegion(), faceListRadius );
-    
-  // Create the iterators
-  InputConstIterator it;
-  OutputIterator out;
-  ScalesImageIterator scalesIt;
-  GradientImageIterator gradientIt;
-  TensorImageIterator hessianIt;
-  VectorImageIterator normalsIt;
+  this->MultiThreadedGenerateDataAtScale( currentScale, true );
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::OrderScales( ScaleContainerType & scales )
+{
+  if( !this->m_OrderScalesByCoarsePass || scales.size() < 2 || scales.size() > 255 )
+    return;
   
-  // Iterate through the regions of the face list first
+  // Share the buffer of the input, so that the upstream pipeline is not updated again
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->Graft( this->GetInput() );
   
-  for( fit = faceList.begin(); fit != faceList.end(); ++fit )
+  typedef itk::ShrinkImageFilter<InputImageType,InputImageType>  ShrinkFilterType;
+  typename ShrinkFilterType::Pointer shrinker = ShrinkFilterType::New();
+  shrinker->SetInput( input );
+  shrinker->SetShrinkFactors( vnl_math_max( this->m_CoarsePassShrinkFactor, 1u ) );
+  shrinker->SetNumberOfThreads( this->GetNumberOfThreads() );
+  
+  // Same parameters as this filter, with only the scale indices as additional output
+  Pointer coarse = Self::New();
+  coarse->SetInput( shrinker->GetOutput() );
+  coarse->AddScales( scales );
+  coarse->SetDoNotComputeZeroPixels( this->m_DoNotComputeZeroPixels );
+  coarse->SetOutputThreshold( this->m_OutputThreshold );
+  coarse->SetSymmetryCoefficient( this->m_SymmetryCoefficient );
+  coarse->SetUseFastGaussianWeights( this->m_UseFastGaussianWeights );
+  coarse->SetRadiusFactor( this->m_RadiusFactor );
+  coarse->SetFilterByEigenValues( this->m_FilterByEigenValues );
+  coarse->SetEarlyRejection( this->m_EarlyRejection );
+  coarse->SetDynamicScheduling( this->m_DynamicScheduling );
+  coarse->ComputeNormalsOff();
+  coarse->StoreScaleIndicesOn();
+  coarse->SetNumberOfThreads( this->GetNumberOfThreads() );
+  coarse->Update();
+  
+  // Number of pixels at which each scale gives the maximum
+  std::vector< std::pair<unsigned long,unsigned int> > counts( scales.size() );
+  
+  for( unsigned int k=0; k<scales.size(); ++k )
+    counts[k] = std::make_pair( 0ul, k );
+  
+  itk::ImageRegionConstIterator<ScaleIndexImageType> it( coarse->GetOutputScaleIndices(),
+    coarse->GetOutputScaleIndices()->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
   {
-    it = InputConstIterator( inputPtr, *fit );
-    out =  OutputIterator( outputPtr, *fit );
-    scalesIt = ScalesImageIterator( scalesPtr, *fit );
-    gradientIt = GradientImageIterator( this->m_GradientMagnitudeGaussian->GetOutput(), *fit );
-    hessianIt = TensorImageIterator( this->m_HessianGaussian->GetOutput(), *fit );
-    normalsIt = VectorImageIterator( normalsPtr, *fit );
+    if( it.Get() )
+      ++counts[it.Get()-1].first;
+  }
   
-    if( fit == faceList.begin() ) // first face is the inner region so don't check bounds
-      checkBounds = false;
-    else
-      checkBounds = true;
+  // Most likely first, keeping the given order for the same number of pixels
+  for( unsigned int k=0; k<counts.size(); ++k )
+    counts[k].first = itk::NumericTraits<unsigned long>::max() - counts[k].first;
   
+  std::sort( counts.begin(), counts.end() );
   
-    // Now iterate in each region of the face list
-    
-    for ( it.GoToBegin(), out.GoToBegin(), gradientIt.GoToBegin(), hessianIt.GoToBegin(), scalesIt.GoToBegin(), normalsIt.GoToBegin();  
-      !out.IsAtEnd(); ++it, ++out, ++gradientIt, ++hessianIt, ++scalesIt, ++normalsIt )
-    {
-        currentIndex = out.GetIndex();
+  ScaleContainerType orderedScales( scales.size() );
+  
+  for( unsigned int k=0; k<counts.size(); ++k )
+  {
+    orderedScales[k] = scales[counts[k].second];
+    itkDebugMacro(<< "Scale " << orderedScales[k] << " wins at " 
+      << itk::NumericTraits<unsigned long>::max() - counts[k].first << " coarse pixels");
+  }
+  
+  scales = orderedScales;
+}
 
-        // Check that the hessian matrix is not a zero matrix. This avoids problems with NaN eigenvalues and eigenvectors
-        if( hessianIt.Get().GetTrace() < 1e-3 )
-          continue;
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ReleaseScaleFiltersOutputs()
+{
+  Superclass::ReleaseScaleFiltersOutputs();
+  
+  this->m_LocalMaximumBoundariness = 0;
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ComputeLocalMaximum( const ScaleImageType *image, const typename ScaleImageType::SizeType & radius, 
+  ScaleImageType *output )
+{
+  const typename ScaleImageType::SizeType size = image->GetBufferedRegion().GetSize();
+  const unsigned long numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  
+  if( !numberOfPixels )
+    return;
+  
+  std::copy( image->GetBufferPointer(), image->GetBufferPointer() + numberOfPixels, 
+    output->GetBufferPointer() );
+  
+  std::vector<ScalePixelType> line;
+  std::deque<unsigned long> window; // positions of the decreasing values in the window
+  
+  unsigned long stride = 1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    const unsigned long length = size[d];
+    const unsigned long lineRadius = radius[d];
+    const unsigned long numberOfLines = numberOfPixels / length;
     
-        // Calculate eigenvalues and eigenvectors at the current location
-        m_EigenAnalysis.ComputeEigenValuesAndVectors( hessianIt.Get(), eigenValues, eigenVectors );
+    line.resize( length );
     
-        // Recover eigenvectors from the matrix (first two rows)
-        for( unsigned int i=0; i<ImageDimension; ++i )
+    for( unsigned long l=0; l<numberOfLines; ++l )
+    {
+      ScalePixelType *start = output->GetBufferPointer() + ( l / stride ) * stride * length + l % stride;
+      
+      for( unsigned long i=0; i<length; ++i )
+        line[i] = start[i*stride];
+      
+      // Slide the window [i-lineRadius,i+lineRadius], its maximum is at the front
+      window.clear();
+      
+      for( unsigned long j=0; j<length+lineRadius; ++j )
+      {
+        if( j < length )
         {
-          firstEigenVector[i]  = eigenVectors( 0, i );
-          secondEigenVector[i] = eigenVectors( 1, i );
-          thirdEigenVector[i]  = eigenVectors( 2, i );
+          while( !window.empty() && line[window.back()] <= line[j] )
+            window.pop_back();
+          
+          window.push_back( j );
         }
-
-        // Do not process those pixels whose first two eigenvalues are not negative
         
-        if( m_FilterByEigenValues )
+        if( j >= lineRadius )
         {
-          if( eigenValues[0] >= 0.0f || eigenValues[1] >= 0.0f )
-            continue;
-        }
-        
-      
-        //////////////////////////
-        // Medialness calculation
-  
-        // Get the physical coordinates of the current index
-        inputPtr->TransformIndexToPhysicalPoint( currentIndex, currentPoint );
-        
-        calculatedSamples = 0;
-  
-        // Calculate points in a circle defined by the two eigenvectors with r = radius
-        for ( unsigned int i=0; i<samples; ++i )
-        {
-          // Evaluate and store the value of the gradient in a circle 
-          
-          for( unsigned int k=0; k<ImageDimension; ++k )
-            currentCirclePoint[k] = currentPoint[k] + radius * ( cosArray[i] * firstEigenVector[k] + sinArray[i] * secondEigenVector[k] );
-            
-          m_GradientInterpolator->ConvertPointToNearestIndex( currentCirclePoint, currentCircleIndex );
+          const unsigned long i = j - lineRadius;
           
-          if( checkBounds )
-          {
-            if( m_GradientInterpolator->IsInsideBuffer( currentCirclePoint ) )
-            {
-              radialMedialness[i] = m_GradientInterpolator->Evaluate( currentCirclePoint );
-              ++calculatedSamples;
-            }
-            else
-              radialMedialness[i] = 0.0;
-          }
+          while( window.front() + lineRadius < i )
+            window.pop_front();
           
-          else // checkBounds
-          {
-            radialMedialness[i] = m_GradientInterpolator->Evaluate( currentCirclePoint );
-            ++calculatedSamples;
-          }
-        
+          start[i*stride] = line[window.front()];
         }
+      }
+    }
+    
+    stride *= length;
+  }
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::MultiThreadedGenerateDataAtScale( const ScalePixelType currentScale, bool useMask )
+{
+  this->m_CurrentScale = currentScale;
+  this->m_UseMaskAtCurrentScale = useMask;
   
-        medialness = 0.0;
+  // Position plus one of the scale in the container, which may be processed in a different order
+  this->m_CurrentScaleIndex = 0;
   
-        if( calculatedSamples > 0 )
-        {
-          if( m_SymmetryCoefficient == 1.0 ) // speed-up calculations for the simplest (default) case
-          {
-            for ( unsigned int i=0; i<samples; ++i )
-              medialness += radialMedialness[i];  
-          }
-          
-          else
-          {
-            averageRadialMedialness = radialMedialness.one_norm() / static_cast<double>( calculatedSamples );
-              
-            for ( unsigned int i=0; i<samples; ++i )
-            {
-              if( !radialMedialness[i] )
-                continue;
-              
-              // Calculate b coefficients
-              weightExponent = ( 1.0 - radialMedialness[i] / averageRadialMedialness ) / m_SymmetryCoefficient;
-              radialMedialnessWeights[i] = exp( -0.5 * weightExponent * weightExponent );
-              medialness += radialMedialnessWeights[i] * radialMedialness[i];
-              //medialness += radial_medialness[i];
-            }
-          
-          }
+  if( this->m_StoreScaleIndices )
+  {
+    typename ScaleContainerType::const_iterator it = 
+      std::find( this->m_Scales.begin(), this->m_Scales.end(), currentScale );
+    this->m_CurrentScaleIndex = static_cast<ScaleIndexPixelType>( it - this->m_Scales.begin() + 1 );
+  }
   
-          medialness /= static_cast<float>( calculatedSamples );
-        
-        }
+  // Set the number of samples in  a circle depending on the current scale
+  unsigned int samples = static_cast<unsigned int>( floor( 2.0 * vnl_math::pi * currentScale + 1.0 + 0.5 ) ); // +0.5 and floor used for rounding
+      
+  // Precalculate sin and cos values as these calculations are costly. The sampler is shared by all threads
+  this->m_CircleSampler.SetNumberOfSamples( samples );
+  this->m_CircleSampler.SetImage( this->GetGradientMagnitudeImage() );
   
-                  
-        // Now calculate final medialness using an adaptative threshold that depends on the central boundariness
-        // (value of gradient at the central point). Vessel centers are supposed to have a low value of boundariness
-        // and thus this is penalized. A threshold is introduced here for noise etc.
-        
-        centralBoundariness = gradientIt.Get();
+  // Create one interpolator per thread, all of them pointing to the gradient magnitude at this scale
+  const int numberOfThreads = this->GetNumberOfThreads();
+  
+  this->m_GradientInterpolatorContainer.resize( numberOfThreads );
+  
+  for( int i=0; i<numberOfThreads; ++i )
+  {
+    if( this->m_GradientInterpolatorContainer[i].IsNull() )
+      this->m_GradientInterpolatorContainer[i] = InterpolatorType::New();
     
-        // Normalization factor. Here we have disabled AccrosScaleNormalization in the gradient
-        // calculation but now we multiply by sigma to get sigma-normalized derivatives (see Krissian)
-        medialness *= currentScale;
-        centralBoundariness *= currentScale;
-        
-        // !!! FUNCIONA MEJOR ASI, xq si no muchos valores dan negativo y los ponemos a cero, sin embargo pueden ser
-        // significativos. Tambin es una manera de que la intensidad de la respuesta sea mayor
-        if( medialness - centralBoundariness < m_OutputThreshold ) 
-          medialness = 0.0f;
+    this->m_GradientInterpolatorContainer[i]->SetInputImage( this->GetGradientMagnitudeImage() );
+  }
+  
+  // The medialness is a (weighted) mean of linearly interpolated gradient magnitudes, so it is 
+  // bounded by the maximum of the gradient magnitude buffer, or locally by the maximum in the 
+  // box of the circle plus one pixel for the interpolation
+  this->m_CurrentMaximumBoundariness = 0.0;
+  
+  if( this->m_EarlyRejection && this->m_LocalRejectionBound )
+  {
+    const ScaleImageType *gradientMagnitude = this->GetGradientMagnitudeImage();
     
-        if( medialness > out.Get() ) 
-        {
-          pixelCount++;
-          out.Set( medialness ); // store medialness value
-          scalesIt.Set( currentScale );
-          normalsIt.Set( thirdEigenVector );
-        }
+    if( this->m_LocalMaximumBoundariness.IsNull() || 
+      this->m_LocalMaximumBoundariness->GetBufferedRegion() != gradientMagnitude->GetBufferedRegion() )
+    {
+      this->m_LocalMaximumBoundariness = ScaleImageType::New();
+      this->m_LocalMaximumBoundariness->CopyInformation( gradientMagnitude );
+      this->m_LocalMaximumBoundariness->SetRegions( gradientMagnitude->GetBufferedRegion() );
+      this->m_LocalMaximumBoundariness->Allocate();
+    }
     
+    typename ScaleImageType::SizeType boundRadius;
+    
+    for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+      boundRadius[i] = static_cast<typename ScaleImageType::SizeValueType>
+        ( ceil( m_RadiusFactor * currentScale / gradientMagnitude->GetSpacing()[i] ) ) + 1;
     }
-        
+    
+    ComputeLocalMaximum( gradientMagnitude, boundRadius, this->m_LocalMaximumBoundariness );
+  }
+  else if( this->m_EarlyRejection )
+  {
+    itk::ImageRegionConstIterator<ScaleImageType> git( this->GetGradientMagnitudeImage(), 
+      this->GetGradientMagnitudeImage()->GetBufferedRegion() );
+    
+    for( git.GoToBegin(); !git.IsAtEnd(); ++git )
+    {
+      if( git.Get() > this->m_CurrentMaximumBoundariness )
+        this->m_CurrentMaximumBoundariness = git.Get();
+    }
+  }
+  
+  // With dynamic scheduling, the threads pull tiles of the current output region
+  if( this->m_DynamicScheduling )
+  {
+    if( this->m_TileScheduler.IsNull() )
+      this->m_TileScheduler = TileSchedulerType::New();
+    
+    this->m_TileScheduler->SetRegion( this->GetCurrentOutputRegion() );
+    this->m_TileScheduler->SetTileSize( this->m_TileSize );
+    this->m_TileScheduler->Initialize();
   }
   
+  // Split the output requested region between threads
+  ScaleThreadStruct str;
+  str.Filter = this;
   
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( this->ScaleThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+  
+  // The Hessian filter will allocate its output again when updated at the next scale
+  if( this->m_ReleaseHessianBetweenScales && !this->m_ScaleSpaceCascade && 
+    this->m_HessianGaussian.IsNotNull() )
+  {
+    this->m_HessianGaussian->GetOutput()->ReleaseData();
+  }
 }
 
 
 
-/** Here the mask is used in two ways : 
- *  - Pixels outside the mask are directly not processed.
- *  - At the time of calculating the radial medialness of a pixel, the contributions of pixels 
- *    outside the mask are not considered
+/**
+ *
  */
 template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
-void 
+ITK_THREAD_RETURN_TYPE
 MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
-::GenerateDataUsingMaskAtScale( const ScalePixelType currentScale )
+::ScaleThreaderCallback( void *arg )
 {
-  itkDebugMacro(<< "MultiscaleMedialnessImageFilter generating data at scale " << currentScale);
+  ScaleThreadStruct *str;
+  int total, threadId, threadCount;
+
+  threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  threadCount = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  str = (ScaleThreadStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  ScopedThreadAffinity affinity( threadId, str->Filter->GetThreadAffinity() );
+  
+  if( str->Filter->m_DynamicScheduling )
+  {
+    OutputImageRegionType tile;
+    
+    while( str->Filter->m_TileScheduler->GetNextTile( tile ) )
+      str->Filter->ThreadedGenerateDataAtScale( tile, threadId );
+      
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  // Execute the actual method with appropriate output region
+  // first find out how many pieces extent can be split into.
+  OutputImageRegionType splitRegion;
+  total = str->Filter->SplitRequestedRegion( threadId, threadCount, splitRegion );
+
+  if( threadId < total )
+    str->Filter->ThreadedGenerateDataAtScale( splitRegion, threadId );
+  
+  // else don't use this thread. Threads were not split conveniently.
 
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputImage, class TScalePixel, class TMaskImage>
+void 
+MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+::ThreadedGenerateDataAtScale( const OutputImageRegionType& outputRegionForThread, int threadId )
+{
+  const ScalePixelType currentScale = this->m_CurrentScale;
+  const ScaleIndexPixelType currentScaleIndex = this->m_CurrentScaleIndex;
+  const bool useMask = this->m_UseMaskAtCurrentScale;
+  
+  // Outputs that are produced
+  const bool storeScales = !this->m_StoreScaleIndices;
+  const bool storeScaleIndices = this->m_StoreScaleIndices;
+  const bool storeNormals = this->m_ComputeNormals && !this->m_EncodeNormals;
+  const bool storeEncodedNormals = this->m_ComputeNormals && this->m_EncodeNormals;
+  
   // Get the input and output pointers
   typename InputImageType::ConstPointer inputPtr  = this->GetInput();
   typename OutputImageType::Pointer outputPtr = this->GetOutput(0);
-  typename MaskImageType::ConstPointer maskPtr = this->GetMaskImage();
+  const PackedMaskType *packedMask = this->GetPackedMask();
   typename ScaleImageType::Pointer scalesPtr = dynamic_cast< ScaleImageType * >
     ( this->itk::ProcessObject::GetOutput(1) );
   typename VectorImageType::Pointer normalsPtr = dynamic_cast< VectorImageType * >
     ( this->itk::ProcessObject::GetOutput(2) );
-
-  m_GradientInterpolator->SetInputImage( this->m_GradientMagnitudeGaussian->GetOutput() );    
+  typename ScaleIndexImageType::Pointer scaleIndicesPtr = this->GetOutputScaleIndices();
+  typename EncodedNormalImageType::Pointer encodedNormalsPtr = this->GetOutputEncodedNormals();
+  
+  // Interpolator owned by this thread
+  InterpolatorType *gradientInterpolator = this->m_GradientInterpolatorContainer[threadId];
+  
+  // Upper bound of the medialness at this scale, with a margin for the rounding of the mean
+  const bool earlyRejection = this->m_EarlyRejection;
+  const bool localBound = earlyRejection && this->m_LocalRejectionBound;
+  const double boundFactor = currentScale * ( 1.0 + 1e-6 );
+  double maximumMedialness = this->m_CurrentMaximumBoundariness * boundFactor;
+  const bool testEigenValueSigns = earlyRejection && m_FilterByEigenValues && ImageDimension == 3;
+  double hessianNorm2, minorsSum, determinant, signTolerance;
   
   // Current eigenvalues, eigenvectors and related variables
   typename TensorScalePixelType::EigenVectorsMatrixType   eigenVectors; // current eigenvalues
@@ -445,62 +754,47 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
   
   // The estimated normal will be the third eigenvector but we need it in the form of an itk::Vector
   VectorPixelType thirdEigenVector;
+  EncodedNormalPixelType encodedNormal;
     
+  // Sin and cos values are precomputed for the current scale  
+  const CircleSamplerType & circleSampler = this->m_CircleSampler;
+  
   // Arrays for medialness calculations
-  itk::Array<double>  sinArray; // store sin values
-  itk::Array<double>  cosArray; // store cos values
   itk::Array<double>  radialMedialness; // this stores all values of gradient in the circle with given radius
   itk::Array<double>  radialMedialnessWeights;  // this stores all weighting factors in the circle with given radius
-    
+      
   // Variables involved in medialness calculation
   double radius; // current radius for medialness calculation
   unsigned int samples; // number of samples in a circle
-  unsigned int calculatedSamples;
-  double angleInc; // angle increment
-  double angle; // current angle and its sin and cos
+  unsigned int calculatedSamples; // number of calculated samples in a circle
   double medialness; // calculated medialness at current point and scale
   double weightExponent; // exponent of weighting factors for medialness calculations
   double averageRadialMedialness; // measure of average medialness without weighting
   double centralBoundariness; // boundariness at the current point
-  typename InterpolatorType::PointType currentCirclePoint;
+  typename InterpolatorType::ContinuousIndexType currentCircleContinuousIndex;
   typename InterpolatorType::IndexType currentCircleIndex;
   
   // Some other necessary variables
-  long pixelCount = 0;
   typename InputImageType::IndexType currentIndex;
   typename InputImageType::PointType currentPoint;
   typename InputImageType::SpacingType spacing = inputPtr->GetSpacing();
       
   // Current radius 
   radius = m_RadiusFactor * currentScale;
-    
-  // Set the number of samples in  a circle depending on the current scale
-  samples = static_cast<unsigned int>( floor( 2.0 * vnl_math::pi * currentScale + 1.0 + 0.5 ) ); // +0.5 and floor used for rounding
-    
-  // Set the angle increment depending on the number of samples
-  angleInc = vnl_math::pi * 2.0 / static_cast<double>( samples ); 
+  
+  samples = circleSampler.GetNumberOfSamples();
+  
+  // Samples of the circle at the current pixel, owned by this thread
+  CircleSampleSetType circleSamples( samples );
   
   // Set the size of the arrays for storing radial boundariness values depending on the number of samples
-  sinArray.SetSize( samples );
-  cosArray.SetSize( samples );
   radialMedialness.SetSize( samples );
   radialMedialnessWeights.SetSize( samples );
   
   // Initialize the arrays
   radialMedialness.Fill( 0.0f );
   radialMedialnessWeights.Fill( 0.0f );
-  
-  // Precalculate sin and cos values as these calculations are very costly
-  
-  angle = 0.0;
-  
-  for ( unsigned int i=0; i<samples; ++i )
-  {
-    sinArray[i] = sin( angle );
-    cosArray[i] = cos( angle );
-    angle += angleInc;
-  }     
-  
+
   // Get the minimum spacing
   
   double minSpacing = itk::NumericTraits<double>::max();
@@ -524,55 +818,114 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
     ImageBoundaryFacesCalculator<TInputImage>   FaceCalculatorType;
   
   FaceCalculatorType faceCalculator;
-  typename FaceCalculatorType::FaceListType faceList;
-  typename FaceCalculatorType::FaceListType::iterator fit;
+  typename FaceCalculatorType::FaceListType            faceList;
+  typename FaceCalculatorType::FaceListType::iterator  fit;
   bool checkBounds;
       
-  faceList = faceCalculator( inputPtr, outputPtr->GetRequestedRegion(), faceListRadius );
-  
+  faceList = faceCalculator( inputPtr, outputRegionForThread, faceListRadius );
+    
   // Create the iterators
-  InputConstIterator it;
   OutputIterator out;
-  MaskImageIterator maskIt;
-  ScalesImageIterator scalesIt;
   GradientImageIterator gradientIt;
+  GradientImageIterator boundIt;
   TensorImageIterator hessianIt;
-  VectorImageIterator normalsIt;
+  
+  // Pixels computed and skipped by this thread, added to the statistics of the scale at the end
+  unsigned long processedPixels = 0;
+  unsigned long zeroTracePixels = 0;
+  unsigned long eigenValuePixels = 0;
+  unsigned long intensityPixels = 0;
+  unsigned long boundPixels = 0;
   
   // Iterate through the regions of the face list first
   
   for( fit = faceList.begin(); fit != faceList.end(); ++fit )
   {
-    it = InputConstIterator( inputPtr, *fit );
     out =  OutputIterator( outputPtr, *fit );
-    maskIt = MaskImageIterator( maskPtr, *fit );
-    scalesIt = ScalesImageIterator( scalesPtr, *fit );
-    gradientIt = GradientImageIterator( this->m_GradientMagnitudeGaussian->GetOutput(), *fit );
-    hessianIt = TensorImageIterator( this->m_HessianGaussian->GetOutput(), *fit );
-    normalsIt = VectorImageIterator( normalsPtr, *fit );
+    gradientIt = GradientImageIterator( this->GetGradientMagnitudeImage(), *fit );
+    hessianIt = TensorImageIterator( this->GetHessianImage(), *fit );
+    
+    if( localBound )
+    {
+      boundIt = GradientImageIterator( this->m_LocalMaximumBoundariness, *fit );
+      boundIt.GoToBegin();
+    }
   
-    if( fit == faceList.begin() ) // first face is the inner region so don't check bound
+    if( fit == faceList.begin() ) // first face is the inner region so don't check bounds
       checkBounds = false;
     else
       checkBounds = true;
-
-
-    for ( it.GoToBegin(), out.GoToBegin(), maskIt.GoToBegin(), gradientIt.GoToBegin(), hessianIt.GoToBegin(),
-      scalesIt.GoToBegin(), normalsIt.GoToBegin();  !out.IsAtEnd(); ++it, ++out, ++maskIt, 
-      ++gradientIt, ++hessianIt, ++scalesIt, ++normalsIt )
+  
+  
+    // Now iterate in each region of the face list
+    
+    for ( out.GoToBegin(), gradientIt.GoToBegin(), hessianIt.GoToBegin();  
+      !out.IsAtEnd(); ++out, ++gradientIt, ++hessianIt )
     {
-        if( !maskIt.Get() )
-          continue; // process next pixel
+        if( localBound )
+        {
+          maximumMedialness = boundIt.Get() * boundFactor;
+          ++boundIt;
+        }
         
         currentIndex = out.GetIndex();
+        
+        // The mask is read from its packed bits
+        if( useMask && !packedMask->GetPixel( currentIndex ) )
+          continue; // process next pixel
+        
+        if( m_UseIntensityThreshold && inputPtr->GetPixel( currentIndex ) < m_IntensityThreshold )
+        {
+          ++intensityPixels;
+          continue;
+        }
 
         // Check that the hessian matrix is not a zero matrix. This avoids problems with NaN eigenvalues and eigenvectors
         if( hessianIt.Get().GetTrace() < 1e-3 )
+        {
+          ++zeroTracePixels;
           continue;
+        }
+        
+        // The output is either zero or the medialness, which is below the bound, and only replaces 
+        // a higher value. If the bound cannot pass the threshold or the current output, skip
+        if( earlyRejection )
+        {
+          const double boundariness = gradientIt.Get() * currentScale;
+          
+          if( maximumMedialness - boundariness < m_OutputThreshold || maximumMedialness <= out.Get() )
+          {
+            ++boundPixels;
+            continue;
+          }
+        }
+        
+        // The characteristic polynomial of the Hessian has coefficients 1, -trace, minorsSum and 
+        // -determinant. Its roots are real, so by Descartes' rule of signs and with a positive trace 
+        // it has two negative roots only if minorsSum < 0 and determinant > 0. The tolerance 
+        // relative to the norm leaves the borderline cases to the eigenanalysis
+        if( testEigenValueSigns )
+        {
+          const TensorScalePixelType & h = hessianIt.Get();
+          
+          hessianNorm2 = h(0,0)*h(0,0) + h(1,1)*h(1,1) + h(2,2)*h(2,2) + 
+            2.0 * ( h(0,1)*h(0,1) + h(0,2)*h(0,2) + h(1,2)*h(1,2) );
+          minorsSum = h(0,0)*h(1,1) - h(0,1)*h(0,1) + h(0,0)*h(2,2) - h(0,2)*h(0,2) + 
+            h(1,1)*h(2,2) - h(1,2)*h(1,2);
+          determinant = h(0,0) * ( h(1,1)*h(2,2) - h(1,2)*h(1,2) ) - 
+            h(0,1) * ( h(0,1)*h(2,2) - h(1,2)*h(0,2) ) + h(0,2) * ( h(0,1)*h(1,2) - h(1,1)*h(0,2) );
+          signTolerance = 1e-6 * hessianNorm2;
+          
+          if( minorsSum > signTolerance || determinant < -signTolerance * sqrt( hessianNorm2 ) )
+          {
+            ++eigenValuePixels;
+            continue;
+          }
+        }
     
         // Calculate eigenvalues and eigenvectors at the current location
-        m_EigenAnalysis.ComputeEigenValuesAndVectors( hessianIt.Get(), eigenValues, eigenVectors );
-
+        EigenAnalysisType::ComputeEigenAnalysis( hessianIt.Get(), eigenValues, eigenVectors );
+    
         // Recover eigenvectors from the matrix (first two rows)
         for( unsigned int i=0; i<ImageDimension; ++i )
         {
@@ -586,56 +939,51 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
         if( m_FilterByEigenValues )
         {
           if( eigenValues[0] >= 0.0f || eigenValues[1] >= 0.0f )
+          {
+            ++eigenValuePixels;
             continue;
+          }
         }
         
+        ++processedPixels;
+        
       
         //////////////////////////
         // Medialness calculation
-
+  
         // Get the physical coordinates of the current index
         inputPtr->TransformIndexToPhysicalPoint( currentIndex, currentPoint );
         
         calculatedSamples = 0;
-
-        // Calculate points in a circle defined by the two eigenvectors with r = radius
+  
+        // Calculate points in a circle defined by the two eigenvectors with r = radius, 
+        // all at once and in index space
+        circleSampler.Sample( currentPoint, radius, firstEigenVector, secondEigenVector, circleSamples );
+        
         for ( unsigned int i=0; i<samples; ++i )
         {
           // Evaluate and store the value of the gradient in a circle 
           
-          for( int k=0; k<ImageDimension; ++k )
-            currentCirclePoint[k] = currentPoint[k] + radius * ( cosArray[i] * firstEigenVector[k] + sinArray[i] * secondEigenVector[k] );
-            
-          m_GradientInterpolator->ConvertPointToNearestIndex( currentCirclePoint, currentCircleIndex );
-          
-          
-          if( checkBounds )
+          if( checkBounds && !circleSamples.IsInside( i ) )
           {
-            if( m_GradientInterpolator->IsInsideBuffer( currentCirclePoint ) && 
-              maskPtr->GetPixel( currentCircleIndex ) )
-            {
-              radialMedialness[i] = m_GradientInterpolator->Evaluate( currentCirclePoint );
-              ++calculatedSamples;
-            }
-            else
-              radialMedialness[i] = 0.0;
+            radialMedialness[i] = 0.0;
+            continue;
           }
           
-          else // checkBounds
+          circleSamples.GetContinuousIndex( i, currentCircleContinuousIndex );
+          gradientInterpolator->ConvertContinuousIndexToNearestIndex( currentCircleContinuousIndex, currentCircleIndex );
+          
+          if( !useMask || packedMask->GetPixel( currentCircleIndex ) )
           {
-            if( maskPtr->GetPixel( currentCircleIndex ) )
-            {
-              radialMedialness[i] = m_GradientInterpolator->Evaluate( currentCirclePoint );
-              ++calculatedSamples;
-            }
-            else
-              radialMedialness[i] = 0.0;
+            radialMedialness[i] = gradientInterpolator->EvaluateAtContinuousIndex( currentCircleContinuousIndex );
+            ++calculatedSamples;
           }
-          
+          else
+            radialMedialness[i] = 0.0;
         }
-        
+  
         medialness = 0.0;
-        
+  
         if( calculatedSamples > 0 )
         {
           if( m_SymmetryCoefficient == 1.0 ) // speed-up calculations for the simplest (default) case
@@ -655,7 +1003,8 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
               
               // Calculate b coefficients
               weightExponent = ( 1.0 - radialMedialness[i] / averageRadialMedialness ) / m_SymmetryCoefficient;
-              radialMedialnessWeights[i] = exp( -0.5 * weightExponent * weightExponent );
+              radialMedialnessWeights[i] = m_UseFastGaussianWeights ? GaussianWeightTable::Evaluate( weightExponent ) :
+                exp( -0.5 * weightExponent * weightExponent );
               medialness += radialMedialnessWeights[i] * radialMedialness[i];
               //medialness += radial_medialness[i];
             }
@@ -665,37 +1014,51 @@ MultiscaleMedialnessImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
           medialness /= static_cast<float>( calculatedSamples );
         
         }
-
-                
+  
+                  
         // Now calculate final medialness using an adaptative threshold that depends on the central boundariness
         // (value of gradient at the central point). Vessel centers are supposed to have a low value of boundariness
         // and thus this is penalized. A threshold is introduced here for noise etc.
         
         centralBoundariness = gradientIt.Get();
-
+    
         // Normalization factor. Here we have disabled AccrosScaleNormalization in the gradient
         // calculation but now we multiply by sigma to get sigma-normalized derivatives (see Krissian)
         medialness *= currentScale;
         centralBoundariness *= currentScale;
         
-        
         // !!! FUNCIONA MEJOR ASI, xq si no muchos valores dan negativo y los ponemos a cero, sin embargo pueden ser
         // significativos. Tambin es una manera de que la intensidad de la respuesta sea mayor
         if( medialness - centralBoundariness < m_OutputThreshold ) 
           medialness = 0.0f;
-
+    
+        // Each pixel belongs to the region of exactly one thread, so this update is race-free
         if( medialness > out.Get() ) 
         {
-          pixelCount++;
           out.Set( medialness ); // store medialness value
-          scalesIt.Set( currentScale );
-          normalsIt.Set( thirdEigenVector );
+          
+          if( storeScales )
+            scalesPtr->SetPixel( currentIndex, currentScale );
+          if( storeScaleIndices )
+            scaleIndicesPtr->SetPixel( currentIndex, currentScaleIndex );
+          
+          if( storeNormals )
+            normalsPtr->SetPixel( currentIndex, thirdEigenVector );
+          
+          if( storeEncodedNormals )
+          {
+            EncodeNormal( thirdEigenVector, encodedNormal );
+            encodedNormalsPtr->SetPixel( currentIndex, encodedNormal );
+          }
         }
+    
     }
+        
   }
+  
+  this->AddScalePixelCounts( processedPixels, zeroTracePixels, eigenValuePixels, intensityPixels, boundPixels );
 }
 
 } // end namespace ivan
 
 #endif
-
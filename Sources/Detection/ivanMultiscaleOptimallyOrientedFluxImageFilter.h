@@ -0,0 +1,164 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleOptimallyOrientedFluxImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: multiscale optimally oriented flux computed in the Fourier domain
+// Date: 2012/11/05
+
+#ifndef __ivanMultiscaleOptimallyOrientedFluxImageFilter_h
+#define __ivanMultiscaleOptimallyOrientedFluxImageFilter_h
+
+
+#include "ivanMultiscaleAnalysisImageFilter.h"
+#include "ivanOptimallyOrientedFluxImageFilter.h"
+
+
+namespace ivan
+{
+
+/** \class MultiscaleOptimallyOrientedFluxImageFilter
+ *  \brief Computes the maximum optimally oriented flux (OOF) response over a set of radii.
+ *
+ * Each scale of MultiscaleAnalysisImageFilter is used as the radius (in physical units) of the
+ * OOF sphere, and the response is computed for the whole region with OptimallyOrientedFluxImageFilter.
+ * The input is padded once for the largest radius, so its spectrum is computed once per 
+ * execution and reused for all the radii.
+ * No scale filters are used. The sigma of the gaussian is fixed for all the scales.
+ *
+ * If NormalizeAcrossScale is on, the flux at each radius is normalized by the area of the sphere.
+ *
+ * FusedScales is supported but not recommended, since the inverse transforms are computed
+ * for the whole image for every slab.
+ * 
+ * \sa OptimallyOrientedFluxImageFilter
+ * \ingroup IntensityImageFilters
+ */
+template <class TInputImage, class TOutputImage, 
+  class TEigenvalueFunctor = GeometricMeanTwoNegativeEigenvalueFunctor<double,3>,
+  class TScalePixel = double, class TMaskImage = TInputImage>
+class ITK_EXPORT MultiscaleOptimallyOrientedFluxImageFilter : 
+  public MultiscaleAnalysisImageFilter<TInputImage,TOutputImage,TScalePixel,TMaskImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MultiscaleOptimallyOrientedFluxImageFilter    Self;
+  typedef MultiscaleAnalysisImageFilter<TInputImage,
+    TOutputImage,TScalePixel,TMaskImage>                Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  /** Typedefs for image types. */
+  typedef TInputImage                                   InputImageType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef TMaskImage                                    MaskImageType;
+ 
+  typedef TScalePixel                                   ScalePixelType;
+  typedef typename OutputImageType::PixelType           OutputImagePixelType;
+  typedef typename OutputImageType::RegionType          OutputImageRegionType;
+
+  /** Scale image types. */
+  typedef typename Superclass::ScaleImageType           ScaleImageType;
+  
+  /** Runs of the mask. */
+  typedef typename Superclass::MaskRunLengthEncodingType  MaskRunLengthEncodingType;
+  typedef typename Superclass::MaskRunContainerType     MaskRunContainerType;
+  
+  /** Image dimension = 3. */
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension);
+  
+  /** Filter used for each radius. */
+  typedef OptimallyOrientedFluxImageFilter
+    <InputImageType,ScaleImageType,TEigenvalueFunctor>  FluxFilterType;
+  typedef typename FluxFilterType::EigenvalueFunctorType  EigenvalueFunctorType;
+      
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiscaleOptimallyOrientedFluxImageFilter, MultiscaleAnalysisImageFilter );
+  
+  /** Set/Get the sigma of the gaussian used for computing the gradient, in physical units. */
+  void SetSigma( double sigma )
+    { 
+      this->m_FluxFilter->SetSigma( sigma );
+      this->Modified();
+    }
+  double GetSigma() const
+    { return this->m_FluxFilter->GetSigma(); }
+    
+  /** Get the eigenvalue functor in order to set/get its properties. */
+  EigenvalueFunctorType * GetEigenvalueFunctor()
+    { return this->m_FluxFilter->GetEigenvalueFunctor(); }
+  
+protected:
+
+  MultiscaleOptimallyOrientedFluxImageFilter();
+  ~MultiscaleOptimallyOrientedFluxImageFilter() {};
+  
+  /** Reimplemented for releasing the spectrum after the execution. */
+  virtual void GenerateData();
+  
+  /** Compute the OOF response at the given radius and keep the maximum. */
+  virtual void GenerateDataAtScale( const ScalePixelType currentScale );
+  
+  /** Same but only in pixels inside the mask. */
+  virtual void GenerateDataUsingMaskAtScale( const ScalePixelType currentScale );
+  
+  /** Update of the flux filter and the maximum over the current output region. */
+  virtual void UpdateMaximumResponseAtScale( const ScalePixelType currentScale, bool useMask );
+    
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  MultiscaleOptimallyOrientedFluxImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+protected:
+
+  typename FluxFilterType::Pointer    m_FluxFilter;
+};
+  
+} // end namespace ivan
+  
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_MultiscaleOptimallyOrientedFluxImageFilter(_, EXPORT, x, y) namespace ivan { \
+  _(2(class EXPORT MultiscaleOptimallyOrientedFluxImageFilter< ITK_TEMPLATE_2 x >)) \
+  namespace Templates { typedef MultiscaleOptimallyOrientedFluxImageFilter< ITK_TEMPLATE_2 x > \
+                                                  MultiscaleOptimallyOrientedFluxImageFilter##y; } \
+  }
+
+#if ITK_TEMPLATE_EXPLICIT
+# include "Templates/ivanMultiscaleOptimallyOrientedFluxImageFilter+-.h"
+#endif
+
+#if ITK_TEMPLATE_TXX
+# include "ivanMultiscaleOptimallyOrientedFluxImageFilter.hxx"
+#endif
+  
+#endif
@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleOptimallyOrientedFluxImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: multiscale optimally oriented flux computed in the Fourier domain
+// Date: 2012/11/05
+
+#ifndef __ivanMultiscaleOptimallyOrientedFluxImageFilter_hxx
+#define __ivanMultiscaleOptimallyOrientedFluxImageFilter_hxx
+
+#include "ivanMultiscaleOptimallyOrientedFluxImageFilter.h"
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::MultiscaleOptimallyOrientedFluxImageFilter()
+{
+  this->m_FluxFilter = FluxFilterType::New();
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+void
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::GenerateData()
+{
+  Superclass::GenerateData();
+  
+  // The spectrum is only valid for the input of this execution
+  this->m_FluxFilter->SetInput( 0 );
+  this->m_FluxFilter->ReleaseSpectrum();
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+void
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::GenerateDataAtScale( const ScalePixelType currentScale )
+{
+  this->UpdateMaximumResponseAtScale( currentScale, false );
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+void
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::GenerateDataUsingMaskAtScale( const ScalePixelType currentScale )
+{
+  this->UpdateMaximumResponseAtScale( currentScale, true );
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+void
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::UpdateMaximumResponseAtScale( const ScalePixelType currentScale, bool useMask )
+{
+  itkDebugMacro(<<"Computing OOF at radius " << currentScale << " in region " << this->m_CurrentOutputRegion);
+  
+  // The flux filter works on the (padded) buffered input
+  this->m_FluxFilter->SetInput( this->m_ScaleFiltersInput );
+  this->m_FluxFilter->SetRadius( currentScale );
+  this->m_FluxFilter->SetMaximumRadius( this->GetMaximumScale() );
+  this->m_FluxFilter->SetNormalizeAcrossScale( this->m_NormalizeAcrossScale );
+  this->m_FluxFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->m_FluxFilter->GetOutput()->SetRequestedRegion( this->m_CurrentOutputRegion );
+  this->m_FluxFilter->Update();
+  
+  const MaskRunLengthEncodingType *maskRuns = this->GetMaskRuns();
+  
+  if( useMask && maskRuns )
+  {
+    // Visit only the runs of mask pixels, which are contiguous in memory
+    const ScaleImageType *responseImage = this->m_FluxFilter->GetOutput();
+    OutputImageType *outputImage = this->GetOutput();
+    ScaleImageType *scalesImage = this->GetOutputScales();
+    
+    MaskRunContainerType runs;
+    maskRuns->GetRunsInRegion( this->m_CurrentOutputRegion, runs );
+    
+    for( typename MaskRunContainerType::const_iterator runIt = runs.begin(); runIt != runs.end(); ++runIt )
+    {
+      const ScalePixelType *responsePixel = 
+        responseImage->GetBufferPointer() + responseImage->ComputeOffset( runIt->Index );
+      OutputImagePixelType *outputPixel = 
+        outputImage->GetBufferPointer() + outputImage->ComputeOffset( runIt->Index );
+      ScalePixelType *scalesPixel = scalesImage->GetBufferPointer() + scalesImage->ComputeOffset( runIt->Index );
+      
+      for( unsigned long k=0; k<runIt->Length; ++k )
+      {
+        const OutputImagePixelType response = static_cast<OutputImagePixelType>( responsePixel[k] );
+        
+        if( response > outputPixel[k] )
+        {
+          outputPixel[k] = response;
+          scalesPixel[k] = currentScale;
+        }
+      }
+    }
+    
+    return;
+  }
+  
+  typedef itk::ImageRegionConstIterator<ScaleImageType>   ResponseIteratorType;
+  typedef itk::ImageRegionIterator<OutputImageType>       OutputIteratorType;
+  typedef itk::ImageRegionIterator<ScaleImageType>        ScalesIteratorType;
+  
+  ResponseIteratorType rit( this->m_FluxFilter->GetOutput(), this->m_CurrentOutputRegion );
+  OutputIteratorType   oit( this->GetOutput(), this->m_CurrentOutputRegion );
+  ScalesIteratorType   sit( this->GetOutputScales(), this->m_CurrentOutputRegion );
+  
+  for( rit.GoToBegin(), oit.GoToBegin(), sit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++oit, ++sit )
+  {
+    const OutputImagePixelType response = static_cast<OutputImagePixelType>( rit.Get() );
+    
+    if( response > oit.Get() )
+    {
+      oit.Set( response );
+      sit.Set( currentScale );
+    }
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor, class TScalePixel, class TMaskImage>
+void
+MultiscaleOptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor,TScalePixel,TMaskImage>
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FluxFilter: " << this->m_FluxFilter << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
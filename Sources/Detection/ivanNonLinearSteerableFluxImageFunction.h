@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanNonLinearSteerableFluxImageFunction_h
 #define __ivanNonLinearSteerableFluxImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanFluxBasedVesselnessImageFunction.h"
 
 
@@ -135,7 +136,7 @@ private:
                                                   NonLinearSteerableFluxImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanNonLinearSteerableFluxImageFunction+-.h"
 #endif
 
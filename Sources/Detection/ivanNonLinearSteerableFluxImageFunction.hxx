@@ -123,29 +123,21 @@ NonLinearSteerableFluxImageFunction<TInputImage,TOutput>
   OutputType firstFluxComponents[2], secondFluxComponents[2];
   OutputType firstFlux, secondFlux;
   
-  typedef typename GradientFunctionType::OutputType VectorType;
-  VectorType gradientVector;
+  double derivative;
   
   // Get the physical coordinates of the current index
   this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( cindex, currentPoint );
     
-  // Compute fluxes. We use as shift s = m_Sigma * m_RadiusFactor 
+  // Compute fluxes. We use as shift s = m_Sigma * m_RadiusFactor. The flux is the dot product 
+  // of the surface vector and the gradient vector, that is, the derivative along the eigenvector
+  // (steered from the gradient basis if UseGradientImage is on). The surface vector is in this 
+  // case one of the eigenvectors but in the opposite direction for the positive shift.
   
   for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
     currentPointShifted[i] = currentPoint[i] + this->m_RadiusFactor * this->m_Sigma * firstEigenVector[i];
   
-  if( this->m_GradientFunction->IsInsideBuffer( currentPointShifted ) )
-  {
-    firstFluxComponents[0] = 0.0;
-    gradientVector = this->m_GradientFunction->Evaluate( currentPointShifted );
-    
-    // The flux is the dot product of the surface vector and the gradient vector. The surface
-    // vector is in this case one of the eigenvectors but in the opposite direction
-    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
-      firstFluxComponents[0] -= gradientVector[i] * firstEigenVector[i]; // use minus for inward direction
-  }
-  else
-    firstFluxComponents[0] = 0.0;
+  this->EvaluateDirectionalDerivative( currentPointShifted, firstEigenVector, derivative );
+  firstFluxComponents[0] = -derivative; // use minus for inward direction
   
   if( firstFluxComponents[0] < 0.0 ) // only take the positive part of the flux
     firstFluxComponents[0] = 0.0;
@@ -155,16 +147,8 @@ NonLinearSteerableFluxImageFunction<TInputImage,TOutput>
   for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
     currentPointShifted[i] = currentPoint[i] - this->m_RadiusFactor * this->m_Sigma * firstEigenVector[i];
   
-  if( this->m_GradientFunction->IsInsideBuffer( currentPointShifted ) )
-  {
-    firstFluxComponents[1] = 0.0;
-    gradientVector = this->m_GradientFunction->Evaluate( currentPointShifted );
-    
-    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
-      firstFluxComponents[1] += gradientVector[i] * firstEigenVector[i];
-  }
-  else
-    firstFluxComponents[1] = 0.0;
+  this->EvaluateDirectionalDerivative( currentPointShifted, firstEigenVector, derivative );
+  firstFluxComponents[1] = derivative;
   
   if( firstFluxComponents[1] < 0.0 ) // only take the positive part of the flux
     firstFluxComponents[1] = 0.0;
@@ -176,16 +160,8 @@ NonLinearSteerableFluxImageFunction<TInputImage,TOutput>
   for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
     currentPointShifted[i] = currentPoint[i] + this->m_RadiusFactor * this->m_Sigma * secondEigenVector[i];
   
-  if( this->m_GradientFunction->IsInsideBuffer( currentPointShifted ) )
-  {
-    secondFluxComponents[0] = 0.0;
-    gradientVector = this->m_GradientFunction->Evaluate( currentPointShifted );
-    
-    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
-      secondFluxComponents[0] -= gradientVector[i] * secondEigenVector[i]; // use minus for inward direction
-  }
-  else
-    secondFluxComponents[0] = 0.0;
+  this->EvaluateDirectionalDerivative( currentPointShifted, secondEigenVector, derivative );
+  secondFluxComponents[0] = -derivative; // use minus for inward direction
   
   if( secondFluxComponents[0] < 0.0 ) // only take the positive part of the flux
     secondFluxComponents[0] = 0.0;
@@ -195,16 +171,8 @@ NonLinearSteerableFluxImageFunction<TInputImage,TOutput>
   for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
     currentPointShifted[i] = currentPoint[i] - this->m_RadiusFactor * this->m_Sigma * secondEigenVector[i];
   
-  if( this->m_GradientFunction->IsInsideBuffer( currentPointShifted ) )
-  {
-    secondFluxComponents[1] = 0.0;
-    gradientVector = this->m_GradientFunction->Evaluate( currentPointShifted );
-    
-    for( unsigned int i=0; i<TInputImage::ImageDimension; ++i )
-      secondFluxComponents[1] += gradientVector[i] * secondEigenVector[i];
-  }
-  else
-    secondFluxComponents[1] = 0.0;
+  this->EvaluateDirectionalDerivative( currentPointShifted, secondEigenVector, derivative );
+  secondFluxComponents[1] = derivative;
   
   if( secondFluxComponents[1] < 0.0 ) // only take the positive part of the flux
     secondFluxComponents[1] = 0.0;
@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanObjectnessMeasureImageFunction_h
 #define __ivanObjectnessMeasureImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianOnlyBasedVesselnessImageFunction.h"
 
 
@@ -77,6 +78,7 @@ public:
     <TInputImage,TCoordRep>                          HessianFunctionType;
   typedef typename HessianFunctionType::Pointer      HessianFunctionPointer;
   typedef typename HessianFunctionType::TensorType   HessianTensorType;
+  typedef typename Superclass::EigenValuesArrayType  EigenValuesArrayType;
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType InterpolationModeType;
@@ -107,6 +109,9 @@ public:
   itkSetMacro( ObjectDimension, unsigned int );
   itkGetConstMacro( ObjectDimension, unsigned int );
   
+  /** Evaluate vesselness from the eigenvalues of the Hessian matrix, in ascending order. */
+  virtual OutputType EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const;
+  
 protected:
 
   ObjectnessMeasureImageFunction();
@@ -145,7 +150,7 @@ private:
                                                   ObjectnessMeasureImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanObjectnessMeasureImageFunction+-.h"
 #endif
 
@@ -32,7 +32,7 @@ SUCH DAMAGE.
 
 #include "ivanObjectnessMeasureImageFunction.h"
 
-#include "itkSymmetricEigenAnalysis.h"
+#include "ivanSymmetricEigenSolver.h"
 
 
 namespace ivan
@@ -78,31 +78,23 @@ typename ObjectnessMeasureImageFunction<TInputImage,TOutput,TCoordRep>::OutputTy
 ObjectnessMeasureImageFunction<TInputImage,TOutput,TCoordRep>
 ::EvaluateVesselness( const HessianTensorType & hessian ) const
 {
-  typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
   EigenValuesArrayType   eigenValues;
   
   // Calculate eigenvalues of Hessian matrix at the current location
-  // We cannot use SymmetricSecondRankTensor::ComputeEigenValues() since currently it computes
-  // eigenvalues ordering by value and not by absolute value which is required by this filter
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
   
-  //hessian.ComputeEigenValues( eigenValues );
-  
-  typedef typename HessianTensorType::SymmetricEigenAnalysisType EigenAnalysisType;
-  typedef typename HessianTensorType::MatrixType                 MatrixType;
-    
-  EigenAnalysisType eigenAnalysis = EigenAnalysisType( HessianTensorType::Dimension );
-    
-  MatrixType hessianMatrix;
-  for( unsigned int row=0; row < HessianTensorType::Dimension; row++ )
-  {
-    for( unsigned int col=0; col < HessianTensorType::Dimension; col++ )
-    {
-      hessianMatrix[row][col] = hessian(row,col);
-    }
-  }
-  
-  eigenAnalysis.SetOrderEigenMagnitudes( true );
-  eigenAnalysis.ComputeEigenValues( hessianMatrix, eigenValues );     
+  return this->EvaluateVesselnessFromEigenValues( eigenValues );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename ObjectnessMeasureImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+ObjectnessMeasureImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & ascendingEigenValues ) const
+{
+  // This measure requires the eigenvalues ordered by magnitude and not by value
+  EigenValuesArrayType eigenValues = ascendingEigenValues;
+  SymmetricEigenSolver<HessianTensorType>::OrderEigenValuesByMagnitude( eigenValues );
   
   //if( vnl_math_abs( eigenValues[2] ) < 1e-3 )
     //return 0.0;
@@ -159,7 +151,7 @@ ObjectnessMeasureImageFunction<TInputImage,TOutput,TCoordRep>
     double frobeniusNormSquared = 0.0;
     for (unsigned int i=0; i<ImageDimension; i++)
     {
-      frobeniusNormSquared += vnl_math_sqr(sortedAbsEigenValues[i]);
+      frobeniusNormSquared += vnl_math_sqr(eigenValues[i]);
     }
     objectnessMeasure *= 1.0 - vcl_exp(- 0.5 * frobeniusNormSquared / vnl_math_sqr(m_Gamma));
   }
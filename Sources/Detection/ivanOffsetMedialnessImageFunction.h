@@ -30,13 +30,23 @@ SUCH DAMAGE.
 #ifndef __ivanOffsetMedialnessImageFunction_h
 #define __ivanOffsetMedialnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianBasedVesselnessImageFunction.h"
 #include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanScratchArray.h"
+#include "ivanCircleSampler.h"
+#include "ivanBufferInteriorRegion.h"
+#include "ivanGaussianWeightTable.h"
 
 #include "itkDiscreteGradientMagnitudeGaussianImageFunction.h"
+#include "itkGradientRecursiveGaussianImageFilter.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
+#include "itkCovariantVector.h"
 #include "itkArray.h"
 #include "itkVector.h"
 
+#include <vector>
+
 
 namespace ivan
 {
@@ -54,6 +64,13 @@ namespace ivan
  * lowest eigenvalued eigenvector of the Hessian matrix. Then, the section plane is formed by the 
  * other two eigenvalues.
  * 
+ * Evaluation at integer indices may optionally use precomputed tables of voxel offsets for the
+ * circle samples, indexed by a quantized section normal (see UseQuantizedRingOffsets).
+ *
+ * Initialize() also computes the centers whose circle lies inside the buffered region of the
+ * image. The samples of these circles are not tested, and the gradient image is interpolated
+ * without bounds checks. The checked path is only used near the borders.
+ *
  * This class is templated over the input image type.
  *
  * The Initialize() method must be called after setting the parameters and before
@@ -85,6 +102,7 @@ public:
   typedef typename Superclass::IndexType             IndexType;
   typedef typename Superclass::ContinuousIndexType   ContinuousIndexType;
   typedef typename Superclass::PointType             PointType;
+  typedef typename InputImageType::OffsetType        OffsetType;
     
   /** Types for Hessian function/matrix. */
   typedef ivan::DiscreteHessianGaussianImageFunction
@@ -100,12 +118,34 @@ public:
   typedef ivan::DiscreteGradientGaussianImageFunction
     <TInputImage,TOutput>                                      GradientFunctionType;
   typedef typename GradientFunctionType::Pointer               GradientFunctionPointer;
+  typedef typename GradientFunctionType::DerivativeCacheType   GradientCacheType;
+  
+  /** Types for the precomputed gradient image. */
+  typedef itk::CovariantVector<TOutput,
+    InputImageType::ImageDimension>                            GradientPixelType;
+  typedef itk::Image<GradientPixelType,
+    InputImageType::ImageDimension>                            GradientImageType;
+  typedef typename GradientImageType::Pointer                  GradientImagePointer;
+  typedef itk::VectorLinearInterpolateImageFunction
+    <GradientImageType,TCoordRep>                              GradientInterpolatorType;
+  typedef typename GradientInterpolatorType::Pointer           GradientInterpolatorPointer;
     
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType           InterpolationModeType;
     
   typedef itk::Vector<double,InputImageType::ImageDimension>   VectorType;
+  
+  /** Temporary storage of the radial values during evaluation. Radial resolutions up to 
+   * the capacity (adaptative sampling up to sigma ~20) do not allocate memory. */
+  typedef ScratchArray<double,128>                             RadialValuesArrayType;
+  
+  /** Generation of the circle samples. */
+  typedef CircleSampler<InputImageType,TCoordRep>              CircleSamplerType;
+  typedef typename CircleSamplerType::SampleSet                CircleSampleSetType;
+  
+  /** Centers whose circle samples need no bounds checks. */
+  typedef BufferInteriorRegion<InputImageType,TCoordRep>       RingInteriorType;
     
   enum GradientImageFunctionType
   {
@@ -129,6 +169,13 @@ public:
   itkSetMacro( SymmetryCoefficient, double );
   itkGetConstMacro( SymmetryCoefficient, double );
   
+  /** Evaluate the symmetry weights from a precomputed table instead of
+    * calling exp() for every radial sample. The relative error is below
+    * GaussianWeightTable::GetMaximumRelativeError(). Off by default. */
+  itkSetMacro( UseFastGaussianWeights, bool );
+  itkGetConstMacro( UseFastGaussianWeights, bool );
+  itkBooleanMacro( UseFastGaussianWeights );
+  
   /** Set/Get the radius at which offset values are calculated. */
   itkSetMacro( Radius, double );
   itkGetConstMacro( Radius, double );
@@ -166,6 +213,40 @@ public:
     * smaller than the one used to calculate the Hessian. */
   virtual void SetGradientSigma( double gradientSigma );
   
+  /** Set/Get a cache for gradient vectors that may be shared with other functions operating on the 
+    * same image with the same gradient parameters (except the scale). */
+  virtual void SetGradientCache( GradientCacheType *cache )
+    { m_GradientFunction->SetDerivativeCache( cache ); }
+  virtual GradientCacheType * GetGradientCache()
+    { return m_GradientFunction->GetDerivativeCache(); }
+  
+  /** Set/Get the flag for using a precomputed gradient image. If set, Initialize() computes the 
+    * gradient of the whole image once with recursive Gaussian filters (with GradientSigma) and 
+    * circle samples are trilinear interpolations in this image, instead of Gaussian derivative 
+    * convolutions at each neighbour. Gradient magnitudes are then the norm of the interpolated 
+    * gradient. This is much faster for whole-image evaluation but needs a vector image of the 
+    * size of the input (see GetGradientImageMemorySize()). Default is false. */
+  itkSetMacro( UseGradientImage, bool );
+  itkGetConstMacro( UseGradientImage, bool );
+  itkBooleanMacro( UseGradientImage );
+  
+  /** Set/Get the precomputed gradient image. A gradient image computed by another function with 
+    * the same input and GradientSigma may be set here so that it is shared. If not set, it is 
+    * computed in Initialize() when UseGradientImage is on. */
+  virtual void SetGradientImage( GradientImageType *image );
+  itkGetObjectMacro( GradientImage, GradientImageType );
+  
+  /** Memory used by the gradient image in bytes (zero if there is no gradient image). */
+  unsigned long GetGradientImageMemorySize() const;
+  
+  /** Set/Get the number of circle samples ahead whose neighborhoods are prefetched while 
+    * evaluating each sample (see CircleSampler::SetPrefetchDistance()). This helps when the 
+    * image does not fit in the cache. Zero disables prefetching. Default is 0. */
+  void SetPrefetchDistance( unsigned int distance )
+    { this->m_CircleSampler.SetPrefetchDistance( distance ); }
+  unsigned int GetPrefetchDistance() const
+    { return this->m_CircleSampler.GetPrefetchDistance(); }
+  
   /** Set the scale, that is, the standard deviation of the Gaussian kernel. Reimplemented to pass
     * the scale to the gradient function too. */
   virtual void SetSigma( double sigma );
@@ -176,6 +257,31 @@ public:
    * SetInputImage again to update cached values. */
   virtual void SetInputImage( const InputImageType * ptr );
   
+  /** Set/Get the flag for using quantized ring offsets. If set, evaluation at integer indices 
+    * (as done by EvaluateAtIndex()) does not sample the circle. Instead, the section normal is 
+    * quantized to the nearest direction of a fixed set on the hemisphere and the samples are taken 
+    * at the voxel offsets precomputed for that direction, the current radius and the radial 
+    * resolution. This avoids the trigonometry, the plane basis and the transformation of each 
+    * sample, at the price of rounding the circle to the voxel grid and the normal to the nearest 
+    * direction. The tables are built by Initialize(); if the radius or the radial resolution 
+    * change afterwards, the exact sampling is used until Initialize() is called again. 
+    * Only 3D images are supported. Default is false. */
+  itkSetMacro( UseQuantizedRingOffsets, bool );
+  itkGetConstMacro( UseQuantizedRingOffsets, bool );
+  itkBooleanMacro( UseQuantizedRingOffsets );
+  
+  /** Set/Get the resolution of the set of directions for the quantized ring offsets. Directions are
+    * the cells of an octahedral map of the hemisphere of Resolution x Resolution cells, which gives
+    * about Resolution^2/2 distinct directions. Default is 32 (about 512 directions). */
+  itkSetClampMacro( RingDirectionResolution, unsigned int, 1, 128 );
+  itkGetConstMacro( RingDirectionResolution, unsigned int );
+  
+  /** Get the number of directions of the current ring offset tables (zero if not built). */
+  unsigned int GetNumberOfRingDirections() const;
+  
+  /** Memory used by the ring offset tables in bytes. */
+  unsigned long GetRingOffsetsMemorySize() const;
+  
   /** Reimplemented to initialize the gradient function also. */
   virtual void Initialize();
 
@@ -187,10 +293,43 @@ protected:
   /** Precompute values that depends on the radial resolution such as sin or cos values. */
   virtual void ComputeIntervals();
   
+  /** Compute the gradient image of the input with GradientSigma. */
+  virtual void ComputeGradientImage();
+  
+  /** Evaluate the gradient or its magnitude at the given continuous index, with the gradient 
+    * function or from the gradient image. */
+  void EvaluateGradient( const ContinuousIndexType & cindex, VectorType & gradient ) const;
+  double EvaluateGradientMagnitude( const ContinuousIndexType & cindex ) const;
+  
+  /** Same as above at an integer index, without interpolation. */
+  void EvaluateGradientAtIndex( const IndexType & index, VectorType & gradient ) const;
+  
+  /** Evaluate the gradient from the gradient image by linear interpolation without bounds 
+    * checks. The continuous index must be at least one pixel inside the buffered region. */
+  void EvaluateGradientInside( const ContinuousIndexType & cindex, VectorType & gradient ) const;
+  double EvaluateGradientMagnitudeAtIndex( const IndexType & index ) const;
+  
+  /** Build the ring offset tables for the current radius, radial resolution and input image. */
+  virtual void ComputeRingOffsets();
+  
+  /** Index of the quantized direction of the given normal in the ring offset tables. */
+  unsigned int ComputeRingDirectionIndex( const VectorType & normal ) const;
+  
+  /** Returns true if the Hessian is close to the zero matrix, which gives undefined eigenvectors. */
+  static bool IsZeroHessian( const HessianTensorType & hessian );
+  
+  /** Sum the radial values with the symmetry weights and normalize by the calculated samples. */
+  OutputType CombineRadialValues( const RadialValuesArrayType & radialMedialness, 
+    unsigned int calculatedSamples ) const;
+  
   /** Evaluate vesselness given Hessian. This must be reimplemented by subclasses. */
   virtual OutputType EvaluateVesselnessAtContinuousIndex( const HessianTensorType & hessian,
     const ContinuousIndexType & cindex ) const;
   
+  /** Reimplemented to use the quantized ring offsets if enabled. */
+  virtual OutputType EvaluateVesselnessAtIndex( const HessianTensorType & hessian,
+    const IndexType & index ) const;
+  
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -210,6 +349,12 @@ private:
   /** Type of gradient function used to calculate gradient. */
   GradientImageFunctionType         m_GradientImageFunctionType;
   
+  /** Precomputed gradient image, its sigma and its interpolator. */
+  bool                              m_UseGradientImage;
+  GradientImagePointer              m_GradientImage;
+  double                            m_GradientImageSigma;
+  GradientInterpolatorPointer       m_GradientInterpolator;
+  
   /** Sigma used for the gradient calculations. In general this sigma should be smaller than the 
     * sigma used for the Hessian. By default is 1.0. */
   double               m_GradientSigma;
@@ -217,6 +362,9 @@ private:
   /** Coefficient for taking into account the simmetry in the medialness. */
   double               m_SymmetryCoefficient;
   
+  /** Use the tabulated Gaussian for the symmetry weights. */
+  bool                 m_UseFastGaussianWeights;
+  
   /** Radius at which offset values are calculated. This may not need to coincide with the scale, since
     * the later is used as the sigma/scale for the gradient calcuations. The theory says that the
     * radius should be sqrt(3) times the scale for optimal detection in circular straight tubes. */
@@ -238,13 +386,27 @@ private:
   bool                 m_AutoComputeSectionNormal;
   
   /** Section normal. If not provided, the section plane will be calculated using the eigenvectors
-    * of the local Hessian matrix. The variable is mutable since, for convenience, it can be changed 
-    * in const methods. */
-  mutable VectorType   m_SectionNormal;  
+    * of the local Hessian matrix. Normals computed during evaluation are not stored here, so that
+    * the function can be shared by several threads. */
+  VectorType           m_SectionNormal;  
+  
+  /** Circle sampler, with cached angular values. */
+  CircleSamplerType    m_CircleSampler;
+  
+  /** Interior of the input image for the radius of the last Initialize(), with the margin of 
+    * the interpolation of the gradient image if it is used. */
+  RingInteriorType     m_RingInterior;
   
-  /** Cached angular values. */
-  itk::Array<double>   m_CosArray;
-  itk::Array<double>   m_SinArray;
+  /** Quantized ring offsets. For each direction, RadialResolution consecutive voxel offsets and 
+    * the radial unit vectors of the samples, along with the radius and resolution they were 
+    * computed for and the maximum absolute offset in each dimension. */
+  bool                     m_UseQuantizedRingOffsets;
+  unsigned int             m_RingDirectionResolution;
+  std::vector<OffsetType>  m_RingOffsets;
+  std::vector<VectorType>  m_RingDirections;
+  double                   m_RingOffsetsRadius;
+  unsigned int             m_RingOffsetsRadialResolution;
+  OffsetType               m_RingOffsetsExtent;
     
   /** Difference threshold. The difference between the medialness and boundariness must be greater than
     * this value. By default zero. The result is that areas surrounding the medial line result in low
@@ -261,7 +423,7 @@ private:
                                                   OffsetMedialnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanOffsetMedialnessImageFunction+-.h"
 #endif
 
@@ -32,9 +32,12 @@ SUCH DAMAGE.
 
 #include "ivanOffsetMedialnessImageFunction.h"
 #include "ivanGlobals.h"
+#include "ivanSymmetricEigenSolver.h"
 
 #include "vnl/vnl_vector_fixed.h"
 
+#include <algorithm>
+
 
 namespace ivan
 {
@@ -44,14 +47,22 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::OffsetMedialnessImageFunction() :
   m_GradientSigma( 1.0 ),
   m_SymmetryCoefficient( 1.0 ),
+  m_UseFastGaussianWeights( false ),
   m_UseCentralBoundariness( false ),
   m_AdaptativeSampling( false ),
   m_AutoComputeSectionNormal( true ),
   m_RadialResolution( 12 ),
   //m_Threshold( 0.0 ),
-  m_GradientImageFunctionType( OffsetMedialnessImageFunction::GradientNormalProjectionFunctionHyperIntense )
+  m_GradientImageFunctionType( OffsetMedialnessImageFunction::GradientNormalProjectionFunctionHyperIntense ),
+  m_UseGradientImage( false ),
+  m_GradientImageSigma( 0.0 ),
+  m_UseQuantizedRingOffsets( false ),
+  m_RingDirectionResolution( 32 ),
+  m_RingOffsetsRadius( 0.0 ),
+  m_RingOffsetsRadialResolution( 0 )
 {
   this->m_SectionNormal.Fill( 0.0 );
+  this->m_RingOffsetsExtent.Fill( 0 );
   
   this->m_Radius = this->m_Sigma / 1.7320508; // sqrt(3.0)
 
@@ -67,6 +78,8 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   this->m_GradientMagnitudeFunction->SetInterpolationMode( GradientMagnitudeFunctionType::LinearInterpolation );
   this->m_GradientMagnitudeFunction->SetSigma( this->m_GradientSigma );
   
+  this->m_GradientInterpolator = GradientInterpolatorType::New();
+  
   this->ComputeIntervals();
 }
 
@@ -89,14 +102,23 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   
   os << indent << "GradientSigma: " << this->m_GradientSigma << std::endl;
   os << indent << "SymmetryCoefficient: " << this->m_SymmetryCoefficient << std::endl;
+  os << indent << "UseFastGaussianWeights: " << this->m_UseFastGaussianWeights << std::endl;
   os << indent << "Radius: " << this->m_Radius << std::endl;
   os << indent << "UseCentralBoundariness: " << this->m_UseCentralBoundariness << std::endl;
   os << indent << "AdaptativeSampling: " << this->m_AdaptativeSampling << std::endl;
   os << indent << "AutoComputeSectionNormal: " << this->m_AutoComputeSectionNormal << std::endl;
   os << indent << "SectionNormal: " << this->m_SectionNormal << std::endl;
   os << indent << "RadialResolution: " << this->m_RadialResolution << std::endl;
-  os << indent << "CosArray: " << this->m_CosArray << std::endl;
-  os << indent << "SinArray: " << this->m_SinArray << std::endl;
+  os << indent << "UseGradientImage: " << this->m_UseGradientImage << std::endl;
+  os << indent << "GradientImageSigma: " << this->m_GradientImageSigma << std::endl;
+  os << indent << "GradientImageMemorySize: " << this->GetGradientImageMemorySize() << std::endl;
+  os << indent << "NumberOfCircleSamples: " << this->m_CircleSampler.GetNumberOfSamples() << std::endl;
+  os << indent << "PrefetchDistance: " << this->GetPrefetchDistance() << std::endl;
+  os << indent << "UseQuantizedRingOffsets: " << this->m_UseQuantizedRingOffsets << std::endl;
+  os << indent << "RingDirectionResolution: " << this->m_RingDirectionResolution << std::endl;
+  os << indent << "NumberOfRingDirections: " << this->GetNumberOfRingDirections() << std::endl;
+  os << indent << "RingOffsetsExtent: " << this->m_RingOffsetsExtent << std::endl;
+  os << indent << "RingOffsetsMemorySize: " << this->GetRingOffsetsMemorySize() << std::endl;
   //os << indent << "Threshold: " << this->m_Threshold << std::endl;
   
   os << indent << "GradientMagnitudeFunction: " << this->m_GradientMagnitudeFunction.GetPointer() << std::endl;
@@ -181,13 +203,93 @@ void
 OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::SetInputImage( const InputImageType * ptr )
 {
+  if( ptr != this->GetInputImage() )
+    this->m_GradientImage = 0;
+  
   Superclass::SetInputImage( ptr );
   
+  this->m_CircleSampler.SetImage( ptr );
   this->m_GradientFunction->SetInputImage( ptr );
   this->m_GradientMagnitudeFunction->SetInputImage( ptr );
 }
 
 
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::SetGradientImage( GradientImageType *image )
+{
+  if( this->m_GradientImage == image )
+    return;
+  
+  // The image is assumed to be computed with the current gradient sigma
+  this->m_GradientImage = image;
+  this->m_GradientImageSigma = this->m_GradientSigma;
+  this->Modified();
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+unsigned long
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::GetGradientImageMemorySize() const
+{
+  if( this->m_GradientImage.IsNull() )
+    return 0;
+  
+  return this->m_GradientImage->GetBufferedRegion().GetNumberOfPixels() * sizeof( GradientPixelType );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+unsigned int
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::GetNumberOfRingDirections() const
+{
+  if( this->m_RingOffsetsRadialResolution == 0 )
+    return 0;
+  
+  return this->m_RingOffsets.size() / this->m_RingOffsetsRadialResolution;
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+unsigned long
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::GetRingOffsetsMemorySize() const
+{
+  return this->m_RingOffsets.size() * sizeof( OffsetType ) + 
+    this->m_RingDirections.size() * sizeof( VectorType );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::ComputeGradientImage()
+{
+  if( !this->GetInputImage() )
+  {
+    itkExceptionMacro( "Input image must be set before computing the gradient image." );
+  }
+  
+  typedef itk::GradientRecursiveGaussianImageFilter<InputImageType,GradientImageType>  GradientFilterType;
+  
+  typename GradientFilterType::Pointer gradientFilter = GradientFilterType::New();
+  gradientFilter->SetInput( this->GetInputImage() );
+  gradientFilter->SetSigma( this->m_GradientSigma );
+  gradientFilter->SetNormalizeAcrossScale( true );
+  gradientFilter->Update();
+  
+  this->m_GradientImage = gradientFilter->GetOutput();
+  this->m_GradientImage->DisconnectPipeline();
+  this->m_GradientImageSigma = this->m_GradientSigma;
+  
+  itkDebugMacro( "Gradient image computed with sigma " << this->m_GradientSigma << ", memory used: " 
+    << this->GetGradientImageMemorySize() << " bytes" );
+}
+
+
 template <class TInputImage, class TOutput, class TCoordRep>
 void
 OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
@@ -197,6 +299,306 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   
   this->m_GradientFunction->Initialize();
   this->m_GradientMagnitudeFunction->Initialize();
+  
+  if( this->m_UseGradientImage )
+  {
+    if( this->m_GradientImage.IsNull() || this->m_GradientImageSigma != this->m_GradientSigma )
+      this->ComputeGradientImage();
+      
+    this->m_GradientInterpolator->SetInputImage( this->m_GradientImage );
+  }
+  
+  // Circles of interior centers are evaluated without bounds checks. The linear interpolation
+  // of the gradient image reads the next pixel in each direction, and it is only done without
+  // checks if the gradient image has the buffered region of the input
+  const InputImageType *interiorImage = this->GetInputImage();
+  
+  if( this->m_UseGradientImage && interiorImage && 
+      this->m_GradientImage->GetBufferedRegion() != interiorImage->GetBufferedRegion() )
+    interiorImage = 0;
+  
+  this->m_RingInterior.SetImage( interiorImage );
+  this->m_RingInterior.Compute( this->m_Radius, this->m_UseGradientImage ? 1.0 : 0.0 );
+  
+  if( this->m_UseQuantizedRingOffsets && TInputImage::GetImageDimension() == 3 )
+    this->ComputeRingOffsets();
+  else
+  {
+    this->m_RingOffsets.clear();
+    this->m_RingDirections.clear();
+    this->m_RingOffsetsRadialResolution = 0;
+  }
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::ComputeRingOffsets()
+{
+  if( !this->GetInputImage() )
+  {
+    itkExceptionMacro( "Input image must be set before computing the ring offsets." );
+  }
+  
+  typedef vnl_vector_fixed<double,3>  VnlVectorType;
+  
+  const InputImageType *image = this->GetInputImage();
+  const unsigned int resolution = this->m_RingDirectionResolution;
+  const unsigned int numberOfDirections = resolution * resolution;
+  const unsigned int numberOfSamples = this->m_RadialResolution;
+  
+  this->m_RingOffsets.resize( numberOfDirections * numberOfSamples );
+  this->m_RingDirections.resize( numberOfDirections * numberOfSamples );
+  this->m_RingOffsetsExtent.Fill( 0 );
+  
+  const double *cosArray = &this->m_CircleSampler.GetCosArray()[0];
+  const double *sinArray = &this->m_CircleSampler.GetSinArray()[0];
+  
+  // Offsets are computed as the displacement from the origin, so that the image direction and 
+  // spacing are taken into account
+  const PointType origin = image->GetOrigin();
+  
+  for( unsigned int j=0; j < resolution; ++j )
+  {
+    for( unsigned int i=0; i < resolution; ++i )
+    {
+      // Representative direction of the cell, from the center of the cell in the octahedral map
+      // of the upper hemisphere. Centers outside the diamond |u|+|v|<=1 are projected to its border
+      double u = 2.0 * ( i + 0.5 ) / resolution - 1.0;
+      double v = 2.0 * ( j + 0.5 ) / resolution - 1.0;
+      double w = 1.0 - vnl_math_abs( u ) - vnl_math_abs( v );
+      
+      if( w < 0.0 )
+      {
+        const double norm = vnl_math_abs( u ) + vnl_math_abs( v );
+        u /= norm;
+        v /= norm;
+        w = 0.0;
+      }
+      
+      VnlVectorType normalVector, firstBaseVector, secondBaseVector;
+      normalVector[0] = u;
+      normalVector[1] = v;
+      normalVector[2] = w;
+      normalVector.normalize();
+      
+      ComputePlaneBasisVectorsFromNormal( normalVector, firstBaseVector, secondBaseVector );
+      
+      const unsigned int firstSample = ( j * resolution + i ) * numberOfSamples;
+      
+      for( unsigned int k=0; k < numberOfSamples; ++k )
+      {
+        VectorType & direction = this->m_RingDirections[firstSample+k];
+        PointType samplePoint;
+        
+        for( unsigned int d=0; d < 3; ++d )
+        {
+          direction[d] = cosArray[k] * firstBaseVector[d] + sinArray[k] * secondBaseVector[d];
+          samplePoint[d] = origin[d] + this->m_Radius * direction[d];
+        }
+        
+        ContinuousIndexType sampleIndex;
+        image->TransformPhysicalPointToContinuousIndex( samplePoint, sampleIndex );
+        
+        OffsetType & offset = this->m_RingOffsets[firstSample+k];
+        
+        for( unsigned int d=0; d < 3; ++d )
+        {
+          offset[d] = vnl_math_rnd( sampleIndex[d] );
+          
+          if( vnl_math_abs( offset[d] ) > this->m_RingOffsetsExtent[d] )
+            this->m_RingOffsetsExtent[d] = vnl_math_abs( offset[d] );
+        }
+      }
+    }
+  }
+  
+  this->m_RingOffsetsRadius = this->m_Radius;
+  this->m_RingOffsetsRadialResolution = numberOfSamples;
+  
+  itkDebugMacro( "Ring offsets computed for " << numberOfDirections << " directions and radius " 
+    << this->m_Radius << ", memory used: " << this->GetRingOffsetsMemorySize() << " bytes" );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+unsigned int
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::ComputeRingDirectionIndex( const VectorType & normal ) const
+{
+  const int resolution = static_cast<int>( this->m_RingDirectionResolution );
+  
+  // Take the normal to the upper hemisphere, the section plane is the same
+  const double sign = ( normal[2] < 0.0 ) ? -1.0 : 1.0;
+  
+  const double norm = vnl_math_abs( normal[0] ) + vnl_math_abs( normal[1] ) + vnl_math_abs( normal[2] );
+  
+  if( norm == 0.0 )
+    return 0;
+  
+  // Octahedral map coordinates in [-1,1]
+  const double u = sign * normal[0] / norm;
+  const double v = sign * normal[1] / norm;
+  
+  int i = static_cast<int>( 0.5 * ( u + 1.0 ) * resolution );
+  int j = static_cast<int>( 0.5 * ( v + 1.0 ) * resolution );
+  
+  i = std::min( std::max( i, 0 ), resolution - 1 );
+  j = std::min( std::max( j, 0 ), resolution - 1 );
+  
+  return static_cast<unsigned int>( j * resolution + i );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradient( const ContinuousIndexType & cindex, VectorType & gradient ) const
+{
+  if( this->m_UseGradientImage )
+  {
+    const typename GradientInterpolatorType::OutputType value = 
+      this->m_GradientInterpolator->EvaluateAtContinuousIndex( cindex );
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+      gradient[k] = value[k];
+  }
+  else
+  {
+    const typename GradientFunctionType::OutputType value = 
+      this->m_GradientFunction->EvaluateAtContinuousIndex( cindex );
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+      gradient[k] = value[k];
+  }
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+double
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradientMagnitude( const ContinuousIndexType & cindex ) const
+{
+  if( this->m_UseGradientImage )
+  {
+    VectorType gradient;
+    this->EvaluateGradient( cindex, gradient );
+    return gradient.GetNorm();
+  }
+  
+  return this->m_GradientMagnitudeFunction->EvaluateAtContinuousIndex( cindex );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradientAtIndex( const IndexType & index, VectorType & gradient ) const
+{
+  if( this->m_UseGradientImage )
+  {
+    const GradientPixelType & value = this->m_GradientImage->GetPixel( index );
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+      gradient[k] = value[k];
+  }
+  else
+  {
+    const typename GradientFunctionType::OutputType value = 
+      this->m_GradientFunction->EvaluateAtIndex( index );
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+      gradient[k] = value[k];
+  }
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradientInside( const ContinuousIndexType & cindex, VectorType & gradient ) const
+{
+  typedef typename GradientImageType::OffsetValueType  OffsetValueType;
+  
+  const unsigned int dimension = TInputImage::GetImageDimension();
+  
+  const GradientPixelType *pixels = this->m_GradientImage->GetBufferPointer();
+  const OffsetValueType *offsetTable = this->m_GradientImage->GetOffsetTable();
+  const IndexType & start = this->m_GradientImage->GetBufferedRegion().GetIndex();
+  
+  // Lower corner of the cell and distances to it. The next pixel is inside the buffer
+  OffsetValueType baseOffset = 0;
+  double distance[InputImageType::ImageDimension];
+  
+  for( unsigned int d=0; d < dimension; ++d )
+  {
+    const long base = static_cast<long>( vcl_floor( cindex[d] ) );
+    distance[d] = cindex[d] - static_cast<double>( base );
+    baseOffset += ( base - start[d] ) * offsetTable[d];
+  }
+  
+  gradient.Fill( 0.0 );
+  
+  // Weighted sum of the corners of the cell
+  for( unsigned int corner=0; corner < ( 1u << dimension ); ++corner )
+  {
+    double weight = 1.0;
+    OffsetValueType offset = baseOffset;
+    
+    for( unsigned int d=0; d < dimension; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        weight *= distance[d];
+        offset += offsetTable[d];
+      }
+      else
+        weight *= 1.0 - distance[d];
+    }
+    
+    const GradientPixelType & value = pixels[offset];
+    
+    for( unsigned int k=0; k < dimension; ++k )
+      gradient[k] += weight * value[k];
+  }
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+double
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateGradientMagnitudeAtIndex( const IndexType & index ) const
+{
+  if( this->m_UseGradientImage )
+  {
+    VectorType gradient;
+    this->EvaluateGradientAtIndex( index, gradient );
+    return gradient.GetNorm();
+  }
+  
+  return this->m_GradientMagnitudeFunction->EvaluateAtIndex( index );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+bool
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::IsZeroHessian( const HessianTensorType & hessian )
+{
+  double trace = 0.0;
+  unsigned int diag = 0; // diagonal position
+  
+  for( unsigned int i=0; i<TInputImage::GetImageDimension(); ++i, 
+    diag += TInputImage::GetImageDimension()-i )
+  {
+    if( fabs( hessian[diag] ) > 1e-3 )
+      return false;
+    
+    trace += hessian[diag];
+  }
+  
+  return fabs( trace ) <= 1e-3;
 }
 
 
@@ -211,21 +613,8 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
       ( vnl_math_rnd( 2.0 * vnl_math::pi * this->m_Sigma + 1.0 ) );
   }
   
-  // Set the size of the arrays for storing radial boundariness values depending on the number of samples
-  this->m_SinArray.SetSize( this->m_RadialResolution );
-  this->m_CosArray.SetSize( this->m_RadialResolution );
-    
   // Precalculate sin and cos values as these calculations are costly
-  
-  double angle = 0.0;
-  double angleInc = vnl_math::pi * 2.0 / static_cast<double>( this->m_RadialResolution ); 
-  
-  for ( unsigned int i=0; i < this->m_RadialResolution; ++i )
-  {
-    this->m_SinArray[i] = sin( angle );
-    this->m_CosArray[i] = cos( angle );
-    angle += angleInc;
-  }  
+  this->m_CircleSampler.SetNumberOfSamples( this->m_RadialResolution );
 }
 
 
@@ -238,6 +627,9 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   // The section plane will be formed by the first and second base vectors, which are normal to the normal vector
   
   typedef vnl_vector_fixed<double,3>  VnlVectorType;  
+  
+  // Local copy of the section normal, so that the function can be evaluated concurrently
+  VectorType sectionNormal = this->m_SectionNormal;
   VnlVectorType  firstBaseVector, secondBaseVector;
   
   if( this->m_AutoComputeSectionNormal )
@@ -248,34 +640,12 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
     EigenVectorsMatrixType eigenVectors;
     EigenValuesArrayType   eigenValues;
     
-    // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
-    hessian.ComputeEigenAnalysis( eigenValues, eigenVectors );
-    
     // Check that the hessian matrix is not a zero matrix. This avoids problems with NaN eigenvalues and eigenvectors
-    double trace = 0.0;
-    bool zeroTrace = true;
-    unsigned int diag = 0; // diagonal position
-    
-    for( unsigned int i=0; i<TInputImage::GetImageDimension(); ++i, 
-      diag += TInputImage::GetImageDimension()-i )
-    {
-      trace += hessian[diag];
-      
-      if( zeroTrace )
-      {
-        if( fabs( hessian[diag] ) > 1e-3 )
-          zeroTrace = false;
-      }
-    }
-    
-    if( zeroTrace )
-    {
-      if( fabs( trace ) > 1e-3 )
-        zeroTrace = false;
-    }    
-    
-    if( zeroTrace )
+    if( IsZeroHessian( hessian ) )
       return itk::NumericTraits<OutputType>::Zero;
+    
+    // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
+    SymmetricEigenSolver<HessianTensorType>::ComputeEigenAnalysis( hessian, eigenValues, eigenVectors );
       
     // Recover eigenvectors from the matrix (first two rows)
     for( unsigned int i=0; i < TInputImage::GetImageDimension(); ++i )
@@ -288,9 +658,9 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
       if( secondBaseVector[i] == -0.0 )
         secondBaseVector[i] = 0.0;
       
-      this->m_SectionNormal[i] = eigenVectors( 2, i );
-      if( this->m_SectionNormal[i] == -0.0 )
-        this->m_SectionNormal[i] = 0.0;
+      sectionNormal[i] = eigenVectors( 2, i );
+      if( sectionNormal[i] == -0.0 )
+        sectionNormal[i] = 0.0;
     }
   
     // Do not process those pixels whose first two eigenvalues are not negative
@@ -308,10 +678,10 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   else // the section normal is provided
   {
     // Verify that the section was provided
-    assert( this->m_SectionNormal[0] + this->m_SectionNormal[1] + this->m_SectionNormal[2] != 0.0 );
+    assert( sectionNormal[0] + sectionNormal[1] + sectionNormal[2] != 0.0 );
     
     VnlVectorType normalVector;
-    normalVector.copy_in( this->m_SectionNormal.GetDataPointer() );
+    normalVector.copy_in( sectionNormal.GetDataPointer() );
     
     // Calculate an orthonormal base of vectors in the plane of the section given the normal vector
     ComputePlaneBasisVectorsFromNormal( normalVector, firstBaseVector, secondBaseVector );
@@ -322,47 +692,59 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   
   unsigned int calculatedSamples = 0; // samples calculated for each circle
   OutputType medialness; // calculated medialness at current point and scale
-  double weightExponent; // exponent of weighting factors for medialness calculations
-  double averageRadialMedialness; // measure of average medialness without weighting
   double centralBoundariness; // boundariness at the current point
   
-  PointType currentPoint, currentCirclePoint;
-  //IndexType currentCircleIndex;
+  PointType currentPoint;
+  ContinuousIndexType currentCircleIndex;
   
-  // Arrays used for medialness calculation
-  
-  itk::Array<double>   radialMedialness; // stores all values of gradient in the circle with given radius
-  itk::Array<double>   radialMedialnessWeights; // stores all weighting factors in the circle with given radius
-
-  radialMedialness.SetSize( this->m_RadialResolution );
-  radialMedialnessWeights.SetSize( this->m_RadialResolution );
-  
-  // Initialize the arrays
-  radialMedialness.Fill( 0.0f );
-  radialMedialnessWeights.Fill( 0.0f );
+  // Stores all values of gradient in the circle with given radius, on the stack
+  RadialValuesArrayType radialMedialness( this->m_RadialResolution );
+  radialMedialness.Fill( 0.0 );
 
   // Get the physical coordinates of the current index
   this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( cindex, currentPoint );
   
-  typename InputImageType::SpacingType spacing = this->GetInputImage()->GetSpacing();
+  // Calculate points in a circle defined by the two eigenvectors with r = m_Radius, 
+  // all at once and in index space
+  CircleSampleSetType circleSamples( this->m_RadialResolution );
+  this->m_CircleSampler.Sample( currentPoint, this->m_Radius, firstBaseVector, secondBaseVector, circleSamples );
+  
+  const double *cosArray = &this->m_CircleSampler.GetCosArray()[0];
+  const double *sinArray = &this->m_CircleSampler.GetSinArray()[0];
+  
+  // Neighborhoods of the gradient functions, the gradient image is not prefetched
+  const unsigned int prefetchRadius = ( this->m_UseGradientImage || !this->GetPrefetchDistance() ) ? 0 :
+    this->m_CircleSampler.ComputeNeighborhoodRadius( this->m_GradientSigma );
+  
+  // Samples of circles far from the border are not tested, and the gradient image is then
+  // interpolated without bounds checks. The interior is not used if the radius changed
+  const bool interior = ( this->m_RingInterior.GetRadius() == this->m_Radius ) && 
+    this->m_RingInterior.IsInside( cindex );
+  const bool interpolateInside = interior && this->m_UseGradientImage && 
+    this->m_RingInterior.GetMargin() >= 1.0;
 
-  // Calculate points in a circle defined by the two eigenvectors with r = m_Radius
   for( unsigned int i=0; i<this->m_RadialResolution; ++i )
   {
     // Evaluate and store the value of the gradient in a circle 
     
-    for( int k=0; k < TInputImage::GetImageDimension(); ++k )
-      currentCirclePoint[k] = currentPoint[k] + this->m_Radius * 
-        ( this->m_CosArray[i] * firstBaseVector[k] + this->m_SinArray[i] * secondBaseVector[k] );
+    if( !this->m_UseGradientImage )
+      this->m_CircleSampler.Prefetch( circleSamples, i, prefetchRadius );
     
-    if( this->m_GradientMagnitudeFunction->IsInsideBuffer( currentCirclePoint ) ) // the check may be made with any filter
+    if( interior || circleSamples.IsInside( i ) )
     {
+      circleSamples.GetContinuousIndex( i, currentCircleIndex );
+      
       if( this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHyperIntense ||
           this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHypoIntense )
       {
         // Project the gradient into the radial direction, that is, compute the dot product of both vectors
                
-        typename GradientFunctionType::OutputType gradient = this->m_GradientFunction->Evaluate( currentCirclePoint );
+        VectorType gradient;
+        
+        if( interpolateInside )
+          this->EvaluateGradientInside( currentCircleIndex, gradient );
+        else
+          this->EvaluateGradient( currentCircleIndex, gradient );
                
         radialMedialness[i] = 0.0; 
         
@@ -370,11 +752,17 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
         double gradientSign = ( ( this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHyperIntense ) ? -1.0 : 1.0 );
         
         for( int k=0; k < TInputImage::GetImageDimension(); ++k )
-          radialMedialness[i] += gradientSign * gradient[k] * ( this->m_CosArray[i] * firstBaseVector[k] + this->m_SinArray[i] * secondBaseVector[k] );
+          radialMedialness[i] += gradientSign * gradient[k] * ( cosArray[i] * firstBaseVector[k] + sinArray[i] * secondBaseVector[k] );
+      }
+      else if( interpolateInside ) // GradientMagnitudeFunction, from the gradient image
+      {
+        VectorType gradient;
+        this->EvaluateGradientInside( currentCircleIndex, gradient );
+        radialMedialness[i] = gradient.GetNorm();
       }
       else // GradientMagnitudeFunction
       {
-        radialMedialness[i] = this->m_GradientMagnitudeFunction->Evaluate( currentCirclePoint );        
+        radialMedialness[i] = this->EvaluateGradientMagnitude( currentCircleIndex );
       }
         
       ++calculatedSamples;
@@ -383,35 +771,7 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
       radialMedialness[i] = 0.0;    
   }
   
-  medialness = 0.0;
-  
-  if( calculatedSamples > 0 )
-  {
-    if( m_SymmetryCoefficient == 1.0 ) // speed-up calculations for the simplest (default) case
-    {
-      for ( unsigned int i=0; i<this->m_RadialResolution; ++i )
-        medialness += radialMedialness[i];  
-    }    
-    else
-    {
-      averageRadialMedialness = radialMedialness.one_norm() 
-        / static_cast<double>( calculatedSamples );
-        
-      for ( unsigned int i=0; i<this->m_RadialResolution; ++i )
-      {
-        if( !radialMedialness[i] )
-          continue;
-        
-        // Calculate b coefficients
-        weightExponent = ( 1.0 - radialMedialness[i] / averageRadialMedialness ) 
-          / m_SymmetryCoefficient;
-        radialMedialnessWeights[i] = vcl_exp( -0.5 * weightExponent * weightExponent );
-        medialness += radialMedialnessWeights[i] * radialMedialness[i];
-      }    
-    }
-
-    medialness /= static_cast<double>( calculatedSamples );
-  }
+  medialness = this->CombineRadialValues( radialMedialness, calculatedSamples );
           
   // Now calculate final medialness using an adaptative threshold that depends on the central boundariness
   // (value of gradient at the central point). Vessel centers are supposed to have a low value of boundariness
@@ -419,7 +779,7 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   
   if( this->m_UseCentralBoundariness )
   {
-    centralBoundariness = this->m_GradientMagnitudeFunction->Evaluate( currentPoint );
+    centralBoundariness = this->EvaluateGradientMagnitude( cindex );
 	  
 	  medialness /= centralBoundariness;
 
@@ -433,6 +793,151 @@ OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
   //return centralBoundariness;
   return medialness;
 }
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::CombineRadialValues( const RadialValuesArrayType & radialMedialness, unsigned int calculatedSamples ) const
+{
+  OutputType medialness = 0.0;
+  
+  if( calculatedSamples == 0 )
+    return medialness;
+  
+  const unsigned int numberOfValues = radialMedialness.Size();
+  
+  if( m_SymmetryCoefficient == 1.0 ) // speed-up calculations for the simplest (default) case
+  {
+    for ( unsigned int i=0; i<numberOfValues; ++i )
+      medialness += radialMedialness[i];  
+  }    
+  else
+  {
+    double weightExponent; // exponent of weighting factors for medialness calculations
+    double averageRadialMedialness = 0.0; // measure of average medialness without weighting
+    
+    for ( unsigned int i=0; i<numberOfValues; ++i )
+      averageRadialMedialness += fabs( radialMedialness[i] );
+      
+    averageRadialMedialness /= static_cast<double>( calculatedSamples );
+      
+    for ( unsigned int i=0; i<numberOfValues; ++i )
+    {
+      if( !radialMedialness[i] )
+        continue;
+      
+      // Calculate b coefficients
+      weightExponent = ( 1.0 - radialMedialness[i] / averageRadialMedialness ) 
+        / m_SymmetryCoefficient;
+      medialness += ( m_UseFastGaussianWeights ? GaussianWeightTable::Evaluate( weightExponent ) :
+        vcl_exp( -0.5 * weightExponent * weightExponent ) ) * radialMedialness[i];
+    }    
+  }
+
+  return medialness / static_cast<double>( calculatedSamples );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+OffsetMedialnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessAtIndex( const HessianTensorType & hessian, const IndexType & index ) const
+{
+  // Use the exact sampling if the tables are not built or are outdated
+  if( !this->m_UseQuantizedRingOffsets || this->m_RingOffsets.empty() ||
+      this->m_RingOffsetsRadius != this->m_Radius || 
+      this->m_RingOffsetsRadialResolution != this->m_RadialResolution )
+    return Superclass::EvaluateVesselnessAtIndex( hessian, index );
+  
+  // Local copy of the section normal, so that the function can be evaluated concurrently
+  VectorType sectionNormal = this->m_SectionNormal;
+  
+  if( this->m_AutoComputeSectionNormal )
+  {
+    typedef typename HessianTensorType::EigenVectorsMatrixType  EigenVectorsMatrixType;
+    typedef typename HessianTensorType::EigenValuesArrayType    EigenValuesArrayType;
+        
+    EigenVectorsMatrixType eigenVectors;
+    EigenValuesArrayType   eigenValues;
+    
+    if( IsZeroHessian( hessian ) )
+      return itk::NumericTraits<OutputType>::Zero;
+    
+    SymmetricEigenSolver<HessianTensorType>::ComputeEigenAnalysis( hessian, eigenValues, eigenVectors );
+    
+    for( unsigned int i=0; i < TInputImage::GetImageDimension(); ++i )
+      sectionNormal[i] = eigenVectors( 2, i );
+  }
+  else
+  {
+    // Verify that the section was provided
+    assert( sectionNormal[0] + sectionNormal[1] + sectionNormal[2] != 0.0 );
+  }
+  
+  const unsigned int numberOfSamples = this->m_RadialResolution;
+  const unsigned int firstSample = this->ComputeRingDirectionIndex( sectionNormal ) * numberOfSamples;
+  
+  const OffsetType *offsets = &this->m_RingOffsets[firstSample];
+  const VectorType *directions = &this->m_RingDirections[firstSample];
+  
+  // Samples only need to be checked if the ring may go out of the buffered region
+  const typename InputImageType::RegionType & region = this->GetInputImage()->GetBufferedRegion();
+  bool checkInside = false;
+  
+  for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+  {
+    if( index[k] - this->m_RingOffsetsExtent[k] < region.GetIndex()[k] ||
+        index[k] + this->m_RingOffsetsExtent[k] >= 
+          region.GetIndex()[k] + static_cast<typename IndexType::IndexValueType>( region.GetSize()[k] ) )
+    {
+      checkInside = true;
+      break;
+    }
+  }
+  
+  const bool projectGradient = 
+    ( this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHyperIntense ||
+      this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHypoIntense );
+  
+  // For hyperintese vessels use minus sign, since we are going from higher to lower values 
+  const double gradientSign = 
+    ( ( this->m_GradientImageFunctionType == GradientNormalProjectionFunctionHyperIntense ) ? -1.0 : 1.0 );
+  
+  unsigned int calculatedSamples = 0;
+  
+  RadialValuesArrayType radialMedialness( numberOfSamples );
+  radialMedialness.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < numberOfSamples; ++i )
+  {
+    const IndexType sampleIndex = index + offsets[i];
+    
+    if( checkInside && !region.IsInside( sampleIndex ) )
+      continue;
+    
+    if( projectGradient )
+    {
+      VectorType gradient;
+      this->EvaluateGradientAtIndex( sampleIndex, gradient );
+      
+      radialMedialness[i] = gradientSign * ( gradient * directions[i] );
+    }
+    else // GradientMagnitudeFunction
+    {
+      radialMedialness[i] = this->EvaluateGradientMagnitudeAtIndex( sampleIndex );
+    }
+    
+    ++calculatedSamples;
+  }
+  
+  OutputType medialness = this->CombineRadialValues( radialMedialness, calculatedSamples );
+  
+  if( this->m_UseCentralBoundariness )
+    medialness /= this->EvaluateGradientMagnitudeAtIndex( index );
+  
+  return medialness;
+}
   
 } // end namespace ivan
 
@@ -33,6 +33,11 @@ SUCH DAMAGE.
 
 #include "ivanImageFunctionInitializerBase.h"
 #include "ivanOffsetMedialnessImageFunction.h"
+#include "ivanScaleSpacePyramid.h"
+
+#include "itkSimpleFastMutexLock.h"
+
+#include <algorithm>
 
 
 #define OFFSET_MEDIALNESS_INITIALIZER_FIXED_SIGMA  1.0
@@ -48,6 +53,15 @@ namespace ivan
  * Specific initialization for offset medialness, where the scale affects the radius of the medialness
  * calculation and not the scale of the Hessian matrix used to compute the plane.
  *
+ * If UseGradientImage is on, the gradient image is computed only once (for the first function
+ * initialized) and shared by all the functions, since the gradient sigma does not depend on the scale.
+ *
+ * If a pyramid of the image is set, the function is initialized with the level selected for the
+ * smallest of the Hessian and gradient sigmas, and with their residual sigmas on that level. The 
+ * radius is in physical units and is not changed. The levels only keep the physical geometry of 
+ * the image, so the pyramid must only be used for functions evaluated at physical points.
+ *
+ * \sa ScaleSpacePyramid
  */
 template <class TImage, class TOutput = double>
 class ITK_EXPORT OffsetMedialnessImageFunctionInitializer : 
@@ -66,6 +80,11 @@ public:
   typedef OffsetMedialnessImageFunction<TImage,TOutput>       ImageFunctionType;
   
   typedef typename ImageFunctionType::GradientImageFunctionType    GradientImageFunctionType; 
+  typedef typename ImageFunctionType::GradientImageType            GradientImageType;
+  typedef typename ImageFunctionType::GradientImagePointer         GradientImagePointer;
+  
+  typedef ScaleSpacePyramid<TImage>                                PyramidType;
+  typedef typename PyramidType::Pointer                            PyramidPointer;
   
   enum ScaleSelectionMethodType
   {
@@ -104,6 +123,22 @@ public:
   GradientImageFunctionType GetGradientImageFunctionType() const
     { return m_GradientImageFunctionType; }
   
+  /** Set/Get the flag for using a precomputed gradient image shared by all functions. */
+  void SetUseGradientImage( bool use )
+    { this->m_UseGradientImage = use; }
+  bool GetUseGradientImage() const
+    { return this->m_UseGradientImage; }
+  itkBooleanMacro( UseGradientImage );
+  
+  /** Memory used by the shared gradient image in bytes (zero if not computed yet). */
+  unsigned long GetGradientImageMemorySize() const
+    {
+      if( this->m_GradientImage.IsNull() )
+        return 0;
+      return this->m_GradientImage->GetBufferedRegion().GetNumberOfPixels() 
+        * sizeof( typename GradientImageType::PixelType );
+    }
+  
   void SetSymmetryCoefficient( double coeff )
     {
       if( coeff < 0.0 )
@@ -122,37 +157,89 @@ public:
       }
     }
     
+  /** Set/Get the pyramid of the image. Only used when the function is initialized with the 
+    * input of the pyramid. */
+  void SetPyramid( PyramidType *pyramid )
+    { this->m_Pyramid = pyramid; }
+  PyramidType * GetPyramid()
+    { return this->m_Pyramid.GetPointer(); }
+    
   virtual void Initialize( ImageFunctionType *imageFunction, const ImageType *image = 0, double scale = 0.0 )
     {
-      imageFunction->SetInputImage( image );
+      double hessianSigma = this->m_HessianSigma;
+      double radius = this->m_Radius;
+      double gradientSigma = this->m_GradientSigma;
       
       switch( this->m_ScaleSelectionMethod )
       {
         case UseScaleAsRadius:
         
-          imageFunction->SetSigma( this->m_HessianSigma );
-          imageFunction->SetRadius( scale );
+          radius = scale;
           break;
           
         case UseScaleAsSigma:
         
-          imageFunction->SetSigma( scale );
-          imageFunction->SetRadius( this->m_Radius );
+          hessianSigma = scale;
           break;
           
         case IgnoreScale:
         
-          imageFunction->SetSigma( this->m_HessianSigma );
-          imageFunction->SetRadius( this->m_Radius );
           break;
       }
       
-      imageFunction->SetGradientSigma( this->m_GradientSigma );      
+      if( this->m_Pyramid.IsNotNull() && image && image == this->m_Pyramid->GetInput() )
+      {
+        const unsigned int level = 
+          this->m_Pyramid->GetLevelForScale( std::min( hessianSigma, gradientSigma ) );
+        
+        image = this->m_Pyramid->GetLevel( level );
+        hessianSigma = this->m_Pyramid->GetResidualSigma( hessianSigma, level );
+        gradientSigma = this->m_Pyramid->GetResidualSigma( gradientSigma, level );
+      }
+      
+      imageFunction->SetInputImage( image );
+      imageFunction->SetSigma( hessianSigma );
+      imageFunction->SetRadius( radius );
+      imageFunction->SetGradientSigma( gradientSigma );      
       imageFunction->SetAdaptativeSampling( true );
       imageFunction->SetAutoComputeSectionNormal( true );
       imageFunction->SetNormalizeAcrossScale( true );
       imageFunction->SetUseImageSpacing( true );
-      imageFunction->Initialize();
+      imageFunction->SetUseGradientImage( this->m_UseGradientImage );
+      
+      if( this->m_UseGradientImage )
+      {
+        // Functions may be initialized from several threads, and the first one computes the 
+        // shared image while the others wait
+        this->m_GradientImageMutex.Lock();
+        
+        try
+        {
+          // Recompute the shared image only if the input or the gradient sigma changed
+          if( this->m_GradientImage.IsNotNull() && this->m_GradientImageInput == image && 
+              this->m_GradientImageSigma == gradientSigma )
+          {
+            imageFunction->SetGradientImage( this->m_GradientImage );
+          }
+          
+          imageFunction->Initialize();
+        }
+        catch( ... )
+        {
+          this->m_GradientImageMutex.Unlock();
+          throw;
+        }
+        
+        this->m_GradientImage = imageFunction->GetGradientImage();
+        this->m_GradientImageInput = image;
+        this->m_GradientImageSigma = gradientSigma;
+        
+        this->m_GradientImageMutex.Unlock();
+      }
+      else
+      {
+        imageFunction->Initialize();
+      }
     }
   
 protected:
@@ -163,7 +250,10 @@ protected:
     m_Radius( OFFSET_MEDIALNESS_INITIALIZER_FIXED_RADIUS ),
     m_GradientSigma( 1.0 ),
     m_SymmetryCoefficient( 0.5 ),
-    m_GradientImageFunctionType( ImageFunctionType::GradientNormalProjectionFunctionHyperIntense )
+    m_GradientImageFunctionType( ImageFunctionType::GradientNormalProjectionFunctionHyperIntense ),
+    m_UseGradientImage( false ),
+    m_GradientImageInput( 0 ),
+    m_GradientImageSigma( 0.0 )
     {}
 
   virtual ~OffsetMedialnessImageFunctionInitializer() {}
@@ -194,6 +284,16 @@ private:
   
   /** The type of gradient use (i.e. magnitude or projected along normal hyperintense and hypointense). */
   GradientImageFunctionType    m_GradientImageFunctionType;
+  
+  /** Flag for using a precomputed gradient image, and the shared image with the input and sigma
+    * used to compute it. */
+  bool                         m_UseGradientImage;
+  GradientImagePointer         m_GradientImage;
+  const ImageType             *m_GradientImageInput;
+  double                       m_GradientImageSigma;
+  itk::SimpleFastMutexLock     m_GradientImageMutex;
+  
+  PyramidPointer               m_Pyramid;
 };
 
 } // end namespace ivan
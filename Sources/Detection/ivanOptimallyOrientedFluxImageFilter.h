@@ -0,0 +1,222 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanOptimallyOrientedFluxImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes optimally oriented flux for the whole image in the Fourier domain
+// Date: 2012/11/05
+
+#ifndef __ivanOptimallyOrientedFluxImageFilter_h
+#define __ivanOptimallyOrientedFluxImageFilter_h
+
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+
+#include "itkImageToImageFilter.h"
+#include "itkImage.h"
+
+#include <vcl_complex.h>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class OptimallyOrientedFluxImageFilter
+ * \brief Computes optimally oriented flux (OOF) vesselness for the whole image using the FFT.
+ *
+ * This filter obtains the same flux matrix as OptimallyOrientedFluxVesselnessImageFunction, 
+ * but for all the pixels at once. Instead of sampling the gradient on a sphere around each 
+ * point, the flux matrix at radius r is computed as the convolution of the image with the second
+ * derivatives of a Gaussian of the given sigma and the indicator function of the ball of 
+ * radius r (divergence theorem). The transfer function of this kernel is known in closed form 
+ * (see Law and Chung), so the flux matrix for all the pixels is obtained with one forward FFT 
+ * of the input and one inverse FFT for each matrix component.
+ *
+ * The vesselness is then computed from the eigenvalues and eigenvectors of the flux matrix
+ * with TEigenvalueFunctor, the same functors used by OptimallyOrientedFluxVesselnessImageFunction.
+ *
+ * The spectrum of the input is kept between executions as long as the input is not modified
+ * and its padding is enough for the current radius. Since the padding grows with the radius,
+ * MaximumRadius should be set to the largest radius when computing the response at several 
+ * radii (e.g. from MultiscaleOptimallyOrientedFluxImageFilter), so that the spectrum is 
+ * computed once and each new radius only requires the inverse transforms.
+ *
+ * The input is padded by replicating the boundary pixels, to a size whose prime factors are 
+ * 2, 3 and 5, as required by the VNL FFT. The whole input is requested. Only 3D images 
+ * are supported.
+ *
+ * \par REFERENCES
+ * Law, M.W.K. and Chung, A.C.S. "Three Dimensional Curvilinear Structure Detection Using Optimally 
+ * Oriented Flux", The 10th European Conf. on Computer Vision (ECCV'08), LNCS 5305:368-382 (2008).
+ *
+ * \sa OptimallyOrientedFluxVesselnessImageFunction
+ */
+template <class TInputImage, class TOutputImage, 
+  class TEigenvalueFunctor = GeometricMeanTwoNegativeEigenvalueFunctor<double,3> >
+class ITK_EXPORT OptimallyOrientedFluxImageFilter :
+  public itk::ImageToImageFilter<TInputImage,TOutputImage>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef OptimallyOrientedFluxImageFilter                    Self;
+  typedef itk::ImageToImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+  
+  typedef TInputImage                                   InputImageType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef typename InputImageType::RegionType           InputImageRegionType;
+  typedef typename OutputImageType::RegionType          OutputImageRegionType;
+  typedef typename OutputImageType::PixelType           OutputPixelType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, ITKImageDimensionMacro( InputImageType ) );
+  
+  /** Flux matrix types. */
+  typedef TEigenvalueFunctor                                 EigenvalueFunctorType;
+  typedef typename EigenvalueFunctorType::MatrixType         FluxMatrixType;
+  typedef typename FluxMatrixType::EigenVectorsMatrixType    EigenVectorsMatrixType;
+  typedef typename FluxMatrixType::EigenValuesArrayType      EigenValuesArrayType;
+  typedef itk::Image<FluxMatrixType,itkGetStaticConstMacro(ImageDimension)>   FluxMatrixImageType;
+  
+  /** Types for the spectrum. */
+  typedef vcl_complex<double>                                ComplexType;
+  typedef std::vector<ComplexType>                           ComplexBufferType;
+  typedef itk::Size<itkGetStaticConstMacro(ImageDimension)>  SizeType;
+  
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );  
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( OptimallyOrientedFluxImageFilter, itk::ImageToImageFilter );
+  
+  /** Set/Get the radius of the sphere, in physical units. */
+  itkSetMacro( Radius, double );
+  itkGetConstMacro( Radius, double );
+  
+  /** Set/Get the largest radius that the input is padded for, in physical units. Zero 
+    * (default) pads for the current radius only. */
+  itkSetMacro( MaximumRadius, double );
+  itkGetConstMacro( MaximumRadius, double );
+  
+  /** Set/Get the sigma of the Gaussian used for computing the gradient, in physical units. */
+  itkSetMacro( Sigma, double );
+  itkGetConstMacro( Sigma, double );
+  
+  /** Set/Get the flag for normalizing the flux by the area of the sphere, which makes 
+    * the responses at different radii comparable. True by default. */
+  itkSetMacro( NormalizeAcrossScale, bool );
+  itkGetConstMacro( NormalizeAcrossScale, bool );
+  itkBooleanMacro( NormalizeAcrossScale );
+  
+  /** Get the eigenvalue functor in order to set/get its properties. */
+  EigenvalueFunctorType * GetEigenvalueFunctor()
+    { return &this->m_EigenvalueFunctor; }
+  const EigenvalueFunctorType * GetEigenvalueFunctor() const
+    { return &this->m_EigenvalueFunctor; }
+  
+  /** Get the flux matrix image computed in the last execution, which covers the output 
+    * requested region. */
+  const FluxMatrixImageType * GetFluxMatrixImage() const
+    { return this->m_FluxMatrixImage.GetPointer(); }
+  
+  /** Release the stored spectrum of the input. */
+  void ReleaseSpectrum();
+  
+  /** Number of times the spectrum of the input has been computed. */
+  itkGetConstMacro( NumberOfSpectrumComputations, unsigned long );
+  
+  /** The FFT needs the whole input. */
+  virtual void GenerateInputRequestedRegion();
+  
+protected:
+
+  OptimallyOrientedFluxImageFilter();
+  ~OptimallyOrientedFluxImageFilter() {};
+  
+  /** Compute the spectrum of the input, if needed, and the flux matrix. */
+  virtual void BeforeThreadedGenerateData();
+  
+  /** Compute the vesselness from the flux matrix. */
+  virtual void ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId );
+  
+  /** Padding needed at each side of the input for the current (or maximum) radius and sigma. */
+  SizeType GetRequiredPaddingSize() const;
+  
+  /** Compute the padded size and the spectrum of the input. */
+  virtual void ComputeInputSpectrum();
+  
+  /** Compute the flux matrix image at the current radius for the output requested region. */
+  virtual void ComputeFluxMatrixImage();
+  
+  /** Smallest size greater or equal than the given one whose prime factors are 2, 3 and 5. */
+  static unsigned int GetNextFFTSize( unsigned int size );
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  OptimallyOrientedFluxImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  double                                   m_Radius;
+  double                                   m_MaximumRadius;
+  double                                   m_Sigma;
+  bool                                     m_NormalizeAcrossScale;
+  
+  EigenvalueFunctorType                    m_EigenvalueFunctor;
+  
+  /** Spectrum of the padded input and the data needed to know if it is still valid. */
+  ComplexBufferType                        m_InputSpectrum;
+  SizeType                                 m_PaddedSize;
+  SizeType                                 m_PaddingSize;
+  const InputImageType                    *m_SpectrumInput;
+  unsigned long                            m_SpectrumInputMTime;
+  unsigned long                            m_NumberOfSpectrumComputations;
+  
+  typename FluxMatrixImageType::Pointer    m_FluxMatrixImage;
+};
+
+} // end namespace ivan
+
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_OptimallyOrientedFluxImageFilter(_, EXPORT, x, y) namespace ivan { \
+  _(2(class EXPORT OptimallyOrientedFluxImageFilter< ITK_TEMPLATE_2 x >)) \
+  namespace Templates { typedef OptimallyOrientedFluxImageFilter< ITK_TEMPLATE_2 x > \
+                                                  OptimallyOrientedFluxImageFilter##y; } \
+  }
+
+#if ITK_TEMPLATE_EXPLICIT
+# include "Templates/ivanOptimallyOrientedFluxImageFilter+-.h"
+#endif
+
+#if ITK_TEMPLATE_TXX
+# include "ivanOptimallyOrientedFluxImageFilter.hxx"
+#endif
+
+#endif
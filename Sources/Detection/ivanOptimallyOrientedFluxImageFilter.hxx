@@ -0,0 +1,368 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanOptimallyOrientedFluxImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: computes optimally oriented flux for the whole image in the Fourier domain
+// Date: 2012/11/05
+
+#ifndef __ivanOptimallyOrientedFluxImageFilter_hxx
+#define __ivanOptimallyOrientedFluxImageFilter_hxx
+
+#include "ivanOptimallyOrientedFluxImageFilter.h"
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+
+#include "vnl/algo/vnl_fft_3d.h"
+#include "vnl/vnl_math.h"
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::OptimallyOrientedFluxImageFilter() :
+  m_Radius( 1.0 ),
+  m_MaximumRadius( 0.0 ),
+  m_Sigma( 1.0 ),
+  m_NormalizeAcrossScale( true ),
+  m_SpectrumInput( 0 ),
+  m_SpectrumInputMTime( 0 ),
+  m_NumberOfSpectrumComputations( 0 )
+{
+  m_PaddedSize.Fill( 0 );
+  m_PaddingSize.Fill( 0 );
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  
+  if( input )
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::ReleaseSpectrum()
+{
+  ComplexBufferType().swap( this->m_InputSpectrum );
+  this->m_SpectrumInput = 0;
+  this->m_SpectrumInputMTime = 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+unsigned int
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::GetNextFFTSize( unsigned int size )
+{
+  unsigned int fftSize = vnl_math_max( size, 1u );
+  
+  while( true )
+  {
+    unsigned int n = fftSize;
+    
+    while( n % 2 == 0 ) n /= 2;
+    while( n % 3 == 0 ) n /= 3;
+    while( n % 5 == 0 ) n /= 5;
+    
+    if( n == 1 )
+      return fftSize;
+      
+    ++fftSize;
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+typename OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>::SizeType
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::GetRequiredPaddingSize() const
+{
+  // Support of the kernel: ball of the given radius dilated by the gaussian
+  const double support = vnl_math_max( this->m_Radius, this->m_MaximumRadius ) + 3.0 * this->m_Sigma;
+  
+  SizeType padding;
+  
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+    padding[d] = static_cast<typename SizeType::SizeValueType>
+      ( vcl_ceil( support / this->GetInput()->GetSpacing()[d] ) ) + 1;
+  
+  return padding;
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::ComputeInputSpectrum()
+{
+  itkDebugMacro(<<"Computing spectrum of the input");
+  
+  const InputImageType *input = this->GetInput();
+  const InputImageRegionType region = input->GetBufferedRegion();
+  
+  typename InputImageType::IndexType start = region.GetIndex();
+  typename InputImageType::SizeType  size  = region.GetSize();
+  
+  this->m_PaddingSize = this->GetRequiredPaddingSize();
+  
+  unsigned long numberOfPixels = 1;
+  
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_PaddedSize[d] = GetNextFFTSize( size[d] + 2 * this->m_PaddingSize[d] );
+    numberOfPixels *= this->m_PaddedSize[d];
+  }
+  
+  this->m_InputSpectrum.assign( numberOfPixels, ComplexType( 0.0, 0.0 ) );
+  
+  // Copy the input to the padded buffer, replicating the boundary pixels
+  typename InputImageType::IndexType inputIndex;
+  unsigned long n = 0;
+  
+  for( unsigned int z = 0; z < this->m_PaddedSize[2]; ++z )
+  {
+    inputIndex[2] = start[2] + vnl_math_min( vnl_math_max( 
+      static_cast<long>( z ) - static_cast<long>( this->m_PaddingSize[2] ), 0L ), static_cast<long>( size[2] ) - 1 );
+    
+    for( unsigned int y = 0; y < this->m_PaddedSize[1]; ++y )
+    {
+      inputIndex[1] = start[1] + vnl_math_min( vnl_math_max( 
+        static_cast<long>( y ) - static_cast<long>( this->m_PaddingSize[1] ), 0L ), static_cast<long>( size[1] ) - 1 );
+      
+      for( unsigned int x = 0; x < this->m_PaddedSize[0]; ++x, ++n )
+      {
+        inputIndex[0] = start[0] + vnl_math_min( vnl_math_max( 
+          static_cast<long>( x ) - static_cast<long>( this->m_PaddingSize[0] ), 0L ), static_cast<long>( size[0] ) - 1 );
+        
+        this->m_InputSpectrum[n] = ComplexType( static_cast<double>( input->GetPixel( inputIndex ) ), 0.0 );
+      }
+    }
+  }
+  
+  // VNL stores the first dimension as the slowest one
+  vnl_fft_3d<double> fft( this->m_PaddedSize[2], this->m_PaddedSize[1], this->m_PaddedSize[0] );
+  fft.transform( &this->m_InputSpectrum[0], -1 );
+  
+  this->m_SpectrumInput = input;
+  this->m_SpectrumInputMTime = input->GetMTime();
+  ++this->m_NumberOfSpectrumComputations;
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::ComputeFluxMatrixImage()
+{
+  itkDebugMacro(<<"Computing flux matrix at radius " << this->m_Radius);
+
+  const InputImageType *input = this->GetInput();
+  const OutputImageRegionType outputRegion = this->GetOutput()->GetRequestedRegion();
+  
+  this->m_FluxMatrixImage = FluxMatrixImageType::New();
+  this->m_FluxMatrixImage->CopyInformation( input );
+  this->m_FluxMatrixImage->SetRegions( outputRegion );
+  this->m_FluxMatrixImage->Allocate();
+  
+  // Frequencies (in cycles per physical unit) for each dimension
+  std::vector<double> frequencies[ImageDimension];
+  
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    const unsigned int n = this->m_PaddedSize[d];
+    const double length = n * input->GetSpacing()[d];
+    
+    frequencies[d].resize( n );
+    
+    for( unsigned int k = 0; k < n; ++k )
+      frequencies[d][k] = ( ( k <= n / 2 ) ? static_cast<double>( k ) : static_cast<double>( k ) - n ) / length;
+  }
+  
+  const unsigned long numberOfPixels = this->m_InputSpectrum.size();
+  
+  const double twoPiRadius = 2.0 * vnl_math::pi * this->m_Radius;
+  const double gaussianFactor = 2.0 * vnl_math::pi * vnl_math::pi * this->m_Sigma * this->m_Sigma;
+  
+  // Normalization of the inverse transform and optionally by the area of the sphere
+  double normalization = 1.0 / static_cast<double>( numberOfPixels );
+  
+  if( this->m_NormalizeAcrossScale )
+    normalization /= 4.0 * vnl_math::pi * this->m_Radius * this->m_Radius;
+  
+  vnl_fft_3d<double> fft( this->m_PaddedSize[2], this->m_PaddedSize[1], this->m_PaddedSize[0] );
+  ComplexBufferType work( numberOfPixels );
+  
+  const typename InputImageType::IndexType inputStart = input->GetBufferedRegion().GetIndex();
+  
+  unsigned int component = 0;
+  
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+  {
+    for( unsigned int j = i; j < ImageDimension; ++j, ++component )
+    {
+      // Multiply the spectrum of the input by the transfer function of the second derivative 
+      // (ij) of the gaussian convolved with the ball of the given radius
+      //   H(u) = 4 pi r u_i u_j / |u|^2 ( cos( 2 pi r |u| ) - sin( 2 pi r |u| ) / ( 2 pi r |u| ) ) exp( -2 pi^2 sigma^2 |u|^2 )
+      unsigned long n = 0;
+      double u[3];
+      
+      for( unsigned int z = 0; z < this->m_PaddedSize[2]; ++z )
+      {
+        u[2] = frequencies[2][z];
+        
+        for( unsigned int y = 0; y < this->m_PaddedSize[1]; ++y )
+        {
+          u[1] = frequencies[1][y];
+          
+          for( unsigned int x = 0; x < this->m_PaddedSize[0]; ++x, ++n )
+          {
+            u[0] = frequencies[0][x];
+            
+            const double u2 = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+            
+            if( u2 == 0.0 )
+            {
+              work[n] = ComplexType( 0.0, 0.0 );
+              continue;
+            }
+            
+            const double uNorm = vcl_sqrt( u2 );
+            const double phase = twoPiRadius * uNorm;
+            
+            const double transfer = 2.0 * twoPiRadius * u[i] * u[j] / u2 * 
+              ( vcl_cos( phase ) - vcl_sin( phase ) / phase ) * vcl_exp( -gaussianFactor * u2 );
+              
+            work[n] = this->m_InputSpectrum[n] * transfer;
+          }
+        }
+      }
+      
+      fft.transform( &work[0], +1 );
+      
+      // Store the real part of the current component in the output requested region
+      typedef itk::ImageRegionIteratorWithIndex<FluxMatrixImageType>  FluxIteratorType;
+      FluxIteratorType fit( this->m_FluxMatrixImage, outputRegion );
+      
+      for( fit.GoToBegin(); !fit.IsAtEnd(); ++fit )
+      {
+        const typename FluxMatrixImageType::IndexType & index = fit.GetIndex();
+        
+        unsigned long offset = 0;
+        for( int d = ImageDimension - 1; d >= 0; --d )
+          offset = offset * this->m_PaddedSize[d] + ( index[d] - inputStart[d] + this->m_PaddingSize[d] );
+          
+        fit.Value()[component] = work[offset].real() * normalization;
+      }
+    }
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::BeforeThreadedGenerateData()
+{
+  if( ImageDimension != 3 )
+    itkExceptionMacro(<<"OptimallyOrientedFluxImageFilter only supports 3D images");
+    
+  if( this->m_Radius <= 0.0 )
+    itkExceptionMacro(<<"Radius must be greater than zero");
+    
+  const InputImageType *input = this->GetInput();
+  
+  // The spectrum is reused if the input has not changed and the padding is enough for the current radius
+  bool validSpectrum = !this->m_InputSpectrum.empty() && this->m_SpectrumInput == input && 
+    this->m_SpectrumInputMTime == input->GetMTime();
+    
+  const SizeType requiredPadding = this->GetRequiredPaddingSize();
+  
+  for( unsigned int d = 0; d < ImageDimension && validSpectrum; ++d )
+  {
+    if( requiredPadding[d] > this->m_PaddingSize[d] )
+      validSpectrum = false;
+  }
+  
+  if( !validSpectrum )
+    this->ComputeInputSpectrum();
+    
+  this->ComputeFluxMatrixImage();
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId )
+{
+  typedef itk::ImageRegionConstIterator<FluxMatrixImageType>  FluxIteratorType;
+  typedef itk::ImageRegionIterator<OutputImageType>           OutputIteratorType;
+  
+  FluxIteratorType   fit( this->m_FluxMatrixImage, outputRegionForThread );
+  OutputIteratorType oit( this->GetOutput(), outputRegionForThread );
+  
+  EigenVectorsMatrixType   eigenVectors;
+  EigenValuesArrayType     eigenValues;
+  
+  for( fit.GoToBegin(), oit.GoToBegin(); !fit.IsAtEnd(); ++fit, ++oit )
+  {
+    fit.Get().ComputeEigenAnalysis( eigenValues, eigenVectors );
+    oit.Set( static_cast<OutputPixelType>( this->m_EigenvalueFunctor.Evaluate( eigenValues, eigenVectors ) ) );
+  }
+}
+
+
+template <class TInputImage, class TOutputImage, class TEigenvalueFunctor>
+void
+OptimallyOrientedFluxImageFilter<TInputImage,TOutputImage,TEigenvalueFunctor>
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Radius: " << this->m_Radius << std::endl;
+  os << indent << "MaximumRadius: " << this->m_MaximumRadius << std::endl;
+  os << indent << "Sigma: " << this->m_Sigma << std::endl;
+  os << indent << "NormalizeAcrossScale: " << this->m_NormalizeAcrossScale << std::endl;
+  os << indent << "PaddedSize: " << this->m_PaddedSize << std::endl;
+  os << indent << "PaddingSize: " << this->m_PaddingSize << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
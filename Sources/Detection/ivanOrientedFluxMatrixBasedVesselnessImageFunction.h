@@ -32,6 +32,7 @@ SUCH DAMAGE.
 
 #include "ivanMacros.h"
 #include "ivanSphereGridBasedImageFunction.h"
+#include "ivanBufferInteriorRegion.h"
 
 #include "itkSymmetricSecondRankTensor.h"
 
@@ -56,6 +57,10 @@ namespace ivan
  * EvaluateFluxMatrix() but it should be treated as abstract in terms of obtaining a vesselness
  * response. By default it returns 0.0 and a warning. 
  *
+ * Initialize() computes the centers whose sphere lies inside the buffer of the vector field. 
+ * For these centers the sphere points are evaluated without the IsInsideBuffer() test of 
+ * each point, which is only done near the borders.
+ *
  *
  * \par REFERENCES
  * Law, M.W.K. and Chung, A.C.S. "Three Dimensional Curvilinear Structure Detection Using Optimally 
@@ -96,6 +101,10 @@ public:
   
   typedef typename VectorFieldType::OutputType       VectorType;
   
+  /** Centers whose sphere points need no bounds checks. */
+  typedef BufferInteriorRegion
+    <typename VectorFieldType::InputImageType,TCoordRep>  SphereInteriorType;
+  
   typedef itk::SymmetricSecondRankTensor<TCoordRep,
     ITKImageDimensionMacro( TInputImage ) >                   FluxMatrixType;
   typedef typename FluxMatrixType::EigenVectorsMatrixType     EigenVectorsMatrixType;
@@ -133,6 +142,11 @@ public:
     { return m_VectorField.GetPointer(); }
   const VectorFieldType * GetVectorField() const
     { return m_VectorField.GetPointer(); }
+  
+  /** Initialize the sphere tables and the interior region of the vector field where the
+    * sphere points are not checked. Call this method after setting the input image of the 
+    * vector field and after any change of the radius. */
+  virtual void Initialize();
 
   /** Evalutate the function at specified point */
   virtual OutputType Evaluate( const PointType& point ) const;
@@ -186,9 +200,10 @@ private:
 
 protected:
 
-  mutable NormalVectorContainerType    m_SphereNormals;
-  
   VectorFieldPointer                   m_VectorField;
+  
+  /** Interior of the vector field for the radius of the last Initialize(). */
+  SphereInteriorType                   m_SphereInterior;
 };
 
 } // namespace ivan
@@ -79,6 +79,20 @@ OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField,TOutput,
 }
 
 
+template <class TInputImage, class TVectorField, class TOutput, class TCoordRep>
+void
+OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField,TOutput,TCoordRep>
+::Initialize()
+{
+  Superclass::Initialize();
+  
+  // The sphere points are at the radius from the center and only IsInsideBuffer() is tested
+  // for them, so there is no margin
+  this->m_SphereInterior.SetImage( this->m_VectorField->GetInputImage() );
+  this->m_SphereInterior.Compute( this->m_Radius, 0.0 );
+}
+
+
 /** Evaluate the function at the specifed index */
 template <class TInputImage, class TVectorField, class TOutput, class TCoordRep>
 typename OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField,TOutput,TCoordRep>::OutputType
@@ -116,42 +130,36 @@ typename OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField
 OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField,TOutput,TCoordRep>
 ::EvaluateFluxMatrix( const PointType& point ) const
 {
-  typename SphereType::PointsContainer *spherePoints = this->m_Sphere->GetPoints();
-  typename SphereType::PointsContainerIterator pointIterator = spherePoints->Begin();
+  // Sphere normals and offsets are precomputed in Initialize(), so this method does not  
+  // modify the state of the function and can be called concurrently
+  const unsigned int numberOfPoints = this->m_NumberOfSpherePoints;
+  const double *normals = numberOfPoints ? &this->GetSphereNormalTable()[0] : 0;
+  const double *offsets = numberOfPoints ? &this->m_SphereOffsetTable[0] : 0;
+  const double *weights = numberOfPoints ? &this->GetSphereWeightTable()[0] : 0;
   
-  this->m_SphereNormals.clear();
-  this->m_SphereNormals.resize( spherePoints->Size() );
-    
-  NormalVectorType  currentNormal;
   PointType         currentPoint;
   VectorType        currentVector; // for the field, i.e. the gradient vector
   
-  unsigned int pointIdx = 0;
+  // Points of spheres far from the border are not checked. The interior is not used if the
+  // radius or the vector field changed after Initialize()
+  const bool checkInside = !( this->m_SphereInterior.GetRadius() == this->m_Radius &&
+    this->m_SphereInterior.GetImage() == this->m_VectorField->GetInputImage() &&
+    this->m_SphereInterior.IsInside( point ) );
   
   // Initialize Q matrix
   FluxMatrixType fluxMatrix;
   fluxMatrix.Fill( 0.0 );
   
-  while( pointIterator != spherePoints->End() )
+  for( unsigned int pointIdx = 0; pointIdx < numberOfPoints; ++pointIdx )
   {
-    for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-      currentNormal[dim] = pointIterator.Value()[dim];
-    
-    currentNormal.Normalize();
-    
-    this->m_SphereNormals[pointIdx++] = currentNormal;
-       
     // Calculate current point on sphere (sphere points have origin at (0,0,0)     
     for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-      currentPoint[dim] = point[dim] + this->m_Radius * currentNormal[dim];
+      currentPoint[dim] = point[dim] + offsets[dim * numberOfPoints + pointIdx];
     
-    if( this->m_VectorField->IsInsideBuffer( currentPoint ) )
+    if( !checkInside || this->m_VectorField->IsInsideBuffer( currentPoint ) )
       currentVector = this->m_VectorField->Evaluate( currentPoint );
     else
-    {
-      ++pointIterator;
       continue;
-    }
     
     // Compute elements of the Q matrix
     
@@ -163,11 +171,9 @@ OrientedFluxMatrixBasedVesselnessImageFunction<TInputImage,TVectorField,TOutput,
       {
         // We have to sum to the previous value since we all calculating the integral 
         // for all points on the sphere surface
-        fluxMatrix[idx++] += currentVector[i] * currentNormal[j];
+        fluxMatrix[idx++] += weights[pointIdx] * currentVector[i] * normals[j * numberOfPoints + pointIdx];
       }      
     }
-        
-    ++pointIterator;    
   }
 
   return fluxMatrix;
@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanPolarProfileVesselnessImageFunction_h
 #define __ivanPolarProfileVesselnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanSphereGridBasedImageFunction.h"
 
 #include "itkImageFunction.h"
@@ -49,6 +50,11 @@ namespace ivan
  * This base class performs partitioning of space in polar coordinates. Subclasses must define
  * how vesselness is calculated according to the corresponding profiles.
  *
+ * The sector geometry and the spatial weights only depend on the parameters, so the continuous 
+ * index offsets of the radial samples of every sector and the weights of the samples are 
+ * precomputed in Initialize() (and again in SetInputImage() for a new image geometry). 
+ * Evaluation is then a linear scan of the offset table from the center index.
+ *
  */
 template <class TInputImage, class TOutput, class TCoordRep=double>
 class ITK_EXPORT PolarProfileVesselnessImageFunction :
@@ -78,11 +84,14 @@ public:
   typedef typename Superclass::SphereSourcePointer   SphereSourcePointer;
   typedef typename Superclass::SphereType            SphereType;
   typedef typename Superclass::SpherePointer         SpherePointer;
+  typedef typename Superclass::SphereTableType       SphereTableType;
   
   typedef itk::LinearInterpolateImageFunction
     <TInputImage>                                    InterpolatorType;
   typedef typename InterpolatorType::Pointer         InterpolatorPointer;
     
+  /** Weighting of the radial samples. Gaussian weighting uses a Gaussian of the distance to the 
+    * center with standard deviation equal to the radius. */
   enum SpatialWeightingType
   {
     UniformSpatialWeighting,
@@ -117,6 +126,10 @@ public:
    * If the BufferedRegion has changed, user must call
    * SetInputImage again to update cached values. */
   virtual void SetInputImage( const InputImageType * ptr );
+  
+  /** Initialize the sphere and precompute the sample offset and weight tables. This method 
+    * MUST be called after any changes to function parameters. */
+  virtual void Initialize();
 
   /** Evalutate the  in the given dimension at specified point */
   virtual OutputType Evaluate( const PointType& point ) const;
@@ -133,6 +146,13 @@ protected:
   virtual ~PolarProfileVesselnessImageFunction() {};
     
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Compute the continuous index offsets of the radial samples for the current input image
+    * and the weights of the samples. */
+  virtual void ComputeSampleTables();
+  
+  /** Compute the vesselness from the profiles around the given center, with the given center value. */
+  OutputType EvaluateProfiles( const ContinuousIndexType & cindex, double centerValue ) const;
 
 private:
   
@@ -158,6 +178,13 @@ protected:
   
   /** Gamma parameter for the exponential that makes the brightness term. */
   double                 m_Gamma;
+  
+  /** Continuous index offsets of the radial samples, one block per dimension. Sample i of 
+    * sector s is at position s * RadialResolution + i within each block. */
+  SphereTableType        m_SampleIndexOffsetTable;
+  
+  /** Spatial weights of the radial samples, depending on the distance to the center. */
+  std::vector<double>    m_RadialWeightTable;
 };
 
 } // namespace ivan
@@ -169,7 +196,7 @@ protected:
                                                   PolarProfileVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanPolarProfileVesselnessImageFunction+-.h"
 #endif
 
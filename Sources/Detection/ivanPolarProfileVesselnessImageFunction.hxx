@@ -79,6 +79,77 @@ PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   Superclass::SetInputImage( ptr );
   
   this->m_Interpolator->SetInputImage( ptr );
+  
+  // The index offsets depend on the image geometry
+  if( this->m_NumberOfSpherePoints )
+    this->ComputeSampleTables();
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::Initialize()
+{
+  Superclass::Initialize();
+  
+  this->ComputeSampleTables();
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::ComputeSampleTables()
+{
+  const unsigned int dimension = TInputImage::GetImageDimension();
+  const unsigned int numberOfSectors = this->m_NumberOfSpherePoints;
+  const unsigned int radialResolution = this->m_RadialResolution;
+  const unsigned int numberOfSamples = numberOfSectors * radialResolution;
+  
+  const double samplingDistance = this->m_Radius / radialResolution;
+  
+  // Spatial weights of the samples
+  this->m_RadialWeightTable.assign( radialResolution, 1.0 );
+  
+  if( this->m_SpatialWeightingType == GaussianSpatialWeighting )
+  {
+    for( unsigned int i=0; i < radialResolution; ++i )
+    {
+      const double distance = (double)( i + 1 ) * samplingDistance / this->m_Radius;
+      this->m_RadialWeightTable[i] = vcl_exp( -0.5 * distance * distance );
+    }
+  }
+  
+  // Offsets of the samples in index space. The origin maps to the zero index, so transforming the
+  // origin plus the physical offset gives the index offset.
+  this->m_SampleIndexOffsetTable.assign( dimension * numberOfSamples, 0.0 );
+  
+  const InputImageType *image = this->GetInputImage();
+  
+  if( !image )
+    return;
+  
+  const SphereTableType & normalTable = this->GetSphereNormalTable();
+  
+  PointType samplePoint;
+  ContinuousIndexType sampleIndex;
+  unsigned int sample = 0;
+  
+  for( unsigned int s=0; s < numberOfSectors; ++s )
+  {
+    for( unsigned int i=0; i < radialResolution; ++i, ++sample )
+    {
+      for( unsigned int dim = 0; dim < dimension; ++dim )
+        samplePoint[dim] = image->GetOrigin()[dim] + 
+          normalTable[dim * numberOfSectors + s] * (double)( i + 1 ) * samplingDistance;
+      
+      image->TransformPhysicalPointToContinuousIndex( samplePoint, sampleIndex );
+      
+      for( unsigned int dim = 0; dim < dimension; ++dim )
+        this->m_SampleIndexOffsetTable[dim * numberOfSamples + sample] = sampleIndex[dim];
+    }
+  }
 }
 
 
@@ -88,10 +159,13 @@ typename PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::Out
 PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::EvaluateAtIndex( const IndexType& index ) const
 {
-  PointType point;
-  this->GetInputImage()->TransformIndexToPhysicalPoint( index, point );
+  ContinuousIndexType cindex;
+  
+  for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
+    cindex[dim] = index[dim];
   
-  return this->Evaluate( point ); 
+  // No need to interpolate at the center
+  return this->EvaluateProfiles( cindex, this->GetInputImage()->GetPixel( index ) ); 
 }
 
 
@@ -101,50 +175,66 @@ typename PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::Out
 PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::Evaluate( const PointType& point ) const
 {
-  assert( this->m_Sphere.IsNotNull() );
+  ContinuousIndexType cindex;
+  this->GetInputImage()->TransformPhysicalPointToContinuousIndex( point, cindex );
   
-  typename SphereType::PointsContainer *spherePoints = this->m_Sphere->GetPoints();
-  typename SphereType::PointsContainerIterator pointIterator = spherePoints->Begin();
-  typename SphereType::PointsContainerIterator minPointIterator = pointIterator;
-    
-  std::vector<TOutput> sectorValues( spherePoints->Size(), 0.0 );
-  std::vector<TOutput> entropyValues( spherePoints->Size(), 0.0 );
+  return this->EvaluateAtContinuousIndex( cindex ); 
+}
+
+
+/** Evaluate the function at specified ContinousIndex position.*/
+template <class TInputImage, class TOutput, class TCoordRep>
+typename PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateAtContinuousIndex( const ContinuousIndexType & cindex ) const
+{
+  return this->EvaluateProfiles( cindex, this->m_Interpolator->EvaluateAtContinuousIndex( cindex ) ); 
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateProfiles( const ContinuousIndexType & cindex, double centerValue ) const
+{
+  assert( this->m_NumberOfSpherePoints > 0 );
+  assert( !this->m_SampleIndexOffsetTable.empty() );
+  
+  const unsigned int dimension = TInputImage::GetImageDimension();
+  const unsigned int numberOfSectors = this->m_NumberOfSpherePoints;
+  const unsigned int radialResolution = this->m_RadialResolution;
+  const unsigned int numberOfSamples = numberOfSectors * radialResolution;
+  
+  const double *offsetTable = &this->m_SampleIndexOffsetTable[0];
+  const double *weightTable = &this->m_RadialWeightTable[0];
     
-  const double weightingValue = 1.0; // TO MODIFY DEPENDING ON m_SpatialWeightingType
-  const double samplingDistance = this->m_Radius / this->m_RadialResolution;
+  std::vector<TOutput> sectorValues( numberOfSectors, 0.0 );
   
-  double centerValue = this->m_Interpolator->Evaluate( point );
   double sampleValue = 0.0;
   double sectorValuesTotal = 0.0;
   
-  typedef itk::Vector<double,3>   VectorType;
-  VectorType radialVector;
-  PointType  samplePoint;
+  ContinuousIndexType sampleIndex;
   
   // Variables used to calculate the sectors with minimum and maximum deviation
-  unsigned int sectorNum = 0, maxDevIdx = 0, minDevIdx = 0;    
+  unsigned int maxDevIdx = 0, minDevIdx = 0;    
   double maxDev = itk::NumericTraits<double>::min(), minDev = itk::NumericTraits<double>::max();
-  std::vector<TOutput> minIntensityValues( this->m_RadialResolution, 0.0 );
   
-  while( pointIterator != spherePoints->End() )
+  unsigned int sample = 0;
+  
+  for( unsigned int sectorNum = 0; sectorNum < numberOfSectors; ++sectorNum )
   {
-    for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-      radialVector[dim] = pointIterator.Value()[dim];
-    
-    radialVector.Normalize();
-    
-    for( unsigned int i=1; i < this->m_RadialResolution + 1; ++i )
+    for( unsigned int i=0; i < radialResolution; ++i, ++sample )
     {      
-      // Add the corresponding radial distance to the sampling point      
-      for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-        samplePoint[dim] = point[dim] + radialVector[dim] * (double)i * samplingDistance;
+      // Add the precomputed offset of the sample to the center
+      for( unsigned int dim = 0; dim < dimension; ++dim )
+        sampleIndex[dim] = cindex[dim] + offsetTable[dim * numberOfSamples + sample];
 
-      if( m_Interpolator->IsInsideBuffer( samplePoint ) )
-        sampleValue = m_Interpolator->Evaluate( samplePoint );
+      if( m_Interpolator->IsInsideBuffer( sampleIndex ) )
+        sampleValue = m_Interpolator->EvaluateAtContinuousIndex( sampleIndex );
       else
         sampleValue = 0.0;
       
-      sectorValues[sectorNum] += ( sampleValue - centerValue ) * ( sampleValue - centerValue );
+      sectorValues[sectorNum] += weightTable[i] * ( sampleValue - centerValue ) * ( sampleValue - centerValue );
     }
     
     if( sectorValues[sectorNum] > maxDev )
@@ -157,42 +247,31 @@ PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
     {
       minDev = sectorValues[sectorNum];
       minDevIdx = sectorNum;
-      minPointIterator = pointIterator;
     }
     
     // Now reuse the vector to calculate probability
     sectorValues[sectorNum] = vcl_exp( - m_Beta * sectorValues[sectorNum] / ( m_Sigma * m_Sigma ) );
     sectorValuesTotal += sectorValues[sectorNum];
-    
-    ++pointIterator;
-    ++sectorNum;
   }
   
-  // Recover the intensity values within the region with minimum deviation and calculate their mean
-  
-  for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-    radialVector[dim] = minPointIterator.Value()[dim];
-    
-  radialVector.Normalize();
+  // Recover the intensity values within the sector with minimum deviation and calculate their mean.
+  // As in the original implementation, the outermost sample of the sector is not included.
   
   minDev = 0.0;
   
-  for( unsigned int i=1; i < minIntensityValues.size(); ++i )
+  for( unsigned int i=0; i+1 < radialResolution; ++i )
   {      
-    // Add the corresponding radial distance to the sampling point      
-    for( unsigned int dim = 0; dim < TInputImage::GetImageDimension(); ++dim )
-      samplePoint[dim] = point[dim] + radialVector[dim] * (double)i * samplingDistance;
+    sample = minDevIdx * radialResolution + i;
+    
+    for( unsigned int dim = 0; dim < dimension; ++dim )
+      sampleIndex[dim] = cindex[dim] + offsetTable[dim * numberOfSamples + sample];
 
-    if( m_Interpolator->IsInsideBuffer( samplePoint ) )
-      minIntensityValues[i-1] = m_Interpolator->Evaluate( samplePoint );
-    else
-      minIntensityValues[i-1] = 0.0;
-      
-    minDev += minIntensityValues[i-1];      
+    if( m_Interpolator->IsInsideBuffer( sampleIndex ) )
+      minDev += m_Interpolator->EvaluateAtContinuousIndex( sampleIndex );
   }
   
   // Calculate mean    
-  minDev /= (double)minIntensityValues.size();
+  minDev /= (double)radialResolution;
   
   
   // Now we can normalize the probability distribution so all values sum exactly one
@@ -201,14 +280,12 @@ PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   
   for( unsigned int i=0; i<sectorValues.size(); ++i )
   {
-    entropyValues[i] = sectorValues[i] * vcl_log( sectorValues[i] );
-	  
-	if( sectorValuesTotal > 1e-6 )
+    if( sectorValuesTotal > 1e-6 )
       sectorValues[i] /= sectorValuesTotal;
     else
       sectorValues[i] = 0.0;
 
-	if( sectorValues[i] > 1e-6 )
+    if( sectorValues[i] > 1e-6 )
       entropy += sectorValues[i] * vcl_log( sectorValues[i] );
       // The VTK implementation uses log but shouldn't be log10???
       //entropy += sectorValues[i] * vcl_log10( sectorValues[i] ); 
@@ -224,19 +301,6 @@ PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   return vesselness;
 }
 
-
-/** Evaluate the function at specified ContinousIndex position.*/
-template <class TInputImage, class TOutput, class TCoordRep>
-typename PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
-PolarProfileVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
-::EvaluateAtContinuousIndex( const ContinuousIndexType & cindex ) const
-{
-  PointType point;
-  this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( cindex, point );
-  
-  return this->Evaluate( point ); 
-}
-
 } // end namespace ivan
 
 #endif
@@ -0,0 +1,199 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanResponseImageFunction.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Vesselness function sampling precomputed response and scale images.
+// Date: 2012/11/05
+
+#ifndef __ivanResponseImageFunction_h
+#define __ivanResponseImageFunction_h
+
+#include "itkImageFunction.h"
+
+
+namespace ivan
+{
+/**
+ * \class ResponseImageFunction
+ * \brief Vesselness function that samples a precomputed response image, and optionally the
+ *        scale image of the same detection, by linear interpolation.
+ *
+ * The trackers evaluate their vesselness function at every search sample, which for functions
+ * computed from the input image, such as Frangi's vesselness or the offset medialness, means a
+ * convolution per sample. When the multiscale response and the scale at which it was obtained 
+ * have already been computed for the whole image, for example by MultiscaleMedialnessImageFilter,
+ * this function provides the vesselness function interface on them, so the trackers run at 
+ * lookup speed.
+ *
+ * The response and scale images are set with SetResponseImage() and SetScaleImage(), and are 
+ * independent from the input image, which is the one given to the function by the initializer of
+ * the tracker and in whose index space EvaluateAtIndex() and EvaluateAtContinuousIndex() are 
+ * interpreted (the response image index space if no input image is set). The response and scale 
+ * images are templated so any image with GetPixel() can be used, including SparseBlockedImage.
+ * The values are interpolated linearly between the 2^N surrounding pixels and IsInsideBuffer() 
+ * refers to the buffer of the response image.
+ *
+ * The trackers initialize their function with the scale of the current section. If a scale
+ * image is set and ScaleTolerance is positive, the response is weighted by 
+ * exp( -log( s / scale )^2 / ( 2 ScaleTolerance^2 ) ), where s is the interpolated scale of the
+ * response, so responses obtained at scales far from the current one, such as those of a 
+ * neighbouring larger vessel, are attenuated. Use ResponseImageFunctionInitializer to set the 
+ * scale from the trackers. EvaluateScale() returns the interpolated scale.
+ *
+ * \sa ResponseImageFunctionInitializer
+ * \sa MultiscaleMedialnessImageFilter
+ */
+template< class TInputImage, class TResponseImage = TInputImage, 
+  class TScaleImage = TResponseImage, class TCoordRep = double >
+class ITK_EXPORT ResponseImageFunction:
+  public itk::ImageFunction< TInputImage, double, TCoordRep >
+{
+public:
+
+  /**Standard "Self" typedef */
+  typedef ResponseImageFunction           Self;
+
+  /** Standard "Superclass" typedef */
+  typedef itk::ImageFunction< TInputImage, double, TCoordRep >   Superclass;
+
+  /** Smart pointer typedef support */
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods) */
+  itkTypeMacro( ResponseImageFunction, ImageFunction );
+
+  /** Image dependent types */
+  typedef typename Superclass::InputImageType      InputImageType;
+  typedef typename Superclass::InputPixelType      InputPixelType;
+  typedef typename Superclass::IndexType           IndexType;
+  typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
+  typedef typename Superclass::PointType           PointType;
+  typedef typename Superclass::OutputType          OutputType;
+
+  /** Dimension of the underlying image */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+
+  /** Response and scale images. */
+  typedef TResponseImage                           ResponseImageType;
+  typedef typename ResponseImageType::ConstPointer ResponseImageConstPointer;
+  typedef TScaleImage                              ScaleImageType;
+  typedef typename ScaleImageType::ConstPointer    ScaleImageConstPointer;
+
+public:
+
+  /** Evalutate the function at specified point */
+  virtual OutputType Evaluate(const PointType & point) const;
+
+  /** Evaluate the function at specified Index position */
+  virtual OutputType EvaluateAtIndex(const IndexType & index) const;
+
+  /** Evaluate the function at specified ContinousIndex position */
+  virtual OutputType EvaluateAtContinuousIndex(
+    const ContinuousIndexType & index) const;
+
+  /** Get the interpolated scale at the specified point, zero if no scale image is set. */
+  virtual double EvaluateScale(const PointType & point) const;
+
+  /** Check if a point is inside the buffer of the response image. */
+  virtual bool IsInsideBuffer(const PointType & point) const;
+
+  /** Check if an index of the input image is inside the buffer of the response image. */
+  virtual bool IsInsideBuffer(const IndexType & index) const;
+
+  /** Check if a continuous index of the input image is inside the buffer of the response image. */
+  virtual bool IsInsideBuffer(const ContinuousIndexType & index) const;
+
+  /** Set/Get the precomputed response image. */
+  virtual void SetResponseImage(const ResponseImageType *image);
+  const ResponseImageType * GetResponseImage() const
+    { return m_ResponseImage.GetPointer(); }
+
+  /** Set/Get the scale image of the response, for example the scale output of a multiscale 
+   * filter. Optional, and it must have the geometry of the response image. */
+  virtual void SetScaleImage(const ScaleImageType *image);
+  const ScaleImageType * GetScaleImage() const
+    { return m_ScaleImage.GetPointer(); }
+
+  /** Set/Get the scale at which the function is evaluated. Default is 0.0. */
+  itkSetMacro(Scale, double);
+  itkGetConstMacro(Scale, double);
+
+  /** Convenience method for initializers setting the scale as the standard deviation. */
+  void SetSigma(const double sigma)
+  {
+    SetScale(sigma);
+  }
+
+  /** Set/Get the tolerance, in logarithmic scale units, of the weighting of the response by the 
+   * distance between its scale and the current scale. Zero disables the weighting. Default is 0.0. */
+  itkSetMacro(ScaleTolerance, double);
+  itkGetConstMacro(ScaleTolerance, double);
+
+  /** Nothing to precompute, provided for consistency with the other vesselness functions. */
+  virtual void Initialize() {}
+
+protected:
+
+  ResponseImageFunction();
+  ~ResponseImageFunction(){}
+
+  void PrintSelf(std::ostream & os, itk::Indent indent) const;
+
+  /** Linear interpolation of an image at a continuous index inside its buffer. */
+  template< class TImage >
+  static double InterpolateAtContinuousIndex(const TImage *image, 
+    const ContinuousIndexType & index);
+
+  /** Continuous index in the response image of a point, false if out of the buffer. */
+  bool GetResponseContinuousIndex(const PointType & point, ContinuousIndexType & index) const;
+
+  /** Physical point of an index of the input image, or of the response image if no input
+   * image is set. */
+  PointType GetPointOfContinuousIndex(const ContinuousIndexType & index) const;
+
+private:
+
+  ResponseImageFunction(const Self &); //purposely not implemented
+  void operator=(const Self &); //purposely not implemented
+
+  ResponseImageConstPointer m_ResponseImage;
+  ScaleImageConstPointer    m_ScaleImage;
+
+  double m_Scale;
+  double m_ScaleTolerance;
+};
+
+} // namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanResponseImageFunction.hxx"
+#endif
+
+#endif
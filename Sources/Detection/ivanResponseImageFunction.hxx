@@ -0,0 +1,321 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanResponseImageFunction.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Vesselness function sampling precomputed response and scale images.
+// Date: 2012/11/05
+
+#ifndef __ivanResponseImageFunction_hxx
+#define __ivanResponseImageFunction_hxx
+
+#include "ivanResponseImageFunction.h"
+
+#include <cmath>
+
+
+namespace ivan
+{
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::ResponseImageFunction() :
+  m_Scale( 0.0 ),
+  m_ScaleTolerance( 0.0 )
+{
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+void
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::SetResponseImage(const ResponseImageType *image)
+{
+  if( m_ResponseImage != image )
+  {
+    m_ResponseImage = image;
+    this->Modified();
+  }
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+void
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::SetScaleImage(const ScaleImageType *image)
+{
+  if( m_ScaleImage != image )
+  {
+    m_ScaleImage = image;
+    this->Modified();
+  }
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+template< class TImage >
+double
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::InterpolateAtContinuousIndex(const TImage *image, 
+  const ContinuousIndexType & index)
+{
+  const typename TImage::RegionType & region = image->GetBufferedRegion();
+
+  // Lower neighbour and distance to it, with the neighbours clamped to the buffer
+  typename TImage::IndexType baseIndex;
+  double distance[ImageDimension];
+
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    const long first = region.GetIndex()[d];
+    const long last = first + static_cast< long >( region.GetSize()[d] ) - 1;
+
+    baseIndex[d] = static_cast< long >( std::floor( index[d] ) );
+    distance[d] = index[d] - baseIndex[d];
+
+    if( baseIndex[d] >= last )
+    {
+      baseIndex[d] = last;
+      distance[d] = 0.0;
+    }
+    else if( baseIndex[d] < first )
+    {
+      baseIndex[d] = first;
+      distance[d] = 0.0;
+    }
+  }
+
+  double value = 0.0;
+
+  for( unsigned int neighbour = 0; neighbour < ( 1u << ImageDimension ); ++neighbour )
+  {
+    typename TImage::IndexType neighbourIndex = baseIndex;
+    double weight = 1.0;
+
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      if( neighbour & ( 1u << d ) )
+      {
+        // Skip the upper neighbour if it has no weight, it may be out of the buffer
+        if( distance[d] == 0.0 )
+        {
+          weight = 0.0;
+          break;
+        }
+
+        ++neighbourIndex[d];
+        weight *= distance[d];
+      }
+      else
+      {
+        weight *= 1.0 - distance[d];
+      }
+    }
+
+    if( weight != 0.0 )
+    {
+      value += weight * static_cast< double >( image->GetPixel( neighbourIndex ) );
+    }
+  }
+
+  return value;
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+bool
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::GetResponseContinuousIndex(const PointType & point, ContinuousIndexType & index) const
+{
+  if( m_ResponseImage.IsNull() )
+  {
+    itkExceptionMacro( << "Response image not set" );
+  }
+
+  m_ResponseImage->TransformPhysicalPointToContinuousIndex( point, index );
+
+  const typename ResponseImageType::RegionType & region = m_ResponseImage->GetBufferedRegion();
+
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    const double first = region.GetIndex()[d] - 0.5;
+    const double last = region.GetIndex()[d] + static_cast< double >( region.GetSize()[d] ) - 0.5;
+
+    if( index[d] < first || index[d] >= last )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+typename ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >::PointType
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::GetPointOfContinuousIndex(const ContinuousIndexType & index) const
+{
+  PointType point;
+
+  if( this->GetInputImage() )
+  {
+    this->GetInputImage()->TransformContinuousIndexToPhysicalPoint( index, point );
+  }
+  else if( m_ResponseImage.IsNotNull() )
+  {
+    m_ResponseImage->TransformContinuousIndexToPhysicalPoint( index, point );
+  }
+  else
+  {
+    itkExceptionMacro( << "Response image not set" );
+  }
+
+  return point;
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+typename ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >::OutputType
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::Evaluate(const PointType & point) const
+{
+  ContinuousIndexType index;
+
+  if( !this->GetResponseContinuousIndex( point, index ) )
+  {
+    return 0.0;
+  }
+
+  double response = InterpolateAtContinuousIndex( m_ResponseImage.GetPointer(), index );
+
+  if( m_ScaleImage.IsNotNull() && m_ScaleTolerance > 0.0 && m_Scale > 0.0 && response != 0.0 )
+  {
+    const double scale = InterpolateAtContinuousIndex( m_ScaleImage.GetPointer(), index );
+
+    if( scale <= 0.0 )
+    {
+      return 0.0;
+    }
+
+    const double logRatio = std::log( scale / m_Scale );
+    response *= std::exp( -logRatio * logRatio / ( 2.0 * m_ScaleTolerance * m_ScaleTolerance ) );
+  }
+
+  return response;
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+typename ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >::OutputType
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::EvaluateAtIndex(const IndexType & index) const
+{
+  ContinuousIndexType continuousIndex;
+
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    continuousIndex[d] = index[d];
+  }
+
+  return this->Evaluate( this->GetPointOfContinuousIndex( continuousIndex ) );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+typename ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >::OutputType
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::EvaluateAtContinuousIndex(const ContinuousIndexType & index) const
+{
+  return this->Evaluate( this->GetPointOfContinuousIndex( index ) );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+double
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::EvaluateScale(const PointType & point) const
+{
+  ContinuousIndexType index;
+
+  if( m_ScaleImage.IsNull() || !this->GetResponseContinuousIndex( point, index ) )
+  {
+    return 0.0;
+  }
+
+  return InterpolateAtContinuousIndex( m_ScaleImage.GetPointer(), index );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+bool
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::IsInsideBuffer(const PointType & point) const
+{
+  ContinuousIndexType index;
+  return this->GetResponseContinuousIndex( point, index );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+bool
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::IsInsideBuffer(const IndexType & index) const
+{
+  ContinuousIndexType continuousIndex;
+
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    continuousIndex[d] = index[d];
+  }
+
+  return this->IsInsideBuffer( this->GetPointOfContinuousIndex( continuousIndex ) );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+bool
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::IsInsideBuffer(const ContinuousIndexType & index) const
+{
+  return this->IsInsideBuffer( this->GetPointOfContinuousIndex( index ) );
+}
+
+
+template< class TInputImage, class TResponseImage, class TScaleImage, class TCoordRep >
+void
+ResponseImageFunction< TInputImage, TResponseImage, TScaleImage, TCoordRep >
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "ResponseImage: " << m_ResponseImage.GetPointer() << std::endl;
+  os << indent << "ScaleImage: " << m_ScaleImage.GetPointer() << std::endl;
+  os << indent << "Scale: " << m_Scale << std::endl;
+  os << indent << "ScaleTolerance: " << m_ScaleTolerance << std::endl;
+}
+
+} // namespace ivan
+
+#endif
@@ -0,0 +1,93 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanResponseImageFunctionInitializer.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Initializer of the scale of functions sampling precomputed responses.
+// Date: 2012/11/05
+
+#ifndef __ivanResponseImageFunctionInitializer_h
+#define __ivanResponseImageFunctionInitializer_h
+
+
+#include "ivanImageFunctionInitializerBase.h"
+
+
+namespace ivan
+{
+
+
+/** \class ResponseImageFunctionInitializer
+ *  \brief Initializer for functions sampling precomputed responses.
+ *
+ * Sets the input image and the scale of a ResponseImageFunction, leaving its response and scale
+ * images untouched, so the function can be used by the trackers, which initialize their 
+ * vesselness function for the scale of each section.
+ *
+ * \sa ResponseImageFunction
+ */
+template <class TImageFunction, class TImage>
+class ITK_EXPORT ResponseImageFunctionInitializer : 
+  public ImageFunctionInitializerBase<TImageFunction,TImage>
+{
+public:
+  
+  typedef ResponseImageFunctionInitializer
+    <TImageFunction,TImage>                    Self;
+  typedef ImageFunctionInitializerBase
+    <TImageFunction,TImage>                    Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+
+  typedef TImageFunction                       ImageFunctionType;
+  typedef TImage                               ImageType;
+    
+public:
+  
+  itkNewMacro( Self );
+  itkTypeMacro( ResponseImageFunctionInitializer, ImageFunctionInitializerBase );
+  
+  virtual void Initialize( ImageFunctionType *imageFunction, const ImageType *image = 0, double scale = 0.0 )
+    {
+      if( image )
+        imageFunction->SetInputImage( image );
+      
+      imageFunction->SetScale( scale );
+      imageFunction->Initialize();
+    }
+  
+protected:
+  
+  ResponseImageFunctionInitializer() {}
+  virtual ~ResponseImageFunctionInitializer() {}
+  
+private:
+  
+  ResponseImageFunctionInitializer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented  
+};
+
+} // end namespace ivan
+
+#endif
@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanSatoVesselnessImageFunction_h
 #define __ivanSatoVesselnessImageFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanHessianOnlyBasedVesselnessImageFunction.h"
 
 
@@ -86,6 +87,8 @@ public:
     <TInputImage,TCoordRep>                          HessianFunctionType;
   typedef typename HessianFunctionType::Pointer      HessianFunctionPointer;
   typedef typename HessianFunctionType::TensorType   HessianTensorType;
+  typedef typename Superclass::EigenValuesArrayType  EigenValuesArrayType;
+  typedef typename Superclass::EigenValueType        EigenValueType;
     
   /** Interpolation modes */
   typedef typename Superclass::InterpolationModeType InterpolationModeType;
@@ -111,6 +114,13 @@ public:
   itkSetMacro( Gamma23, double );
   itkGetConstMacro( Gamma23, double );
   
+  /** Evaluate vesselness from the eigenvalues of the Hessian matrix, in ascending order. */
+  virtual OutputType EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const;
+  
+  /** Evaluate vesselness from the eigenvalues stored by component, without branches. */
+  virtual void EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+    unsigned long numberOfValues, OutputType * vesselness ) const;
+  
 protected:
 
   SatoVesselnessImageFunction();
@@ -146,7 +156,7 @@ private:
                                                   SatoVesselnessImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanSatoVesselnessImageFunction+-.h"
 #endif
 
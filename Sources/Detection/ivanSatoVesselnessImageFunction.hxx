@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #define __ivanSatoVesselnessImageFunction_hxx
 
 #include "ivanSatoVesselnessImageFunction.h"
+#include "ivanSymmetricEigenSolver.h"
 
 #define ZERO_TOLERANCE 1e-2
 
@@ -77,12 +78,20 @@ typename SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
 SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
 ::EvaluateVesselness( const HessianTensorType & hessian ) const
 {
-  typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
   EigenValuesArrayType   eigenValues;
   
   // Calculate eigenvalues of Hessian matrix at the current location
-  hessian.ComputeEigenValues( eigenValues );
+  SymmetricEigenSolver<HessianTensorType>::ComputeEigenValues( hessian, eigenValues );
   
+  return this->EvaluateVesselnessFromEigenValues( eigenValues );
+}
+
+
+template <class TInputImage, class TOutput, class TCoordRep>
+typename SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>::OutputType
+SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValues( const EigenValuesArrayType & eigenValues ) const
+{
   if( this->m_FilterByEigenValues )
   {
     if( eigenValues[0] >= 0.0 || eigenValues[1] >= 0.0 || eigenValues[2] >= vnl_math_abs( eigenValues[1] ) / m_Alpha )
@@ -110,6 +119,45 @@ SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
   return lineMeasure;  
 }
 
+
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+SatoVesselnessImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateVesselnessFromEigenValueComponents( const EigenValueType * const * eigenValues,
+  unsigned long numberOfValues, OutputType * vesselness ) const
+{
+  const EigenValueType *l0 = eigenValues[0];
+  const EigenValueType *l1 = eigenValues[1];
+  const EigenValueType *l2 = eigenValues[2];
+  
+  const double alpha = m_Alpha;
+  const double gamma12 = m_Gamma12;
+  const double gamma23 = m_Gamma23;
+  const bool filter = m_FilterByEigenValues;
+  
+  // Same measure as EvaluateVesselnessFromEigenValues(), with the discarded sets given by a 
+  // mask instead of early returns. Non-short-circuit operators keep the mask free of branches
+  for( unsigned long k=0; k<numberOfValues; ++k )
+  {
+    const double e0 = l0[k];
+    const double e1 = l1[k];
+    const double e2 = l2[k];
+    const double a1 = vnl_math_abs( e1 );
+    
+    const bool positive = ( e2 > 0.0 );
+    
+    bool discarded = positive & !( e2 * alpha < a1 );
+    discarded = discarded | ( filter & ( ( e0 >= 0.0 ) | ( e1 >= 0.0 ) | ( e2 >= a1 / alpha ) ) );
+    
+    const double mantissa = positive ? 1.0 - alpha * e2 / a1 : 1.0 + e2 / a1;
+    
+    const double lineMeasure = vnl_math_abs( e0 ) * vcl_pow( e1 / e0, gamma23 ) * 
+      vcl_pow( mantissa, gamma12 );
+    
+    vesselness[k] = static_cast<OutputType>( discarded ? 0.0 : lineMeasure );
+  }
+}
+
 } // end namespace ivan
 
 #endif
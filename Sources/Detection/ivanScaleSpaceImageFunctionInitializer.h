@@ -32,6 +32,7 @@ SUCH DAMAGE.
 
 
 #include "ivanImageFunctionInitializerBase.h"
+#include "ivanScaleSpacePyramid.h"
 
 
 namespace ivan
@@ -44,6 +45,12 @@ namespace ivan
  * Specific initializations for some scale-space based metric image functions. This is used in 
  * multi-scale approaches in order to initialize the functions that operate at different scales.
  *
+ * If a pyramid of the image is set, the functions are initialized with the level of the pyramid
+ * selected for the scale and with the residual scale of that level, so large scales are evaluated
+ * with small kernels. The levels only keep the physical geometry of the image, so the pyramid 
+ * must only be used for functions evaluated at physical points, as in the trackers.
+ *
+ * \sa ScaleSpacePyramid
  */
 template <class TImageFunction, class TImage>
 class ITK_EXPORT ScaleSpaceImageFunctionInitializer : 
@@ -60,14 +67,32 @@ public:
 
   typedef TImageFunction                       ImageFunctionType;
   typedef TImage                               ImageType;
+  
+  typedef ScaleSpacePyramid<TImage>            PyramidType;
+  typedef typename PyramidType::Pointer        PyramidPointer;
     
 public:
   
   itkNewMacro( Self );
   itkTypeMacro( ScaleSpaceImageFunctionInitializer, ImageFunctionInitializerBase );
   
+  /** Set/Get the pyramid of the image. Only used when the functions are initialized with the 
+    * input of the pyramid. */
+  void SetPyramid( PyramidType *pyramid )
+    { this->m_Pyramid = pyramid; }
+  PyramidType * GetPyramid()
+    { return this->m_Pyramid.GetPointer(); }
+  
   virtual void Initialize( ImageFunctionType *imageFunction, const ImageType *image = 0, double scale = 0.0 )
     {
+      if( this->m_Pyramid.IsNotNull() && image && image == this->m_Pyramid->GetInput() )
+      {
+        const unsigned int level = this->m_Pyramid->GetLevelForScale( scale );
+        
+        image = this->m_Pyramid->GetLevel( level );
+        scale = this->m_Pyramid->GetResidualSigma( scale, level );
+      }
+      
       imageFunction->SetInputImage( image );
       imageFunction->SetSigma( scale );      
       imageFunction->SetNormalizeAcrossScale( true );
@@ -84,6 +109,8 @@ private:
   
   ScaleSpaceImageFunctionInitializer(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented  
+  
+  PyramidPointer    m_Pyramid;
 };
 
 } // end namespace ivan
@@ -0,0 +1,152 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleSpacePyramid.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Downsampled image levels for the evaluation of large scales.
+// Date: 2012/11/05
+
+#ifndef __ivanScaleSpacePyramid_h
+#define __ivanScaleSpacePyramid_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class ScaleSpacePyramid
+ *  \brief Downsampled levels of an image where large scales are evaluated with small kernels.
+ *
+ * Large vessels are evaluated at scales of several millimeters, and the kernels of the 
+ * scale-space functions become very large, or are truncated by MaximumKernelWidth. Level k of the
+ * pyramid is the input smoothed with a Gaussian of standard deviation 0.5 * 2^k times the
+ * largest input spacing and shrunk by a factor of 2^k, so smoothing it with the residual scale 
+ * sqrt( scale^2 - levelSigma^2 ) equals smoothing the input with the scale.
+ *
+ * GetLevelForScale() returns the coarsest level where the residual scale is still at least 
+ * MinimumSigmaInPixels pixels of the level, so the kernels need at most a few times that radius 
+ * whatever the scale. Levels are computed on demand and kept until the input changes.
+ *
+ * Since the residual is the scale the functions are initialized with, scale-normalized 
+ * derivatives of order n computed on a level are those of the input multiplied by 
+ * ( residual / scale )^n, which is above 0.97 for the second order with the default 
+ * MinimumSigmaInPixels of 3.
+ *
+ * The levels have the physical geometry of the input but not its indices, so they can only be
+ * used by functions evaluated at physical points, as the trackers do.
+ *
+ * \sa ScaleSpaceImageFunctionInitializer
+ * \sa OffsetMedialnessImageFunctionInitializer
+ */
+template <class TImage>
+class ITK_EXPORT ScaleSpacePyramid : public itk::Object
+{
+public:
+  
+  typedef ScaleSpacePyramid                Self;
+  typedef itk::Object                      Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+  
+  typedef TImage                           ImageType;
+  typedef typename ImageType::Pointer      ImagePointer;
+  typedef typename ImageType::ConstPointer ImageConstPointer;
+  
+public:
+  
+  itkNewMacro( Self );
+  itkTypeMacro( ScaleSpacePyramid, itk::Object );
+  
+  /** Set/Get the image of level zero. Releases the computed levels. */
+  virtual void SetInput( const ImageType *image );
+  const ImageType * GetInput() const
+    { return this->m_Input.GetPointer(); }
+  
+  /** Set/Get the maximum number of levels, including the input. Default is 4. */
+  virtual void SetMaximumNumberOfLevels( unsigned int levels );
+  itkGetConstMacro( MaximumNumberOfLevels, unsigned int );
+  
+  /** Set/Get the minimum residual scale, in pixels of the level, for a level to be selected. 
+    * Default is 3.0. */
+  itkSetMacro( MinimumSigmaInPixels, double );
+  itkGetConstMacro( MinimumSigmaInPixels, double );
+  
+  /** Coarsest level where the given scale can be evaluated. */
+  unsigned int GetLevelForScale( double scale ) const;
+  
+  /** Shrink factor of a level, 2^level. */
+  static double GetShrinkFactor( unsigned int level )
+    { return static_cast<double>( 1u << level ); }
+  
+  /** Standard deviation, in physical units, of the smoothing of a level. */
+  double GetLevelSigma( unsigned int level ) const;
+  
+  /** Scale to evaluate at the level to obtain the given scale of the input. */
+  double GetResidualSigma( double scale, unsigned int level ) const;
+  
+  /** Get a level, computed if necessary. Level zero is the input. */
+  const ImageType * GetLevel( unsigned int level );
+  
+  /** Memory used by the computed levels, not including the input, in bytes. */
+  unsigned long GetMemorySize() const;
+  
+protected:
+  
+  ScaleSpacePyramid();
+  virtual ~ScaleSpacePyramid() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Largest spacing of the input. */
+  double GetMaximumSpacing() const;
+  
+private:
+  
+  ScaleSpacePyramid(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented  
+  
+  ImageConstPointer           m_Input;
+  
+  /** Computed levels, null until requested. The first one is not used. */
+  std::vector<ImagePointer>   m_Levels;
+  
+  unsigned int                m_MaximumNumberOfLevels;
+  double                      m_MinimumSigmaInPixels;
+  
+  /** Levels may be requested from the initializers of several threads. */
+  itk::SimpleFastMutexLock    m_Mutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanScaleSpacePyramid.hxx"
+#endif
+
+#endif
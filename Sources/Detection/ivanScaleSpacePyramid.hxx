@@ -0,0 +1,243 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleSpacePyramid.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Downsampled image levels for the evaluation of large scales.
+// Date: 2012/11/05
+
+#ifndef __ivanScaleSpacePyramid_hxx
+#define __ivanScaleSpacePyramid_hxx
+
+#include "ivanScaleSpacePyramid.h"
+
+#include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkShrinkImageFilter.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace ivan
+{
+
+template <class TImage>
+ScaleSpacePyramid<TImage>
+::ScaleSpacePyramid() :
+  m_MaximumNumberOfLevels( 4 ),
+  m_MinimumSigmaInPixels( 3.0 )
+{
+  this->m_Levels.resize( this->m_MaximumNumberOfLevels );
+}
+
+
+template <class TImage>
+void
+ScaleSpacePyramid<TImage>
+::SetInput( const ImageType *image )
+{
+  if( this->m_Input == image )
+    return;
+  
+  this->m_Input = image;
+  
+  this->m_Levels.clear();
+  this->m_Levels.resize( this->m_MaximumNumberOfLevels );
+  
+  this->Modified();
+}
+
+
+template <class TImage>
+void
+ScaleSpacePyramid<TImage>
+::SetMaximumNumberOfLevels( unsigned int levels )
+{
+  levels = std::max( levels, 1u );
+  
+  if( this->m_MaximumNumberOfLevels == levels )
+    return;
+  
+  this->m_MaximumNumberOfLevels = levels;
+  this->m_Levels.resize( levels );
+  
+  this->Modified();
+}
+
+
+template <class TImage>
+double
+ScaleSpacePyramid<TImage>
+::GetMaximumSpacing() const
+{
+  if( this->m_Input.IsNull() )
+    itkExceptionMacro( "Input image not set." );
+  
+  double spacing = 0.0;
+  
+  for( unsigned int d=0; d<ImageType::ImageDimension; ++d )
+    spacing = std::max( spacing, static_cast<double>( this->m_Input->GetSpacing()[d] ) );
+  
+  return spacing;
+}
+
+
+template <class TImage>
+double
+ScaleSpacePyramid<TImage>
+::GetLevelSigma( unsigned int level ) const
+{
+  if( !level )
+    return 0.0;
+  
+  return 0.5 * GetShrinkFactor( level ) * this->GetMaximumSpacing();
+}
+
+
+template <class TImage>
+double
+ScaleSpacePyramid<TImage>
+::GetResidualSigma( double scale, unsigned int level ) const
+{
+  const double levelSigma = this->GetLevelSigma( level );
+  return std::sqrt( std::max( scale * scale - levelSigma * levelSigma, 0.0 ) );
+}
+
+
+template <class TImage>
+unsigned int
+ScaleSpacePyramid<TImage>
+::GetLevelForScale( double scale ) const
+{
+  const double spacing = this->GetMaximumSpacing();
+  const typename ImageType::SizeType & size = this->m_Input->GetBufferedRegion().GetSize();
+  
+  for( unsigned int level = this->m_MaximumNumberOfLevels - 1; level > 0; --level )
+  {
+    const double factor = GetShrinkFactor( level );
+    
+    // The level must keep a few pixels in every dimension
+    bool largeEnough = true;
+    
+    for( unsigned int d=0; d<ImageType::ImageDimension; ++d )
+      if( size[d] < 4 * factor )
+        largeEnough = false;
+    
+    if( largeEnough && 
+        this->GetResidualSigma( scale, level ) >= this->m_MinimumSigmaInPixels * factor * spacing )
+      return level;
+  }
+  
+  return 0;
+}
+
+
+template <class TImage>
+const typename ScaleSpacePyramid<TImage>::ImageType *
+ScaleSpacePyramid<TImage>
+::GetLevel( unsigned int level )
+{
+  if( this->m_Input.IsNull() )
+    itkExceptionMacro( "Input image not set." );
+  
+  if( !level )
+    return this->m_Input;
+  
+  if( level >= this->m_MaximumNumberOfLevels )
+    itkExceptionMacro( "Level " << level << " not in the pyramid." );
+  
+  this->m_Mutex.Lock();
+  
+  if( this->m_Levels[level].IsNull() )
+  {
+    typedef itk::SmoothingRecursiveGaussianImageFilter<ImageType,ImageType>  SmoothingFilterType;
+    typedef itk::ShrinkImageFilter<ImageType,ImageType>                      ShrinkFilterType;
+    
+    typename SmoothingFilterType::Pointer smoothingFilter = SmoothingFilterType::New();
+    smoothingFilter->SetInput( this->m_Input );
+    smoothingFilter->SetSigma( this->GetLevelSigma( level ) );
+    smoothingFilter->SetNormalizeAcrossScale( false );
+    
+    typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+    shrinkFilter->SetInput( smoothingFilter->GetOutput() );
+    shrinkFilter->SetShrinkFactors( static_cast<unsigned int>( GetShrinkFactor( level ) ) );
+    
+    try
+    {
+      shrinkFilter->Update();
+    }
+    catch( itk::ExceptionObject & )
+    {
+      this->m_Mutex.Unlock();
+      throw;
+    }
+    
+    this->m_Levels[level] = shrinkFilter->GetOutput();
+    this->m_Levels[level]->DisconnectPipeline();
+  }
+  
+  const ImageType *image = this->m_Levels[level];
+  
+  this->m_Mutex.Unlock();
+  
+  return image;
+}
+
+
+template <class TImage>
+unsigned long
+ScaleSpacePyramid<TImage>
+::GetMemorySize() const
+{
+  unsigned long size = 0;
+  
+  for( unsigned int level=1; level<this->m_Levels.size(); ++level )
+  {
+    if( this->m_Levels[level].IsNotNull() )
+    {
+      size += this->m_Levels[level]->GetBufferedRegion().GetNumberOfPixels() * 
+        sizeof( typename ImageType::PixelType );
+    }
+  }
+  
+  return size;
+}
+
+
+template <class TImage>
+void
+ScaleSpacePyramid<TImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Input: " << this->m_Input.GetPointer() << std::endl;
+  os << indent << "MaximumNumberOfLevels: " << this->m_MaximumNumberOfLevels << std::endl;
+  os << indent << "MinimumSigmaInPixels: " << this->m_MinimumSigmaInPixels << std::endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
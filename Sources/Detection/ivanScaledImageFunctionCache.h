@@ -0,0 +1,122 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaledImageFunctionCache.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe container of initialized scaled image functions shared between multiscale objects
+// Date: 2012/11/05
+
+#ifndef __ivanScaledImageFunctionCache_h
+#define __ivanScaledImageFunctionCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <map>
+
+namespace ivan
+{
+/**
+ * \class ScaledImageFunctionCache
+ * \brief Thread-safe container of initialized scaled image functions indexed by scale.
+ *
+ * Multiscale objects such as MultiscaleImageFunction or MultiscaleVesselSectionEstimator create
+ * and initialize one image function per scale. When several of these objects use the same scaled
+ * function type on the same image, they can share one of these caches so that the function (and
+ * its precomputed kernels) for a given scale is only created and initialized once.
+ *
+ * A cache must only be shared between objects that use the same input image and initialize
+ * their scaled functions with the same parameters other than the scale.
+ *
+ * This class is templated over the scaled image function type.
+ *
+ * \sa MultiscaleImageFunction
+ * \sa MultiscaleVesselSectionEstimator
+ */
+template <class TScaledImageFunction>
+class ITK_EXPORT ScaledImageFunctionCache : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ScaledImageFunctionCache        Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ScaledImageFunctionCache, Object );
+  
+  typedef TScaledImageFunction                            ScaledImageFunctionType;
+  typedef typename ScaledImageFunctionType::Pointer       ScaledImageFunctionPointer;
+  
+  typedef std::map<double,ScaledImageFunctionPointer>     FunctionContainerType;
+  
+public:
+  
+  /** Look for the function of the given scale. Returns null if not found. */
+  ScaledImageFunctionType * Find( double scale ) const;
+  
+  /** Store the function of the given scale. If another function was already stored for that 
+    * scale (for example by another thread), the stored function is kept. Returns the stored 
+    * function. */
+  ScaledImageFunctionType * Insert( double scale, ScaledImageFunctionType *scaledFunction );
+  
+  /** Remove all functions. */
+  void Clear();
+  
+  /** Get the number of functions stored. */
+  unsigned long GetNumberOfFunctions() const;
+  
+protected:
+
+  ScaledImageFunctionCache() {};
+  ~ScaledImageFunctionCache() {};
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+private:
+
+  ScaledImageFunctionCache( const Self& ); // purposely not implemented
+  void operator=( const Self& ); // purposely not implemented
+
+private:
+
+  FunctionContainerType   m_Functions;
+  
+  /** Mutex for accessing the container from several threads. */
+  mutable itk::SimpleFastMutexLock    m_Mutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanScaledImageFunctionCache.hxx"
+#endif
+
+#endif
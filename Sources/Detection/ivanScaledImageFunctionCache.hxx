@@ -0,0 +1,111 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaledImageFunctionCache.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: thread-safe container of initialized scaled image functions shared between multiscale objects
+// Date: 2012/11/05
+
+#ifndef __ivanScaledImageFunctionCache_hxx
+#define __ivanScaledImageFunctionCache_hxx
+
+#include "ivanScaledImageFunctionCache.h"
+
+namespace ivan
+{
+
+template <class TScaledImageFunction>
+typename ScaledImageFunctionCache<TScaledImageFunction>::ScaledImageFunctionType *
+ScaledImageFunctionCache<TScaledImageFunction>
+::Find( double scale ) const
+{
+  ScaledImageFunctionType *scaledFunction = 0;
+  
+  m_Mutex.Lock();
+  
+  typename FunctionContainerType::const_iterator it = m_Functions.find( scale );
+  
+  if( it != m_Functions.end() )
+    scaledFunction = it->second;
+    
+  m_Mutex.Unlock();
+  
+  return scaledFunction;
+}
+
+
+template <class TScaledImageFunction>
+typename ScaledImageFunctionCache<TScaledImageFunction>::ScaledImageFunctionType *
+ScaledImageFunctionCache<TScaledImageFunction>
+::Insert( double scale, ScaledImageFunctionType *scaledFunction )
+{
+  m_Mutex.Lock();
+  
+  // Another thread may have inserted a function for the same scale meanwhile
+  ScaledImageFunctionType *storedFunction = m_Functions.insert
+    ( typename FunctionContainerType::value_type( scale, scaledFunction ) ).first->second;
+  
+  m_Mutex.Unlock();
+  
+  return storedFunction;
+}
+
+
+template <class TScaledImageFunction>
+void
+ScaledImageFunctionCache<TScaledImageFunction>
+::Clear()
+{
+  m_Mutex.Lock();
+  m_Functions.clear();
+  m_Mutex.Unlock();
+}
+
+
+template <class TScaledImageFunction>
+unsigned long
+ScaledImageFunctionCache<TScaledImageFunction>
+::GetNumberOfFunctions() const
+{
+  m_Mutex.Lock();
+  unsigned long numberOfFunctions = m_Functions.size();
+  m_Mutex.Unlock();
+  
+  return numberOfFunctions;
+}
+
+
+template <class TScaledImageFunction>
+void
+ScaledImageFunctionCache<TScaledImageFunction>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfFunctions: " << this->GetNumberOfFunctions() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
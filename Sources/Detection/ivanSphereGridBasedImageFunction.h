@@ -31,11 +31,15 @@ SUCH DAMAGE.
 #define __ivanSphereGridBasedImageFunction_h
 
 
+#include "ivanExplicitInstantiation.h"
 #include "itkImageFunction.h"
 #include "ivanRegularSphereMeshSource2.h"
+#include "ivanSphereSamplingTableCache.h"
 #include "ivanDiscreteHessianGaussianImageFunction.h"
 #include "itkLinearInterpolateImageFunction.h"
 
+#include <vector>
+
 
 namespace ivan
 {
@@ -49,8 +53,19 @@ namespace ivan
  * This base class performs partitioning of space in polar coordinates. Subclasses must define
  * how the flux is calculated specifically.
  *
- * TODO: encapsulate sphere calculations in a struct. Pre-compute normals for the sphere and
- * then some other calculations.
+ * The unit normals at the sphere points and the offsets of the points from the sphere center 
+ * (normals scaled by the radius) are precomputed in Initialize() and stored in flat tables 
+ * with one contiguous block per dimension, so that subclasses can evaluate by simply walking 
+ * the tables. The element for point p in dimension d is at position d * N + p, where N is the
+ * number of sphere points.
+ *
+ * The sphere points are not equally spaced, the vertices of the original icosahedron have
+ * fewer neighbours and larger cells than those created by the decimation. If 
+ * UseQuadratureWeights is on, the area of the spherical Voronoi cell of each point, computed 
+ * from the triangles of the mesh, is stored in the weight table, normalized to a mean of one so 
+ * weighted sums keep the scale of plain sums. Otherwise all the weights are one. Subclasses 
+ * integrating over the sphere multiply each sample by its weight, which makes the integrals 
+ * converge with the decimation instead of keeping the bias of equal weights.
  *
  */
 template <class TInputImage, class TOutput, class TCoordRep=double>
@@ -76,11 +91,21 @@ public:
   typedef typename Superclass::IndexType             IndexType;
   typedef typename Superclass::ContinuousIndexType   ContinuousIndexType;
   typedef typename Superclass::PointType             PointType;
+  
+  /** Container of points for batch evaluation. */
+  typedef std::vector<PointType>                     PointContainerType;
     
   typedef ivan::RegularSphereMeshSource2<double>     SphereSourceType;
   typedef typename SphereSourceType::Pointer         SphereSourcePointer;
   typedef typename SphereSourceType::OutputMeshType  SphereType;
   typedef typename SphereType::Pointer               SpherePointer;
+  
+  /** Flat table of per-point values (one block per dimension). */
+  typedef std::vector<double>                        SphereTableType;
+  
+  /** Shared sampling of the unit sphere. */
+  typedef SphereSamplingTable                        SphereSamplingTableType;
+  typedef SphereSamplingTableType::ConstPointer      SphereSamplingTableConstPointer;
         
 public:
 
@@ -103,9 +128,39 @@ public:
           
   /** Set the input image. */
   virtual void SetInputImage( const InputImageType * ptr );
+  
+  /** Get the number of points of the sphere. Valid after Initialize(). */
+  unsigned int GetNumberOfSpherePoints() const
+    { return m_NumberOfSpherePoints; }
+    
+  /** Get the table of unit normals at the sphere points. Valid after Initialize(). */
+  const SphereTableType & GetSphereNormalTable() const
+    { return m_SphereSamplingTable->GetNormalTable(); }
+  
+  /** Get the table of offsets of the sphere points from the sphere center. Valid after Initialize(). */
+  const SphereTableType & GetSphereOffsetTable() const
+    { return m_SphereOffsetTable; }
+  
+  /** Get the table of quadrature weights of the sphere points, with one element per point. 
+    * Valid after Initialize(). */
+  const SphereTableType & GetSphereWeightTable() const
+    { return ( m_UseQuadratureWeights && TInputImage::ImageDimension == 3 ) ? 
+        m_SphereSamplingTable->GetWeightTable() : m_SphereSamplingTable->GetUniformWeightTable(); }
+  
+  /** Get the sampling of the unit sphere, shared by all the functions with the same 
+    * decimation. Valid after Initialize(). */
+  const SphereSamplingTableType * GetSphereSamplingTable() const
+    { return m_SphereSamplingTable.GetPointer(); }
+  
+  /** Set/Get the flag for weighting the sphere points by the area of their cells. Default is off. */
+  itkSetMacro( UseQuadratureWeights, bool );
+  itkGetConstMacro( UseQuadratureWeights, bool );
+  itkBooleanMacro( UseQuadratureWeights );
 
   /** Initialize the flux-based function. Call this method before evaluating the function.
-    * This method MUST be called after any changes to function parameters. */
+    * This method MUST be called after any changes to function parameters. The unit sphere
+    * sampling is looked up in SphereSamplingTableCache, so only the first function with a 
+    * given decimation builds the sphere mesh. */
   virtual void Initialize();
   
   /** Evalutate the  in the given dimension at specified point */
@@ -117,6 +172,11 @@ public:
   /** Evaluate the function at specified ContinousIndex position */
   virtual OutputType EvaluateAtContinuousIndex( const ContinuousIndexType & index ) const;
   
+  /** Evaluate the function at all the given points and store the results in values, which must 
+    * have room for points.size() elements. The default implementation calls Evaluate() for each 
+    * point. Subclasses may reimplement this to amortize setup costs over the points. */
+  virtual void EvaluateBatch( const PointContainerType& points, OutputType* values ) const;
+  
 protected:
 
   SphereGridBasedImageFunction();
@@ -131,8 +191,9 @@ private:
 
 protected:
 
-  /** Sphere mesh that will be used for sampling via ray-tracing from the sphere centre. */
-  SpherePointer          m_Sphere;
+  /** Unit sphere sampling used for ray-tracing from the sphere centre. It is shared with 
+    * the other functions of the same decimation, and must not be modified. */
+  SphereSamplingTableConstPointer   m_SphereSamplingTable;
   
   /** Radius of the sphere to be sampled. */
   double                 m_Radius;
@@ -144,6 +205,14 @@ protected:
   
   /** Number of radial samples used for the sphere. This includes the center point. */
   unsigned int           m_RadialResolution;
+  
+  /** Number of points of the sphere mesh. */
+  unsigned int           m_NumberOfSpherePoints;
+  
+  /** Offsets of the sphere points from the center, i.e. normals scaled by the radius. */
+  SphereTableType        m_SphereOffsetTable;
+  
+  bool                   m_UseQuadratureWeights;
 };
 
 } // namespace ivan
@@ -155,7 +224,7 @@ protected:
                                                   SphereGridBasedImageFunction##y; } \
   }
 
-#if ITK_TEMPLATE_EXPLICIT
+#if IVAN_TEMPLATE_EXPLICIT
 # include "Templates/ivanSphereGridBasedImageFunction+-.h"
 #endif
 
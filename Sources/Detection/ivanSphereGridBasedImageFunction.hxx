@@ -33,7 +33,6 @@ SUCH DAMAGE.
 #include "ivanSphereGridBasedImageFunction.h"
 
 
-
 namespace ivan
 {
 
@@ -43,9 +42,11 @@ SphereGridBasedImageFunction<TInputImage,TOutput,TCoordRep>
 ::SphereGridBasedImageFunction() : 
   m_Radius( 1.0 ),
   m_Decimation( 1 ),
-  m_RadialResolution( 1 ) // by default on the sphere surface only
+  m_RadialResolution( 1 ), // by default on the sphere surface only
+  m_NumberOfSpherePoints( 0 ),
+  m_UseQuadratureWeights( false )
 {
-
+  m_SphereSamplingTable = SphereSamplingTableType::New().GetPointer(); // empty until Initialize()
 }
 
 
@@ -60,6 +61,8 @@ SphereGridBasedImageFunction<TInputImage,TOutput,TCoordRep>
   os << indent << "Radius: " << m_Radius << std::endl;
   os << indent << "Decimation: " << m_Decimation << std::endl;
   os << indent << "RadialResolution: " << m_RadialResolution << std::endl;
+  os << indent << "NumberOfSpherePoints: " << m_NumberOfSpherePoints << std::endl;
+  os << indent << "UseQuadratureWeights: " << m_UseQuadratureWeights << std::endl;
 }
 
 
@@ -79,13 +82,18 @@ void
 SphereGridBasedImageFunction<TInputImage,TOutput,TCoordRep>
 ::Initialize()
 {
-  SphereSourcePointer sphereSource = SphereSourceType::New();
-    
-  sphereSource->SetRadius( this->m_Radius );
-  sphereSource->SetDecimation( this->m_Decimation );
-  sphereSource->Update(); // should we add a try/catch here???
+  m_SphereSamplingTable = SphereSamplingTableCache::GetInstance()->GetTable( m_Decimation );
+  
+  // The offsets depend on the radius, so they are the only per-function table
+  const unsigned int dimension = TInputImage::GetImageDimension();
+  const SphereTableType & normals = m_SphereSamplingTable->GetNormalTable();
   
-  m_Sphere = sphereSource->GetOutput();
+  m_NumberOfSpherePoints = m_SphereSamplingTable->GetNumberOfPoints();
+  
+  m_SphereOffsetTable.resize( dimension * m_NumberOfSpherePoints );
+  
+  for( unsigned int i = 0; i < dimension * m_NumberOfSpherePoints; ++i )
+    m_SphereOffsetTable[i] = m_Radius * normals[i];
 }
 
 
@@ -245,6 +253,17 @@ SphereGridBasedImageFunction<TInputImage,TOutput,TCoordRep>
   return this->Evaluate( point ); 
 }
 
+
+/** Evaluate the function at the given points */
+template <class TInputImage, class TOutput, class TCoordRep>
+void
+SphereGridBasedImageFunction<TInputImage,TOutput,TCoordRep>
+::EvaluateBatch( const PointContainerType& points, OutputType* values ) const
+{
+  for( unsigned long i=0; i < points.size(); ++i )
+    values[i] = this->Evaluate( points[i] );
+}
+
 } // end namespace ivan
 
 #endif
@@ -24,40 +24,62 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanImageToCircleFitCostFunction.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: cost function to fit a circle to a 2D image
+// Description: cost function to fit a circle to a 2D image or to a section plane of a 3D image
 
 
 #ifndef __ivanImageToCircleFitCostFunction_h
 #define __ivanImageToCircleFitCostFunction_h
 
-#include <time.h>
-
 #include "itkImage.h"
-#include "itkArray2D.h"
-#include "itkOnePlusOneEvolutionaryOptimizer.h"
 #include "itkArray.h"
+#include "itkVector.h"
+#include "itkSingleValuedCostFunction.h"
 #include "itkInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include <vector>
 
 
 namespace ivan
 {
 /** \class ImageToCircleFitCostFunction
- *  \brief a cost function for optimization
+ *  \brief Cost function for fitting the radius of a circle to an image
+ *
+ * The value is the mean of the image interpolated on a ring of the given radius around Center,
+ * in the plane of the image in 2D, or in the plane orthogonal to Normal in 3D. The number of 
+ * samples grows with the radius (2 pi r + 1, rounded up to a multiple of four, at least four).
+ *
+ * The ring is sampled in a single pass for the value and the derivative. The sines and cosines 
+ * are only computed for the first quadrant, the other three samples of each angle being its 
+ * rotations by 90 degrees in the plane. If the interpolator is a BSplineInterpolateImageFunction,
+ * each sample gives the value and the image gradient in one call, and the derivative with respect
+ * to the radius is the mean of the gradient projected on the radial directions, so one 
+ * interpolation per sample is done. Otherwise the derivative is the forward difference of the 
+ * ring with a radius DerivativeDelta times larger, which takes two interpolations per sample. 
+ * Previously, value and derivative took three.
+ *
+ * The derivative is the derivative of the value with respect to the radius. Before, it was the 
+ * difference between the rings of radii 1.5 r and 0.5 r, about r times the derivative and 
+ * computed from other samples than the value. Gradient-based optimizers tuned for the old 
+ * derivative need their step, such as the learning rate, multiplied by the radius. Optimizers 
+ * using only the value, such as OnePlusOneEvolutionaryOptimizer in 
+ * RadiusEstimationVesselNetworkFilter, are not affected.
  *
- *   
+ * The value and derivative are zero for radii below half the largest spacing or above half the
+ * smallest size of the region.
  */
 template<class TImage>
-class ImageToCircleFitCostFunction : public SingleValuedCostFunction
+class ImageToCircleFitCostFunction : public itk::SingleValuedCostFunction
 {
 public:
   /** Standard class typedefs. */
   typedef ImageToCircleFitCostFunction   Self;
-  typedef SingleValuedCostFunction       Superclass;
-  typedef itk::SmartPointer<Self>             Pointer;
-  typedef itk::SmartPointer<const Self>       ConstPointer;
+  typedef itk::SingleValuedCostFunction  Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
   
   /** Run-time type information (and related methods). */
-  itkTypeMacro( ImageToCircleFitCostFunction, CostFunction );
+  itkTypeMacro( ImageToCircleFitCostFunction, SingleValuedCostFunction );
 
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
@@ -79,17 +101,22 @@ public:
   /** Type used for representing point components  */
   typedef Superclass::ParametersValueType CoordinateRepresentationType;
   
-    /** Not used, but expected by SingleValuedNonLinearOptimizer class. */
+  /** Derivative with respect to the radius. */
   typedef Superclass::DerivativeType      DerivativeType;
 
   /** The cost value type. */
   typedef Superclass::MeasureType         MeasureType;
   
-  /** Interpolator type. */
-	typedef InterpolateImageFunction
-		< ImageType, CoordinateRepresentationType >   InterpolatorType;
-	typedef typename InterpolatorType::Pointer      InterpolatorPointer;
-	
+  /** Vector type of the section normal and the ring directions. */
+  typedef itk::Vector<double,itkGetStaticConstMacro(ImageDimension)>  VectorType;
+  
+  /** Interpolator types. */
+  typedef itk::InterpolateImageFunction
+    < ImageType, CoordinateRepresentationType >   InterpolatorType;
+  typedef typename InterpolatorType::Pointer      InterpolatorPointer;
+  typedef itk::BSplineInterpolateImageFunction
+    < ImageType, CoordinateRepresentationType >   BSplineInterpolatorType;
+  typedef typename BSplineInterpolatorType::CovariantVectorType  GradientType;
 
   /** Specify the input image. */
   itkSetObjectMacro( Image, ImageType );
@@ -102,30 +129,47 @@ public:
   itkSetMacro( Center, PointType );
   itkGetMacro( Center, PointType );
   
+  /** Set/Get the normal to the plane of the circle. Only used in 3D. Default is the z axis. */
+  virtual void SetNormal( const VectorType & normal );
+  itkGetConstReferenceMacro( Normal, VectorType );
+  
   /** Set/Get the symmetry coefficient (from zero to one). */
   itkSetMacro( SymmetryCoefficient, double );
   itkGetMacro( SymmetryCoefficient, double );
   
+  /** Set/Get the relative increment of the radius for the finite difference derivative, used 
+   * when the interpolator does not provide the gradient. Default is 0.1. */
+  itkSetMacro( DerivativeDelta, double );
+  itkGetMacro( DerivativeDelta, double );
+  
   /** Set/Get the Interpolator. */
   itkSetObjectMacro( Interpolator, InterpolatorType );
-	itkGetObjectMacro( Interpolator, InterpolatorType );
+  itkGetObjectMacro( Interpolator, InterpolatorType );
   
   /** Gets the cost function value. */
   virtual MeasureType GetValue(const ParametersType & parameters ) const ;
 
-  /** Dummy implementation to confirm to the SingleValuedCostFunction 
-   * interfaces. It is pure virtual in the superclass */
+  /** Gets the derivative with respect to the radius. */
   virtual void GetDerivative( const ParametersType & parameters,
     DerivativeType & derivative ) const;
 
-	virtual void GetValueAndDerivative( const ParametersType &parameters, 
-		MeasureType &value, DerivativeType &derivative) const;
+  /** Gets value and derivative from the same ring samples. */
+  virtual void GetValueAndDerivative( const ParametersType &parameters, 
+    MeasureType &value, DerivativeType &derivative) const;
 
   virtual unsigned int GetNumberOfParameters(void) const;
   
+  /** Number of samples of the ring of the given radius. */
+  static unsigned int GetNumberOfSamples( double radius );
+  
+  /** Number of interpolator calls since the last Initialize(), to measure the cost of the 
+   * optimization. */
+  unsigned long GetNumberOfInterpolations() const
+    { return m_NumberOfInterpolations; }
+  
   /** Initialize the Cost Function by making sure that all the components
    *  are present and plugged together correctly     */
-  virtual void Initialize(void) throw ( ExceptionObject );
+  virtual void Initialize(void) throw ( itk::ExceptionObject );
 
 protected:
   /** Constructor: */
@@ -133,7 +177,12 @@ protected:
 
   /** Destructor: */
   virtual ~ImageToCircleFitCostFunction();
-
+  
+  /** Check that the radius is inside the valid range. */
+  bool IsValidRadius( double radius ) const;
+  
+  /** Sample the ring of the given radius and compute the value, and the derivative if not null. */
+  void SampleRing( double radius, MeasureType & value, double *derivative ) const;
 
 private:
   
@@ -152,13 +201,23 @@ private:
   /** Interpolator used to interpolate circle values. */
   InterpolatorPointer    m_Interpolator;
   
+  /** The interpolator, if it is a B-spline interpolator, to get the gradient in the same call. */
+  const BSplineInterpolatorType  *m_BSplineInterpolator;
+  
   /** Center of the circle. */
-  PointType							 m_Center;  
+  PointType              m_Center;  
+  
+  /** Normal to the plane of the circle, and orthonormal basis of the plane. */
+  VectorType             m_Normal;
+  VectorType             m_FirstBaseVector;
+  VectorType             m_SecondBaseVector;
   
   /** Symmetry coefficient for medialness calculation (from 0.0 to 1.0). */
-  double						m_SymmetryCoefficient;
-
+  double                 m_SymmetryCoefficient;
+  
+  double                 m_DerivativeDelta;
   
+  mutable unsigned long  m_NumberOfInterpolations;
   
 }; // end of class
 
@@ -166,7 +225,7 @@ private:
 } // end namespace ivan
 
 #ifndef ITK_MANUAL_INSTANTIATION
-#include "itkImageToCircleFitCostFunction.hxx"
+#include "ivanImageToCircleFitCostFunction.hxx"
 #endif
 
 #endif
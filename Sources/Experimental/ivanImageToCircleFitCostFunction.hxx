@@ -22,14 +22,18 @@ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
 SUCH DAMAGE.
 
 ==========================================================================*/
-// File: ivanImageToCircleFitCostFunction.h
+// File: ivanImageToCircleFitCostFunction.hxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: cost function to fit a circle to a 2D image
+// Description: cost function to fit a circle to a 2D image or to a section plane of a 3D image
 
 #ifndef __ivanImageToCircleFitCostFunction_hxx
 #define __ivanImageToCircleFitCostFunction_hxx
 
-#include "vnl/vnl_cross.h"
+#include "ivanImageToCircleFitCostFunction.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
 
 namespace ivan
 {
@@ -39,9 +43,22 @@ namespace ivan
 template<class TImage>
 ImageToCircleFitCostFunction<TImage>
 ::ImageToCircleFitCostFunction() :
-	m_SymmetryCoefficient(1.0)
+  m_BSplineInterpolator(0),
+  m_SymmetryCoefficient(1.0),
+  m_DerivativeDelta(0.1),
+  m_NumberOfInterpolations(0)
 {
-	m_Center.Fill(0.0);  
+  m_Center.Fill(0.0);
+  
+  // In 2D the circle lies on the image plane, in 3D the default normal is the z axis
+  m_FirstBaseVector.Fill(0.0);
+  m_FirstBaseVector[0] = 1.0;
+  m_SecondBaseVector.Fill(0.0);
+  m_SecondBaseVector[1] = 1.0;
+  m_Normal.Fill(0.0);
+  
+  if( ImageDimension == 3 )
+    m_Normal[2] = 1.0;
 }
 
 
@@ -55,10 +72,56 @@ ImageToCircleFitCostFunction<TImage>
 
 
 
+template<class TImage>
+void
+ImageToCircleFitCostFunction<TImage>
+::SetNormal( const VectorType & normal )
+{
+  if( ImageDimension != 3 )
+    {
+    itkExceptionMacro(<<"The normal can only be set for 3D images");
+    }
+  
+  double norm = normal.GetNorm();
+  
+  if( norm <= 0.0 )
+    {
+    itkExceptionMacro(<<"Null normal");
+    }
+  
+  m_Normal = normal / norm;
+  
+  // Start the first base vector from the axis least aligned with the normal
+  // and make it orthogonal to it
+  
+  unsigned int minAxis = 0;
+  
+  for( unsigned int i=1; i<ImageDimension; ++i )
+  {
+    if( vnl_math_abs( m_Normal[i] ) < vnl_math_abs( m_Normal[minAxis] ) )
+      minAxis = i;
+  }
+  
+  m_FirstBaseVector.Fill(0.0);
+  m_FirstBaseVector[minAxis] = 1.0;
+  m_FirstBaseVector -= m_Normal * ( m_FirstBaseVector * m_Normal );
+  m_FirstBaseVector.Normalize();
+  
+  // Second base vector is normal x first
+  
+  m_SecondBaseVector[0] = m_Normal[1] * m_FirstBaseVector[2] - m_Normal[2] * m_FirstBaseVector[1];
+  m_SecondBaseVector[1] = m_Normal[2] * m_FirstBaseVector[0] - m_Normal[0] * m_FirstBaseVector[2];
+  m_SecondBaseVector[2] = m_Normal[0] * m_FirstBaseVector[1] - m_Normal[1] * m_FirstBaseVector[0];
+  
+  this->Modified();
+}
+
+
+
 template <class TImage> 
 void
 ImageToCircleFitCostFunction<TImage>
-::Initialize(void) throw ( ExceptionObject )
+::Initialize(void) throw ( itk::ExceptionObject )
 {
 
   if( !m_Interpolator )
@@ -77,12 +140,12 @@ ImageToCircleFitCostFunction<TImage>
   
   for( unsigned int i=0; i<ImageDimension; ++i )
   {
-  	if( size[i] == 0 )
-  	{
-  		m_Region = m_Image->GetRequestedRegion();
-  		break;  		
-  	}
-  }    
+    if( size[i] == 0 )
+    {
+      m_Region = m_Image->GetRequestedRegion();
+      break;
+    }
+  }
         
   // If the image is provided by a source, update the source.
   if( m_Image->GetSource() )
@@ -91,14 +154,15 @@ ImageToCircleFitCostFunction<TImage>
     }
 
   m_Interpolator->SetInputImage( m_Image );
- 
- 
+  
+  // B-spline interpolators give the value and the gradient in the same call
+  m_BSplineInterpolator = dynamic_cast<const BSplineInterpolatorType *>( m_Interpolator.GetPointer() );
+  
+  m_NumberOfInterpolations = 0;
 }
 
 
 
-
-
 template<class TImage>
 unsigned int
 ImageToCircleFitCostFunction<TImage>
@@ -109,184 +173,197 @@ ImageToCircleFitCostFunction<TImage>
 
 
 
-
 template<class TImage>
-typename ImageToCircleFitCostFunction<TImage>::MeasureType
+unsigned int
 ImageToCircleFitCostFunction<TImage>
-::GetValue( const ParametersType & parameters ) const
+::GetNumberOfSamples( double radius )
 {
-  if ( m_Image.IsNull() )
-    {
-    itkExceptionMacro(<<"Image is null");
-    }
+  // Set the number of samples in a circle depending on the scale
+  double tempSamples = 2.0 * vnl_math::pi * radius + 1.0;
+  unsigned int samples = static_cast<unsigned int>( std::floor( tempSamples + 0.5 ) );
 
-  MeasureType value = 0.0;
-  double radius = parameters[0];
+  // Round up to a multiple of four so that each sample has its three rotations by 90 degrees
+  samples = 4 * ( ( samples + 3 ) / 4 );
+
+  if( samples < 4 )
+    samples = 4; // take at least four samples
 
+  return samples;
+}
 
-	// Do not allow the radius to be bigger than the image region or to be negative
-	
-	if( radius <= 0.0 )
-		return itk::NumericTraits<MeasureType>::Zero;
-			
-	// Do not allow the radius to be larger than half the minimum size in all directions
 
-	typename RegionType::SizeType::SizeValueType minSize = 
-		itk::NumericTraits<typename RegionType::SizeType::SizeValueType>::max();
-	
-	typename RegionType::SizeType size = m_Region.GetSize();
+
+template<class TImage>
+bool
+ImageToCircleFitCostFunction<TImage>
+::IsValidRadius( double radius ) const
+{
+  // Do not allow the radius to be bigger than the image region or to be negative
+  
+  if( radius <= 0.0 )
+    return false;
+      
+  // Do not allow the radius to be larger than half the minimum size in all directions
+
+  typename RegionType::SizeType::SizeValueType minSize = 
+    itk::NumericTraits<typename RegionType::SizeType::SizeValueType>::max();
+  
+  typename RegionType::SizeType size = m_Region.GetSize();
 
   for( unsigned int i=0; i<ImageDimension; ++i )
-	{
-		if( size[i] < minSize )
-			minSize = size[i];
-	}
+  {
+    if( size[i] < minSize )
+      minSize = size[i];
+  }
 
-	if( radius >= minSize / 2.0 )
-		return itk::NumericTraits<MeasureType>::Zero;
+  if( radius >= minSize / 2.0 )
+    return false;
 
   // Do not allow radius to be smaller than half the minimum spacing in all directions
   
-	const typename TImage::SpacingType &spacing = m_Image->GetSpacing();
+  const typename TImage::SpacingType &spacing = m_Image->GetSpacing();
 
-	double maxSpacing = 0.0;
+  double maxSpacing = 0.0;
 
-	for( unsigned int i=0; i<ImageDimension; ++i )
-	{
-		if( spacing[i] > maxSpacing )
-			maxSpacing = spacing[i];
-	}
+  for( unsigned int i=0; i<ImageDimension; ++i )
+  {
+    if( spacing[i] > maxSpacing )
+      maxSpacing = spacing[i];
+  }
 
-	if( radius <= maxSpacing / 2.0 )
-		return itk::NumericTraits<MeasureType>::Zero;
-	
-	
-  // Set the number of samples in a circle depending on the scale
-	double tempSamples = 2.0f * vnl_math::pi * radius + 1.0f;
-	unsigned int samples = static_cast<unsigned int>( std::floor( tempSamples + 0.5 ) );
-
-	if( samples < 4 )
-		samples = 4; // take at least four samples
-	
-	// Set the angle increment 
-	double angleInc = vnl_math::pi * 2.0f / static_cast<double>( samples ); 
-	
-	double angle = 0.0, sinAngle, cosAngle; // current angle and its sin and cos
-	PointType circlePoint;
-	
-	itk::Array<double>		firstBaseVector; 
-	itk::Array<double>	 	secondBaseVector;
-	firstBaseVector.SetSize(ImageDimension);
-	secondBaseVector.SetSize(ImageDimension);
-	
-	// !!! Specific for 2D
-	firstBaseVector.Fill(0.0);
-	firstBaseVector[0] = 1.0;
-	secondBaseVector.Fill(0.0);
-	secondBaseVector[1] = 1.0;
-	
-	// Calculate points in a circle with the given radius
-	for ( unsigned int i=0; i<samples; ++i )
-	{
-		cosAngle = cos( angle );
-		sinAngle = sin( angle );
-	  
-		// Evaluate and store the value of the gradient in a circle (rotate 90� and calculate 4 points each time)
-		
-		for( int k=0; k<ImageDimension; ++k )
-			circlePoint[k] = m_Center[k] + radius * ( cosAngle * firstBaseVector[k] + sinAngle * secondBaseVector[k] );
-
-		if( m_Interpolator->IsInsideBuffer( circlePoint ) )
-			value += m_Interpolator->Evaluate( circlePoint );
-		  			
-		angle += angleInc;
-		
-	}
-	
-	value /= samples;
-
-	std::cout << "Radius: " << radius << "  Value: " << value << std::endl;
-  
-  return value;
+  if( radius <= maxSpacing / 2.0 )
+    return false;
   
+  return true;
 }
 
 
 
-template <class TImage> 
+template<class TImage>
 void
 ImageToCircleFitCostFunction<TImage>
-::GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const
+::SampleRing( double radius, MeasureType & value, double *derivative ) const
+{
+  const unsigned int samples = GetNumberOfSamples( radius );
+  const unsigned int quarterSamples = samples / 4;
+  
+  // Set the angle increment 
+  const double angleInc = vnl_math::pi * 2.0 / static_cast<double>( samples );
+  
+  const bool useGradient = ( derivative != 0 && m_BSplineInterpolator != 0 );
+  const double forwardRadius = radius * ( 1.0 + m_DerivativeDelta );
+  
+  double sumValue = 0.0, sumDerivative = 0.0;
+  unsigned long numberOfInterpolations = 0;
+  
+  double sinAngle, cosAngle; // sin and cos of the current angle
+  double firstCoeff[4], secondCoeff[4];
+  VectorType direction;
+  PointType circlePoint, forwardPoint;
+  
+  typename BSplineInterpolatorType::OutputType sampleValue;
+  GradientType gradient;
+  
+  for ( unsigned int i=0; i<quarterSamples; ++i )
+  {
+    cosAngle = std::cos( i * angleInc );
+    sinAngle = std::sin( i * angleInc );
+    
+    // Rotate 90 degrees to get the other three samples with the same sin and cos
+    firstCoeff[0] =  cosAngle;  secondCoeff[0] =  sinAngle;
+    firstCoeff[1] = -sinAngle;  secondCoeff[1] =  cosAngle;
+    firstCoeff[2] = -cosAngle;  secondCoeff[2] = -sinAngle;
+    firstCoeff[3] =  sinAngle;  secondCoeff[3] = -cosAngle;
+    
+    for( unsigned int j=0; j<4; ++j )
+    {
+      for( unsigned int k=0; k<ImageDimension; ++k )
+      {
+        direction[k] = firstCoeff[j] * m_FirstBaseVector[k] + secondCoeff[j] * m_SecondBaseVector[k];
+        circlePoint[k] = m_Center[k] + radius * direction[k];
+      }
+      
+      if( !m_Interpolator->IsInsideBuffer( circlePoint ) )
+        continue;
+      
+      if( useGradient )
+      {
+        // Value and gradient in one call, the radial derivative is the gradient along the direction
+        m_BSplineInterpolator->EvaluateValueAndDerivative( circlePoint, sampleValue, gradient );
+        ++numberOfInterpolations;
+        
+        sumValue += sampleValue;
+        
+        for( unsigned int k=0; k<ImageDimension; ++k )
+          sumDerivative += gradient[k] * direction[k];
+      }
+      else
+      {
+        const double currentValue = m_Interpolator->Evaluate( circlePoint );
+        ++numberOfInterpolations;
+        
+        sumValue += currentValue;
+        
+        if( derivative != 0 )
+        {
+          for( unsigned int k=0; k<ImageDimension; ++k )
+            forwardPoint[k] = m_Center[k] + forwardRadius * direction[k];
+          
+          if( m_Interpolator->IsInsideBuffer( forwardPoint ) )
+          {
+            sumDerivative += m_Interpolator->Evaluate( forwardPoint ) - currentValue;
+            ++numberOfInterpolations;
+          }
+        }
+      }
+    }
+  }
+  
+  value = sumValue / samples;
+  
+  if( derivative != 0 )
+  {
+    if( useGradient )
+      *derivative = sumDerivative / samples;
+    else
+      *derivative = sumDerivative / ( samples * ( forwardRadius - radius ) );
+  }
+  
+  m_NumberOfInterpolations += numberOfInterpolations;
+}
+
+
+
+template<class TImage>
+typename ImageToCircleFitCostFunction<TImage>::MeasureType
+ImageToCircleFitCostFunction<TImage>
+::GetValue( const ParametersType & parameters ) const
 {
-	if ( m_Image.IsNull() )
+  if ( m_Image.IsNull() )
     {
     itkExceptionMacro(<<"Image is null");
     }
-    
-  const unsigned int ParametersDimension = this->GetNumberOfParameters();
-  derivative = DerivativeType( ParametersDimension );
-  derivative.Fill( NumericTraits<ITK_TYPENAME DerivativeType::ValueType>::Zero );
-    
+
+  MeasureType value = itk::NumericTraits<MeasureType>::Zero;
   double radius = parameters[0];
- 
- 
-  // Set the number of samples in a circle depending on the scale
-	double tempSamples = 2.0f * vnl_math::pi * radius + 1.0f;
-	unsigned int samples = static_cast<unsigned int>( std::floor( tempSamples + 0.5 ) );
-	
-	if( samples < 4 )
-		samples = 4; // take at least four samples
-	
-	// Set the angle increment 
-	double angleInc = vnl_math::pi * 2.0f / static_cast<double>( samples ); 
-	
-	MeasureType tempDerivative;
-	double angle = 0.0, delta = 0.5, sinAngle, cosAngle; // current angle and its sin and cos
-	PointType circlePointBack, circlePointFord;
-	
-	itk::Array<double>		firstBaseVector; 
-	itk::Array<double>	 	secondBaseVector;
-	firstBaseVector.SetSize(ImageDimension);
-	secondBaseVector.SetSize(ImageDimension);
-	
-	// !!! Specific for 2D
-	firstBaseVector.Fill(0.0);
-	firstBaseVector[0] = 1.0;
-	secondBaseVector.Fill(0.0);
-	secondBaseVector[1] = 1.0;
-	
-	// Calculate points in a circle with the given radius
-	for ( unsigned int i=0; i<samples; ++i )
-	{
-		cosAngle = cos( angle );
-		sinAngle = sin( angle );
-	  
-		// Evaluate and store the value of the gradient in a circle (rotate 90� and calculate 4 points each time)
-		
-		for( int k=0; k<ImageDimension; ++k )
-		{
-			circlePointBack[k] = m_Center[k] + radius * ( 1.0 - delta ) * 
-				( cosAngle * firstBaseVector[k] + sinAngle * secondBaseVector[k] );
-			circlePointFord[k] = m_Center[k] + radius * ( 1.0 + delta ) * 
-				( cosAngle * firstBaseVector[k] + sinAngle * secondBaseVector[k] );
-			
-		}
-
-		if( m_Interpolator->IsInsideBuffer( circlePointBack ) && m_Interpolator->IsInsideBuffer( circlePointFord ) )
-		{
-			tempDerivative = 0.0;
-			tempDerivative += m_Interpolator->Evaluate( circlePointFord );
-			tempDerivative -= m_Interpolator->Evaluate( circlePointBack );
-			tempDerivative /= 2.0 * delta;
-			derivative[0] += tempDerivative;
-		}
-		  			
-		angle += angleInc;		
-	}
-	
-	derivative[0] /= samples;
-
-  std::cout << "Derivative:  " << derivative[0] << std::endl;  
+
+  if( !this->IsValidRadius( radius ) )
+    return value;
+  
+  this->SampleRing( radius, value, 0 );
+  
+  return value;
+}
+
+
+
+template <class TImage> 
+void
+ImageToCircleFitCostFunction<TImage>
+::GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const
+{
+  MeasureType value;
+  this->GetValueAndDerivative( parameters, value, derivative );
 }
 
 
@@ -297,8 +374,24 @@ ImageToCircleFitCostFunction<TImage>
 ::GetValueAndDerivative( const ParametersType & parameters, 
   MeasureType & value, DerivativeType  & derivative ) const
 {
-  value = this->GetValue( parameters );
-  this->GetDerivative( parameters, derivative );
+  if ( m_Image.IsNull() )
+    {
+    itkExceptionMacro(<<"Image is null");
+    }
+    
+  derivative = DerivativeType( this->GetNumberOfParameters() );
+  derivative.Fill( itk::NumericTraits<typename DerivativeType::ValueType>::Zero );
+  
+  value = itk::NumericTraits<MeasureType>::Zero;
+  double radius = parameters[0];
+  
+  if( !this->IsValidRadius( radius ) )
+    return;
+  
+  double radiusDerivative;
+  this->SampleRing( radius, value, &radiusDerivative );
+  
+  derivative[0] = radiusDerivative;
 }
 
 
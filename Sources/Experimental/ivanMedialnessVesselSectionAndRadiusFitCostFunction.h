@@ -38,6 +38,8 @@ SUCH DAMAGE.
 #include "itkArray.h"
 #include "itk_hash_map.h"
 #include "itkDiscreteGradientMagnitudeGaussianImageFunction.h"
+#include "ivanScratchArray.h"
+#include "ivanGaussianWeightTable.h"
 
 namespace ivan
 {
@@ -102,6 +104,10 @@ public:
   
   /** Hash map for buffering gradient calculations. */
   typedef itk::hash_map<unsigned long,ScaleType>  HashMapType;
+  
+  /** Temporary storage of the values in a circle during evaluation. Up to 128 samples 
+   * (radius ~20) no memory is allocated, which matters inside the optimizer loop. */
+  typedef ScratchArray<double,128>                CircleValuesArrayType;
 
 public:
   
@@ -132,6 +138,11 @@ public:
   itkSetMacro( SymmetryCoefficient, double );
   itkGetMacro( SymmetryCoefficient, double );
   
+  /** Set/Get whether the symmetry weights are taken from a precomputed Gaussian table. */
+  itkSetMacro( UseFastGaussianWeights, bool );
+  itkGetMacro( UseFastGaussianWeights, bool );
+  itkBooleanMacro( UseFastGaussianWeights );
+  
   /** Gets the cost function value. */
   virtual MeasureType GetValue(const ParametersType & parameters ) const ;
 
@@ -176,6 +187,9 @@ private:
   
   /** Symmetry coefficient for medialness calculation (from 0.0 to 1.0). */
   double        m_SymmetryCoefficient;
+  
+  /** Use the tabulated Gaussian for the symmetry weights. */
+  bool          m_UseFastGaussianWeights;
     
   /** Sampling distance. By default this is the minimum spacing. */
   double        m_SamplingDistance;
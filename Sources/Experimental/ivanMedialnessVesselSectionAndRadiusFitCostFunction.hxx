@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #define __ivanMedialnessVesselSectionAndRadiusFitCostFunction_hxx
 
 #include "vnl_cross.h"
+#include "vnl/vnl_vector_fixed.h"
 
 namespace ivan
 {
@@ -41,6 +42,7 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
 ::MedialnessVesselSectionAndRadiusFitCostFunction() :
   m_SamplingDistance(0.5),
   m_SymmetryCoefficient(1.0),
+  m_UseFastGaussianWeights(false),
   m_CurrentScale(0.0),
   m_ScaleTolerance(0.5)
 {
@@ -138,8 +140,7 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
   double radius = parameters[0];
   double a, b, c;
   
-  itk::Array<double>  normal; 
-  normal.SetSize(ImageDimension);
+  vnl_vector_fixed<double,3>  normal; 
     
   normal[0] = parameters[1];
   normal[1] = parameters[2];
@@ -202,10 +203,8 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
   // and (x-x0) = ( -b(y-y0) -c(z-z0) ) / a 
   
     
-  itk::Array<double>    firstBaseVector; 
-  itk::Array<double>    secondBaseVector;
-  firstBaseVector.SetSize(ImageDimension);
-  secondBaseVector.SetSize(ImageDimension);
+  vnl_vector_fixed<double,3>    firstBaseVector; 
+  vnl_vector_fixed<double,3>    secondBaseVector;
   
   firstBaseVector[1] = sqrt( 1.0 - b*b );
   firstBaseVector[2] = ( - b*c ) / firstBaseVector[1];
@@ -238,21 +237,15 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
   double averageRadialMedialness, averageRadialMedialness2; // measure of average medialness without weighting
   double weightExponent; // exponent of weighting factors for medialness calculations
   
-  // Arrays used for calculations
-  itk::Array<double>  radialMedialness, radialMedialness2; // this stores all values of gradient in the circle with given radius
-  itk::Array<double>  radialMedialnessWeights, radialMedialnessWeights2;  // this stores all weighting factors in the circle with given radius
-  radialMedialness.SetSize( samples );
-  radialMedialness2.SetSize( samples );
-  radialMedialnessWeights.SetSize( samples );
-  radialMedialnessWeights2.SetSize( samples );
+  // Arrays used for calculations, on the stack
+  CircleValuesArrayType radialMedialness( samples ); // this stores all values of gradient in the circle with given radius
+  CircleValuesArrayType radialMedialness2( samples );
   
   
   // Precalculate sin and cos values as these calculations are costly
   
-  itk::Array<double>  sinArray; // store sin values
-  itk::Array<double>  cosArray; // store cos values
-  sinArray.SetSize( samples );
-  conArray.SetSize( samples );
+  CircleValuesArrayType sinArray( samples ); // store sin values
+  CircleValuesArrayType cosArray( samples ); // store cos values
     
   double angle = 0.0;
   
@@ -274,8 +267,6 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
     tempValue2 = 0.0;
     radialMedialness.Fill(0.0);
     radialMedialness2.Fill(0.0);
-    radialMedialnessWeights.Fill(0.0);
-    radialMedialnessWeights2.Fill(0.0);
     
     // Calculate points in a circle with the given radius
     for ( unsigned int i=0; i<samples; ++i )
@@ -321,7 +312,10 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
       }
       else
       {
-        averageRadialMedialness = radialMedialness.one_norm() / static_cast<double>( calculatedSamples );
+        averageRadialMedialness = 0.0;
+        for ( unsigned int i=0; i<samples; ++i )
+          averageRadialMedialness += fabs( radialMedialness[i] );
+        averageRadialMedialness /= static_cast<double>( calculatedSamples );
         
         for ( unsigned int i=0; i<samples; ++i )
         {
@@ -330,8 +324,8 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
           
           // Calculate b coefficients
           weightExponent = ( 1.0 - radialMedialness[i] / averageRadialMedialness ) / m_SymmetryCoefficient;
-          radialMedialnessWeights[i] = exp( -0.5 * weightExponent * weightExponent );
-          tempValue += radialMedialnessWeights[i] * radialMedialness[i];
+          tempValue += ( m_UseFastGaussianWeights ? GaussianWeightTable::Evaluate( weightExponent ) :
+            exp( -0.5 * weightExponent * weightExponent ) ) * radialMedialness[i];
         }
         
       }
@@ -351,7 +345,10 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
       }
       else
       {
-        averageRadialMedialness2 = radialMedialness2.one_norm() / static_cast<double>( calculatedSamples2 );
+        averageRadialMedialness2 = 0.0;
+        for ( unsigned int i=0; i<samples; ++i )
+          averageRadialMedialness2 += fabs( radialMedialness2[i] );
+        averageRadialMedialness2 /= static_cast<double>( calculatedSamples2 );
         
         for ( unsigned int i=0; i<samples; ++i )
         {
@@ -360,8 +357,8 @@ MedialnessVesselSectionAndRadiusFitCostFunction<TImage,TScale>
           
           // Calculate b coefficients
           weightExponent = ( 1.0 - radialMedialness2[i] / averageRadialMedialness2 ) / m_SymmetryCoefficient;
-          radialMedialnessWeights2[i] = exp( -0.5 * weightExponent * weightExponent );
-          tempValue2 += radialMedialnessWeights2[i] * radialMedialness2[i];
+          tempValue2 += ( m_UseFastGaussianWeights ? GaussianWeightTable::Evaluate( weightExponent ) :
+            exp( -0.5 * weightExponent * weightExponent ) ) * radialMedialness2[i];
         }
       }
             
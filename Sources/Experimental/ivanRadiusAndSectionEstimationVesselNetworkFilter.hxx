@@ -48,7 +48,13 @@ namespace ivan
  */
 template <class TInputNetwork, class TOutputNetwork, class TSourceImage>
 RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSourceImage>
-::RadiusAndSectionEstimationVesselNetworkFilter()
+::RadiusAndSectionEstimationVesselNetworkFilter() :
+  m_NextWorkItem( 0 ),
+  m_WorkChunkSize( 4 ),
+  m_WarmStart( false ),
+  m_WarmStartSearchRadius( 2.0 ),
+  m_OptimizationFailed( false ),
+  m_Interrupted( false )
 {
   // Modify superclass default values, can be overridden by subclasses
   this->SetNumberOfRequiredInputs(2);
@@ -91,21 +97,120 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
   // Get the input an output pointers
   typename TInputNetwork::ConstPointer inputPtr  = this->GetInput();
   typename TOutputNetwork::Pointer     outputPtr = this->GetOutput(0);
-  typename TSourceImage::Pointer       sourcePtr = dynamic_cast<SourceImageType*>
-    ( this->ProcessObject::GetInput(1) );
     
-  std::cout << "Estimating optimized radius and section..." << std::endl;
+  itkDebugMacro( "Estimating optimized radius and section..." );
+  
+  // Iterators for vessel branches and vessel points 
+  typename TInputNetwork::VesselBranchConstIterator  branchIt;
+  InputPointIterator     inPointIt;
+  OutputPointIterator    outPointIt;
+  
+  PointWorkItem item;
+  item.Branch = 0;
+  
+  this->m_WorkItems.clear();
+  		
+  // Clear output first as we will insert the points again
+  outputPtr->Clear();
+  
+  // Set the output spacing too
+  outputPtr->SetSpacing( inputPtr->GetSpacing() );
+    		  		
+  // Copy the branches and queue their points
+  for( branchIt = inputPtr->Begin(); branchIt != inputPtr->End(); ++branchIt )
+  {
+  	// First make a copy of the point itself and insert it in the output
+	  typename TInputNetwork::VesselBranchPointer outBranch = (*branchIt)->MakeCopy();
+	  	
+	  for( inPointIt = (*branchIt)->Begin(), outPointIt = outBranch->Begin();
+	    inPointIt != (*branchIt)->End(); ++inPointIt, ++outPointIt )
+	  {
+	    item.Input = inPointIt;
+	    item.Output = outPointIt;
+	    this->m_WorkItems.push_back( item );
+	  }
+	  
+	  // Push the branch into the output VesselNetwork
+	  outputPtr->PushBack( outBranch );
+	  
+	  ++item.Branch;
+  }
+  
+  this->m_NextWorkItem = 0;
+  this->m_OptimizationFailed = false;
+  this->m_Interrupted = false;
+  this->m_OptimizationErrorDescription.clear();
+  
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->FitPointsThreaderCallback, this );
+  this->GetMultiThreader()->SingleMethodExecute();
+  
+  this->m_WorkItems.clear();
+  
+  if( this->m_OptimizationFailed )
+    std::cerr << "EXCEPTION CAUGHT!" << this->m_OptimizationErrorDescription << std::endl;
+}
+
+
+/**
+ *
+ */
+template <class TInputNetwork, class TOutputNetwork, class TSourceImage>
+ITK_THREAD_RETURN_TYPE
+RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSourceImage>
+::FitPointsThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  
+  Self *filter = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  filter->ThreadedFitPoints( threadId );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputNetwork, class TOutputNetwork, class TSourceImage>
+bool
+RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSourceImage>
+::GetNextWorkChunk( unsigned int & begin, unsigned int & end )
+{
+  this->m_WorkMutex.Lock();
   
-  const unsigned int ImageDimension = SourceImageType::GetImageDimension(); 
+  // Stop handing out work if the token asks for it
+  if( this->m_CancellationToken.IsNotNull() && this->m_NextWorkItem < this->m_WorkItems.size() &&
+    this->m_CancellationToken->IsStopRequested() )
+  {
+    this->m_Interrupted = true;
+    this->m_NextWorkItem = this->m_WorkItems.size();
+  }
   
-  // Get access to the vessel branches
-  typename TInputNetwork::VesselBranchIterator                branchesIt;
+  begin = this->m_NextWorkItem;
+  end = vnl_math_min( begin + this->m_WorkChunkSize, (unsigned int)this->m_WorkItems.size() );
+  this->m_NextWorkItem = end;
   
-  // Create a gradient magnitude image function for gradient estimation
+  this->m_WorkMutex.Unlock();
+  
+  return begin < end;
+}
+
+
+/**
+ *
+ */
+template <class TInputNetwork, class TOutputNetwork, class TSourceImage>
+void
+RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSourceImage>
+::ThreadedFitPoints( unsigned int threadId )
+{
+  typename TSourceImage::Pointer       sourcePtr = dynamic_cast<SourceImageType*>
+    ( this->ProcessObject::GetInput(1) );
+  
+  // Every thread has its own cost function and optimizer
   
-  typedef typename TInputNetwork::ScalePixelType   InputScalePixelType;
-  typedef typename TOutputNetwork::ScalePixelType  OutputScalePixelType;
-     
   // Variables for optimization of radius and section
   
   typedef itk::Statistics::NormalVariateGenerator  GeneratorType;
@@ -140,7 +245,7 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
   typename OutputVesselBranchType::NormalVectorType  normal, finalNormal;
   	
   // Variables for optimization results    
-  double finalRadius, bestValue;
+  double finalRadius = 0.0, bestValue;
   unsigned int numberOfIterations;
   
   typename SourceImageType::PointType     point; // current point
@@ -152,30 +257,18 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
   typename SourceImageType::RegionType::IndexType  vesselPointStartIndex;
   typename SourceImageType::RegionType::SizeType::SizeValueType   vesselPointBaseSize;
   
-  // Iterators for vessel branches and vessel points 
-  typename TInputNetwork::VesselBranchConstIterator  branchIt;
-  typename TInputNetwork::VesselBranchType
-  	::VesselPointConstIterator     inPointIt;
-  typename TOutputNetwork::VesselBranchType
-  	::VesselPointIterator          outPointIt;
-  		
-  // Clear output first as we will insert the points again
-  outputPtr->Clear();
+  unsigned int begin, end;
   
-  // Set the output spacing too
-  outputPtr->SetSpacing( inputPtr->GetSpacing() );
-    		  		
-  // Iterate through the branches
-  for( branchIt = inputPtr->Begin(); branchIt != inputPtr->End(); ++branchIt )
+  while( this->GetNextWorkChunk( begin, end ) )
   {
-  	// First make a copy of the point itself and insert it in the output
-	  typename TInputNetwork::VesselBranchPointer outBranch = (*branchIt)->MakeCopy();
-	  	
-	  // Iterate through the points in the branches
-	  for( inPointIt = (*branchIt)->Begin(), outPointIt = outBranch->Begin();
-	    inPointIt != (*branchIt)->End(); ++inPointIt, ++outPointIt )
-	  {
-	  	index = (*inPointIt)->GetIndex();
+    for( unsigned int i = begin; i < end; ++i )
+    {
+      const PointWorkItem & item = this->m_WorkItems[i];
+      
+      // The previous point of the branch was fitted just before in this thread
+      const bool warmStart = this->m_WarmStart && i > begin && this->m_WorkItems[i-1].Branch == item.Branch;
+      
+	  	index = (*item.Input)->GetIndex();
 	    
 	    for( unsigned int k=0; k<SourceImageType::GetImageDimension(); ++k )
 	      point[k] = sourcePtr->GetSpacing()[k] * index[k]; // voxel center 
@@ -183,7 +276,7 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
 	    // Estimate a base size for the region. This avoids that the optimizer
       // tries to estimate a radius that is too large limiting the search space   
       vesselPointBaseSize = static_cast<typename SourceImageType::SizeType::SizeValueType>
-        ( ceil( 1.732050807 * (*inPointIt)->GetScale() ) + 1.0 ) + 4;
+        ( ceil( 1.732050807 * (*item.Input)->GetScale() ) + 1.0 ) + 4;
     
       if( vesselPointBaseSize % 2 == 0 )
         vesselPointBaseSize += 1;
@@ -212,20 +305,30 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
 	    // Optimization for estimating radius and section
 	    
 	    generator->Initialize(12345);
-	    optimizer->Initialize( 10 );
+	    optimizer->Initialize( warmStart ? this->m_WarmStartSearchRadius : 10 );
 	    
 	    costFunction->SetRegion( vesselPointRegion );
 	    costFunction->SetCenter( point );
 	    costFunction->Initialize();
 	    
-	    normal = (*inPointIt)->GetNormal();
+	    normal = (*item.Input)->GetNormal();
 	    normal.Normalize();
 	    
 	    // Initialize the optimizer with sqrt(3)*sigma as radius and the third eigenvector as the estimated normal
-	    initialPosition[0] = 1.732050807 * (*inPointIt)->GetScale();
-	    initialPosition[1] = normal[0];
-	    initialPosition[2] = normal[1];
-	    initialPosition[3] = normal[2];
+	    if( warmStart )
+	    {
+	      initialPosition[0] = finalRadius;
+	      initialPosition[1] = finalNormal[0];
+	      initialPosition[2] = finalNormal[1];
+	      initialPosition[3] = finalNormal[2];
+	    }
+	    else
+	    {
+	      initialPosition[0] = 1.732050807 * (*item.Input)->GetScale();
+	      initialPosition[1] = normal[0];
+	      initialPosition[2] = normal[1];
+	      initialPosition[3] = normal[2];
+	    }
 	    optimizer->SetInitialPosition( initialPosition );
 	    	    
 	    try 
@@ -234,7 +337,15 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
 	    } 
 	    catch (itk::ExceptionObject& excpt)
 	    {
-	      std::cerr << "EXCEPTION CAUGHT!" << excpt.GetDescription() << std::endl;
+	      // Stop all the threads by emptying the queue
+	      this->m_WorkMutex.Lock();
+	      if( !this->m_OptimizationFailed )
+	      {
+	        this->m_OptimizationFailed = true;
+	        this->m_OptimizationErrorDescription = excpt.GetDescription();
+	      }
+	      this->m_NextWorkItem = this->m_WorkItems.size();
+	      this->m_WorkMutex.Unlock();
 	      return;
 	    }  
 	          
@@ -247,22 +358,14 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
 	    numberOfIterations = optimizer->GetCurrentIteration();
 	    bestValue = optimizer->GetValue();
 	          
-	    std::cout << "Point " << index << std::endl;
-	    std::cout << " Radius     = " << finalRadius  << std::endl;
-	    std::cout << " Normal     = " << finalNormal  << std::endl;
-	    std::cout << " Iterations = " << numberOfIterations << std::endl;
-	    std::cout << " Best value = " << bestValue          << std::endl;
-	    std::cout << std::endl;
+	    itkDebugMacro( "Point " << index << ": Radius = " << finalRadius << ", Normal = " << finalNormal << ", Iterations = " 
+	      << numberOfIterations << ", Best value = " << bestValue );
 	    
-	    (*outPointIt)->SetRadius( finalRadius );
-	    (*outPointIt)->SetScale( finalRadius / 1.732050807 );
-	    (*outPointIt)->SetNormal( finalNormal );
-	  } // end for pointIt
-	  
-	  // Push the branch into the output VesselNetwork
-	  outputPtr->PushBack( outBranch );
-    
-  } // end for branchIt
+	    (*item.Output)->SetRadius( finalRadius );
+	    (*item.Output)->SetScale( finalRadius / 1.732050807 );
+	    (*item.Output)->SetNormal( finalNormal );
+    } // end for i
+  } // end while
 }
 
 
@@ -276,6 +379,11 @@ RadiusAndSectionEstimationVesselNetworkFilter<TInputNetwork,TOutputNetwork,TSour
 {
   Superclass::PrintSelf( os, indent );
 
+  os << indent << "WorkChunkSize: " << this->m_WorkChunkSize << std::endl;
+  os << indent << "WarmStart: " << this->m_WarmStart << std::endl;
+  os << indent << "WarmStartSearchRadius: " << this->m_WarmStartSearchRadius << std::endl;
+  os << indent << "CancellationToken: " << this->m_CancellationToken.GetPointer() << std::endl;
+  os << indent << "Interrupted: " << this->m_Interrupted << std::endl;
 }
 
 
@@ -36,6 +36,12 @@ SUCH DAMAGE.
 #include "ivanVesselNetworkSource.h"
 #include "ivanVesselNetwork.h"
 
+#include "ivanCancellationToken.h"
+
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
 namespace ivan
 {
   
@@ -50,6 +56,18 @@ namespace ivan
  * This filter requires two inputs, the input vessel network and the input image whose
  * values will be used to evaluate the medialness values. 
  *
+ * The fit at every point is independent, so points are distributed among the threads of the 
+ * filter. Threads take chunks of WorkChunkSize points from a shared queue when they finish 
+ * the previous chunk, so the load stays balanced even if the fits converge at different speeds. 
+ * Every thread uses its own cost function and optimizer.
+ *
+ * If WarmStart is on, a point whose previous point in the branch was fitted just before by the 
+ * same thread starts from its solution, with the smaller search radius WarmStartSearchRadius. 
+ * Larger values of WorkChunkSize make this more frequent.
+ *
+ * If a CancellationToken is set, no more chunks are handed out once it requests to stop. 
+ * The points that were not fitted keep their input values and Interrupted is set.
+ *
  */
 
 template <class TInputNetwork, class TOutputNetwork, 
@@ -83,12 +101,41 @@ public:
   void SetSourceImage( const SourceImageType * sourceImage );
   const SourceImageType * GetSourceImage() const;
   
+  /** Set/Get the number of points taken by a thread each time from the queue. Default is 4. */
+  itkSetClampMacro( WorkChunkSize, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( WorkChunkSize, unsigned int );
+  
+  /** Start every fit from the solution of the previous point of the branch. Default is false. */
+  itkSetMacro( WarmStart, bool );
+  itkGetConstMacro( WarmStart, bool );
+  itkBooleanMacro( WarmStart );
+  
+  /** Initial search radius of the optimizer for warm-started fits. Default is 2.0. */
+  itkSetMacro( WarmStartSearchRadius, double );
+  itkGetConstMacro( WarmStartSearchRadius, double );
+  
+  /** Set/Get the token used to cancel the estimation or limit its time. Default is NULL. */
+  itkSetObjectMacro( CancellationToken, CancellationToken );
+  itkGetObjectMacro( CancellationToken, CancellationToken );
+  
+  /** True if the last update was stopped by the cancellation token before fitting all the points. */
+  itkGetConstMacro( Interrupted, bool );
+  
 protected:
   RadiusEstimationVesselNetworkFilter();
   ~RadiusEstimationVesselNetworkFilter() {}
   
   void GenerateData();
   
+  /** Fit the points taken from the queue until it is empty. */
+  void ThreadedFitPoints( unsigned int threadId );
+  
+  /** Take the next chunk of points [begin, end) from the queue. Returns false if it is empty. */
+  bool GetNextWorkChunk( unsigned int & begin, unsigned int & end );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FitPointsThreaderCallback( void *arg );
+  
   virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
 
 private:
@@ -96,8 +143,33 @@ private:
   void operator=(const Self&);   //purposely not implemented
   
 private:
-	
-	
+  
+  typedef typename TInputNetwork::VesselBranchType::VesselPointConstIterator    InputPointIterator;
+  typedef typename TInputNetwork::VesselBranchType::VesselPointIterator          OutputPointIterator;
+  
+  /** Input and output points of a single fit. */
+  struct PointWorkItem
+  {
+    unsigned int          Branch;
+    InputPointIterator    Input;
+    OutputPointIterator   Output;
+  };
+  
+  std::vector<PointWorkItem>    m_WorkItems;
+  unsigned int                  m_NextWorkItem;
+  unsigned int                  m_WorkChunkSize;
+  
+  bool                          m_WarmStart;
+  double                        m_WarmStartSearchRadius;
+  
+  itk::SimpleFastMutexLock      m_WorkMutex;
+  
+  CancellationToken::Pointer    m_CancellationToken;
+  bool                          m_Interrupted;
+  
+  /** Description of the first exception thrown by the optimizer, if any. */
+  bool                          m_OptimizationFailed;
+  std::string                   m_OptimizationErrorDescription;
 };
 
 } // end namespace ivan
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanBSplineVesselCenterlineInterpolator.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: cubic spline interpolation and resampling of centerlines
 // Date: 2009/02/06
 
 
@@ -33,11 +33,15 @@ SUCH DAMAGE.
 
 #include "ivanVesselCenterlineAlgorithm.h"
 
+#include "vnl/vnl_math.h"
+
+#include <vector>
+
 
 namespace ivan
 {
   
-/** \class VesselBranchNode
+/** \class BSplineVesselCenterlineInterpolator
  *  \brief B-spline interpolation of vessel centerlines.
  *
  * This class interpolates centerlines consisting of sections stored in a container. 
@@ -45,6 +49,19 @@ namespace ivan
  * or specializations may interpolate the whole section as well. This is useful for 
  * example if we have a ray-casted section.
  *
+ * The centers are interpolated with a natural cubic spline parametrized by the chord length,
+ * and the centerline is resampled every SamplingDistance units of that length. If it is zero,
+ * the sections are kept at the input centers. Normals are the unit tangent of the spline, 
+ * oriented as the input normals, and radius and scale are interpolated linearly. The spline 
+ * coefficients are obtained by solving a tridiagonal system, so the cost is linear in the 
+ * number of sections.
+ *
+ * Process() resamples the centerline in place, reusing its section objects and only creating
+ * the ones exceeding the input number of sections. ComputeSamples() gives the resampled values
+ * without writing them, for VesselGraphCenterlineResampler. The section type must provide 
+ * Get/SetCenter(), Get/SetNormal(), Get/SetRadius(), Get/SetScale() and SetArclength() as 
+ * CircularVesselSection.
+ *
  * \ingroup
  *
  */
@@ -55,8 +72,8 @@ class ITK_EXPORT BSplineVesselCenterlineInterpolator
 {
 public:
 
-  typedef BSplineVesselCenterlineInterpolator  Self;
-  typedef VesselCenterlineAlgorithm            Superclass;
+  typedef BSplineVesselCenterlineInterpolator       Self;
+  typedef VesselCenterlineAlgorithm<TCenterline>    Superclass;
   
   typedef itk::SmartPointer<Self>                   Pointer;
   typedef itk::SmartPointer<const Self>             ConstPointer;
@@ -69,7 +86,8 @@ public:
   typedef typename CenterlineType::ConstPointer     CenterlineConstPointer;
   
   typedef typename CenterlineType::SectionType      SectionType;
-  typedef typename CenterlineType::PointType        PointType;
+  typedef typename SectionType::PointType           PointType;
+  typedef typename SectionType::VectorType          VectorType;
 
 public:
 
@@ -79,14 +97,42 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( BSplineVesselCenterlineInterpolator, VesselCenterlineAlgorithm );
   
-  /* Evaluate a new section at the specified input position. */
-  CenterlinePointer Evaluate( CenterlineConstPointer input ) = 0;
+  /** Set/Get the distance between resampled sections. Zero keeps the input centers. 
+    * Default is 0.5. */
+  itkSetMacro( SamplingDistance, double );
+  itkGetConstMacro( SamplingDistance, double );
+  
+  /* Return a new interpolated centerline. */
+  virtual OutputType Evaluate( const InputType & input ) const;
+  
+  /** Resample the centerline in place and return it. */
+  virtual CenterlinePointer Process( CenterlineType * centerline ) const;
+  
+  /** Values of a resampled section. The arclength is the chord length of the spline. */
+  struct SampleType
+  {
+    PointType     Center;
+    VectorType    Normal;
+    double        Radius;
+    double        Scale;
+    double        Arclength;
+  };
+  
+  typedef std::vector<SampleType>   SampleContainer;
+  
+  /** Compute the resampled sections of the centerline. */
+  void ComputeSamples( const CenterlineType * centerline, SampleContainer & samples ) const;
     
 protected:
   
   BSplineVesselCenterlineInterpolator();
   ~BSplineVesselCenterlineInterpolator();
   
+  /** Write the samples in the centerline, reusing its sections. */
+  void WriteSamples( const SampleContainer & samples, CenterlineType * centerline ) const;
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
 private:
 
   BSplineVesselCenterlineInterpolator( const Self & other );
@@ -94,7 +140,7 @@ private:
   
 protected:
 
-
+  double    m_SamplingDistance;
 };
 
 } // end namespace ivan
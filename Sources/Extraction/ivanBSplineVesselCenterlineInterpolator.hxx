@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanBSplineVesselCenterlineInterpolator.hxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: cubic spline interpolation and resampling of centerlines
 // Date: 2009/02/06
 
 #ifndef __ivanBSplineVesselCenterlineInterpolator_hxx
@@ -37,7 +37,8 @@ namespace ivan
 {
 
 template <class TCenterline>
-BSplineVesselCenterlineInterpolator<TCenterline>::BSplineVesselCenterlineInterpolator()
+BSplineVesselCenterlineInterpolator<TCenterline>::BSplineVesselCenterlineInterpolator() :
+  m_SamplingDistance( 0.5 )
 {
 
 }
@@ -51,19 +52,231 @@ BSplineVesselCenterlineInterpolator<TCenterline>::~BSplineVesselCenterlineInterp
 
 
 template <class TCenterline>
-BSplineVesselCenterlineInterpolator<TCenterline>::CenterlinePointer 
-BSplineVesselCenterlineInterpolator<TCenterline>::Evaluate( CenterlineConstPointer input )
+typename BSplineVesselCenterlineInterpolator<TCenterline>::OutputType 
+BSplineVesselCenterlineInterpolator<TCenterline>::Evaluate( const InputType & input ) const
 {
+  SampleContainer samples;
+  this->ComputeSamples( input, samples );
   
+  CenterlinePointer output = CenterlineType::New();
+  this->WriteSamples( samples, output );
   
+  return output;
 }
 
+
+template <class TCenterline>
+typename BSplineVesselCenterlineInterpolator<TCenterline>::CenterlinePointer 
+BSplineVesselCenterlineInterpolator<TCenterline>::Process( CenterlineType * centerline ) const
+{
+  SampleContainer samples;
+  this->ComputeSamples( centerline, samples );
+  this->WriteSamples( samples, centerline );
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+void 
+BSplineVesselCenterlineInterpolator<TCenterline>::ComputeSamples
+  ( const CenterlineType * centerline, SampleContainer & samples ) const
+{
+  const unsigned int dimension = PointType::PointDimension;
+  
+  samples.clear();
+  
+  // Knots of the spline, skipping repeated centers
+  std::vector<unsigned int> knots;
+  std::vector<double> t;
+  
+  knots.reserve( centerline->size() );
+  t.reserve( centerline->size() );
+  
+  for( unsigned int i=0; i<centerline->size(); ++i )
+  {
+    if( knots.empty() )
+    {
+      knots.push_back( i );
+      t.push_back( 0.0 );
+      continue;
+    }
+    
+    const double chord = centerline->at(i)->GetCenter().EuclideanDistanceTo
+      ( centerline->at( knots.back() )->GetCenter() );
+      
+    if( chord > 0.0 )
+    {
+      knots.push_back( i );
+      t.push_back( t.back() + chord );
+    }
+  }
+  
+  const unsigned int numberOfKnots = knots.size();
+  
+  if( numberOfKnots < 2 )
+  {
+    // Nothing to interpolate, keep the sections
+    for( unsigned int i=0; i<centerline->size(); ++i )
+    {
+      SampleType sample;
+      sample.Center = centerline->at(i)->GetCenter();
+      sample.Normal = centerline->at(i)->GetNormal();
+      sample.Radius = centerline->at(i)->GetRadius();
+      sample.Scale = centerline->at(i)->GetScale();
+      sample.Arclength = 0.0;
+      samples.push_back( sample );
+    }
+    
+    return;
+  }
+  
+  // Second derivatives at the knots, zero at the ends. The interior ones solve the 
+  // tridiagonal system h[k-1]*M[k-1] + 2*(h[k-1]+h[k])*M[k] + h[k]*M[k+1] = 6*(s[k]-s[k-1]), 
+  // with h the knot intervals and s the slopes, by forward elimination and back substitution
+  std::vector<VectorType> M( numberOfKnots );
+  std::vector<VectorType> d( numberOfKnots );
+  std::vector<double> c( numberOfKnots, 0.0 );
+  
+  M[0].Fill( 0.0 );
+  M[numberOfKnots-1].Fill( 0.0 );
+  
+  VectorType previousSlope = ( centerline->at( knots[1] )->GetCenter() - 
+    centerline->at( knots[0] )->GetCenter() ) / ( t[1] - t[0] );
+  VectorType slope;
+  
+  for( unsigned int k=1; k+1<numberOfKnots; ++k )
+  {
+    const double h0 = t[k] - t[k-1];
+    const double h1 = t[k+1] - t[k];
+    
+    slope = ( centerline->at( knots[k+1] )->GetCenter() - 
+      centerline->at( knots[k] )->GetCenter() ) / h1;
+    
+    const double denominator = 2.0 * ( h0 + h1 ) - ( k > 1 ? h0 * c[k-1] : 0.0 );
+    
+    c[k] = h1 / denominator;
+    d[k] = ( slope - previousSlope ) * 6.0;
+    
+    if( k > 1 )
+      d[k] -= d[k-1] * h0;
+    
+    d[k] /= denominator;
+    
+    previousSlope = slope;
+  }
+  
+  for( unsigned int k=numberOfKnots-2; k>0; --k )
+    M[k] = d[k] - M[k+1] * c[k];
+    
+  // Sample positions along the chord length, including the last knot
+  const double length = t[numberOfKnots-1];
+  std::vector<double> positions;
+  
+  if( this->m_SamplingDistance > 0.0 )
+  {
+    const unsigned int numberOfSteps = static_cast<unsigned int>( length / this->m_SamplingDistance );
+    
+    positions.reserve( numberOfSteps + 2 );
+    
+    for( unsigned int k=0; k<=numberOfSteps; ++k )
+      positions.push_back( k * this->m_SamplingDistance );
+      
+    if( length - positions.back() > 1e-6 * this->m_SamplingDistance )
+      positions.push_back( length );
+  }
+  else
+  {
+    positions = t;
+  }
+  
+  samples.resize( positions.size() );
+  
+  // Evaluate the spline, walking along the knot intervals
+  unsigned int k = 0;
+  
+  for( unsigned int i=0; i<positions.size(); ++i )
+  {
+    while( k + 2 < numberOfKnots && positions[i] > t[k+1] )
+      ++k;
+      
+    const SectionType *section = centerline->at( knots[k] );
+    const SectionType *nextSection = centerline->at( knots[k+1] );
+    
+    const double h = t[k+1] - t[k];
+    const double A = ( t[k+1] - positions[i] ) / h;
+    const double B = 1.0 - A;
+    
+    const double a = ( A * A * A - A ) * h * h / 6.0;
+    const double b = ( B * B * B - B ) * h * h / 6.0;
+    const double da = -( 3.0 * A * A - 1.0 ) * h / 6.0;
+    const double db = ( 3.0 * B * B - 1.0 ) * h / 6.0;
+    
+    SampleType & sample = samples[i];
+    VectorType tangent;
+    double dotProduct = 0.0;
+    
+    for( unsigned int dim=0; dim<dimension; ++dim )
+    {
+      sample.Center[dim] = A * section->GetCenter()[dim] + B * nextSection->GetCenter()[dim] +
+        a * M[k][dim] + b * M[k+1][dim];
+      tangent[dim] = ( nextSection->GetCenter()[dim] - section->GetCenter()[dim] ) / h +
+        da * M[k][dim] + db * M[k+1][dim];
+      dotProduct += tangent[dim] * section->GetNormal()[dim];
+    }
+    
+    const double norm = tangent.GetNorm();
+    
+    if( norm > 0.0 )
+      sample.Normal = tangent / ( dotProduct < 0.0 ? -norm : norm );
+    else
+      sample.Normal = section->GetNormal();
+    
+    sample.Radius = A * section->GetRadius() + B * nextSection->GetRadius();
+    sample.Scale = A * section->GetScale() + B * nextSection->GetScale();
+    sample.Arclength = positions[i];
+  }
+}
+
+
+template <class TCenterline>
+void 
+BSplineVesselCenterlineInterpolator<TCenterline>::WriteSamples
+  ( const SampleContainer & samples, CenterlineType * centerline ) const
+{
+  const unsigned int numberOfReusedSections = vnl_math_min
+    ( (unsigned int)samples.size(), (unsigned int)centerline->size() );
+    
+  centerline->resize( samples.size() );
+  
+  PointType center;
+  VectorType normal;
+  
+  for( unsigned int i=0; i<samples.size(); ++i )
+  {
+    if( i >= numberOfReusedSections )
+      centerline->at(i) = SectionType::New();
+    
+    SectionType *section = centerline->at(i);
+    
+    center = samples[i].Center;
+    normal = samples[i].Normal;
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( samples[i].Radius );
+    section->SetScale( samples[i].Scale );
+    section->SetArclength( samples[i].Arclength );
+  }
+}
+
+
 template <class TCenterline>
 void BSplineVesselCenterlineInterpolator<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
-  
+  os << indent << "SamplingDistance: " << m_SamplingDistance << std::endl;
 }
 
 } // end namespace ivan
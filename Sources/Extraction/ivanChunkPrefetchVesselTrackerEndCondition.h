@@ -0,0 +1,137 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkPrefetchVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that prefetches the chunks ahead of tracking
+// Date: 2012/11/05
+
+
+#ifndef __ivanChunkPrefetchVesselTrackerEndCondition_h
+#define __ivanChunkPrefetchVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+
+#include "itkVector.h"
+
+
+namespace ivan
+{
+
+/** \class ChunkPrefetchVesselTrackerEndCondition
+ *  \brief End condition that never stops tracking, and prefetches the chunks of a chunked 
+ *  image ahead of the current section.
+ *
+ * Every step, the direction of tracking is estimated from the last two section centers, taken
+ * from the step state of the tracker, and the chunks along that direction up to 
+ * PrefetchDistance chunks ahead are requested with the Prefetch() method of the image (see 
+ * ChunkedImage), padded by RadiusFactor times the scale of the section to cover the support of
+ * the image functions. The chunks are decompressed in the background while the tracker works
+ * on the current ones, so that tracking of volumes read on demand does not wait for them.
+ *
+ * The image must provide Prefetch( index, radius ) and GetChunkSize(). Finished() always 
+ * returns false, so adding this condition to a CompositeVesselTrackerEndCondition does not 
+ * change where tracking stops. Nothing is done if there is no image or step state.
+ *
+ */
+
+template <class TImage>
+class ITK_EXPORT ChunkPrefetchVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef ChunkPrefetchVesselTrackerEndCondition    Self;
+  typedef VesselTrackerEndCondition                 Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+  
+  typedef TImage                               ImageType;
+  typedef typename ImageType::ConstPointer     ImageConstPointer;
+  typedef typename ImageType::PointType        ImagePointType;
+  typedef typename ImageType::IndexType        ImageIndexType;
+  
+  typedef VesselTrackerStepState::PointType    PointType;
+  typedef itk::Vector<double,3>                DirectionType;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ChunkPrefetchVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Set/Get the image whose chunks are prefetched. */
+  itkSetConstObjectMacro( Image, ImageType );
+  itkGetConstObjectMacro( Image, ImageType );
+  
+  /** Set/Get how far ahead chunks are prefetched, in chunks. Default is 1.0. */
+  itkSetMacro( PrefetchDistance, double );
+  itkGetConstMacro( PrefetchDistance, double );
+  
+  /** Set/Get the radius of the prefetched region around the path ahead, in multiples of the
+    * scale of the section. Default is 3.0. */
+  itkSetMacro( RadiusFactor, double );
+  itkGetConstMacro( RadiusFactor, double );
+  
+  virtual bool Finished();
+  
+  virtual void Reset()
+    { this->m_HasLastPosition = false; }
+  
+  /** A few cache lookups. */
+  virtual double GetEvaluationCost() const
+    { return 0.0; }
+
+protected:
+  
+  ChunkPrefetchVesselTrackerEndCondition();
+  virtual ~ChunkPrefetchVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
+  
+  void Prefetch( const PointType & position, unsigned long radius ) const;
+      
+private:
+  
+  ChunkPrefetchVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  ImageConstPointer   m_Image;
+  
+  double              m_PrefetchDistance;
+  double              m_RadiusFactor;
+  
+  PointType           m_LastPosition;
+  bool                m_HasLastPosition;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanChunkPrefetchVesselTrackerEndCondition.hxx"
+#endif
+
+#endif
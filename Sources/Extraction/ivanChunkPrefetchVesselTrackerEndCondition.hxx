@@ -0,0 +1,142 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkPrefetchVesselTrackerEndCondition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that prefetches the chunks ahead of tracking
+// Date: 2012/11/05
+
+#ifndef __ivanChunkPrefetchVesselTrackerEndCondition_hxx
+#define __ivanChunkPrefetchVesselTrackerEndCondition_hxx
+
+#include "ivanChunkPrefetchVesselTrackerEndCondition.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TImage>
+ChunkPrefetchVesselTrackerEndCondition<TImage>
+::ChunkPrefetchVesselTrackerEndCondition() :
+  m_PrefetchDistance( 1.0 ),
+  m_RadiusFactor( 3.0 ),
+  m_HasLastPosition( false )
+{
+  this->m_LastPosition.Fill( 0.0 );
+}
+
+
+template <class TImage>
+void 
+ChunkPrefetchVesselTrackerEndCondition<TImage>
+::Prefetch( const PointType & position, unsigned long radius ) const
+{
+  ImagePointType point;
+  point.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < ImageType::ImageDimension && i < 3; ++i )
+    point[i] = position[i];
+    
+  ImageIndexType index;
+  
+  // Points outside the image are clipped by the image
+  this->m_Image->TransformPhysicalPointToIndex( point, index );
+  this->m_Image->Prefetch( index, radius );
+}
+
+
+template <class TImage>
+bool 
+ChunkPrefetchVesselTrackerEndCondition<TImage>
+::Finished()
+{
+  if( this->m_Image.IsNull() || !this->m_StepState || !this->m_StepState->Valid )
+    return false;
+  
+  const PointType & position = this->m_StepState->Position;
+  
+  // Smallest extent of a chunk and spacing, so that the samples along the path ahead are 
+  // closer than a chunk along every axis
+  
+  double chunkExtent = 0.0;
+  double spacing = 0.0;
+  
+  for( unsigned int dim = 0; dim < ImageType::ImageDimension; ++dim )
+  {
+    const double extent = this->m_Image->GetChunkSize()[dim] * this->m_Image->GetSpacing()[dim];
+    
+    if( dim == 0 || extent < chunkExtent )
+      chunkExtent = extent;
+    if( dim == 0 || this->m_Image->GetSpacing()[dim] < spacing )
+      spacing = this->m_Image->GetSpacing()[dim];
+  }
+  
+  const unsigned long radius = 
+    static_cast<unsigned long>( std::ceil( this->m_RadiusFactor * this->m_StepState->Scale / spacing ) );
+  
+  this->Prefetch( position, radius );
+  
+  if( this->m_HasLastPosition )
+  {
+    DirectionType direction = position - this->m_LastPosition;
+    const double norm = direction.GetNorm();
+    
+    if( norm > 0.0 )
+    {
+      direction /= norm;
+      
+      const unsigned int numberOfSamples = 
+        static_cast<unsigned int>( std::ceil( this->m_PrefetchDistance ) );
+      const double step = this->m_PrefetchDistance * chunkExtent / std::max( numberOfSamples, 1u );
+      
+      for( unsigned int i=1; i <= numberOfSamples; ++i )
+        this->Prefetch( position + direction * ( i * step ), radius );
+    }
+  }
+  
+  this->m_LastPosition = position;
+  this->m_HasLastPosition = true;
+  
+  return false;
+}
+	
+
+template <class TImage>
+void 
+ChunkPrefetchVesselTrackerEndCondition<TImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Image: " << this->m_Image.GetPointer() << std::endl;
+  os << indent << "PrefetchDistance: " << this->m_PrefetchDistance << std::endl;
+  os << indent << "RadiusFactor: " << this->m_RadiusFactor << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanChunkPrefetchVesselTrackerEndCondition_hxx
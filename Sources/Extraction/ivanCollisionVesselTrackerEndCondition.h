@@ -0,0 +1,175 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCollisionVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking inside already tracked vessels
+// Date: 2012/11/05
+
+
+#ifndef __ivanCollisionVesselTrackerEndCondition_h
+#define __ivanCollisionVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+#include "ivanVesselCenterlineSpatialIndex.h"
+
+#include "itkMutexLock.h"
+
+#include <set>
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class CollisionVesselTrackerEndCondition
+ *  \brief End condition that stops tracking when the current point enters an already tracked vessel.
+ *
+ * Tracking finishes when the center of the current section, taken from the step state of the 
+ * tracker, is within CollisionDistance of the surface of a vessel stored in a 
+ * VesselCenterlineSpatialIndex, other than the branch being tracked. This prevents several 
+ * seeds from tracking the same vessel again. Each check is a query to the bounding volume 
+ * hierarchy of the index plus a test of the sections appended since the hierarchy was last
+ * rebuilt (see VesselCenterlineSpatialIndex::AppendSections()).
+ *
+ * If AppendTrackedSections is on (the default), the sections of the branch being tracked are 
+ * appended to the index at every check, so the branches tracked later stop when they reach it. 
+ * Branches detected at a bifurcation start inside their parent vessel, and may run inside it 
+ * for a distance that depends on its radius, so with IgnoreAncestorBranches on (the default) 
+ * the branches above the tracked one in the graph, reached through the parents of its nodes, 
+ * are not collisions. The first NumberOfIgnoredSections sections of a branch are not checked 
+ * either, which covers branches that are not linked to their parent yet.
+ *
+ * The index may be shared by the end conditions of several trackers, so that each seed stops 
+ * at the vessels tracked from the others. If the trackers run concurrently, as in 
+ * MultiSeedVesselTrackerFilter, set the same mutex on all the end conditions. In that case
+ * where each branch stops depends on the order in which the seeds are tracked.
+ *
+ * \sa VesselCenterlineSpatialIndex
+ */
+
+template <class TCenterline>
+class ITK_EXPORT CollisionVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef CollisionVesselTrackerEndCondition    Self;
+  typedef VesselTrackerEndCondition             Superclass;
+  typedef itk::SmartPointer<Self>               Pointer;
+  typedef itk::SmartPointer<const Self>         ConstPointer;
+  
+  typedef VesselCenterlineSpatialIndex<TCenterline>   SpatialIndexType;
+  typedef typename SpatialIndexType::Pointer          SpatialIndexPointer;
+  typedef typename SpatialIndexType::PointType        PointType;
+  typedef typename SpatialIndexType::BranchNodeType   BranchNodeType;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CollisionVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Set/Get the index of the tracked vessels. */
+  itkSetObjectMacro( SpatialIndex, SpatialIndexType );
+  itkGetObjectMacro( SpatialIndex, SpatialIndexType );
+  
+  /** Set/Get the mutex that guards the index when it is shared between threads. */
+  itkSetObjectMacro( Mutex, itk::MutexLock );
+  itkGetObjectMacro( Mutex, itk::MutexLock );
+  
+  /** Distance to the vessel surface below which tracking finishes. Negative values require 
+    * the point to be that deep inside the vessel. Default is 0. */
+  itkSetMacro( CollisionDistance, double );
+  itkGetConstMacro( CollisionDistance, double );
+  
+  /** Number of sections at the start of each branch that are not checked. Default is 3. */
+  itkSetMacro( NumberOfIgnoredSections, unsigned int );
+  itkGetConstMacro( NumberOfIgnoredSections, unsigned int );
+  
+  /** Do not stop at the ancestor branches of the tracked branch. Default is on. */
+  itkSetMacro( IgnoreAncestorBranches, bool );
+  itkGetConstMacro( IgnoreAncestorBranches, bool );
+  itkBooleanMacro( IgnoreAncestorBranches );
+  
+  /** Append the sections of the tracked branch to the index. Default is on. */
+  itkSetMacro( AppendTrackedSections, bool );
+  itkGetConstMacro( AppendTrackedSections, bool );
+  itkBooleanMacro( AppendTrackedSections );
+  
+  /** Get the branch that the tracker collided with in the last check, or NULL. */
+  const BranchNodeType * GetCollisionBranch() const
+    { return m_CollisionBranch; }
+  
+  virtual bool Finished();
+  
+  virtual void Reset()
+    { m_CollisionBranch = 0; }
+  
+  /** A tree query. */
+  virtual double GetEvaluationCost() const
+    { return 2.0; }
+
+protected:
+  
+  CollisionVesselTrackerEndCondition();
+  virtual ~CollisionVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
+  
+  /** Collect the ancestor nodes of the given branch. They are collected at every check with
+    * hits, since the branch may be linked to its parents while it is tracked. */
+  void UpdateAncestorBranches( const BranchNodeType * branch );
+      
+private:
+  
+  CollisionVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  SpatialIndexPointer     m_SpatialIndex;
+  itk::MutexLock::Pointer m_Mutex;
+  
+  double                  m_CollisionDistance;
+  unsigned int            m_NumberOfIgnoredSections;
+  bool                    m_IgnoreAncestorBranches;
+  bool                    m_AppendTrackedSections;
+  
+  const BranchNodeType    *m_CollisionBranch;
+  
+  /** Ancestors of the last checked branch, kept to avoid allocating at every check. */
+  std::set<const GraphNode*>      m_AncestorBranches;
+  
+  /** Kept to avoid allocating at every check. */
+  typename SpatialIndexType::SegmentHitContainer  m_Hits;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanCollisionVesselTrackerEndCondition.hxx"
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCollisionVesselTrackerEndCondition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking inside already tracked vessels
+// Date: 2012/11/05
+
+#ifndef __ivanCollisionVesselTrackerEndCondition_hxx
+#define __ivanCollisionVesselTrackerEndCondition_hxx
+
+#include "ivanCollisionVesselTrackerEndCondition.h"
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+CollisionVesselTrackerEndCondition<TCenterline>
+::CollisionVesselTrackerEndCondition() :
+  m_CollisionDistance( 0.0 ),
+  m_NumberOfIgnoredSections( 3 ),
+  m_IgnoreAncestorBranches( true ),
+  m_AppendTrackedSections( true ),
+  m_CollisionBranch( 0 )
+{
+}
+
+
+template <class TCenterline>
+void 
+CollisionVesselTrackerEndCondition<TCenterline>
+::UpdateAncestorBranches( const BranchNodeType * branch )
+{
+  this->m_AncestorBranches.clear();
+  
+  if( !branch )
+    return;
+  
+  // Bifurcation nodes are inserted too, which does no harm
+  std::vector<const GraphNode*> pendingNodes( 1, branch );
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    for( unsigned int i=0; i<node->GetNumberOfParents(); ++i )
+    {
+      const GraphNode *parent = node->GetParent(i);
+      
+      if( parent && this->m_AncestorBranches.insert( parent ).second )
+        pendingNodes.push_back( parent );
+    }
+  }
+}
+
+
+template <class TCenterline>
+bool 
+CollisionVesselTrackerEndCondition<TCenterline>
+::Finished()
+{
+  this->m_CollisionBranch = 0;
+  
+  if( this->m_SpatialIndex.IsNull() || !this->m_StepState || !this->m_StepState->Valid )
+    return false;
+  
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( this->m_StepState->Branch );
+  
+  PointType point;
+  point.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < PointType::PointDimension && i < 3; ++i )
+    point[i] = this->m_StepState->Position[i];
+    
+  if( this->m_Mutex.IsNotNull() )
+    this->m_Mutex->Lock();
+  
+  if( this->m_AppendTrackedSections && branch )
+    this->m_SpatialIndex->AppendSections( branch );
+    
+  if( this->m_StepState->SectionIndex >= this->m_NumberOfIgnoredSections &&
+    this->m_SpatialIndex->FindSegmentsWithinDistance( point, this->m_CollisionDistance, 
+      this->m_Hits, branch ) )
+  {
+    if( this->m_IgnoreAncestorBranches )
+      this->UpdateAncestorBranches( branch );
+    
+    for( unsigned int i=0; i<this->m_Hits.size() && !this->m_CollisionBranch; ++i )
+    {
+      if( !this->m_IgnoreAncestorBranches || 
+        this->m_AncestorBranches.find( this->m_Hits[i].Branch ) == this->m_AncestorBranches.end() )
+        this->m_CollisionBranch = this->m_Hits[i].Branch;
+    }
+  }
+  
+  if( this->m_Mutex.IsNotNull() )
+    this->m_Mutex->Unlock();
+    
+  return this->m_CollisionBranch != 0;
+}
+	
+
+template <class TCenterline>
+void 
+CollisionVesselTrackerEndCondition<TCenterline>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "SpatialIndex: " << this->m_SpatialIndex.GetPointer() << std::endl;
+  os << indent << "Mutex: " << this->m_Mutex.GetPointer() << std::endl;
+  os << indent << "CollisionDistance: " << this->m_CollisionDistance << std::endl;
+  os << indent << "NumberOfIgnoredSections: " << this->m_NumberOfIgnoredSections << std::endl;
+  os << indent << "IgnoreAncestorBranches: " << this->m_IgnoreAncestorBranches << std::endl;
+  os << indent << "AppendTrackedSections: " << this->m_AppendTrackedSections << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanCollisionVesselTrackerEndCondition_hxx
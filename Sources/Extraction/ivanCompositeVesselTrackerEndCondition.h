@@ -0,0 +1,254 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCompositeVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that combines several end conditions
+// Date: 2012/11/05
+
+
+#ifndef __ivanCompositeVesselTrackerEndCondition_h
+#define __ivanCompositeVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+
+#include "itkTimeProbe.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class CompositeVesselTrackerEndCondition
+ *  \brief End condition that combines several end conditions.
+ *
+ * Tracking finishes as soon as any of the added end conditions is met, for example after a 
+ * maximum number of iterations, when the tracker leaves a mask or when the vesselness is too low.
+ * 
+ * The conditions are checked in order of increasing GetEvaluationCost(), so that counters and 
+ * bounds checks are done first and image function evaluations last. With ShortCircuit on (the 
+ * default), the remaining conditions are not checked once one is met. It may be turned off if 
+ * some condition must be updated at every step regardless of the others.
+ *
+ * If MeasureEvaluationCosts is on, the time spent in each condition is measured, and the 
+ * conditions are reordered by their mean time on Reset(), that is, before tracking again.
+ *
+ * The step state and Reset() are forwarded to all the conditions, so they share the values 
+ * published by the tracker.
+ *
+ */
+
+class ITK_EXPORT CompositeVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef CompositeVesselTrackerEndCondition   Self;
+  typedef VesselTrackerEndCondition            Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+  
+  typedef Superclass::Pointer                  EndConditionPointer;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CompositeVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Add an end condition. It is inserted according to its evaluation cost. */
+  void AddEndCondition( VesselTrackerEndCondition *endCondition )
+    {
+      if( !endCondition )
+        return;
+        
+      endCondition->SetStepState( this->m_StepState );
+      
+      EndConditionEntry entry;
+      entry.EndCondition = endCondition;
+      entry.Cost = endCondition->GetEvaluationCost();
+      
+      this->m_Entries.push_back( entry );
+      this->SortEndConditions();
+      
+      this->Modified();
+    }
+  
+  void ClearEndConditions()
+    {
+      this->m_Entries.clear();
+      this->m_FinishedEndCondition = 0;
+      this->Modified();
+    }
+    
+  unsigned int GetNumberOfEndConditions() const
+    { return this->m_Entries.size(); }
+  
+  /** Get the end conditions in the order they are checked. */
+  VesselTrackerEndCondition * GetEndCondition( unsigned int i )
+    { return this->m_Entries[i].EndCondition.GetPointer(); }
+  
+  /** Get the end condition that finished tracking in the last Finished() call, or NULL. */
+  VesselTrackerEndCondition * GetFinishedEndCondition()
+    { return this->m_FinishedEndCondition; }
+  
+  /** Stop checking as soon as one condition is met. Default is true. */
+  itkSetMacro( ShortCircuit, bool );
+  itkGetConstMacro( ShortCircuit, bool );
+  itkBooleanMacro( ShortCircuit );
+  
+  /** Measure the time spent in each condition and reorder them on Reset(). Default is false. */
+  itkSetMacro( MeasureEvaluationCosts, bool );
+  itkGetConstMacro( MeasureEvaluationCosts, bool );
+  itkBooleanMacro( MeasureEvaluationCosts );
+  
+  virtual void SetStepState( const VesselTrackerStepState *state )
+    {
+      Superclass::SetStepState( state );
+      
+      for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+        this->m_Entries[i].EndCondition->SetStepState( state );
+    }
+  
+  virtual void Reset()
+    {
+      this->m_FinishedEndCondition = 0;
+      
+      for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+        this->m_Entries[i].EndCondition->Reset();
+      
+      if( this->m_MeasureEvaluationCosts )
+      {
+        // Reorder with the times measured while tracking, keeping the hint for unmeasured 
+        // conditions
+        for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+        {
+          if( this->m_Entries[i].Probe.GetNumberOfStops() )
+            this->m_Entries[i].Cost = this->m_Entries[i].Probe.GetMeanTime();
+        }
+        
+        this->SortEndConditions();
+      }
+    }
+  
+  virtual bool Finished()
+    {
+      bool finished = false;
+      
+      this->m_FinishedEndCondition = 0;
+      
+      for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+      {
+        EndConditionEntry & entry = this->m_Entries[i];
+        
+        if( this->m_MeasureEvaluationCosts )
+          entry.Probe.Start();
+          
+        const bool conditionFinished = entry.EndCondition->Finished();
+        
+        if( this->m_MeasureEvaluationCosts )
+          entry.Probe.Stop();
+        
+        if( conditionFinished && !finished )
+        {
+          finished = true;
+          this->m_FinishedEndCondition = entry.EndCondition.GetPointer();
+        }
+        
+        if( finished && this->m_ShortCircuit )
+          break;
+      }
+      
+      return finished;
+    }
+  
+  /** The cost of the composite is the sum of the costs of its conditions. */
+  virtual double GetEvaluationCost() const
+    {
+      double cost = 0.0;
+      
+      for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+        cost += this->m_Entries[i].EndCondition->GetEvaluationCost();
+        
+      return cost;
+    }
+
+protected:
+  
+  CompositeVesselTrackerEndCondition() : 
+    m_FinishedEndCondition(0), m_ShortCircuit(true), m_MeasureEvaluationCosts(false) {}
+  virtual ~CompositeVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const
+    { 
+      Superclass::PrintSelf( os, indent );
+      os << indent << "ShortCircuit: " << this->m_ShortCircuit << std::endl;
+      os << indent << "MeasureEvaluationCosts: " << this->m_MeasureEvaluationCosts << std::endl;
+      os << indent << "NumberOfEndConditions: " << this->m_Entries.size() << std::endl;
+      
+      for( unsigned int i=0; i < this->m_Entries.size(); ++i )
+      {
+        os << indent << "EndCondition " << i << ": " 
+           << this->m_Entries[i].EndCondition->GetNameOfClass()
+           << " (cost " << this->m_Entries[i].Cost << ")" << std::endl;
+      }
+    }
+  
+  struct EndConditionEntry
+  {
+    EndConditionPointer   EndCondition;
+    double                Cost;
+    itk::TimeProbe        Probe;
+  };
+  
+  static bool CostLess( const EndConditionEntry & a, const EndConditionEntry & b )
+    { return a.Cost < b.Cost; }
+  
+  /** Sort the conditions by cost. Stable, so conditions of the same cost are checked in the 
+    * order they were added. */
+  void SortEndConditions()
+    { std::stable_sort( this->m_Entries.begin(), this->m_Entries.end(), CostLess ); }
+      
+private:
+  
+  CompositeVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  typedef std::vector<EndConditionEntry>   EndConditionContainerType;
+  
+  EndConditionContainerType    m_Entries;
+  
+  VesselTrackerEndCondition   *m_FinishedEndCondition;
+  
+  bool                         m_ShortCircuit;
+  bool                         m_MeasureEvaluationCosts;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,133 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCorridorVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that keeps tracking within a corridor around known vessels.
+// Date: 2012/11/05
+
+#ifndef __ivanCorridorVesselTrackerEndCondition_h
+#define __ivanCorridorVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+#include "ivanVesselCenterlineSpatialIndex.h"
+
+
+namespace ivan
+{
+
+/** \class CorridorVesselTrackerEndCondition
+ *  \brief End condition that stops tracking when the current point leaves a corridor around 
+ *  reference vessels.
+ *
+ * Tracking finishes when the center of the current section, taken from the step state of the 
+ * tracker, is farther than CorridorDistance from the surface of every vessel stored in a 
+ * VesselCenterlineSpatialIndex. This restricts the tracking to the neighbourhood of a known 
+ * centerline, for example the one tracked in the previous phase of a time series (see 
+ * TemporalVesselTrackerFilter), so that the tracker does not leave to nearby vessels. As with
+ * RegionVesselTrackerEndCondition, the first position outside the corridor is recorded.
+ *
+ * The index is only read, so once it is up to date (see VesselCenterlineSpatialIndex::Update())
+ * it may be shared by the end conditions of several trackers running concurrently. Nothing is checked if there is no index or step state.
+ *
+ * \sa VesselCenterlineSpatialIndex
+ * \sa CollisionVesselTrackerEndCondition
+ */
+
+template <class TCenterline>
+class ITK_EXPORT CorridorVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef CorridorVesselTrackerEndCondition     Self;
+  typedef VesselTrackerEndCondition             Superclass;
+  typedef itk::SmartPointer<Self>               Pointer;
+  typedef itk::SmartPointer<const Self>         ConstPointer;
+  
+  typedef VesselCenterlineSpatialIndex<TCenterline>   SpatialIndexType;
+  typedef typename SpatialIndexType::Pointer          SpatialIndexPointer;
+  typedef typename SpatialIndexType::PointType        PointType;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CorridorVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Set/Get the index of the vessels that define the corridor. */
+  itkSetObjectMacro( SpatialIndex, SpatialIndexType );
+  itkGetObjectMacro( SpatialIndex, SpatialIndexType );
+  
+  /** Distance to the surface of the reference vessels, in physical units, beyond which 
+    * tracking finishes. Default is 2.0. */
+  itkSetMacro( CorridorDistance, double );
+  itkGetConstMacro( CorridorDistance, double );
+  
+  /** Returns true if tracking left the corridor in the last check, and the position where it 
+    * did. */
+  itkGetConstMacro( LeftCorridor, bool );
+  itkGetConstReferenceMacro( ExitPosition, PointType );
+  
+  virtual bool Finished();
+  
+  virtual void Reset()
+    { m_LeftCorridor = false; }
+  
+  /** A tree query. */
+  virtual double GetEvaluationCost() const
+    { return 2.0; }
+
+protected:
+  
+  CorridorVesselTrackerEndCondition();
+  virtual ~CorridorVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
+      
+private:
+  
+  CorridorVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  SpatialIndexPointer     m_SpatialIndex;
+  
+  double                  m_CorridorDistance;
+  
+  bool                    m_LeftCorridor;
+  PointType               m_ExitPosition;
+  
+  /** Kept to avoid allocating at every check. */
+  typename SpatialIndexType::SegmentHitContainer  m_Hits;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanCorridorVesselTrackerEndCondition.hxx"
+#endif
+
+#endif
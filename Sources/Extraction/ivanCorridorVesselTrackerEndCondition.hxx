@@ -0,0 +1,91 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCorridorVesselTrackerEndCondition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that keeps tracking within a corridor around known vessels.
+// Date: 2012/11/05
+
+#ifndef __ivanCorridorVesselTrackerEndCondition_hxx
+#define __ivanCorridorVesselTrackerEndCondition_hxx
+
+#include "ivanCorridorVesselTrackerEndCondition.h"
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+CorridorVesselTrackerEndCondition<TCenterline>
+::CorridorVesselTrackerEndCondition() :
+  m_CorridorDistance( 2.0 ),
+  m_LeftCorridor( false )
+{
+  m_ExitPosition.Fill( 0.0 );
+}
+
+
+template <class TCenterline>
+bool 
+CorridorVesselTrackerEndCondition<TCenterline>
+::Finished()
+{
+  this->m_LeftCorridor = false;
+  
+  if( this->m_SpatialIndex.IsNull() || !this->m_StepState || !this->m_StepState->Valid )
+    return false;
+  
+  PointType point;
+  point.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < PointType::PointDimension && i < 3; ++i )
+    point[i] = this->m_StepState->Position[i];
+  
+  if( !this->m_SpatialIndex->FindSegmentsWithinDistance( point, this->m_CorridorDistance, 
+        this->m_Hits ) )
+  {
+    this->m_LeftCorridor = true;
+    this->m_ExitPosition = point;
+  }
+  
+  return this->m_LeftCorridor;
+}
+	
+
+template <class TCenterline>
+void 
+CorridorVesselTrackerEndCondition<TCenterline>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "SpatialIndex: " << this->m_SpatialIndex.GetPointer() << std::endl;
+  os << indent << "CorridorDistance: " << this->m_CorridorDistance << std::endl;
+  os << indent << "LeftCorridor: " << this->m_LeftCorridor << std::endl;
+  os << indent << "ExitPosition: " << this->m_ExitPosition << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanCorridorVesselTrackerEndCondition_hxx
@@ -30,11 +30,15 @@ SUCH DAMAGE.
 #ifndef __ivanCylindricalOffsetMedialnessVesselSectionFitCostFunction_h
 #define __ivanCylindricalOffsetMedialnessVesselSectionFitCostFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanImageBasedVesselSectionFitCostFunction.h"
 #include "ivanImageFunctionToCostFunctionAdaptor.h"
 #include "ivanOffsetMedialnessImageFunction.h"
 
 #include "itkImage.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
 
 
 namespace ivan
@@ -47,8 +51,14 @@ namespace ivan
  * an offset medialness value. This value is obtained as the sum of the gradients at an offset
  * location, which corresponds to a circle around the center point in the current vessel plane.
  *
- * Different from the OffsetMedialnessImageFunction
+ * Different from the OffsetMedialnessVesselSectionFitCostFunction, the value is the mean 
+ * medialness of NumberOfSections sections of the candidate cylinder, with the same normal and 
+ * radius and centers spaced SectionSpacing along the normal, around the section center. Sections 
+ * whose center is out of the image are not used. With a single section (default) both are the same.
  *
+ * The sections are independent, so they are split among NumberOfThreads threads within each 
+ * GetValue() call. This uses idle cores when a single section is fitted, as in interactive 
+ * seeding. The default is a single thread.
  *   
  */
 template <class TImage>
@@ -76,16 +86,16 @@ public:
   itkStaticConstMacro( ImageDimension, unsigned int, ImageType::ImageDimension );
   
   /** Parameters type for optimizer. */
-  typedef Superclass::ParametersType                  ParametersType ;
+  typedef typename Superclass::ParametersType         ParametersType;
   
   /** Type used for representing point components  */
-  typedef Superclass::ParametersValueType             CoordinateRepresentationType;
+  typedef typename Superclass::ParametersValueType    CoordinateRepresentationType;
   
-    /** Not used, but expected by SingleValuedNonLinearOptimizer class. */
-  typedef Superclass::DerivativeType                  DerivativeType;
+  /** Derivative type, a finite-difference approximation (see superclass). */
+  typedef typename Superclass::DerivativeType         DerivativeType;
 
   /** The cost value type. */
-  typedef Superclass::MeasureType                     MeasureType;
+  typedef typename Superclass::MeasureType            MeasureType;
   
   /** Offset medialness function adapted as a cost function. */
 	typedef ivan::OffsetMedialnessImageFunction
@@ -105,6 +115,18 @@ public:
   itkSetMacro( MaxRadius, double );
   itkGetConstMacro( MaxRadius, double );
   
+  /** Set/Get the number of sections of the cylinder. Default is 1. */
+  itkSetClampMacro( NumberOfSections, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfSections, unsigned int );
+  
+  /** Set/Get the distance between consecutive sections, in physical units. Default is 1.0. */
+  itkSetMacro( SectionSpacing, double );
+  itkGetConstMacro( SectionSpacing, double );
+  
+  /** Set/Get the number of threads used to evaluate the sections. Default is 1. */
+  itkSetClampMacro( NumberOfThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
   /** Set/Get the medialness function and its properties. */
   itkSetObjectMacro( MedialnessFunction, MedialnessFunctionType );
   itkGetObjectMacro( MedialnessFunction, MedialnessFunctionType );
@@ -123,16 +145,6 @@ public:
   /** Gets the cost function value. */
   virtual MeasureType GetValue(const ParametersType & parameters ) const ;
 
-  /** Dummy implementation to confirm to the SingleValuedCostFunction 
-   * interfaces. It is pure virtual in the superclass */
-  virtual void GetDerivative( const ParametersType & parameters,
-    DerivativeType & derivative ) const
-    {
-      itkWarningMacro( "GetDerivative() method not implemented yet." );
-    }
-
-	//virtual void GetValueAndDerivative( const ParametersType &parameters, 
-		//MeasureType &value, DerivativeType &derivative) const;
 
   //virtual unsigned int GetNumberOfParameters(void) const;
   
@@ -145,6 +157,17 @@ protected:
   virtual ~CylindricalOffsetMedialnessVesselSectionFitCostFunction();
   
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE EvaluateSectionsThreaderCallback( void *arg );
+  
+  /** Data of one GetValue() call shared by the threads. */
+  struct SectionsStruct
+  {
+    const MedialnessFunctionType      *MedialnessFunction;
+    const std::vector<CenterPointType> *Centers;
+    std::vector<double>               *Values;
+  };
 
 private:
   
@@ -157,10 +180,27 @@ private:
   
   /** Maximum radius allowed for the medialness calculations. */
   double                      m_MaxRadius; 
+  
+  unsigned int                m_NumberOfSections;
+  double                      m_SectionSpacing;
+  
+  unsigned int                m_NumberOfThreads;
+  itk::MultiThreader::Pointer m_MultiThreader;
 }; // end of class
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_CylindricalOffsetMedialnessVesselSectionFitCostFunction(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT CylindricalOffsetMedialnessVesselSectionFitCostFunction< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef CylindricalOffsetMedialnessVesselSectionFitCostFunction< ITK_TEMPLATE_1 x > \
+                                                  CylindricalOffsetMedialnessVesselSectionFitCostFunction##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanCylindricalOffsetMedialnessVesselSectionFitCostFunction+-.h"
+#endif
+
 #ifndef ITK_MANUAL_INSTANTIATION
 #include "ivanCylindricalOffsetMedialnessVesselSectionFitCostFunction.hxx"
 #endif
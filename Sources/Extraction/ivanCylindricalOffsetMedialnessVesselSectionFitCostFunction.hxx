@@ -40,8 +40,13 @@ namespace ivan
 template <class TImage>
 CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
 ::CylindricalOffsetMedialnessVesselSectionFitCostFunction() :
-  m_MaxRadius( 10.0 )
+  m_MaxRadius( 10.0 ),
+  m_NumberOfSections( 1 ),
+  m_SectionSpacing( 1.0 ),
+  m_NumberOfThreads( 1 )
 {
+  this->m_MultiThreader = itk::MultiThreader::New();
+  
 	this->m_MedialnessFunction = MedialnessFunctionType::New();
 	this->m_MedialnessFunction->AutoComputeSectionNormalOff();
 	  
@@ -130,9 +135,60 @@ CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
   this->m_MedialnessFunction->SetRadius( radius );  
   this->m_MedialnessFunction->SetSectionNormal( sectionNormal );
   
-  // Here the medialness function is always evaluated at the same point. However, the normal plane and radius
+  // Here the medialness function is always evaluated at the same points. However, the normal plane and radius
   // vary and so does the computation of the medialness at the offset locations
-  double medialness = this->m_MedialnessFunction->Evaluate( this->m_SectionCenter );
+  
+  // Centers of the sections along the cylinder axis, skipping those out of the image
+  std::vector<CenterPointType> centers;
+  centers.reserve( this->m_NumberOfSections );
+  
+  for( unsigned int k=0; k < this->m_NumberOfSections; ++k )
+  {
+    const double offset = ( k - 0.5 * ( this->m_NumberOfSections - 1.0 ) ) * this->m_SectionSpacing;
+    
+    CenterPointType center;
+    
+    for( unsigned int i=0; i<ImageDimension; ++i )
+      center[i] = this->m_SectionCenter[i] + offset * sectionNormal[i];
+    
+    if( this->m_NumberOfSections == 1 || this->m_MedialnessFunction->IsInsideBuffer( center ) )
+      centers.push_back( center );
+  }
+  
+  if( centers.empty() )
+    return itk::NumericTraits<MeasureType>::Zero;
+  
+  std::vector<double> values( centers.size() );
+  
+  unsigned int numberOfThreads = this->m_NumberOfThreads;
+  
+  if( numberOfThreads > centers.size() )
+    numberOfThreads = centers.size();
+  
+  if( numberOfThreads <= 1 )
+  {
+    for( unsigned int k=0; k < centers.size(); ++k )
+      values[k] = this->m_MedialnessFunction->Evaluate( centers[k] );
+  }
+  else
+  {
+    // The medialness function is not modified during evaluation, so it can be shared
+    SectionsStruct sections;
+    sections.MedialnessFunction = this->m_MedialnessFunction;
+    sections.Centers = &centers;
+    sections.Values = &values;
+    
+    this->m_MultiThreader->SetNumberOfThreads( numberOfThreads );
+    this->m_MultiThreader->SetSingleMethod( this->EvaluateSectionsThreaderCallback, &sections );
+    this->m_MultiThreader->SingleMethodExecute();
+  }
+  
+  double medialness = 0.0;
+  
+  for( unsigned int k=0; k < values.size(); ++k )
+    medialness += values[k];
+  
+  medialness /= values.size();
   
   // Now use a Lagrangian multiplier to implement the unit normal constraint
   //double constraint1 = lagrangeMult1 * ( 1.0 - sectionNormal[0] * sectionNormal[0] - 
@@ -143,6 +199,23 @@ CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
 }
 
 
+template <class TImage>
+ITK_THREAD_RETURN_TYPE
+CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
+::EvaluateSectionsThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const unsigned int numberOfThreads = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  
+  SectionsStruct *sections = (SectionsStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  for( unsigned int k = threadId; k < sections->Centers->size(); k += numberOfThreads )
+    (*sections->Values)[k] = sections->MedialnessFunction->Evaluate( (*sections->Centers)[k] );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
 template <class TImage>
 void
 CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
@@ -152,6 +225,9 @@ CylindricalOffsetMedialnessVesselSectionFitCostFunction<TImage>
   
   os << indent << "SectionCenter: " << this->m_SectionCenter << std::endl;
   os << indent << "MaxRadius: " << this->m_MaxRadius << std::endl;
+  os << indent << "NumberOfSections: " << this->m_NumberOfSections << std::endl;
+  os << indent << "SectionSpacing: " << this->m_SectionSpacing << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
   os << indent << "MedialnessFunction: " << this->m_MedialnessFunction.GetPointer() << std::endl;
   
   this->m_MedialnessFunction->Print( os, indent.GetNextIndent() );
@@ -50,6 +50,10 @@ namespace ivan
  *
  * It is assumed that the section has a Normal such as the CircularVesselSection.
  *
+ * Sections are independent, so ComputeRange() and ComputeAll() can distribute them among 
+ * NumberOfThreads threads. Additional threads use copies of the Hessian function with the same 
+ * parameters, except the derivative cache, which is not shared.
+ *
  * \ingroup 
  */
 
@@ -74,6 +78,8 @@ public:
   
   typedef typename CenterlineType::SectionType  SectionType;
   typedef typename SectionType::Pointer         SectionPointer;
+  
+  typedef typename Superclass::RangeValueType   RangeValueType;
 
   typedef TImage                                ImageType;
   typedef typename ImageType::Pointer           ImagePointer;
@@ -112,6 +118,13 @@ protected:
   /** Hessian kernel calculation is expensive so compute it only when properties change for 
     * fixed scale calculations. */
   void RecomputeKernel();
+  
+  virtual bool SupportsThreadedCompute() const
+    { return true; }
+  
+  virtual void BeforeThreadedCompute( unsigned int numberOfThreads );
+  virtual void ThreadedComputeSection( unsigned int sectionIdx, unsigned int threadId );
+  virtual void AfterThreadedCompute( RangeValueType first, RangeValueType last );
     
   void PrintSelf(std::ostream& os, itk::Indent indent) const;
 
@@ -127,6 +140,9 @@ protected:
   ImagePointer   m_Image;
   
   HessianFunctionPointer  m_HessianFunction;
+  
+  /** Copies of the Hessian function for threads other than the first one. */
+  std::vector<HessianFunctionPointer>   m_ThreadHessianFunctions;
 };
 
 } // end namespace ivan
@@ -164,6 +164,108 @@ FixedScaleHessianBasedVesselSectionEstimator<TImage,TCenterline, TMetricsCalcula
   m_HessianFunction->SetNormalizeAcrossScale( true );
   m_HessianFunction->SetUseImageSpacing( true );
   m_HessianFunction->Initialize();  
+  
+  // Thread copies are created again with the new parameters
+  m_ThreadHessianFunctions.clear();
+}
+
+
+template <class TImage, class TCenterline, class TMetricsCalculator>
+void
+FixedScaleHessianBasedVesselSectionEstimator<TImage,TCenterline, TMetricsCalculator>
+::BeforeThreadedCompute( unsigned int numberOfThreads )
+{
+  assert( this->m_Image.IsNotNull() );
+  
+  // Parameters may have been changed through GetHessianFunction() since the copies were created
+  m_ThreadHessianFunctions.clear();
+  
+  for( unsigned int t = 1; t < numberOfThreads; ++t )
+  {
+    HessianFunctionPointer hessianFunction = HessianFunctionType::New();
+    
+    hessianFunction->SetVariance( m_HessianFunction->GetVariance() );
+    hessianFunction->SetMaximumError( m_HessianFunction->GetMaximumError() );
+    hessianFunction->SetMaximumKernelWidth( m_HessianFunction->GetMaximumKernelWidth() );
+    hessianFunction->SetNormalizeAcrossScale( m_HessianFunction->GetNormalizeAcrossScale() );
+    hessianFunction->SetGamma( m_HessianFunction->GetGamma() );
+    hessianFunction->SetUseImageSpacing( m_HessianFunction->GetUseImageSpacing() );
+    hessianFunction->SetInterpolationMode( m_HessianFunction->GetInterpolationMode() );
+    hessianFunction->SetUseSeparableEvaluation( m_HessianFunction->GetUseSeparableEvaluation() );
+    hessianFunction->SetInputImage( this->m_Image );
+    hessianFunction->Initialize();
+    
+    m_ThreadHessianFunctions.push_back( hessianFunction );
+  }
+}
+
+
+template <class TImage, class TCenterline, class TMetricsCalculator>
+void
+FixedScaleHessianBasedVesselSectionEstimator<TImage,TCenterline, TMetricsCalculator>
+::ThreadedComputeSection( unsigned int sectionIdx, unsigned int threadId )
+{
+  typedef typename HessianTensorType::EigenVectorsMatrixType EigenVectorsMatrixType;
+  typedef typename HessianTensorType::EigenValuesArrayType   EigenValuesArrayType;
+  
+  EigenVectorsMatrixType eigenVectors;
+  EigenValuesArrayType   eigenValues;
+  
+  typename SectionType::VectorType          sectionNormal;
+  typename HessianFunctionType::PointType   centerPoint;
+  
+  HessianFunctionType *hessianFunction = threadId ? 
+    m_ThreadHessianFunctions[threadId-1].GetPointer() : m_HessianFunction.GetPointer();
+  
+  SectionPointer currentSection = this->GetCenterline()->at( sectionIdx );
+  
+  for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+    centerPoint[dim] = currentSection->GetCenter()[dim];
+  
+  if( !hessianFunction->IsInsideBuffer( centerPoint ) )
+  {
+    // A null normal is not flipped in AfterThreadedCompute()
+    sectionNormal.Fill(0.0);
+    currentSection->SetNormal( sectionNormal );
+    currentSection->SetRadius( 0.0 );
+    return;
+  }
+  
+  hessianFunction->Evaluate( centerPoint ).ComputeEigenAnalysis( eigenValues, eigenVectors );
+  
+  for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+    sectionNormal[dim] = eigenVectors( 2, dim ); // third eigenvector
+  
+  currentSection->SetNormal( sectionNormal );
+  currentSection->SetRadius( this->m_Scale / sqrt( 1.732 ) ); // see Krissian et al. for Gaussian tubes
+}
+
+
+template <class TImage, class TCenterline, class TMetricsCalculator>
+void
+FixedScaleHessianBasedVesselSectionEstimator<TImage,TCenterline, TMetricsCalculator>
+::AfterThreadedCompute( RangeValueType first, RangeValueType last )
+{
+  typename SectionType::VectorType sectionNormal;
+  double dotProduct;
+  
+  // Avoid changing sign in direction from the previous normal, as in Compute()
+  for( unsigned int i = vnl_math_max( first, 1u ); i <= last; ++i )
+  {
+    sectionNormal = this->GetCenterline()->at(i)->GetNormal();
+    
+    dotProduct = 0.0;
+    for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+      dotProduct += this->GetCenterline()->at(i-1)->GetNormal()[dim] * sectionNormal[dim];
+    
+    if( dotProduct < 0.0 )
+    {
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+        sectionNormal[dim] = -sectionNormal[dim]; 
+      
+      this->GetCenterline()->at(i)->SetNormal( sectionNormal );
+    }
+  }
 }
 
 
@@ -30,9 +30,11 @@ SUCH DAMAGE.
 #ifndef __ivanImageBasedVesselSectionFitCostFunction_h
 #define __ivanImageBasedVesselSectionFitCostFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanVesselSectionFitCostFunction.h"
 
 #include "itkImage.h"
+#include "itkArray.h"
 
 
 namespace ivan
@@ -46,6 +48,12 @@ namespace ivan
  * the section. The function must be designed so it gives a minimum (maximum) when the parameters
  * approximate well the real vessel section.
  *
+ * GetDerivative() is not analytic, but a finite-difference approximation with central 
+ * differences of GetValue(), so gradient-based optimizers can be used with any subclass. The 
+ * step of each parameter is DerivativeStepLength times its DerivativeStepScales entry or, if no 
+ * scales are set, times the magnitude of the parameter (at least 1). This keeps the relative step 
+ * similar for parameters of different units, such as normal components and radii. Subclasses with 
+ * closed-form derivatives should override GetDerivative().
  *   
  */
 template<class TImage>
@@ -77,11 +85,14 @@ public:
   /** Type used for representing point components  */
   typedef Superclass::ParametersValueType CoordinateRepresentationType;
   
-    /** Not used, but expected by SingleValuedNonLinearOptimizer class. */
+  /** Derivative type, used by gradient-based optimizers. */
   typedef Superclass::DerivativeType      DerivativeType;
 
   /** The cost value type. */
   typedef Superclass::MeasureType         MeasureType;
+  
+  /** Type of the scales of the finite-difference steps, one per parameter. */
+  typedef itk::Array<double>              ScalesType;
 	
 public:
   
@@ -103,13 +114,21 @@ public:
   /** Gets the cost function value. */
   //virtual MeasureType GetValue(const ParametersType & parameters ) const ;
 
-  /** Dummy implementation to confirm to the SingleValuedCostFunction 
-   * interfaces. It is pure virtual in the superclass */
-  //virtual void GetDerivative( const ParametersType & parameters,
-    //DerivativeType & derivative ) const;
+  /** Get the finite-difference derivative, see ComputeFiniteDifferenceDerivative(). */
+  virtual void GetDerivative( const ParametersType & parameters,
+    DerivativeType & derivative ) const;
 
-	//virtual void GetValueAndDerivative( const ParametersType &parameters, 
-		//MeasureType &value, DerivativeType &derivative) const;
+  virtual void GetValueAndDerivative( const ParametersType &parameters, 
+    MeasureType &value, DerivativeType &derivative) const;
+  
+  /** Set/Get the base step of the central differences. Default is 0.01. */
+  itkSetMacro( DerivativeStepLength, double );
+  itkGetConstMacro( DerivativeStepLength, double );
+  
+  /** Set/Get the scale of the step of each parameter. If empty (default), the step is scaled by 
+    * the magnitude of each parameter. */
+  itkSetMacro( DerivativeStepScales, ScalesType );
+  itkGetConstReferenceMacro( DerivativeStepScales, ScalesType );
 
   //virtual unsigned int GetNumberOfParameters(void) const;
   
@@ -123,6 +142,13 @@ protected:
 
   /** Destructor: */
   virtual ~ImageBasedVesselSectionFitCostFunction();
+  
+  /** Approximate the derivative with central differences of GetValue(). */
+  void ComputeFiniteDifferenceDerivative( const ParametersType & parameters,
+    DerivativeType & derivative ) const;
+  
+  /** Step of the central differences for the given parameter. */
+  double GetDerivativeStep( const ParametersType & parameters, unsigned int i ) const;
 
 private:
   
@@ -133,6 +159,9 @@ protected:
   
   /** Input image smart pointer. */
   ImagePointer      m_Image ;
+  
+  double            m_DerivativeStepLength;
+  ScalesType        m_DerivativeStepScales;
 
   /** Region of interest. */
   //RegionType        m_Region ;
@@ -140,6 +169,17 @@ protected:
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_ImageBasedVesselSectionFitCostFunction(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT ImageBasedVesselSectionFitCostFunction< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef ImageBasedVesselSectionFitCostFunction< ITK_TEMPLATE_1 x > \
+                                                  ImageBasedVesselSectionFitCostFunction##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanImageBasedVesselSectionFitCostFunction+-.h"
+#endif
+
 #ifndef ITK_MANUAL_INSTANTIATION
 #include "ivanImageBasedVesselSectionFitCostFunction.hxx"
 #endif
@@ -29,13 +29,16 @@ SUCH DAMAGE.
 #ifndef __ivanImageBasedVesselSectionFitCostFunction_hxx
 #define __ivanImageBasedVesselSectionFitCostFunction_hxx
 
+#include "vnl/vnl_math.h"
+
 
 namespace ivan
 {
 
 template<class TImage>
 ImageBasedVesselSectionFitCostFunction<TImage>
-::ImageBasedVesselSectionFitCostFunction()
+::ImageBasedVesselSectionFitCostFunction() :
+  m_DerivativeStepLength( 0.01 )
 {
 	
 }
@@ -48,6 +51,67 @@ ImageBasedVesselSectionFitCostFunction<TImage>
 
 }
 
+
+template<class TImage>
+void
+ImageBasedVesselSectionFitCostFunction<TImage>
+::GetDerivative( const ParametersType & parameters, DerivativeType & derivative ) const
+{
+  this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+}
+
+
+template<class TImage>
+void
+ImageBasedVesselSectionFitCostFunction<TImage>
+::ComputeFiniteDifferenceDerivative( const ParametersType & parameters, 
+  DerivativeType & derivative ) const
+{
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  
+  derivative.SetSize( numberOfParameters );
+  
+  ParametersType forwardParameters = parameters;
+  ParametersType backwardParameters = parameters;
+  
+  for( unsigned int i=0; i<numberOfParameters; ++i )
+  {
+    const double step = this->GetDerivativeStep( parameters, i );
+    
+    forwardParameters[i] = parameters[i] + step;
+    backwardParameters[i] = parameters[i] - step;
+    
+    derivative[i] = ( this->GetValue( forwardParameters ) - this->GetValue( backwardParameters ) ) /
+      ( 2.0 * step );
+    
+    forwardParameters[i] = parameters[i];
+    backwardParameters[i] = parameters[i];
+  }
+}
+
+
+template<class TImage>
+void
+ImageBasedVesselSectionFitCostFunction<TImage>
+::GetValueAndDerivative( const ParametersType & parameters, MeasureType & value, 
+  DerivativeType & derivative ) const
+{
+  value = this->GetValue( parameters );
+  this->GetDerivative( parameters, derivative );
+}
+
+
+template<class TImage>
+double
+ImageBasedVesselSectionFitCostFunction<TImage>
+::GetDerivativeStep( const ParametersType & parameters, unsigned int i ) const
+{
+  if( i < this->m_DerivativeStepScales.GetSize() )
+    return this->m_DerivativeStepLength * this->m_DerivativeStepScales[i];
+  else
+    return this->m_DerivativeStepLength * vnl_math_max( 1.0, (double)vnl_math_abs( parameters[i] ) );
+}
+
 } // end namespace ivan
 
 #endif
@@ -0,0 +1,139 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMaskVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking outside a mask
+// Date: 2012/11/05
+
+
+#ifndef __ivanMaskVesselTrackerEndCondition_h
+#define __ivanMaskVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+#include "ivanMaskRunLengthEncoding.h"
+
+#include "itkImageRegion.h"
+#include "itkTimeStamp.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class MaskVesselTrackerEndCondition
+ *  \brief End condition that stops tracking when the current section leaves a mask or region.
+ *
+ * Tracking finishes when the center of the current section, taken from the step state of the 
+ * tracker, is outside the given region of the mask image (the buffered region by default) or 
+ * where the mask is zero.
+ *
+ * The mask is encoded once in a bitmask that covers the bounding box of the mask pixels, so 
+ * each check is a bounds check and a bit lookup. The bitmask is rebuilt if the mask or the 
+ * region change. Nothing is checked if there is no mask or step state.
+ *
+ */
+
+template <class TMaskImage>
+class ITK_EXPORT MaskVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef MaskVesselTrackerEndCondition    Self;
+  typedef VesselTrackerEndCondition        Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+  
+  typedef TMaskImage                              MaskImageType;
+  typedef typename MaskImageType::ConstPointer    MaskImageConstPointer;
+  typedef typename MaskImageType::PointType       MaskPointType;
+  typedef typename MaskImageType::IndexType       MaskIndexType;
+  typedef typename MaskImageType::RegionType      RegionType;
+  
+  typedef MaskRunLengthEncoding<MaskImageType>    MaskEncodingType;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MaskVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Set/Get the mask image. */
+  itkSetConstObjectMacro( MaskImage, MaskImageType );
+  itkGetConstObjectMacro( MaskImage, MaskImageType );
+  
+  /** Set/Get the region of the mask where tracking is allowed. If not set, the buffered region 
+    * of the mask is used. */
+  void SetRegion( const RegionType & region )
+    {
+      this->m_Region = region;
+      this->m_RegionSet = true;
+      this->Modified();
+    }
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  /** Build the bitmask. This is done by Finished() if needed, but may be called in advance. */
+  void Initialize();
+  
+  virtual bool Finished();
+  
+  /** A bounds check and a bit lookup. */
+  virtual double GetEvaluationCost() const
+    { return 1.0; }
+
+protected:
+  
+  MaskVesselTrackerEndCondition();
+  virtual ~MaskVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
+      
+private:
+  
+  MaskVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  MaskImageConstPointer   m_MaskImage;
+  
+  RegionType              m_Region;
+  bool                    m_RegionSet;
+  
+  /** Bit for each pixel of the bounding box of the mask, in raster order. */
+  std::vector<bool>       m_BitMask;
+  RegionType              m_BoundingBox;
+  
+  itk::TimeStamp          m_BitMaskBuildTime;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanMaskVesselTrackerEndCondition.hxx"
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMaskVesselTrackerEndCondition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking outside a mask
+// Date: 2012/11/05
+
+#ifndef __ivanMaskVesselTrackerEndCondition_hxx
+#define __ivanMaskVesselTrackerEndCondition_hxx
+
+#include "ivanMaskVesselTrackerEndCondition.h"
+
+
+namespace ivan
+{
+
+template <class TMaskImage>
+MaskVesselTrackerEndCondition<TMaskImage>
+::MaskVesselTrackerEndCondition() :
+  m_RegionSet( false )
+{
+}
+
+
+template <class TMaskImage>
+void
+MaskVesselTrackerEndCondition<TMaskImage>
+::Initialize()
+{
+  this->m_BitMask.clear();
+  this->m_BoundingBox = RegionType();
+  
+  if( this->m_MaskImage.IsNull() )
+    return;
+    
+  typename MaskEncodingType::Pointer encoding = MaskEncodingType::New();
+  encoding->SetMaskImage( this->m_MaskImage );
+  
+  if( this->m_RegionSet )
+    encoding->SetRegion( this->m_Region );
+    
+  encoding->Initialize();
+  
+  this->m_BoundingBox = encoding->GetBoundingBox();
+  this->m_BitMask.assign( this->m_BoundingBox.GetNumberOfPixels(), false );
+  
+  const typename MaskEncodingType::RunContainerType & runs = encoding->GetRuns();
+  
+  for( unsigned int i=0; i < runs.size(); ++i )
+  {
+    unsigned long offset = 0;
+    unsigned long stride = 1;
+    
+    for( unsigned int dim = 0; dim < MaskImageType::ImageDimension; ++dim )
+    {
+      offset += ( runs[i].Index[dim] - this->m_BoundingBox.GetIndex()[dim] ) * stride;
+      stride *= this->m_BoundingBox.GetSize()[dim];
+    }
+    
+    for( unsigned long j=0; j < runs[i].Length; ++j )
+      this->m_BitMask[offset+j] = true;
+  }
+  
+  this->m_BitMaskBuildTime.Modified();
+}
+
+
+template <class TMaskImage>
+bool 
+MaskVesselTrackerEndCondition<TMaskImage>
+::Finished()
+{
+  if( this->m_MaskImage.IsNull() || !this->m_StepState || !this->m_StepState->Valid )
+    return false;
+  
+  if( this->GetMTime() > this->m_BitMaskBuildTime.GetMTime() || 
+    this->m_MaskImage->GetMTime() > this->m_BitMaskBuildTime.GetMTime() )
+  {
+    this->Initialize();
+  }
+  
+  MaskPointType point;
+  point.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < MaskImageType::ImageDimension && i < 3; ++i )
+    point[i] = this->m_StepState->Position[i];
+  
+  MaskIndexType index;
+  this->m_MaskImage->TransformPhysicalPointToIndex( point, index );
+  
+  // Outside the region or the bounding box of the mask
+  if( !this->m_BoundingBox.IsInside( index ) )
+    return true;
+    
+  unsigned long offset = 0;
+  unsigned long stride = 1;
+  
+  for( unsigned int dim = 0; dim < MaskImageType::ImageDimension; ++dim )
+  {
+    offset += ( index[dim] - this->m_BoundingBox.GetIndex()[dim] ) * stride;
+    stride *= this->m_BoundingBox.GetSize()[dim];
+  }
+    
+  return !this->m_BitMask[offset];
+}
+	
+
+template <class TMaskImage>
+void 
+MaskVesselTrackerEndCondition<TMaskImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "MaskImage: " << this->m_MaskImage.GetPointer() << std::endl;
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "RegionSet: " << this->m_RegionSet << std::endl;
+  os << indent << "BoundingBox: " << this->m_BoundingBox << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanMaskVesselTrackerEndCondition_hxx
@@ -74,6 +74,10 @@ public:
       else
         return false;
     }
+  
+  /** Just a counter. */
+  virtual double GetEvaluationCost() const
+    { return 0.0; }
 
 protected:
   
@@ -0,0 +1,261 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMinimalPathVesselExtractionFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: extracts the minimal path centerline between two seeds.
+// Date: 2012/11/05
+
+
+#ifndef __ivanMinimalPathVesselExtractionFilter_h
+#define __ivanMinimalPathVesselExtractionFilter_h
+
+#include "ivanImageToVesselDataObjectFilter.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkImageFunction.h"
+#include "itkImage.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class MinimalPathVesselExtractionFilter
+ * \brief Extracts the centerline between two seeds as the minimal path of a vesselness based cost.
+ *
+ * The cost of a pixel is 1/(Epsilon + max(V,0)^Power), where V is the response at the pixel, 
+ * so that paths through high responses are cheap. The response is the input image itself, such
+ * as a precomputed vesselness image, or the value of a VesselnessFunction evaluated at the 
+ * pixels reached, if one is set. The function must be initialized by the caller, and it is only 
+ * evaluated once per pixel.
+ *
+ * Arrival times are computed by a bidirectional fast marching, with first order upwind 
+ * updates on the face neighbours, from both seeds at the same time, keeping the front in a 
+ * binary heap. Only the region spanned by both seeds, enlarged by RegionMargin in physical 
+ * units, is processed, and only that region is requested from the input. Marching stops when 
+ * the first pixel is accepted by both fronts, which is taken as the meeting point of the path. 
+ * The path is back-traced from it to each seed by discrete steepest descent of the arrival times
+ * on all the neighbours, and smoothed with NumberOfSmoothingIterations of Laplacian smoothing 
+ * keeping the seeds fixed.
+ *
+ * The output is a VesselGraph whose root is a single VesselBranchNode with one section per path
+ * point, from the start to the end point. Normals are the direction of the path. If a scale 
+ * image is set, the scale of every section is taken from it and the radius is the scale times 
+ * ScaleToRadiusFactor, otherwise they are zero.
+ *
+ * \sa VesselTrackerFilter
+ */
+
+template <class TInputImage, class TOutputVessel, 
+  class TVesselnessFunction = itk::ImageFunction<TInputImage,double,double> >
+class ITK_EXPORT MinimalPathVesselExtractionFilter : 
+  public ImageToVesselDataObjectFilter<TInputImage,TOutputVessel>
+{
+public:
+	
+  /** Standard class typedefs. */
+  typedef MinimalPathVesselExtractionFilter
+    <TInputImage,TOutputVessel,TVesselnessFunction>   Self;
+  typedef ImageToVesselDataObjectFilter
+    <TInputImage,TOutputVessel>                       Superclass;
+  typedef itk::SmartPointer<Self>                     Pointer;
+  typedef itk::SmartPointer<const Self>               ConstPointer;
+  
+  /** Image-related typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::Pointer        InputImagePointer;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::RegionType     InputImageRegionType; 
+  typedef typename InputImageType::PixelType      InputImagePixelType;
+  typedef typename InputImageType::PointType      InputImagePointType;
+  typedef typename InputImageType::IndexType      InputImageIndexType; 
+  	
+  /** Vessel-related typedefs. */
+  typedef TOutputVessel                              OutputVesselType;
+  typedef typename OutputVesselType::Pointer         OutputVesselPointer;
+  typedef typename OutputVesselType::CenterlineType  CenterlineType;
+  typedef typename CenterlineType::SectionType       SectionType;
+    
+  typedef VesselBranchNode<CenterlineType>           BranchNodeType;
+  typedef typename BranchNodeType::Pointer           BranchNodePointer;
+  
+  /** Vesselness function typedefs. */
+  typedef TVesselnessFunction                        VesselnessFunctionType;
+  typedef typename VesselnessFunctionType::Pointer   VesselnessFunctionPointer;
+  
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  
+  /** Image of the scale of every pixel. */
+  typedef itk::Image<float,itkGetStaticConstMacro(InputImageDimension)>   ScaleImageType;
+  
+public:
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MinimalPathVesselExtractionFilter, ImageToVesselDataObjectFilter );
+  
+  /** Set/Get the seeds where the path starts and ends, in physical coordinates. */
+  itkSetMacro( StartPoint, InputImagePointType );
+  itkGetConstReferenceMacro( StartPoint, InputImagePointType );
+  itkSetMacro( EndPoint, InputImagePointType );
+  itkGetConstReferenceMacro( EndPoint, InputImagePointType );
+  
+  /** Set/Get the function evaluated for the response. If NULL, the input pixel values are the 
+    * response. Default is NULL. */
+  itkSetObjectMacro( VesselnessFunction, VesselnessFunctionType );
+  itkGetObjectMacro( VesselnessFunction, VesselnessFunctionType );
+  
+  /** Set/Get the image used to set the scale and radius of the sections. It must be up to date 
+    * and span the same physical space as the input. Default is NULL. */
+  itkSetConstObjectMacro( ScaleImage, ScaleImageType );
+  itkGetConstObjectMacro( ScaleImage, ScaleImageType );
+  
+  /** Set/Get the factor converting scales to radii. Default is sqrt(3), which is exact for
+    * the Hessian of a Gaussian profile tube (Krissian). */
+  itkSetMacro( ScaleToRadiusFactor, double );
+  itkGetConstMacro( ScaleToRadiusFactor, double );
+  
+  /** Set/Get the terms of the cost 1/(Epsilon + max(V,0)^Power). Epsilon must be positive, and
+    * it should be small compared to the response on the vessels. Defaults are 0.001 and 1.0. */
+  itkSetMacro( Epsilon, double );
+  itkGetConstMacro( Epsilon, double );
+  itkSetMacro( Power, double );
+  itkGetConstMacro( Power, double );
+  
+  /** Set/Get the margin added around the seeds to the processed region, in physical units. 
+    * Paths leaving this region are not found. Default is 10.0. */
+  itkSetMacro( RegionMargin, double );
+  itkGetConstMacro( RegionMargin, double );
+  
+  /** Set/Get the number of Laplacian smoothing iterations of the path. Default is 2. */
+  itkSetMacro( NumberOfSmoothingIterations, unsigned int );
+  itkGetConstMacro( NumberOfSmoothingIterations, unsigned int );
+  
+  /** Get the processed region of the last execution. */
+  itkGetConstReferenceMacro( ProcessedRegion, InputImageRegionType );
+  
+  /** Get the number of pixels accepted by both fronts in the last execution. */
+  itkGetConstMacro( NumberOfAcceptedPixels, unsigned long );
+  
+  /** Get the cost of the path found, that is, the sum of the arrival times of both fronts at 
+    * the meeting point. */
+  itkGetConstMacro( PathCost, double );
+  
+protected:
+  
+  MinimalPathVesselExtractionFilter();
+  ~MinimalPathVesselExtractionFilter() {}
+  
+  /** Request the region spanned by the seeds and the margin. */
+  virtual void GenerateInputRequestedRegion();
+  
+  virtual void GenerateData();
+  
+  /** Compute the region spanned by the seeds and the margin, inside the given region. */
+  InputImageRegionType ComputeProcessedRegion( const InputImageRegionType & region ) const;
+  
+  /** Cost of the pixel at the given offset of the processed region, evaluated once. */
+  double GetCost( const InputImageType *input, unsigned long offset, const InputImageIndexType & index );
+  
+  /** Arrival time of the given front at a pixel from its accepted face neighbours. */
+  double ComputeArrivalTime( unsigned int front, unsigned long offset, 
+    const InputImageIndexType & index, double cost ) const;
+  
+  /** Back-trace the path from the given pixel to the seed of the given front, by steepest 
+    * descent of its arrival times. The pixel is the first of the path. */
+  void BackTrace( unsigned int front, unsigned long offset, std::vector<unsigned long> & path ) const;
+  
+  /** Index of the pixel at the given offset of the processed region. */
+  InputImageIndexType GetIndex( unsigned long offset ) const
+    {
+      InputImageIndexType index;
+      
+      for( unsigned int d=0; d<InputImageDimension; ++d )
+      {
+        index[d] = this->m_ProcessedRegion.GetIndex()[d] + ( offset / this->m_Strides[d] ) % 
+          this->m_ProcessedRegion.GetSize()[d];
+      }
+      
+      return index;
+    }
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  MinimalPathVesselExtractionFilter(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+  /** Element of the fronts, ordered so that the heap top is the earliest arrival. */
+  struct FrontElement
+  {
+    double          Time;
+    unsigned long   Offset;
+    unsigned int    Front;
+    
+    bool operator<( const FrontElement & other ) const
+      { return this->Time > other.Time; }
+  };
+  
+protected:
+
+  InputImagePointType           m_StartPoint;
+  InputImagePointType           m_EndPoint;
+  
+  VesselnessFunctionPointer     m_VesselnessFunction;
+  
+  typename ScaleImageType::ConstPointer   m_ScaleImage;
+  double                        m_ScaleToRadiusFactor;
+  
+  double                        m_Epsilon;
+  double                        m_Power;
+  double                        m_RegionMargin;
+  unsigned int                  m_NumberOfSmoothingIterations;
+  
+  InputImageRegionType          m_ProcessedRegion;
+  unsigned long                 m_NumberOfAcceptedPixels;
+  double                        m_PathCost;
+  
+  /** Data of the processed region, by offset, only kept during GenerateData(). Costs are 
+    * negative until evaluated, and the state has one accepted bit per front. */
+  unsigned long                 m_Strides[InputImageDimension];
+  double                        m_Spacing[InputImageDimension];
+  std::vector<float>            m_Costs;
+  std::vector<float>            m_Times[2];
+  std::vector<unsigned char>    m_States;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanMinimalPathVesselExtractionFilter.hxx"
+#endif
+
+#endif
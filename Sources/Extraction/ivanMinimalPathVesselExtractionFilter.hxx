@@ -0,0 +1,545 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMinimalPathVesselExtractionFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: extracts the minimal path centerline between two seeds.
+// Date: 2012/11/05
+
+#ifndef __ivanMinimalPathVesselExtractionFilter_hxx
+#define __ivanMinimalPathVesselExtractionFilter_hxx
+
+#include "ivanMinimalPathVesselExtractionFilter.h"
+
+#include "itkContinuousIndex.h"
+#include "itkNumericTraits.h"
+
+#include <vnl/vnl_math.h>
+
+#include <queue>
+#include <algorithm>
+#include <cmath>
+
+namespace ivan
+{
+  
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::MinimalPathVesselExtractionFilter() :
+  m_ScaleToRadiusFactor( vcl_sqrt( 3.0 ) ),
+  m_Epsilon( 0.001 ),
+  m_Power( 1.0 ),
+  m_RegionMargin( 10.0 ),
+  m_NumberOfSmoothingIterations( 2 ),
+  m_NumberOfAcceptedPixels( 0 ),
+  m_PathCost( 0.0 )
+{
+  m_StartPoint.Fill( 0.0 );
+  m_EndPoint.Fill( 0.0 );
+  
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+  {
+    m_Strides[d] = 0;
+    m_Spacing[d] = 1.0;
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+typename MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>::InputImageRegionType
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::ComputeProcessedRegion( const InputImageRegionType & region ) const
+{
+  const InputImageType *input = 
+    static_cast<const InputImageType *>( this->itk::ProcessObject::GetInput(0) );
+  
+  InputImageIndexType startIndex, endIndex;
+  input->TransformPhysicalPointToIndex( this->m_StartPoint, startIndex );
+  input->TransformPhysicalPointToIndex( this->m_EndPoint, endIndex );
+  
+  InputImageRegionType processedRegion;
+  
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+  {
+    const long margin = static_cast<long>( vcl_ceil( this->m_RegionMargin / input->GetSpacing()[d] ) );
+    
+    const long regionStart = region.GetIndex()[d];
+    const long regionEnd = regionStart + static_cast<long>( region.GetSize()[d] ) - 1;
+    
+    const long first = std::max( std::min<long>( startIndex[d], endIndex[d] ) - margin, regionStart );
+    const long last = std::min( std::max<long>( startIndex[d], endIndex[d] ) + margin, regionEnd );
+    
+    processedRegion.SetIndex( d, first );
+    processedRegion.SetSize( d, ( last >= first ) ? last - first + 1 : 0 );
+  }
+  
+  return processedRegion;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  if( !this->GetInput() )
+    return;
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  
+  const InputImageRegionType region = this->ComputeProcessedRegion( input->GetLargestPossibleRegion() );
+  
+  // Seeds outside the image are reported in GenerateData()
+  if( region.GetNumberOfPixels() )
+    input->SetRequestedRegion( region );
+  else
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+double
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::GetCost( const InputImageType *input, unsigned long offset, const InputImageIndexType & index )
+{
+  float & cost = this->m_Costs[offset];
+  
+  if( cost < 0.0f )
+  {
+    double response = this->m_VesselnessFunction.IsNotNull() ? 
+      static_cast<double>( this->m_VesselnessFunction->EvaluateAtIndex( index ) ) :
+      static_cast<double>( input->GetPixel( index ) );
+    
+    if( response < 0.0 )
+      response = 0.0;
+    
+    cost = static_cast<float>( 1.0 / ( this->m_Epsilon + vcl_pow( response, this->m_Power ) ) );
+  }
+  
+  return cost;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+double
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::ComputeArrivalTime( unsigned int front, unsigned long offset, const InputImageIndexType & index,
+  double cost ) const
+{
+  const unsigned char accepted = 1 << front;
+  const std::vector<float> & times = this->m_Times[front];
+  
+  // Smallest accepted time of the face neighbours along every direction, sorted
+  double values[InputImageDimension], weights[InputImageDimension];
+  unsigned int n = 0;
+  
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+  {
+    double value = itk::NumericTraits<double>::max();
+    
+    const long position = index[d] - this->m_ProcessedRegion.GetIndex()[d];
+    
+    if( position > 0 && ( this->m_States[offset - this->m_Strides[d]] & accepted ) )
+      value = times[offset - this->m_Strides[d]];
+    
+    if( position + 1 < static_cast<long>( this->m_ProcessedRegion.GetSize()[d] ) && 
+        ( this->m_States[offset + this->m_Strides[d]] & accepted ) )
+      value = std::min<double>( value, times[offset + this->m_Strides[d]] );
+    
+    if( value == itk::NumericTraits<double>::max() )
+      continue;
+    
+    unsigned int i = n++;
+    
+    for( ; i > 0 && values[i-1] > value; --i )
+    {
+      values[i] = values[i-1];
+      weights[i] = weights[i-1];
+    }
+    
+    values[i] = value;
+    weights[i] = 1.0 / ( this->m_Spacing[d] * this->m_Spacing[d] );
+  }
+  
+  assert( n > 0 );
+  
+  // Solve sum_k w_k (T - a_k)^2 = cost^2 with the upwind neighbours, adding them in increasing 
+  // order while the solution is larger than the next one
+  double time = values[0] + cost / vcl_sqrt( weights[0] );
+  double a = 0.0, b = 0.0, c = -cost * cost;
+  
+  for( unsigned int k=0; k<n; ++k )
+  {
+    a += weights[k];
+    b -= 2.0 * weights[k] * values[k];
+    c += weights[k] * values[k] * values[k];
+    
+    const double discriminant = b * b - 4.0 * a * c;
+    
+    if( discriminant < 0.0 )
+      break;
+    
+    time = ( -b + vcl_sqrt( discriminant ) ) / ( 2.0 * a );
+    
+    if( k + 1 == n || time <= values[k+1] )
+      break;
+  }
+  
+  return time;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::BackTrace( unsigned int front, unsigned long offset, std::vector<unsigned long> & path ) const
+{
+  const unsigned char accepted = 1 << front;
+  const std::vector<float> & times = this->m_Times[front];
+  
+  unsigned int numberOfNeighbours = 1;
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+    numberOfNeighbours *= 3;
+  
+  path.clear();
+  path.push_back( offset );
+  
+  unsigned long current = offset;
+  
+  // Accepted pixels other than the seed always have an accepted face neighbour with a smaller
+  // time, the one they were updated from, so this reaches the seed
+  while( times[current] > 0.0f )
+  {
+    const InputImageIndexType index = this->GetIndex( current );
+    
+    unsigned long next = current;
+    float nextTime = times[current];
+    
+    for( unsigned int n=0; n<numberOfNeighbours; ++n )
+    {
+      long neighbourOffset = 0;
+      bool inside = true;
+      unsigned int code = n;
+      
+      for( unsigned int d=0; d<InputImageDimension && inside; ++d, code /= 3 )
+      {
+        const long step = static_cast<long>( code % 3 ) - 1;
+        const long position = index[d] - this->m_ProcessedRegion.GetIndex()[d] + step;
+        
+        inside = ( position >= 0 && position < static_cast<long>( this->m_ProcessedRegion.GetSize()[d] ) );
+        neighbourOffset += step * static_cast<long>( this->m_Strides[d] );
+      }
+      
+      if( !inside || !neighbourOffset )
+        continue;
+      
+      const unsigned long neighbour = current + neighbourOffset;
+      
+      if( ( this->m_States[neighbour] & accepted ) && times[neighbour] < nextTime )
+      {
+        next = neighbour;
+        nextTime = times[neighbour];
+      }
+    }
+    
+    if( next == current )
+      break;
+    
+    current = next;
+    path.push_back( current );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::GenerateData()
+{
+  const InputImageType *input = this->GetInput();
+  
+  this->m_ProcessedRegion = this->ComputeProcessedRegion( input->GetBufferedRegion() );
+  this->m_NumberOfAcceptedPixels = 0;
+  this->m_PathCost = 0.0;
+  
+  InputImageIndexType seeds[2];
+  
+  if( !input->TransformPhysicalPointToIndex( this->m_StartPoint, seeds[0] ) ||
+      !input->TransformPhysicalPointToIndex( this->m_EndPoint, seeds[1] ) ||
+      !this->m_ProcessedRegion.IsInside( seeds[0] ) || !this->m_ProcessedRegion.IsInside( seeds[1] ) )
+  {
+    itkExceptionMacro( "The start and end points must be inside the input image." );
+  }
+  
+  unsigned long numberOfPixels = 1;
+  
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+  {
+    this->m_Strides[d] = numberOfPixels;
+    this->m_Spacing[d] = input->GetSpacing()[d];
+    numberOfPixels *= this->m_ProcessedRegion.GetSize()[d];
+  }
+  
+  this->m_Costs.assign( numberOfPixels, -1.0f );
+  this->m_Times[0].assign( numberOfPixels, itk::NumericTraits<float>::max() );
+  this->m_Times[1].assign( numberOfPixels, itk::NumericTraits<float>::max() );
+  this->m_States.assign( numberOfPixels, 0 );
+  
+  // Both fronts share the heap, so that they advance at the same speed and meet halfway
+  std::priority_queue<FrontElement> heap;
+  
+  unsigned long seedOffsets[2];
+  
+  for( unsigned int f=0; f<2; ++f )
+  {
+    seedOffsets[f] = 0;
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+      seedOffsets[f] += ( seeds[f][d] - this->m_ProcessedRegion.GetIndex()[d] ) * this->m_Strides[d];
+    
+    this->m_Times[f][seedOffsets[f]] = 0.0f;
+    
+    FrontElement element;
+    element.Time = 0.0;
+    element.Offset = seedOffsets[f];
+    element.Front = f;
+    heap.push( element );
+  }
+  
+  bool met = false;
+  unsigned long meetingOffset = 0;
+  
+  while( !heap.empty() && !met )
+  {
+    const FrontElement element = heap.top();
+    heap.pop();
+    
+    const unsigned long offset = element.Offset;
+    const unsigned char accepted = 1 << element.Front;
+    
+    // Elements are not removed from the heap when their time decreases, so skip the stale ones
+    if( ( this->m_States[offset] & accepted ) || element.Time > this->m_Times[element.Front][offset] )
+      continue;
+    
+    this->m_States[offset] |= accepted;
+    ++this->m_NumberOfAcceptedPixels;
+    
+    if( this->m_States[offset] == 3 )
+    {
+      met = true;
+      meetingOffset = offset;
+      break;
+    }
+    
+    const InputImageIndexType index = this->GetIndex( offset );
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+    {
+      for( int step = -1; step <= 1; step += 2 )
+      {
+        const long position = index[d] - this->m_ProcessedRegion.GetIndex()[d] + step;
+        
+        if( position < 0 || position >= static_cast<long>( this->m_ProcessedRegion.GetSize()[d] ) )
+          continue;
+        
+        const unsigned long neighbour = ( step > 0 ) ? offset + this->m_Strides[d] : offset - this->m_Strides[d];
+        
+        if( this->m_States[neighbour] & accepted )
+          continue;
+        
+        InputImageIndexType neighbourIndex = index;
+        neighbourIndex[d] += step;
+        
+        const double cost = this->GetCost( input, neighbour, neighbourIndex );
+        const double time = this->ComputeArrivalTime( element.Front, neighbour, neighbourIndex, cost );
+        
+        if( time < this->m_Times[element.Front][neighbour] )
+        {
+          this->m_Times[element.Front][neighbour] = static_cast<float>( time );
+          
+          FrontElement neighbourElement;
+          neighbourElement.Time = static_cast<float>( time );
+          neighbourElement.Offset = neighbour;
+          neighbourElement.Front = element.Front;
+          heap.push( neighbourElement );
+        }
+      }
+    }
+  }
+  
+  if( !met )
+  {
+    this->m_Costs.clear();
+    itkExceptionMacro( "The start and end points are not connected in the processed region." );
+  }
+  
+  this->m_PathCost = this->m_Times[0][meetingOffset] + this->m_Times[1][meetingOffset];
+  
+  // Path from the start to the end point, through the meeting point
+  std::vector<unsigned long> firstHalf, secondHalf;
+  this->BackTrace( 0, meetingOffset, firstHalf );
+  this->BackTrace( 1, meetingOffset, secondHalf );
+  
+  typedef itk::ContinuousIndex<double,InputImageDimension>   ContinuousIndexType;
+  std::vector<unsigned long> pathOffsets( firstHalf.rbegin(), firstHalf.rend() );
+  pathOffsets.insert( pathOffsets.end(), secondHalf.begin() + 1, secondHalf.end() );
+  
+  std::vector<ContinuousIndexType> path( pathOffsets.size() );
+  
+  for( unsigned int i=0; i < pathOffsets.size(); ++i )
+  {
+    const InputImageIndexType index = this->GetIndex( pathOffsets[i] );
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+      path[i][d] = index[d];
+  }
+  
+  // The ends are the seeds themselves, not the centers of their pixels
+  input->TransformPhysicalPointToContinuousIndex( this->m_StartPoint, path.front() );
+  input->TransformPhysicalPointToContinuousIndex( this->m_EndPoint, path.back() );
+  
+  for( unsigned int iteration=0; iteration < this->m_NumberOfSmoothingIterations; ++iteration )
+  {
+    std::vector<ContinuousIndexType> smoothedPath( path );
+    
+    for( unsigned int i=1; i + 1 < path.size(); ++i )
+    {
+      for( unsigned int d=0; d<InputImageDimension; ++d )
+        smoothedPath[i][d] = 0.25 * path[i-1][d] + 0.5 * path[i][d] + 0.25 * path[i+1][d];
+    }
+    
+    path.swap( smoothedPath );
+  }
+  
+  std::vector<float>().swap( this->m_Costs );
+  std::vector<float>().swap( this->m_Times[0] );
+  std::vector<float>().swap( this->m_Times[1] );
+  std::vector<unsigned char>().swap( this->m_States );
+  
+  // Build the output branch
+  std::vector<InputImagePointType> points( path.size() );
+  
+  for( unsigned int i=0; i < path.size(); ++i )
+    input->TransformContinuousIndexToPhysicalPoint( path[i], points[i] );
+  
+  BranchNodePointer branch = BranchNodeType::New();
+  typename CenterlineType::Pointer centerline = branch->GetCenterline();
+  
+  for( unsigned int i=0; i < points.size(); ++i )
+  {
+    typename SectionType::Pointer section = SectionType::New();
+    section->SetCenter( points[i] );
+    
+    // Direction of the path, by central differences inside
+    const InputImagePointType & previous = points[ i > 0 ? i-1 : i ];
+    const InputImagePointType & next = points[ i + 1 < points.size() ? i+1 : i ];
+    
+    typename SectionType::VectorType normal;
+    double norm = 0.0;
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+    {
+      normal[d] = next[d] - previous[d];
+      norm += normal[d] * normal[d];
+    }
+    
+    norm = vcl_sqrt( norm );
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+      normal[d] = ( norm > 0.0 ) ? normal[d] / norm : 0.0;
+    
+    section->SetNormal( normal );
+    
+    if( this->m_ScaleImage.IsNotNull() )
+    {
+      typename ScaleImageType::IndexType scaleIndex;
+      
+      if( this->m_ScaleImage->TransformPhysicalPointToIndex( points[i], scaleIndex ) &&
+          this->m_ScaleImage->GetBufferedRegion().IsInside( scaleIndex ) )
+      {
+        const double scale = this->m_ScaleImage->GetPixel( scaleIndex );
+        section->SetScale( scale );
+        section->SetRadius( scale * this->m_ScaleToRadiusFactor );
+      }
+    }
+    
+    centerline->push_back( section );
+  }
+  
+  this->GetOutput(0)->SetRootNode( branch );
+  
+  itkDebugMacro( "Path of " << points.size() << " sections and cost " << this->m_PathCost 
+    << ", accepted " << this->m_NumberOfAcceptedPixels << " of " << numberOfPixels << " pixels" );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void 
+MinimalPathVesselExtractionFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "StartPoint: " << this->m_StartPoint << std::endl;
+  os << indent << "EndPoint: " << this->m_EndPoint << std::endl;
+  os << indent << "VesselnessFunction: " << this->m_VesselnessFunction.GetPointer() << std::endl;
+  os << indent << "ScaleImage: " << this->m_ScaleImage.GetPointer() << std::endl;
+  os << indent << "ScaleToRadiusFactor: " << this->m_ScaleToRadiusFactor << std::endl;
+  os << indent << "Epsilon: " << this->m_Epsilon << std::endl;
+  os << indent << "Power: " << this->m_Power << std::endl;
+  os << indent << "RegionMargin: " << this->m_RegionMargin << std::endl;
+  os << indent << "NumberOfSmoothingIterations: " << this->m_NumberOfSmoothingIterations << std::endl;
+  os << indent << "ProcessedRegion: " << this->m_ProcessedRegion << std::endl;
+  os << indent << "NumberOfAcceptedPixels: " << this->m_NumberOfAcceptedPixels << std::endl;
+  os << indent << "PathCost: " << this->m_PathCost << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
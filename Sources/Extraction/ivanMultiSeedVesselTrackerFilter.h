@@ -0,0 +1,391 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiSeedVesselTrackerFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks vessels from several seeds concurrently.
+// Date: 2012/11/05
+
+#ifndef __ivanMultiSeedVesselTrackerFilter_h
+#define __ivanMultiSeedVesselTrackerFilter_h
+
+#include "ivanImageToVesselDataObjectFilter.h"
+#include "ivanVesselTrackerFilter.h"
+#include "ivanVesselTrackerFactory.h"
+#include "ivanVesselTrackingMemo.h"
+#include "ivanVesselNode.h"
+#include "ivanVesselBifurcationNode.h"
+
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class MultiSeedVesselTrackerFilter
+ * \brief Tracks vessels from several independent seeds concurrently.
+ *
+ * This filter tracks one branch from each seed point, running the trackers of different seeds
+ * concurrently. Threads dynamically take the next seed not yet tracked, so that seeds whose
+ * branches are long do not hold the rest. The tracker of each seed is created by a 
+ * VesselTrackerFactory before tracking starts, and owns its section estimator, end condition and
+ * vesselness functions, so no state is shared between threads except the input image. 
+ * Trackers are run with VesselTrackerFilter::Track(), which does not update the pipeline.
+ *
+ * The output is a single VesselGraph whose root is a VesselNode with id 0, with one child 
+ * VesselBranchNode per seed, in seed order and with id equal to the seed index plus one. The 
+ * output does not depend on the number of threads or on the order in which seeds are tracked. 
+ *
+ * If RecursiveTracking is on, branch detection is enabled in the trackers (see 
+ * VesselTrackerFilter::SetDetectBranches()) and the branch candidates found while tracking are 
+ * tracked in turn, as new seeds, up to MaximumBranchDepth levels and MaximumNumberOfBranches 
+ * detected branches in total. Tracking proceeds by generations: all the branches of one depth 
+ * are tracked concurrently, and the candidates they found, in parent and detection order, form 
+ * the next generation. Candidates closer than the tracker MinimumBranchSeparation to an already
+ * tracked seed are discarded. Each detected branch hangs from a VesselBifurcationNode which is 
+ * a child of its parent branch. Detected seeds are numbered after the given ones, and seed k 
+ * gets ids NumberOfSeeds+2(k-NumberOfSeeds)+1 for its bifurcation and the next for its branch, 
+ * so the tree is also independent of the number of threads. The factory is asked for trackers
+ * with these seed indices. Trackers that do not implement branch detection just produce no
+ * candidates.
+ *
+ * With NumberOfInterleavedTrackers larger than one, each thread advances several trackers at 
+ * once, one step of each in turn (see VesselTrackerFilter::TrackStep()). After every step the 
+ * tracker prefetches the image around its next point (see VesselTrackerFilter::PrefetchNextStep()),
+ * so that its memory is loaded while the other trackers step. This hides the memory latency 
+ * when the image is much larger than the cache and there are many more seeds than threads, 
+ * provided the factory gives the trackers a PrefetchRadius. The output does not change.
+ *
+ * If ReuseUnchangedBranches is on, a VesselTrackingMemo is kept with each branch of the output,
+ * with the seed, the parameter keys given by the factory (see 
+ * VesselTrackerFactory::GetSectionParametersKey()) and a hash of the input around the branch.
+ * When the filter is updated again, a seed with the same starting point, direction, section 
+ * parameters and input hash as a branch of the previous output reuses its centerline and branch
+ * candidates if the end condition key is also the same. If only the end condition changed, 
+ * the tracking is resumed from the previous sections instead (see 
+ * VesselTrackerFilter::ResumeTracking()), so that the branch is truncated where the new end 
+ * condition is met, or tracked further from the last section. Only the seeds whose parameters 
+ * or input changed, or those detected from them, are tracked anew. The input is hashed in the 
+ * bounding box of the section centers padded by ImageHashRadius, which must cover the 
+ * neighborhoods read by the trackers, or as a whole if ImageHashRadius is zero.
+ *
+ * With a TrackingRegionRadius, only the bounding box of the regions around the given seeds is
+ * requested from the pipeline (see VesselTrackerFilter::SetTrackingRegionRadius()), and it is
+ * grown, updating the input again, before each generation whose seeds are not buffered. The 
+ * radius and margin are given to the trackers, which run directly on the buffered input and 
+ * stop at its boundary, so the radius must cover the expected length of the branches.
+ *
+ * If tracking from some seed throws an exception, the rest of the seeds are tracked anyway
+ * and an exception with the error of the first failed seed is thrown after merging.
+ *
+ * \sa VesselTrackerFilter
+ * \sa VesselTrackerFactory
+ */
+
+template <class TInputImage, class TOutputVessel>
+class ITK_EXPORT MultiSeedVesselTrackerFilter : 
+  public ImageToVesselDataObjectFilter<TInputImage,TOutputVessel>
+{
+public:
+	
+  /** Standard class typedefs. */
+  typedef MultiSeedVesselTrackerFilter
+    <TInputImage, TOutputVessel>          Self;
+  typedef ImageToVesselDataObjectFilter
+    <TInputImage,TOutputVessel>           Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Image-related typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::Pointer        InputImagePointer;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::PointType      InputImagePointType;
+  	
+  /** Vessel-related typedefs. */
+  typedef TOutputVessel                              OutputVesselType;
+  typedef typename OutputVesselType::Pointer         OutputVesselPointer;
+  typedef typename OutputVesselType::CenterlineType  CenterlineType;
+    
+  typedef VesselBranchNode<CenterlineType>           BranchNodeType;
+  typedef typename BranchNodeType::Pointer           BranchNodePointer;
+  typedef VesselBifurcationNode<CenterlineType>      BifurcationNodeType;
+  typedef typename BifurcationNodeType::Pointer      BifurcationNodePointer;
+  
+  /** Tracker-related typedefs. */
+  typedef VesselTrackerFilter
+    <TInputImage,TOutputVessel>                      TrackerType;
+  typedef typename TrackerType::Pointer              TrackerPointer;
+  typedef VesselTrackerFactory
+    <TInputImage,TOutputVessel>                      TrackerFactoryType;
+  typedef typename TrackerFactoryType::Pointer       TrackerFactoryPointer;
+  typedef typename TrackerType::DirectionType        DirectionType;
+  typedef typename TrackerType::BranchCandidateContainerType  
+                                                     BranchCandidateContainerType;
+  
+  typedef std::vector<InputImagePointType>           SeedContainerType;
+  
+  /** Memo-related typedefs. */
+  typedef VesselTrackingMemo
+    <TInputImage,TOutputVessel>                      TrackingMemoType;
+  typedef typename TrackingMemoType::Pointer         TrackingMemoPointer;
+  typedef typename TrackingMemoType::HashType        HashType;
+  typedef typename InputImageType::RegionType        InputImageRegionType;
+    
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  
+public:
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiSeedVesselTrackerFilter, ImageToVesselDataObjectFilter );
+  
+  /** Set/Get the factory that creates the tracker of each seed. */
+  itkSetObjectMacro( TrackerFactory, TrackerFactoryType );
+  itkGetObjectMacro( TrackerFactory, TrackerFactoryType );
+  
+  /** Add a seed point, in physical coordinates. */
+  void AddSeed( const InputImagePointType & seed );
+  
+  /** Set/Get all the seed points. */
+  void SetSeeds( const SeedContainerType & seeds );
+  const SeedContainerType & GetSeeds() const
+    { return m_Seeds; }
+  
+  /** Remove all the seed points. */
+  void ClearSeeds();
+  
+  unsigned int GetNumberOfSeeds() const
+    { return m_Seeds.size(); }
+  
+  /** Get the branch tracked from the given seed, after the filter has been updated. */
+  BranchNodeType * GetSeedBranch( unsigned int seed );
+  
+  /** Flag for tracking the branches detected from the seeds recursively. Default is false. */
+  itkSetMacro( RecursiveTracking, bool );
+  itkGetConstMacro( RecursiveTracking, bool );
+  itkBooleanMacro( RecursiveTracking );
+  
+  /** Set/Get the maximum depth of detected branches, where the branches of the given seeds 
+    * have depth 0. Default is 3. */
+  itkSetMacro( MaximumBranchDepth, unsigned int );
+  itkGetConstMacro( MaximumBranchDepth, unsigned int );
+  
+  /** Set/Get the maximum number of detected branches tracked. Default is 100. */
+  itkSetMacro( MaximumNumberOfBranches, unsigned int );
+  itkGetConstMacro( MaximumNumberOfBranches, unsigned int );
+  
+  /** Set/Get the number of trackers advanced step by step at once by each thread. Default is 1,
+    * where each thread tracks one seed at a time. */
+  itkSetClampMacro( NumberOfInterleavedTrackers, unsigned int, 1, 
+    itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfInterleavedTrackers, unsigned int );
+  
+  /** Get the number of branches detected and tracked in the last update. */
+  unsigned int GetNumberOfDetectedBranches() const
+    { return m_TrackedSeeds.size() - m_Seeds.size(); }
+  
+  /** Flag for keeping a memo with each tracked branch and reusing the branches of the previous
+    * output whose seed, parameters and input did not change. Default is false. */
+  itkSetMacro( ReuseUnchangedBranches, bool );
+  itkGetConstMacro( ReuseUnchangedBranches, bool );
+  itkBooleanMacro( ReuseUnchangedBranches );
+  
+  /** Set/Get the distance, in physical units, around the section centers of a branch in which
+    * the input is hashed. If zero, the whole input is hashed, so any change of the input tracks
+    * all the branches again. Default is 0.0. */
+  itkSetMacro( ImageHashRadius, double );
+  itkGetConstMacro( ImageHashRadius, double );
+  
+  /** Set/Get the distance, in physical units, around each seed of the requested input region.
+    * If zero, the whole input is requested. Default is 0.0. */
+  itkSetMacro( TrackingRegionRadius, double );
+  itkGetConstMacro( TrackingRegionRadius, double );
+  
+  /** Set/Get the padding, in physical units, of the requested input region for the support of
+    * the image functions of the trackers. Default is 0.0. */
+  itkSetMacro( TrackingRegionMargin, double );
+  itkGetConstMacro( TrackingRegionMargin, double );
+  
+  /** Get the number of times the requested input region was grown, and the number of branches
+    * that stopped at the boundary of the buffered region, in the last update. */
+  itkGetConstMacro( NumberOfRegionGrowths, unsigned int );
+  itkGetConstMacro( NumberOfBoundaryBranches, unsigned int );
+  
+  /** Get the number of branches reused unchanged, and of branches whose tracking was resumed,
+    * in the last update. */
+  itkGetConstMacro( NumberOfReusedBranches, unsigned int );
+  itkGetConstMacro( NumberOfResumedBranches, unsigned int );
+  
+protected:
+  
+  MultiSeedVesselTrackerFilter();
+  ~MultiSeedVesselTrackerFilter() {}
+  
+  virtual void GenerateData();
+  
+  /** Request the bounding box of the regions around the seeds if TrackingRegionRadius is set, 
+    * or the whole input otherwise. */
+  virtual void GenerateInputRequestedRegion();
+  
+  /** Grow the requested region of the input to cover the seeds in [begin,end) and update the 
+    * input, if they are not buffered. Returns true if the region was grown. */
+  bool GrowTrackingRegion( unsigned int begin, unsigned int end );
+  
+  /** Track the seeds given by the dynamic seed queue until there are none left. */
+  virtual void ThreadedTrackSeeds( int threadId );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE TrackerThreaderCallback( void *arg );
+  
+  /** Track the seeds given by the dynamic seed queue, interleaving the steps of 
+    * NumberOfInterleavedTrackers trackers. */
+  void InterleavedTrackSeeds();
+  
+  /** Take the next step of the tracker of the given seed, initializing it first if requested, 
+    * and prefetch its next step. Returns false once it finishes or fails, recording the error. */
+  bool StepSeedTracker( unsigned int seed, bool initialize );
+  
+  /** Get the next seed not yet given to any thread. Returns false if there are none left. */
+  bool GetNextSeed( unsigned int & seed );
+  
+  /** Create the trackers of the seeds in [begin,end) and track them concurrently. */
+  void TrackGeneration( unsigned int begin, unsigned int end );
+  
+  /** Append the branch candidates of the given tracked seed as new seeds. */
+  void QueueBranchCandidates( unsigned int seed );
+  
+  /** Initialize the tracker of the given seed to resume the tracking of its previous branch. */
+  void ResumeSeedTracker( unsigned int seed );
+  
+  /** Add the branches with a tracking memo found under the given node to the previous 
+    * branches. */
+  void CollectPreviousBranches( const GraphNode *node );
+  
+  /** Look for a previous branch tracked from the given seed with the same parameters and input, 
+    * and decide whether to reuse it, resume it or track the seed again. */
+  void FindPreviousBranch( unsigned int seed );
+  
+  /** Create the memo of the branch just tracked from the given seed. */
+  TrackingMemoPointer CreateTrackingMemo( unsigned int seed );
+  
+  /** Get the input region hashed for the given centerline. */
+  InputImageRegionType ComputeImageHashRegion( const CenterlineType *centerline ) const;
+  
+  /** Compute the hash of the input geometry and pixels in the given region. */
+  HashType ComputeImageHash( const InputImageRegionType & region );
+  
+  /** Accumulate the given bytes in a 64-bit FNV-1a hash. */
+  static HashType HashBytes( HashType hash, const void *data, size_t size );
+  
+  /** What is done with each seed when reusing the previous branches. */
+  enum SeedReuseType
+  {
+    TrackSeedBranch = 0,
+    ReuseSeedBranch,
+    ResumeSeedBranch
+  };
+  
+  /** Information about every seed tracked, given or detected. */
+  struct TrackedSeed
+  {
+    InputImagePointType  Point;
+    DirectionType        Direction;
+    int                  Parent;
+    unsigned int         Depth;
+  };
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  MultiSeedVesselTrackerFilter(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+
+  TrackerFactoryPointer         m_TrackerFactory;
+  
+  SeedContainerType             m_Seeds;
+  
+  bool                          m_RecursiveTracking;
+  unsigned int                  m_MaximumBranchDepth;
+  unsigned int                  m_MaximumNumberOfBranches;
+  
+  unsigned int                  m_NumberOfInterleavedTrackers;
+  
+  bool                          m_ReuseUnchangedBranches;
+  double                        m_ImageHashRadius;
+  unsigned int                  m_NumberOfReusedBranches;
+  unsigned int                  m_NumberOfResumedBranches;
+  
+  double                        m_TrackingRegionRadius;
+  double                        m_TrackingRegionMargin;
+  unsigned int                  m_NumberOfRegionGrowths;
+  unsigned int                  m_NumberOfBoundaryBranches;
+  
+  /** Branches of the previous output with a tracking memo, only kept during GenerateData(). */
+  std::vector<BranchNodePointer>  m_PreviousBranches;
+  
+  /** Previous branch reused or resumed by each seed, and what is done with it. */
+  std::vector<BranchNodePointer>  m_SeedPreviousBranches;
+  std::vector<SeedReuseType>      m_SeedReuse;
+  
+  /** Hash of the whole input, computed once per update when ImageHashRadius is zero. */
+  HashType                      m_InputHash;
+  bool                          m_InputHashValid;
+  
+  /** Given seeds followed by the detected ones, in tracking order. */
+  std::vector<TrackedSeed>      m_TrackedSeeds;
+  
+  /** Trackers for each seed, only kept during GenerateData(). */
+  std::vector<TrackerPointer>   m_Trackers;
+  
+  /** Branches tracked from each seed, only kept during GenerateData(). */
+  std::vector<BranchNodePointer>  m_Branches;
+  
+  /** Error descriptions for the seeds whose tracking failed (empty if succeeded). */
+  std::vector<std::string>      m_TrackingErrors;
+  
+  /** Dynamic seed queue, for the seeds in [m_NextSeed,m_EndSeed). */
+  unsigned int                  m_NextSeed;
+  unsigned int                  m_EndSeed;
+  itk::SimpleFastMutexLock      m_SeedMutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanMultiSeedVesselTrackerFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,949 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiSeedVesselTrackerFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: 
+// Date: 2012/11/05
+
+#ifndef __ivanMultiSeedVesselTrackerFilter_hxx
+#define __ivanMultiSeedVesselTrackerFilter_hxx
+
+#include "ivanMultiSeedVesselTrackerFilter.h"
+
+#include "itkImageLinearConstIteratorWithIndex.h"
+
+#include <vnl/vnl_math.h>
+
+#include <cmath>
+
+namespace ivan
+{
+  
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::MultiSeedVesselTrackerFilter() :
+  m_RecursiveTracking( false ),
+  m_MaximumBranchDepth( 3 ),
+  m_MaximumNumberOfBranches( 100 ),
+  m_NumberOfInterleavedTrackers( 1 ),
+  m_ReuseUnchangedBranches( false ),
+  m_ImageHashRadius( 0.0 ),
+  m_NumberOfReusedBranches( 0 ),
+  m_NumberOfResumedBranches( 0 ),
+  m_TrackingRegionRadius( 0.0 ),
+  m_TrackingRegionMargin( 0.0 ),
+  m_NumberOfRegionGrowths( 0 ),
+  m_NumberOfBoundaryBranches( 0 ),
+  m_InputHash( 0 ),
+  m_InputHashValid( false ),
+  m_NextSeed(0),
+  m_EndSeed(0)
+{
+  
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::AddSeed( const InputImagePointType & seed )
+{ 
+  this->m_Seeds.push_back( seed );
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::SetSeeds( const SeedContainerType & seeds )
+{ 
+  this->m_Seeds = seeds;
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::ClearSeeds()
+{ 
+  if( this->m_Seeds.empty() )
+    return;
+  
+  this->m_Seeds.clear();
+  this->Modified();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>::BranchNodeType *
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::GetSeedBranch( unsigned int seed )
+{
+  OutputVesselType *vesselGraph = this->GetOutput();
+  
+  if( !vesselGraph || vesselGraph->GetRootNode().IsNull() )
+    return 0;
+  
+  return dynamic_cast<BranchNodeType*>( vesselGraph->GetRootNode()->GetChildById( seed + 1 ) );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::GenerateData()
+{
+  if( this->m_TrackerFactory.IsNull() )
+    itkExceptionMacro( "A tracker factory must be set." );
+  
+  const unsigned int numberOfSeeds = this->m_Seeds.size();
+  
+  OutputVesselPointer outputGraph = this->GetOutput(0);
+  
+  // Keep the branches of the previous output before replacing it
+  this->m_PreviousBranches.clear();
+  this->m_NumberOfReusedBranches = 0;
+  this->m_NumberOfResumedBranches = 0;
+  this->m_NumberOfRegionGrowths = 0;
+  this->m_NumberOfBoundaryBranches = 0;
+  this->m_InputHashValid = false;
+  
+  if( this->m_ReuseUnchangedBranches && outputGraph->GetRootNode().IsNotNull() )
+    this->CollectPreviousBranches( outputGraph->GetRootNode() );
+  
+  // The root groups the branches of all the seeds
+  VesselNode::Pointer rootNode = VesselNode::New();
+  rootNode->SetNodeId( 0 );
+  outputGraph->SetRootNode( rootNode );
+  
+  this->m_TrackedSeeds.clear();
+  
+  if( !numberOfSeeds )
+  {
+    this->m_PreviousBranches.clear();
+    itkWarningMacro( "No seeds given. Output graph has no branches." );
+    return;
+  }
+  
+  for( unsigned int i=0; i < numberOfSeeds; ++i )
+  {
+    TrackedSeed trackedSeed;
+    trackedSeed.Point = this->m_Seeds[i];
+    trackedSeed.Direction.Fill( 0.0 );
+    trackedSeed.Parent = -1;
+    trackedSeed.Depth = 0;
+    
+    this->m_TrackedSeeds.push_back( trackedSeed );
+  }
+  
+  this->m_Branches.clear();
+  this->m_TrackingErrors.clear();
+  
+  // Track by generations. Candidates are queued serially in seed order after each generation, 
+  // so the seeds of the next one do not depend on the thread scheduling
+  unsigned int begin = 0;
+  
+  while( begin < this->m_TrackedSeeds.size() )
+  {
+    const unsigned int end = this->m_TrackedSeeds.size();
+    
+    // The region of the given seeds was requested before the update
+    if( begin > 0 )
+      this->GrowTrackingRegion( begin, end );
+    
+    this->TrackGeneration( begin, end );
+    
+    if( this->m_RecursiveTracking )
+    {
+      for( unsigned int i = begin; i < end; ++i )
+        this->QueueBranchCandidates( i );
+    }
+    
+    this->m_Trackers.clear();
+    
+    begin = end;
+  }
+  
+  // Merge in seed order, so ids do not depend on the thread scheduling
+  int firstFailedSeed = -1;
+  
+  for( unsigned int i=0; i < this->m_TrackedSeeds.size(); ++i )
+  {
+    if( !this->m_TrackingErrors[i].empty() )
+    {
+      if( firstFailedSeed < 0 )
+        firstFailedSeed = i;
+      
+      continue;
+    }
+    
+    BranchNodeType *branch = this->m_Branches[i];
+    
+    if( !branch )
+      continue;
+    
+    if( i < numberOfSeeds )
+    {
+      branch->SetNodeId( i + 1 );
+      rootNode->AddChild( branch );
+    }
+    else
+    {
+      // Parents are always before their children, and were merged if they have children
+      const unsigned int nodeId = numberOfSeeds + 2 * ( i - numberOfSeeds ) + 1;
+      
+      BifurcationNodePointer bifurcation = BifurcationNodeType::New();
+      bifurcation->SetNodeId( nodeId );
+      this->m_Branches[ this->m_TrackedSeeds[i].Parent ]->AddChild( bifurcation );
+      
+      branch->SetNodeId( nodeId + 1 );
+      bifurcation->AddChild( branch );
+    }
+  }
+  
+  this->m_Branches.clear();
+  this->m_PreviousBranches.clear();
+  this->m_SeedPreviousBranches.clear();
+  this->m_SeedReuse.clear();
+  
+  itkDebugMacro( "Tracked " << rootNode->GetNumberOfChildren() << " of " << numberOfSeeds 
+    << " seeds and " << this->GetNumberOfDetectedBranches() << " detected branches, reusing " 
+    << this->m_NumberOfReusedBranches << " and resuming " << this->m_NumberOfResumedBranches );
+  
+  if( firstFailedSeed >= 0 )
+  {
+    itkExceptionMacro( "Tracking from seed " << firstFailedSeed << " failed: " 
+      << this->m_TrackingErrors[firstFailedSeed] );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  if( !this->GetInput() )
+    return;
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  
+  if( this->m_TrackingRegionRadius <= 0.0 || this->m_Seeds.empty() )
+  {
+    input->SetRequestedRegionToLargestPossibleRegion();
+    return;
+  }
+  
+  InputImageRegionType region = TrackerType::ComputeTrackingRegion( input, this->m_Seeds[0], 
+    this->m_TrackingRegionRadius + this->m_TrackingRegionMargin );
+  
+  for( unsigned int i=1; i < this->m_Seeds.size(); ++i )
+  {
+    region = TrackerType::MergeTrackingRegions( region, TrackerType::ComputeTrackingRegion( 
+      input, this->m_Seeds[i], this->m_TrackingRegionRadius + this->m_TrackingRegionMargin ) );
+  }
+  
+  // Seeds outside the image are left to the trackers
+  if( region.GetNumberOfPixels() )
+    input->SetRequestedRegion( region );
+  else
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::GrowTrackingRegion( unsigned int begin, unsigned int end )
+{
+  if( this->m_TrackingRegionRadius <= 0.0 )
+    return false;
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  
+  InputImageRegionType region = input->GetBufferedRegion();
+  
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    region = TrackerType::MergeTrackingRegions( region, TrackerType::ComputeTrackingRegion( input, 
+      this->m_TrackedSeeds[i].Point, this->m_TrackingRegionRadius + this->m_TrackingRegionMargin ) );
+  }
+  
+  if( region == input->GetBufferedRegion() )
+    return false;
+  
+  itkDebugMacro( "Growing the input region to " << region );
+  
+  const InputImageRegionType previousRegion = input->GetBufferedRegion();
+  
+  input->SetRequestedRegion( region );
+  input->PropagateRequestedRegion();
+  input->UpdateOutputData();
+  
+  if( input->GetBufferedRegion() == previousRegion )
+    return false;
+  
+  ++this->m_NumberOfRegionGrowths;
+  this->InvokeEvent( TrackingRegionGrownEvent() );
+  
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::TrackGeneration( unsigned int begin, unsigned int end )
+{
+  // Create the trackers serially, so that factories need not be thread-safe
+  this->m_Trackers.resize( end );
+  this->m_Branches.resize( end );
+  this->m_TrackingErrors.resize( end );
+  this->m_SeedPreviousBranches.resize( end );
+  this->m_SeedReuse.resize( end, TrackSeedBranch );
+  
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    const TrackedSeed & trackedSeed = this->m_TrackedSeeds[i];
+    
+    this->m_Trackers[i] = this->m_TrackerFactory->CreateTracker( i );
+    
+    if( this->m_Trackers[i].IsNull() )
+    {
+      this->m_Trackers.clear();
+      this->m_Branches.clear();
+      itkExceptionMacro( "Tracker factory returned no tracker for seed " << i << "." );
+    }
+    
+    this->m_Trackers[i]->SetInput( this->GetInput() );
+    this->m_Trackers[i]->SetStartingPoint( trackedSeed.Point );
+    this->m_Trackers[i]->SetTrackingRegionRadius( this->m_TrackingRegionRadius );
+    this->m_Trackers[i]->SetTrackingRegionMargin( this->m_TrackingRegionMargin );
+    
+    if( this->m_RecursiveTracking )
+      this->m_Trackers[i]->SetDetectBranches( trackedSeed.Depth < this->m_MaximumBranchDepth );
+    
+    if( trackedSeed.Parent >= 0 )
+      this->m_Trackers[i]->SetInitialDirection( trackedSeed.Direction );
+    
+    this->FindPreviousBranch( i );
+  }
+  
+  this->m_NextSeed = begin;
+  this->m_EndSeed = end;
+  
+  // Do not create more threads than seeds
+  unsigned int numberOfThreads = this->GetNumberOfThreads();
+  if( numberOfThreads > end - begin )
+    numberOfThreads = end - begin;
+  
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( this->TrackerThreaderCallback, this );
+  this->GetMultiThreader()->SingleMethodExecute();
+  
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    if( !this->m_TrackingErrors[i].empty() )
+      continue;
+    
+    if( this->m_SeedReuse[i] == ReuseSeedBranch )
+    {
+      // Share the centerline and the memo of the previous branch
+      const BranchNodeType *previousBranch = this->m_SeedPreviousBranches[i];
+      
+      this->m_Branches[i] = BranchNodeType::New();
+      this->m_Branches[i]->SetCenterline( 
+        const_cast<CenterlineType*>( previousBranch->GetCenterline().GetPointer() ) );
+      this->m_Branches[i]->SetTrackingMemo( previousBranch->GetTrackingMemo() );
+      
+      ++this->m_NumberOfReusedBranches;
+      continue;
+    }
+    
+    this->m_Branches[i] = dynamic_cast<BranchNodeType*>
+      ( this->m_Trackers[i]->GetOutput()->GetRootNode().GetPointer() );
+    
+    if( this->m_SeedReuse[i] == ResumeSeedBranch )
+      ++this->m_NumberOfResumedBranches;
+    
+    if( this->m_Trackers[i]->GetReachedRegionBoundary() )
+      ++this->m_NumberOfBoundaryBranches;
+    
+    // Interrupted branches are not complete, so they are not reused
+    if( this->m_ReuseUnchangedBranches && this->m_Branches[i].IsNotNull() && 
+        !this->m_Trackers[i]->GetInterrupted() )
+      this->m_Branches[i]->SetTrackingMemo( this->CreateTrackingMemo( i ) );
+  }
+  
+  itkDebugMacro( "Tracked seeds " << begin << " to " << end - 1 << " using " 
+    << numberOfThreads << " threads" );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::QueueBranchCandidates( unsigned int seed )
+{
+  if( this->m_Branches[seed].IsNull() )
+    return;
+  
+  // Reused branches were not tracked, so their candidates are taken from the memo
+  const TrackerType *tracker = this->m_Trackers[seed];
+  const TrackingMemoType *memo = 
+    dynamic_cast<const TrackingMemoType*>( this->m_Branches[seed]->GetTrackingMemo() );
+  
+  const BranchCandidateContainerType & candidates = 
+    memo ? memo->GetBranchCandidates() : tracker->GetBranchCandidates();
+  
+  const double minimumSquaredDistance = 
+    tracker->GetMinimumBranchSeparation() * tracker->GetMinimumBranchSeparation();
+  
+  for( unsigned int c=0; c < candidates.size(); ++c )
+  {
+    if( this->GetNumberOfDetectedBranches() >= this->m_MaximumNumberOfBranches )
+      return;
+    
+    // Discard branches already tracked, or detected again from another branch
+    bool tracked = false;
+    
+    for( unsigned int i=0; i < this->m_TrackedSeeds.size() && !tracked; ++i )
+    {
+      tracked = ( candidates[c].Point.SquaredEuclideanDistanceTo( this->m_TrackedSeeds[i].Point ) 
+        < minimumSquaredDistance );
+    }
+    
+    if( tracked )
+      continue;
+    
+    TrackedSeed trackedSeed;
+    trackedSeed.Point = candidates[c].Point;
+    trackedSeed.Direction = candidates[c].Direction;
+    trackedSeed.Parent = seed;
+    trackedSeed.Depth = this->m_TrackedSeeds[seed].Depth + 1;
+    
+    this->m_TrackedSeeds.push_back( trackedSeed );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::ResumeSeedTracker( unsigned int seed )
+{
+  const BranchNodeType *previousBranch = this->m_SeedPreviousBranches[seed];
+  const TrackingMemoType *memo = 
+    dynamic_cast<const TrackingMemoType*>( previousBranch->GetTrackingMemo() );
+  
+  this->m_Trackers[seed]->ResumeTracking( previousBranch->GetCenterline(), 
+    memo->GetBranchCandidates() );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::CollectPreviousBranches( const GraphNode *node )
+{
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+  
+  if( branch && dynamic_cast<const TrackingMemoType*>( branch->GetTrackingMemo() ) )
+    this->m_PreviousBranches.push_back( const_cast<BranchNodeType*>( branch ) );
+  
+  for( unsigned int i=0; i < node->GetNumberOfChildren(); ++i )
+    this->CollectPreviousBranches( node->GetChild(i) );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::FindPreviousBranch( unsigned int seed )
+{
+  this->m_SeedReuse[seed] = TrackSeedBranch;
+  this->m_SeedPreviousBranches[seed] = 0;
+  
+  if( !this->m_ReuseUnchangedBranches || this->m_PreviousBranches.empty() )
+    return;
+  
+  const TrackedSeed & trackedSeed = this->m_TrackedSeeds[seed];
+  const TrackerType *tracker = this->m_Trackers[seed];
+  
+  const std::string sectionKey = this->m_TrackerFactory->GetSectionParametersKey( seed );
+  const std::string endConditionKey = this->m_TrackerFactory->GetEndConditionParametersKey( seed );
+  
+  if( sectionKey.empty() )
+    return;
+  
+  const InputImageRegionType & bufferedRegion = this->GetInput()->GetBufferedRegion();
+  
+  for( unsigned int i=0; i < this->m_PreviousBranches.size(); ++i )
+  {
+    const TrackingMemoType *memo = 
+      dynamic_cast<const TrackingMemoType*>( this->m_PreviousBranches[i]->GetTrackingMemo() );
+    
+    if( !memo->Matches( trackedSeed.Point, trackedSeed.Direction, trackedSeed.Parent >= 0, 
+          tracker->GetDetectBranches(), sectionKey ) )
+      continue;
+    
+    // The hashed region must still be available, and be the whole input if so it was
+    const InputImageRegionType & region = memo->GetImageRegion();
+    
+    if( ( this->m_ImageHashRadius <= 0.0 ) ? ( region != bufferedRegion ) : 
+        !bufferedRegion.IsInside( region ) )
+      continue;
+    
+    if( this->ComputeImageHash( region ) != memo->GetImageHash() )
+      continue;
+    
+    // When only the end condition changed, the previous sections are replayed with the new one
+    if( !endConditionKey.empty() && endConditionKey == memo->GetEndConditionParametersKey() )
+      this->m_SeedReuse[seed] = ReuseSeedBranch;
+    else if( !tracker->GetBidirectional() )
+      this->m_SeedReuse[seed] = ResumeSeedBranch;
+    else
+      return;
+    
+    this->m_SeedPreviousBranches[seed] = this->m_PreviousBranches[i];
+    return;
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>::TrackingMemoPointer
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::CreateTrackingMemo( unsigned int seed )
+{
+  const TrackedSeed & trackedSeed = this->m_TrackedSeeds[seed];
+  const TrackerType *tracker = this->m_Trackers[seed];
+  
+  TrackingMemoPointer memo = TrackingMemoType::New();
+  memo->SetStartingPoint( trackedSeed.Point );
+  memo->SetInitialDirection( trackedSeed.Direction );
+  memo->SetUseInitialDirection( trackedSeed.Parent >= 0 );
+  memo->SetDetectBranches( tracker->GetDetectBranches() );
+  memo->SetSectionParametersKey( this->m_TrackerFactory->GetSectionParametersKey( seed ) );
+  memo->SetEndConditionParametersKey( this->m_TrackerFactory->GetEndConditionParametersKey( seed ) );
+  memo->SetBranchCandidates( tracker->GetBranchCandidates() );
+  
+  const InputImageRegionType region = 
+    this->ComputeImageHashRegion( this->m_Branches[seed]->GetCenterline() );
+  
+  memo->SetImageRegion( region );
+  memo->SetImageHash( this->ComputeImageHash( region ) );
+  
+  return memo;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>::InputImageRegionType
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::ComputeImageHashRegion( const CenterlineType *centerline ) const
+{
+  const InputImageType *input = this->GetInput();
+  
+  InputImageRegionType region = input->GetBufferedRegion();
+  
+  if( this->m_ImageHashRadius <= 0.0 || centerline->empty() )
+    return region;
+  
+  typedef itk::ContinuousIndex<double,InputImageDimension>  ContinuousIndexType;
+  
+  ContinuousIndexType minimumIndex, maximumIndex;
+  
+  for( unsigned int i=0; i < centerline->size(); ++i )
+  {
+    InputImagePointType center;
+    
+    for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+      center[dim] = centerline->at(i)->GetCenter()[dim];
+    
+    ContinuousIndexType index;
+    input->TransformPhysicalPointToContinuousIndex( center, index );
+    
+    for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+    {
+      if( i == 0 || index[dim] < minimumIndex[dim] )
+        minimumIndex[dim] = index[dim];
+      if( i == 0 || index[dim] > maximumIndex[dim] )
+        maximumIndex[dim] = index[dim];
+    }
+  }
+  
+  // Pad with the radius in pixels along the smallest spacing, which covers any orientation
+  double minimumSpacing = input->GetSpacing()[0];
+  
+  for( unsigned int dim=1; dim < InputImageDimension; ++dim )
+    minimumSpacing = vnl_math_min( minimumSpacing, (double)input->GetSpacing()[dim] );
+  
+  const double padding = this->m_ImageHashRadius / minimumSpacing;
+  
+  typename InputImageRegionType::IndexType  index;
+  typename InputImageRegionType::SizeType   size;
+  
+  for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+  {
+    index[dim] = (typename InputImageRegionType::IndexValueType)
+      std::floor( minimumIndex[dim] - padding );
+    size[dim] = (typename InputImageRegionType::SizeValueType)
+      ( std::ceil( maximumIndex[dim] + padding ) - index[dim] + 1 );
+  }
+  
+  InputImageRegionType branchRegion( index, size );
+  
+  // An empty region if the branch is outside the input, which only hashes the geometry
+  if( !branchRegion.Crop( region ) )
+  {
+    size.Fill( 0 );
+    branchRegion.SetSize( size );
+  }
+  
+  return branchRegion;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>::HashType
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::ComputeImageHash( const InputImageRegionType & region )
+{
+  const InputImageType *input = this->GetInput();
+  
+  const bool wholeInput = ( this->m_ImageHashRadius <= 0.0 );
+  
+  if( wholeInput && this->m_InputHashValid )
+    return this->m_InputHash;
+  
+  // 64-bit FNV-1a of the geometry and the pixels, by rows
+  HashType hash = 14695981039346656037ULL;
+  
+  typename InputImageType::PointType      origin = input->GetOrigin();
+  typename InputImageType::SpacingType    spacing = input->GetSpacing();
+  typename InputImageType::DirectionType  direction = input->GetDirection();
+  
+  hash = HashBytes( hash, region.GetIndex().GetIndex(), sizeof( region.GetIndex() ) );
+  hash = HashBytes( hash, region.GetSize().GetSize(), sizeof( region.GetSize() ) );
+  hash = HashBytes( hash, origin.GetDataPointer(), sizeof( origin ) );
+  hash = HashBytes( hash, spacing.GetDataPointer(), sizeof( spacing ) );
+  hash = HashBytes( hash, direction.GetVnlMatrix().data_block(), 
+    InputImageDimension * InputImageDimension * sizeof( direction(0,0) ) );
+  
+  if( region.GetNumberOfPixels() > 0 )
+  {
+    typedef itk::ImageLinearConstIteratorWithIndex<InputImageType>  IteratorType;
+    
+    IteratorType it( input, region );
+    it.SetDirection( 0 );
+    
+    const size_t rowBytes = region.GetSize(0) * sizeof( typename InputImageType::PixelType );
+    
+    for( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      hash = HashBytes( hash, &it.Value(), rowBytes );
+  }
+  
+  if( wholeInput )
+  {
+    this->m_InputHash = hash;
+    this->m_InputHashValid = true;
+  }
+  
+  return hash;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>::HashType
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::HashBytes( HashType hash, const void *data, size_t size )
+{
+  const unsigned char *bytes = static_cast<const unsigned char*>( data );
+  
+  for( size_t i=0; i < size; ++i )
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  
+  return hash;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::GetNextSeed( unsigned int & seed )
+{
+  this->m_SeedMutex.Lock();
+  
+  const bool found = this->m_NextSeed < this->m_EndSeed;
+  
+  if( found )
+    seed = this->m_NextSeed++;
+  
+  this->m_SeedMutex.Unlock();
+  
+  return found;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::ThreadedTrackSeeds( int itkNotUsed( threadId ) )
+{
+  if( this->m_NumberOfInterleavedTrackers > 1 )
+  {
+    this->InterleavedTrackSeeds();
+    return;
+  }
+  
+  unsigned int seed;
+  
+  while( this->GetNextSeed( seed ) )
+  {
+    // Exceptions cannot cross the thread boundary, so they are reported after merging
+    try
+    {
+      if( this->m_SeedReuse[seed] == TrackSeedBranch )
+      {
+        this->m_Trackers[seed]->Track();
+      }
+      else if( this->m_SeedReuse[seed] == ResumeSeedBranch )
+      {
+        this->ResumeSeedTracker( seed );
+        
+        while( this->m_Trackers[seed]->TrackStep() )
+          {}
+      }
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      this->m_TrackingErrors[seed] = excpt.GetDescription();
+    }
+    catch( std::exception & excpt )
+    {
+      this->m_TrackingErrors[seed] = excpt.what();
+    }
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::InterleavedTrackSeeds()
+{
+  std::vector<unsigned int> seeds;
+  seeds.reserve( this->m_NumberOfInterleavedTrackers );
+  
+  unsigned int seed;
+  
+  while( true )
+  {
+    // Replace the trackers that finished with new seeds
+    while( seeds.size() < this->m_NumberOfInterleavedTrackers && this->GetNextSeed( seed ) )
+    {
+      if( this->StepSeedTracker( seed, true ) )
+        seeds.push_back( seed );
+    }
+    
+    if( seeds.empty() )
+      break;
+    
+    // One step of every tracker, so that the memory prefetched by each one has arrived by the
+    // time it steps again
+    for( unsigned int i=0; i < seeds.size(); )
+    {
+      if( this->StepSeedTracker( seeds[i], false ) )
+      {
+        ++i;
+      }
+      else
+      {
+        seeds[i] = seeds.back();
+        seeds.pop_back();
+      }
+    }
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::StepSeedTracker( unsigned int seed, bool initialize )
+{
+  TrackerType *tracker = this->m_Trackers[seed];
+  
+  // Exceptions cannot cross the thread boundary, so they are reported after merging
+  try
+  {
+    if( initialize )
+    {
+      if( this->m_SeedReuse[seed] == ReuseSeedBranch )
+        return false;
+      else if( this->m_SeedReuse[seed] == ResumeSeedBranch )
+        this->ResumeSeedTracker( seed );
+      else
+        tracker->InitializeTracking();
+    }
+    
+    if( !tracker->TrackStep() )
+      return false;
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    this->m_TrackingErrors[seed] = excpt.GetDescription();
+    return false;
+  }
+  catch( std::exception & excpt )
+  {
+    this->m_TrackingErrors[seed] = excpt.what();
+    return false;
+  }
+  
+  tracker->PrefetchNextStep();
+  
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+ITK_THREAD_RETURN_TYPE
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::TrackerThreaderCallback( void *arg )
+{
+  int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  
+  Self *filter = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  filter->ThreadedTrackSeeds( threadId );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void 
+MultiSeedVesselTrackerFilter<TInputImage,TOutputVessel>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "TrackerFactory: " << this->m_TrackerFactory.GetPointer() << std::endl;
+  os << indent << "NumberOfSeeds: " << this->m_Seeds.size() << std::endl;
+  os << indent << "RecursiveTracking: " << this->m_RecursiveTracking << std::endl;
+  os << indent << "MaximumBranchDepth: " << this->m_MaximumBranchDepth << std::endl;
+  os << indent << "MaximumNumberOfBranches: " << this->m_MaximumNumberOfBranches << std::endl;
+  os << indent << "NumberOfInterleavedTrackers: " << this->m_NumberOfInterleavedTrackers << std::endl;
+  os << indent << "ReuseUnchangedBranches: " << this->m_ReuseUnchangedBranches << std::endl;
+  os << indent << "ImageHashRadius: " << this->m_ImageHashRadius << std::endl;
+  os << indent << "NumberOfReusedBranches: " << this->m_NumberOfReusedBranches << std::endl;
+  os << indent << "NumberOfResumedBranches: " << this->m_NumberOfResumedBranches << std::endl;
+  os << indent << "TrackingRegionRadius: " << this->m_TrackingRegionRadius << std::endl;
+  os << indent << "TrackingRegionMargin: " << this->m_TrackingRegionMargin << std::endl;
+  os << indent << "NumberOfRegionGrowths: " << this->m_NumberOfRegionGrowths << std::endl;
+  os << indent << "NumberOfBoundaryBranches: " << this->m_NumberOfBoundaryBranches << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
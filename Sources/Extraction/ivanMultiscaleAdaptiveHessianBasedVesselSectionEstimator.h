@@ -33,6 +33,7 @@ SUCH DAMAGE.
 
 #include "ivanMultiscaleHessianBasedVesselSectionEstimator.h"
 #include "ivanImageFunctionInitializerBase.h"
+#include "ivanScaleContinuityPredictor.h"
 
 
 namespace ivan
@@ -50,6 +51,21 @@ namespace ivan
  * an initializer object of type MetricFunctionInitializerBase or any user-defined subclass. This
  * avoids to initialize externally every operator for each scale
  *
+ * By default the search across scales starts at the scale of the previous section and climbs 
+ * towards the maximum. If UseScalePrediction is on, a ScaleContinuityPredictor tracks the scale 
+ * along the arclength of the centerline and the search starts at the predicted scale, so usually 
+ * only the predicted scale and its two neighbours are evaluated. If the maximum found is lower 
+ * than ResponseDropRatio times the one of the previous section, the search is widened to all 
+ * the scales, since the prediction may have led to a local maximum.
+ *
+ * If a prior centerline is set (see VesselSectionEstimator::SetPriorCenterline()), the search 
+ * starts instead at the scale of its closest section, and the prediction is not used. This 
+ * warm starts the tracking of a vessel already tracked in a similar image.
+ *
+ * If InterpolateSelectedScale is on, the scale of the maximum is refined with the metric values 
+ * of its two neighbour scales, which are usually already evaluated by the search. The Hessian 
+ * is then interpolated between the two closest scales, and the radius follows the refined scale.
+ *
  * /sa MetricFunctionInitializerBase
  * /sa ScaleSpaceMetricFunctionInitializer
  *
@@ -119,6 +135,22 @@ public:
   itkGetObjectMacro( MetricFunctionInitializer, MetricFunctionInitializerType );
   itkGetConstObjectMacro( MetricFunctionInitializer, MetricFunctionInitializerType );
   
+  /** Start the search across scales at the scale predicted along the centerline. Default is false. */
+  itkSetMacro( UseScalePrediction, bool );
+  itkGetConstMacro( UseScalePrediction, bool );
+  itkBooleanMacro( UseScalePrediction );
+  
+  /** Ratio of the response of the previous section below which all the scales are searched when 
+    * the scale prediction is used. Default is 0.5. */
+  itkSetClampMacro( ResponseDropRatio, double, 0.0, 1.0 );
+  itkGetConstMacro( ResponseDropRatio, double );
+  
+  /** Get the predictor used when UseScalePrediction is on, in order to set its parameters. */
+  itkGetObjectMacro( ScalePredictor, ScaleContinuityPredictor );
+  
+  /** Get the number of evaluations of the metric functions since the last call to Initialize(). */
+  itkGetConstMacro( NumberOfScaleEvaluations, unsigned long );
+  
   /** Initialize the Gaussian kernel. Call this method before evaluating the function.
     * This method MUST be called after any changes to function parameters. */
   virtual void Initialize();
@@ -132,6 +164,15 @@ protected:
     * estimated radius or from a source scales image for example. */
   virtual double GetScaleAt( unsigned int centerlineIdx, const PointType & point );
   
+  /** Get the value of the metric function at the given scale index. Values are stored during 
+    * a single call to GetScaleAt() so each scale is evaluated at most once. */
+  double GetMetricValue( unsigned int scaleIdx, const PointType & point );
+  
+  /** The scale search starts from the scale of the previous section and uses state shared 
+    * across sections, so sections must be computed serially. */
+  virtual bool SupportsThreadedCompute() const
+    { return false; }
+  
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -148,6 +189,20 @@ protected:
   /** Provide a means to initialize the metric function for each scale. This is called at 
     * initialization for the metrics of all scales. */
   MetricFunctionInitializerPointer   m_MetricFunctionInitializer;
+  
+  bool                               m_UseScalePrediction;
+  double                             m_ResponseDropRatio;
+  
+  ScaleContinuityPredictor::Pointer  m_ScalePredictor;
+  
+  /** Index of the last section whose scale updated the predictor and its metric value. */
+  unsigned int                       m_PredictedSectionIndex;
+  double                             m_PreviousResponse;
+  
+  unsigned long                      m_NumberOfScaleEvaluations;
+  
+  std::vector<double>                m_MetricValues;
+  std::vector<bool>                  m_EvaluatedMetricValues;
 };
 
 } // end namespace ivan
@@ -33,15 +33,22 @@ SUCH DAMAGE.
 #include "ivanMultiscaleAdaptiveHessianBasedVesselSectionEstimator.h"
 
 #include <algorithm>
+#include <cmath>
 
 namespace ivan
 {
 
 template <class TImage, class TMetricFunction, class TCenterline, class TMetricsCalculator>
 MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCenterline,TMetricsCalculator>
-::MultiscaleAdaptiveHessianBasedVesselSectionEstimator()
+::MultiscaleAdaptiveHessianBasedVesselSectionEstimator() :
+  m_UseScalePrediction( false ),
+  m_ResponseDropRatio( 0.5 ),
+  m_PredictedSectionIndex( 0 ),
+  m_PreviousResponse( 0.0 ),
+  m_NumberOfScaleEvaluations( 0 )
 {
   this->m_MetricFunctionInitializer = MetricFunctionInitializerType::New(); // provide at least default implementation
+  this->m_ScalePredictor = ScaleContinuityPredictor::New();
 }
 
 
@@ -67,7 +74,10 @@ MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCen
     metricFunction = MetricFunctionType::New();
     this->m_MetricFunctionInitializer->Initialize( metricFunction.GetPointer(), this->m_Image, this->m_Scales[i] );
     this->m_MetricFunctionContainer.push_back( metricFunction );   
-  }  
+  }
+  
+  this->m_ScalePredictor->Reset();
+  this->m_NumberOfScaleEvaluations = 0;
 }
 
 
@@ -78,52 +88,98 @@ MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCen
 {
   assert( this->m_Scales.size() );
   
-  SectionPointer currentSection = this->GetCenterline()->at( centerlineIdx );
+  if( this->m_MetricFunctionContainer.size() <= 1 )
+    return this->m_Scales[0];
+  
+  const unsigned int numberOfScales = this->m_MetricFunctionContainer.size();
+  
+  this->m_MetricValues.assign( numberOfScales, 0.0 );
+  this->m_EvaluatedMetricValues.assign( numberOfScales, false );
+  
   SectionPointer previousSection;
   
-  double currentScale;
-  int idx = 0;
+  unsigned int idx = 0;
+  bool predicted = false;
   
-  if( centerlineIdx > 0 )
+  // A prior centerline, such as the one of the previous phase, gives the starting scale
+  double priorScale = 0.0;
+  const bool usePriorScale = this->GetPriorScale( point, priorScale );
+  
+  if( usePriorScale )
+  {
+    if( priorScale > this->m_Scales[0] )
+    {
+      typename ScaleVectorType::iterator it = std::lower_bound
+        ( this->m_Scales.begin(), this->m_Scales.end(), priorScale );
+      
+      if( it == this->m_Scales.end() )
+        idx = numberOfScales - 1;
+      else
+      {
+        idx = (unsigned int)( it - this->m_Scales.begin() );
+        
+        if( idx > 0 && priorScale - this->m_Scales[idx-1] < this->m_Scales[idx] - priorScale )
+          --idx;
+      }
+    }
+  }
+  else if( centerlineIdx > 0 )
   {
     previousSection = this->GetCenterline()->at( centerlineIdx-1 );
-    currentScale = previousSection->GetScale();
+    double scale = previousSection->GetScale();
+    
+    if( this->m_UseScalePrediction )
+    {
+      // Restart the prediction if the previous scale was not obtained here, eg. taken from a cache
+      if( !this->m_ScalePredictor->GetInitialized() || this->m_PredictedSectionIndex + 1 != centerlineIdx )
+      {
+        this->m_ScalePredictor->Initialize( scale );
+        this->m_PreviousResponse = 0.0;
+      }
+      
+      double arcLength = 0.0;
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+        arcLength += ( point[dim] - previousSection->GetCenter()[dim] ) * ( point[dim] - previousSection->GetCenter()[dim] );
+      
+      scale = this->m_ScalePredictor->Predict( vcl_sqrt( arcLength ) );
+      predicted = true;
+    }
     
     // Get the closest scale from our group of scales
-    if( previousSection->GetScale() < this->m_Scales[0] )
-      currentScale = *( this->m_Scales.begin() );
-    else
+    if( scale > this->m_Scales[0] )
     {
-      double scale = previousSection->GetScale(); 
       // imacia: I dont know why but need to create the variable or VS2008 compiler complains on next line
       typename ScaleVectorType::iterator it = std::lower_bound
         ( this->m_Scales.begin(), this->m_Scales.end(), scale );
-      if( it == this->m_Scales.begin() )
-        currentScale = *( this->m_Scales.begin() );
+      
+      if( it == this->m_Scales.end() )
+        idx = numberOfScales - 1;
       else
-        currentScale = *( --it );
+      {
+        idx = (unsigned int)( it - this->m_Scales.begin() );
         
-      idx = (unsigned int)( it - this->m_Scales.begin() ); // CHECK THIS
-      assert( idx >= 0 && idx < this->m_Scales.size() );
+        // The previous scale is taken unless the predicted one is closer to the next one
+        if( idx > 0 && ( !predicted || scale - this->m_Scales[idx-1] < this->m_Scales[idx] - scale ) )
+          --idx;
+      }
     }
   }
-  else
-    currentScale = *( this->m_Scales.begin() ); // always take the smallest if possible since it is faster to calculate
+  // else always take the smallest if possible since it is faster to calculate
 
   double currentValue, nextValue, previousValue;
   bool maxFound = false;
 
-  if( this->m_MetricFunctionContainer.size() <= 1 )
-    return this->m_Scales[0];
-
-  currentValue = this->m_MetricFunctionContainer[idx]->Evaluate( point );
+  currentValue = this->GetMetricValue( idx, point );
 
-  nextValue = this->m_MetricFunctionContainer[idx+1]->Evaluate( point );
+  if( idx+1 < numberOfScales )
+    nextValue = this->GetMetricValue( idx+1, point );
+  else
+    nextValue = itk::NumericTraits<double>::NonpositiveMin();
 
   if( !idx )
     previousValue = itk::NumericTraits<double>::NonpositiveMin();
   else
-    previousValue = this->m_MetricFunctionContainer[idx-1]->Evaluate( point );
+    previousValue = this->GetMetricValue( idx-1, point );
   
   // WARNING: we are assuming that there is a single maximum accross scales!!!
 
@@ -140,7 +196,7 @@ MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCen
       --idx;
       
       if( idx > 0 )
-        previousValue = this->m_MetricFunctionContainer[idx-1]->Evaluate( point );
+        previousValue = this->GetMetricValue( idx-1, point );
       else
         previousValue = itk::NumericTraits<double>::NonpositiveMin();
     }
@@ -150,27 +206,76 @@ MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCen
       currentValue = nextValue; 
       ++idx;
 
-      if( idx+1 > this->m_Scales.size()-1 )
+      if( idx+1 > numberOfScales-1 )
         nextValue = itk::NumericTraits<double>::NonpositiveMin(); // set again a minimum value
       else
-        nextValue = this->m_MetricFunctionContainer[idx+1]->Evaluate( point );
+        nextValue = this->GetMetricValue( idx+1, point );
     }
     else if( currentValue >= previousValue && currentValue >= nextValue && currentValue == 0.0 )
     {
       // This might happen for example when all the values are 0.0, such as in out of bounds condition
       itkWarningMacro( "The medialness at the current position is zero." );
-      return this->m_Scales[idx];
+      maxFound = true;
     }
     else 
     {
       assert(0); // OOOOOPS
     }
-
-    if( idx == this->m_MetricFunctionContainer.size() )
-      return this->m_Scales[idx-1];
+  }
+  
+  if( this->m_UseScalePrediction && !usePriorScale )
+  {
+    // A drop in the response may be due to a wrong prediction, so look at all the scales
+    if( predicted && currentValue < this->m_ResponseDropRatio * this->m_PreviousResponse )
+    {
+      for( unsigned int i = 0; i < numberOfScales; ++i )
+      {
+        if( this->GetMetricValue( i, point ) > currentValue )
+        {
+          currentValue = this->m_MetricValues[i];
+          idx = i;
+        }
+      }
+    }
+  }
+  
+  // Refine the scale between the discrete scales with the responses of its neighbours
+  double selectedScale = this->m_Scales[idx];
+  
+  if( this->m_InterpolateSelectedScale && idx > 0 && idx + 1 < numberOfScales )
+    selectedScale = this->RefineScale( idx, this->GetMetricValue( idx-1, point ), currentValue, 
+      this->GetMetricValue( idx+1, point ) );
+  
+  if( this->m_UseScalePrediction && !usePriorScale )
+  {
+    if( centerlineIdx == 0 )
+      this->m_ScalePredictor->Initialize( selectedScale );
+    else
+      this->m_ScalePredictor->Update( selectedScale );
+    
+    this->m_PredictedSectionIndex = centerlineIdx;
+    this->m_PreviousResponse = currentValue;
   }
     
-  return this->m_Scales[idx];
+  return selectedScale;
+}
+
+
+template <class TImage, class TMetricFunction, class TCenterline, class TMetricsCalculator>
+double
+MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCenterline,TMetricsCalculator>
+::GetMetricValue( unsigned int scaleIdx, const PointType & point )
+{
+  assert( scaleIdx < this->m_MetricValues.size() );
+  
+  if( !this->m_EvaluatedMetricValues[scaleIdx] )
+  {
+    this->m_MetricValues[scaleIdx] = this->m_MetricFunctionContainer[scaleIdx]->Evaluate( point );
+    this->m_EvaluatedMetricValues[scaleIdx] = true;
+    ++this->m_NumberOfScaleEvaluations;
+  }
+  
+  return this->m_MetricValues[scaleIdx];
 }
 
 
@@ -181,6 +286,11 @@ MultiscaleAdaptiveHessianBasedVesselSectionEstimator<TImage,TMetricFunction,TCen
 {
   Superclass::PrintSelf( os, indent );
  
+  os << indent << "UseScalePrediction: " << this->m_UseScalePrediction << std::endl;
+  os << indent << "ResponseDropRatio: " << this->m_ResponseDropRatio << std::endl;
+  os << indent << "NumberOfScaleEvaluations: " << this->m_NumberOfScaleEvaluations << std::endl;
+  os << indent << "ScalePredictor: " << std::endl;
+  this->m_ScalePredictor->Print( os, indent.GetNextIndent() );
   os << indent << "MetricFunction: " << std::endl;
   for( unsigned int i=0; i<this->m_MetricFunctionContainer.size(); ++i )
   {
@@ -96,6 +96,9 @@ public:
   /** The use of the previous traits is preferred for the image function. */
   typedef ivan::DiscreteHessianGaussianImageFunction<ImageType>    HessianFunctionType;
   typedef typename HessianFunctionType::Pointer                   HessianFunctionPointer;
+  
+  typedef typename HessianFunctionType::BrickedImageType          BrickedImageType;
+  typedef typename BrickedImageType::Pointer                      BrickedImagePointer;
     
 public:
 
@@ -104,6 +107,17 @@ public:
 
   /** Run-time type information (and related methods). */
   itkTypeMacro( MultiscaleHessianBasedVesselSectionEstimator, MultiscaleTensorBasedVesselSectionEstimator );
+  
+  /** Set/Get the flag for gathering the neighborhoods of the Hessian functions from a bricked 
+    * copy of the image, shared by all the scales. The sections are estimated at scattered points
+    * along the centerline, and the bricked layout improves the cache behaviour of these accesses
+    * at the price of a copy of the image. Default is false. */
+  itkSetMacro( UseBrickedImage, bool );
+  itkGetConstMacro( UseBrickedImage, bool );
+  itkBooleanMacro( UseBrickedImage );
+  
+  /** Get the bricked copy of the image (null if not used). */
+  itkGetObjectMacro( BrickedImage, BrickedImageType );
       
 protected:
   
@@ -124,7 +138,11 @@ private:
 
 protected:
 
+  bool                      m_UseBrickedImage;
   
+  /** Bricked copy of the image, created by the first scaled function initialized. */
+  BrickedImagePointer       m_BrickedImage;
+  itk::SimpleFastMutexLock  m_BrickedImageMutex;
 };
 
 } // end namespace ivan
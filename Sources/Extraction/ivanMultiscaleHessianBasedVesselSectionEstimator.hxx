@@ -46,7 +46,8 @@ namespace ivan
 
 template <class TImage, class TCenterline, class TMetricsCalculator>
 MultiscaleHessianBasedVesselSectionEstimator<TImage,TCenterline,TMetricsCalculator>
-::MultiscaleHessianBasedVesselSectionEstimator()
+::MultiscaleHessianBasedVesselSectionEstimator() :
+  m_UseBrickedImage( false )
 {
   
 }
@@ -70,6 +71,36 @@ MultiscaleHessianBasedVesselSectionEstimator<TImage,TCenterline,TMetricsCalculat
   scaledImageFunction->SetInputImage( this->m_Image );
   scaledImageFunction->SetNormalizeAcrossScale( true );
   scaledImageFunction->SetUseImageSpacing( true );
+  
+  if( this->m_UseBrickedImage )
+  {
+    // Scaled functions may be initialized from several threads
+    this->m_BrickedImageMutex.Lock();
+    
+    try
+    {
+      if( this->m_BrickedImage.IsNull() )
+        this->m_BrickedImage = BrickedImageType::New();
+      
+      if( !this->m_BrickedImage->IsCopyOf( this->m_Image ) )
+        this->m_BrickedImage->CopyImage( this->m_Image );
+    }
+    catch( ... )
+    {
+      this->m_BrickedImageMutex.Unlock();
+      throw;
+    }
+    
+    this->m_BrickedImageMutex.Unlock();
+    
+    scaledImageFunction->SetBrickedImage( this->m_BrickedImage );
+  }
+  else
+  {
+    this->m_BrickedImage = 0;
+    scaledImageFunction->SetBrickedImage( 0 );
+  }
+  
   scaledImageFunction->Initialize();
 }
 
@@ -81,7 +112,8 @@ MultiscaleHessianBasedVesselSectionEstimator<TImage,TCenterline,TMetricsCalculat
 {
   Superclass::PrintSelf( os, indent );
   
-
+  os << indent << "UseBrickedImage: " << this->m_UseBrickedImage << std::endl;
+  os << indent << "BrickedImage: " << this->m_BrickedImage.GetPointer() << std::endl;
 }
 
 } // end namespace ivan
@@ -33,11 +33,17 @@ SUCH DAMAGE.
 
 #include "ivanMultiscaleVesselSectionEstimator.h"
 
+#include "itkEventObject.h"
+
+#include <vector>
 
 
 namespace ivan
 {
 
+/** Event invoked by MultiscaleTensorBasedVesselSectionEstimator after each section is computed. */
+itkEventMacro( SectionComputedEvent, itk::AnyEvent );
+
 /** \class MultiscaleTensorBasedVesselSectionEstimator
  *  \brief Abstract class estimating the vessel section using multiple scales of a tensor-based operator.
  *
@@ -59,6 +65,26 @@ namespace ivan
  * 
  * It is assumed that the section has a Normal such as the CircularVesselSection.
  *
+ * If UseSectionCache is on, the scale and the eigenvector of every computed section are kept. 
+ * In later calls to Compute(), sections whose object and center have not changed, and whose 
+ * previous section kept its scale, are not evaluated again, only the sign of their normal is 
+ * checked against the previous one. This way, when the tracker appends a section and the whole 
+ * centerline is requested, only the new section is evaluated. The cache is cleared when the 
+ * image or centerline are set, in Initialize() and with ClearSectionCache(). It is off by 
+ * default because subclasses whose scale search keeps state along the centerline, such as the 
+ * scale prediction of the adaptive estimators, restart that state after the cached sections, 
+ * so the new sections may get a different scale than when the whole centerline is computed.
+ *
+ * A SectionComputedEvent is invoked after each section. Observers can query 
+ * GetLastSectionTimings() for the index of the section, whether it was cached and, if 
+ * MeasureSectionTimings is on, the time in seconds spent in scale selection, tensor 
+ * interpolation and eigen-analysis.
+ *
+ * ComputeRange() and ComputeAll() distribute the sections among NumberOfThreads threads when 
+ * the scale of a section does not depend on the previous one. Every additional thread uses its 
+ * own copy of the scaled image functions. The signs of the normals are fixed and the 
+ * SectionComputedEvent are invoked afterwards in order, without timings.
+ *
  * \ingroup 
  */
 
@@ -89,6 +115,8 @@ public:
   typedef typename Superclass::PointType        PointType;
   
   typedef typename Superclass::ScaleVectorType  ScaleVectorType;
+  
+  typedef typename Superclass::RangeValueType   RangeValueType;
     
   typedef TScaledImageFunction                                    ScaledImageFunctionType;
   typedef typename ScaledImageFunctionType::Pointer               ScaledImageFunctionPointer;
@@ -96,6 +124,16 @@ public:
   typedef typename Superclass::ScaledImageFunctionContainerType   ScaledImageFunctionContainerType;
   
   typedef typename ScaledImageFunctionType::TensorType            StructureTensorType;
+  
+  /** Timings of the last computed section. */
+  struct SectionTimings
+  {
+    unsigned int  SectionIndex;
+    bool          Cached;
+    double        ScaleSelectionTime;
+    double        TensorInterpolationTime;
+    double        EigenAnalysisTime;
+  };
       
 public:
 
@@ -108,6 +146,32 @@ public:
   /** Default computation computes multi-scale eigenvalues and eigenvectors of the structure tensor and uses
     * them for the section calculation. */
   virtual void Compute();
+  
+  virtual void Initialize();
+  
+  virtual void SetImage( ImageType *image );
+  virtual void SetCenterline( CenterlineType * centerline );
+  
+  /** Flag for reusing the sections computed in previous calls to Compute(). Default is false. */
+  itkSetMacro( UseSectionCache, bool );
+  itkGetConstMacro( UseSectionCache, bool );
+  itkBooleanMacro( UseSectionCache );
+  
+  /** Remove all the cached sections, for example if the image has been modified in place. */
+  void ClearSectionCache()
+    { m_SectionCache.clear(); }
+  
+  /** Get the number of sections taken from the cache in the last call to Compute(). */
+  itkGetConstMacro( NumberOfCachedSections, unsigned int );
+  
+  /** Flag for measuring the time of each stage of the section computation. Default is false. */
+  itkSetMacro( MeasureSectionTimings, bool );
+  itkGetConstMacro( MeasureSectionTimings, bool );
+  itkBooleanMacro( MeasureSectionTimings );
+  
+  /** Get the timings of the last computed section, usually from a SectionComputedEvent observer. */
+  const SectionTimings & GetLastSectionTimings() const
+    { return m_LastSectionTimings; }
     
 protected:
   
@@ -118,8 +182,24 @@ protected:
     * estimated radius or from a source scales image for example. */
   virtual double GetScaleAt( unsigned int centerlineIdx, const PointType & point ) = 0;
   
-  /** Get interpolated structure tensor value at given scale. */
-  void GetInterpolatedTensor( const PointType & center, double scale, StructureTensorType & tensor );
+  /** Get interpolated structure tensor value at given scale, using the scaled functions of 
+    * the given thread. */
+  void GetInterpolatedTensor( const PointType & center, double scale, StructureTensorType & tensor, 
+    unsigned int threadId = 0 );
+  
+  /** Get the scaled function of the given scale index for the given thread. Thread 0 uses the 
+    * functions of the estimator and the rest the copies allocated in BeforeThreadedCompute(). */
+  ScaledImageFunctionType * GetThreadScaledImageFunction( unsigned int i, unsigned int threadId );
+  
+  /** Sections can be computed concurrently if GetScaleAt() does not depend on the previous 
+    * section. Subclasses where it does must return false. */
+  virtual bool SupportsThreadedCompute() const
+    { return true; }
+  
+  virtual void BeforeThreadedCompute( unsigned int numberOfThreads );
+  virtual void BeforeSpeculativeSection( RangeValueType section );
+  virtual void ThreadedComputeSection( unsigned int sectionIdx, unsigned int threadId );
+  virtual void AfterThreadedCompute( RangeValueType first, RangeValueType last );
     
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
@@ -130,6 +210,35 @@ private:
 
 protected:
 
+  /** Cached result of a section. */
+  struct SectionCacheEntry
+  {
+    SectionPointer                    Section;
+    PointType                         Center;
+    double                            Scale;
+    typename SectionType::VectorType  Normal;
+  };
+  
+  typedef std::vector<SectionCacheEntry>   SectionCacheType;
+  
+  bool                  m_UseSectionCache;
+  
+  /** Cached sections, by centerline index. */
+  SectionCacheType      m_SectionCache;
+  
+  unsigned int          m_NumberOfCachedSections;
+  
+  bool                  m_MeasureSectionTimings;
+  SectionTimings        m_LastSectionTimings;
+  
+  typedef std::vector<ScaledImageFunctionContainerType>   ThreadScaledImageFunctionContainerType;
+  
+  /** Copies of the scaled functions for threads other than the first one. */
+  ThreadScaledImageFunctionContainerType   m_ThreadScaledImageFunctionContainer;
+  
+  /** Whether each section was taken from the cache in the last threaded computation. It is 
+    * indexed by section, like the section cache, so that it does not depend on the range. */
+  std::vector<unsigned char>               m_ThreadedSectionCached;
 };
 
 } // end namespace ivan
@@ -31,6 +31,9 @@ SUCH DAMAGE.
 #define __ivanMultiscaleTensorBasedVesselSectionEstimator_hxx
 
 #include "ivanMultiscaleTensorBasedVesselSectionEstimator.h"
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkTimeProbe.h"
 
 #ifdef _DEBUG
   #include "itkLinearInterpolateImageFunction.h"
@@ -46,9 +49,16 @@ namespace ivan
 
 template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
 MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
-::MultiscaleTensorBasedVesselSectionEstimator()
+::MultiscaleTensorBasedVesselSectionEstimator() :
+  m_UseSectionCache( false ),
+  m_NumberOfCachedSections( 0 ),
+  m_MeasureSectionTimings( false )
 {
-  
+  m_LastSectionTimings.SectionIndex = 0;
+  m_LastSectionTimings.Cached = false;
+  m_LastSectionTimings.ScaleSelectionTime = 0.0;
+  m_LastSectionTimings.TensorInterpolationTime = 0.0;
+  m_LastSectionTimings.EigenAnalysisTime = 0.0;
 }
 
 
@@ -60,6 +70,44 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
 }
 
 
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::Initialize()
+{
+  Superclass::Initialize();
+  this->ClearSectionCache();
+  this->m_ThreadScaledImageFunctionContainer.clear();
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::SetImage( ImageType *image )
+{
+  if( this->m_Image.GetPointer() != image )
+  {
+    this->ClearSectionCache();
+    this->m_ThreadScaledImageFunctionContainer.clear();
+  }
+  
+  Superclass::SetImage( image );
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::SetCenterline( CenterlineType * centerline )
+{
+  if( this->GetCenterline() != centerline )
+    this->ClearSectionCache();
+  
+  Superclass::SetCenterline( centerline );
+}
+
+
 template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
 void
 MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
@@ -88,14 +136,28 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
   double dotProduct;
   double currentScale = 0.0;
   
+  // Whether the scale of the previous section changed in this call, since the scale of the 
+  // current one may depend on it
+  bool previousScaleChanged = false;
+  
+  this->m_NumberOfCachedSections = 0;
+  
+  if( this->m_SectionCache.size() < this->GetCenterline()->size() )
+    this->m_SectionCache.resize( this->GetCenterline()->size() );
+  
   // If the section range is not specified take all the sections
   if( this->m_SectionRange[0] == 0 && this->m_SectionRange[1] == 0 )
     this->m_SectionRange[1] = this->GetCenterline()->size() - 1;
   
   for( unsigned int i = this->m_SectionRange[0]; i <= this->m_SectionRange[1]; ++i )
   {
-    std::cout << "Calculating section " << i+1 << " out of " << 
-      ( this->m_SectionRange[1] - this->m_SectionRange[0] + 1 ) << " ... " << std::endl;
+    itkDebugMacro( "Calculating section " << i+1 << " out of " << 
+      ( this->m_SectionRange[1] - this->m_SectionRange[0] + 1 ) );
+    
+    this->m_LastSectionTimings.SectionIndex = i;
+    this->m_LastSectionTimings.ScaleSelectionTime = 0.0;
+    this->m_LastSectionTimings.TensorInterpolationTime = 0.0;
+    this->m_LastSectionTimings.EigenAnalysisTime = 0.0;
     
     currentSection = this->GetCenterline()->at(i);
     
@@ -109,21 +171,70 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
       std::cout << "CenterValue: out of bounds" << std::endl;
 #endif
 
-    // Get scale for hessian calculation and then calculate/interpolate hessian
-    currentScale = this->GetScaleAt( i, centerPoint );
-    this->GetInterpolatedTensor( centerPoint, currentScale, tensor );
+    SectionCacheEntry & cacheEntry = this->m_SectionCache[i];
+    
+    const bool cached = this->m_UseSectionCache && !previousScaleChanged && 
+      cacheEntry.Section == currentSection && cacheEntry.Center == centerPoint;
     
-    // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
-    tensor.ComputeEigenAnalysis( eigenValues, eigenVectors );
+    this->m_LastSectionTimings.Cached = cached;
+    
+    if( cached )
+    {
+      currentScale = cacheEntry.Scale;
+      sectionNormal = cacheEntry.Normal;
+      
+      ++this->m_NumberOfCachedSections;
+    }
+    else if( this->m_MeasureSectionTimings )
+    {
+      itk::TimeProbe scaleProbe, tensorProbe, eigenProbe;
+      
+      scaleProbe.Start();
+      currentScale = this->GetScaleAt( i, centerPoint );
+      scaleProbe.Stop();
+      
+      tensorProbe.Start();
+      this->GetInterpolatedTensor( centerPoint, currentScale, tensor );
+      tensorProbe.Stop();
+      
+      eigenProbe.Start();
+      SymmetricEigenSolver<StructureTensorType>::ComputeEigenAnalysis( tensor, eigenValues, eigenVectors );
+      eigenProbe.Stop();
+      
+      this->m_LastSectionTimings.ScaleSelectionTime = scaleProbe.GetMeanTime();
+      this->m_LastSectionTimings.TensorInterpolationTime = tensorProbe.GetMeanTime();
+      this->m_LastSectionTimings.EigenAnalysisTime = eigenProbe.GetMeanTime();
+    }
+    else
+    {
+      // Get scale for hessian calculation and then calculate/interpolate hessian
+      currentScale = this->GetScaleAt( i, centerPoint );
+      this->GetInterpolatedTensor( centerPoint, currentScale, tensor );
+      
+      // Calculate eigenvalues and eigenvectors of Hessian matrix at the current location
+      SymmetricEigenSolver<StructureTensorType>::ComputeEigenAnalysis( tensor, eigenValues, eigenVectors );
+    }
+    
+    if( !cached )
+    {
+      // WARNING: CHECK THAT THESE ARE THE TWO MOST NEGATIVE EIGENVALUED-EIGENVECTORS
+      // THE NORMAL CORRESPONDS TO THE THIRD (LARGEST POSITIVE EIGENVALUED-EIGENVECTOR)
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+        sectionNormal[dim] = eigenVectors( 2, dim ); // third eigenvector
+      
+      previousScaleChanged = ( cacheEntry.Section != currentSection || cacheEntry.Scale != currentScale );
+      
+      cacheEntry.Section = currentSection;
+      cacheEntry.Center = centerPoint;
+      cacheEntry.Scale = currentScale;
+      cacheEntry.Normal = sectionNormal;
+    }
     
     dotProduct = 0.0;
-        
-    // WARNING: CHECK THAT THESE ARE THE TWO MOST NEGATIVE EIGENVALUED-EIGENVECTORS
-    // THE NORMAL CORRESPONDS TO THE THIRD (LARGEST POSITIVE EIGENVALUED-EIGENVECTOR)
-    for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+    
+    if( i )
     {
-      sectionNormal[dim] = eigenVectors( 2, dim ); // third eigenvector
-      if( i )
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
         dotProduct += this->GetCenterline()->at(i-1)->GetNormal()[dim] * sectionNormal[dim];
     }
     
@@ -145,31 +256,195 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
 #endif 
 
     this->m_CurrentScale = currentScale;
+    
+    this->InvokeEvent( SectionComputedEvent() );
+  }
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::BeforeThreadedCompute( unsigned int numberOfThreads )
+{
+  assert( this->m_Image.IsNotNull() );
+  
+  if( this->GetCenterline() && !this->GetCenterline()->empty() )
+    this->BeforeSpeculativeSection( this->GetCenterline()->size() - 1 );
+  
+  // The copies are not taken from the ScaledImageFunctionCache since that would share them
+  if( this->m_ThreadScaledImageFunctionContainer.size() < numberOfThreads - 1 )
+  {
+    this->m_ThreadScaledImageFunctionContainer.resize( numberOfThreads - 1 );
+    
+    for( unsigned int t = 0; t < numberOfThreads - 1; ++t )
+    {
+      ScaledImageFunctionContainerType & container = this->m_ThreadScaledImageFunctionContainer[t];
+      
+      if( container.size() == this->m_Scales.size() )
+        continue;
+      
+      container.resize( this->m_Scales.size() );
+      
+      for( unsigned int i = 0; i < this->m_Scales.size(); ++i )
+      {
+        container[i] = ScaledImageFunctionType::New();
+        this->InitializeScaledFunction( container[i].GetPointer(), this->m_Scales[i] );
+      }
+    }
   }
 }
 
 
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::BeforeSpeculativeSection( RangeValueType section )
+{
+  // Every section up to the given one gets its own entry
+  if( this->m_SectionCache.size() <= section )
+    this->m_SectionCache.resize( section + 1 );
+  
+  if( this->m_ThreadedSectionCached.size() <= section )
+    this->m_ThreadedSectionCached.resize( section + 1, 0 );
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::ThreadedComputeSection( unsigned int sectionIdx, unsigned int threadId )
+{
+  typedef typename StructureTensorType::EigenVectorsMatrixType   EigenVectorsMatrixType;
+  typedef typename StructureTensorType::EigenValuesArrayType     EigenValuesArrayType;
+  
+  EigenVectorsMatrixType eigenVectors;
+  EigenValuesArrayType   eigenValues;
+  StructureTensorType    tensor;
+  
+  SectionPointer currentSection = this->GetCenterline()->at( sectionIdx );
+  PointType centerPoint;
+  
+  for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+    centerPoint[dim] = currentSection->GetCenter()[dim];
+  
+  // Each section has its own entry, which was allocated in BeforeThreadedCompute()
+  SectionCacheEntry & cacheEntry = this->m_SectionCache[sectionIdx];
+  
+  // The scale does not depend on the previous section here, so the entry is valid by itself
+  // Set for every section computed, so that it does not need to be reset for every range
+  const bool cached = this->m_UseSectionCache && cacheEntry.Section == currentSection && 
+    cacheEntry.Center == centerPoint;
+  
+  this->m_ThreadedSectionCached[sectionIdx] = cached;
+  
+  if( !cached )
+  {
+    const double scale = this->GetScaleAt( sectionIdx, centerPoint );
+    this->GetInterpolatedTensor( centerPoint, scale, tensor, threadId );
+    
+    SymmetricEigenSolver<StructureTensorType>::ComputeEigenAnalysis( tensor, eigenValues, eigenVectors );
+    
+    cacheEntry.Section = currentSection;
+    cacheEntry.Center = centerPoint;
+    cacheEntry.Scale = scale;
+    
+    for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+      cacheEntry.Normal[dim] = eigenVectors( 2, dim ); // third eigenvector
+  }
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
+::AfterThreadedCompute( RangeValueType first, RangeValueType last )
+{
+  typename SectionType::VectorType sectionNormal;
+  double dotProduct;
+  
+  this->m_NumberOfCachedSections = 0;
+  
+  for( unsigned int i = first; i <= last; ++i )
+  {
+    SectionPointer currentSection = this->GetCenterline()->at(i);
+    const SectionCacheEntry & cacheEntry = this->m_SectionCache[i];
+    
+    sectionNormal = cacheEntry.Normal;
+    
+    dotProduct = 0.0;
+    
+    if( i )
+    {
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+        dotProduct += this->GetCenterline()->at(i-1)->GetNormal()[dim] * sectionNormal[dim];
+    }
+    
+    // If this is not the first normal, avoid changing sign in direction from the previous normal
+    if( dotProduct < 0.0 )
+    {
+      for( unsigned int dim = 0; dim < ImageType::GetImageDimension(); ++dim )
+        sectionNormal[dim] = -sectionNormal[dim]; 
+    }
+    
+    currentSection->SetNormal( sectionNormal );
+    currentSection->SetScale( cacheEntry.Scale );
+    currentSection->SetRadius( cacheEntry.Scale * 1.732 ); // might be an approximation (Krissian)
+    
+    this->m_CurrentScale = cacheEntry.Scale;
+    
+    const bool cached = this->m_ThreadedSectionCached[i] != 0;
+    
+    if( cached )
+      ++this->m_NumberOfCachedSections;
+    
+    this->m_LastSectionTimings.SectionIndex = i;
+    this->m_LastSectionTimings.Cached = cached;
+    this->m_LastSectionTimings.ScaleSelectionTime = 0.0;
+    this->m_LastSectionTimings.TensorInterpolationTime = 0.0;
+    this->m_LastSectionTimings.EigenAnalysisTime = 0.0;
+    
+    this->InvokeEvent( SectionComputedEvent() );
+  }
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+typename MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>::ScaledImageFunctionType *
+MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
+::GetThreadScaledImageFunction( unsigned int i, unsigned int threadId )
+{
+  if( !threadId )
+    return this->GetScaledImageFunction( i );
+  
+  assert( threadId-1 < this->m_ThreadScaledImageFunctionContainer.size() );
+  
+  return this->m_ThreadScaledImageFunctionContainer[threadId-1][i];
+}
+
+
 template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
 void 
 MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetricsCalculator>
-::GetInterpolatedTensor( const PointType & center, double scale, StructureTensorType & tensor )
+::GetInterpolatedTensor( const PointType & center, double scale, StructureTensorType & tensor, 
+  unsigned int threadId )
 {
   assert( this->m_ScaledImageFunctionContainer.size() && this->m_Scales.size() == this->m_ScaledImageFunctionContainer.size() );
   
   if( this->m_ScaledImageFunctionContainer.size() == 1 )
   {
     // We cannot interpolate
-    tensor = this->m_ScaledImageFunctionContainer[0]->Evaluate( center );
+    tensor = this->GetThreadScaledImageFunction( 0, threadId )->Evaluate( center );
     return;
   }
   else if( scale <= this->m_Scales[0] )
   {
-    tensor = this->m_ScaledImageFunctionContainer[0]->Evaluate( center );
+    tensor = this->GetThreadScaledImageFunction( 0, threadId )->Evaluate( center );
     return;
   }
   else if( scale >= this->m_Scales[ this->m_ScaledImageFunctionContainer.size()-1 ] )
   {
-    tensor = this->m_ScaledImageFunctionContainer[ this->m_ScaledImageFunctionContainer.size()-1 ]->Evaluate( center );
+    tensor = this->GetThreadScaledImageFunction( this->m_ScaledImageFunctionContainer.size()-1, threadId )->Evaluate( center );
     return;
   }
   else
@@ -183,12 +458,12 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
     
     if( vnl_math_abs( scale - this->m_Scales[idx] ) <= SCALE_TOLERANCE )
     {
-      tensor = this->m_ScaledImageFunctionContainer[idx]->Evaluate( center );
+      tensor = this->GetThreadScaledImageFunction( idx, threadId )->Evaluate( center );
       return;
     }
     else if( vnl_math_abs( scale - this->m_Scales[idx+1] ) <= SCALE_TOLERANCE )
     {
-      tensor = this->m_ScaledImageFunctionContainer[idx+1]->Evaluate( center );
+      tensor = this->GetThreadScaledImageFunction( idx+1, threadId )->Evaluate( center );
       return;     
     }
     
@@ -197,8 +472,8 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
     // interpolation is linear, even if the values are generated logarithmically, because the values
     // themselves are not logarithms
         
-    StructureTensorType lowerTensor = this->m_ScaledImageFunctionContainer[idx]->Evaluate( center );
-    StructureTensorType upperTensor = this->m_ScaledImageFunctionContainer[idx+1]->Evaluate( center );
+    StructureTensorType lowerTensor = this->GetThreadScaledImageFunction( idx, threadId )->Evaluate( center );
+    StructureTensorType upperTensor = this->GetThreadScaledImageFunction( idx+1, threadId )->Evaluate( center );
     
     double linearFactor = ( scale - this->m_Scales[idx] ) / ( this->m_Scales[idx+1] - this->m_Scales[idx] );
     
@@ -215,7 +490,9 @@ MultiscaleTensorBasedVesselSectionEstimator<TImage,TScaledImageFunction,TCenterl
 {
   Superclass::PrintSelf( os, indent );
   
- 
+  os << indent << "UseSectionCache: " << this->m_UseSectionCache << std::endl;
+  os << indent << "NumberOfCachedSections: " << this->m_NumberOfCachedSections << std::endl;
+  os << indent << "MeasureSectionTimings: " << this->m_MeasureSectionTimings << std::endl;
 }
 
 } // end namespace ivan
@@ -34,6 +34,15 @@ SUCH DAMAGE.
 
 #include "ivanImageBasedVesselSectionEstimator.h"
 #include "ivanDiscreteHessianGaussianImageFunction.h"
+#include "ivanScaledImageFunctionCache.h"
+#include "ivanTaskPool.h"
+#include "ivanScaleInterpolation.h"
+
+#include "itkSimpleFastMutexLock.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+#include <string>
 
 
 namespace ivan
@@ -52,6 +61,14 @@ namespace ivan
  * 
  * It is assumed that the section has a Normal such as the CircularVesselSection.
  *
+ * If LazyInitialization is on, the scaled function of each scale is only created and initialized
+ * the first time it is requested through GetScaledImageFunction(). The initialized functions can 
+ * be shared with other estimators or multiscale image functions through a ScaledImageFunctionCache.
+ *
+ * Subclasses that search the maximum of a response over the scales may refine the selected scale
+ * between the discrete scales with RefineScale() if InterpolateSelectedScale is on, so that 
+ * fewer scales give the same accuracy of the scale and radius.
+ *
  * \ingroup 
  */
 
@@ -87,6 +104,9 @@ public:
   typedef typename ScaledImageFunctionType::Pointer  ScaledImageFunctionPointer;
   
   typedef std::vector<ScaledImageFunctionPointer>    ScaledImageFunctionContainerType;
+  
+  typedef ScaledImageFunctionCache<TScaledImageFunction>    ScaledImageFunctionCacheType;
+  typedef typename ScaledImageFunctionCacheType::Pointer    ScaledImageFunctionCachePointer;
     
   enum ScaleStepMethodType
   { 
@@ -132,6 +152,36 @@ public:
   void SetScaleStepMethodToLogarithmic()
     { this->SetScaleStepMethod( LogarithmicScaleSteps ); }
   
+  /** Set/Get the flag for lazy initialization. If on, Initialize() only computes the scales, and 
+    * the function of each scale is created and initialized the first time it is requested. This 
+    * is thread-safe. Off by default. */
+  itkSetMacro( LazyInitialization, bool );
+  itkGetConstMacro( LazyInitialization, bool );
+  itkBooleanMacro( LazyInitialization );
+  
+  /** Set/Get the cache used to share the initialized scaled functions with other objects. The 
+    * functions are taken from the cache if already there and inserted otherwise. Null by default. */
+  itkSetObjectMacro( ScaledImageFunctionCache, ScaledImageFunctionCacheType );
+  itkGetObjectMacro( ScaledImageFunctionCache, ScaledImageFunctionCacheType );
+  
+  /** Set/Get the number of threads used by Initialize() to create and initialize the scaled 
+    * functions. The scales are independent, so the threads of the TaskPool take them one at a 
+    * time, from the largest, into the already sized container. The initialization of the scaled 
+    * functions must be thread-safe to use more than one thread. Not used with LazyInitialization on. Default is 1. */
+  itkSetClampMacro( NumberOfInitializationThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfInitializationThreads, unsigned int );
+  
+  /** Set/Get the flag for the refinement of the selected scale between the discrete scales, for
+    * the subclasses that select the scale of maximum response. The parabola through the responses 
+    * is fitted in the logarithm of the scale unless the scales are equispaced. Off by default. */
+  itkSetMacro( InterpolateSelectedScale, bool );
+  itkGetConstMacro( InterpolateSelectedScale, bool );
+  itkBooleanMacro( InterpolateSelectedScale );
+  
+  /** Get the scales computed in Initialize(). */
+  const ScaleVectorType & GetScales() const
+    { return this->m_Scales; }
+  
   /** Initialize the kernels. Call this method before evaluating the function.
     * This method MUST be called after any changes to function parameters. By default initialize
     * computes al the kernels using the chosen scale step computation method and fills the scale
@@ -151,7 +201,31 @@ protected:
   /** Initialize a single scaled image function or operator. This is called by Initialize() for
     * every operator. This may be reimplemented for specific operators. */    
   virtual void InitializeScaledFunction( ScaledImageFunctionType *scaledImageFunction, double scale ) {}
+  
+  /** Refine the scale of index scaleIdx, selected as the maximum response, with the responses of
+    * the neighbour scales. See ScaleInterpolation. */
+  double RefineScale( unsigned int scaleIdx, double lowerValue, double value, double upperValue ) const;
+  
+  /** Get the scaled function of the given scale index, creating it if lazy initialization is on
+    * and it was not requested before. Subclasses must access the scaled functions through this. */
+  ScaledImageFunctionType * GetScaledImageFunction( unsigned int i );
+  
+  /** Create and initialize the scaled function for the given scale, or take it from the cache. */
+  ScaledImageFunctionPointer CreateScaledImageFunction( double scale );
+  
+  /** Create and initialize the scaled functions of all the scales, with NumberOfInitializationThreads 
+    * threads. Called by Initialize() if LazyInitialization is off. */
+  void CreateScaledImageFunctions();
+  
+  /** Loop of CreateScaledImageFunctions() over the scales, with the error of each scale. */
+  struct InitializeScalesFunction : public TaskPool::RangeFunction
+  {
+    Self                      *Object;
+    std::vector<std::string>  Errors;
     
+    virtual void Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int threadId );
+  };
+  
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -161,9 +235,18 @@ private:
 
 protected:
 
-  /** Contains the different hessian function for the different scales. */  
+  /** Contains the different hessian function for the different scales. With lazy initialization,
+    * entries are null until first requested. */  
   ScaledImageFunctionContainerType  m_ScaledImageFunctionContainer;
   
+  bool                              m_LazyInitialization;
+  ScaledImageFunctionCachePointer   m_ScaledImageFunctionCache;
+  
+  /** Mutex for creating the scaled functions from several threads. */
+  itk::SimpleFastMutexLock          m_ScaledImageFunctionMutex;
+  
+  unsigned int                      m_NumberOfInitializationThreads;
+  
   /** Optimize across scales by calculating at several scales. */
   bool                          m_OptimizeScale;
   
@@ -177,6 +260,8 @@ protected:
   /** Power factor used when PowerFactorScaleStepMethod is selected for scales. */
   double                        m_PowerFactor;
   
+  bool                          m_InterpolateSelectedScale;
+  
   /** Sigmas calculated internally. */
   ScaleVectorType               m_Scales;
 };
@@ -48,7 +48,10 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetric
   m_MaximumScale( 3.0 ),
   m_NumberOfScales( 5 ),
   m_PowerFactor( 1.5 ),
-  m_ScaleStepMethod( LogarithmicScaleSteps )
+  m_ScaleStepMethod( LogarithmicScaleSteps ),
+  m_InterpolateSelectedScale( false ),
+  m_LazyInitialization( false ),
+  m_NumberOfInitializationThreads( 1 )
 {
   
 }
@@ -78,7 +81,9 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetri
   
   double stepSize = 0.0, scaleValue = 0.0;
   
-  if( this->GetNumberOfScales() > 1 )
+  if( this->GetNumberOfScales() == 1 )
+    this->m_Scales.push_back( this->m_MinimumScale );
+  else
   {
     switch( this->m_ScaleStepMethod )
     {
@@ -89,11 +94,6 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetri
         for( unsigned int i=0; i < this->GetNumberOfScales(); ++i )
         {
           scaleValue = this->m_MinimumScale + stepSize * (double)i;
-          
-          ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
-          this->InitializeScaledFunction( scaledFunction.GetPointer(), scaleValue );
-                    
-          this->m_ScaledImageFunctionContainer.push_back( scaledFunction );
           this->m_Scales.push_back( scaleValue );
         }
         
@@ -107,11 +107,6 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetri
         for( unsigned int i=0; i < this->GetNumberOfScales(); ++i )
         {
           scaleValue = vcl_exp( vcl_log ( this->m_MinimumScale ) + stepSize * (double)i );
-          
-          ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
-          this->InitializeScaledFunction( scaledFunction.GetPointer(), scaleValue );
-          
-          this->m_ScaledImageFunctionContainer.push_back( scaledFunction );
           this->m_Scales.push_back( scaleValue );
         }
                  
@@ -123,12 +118,7 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetri
         
         while( scaleValue < this->m_MaximumScale )
         {
-          ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
-          this->InitializeScaledFunction( scaledFunction.GetPointer(), scaleValue );
-          
-          this->m_ScaledImageFunctionContainer.push_back( scaledFunction );
           this->m_Scales.push_back( scaleValue );
-          
           scaleValue *= this->m_PowerFactor;          
         }
         
@@ -139,6 +129,137 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline, TMetri
         break;
     }
   }
+  
+  // With lazy initialization the functions are created in GetScaledImageFunction()
+  this->m_ScaledImageFunctionContainer.resize( this->m_Scales.size() );
+  
+  if( !this->m_LazyInitialization )
+    this->CreateScaledImageFunctions();
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void 
+MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
+::CreateScaledImageFunctions()
+{
+  const unsigned int numberOfScales = this->m_Scales.size();
+  const unsigned int numberOfThreads = vnl_math_min( this->m_NumberOfInitializationThreads, numberOfScales );
+  
+  if( numberOfThreads <= 1 )
+  {
+    for( unsigned int i=0; i < numberOfScales; ++i )
+      this->m_ScaledImageFunctionContainer[i] = this->CreateScaledImageFunction( this->m_Scales[i] );
+    
+    return;
+  }
+  
+  InitializeScalesFunction function;
+  function.Object = this;
+  function.Errors.resize( numberOfScales );
+  
+  TaskPool::GetInstance()->ParallelFor( 0, numberOfScales, &function, 1, numberOfThreads );
+  
+  for( unsigned int i=0; i < numberOfScales; ++i )
+  {
+    if( !function.Errors[i].empty() )
+      itkExceptionMacro( "Error initializing the function of scale " << this->m_Scales[i] << ": " << function.Errors[i] );
+  }
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+void
+MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>::InitializeScalesFunction
+::Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int )
+{
+  // Largest scales first, since the size of the kernels grows with the scale
+  for( TaskPool::IndexValueType j = begin; j < end; ++j )
+  {
+    const unsigned int i = static_cast<unsigned int>( this->Object->m_Scales.size() - 1 - j );
+    
+    try
+    {
+      this->Object->m_ScaledImageFunctionContainer[i] = this->Object->CreateScaledImageFunction( this->Object->m_Scales[i] );
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      this->Errors[i] = excpt.GetDescription();
+    }
+    catch( std::exception & excpt )
+    {
+      this->Errors[i] = excpt.what();
+    }
+  }
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+typename MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>::ScaledImageFunctionPointer
+MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
+::CreateScaledImageFunction( double scale )
+{
+  if( this->m_ScaledImageFunctionCache.IsNotNull() )
+  {
+    ScaledImageFunctionPointer cachedFunction = this->m_ScaledImageFunctionCache->Find( scale );
+    
+    if( cachedFunction.IsNotNull() )
+      return cachedFunction;
+  }
+  
+  ScaledImageFunctionPointer scaledFunction = ScaledImageFunctionType::New();
+  this->InitializeScaledFunction( scaledFunction.GetPointer(), scale );
+  
+  if( this->m_ScaledImageFunctionCache.IsNotNull() )
+    scaledFunction = this->m_ScaledImageFunctionCache->Insert( scale, scaledFunction );
+  
+  return scaledFunction;
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+typename MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>::ScaledImageFunctionType *
+MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
+::GetScaledImageFunction( unsigned int i )
+{
+  // The container does not change after Initialize() in this case
+  if( !this->m_LazyInitialization )
+    return this->m_ScaledImageFunctionContainer[i];
+  
+  this->m_ScaledImageFunctionMutex.Lock();
+  
+  try
+  {
+    if( this->m_ScaledImageFunctionContainer[i].IsNull() )
+      this->m_ScaledImageFunctionContainer[i] = this->CreateScaledImageFunction( this->m_Scales[i] );
+  }
+  catch( ... )
+  {
+    this->m_ScaledImageFunctionMutex.Unlock();
+    throw;
+  }
+  
+  ScaledImageFunctionType *scaledFunction = this->m_ScaledImageFunctionContainer[i];
+  
+  this->m_ScaledImageFunctionMutex.Unlock();
+  
+  return scaledFunction;
+}
+
+
+template <class TImage, class TScaledImageFunction, class TCenterline, class TMetricsCalculator>
+double
+MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetricsCalculator>
+::RefineScale( unsigned int scaleIdx, double lowerValue, double value, double upperValue ) const
+{
+  assert( scaleIdx < this->m_Scales.size() );
+  
+  if( scaleIdx == 0 || scaleIdx + 1 >= this->m_Scales.size() )
+    return this->m_Scales[scaleIdx];
+  
+  // Logarithmic and power factor scales are uniform in the logarithm of the scale
+  return ScaleInterpolation::InterpolateMaximum( this->m_Scales[scaleIdx-1], this->m_Scales[scaleIdx], 
+    this->m_Scales[scaleIdx+1], lowerValue, value, upperValue, this->m_ScaleStepMethod != Self::EquispacedScaleSteps );
 }
 
 
@@ -155,10 +276,17 @@ MultiscaleVesselSectionEstimator<TImage,TScaledImageFunction,TCenterline,TMetric
   os << indent << "NumberOfScales: " << this->m_NumberOfScales << std::endl;
   os << indent << "PowerFactor: " << this->m_PowerFactor << std::endl;
   os << indent << "ScaleStepMethod: " << this->m_ScaleStepMethod << std::endl;
+  os << indent << "InterpolateSelectedScale: " << this->m_InterpolateSelectedScale << std::endl;
+  os << indent << "LazyInitialization: " << this->m_LazyInitialization << std::endl;
+  os << indent << "NumberOfInitializationThreads: " << this->m_NumberOfInitializationThreads << std::endl;
+  os << indent << "ScaledImageFunctionCache: " << this->m_ScaledImageFunctionCache.GetPointer() << std::endl;
   os << indent << "ScaledImageFunctionContainer:" << std::endl;
   for( typename ScaledImageFunctionContainerType::const_iterator it = this->m_ScaledImageFunctionContainer.begin();
     it != this->m_ScaledImageFunctionContainer.end(); ++it )
-    (*it)->Print( os, indent.GetNextIndent() );
+  {
+    if( it->IsNotNull() )
+      (*it)->Print( os, indent.GetNextIndent() );
+  }
   os << indent << "Scales: ";
   for( unsigned int i=0; i<this->m_Scales.size(); ++i )
     os << this->m_Scales[i] << " ";
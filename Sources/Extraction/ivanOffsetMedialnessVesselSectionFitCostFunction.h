@@ -30,6 +30,7 @@ SUCH DAMAGE.
 #ifndef __ivanOffsetMedialnessVesselSectionFitCostFunction_h
 #define __ivanOffsetMedialnessVesselSectionFitCostFunction_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanImageBasedVesselSectionFitCostFunction.h"
 #include "ivanImageFunctionToCostFunctionAdaptor.h"
 #include "ivanOffsetMedialnessImageFunction.h"
@@ -81,7 +82,7 @@ public:
   /** Type used for representing point components  */
   typedef typename Superclass::ParametersValueType    CoordinateRepresentationType;
   
-    /** Not used, but expected by SingleValuedNonLinearOptimizer class. */
+  /** Derivative type, a finite-difference approximation (see superclass). */
   typedef typename Superclass::DerivativeType         DerivativeType;
 
   /** The cost value type. */
@@ -123,16 +124,6 @@ public:
   /** Gets the cost function value. */
   virtual MeasureType GetValue(const ParametersType & parameters ) const ;
 
-  /** Dummy implementation to confirm to the SingleValuedCostFunction 
-   * interfaces. It is pure virtual in the superclass */
-  virtual void GetDerivative( const ParametersType & parameters,
-    DerivativeType & derivative ) const
-    {
-      itkWarningMacro( "GetDerivative() method not implemented yet." );
-    }
-
-	//virtual void GetValueAndDerivative( const ParametersType &parameters, 
-		//MeasureType &value, DerivativeType &derivative) const;
 
   //virtual unsigned int GetNumberOfParameters(void) const;
   
@@ -163,6 +154,17 @@ private:
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_OffsetMedialnessVesselSectionFitCostFunction(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT OffsetMedialnessVesselSectionFitCostFunction< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef OffsetMedialnessVesselSectionFitCostFunction< ITK_TEMPLATE_1 x > \
+                                                  OffsetMedialnessVesselSectionFitCostFunction##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanOffsetMedialnessVesselSectionFitCostFunction+-.h"
+#endif
+
 #ifndef ITK_MANUAL_INSTANTIATION
 #include "ivanOffsetMedialnessVesselSectionFitCostFunction.hxx"
 #endif
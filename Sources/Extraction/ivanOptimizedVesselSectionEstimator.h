@@ -33,6 +33,7 @@ SUCH DAMAGE.
 
 
 #include "ivanVesselSectionEstimator.h"
+#include "ivanParallelPatternSearchOptimizer.h"
 
 
 namespace ivan
@@ -43,6 +44,16 @@ namespace ivan
  *
  * The cost function must be a subclass of VesselSectionFitCostFunction. Any optimizer may be used.
  *
+ * If WarmStart is on, every section after the first one of the range starts from the solution of 
+ * the previous section instead of the normal and radius stored in the section, since neighbouring 
+ * sections have nearly the same optimum. With a ParallelPatternSearchOptimizer the initial step 
+ * is also reduced to WarmStartStepFactor times the distance between the two previous solutions, 
+ * within [ MinimumStepLength, InitialStepLength ], so fewer contractions are needed to converge.
+ *
+ * The cancellation token is checked before every section, and passed to a 
+ * ParallelPatternSearchOptimizer so that it is also checked at every iteration. A section 
+ * whose optimization is interrupted keeps its previous normal and radius.
+ *
  * \ingroup 
  */
 
@@ -94,6 +105,19 @@ public:
   itkGetObjectMacro( Centerline, CenterlineType );
   itkGetConstObjectMacro( Centerline, CenterlineType );
   
+  /** Start each section from the solution of the previous one. Default is false. */
+  itkSetMacro( WarmStart, bool );
+  itkGetConstMacro( WarmStart, bool );
+  itkBooleanMacro( WarmStart );
+  
+  /** Factor applied to the distance between the two previous solutions to get the initial step 
+    * of a warm-started section. Only used with step-based optimizers. Default is 2.0. */
+  itkSetMacro( WarmStartStepFactor, double );
+  itkGetConstMacro( WarmStartStepFactor, double );
+  
+  /** Get the total number of optimizer iterations in the last call to Compute(). */
+  itkGetConstMacro( TotalNumberOfIterations, unsigned long );
+  
   /** Set the initial position for the optimizer. */
   //virtual void SetInitialPosition( const ParametersType &params )
   //  { this->m_Optimizer->SetInitialPosition( params ); }
@@ -105,6 +129,13 @@ protected:
   OptimizedVesselSectionEstimator();
   ~OptimizedVesselSectionEstimator();
   
+  /** Set the initial step of the optimizer, if it has one. Returns the previous step, or a 
+    * negative value if the optimizer does not support it. */
+  virtual double SetOptimizerInitialStep( double step );
+  
+  /** Get the number of iterations of the last optimization. */
+  virtual unsigned long GetOptimizerNumberOfIterations() const;
+  
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -118,6 +149,11 @@ protected:
   OptimizerPointer          m_Optimizer;
   
   CenterlinePointer         m_Centerline;
+  
+  bool                      m_WarmStart;
+  double                    m_WarmStartStepFactor;
+  
+  unsigned long             m_TotalNumberOfIterations;
 };
 
 } // end namespace ivan
@@ -42,7 +42,10 @@ namespace ivan
 
 template <class TCostFunction, class TOptimizer, class TCenterline, class TMetricsCalculator>
 OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCalculator>
-::OptimizedVesselSectionEstimator()
+::OptimizedVesselSectionEstimator() :
+  m_WarmStart( false ),
+  m_WarmStartStepFactor( 2.0 ),
+  m_TotalNumberOfIterations( 0 )
 {
   this->m_CostFunction = CostFunctionType::New();
   this->m_Optimizer = OptimizerType::New();
@@ -71,6 +74,7 @@ OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCal
   typename OptimizerType::ParametersType initialPosition = typename OptimizerType::ParametersType
     ( this->m_CostFunction->GetNumberOfParameters() );
   typename OptimizerType::ParametersType  finalParameters;
+  typename OptimizerType::ParametersType  previousParameters;
   
   SectionPointer                          currentSection;
   typename SectionType::CenterPointType   currentCenter;
@@ -78,28 +82,61 @@ OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCal
   typename SectionType::VectorType        finalNormal;
   double                                  finalRadius;
   
+  // Initial step of the optimizer, restored after the computation, and distance between the 
+  // last two solutions, negative until known
+  const double coldStep = this->m_WarmStart ? this->SetOptimizerInitialStep( -1.0 ) : -1.0;
+  double solutionDistance = -1.0;
+  
+  this->m_TotalNumberOfIterations = 0;
+  this->m_Interrupted = false;
+  this->m_NumberOfComputedSections = 0;
+  
+  // The pattern search can also be stopped within the optimization of a section
+  ParallelPatternSearchOptimizer *patternSearch = 
+    dynamic_cast<ParallelPatternSearchOptimizer *>( this->m_Optimizer.GetPointer() );
+  
+  if( patternSearch )
+    patternSearch->SetCancellationToken( this->m_CancellationToken );
+  
   // If the section range is not specified take all the sections
   if( this->m_SectionRange[0] == 0 && this->m_SectionRange[1] == 0 )
     this->m_SectionRange[1] = this->GetCenterline()->size() - 1;
       
   for( unsigned int i = this->m_SectionRange[0]; i <= this->m_SectionRange[1]; ++i )
   {
+    if( this->IsStopRequested() )
+    {
+      this->m_Interrupted = true;
+      break;
+    }
+    
     currentSection = this->GetCenterline()->at(i);
     
     this->m_CostFunction->SetSectionCenter( currentSection->GetCenter() );
     this->m_CostFunction->GetMedialnessFunction()->SetSigma( currentSection->GetScale() ); // this is the sigma for derivative calculations
     this->m_CostFunction->GetMedialnessFunction()->Initialize(); // recompute kernel since we changed sigma
     
-    // Get the initial position from each section
-    
-    currentNormal = currentSection->GetNormal();
-
-    initialPosition[0] = currentNormal[0];
-    initialPosition[1] = currentNormal[1];
-    //initialPosition[2] = currentNormal[2];
-    //initialPosition[3] = currentSection->GetRadius();
-    //initialPosition[4] = 1.0; // for the Lagrange multiplier
-    initialPosition[2] = currentSection->GetRadius();
+    if( this->m_WarmStart && i > this->m_SectionRange[0] )
+    {
+      // Start from the previous solution
+      initialPosition = finalParameters;
+      
+      if( coldStep > 0.0 && solutionDistance >= 0.0 )
+        this->SetOptimizerInitialStep( vnl_math_min( coldStep, this->m_WarmStartStepFactor * solutionDistance ) );
+    }
+    else
+    {
+      // Get the initial position from each section
+      
+      currentNormal = currentSection->GetNormal();
+  
+      initialPosition[0] = currentNormal[0];
+      initialPosition[1] = currentNormal[1];
+      //initialPosition[2] = currentNormal[2];
+      //initialPosition[3] = currentSection->GetRadius();
+      //initialPosition[4] = 1.0; // for the Lagrange multiplier
+      initialPosition[2] = currentSection->GetRadius();
+    }
     
     this->m_Optimizer->SetInitialPosition( initialPosition );
     
@@ -110,11 +147,33 @@ OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCal
     catch (itk::ExceptionObject& excpt)
     {
       std::cerr << "EXCEPTION CAUGHT!" << excpt.GetDescription() << std::endl;
+      
+      if( coldStep > 0.0 )
+        this->SetOptimizerInitialStep( coldStep );
+      
       return;
     }  
-          
+    
+    // Keep the initial section if the optimization did not finish
+    if( patternSearch && patternSearch->GetInterrupted() )
+    {
+      this->m_Interrupted = true;
+      break;
+    }
+    
+    previousParameters = finalParameters;
     finalParameters = this->m_Optimizer->GetCurrentPosition();
     
+    if( previousParameters.Size() == finalParameters.Size() )
+    {
+      solutionDistance = 0.0;
+      for( unsigned int k = 0; k < finalParameters.Size(); ++k )
+        solutionDistance += ( finalParameters[k] - previousParameters[k] ) * ( finalParameters[k] - previousParameters[k] );
+      solutionDistance = sqrt( solutionDistance );
+    }
+    
+    this->m_TotalNumberOfIterations += this->GetOptimizerNumberOfIterations();
+    
     finalNormal[0] = finalParameters[0];
     finalNormal[1] = finalParameters[1];
     //finalNormal[2] = finalParameters[2];
@@ -129,21 +188,50 @@ OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCal
     
     finalRadius = finalParameters[2];
     
-    std::cout << "Optimization finished!!!" << std::endl;
-    std::cout << "Reason: " << this->m_Optimizer->GetStopConditionDescription() << std::endl;
-    std::cout << "Point " << currentSection->GetCenter() << std::endl;
-    std::cout << " Normal     = " << finalNormal  << std::endl;
-    std::cout << " Radius     = " << finalRadius  << std::endl;
-    std::cout << " Iterations = " << this->m_Optimizer->GetCurrentIteration() << std::endl;
-    std::cout << " Best value = " << this->m_Optimizer->GetValue() << std::endl;
-    std::cout << " Frobenius norm = " << this->m_Optimizer->GetFrobeniusNorm() << std::endl;
-    std::cout << std::endl;
+    itkDebugMacro( "Optimization finished: " << this->m_Optimizer->GetStopConditionDescription() 
+      << " Point " << currentSection->GetCenter() << ", Normal = " << finalNormal 
+      << ", Radius = " << finalRadius << ", Iterations = " << this->GetOptimizerNumberOfIterations() );
     
     currentSection->SetNormal( finalNormal );
     currentSection->SetRadius( finalRadius );
     
     this->m_CurrentScale = finalRadius; // !!! WARNING: CHECK THIS
+    
+    ++this->m_NumberOfComputedSections;
   }
+  
+  if( coldStep > 0.0 )
+    this->SetOptimizerInitialStep( coldStep );
+}
+
+
+template <class TCostFunction, class TOptimizer, class TCenterline, class TMetricsCalculator>
+double
+OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCalculator>
+::SetOptimizerInitialStep( double step )
+{
+  ParallelPatternSearchOptimizer *patternSearch = 
+    dynamic_cast<ParallelPatternSearchOptimizer *>( this->m_Optimizer.GetPointer() );
+  
+  if( !patternSearch )
+    return -1.0;
+  
+  const double previousStep = patternSearch->GetInitialStepLength();
+  
+  // A negative step just queries the current one
+  if( step >= 0.0 )
+    patternSearch->SetInitialStepLength( vnl_math_max( step, patternSearch->GetMinimumStepLength() ) );
+  
+  return previousStep;
+}
+
+
+template <class TCostFunction, class TOptimizer, class TCenterline, class TMetricsCalculator>
+unsigned long
+OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCalculator>
+::GetOptimizerNumberOfIterations() const
+{
+  return this->m_Optimizer->GetCurrentIteration();
 }
 
 
@@ -154,6 +242,9 @@ OptimizedVesselSectionEstimator<TCostFunction,TOptimizer,TCenterline,TMetricsCal
 {
   Superclass::PrintSelf( os, indent );
   
+  os << indent << "WarmStart: " << this->m_WarmStart << std::endl;
+  os << indent << "WarmStartStepFactor: " << this->m_WarmStartStepFactor << std::endl;
+  os << indent << "TotalNumberOfIterations: " << this->m_TotalNumberOfIterations << std::endl;
   os << indent << "CostFunction: " << this->m_CostFunction << std::endl;
   this->m_CostFunction->Print( os, indent.GetNextIndent() );
   
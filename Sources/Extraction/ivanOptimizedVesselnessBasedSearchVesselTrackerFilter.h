@@ -50,6 +50,10 @@ namespace ivan
  * The cost function is an adapted vesselness image function used to guide the
  * optimization procedure.
  *
+ * The adaptors are BatchSingleValuedCostFunction objects, so with an optimizer that evaluates 
+ * several independent candidates per iteration, such as ParallelPatternSearchOptimizer, these 
+ * can be evaluated concurrently by setting the number of threads of the cost function.
+ *
  */
 
 template <class TInputImage, class TOutputVessel, class TVesselnessFunction, class TCostFunction>
@@ -148,7 +152,8 @@ public:
 protected:
   
   OptimizedVesselnessBasedSearchVesselTrackerFilter();
-  ~OptimizedVesselnessBasedSearchVesselTrackerFilter() {}
+  ~OptimizedVesselnessBasedSearchVesselTrackerFilter()
+    { this->StopTracking(); }
   
   /** Reimplemente the search for the optimum as a local optimization of the vesselness function. */
   virtual void Search();
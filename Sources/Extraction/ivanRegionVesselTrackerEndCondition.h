@@ -0,0 +1,158 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRegionVesselTrackerEndCondition.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking outside an image region
+// Date: 2012/11/05
+
+
+#ifndef __ivanRegionVesselTrackerEndCondition_h
+#define __ivanRegionVesselTrackerEndCondition_h
+
+#include "ivanVesselTrackerEndCondition.h"
+
+#include "itkImageRegion.h"
+#include "itkVector.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+/** \class RegionVesselTrackerEndCondition
+ *  \brief End condition that stops tracking when the current section leaves an image region.
+ *
+ * Tracking finishes when the center of the current section, taken from the step state of the 
+ * tracker, is outside the given region of the reference image (the largest possible region 
+ * by default). Only the geometry of the image is used, so it may be a header-only image. 
+ * Pixels cover half a spacing around their index, as in ITK.
+ *
+ * Every time tracking leaves the region, the first position outside and the direction from the
+ * last position inside are recorded as an exit. In a distributed tracking, where each process
+ * tracks a region of the image, the exits are the seeds handed to the neighbouring processes. 
+ * Exits are kept by Reset(), so both directions of a bidirectional tracking are reported, and 
+ * removed by ClearExits(). Nothing is checked if there is no image or step state.
+ *
+ */
+
+template <class TImage>
+class ITK_EXPORT RegionVesselTrackerEndCondition : public VesselTrackerEndCondition
+{
+public:
+  
+  typedef RegionVesselTrackerEndCondition    Self;
+  typedef VesselTrackerEndCondition          Superclass;
+  typedef itk::SmartPointer<Self>            Pointer;
+  typedef itk::SmartPointer<const Self>      ConstPointer;
+  
+  typedef TImage                               ImageType;
+  typedef typename ImageType::ConstPointer     ImageConstPointer;
+  typedef typename ImageType::PointType        ImagePointType;
+  typedef typename ImageType::RegionType       RegionType;
+  
+  typedef VesselTrackerStepState::PointType    PointType;
+  typedef itk::Vector<double,3>                DirectionType;
+  
+  /** Position where tracking left the region, and unit direction of the last step. */
+  struct Exit
+  {
+    PointType      Position;
+    DirectionType  Direction;
+  };
+  
+  typedef std::vector<Exit>                    ExitContainerType;
+    
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RegionVesselTrackerEndCondition, VesselTrackerEndCondition );
+  
+  /** Set/Get the image that gives the geometry of the region. */
+  itkSetConstObjectMacro( Image, ImageType );
+  itkGetConstObjectMacro( Image, ImageType );
+  
+  /** Set/Get the region where tracking is allowed. If not set, the largest possible region 
+    * of the image is used. */
+  void SetRegion( const RegionType & region )
+    {
+      this->m_Region = region;
+      this->m_RegionSet = true;
+      this->Modified();
+    }
+  itkGetConstReferenceMacro( Region, RegionType );
+  
+  virtual bool Finished();
+  
+  virtual void Reset()
+    { this->m_HasLastInsidePosition = false; }
+  
+  /** A bounds check. */
+  virtual double GetEvaluationCost() const
+    { return 1.0; }
+  
+  /** Get the exits recorded since the last ClearExits(). */
+  const ExitContainerType & GetExits() const
+    { return this->m_Exits; }
+  
+  void ClearExits()
+    { this->m_Exits.clear(); }
+
+protected:
+  
+  RegionVesselTrackerEndCondition();
+  virtual ~RegionVesselTrackerEndCondition() {}
+  virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
+  
+  bool IsInside( const PointType & position ) const;
+      
+private:
+  
+  RegionVesselTrackerEndCondition(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  ImageConstPointer   m_Image;
+  
+  RegionType          m_Region;
+  bool                m_RegionSet;
+  
+  PointType           m_LastInsidePosition;
+  bool                m_HasLastInsidePosition;
+  
+  ExitContainerType   m_Exits;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanRegionVesselTrackerEndCondition.hxx"
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRegionVesselTrackerEndCondition.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: end condition that stops tracking outside an image region
+// Date: 2012/11/05
+
+#ifndef __ivanRegionVesselTrackerEndCondition_hxx
+#define __ivanRegionVesselTrackerEndCondition_hxx
+
+#include "ivanRegionVesselTrackerEndCondition.h"
+
+#include "itkContinuousIndex.h"
+
+
+namespace ivan
+{
+
+template <class TImage>
+RegionVesselTrackerEndCondition<TImage>
+::RegionVesselTrackerEndCondition() :
+  m_RegionSet( false ),
+  m_HasLastInsidePosition( false )
+{
+  this->m_LastInsidePosition.Fill( 0.0 );
+}
+
+
+template <class TImage>
+bool 
+RegionVesselTrackerEndCondition<TImage>
+::IsInside( const PointType & position ) const
+{
+  ImagePointType point;
+  point.Fill( 0.0 );
+  
+  for( unsigned int i=0; i < ImageType::ImageDimension && i < 3; ++i )
+    point[i] = position[i];
+    
+  itk::ContinuousIndex<double,ImageType::ImageDimension> index;
+  this->m_Image->TransformPhysicalPointToContinuousIndex( point, index );
+  
+  const RegionType & region = 
+    this->m_RegionSet ? this->m_Region : this->m_Image->GetLargestPossibleRegion();
+  
+  for( unsigned int dim = 0; dim < ImageType::ImageDimension; ++dim )
+  {
+    const double start = region.GetIndex()[dim] - 0.5;
+    
+    if( index[dim] < start || index[dim] >= start + region.GetSize()[dim] )
+      return false;
+  }
+  
+  return true;
+}
+
+
+template <class TImage>
+bool 
+RegionVesselTrackerEndCondition<TImage>
+::Finished()
+{
+  if( this->m_Image.IsNull() || !this->m_StepState || !this->m_StepState->Valid )
+    return false;
+  
+  const PointType & position = this->m_StepState->Position;
+  
+  if( this->IsInside( position ) )
+  {
+    this->m_LastInsidePosition = position;
+    this->m_HasLastInsidePosition = true;
+    return false;
+  }
+  
+  // Tracking started outside the region gives no exit
+  if( this->m_HasLastInsidePosition )
+  {
+    Exit exit;
+    exit.Position = position;
+    exit.Direction = position - this->m_LastInsidePosition;
+    
+    const double norm = exit.Direction.GetNorm();
+    
+    if( norm > 0.0 )
+      exit.Direction /= norm;
+    
+    this->m_Exits.push_back( exit );
+    this->m_HasLastInsidePosition = false;
+  }
+  
+  return true;
+}
+	
+
+template <class TImage>
+void 
+RegionVesselTrackerEndCondition<TImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Image: " << this->m_Image.GetPointer() << std::endl;
+  os << indent << "Region: " << this->m_Region << std::endl;
+  os << indent << "RegionSet: " << this->m_RegionSet << std::endl;
+  os << indent << "NumberOfExits: " << this->m_Exits.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanRegionVesselTrackerEndCondition_hxx
@@ -0,0 +1,294 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSkeletonVesselExtractionFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: extracts the centerlines of a vessel tree from multiscale filter outputs.
+// Date: 2012/11/05
+
+
+#ifndef __ivanSkeletonVesselExtractionFilter_h
+#define __ivanSkeletonVesselExtractionFilter_h
+
+#include "ivanImageToVesselDataObjectFilter.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class SkeletonVesselExtractionFilter
+ * \brief Extracts the centerlines of a whole vessel tree from the outputs of a multiscale filter.
+ *
+ * The inputs are a medialness or vesselness image, such as the output of a 
+ * MultiscaleMedialnessImageFilter, the image of the section normals, which are the vessel 
+ * directions (GetOutputNormals()), and optionally the image of the scales (GetOutputScales()). 
+ * No seeds are needed. Only 3D images are supported.
+ *
+ * Extraction takes a single pass over the volume and a few passes over the ridge pixels:
+ *
+ * 1. Non-maximum suppression. A pixel whose response is above LowerThreshold is a ridge pixel 
+ *    if it is a maximum of the response in the plane orthogonal to its normal. The response 
+ *    is interpolated at one pixel from it in eight directions of that plane. Ties are broken 
+ *    by the direction of the sample, so that plateaus two pixels wide give a single ridge.
+ * 2. Linking. Ridge pixels are linked to their 26 neighbours by a minimum spanning forest,
+ *    built with Kruskal's algorithm and a union-find. The weight of a link is its length over
+ *    the sum of the responses of its pixels (minus twice LowerThreshold), so the forest 
+ *    follows the highest responses where the ridge is more than one pixel thick. 
+ * 3. Pruning. Terminal branches, from a pixel with a single link to a pixel with three or more, 
+ *    with fewer than MinimumBranchLength pixels are removed, as well as isolated branches of 
+ *    fewer pixels. This is done once, so that the spurs of thick ridges are removed but the 
+ *    branches made terminal by the removal are kept.
+ *
+ * The first two steps are run in parallel over slabs of the image along the last dimension
+ * (see SlabDecomposition), one per thread. Each thread builds the spanning forest of the links 
+ * inside its slab, and the links across slabs are merged with these forests at the end. The 
+ * forest is unique, since links are ordered by weight and pixel, so the output does not 
+ * depend on the number of threads.
+ *
+ * The output is a VesselGraph whose root is a VesselNode with id 0. Each tree of the forest 
+ * starts with a VesselBranchNode child of the root, from its first terminal pixel in memory 
+ * order. A branch ends at a terminal pixel or at a pixel with three or more links, where a 
+ * VesselBifurcationNode child of the branch is the parent of the branches that start there, 
+ * in breadth-first order. Consecutive branches share the section of the bifurcation pixel. 
+ * Ids are given in order of creation. Sections are at the centers of the ridge pixels, with 
+ * the normal of the normals image, oriented along the branch. If the scale image is set, the 
+ * scale of every section is taken from it and the radius is the scale times 
+ * ScaleToRadiusFactor, otherwise they are zero.
+ *
+ * All the inputs must have the same buffered region, which by default is their largest 
+ * possible region.
+ *
+ * \sa MultiscaleMedialnessImageFilter, MultiSeedVesselTrackerFilter
+ */
+
+template <class TInputImage, class TOutputVessel, class TScalePixel = double>
+class ITK_EXPORT SkeletonVesselExtractionFilter : 
+  public ImageToVesselDataObjectFilter<TInputImage,TOutputVessel>
+{
+public:
+	
+  /** Standard class typedefs. */
+  typedef SkeletonVesselExtractionFilter
+    <TInputImage,TOutputVessel,TScalePixel>           Self;
+  typedef ImageToVesselDataObjectFilter
+    <TInputImage,TOutputVessel>                       Superclass;
+  typedef itk::SmartPointer<Self>                     Pointer;
+  typedef itk::SmartPointer<const Self>               ConstPointer;
+  
+  /** Image-related typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::Pointer        InputImagePointer;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::RegionType     InputImageRegionType; 
+  typedef typename InputImageType::PixelType      InputImagePixelType;
+  typedef typename InputImageType::PointType      InputImagePointType;
+  typedef typename InputImageType::IndexType      InputImageIndexType; 
+  	
+  /** Vessel-related typedefs. */
+  typedef TOutputVessel                              OutputVesselType;
+  typedef typename OutputVesselType::Pointer         OutputVesselPointer;
+  typedef typename OutputVesselType::CenterlineType  CenterlineType;
+  typedef typename CenterlineType::SectionType       SectionType;
+    
+  typedef VesselBranchNode<CenterlineType>           BranchNodeType;
+  typedef typename BranchNodeType::Pointer           BranchNodePointer;
+  typedef VesselBifurcationNode<CenterlineType>      BifurcationNodeType;
+  typedef typename BifurcationNodeType::Pointer      BifurcationNodePointer;
+  
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  
+  /** Types of the scale and normal images, as produced by the multiscale filters. */
+  typedef TScalePixel                                                             ScalePixelType;
+  typedef itk::Image<ScalePixelType,itkGetStaticConstMacro(InputImageDimension)>  ScaleImageType;
+  typedef itk::Vector<ScalePixelType,itkGetStaticConstMacro(InputImageDimension)> NormalPixelType;
+  typedef itk::Image<NormalPixelType,itkGetStaticConstMacro(InputImageDimension)> NormalImageType;
+  
+public:
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SkeletonVesselExtractionFilter, ImageToVesselDataObjectFilter );
+  
+  /** Set/Get the image of the section normals. Required. */
+  void SetNormalImage( const NormalImageType * normalImage );
+  const NormalImageType * GetNormalImage() const;
+  
+  /** Set/Get the image of the scales. Optional. */
+  void SetScaleImage( const ScaleImageType * scaleImage );
+  const ScaleImageType * GetScaleImage() const;
+  
+  /** Set/Get the response above which pixels may be ridge pixels. Default is 0.0. */
+  itkSetMacro( LowerThreshold, double );
+  itkGetConstMacro( LowerThreshold, double );
+  
+  /** Set/Get the minimum number of pixels of terminal and isolated branches. Default is 5. */
+  itkSetMacro( MinimumBranchLength, unsigned int );
+  itkGetConstMacro( MinimumBranchLength, unsigned int );
+  
+  /** Set/Get the factor converting scales to radii. Default is sqrt(3), the radius factor of
+    * MultiscaleMedialnessImageFilter. */
+  itkSetMacro( ScaleToRadiusFactor, double );
+  itkGetConstMacro( ScaleToRadiusFactor, double );
+  
+  /** Get the number of ridge pixels found by the last execution, before pruning. */
+  itkGetConstMacro( NumberOfRidgePixels, unsigned long );
+  
+  /** Get the number of branches and bifurcations of the output of the last execution. */
+  itkGetConstMacro( NumberOfBranches, unsigned long );
+  itkGetConstMacro( NumberOfBifurcations, unsigned long );
+  
+protected:
+  
+  SkeletonVesselExtractionFilter();
+  ~SkeletonVesselExtractionFilter() {}
+  
+  virtual void GenerateData();
+  
+  /** Find the ridge pixels of the given slab by non-maximum suppression. */
+  virtual void ThreadedFindRidgePixels( unsigned int slab );
+  
+  /** Find the links of the ridge pixels of the given slab and build the spanning forest of 
+    * the links inside the slab. */
+  virtual void ThreadedLinkRidgePixels( unsigned int slab );
+  
+  /** Merge the forests of the slabs with the links across slabs, and build the adjacency of
+    * the resulting forest. */
+  void MergeSlabForests();
+  
+  /** Remove the short terminal and isolated branches of the forest. */
+  void PruneForest();
+  
+  /** Build the output graph from the pruned forest. */
+  void BuildGraph();
+  
+  /** Build the branch that starts at the given ridge pixel going to the given neighbour, up
+    * to the next pixel whose number of links is not two. This last pixel and the one before it
+    * are returned. */
+  BranchNodePointer BuildBranch( unsigned int start, unsigned int next, 
+    unsigned int & previous, unsigned int & end ) const;
+  
+  /** Static functions used as "callbacks" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FindRidgePixelsThreaderCallback( void *arg );
+  static ITK_THREAD_RETURN_TYPE LinkRidgePixelsThreaderCallback( void *arg );
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  SkeletonVesselExtractionFilter(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+  /** Link between two ridge pixels, ordered by weight and then by pixels. */
+  struct Link
+  {
+    float           Weight;
+    unsigned int    First;
+    unsigned int    Second;
+    
+    bool operator<( const Link & other ) const
+      { 
+        if( this->Weight != other.Weight )
+          return this->Weight < other.Weight;
+        if( this->First != other.First )
+          return this->First < other.First;
+        return this->Second < other.Second; 
+      }
+  };
+  
+  typedef std::vector<Link>   LinkContainerType;
+  
+  /** Branch waiting to be built, from a pixel to one of its neighbours. */
+  struct PendingBranch
+  {
+    unsigned int    Start;
+    unsigned int    Next;
+    GraphNode       *Parent;
+  };
+  
+  /** Root of the given ridge pixel in the union-find, with path halving. */
+  unsigned int FindRoot( unsigned int pixel )
+    {
+      while( this->m_Parents[pixel] != pixel )
+      {
+        this->m_Parents[pixel] = this->m_Parents[ this->m_Parents[pixel] ];
+        pixel = this->m_Parents[pixel];
+      }
+      return pixel;
+    }
+  
+  /** Add the links that join different trees to the forest, in order. Roots are the smallest 
+    * pixel of every tree. */
+  void AddForestLinks( LinkContainerType & links, LinkContainerType & forest );
+  
+protected:
+
+  double                        m_LowerThreshold;
+  unsigned int                  m_MinimumBranchLength;
+  double                        m_ScaleToRadiusFactor;
+  
+  unsigned long                 m_NumberOfRidgePixels;
+  unsigned long                 m_NumberOfBranches;
+  unsigned long                 m_NumberOfBifurcations;
+  
+  /** Data of the ridge pixels, only kept during GenerateData(). Pixels are numbered in the
+    * order of their offsets in the buffer, and slab k holds the pixels from m_SlabStarts[k]
+    * to m_SlabStarts[k+1]. */
+  std::vector<InputImageRegionType>         m_Slabs;
+  std::vector<std::vector<unsigned long> >  m_SlabOffsets;
+  std::vector<std::vector<float> >          m_SlabValues;
+  std::vector<LinkContainerType>            m_SlabForests;
+  std::vector<LinkContainerType>            m_SlabCrossLinks;
+  std::vector<unsigned int>                 m_SlabStarts;
+  
+  std::vector<unsigned long>    m_Offsets;
+  std::vector<float>            m_Values;
+  std::vector<unsigned int>     m_Parents;
+  
+  /** Adjacency of the forest, the neighbours of pixel i being from m_NeighbourStarts[i] to 
+    * m_NeighbourStarts[i+1], and the number of links left after pruning. */
+  std::vector<unsigned int>     m_NeighbourStarts;
+  std::vector<unsigned int>     m_Neighbours;
+  std::vector<unsigned char>    m_Removed;
+  std::vector<unsigned char>    m_Degrees;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanSkeletonVesselExtractionFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,855 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSkeletonVesselExtractionFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: extracts the centerlines of a vessel tree from multiscale filter outputs.
+// Date: 2012/11/05
+
+#ifndef __ivanSkeletonVesselExtractionFilter_hxx
+#define __ivanSkeletonVesselExtractionFilter_hxx
+
+#include "ivanSkeletonVesselExtractionFilter.h"
+#include "ivanSlabDecomposition.h"
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkContinuousIndex.h"
+
+#include <vnl/vnl_math.h>
+
+#include <deque>
+#include <algorithm>
+#include <cmath>
+
+namespace ivan
+{
+  
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::SkeletonVesselExtractionFilter() :
+  m_LowerThreshold( 0.0 ),
+  m_MinimumBranchLength( 5 ),
+  m_ScaleToRadiusFactor( vcl_sqrt( 3.0 ) ),
+  m_NumberOfRidgePixels( 0 ),
+  m_NumberOfBranches( 0 ),
+  m_NumberOfBifurcations( 0 )
+{
+  this->SetNumberOfRequiredInputs(2);
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::SetNormalImage( const NormalImageType * normalImage )
+{
+  this->SetNthInput(1, const_cast<NormalImageType*>( normalImage ));
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+const typename SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>::NormalImageType *
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::GetNormalImage() const
+{
+  return (static_cast<const NormalImageType*>(this->itk::ProcessObject::GetInput(1)));
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::SetScaleImage( const ScaleImageType * scaleImage )
+{
+  this->SetNthInput(2, const_cast<ScaleImageType*>( scaleImage ));
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+const typename SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>::ScaleImageType *
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::GetScaleImage() const
+{
+  if( this->GetNumberOfInputs() < 3 )
+    return 0;
+  
+  return (static_cast<const ScaleImageType*>(this->itk::ProcessObject::GetInput(2)));
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::GenerateData()
+{
+  const InputImageType *input = this->GetInput();
+  const NormalImageType *normals = this->GetNormalImage();
+  const ScaleImageType *scales = this->GetScaleImage();
+  
+  if( InputImageDimension != 3 )
+    itkExceptionMacro( "Only 3D images are supported." );
+  
+  const InputImageRegionType region = input->GetBufferedRegion();
+  
+  if( normals->GetBufferedRegion() != region || ( scales && scales->GetBufferedRegion() != region ) )
+    itkExceptionMacro( "The normal and scale images must have the same buffered region as the input." );
+  
+  // One slab per thread along the last dimension, so that slabs are contiguous in memory
+  typedef SlabDecomposition<InputImageDimension>  SlabDecompositionType;
+  
+  typename SlabDecompositionType::Pointer slabDecomposition = SlabDecompositionType::New();
+  slabDecomposition->SetRegion( region );
+  slabDecomposition->SetRequestedNumberOfSlabs( this->GetNumberOfThreads() );
+  slabDecomposition->Initialize();
+  
+  const unsigned int numberOfSlabs = slabDecomposition->GetNumberOfSlabs();
+  
+  this->m_Slabs.resize( numberOfSlabs );
+  
+  for( unsigned int k=0; k < numberOfSlabs; ++k )
+    this->m_Slabs[k] = slabDecomposition->GetSlab(k);
+  
+  this->m_SlabOffsets.assign( numberOfSlabs, std::vector<unsigned long>() );
+  this->m_SlabValues.assign( numberOfSlabs, std::vector<float>() );
+  this->m_SlabForests.assign( numberOfSlabs, LinkContainerType() );
+  this->m_SlabCrossLinks.assign( numberOfSlabs, LinkContainerType() );
+  
+  if( numberOfSlabs > 0 )
+  {
+    this->GetMultiThreader()->SetNumberOfThreads( numberOfSlabs );
+    this->GetMultiThreader()->SetSingleMethod( this->FindRidgePixelsThreaderCallback, this );
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+  
+  // Number the ridge pixels in memory order
+  this->m_SlabStarts.assign( numberOfSlabs + 1, 0 );
+  
+  for( unsigned int k=0; k < numberOfSlabs; ++k )
+    this->m_SlabStarts[k+1] = this->m_SlabStarts[k] + this->m_SlabOffsets[k].size();
+  
+  this->m_Offsets.clear();
+  this->m_Offsets.reserve( this->m_SlabStarts[numberOfSlabs] );
+  this->m_Values.clear();
+  this->m_Values.reserve( this->m_SlabStarts[numberOfSlabs] );
+  
+  for( unsigned int k=0; k < numberOfSlabs; ++k )
+  {
+    this->m_Offsets.insert( this->m_Offsets.end(), this->m_SlabOffsets[k].begin(), this->m_SlabOffsets[k].end() );
+    this->m_Values.insert( this->m_Values.end(), this->m_SlabValues[k].begin(), this->m_SlabValues[k].end() );
+    std::vector<unsigned long>().swap( this->m_SlabOffsets[k] );
+    std::vector<float>().swap( this->m_SlabValues[k] );
+  }
+  
+  this->m_NumberOfRidgePixels = this->m_Offsets.size();
+  this->m_Parents.resize( this->m_Offsets.size() );
+  
+  if( numberOfSlabs > 0 )
+  {
+    this->GetMultiThreader()->SetSingleMethod( this->LinkRidgePixelsThreaderCallback, this );
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+  
+  this->MergeSlabForests();
+  this->PruneForest();
+  this->BuildGraph();
+  
+  this->m_Slabs.clear();
+  this->m_SlabOffsets.clear();
+  this->m_SlabValues.clear();
+  this->m_SlabForests.clear();
+  this->m_SlabCrossLinks.clear();
+  std::vector<unsigned long>().swap( this->m_Offsets );
+  std::vector<float>().swap( this->m_Values );
+  std::vector<unsigned int>().swap( this->m_NeighbourStarts );
+  std::vector<unsigned int>().swap( this->m_Neighbours );
+  std::vector<unsigned char>().swap( this->m_Removed );
+  std::vector<unsigned char>().swap( this->m_Degrees );
+  
+  itkDebugMacro( "Extracted " << this->m_NumberOfBranches << " branches and " 
+    << this->m_NumberOfBifurcations << " bifurcations from " << this->m_NumberOfRidgePixels 
+    << " ridge pixels using " << numberOfSlabs << " slabs" );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::ThreadedFindRidgePixels( unsigned int slab )
+{
+  const InputImageType *input = 
+    static_cast<const InputImageType *>( this->itk::ProcessObject::GetInput(0) );
+  const NormalImageType *normals = this->GetNormalImage();
+  
+  // Every thread uses its own interpolator
+  typedef itk::LinearInterpolateImageFunction<InputImageType,double>  InterpolatorType;
+  typedef typename InterpolatorType::ContinuousIndexType              ContinuousIndexType;
+  
+  typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( input );
+  
+  // Samples are taken at the smallest spacing from the pixel
+  const typename InputImageType::SpacingType & spacing = input->GetSpacing();
+  
+  double step = spacing[0];
+  for( unsigned int d=1; d<InputImageDimension; ++d )
+    step = std::min<double>( step, spacing[d] );
+  
+  std::vector<unsigned long> & offsets = this->m_SlabOffsets[slab];
+  std::vector<float> & values = this->m_SlabValues[slab];
+  
+  itk::ImageRegionConstIteratorWithIndex<InputImageType> it( input, this->m_Slabs[slab] );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double value = it.Get();
+    
+    if( !( value > this->m_LowerThreshold ) )
+      continue;
+    
+    const InputImageIndexType & index = it.GetIndex();
+    const NormalPixelType & pixelNormal = normals->GetPixel( index );
+    
+    double normal[3] = { 0.0, 0.0, 0.0 };
+    double norm = 0.0;
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+    {
+      normal[d] = pixelNormal[d];
+      norm += normal[d] * normal[d];
+    }
+    
+    if( norm <= 0.0 )
+      continue;
+    
+    norm = vcl_sqrt( norm );
+    
+    for( unsigned int d=0; d<3; ++d )
+      normal[d] /= norm;
+    
+    // Orthonormal basis of the plane orthogonal to the normal, from the axis farthest from it
+    unsigned int axis = 0;
+    for( unsigned int d=1; d<3; ++d )
+    {
+      if( vcl_abs( normal[d] ) < vcl_abs( normal[axis] ) )
+        axis = d;
+    }
+    
+    double u[3], v[3];
+    u[0] = ( axis == 0 ) ? 0.0 : ( axis == 1 ) ? -normal[2] : normal[1];
+    u[1] = ( axis == 1 ) ? 0.0 : ( axis == 0 ) ? normal[2] : -normal[0];
+    u[2] = ( axis == 2 ) ? 0.0 : ( axis == 0 ) ? -normal[1] : normal[0];
+    
+    const double uNorm = vcl_sqrt( u[0] * u[0] + u[1] * u[1] + u[2] * u[2] );
+    
+    for( unsigned int d=0; d<3; ++d )
+      u[d] /= uNorm;
+    
+    v[0] = normal[1] * u[2] - normal[2] * u[1];
+    v[1] = normal[2] * u[0] - normal[0] * u[2];
+    v[2] = normal[0] * u[1] - normal[1] * u[0];
+    
+    double directions[4][3];
+    
+    for( unsigned int d=0; d<3; ++d )
+    {
+      directions[0][d] = u[d];
+      directions[1][d] = v[d];
+      directions[2][d] = ( u[d] + v[d] ) * vnl_math::sqrt1_2;
+      directions[3][d] = ( u[d] - v[d] ) * vnl_math::sqrt1_2;
+    }
+    
+    // Compare with the samples at both sides along every direction. The pixel must be strictly
+    // larger than the sample whose first non-zero coordinate is positive
+    bool isMaximum = true;
+    
+    for( unsigned int k=0; k < 8 && isMaximum; ++k )
+    {
+      const double sign = ( k % 2 ) ? -1.0 : 1.0;
+      
+      ContinuousIndexType sampleIndex;
+      int side = 0;
+      
+      for( unsigned int d=0; d<InputImageDimension; ++d )
+      {
+        const double delta = sign * directions[k/2][d] * step / spacing[d];
+        
+        if( side == 0 && vcl_abs( delta ) > 1e-6 )
+          side = ( delta > 0.0 ) ? 1 : -1;
+          
+        sampleIndex[d] = index[d] + delta;
+      }
+      
+      if( !interpolator->IsInsideBuffer( sampleIndex ) )
+        continue;
+      
+      const double sample = interpolator->EvaluateAtContinuousIndex( sampleIndex );
+      
+      if( ( side > 0 ) ? sample >= value : sample > value )
+        isMaximum = false;
+    }
+    
+    if( isMaximum )
+    {
+      offsets.push_back( input->ComputeOffset( index ) );
+      values.push_back( static_cast<float>( value ) );
+    }
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::ThreadedLinkRidgePixels( unsigned int slab )
+{
+  const InputImageType *input = 
+    static_cast<const InputImageType *>( this->itk::ProcessObject::GetInput(0) );
+  
+  const InputImageRegionType & region = input->GetBufferedRegion();
+  const typename InputImageType::SpacingType & spacing = input->GetSpacing();
+  
+  long strides[InputImageDimension];
+  strides[0] = 1;
+  for( unsigned int d=1; d<InputImageDimension; ++d )
+    strides[d] = strides[d-1] * static_cast<long>( region.GetSize()[d-1] );
+  
+  // The neighbours with a larger offset, half of the 26 neighbours
+  unsigned int numberOfNeighbours = 1;
+  for( unsigned int d=0; d<InputImageDimension; ++d )
+    numberOfNeighbours *= 3;
+  
+  std::vector<typename InputImageType::OffsetType> neighbourOffsets;
+  std::vector<long> neighbourBufferOffsets;
+  std::vector<double> neighbourDistances;
+  
+  for( unsigned int k=0; k < numberOfNeighbours; ++k )
+  {
+    typename InputImageType::OffsetType neighbourOffset;
+    long bufferOffset = 0;
+    double distance = 0.0;
+    
+    for( unsigned int d=0, code=k; d<InputImageDimension; ++d, code /= 3 )
+    {
+      neighbourOffset[d] = static_cast<long>( code % 3 ) - 1;
+      bufferOffset += neighbourOffset[d] * strides[d];
+      distance += neighbourOffset[d] * neighbourOffset[d] * spacing[d] * spacing[d];
+    }
+    
+    if( bufferOffset > 0 )
+    {
+      neighbourOffsets.push_back( neighbourOffset );
+      neighbourBufferOffsets.push_back( bufferOffset );
+      neighbourDistances.push_back( vcl_sqrt( distance ) );
+    }
+  }
+  
+  const unsigned int begin = this->m_SlabStarts[slab];
+  const unsigned int end = this->m_SlabStarts[slab+1];
+  
+  LinkContainerType links;
+  LinkContainerType & crossLinks = this->m_SlabCrossLinks[slab];
+  
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    const InputImageIndexType index = input->ComputeIndex( this->m_Offsets[i] );
+    
+    for( unsigned int k=0; k < neighbourOffsets.size(); ++k )
+    {
+      const InputImageIndexType neighbourIndex = index + neighbourOffsets[k];
+      
+      if( !region.IsInside( neighbourIndex ) )
+        continue;
+      
+      const unsigned long neighbourOffset = this->m_Offsets[i] + neighbourBufferOffsets[k];
+      
+      std::vector<unsigned long>::const_iterator found = std::lower_bound( 
+        this->m_Offsets.begin() + i + 1, this->m_Offsets.end(), neighbourOffset );
+      
+      if( found == this->m_Offsets.end() || *found != neighbourOffset )
+        continue;
+      
+      Link link;
+      link.First = i;
+      link.Second = found - this->m_Offsets.begin();
+      link.Weight = static_cast<float>( neighbourDistances[k] / ( this->m_Values[link.First] + 
+        this->m_Values[link.Second] - 2.0 * this->m_LowerThreshold ) );
+      
+      if( link.Second < end )
+        links.push_back( link );
+      else
+        crossLinks.push_back( link );
+    }
+  }
+  
+  // Spanning forest of the links inside the slab, whose roots stay inside the slab
+  for( unsigned int i = begin; i < end; ++i )
+    this->m_Parents[i] = i;
+  
+  std::sort( links.begin(), links.end() );
+  
+  this->AddForestLinks( links, this->m_SlabForests[slab] );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::AddForestLinks( LinkContainerType & links, LinkContainerType & forest )
+{
+  for( unsigned int k=0; k < links.size(); ++k )
+  {
+    const unsigned int firstRoot = this->FindRoot( links[k].First );
+    const unsigned int secondRoot = this->FindRoot( links[k].Second );
+    
+    if( firstRoot == secondRoot )
+      continue;
+    
+    if( firstRoot < secondRoot )
+      this->m_Parents[secondRoot] = firstRoot;
+    else
+      this->m_Parents[firstRoot] = secondRoot;
+    
+    forest.push_back( links[k] );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::MergeSlabForests()
+{
+  // A link left out of the forest of a slab closes a cycle of lighter links, so it cannot be 
+  // in the forest of the whole image either
+  LinkContainerType links;
+  
+  for( unsigned int k=0; k < this->m_SlabForests.size(); ++k )
+  {
+    links.insert( links.end(), this->m_SlabForests[k].begin(), this->m_SlabForests[k].end() );
+    links.insert( links.end(), this->m_SlabCrossLinks[k].begin(), this->m_SlabCrossLinks[k].end() );
+    LinkContainerType().swap( this->m_SlabForests[k] );
+    LinkContainerType().swap( this->m_SlabCrossLinks[k] );
+  }
+  
+  const unsigned int numberOfPixels = this->m_Offsets.size();
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+    this->m_Parents[i] = i;
+  
+  std::sort( links.begin(), links.end() );
+  
+  LinkContainerType forest;
+  this->AddForestLinks( links, forest );
+  
+  std::vector<unsigned int>().swap( this->m_Parents );
+  
+  // Adjacency of the forest, each list sorted by pixel
+  this->m_NeighbourStarts.assign( numberOfPixels + 1, 0 );
+  
+  for( unsigned int k=0; k < forest.size(); ++k )
+  {
+    ++this->m_NeighbourStarts[ forest[k].First + 1 ];
+    ++this->m_NeighbourStarts[ forest[k].Second + 1 ];
+  }
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+    this->m_NeighbourStarts[i+1] += this->m_NeighbourStarts[i];
+  
+  this->m_Neighbours.resize( 2 * forest.size() );
+  
+  std::vector<unsigned int> positions( this->m_NeighbourStarts.begin(), this->m_NeighbourStarts.end() - 1 );
+  
+  for( unsigned int k=0; k < forest.size(); ++k )
+  {
+    this->m_Neighbours[ positions[ forest[k].First ]++ ] = forest[k].Second;
+    this->m_Neighbours[ positions[ forest[k].Second ]++ ] = forest[k].First;
+  }
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+  {
+    std::sort( this->m_Neighbours.begin() + this->m_NeighbourStarts[i], 
+      this->m_Neighbours.begin() + this->m_NeighbourStarts[i+1] );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::PruneForest()
+{
+  const unsigned int numberOfPixels = this->m_Offsets.size();
+  
+  this->m_Degrees.resize( numberOfPixels );
+  this->m_Removed.assign( numberOfPixels, 0 );
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+    this->m_Degrees[i] = this->m_NeighbourStarts[i+1] - this->m_NeighbourStarts[i];
+  
+  // Decisions are taken on the links of the forest before pruning
+  std::vector<unsigned int> pixels;
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+  {
+    if( this->m_Degrees[i] == 0 )
+    {
+      this->m_Removed[i] = 1;
+      continue;
+    }
+    
+    if( this->m_Degrees[i] != 1 )
+      continue;
+    
+    // Walk to the first pixel without two links
+    pixels.clear();
+    pixels.push_back( i );
+    
+    unsigned int previous = i;
+    unsigned int current = this->m_Neighbours[ this->m_NeighbourStarts[i] ];
+    
+    while( this->m_Degrees[current] == 2 )
+    {
+      pixels.push_back( current );
+      
+      const unsigned int *neighbours = &this->m_Neighbours[ this->m_NeighbourStarts[current] ];
+      const unsigned int next = ( neighbours[0] != previous ) ? neighbours[0] : neighbours[1];
+      
+      previous = current;
+      current = next;
+    }
+    
+    // Isolated branches are visited from both ends, with the same result
+    if( this->m_Degrees[current] == 1 )
+    {
+      if( pixels.size() + 1 >= this->m_MinimumBranchLength )
+        continue;
+      
+      this->m_Removed[current] = 1;
+    }
+    else if( pixels.size() >= this->m_MinimumBranchLength )
+    {
+      continue;
+    }
+    
+    for( unsigned int k=0; k < pixels.size(); ++k )
+      this->m_Removed[ pixels[k] ] = 1;
+  }
+  
+  // Number of links left
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+  {
+    unsigned int degree = 0;
+    
+    if( !this->m_Removed[i] )
+    {
+      for( unsigned int k = this->m_NeighbourStarts[i]; k < this->m_NeighbourStarts[i+1]; ++k )
+        degree += !this->m_Removed[ this->m_Neighbours[k] ];
+    }
+    
+    this->m_Degrees[i] = degree;
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::BuildGraph()
+{
+  const unsigned int numberOfPixels = this->m_Offsets.size();
+  
+  VesselNode::Pointer rootNode = VesselNode::New();
+  rootNode->SetNodeId( 0 );
+  
+  unsigned int nodeId = 1;
+  
+  this->m_NumberOfBranches = 0;
+  this->m_NumberOfBifurcations = 0;
+  
+  // Terminal pixels already reached from the other end of their tree
+  std::vector<unsigned char> reached( numberOfPixels, 0 );
+  
+  std::deque<PendingBranch> pendingBranches;
+  
+  for( unsigned int i=0; i < numberOfPixels; ++i )
+  {
+    if( this->m_Degrees[i] != 1 || reached[i] )
+      continue;
+    
+    PendingBranch firstBranch;
+    firstBranch.Start = i;
+    firstBranch.Parent = rootNode.GetPointer();
+    
+    for( unsigned int k = this->m_NeighbourStarts[i]; k < this->m_NeighbourStarts[i+1]; ++k )
+    {
+      if( !this->m_Removed[ this->m_Neighbours[k] ] )
+        firstBranch.Next = this->m_Neighbours[k];
+    }
+    
+    pendingBranches.push_back( firstBranch );
+    
+    // Branches of the tree in breadth-first order
+    while( !pendingBranches.empty() )
+    {
+      const PendingBranch pendingBranch = pendingBranches.front();
+      pendingBranches.pop_front();
+      
+      unsigned int previous, end;
+      BranchNodePointer branch = this->BuildBranch( pendingBranch.Start, pendingBranch.Next, previous, end );
+      
+      branch->SetNodeId( nodeId++ );
+      pendingBranch.Parent->AddChild( branch );
+      ++this->m_NumberOfBranches;
+      
+      reached[end] = 1;
+      
+      if( this->m_Degrees[end] < 3 )
+        continue;
+      
+      BifurcationNodePointer bifurcation = BifurcationNodeType::New();
+      bifurcation->SetNodeId( nodeId++ );
+      branch->AddChild( bifurcation );
+      ++this->m_NumberOfBifurcations;
+      
+      for( unsigned int k = this->m_NeighbourStarts[end]; k < this->m_NeighbourStarts[end+1]; ++k )
+      {
+        const unsigned int neighbour = this->m_Neighbours[k];
+        
+        if( this->m_Removed[neighbour] || neighbour == previous )
+          continue;
+        
+        PendingBranch childBranch;
+        childBranch.Start = end;
+        childBranch.Next = neighbour;
+        childBranch.Parent = bifurcation.GetPointer();
+        
+        pendingBranches.push_back( childBranch );
+      }
+    }
+  }
+  
+  this->GetOutput(0)->SetRootNode( rootNode );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+typename SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>::BranchNodePointer
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::BuildBranch( unsigned int start, unsigned int next, unsigned int & previous, unsigned int & end ) const
+{
+  const InputImageType *input = 
+    static_cast<const InputImageType *>( this->itk::ProcessObject::GetInput(0) );
+  const NormalImageType *normals = this->GetNormalImage();
+  const ScaleImageType *scales = this->GetScaleImage();
+  
+  // Pixels of the branch
+  std::vector<unsigned int> pixels;
+  pixels.push_back( start );
+  
+  previous = start;
+  unsigned int current = next;
+  
+  while( true )
+  {
+    pixels.push_back( current );
+    
+    if( this->m_Degrees[current] != 2 )
+      break;
+    
+    unsigned int following = current;
+    
+    for( unsigned int k = this->m_NeighbourStarts[current]; k < this->m_NeighbourStarts[current+1]; ++k )
+    {
+      const unsigned int neighbour = this->m_Neighbours[k];
+      
+      if( !this->m_Removed[neighbour] && neighbour != previous )
+        following = neighbour;
+    }
+    
+    previous = current;
+    current = following;
+  }
+  
+  end = current;
+  
+  std::vector<InputImageIndexType> indices( pixels.size() );
+  std::vector<InputImagePointType> points( pixels.size() );
+  
+  for( unsigned int i=0; i < pixels.size(); ++i )
+  {
+    indices[i] = input->ComputeIndex( this->m_Offsets[ pixels[i] ] );
+    input->TransformIndexToPhysicalPoint( indices[i], points[i] );
+  }
+  
+  BranchNodePointer branch = BranchNodeType::New();
+  typename CenterlineType::Pointer centerline = branch->GetCenterline();
+  
+  for( unsigned int i=0; i < points.size(); ++i )
+  {
+    typename SectionType::Pointer section = SectionType::New();
+    section->SetCenter( points[i] );
+    
+    // Normal of the pixel, oriented along the branch, or the direction of the branch if null
+    const InputImagePointType & previousPoint = points[ i > 0 ? i-1 : i ];
+    const InputImagePointType & nextPoint = points[ i + 1 < points.size() ? i+1 : i ];
+    const NormalPixelType & pixelNormal = normals->GetPixel( indices[i] );
+    
+    typename SectionType::VectorType normal, direction;
+    double normalNorm = 0.0, directionNorm = 0.0, product = 0.0;
+    
+    for( unsigned int d=0; d<InputImageDimension; ++d )
+    {
+      normal[d] = pixelNormal[d];
+      direction[d] = nextPoint[d] - previousPoint[d];
+      normalNorm += normal[d] * normal[d];
+      directionNorm += direction[d] * direction[d];
+      product += normal[d] * direction[d];
+    }
+    
+    if( normalNorm > 0.0 )
+    {
+      const double factor = ( ( product < 0.0 ) ? -1.0 : 1.0 ) / vcl_sqrt( normalNorm );
+      
+      for( unsigned int d=0; d<InputImageDimension; ++d )
+        normal[d] *= factor;
+    }
+    else
+    {
+      for( unsigned int d=0; d<InputImageDimension; ++d )
+        normal[d] = direction[d] / vcl_sqrt( directionNorm );
+    }
+    
+    section->SetNormal( normal );
+    
+    if( scales )
+    {
+      const double scale = scales->GetPixel( indices[i] );
+      section->SetScale( scale );
+      section->SetRadius( scale * this->m_ScaleToRadiusFactor );
+    }
+    
+    centerline->push_back( section );
+  }
+  
+  return branch;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+ITK_THREAD_RETURN_TYPE
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::FindRidgePixelsThreaderCallback( void *arg )
+{
+  int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  
+  Self *filter = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  filter->ThreadedFindRidgePixels( threadId );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+ITK_THREAD_RETURN_TYPE
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::LinkRidgePixelsThreaderCallback( void *arg )
+{
+  int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  
+  Self *filter = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  filter->ThreadedLinkRidgePixels( threadId );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TScalePixel>
+void 
+SkeletonVesselExtractionFilter<TInputImage,TOutputVessel,TScalePixel>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "LowerThreshold: " << this->m_LowerThreshold << std::endl;
+  os << indent << "MinimumBranchLength: " << this->m_MinimumBranchLength << std::endl;
+  os << indent << "ScaleToRadiusFactor: " << this->m_ScaleToRadiusFactor << std::endl;
+  os << indent << "NumberOfRidgePixels: " << this->m_NumberOfRidgePixels << std::endl;
+  os << indent << "NumberOfBranches: " << this->m_NumberOfBranches << std::endl;
+  os << indent << "NumberOfBifurcations: " << this->m_NumberOfBifurcations << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,204 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTemporalVesselTrackerFactory.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: factory that warm starts trackers from the centerlines of a previous phase.
+// Date: 2012/11/05
+
+#ifndef __ivanTemporalVesselTrackerFactory_h
+#define __ivanTemporalVesselTrackerFactory_h
+
+#include "ivanVesselTrackerFactory.h"
+#include "ivanCorridorVesselTrackerEndCondition.h"
+#include "ivanCompositeVesselTrackerEndCondition.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class TemporalVesselTrackerFactory
+ *  \brief Tracker factory that warm starts the trackers of another factory from prior branches.
+ *
+ * This factory creates the trackers with another factory and configures the tracker of seed i 
+ * with the i-th prior branch added, usually a branch tracked in the previous phase of a time 
+ * series and displaced to the current one (see TemporalVesselTrackerFilter). The tracker is 
+ * given the initial direction of the branch, its section estimator the prior centerline, so 
+ * that the search across scales starts at the scales found before (see 
+ * VesselSectionEstimator::SetPriorCenterline()), and its end condition is combined with a 
+ * CorridorVesselTrackerEndCondition around the prior branch. Seeds without a prior branch are
+ * left as created.
+ *
+ * \sa TemporalVesselTrackerFilter
+ */
+
+template <class TInputImage, class TOutputVessel>
+class ITK_EXPORT TemporalVesselTrackerFactory : 
+  public VesselTrackerFactory<TInputImage,TOutputVessel>
+{
+public:
+  
+  typedef TemporalVesselTrackerFactory                     Self;
+  typedef VesselTrackerFactory<TInputImage,TOutputVessel>  Superclass;
+  typedef itk::SmartPointer<Self>                          Pointer;
+  typedef itk::SmartPointer<const Self>                    ConstPointer;
+  
+  typedef typename Superclass::TrackerType                 TrackerType;
+  typedef typename Superclass::TrackerPointer              TrackerPointer;
+  typedef typename TrackerType::DirectionType              DirectionType;
+  typedef typename TrackerType::CenterlineType             CenterlineType;
+  typedef typename TrackerType::BranchNodeType             BranchNodeType;
+  
+  typedef CorridorVesselTrackerEndCondition<CenterlineType>   CorridorEndConditionType;
+  typedef typename CorridorEndConditionType::SpatialIndexType SpatialIndexType;
+  typedef typename SpatialIndexType::Pointer                  SpatialIndexPointer;
+  
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TemporalVesselTrackerFactory, VesselTrackerFactory );
+  
+  /** Set/Get the factory that creates the trackers. */
+  itkSetObjectMacro( TrackerFactory, Superclass );
+  itkGetObjectMacro( TrackerFactory, Superclass );
+  
+  /** Add the prior branch of the next seed and the direction to track it. The branch is 
+    * indexed for the corridor, so its sections must not be modified afterwards. */
+  void AddPriorBranch( const BranchNodeType *branch, const DirectionType & direction )
+    {
+      SpatialIndexPointer spatialIndex = SpatialIndexType::New();
+      spatialIndex->AppendSections( branch );
+      spatialIndex->Update();
+      
+      PriorBranch prior;
+      prior.Branch = branch;
+      prior.Direction = direction;
+      prior.SpatialIndex = spatialIndex;
+      
+      m_PriorBranches.push_back( prior );
+      this->Modified();
+    }
+  
+  void ClearPriorBranches()
+    { 
+      m_PriorBranches.clear();
+      this->Modified();
+    }
+  
+  unsigned int GetNumberOfPriorBranches() const
+    { return m_PriorBranches.size(); }
+  
+  /** Set/Get the distance to the surface of the prior branch beyond which tracking finishes. 
+    * If not positive, no corridor is used. Default is 2.0. */
+  itkSetMacro( CorridorDistance, double );
+  itkGetConstMacro( CorridorDistance, double );
+  
+  /** Flag for giving the prior centerline to the section estimators. Default is true. */
+  itkSetMacro( UsePriorScales, bool );
+  itkGetConstMacro( UsePriorScales, bool );
+  itkBooleanMacro( UsePriorScales );
+  
+  virtual TrackerPointer CreateTracker( unsigned int seed )
+    {
+      if( m_TrackerFactory.IsNull() )
+        itkExceptionMacro( "A tracker factory must be set." );
+      
+      TrackerPointer tracker = m_TrackerFactory->CreateTracker( seed );
+      
+      if( tracker.IsNull() || seed >= m_PriorBranches.size() )
+        return tracker;
+      
+      const PriorBranch & prior = m_PriorBranches[seed];
+      
+      tracker->SetInitialDirection( prior.Direction );
+      
+      if( m_UsePriorScales && tracker->GetSectionEstimator() )
+        tracker->GetSectionEstimator()->SetPriorCenterline( prior.Branch->GetCenterline() );
+      
+      if( m_CorridorDistance > 0.0 )
+      {
+        typename CorridorEndConditionType::Pointer corridor = CorridorEndConditionType::New();
+        corridor->SetSpatialIndex( prior.SpatialIndex );
+        corridor->SetCorridorDistance( m_CorridorDistance );
+        
+        CompositeVesselTrackerEndCondition::Pointer endCondition = 
+          CompositeVesselTrackerEndCondition::New();
+        endCondition->AddEndCondition( tracker->GetEndCondition() );
+        endCondition->AddEndCondition( corridor );
+        
+        tracker->SetEndCondition( endCondition );
+      }
+      
+      return tracker;
+    }
+
+protected:
+  
+  TemporalVesselTrackerFactory() :
+    m_CorridorDistance( 2.0 ),
+    m_UsePriorScales( true )
+    {}
+  virtual ~TemporalVesselTrackerFactory() {}
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const
+    {
+      Superclass::PrintSelf( os, indent );
+      
+      os << indent << "TrackerFactory: " << m_TrackerFactory.GetPointer() << std::endl;
+      os << indent << "NumberOfPriorBranches: " << m_PriorBranches.size() << std::endl;
+      os << indent << "CorridorDistance: " << m_CorridorDistance << std::endl;
+      os << indent << "UsePriorScales: " << m_UsePriorScales << std::endl;
+    }
+      
+private:
+  
+  TemporalVesselTrackerFactory(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  /** Prior branch of a seed, with the index of its corridor. */
+  struct PriorBranch
+  {
+    typename BranchNodeType::ConstPointer   Branch;
+    DirectionType                           Direction;
+    SpatialIndexPointer                     SpatialIndex;
+  };
+  
+  typename Superclass::Pointer    m_TrackerFactory;
+  
+  std::vector<PriorBranch>        m_PriorBranches;
+  
+  double                          m_CorridorDistance;
+  bool                            m_UsePriorScales;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,197 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTemporalVesselTrackerFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks the vessels of a phase of a time series from those of the previous one.
+// Date: 2012/11/05
+
+#ifndef __ivanTemporalVesselTrackerFilter_h
+#define __ivanTemporalVesselTrackerFilter_h
+
+#include "ivanImageToVesselDataObjectFilter.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanTemporalVesselTrackerFactory.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class TemporalVesselTrackerFilter
+ * \brief Tracks the vessels of one phase of a time series warm started from the previous phase.
+ *
+ * In cardiac-gated or perfusion series the same vessels are tracked in every phase. This filter
+ * tracks the input, the current phase, from the branches of PreviousVesselGraph, the branches 
+ * tracked in the previous phase. Each previous branch is first displaced with a cheap local 
+ * registration: the translation, within RegistrationRadius, that maximizes the mean input 
+ * intensity at the displaced section centers, searched exhaustively on a grid with the smallest
+ * input spacing. Vessels are assumed brighter than the background, as by the section 
+ * estimators. Then each displaced branch gives a seed at its first section, tracked along 
+ * the branch, and the trackers are configured by a TemporalVesselTrackerFactory: the section 
+ * estimators start their search across scales at the previous scales and tracking stops when 
+ * leaving a corridor of CorridorDistance around the displaced branch.
+ *
+ * The branches are tracked concurrently by a MultiSeedVesselTrackerFilter with the trackers of 
+ * TrackerFactory. The output has the same layout, a root VesselNode with id 0 and one 
+ * VesselBranchNode per previous branch, in depth-first order of the previous graph and with 
+ * id equal to its position plus one. The previous graph is not modified. To track a whole 
+ * series, track the first phase in any other way and then update this filter for every phase
+ * with the output of the previous one, disconnected from the pipeline.
+ *
+ * \sa TemporalVesselTrackerFactory
+ * \sa MultiSeedVesselTrackerFilter
+ */
+
+template <class TInputImage, class TOutputVessel>
+class ITK_EXPORT TemporalVesselTrackerFilter : 
+  public ImageToVesselDataObjectFilter<TInputImage,TOutputVessel>
+{
+public:
+	
+  /** Standard class typedefs. */
+  typedef TemporalVesselTrackerFilter
+    <TInputImage, TOutputVessel>          Self;
+  typedef ImageToVesselDataObjectFilter
+    <TInputImage,TOutputVessel>           Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Image-related typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::Pointer        InputImagePointer;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::PointType      InputImagePointType;
+  	
+  /** Vessel-related typedefs. */
+  typedef TOutputVessel                              OutputVesselType;
+  typedef typename OutputVesselType::Pointer         OutputVesselPointer;
+  typedef typename OutputVesselType::ConstPointer    OutputVesselConstPointer;
+  typedef typename OutputVesselType::CenterlineType  CenterlineType;
+  typedef typename CenterlineType::SectionType       SectionType;
+    
+  typedef VesselBranchNode<CenterlineType>           BranchNodeType;
+  typedef typename BranchNodeType::Pointer           BranchNodePointer;
+  
+  /** Tracker-related typedefs. */
+  typedef MultiSeedVesselTrackerFilter
+    <TInputImage,TOutputVessel>                      MultiSeedTrackerType;
+  typedef typename MultiSeedTrackerType::TrackerFactoryType  
+                                                     TrackerFactoryType;
+  typedef typename TrackerFactoryType::Pointer       TrackerFactoryPointer;
+  typedef TemporalVesselTrackerFactory
+    <TInputImage,TOutputVessel>                      TemporalTrackerFactoryType;
+  typedef typename TemporalTrackerFactoryType::DirectionType  DirectionType;
+  
+  typedef itk::Vector<double,
+    TInputImage::ImageDimension>                     DisplacementType;
+    
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  
+public:
+  
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TemporalVesselTrackerFilter, ImageToVesselDataObjectFilter );
+  
+  /** Set/Get the factory that creates the tracker of each branch. */
+  itkSetObjectMacro( TrackerFactory, TrackerFactoryType );
+  itkGetObjectMacro( TrackerFactory, TrackerFactoryType );
+  
+  /** Set/Get the graph tracked in the previous phase. */
+  itkSetConstObjectMacro( PreviousVesselGraph, OutputVesselType );
+  itkGetConstObjectMacro( PreviousVesselGraph, OutputVesselType );
+  
+  /** Set/Get the maximum displacement of a branch between phases, in physical units. If zero, 
+    * the branches are not registered. Default is 2.0. */
+  itkSetMacro( RegistrationRadius, double );
+  itkGetConstMacro( RegistrationRadius, double );
+  
+  /** Set/Get the distance to the surface of the displaced branch beyond which tracking 
+    * finishes. If not positive, no corridor is used. Default is 2.0. */
+  itkSetMacro( CorridorDistance, double );
+  itkGetConstMacro( CorridorDistance, double );
+  
+  /** Flag for starting the search across scales at the scales of the previous phase. Default 
+    * is true. */
+  itkSetMacro( UsePriorScales, bool );
+  itkGetConstMacro( UsePriorScales, bool );
+  itkBooleanMacro( UsePriorScales );
+  
+  /** Get the number of branches of the previous phase tracked in the last update. */
+  unsigned int GetNumberOfPriorBranches() const
+    { return m_Displacements.size(); }
+  
+  /** Get the displacement found for the given branch in the last update. */
+  const DisplacementType & GetBranchDisplacement( unsigned int branch ) const
+    { return m_Displacements[branch]; }
+  
+protected:
+  
+  TemporalVesselTrackerFilter();
+  ~TemporalVesselTrackerFilter() {}
+  
+  virtual void GenerateData();
+  
+  /** Add the branches under the given node of the previous graph, in depth-first order. */
+  void CollectPriorBranches( const GraphNode *node, std::vector<const BranchNodeType*> & branches );
+  
+  /** Find the translation of the given centerline that best fits the input. */
+  DisplacementType EstimateDisplacement( const CenterlineType *centerline ) const;
+  
+  /** Create a branch with copies of the sections of the given one, translated. */
+  BranchNodePointer CreateDisplacedBranch( const BranchNodeType *branch, 
+    const DisplacementType & displacement ) const;
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  TemporalVesselTrackerFilter(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+
+  TrackerFactoryPointer         m_TrackerFactory;
+  OutputVesselConstPointer      m_PreviousVesselGraph;
+  
+  double                        m_RegistrationRadius;
+  double                        m_CorridorDistance;
+  bool                          m_UsePriorScales;
+  
+  std::vector<DisplacementType> m_Displacements;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanTemporalVesselTrackerFilter.hxx"
+#endif
+
+#endif
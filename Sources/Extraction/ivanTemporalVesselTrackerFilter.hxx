@@ -0,0 +1,299 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTemporalVesselTrackerFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks the vessels of a phase of a time series from those of the previous one.
+// Date: 2012/11/05
+
+#ifndef __ivanTemporalVesselTrackerFilter_hxx
+#define __ivanTemporalVesselTrackerFilter_hxx
+
+#include "ivanTemporalVesselTrackerFilter.h"
+
+#include "itkLinearInterpolateImageFunction.h"
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+namespace ivan
+{
+  
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::TemporalVesselTrackerFilter() :
+  m_RegistrationRadius( 2.0 ),
+  m_CorridorDistance( 2.0 ),
+  m_UsePriorScales( true )
+{
+  
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::GenerateData()
+{
+  if( this->m_TrackerFactory.IsNull() )
+    itkExceptionMacro( "A tracker factory must be set." );
+  
+  if( this->m_PreviousVesselGraph.IsNull() )
+    itkExceptionMacro( "The vessel graph of the previous phase must be set." );
+  
+  OutputVesselPointer outputGraph = this->GetOutput(0);
+  
+  std::vector<const BranchNodeType*> priorBranches;
+  
+  if( this->m_PreviousVesselGraph->GetRootNode().IsNotNull() )
+    this->CollectPriorBranches( this->m_PreviousVesselGraph->GetRootNode(), priorBranches );
+  
+  this->m_Displacements.clear();
+  
+  if( priorBranches.empty() )
+  {
+    VesselNode::Pointer rootNode = VesselNode::New();
+    rootNode->SetNodeId( 0 );
+    outputGraph->SetRootNode( rootNode );
+    
+    itkWarningMacro( "The previous graph has no branches. Output graph has no branches." );
+    return;
+  }
+  
+  typename TemporalTrackerFactoryType::Pointer factory = TemporalTrackerFactoryType::New();
+  factory->SetTrackerFactory( this->m_TrackerFactory );
+  factory->SetCorridorDistance( this->m_CorridorDistance );
+  factory->SetUsePriorScales( this->m_UsePriorScales );
+  
+  typename MultiSeedTrackerType::Pointer tracker = MultiSeedTrackerType::New();
+  tracker->SetInput( this->GetInput() );
+  tracker->SetTrackerFactory( factory );
+  tracker->SetNumberOfThreads( this->GetNumberOfThreads() );
+  
+  for( unsigned int i=0; i < priorBranches.size(); ++i )
+  {
+    const DisplacementType displacement = 
+      this->EstimateDisplacement( priorBranches[i]->GetCenterline() );
+    
+    this->m_Displacements.push_back( displacement );
+    
+    BranchNodePointer displacedBranch = this->CreateDisplacedBranch( priorBranches[i], displacement );
+    const CenterlineType *centerline = displacedBranch->GetCenterline();
+    
+    // Track from the first section along the branch
+    InputImagePointType seed;
+    DirectionType direction;
+    double dotProduct = 0.0;
+    
+    for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+    {
+      seed[dim] = centerline->at(0)->GetCenter()[dim];
+      direction[dim] = centerline->at(0)->GetNormal()[dim];
+      
+      if( centerline->size() > 1 )
+        dotProduct += direction[dim] * ( centerline->at(1)->GetCenter()[dim] - seed[dim] );
+    }
+    
+    if( dotProduct < 0.0 )
+      direction = -direction;
+    
+    factory->AddPriorBranch( displacedBranch, direction );
+    tracker->AddSeed( seed );
+  }
+  
+  tracker->Update();
+  
+  outputGraph->SetRootNode( tracker->GetOutput()->GetRootNode() );
+  
+  itkDebugMacro( "Tracked " << priorBranches.size() << " branches of the previous phase" );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::CollectPriorBranches( const GraphNode *node, std::vector<const BranchNodeType*> & branches )
+{
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+  
+  if( branch && !branch->GetCenterline()->empty() )
+    branches.push_back( branch );
+  
+  for( unsigned int i=0; i < node->GetNumberOfChildren(); ++i )
+    this->CollectPriorBranches( node->GetChild(i), branches );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename TemporalVesselTrackerFilter<TInputImage,TOutputVessel>::DisplacementType
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::EstimateDisplacement( const CenterlineType *centerline ) const
+{
+  DisplacementType bestDisplacement;
+  bestDisplacement.Fill( 0.0 );
+  
+  const InputImageType *input = this->GetInput();
+  
+  if( this->m_RegistrationRadius <= 0.0 || centerline->empty() )
+    return bestDisplacement;
+  
+  typedef itk::LinearInterpolateImageFunction<InputImageType,double>  InterpolatorType;
+  
+  typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( input );
+  
+  double step = input->GetSpacing()[0];
+  
+  for( unsigned int dim=1; dim < InputImageDimension; ++dim )
+    step = vnl_math_min( step, (double)input->GetSpacing()[dim] );
+  
+  const int numberOfSteps = (int)std::floor( this->m_RegistrationRadius / step );
+  const unsigned long width = 2 * numberOfSteps + 1;
+  
+  unsigned long numberOfOffsets = 1;
+  for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+    numberOfOffsets *= width;
+  
+  const double squaredRadius = this->m_RegistrationRadius * this->m_RegistrationRadius;
+  
+  double bestMetric = itk::NumericTraits<double>::NonpositiveMin();
+  double bestSquaredNorm = 0.0;
+  
+  // Exhaustive search of the translation with the largest mean intensity at the displaced 
+  // centers, preferring the smallest one in case of ties
+  for( unsigned long k=0; k < numberOfOffsets; ++k )
+  {
+    DisplacementType displacement;
+    double squaredNorm = 0.0;
+    unsigned long code = k;
+    
+    for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+    {
+      displacement[dim] = step * ( (int)( code % width ) - numberOfSteps );
+      squaredNorm += displacement[dim] * displacement[dim];
+      code /= width;
+    }
+    
+    if( squaredNorm > squaredRadius )
+      continue;
+    
+    double sum = 0.0;
+    unsigned int count = 0;
+    
+    for( unsigned int i=0; i < centerline->size(); ++i )
+    {
+      InputImagePointType point;
+      
+      for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+        point[dim] = centerline->at(i)->GetCenter()[dim] + displacement[dim];
+      
+      if( interpolator->IsInsideBuffer( point ) )
+      {
+        sum += interpolator->Evaluate( point );
+        ++count;
+      }
+    }
+    
+    if( !count )
+      continue;
+    
+    const double metric = sum / count;
+    
+    if( metric > bestMetric || ( metric == bestMetric && squaredNorm < bestSquaredNorm ) )
+    {
+      bestMetric = metric;
+      bestSquaredNorm = squaredNorm;
+      bestDisplacement = displacement;
+    }
+  }
+  
+  return bestDisplacement;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename TemporalVesselTrackerFilter<TInputImage,TOutputVessel>::BranchNodePointer
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::CreateDisplacedBranch( const BranchNodeType *branch, const DisplacementType & displacement ) const
+{
+  BranchNodePointer displacedBranch = BranchNodeType::New();
+  displacedBranch->SetNodeId( branch->GetNodeId() );
+  
+  typename CenterlineType::ConstPointer centerline = branch->GetCenterline();
+  typename CenterlineType::Pointer displacedCenterline = displacedBranch->GetCenterline();
+  
+  for( unsigned int i=0; i < centerline->size(); ++i )
+  {
+    typename SectionType::Pointer section = SectionType::New();
+    section->DeepCopy( centerline->at(i) );
+    
+    typename SectionType::PointType center = section->GetCenter();
+    
+    for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+      center[dim] += displacement[dim];
+    
+    section->SetCenter( center );
+    displacedCenterline->push_back( section );
+  }
+  
+  return displacedBranch;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void 
+TemporalVesselTrackerFilter<TInputImage,TOutputVessel>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "TrackerFactory: " << this->m_TrackerFactory.GetPointer() << std::endl;
+  os << indent << "PreviousVesselGraph: " << this->m_PreviousVesselGraph.GetPointer() << std::endl;
+  os << indent << "RegistrationRadius: " << this->m_RegistrationRadius << std::endl;
+  os << indent << "CorridorDistance: " << this->m_CorridorDistance << std::endl;
+  os << indent << "UsePriorScales: " << this->m_UsePriorScales << std::endl;
+  os << indent << "NumberOfPriorBranches: " << this->m_Displacements.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
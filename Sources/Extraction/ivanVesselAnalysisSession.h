@@ -0,0 +1,263 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselAnalysisSession.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image of a study with the cached data shared by repeated analysis requests
+// Date: 2012/11/05
+
+#ifndef __ivanVesselAnalysisSession_h
+#define __ivanVesselAnalysisSession_h
+
+#include "ivanScaleSpacePyramid.h"
+#include "ivanScaledImageFunctionCache.h"
+#include "ivanVesselCenterlineSpatialIndex.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkHessianRecursiveGaussianImageFilter.h"
+#include "itkGradientRecursiveGaussianImageFilter.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkMutexLock.h"
+
+#include <map>
+#include <string>
+#include <typeinfo>
+
+
+namespace ivan
+{
+  
+/** \class VesselAnalysisSession
+ *  \brief Holds an image and the data that several detection and tracking requests on it share.
+ *
+ * A service that runs many requests (different seeds, parameters or vessel types) against the 
+ * same loaded study would otherwise compute the same scale-space data for each of them. The 
+ * session keeps the image together with data built lazily the first time it is requested:
+ *
+ * - Hessian and gradient images at given scales, computed with the recursive Gaussian filters 
+ * for the whole image. They are kept within MemoryBudget, evicting the least recently used
+ * ones.
+ * - A ScaleSpacePyramid of the image, for the evaluation of large scales.
+ * - Shared objects created by name, such as the ScaledImageFunctionCache of a multiscale 
+ * estimator (which holds the initialized functions and their kernel tables), or the 
+ * DiscreteDerivativeCache of the vesselness functions. GetScaledImageFunctionCache() names the 
+ * cache after the function type. Objects must only be shared by requests that use the same 
+ * parameters other than the scale, see ScaledImageFunctionCache.
+ * - A VesselCenterlineSpatialIndex of the vessels tracked so far, with the mutex to give to 
+ * CollisionVesselTrackerEndCondition when trackers run concurrently.
+ *
+ * Requests are given the session data instead of the raw image. For example, a multiscale 
+ * section estimator is given GetImage() and GetScaledImageFunctionCache(), and the initializers
+ * of the scale-space functions are given GetPyramid().
+ * Setting another image releases all the data. All methods can be called from several threads,
+ * and a derivative image is computed only once even if requested concurrently, although other
+ * requests wait meanwhile.
+ *
+ * \sa ScaleSpacePyramid
+ * \sa ScaledImageFunctionCache
+ * \sa VesselCenterlineSpatialIndex
+ */
+template <class TImage, class TCenterline>
+class ITK_EXPORT VesselAnalysisSession : public itk::Object
+{
+public:
+  
+  typedef VesselAnalysisSession            Self;
+  typedef itk::Object                      Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+  
+  typedef TImage                           ImageType;
+  typedef typename ImageType::ConstPointer ImageConstPointer;
+  
+  typedef TCenterline                      CenterlineType;
+  
+  typedef itk::HessianRecursiveGaussianImageFilter<ImageType>     HessianFilterType;
+  typedef typename HessianFilterType::OutputImageType             HessianImageType;
+  typedef typename HessianImageType::ConstPointer                 HessianImageConstPointer;
+  
+  typedef itk::GradientRecursiveGaussianImageFilter<ImageType>    GradientFilterType;
+  typedef typename GradientFilterType::OutputImageType            GradientImageType;
+  typedef typename GradientImageType::ConstPointer                GradientImageConstPointer;
+  
+  typedef ScaleSpacePyramid<ImageType>                            PyramidType;
+  typedef typename PyramidType::Pointer                           PyramidPointer;
+  
+  typedef VesselCenterlineSpatialIndex<CenterlineType>            SpatialIndexType;
+  typedef typename SpatialIndexType::Pointer                      SpatialIndexPointer;
+  
+public:
+  
+  itkNewMacro( Self );
+  itkTypeMacro( VesselAnalysisSession, itk::Object );
+  
+  /** Set/Get the image of the session. Setting another image releases all the cached data. */
+  virtual void SetImage( const ImageType *image );
+  const ImageType * GetImage() const
+    { return this->m_Image.GetPointer(); }
+  
+  /** Set/Get if the derivative images are normalized across scale. Changing it releases the
+    * derivative images. Default is true. */
+  virtual void SetNormalizeAcrossScale( bool normalize );
+  itkGetConstMacro( NormalizeAcrossScale, bool );
+  itkBooleanMacro( NormalizeAcrossScale );
+  
+  /** Set/Get the memory in bytes that the derivative images and the pyramid may use. When 
+    * exceeded, the least recently used derivative images are released, but the last requested 
+    * one is always kept. Zero means no limit, which is the default. */
+  virtual void SetMemoryBudget( unsigned long budget );
+  itkGetConstMacro( MemoryBudget, unsigned long );
+  
+  /** Hessian and gradient images at the given scale, computed the first time they are 
+    * requested. The returned pointers keep the images alive even if evicted later. */
+  HessianImageConstPointer GetHessianImage( double scale );
+  GradientImageConstPointer GetGradientImage( double scale );
+  
+  /** Number of derivative images kept. */
+  unsigned long GetNumberOfDerivativeImages() const;
+  
+  /** Number of derivative images requested that were already computed, and that had to be 
+    * computed, since the image was set. */
+  itkGetConstMacro( NumberOfHits, unsigned long );
+  itkGetConstMacro( NumberOfMisses, unsigned long );
+  
+  /** Scale-space pyramid of the image, created the first time it is requested. */
+  PyramidType * GetPyramid();
+  
+  /** Spatial index of the vessels tracked on the image, created the first time it is 
+    * requested, and the mutex that concurrent trackers must use to access it. */
+  SpatialIndexType * GetSpatialIndex();
+  itk::MutexLock * GetSpatialIndexMutex()
+    { return this->m_SpatialIndexMutex.GetPointer(); }
+  
+  /** Get the shared object of the given name, created with TObject::New() the first time. 
+    * Throws an exception if an object of another type was stored with that name. */
+  template <class TObject>
+  TObject * GetSharedObject( const std::string & name )
+    {
+      this->m_Mutex.Lock();
+      
+      itk::Object::Pointer & stored = this->m_SharedObjects[name];
+      
+      if( stored.IsNull() )
+      {
+        typename TObject::Pointer object = TObject::New();
+        stored = object.GetPointer();
+      }
+      
+      TObject *object = dynamic_cast<TObject *>( stored.GetPointer() );
+      const std::string storedClass = stored->GetNameOfClass();
+      
+      this->m_Mutex.Unlock();
+      
+      if( !object )
+      {
+        itkExceptionMacro( "Shared object " << name << " is a " << storedClass );
+      }
+      
+      return object;
+    }
+  
+  /** Cache shared by the multiscale objects that use the given scaled image function type. */
+  template <class TScaledImageFunction>
+  ScaledImageFunctionCache<TScaledImageFunction> * GetScaledImageFunctionCache()
+    {
+      return this->template GetSharedObject< ScaledImageFunctionCache<TScaledImageFunction> >( 
+        typeid( TScaledImageFunction ).name() );
+    }
+  
+  unsigned long GetNumberOfSharedObjects() const;
+  
+  /** Release the derivative images, the pyramid levels and the shared objects. The spatial 
+    * index is kept, since it is not computed from the image. */
+  void ReleaseCachedData();
+  
+  /** Memory in bytes of the derivative images and the pyramid levels. */
+  unsigned long GetMemorySize() const;
+  
+protected:
+  
+  VesselAnalysisSession();
+  virtual ~VesselAnalysisSession() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Derivative image at a scale, with the time of its last request. */
+  struct DerivativeImageEntry
+  {
+    itk::DataObject::Pointer  Image;
+    unsigned long             MemorySize;
+    unsigned long             LastUse;
+  };
+  
+  typedef std::map<double,DerivativeImageEntry>           DerivativeImageContainerType;
+  typedef std::map<std::string,itk::Object::Pointer>      SharedObjectContainerType;
+  
+  /** Find the image of the scale in the container, or compute it with the filter type given. 
+    * The mutex must be locked by the caller, and it is unlocked if an exception is thrown. */
+  template <class TFilter>
+  itk::DataObject * GetDerivativeImage( DerivativeImageContainerType & images, double scale );
+  
+  /** Release the least recently used derivative images, other than the one given, until the 
+    * budget is met. The mutex must be locked by the caller. */
+  void EnforceMemoryBudget( const itk::DataObject *kept );
+  
+  /** Memory of the derivative images and the pyramid. The mutex must be locked by the caller. */
+  unsigned long ComputeMemorySize() const;
+  
+private:
+  
+  VesselAnalysisSession(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented  
+  
+  ImageConstPointer               m_Image;
+  
+  bool                            m_NormalizeAcrossScale;
+  unsigned long                   m_MemoryBudget;
+  
+  DerivativeImageContainerType    m_HessianImages;
+  DerivativeImageContainerType    m_GradientImages;
+  
+  /** Counter of requests for the least recently used eviction. */
+  unsigned long                   m_UseCounter;
+  unsigned long                   m_NumberOfHits;
+  unsigned long                   m_NumberOfMisses;
+  
+  PyramidPointer                  m_Pyramid;
+  SpatialIndexPointer             m_SpatialIndex;
+  itk::MutexLock::Pointer         m_SpatialIndexMutex;
+  
+  SharedObjectContainerType       m_SharedObjects;
+  
+  mutable itk::SimpleFastMutexLock    m_Mutex;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanVesselAnalysisSession.hxx"
+#endif
+
+#endif
@@ -0,0 +1,375 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselAnalysisSession.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image of a study with the cached data shared by repeated analysis requests
+// Date: 2012/11/05
+
+#ifndef __ivanVesselAnalysisSession_hxx
+#define __ivanVesselAnalysisSession_hxx
+
+#include "ivanVesselAnalysisSession.h"
+
+
+namespace ivan
+{
+
+template <class TImage, class TCenterline>
+VesselAnalysisSession<TImage,TCenterline>
+::VesselAnalysisSession() :
+  m_NormalizeAcrossScale( true ),
+  m_MemoryBudget( 0 ),
+  m_UseCounter( 0 ),
+  m_NumberOfHits( 0 ),
+  m_NumberOfMisses( 0 )
+{
+  this->m_SpatialIndexMutex = itk::MutexLock::New();
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::SetImage( const ImageType *image )
+{
+  if( this->m_Image == image )
+    return;
+  
+  this->ReleaseCachedData();
+  
+  this->m_Mutex.Lock();
+  
+  this->m_Image = image;
+  this->m_SpatialIndex = 0;
+  this->m_NumberOfHits = 0;
+  this->m_NumberOfMisses = 0;
+  
+  this->m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::SetNormalizeAcrossScale( bool normalize )
+{
+  if( this->m_NormalizeAcrossScale == normalize )
+    return;
+  
+  this->m_Mutex.Lock();
+  
+  this->m_NormalizeAcrossScale = normalize;
+  this->m_HessianImages.clear();
+  this->m_GradientImages.clear();
+  
+  this->m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::SetMemoryBudget( unsigned long budget )
+{
+  if( this->m_MemoryBudget == budget )
+    return;
+  
+  this->m_Mutex.Lock();
+  
+  this->m_MemoryBudget = budget;
+  this->EnforceMemoryBudget( 0 );
+  
+  this->m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TImage, class TCenterline>
+typename VesselAnalysisSession<TImage,TCenterline>::HessianImageConstPointer
+VesselAnalysisSession<TImage,TCenterline>
+::GetHessianImage( double scale )
+{
+  this->m_Mutex.Lock();
+  
+  HessianImageConstPointer image = static_cast<const HessianImageType *>( 
+    this->template GetDerivativeImage<HessianFilterType>( this->m_HessianImages, scale ) );
+  
+  this->m_Mutex.Unlock();
+  
+  return image;
+}
+
+
+template <class TImage, class TCenterline>
+typename VesselAnalysisSession<TImage,TCenterline>::GradientImageConstPointer
+VesselAnalysisSession<TImage,TCenterline>
+::GetGradientImage( double scale )
+{
+  this->m_Mutex.Lock();
+  
+  GradientImageConstPointer image = static_cast<const GradientImageType *>( 
+    this->template GetDerivativeImage<GradientFilterType>( this->m_GradientImages, scale ) );
+  
+  this->m_Mutex.Unlock();
+  
+  return image;
+}
+
+
+template <class TImage, class TCenterline>
+template <class TFilter>
+itk::DataObject *
+VesselAnalysisSession<TImage,TCenterline>
+::GetDerivativeImage( DerivativeImageContainerType & images, double scale )
+{
+  if( this->m_Image.IsNull() )
+  {
+    this->m_Mutex.Unlock();
+    itkExceptionMacro( "No image set in the session" );
+  }
+  
+  typename DerivativeImageContainerType::iterator it = images.find( scale );
+  
+  if( it != images.end() )
+  {
+    ++this->m_NumberOfHits;
+    it->second.LastUse = ++this->m_UseCounter;
+    return it->second.Image.GetPointer();
+  }
+  
+  ++this->m_NumberOfMisses;
+  
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( this->m_Image );
+  filter->SetSigma( scale );
+  filter->SetNormalizeAcrossScale( this->m_NormalizeAcrossScale );
+  
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    this->m_Mutex.Unlock();
+    throw;
+  }
+  
+  typename TFilter::OutputImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  
+  DerivativeImageEntry entry;
+  entry.Image = output.GetPointer();
+  entry.MemorySize = output->GetBufferedRegion().GetNumberOfPixels() * 
+    sizeof( typename TFilter::OutputImageType::PixelType );
+  entry.LastUse = ++this->m_UseCounter;
+  
+  images[scale] = entry;
+  
+  this->EnforceMemoryBudget( output );
+  
+  return output.GetPointer();
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::EnforceMemoryBudget( const itk::DataObject *kept )
+{
+  if( !this->m_MemoryBudget )
+    return;
+  
+  while( this->ComputeMemorySize() > this->m_MemoryBudget )
+  {
+    // Least recently used image of both containers
+    DerivativeImageContainerType *oldestContainer = 0;
+    typename DerivativeImageContainerType::iterator oldest;
+    
+    DerivativeImageContainerType *containers[2] = { &this->m_HessianImages, &this->m_GradientImages };
+    
+    for( unsigned int c=0; c<2; ++c )
+    {
+      for( typename DerivativeImageContainerType::iterator it = containers[c]->begin(); 
+        it != containers[c]->end(); ++it )
+      {
+        if( it->second.Image.GetPointer() == kept )
+          continue;
+        
+        if( !oldestContainer || it->second.LastUse < oldest->second.LastUse )
+        {
+          oldestContainer = containers[c];
+          oldest = it;
+        }
+      }
+    }
+    
+    if( !oldestContainer )
+      break;
+    
+    oldestContainer->erase( oldest );
+  }
+}
+
+
+template <class TImage, class TCenterline>
+unsigned long
+VesselAnalysisSession<TImage,TCenterline>
+::GetNumberOfDerivativeImages() const
+{
+  this->m_Mutex.Lock();
+  const unsigned long number = this->m_HessianImages.size() + this->m_GradientImages.size();
+  this->m_Mutex.Unlock();
+  
+  return number;
+}
+
+
+template <class TImage, class TCenterline>
+typename VesselAnalysisSession<TImage,TCenterline>::PyramidType *
+VesselAnalysisSession<TImage,TCenterline>
+::GetPyramid()
+{
+  this->m_Mutex.Lock();
+  
+  if( this->m_Pyramid.IsNull() )
+  {
+    this->m_Pyramid = PyramidType::New();
+    this->m_Pyramid->SetInput( this->m_Image );
+  }
+  
+  PyramidType *pyramid = this->m_Pyramid.GetPointer();
+  
+  this->m_Mutex.Unlock();
+  
+  return pyramid;
+}
+
+
+template <class TImage, class TCenterline>
+typename VesselAnalysisSession<TImage,TCenterline>::SpatialIndexType *
+VesselAnalysisSession<TImage,TCenterline>
+::GetSpatialIndex()
+{
+  this->m_Mutex.Lock();
+  
+  if( this->m_SpatialIndex.IsNull() )
+    this->m_SpatialIndex = SpatialIndexType::New();
+  
+  SpatialIndexType *index = this->m_SpatialIndex.GetPointer();
+  
+  this->m_Mutex.Unlock();
+  
+  return index;
+}
+
+
+template <class TImage, class TCenterline>
+unsigned long
+VesselAnalysisSession<TImage,TCenterline>
+::GetNumberOfSharedObjects() const
+{
+  this->m_Mutex.Lock();
+  const unsigned long number = this->m_SharedObjects.size();
+  this->m_Mutex.Unlock();
+  
+  return number;
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::ReleaseCachedData()
+{
+  this->m_Mutex.Lock();
+  
+  this->m_HessianImages.clear();
+  this->m_GradientImages.clear();
+  this->m_SharedObjects.clear();
+  this->m_Pyramid = 0;
+  
+  this->m_Mutex.Unlock();
+}
+
+
+template <class TImage, class TCenterline>
+unsigned long
+VesselAnalysisSession<TImage,TCenterline>
+::GetMemorySize() const
+{
+  this->m_Mutex.Lock();
+  const unsigned long size = this->ComputeMemorySize();
+  this->m_Mutex.Unlock();
+  
+  return size;
+}
+
+
+template <class TImage, class TCenterline>
+unsigned long
+VesselAnalysisSession<TImage,TCenterline>
+::ComputeMemorySize() const
+{
+  unsigned long size = ( this->m_Pyramid.IsNotNull() )? this->m_Pyramid->GetMemorySize() : 0;
+  
+  typename DerivativeImageContainerType::const_iterator it;
+  
+  for( it = this->m_HessianImages.begin(); it != this->m_HessianImages.end(); ++it )
+    size += it->second.MemorySize;
+  
+  for( it = this->m_GradientImages.begin(); it != this->m_GradientImages.end(); ++it )
+    size += it->second.MemorySize;
+  
+  return size;
+}
+
+
+template <class TImage, class TCenterline>
+void
+VesselAnalysisSession<TImage,TCenterline>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Image: " << this->m_Image.GetPointer() << std::endl;
+  os << indent << "NormalizeAcrossScale: " << this->m_NormalizeAcrossScale << std::endl;
+  os << indent << "MemoryBudget: " << this->m_MemoryBudget << std::endl;
+  os << indent << "NumberOfHessianImages: " << this->m_HessianImages.size() << std::endl;
+  os << indent << "NumberOfGradientImages: " << this->m_GradientImages.size() << std::endl;
+  os << indent << "NumberOfHits: " << this->m_NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << this->m_NumberOfMisses << std::endl;
+  os << indent << "NumberOfSharedObjects: " << this->m_SharedObjects.size() << std::endl;
+  os << indent << "Pyramid: " << this->m_Pyramid.GetPointer() << std::endl;
+  os << indent << "SpatialIndex: " << this->m_SpatialIndex.GetPointer() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
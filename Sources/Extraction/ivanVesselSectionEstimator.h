@@ -32,9 +32,12 @@ SUCH DAMAGE.
 #define __ivanVesselSectionEstimator_h
 
 #include "ivanVesselSection.h"
+#include "ivanCancellationToken.h"
 
 #include "itkVectorContainer.h"
 #include "itkFixedArray.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
 
 
 namespace ivan
@@ -130,6 +133,23 @@ protected:
  * several different section properties under the same basic section model, depending on the 
  * application.
  *
+ * ComputeRange() and ComputeAll() are the entry points for estimating many sections at once, for 
+ * instance when re-estimating an already tracked centerline. If NumberOfThreads is larger than one 
+ * and the estimator supports it, the sections are distributed among the threads. Subclasses support 
+ * this by reimplementing SupportsThreadedCompute(), ThreadedComputeSection() and usually 
+ * BeforeThreadedCompute() and AfterThreadedCompute(), where anything that depends on the previous 
+ * section, such as the sign of the normal, can be fixed in a serial pass.
+ *
+ * If a CancellationToken is set, it is checked before every section computed by the threads, 
+ * and by subclasses with long loops such as OptimizedVesselSectionEstimator. When stop is 
+ * requested, GetInterrupted() returns true and only the first GetNumberOfComputedSections() 
+ * sections of the range are valid. Setting a new section or range clears the flag.
+ *
+ * Estimators that support threaded computation also support speculative computation, where a
+ * section is estimated from another thread while Compute() runs on a different section. This is
+ * used by VesselTrackerFilter to estimate the next section before the current one is finished
+ * (see VesselTrackerFilter::SetSpeculativeTurn()).
+ *
  * \ingroup 
  */
 
@@ -184,6 +204,67 @@ public:
   itkGetConstMacro( CurrentScale, double );
   
   virtual void Compute() = 0;
+  
+  /** Compute the sections in the range [first, last]. This is equivalent to SetSectionRange() 
+    * followed by Compute(), except that the sections are computed by NumberOfThreads threads if 
+    * the estimator supports it. */
+  virtual void ComputeRange( RangeValueType first, RangeValueType last );
+  
+  /** Compute all the sections of the centerline. */
+  void ComputeAll();
+  
+  /** Set/Get the number of threads used by ComputeRange() and ComputeAll(). Default is 1. */
+  itkSetClampMacro( NumberOfThreads, unsigned int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+  /** Set/Get the token used to stop the computation. Default is NULL. */
+  itkSetObjectMacro( CancellationToken, CancellationToken );
+  itkGetObjectMacro( CancellationToken, CancellationToken );
+  
+  /** Returns true if the last computation was stopped by the cancellation token. */
+  itkGetConstMacro( Interrupted, bool );
+  
+  /** Set/Get a centerline tracked before in a similar image, such as the previous phase of a 
+    * time series, already displaced to the current image. Estimators that search across scales
+    * start the search at the scale of its closest section instead of the scale of the previous
+    * section (see GetPriorScale()). Default is NULL. */
+  void SetPriorCenterline( const CenterlineType * centerline )
+    {
+      m_PriorCenterline = centerline;
+      this->Modified();
+    }
+  const CenterlineType * GetPriorCenterline() const
+    { return m_PriorCenterline; }
+  
+  /** Get the number of sections, from the first of the range, computed in the last call to 
+    * ComputeRange(). This is the whole range unless interrupted. */
+  itkGetConstMacro( NumberOfComputedSections, RangeValueType );
+  
+  /** Returns true if a section can be computed with ComputeSpeculativeSection() from another 
+    * thread while Compute() runs on a different section. */
+  bool SupportsSpeculativeCompute() const
+    { return this->SupportsThreadedCompute(); }
+  
+  /** Prepare the resources of the speculative thread, such as copies of the image functions. 
+    * Call it from the thread that calls Compute(), once before the speculative sections of a 
+    * tracking direction, and again if the parameters of the estimator change. */
+  void BeginSpeculativeCompute()
+    { this->BeforeThreadedCompute( 2 ); }
+  
+  /** Prepare a single speculative section. Call it from the thread that calls Compute(), after 
+    * the section has been added to the centerline and before ComputeSpeculativeSection(). */
+  void PrepareSpeculativeSection( RangeValueType section )
+    { this->BeforeSpeculativeSection( section ); }
+  
+  /** Estimate the given section from the speculative thread. Compute() must not be running on 
+    * the same section or on a range that contains it. */
+  void ComputeSpeculativeSection( RangeValueType section )
+    { this->ThreadedComputeSection( section, 1 ); }
+  
+  /** Finish a speculative section that was accepted, once the previous section is final. This
+    * fixes what depends on the previous section, such as the sign of the normal. */
+  void EndSpeculativeCompute( RangeValueType section )
+    { this->AfterThreadedCompute( section, section ); }
     
 protected:
   
@@ -192,6 +273,73 @@ protected:
   
   /** Check the validity range when the centerline or range is set. */
   void CheckSectionRangeIsValid();
+  
+  /** Return true if ThreadedComputeSection() can be called concurrently for different sections. 
+    * This is not the case if the estimation of a section depends on the result of the previous one. 
+    * Default is false, so ComputeRange() just calls Compute(). */
+  virtual bool SupportsThreadedCompute() const
+    { return false; }
+  
+  /** Allocate the resources of every thread, such as copies of the image functions. */
+  virtual void BeforeThreadedCompute( unsigned int itkNotUsed( numberOfThreads ) ) {}
+  
+  /** Allocate what a single speculative section needs, such as its cache entries. The resources
+    * of the threads have already been allocated by BeforeThreadedCompute(). */
+  virtual void BeforeSpeculativeSection( RangeValueType itkNotUsed( section ) ) {}
+  
+  /** Estimate a single section from the given thread. */
+  virtual void ThreadedComputeSection( unsigned int itkNotUsed( sectionIdx ), 
+    unsigned int itkNotUsed( threadId ) ) {}
+  
+  /** Serial pass after all the sections of the range have been computed. */
+  virtual void AfterThreadedCompute( RangeValueType itkNotUsed( first ), 
+    RangeValueType itkNotUsed( last ) ) {}
+  
+  /** Get the scale of the section of the prior centerline closest to the given point. Returns
+    * false if there is no prior centerline or it has no sections. */
+  template <class TPoint>
+  bool GetPriorScale( const TPoint & point, double & scale ) const
+    {
+      if( m_PriorCenterline.IsNull() || m_PriorCenterline->empty() )
+        return false;
+      
+      double minimumDistance = itk::NumericTraits<double>::max();
+      
+      for( unsigned int i=0; i < m_PriorCenterline->size(); ++i )
+      {
+        const SectionType *section = m_PriorCenterline->at(i);
+        
+        double distance = 0.0;
+        for( unsigned int dim=0; dim < TPoint::PointDimension; ++dim )
+          distance += ( point[dim] - section->GetCenter()[dim] ) * ( point[dim] - section->GetCenter()[dim] );
+        
+        if( distance < minimumDistance )
+        {
+          minimumDistance = distance;
+          scale = section->GetScale();
+        }
+      }
+      
+      return true;
+    }
+  
+  /** Returns true if a cancellation token is set and requests to stop. */
+  bool IsStopRequested() const
+    { return m_CancellationToken.IsNotNull() && m_CancellationToken->IsStopRequested(); }
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeRangeThreaderCallback( void *arg );
+  
+  /** Data of one ComputeRange() call shared by the threads. */
+  struct ThreadStruct
+  {
+    Self            *Estimator;
+    RangeValueType  First;
+    RangeValueType  Last;
+    
+    /** First section not computed by each thread, Last + 1 or more if it finished. */
+    RangeValueType  NextSection[ITK_MAX_THREADS];
+  };
     
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
@@ -213,6 +361,15 @@ protected:
   
   /** Scale of last calculation. */
   double                         m_CurrentScale;
+  
+  unsigned int                   m_NumberOfThreads;
+  itk::MultiThreader::Pointer    m_MultiThreader;
+  
+  CancellationToken::Pointer     m_CancellationToken;
+  bool                           m_Interrupted;
+  RangeValueType                 m_NumberOfComputedSections;
+  
+  typename CenterlineType::ConstPointer   m_PriorCenterline;
 };
 
 } // end namespace ivan
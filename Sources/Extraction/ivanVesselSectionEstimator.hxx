@@ -105,10 +105,14 @@ VesselSectionMetricsCalculator<TCenterline,TMetrics>
 template <class TCenterline, class TMetricsCalculator>
 VesselSectionEstimator<TCenterline,TMetricsCalculator>
 ::VesselSectionEstimator() :
-  m_CurrentScale( 0.0 )
+  m_CurrentScale( 0.0 ),
+  m_NumberOfThreads( 1 ),
+  m_Interrupted( false ),
+  m_NumberOfComputedSections( 0 )
 {
   this->m_MeasurementCalculator = MetricsCalculatorType::New();
   this->m_SectionRange.Fill(0);
+  this->m_MultiThreader = itk::MultiThreader::New();
 }
 
 
@@ -139,9 +143,10 @@ void
 VesselSectionEstimator<TCenterline,TMetricsCalculator>
 ::SetSectionRange( RangeValueType first, RangeValueType last )
 {
+  this->m_Interrupted = false;
   this->m_SectionRange[0] = first;
   
-  if( last > first )
+  if( last < first )
   {
     itkWarningMacro( "Last section index should be larger than first. Setting last to first." );
     this->m_SectionRange[1] = this->m_SectionRange[0];
@@ -159,6 +164,7 @@ void
 VesselSectionEstimator<TCenterline,TMetricsCalculator>
 ::SetSection( RangeValueType section )
 {
+  this->m_Interrupted = false;
   this->m_SectionRange[0] = this->m_SectionRange[1] = section;
     
   if( this->m_Centerline.IsNotNull() )
@@ -183,6 +189,114 @@ VesselSectionEstimator<TCenterline,TMetricsCalculator>
 }
 
 
+template <class TCenterline, class TMetricsCalculator>
+void
+VesselSectionEstimator<TCenterline,TMetricsCalculator>
+::ComputeRange( RangeValueType first, RangeValueType last )
+{
+  if( this->m_Centerline.IsNull() )
+    itkExceptionMacro( "Centerline must be set before computing sections." );
+  
+  if( !this->m_Centerline->GetNumberOfSections() )
+    return;
+  
+  this->SetSectionRange( first, last );
+  
+  // Same convention as in Compute(), where a null range means all the sections
+  if( this->m_SectionRange[0] == 0 && this->m_SectionRange[1] == 0 )
+    this->m_SectionRange[1] = this->m_Centerline->GetNumberOfSections() - 1;
+  
+  const RangeValueType numberOfSections = this->m_SectionRange[1] - this->m_SectionRange[0] + 1;
+  
+  unsigned int numberOfThreads = this->m_NumberOfThreads;
+  
+  if( numberOfThreads > numberOfSections )
+    numberOfThreads = numberOfSections;
+  
+  // Estimators with their own checks of the cancellation token update these in Compute()
+  this->m_Interrupted = false;
+  this->m_NumberOfComputedSections = numberOfSections;
+  
+  if( numberOfThreads <= 1 || !this->SupportsThreadedCompute() )
+  {
+    this->Compute();
+    return;
+  }
+  
+  this->BeforeThreadedCompute( numberOfThreads );
+  
+  ThreadStruct str;
+  str.Estimator = this;
+  str.First = this->m_SectionRange[0];
+  str.Last = this->m_SectionRange[1];
+  
+  this->m_MultiThreader->SetNumberOfThreads( numberOfThreads );
+  this->m_MultiThreader->SetSingleMethod( this->ComputeRangeThreaderCallback, &str );
+  this->m_MultiThreader->SingleMethodExecute();
+  
+  // Sections are interleaved, so the valid ones are those before the first one not computed 
+  // by any thread
+  RangeValueType next = str.Last + 1;
+  
+  for( unsigned int i=0; i < numberOfThreads; ++i )
+  {
+    if( str.NextSection[i] < next )
+      next = str.NextSection[i];
+  }
+  
+  if( next <= str.Last )
+  {
+    this->m_Interrupted = true;
+    this->m_NumberOfComputedSections = next - str.First;
+  }
+  
+  if( next > str.First )
+    this->AfterThreadedCompute( str.First, next - 1 );
+}
+
+
+template <class TCenterline, class TMetricsCalculator>
+void
+VesselSectionEstimator<TCenterline,TMetricsCalculator>
+::ComputeAll()
+{
+  if( this->m_Centerline.IsNull() )
+    itkExceptionMacro( "Centerline must be set before computing sections." );
+  
+  if( !this->m_Centerline->GetNumberOfSections() )
+    return;
+  
+  this->ComputeRange( 0, this->m_Centerline->GetNumberOfSections() - 1 );
+}
+
+
+template <class TCenterline, class TMetricsCalculator>
+ITK_THREAD_RETURN_TYPE
+VesselSectionEstimator<TCenterline,TMetricsCalculator>
+::ComputeRangeThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const unsigned int numberOfThreads = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  
+  ThreadStruct *str = (ThreadStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  // Sections are interleaved since their cost may vary a lot along the centerline
+  RangeValueType i = str->First + threadId;
+  
+  for( ; i <= str->Last; i += numberOfThreads )
+  {
+    if( str->Estimator->IsStopRequested() )
+      break;
+    
+    str->Estimator->ThreadedComputeSection( i, threadId );
+  }
+  
+  str->NextSection[threadId] = i;
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
 template <class TCenterline, class TMetricsCalculator>
 void 
 VesselSectionEstimator<TCenterline,TMetricsCalculator>
@@ -225,6 +339,10 @@ VesselSectionEstimator<TCenterline,TMetricsCalculator>
   os << indent << "Centerline: " << this->m_Centerline.GetPointer() << std::endl;
   os << indent << "SectionRange: ( " << this->m_SectionRange[0] << ", " << this->m_SectionRange[1] << " )" << std::endl;
   os << indent << "CurrentScale: " << this->m_CurrentScale << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "Interrupted: " << this->m_Interrupted << std::endl;
+  os << indent << "NumberOfComputedSections: " << this->m_NumberOfComputedSections << std::endl;
+  os << indent << "PriorCenterline: " << this->m_PriorCenterline.GetPointer() << std::endl;
 }
 
 } // end namespace ivan
@@ -0,0 +1,266 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselSeedDetector.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: detects seeds for vessel tracking at the maxima of a vesselness image.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselSeedDetector_h
+#define __ivanVesselSeedDetector_h
+
+#include "ivanVesselCenterlineSpatialIndex.h"
+#include "ivanImageRegionTileScheduler.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+#include <algorithm>
+
+
+namespace ivan
+{
+  
+/** \class VesselSeedDetector
+ *  \brief Detects seeds for vessel tracking at the local maxima of a vesselness image.
+ *
+ * A pixel whose response is above LowerThreshold is a candidate if it is the maximum of the 
+ * response in a ball around it, whose radius is its scale times WindowRadiusFactor, and at 
+ * least MinimumWindowRadius, in physical units. Ties go to the pixel first in memory. The 26 
+ * neighbours are tested first, which rejects most pixels at once. The scales are taken from 
+ * an optional scale image, such as the scales output of the multiscale filters, and are zero 
+ * otherwise. Candidates are searched in parallel, in tiles of the buffered region that the 
+ * threads pull from an ImageRegionTileScheduler.
+ *
+ * Candidates are then ranked by decreasing response, and accepted in that order unless they 
+ * are inside a vessel of ExistingVessels or inside the window of an accepted seed. Both tests 
+ * use a VesselCenterlineSpatialIndex, where every accepted seed is added as a single section 
+ * branch whose radius is its window radius. Up to MaximumNumberOfSeeds seeds are accepted, if 
+ * not zero. The seeds do not depend on the number of threads.
+ *
+ * Every seed has the scale at its pixel and, if a normal image is set, its normalized normal
+ * as direction, which is zero otherwise. GetSeedPoints() can be given directly to 
+ * MultiSeedVesselTrackerFilter::SetSeeds(), in rank order, and a VesselTrackerFactory may set 
+ * the initial scale and direction of the tracker of seed i from GetSeeds()[i]. Passing the 
+ * graph tracked so far as ExistingVessels avoids tracking the same vessels again.
+ *
+ * The images must be up to date, and the scale and normal images must have the same buffered 
+ * region as the input.
+ *
+ * \sa MultiSeedVesselTrackerFilter
+ *
+ * \ingroup 
+ */
+ 
+template <class TInputImage, class TCenterline, class TScalePixel = double>
+class ITK_EXPORT VesselSeedDetector : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselSeedDetector              Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  /** Image-related typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::RegionType     InputImageRegionType; 
+  typedef typename InputImageType::IndexType      InputImageIndexType; 
+  typedef typename InputImageType::PointType      PointType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
+  
+  typedef TScalePixel                                                       ScalePixelType;
+  typedef itk::Image<ScalePixelType,itkGetStaticConstMacro(ImageDimension)> ScaleImageType;
+  typedef itk::Vector<ScalePixelType,itkGetStaticConstMacro(ImageDimension)>  NormalPixelType;
+  typedef itk::Image<NormalPixelType,itkGetStaticConstMacro(ImageDimension)>  NormalImageType;
+  
+  typedef itk::Vector<double,itkGetStaticConstMacro(ImageDimension)>        VectorType;
+  
+  /** Vessel-related typedefs. */
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::SectionType  SectionType;
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  typedef typename BranchNodeType::Pointer      BranchNodePointer;
+  
+  typedef VesselCenterlineSpatialIndex<TCenterline>         SpatialIndexType;
+  typedef ImageRegionTileScheduler<itkGetStaticConstMacro(ImageDimension)>  TileSchedulerType;
+  
+  /** A detected seed. */
+  struct Seed
+  {
+    PointType     Point;
+    double        Scale;
+    VectorType    Direction;
+    double        Response;
+  };
+  
+  typedef std::vector<Seed>         SeedContainerType;
+  typedef std::vector<PointType>    PointContainerType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselSeedDetector, itk::Object );
+  
+  /** Set/Get the vesselness image. */
+  itkSetConstObjectMacro( Input, InputImageType );
+  itkGetConstObjectMacro( Input, InputImageType );
+  
+  /** Set/Get the image of the scales. Default is NULL. */
+  itkSetConstObjectMacro( ScaleImage, ScaleImageType );
+  itkGetConstObjectMacro( ScaleImage, ScaleImageType );
+  
+  /** Set/Get the image of the normals, which are the vessel directions. Default is NULL. */
+  itkSetConstObjectMacro( NormalImage, NormalImageType );
+  itkGetConstObjectMacro( NormalImage, NormalImageType );
+  
+  /** Set/Get the vessels already tracked, whose candidates are discarded. Default is NULL. */
+  itkSetConstObjectMacro( ExistingVessels, VesselGraphType );
+  itkGetConstObjectMacro( ExistingVessels, VesselGraphType );
+  
+  /** Set/Get the response above which pixels may be candidates. Default is 0.0. */
+  itkSetMacro( LowerThreshold, double );
+  itkGetConstMacro( LowerThreshold, double );
+  
+  /** Set/Get the factor converting scales to window radii. Default is 2.0. */
+  itkSetMacro( WindowRadiusFactor, double );
+  itkGetConstMacro( WindowRadiusFactor, double );
+  
+  /** Set/Get the smallest window radius, in physical units. Default is 1.0. */
+  itkSetMacro( MinimumWindowRadius, double );
+  itkGetConstMacro( MinimumWindowRadius, double );
+  
+  /** Set/Get the maximum number of seeds, or zero for no limit. Default is zero. */
+  itkSetMacro( MaximumNumberOfSeeds, unsigned int );
+  itkGetConstMacro( MaximumNumberOfSeeds, unsigned int );
+  
+  /** Set/Get the size of the tiles in each dimension. Default is 16. */
+  itkSetClampMacro( TileSize, unsigned long, 1, itk::NumericTraits<unsigned long>::max() );
+  itkGetConstMacro( TileSize, unsigned long );
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Detect the seeds. */
+  void Update();
+  
+  /** Seeds detected by the last call to Update(), in rank order. */
+  const SeedContainerType & GetSeeds() const
+    { return m_Seeds; }
+  
+  /** Points of the seeds, in rank order. */
+  PointContainerType GetSeedPoints() const;
+  
+  /** Number of candidates found by the last call to Update(), before ranking. */
+  itkGetConstMacro( NumberOfCandidates, unsigned long );
+		
+protected:
+
+  VesselSeedDetector();
+  ~VesselSeedDetector() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Window radius of a pixel, from its scale. */
+  double GetWindowRadius( double scale ) const
+    { return std::max( scale * m_WindowRadiusFactor, m_MinimumWindowRadius ); }
+  
+  /** Find the candidates of the tiles pulled by the thread. */
+  void ThreadedFindCandidates( int threadId );
+  
+  /** Check if the pixel is the maximum of the given window. */
+  bool IsWindowMaximum( const InputImageIndexType & index, double response, 
+    const typename InputImageType::SizeType & radius, double physicalRadius ) const;
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FindCandidatesThreaderCallback( void *arg );
+
+private:
+
+  VesselSeedDetector(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+  /** Candidate pixel, ordered by decreasing response and then by offset. */
+  struct Candidate
+  {
+    unsigned long   Offset;
+    double          Response;
+    double          Scale;
+    
+    bool operator<( const Candidate & other ) const
+      { 
+        if( this->Response != other.Response )
+          return this->Response > other.Response;
+        return this->Offset < other.Offset; 
+      }
+  };
+  
+  typedef std::vector<Candidate>    CandidateContainerType;
+
+protected:
+
+  InputImageConstPointer                    m_Input;
+  typename ScaleImageType::ConstPointer     m_ScaleImage;
+  typename NormalImageType::ConstPointer    m_NormalImage;
+  typename VesselGraphType::ConstPointer    m_ExistingVessels;
+  
+  double                m_LowerThreshold;
+  double                m_WindowRadiusFactor;
+  double                m_MinimumWindowRadius;
+  unsigned int          m_MaximumNumberOfSeeds;
+  unsigned long         m_TileSize;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  typename TileSchedulerType::Pointer       m_TileScheduler;
+  std::vector<CandidateContainerType>       m_ThreadCandidates;
+  
+  SeedContainerType     m_Seeds;
+  unsigned long         m_NumberOfCandidates;
+};
+
+} // end namespace ivan
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ivanVesselSeedDetector.hxx"
+#endif
+
+#endif
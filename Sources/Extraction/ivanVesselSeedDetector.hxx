@@ -0,0 +1,358 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselSeedDetector.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: detects seeds for vessel tracking at the maxima of a vesselness image.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselSeedDetector_hxx
+#define __ivanVesselSeedDetector_hxx
+
+#include "ivanVesselSeedDetector.h"
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <vnl/vnl_math.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ivan
+{
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::VesselSeedDetector() :
+  m_LowerThreshold( 0.0 ),
+  m_WindowRadiusFactor( 2.0 ),
+  m_MinimumWindowRadius( 1.0 ),
+  m_MaximumNumberOfSeeds( 0 ),
+  m_TileSize( 16 ),
+  m_NumberOfCandidates( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+void
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::Update()
+{
+  if( m_Input.IsNull() )
+    itkExceptionMacro( "Input not set." );
+  
+  const InputImageRegionType region = m_Input->GetBufferedRegion();
+  
+  if( ( m_ScaleImage.IsNotNull() && m_ScaleImage->GetBufferedRegion() != region ) ||
+      ( m_NormalImage.IsNotNull() && m_NormalImage->GetBufferedRegion() != region ) )
+    itkExceptionMacro( "The scale and normal images must have the same buffered region as the input." );
+  
+  // Find the candidates in tiles
+  m_TileScheduler = TileSchedulerType::New();
+  m_TileScheduler->SetRegion( region );
+  m_TileScheduler->SetTileSize( m_TileSize );
+  m_TileScheduler->Initialize();
+  
+  const int numberOfThreads = m_TileScheduler->GetNumberOfTiles() > 1 ? 
+    vnl_math_min( m_NumberOfThreads, (int)m_TileScheduler->GetNumberOfTiles() ) : 1;
+  
+  m_ThreadCandidates.assign( numberOfThreads, CandidateContainerType() );
+  
+  if( numberOfThreads > 1 )
+  {
+    m_Threader->SetNumberOfThreads( numberOfThreads );
+    m_Threader->SetSingleMethod( this->FindCandidatesThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedFindCandidates( 0 );
+  }
+  
+  CandidateContainerType candidates;
+  
+  for( int t=0; t<numberOfThreads; ++t )
+  {
+    candidates.insert( candidates.end(), m_ThreadCandidates[t].begin(), m_ThreadCandidates[t].end() );
+    CandidateContainerType().swap( m_ThreadCandidates[t] );
+  }
+  
+  m_TileScheduler = 0;
+  m_NumberOfCandidates = candidates.size();
+  
+  // Rank the candidates, which makes the order of the threads irrelevant
+  std::sort( candidates.begin(), candidates.end() );
+  
+  // Accept the candidates outside the existing vessels and the windows of the accepted seeds
+  typename SpatialIndexType::Pointer spatialIndex = SpatialIndexType::New();
+  
+  if( m_ExistingVessels.IsNotNull() )
+    spatialIndex->Build( m_ExistingVessels );
+  
+  std::vector<BranchNodePointer> windows;
+  
+  m_Seeds.clear();
+  
+  for( unsigned int i=0; i < candidates.size(); ++i )
+  {
+    if( m_MaximumNumberOfSeeds > 0 && m_Seeds.size() >= m_MaximumNumberOfSeeds )
+      break;
+    
+    const InputImageIndexType index = m_Input->ComputeIndex( candidates[i].Offset );
+    
+    PointType point;
+    m_Input->TransformIndexToPhysicalPoint( index, point );
+    
+    if( spatialIndex->FindContainingBranch( point ) )
+      continue;
+    
+    Seed seed;
+    seed.Point = point;
+    seed.Scale = candidates[i].Scale;
+    seed.Response = candidates[i].Response;
+    seed.Direction.Fill( 0.0 );
+    
+    if( m_NormalImage.IsNotNull() )
+    {
+      const NormalPixelType & normal = m_NormalImage->GetPixel( index );
+      const double norm = normal.GetNorm();
+      
+      if( norm > 0.0 )
+      {
+        for( unsigned int d=0; d<ImageDimension; ++d )
+          seed.Direction[d] = normal[d] / norm;
+      }
+    }
+    
+    m_Seeds.push_back( seed );
+    
+    // The window of the seed, as a sphere
+    typename SectionType::Pointer section = SectionType::New();
+    section->SetCenter( point );
+    section->SetRadius( this->GetWindowRadius( seed.Scale ) );
+    
+    BranchNodePointer window = BranchNodeType::New();
+    window->GetCenterline()->push_back( section );
+    windows.push_back( window );
+    
+    spatialIndex->AppendSections( window );
+  }
+  
+  itkDebugMacro( "Accepted " << m_Seeds.size() << " seeds of " << m_NumberOfCandidates 
+    << " candidates using " << numberOfThreads << " threads" );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+typename VesselSeedDetector<TInputImage,TCenterline,TScalePixel>::PointContainerType
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::GetSeedPoints() const
+{
+  PointContainerType points( m_Seeds.size() );
+  
+  for( unsigned int i=0; i < m_Seeds.size(); ++i )
+    points[i] = m_Seeds[i].Point;
+  
+  return points;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+void
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::ThreadedFindCandidates( int threadId )
+{
+  const typename InputImageType::SpacingType & spacing = m_Input->GetSpacing();
+  
+  CandidateContainerType & candidates = m_ThreadCandidates[threadId];
+  
+  typename InputImageType::SizeType unitRadius;
+  unitRadius.Fill( 1 );
+  
+  InputImageRegionType tile;
+  
+  while( m_TileScheduler->GetNextTile( tile ) )
+  {
+    itk::ImageRegionConstIteratorWithIndex<InputImageType> it( m_Input, tile );
+    
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+      const double response = it.Get();
+      
+      if( !( response > m_LowerThreshold ) )
+        continue;
+      
+      const InputImageIndexType & index = it.GetIndex();
+      
+      // Most pixels are not maxima of their 26 neighbours
+      if( !this->IsWindowMaximum( index, response, unitRadius, itk::NumericTraits<double>::max() ) )
+        continue;
+      
+      const double scale = m_ScaleImage.IsNotNull() ? 
+        static_cast<double>( m_ScaleImage->GetPixel( index ) ) : 0.0;
+      const double windowRadius = this->GetWindowRadius( scale );
+      
+      typename InputImageType::SizeType radius;
+      bool isLarger = false;
+      
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        radius[d] = static_cast<unsigned long>( vcl_floor( windowRadius / spacing[d] ) );
+        isLarger = isLarger || ( radius[d] > 1 );
+      }
+      
+      if( isLarger && !this->IsWindowMaximum( index, response, radius, windowRadius ) )
+        continue;
+      
+      Candidate candidate;
+      candidate.Offset = m_Input->ComputeOffset( index );
+      candidate.Response = response;
+      candidate.Scale = scale;
+      
+      candidates.push_back( candidate );
+    }
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+bool
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::IsWindowMaximum( const InputImageIndexType & index, double response, 
+  const typename InputImageType::SizeType & radius, double physicalRadius ) const
+{
+  const typename InputImageType::SpacingType & spacing = m_Input->GetSpacing();
+  
+  InputImageRegionType window;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    window.SetIndex( d, index[d] - static_cast<long>( radius[d] ) );
+    window.SetSize( d, 2 * radius[d] + 1 );
+  }
+  
+  window.Crop( m_Input->GetBufferedRegion() );
+  
+  itk::ImageRegionConstIteratorWithIndex<InputImageType> it( m_Input, window );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double neighbourResponse = it.Get();
+    
+    if( neighbourResponse < response )
+      continue;
+    
+    const InputImageIndexType & neighbourIndex = it.GetIndex();
+    
+    // Ties go to the pixel first in memory, that is, with the last different coordinate smaller
+    if( neighbourResponse == response )
+    {
+      int d = ImageDimension - 1;
+      
+      while( d >= 0 && neighbourIndex[d] == index[d] )
+        --d;
+        
+      if( d < 0 || neighbourIndex[d] > index[d] )
+        continue;
+    }
+    
+    // Only the pixels inside the ball
+    double distance = 0.0;
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      const double difference = ( neighbourIndex[d] - index[d] ) * spacing[d];
+      distance += difference * difference;
+    }
+    
+    if( distance <= physicalRadius * physicalRadius )
+      return false;
+  }
+  
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+ITK_THREAD_RETURN_TYPE
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::FindCandidatesThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+  Self *detector = (Self *)( info->UserData );
+  
+  detector->ThreadedFindCandidates( info->ThreadID );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TCenterline, class TScalePixel>
+void
+VesselSeedDetector<TInputImage,TCenterline,TScalePixel>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Input: " << m_Input.GetPointer() << std::endl;
+  os << indent << "ScaleImage: " << m_ScaleImage.GetPointer() << std::endl;
+  os << indent << "NormalImage: " << m_NormalImage.GetPointer() << std::endl;
+  os << indent << "ExistingVessels: " << m_ExistingVessels.GetPointer() << std::endl;
+  os << indent << "LowerThreshold: " << m_LowerThreshold << std::endl;
+  os << indent << "WindowRadiusFactor: " << m_WindowRadiusFactor << std::endl;
+  os << indent << "MinimumWindowRadius: " << m_MinimumWindowRadius << std::endl;
+  os << indent << "MaximumNumberOfSeeds: " << m_MaximumNumberOfSeeds << std::endl;
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfSeeds: " << m_Seeds.size() << std::endl;
+  os << indent << "NumberOfCandidates: " << m_NumberOfCandidates << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -31,10 +31,51 @@ SUCH DAMAGE.
 #define __ivanVesselTrackerEndCondition_h
 
 #include "itkObject.h"
+#include "itkPoint.h"
 
 
 namespace ivan
 {
+
+class GraphNode;
+
+/** \class VesselTrackerStepState
+ *  \brief State of the current tracking step shared with the end conditions.
+ *
+ * VesselTrackerFilter updates this structure after the Measure stage of every step, and 
+ * subclasses may publish values that they have already evaluated, such as the vesselness at the
+ * section center found in the Search stage. End conditions read these values instead of 
+ * evaluating them again. The state is not valid before the first step, and the vesselness is 
+ * only valid if VesselnessValid is true.
+ *
+ */
+struct VesselTrackerStepState
+{
+  typedef itk::Point<double,3>   PointType;
+  
+  VesselTrackerStepState() :
+    Valid(false), Branch(0), SectionIndex(0), Scale(0.0), VesselnessValid(false), 
+    VesselnessValue(0.0)
+    { Position.Fill(0.0); }
+  
+  /** False until the first step has been measured. */
+  bool           Valid;
+  
+  /** Branch being tracked. */
+  const GraphNode  *Branch;
+  
+  /** Index of the section in the current branch and its center. */
+  unsigned int   SectionIndex;
+  PointType      Position;
+  
+  /** Scale of the section. */
+  double         Scale;
+  
+  /** Last vesselness value evaluated at Position, if any. */
+  bool           VesselnessValid;
+  double         VesselnessValue;
+};
+
   
 /** \class VesselTrackerEndCondition
  *  \brief Abstract class that represents and end condition for VesselTrackerFilter.
@@ -66,10 +107,28 @@ public:
   itkTypeMacro( VesselTrackerEndCondition, itk::Object );
   
   virtual bool Finished() = 0;
+  
+  /** Set the state of the current step. This is done by VesselTrackerFilter when the end condition
+    * is set, and the state is owned by the tracker. May be NULL if the end condition is not used 
+    * from a tracker. */
+  virtual void SetStepState( const VesselTrackerStepState *state )
+    { m_StepState = state; }
+  const VesselTrackerStepState * GetStepState() const
+    { return m_StepState; }
+  
+  /** Reset any internal state, so that tracking can be started again (for instance in the 
+    * opposite direction in VesselTrackerFilter bidirectional mode). Does nothing by default. */
+  virtual void Reset() {}
+  
+  /** Relative cost of Finished(), used by CompositeVesselTrackerEndCondition to check cheap 
+    * conditions first. Counters should return about 0, bounds checks and mask lookups about 1,
+    * and conditions that evaluate image functions larger values. Default is 1.0. */
+  virtual double GetEvaluationCost() const
+    { return 1.0; }
 
 protected:
   
-  VesselTrackerEndCondition() {}
+  VesselTrackerEndCondition() : m_StepState(0) {}
   virtual ~VesselTrackerEndCondition() {}
       
 private:
@@ -79,7 +138,7 @@ private:
   
 protected:
   
-
+  const VesselTrackerStepState  *m_StepState;
 };
 
 } // end namespace ivan
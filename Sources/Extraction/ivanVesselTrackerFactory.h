@@ -0,0 +1,113 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTrackerFactory.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: abstract factory of vessel trackers for multi-seed tracking.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselTrackerFactory_h
+#define __ivanVesselTrackerFactory_h
+
+#include "ivanVesselTrackerFilter.h"
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class VesselTrackerFactory
+ *  \brief Abstract class that creates configured vessel trackers, one per seed.
+ *
+ * This abstract class is used by MultiSeedVesselTrackerFilter to obtain an independent
+ * tracker for each seed. Trackers are run concurrently, so each created tracker must own its 
+ * section estimator, end condition and any vesselness or image functions with state. These 
+ * may be created anew or cloned from existing ones with the same parameters. Read-only data, 
+ * such as the input image or precomputed vesselness images, can be shared.
+ *
+ * The input and the starting point of the created trackers are set by the multi-seed filter.
+ *
+ * Factories may also describe the parameters of the trackers they create with keys, so that
+ * branches tracked before with the same parameters are reused instead of tracked again (see
+ * MultiSeedVesselTrackerFilter::SetReuseUnchangedBranches()).
+ *
+ * This class is templated over the input image and output vessel types of the trackers.
+ *
+ * \sa MultiSeedVesselTrackerFilter
+ */
+
+template <class TInputImage, class TOutputVessel>
+class ITK_EXPORT VesselTrackerFactory : public itk::Object
+{
+public:
+  
+  typedef VesselTrackerFactory             Self;
+  typedef itk::Object                      Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+  
+  typedef VesselTrackerFilter<TInputImage,TOutputVessel>   TrackerType;
+  typedef typename TrackerType::Pointer                    TrackerPointer;
+  
+public:
+
+  /** Method for creation through the object factory. */
+  //itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselTrackerFactory, itk::Object );
+  
+  /** Create a tracker for the given seed. This is called from a single thread, once per seed
+    * and in seed order, before tracking starts. */
+  virtual TrackerPointer CreateTracker( unsigned int seed ) = 0;
+  
+  /** Get a key that describes all the parameters of the tracker created for the given seed 
+    * that affect the sections tracked, except those of the end condition. These include the 
+    * parameters of the tracker, the section estimator and the vesselness functions, and must
+    * identify any other image used besides the input. Two trackers with the same key must 
+    * track the same sections from the same starting point in the same input. The default is 
+    * an empty key, which means that the parameters are unknown and branches are never reused. */
+  virtual std::string GetSectionParametersKey( unsigned int itkNotUsed( seed ) )
+    { return std::string(); }
+  
+  /** Get a key that describes the end condition of the tracker created for the given seed. 
+    * The default is an empty key, which means that the end condition is unknown. */
+  virtual std::string GetEndConditionParametersKey( unsigned int itkNotUsed( seed ) )
+    { return std::string(); }
+
+protected:
+  
+  VesselTrackerFactory() {}
+  virtual ~VesselTrackerFactory() {}
+      
+private:
+  
+  VesselTrackerFactory(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+};
+
+} // end namespace ivan
+
+#endif
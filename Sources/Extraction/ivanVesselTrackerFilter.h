@@ -34,10 +34,28 @@ SUCH DAMAGE.
 #include "ivanVesselBranchNode.h"
 #include "ivanVesselSectionEstimator.h"
 #include "ivanVesselTrackerEndCondition.h"
+#include "ivanPerformanceProfile.h"
+
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+#include "itkTimeProbe.h"
+
+#include <deque>
 
 
 namespace ivan
 {
+
+/** Event invoked when a section is completed while streaming sections (see 
+  * VesselTrackerFilter::SetStreamSections()). It is invoked from the tracking thread. */
+itkEventMacro( SectionTrackedEvent, itk::AnyEvent );
+
+/** Event invoked when the requested region of the input is grown while tracking, after the 
+  * input is updated (see VesselTrackerFilter::SetTrackingRegionRadius()). */
+itkEventMacro( TrackingRegionGrownEvent, itk::AnyEvent );
+
   
 /** \class VesselTrackerFilter
  * \brief Base class for filters that take an image as input and produce a VesselDataObject as output.
@@ -50,6 +68,46 @@ namespace ivan
  * the center point of the section is an array-like object (such as Array or std::vector) with the 
  * same dimension as the image and the random access [] operator defined.
  *
+ * Tracking can be run asynchronously with StartTracking(), which calls Track() on a separate 
+ * thread and returns immediately. With StreamSections on, every section is pushed to a queue
+ * as soon as it is completed (after the Step stage), where it can be retrieved from another 
+ * thread with PopTrackedSection(), for example to render the sections while they are tracked. 
+ * With PublishSections on, the centerline of the current branch is published after every step
+ * instead (see VesselCenterline::PublishSections()), so that viewers can iterate all the 
+ * sections tracked so far from another thread without locks or copies.
+ * CancelTracking() stops the tracking loop at the next step and waits for the thread.
+ * The tracking thread calls the virtual stages of the tracker, so it must be stopped before 
+ * any part of the tracker is destroyed: the owner must call CancelTracking() or 
+ * WaitForTracking() before releasing the tracker, and every subclass must call StopTracking() 
+ * in its destructor, since by the time this class' destructor runs the subclass members are 
+ * already gone.
+ *
+ * A CancellationToken can be set to bound the work of a request, with Cancel() or a time budget. 
+ * It is checked at every step of the tracking loop and given to the section estimator, and 
+ * through it to its optimizer, if they do not have one. When stop is requested the branch keeps
+ * the sections tracked so far and GetInterrupted() returns true. If the section estimator is 
+ * stopped before the new section is estimated, that section is removed from the branch, so every
+ * section of an interrupted branch is estimated.
+ *
+ * With SpeculativeTurn on, the Turn stage of the next step is overlapped with the Search and 
+ * Measure stages of the current one (see SetSpeculativeTurn()).
+ *
+ * Tracking can also be run one step at a time with InitializeTracking() and TrackStep(), so 
+ * that a caller can interleave the steps of several trackers on the same thread (see 
+ * MultiSeedVesselTrackerFilter::SetNumberOfInterleavedTrackers()). Track() is equivalent to 
+ * InitializeTracking() followed by calling TrackStep() until it returns false. ResumeTracking()
+ * can be used instead of InitializeTracking() to continue a branch tracked before, when only
+ * the end condition has changed.
+ *
+ * By default the whole input is requested from the pipeline. With a TrackingRegionRadius, only
+ * the region within that distance of the starting point, padded by TrackingRegionMargin for the
+ * support of the image functions, is requested. While updating, the region is grown around 
+ * the current point, and the input is updated again, whenever the next step would need pixels 
+ * that are not buffered, so that streaming readers only load the part of the image around the 
+ * branch. Observers of TrackingRegionGrownEvent must then set the image again on the image 
+ * functions that use the input. Track() does not touch the pipeline, so it stops at the 
+ * boundary of the buffered region instead (see GetReachedRegionBoundary()).
+ *
  */
 
 template <class TInputImage, class TOutputVessel>
@@ -89,11 +147,36 @@ public:
   
   typedef VesselTrackerEndCondition                  EndConditionType;
   typedef typename EndConditionType::Pointer         EndConditionPointer;
+  typedef VesselTrackerStepState                     StepStateType;
     
   /** ImageDimension constants */
   itkStaticConstMacro(InputImageDimension, unsigned int,
                       TInputImage::ImageDimension);
   
+  typedef itk::Vector<double,itkGetStaticConstMacro(InputImageDimension)>  DirectionType;
+  
+  /** Candidate child branch detected during tracking. The point is the estimated child vessel
+    * location, the direction points from the parent section center towards it, and the index
+    * is the one of the parent section where it was detected. */
+  struct BranchCandidate
+  {
+    InputImagePointType   Point;
+    DirectionType         Direction;
+    unsigned int          SectionIndex;
+  };
+  
+  typedef std::vector<BranchCandidate>               BranchCandidateContainerType;
+  
+  /** Section completed while tracking. The index is the one in the tracked direction, and 
+    * SecondDirection is true for the opposite direction in bidirectional mode. In this mode the
+    * order of the sections in the final centerline differs (see SetBidirectional()). */
+  struct TrackedSection
+  {
+    typename SectionType::Pointer   Section;
+    unsigned int                    Index;
+    bool                            SecondDirection;
+  };
+  
 public:
   
   /** Method for creation through the object factory. */
@@ -112,9 +195,98 @@ public:
   itkGetConstMacro( InvertDirection, bool );
   itkBooleanMacro( InvertDirection );
   
+  /** Flag for tracking in both directions from the starting point. The direction given by 
+    * InvertDirection is tracked first, and then the opposite one, reusing the initialized section 
+    * estimator and vesselness functions. Both are written to the same branch centerline in 
+    * arclength order, that is, from the end of the opposite direction, through the starting 
+    * point, to the end of the first direction. The end condition is reset between both 
+    * directions. Default is false. */
+  itkSetMacro( Bidirectional, bool );
+  itkGetConstMacro( Bidirectional, bool );
+  itkBooleanMacro( Bidirectional );
+  
   itkSetMacro( InitialStepSize, double );
   itkGetConstMacro( InitialStepSize, double );
   
+  /** Flag for adaptive step size. If off, the tracker always advances InitialStepSize. If on,
+    * the step is RadiusStepFactor times the radius of the current section (InitialStepSize if
+    * the radius is not estimated), reduced with the curvature estimated from consecutive normals 
+    * so that the normal turns about half MaximumNormalAngle per step, multiplied by the step 
+    * confidence (see GetStepConfidence()) and clamped to [MinimumStepSize,MaximumStepSize]. 
+    * Steps after which the normal turns more than MaximumNormalAngle are rejected and retried
+    * with half the size, down to MinimumStepSize. Default is false. */
+  itkSetMacro( AdaptiveStepSize, bool );
+  itkGetConstMacro( AdaptiveStepSize, bool );
+  itkBooleanMacro( AdaptiveStepSize );
+  
+  /** Set/Get the bounds of the adaptive step size. Defaults are 0.25 and 4.0. */
+  itkSetMacro( MinimumStepSize, double );
+  itkGetConstMacro( MinimumStepSize, double );
+  itkSetMacro( MaximumStepSize, double );
+  itkGetConstMacro( MaximumStepSize, double );
+  
+  /** Set/Get the factor of the section radius used as step size in adaptive mode. Default is 1.0. */
+  itkSetMacro( RadiusStepFactor, double );
+  itkGetConstMacro( RadiusStepFactor, double );
+  
+  /** Set/Get the maximum angle, in radians, accepted between consecutive normals in adaptive 
+    * mode. Default is pi/6 (30 degrees). */
+  itkSetMacro( MaximumNormalAngle, double );
+  itkGetConstMacro( MaximumNormalAngle, double );
+  
+  /** Get the size of the last step taken and the number of steps rejected in adaptive mode. */
+  itkGetConstMacro( LastStepSize, double );
+  itkGetConstMacro( NumberOfRejectedSteps, unsigned int );
+  
+  /** Flag for speculative turns. If on, once the section is estimated in the Turn stage, the 
+    * next section is estimated on a separate thread at the point predicted by stepping from the
+    * section center with the last step size, while the Search and Measure stages refine the 
+    * current one. If the next step lands within SpeculationTolerance of the predicted point, the
+    * speculative section is kept instead of estimating it again, so it keeps the normal and 
+    * radius estimated at the predicted point. This requires a section estimator that supports
+    * threaded computation (see VesselSectionEstimator::SupportsSpeculativeCompute()), otherwise
+    * it is ignored, and subclasses must not reimplement Turn(). Default is false. */
+  itkSetMacro( SpeculativeTurn, bool );
+  itkGetConstMacro( SpeculativeTurn, bool );
+  itkBooleanMacro( SpeculativeTurn );
+  
+  /** Set/Get the maximum distance between the predicted and the actual next point for keeping
+    * the speculative section. Default is 0.1. */
+  itkSetMacro( SpeculationTolerance, double );
+  itkGetConstMacro( SpeculationTolerance, double );
+  
+  /** Get the number of speculative sections kept and discarded in the last tracking. */
+  itkGetConstMacro( NumberOfSpeculativeHits, unsigned int );
+  itkGetConstMacro( NumberOfSpeculativeMisses, unsigned int );
+  
+  /** Flag for detecting bifurcations while tracking, if implemented in subclasses (see 
+    * VesselnessRidgeSearchVesselTrackerFilter). Detected child branches are only recorded as
+    * candidates (see GetBranchCandidates()), they are not tracked. Default is false. */
+  itkSetMacro( DetectBranches, bool );
+  itkGetConstMacro( DetectBranches, bool );
+  itkBooleanMacro( DetectBranches );
+  
+  /** Set/Get the minimum distance between branch candidates, and between a candidate and the 
+    * starting point. Closer candidates are discarded as detections of the same branch. 
+    * Default is 10.0. */
+  itkSetMacro( MinimumBranchSeparation, double );
+  itkGetConstMacro( MinimumBranchSeparation, double );
+  
+  /** Get the branch candidates detected in the last tracking. */
+  const BranchCandidateContainerType & GetBranchCandidates() const
+    { return m_BranchCandidates; }
+  
+  /** Set the approximate initial tracking direction. If set, InvertDirection is chosen after
+    * the first section so that the tracker advances along this direction, which is used to track
+    * child branches away from the bifurcation. Ignored in bidirectional mode. */
+  void SetInitialDirection( const DirectionType & direction )
+    { m_InitialDirection = direction; m_UseInitialDirection = true; this->Modified(); }
+  const DirectionType & GetInitialDirection() const
+    { return m_InitialDirection; }
+  void ClearInitialDirection()
+    { m_UseInitialDirection = false; this->Modified(); }
+  itkGetConstMacro( UseInitialDirection, bool );
+  
   const BranchNodeType * GetCurrentBranch() const
     { return m_CurrentBranch.GetPointer(); }
   BranchNodeType * GetCurrentBranch()
@@ -123,7 +295,7 @@ public:
   itkGetConstMacro( BranchPointIndex, unsigned int );
 
   virtual void SetStartingPoint( const InputImagePointType & point )
-    { m_PreviousPoint = m_CurrentPoint = point; }
+    { m_StartingPoint = m_PreviousPoint = m_CurrentPoint = point; }
   const InputImagePointType & GetPreviousPoint() const
     { return m_PreviousPoint; }
   const InputImagePointType & GetCurrentPoint() const
@@ -137,21 +309,184 @@ public:
   SectionEstimatorType * GetSectionEstimator()
     { return m_SectionEstimator.GetPointer(); }
     
-  /** Set the end condition. */
+  /** Set/Get the end condition. The end condition is given access to the state of the current step
+    * (see VesselTrackerStepState). */
   virtual void SetEndCondition( VesselTrackerEndCondition *endCondition )
-    { m_EndCondition = endCondition; }
+    { 
+      m_EndCondition = endCondition;
+      
+      if( m_EndCondition.IsNotNull() )
+        m_EndCondition->SetStepState( &m_StepState );
+    }
+  VesselTrackerEndCondition * GetEndCondition()
+    { return m_EndCondition.GetPointer(); }
+  
+  /** Get the state of the current tracking step. */
+  const StepStateType & GetStepState() const
+    { return m_StepState; }
+  
+  /** Run the Turn/Search/Measure/Step tracking loop from the starting point, directly on the 
+    * current input and without updating the pipeline. The input must be up to date. This is 
+    * what GenerateData() does, except for growing the requested region of the input, and it 
+    * allows several trackers to be run concurrently on the same input, since the input 
+    * pipeline is not touched (see MultiSeedVesselTrackerFilter). */
+  virtual void Track();
+  
+  /** Initialize the tracking, as Track() does, without taking any step. */
+  void InitializeTracking();
+  
+  /** Take the next Turn/Search/Measure/Step iteration of the tracking loop, switching to the
+    * opposite direction in bidirectional mode when needed. Returns false, without doing 
+    * anything, once the end condition is met or tracking is stopped, and then the branch is 
+    * complete. If an exception is thrown, tracking cannot be resumed. */
+  bool TrackStep();
+  
+  /** Initialize the tracking to continue a centerline tracked before from the same starting 
+    * point and input, with the same parameters except the end condition. The given sections are
+    * taken, in order, while the end condition is not met, as if they had been tracked again, 
+    * and so are the branch candidates detected at them. Then TrackStep() continues from the 
+    * last one taken, if the end condition was not met. The sections are shared with the given 
+    * centerline. The step size and the vesselness used by the end condition are recomputed 
+    * from the sections, so the result may only differ from tracking again in the values 
+    * published by the Search stage. Only supported in unidirectional mode. */
+  void ResumeTracking( const CenterlineType *centerline, 
+    const BranchCandidateContainerType & candidates );
+  
+  /** Hint the processor to load the input image around the current point, where the next step 
+    * will start, so that the memory is fetched while other work is done, such as the steps of 
+    * other trackers. It does nothing if PrefetchRadius is zero. */
+  void PrefetchNextStep();
+  
+  /** Set/Get the distance, in physical units, around the starting point of the input region 
+    * requested by the pipeline, and by which it is grown while tracking. If zero, the whole 
+    * input is requested. Default is 0.0. */
+  itkSetMacro( TrackingRegionRadius, double );
+  itkGetConstMacro( TrackingRegionRadius, double );
+  
+  /** Set/Get the padding, in physical units, of the requested input region, which must cover 
+    * the support of the image functions around the section center, such as the largest kernel
+    * radius. Tracking stops at a point closer than this to the boundary of the buffered region
+    * if it cannot be grown. Default is 0.0. */
+  itkSetMacro( TrackingRegionMargin, double );
+  itkGetConstMacro( TrackingRegionMargin, double );
+  
+  /** Get the number of times the requested input region was grown in the last update. */
+  itkGetConstMacro( NumberOfRegionGrowths, unsigned int );
+  
+  /** Returns true if the last tracking stopped at the boundary of the buffered region. */
+  itkGetConstMacro( ReachedRegionBoundary, bool );
+  
+  /** Compute the region of the image that contains all the points within the given distance of
+    * the given point, cropped to the largest possible region. The region is empty if they are
+    * all outside the image. */
+  static InputImageRegionType ComputeTrackingRegion( const InputImageType *image, 
+    const InputImagePointType & point, double distance );
+  
+  /** Compute the smallest region that contains both regions. Empty regions are ignored. */
+  static InputImageRegionType MergeTrackingRegions( const InputImageRegionType & region1,
+    const InputImageRegionType & region2 );
+  
+  /** Set/Get the radius in pixels of the neighborhood prefetched by PrefetchNextStep(). 
+    * Default is 0. */
+  itkSetMacro( PrefetchRadius, unsigned int );
+  itkGetConstMacro( PrefetchRadius, unsigned int );
+  
+  /** Flag for pushing each completed section to the tracked section queue and invoking a 
+    * SectionTrackedEvent. Default is false. */
+  itkSetMacro( StreamSections, bool );
+  itkGetConstMacro( StreamSections, bool );
+  itkBooleanMacro( StreamSections );
+  
+  /** Flag for publishing the centerline of the current branch after each step, for readers in
+    * other threads. Default is false. */
+  itkSetMacro( PublishSections, bool );
+  itkGetConstMacro( PublishSections, bool );
+  itkBooleanMacro( PublishSections );
+  
+  /** Start tracking asynchronously. Track() is run on a new thread, so the input must be up to 
+    * date and the tracker must not be modified until tracking finishes. The tracked section 
+    * queue is cleared. Throws an exception if already tracking. */
+  void StartTracking();
+  
+  /** Wait for the asynchronous tracking to finish. If an exception was thrown while tracking, 
+    * it is thrown again here. */
+  void WaitForTracking();
+  
+  /** Stop the asynchronous tracking at the next step and wait for the thread. The sections 
+    * tracked until then are kept. */
+  void CancelTracking();
+  
+  /** Returns true while the asynchronous tracking is running. */
+  bool IsTracking() const;
+  
+  /** Retrieve the oldest section in the tracked section queue. Returns false if it is empty. */
+  bool PopTrackedSection( TrackedSection & trackedSection );
+  
+  /** Get the number of sections waiting in the tracked section queue. */
+  unsigned int GetNumberOfQueuedSections() const;
+  
+  /** Set/Get the token used to stop tracking. Default is NULL. */
+  itkSetObjectMacro( CancellationToken, CancellationToken );
+  itkGetObjectMacro( CancellationToken, CancellationToken );
+  
+  /** Returns true if the last tracking was stopped by the cancellation token, so the branch 
+    * is not complete. */
+  itkGetConstMacro( Interrupted, bool );
+  
+  /** Time in seconds from StartTracking() until the first section was streamed. */
+  itkGetConstMacro( FirstSectionLatency, double );
+  
+  /** Timing of the Turn, Search, Measure and Step stages and of the section estimation in 
+    * the last tracking, of the waits for the speculative section (see SetSpeculativeTurn()),
+    * and of the re-initializations of the image functions at a new scale. Enable its trace
+    * to see them along time. Empty unless built with IVAN_USE_PROFILING. */
+  itkGetObjectMacro( Profile, PerformanceProfile );
       
 protected:
   
   VesselTrackerFilter();
-  ~VesselTrackerFilter() {}
+  ~VesselTrackerFilter()
+    { this->StopTracking(); }
+  
+  /** Stop the asynchronous tracking at the next step and wait for the thread, without throwing 
+    * if tracking failed, and stop the speculation thread. Subclasses must call it first in 
+    * their destructor, while the members used by their stages are still alive. */
+  void StopTracking();
   
   virtual void GenerateData();
   
+  /** Request the region around the starting point if TrackingRegionRadius is set, or the 
+    * whole input otherwise. */
+  virtual void GenerateInputRequestedRegion();
+  
+  /** Grow the requested region of the input around the current point and update the input, if
+    * the pixels needed by the next step are not buffered. Only called from GenerateData(). 
+    * Returns true if the region was grown. */
+  bool GrowTrackingRegion();
+  
+  /** Returns true, and sets the reached boundary flag, if the pixels around the current point
+    * needed by the next step are in the image but not buffered. */
+  bool CheckRegionBoundary();
+  
   /** Initializes the algorithm. The default version creates a vessel graph with a single branch.
     * The initialization can also be used, for example, to search the vessel center from the starting point. */
   virtual void Initialize();
   
+  /** Take one step of the tracking loop in the current direction, appending a section to the 
+    * current branch. Returns false if the end condition is met or tracking is stopped. */
+  virtual bool StepInCurrentDirection();
+  
+  /** Start and finish tracking in the current direction, which starts and stops the speculation
+    * thread. */
+  void BeginDirection();
+  void EndDirection();
+  
+  /** Prepare for tracking the opposite direction in bidirectional mode. */
+  void BeginSecondDirection();
+  
+  /** Merge both directions in arclength order in bidirectional mode. */
+  void StitchDirections();
+  
   /** Search for the optimum vessel (center) location after we have adivanced the given step size. 
     * By default the search step is not implemented. Under the assumption of smoothness and with a small
     * step size, if the tracking method tracks the centerline (most common case) the next point can
@@ -172,6 +507,73 @@ protected:
   /** Check if we have finished. */
   virtual bool Finished();
   
+  /** Returns true, and sets the interrupted flag, if the cancellation token requests to stop. */
+  bool CheckStopRequested();
+  
+  /** Returns true, and removes the new section from the branch and sets the interrupted flag, 
+    * if the section estimator was stopped before estimating it. */
+  bool CheckSectionInterrupted();
+  
+  /** Update the step state with the current section, after the Measure stage. */
+  virtual void UpdateStepState();
+  
+  /** Publish the vesselness evaluated at the current section center, so that it is not 
+    * evaluated again by the end condition or the step confidence. */
+  void SetStepStateVesselness( double value )
+    { 
+      m_StepState.VesselnessValue = value;
+      m_StepState.VesselnessValid = true;
+    }
+  
+  /** Confidence in [0,1] on the current estimation, which scales the adaptive step, so that
+    * uncertain regions are tracked with smaller steps. By default this is 1.0. */
+  virtual double GetStepConfidence()
+    { return 1.0; }
+  
+  /** Compute the adaptive step size for the given section. */
+  virtual double ComputeAdaptiveStepSize( const SectionType *section );
+  
+  /** Reject the last step while the normal at the current section turns more than 
+    * MaximumNormalAngle, halving it and estimating the section again. */
+  virtual void RejectLargeTurns();
+  
+  /** Angle in radians between the normals of the section at the given index and the previous. */
+  double GetNormalAngle( unsigned int index ) const;
+  
+  /** Record a branch candidate at the current section. Returns false if it is discarded for
+    * being closer than MinimumBranchSeparation to the starting point or a previous candidate. */
+  bool AddBranchCandidate( const InputImagePointType & point, const DirectionType & direction );
+  
+  /** Push the section at the given index to the queue and invoke a SectionTrackedEvent. */
+  void StreamSection( unsigned int index );
+  
+  /** Thread function of the asynchronous tracking. */
+  static ITK_THREAD_RETURN_TYPE TrackingThreaderCallback( void *arg );
+  
+  /** Start the speculation thread. Returns false if the section estimator does not support it. */
+  bool StartSpeculation();
+  
+  /** Stop and join the speculation thread. */
+  void StopSpeculation();
+  
+  /** Add the section predicted from the current one to the centerline and start estimating it 
+    * on the speculation thread. */
+  void RequestSpeculation();
+  
+  /** Wait for the requested speculative section and remove it from the centerline, keeping it 
+    * for the next step. */
+  void WaitForSpeculation();
+  
+  /** Returns the kept speculative section if it was predicted within SpeculationTolerance of the
+    * current point, or NULL, updating the hit and miss counts. */
+  typename SectionType::Pointer TakeSpeculativeSection();
+  
+  /** Loop of the speculation thread. */
+  void ProcessSpeculations();
+  
+  /** Thread function of the speculation thread. */
+  static ITK_THREAD_RETURN_TYPE SpeculationThreaderCallback( void *arg );
+  
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -184,9 +586,37 @@ protected:
   bool                     m_EnableSearchStage;
   
   bool                     m_InvertDirection;
+  
+  bool                     m_Bidirectional;
 
   double                   m_InitialStepSize;
   
+  bool                     m_AdaptiveStepSize;
+  double                   m_MinimumStepSize;
+  double                   m_MaximumStepSize;
+  double                   m_RadiusStepFactor;
+  double                   m_MaximumNormalAngle;
+  
+  /** Size of the last step (unsigned) and number of rejected steps in adaptive mode. */
+  double                   m_LastStepSize;
+  unsigned int             m_NumberOfRejectedSteps;
+  
+  bool                     m_SpeculativeTurn;
+  double                   m_SpeculationTolerance;
+  unsigned int             m_NumberOfSpeculativeHits;
+  unsigned int             m_NumberOfSpeculativeMisses;
+  
+  bool                     m_DetectBranches;
+  double                   m_MinimumBranchSeparation;
+  
+  BranchCandidateContainerType  m_BranchCandidates;
+  
+  bool                     m_UseInitialDirection;
+  DirectionType            m_InitialDirection;
+  
+  /** Point given with SetStartingPoint(). */
+  InputImagePointType      m_StartingPoint;
+  
   /** This represents the vessel point in the last iteration. */
   InputImagePointType      m_PreviousPoint;
   
@@ -197,11 +627,80 @@ protected:
     
   EndConditionPointer      m_EndCondition;
   
+  /** State of the current step, shared with the end condition. */
+  StepStateType            m_StepState;
+  
   /** Current branch. */
   BranchNodePointer        m_CurrentBranch;
   
   /** Current point index in branch. */
   unsigned int             m_BranchPointIndex;  
+  
+  bool                     m_StreamSections;
+  bool                     m_PublishSections;
+  
+  /** True while tracking the opposite direction in bidirectional mode. */
+  bool                     m_TrackingSecondDirection;
+  
+  /** Completed sections not retrieved yet, protected by the queue mutex. */
+  std::deque<TrackedSection>          m_TrackedSectionQueue;
+  mutable itk::SimpleFastMutexLock    m_TrackedSectionQueueMutex;
+  
+  /** Asynchronous tracking. The error description is set if Track() threw an exception. */
+  itk::MultiThreader::Pointer   m_TrackingThreader;
+  int                           m_TrackingThreadId;
+  volatile bool                 m_Tracking;
+  bool                          m_TrackingFailed;
+  std::string                   m_TrackingErrorDescription;
+  
+  CancellationToken::Pointer    m_CancellationToken;
+  bool                          m_Interrupted;
+  
+  itk::TimeProbe                m_FirstSectionProbe;
+  double                        m_FirstSectionLatency;
+  
+  /** Speculation thread. The state and the requested section are protected by the mutex, and 
+    * both threads are woken up through the condition when the state changes. */
+  enum SpeculationStateType { SpeculationIdle, SpeculationRequested, SpeculationDone, SpeculationStopped };
+  
+  itk::MultiThreader::Pointer       m_SpeculationThreader;
+  int                               m_SpeculationThreadId;
+  itk::SimpleMutexLock              m_SpeculationMutex;
+  itk::ConditionVariable::Pointer   m_SpeculationCondition;
+  SpeculationStateType              m_SpeculationState;
+  unsigned int                      m_SpeculationSectionIndex;
+  bool                              m_SpeculationFailed;
+  bool                              m_SpeculationPending;
+  
+  /** Speculative section waiting for the next step, and the point where it was estimated. */
+  typename SectionType::Pointer     m_SpeculativeSection;
+  InputImagePointType               m_SpeculativePoint;
+  
+  /** True if the speculation thread is used in the current direction. */
+  bool                              m_SpeculationActive;
+  
+  unsigned int                      m_PrefetchRadius;
+  
+  double                            m_TrackingRegionRadius;
+  double                            m_TrackingRegionMargin;
+  unsigned int                      m_NumberOfRegionGrowths;
+  bool                              m_ReachedRegionBoundary;
+  
+  /** Stepwise tracking. The starting point and direction are kept for the opposite direction,
+    * and the sections of the first direction while the opposite one is tracked. */
+  bool                                                   m_Stepping;
+  InputImagePointType                                    m_SteppingStartingPoint;
+  bool                                                   m_SteppingInvertDirection;
+  std::vector<typename CenterlineType::SectionPointer>   m_FirstDirectionSections;
+  
+  PerformanceProfile::Pointer   m_Profile;
+  PerformanceProfile::ProbeIdType   m_TurnProbe;
+  PerformanceProfile::ProbeIdType   m_SearchProbe;
+  PerformanceProfile::ProbeIdType   m_MeasureProbe;
+  PerformanceProfile::ProbeIdType   m_StepProbe;
+  PerformanceProfile::ProbeIdType   m_SectionEstimationProbe;
+  PerformanceProfile::ProbeIdType   m_SpeculationWaitProbe;
+  PerformanceProfile::ProbeIdType   m_FunctionInitializationProbe;
 };
 
 } // end namespace ivan
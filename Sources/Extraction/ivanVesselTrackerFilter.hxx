@@ -31,6 +31,14 @@ SUCH DAMAGE.
 #define __ivanVesselTrackerFilter_hxx
 
 #include "ivanVesselTrackerFilter.h"
+#include "ivanMacros.h"
+
+#include "itkContinuousIndex.h"
+
+#include <vnl/vnl_math.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace ivan
 {
@@ -43,10 +51,60 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
 ::VesselTrackerFilter() :
   m_EnableSearchStage( true ),
   m_InvertDirection( false ),
+  m_Bidirectional( false ),
   m_InitialStepSize( 1.0 ),
-  m_BranchPointIndex(0)
+  m_AdaptiveStepSize( false ),
+  m_MinimumStepSize( 0.25 ),
+  m_MaximumStepSize( 4.0 ),
+  m_RadiusStepFactor( 1.0 ),
+  m_MaximumNormalAngle( vnl_math::pi / 6.0 ),
+  m_LastStepSize( 0.0 ),
+  m_NumberOfRejectedSteps( 0 ),
+  m_SpeculativeTurn( false ),
+  m_SpeculationTolerance( 0.1 ),
+  m_NumberOfSpeculativeHits( 0 ),
+  m_NumberOfSpeculativeMisses( 0 ),
+  m_DetectBranches( false ),
+  m_MinimumBranchSeparation( 10.0 ),
+  m_UseInitialDirection( false ),
+  m_BranchPointIndex(0),
+  m_StreamSections( false ),
+  m_PublishSections( false ),
+  m_TrackingSecondDirection( false ),
+  m_TrackingThreadId( -1 ),
+  m_Tracking( false ),
+  m_TrackingFailed( false ),
+  m_Interrupted( false ),
+  m_FirstSectionLatency( 0.0 ),
+  m_SpeculationThreadId( -1 ),
+  m_SpeculationState( SpeculationIdle ),
+  m_SpeculationSectionIndex( 0 ),
+  m_SpeculationFailed( false ),
+  m_SpeculationPending( false ),
+  m_SpeculationActive( false ),
+  m_PrefetchRadius( 0 ),
+  m_TrackingRegionRadius( 0.0 ),
+  m_TrackingRegionMargin( 0.0 ),
+  m_NumberOfRegionGrowths( 0 ),
+  m_ReachedRegionBoundary( false ),
+  m_Stepping( false ),
+  m_SteppingInvertDirection( false )
 {
+  m_InitialDirection.Fill( 0.0 );
+  m_StartingPoint.Fill( 0.0 );
+  m_SpeculativePoint.Fill( 0.0 );
+  m_SteppingStartingPoint.Fill( 0.0 );
+  
+  m_SpeculationCondition = itk::ConditionVariable::New();
   
+  m_Profile = PerformanceProfile::New();
+  m_TurnProbe = m_Profile->RegisterProbe( "Turn" );
+  m_SearchProbe = m_Profile->RegisterProbe( "Search" );
+  m_MeasureProbe = m_Profile->RegisterProbe( "Measure" );
+  m_StepProbe = m_Profile->RegisterProbe( "Step" );
+  m_SectionEstimationProbe = m_Profile->RegisterProbe( "SectionEstimation" );
+  m_SpeculationWaitProbe = m_Profile->RegisterProbe( "SpeculationWait" );
+  m_FunctionInitializationProbe = m_Profile->RegisterProbe( "FunctionInitialization" );
 }
 
 
@@ -92,7 +150,19 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
   // Assign the current centerline to the section estimator
   this->m_SectionEstimator->SetCenterline( this->m_CurrentBranch->GetCenterline() );
   
+  if( this->m_CancellationToken.IsNotNull() && !this->m_SectionEstimator->GetCancellationToken() )
+    this->m_SectionEstimator->SetCancellationToken( this->m_CancellationToken );
+  
+  this->m_Interrupted = false;
+  this->m_ReachedRegionBoundary = false;
+  
   this->m_BranchPointIndex = 0;
+  this->m_LastStepSize = 0.0;
+  this->m_NumberOfRejectedSteps = 0;
+  this->m_NumberOfSpeculativeHits = 0;
+  this->m_NumberOfSpeculativeMisses = 0;
+  this->m_BranchCandidates.clear();
+  this->m_StepState = StepStateType();
 }
 
 
@@ -104,32 +174,196 @@ void
 VesselTrackerFilter<TInputImage,TOutputVessel>
 ::GenerateData()
 {
-  //ImageConstPointer  inputImage = this->GetInput();
-  //OutputVesselPointer outputPtr = this->GetOutput(0);
+  this->m_NumberOfRegionGrowths = 0;
   
-  this->Initialize();
+  // The same loop as Track(), growing the input region before each step if needed
+  this->InitializeTracking();
+  
+  while( this->TrackStep() )
+    this->GrowTrackingRegion();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  if( !this->GetInput() )
+    return;
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
   
-  while( !this->Finished() )
+  if( this->m_TrackingRegionRadius <= 0.0 )
   {
-    // Create a new section
-    typename SectionType::Pointer newSection = SectionType::New();
-    newSection->SetCenter( this->m_CurrentPoint );
-    m_CurrentBranch->GetCenterline()->push_back( newSection );
-        
-    this->Turn();
+    input->SetRequestedRegionToLargestPossibleRegion();
+    return;
+  }
+  
+  const InputImageRegionType region = this->ComputeTrackingRegion( input, this->m_StartingPoint, 
+    this->m_TrackingRegionRadius + this->m_TrackingRegionMargin );
+  
+  // Starting points outside the image are left to the section estimator
+  if( region.GetNumberOfPixels() )
+    input->SetRequestedRegion( region );
+  else
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename VesselTrackerFilter<TInputImage,TOutputVessel>::InputImageRegionType
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::ComputeTrackingRegion( const InputImageType *image, const InputImagePointType & point, 
+  double distance )
+{
+  typedef itk::ContinuousIndex<double,InputImageDimension>  ContinuousIndexType;
+  
+  const InputImageRegionType & largestRegion = image->GetLargestPossibleRegion();
+  
+  ContinuousIndexType center;
+  image->TransformPhysicalPointToContinuousIndex( point, center );
+  
+  // Pad with the distance in pixels along the smallest spacing, which covers any orientation
+  double minimumSpacing = image->GetSpacing()[0];
+  
+  for( unsigned int dim=1; dim < InputImageDimension; ++dim )
+    minimumSpacing = vnl_math_min( minimumSpacing, (double)image->GetSpacing()[dim] );
+  
+  const double padding = distance / minimumSpacing;
+  
+  InputImageRegionType region;
+  
+  for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+  {
+    const long regionStart = largestRegion.GetIndex()[dim];
+    const long regionEnd = regionStart + static_cast<long>( largestRegion.GetSize()[dim] ) - 1;
     
-    if( this->GetEnableSearchStage() )
-      this->Search();
+    const long first = std::max( static_cast<long>( std::floor( center[dim] - padding ) ), regionStart );
+    const long last = std::min( static_cast<long>( std::ceil( center[dim] + padding ) ), regionEnd );
     
-    this->Measure();
-    this->Step();
-          
-#ifdef _DEBUG
-    // BREAK FOR DEBUG PURPOSES SO WE KNOW WHAT IS HAPPENING
-    if( this->m_BranchPointIndex == 140 )
-      break;
-#endif
+    region.SetIndex( dim, first );
+    region.SetSize( dim, ( last >= first ) ? last - first + 1 : 0 );
+  }
+  
+  if( !region.GetNumberOfPixels() )
+  {
+    typename InputImageRegionType::SizeType size;
+    size.Fill( 0 );
+    region.SetSize( size );
+  }
+  
+  return region;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename VesselTrackerFilter<TInputImage,TOutputVessel>::InputImageRegionType
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::MergeTrackingRegions( const InputImageRegionType & region1, const InputImageRegionType & region2 )
+{
+  if( !region1.GetNumberOfPixels() )
+    return region2;
+  
+  if( !region2.GetNumberOfPixels() )
+    return region1;
+  
+  InputImageRegionType region;
+  
+  for( unsigned int dim=0; dim < InputImageDimension; ++dim )
+  {
+    const long start1 = region1.GetIndex()[dim];
+    const long start2 = region2.GetIndex()[dim];
+    
+    const long first = std::min( start1, start2 );
+    const long last = std::max( start1 + static_cast<long>( region1.GetSize()[dim] ),
+      start2 + static_cast<long>( region2.GetSize()[dim] ) ) - 1;
+    
+    region.SetIndex( dim, first );
+    region.SetSize( dim, last - first + 1 );
   }
+  
+  return region;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::CheckRegionBoundary()
+{
+  if( this->m_TrackingRegionRadius <= 0.0 || !this->GetInput() )
+    return false;
+  
+  const InputImageType *input = this->GetInput();
+  
+  const InputImageRegionType region = 
+    this->ComputeTrackingRegion( input, this->m_CurrentPoint, this->m_TrackingRegionMargin );
+  
+  // Nothing can be buffered outside the image, that is left to the end condition
+  if( !region.GetNumberOfPixels() || input->GetBufferedRegion().IsInside( region ) )
+    return false;
+  
+  this->m_ReachedRegionBoundary = true;
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::GrowTrackingRegion()
+{
+  if( this->m_TrackingRegionRadius <= 0.0 || !this->GetInput() )
+    return false;
+  
+  InputImageType *input = const_cast<InputImageType *>( this->GetInput() );
+  
+  const InputImageRegionType neededRegion = 
+    this->ComputeTrackingRegion( input, this->m_CurrentPoint, this->m_TrackingRegionMargin );
+  
+  if( !neededRegion.GetNumberOfPixels() || input->GetBufferedRegion().IsInside( neededRegion ) )
+    return false;
+  
+  // Keep what is already buffered, so the sections tracked so far stay inside
+  const InputImageRegionType region = this->MergeTrackingRegions( input->GetBufferedRegion(), 
+    this->ComputeTrackingRegion( input, this->m_CurrentPoint, 
+      this->m_TrackingRegionRadius + this->m_TrackingRegionMargin ) );
+  
+  itkDebugMacro( "Growing the input region to " << region );
+  
+  const InputImageRegionType previousRegion = input->GetBufferedRegion();
+  
+  // Same as a streaming filter does for each of its pieces. An input without a source keeps 
+  // its buffer, and tracking stops at its boundary in the next step
+  input->SetRequestedRegion( region );
+  input->PropagateRequestedRegion();
+  input->UpdateOutputData();
+  
+  if( input->GetBufferedRegion() == previousRegion )
+    return false;
+  
+  ++this->m_NumberOfRegionGrowths;
+  this->InvokeEvent( TrackingRegionGrownEvent() );
+  
+  return true;
 }
 
 
@@ -139,13 +373,12 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
 template <class TInputImage, class TOutputVessel>
 void
 VesselTrackerFilter<TInputImage,TOutputVessel>
-::Turn()
+::Track()
 {
-  assert( this->m_SectionEstimator.IsNotNull() );
+  this->InitializeTracking();
   
-  // This computes the section normal which estimates the current vessel direction
-  this->m_SectionEstimator->SetSection( this->m_BranchPointIndex );
-  this->m_SectionEstimator->Compute();  
+  while( this->TrackStep() )
+    {}
 }
 
 
@@ -155,25 +388,232 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
 template <class TInputImage, class TOutputVessel>
 void
 VesselTrackerFilter<TInputImage,TOutputVessel>
-::Step()
+::InitializeTracking()
 {
-  assert( m_SectionEstimator.IsNotNull() );
+  this->m_Profile->Reset();
+  this->Initialize();
   
-  SectionType *section = this->m_CurrentBranch->GetCenterline()->at( this->m_BranchPointIndex );
+  this->m_TrackingSecondDirection = false;
   
-  double stepSize = this->m_InitialStepSize;
+  // Kept for tracking the opposite direction in bidirectional mode
+  this->m_SteppingStartingPoint = this->m_CurrentPoint;
+  this->m_SteppingInvertDirection = this->m_InvertDirection;
+  this->m_FirstDirectionSections.clear();
   
-  if( this->m_InvertDirection )
-    stepSize = -stepSize;  
+  this->BeginDirection();
+  this->m_Stepping = true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::TrackStep()
+{
+  if( !this->m_Stepping )
+    return false;
   
-  // By default use regular step size
-  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+  try
   {
-    this->m_PreviousPoint[dim] = this->m_CurrentPoint[dim];
-    this->m_CurrentPoint[dim]  = this->m_PreviousPoint[dim] + stepSize * section->GetNormal()[dim];
+    if( this->StepInCurrentDirection() )
+      return true;
+  }
+  catch( ... )
+  {
+    this->EndDirection();
+    this->m_Stepping = false;
+    throw;
   }
   
-  ++this->m_BranchPointIndex;
+  this->EndDirection();
+  
+  if( this->m_Bidirectional && !this->m_TrackingSecondDirection )
+  {
+    this->BeginSecondDirection();
+    this->BeginDirection();
+    return true;
+  }
+  
+  if( this->m_Bidirectional )
+    this->StitchDirections();
+  
+  this->m_Stepping = false;
+  return false;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::ResumeTracking( const CenterlineType *centerline, 
+  const BranchCandidateContainerType & candidates )
+{
+  if( this->m_Bidirectional )
+    itkExceptionMacro( "Tracking can only be resumed in unidirectional mode." );
+  
+  this->InitializeTracking();
+  
+  typename CenterlineType::Pointer currentCenterline = this->m_CurrentBranch->GetCenterline();
+  
+  // Replay the loop with the stored sections. The end condition is checked with the state of 
+  // the previous section, the same as in StepInCurrentDirection()
+  for( unsigned int i=0; i < centerline->size(); ++i )
+  {
+    if( this->Finished() )
+    {
+      this->EndDirection();
+      this->m_Stepping = false;
+      break;
+    }
+    
+    const SectionType *section = centerline->at(i);
+    currentCenterline->push_back( const_cast<SectionType*>( section ) );
+    
+    this->m_BranchPointIndex = i;
+    this->m_StepState.VesselnessValid = false;
+    
+    // The step that reached this section, which may have been reduced by RejectLargeTurns()
+    double squaredStepSize = 0.0;
+    
+    for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+    {
+      this->m_CurrentPoint[dim] = section->GetCenter()[dim];
+      
+      if( i > 0 )
+      {
+        const double delta = section->GetCenter()[dim] - centerline->at( i - 1 )->GetCenter()[dim];
+        squaredStepSize += delta * delta;
+      }
+    }
+    
+    this->m_LastStepSize = std::sqrt( squaredStepSize );
+    
+    this->UpdateStepState();
+    this->Step();
+    
+    if( this->m_StreamSections )
+      this->StreamSection( i );
+      
+    if( this->m_PublishSections )
+      currentCenterline->PublishSections();
+  }
+  
+  for( unsigned int c=0; c < candidates.size(); ++c )
+  {
+    if( candidates[c].SectionIndex < currentCenterline->size() )
+      this->m_BranchCandidates.push_back( candidates[c] );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::BeginSecondDirection()
+{
+  typename CenterlineType::Pointer centerline = this->m_CurrentBranch->GetCenterline();
+  
+  // Keep the sections of the first direction apart
+  this->m_FirstDirectionSections.assign( centerline->begin(), centerline->end() );
+  centerline->CastToSTLContainer().clear();
+  
+  if( this->m_PublishSections )
+    centerline->PublishSections();
+  
+  // Now track the opposite direction from the starting point again. The starting section is
+  // recomputed with the same estimator, so it gets the same normal and we step the other way
+  this->m_PreviousPoint = this->m_CurrentPoint = this->m_SteppingStartingPoint;
+  this->m_BranchPointIndex = 0;
+  this->m_LastStepSize = 0.0;
+  this->m_InvertDirection = !this->m_SteppingInvertDirection;
+  this->m_StepState = StepStateType();
+  this->m_TrackingSecondDirection = true;
+  
+  if( this->m_EndCondition.IsNotNull() )
+    this->m_EndCondition->Reset();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StitchDirections()
+{
+  typedef typename CenterlineType::SectionPointer   SectionPointer;
+  typedef std::vector<SectionPointer>               SectionContainer;
+  
+  typename CenterlineType::Pointer centerline = this->m_CurrentBranch->GetCenterline();
+  
+  this->m_InvertDirection = this->m_SteppingInvertDirection;
+  this->m_TrackingSecondDirection = false;
+  
+  SectionContainer firstSections;
+  firstSections.swap( this->m_FirstDirectionSections );
+  
+  SectionContainer secondSections( centerline->begin(), centerline->end() );
+  centerline->CastToSTLContainer().clear();
+  
+  // Stitch in arclength order. The opposite direction is reversed, skipping its starting section, 
+  // which is already the first of the first direction. Normals are consistent along the whole 
+  // centerline since both directions start from the same normal
+  for( int i = (int)secondSections.size() - 1; i > 0; --i )
+    centerline->push_back( secondSections[i] );
+  
+  if( firstSections.empty() && !secondSections.empty() )
+    centerline->push_back( secondSections[0] );
+  
+  for( unsigned int i=0; i < firstSections.size(); ++i )
+    centerline->push_back( firstSections[i] );
+  
+  this->m_BranchPointIndex = centerline->size();
+  
+  if( this->m_PublishSections )
+    centerline->PublishSections();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::BeginDirection()
+{
+  this->m_SpeculationActive = this->m_SpeculativeTurn && this->StartSpeculation();
+  this->m_SpeculativeSection = NULL;
+  
+  // The copies of the image functions are built once for all the steps of the direction
+  if( this->m_SpeculationActive )
+    this->m_SectionEstimator->BeginSpeculativeCompute();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::EndDirection()
+{
+  // The speculation thread may still be using the centerline if a stage threw an exception
+  this->WaitForSpeculation();
+  this->StopSpeculation();
+  this->m_SpeculationActive = false;
+  this->m_SpeculativeSection = NULL;
 }
 
 
@@ -183,11 +623,846 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
 template <class TInputImage, class TOutputVessel>
 bool
 VesselTrackerFilter<TInputImage,TOutputVessel>
-::Finished()
+::StepInCurrentDirection()
 {
-  assert( this->m_EndCondition.IsNotNull() );
+  if( this->GetAbortGenerateData() || this->CheckStopRequested() || this->CheckRegionBoundary() ||
+      this->Finished() )
+    return false;
   
-  return this->m_EndCondition->Finished();
+  // Create a new section, or keep the speculative one if we landed close enough to it
+  typename SectionType::Pointer newSection = this->TakeSpeculativeSection();
+  const bool speculated = newSection.IsNotNull();
+  
+  if( !speculated )
+    newSection = SectionType::New();
+  
+  newSection->SetCenter( this->m_CurrentPoint );
+  m_CurrentBranch->GetCenterline()->push_back( newSection );
+  
+  // Values published in the previous step are no longer valid
+  this->m_StepState.VesselnessValid = false;
+      
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_TurnProbe );
+    
+    if( speculated )
+    {
+      // Already estimated, it only needs to be consistent with the previous section. The 
+      // estimator is set to it anyway, since Search() may estimate it again
+      this->m_SectionEstimator->SetSection( this->m_BranchPointIndex );
+      this->m_SectionEstimator->EndSpeculativeCompute( this->m_BranchPointIndex );
+    }
+    else
+    {
+      this->Turn();
+      
+      if( this->CheckSectionInterrupted() )
+        return false;
+    }
+  
+    if( this->m_AdaptiveStepSize )
+      this->RejectLargeTurns();
+  }
+  
+  // The direction is not known until the first step is taken
+  if( this->m_SpeculationActive && this->m_BranchPointIndex > 0 )
+    this->RequestSpeculation();
+  
+  if( this->GetEnableSearchStage() )
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_SearchProbe );
+    this->Search();
+  }
+  
+  // The search stage may estimate the section again
+  if( this->CheckSectionInterrupted() )
+    return false;
+  
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_MeasureProbe );
+    this->Measure();
+  }
+  
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_SpeculationWaitProbe );
+    this->WaitForSpeculation();
+  }
+  
+  this->UpdateStepState();
+  
+  {
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_StepProbe );
+    this->Step();
+  }
+  
+  if( this->m_StreamSections )
+    this->StreamSection( this->m_BranchPointIndex - 1 );
+    
+  if( this->m_PublishSections )
+    this->m_CurrentBranch->GetCenterline()->PublishSections();
+        
+#ifdef _DEBUG
+  // BREAK FOR DEBUG PURPOSES SO WE KNOW WHAT IS HAPPENING
+  if( this->m_BranchPointIndex == 140 )
+    return false;
+#endif
+
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::PrefetchNextStep()
+{
+  if( !this->m_PrefetchRadius || !this->GetInput() )
+    return;
+  
+  const InputImageType *image = this->GetInput();
+  
+  InputImageIndexType index;
+  
+  if( !image->GetBufferPointer() || !image->TransformPhysicalPointToIndex( this->m_CurrentPoint, index ) )
+    return;
+  
+  typedef typename InputImageType::OffsetValueType  OffsetValueType;
+  
+  // The index is only checked against the largest possible region, and the neighborhood is
+  // clamped to the buffer assuming its center is inside
+  const InputImageRegionType & region = image->GetBufferedRegion();
+  
+  if( !region.IsInside( index ) )
+    return;
+  const OffsetValueType *offsetTable = image->GetOffsetTable();
+  const unsigned int dimension = InputImageType::GetImageDimension();
+  
+  const long radius = static_cast<long>( this->m_PrefetchRadius );
+  const long width = 2 * radius + 1;
+  
+  long first[InputImageDimension], last[InputImageDimension];
+  
+  for( unsigned int d=0; d<dimension; ++d )
+  {
+    const long start = region.GetIndex()[d];
+    const long end = start + static_cast<long>( region.GetSize()[d] ) - 1;
+    
+    first[d] = std::max( static_cast<long>( index[d] ) - radius, start ) - start;
+    last[d] = std::min( static_cast<long>( index[d] ) + radius, end ) - start;
+  }
+  
+  const InputImagePixelType *pixels = image->GetBufferPointer();
+  const unsigned long rowBytes = ( last[0] - first[0] + 1 ) * sizeof( InputImagePixelType );
+  
+  // One prefetch per cache line of every row of the neighborhood
+  for( long row=0; ; ++row )
+  {
+    long position = row;
+    OffsetValueType offset = first[0];
+    
+    for( unsigned int d=1; d<dimension; ++d )
+    {
+      offset += std::min( first[d] + position % width, last[d] ) * offsetTable[d];
+      position /= width;
+    }
+    
+    if( position > 0 )
+      break;
+    
+    const char *address = reinterpret_cast<const char *>( pixels + offset );
+    
+    for( unsigned long b=0; b<rowBytes; b+=64 )
+      ivanPrefetchMacro( address + b );
+    
+    ivanPrefetchMacro( address + rowBytes - 1 );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StartSpeculation()
+{
+  assert( this->m_SectionEstimator.IsNotNull() );
+  
+  if( !this->m_SectionEstimator->SupportsSpeculativeCompute() )
+    return false;
+  
+  if( this->m_SpeculationThreadId >= 0 )
+    return true;
+  
+  if( this->m_SpeculationThreader.IsNull() )
+    this->m_SpeculationThreader = itk::MultiThreader::New();
+  
+  this->m_SpeculationState = SpeculationIdle;
+  this->m_SpeculationPending = false;
+  this->m_SpeculationThreadId = this->m_SpeculationThreader->SpawnThread( this->SpeculationThreaderCallback, this );
+  
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StopSpeculation()
+{
+  if( this->m_SpeculationThreadId < 0 )
+    return;
+  
+  this->m_SpeculationMutex.Lock();
+  this->m_SpeculationState = SpeculationStopped;
+  this->m_SpeculationCondition->Broadcast();
+  this->m_SpeculationMutex.Unlock();
+  
+  // This joins the thread
+  this->m_SpeculationThreader->TerminateThread( this->m_SpeculationThreadId );
+  this->m_SpeculationThreadId = -1;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::RequestSpeculation()
+{
+  typename CenterlineType::Pointer centerline = this->m_CurrentBranch->GetCenterline();
+  const SectionType *section = centerline->at( this->m_BranchPointIndex );
+  
+  // Predict the next point as Step() would do before the section is refined
+  double stepSize = this->m_InitialStepSize;
+  
+  if( this->m_AdaptiveStepSize && this->m_LastStepSize > 0.0 )
+    stepSize = this->m_LastStepSize;
+  
+  if( this->m_InvertDirection )
+    stepSize = -stepSize;
+  
+  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+    this->m_SpeculativePoint[dim] = this->m_CurrentPoint[dim] + stepSize * section->GetNormal()[dim];
+  
+  // Some estimators choose the scale from the radius, so start from the current one
+  typename SectionType::Pointer speculativeSection = SectionType::New();
+  speculativeSection->SetCenter( this->m_SpeculativePoint );
+  speculativeSection->SetRadius( section->GetRadius() );
+  speculativeSection->SetScale( section->GetScale() );
+  
+  centerline->push_back( speculativeSection );
+  
+  this->m_SectionEstimator->PrepareSpeculativeSection( this->m_BranchPointIndex + 1 );
+  
+  this->m_SpeculationMutex.Lock();
+  this->m_SpeculationSectionIndex = this->m_BranchPointIndex + 1;
+  this->m_SpeculationFailed = false;
+  this->m_SpeculationState = SpeculationRequested;
+  this->m_SpeculationCondition->Broadcast();
+  this->m_SpeculationMutex.Unlock();
+  
+  this->m_SpeculationPending = true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::WaitForSpeculation()
+{
+  if( !this->m_SpeculationPending )
+    return;
+  
+  this->m_SpeculationMutex.Lock();
+  
+  while( this->m_SpeculationState == SpeculationRequested )
+    this->m_SpeculationCondition->Wait( &this->m_SpeculationMutex );
+  
+  const bool failed = this->m_SpeculationFailed;
+  this->m_SpeculationState = SpeculationIdle;
+  this->m_SpeculationMutex.Unlock();
+  
+  this->m_SpeculationPending = false;
+  
+  // The speculative section is always the last one, so the centerline is left as it was
+  typename CenterlineType::STLContainerType & sections = 
+    this->m_CurrentBranch->GetCenterline()->CastToSTLContainer();
+  
+  if( !failed )
+    this->m_SpeculativeSection = sections.back();
+  
+  sections.pop_back();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+typename VesselTrackerFilter<TInputImage,TOutputVessel>::SectionType::Pointer
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::TakeSpeculativeSection()
+{
+  typename SectionType::Pointer section = this->m_SpeculativeSection;
+  this->m_SpeculativeSection = NULL;
+  
+  if( section.IsNull() )
+    return section;
+  
+  double squaredDistance = 0.0;
+  
+  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+  {
+    const double difference = this->m_CurrentPoint[dim] - this->m_SpeculativePoint[dim];
+    squaredDistance += difference * difference;
+  }
+  
+  if( squaredDistance > this->m_SpeculationTolerance * this->m_SpeculationTolerance )
+  {
+    ++this->m_NumberOfSpeculativeMisses;
+    return NULL;
+  }
+  
+  ++this->m_NumberOfSpeculativeHits;
+  return section;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::ProcessSpeculations()
+{
+  this->m_SpeculationMutex.Lock();
+  
+  while( true )
+  {
+    while( this->m_SpeculationState == SpeculationIdle || this->m_SpeculationState == SpeculationDone )
+      this->m_SpeculationCondition->Wait( &this->m_SpeculationMutex );
+    
+    if( this->m_SpeculationState == SpeculationStopped )
+      break;
+    
+    const unsigned int sectionIndex = this->m_SpeculationSectionIndex;
+    this->m_SpeculationMutex.Unlock();
+    
+    // A failed speculation is just discarded, the section is estimated again in the next step
+    bool failed = false;
+    
+    try
+    {
+      this->m_SectionEstimator->ComputeSpeculativeSection( sectionIndex );
+    }
+    catch( ... )
+    {
+      failed = true;
+    }
+    
+    this->m_SpeculationMutex.Lock();
+    this->m_SpeculationFailed = failed;
+    this->m_SpeculationState = SpeculationDone;
+    this->m_SpeculationCondition->Broadcast();
+  }
+  
+  this->m_SpeculationMutex.Unlock();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+ITK_THREAD_RETURN_TYPE
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::SpeculationThreaderCallback( void *arg )
+{
+  Self *tracker = (Self *)( ((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData );
+  
+  tracker->ProcessSpeculations();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::Turn()
+{
+  assert( this->m_SectionEstimator.IsNotNull() );
+  
+  // This computes the section normal which estimates the current vessel direction
+  this->m_SectionEstimator->SetSection( this->m_BranchPointIndex );
+  
+  IVAN_PROFILE_SCOPE( this->m_Profile, this->m_SectionEstimationProbe );
+  this->m_SectionEstimator->Compute();  
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::Step()
+{
+  assert( m_SectionEstimator.IsNotNull() );
+  
+  SectionType *section = this->m_CurrentBranch->GetCenterline()->at( this->m_BranchPointIndex );
+  
+  double stepSize = this->m_InitialStepSize;
+  
+  if( this->m_AdaptiveStepSize )
+    stepSize = this->ComputeAdaptiveStepSize( section );
+  
+  this->m_LastStepSize = stepSize;
+  
+  // The sign of the first normal is arbitrary, so choose the direction closest to the given one
+  if( this->m_BranchPointIndex == 0 && this->m_UseInitialDirection && !this->m_Bidirectional )
+  {
+    double dotProduct = 0.0;
+    
+    for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+      dotProduct += section->GetNormal()[dim] * this->m_InitialDirection[dim];
+      
+    this->m_InvertDirection = ( dotProduct < 0.0 );
+  }
+  
+  if( this->m_InvertDirection )
+    stepSize = -stepSize;  
+  
+  // By default use regular step size
+  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+  {
+    this->m_PreviousPoint[dim] = this->m_CurrentPoint[dim];
+    this->m_CurrentPoint[dim]  = this->m_PreviousPoint[dim] + stepSize * section->GetNormal()[dim];
+  }
+  
+  ++this->m_BranchPointIndex;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+double
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::ComputeAdaptiveStepSize( const SectionType *section )
+{
+  // Step proportional to the local radius
+  double stepSize = this->m_InitialStepSize;
+  
+  if( section->GetRadius() > 0.0 )
+    stepSize = this->m_RadiusStepFactor * section->GetRadius();
+  
+  // Reduce with the curvature, estimated as the turn of the normal per unit length in the
+  // last step, so that the normal turns about half the maximum angle
+  if( this->m_BranchPointIndex > 0 && this->m_LastStepSize > 0.0 )
+  {
+    const double curvature = this->GetNormalAngle( this->m_BranchPointIndex ) / this->m_LastStepSize;
+    
+    if( curvature > 1e-6 )
+      stepSize = vnl_math_min( stepSize, 0.5 * this->m_MaximumNormalAngle / curvature );
+  }
+  
+  // Smaller steps where the estimation is not reliable
+  double confidence = this->GetStepConfidence();
+  
+  if( confidence < 0.0 )
+    confidence = 0.0;
+  else if( confidence > 1.0 )
+    confidence = 1.0;
+  
+  stepSize *= confidence;
+  
+  if( stepSize < this->m_MinimumStepSize )
+    stepSize = this->m_MinimumStepSize;
+  else if( stepSize > this->m_MaximumStepSize )
+    stepSize = this->m_MaximumStepSize;
+  
+  return stepSize;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::RejectLargeTurns()
+{
+  if( this->m_BranchPointIndex == 0 || this->m_LastStepSize <= 0.0 )
+    return;
+    
+  SectionType *section = this->m_CurrentBranch->GetCenterline()->at( this->m_BranchPointIndex );
+  const SectionType *previousSection = 
+    this->m_CurrentBranch->GetCenterline()->at( this->m_BranchPointIndex - 1 );
+  
+  while( this->GetNormalAngle( this->m_BranchPointIndex ) > this->m_MaximumNormalAngle &&
+    0.5 * this->m_LastStepSize >= this->m_MinimumStepSize )
+  {
+    this->m_LastStepSize *= 0.5;
+    
+    const double stepSize = this->m_InvertDirection ? -this->m_LastStepSize : this->m_LastStepSize;
+    
+    // Go back along the previous normal and estimate the section again at the new point
+    for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+      this->m_CurrentPoint[dim] = this->m_PreviousPoint[dim] + stepSize * previousSection->GetNormal()[dim];
+      
+    section->SetCenter( this->m_CurrentPoint );
+    this->Turn();
+    
+    ++this->m_NumberOfRejectedSteps;
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+double
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::GetNormalAngle( unsigned int index ) const
+{
+  assert( index > 0 );
+  
+  const SectionType *section = this->m_CurrentBranch->GetCenterline()->at( index );
+  const SectionType *previousSection = this->m_CurrentBranch->GetCenterline()->at( index - 1 );
+  
+  double dotProduct = 0.0;
+  
+  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension(); ++dim )
+    dotProduct += section->GetNormal()[dim] * previousSection->GetNormal()[dim];
+  
+  if( dotProduct > 1.0 )
+    dotProduct = 1.0;
+  else if( dotProduct < -1.0 )
+    dotProduct = -1.0;
+  
+  return std::acos( dotProduct );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::AddBranchCandidate( const InputImagePointType & point, const DirectionType & direction )
+{
+  const double minimumSquaredDistance = 
+    this->m_MinimumBranchSeparation * this->m_MinimumBranchSeparation;
+  
+  // Avoid detecting the parent vessel from the start of a child branch
+  if( point.SquaredEuclideanDistanceTo( this->m_StartingPoint ) < minimumSquaredDistance )
+    return false;
+  
+  for( unsigned int i=0; i < this->m_BranchCandidates.size(); ++i )
+  {
+    if( point.SquaredEuclideanDistanceTo( this->m_BranchCandidates[i].Point ) < minimumSquaredDistance )
+      return false;
+  }
+  
+  BranchCandidate candidate;
+  candidate.Point = point;
+  candidate.Direction = direction;
+  candidate.SectionIndex = this->m_BranchPointIndex;
+  
+  this->m_BranchCandidates.push_back( candidate );
+  
+  return true;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::Finished()
+{
+  assert( this->m_EndCondition.IsNotNull() );
+  
+  return this->m_EndCondition->Finished();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StreamSection( unsigned int index )
+{
+  TrackedSection trackedSection;
+  trackedSection.Section = this->m_CurrentBranch->GetCenterline()->at( index );
+  trackedSection.Index = index;
+  trackedSection.SecondDirection = this->m_TrackingSecondDirection;
+  
+  this->m_TrackedSectionQueueMutex.Lock();
+  
+  if( this->m_Tracking && this->m_FirstSectionLatency == 0.0 )
+  {
+    this->m_FirstSectionProbe.Stop();
+    this->m_FirstSectionLatency = this->m_FirstSectionProbe.GetMeanTime();
+  }
+  
+  this->m_TrackedSectionQueue.push_back( trackedSection );
+  this->m_TrackedSectionQueueMutex.Unlock();
+  
+  this->InvokeEvent( SectionTrackedEvent() );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::PopTrackedSection( TrackedSection & trackedSection )
+{
+  bool popped = false;
+  
+  this->m_TrackedSectionQueueMutex.Lock();
+  
+  if( !this->m_TrackedSectionQueue.empty() )
+  {
+    trackedSection = this->m_TrackedSectionQueue.front();
+    this->m_TrackedSectionQueue.pop_front();
+    popped = true;
+  }
+  
+  this->m_TrackedSectionQueueMutex.Unlock();
+  
+  return popped;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+unsigned int
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::GetNumberOfQueuedSections() const
+{
+  this->m_TrackedSectionQueueMutex.Lock();
+  const unsigned int size = this->m_TrackedSectionQueue.size();
+  this->m_TrackedSectionQueueMutex.Unlock();
+  
+  return size;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StartTracking()
+{
+  if( this->m_Tracking )
+    itkExceptionMacro( "Tracking already started." );
+  
+  if( this->m_TrackingThreader.IsNull() )
+    this->m_TrackingThreader = itk::MultiThreader::New();
+  
+  this->m_TrackedSectionQueueMutex.Lock();
+  this->m_TrackedSectionQueue.clear();
+  this->m_TrackedSectionQueueMutex.Unlock();
+  
+  this->SetAbortGenerateData( false );
+  this->m_TrackingFailed = false;
+  this->m_TrackingErrorDescription = "";
+  this->m_FirstSectionLatency = 0.0;
+  this->m_FirstSectionProbe = itk::TimeProbe();
+  this->m_FirstSectionProbe.Start();
+  
+  this->m_Tracking = true;
+  this->m_TrackingThreadId = this->m_TrackingThreader->SpawnThread( this->TrackingThreaderCallback, this );
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::WaitForTracking()
+{
+  if( this->m_TrackingThreadId < 0 )
+    return;
+  
+  // This joins the thread
+  this->m_TrackingThreader->TerminateThread( this->m_TrackingThreadId );
+  this->m_TrackingThreadId = -1;
+  
+  if( this->m_TrackingFailed )
+  {
+    this->m_TrackingFailed = false;
+    itkExceptionMacro( "Tracking failed: " << this->m_TrackingErrorDescription );
+  }
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::CancelTracking()
+{
+  this->SetAbortGenerateData( true );
+  this->WaitForTracking();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::StopTracking()
+{
+  if( this->m_TrackingThreadId >= 0 )
+  {
+    this->SetAbortGenerateData( true );
+    this->m_TrackingThreader->TerminateThread( this->m_TrackingThreadId );
+    this->m_TrackingThreadId = -1;
+    this->m_TrackingFailed = false;
+  }
+  
+  this->StopSpeculation();
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::IsTracking() const
+{
+  return this->m_Tracking;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+ITK_THREAD_RETURN_TYPE
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::TrackingThreaderCallback( void *arg )
+{
+  Self *tracker = (Self *)( ((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData );
+  
+  try
+  {
+    tracker->Track();
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    tracker->m_TrackingErrorDescription = e.GetDescription();
+    tracker->m_TrackingFailed = true;
+  }
+  catch( std::exception & e )
+  {
+    tracker->m_TrackingErrorDescription = e.what();
+    tracker->m_TrackingFailed = true;
+  }
+  
+  tracker->m_Tracking = false;
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+void
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::UpdateStepState()
+{
+  const SectionType *section = this->m_CurrentBranch->GetCenterline()->at( this->m_BranchPointIndex );
+  
+  this->m_StepState.Valid = true;
+  this->m_StepState.Branch = this->m_CurrentBranch.GetPointer();
+  this->m_StepState.SectionIndex = this->m_BranchPointIndex;
+  this->m_StepState.Scale = section->GetScale();
+  
+  for( unsigned int dim = 0; dim < InputImageType::GetImageDimension() && dim < 3; ++dim )
+    this->m_StepState.Position[dim] = section->GetCenter()[dim];
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::CheckStopRequested()
+{
+  if( this->m_CancellationToken.IsNotNull() && this->m_CancellationToken->IsStopRequested() )
+    this->m_Interrupted = true;
+  
+  return this->m_Interrupted;
+}
+
+
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel>
+bool
+VesselTrackerFilter<TInputImage,TOutputVessel>
+::CheckSectionInterrupted()
+{
+  if( !this->m_SectionEstimator->GetInterrupted() )
+    return false;
+  
+  // The speculation thread may be estimating the next section from this one
+  this->WaitForSpeculation();
+  
+  this->m_CurrentBranch->GetCenterline()->CastToSTLContainer().pop_back();
+  this->m_Interrupted = true;
+  
+  return true;
 }
 
 
@@ -202,10 +1477,38 @@ VesselTrackerFilter<TInputImage,TOutputVessel>
   Superclass::PrintSelf( os, indent );
   
   os << indent << "EnableSearchStage: " << this->m_EnableSearchStage << std::endl;
+  os << indent << "InvertDirection: " << this->m_InvertDirection << std::endl;
+  os << indent << "Bidirectional: " << this->m_Bidirectional << std::endl;
   os << indent << "InitialStepSize: " << this->m_InitialStepSize << std::endl;
+  os << indent << "AdaptiveStepSize: " << this->m_AdaptiveStepSize << std::endl;
+  os << indent << "MinimumStepSize: " << this->m_MinimumStepSize << std::endl;
+  os << indent << "MaximumStepSize: " << this->m_MaximumStepSize << std::endl;
+  os << indent << "RadiusStepFactor: " << this->m_RadiusStepFactor << std::endl;
+  os << indent << "MaximumNormalAngle: " << this->m_MaximumNormalAngle << std::endl;
+  os << indent << "NumberOfRejectedSteps: " << this->m_NumberOfRejectedSteps << std::endl;
+  os << indent << "SpeculativeTurn: " << this->m_SpeculativeTurn << std::endl;
+  os << indent << "SpeculationTolerance: " << this->m_SpeculationTolerance << std::endl;
+  os << indent << "NumberOfSpeculativeHits: " << this->m_NumberOfSpeculativeHits << std::endl;
+  os << indent << "NumberOfSpeculativeMisses: " << this->m_NumberOfSpeculativeMisses << std::endl;
+  os << indent << "DetectBranches: " << this->m_DetectBranches << std::endl;
+  os << indent << "MinimumBranchSeparation: " << this->m_MinimumBranchSeparation << std::endl;
+  os << indent << "NumberOfBranchCandidates: " << this->m_BranchCandidates.size() << std::endl;
+  os << indent << "UseInitialDirection: " << this->m_UseInitialDirection << std::endl;
+  os << indent << "InitialDirection: " << this->m_InitialDirection << std::endl;
   os << indent << "PreviousPoint: " << this->m_PreviousPoint << std::endl;
   os << indent << "CurrentPoint: " << this->m_CurrentPoint << std::endl;
   os << indent << "BranchPointIndex: " << this->m_BranchPointIndex << std::endl;
+  os << indent << "StreamSections: " << this->m_StreamSections << std::endl;
+  os << indent << "PublishSections: " << this->m_PublishSections << std::endl;
+  os << indent << "PrefetchRadius: " << this->m_PrefetchRadius << std::endl;
+  os << indent << "TrackingRegionRadius: " << this->m_TrackingRegionRadius << std::endl;
+  os << indent << "TrackingRegionMargin: " << this->m_TrackingRegionMargin << std::endl;
+  os << indent << "NumberOfRegionGrowths: " << this->m_NumberOfRegionGrowths << std::endl;
+  os << indent << "ReachedRegionBoundary: " << this->m_ReachedRegionBoundary << std::endl;
+  os << indent << "Stepping: " << this->m_Stepping << std::endl;
+  os << indent << "Tracking: " << this->m_Tracking << std::endl;
+  os << indent << "Interrupted: " << this->m_Interrupted << std::endl;
+  os << indent << "FirstSectionLatency: " << this->m_FirstSectionLatency << std::endl;
 }
 
 } // end namespace ivan
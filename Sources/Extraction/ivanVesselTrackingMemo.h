@@ -0,0 +1,184 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTrackingMemo.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: parameters and state kept with a tracked branch for reusing it.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselTrackingMemo_h
+#define __ivanVesselTrackingMemo_h
+
+#include "ivanVesselTrackerFilter.h"
+
+#include <vxl_config.h>
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class VesselTrackingMemo
+ *  \brief Parameters and results of the tracking of a branch, kept with the branch.
+ *
+ * This object is attached to the branches tracked by MultiSeedVesselTrackerFilter when 
+ * ReuseUnchangedBranches is on (see VesselBranchNode::SetTrackingMemo()). It records the seed
+ * the branch was tracked from, the parameter keys given by the tracker factory, a hash of the 
+ * input image in the region around the branch and the branch candidates detected, so that the 
+ * branch can be reused, or its tracking resumed, when the filter is updated again.
+ *
+ * This class is templated over the input image and output vessel types of the trackers.
+ *
+ * \sa MultiSeedVesselTrackerFilter
+ * \sa VesselTrackerFactory
+ */
+
+template <class TInputImage, class TOutputVessel>
+class ITK_EXPORT VesselTrackingMemo : public itk::Object
+{
+public:
+  
+  typedef VesselTrackingMemo               Self;
+  typedef itk::Object                      Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  typedef itk::SmartPointer<const Self>    ConstPointer;
+  
+  typedef VesselTrackerFilter<TInputImage,TOutputVessel>   TrackerType;
+  typedef typename TrackerType::InputImagePointType        PointType;
+  typedef typename TrackerType::DirectionType              DirectionType;
+  typedef typename TrackerType::BranchCandidateContainerType  
+                                                           BranchCandidateContainerType;
+  typedef typename TInputImage::RegionType                 RegionType;
+  
+  typedef vxl_uint_64                                      HashType;
+  
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselTrackingMemo, itk::Object );
+  
+  /** Set/Get the starting point of the tracker. */
+  itkSetMacro( StartingPoint, PointType );
+  itkGetConstReferenceMacro( StartingPoint, PointType );
+  
+  /** Set/Get the initial direction of the tracker, only used if UseInitialDirection is true. */
+  itkSetMacro( InitialDirection, DirectionType );
+  itkGetConstReferenceMacro( InitialDirection, DirectionType );
+  
+  itkSetMacro( UseInitialDirection, bool );
+  itkGetConstMacro( UseInitialDirection, bool );
+  
+  /** Set/Get whether branch detection was enabled in the tracker. */
+  itkSetMacro( DetectBranches, bool );
+  itkGetConstMacro( DetectBranches, bool );
+  
+  /** Set/Get the keys of the tracker parameters (see VesselTrackerFactory). */
+  itkSetStringMacro( SectionParametersKey );
+  itkGetStringMacro( SectionParametersKey );
+  itkSetStringMacro( EndConditionParametersKey );
+  itkGetStringMacro( EndConditionParametersKey );
+  
+  /** Set/Get the input region hashed and its hash. */
+  itkSetMacro( ImageRegion, RegionType );
+  itkGetConstReferenceMacro( ImageRegion, RegionType );
+  itkSetMacro( ImageHash, HashType );
+  itkGetConstMacro( ImageHash, HashType );
+  
+  /** Set/Get the branch candidates detected by the tracker. */
+  void SetBranchCandidates( const BranchCandidateContainerType & candidates )
+    { 
+      m_BranchCandidates = candidates; 
+      this->Modified();
+    }
+  const BranchCandidateContainerType & GetBranchCandidates() const
+    { return m_BranchCandidates; }
+  
+  /** Returns true if the branch was tracked from the given seed and parameters. The image 
+    * hash is not compared. */
+  bool Matches( const PointType & startingPoint, const DirectionType & initialDirection,
+    bool useInitialDirection, bool detectBranches, const std::string & sectionParametersKey ) const
+    {
+      if( sectionParametersKey.empty() || sectionParametersKey != m_SectionParametersKey ||
+          startingPoint != m_StartingPoint || useInitialDirection != m_UseInitialDirection ||
+          detectBranches != m_DetectBranches )
+        return false;
+      
+      return ( !useInitialDirection || initialDirection == m_InitialDirection );
+    }
+
+protected:
+  
+  VesselTrackingMemo() :
+    m_UseInitialDirection( false ),
+    m_DetectBranches( false ),
+    m_ImageHash( 0 )
+    {
+      m_StartingPoint.Fill( 0.0 );
+      m_InitialDirection.Fill( 0.0 );
+    }
+  virtual ~VesselTrackingMemo() {}
+  
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const
+    {
+      Superclass::PrintSelf( os, indent );
+      
+      os << indent << "StartingPoint: " << m_StartingPoint << std::endl;
+      os << indent << "InitialDirection: " << m_InitialDirection << std::endl;
+      os << indent << "UseInitialDirection: " << m_UseInitialDirection << std::endl;
+      os << indent << "DetectBranches: " << m_DetectBranches << std::endl;
+      os << indent << "SectionParametersKey: " << m_SectionParametersKey << std::endl;
+      os << indent << "EndConditionParametersKey: " << m_EndConditionParametersKey << std::endl;
+      os << indent << "ImageRegion: " << m_ImageRegion << std::endl;
+      os << indent << "ImageHash: " << m_ImageHash << std::endl;
+      os << indent << "NumberOfBranchCandidates: " << m_BranchCandidates.size() << std::endl;
+    }
+      
+private:
+  
+  VesselTrackingMemo(const Self&); //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+  
+protected:
+  
+  PointType       m_StartingPoint;
+  DirectionType   m_InitialDirection;
+  bool            m_UseInitialDirection;
+  bool            m_DetectBranches;
+  
+  std::string     m_SectionParametersKey;
+  std::string     m_EndConditionParametersKey;
+  
+  RegionType      m_ImageRegion;
+  HashType        m_ImageHash;
+  
+  BranchCandidateContainerType  m_BranchCandidates;
+};
+
+} // end namespace ivan
+
+#endif
@@ -107,7 +107,9 @@ public:
   
   /** Set/Get the VesselnessImageFunction to use. This can be a vesselness calculated from a source
     * image as an image function, or, if the full vesselness image has been previously calculated,
-    * can be an interpolator of that image, such as nearest neighbour or linear interpolator. */
+    * can be an interpolator of that image, such as nearest neighbour or linear interpolator. 
+    * ResponseImageFunction, initialized with ResponseImageFunctionInitializer, also samples the
+    * scale image of a multiscale detection to attenuate the responses at other scales. */
   virtual void SetVesselnessImageFunction( VesselnessFunctionType *func )
     {
       m_VesselnessFunction = func;
@@ -126,7 +128,13 @@ public:
 protected:
   
   VesselnessBasedSearchVesselTrackerFilter();
-  ~VesselnessBasedSearchVesselTrackerFilter() {}
+  ~VesselnessBasedSearchVesselTrackerFilter()
+    { this->StopTracking(); }
+  
+  /** Reimplemented to use the vesselness at the current point relative to the vesselness at
+    * the starting point of the branch as the confidence for the adaptive step size. The value 
+    * published in the step state by the search stage is used if available. */
+  virtual double GetStepConfidence();
   
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
@@ -143,6 +151,9 @@ protected:
     * initialization for the metrics of all scales and during the search stage whenever the
     * scale changes. */
   VesselnessFunctionInitializerPointer       m_VesselnessFunctionInitializer;
+  
+  /** Vesselness at the starting point of the branch, used as reference of the step confidence. */
+  double                                     m_ReferenceVesselnessValue;
 };
 
 } // end namespace ivan
@@ -42,7 +42,8 @@ namespace ivan
  */
 template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
 VesselnessBasedSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
-::VesselnessBasedSearchVesselTrackerFilter()
+::VesselnessBasedSearchVesselTrackerFilter() :
+  m_ReferenceVesselnessValue( 0.0 )
 {
   // This can be provided externally, but at least create a default one
   this->m_VesselnessFunction = VesselnessFunctionType::New();
@@ -109,6 +110,29 @@ VesselnessBasedSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
 }
 
 
+/**
+ *
+ */
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+double
+VesselnessBasedSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::GetStepConfidence()
+{
+  // Use the value evaluated in the search stage if available
+  const double value = this->m_StepState.VesselnessValid ? 
+    this->m_StepState.VesselnessValue : this->GetVesselnessValueAtCurrentPoint();
+  
+  // The first point of the branch gives the reference
+  if( this->m_BranchPointIndex == 0 )
+    this->m_ReferenceVesselnessValue = value;
+  
+  if( this->m_ReferenceVesselnessValue <= 0.0 )
+    return 1.0;
+  
+  return value / this->m_ReferenceVesselnessValue;
+}
+
+
 /**
  *
  */
@@ -72,6 +72,12 @@ private:
  * This class implements and end condition for vessel tracking based on a value of
  * vesselness. The value functor is used to compute the condition
  *
+ * When used from a VesselTrackerFilter, the vesselness published in the step state by the 
+ * search stage is used if available and UseStepStateVesselness is on, so the vesselness function
+ * is not evaluated again at the same point. Otherwise, the vesselness function is evaluated at 
+ * the center of the current section, or at the given position if there is no step state. Points
+ * outside the buffer of the vesselness function have zero vesselness.
+ *
  */
 
 template <class TVesselnessFunction, class TValueFunctor = 
@@ -112,8 +118,18 @@ public:
   const VesselnessFunctionType * GetVesselnessFunction() const
     { return this->m_VesselnessFunction.GetPointer(); }
     
-  void SetPosition( PointType *position )
+  /** Set the position where the vesselness is evaluated if there is no step state. */
+  void SetPosition( const PointType & position )
     { this->m_Position = position; }
+  const PointType & GetPosition() const
+    { return this->m_Position; }
+  
+  /** Use the vesselness published by the tracker in the step state, if available. This should
+    * be turned off if the vesselness function of the end condition is not the one used by the 
+    * tracker. Default is true. */
+  itkSetMacro( UseStepStateVesselness, bool );
+  itkGetConstMacro( UseStepStateVesselness, bool );
+  itkBooleanMacro( UseStepStateVesselness );
     
   /** Set/Get the value functor which calculates the condition based on the vesselness value. 
     * This is created by default, but may be useful to access it to set/get properties. 
@@ -124,6 +140,10 @@ public:
     { return &this->m_ValueFunctor; }
   
   virtual bool Finished();
+  
+  /** The vesselness function is evaluated unless the value is published in the step state. */
+  virtual double GetEvaluationCost() const
+    { return this->m_UseStepStateVesselness ? 10.0 : 100.0; }
 
 protected:
   
@@ -143,6 +163,8 @@ protected:
   ValueFunctorType           m_ValueFunctor;
   
   PointType                  m_Position;
+  
+  bool                       m_UseStepStateVesselness;
 };
 
 } // end namespace ivan
@@ -40,7 +40,8 @@ namespace ivan
 
 template <class TVesselnessFunction, class TValueFunctor>
 VesselnessBasedVesselTrackerEndCondition<TVesselnessFunction,TValueFunctor>
-::VesselnessBasedVesselTrackerEndCondition()
+::VesselnessBasedVesselTrackerEndCondition() :
+  m_UseStepStateVesselness( true )
 {
   this->m_VesselnessFunction = VesselnessFunctionType::New();
   this->m_Position.Fill(0.0);
@@ -52,7 +53,27 @@ bool
 VesselnessBasedVesselTrackerEndCondition<TVesselnessFunction,TValueFunctor>
 ::Finished()
 {
-  return ( this->m_ValueFunctor( this->m_VesselnessFunction->Evaluate( this->m_Position ) ) );
+  PointType position = this->m_Position;
+  
+  if( this->m_StepState )
+  {
+    // Nothing has been tracked yet
+    if( !this->m_StepState->Valid )
+      return false;
+    
+    if( this->m_UseStepStateVesselness && this->m_StepState->VesselnessValid )
+      return this->m_ValueFunctor( static_cast<VesselnessValueType>( this->m_StepState->VesselnessValue ) );
+    
+    for( unsigned int i=0; i < PointType::PointDimension && i < 3; ++i )
+      position[i] = this->m_StepState->Position[i];
+  }
+  
+  VesselnessValueType value = itk::NumericTraits<VesselnessValueType>::Zero;
+  
+  if( this->m_VesselnessFunction->IsInsideBuffer( position ) )
+    value = this->m_VesselnessFunction->Evaluate( position );
+  
+  return this->m_ValueFunctor( value );
 }
 	
 
@@ -64,6 +85,7 @@ VesselnessBasedVesselTrackerEndCondition<TVesselnessFunction,TValueFunctor>
   Superclass::PrintSelf( os, indent );
   
   os << indent << "Position: " << this->m_Position << std::endl;
+  os << indent << "UseStepStateVesselness: " << this->m_UseStepStateVesselness << std::endl;
 }
 
 } // end namespace ivan
@@ -31,9 +31,16 @@ SUCH DAMAGE.
 #define __ivanVesselnessRidgeSearchVesselTrackerFilter_h
 
 #include "ivanVesselnessBasedSearchVesselTrackerFilter.h"
+#include "ivanCircleSampler.h"
+#include "ivanBufferInteriorRegion.h"
+#include "ivanDiscreteDerivativeCache.h"
+#include "ivanScaledImageFunctionCache.h"
 
 #include "itkArray.h"
 
+#include <vector>
+#include <algorithm>
+
 
 namespace ivan
 {
@@ -44,6 +51,39 @@ namespace ivan
  * VesselnessRidgeSearchVesselTrackerFilter searches for the local ridges of vesselness 
  * in order to find the best plane center and normal.
  *
+ * If DetectBranches is on, a ring of radius BranchSearchRadius is sampled in the section plane 
+ * after the search. Each local maximum of vesselness in the ring with a value of at least 
+ * BranchVesselnessRatio times the vesselness at the center is recorded as a branch candidate,
+ * pointing from the center towards the maximum.
+ *
+ * Consecutive search disks overlap, so if UseSampleCache is on, the vesselness of the samples is
+ * memoized for the current branch, indexed by the scale of the section and by the sample position 
+ * quantized to SampleCacheTolerance. Samples falling in the same quantization cell at the same 
+ * scale reuse the first value computed, so the tolerance should be small compared to the vessel
+ * radius. The cache is cleared at the start of every branch.
+ *
+ * The default search is exhaustive over RadialResolution x AngularResolution samples. If 
+ * CoarseToFineSearch is on, a sparse search over CoarseRadialResolution rings of 
+ * CoarseAngularResolution samples is done first. Then, the best point is refined with 
+ * RefinementIterations compass iterations in the section plane, which evaluate the four 
+ * neighbours along the plane axes and halve their distance after each iteration, starting from the
+ * coarse ring spacing. Finally GradientAscentIterations steps along the in-plane vesselness 
+ * gradient, estimated with central differences at the last refinement distance, can be taken. 
+ * The search is restricted to MaximumSearchDistance from the initial center.
+ *
+ * The centers whose search samples all lie inside the buffer of the input image are found with
+ * a BufferInteriorRegion computed once per branch. For these centers the samples are evaluated 
+ * without testing each of them, and the tests are only done near the borders.
+ *
+ * The vesselness function is initialized again only when the scale of the section changes. If 
+ * UseVesselnessFunctionPool is on, the function of each scale is instead taken from a pool of 
+ * functions initialized once, so that alternating scales do not rebuild the kernels. If 
+ * VesselnessFunctionScales are given, usually the scales of a multiscale section estimator, the 
+ * scale of each section is rounded to the nearest of them and their functions are initialized when 
+ * the branch starts. The pool is a ScaledImageFunctionCache, so it can be shared with other 
+ * objects that use the same function type, image and initializer, or filled beforehand with 
+ * already initialized functions.
+ *
  */
 
 template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
@@ -82,6 +122,24 @@ public:
   typedef TVesselnessFunction                            VesselnessFunctionType;
   typedef typename VesselnessFunctionType::Pointer       VesselnessFunctionPointer;
   typedef typename VesselnessFunctionType::OutputType    VesselnessValueType;
+  
+  /** Generation of the circle samples. */
+  typedef CircleSampler<InputImageType>                  CircleSamplerType;
+  typedef typename CircleSamplerType::SampleSet          CircleSampleSetType;
+  typedef typename CircleSamplerType::PointType          SamplePointType;
+  
+  /** Centers whose search samples need no bounds checks. */
+  typedef BufferInteriorRegion<InputImageType>           SearchInteriorType;
+  
+  /** Memo of vesselness values, indexed by scale and quantized position. */
+  typedef DiscreteDerivativeCache<double, 
+    InputImageType::ImageDimension>                      SampleCacheType;
+  typedef typename SampleCacheType::Pointer              SampleCachePointer;
+  
+  /** Pool of vesselness functions initialized for each scale. */
+  typedef ScaledImageFunctionCache<VesselnessFunctionType> VesselnessFunctionPoolType;
+  typedef typename VesselnessFunctionPoolType::Pointer   VesselnessFunctionPoolPointer;
+  typedef std::vector<double>                            ScaleVectorType;
 
 public:
   
@@ -110,10 +168,108 @@ public:
   virtual void SetAngularResolution( const unsigned int resolution );
   itkGetConstMacro( AngularResolution, unsigned int );
   
+  /** Flag for the coarse-to-fine search. Default is false. */
+  itkSetMacro( CoarseToFineSearch, bool );
+  itkGetConstMacro( CoarseToFineSearch, bool );
+  itkBooleanMacro( CoarseToFineSearch );
+  
+  /** Set/Get the number of rings and samples per ring in the coarse stage. Defaults are 1 and 6. */
+  itkSetMacro( CoarseRadialResolution, unsigned int );
+  itkGetConstMacro( CoarseRadialResolution, unsigned int );
+  virtual void SetCoarseAngularResolution( unsigned int resolution );
+  itkGetConstMacro( CoarseAngularResolution, unsigned int );
+  
+  /** Set/Get the number of refinement iterations. Default is 1. */
+  itkSetMacro( RefinementIterations, unsigned int );
+  itkGetConstMacro( RefinementIterations, unsigned int );
+  
+  /** Set/Get the number of gradient ascent iterations after the refinement. Default is 0. */
+  itkSetMacro( GradientAscentIterations, unsigned int );
+  itkGetConstMacro( GradientAscentIterations, unsigned int );
+  
+  /** Get the number of vesselness samples requested in the current branch, including the ones
+    * found in the sample cache and the ones of branch detection. */
+  itkGetConstMacro( NumberOfSearchSamples, unsigned long );
+  
+  /** Set/Get the radius of the ring sampled for branch detection. If not positive, 
+    * MaximumSearchDistance is used. Default is 0.0. */
+  itkSetMacro( BranchSearchRadius, double );
+  itkGetConstMacro( BranchSearchRadius, double );
+  
+  /** Set/Get the minimum ratio between the vesselness of a ring maximum and the one at the center
+    * for the maximum to be considered a branch. Default is 0.5. */
+  itkSetMacro( BranchVesselnessRatio, double );
+  itkGetConstMacro( BranchVesselnessRatio, double );
+  
+  /** Flag for memoizing the vesselness of the search samples in the current branch. 
+    * Default is false. */
+  itkSetMacro( UseSampleCache, bool );
+  itkGetConstMacro( UseSampleCache, bool );
+  itkBooleanMacro( UseSampleCache );
+  
+  /** Set/Get the size of the cells, in physical units, in which sample positions are quantized
+    * for the sample cache. Default is 0.1. */
+  itkSetMacro( SampleCacheTolerance, double );
+  itkGetConstMacro( SampleCacheTolerance, double );
+  
+  /** Get the sample cache, for example to query the number of hits and misses, which indicate
+    * the effect of the tolerance. */
+  const SampleCacheType * GetSampleCache() const
+    { return m_SampleCache.GetPointer(); }
+  
+  /** Set/Get the number of search samples ahead of the current one whose neighborhoods are
+    * prefetched before evaluating the vesselness. Zero disables prefetching. Default is 0. */
+  void SetPrefetchDistance( unsigned int distance )
+    {
+    if( distance != this->m_CircleSampler.GetPrefetchDistance() )
+      {
+      this->m_CircleSampler.SetPrefetchDistance( distance );
+      this->m_CoarseCircleSampler.SetPrefetchDistance( distance );
+      this->Modified();
+      }
+    }
+  unsigned int GetPrefetchDistance() const
+    { return this->m_CircleSampler.GetPrefetchDistance(); }
+  
+  /** Set the vesselness function given by the user, which is the one initialized for each scale
+    * when the pool is not used. */
+  virtual void SetVesselnessImageFunction( VesselnessFunctionType *func )
+    {
+    this->m_UnpooledVesselnessFunction = 0;
+    this->m_VesselnessFunctionScale = -1.0;
+    Superclass::SetVesselnessImageFunction( func );
+    }
+  
+  /** Flag for taking the vesselness function of each scale from the pool. The functions of the 
+    * pool are created with New() and set up only by the VesselnessFunctionInitializer, so it must 
+    * initialize them completely. While tracking, GetVesselnessImageFunction() returns the function 
+    * of the current scale. Default is false. */
+  itkSetMacro( UseVesselnessFunctionPool, bool );
+  itkGetConstMacro( UseVesselnessFunctionPool, bool );
+  itkBooleanMacro( UseVesselnessFunctionPool );
+  
+  /** Set/Get the discrete scales of the pool. If not empty, the scale of each section is rounded 
+    * to the nearest of them. Otherwise, the pool keeps one function per section scale. Empty by 
+    * default. */
+  void SetVesselnessFunctionScales( const ScaleVectorType & scales )
+    {
+    this->m_VesselnessFunctionScales = scales;
+    std::sort( this->m_VesselnessFunctionScales.begin(), this->m_VesselnessFunctionScales.end() );
+    this->Modified();
+    }
+  const ScaleVectorType & GetVesselnessFunctionScales() const
+    { return this->m_VesselnessFunctionScales; }
+  
+  /** Set/Get the pool of vesselness functions. It is cleared when the input image changes between
+    * branches. Created by default. */
+  itkSetObjectMacro( VesselnessFunctionPool, VesselnessFunctionPoolType );
+  itkGetObjectMacro( VesselnessFunctionPool, VesselnessFunctionPoolType );
+  
 protected:
   
   VesselnessRidgeSearchVesselTrackerFilter();
-  ~VesselnessRidgeSearchVesselTrackerFilter() {}
+  ~VesselnessRidgeSearchVesselTrackerFilter()
+    { this->StopTracking(); }
   
   /** Pre-computes some calculations used in the sampling. */ 
   void ComputeIntervals();
@@ -121,6 +277,30 @@ protected:
   /** Reimplemente the search for the optimum as a local optimization of the vesselness function. */
   virtual void Search();
   
+  /** Make the vesselness function ready for the scale of the current section, initializing it
+    * again if the scale changed or taking it from the pool. */
+  void SelectVesselnessFunction( InputImageType *inputImage, double scale );
+  
+  /** Get the function of the pool for the given scale, creating and initializing it if needed. */
+  VesselnessFunctionType * GetPooledVesselnessFunction( InputImageType *inputImage, double scale );
+  
+  /** Evaluate the vesselness at the given sample point, which must be inside the image buffer, 
+    * using the sample cache if enabled. */
+  double EvaluateVesselnessAtSample( const SamplePointType & point, double scale );
+  
+  /** Same as EvaluateVesselnessAtSample() but returns zero outside the buffer. */
+  double EvaluateVesselnessAtPoint( const SamplePointType & point, double scale );
+  
+  /** Coarse-to-fine search around the center in the plane given by the basis vectors. The maximum
+    * value and point are updated if a larger value is found, and true is returned. */
+  template <class TVector>
+  bool CoarseToFineSearch( const SamplePointType & center, const TVector & firstBaseVector,
+    const TVector & secondBaseVector, double scale, double & maximumValue, 
+    SamplePointType & maximumPoint );
+  
+  /** Sample the branch detection ring at the current section and record the branch candidates. */
+  virtual void DetectBranchesInSection( InputImageType *inputImage, SectionType *section );
+  
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
 
 private:
@@ -143,9 +323,43 @@ protected:
     * depends on the current scale, and the radial resolution is ignored. */
   bool                 m_AdaptativeSampling;
   
-  /** Cached angular values. */
-  itk::Array<double>   m_CosArray;
-  itk::Array<double>   m_SinArray;
+  /** Circle sampler, with cached angular values. */
+  CircleSamplerType    m_CircleSampler;
+  
+  bool                 m_CoarseToFineSearch;
+  unsigned int         m_CoarseRadialResolution;
+  unsigned int         m_CoarseAngularResolution;
+  unsigned int         m_RefinementIterations;
+  unsigned int         m_GradientAscentIterations;
+  
+  /** Circle sampler of the coarse stage. */
+  CircleSamplerType    m_CoarseCircleSampler;
+  
+  /** Interior of the input image for the search distance, and whether the center of the
+    * current search is in it. */
+  SearchInteriorType   m_SearchInterior;
+  bool                 m_SearchCenterInInterior;
+  
+  unsigned long        m_NumberOfSearchSamples;
+  
+  double               m_BranchSearchRadius;
+  double               m_BranchVesselnessRatio;
+  
+  bool                 m_UseSampleCache;
+  double               m_SampleCacheTolerance;
+  SampleCachePointer   m_SampleCache;
+  
+  bool                            m_UseVesselnessFunctionPool;
+  ScaleVectorType                 m_VesselnessFunctionScales;
+  VesselnessFunctionPoolPointer   m_VesselnessFunctionPool;
+  
+  /** Function given with SetVesselnessImageFunction(), kept while the ones of the pool are used. */
+  VesselnessFunctionPointer       m_UnpooledVesselnessFunction;
+  
+  /** Scale for which the current vesselness function is initialized, negative if none, and 
+    * image for which the functions of the pool are initialized. */
+  double                          m_VesselnessFunctionScale;
+  const InputImageType           *m_VesselnessFunctionPoolImage;
 };
 
 } // end namespace ivan
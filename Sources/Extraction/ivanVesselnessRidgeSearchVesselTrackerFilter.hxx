@@ -44,8 +44,26 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
   m_MaximumSearchDistance( 5.0 ),
   m_RadialResolution( 5 ),
   m_AngularResolution( 8 ),
-  m_AdaptativeSampling( false )
+  m_AdaptativeSampling( false ),
+  m_CoarseToFineSearch( false ),
+  m_CoarseRadialResolution( 1 ),
+  m_CoarseAngularResolution( 6 ),
+  m_RefinementIterations( 1 ),
+  m_GradientAscentIterations( 0 ),
+  m_SearchCenterInInterior( false ),
+  m_NumberOfSearchSamples( 0 ),
+  m_BranchSearchRadius( 0.0 ),
+  m_BranchVesselnessRatio( 0.5 ),
+  m_UseSampleCache( false ),
+  m_SampleCacheTolerance( 0.1 ),
+  m_UseVesselnessFunctionPool( false ),
+  m_VesselnessFunctionScale( -1.0 ),
+  m_VesselnessFunctionPoolImage( 0 )
 {
+  m_SampleCache = SampleCacheType::New();
+  m_VesselnessFunctionPool = VesselnessFunctionPoolType::New();
+  m_CoarseCircleSampler.SetNumberOfSamples( m_CoarseAngularResolution );
+  
   this->ComputeIntervals();
 }
 
@@ -58,12 +76,26 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
   if( this->GetAdaptativeSampling() == adaptative )
     return;
   
-  this->SetAdaptativeSampling( adaptative );  
+  this->m_AdaptativeSampling = adaptative;  
   this->ComputeIntervals();
   this->Modified(); 
 }
 
 
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::SetCoarseAngularResolution( unsigned int resolution )
+{
+  if( this->m_CoarseAngularResolution == resolution )
+    return;
+  
+  this->m_CoarseAngularResolution = resolution;
+  this->m_CoarseCircleSampler.SetNumberOfSamples( resolution );
+  this->Modified();
+}
+
+
 template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
 void
 VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
@@ -88,30 +120,22 @@ void
 VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
 ::ComputeIntervals()
 {
-  if( this->GetAdaptativeSampling() )
+  // The radius is only known while tracking, so this is done again at every search
+  if( this->GetAdaptativeSampling() && this->GetCurrentBranch() && 
+    this->m_BranchPointIndex < this->GetCurrentBranch()->GetCenterline()->size() )
   {
     typename CenterlineType::Pointer  centerline = this->GetCurrentBranch()->GetCenterline();
     typename SectionType::Pointer     section = centerline->at( this->m_BranchPointIndex );
       
     this->m_AngularResolution = static_cast<unsigned int>
       ( vnl_math_rnd( 2.0 * vnl_math::pi * section->GetRadius() + 1.0 ) );
+    
+    if( this->m_AngularResolution < 4 )
+      this->m_AngularResolution = 4;
   }
   
-  // Set the size of the arrays for storing radial boundariness values depending on the number of samples
-  this->m_SinArray.SetSize( this->m_AngularResolution );
-  this->m_CosArray.SetSize( this->m_AngularResolution );
-    
   // Precalculate sin and cos values as these calculations are costly
-  
-  double angle = 0.0;
-  double angleInc = vnl_math::pi * 2.0 / static_cast<double>( this->m_AngularResolution ); 
-  
-  for ( unsigned int i=0; i < this->m_AngularResolution; ++i )
-  {
-    this->m_SinArray[i] = sin( angle );
-    this->m_CosArray[i] = cos( angle );
-    angle += angleInc;
-  }  
+  this->m_CircleSampler.SetNumberOfSamples( this->m_AngularResolution );
 }
 
 
@@ -135,24 +159,44 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
   //radialValues.SetSize( this->m_RadialResolution );
   
   
-  // Initialize vesselness function taking into account current scale as calculated for the section.
-  // Do this only if the scale changed from the previous point and it is not the first point
+  // Set up the vesselness function for the current scale as calculated for the section.
   
   InputImageType *inputImage = static_cast<InputImageType*>( this->itk::ProcessObject::GetInput(0) );
-
+  this->SelectVesselnessFunction( inputImage, section->GetScale() );
+  
+  // The memo only lives as long as the branch
   if( !this->m_BranchPointIndex )
   {
-    this->m_VesselnessFunctionInitializer->Initialize( this->m_VesselnessFunction.GetPointer(), 
-      inputImage, section->GetScale() );
+    this->m_SampleCache->Clear();
+    this->m_NumberOfSearchSamples = 0;
   }
-  else if( centerline->at( this->m_BranchPointIndex-1 ) != centerline->at( this->m_BranchPointIndex ) )
+  
+  if( this->m_AdaptativeSampling )
+    this->ComputeIntervals();
+  
+  const double scale = section->GetScale();
+  
+  typename CircleSamplerType::PointType searchCenter, currentCirclePoint;
+  
+  for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+    searchCenter[k] = section->GetCenter()[k];
+  
+  // Samples of searches far from the border are not tested. They are all within the search
+  // distance from the center, except the central differences of the gradient ascent, which may
+  // be up to half the coarse ring spacing further
+  const double searchRadius = 1.5 * this->m_MaximumSearchDistance;
+  
+  if( !this->m_BranchPointIndex || this->m_SearchInterior.GetImage() != inputImage || 
+      this->m_SearchInterior.GetRadius() != searchRadius )
   {
-    this->m_VesselnessFunctionInitializer->Initialize( this->m_VesselnessFunction.GetPointer(), 
-      inputImage, section->GetScale() );    
+    this->m_SearchInterior.SetImage( inputImage );
+    this->m_SearchInterior.Compute( searchRadius, 0.0 );
   }
   
-  if( this->m_VesselnessFunction->IsInsideBuffer( section->GetCenter() ) )
-    currentMax = this->m_VesselnessFunction->Evaluate( section->GetCenter() );
+  this->m_SearchCenterInInterior = this->m_SearchInterior.IsInside( searchCenter );
+  
+  if( this->m_SearchCenterInInterior || this->m_VesselnessFunction->IsInsideBuffer( section->GetCenter() ) )
+    currentMax = this->EvaluateVesselnessAtSample( searchCenter, scale );
   else
     currentMax = 0.0;
   
@@ -164,26 +208,46 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
   // Calculate an orthonormal base of vectors in the plane of the section given the normal vector
   ComputePlaneBasisVectorsFromNormal( normalVector, firstBaseVector, secondBaseVector );
   
-  typename SectionType::PointType currentCirclePoint, currentMaxPoint;
+  typename SectionType::PointType currentMaxPoint;
   currentMaxPoint = section->GetCenter();
 
   bool reestimate = false;
   
-  // Calculate points in a circle defined by the two base vectors
-  for( unsigned int i=0; i<this->m_RadialResolution; ++i )
+  // The samples of each circle are computed all at once, checking the buffer of the input image
+  this->m_CircleSampler.SetImage( inputImage );
+  this->m_CoarseCircleSampler.SetImage( inputImage );
+  CircleSampleSetType circleSamples( this->m_AngularResolution );
+  
+  if( this->m_CoarseToFineSearch )
   {
-    //radialValues.Fill(0.0);
+    typename CircleSamplerType::PointType maximumPoint = searchCenter;
+    
+    reestimate = this->CoarseToFineSearch( searchCenter, firstBaseVector, secondBaseVector, scale,
+      currentMax, maximumPoint );
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+      currentMaxPoint[k] = maximumPoint[k];
+  }
+  
+  const unsigned int prefetchRadius = this->GetPrefetchDistance() ? 
+    this->m_CircleSampler.ComputeNeighborhoodRadius( scale ) : 0;
+  
+  // Calculate points in circles defined by the two base vectors
+  for( unsigned int i=0; i<this->m_RadialResolution && !this->m_CoarseToFineSearch; ++i )
+  {
+    this->m_CircleSampler.Sample( searchCenter, (i+1) * samplingDistance, firstBaseVector, secondBaseVector, 
+      circleSamples );
        
     for( unsigned int j=0; j<this->m_AngularResolution; ++j )
     {
-      // Evaluate and store the value of the gradient in a circle 
+      // Evaluate the vesselness in the circle 
+      
+      this->m_CircleSampler.Prefetch( circleSamples, j, prefetchRadius );
       
-      for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
-        currentCirclePoint[k] = section->GetCenter()[k] + ( (i+1) * samplingDistance ) * 
-          ( this->m_CosArray[j] * firstBaseVector[k] + this->m_SinArray[j] * secondBaseVector[k] );
-          
-      if( this->m_VesselnessFunction->IsInsideBuffer( currentCirclePoint ) )
-        currentValue = this->m_VesselnessFunction->Evaluate( currentCirclePoint );
+      circleSamples.GetPoint( j, currentCirclePoint );
+      
+      if( this->m_SearchCenterInInterior || circleSamples.IsInside( j ) )
+        currentValue = this->EvaluateVesselnessAtSample( currentCirclePoint, scale );
       else
         currentValue = 0.0;
         
@@ -191,7 +255,9 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
       {
         reestimate = true;
         currentMax = currentValue;
-        currentMaxPoint = currentCirclePoint;
+        
+        for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+          currentMaxPoint[k] = currentCirclePoint[k];
       }
     }
   }
@@ -204,6 +270,347 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
     // Recompute section at the new center
     this->m_SectionEstimator->Compute();
   }
+  
+  // The maximum is the vesselness at the section center, so the end condition can use it
+  this->SetStepStateVesselness( currentMax );
+  
+  if( this->m_DetectBranches )
+    this->DetectBranchesInSection( inputImage, section );
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+template <class TVector>
+bool
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::CoarseToFineSearch( const SamplePointType & center, const TVector & firstBaseVector,
+  const TVector & secondBaseVector, double scale, double & maximumValue, 
+  SamplePointType & maximumPoint )
+{
+  const unsigned int dimension = TInputImage::GetImageDimension();
+  
+  const unsigned int numberOfRings = vnl_math_max( this->m_CoarseRadialResolution, 1u );
+  const double ringSpacing = this->m_MaximumSearchDistance / (double)numberOfRings;
+  const double maximumSquaredDistance = this->m_MaximumSearchDistance * this->m_MaximumSearchDistance;
+  
+  bool found = false;
+  
+  SamplePointType samplePoint;
+  double          sampleValue;
+  
+  // Coarse stage. Rings are placed in the middle of each radial interval, so that the 
+  // refinement can reach both the center and the search border
+  CircleSampleSetType coarseSamples( this->m_CoarseAngularResolution );
+  
+  const unsigned int prefetchRadius = this->GetPrefetchDistance() ? 
+    this->m_CoarseCircleSampler.ComputeNeighborhoodRadius( scale ) : 0;
+  
+  for( unsigned int i=0; i < numberOfRings; ++i )
+  {
+    this->m_CoarseCircleSampler.Sample( center, ( i + 0.5 ) * ringSpacing, firstBaseVector, 
+      secondBaseVector, coarseSamples );
+    
+    for( unsigned int j=0; j < this->m_CoarseAngularResolution; ++j )
+    {
+      this->m_CoarseCircleSampler.Prefetch( coarseSamples, j, prefetchRadius );
+      
+      if( !this->m_SearchCenterInInterior && !coarseSamples.IsInside( j ) )
+        continue;
+      
+      coarseSamples.GetPoint( j, samplePoint );
+      sampleValue = this->EvaluateVesselnessAtSample( samplePoint, scale );
+      
+      if( sampleValue > maximumValue )
+      {
+        found = true;
+        maximumValue = sampleValue;
+        maximumPoint = samplePoint;
+      }
+    }
+  }
+  
+  // Compass refinement in the plane around the best point
+  double distance = 0.5 * ringSpacing;
+  
+  for( unsigned int iteration=0; iteration < this->m_RefinementIterations; ++iteration )
+  {
+    const SamplePointType currentPoint = maximumPoint;
+    
+    for( unsigned int n=0; n < 4; ++n )
+    {
+      const double firstCoefficient  = ( n < 2 ) ? ( n == 0 ? distance : -distance ) : 0.0;
+      const double secondCoefficient = ( n < 2 ) ? 0.0 : ( n == 2 ? distance : -distance );
+      
+      for( unsigned int k=0; k < dimension; ++k )
+        samplePoint[k] = currentPoint[k] + firstCoefficient * firstBaseVector[k] + 
+          secondCoefficient * secondBaseVector[k];
+      
+      if( samplePoint.SquaredEuclideanDistanceTo( center ) > maximumSquaredDistance )
+        continue;
+      
+      sampleValue = this->EvaluateVesselnessAtPoint( samplePoint, scale );
+      
+      if( sampleValue > maximumValue )
+      {
+        found = true;
+        maximumValue = sampleValue;
+        maximumPoint = samplePoint;
+      }
+    }
+    
+    distance *= 0.5;
+  }
+  
+  // Gradient ascent with central differences, taking steps of the last refinement distance
+  for( unsigned int iteration=0; iteration < this->m_GradientAscentIterations; ++iteration )
+  {
+    double gradient[2];
+    
+    for( unsigned int axis=0; axis < 2; ++axis )
+    {
+      const TVector & baseVector = ( axis == 0 ) ? firstBaseVector : secondBaseVector;
+      
+      SamplePointType forwardPoint, backwardPoint;
+      
+      for( unsigned int k=0; k < dimension; ++k )
+      {
+        forwardPoint[k]  = maximumPoint[k] + distance * baseVector[k];
+        backwardPoint[k] = maximumPoint[k] - distance * baseVector[k];
+      }
+      
+      gradient[axis] = ( this->EvaluateVesselnessAtPoint( forwardPoint, scale ) - 
+        this->EvaluateVesselnessAtPoint( backwardPoint, scale ) ) / ( 2.0 * distance );
+    }
+    
+    const double gradientNorm = std::sqrt( gradient[0] * gradient[0] + gradient[1] * gradient[1] );
+    
+    if( gradientNorm <= 0.0 )
+      break;
+    
+    for( unsigned int k=0; k < dimension; ++k )
+      samplePoint[k] = maximumPoint[k] + distance * ( gradient[0] * firstBaseVector[k] + 
+        gradient[1] * secondBaseVector[k] ) / gradientNorm;
+    
+    if( samplePoint.SquaredEuclideanDistanceTo( center ) > maximumSquaredDistance )
+      break;
+    
+    sampleValue = this->EvaluateVesselnessAtPoint( samplePoint, scale );
+    
+    if( sampleValue <= maximumValue )
+      break;
+    
+    found = true;
+    maximumValue = sampleValue;
+    maximumPoint = samplePoint;
+  }
+  
+  return found;
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void 
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::SelectVesselnessFunction( InputImageType *inputImage, double scale )
+{
+  if( !this->m_UseVesselnessFunctionPool )
+  {
+    // The user function is restored so that the ones of the pool keep their scale
+    if( this->m_UnpooledVesselnessFunction.IsNotNull() )
+    {
+      this->m_VesselnessFunction = this->m_UnpooledVesselnessFunction;
+      this->m_UnpooledVesselnessFunction = 0;
+      this->m_VesselnessFunctionScale = -1.0;
+    }
+    
+    // The first point of the branch is always initialized, since the image may have changed
+    if( this->m_BranchPointIndex && scale == this->m_VesselnessFunctionScale )
+      return;
+    
+    IVAN_PROFILE_SCOPE( this->m_Profile, this->m_FunctionInitializationProbe );
+    this->m_VesselnessFunctionInitializer->Initialize( this->m_VesselnessFunction.GetPointer(), 
+      inputImage, scale );
+    this->m_VesselnessFunctionScale = scale;
+    return;
+  }
+  
+  // Round to the nearest discrete scale
+  if( !this->m_VesselnessFunctionScales.empty() )
+  {
+    const ScaleVectorType & scales = this->m_VesselnessFunctionScales;
+    typename ScaleVectorType::const_iterator it = std::lower_bound( scales.begin(), scales.end(), scale );
+    
+    if( it == scales.end() )
+      scale = scales.back();
+    else if( it != scales.begin() && scale - *(it-1) < *it - scale )
+      scale = *(it-1);
+    else
+      scale = *it;
+  }
+  
+  if( this->m_VesselnessFunctionPool.IsNull() )
+    this->m_VesselnessFunctionPool = VesselnessFunctionPoolType::New();
+  
+  if( !this->m_BranchPointIndex )
+  {
+    // Functions inserted by other objects before the first branch are kept
+    if( this->m_VesselnessFunctionPoolImage && this->m_VesselnessFunctionPoolImage != inputImage )
+      this->m_VesselnessFunctionPool->Clear();
+    
+    this->m_VesselnessFunctionPoolImage = inputImage;
+    
+    for( unsigned int i=0; i<this->m_VesselnessFunctionScales.size(); ++i )
+      this->GetPooledVesselnessFunction( inputImage, this->m_VesselnessFunctionScales[i] );
+  }
+  else if( scale == this->m_VesselnessFunctionScale )
+    return;
+  
+  if( this->m_UnpooledVesselnessFunction.IsNull() )
+    this->m_UnpooledVesselnessFunction = this->m_VesselnessFunction;
+  
+  this->m_VesselnessFunction = this->GetPooledVesselnessFunction( inputImage, scale );
+  this->m_VesselnessFunctionScale = scale;
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+typename VesselnessRidgeSearchVesselTrackerFilter
+  <TInputImage,TOutputVessel,TVesselnessFunction>::VesselnessFunctionType *
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::GetPooledVesselnessFunction( InputImageType *inputImage, double scale )
+{
+  VesselnessFunctionType *pooledFunction = this->m_VesselnessFunctionPool->Find( scale );
+  
+  if( pooledFunction )
+    return pooledFunction;
+  
+  IVAN_PROFILE_SCOPE( this->m_Profile, this->m_FunctionInitializationProbe );
+  
+  VesselnessFunctionPointer newFunction = VesselnessFunctionType::New();
+  this->m_VesselnessFunctionInitializer->Initialize( newFunction.GetPointer(), inputImage, scale );
+  
+  return this->m_VesselnessFunctionPool->Insert( scale, newFunction.GetPointer() );
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+double 
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::EvaluateVesselnessAtPoint( const SamplePointType & point, double scale )
+{
+  if( !this->m_SearchCenterInInterior && !this->m_VesselnessFunction->IsInsideBuffer( point ) )
+    return 0.0;
+  
+  return this->EvaluateVesselnessAtSample( point, scale );
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+double 
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::EvaluateVesselnessAtSample( const SamplePointType & point, double scale )
+{
+  ++this->m_NumberOfSearchSamples;
+  
+  if( !this->m_UseSampleCache || this->m_SampleCacheTolerance <= 0.0 )
+    return this->m_VesselnessFunction->Evaluate( point );
+  
+  typename SampleCacheType::IndexType cell;
+  
+  for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+    cell[k] = vnl_math_rnd( point[k] / this->m_SampleCacheTolerance );
+  
+  double value;
+  
+  if( !this->m_SampleCache->Find( scale, cell, value ) )
+  {
+    value = this->m_VesselnessFunction->Evaluate( point );
+    this->m_SampleCache->Insert( scale, cell, value );
+  }
+  
+  return value;
+}
+
+
+template <class TInputImage, class TOutputVessel, class TVesselnessFunction>
+void 
+VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFunction>
+::DetectBranchesInSection( InputImageType *inputImage, SectionType *section )
+{
+  if( !this->m_VesselnessFunction->IsInsideBuffer( section->GetCenter() ) )
+    return;
+  
+  typename CircleSamplerType::PointType ringCenter, ringPoint;
+  
+  for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+    ringCenter[k] = section->GetCenter()[k];
+  
+  const double scale = section->GetScale();
+  const double centerValue = this->EvaluateVesselnessAtSample( ringCenter, scale );
+  
+  if( centerValue <= 0.0 )
+    return;
+  
+  const double radius = ( this->m_BranchSearchRadius > 0.0 ) ? 
+    this->m_BranchSearchRadius : this->m_MaximumSearchDistance;
+  
+  // The normal may have changed in the search, so the basis is computed again
+  typedef vnl_vector_fixed<double,3>  VnlVectorType;  
+  VnlVectorType  firstBaseVector, secondBaseVector, normalVector;
+  
+  normalVector.copy_in( section->GetNormal().GetDataPointer() );
+  ComputePlaneBasisVectorsFromNormal( normalVector, firstBaseVector, secondBaseVector );
+  
+  const unsigned int numberOfSamples = this->m_AngularResolution;
+  
+  if( numberOfSamples < 3 )
+    return;
+  
+  this->m_CircleSampler.SetImage( inputImage );
+  CircleSampleSetType ringSamples( numberOfSamples );
+  
+  this->m_CircleSampler.Sample( ringCenter, radius, firstBaseVector, secondBaseVector, ringSamples );
+  
+  std::vector<double> ringValues( numberOfSamples, 0.0 );
+  
+  const unsigned int prefetchRadius = this->GetPrefetchDistance() ? 
+    this->m_CircleSampler.ComputeNeighborhoodRadius( scale ) : 0;
+  
+  for( unsigned int j=0; j < numberOfSamples; ++j )
+  {
+    this->m_CircleSampler.Prefetch( ringSamples, j, prefetchRadius );
+    
+    if( ringSamples.IsInside( j ) )
+    {
+      ringSamples.GetPoint( j, ringPoint );
+      ringValues[j] = this->EvaluateVesselnessAtSample( ringPoint, scale );
+    }
+  }
+  
+  const double minimumValue = this->m_BranchVesselnessRatio * centerValue;
+  
+  // Circular local maxima. Plateaus are counted once, at their first sample
+  for( unsigned int j=0; j < numberOfSamples; ++j )
+  {
+    const double previousValue = ringValues[ ( j + numberOfSamples - 1 ) % numberOfSamples ];
+    const double nextValue = ringValues[ ( j + 1 ) % numberOfSamples ];
+    
+    if( ringValues[j] < minimumValue || ringValues[j] <= previousValue || ringValues[j] < nextValue )
+      continue;
+    
+    ringSamples.GetPoint( j, ringPoint );
+    
+    InputImagePointType                   candidatePoint;
+    typename Superclass::DirectionType    direction;
+    
+    for( unsigned int k=0; k < TInputImage::GetImageDimension(); ++k )
+    {
+      candidatePoint[k] = ringPoint[k];
+      direction[k] = ( ringPoint[k] - ringCenter[k] ) / radius;
+    }
+    
+    this->AddBranchCandidate( candidatePoint, direction );
+  }
 }
 
 
@@ -218,6 +625,21 @@ VesselnessRidgeSearchVesselTrackerFilter<TInputImage,TOutputVessel,TVesselnessFu
   os << indent << "RadialResolution  : " << this->m_RadialResolution << std::endl;
   os << indent << "AngularResolution : " << this->m_AngularResolution << std::endl;
   os << indent << "AdaptativeSampling : " << this-> m_AdaptativeSampling << std::endl;
+  os << indent << "CoarseToFineSearch : " << this->m_CoarseToFineSearch << std::endl;
+  os << indent << "CoarseRadialResolution : " << this->m_CoarseRadialResolution << std::endl;
+  os << indent << "CoarseAngularResolution : " << this->m_CoarseAngularResolution << std::endl;
+  os << indent << "RefinementIterations : " << this->m_RefinementIterations << std::endl;
+  os << indent << "GradientAscentIterations : " << this->m_GradientAscentIterations << std::endl;
+  os << indent << "NumberOfSearchSamples : " << this->m_NumberOfSearchSamples << std::endl;
+  os << indent << "BranchSearchRadius : " << this->m_BranchSearchRadius << std::endl;
+  os << indent << "BranchVesselnessRatio : " << this->m_BranchVesselnessRatio << std::endl;
+  os << indent << "UseSampleCache : " << this->m_UseSampleCache << std::endl;
+  os << indent << "SampleCacheTolerance : " << this->m_SampleCacheTolerance << std::endl;
+  os << indent << "SampleCache : " << this->m_SampleCache.GetPointer() << std::endl;
+  os << indent << "PrefetchDistance : " << this->GetPrefetchDistance() << std::endl;
+  os << indent << "UseVesselnessFunctionPool : " << this->m_UseVesselnessFunctionPool << std::endl;
+  os << indent << "NumberOfVesselnessFunctionScales : " << this->m_VesselnessFunctionScales.size() << std::endl;
+  os << indent << "VesselnessFunctionPool : " << this->m_VesselnessFunctionPool.GetPointer() << std::endl;
 }
 
 } // end namespace ivan
@@ -0,0 +1,236 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkCache.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: cache of decompressed chunks of a chunked array.
+// Date: 2012/11/05
+
+
+#ifndef __ivanChunkCache_h
+#define __ivanChunkCache_h
+
+#include "ivanZarrArray.h"
+
+#include "itkLightObject.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <deque>
+#include <list>
+#include <map>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class ChunkCache
+ *  \brief Cache of the decompressed chunks of a ZarrArray, with background prefetching.
+ *
+ * Chunks are read and decompressed on demand by GetChunk() and kept in a cache of at most 
+ * MaximumNumberOfChunks chunks, evicting the least recently used ones. Chunks are reference 
+ * counted, so a chunk evicted while in use stays valid until released. Chunks never written 
+ * to the array are kept as empty chunks, whose pixels have the fill value of the array.
+ *
+ * Prefetch() queues chunks to be decompressed by NumberOfThreads background threads, started 
+ * on the first request, so that the decompression of the chunks needed next overlaps with the
+ * work on the current ones. A chunk requested with GetChunk() while being loaded waits for it,
+ * and a chunk still queued is loaded by the caller. The queue holds at most 
+ * MaximumNumberOfChunks requests, older requests are dropped first, since they are the ones 
+ * least likely to be needed when following a moving front. With no threads Prefetch() does 
+ * nothing.
+ *
+ * All methods may be called concurrently from several threads. The element type of the array
+ * must match TPixel.
+ *
+ * \sa ZarrArray, ChunkedImage
+ * \ingroup 
+ */
+ 
+template <class TPixel>
+class ITK_EXPORT ChunkCache : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ChunkCache                      Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TPixel                          PixelType;
+  
+  typedef ZarrArray                       ArrayType;
+  typedef ArrayType::ShapeType            ShapeType;
+  
+  /** Decompressed chunk. */
+  class Chunk : public itk::LightObject
+  {
+  public:
+    typedef Chunk                             Self;
+    typedef itk::LightObject                  Superclass;
+    typedef itk::SmartPointer<Self>           Pointer;
+    typedef itk::SmartPointer<const Self>     ConstPointer;
+    
+    itkNewMacro( Self );
+    itkTypeMacro( Chunk, LightObject );
+    
+    bool IsEmpty() const
+      { return Pixels.empty(); }
+    
+    /** Pixels in raster order, empty if the chunk was never written. */
+    std::vector<PixelType>    Pixels;
+    
+  protected:
+    Chunk() {}
+    ~Chunk() {}
+    
+  private:
+    Chunk(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+  };
+  
+  typedef typename Chunk::ConstPointer    ChunkConstPointer;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ChunkCache, itk::Object );
+  
+  /** Set the array, clearing the cache. Throws an exception if its element type does not match
+    * the pixel type. */
+  void SetArray( const ArrayType * array );
+  const ArrayType * GetArray() const
+    { return m_Array.GetPointer(); }
+  
+  /** Set/Get the maximum number of chunks kept. Default is 256. */
+  itkSetMacro( MaximumNumberOfChunks, unsigned long );
+  itkGetConstMacro( MaximumNumberOfChunks, unsigned long );
+  
+  /** Set/Get the number of background threads that decompress prefetched chunks. It must be
+    * set before the first prefetch. Default is 2. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+  
+  /** Value of the pixels of empty chunks. */
+  itkGetConstReferenceMacro( FillValue, PixelType );
+  
+  /** Get the given chunk, reading it if not in the cache. */
+  ChunkConstPointer GetChunk( unsigned long chunk );
+  
+  /** Queue the given chunk to be read in the background, unless it is already in the cache. */
+  void Prefetch( unsigned long chunk );
+  
+  /** Remove all the chunks not in use by other threads and the queued requests. */
+  void Clear();
+  
+  /** Number of chunks in the cache. */
+  unsigned long GetNumberOfChunks() const;
+  
+  /** Number of requests of GetChunk() found in the cache (or being prefetched), of those that 
+    * had to read the chunk, and number of chunks read in the background. */
+  unsigned long GetNumberOfHits() const
+    { return m_NumberOfHits; }
+  unsigned long GetNumberOfMisses() const
+    { return m_NumberOfMisses; }
+  unsigned long GetNumberOfPrefetchedChunks() const
+    { return m_NumberOfPrefetchedChunks; }
+		
+protected:
+
+  ChunkCache();
+  ~ChunkCache();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  typedef enum { Queued, Loading, Loaded } ChunkStateType;
+  
+  typedef std::list<unsigned long>  LRUListType;
+  
+  struct Entry
+  {
+    typename Chunk::Pointer   Data;
+    ChunkStateType            State;
+    LRUListType::iterator     Position;
+  };
+  
+  typedef std::map<unsigned long, Entry>  EntryMapType;
+  
+  /** Read a chunk. Called without holding the lock. */
+  void LoadChunk( unsigned long chunk, Chunk * data ) const;
+  
+  /** Mark a loaded chunk as the most recently used and evict the least recently used chunks.
+    * Called holding the lock. */
+  void InsertLoadedChunk( typename EntryMapType::iterator it );
+  
+  void StopThreads();
+  
+  /** Thread that loads queued chunks until the cache is destroyed. */
+  static ITK_THREAD_RETURN_TYPE PrefetchThreaderCallback( void *arg );
+  void ProcessPrefetchQueue();
+
+private:
+
+  ChunkCache(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  ArrayType::ConstPointer   m_Array;
+  PixelType                 m_FillValue;
+  unsigned long             m_NumberOfElementsPerChunk;
+  
+  unsigned long             m_MaximumNumberOfChunks;
+  unsigned int              m_NumberOfThreads;
+  
+  EntryMapType              m_Entries;
+  LRUListType               m_LRUList;
+  std::deque<unsigned long> m_PrefetchQueue;
+  
+  mutable itk::SimpleMutexLock          m_Mutex;
+  itk::ConditionVariable::Pointer       m_ChunkLoaded;
+  itk::ConditionVariable::Pointer       m_PrefetchRequested;
+  
+  itk::MultiThreader::Pointer           m_PrefetchThreader;
+  std::vector<int>                      m_PrefetchThreadIds;
+  bool                                  m_Stopping;
+  
+  unsigned long             m_NumberOfHits;
+  unsigned long             m_NumberOfMisses;
+  unsigned long             m_NumberOfPrefetchedChunks;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanChunkCache.hxx"
+#endif
+
+#endif
@@ -0,0 +1,388 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkCache.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: cache of decompressed chunks of a chunked array.
+// Date: 2012/11/05
+
+#ifndef __ivanChunkCache_hxx
+#define __ivanChunkCache_hxx
+
+#include "ivanChunkCache.h"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace ivan
+{
+
+template <class TPixel>
+ChunkCache<TPixel>::ChunkCache() :
+  m_FillValue( 0 ),
+  m_NumberOfElementsPerChunk( 0 ),
+  m_MaximumNumberOfChunks( 256 ),
+  m_NumberOfThreads( 2 ),
+  m_Stopping( false ),
+  m_NumberOfHits( 0 ),
+  m_NumberOfMisses( 0 ),
+  m_NumberOfPrefetchedChunks( 0 )
+{
+  m_ChunkLoaded = itk::ConditionVariable::New();
+  m_PrefetchRequested = itk::ConditionVariable::New();
+}
+
+
+template <class TPixel>
+ChunkCache<TPixel>::~ChunkCache()
+{
+  this->StopThreads();
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::SetArray( const ArrayType * array )
+{
+  if( array && ( array->GetElementSize() != sizeof( PixelType ) || 
+    array->GetElementIsInteger() != std::numeric_limits<PixelType>::is_integer ||
+    array->GetElementIsSigned() != ( std::numeric_limits<PixelType>::is_signed ) ) )
+  {
+    itkExceptionMacro( "The element type of " << array->GetPath() << " does not match the pixel type." );
+  }
+  
+  // Threads of a previous array may be loading its chunks
+  
+  this->StopThreads();
+  
+  m_Mutex.Lock();
+  
+  m_Entries.clear();
+  m_LRUList.clear();
+  m_PrefetchQueue.clear();
+  
+  m_Array = array;
+  m_FillValue = array ? static_cast<PixelType>( array->GetFillValue() ) : PixelType( 0 );
+  m_NumberOfElementsPerChunk = array ? array->GetNumberOfElementsPerChunk() : 0;
+  
+  m_NumberOfHits = 0;
+  m_NumberOfMisses = 0;
+  m_NumberOfPrefetchedChunks = 0;
+  
+  m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TPixel>
+typename ChunkCache<TPixel>::ChunkConstPointer ChunkCache<TPixel>::GetChunk( unsigned long chunk )
+{
+  if( m_Array.IsNull() )
+    itkExceptionMacro( "No array given." );
+    
+  m_Mutex.Lock();
+  
+  while( true )
+  {
+    typename EntryMapType::iterator it = m_Entries.find( chunk );
+    
+    if( it == m_Entries.end() || it->second.State == Queued )
+    {
+      // Read the chunk here when not in the cache or not yet taken by a prefetching thread
+      
+      if( it == m_Entries.end() )
+      {
+        it = m_Entries.insert( typename EntryMapType::value_type( chunk, Entry() ) ).first;
+        it->second.Data = Chunk::New();
+        ++m_NumberOfMisses;
+      }
+      else
+      {
+        ++m_NumberOfHits;
+      }
+      
+      it->second.State = Loading;
+      typename Chunk::Pointer data = it->second.Data;
+      
+      m_Mutex.Unlock();
+      
+      try
+      {
+        this->LoadChunk( chunk, data );
+      }
+      catch( ... )
+      {
+        m_Mutex.Lock();
+        m_Entries.erase( chunk );
+        m_ChunkLoaded->Broadcast();
+        m_Mutex.Unlock();
+        throw;
+      }
+      
+      m_Mutex.Lock();
+      
+      it = m_Entries.find( chunk );
+      this->InsertLoadedChunk( it );
+      m_ChunkLoaded->Broadcast();
+      
+      m_Mutex.Unlock();
+      
+      return data.GetPointer();
+    }
+    
+    if( it->second.State == Loaded )
+    {
+      ++m_NumberOfHits;
+      m_LRUList.splice( m_LRUList.begin(), m_LRUList, it->second.Position );
+      
+      ChunkConstPointer data = it->second.Data.GetPointer();
+      
+      m_Mutex.Unlock();
+      
+      return data;
+    }
+    
+    // Being loaded by another thread, which may fail and erase the entry
+    
+    m_ChunkLoaded->Wait( &m_Mutex );
+  }
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::Prefetch( unsigned long chunk )
+{
+  if( m_Array.IsNull() || m_NumberOfThreads == 0 )
+    return;
+    
+  m_Mutex.Lock();
+  
+  if( m_Entries.find( chunk ) != m_Entries.end() || m_Stopping )
+  {
+    m_Mutex.Unlock();
+    return;
+  }
+  
+  if( m_PrefetchThreadIds.empty() )
+  {
+    if( m_PrefetchThreader.IsNull() )
+      m_PrefetchThreader = itk::MultiThreader::New();
+      
+    for( unsigned int i=0; i < m_NumberOfThreads; ++i )
+      m_PrefetchThreadIds.push_back( m_PrefetchThreader->SpawnThread( this->PrefetchThreaderCallback, this ) );
+  }
+  
+  Entry entry;
+  entry.Data = Chunk::New();
+  entry.State = Queued;
+  
+  m_Entries.insert( typename EntryMapType::value_type( chunk, entry ) );
+  m_PrefetchQueue.push_back( chunk );
+  
+  // Drop the oldest requests
+  
+  while( m_PrefetchQueue.size() > m_MaximumNumberOfChunks )
+  {
+    typename EntryMapType::iterator it = m_Entries.find( m_PrefetchQueue.front() );
+    
+    if( it != m_Entries.end() && it->second.State == Queued )
+      m_Entries.erase( it );
+      
+    m_PrefetchQueue.pop_front();
+  }
+  
+  m_PrefetchRequested->Signal();
+  m_Mutex.Unlock();
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::Clear()
+{
+  m_Mutex.Lock();
+  
+  for( std::deque<unsigned long>::const_iterator queued = m_PrefetchQueue.begin(); 
+    queued != m_PrefetchQueue.end(); ++queued )
+  {
+    typename EntryMapType::iterator it = m_Entries.find( *queued );
+    
+    if( it != m_Entries.end() && it->second.State == Queued )
+      m_Entries.erase( it );
+  }
+  
+  m_PrefetchQueue.clear();
+  
+  for( LRUListType::const_iterator loaded = m_LRUList.begin(); loaded != m_LRUList.end(); ++loaded )
+    m_Entries.erase( *loaded );
+    
+  m_LRUList.clear();
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TPixel>
+unsigned long ChunkCache<TPixel>::GetNumberOfChunks() const
+{
+  m_Mutex.Lock();
+  unsigned long numberOfChunks = m_LRUList.size();
+  m_Mutex.Unlock();
+  
+  return numberOfChunks;
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::LoadChunk( unsigned long chunk, Chunk * data ) const
+{
+  data->Pixels.resize( m_NumberOfElementsPerChunk );
+  
+  if( !m_Array->ReadChunk( chunk, &data->Pixels[0] ) )
+    std::vector<PixelType>().swap( data->Pixels );
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::InsertLoadedChunk( typename EntryMapType::iterator it )
+{
+  it->second.State = Loaded;
+  it->second.Position = m_LRUList.insert( m_LRUList.begin(), it->first );
+  
+  while( m_LRUList.size() > std::max( m_MaximumNumberOfChunks, 1ul ) )
+  {
+    m_Entries.erase( m_LRUList.back() );
+    m_LRUList.pop_back();
+  }
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::StopThreads()
+{
+  if( m_PrefetchThreadIds.empty() )
+    return;
+    
+  m_Mutex.Lock();
+  m_Stopping = true;
+  m_PrefetchRequested->Broadcast();
+  m_Mutex.Unlock();
+  
+  // This joins the threads
+  for( unsigned int i=0; i < m_PrefetchThreadIds.size(); ++i )
+    m_PrefetchThreader->TerminateThread( m_PrefetchThreadIds[i] );
+    
+  m_PrefetchThreadIds.clear();
+  m_Stopping = false;
+}
+
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE ChunkCache<TPixel>::PrefetchThreaderCallback( void *arg )
+{
+  Self *cache = (Self *)( ((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData );
+  
+  cache->ProcessPrefetchQueue();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::ProcessPrefetchQueue()
+{
+  m_Mutex.Lock();
+  
+  while( true )
+  {
+    while( m_PrefetchQueue.empty() && !m_Stopping )
+      m_PrefetchRequested->Wait( &m_Mutex );
+      
+    if( m_Stopping )
+      break;
+    
+    // The newest requests first, the front is most likely ahead
+    
+    unsigned long chunk = m_PrefetchQueue.back();
+    m_PrefetchQueue.pop_back();
+    
+    typename EntryMapType::iterator it = m_Entries.find( chunk );
+    
+    if( it == m_Entries.end() || it->second.State != Queued )
+      continue;
+    
+    it->second.State = Loading;
+    typename Chunk::Pointer data = it->second.Data;
+    
+    m_Mutex.Unlock();
+    
+    bool loaded = true;
+    
+    try
+    {
+      this->LoadChunk( chunk, data );
+    }
+    catch( ... )
+    {
+      // Left for GetChunk() to report
+      loaded = false;
+    }
+    
+    m_Mutex.Lock();
+    
+    it = m_Entries.find( chunk );
+    
+    if( loaded )
+    {
+      this->InsertLoadedChunk( it );
+      ++m_NumberOfPrefetchedChunks;
+    }
+    else
+    {
+      m_Entries.erase( it );
+    }
+    
+    m_ChunkLoaded->Broadcast();
+  }
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TPixel>
+void ChunkCache<TPixel>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Array: " << m_Array.GetPointer() << std::endl;
+  os << indent << "MaximumNumberOfChunks: " << m_MaximumNumberOfChunks << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfHits: " << m_NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << m_NumberOfMisses << std::endl;
+  os << indent << "NumberOfPrefetchedChunks: " << m_NumberOfPrefetchedChunks << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanChunkCache_hxx
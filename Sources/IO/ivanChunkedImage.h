@@ -0,0 +1,170 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkedImage.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image read on demand from the chunks of a chunked array.
+// Date: 2012/11/05
+
+
+#ifndef __ivanChunkedImage_h
+#define __ivanChunkedImage_h
+
+#include "ivanChunkCache.h"
+
+#include "itkImageBase.h"
+
+
+namespace ivan
+{
+  
+/** \class ChunkedImage
+ *  \brief Image whose pixels are read on demand from the chunks of a ZarrArray.
+ *
+ * The image covers the whole array, and GetPixel() gets the chunk of the pixel from a 
+ * ChunkCache, which reads and decompresses it the first time. Only the chunks touched are 
+ * read, so algorithms that visit a small part of the volume, such as vessel tracking, work on 
+ * volumes much larger than the memory, with a resident memory of the size of the cache. 
+ * Prefetch() requests the chunks around a point in the background, so that tracking may ask 
+ * for the chunks ahead of it (see ChunkPrefetchVesselTrackerEndCondition).
+ *
+ * The image has the geometry of itk::ImageBase and the GetPixel() method of itk::Image, so it 
+ * can be the input of image functions that read with GetPixel(), such as 
+ * itk::LinearInterpolateImageFunction. Each GetPixel() takes the lock of the cache, so it is 
+ * suited to sparse access; filters that process whole regions should read the array with 
+ * ChunkedImageSource instead. It does not provide a pixel buffer, so image iterators can't be 
+ * used on it, and it is read-only. Graft() shares the cache with the grafted image.
+ *
+ * \sa ChunkCache, ChunkedImageSource, SparseBlockedImage
+ */
+template <class TPixel, unsigned int VDimension = 3>
+class ITK_EXPORT ChunkedImage : public itk::ImageBase<VDimension>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ChunkedImage                         Self;
+  typedef itk::ImageBase<VDimension>           Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+  typedef itk::WeakPointer<const Self>         ConstWeakPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ChunkedImage, ImageBase );
+  
+  typedef TPixel                                  PixelType;
+  typedef TPixel                                  ValueType;
+  typedef TPixel                                  InternalPixelType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, VDimension );
+  
+  typedef typename Superclass::IndexType          IndexType;
+  typedef typename Superclass::SizeType           SizeType;
+  typedef typename Superclass::RegionType         RegionType;
+  typedef typename Superclass::SpacingType        SpacingType;
+  typedef typename Superclass::PointType          PointType;
+  
+  typedef ChunkCache<PixelType>                   ChunkCacheType;
+  typedef typename ChunkCacheType::ShapeType      ShapeType;
+  
+public:
+  
+  /** Set the cache of the chunks, whose array sets the regions of the image. Throws an 
+    * exception if the dimension of the array is not the image dimension. */
+  void SetChunkCache( ChunkCacheType * cache );
+  ChunkCacheType * GetChunkCache() const
+    { return this->m_ChunkCache; }
+  
+  /** Get the pixel at the given index, which must be inside the buffered region. */
+  PixelType GetPixel( const IndexType & index ) const
+    {
+      unsigned long chunk, offset;
+      this->ComputeChunkAndOffset( index, chunk, offset );
+      
+      typename ChunkCacheType::ChunkConstPointer data = this->m_ChunkCache->GetChunk( chunk );
+      return data->IsEmpty() ? this->m_ChunkCache->GetFillValue() : data->Pixels[offset];
+    }
+  
+  /** Prefetch the chunks that overlap the box of the given radius in pixels around an index.
+    * Parts of the box outside the image are ignored. */
+  void Prefetch( const IndexType & index, unsigned long radius ) const;
+  
+  /** Number of pixels of a chunk along each dimension. */
+  const SizeType & GetChunkSize() const
+    { return this->m_ChunkSize; }
+  
+  /** Restore the image to its initial state, releasing the cache. */
+  virtual void Initialize();
+  
+  /** Copy the geometry and share the cache of another ChunkedImage. */
+  virtual void Graft( const itk::DataObject *data );
+  
+protected:
+
+  ChunkedImage();
+  virtual ~ChunkedImage() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Number of the chunk of a pixel and offset of the pixel in the chunk. */
+  void ComputeChunkAndOffset( const IndexType & index, unsigned long & chunk, 
+    unsigned long & offset ) const
+    {
+      chunk = 0;
+      offset = 0;
+      
+      unsigned long pixelStride = 1;
+      
+      for( unsigned int d=0; d<VDimension; ++d )
+      {
+        const unsigned long position = static_cast<unsigned long>( index[d] );
+        chunk += ( position / this->m_ChunkSize[d] ) * this->m_ChunkStrides[d];
+        offset += ( position % this->m_ChunkSize[d] ) * pixelStride;
+        pixelStride *= this->m_ChunkSize[d];
+      }
+    }
+  
+private:
+
+  ChunkedImage(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+  typename ChunkCacheType::Pointer    m_ChunkCache;
+  
+  SizeType                            m_ChunkSize;
+  
+  /** Stride of the chunks in the numbering of the array along each dimension. */
+  unsigned long                       m_ChunkStrides[VDimension];
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanChunkedImage.hxx"
+#endif
+
+#endif
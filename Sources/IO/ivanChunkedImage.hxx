@@ -0,0 +1,178 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkedImage.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image read on demand from the chunks of a chunked array.
+// Date: 2012/11/05
+
+#ifndef __ivanChunkedImage_hxx
+#define __ivanChunkedImage_hxx
+
+#include "ivanChunkedImage.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+
+namespace ivan
+{
+
+template <class TPixel, unsigned int VDimension>
+ChunkedImage<TPixel,VDimension>::ChunkedImage()
+{
+  this->m_ChunkSize.Fill( 1 );
+  std::fill( this->m_ChunkStrides, this->m_ChunkStrides + VDimension, 0ul );
+}
+
+
+template <class TPixel, unsigned int VDimension>
+void ChunkedImage<TPixel,VDimension>::SetChunkCache( ChunkCacheType * cache )
+{
+  const ZarrArray *array = cache ? cache->GetArray() : 0;
+  
+  if( !array )
+    itkExceptionMacro( "The chunk cache has no array." );
+    
+  if( array->GetDimension() != VDimension )
+    itkExceptionMacro( "Array " << array->GetPath() << " has dimension " << array->GetDimension() << "." );
+    
+  const ShapeType & shape = array->GetShape();
+  const ShapeType & chunkShape = array->GetChunkShape();
+  const ShapeType & numberOfChunks = array->GetNumberOfChunksPerAxis();
+  
+  RegionType region;
+  SizeType size;
+  unsigned long chunkStride = 1;
+  
+  for( unsigned int d=0; d<VDimension; ++d )
+  {
+    size[d] = shape[d];
+    this->m_ChunkSize[d] = chunkShape[d];
+    this->m_ChunkStrides[d] = chunkStride;
+    chunkStride *= numberOfChunks[d];
+  }
+  
+  region.SetSize( size );
+  
+  this->SetLargestPossibleRegion( region );
+  this->SetBufferedRegion( region );
+  this->SetRequestedRegion( region );
+  
+  this->m_ChunkCache = cache;
+  this->Modified();
+}
+
+
+template <class TPixel, unsigned int VDimension>
+void ChunkedImage<TPixel,VDimension>::Prefetch( const IndexType & index, unsigned long radius ) const
+{
+  if( this->m_ChunkCache.IsNull() )
+    return;
+    
+  const SizeType & size = this->GetBufferedRegion().GetSize();
+  
+  unsigned long firstChunk[VDimension], lastChunk[VDimension], chunkIndex[VDimension];
+  
+  for( unsigned int d=0; d<VDimension; ++d )
+  {
+    const long first = index[d] - static_cast<long>( radius );
+    const long last = index[d] + static_cast<long>( radius );
+    
+    if( last < 0 || first >= static_cast<long>( size[d] ) )
+      return;
+      
+    firstChunk[d] = static_cast<unsigned long>( std::max( first, 0l ) ) / this->m_ChunkSize[d];
+    lastChunk[d] = static_cast<unsigned long>( std::min( last, static_cast<long>( size[d] ) - 1 ) ) / 
+      this->m_ChunkSize[d];
+    chunkIndex[d] = firstChunk[d];
+  }
+  
+  while( true )
+  {
+    unsigned long chunk = 0;
+    
+    for( unsigned int d=0; d<VDimension; ++d )
+      chunk += chunkIndex[d] * this->m_ChunkStrides[d];
+      
+    this->m_ChunkCache->Prefetch( chunk );
+    
+    unsigned int d = 0;
+    
+    while( d < VDimension && chunkIndex[d] == lastChunk[d] )
+    {
+      chunkIndex[d] = firstChunk[d];
+      ++d;
+    }
+    
+    if( d == VDimension )
+      break;
+      
+    ++chunkIndex[d];
+  }
+}
+
+
+template <class TPixel, unsigned int VDimension>
+void ChunkedImage<TPixel,VDimension>::Initialize()
+{
+  Superclass::Initialize();
+  
+  this->m_ChunkCache = 0;
+  this->m_ChunkSize.Fill( 1 );
+  std::fill( this->m_ChunkStrides, this->m_ChunkStrides + VDimension, 0ul );
+}
+
+
+template <class TPixel, unsigned int VDimension>
+void ChunkedImage<TPixel,VDimension>::Graft( const itk::DataObject *data )
+{
+  Superclass::Graft( data );
+  
+  const Self *image = dynamic_cast<const Self *>( data );
+  
+  if( !image )
+  {
+    itkExceptionMacro( << "ivan::ChunkedImage::Graft() cannot cast " << typeid( data ).name() 
+      << " to " << typeid( const Self * ).name() );
+  }
+  
+  this->m_ChunkCache = image->GetChunkCache();
+  this->m_ChunkSize = image->m_ChunkSize;
+  std::copy( image->m_ChunkStrides, image->m_ChunkStrides + VDimension, this->m_ChunkStrides );
+}
+
+
+template <class TPixel, unsigned int VDimension>
+void ChunkedImage<TPixel,VDimension>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "ChunkCache: " << this->m_ChunkCache.GetPointer() << std::endl;
+  os << indent << "ChunkSize: " << this->m_ChunkSize << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanChunkedImage_hxx
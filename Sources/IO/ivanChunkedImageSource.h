@@ -0,0 +1,148 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkedImageSource.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image source that reads regions of a chunked array.
+// Date: 2012/11/05
+
+
+#ifndef __ivanChunkedImageSource_h
+#define __ivanChunkedImageSource_h
+
+#include "ivanChunkCache.h"
+
+#include "itkImageSource.h"
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class ChunkedImageSource
+ *  \brief Image source that reads the requested region of an image stored as a ZarrArray.
+ *
+ * Only the requested region of the output is generated, reading only the chunks that overlap
+ * it, so with itk::StreamingImageFilter, or with filters that request a padded region of their
+ * input such as MultiscaleAnalysisImageFilter in slabs, volumes much larger than the memory 
+ * are processed a region at a time. All the chunks of the region are first requested to the 
+ * prefetching threads of the ChunkCache, so their decompression runs in parallel with the copy
+ * of the chunks already available. The cache should hold at least the chunks of a requested 
+ * region, and with padded requests chunks shared by consecutive regions are read only once.
+ *
+ * The cache may be shared with a ChunkedImage (see GetChunkCache()), so that tracking reads 
+ * the chunks already decompressed by detection. Zarr arrays have no geometry, it is given
+ * with SetSpacing() and SetOrigin(). The element type of the array must match the pixel type 
+ * of the output, and only scalar images are supported.
+ *
+ * \sa ZarrArray, ChunkCache, ChunkedImage
+ * \ingroup 
+ */
+ 
+template <class TOutputImage>
+class ITK_EXPORT ChunkedImageSource : public itk::ImageSource<TOutputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ChunkedImageSource                Self;
+  typedef itk::ImageSource<TOutputImage>    Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  typedef TOutputImage                            OutputImageType;
+  typedef typename OutputImageType::PixelType     PixelType;
+  typedef typename OutputImageType::RegionType    RegionType;
+  typedef typename OutputImageType::IndexType     IndexType;
+  typedef typename OutputImageType::SizeType      SizeType;
+  typedef typename OutputImageType::SpacingType   SpacingType;
+  typedef typename OutputImageType::PointType     PointType;
+  
+  typedef ChunkCache<PixelType>                   ChunkCacheType;
+  typedef typename ChunkCacheType::ShapeType      ShapeType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ChunkedImageSource, ImageSource );
+  
+  /** Set/Get the directory of the array. */
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Geometry of the output. */
+  itkSetMacro( Spacing, SpacingType );
+  itkGetConstReferenceMacro( Spacing, SpacingType );
+  itkSetMacro( Origin, PointType );
+  itkGetConstReferenceMacro( Origin, PointType );
+  
+  /** Set/Get the cache of the chunks. A cache is created by default. */
+  void SetChunkCache( ChunkCacheType * cache );
+  ChunkCacheType * GetChunkCache() const
+    { return m_ChunkCache; }
+		
+protected:
+
+  ChunkedImageSource();
+  ~ChunkedImageSource() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Open the array and set the geometry of the output. */
+  virtual void GenerateOutputInformation();
+  
+  virtual void GenerateData();
+  
+  /** Copy the part of a chunk inside a region of the output. */
+  void CopyChunk( const ShapeType & chunkIndex, const RegionType & region );
+
+private:
+
+  ChunkedImageSource(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string       m_FileName;
+  
+  SpacingType       m_Spacing;
+  PointType         m_Origin;
+  
+  typename ChunkCacheType::Pointer  m_ChunkCache;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanChunkedImageSource.hxx"
+#endif
+
+#endif
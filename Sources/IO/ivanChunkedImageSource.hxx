@@ -0,0 +1,222 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkedImageSource.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image source that reads regions of a chunked array.
+// Date: 2012/11/05
+
+#ifndef __ivanChunkedImageSource_hxx
+#define __ivanChunkedImageSource_hxx
+
+#include "ivanChunkedImageSource.h"
+
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TOutputImage>
+ChunkedImageSource<TOutputImage>::ChunkedImageSource()
+{
+  this->SetNumberOfRequiredInputs( 0 );
+  
+  m_Spacing.Fill( 1.0 );
+  m_Origin.Fill( 0.0 );
+  
+  m_ChunkCache = ChunkCacheType::New();
+}
+
+
+template <class TOutputImage>
+void ChunkedImageSource<TOutputImage>::SetChunkCache( ChunkCacheType * cache )
+{
+  if( !cache )
+    itkExceptionMacro( "No chunk cache given." );
+    
+  if( m_ChunkCache.GetPointer() != cache )
+  {
+    m_ChunkCache = cache;
+    this->Modified();
+  }
+}
+
+
+template <class TOutputImage>
+void ChunkedImageSource<TOutputImage>::GenerateOutputInformation()
+{
+  if( m_FileName.empty() )
+    itkExceptionMacro( "No file name given." );
+  
+  // The array is opened again only if the file name changed, keeping the cached chunks
+  
+  if( !m_ChunkCache->GetArray() || m_ChunkCache->GetArray()->GetPath() != m_FileName )
+  {
+    ZarrArray::Pointer array = ZarrArray::New();
+    array->Open( m_FileName );
+    m_ChunkCache->SetArray( array );
+  }
+  
+  const ZarrArray *array = m_ChunkCache->GetArray();
+  
+  if( array->GetDimension() != ImageDimension )
+    itkExceptionMacro( "Array " << m_FileName << " has dimension " << array->GetDimension() << "." );
+  
+  RegionType region;
+  SizeType size;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+    size[d] = array->GetShape()[d];
+    
+  region.SetSize( size );
+  
+  OutputImageType *output = this->GetOutput();
+  output->SetLargestPossibleRegion( region );
+  output->SetSpacing( m_Spacing );
+  output->SetOrigin( m_Origin );
+}
+
+
+template <class TOutputImage>
+void ChunkedImageSource<TOutputImage>::GenerateData()
+{
+  OutputImageType *output = this->GetOutput();
+  
+  const RegionType region = output->GetRequestedRegion();
+  output->SetBufferedRegion( region );
+  output->Allocate();
+  
+  const ZarrArray *array = m_ChunkCache->GetArray();
+  const ShapeType & chunkShape = array->GetChunkShape();
+  
+  // Chunks that overlap the region
+  
+  ShapeType firstChunk( ImageDimension ), lastChunk( ImageDimension );
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    firstChunk[d] = region.GetIndex()[d] / chunkShape[d];
+    lastChunk[d] = ( region.GetIndex()[d] + region.GetSize()[d] - 1 ) / chunkShape[d];
+  }
+  
+  std::vector<ShapeType> chunks;
+  ShapeType chunkIndex = firstChunk;
+  
+  while( true )
+  {
+    chunks.push_back( chunkIndex );
+    
+    unsigned int d = 0;
+    
+    while( d < ImageDimension && chunkIndex[d] == lastChunk[d] )
+    {
+      chunkIndex[d] = firstChunk[d];
+      ++d;
+    }
+    
+    if( d == ImageDimension )
+      break;
+      
+    ++chunkIndex[d];
+  }
+  
+  // The newest requests are decompressed first, so request them in the opposite order of 
+  // the copy to have the threads and the copy start at opposite ends
+  
+  for( unsigned long i=chunks.size(); i > 0; --i )
+    m_ChunkCache->Prefetch( array->GetChunkNumber( chunks[i-1] ) );
+    
+  for( unsigned long i=0; i < chunks.size(); ++i )
+    this->CopyChunk( chunks[i], region );
+}
+
+
+template <class TOutputImage>
+void ChunkedImageSource<TOutputImage>::CopyChunk( const ShapeType & chunkIndex, const RegionType & region )
+{
+  const ZarrArray *array = m_ChunkCache->GetArray();
+  const ShapeType & chunkShape = array->GetChunkShape();
+  
+  IndexType chunkStart;
+  SizeType chunkSize;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    chunkStart[d] = chunkIndex[d] * chunkShape[d];
+    chunkSize[d] = chunkShape[d];
+  }
+  
+  RegionType chunkRegion( chunkStart, chunkSize );
+  chunkRegion.Crop( region );
+  
+  typename ChunkCacheType::ChunkConstPointer chunk = 
+    m_ChunkCache->GetChunk( array->GetChunkNumber( chunkIndex ) );
+  
+  itk::ImageRegionIteratorWithIndex<OutputImageType> it( this->GetOutput(), chunkRegion );
+  
+  if( chunk->IsEmpty() )
+  {
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      it.Set( m_ChunkCache->GetFillValue() );
+      
+    return;
+  }
+  
+  const PixelType *pixels = &chunk->Pixels[0];
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const IndexType & index = it.GetIndex();
+    
+    unsigned long offset = 0;
+    unsigned long pixelStride = 1;
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      offset += ( index[d] - chunkStart[d] ) * pixelStride;
+      pixelStride *= chunkShape[d];
+    }
+    
+    it.Set( pixels[offset] );
+  }
+}
+
+
+template <class TOutputImage>
+void ChunkedImageSource<TOutputImage>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Spacing: " << m_Spacing << std::endl;
+  os << indent << "Origin: " << m_Origin << std::endl;
+  os << indent << "ChunkCache: " << m_ChunkCache.GetPointer() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanChunkedImageSource_hxx
@@ -0,0 +1,220 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFileMapping.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: maps a byte range of a file in memory.
+// Date: 2012/11/05
+
+#include "ivanFileMapping.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace ivan
+{
+
+FileMapping::FileMapping() :
+  m_MappedBase( 0 ),
+  m_MappedLength( 0 ),
+  m_Data( 0 ),
+  m_Length( 0 ),
+  m_FileHandle( 0 ),
+  m_MappingHandle( 0 )
+{
+}
+
+
+FileMapping::~FileMapping()
+{
+  this->Unmap();
+}
+
+
+vxl_uint_64 FileMapping::GetFileSize( const std::string & fileName )
+{
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  
+  if( !GetFileAttributesExA( fileName.c_str(), GetFileExInfoStandard, &attributes ) )
+  {
+    itkGenericExceptionMacro( "Could not open " << fileName << "." );
+  }
+    
+  return ( static_cast<vxl_uint_64>( attributes.nFileSizeHigh ) << 32 ) | attributes.nFileSizeLow;
+#else
+  struct stat fileStatus;
+  
+  if( stat( fileName.c_str(), &fileStatus ) != 0 )
+  {
+    itkGenericExceptionMacro( "Could not open " << fileName << "." );
+  }
+    
+  return fileStatus.st_size;
+#endif
+}
+
+
+void FileMapping::Map( const std::string & fileName, vxl_uint_64 offset, vxl_uint_64 length )
+{
+  this->Unmap();
+  
+  if( offset + length > GetFileSize( fileName ) )
+    itkExceptionMacro( "File " << fileName << " is too short to map " << length << " bytes from " 
+      << offset << "." );
+  
+  if( !length )
+    itkExceptionMacro( "Empty range of " << fileName << "." );
+  
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo( &systemInfo );
+  
+  const vxl_uint_64 mappedOffset = offset - offset % systemInfo.dwAllocationGranularity;
+  const vxl_uint_64 mappedLength = length + ( offset - mappedOffset );
+  
+  HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 
+    FILE_ATTRIBUTE_NORMAL, NULL );
+  
+  if( file == INVALID_HANDLE_VALUE )
+    itkExceptionMacro( "Could not open " << fileName << "." );
+    
+  HANDLE mapping = CreateFileMapping( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+  void *data = mapping ? MapViewOfFile( mapping, FILE_MAP_COPY, 
+    static_cast<DWORD>( mappedOffset >> 32 ), static_cast<DWORD>( mappedOffset ), 
+    static_cast<SIZE_T>( mappedLength ) ) : NULL;
+  
+  if( !data )
+  {
+    if( mapping )
+      CloseHandle( mapping );
+    CloseHandle( file );
+    itkExceptionMacro( "Could not map " << fileName << "." );
+  }
+  
+  m_FileHandle = file;
+  m_MappingHandle = mapping;
+#else
+  const vxl_uint_64 pageSize = sysconf( _SC_PAGESIZE );
+  const vxl_uint_64 mappedOffset = offset - offset % pageSize;
+  const vxl_uint_64 mappedLength = length + ( offset - mappedOffset );
+  
+  int file = open( fileName.c_str(), O_RDONLY );
+  
+  if( file < 0 )
+    itkExceptionMacro( "Could not open " << fileName << "." );
+    
+  void *data = mmap( 0, mappedLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, mappedOffset );
+  
+  // The mapping keeps the file open
+  close( file );
+  
+  if( data == MAP_FAILED )
+    itkExceptionMacro( "Could not map " << fileName << "." );
+#endif
+
+  m_FileName = fileName;
+  m_MappedBase = static_cast<char*>( data );
+  m_MappedLength = mappedLength;
+  m_Data = m_MappedBase + ( offset - mappedOffset );
+  m_Length = length;
+}
+
+
+void FileMapping::Unmap()
+{
+  if( m_MappedBase )
+  {
+#ifdef _WIN32
+    UnmapViewOfFile( m_MappedBase );
+    CloseHandle( m_MappingHandle );
+    CloseHandle( m_FileHandle );
+#else
+    munmap( m_MappedBase, m_MappedLength );
+#endif
+  }
+  
+  m_MappedBase = 0;
+  m_MappedLength = 0;
+  m_Data = 0;
+  m_Length = 0;
+  m_FileHandle = 0;
+  m_MappingHandle = 0;
+}
+
+
+void FileMapping::AdviseAccessPattern( AccessPatternType pattern )
+{
+#ifndef _WIN32
+  if( !m_MappedBase )
+    return;
+    
+  int advice = MADV_NORMAL;
+  
+  if( pattern == RandomAccess )
+    advice = MADV_RANDOM;
+  else if( pattern == SequentialAccess )
+    advice = MADV_SEQUENTIAL;
+    
+  madvise( m_MappedBase, m_MappedLength, advice );
+#endif
+}
+
+
+void FileMapping::AdviseWillNeed( vxl_uint_64 offset, vxl_uint_64 length )
+{
+#ifndef _WIN32
+  if( !m_MappedBase || offset >= m_Length )
+    return;
+  
+  if( length > m_Length - offset )
+    length = m_Length - offset;
+  
+  // The range must start at a page
+  const vxl_uint_64 pageSize = sysconf( _SC_PAGESIZE );
+  const vxl_uint_64 start = ( m_Data - m_MappedBase ) + offset;
+  const vxl_uint_64 alignedStart = start - start % pageSize;
+  
+  madvise( m_MappedBase + alignedStart, length + ( start - alignedStart ), MADV_WILLNEED );
+#endif
+}
+
+
+void FileMapping::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Length: " << m_Length << std::endl;
+  os << indent << "MappedLength: " << m_MappedLength << std::endl;
+}
+
+} // end namespace ivan
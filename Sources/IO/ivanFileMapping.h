@@ -0,0 +1,138 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFileMapping.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: maps a byte range of a file in memory.
+// Date: 2012/11/05
+
+
+#ifndef __ivanFileMapping_h
+#define __ivanFileMapping_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include "vxl_config.h"
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class FileMapping
+ *  \brief Maps a byte range of a file in memory.
+ *
+ * The pages of the range are read by the system as they are accessed, so only the part of the 
+ * file that is used becomes resident. Pages are private and copied on write, so the data may 
+ * be modified in memory without changing the file. The offset of the range does not need to be
+ * aligned to pages, the mapping is extended as needed and GetData() points to its first byte.
+ *
+ * The access pattern and the ranges about to be used can be advised to the system (madvise() 
+ * on POSIX systems), to read ahead sequential access and avoid reading ahead random access, 
+ * as when tracking. The hints are ignored on Windows.
+ *
+ * \sa MappedImageSource
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT FileMapping : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef FileMapping                     Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef enum { NormalAccess, RandomAccess, SequentialAccess } AccessPatternType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FileMapping, itk::Object );
+  
+  /** Map length bytes of the file from the given offset. Throws an exception if the file 
+    * cannot be mapped or is too short. */
+  void Map( const std::string & fileName, vxl_uint_64 offset, vxl_uint_64 length );
+  
+  /** Unmap the file. */
+  void Unmap();
+  
+  bool IsMapped() const
+    { return m_Data != 0; }
+  
+  char * GetData()
+    { return m_Data; }
+  const char * GetData() const
+    { return m_Data; }
+  
+  vxl_uint_64 GetLength() const
+    { return m_Length; }
+  
+  /** Advise the expected access pattern of the whole range. */
+  void AdviseAccessPattern( AccessPatternType pattern );
+  
+  /** Advise that the given range, relative to GetData(), will be accessed soon. */
+  void AdviseWillNeed( vxl_uint_64 offset, vxl_uint_64 length );
+  
+  /** Size of a file in bytes. Throws an exception if the file cannot be opened. */
+  static vxl_uint_64 GetFileSize( const std::string & fileName );
+		
+protected:
+
+  FileMapping();
+  ~FileMapping();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  FileMapping(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string     m_FileName;
+  
+  /** Mapped pages, from the offset rounded down to the mapping granularity. */
+  char            *m_MappedBase;
+  vxl_uint_64     m_MappedLength;
+  
+  char            *m_Data;
+  vxl_uint_64     m_Length;
+  
+  void            *m_FileHandle;
+  void            *m_MappingHandle;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,107 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedImageContainer.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: pixel container of an image file mapped in memory.
+// Date: 2012/11/05
+
+
+#ifndef __ivanMappedImageContainer_h
+#define __ivanMappedImageContainer_h
+
+#include "ivanFileMapping.h"
+
+#include "itkImportImageContainer.h"
+
+
+namespace ivan
+{
+  
+/** \class MappedImageContainer
+ *  \brief Pixel container whose elements are in a file mapped in memory.
+ *
+ * The container imports the data of a FileMapping and keeps the mapping while it exists, so 
+ * an image with this container can be used as any other and the file is unmapped when the 
+ * last reference to the image buffer is released. The memory is not managed by the 
+ * container: resizing or squeezing it allocates an ordinary buffer and copies the elements.
+ *
+ * \sa MappedImageSource
+ * \ingroup 
+ */
+ 
+template <class TElementIdentifier, class TElement>
+class ITK_EXPORT MappedImageContainer : 
+  public itk::ImportImageContainer<TElementIdentifier, TElement>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedImageContainer            Self;
+  typedef itk::ImportImageContainer
+    <TElementIdentifier, TElement>        Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TElementIdentifier              ElementIdentifier;
+  typedef TElement                        Element;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MappedImageContainer, ImportImageContainer );
+  
+  /** Use the given number of elements at the start of the mapping. */
+  void SetFileMapping( FileMapping * mapping, ElementIdentifier numberOfElements )
+    {
+      m_FileMapping = mapping;
+      this->SetImportPointer( reinterpret_cast<Element*>( mapping->GetData() ), 
+        numberOfElements, false );
+    }
+    
+  FileMapping * GetFileMapping()
+    { return m_FileMapping; }
+		
+protected:
+
+  MappedImageContainer() {}
+  ~MappedImageContainer() {}
+
+private:
+
+  MappedImageContainer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  FileMapping::Pointer    m_FileMapping;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedImageSource.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image source of an uncompressed image file mapped in memory.
+// Date: 2012/11/05
+
+
+#ifndef __ivanMappedImageSource_h
+#define __ivanMappedImageSource_h
+
+#include "ivanFileMapping.h"
+#include "ivanMappedImageContainer.h"
+
+#include "itkImageSource.h"
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class MappedImageSource
+ *  \brief Image source whose output buffer is an uncompressed image file mapped in memory.
+ *
+ * The output is an ordinary itk::Image whose pixel container is a mapping of the data of the 
+ * file (see MappedImageContainer), so any filter can take it as input. Nothing is read until 
+ * pixels are accessed, and then only the pages that contain them, so algorithms that touch a 
+ * small part of the volume, such as tracking along vessels, keep a resident memory of the size
+ * of their working set instead of the whole volume. The system may drop unmodified pages 
+ * under memory pressure, since they can be read again from the file. Pages are copied on write,
+ * so the output may be modified without changing the file.
+ *
+ * The file may be a MetaImage (.mha, .mhd) or NRRD (.nrrd, .nhdr) file with raw encoding, 
+ * with the data in the same file or in a separate one, or a raw file whose geometry is given 
+ * with SetSize(), SetSpacing(), SetOrigin() and SetDataOffset(). The element type must match 
+ * the pixel type of the output, and only scalar images are supported. Compressed data throws 
+ * an exception. If the data is in another byte order or not aligned to the pixel size in the 
+ * file (possible in files with the header and the data together), it cannot be mapped, and it
+ * is read into an ordinary buffer with a warning. GetMapped() tells which was the case.
+ *
+ * The whole image is always generated, since the mapping costs the same for any region.
+ * AccessPattern is advised to the system for the whole mapping: RandomAccess avoids reading
+ * ahead pages that are not needed when tracking, and SequentialAccess reads ahead for filters
+ * that sweep the volume. Default is NormalAccess.
+ *
+ * \sa FileMapping
+ * \ingroup 
+ */
+ 
+template <class TOutputImage>
+class ITK_EXPORT MappedImageSource : public itk::ImageSource<TOutputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedImageSource                 Self;
+  typedef itk::ImageSource<TOutputImage>    Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  typedef TOutputImage                            OutputImageType;
+  typedef typename OutputImageType::PixelType     PixelType;
+  typedef typename OutputImageType::RegionType    RegionType;
+  typedef typename OutputImageType::SizeType      SizeType;
+  typedef typename OutputImageType::SpacingType   SpacingType;
+  typedef typename OutputImageType::PointType     PointType;
+  typedef typename OutputImageType::DirectionType DirectionType;
+  
+  typedef typename OutputImageType::PixelContainer  PixelContainerType;
+  typedef MappedImageContainer
+    <typename PixelContainerType::ElementIdentifier, PixelType>  MappedContainerType;
+  
+  typedef FileMapping::AccessPatternType    AccessPatternType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MappedImageSource, ImageSource );
+  
+  /** Set/Get the image file, or the raw data file. */
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Geometry of raw files. Ignored for MetaImage and NRRD files. */
+  itkSetMacro( Size, SizeType );
+  itkGetConstReferenceMacro( Size, SizeType );
+  itkSetMacro( Spacing, SpacingType );
+  itkGetConstReferenceMacro( Spacing, SpacingType );
+  itkSetMacro( Origin, PointType );
+  itkGetConstReferenceMacro( Origin, PointType );
+  
+  /** Offset of the data in the raw file. For header files it is read from the header. 
+    * Default is 0. */
+  itkSetMacro( DataOffset, vxl_uint_64 );
+  itkGetConstMacro( DataOffset, vxl_uint_64 );
+  
+  /** Access pattern advised to the system. Default is NormalAccess. */
+  itkSetMacro( AccessPattern, AccessPatternType );
+  itkGetConstMacro( AccessPattern, AccessPatternType );
+  
+  /** File with the data, after updating the output information. */
+  itkGetStringMacro( DataFileName );
+  
+  /** Whether the output buffer is mapped, after updating. */
+  itkGetConstMacro( Mapped, bool );
+		
+protected:
+
+  MappedImageSource();
+  ~MappedImageSource() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Read the header and set the geometry of the output. */
+  virtual void GenerateOutputInformation();
+  
+  /** The whole image is generated. */
+  virtual void EnlargeOutputRequestedRegion( itk::DataObject * output );
+  
+  virtual void GenerateData();
+  
+  /** Read the header of MetaImage and NRRD files. */
+  void ReadMetaImageHeader();
+  void ReadNrrdHeader();
+  
+  /** Check that the element type of the file, given as its size in bytes and whether it is 
+    * integer and signed, matches the pixel type. */
+  void CheckElementType( unsigned int size, bool integer, bool isSigned ) const;
+  
+  /** Path of a data file given relative to the header file. */
+  std::string GetDataFilePath( const std::string & dataFile ) const;
+  
+  /** Offset after skipping the given number of lines of the data file from an offset. */
+  vxl_uint_64 SkipLines( const std::string & fileName, vxl_uint_64 offset, unsigned int lines );
+  
+  vxl_uint_64 GetDataLength() const;
+  
+  static std::string Trim( const std::string & text );
+
+private:
+
+  MappedImageSource(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string       m_FileName;
+  
+  SizeType          m_Size;
+  SpacingType       m_Spacing;
+  PointType         m_Origin;
+  vxl_uint_64       m_DataOffset;
+  
+  AccessPatternType m_AccessPattern;
+  
+  /** Geometry and data location of the last header read. */
+  std::string       m_DataFileName;
+  vxl_uint_64       m_FileDataOffset;
+  SizeType          m_FileSize;
+  SpacingType       m_FileSpacing;
+  PointType         m_FileOrigin;
+  DirectionType     m_FileDirection;
+  bool              m_BigEndian;
+  
+  bool              m_Mapped;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanMappedImageSource.hxx"
+#endif
+
+#endif
@@ -0,0 +1,606 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedImageSource.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: image source of an uncompressed image file mapped in memory.
+// Date: 2012/11/05
+
+#ifndef __ivanMappedImageSource_hxx
+#define __ivanMappedImageSource_hxx
+
+#include "ivanMappedImageSource.h"
+
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TOutputImage>
+MappedImageSource<TOutputImage>::MappedImageSource() :
+  m_DataOffset( 0 ),
+  m_AccessPattern( FileMapping::NormalAccess ),
+  m_FileDataOffset( 0 ),
+  m_BigEndian( false ),
+  m_Mapped( false )
+{
+  this->SetNumberOfRequiredInputs( 0 );
+  
+  m_Size.Fill( 0 );
+  m_Spacing.Fill( 1.0 );
+  m_Origin.Fill( 0.0 );
+  
+  m_FileSize.Fill( 0 );
+  m_FileSpacing.Fill( 1.0 );
+  m_FileOrigin.Fill( 0.0 );
+  m_FileDirection.SetIdentity();
+}
+
+
+template <class TOutputImage>
+std::string MappedImageSource<TOutputImage>::Trim( const std::string & text )
+{
+  const std::string::size_type first = text.find_first_not_of( " \t\r\n" );
+  
+  if( first == std::string::npos )
+    return std::string();
+    
+  return text.substr( first, text.find_last_not_of( " \t\r\n" ) - first + 1 );
+}
+
+
+template <class TOutputImage>
+std::string 
+MappedImageSource<TOutputImage>::GetDataFilePath( const std::string & dataFile ) const
+{
+  if( dataFile.empty() || dataFile[0] == '/' || dataFile[0] == '\\' || 
+    ( dataFile.size() > 1 && dataFile[1] == ':' ) )
+  {
+    return dataFile;
+  }
+  
+  const std::string::size_type separator = m_FileName.find_last_of( "/\\" );
+  
+  if( separator == std::string::npos )
+    return dataFile;
+    
+  return m_FileName.substr( 0, separator + 1 ) + dataFile;
+}
+
+
+template <class TOutputImage>
+vxl_uint_64 MappedImageSource<TOutputImage>::SkipLines( const std::string & fileName, 
+  vxl_uint_64 offset, unsigned int lines )
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  file.seekg( static_cast<std::streamoff>( offset ) );
+  
+  std::string line;
+  
+  for( unsigned int i=0; i<lines; ++i )
+  {
+    if( !std::getline( file, line ) )
+      itkExceptionMacro( "Could not skip " << lines << " lines of " << fileName << "." );
+  }
+  
+  return static_cast<vxl_uint_64>( file.tellg() );
+}
+
+
+template <class TOutputImage>
+vxl_uint_64 MappedImageSource<TOutputImage>::GetDataLength() const
+{
+  vxl_uint_64 numberOfPixels = 1;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    numberOfPixels *= m_FileSize[i];
+    
+  return numberOfPixels * sizeof( PixelType );
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::CheckElementType( unsigned int size, bool integer, 
+  bool isSigned ) const
+{
+  if( size != sizeof( PixelType ) || integer != std::numeric_limits<PixelType>::is_integer ||
+    isSigned != std::numeric_limits<PixelType>::is_signed )
+  {
+    itkExceptionMacro( "The element type of " << m_FileName << " does not match the pixel type." );
+  }
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::ReadMetaImageHeader()
+{
+  std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << "." );
+    
+  unsigned int dimension = 0;
+  unsigned int channels = 1;
+  bool compressed = false;
+  long headerSize = 0;
+  std::string elementType;
+  std::string dataFile;
+  
+  std::vector<double> sizes, spacings, elementSizes, origin, matrix;
+  
+  m_BigEndian = false;
+  
+  // ElementDataFile is the last field
+  std::string line;
+  
+  while( dataFile.empty() && std::getline( file, line ) )
+  {
+    const std::string::size_type equal = line.find( '=' );
+    
+    if( equal == std::string::npos )
+      continue;
+      
+    const std::string key = Trim( line.substr( 0, equal ) );
+    const std::string text = Trim( line.substr( equal + 1 ) );
+    std::istringstream value( text );
+    
+    std::vector<double> *values = 0;
+    
+    if( key == "NDims" )
+      value >> dimension;
+    else if( key == "DimSize" )
+      values = &sizes;
+    else if( key == "ElementSpacing" )
+      values = &spacings;
+    else if( key == "ElementSize" )
+      values = &elementSizes;
+    else if( key == "Offset" || key == "Origin" || key == "Position" )
+      values = &origin;
+    else if( key == "TransformMatrix" || key == "Rotation" || key == "Orientation" )
+      values = &matrix;
+    else if( key == "ElementType" )
+      elementType = text;
+    else if( key == "ElementByteOrderMSB" || key == "BinaryDataByteOrderMSB" )
+      m_BigEndian = ( text == "True" || text == "true" || text == "1" );
+    else if( key == "CompressedData" )
+      compressed = ( text == "True" || text == "true" || text == "1" );
+    else if( key == "ElementNumberOfChannels" )
+      value >> channels;
+    else if( key == "HeaderSize" )
+      value >> headerSize;
+    else if( key == "ElementDataFile" )
+      dataFile = text;
+    
+    double number;
+    
+    while( values && value >> number )
+      values->push_back( number );
+  }
+  
+  if( dataFile.empty() )
+    itkExceptionMacro( "File " << m_FileName << " has no ElementDataFile." );
+  if( compressed )
+    itkExceptionMacro( "File " << m_FileName << " is compressed and cannot be mapped." );
+  if( channels != 1 )
+    itkExceptionMacro( "File " << m_FileName << " is not a scalar image." );
+  if( dimension != ImageDimension || sizes.size() < ImageDimension )
+    itkExceptionMacro( "File " << m_FileName << " has dimension " << dimension << "." );
+    
+  if( elementType == "MET_CHAR" )
+    this->CheckElementType( 1, true, true );
+  else if( elementType == "MET_UCHAR" )
+    this->CheckElementType( 1, true, false );
+  else if( elementType == "MET_SHORT" )
+    this->CheckElementType( 2, true, true );
+  else if( elementType == "MET_USHORT" )
+    this->CheckElementType( 2, true, false );
+  else if( elementType == "MET_INT" || elementType == "MET_LONG" )
+    this->CheckElementType( 4, true, true );
+  else if( elementType == "MET_UINT" || elementType == "MET_ULONG" )
+    this->CheckElementType( 4, true, false );
+  else if( elementType == "MET_LONG_LONG" )
+    this->CheckElementType( 8, true, true );
+  else if( elementType == "MET_ULONG_LONG" )
+    this->CheckElementType( 8, true, false );
+  else if( elementType == "MET_FLOAT" )
+    this->CheckElementType( 4, false, true );
+  else if( elementType == "MET_DOUBLE" )
+    this->CheckElementType( 8, false, true );
+  else
+    itkExceptionMacro( "Element type " << elementType << " of " << m_FileName << " is not supported." );
+  
+  if( spacings.size() < ImageDimension )
+    spacings = elementSizes;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+  {
+    m_FileSize[i] = static_cast<typename SizeType::SizeValueType>( sizes[i] );
+    m_FileSpacing[i] = ( i < spacings.size() ) ? spacings[i] : 1.0;
+    m_FileOrigin[i] = ( i < origin.size() ) ? origin[i] : 0.0;
+    
+    // Each row of the matrix is the direction of an axis
+    for( unsigned int j=0; j<ImageDimension; ++j )
+    {
+      if( matrix.size() >= ImageDimension * ImageDimension )
+        m_FileDirection[j][i] = matrix[ i * dimension + j ];
+      else
+        m_FileDirection[j][i] = ( i == j ) ? 1.0 : 0.0;
+    }
+  }
+  
+  if( dataFile == "LOCAL" )
+  {
+    m_DataFileName = m_FileName;
+    m_FileDataOffset = static_cast<vxl_uint_64>( file.tellg() );
+  }
+  else if( dataFile.compare( 0, 4, "LIST" ) == 0 || dataFile.find( '%' ) != std::string::npos )
+  {
+    itkExceptionMacro( "File " << m_FileName << " has its data in several files." );
+  }
+  else
+  {
+    m_DataFileName = this->GetDataFilePath( dataFile );
+    
+    // A negative header size places the data at the end of the file
+    if( headerSize >= 0 )
+      m_FileDataOffset = headerSize;
+    else
+      m_FileDataOffset = FileMapping::GetFileSize( m_DataFileName ) - this->GetDataLength();
+  }
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::ReadNrrdHeader()
+{
+  std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << "." );
+  
+  std::string line;
+  
+  if( !std::getline( file, line ) || line.compare( 0, 7, "NRRD000" ) != 0 )
+    itkExceptionMacro( "File " << m_FileName << " is not a NRRD file." );
+    
+  unsigned int dimension = 0;
+  long byteSkip = 0;
+  unsigned int lineSkip = 0;
+  std::string type, encoding( "raw" ), space, dataFile;
+  bool attached = false;
+  
+  std::vector<double> sizes, spacings, origin;
+  std::vector< std::vector<double> > directions;
+  
+  m_BigEndian = false;
+  
+  while( std::getline( file, line ) )
+  {
+    line = Trim( line );
+    
+    // The attached data starts after an empty line
+    if( line.empty() )
+    {
+      attached = true;
+      break;
+    }
+    
+    if( line[0] == '#' || line.find( ":=" ) != std::string::npos )
+      continue;
+    
+    const std::string::size_type colon = line.find( ':' );
+    
+    if( colon == std::string::npos )
+      continue;
+    
+    std::string field = Trim( line.substr( 0, colon ) );
+    std::transform( field.begin(), field.end(), field.begin(), ::tolower );
+    
+    const std::string text = Trim( line.substr( colon + 1 ) );
+    std::istringstream value( text );
+    
+    std::vector<double> *values = 0;
+    
+    if( field == "type" )
+      type = text;
+    else if( field == "dimension" )
+      value >> dimension;
+    else if( field == "sizes" )
+      values = &sizes;
+    else if( field == "spacings" )
+      values = &spacings;
+    else if( field == "encoding" )
+      encoding = text;
+    else if( field == "endian" )
+      m_BigEndian = ( text == "big" );
+    else if( field == "space" )
+      space = text;
+    else if( field == "data file" || field == "datafile" )
+      dataFile = text;
+    else if( field == "byte skip" || field == "byteskip" )
+      value >> byteSkip;
+    else if( field == "line skip" || field == "lineskip" )
+      value >> lineSkip;
+    else if( field == "space directions" || field == "space origin" )
+    {
+      // Vectors as (x,y,z), or none
+      std::vector< std::vector<double> > vectors;
+      std::string::size_type position = 0;
+      
+      while( position < text.size() )
+      {
+        if( text.compare( position, 4, "none" ) == 0 )
+        {
+          vectors.push_back( std::vector<double>() );
+          position += 4;
+        }
+        else if( text[position] == '(' )
+        {
+          const std::string::size_type end = text.find( ')', position );
+          std::string components = text.substr( position + 1, end - position - 1 );
+          std::replace( components.begin(), components.end(), ',', ' ' );
+          
+          std::istringstream stream( components );
+          std::vector<double> vector;
+          double number;
+          
+          while( stream >> number )
+            vector.push_back( number );
+            
+          vectors.push_back( vector );
+          position = ( end == std::string::npos ) ? text.size() : end + 1;
+        }
+        else
+          ++position;
+      }
+      
+      if( field == "space directions" )
+        directions = vectors;
+      else if( !vectors.empty() )
+        origin = vectors[0];
+    }
+    
+    double number;
+    
+    while( values && value >> number )
+      values->push_back( number );
+  }
+  
+  if( encoding != "raw" )
+    itkExceptionMacro( "File " << m_FileName << " has " << encoding << " encoding and cannot be mapped." );
+  if( dimension != ImageDimension || sizes.size() < ImageDimension )
+    itkExceptionMacro( "File " << m_FileName << " has dimension " << dimension << "." );
+  
+  if( type == "signed char" || type == "int8" || type == "int8_t" )
+    this->CheckElementType( 1, true, true );
+  else if( type == "uchar" || type == "unsigned char" || type == "uint8" || type == "uint8_t" )
+    this->CheckElementType( 1, true, false );
+  else if( type == "short" || type == "short int" || type == "signed short" || 
+    type == "signed short int" || type == "int16" || type == "int16_t" )
+    this->CheckElementType( 2, true, true );
+  else if( type == "ushort" || type == "unsigned short" || type == "unsigned short int" || 
+    type == "uint16" || type == "uint16_t" )
+    this->CheckElementType( 2, true, false );
+  else if( type == "int" || type == "signed int" || type == "int32" || type == "int32_t" )
+    this->CheckElementType( 4, true, true );
+  else if( type == "uint" || type == "unsigned int" || type == "uint32" || type == "uint32_t" )
+    this->CheckElementType( 4, true, false );
+  else if( type == "longlong" || type == "long long" || type == "long long int" || 
+    type == "signed long long" || type == "signed long long int" || type == "int64" || 
+    type == "int64_t" )
+    this->CheckElementType( 8, true, true );
+  else if( type == "ulonglong" || type == "unsigned long long" || 
+    type == "unsigned long long int" || type == "uint64" || type == "uint64_t" )
+    this->CheckElementType( 8, true, false );
+  else if( type == "float" )
+    this->CheckElementType( 4, false, true );
+  else if( type == "double" )
+    this->CheckElementType( 8, false, true );
+  else
+    itkExceptionMacro( "Type " << type << " of " << m_FileName << " is not supported." );
+    
+  // ITK uses LPS coordinates
+  std::vector<double> flip( ImageDimension, 1.0 );
+  
+  if( space == "right-anterior-superior" || space == "RAS" )
+    flip[0] = flip[1] = -1.0;
+  else if( space == "left-anterior-superior" || space == "LAS" )
+    flip[1] = -1.0;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+  {
+    m_FileSize[i] = static_cast<typename SizeType::SizeValueType>( sizes[i] );
+    m_FileOrigin[i] = ( i < origin.size() ) ? flip[i] * origin[i] : 0.0;
+    
+    if( i < directions.size() && directions[i].size() >= ImageDimension )
+    {
+      double norm = 0.0;
+      
+      for( unsigned int j=0; j<ImageDimension; ++j )
+        norm += directions[i][j] * directions[i][j];
+        
+      norm = std::sqrt( norm );
+      m_FileSpacing[i] = norm;
+      
+      for( unsigned int j=0; j<ImageDimension; ++j )
+        m_FileDirection[j][i] = ( norm > 0.0 ) ? flip[j] * directions[i][j] / norm : ( i == j );
+    }
+    else
+    {
+      m_FileSpacing[i] = ( i < spacings.size() && spacings[i] == spacings[i] ) ? spacings[i] : 1.0;
+      
+      for( unsigned int j=0; j<ImageDimension; ++j )
+        m_FileDirection[j][i] = ( i == j ) ? 1.0 : 0.0;
+    }
+  }
+  
+  vxl_uint_64 offset = 0;
+  
+  if( !dataFile.empty() )
+  {
+    if( dataFile.compare( 0, 4, "LIST" ) == 0 || dataFile.find( ' ' ) != std::string::npos )
+      itkExceptionMacro( "File " << m_FileName << " has its data in several files." );
+      
+    m_DataFileName = this->GetDataFilePath( dataFile );
+  }
+  else if( attached )
+  {
+    m_DataFileName = m_FileName;
+    offset = static_cast<vxl_uint_64>( file.tellg() );
+  }
+  else
+    itkExceptionMacro( "File " << m_FileName << " has no data." );
+  
+  if( lineSkip )
+    offset = this->SkipLines( m_DataFileName, offset, lineSkip );
+  
+  // A byte skip of -1 places the data at the end of the file
+  if( byteSkip >= 0 )
+    m_FileDataOffset = offset + byteSkip;
+  else
+    m_FileDataOffset = FileMapping::GetFileSize( m_DataFileName ) - this->GetDataLength();
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::GenerateOutputInformation()
+{
+  if( m_FileName.empty() )
+    itkExceptionMacro( "No file name given." );
+  
+  std::string extension;
+  const std::string::size_type dot = m_FileName.find_last_of( '.' );
+  
+  if( dot != std::string::npos )
+    extension = m_FileName.substr( dot );
+    
+  std::transform( extension.begin(), extension.end(), extension.begin(), ::tolower );
+  
+  if( extension == ".mha" || extension == ".mhd" )
+    this->ReadMetaImageHeader();
+  else if( extension == ".nrrd" || extension == ".nhdr" )
+    this->ReadNrrdHeader();
+  else
+  {
+    m_DataFileName = m_FileName;
+    m_FileDataOffset = m_DataOffset;
+    m_FileSize = m_Size;
+    m_FileSpacing = m_Spacing;
+    m_FileOrigin = m_Origin;
+    m_FileDirection.SetIdentity();
+    m_BigEndian = itk::ByteSwapper<PixelType>::SystemIsBigEndian();
+  }
+  
+  RegionType region;
+  region.SetSize( m_FileSize );
+  
+  OutputImageType *output = this->GetOutput();
+  output->SetLargestPossibleRegion( region );
+  output->SetSpacing( m_FileSpacing );
+  output->SetOrigin( m_FileOrigin );
+  output->SetDirection( m_FileDirection );
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::EnlargeOutputRequestedRegion( itk::DataObject * output )
+{
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::GenerateData()
+{
+  OutputImageType *output = this->GetOutput();
+  output->SetBufferedRegion( output->GetLargestPossibleRegion() );
+  
+  const unsigned long numberOfPixels = output->GetLargestPossibleRegion().GetNumberOfPixels();
+  const vxl_uint_64 length = this->GetDataLength();
+  
+  const bool nativeOrder = sizeof( PixelType ) == 1 || 
+    m_BigEndian == itk::ByteSwapper<PixelType>::SystemIsBigEndian();
+  
+  // Mappings start at a page, so pixels are aligned if their offset is
+  m_Mapped = nativeOrder && m_FileDataOffset % sizeof( PixelType ) == 0;
+  
+  if( m_Mapped )
+  {
+    FileMapping::Pointer mapping = FileMapping::New();
+    mapping->Map( m_DataFileName, m_FileDataOffset, length );
+    mapping->AdviseAccessPattern( m_AccessPattern );
+    
+    typename MappedContainerType::Pointer container = MappedContainerType::New();
+    container->SetFileMapping( mapping, numberOfPixels );
+    output->SetPixelContainer( container );
+    
+    return;
+  }
+  
+  itkWarningMacro( "The data of " << m_DataFileName << " is " << 
+    ( nativeOrder ? "not aligned" : "in another byte order" ) << ", so it is read instead of mapped." );
+  
+  output->Allocate();
+  
+  std::ifstream file( m_DataFileName.c_str(), std::ios::in | std::ios::binary );
+  file.seekg( static_cast<std::streamoff>( m_FileDataOffset ) );
+  file.read( reinterpret_cast<char*>( output->GetBufferPointer() ), length );
+  
+  if( !file )
+    itkExceptionMacro( "Could not read " << length << " bytes from " << m_DataFileName << "." );
+  
+  if( !nativeOrder && m_BigEndian )
+    itk::ByteSwapper<PixelType>::SwapRangeFromSystemToBigEndian( output->GetBufferPointer(), numberOfPixels );
+  else if( !nativeOrder )
+    itk::ByteSwapper<PixelType>::SwapRangeFromSystemToLittleEndian( output->GetBufferPointer(), numberOfPixels );
+}
+
+
+template <class TOutputImage>
+void MappedImageSource<TOutputImage>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "Spacing: " << m_Spacing << std::endl;
+  os << indent << "Origin: " << m_Origin << std::endl;
+  os << indent << "DataOffset: " << m_DataOffset << std::endl;
+  os << indent << "AccessPattern: " << m_AccessPattern << std::endl;
+  os << indent << "DataFileName: " << m_DataFileName << std::endl;
+  os << indent << "Mapped: " << m_Mapped << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanMappedImageSource_hxx
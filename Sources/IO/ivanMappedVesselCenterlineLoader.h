@@ -0,0 +1,129 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedVesselCenterlineLoader.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: loads vessel centerlines on demand from a mapped binary vessel graph file.
+// Date: 2012/11/05
+
+#ifndef __ivanMappedVesselCenterlineLoader_h
+#define __ivanMappedVesselCenterlineLoader_h
+
+#include "ivanVesselCenterlineLoader.h"
+#include "ivanMappedVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObjectFactory.h"
+
+#include <map>
+
+
+namespace ivan
+{
+  
+/** \class MappedVesselCenterlineLoader
+ *  \brief Loads the centerlines of vessel branches from a mapped binary vessel graph file.
+ *
+ * Each branch added with AddBranch() is linked to the index of its node in the file, and its 
+ * sections are created from the mapped columns on first access. The loader keeps the graph 
+ * mapped while any of its branches exists. Only the pages of the accessed branches are read.
+ *
+ * VesselGraphBinaryReader uses this loader when LazyCenterlines is on, and CreateCenterline()
+ * to read all the centerlines otherwise.
+ *
+ * \sa VesselCenterlineLoader
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT MappedVesselCenterlineLoader : public VesselCenterlineLoader<TCenterline>
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedVesselCenterlineLoader           Self;
+  typedef VesselCenterlineLoader<TCenterline>    Superclass;
+  typedef itk::SmartPointer<Self>                Pointer;
+  typedef itk::SmartPointer<const Self>          ConstPointer;
+  
+  typedef typename Superclass::CenterlineType     CenterlineType;
+  typedef typename Superclass::CenterlinePointer  CenterlinePointer;
+  typedef typename Superclass::BranchNodeType     BranchNodeType;
+  typedef typename CenterlineType::SectionType    SectionType;
+  
+  typedef MappedVesselGraph::NodeIndex            NodeIndex;
+  
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::CurveMetricsType>    CurveMetricsTraitsType;
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::SectionMetricsType>  SectionMetricsTraitsType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MappedVesselCenterlineLoader, VesselCenterlineLoader );
+  
+  /** Set the open graph the centerlines are read from. */
+  void SetMappedGraph( const MappedVesselGraph * graph );
+  const MappedVesselGraph * GetMappedGraph() const
+    { return m_MappedGraph; }
+    
+  /** Load the centerline of the branch from the given node of the file. */
+  void AddBranch( BranchNodeType * branch, NodeIndex node );
+  
+  /** Create the centerline of a node of the file. */
+  CenterlinePointer CreateCenterline( NodeIndex node ) const;
+	
+protected:
+
+  MappedVesselCenterlineLoader() {}
+  ~MappedVesselCenterlineLoader() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  virtual CenterlinePointer LoadCenterline( const BranchNodeType * branch );
+  virtual void ForgetBranch( const BranchNodeType * branch )
+    { m_BranchNodes.erase( branch ); }
+
+private:
+
+  MappedVesselCenterlineLoader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  MappedVesselGraph::ConstPointer               m_MappedGraph;
+  std::map<const BranchNodeType*,NodeIndex>     m_BranchNodes;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanMappedVesselCenterlineLoader.hxx"
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedVesselCenterlineLoader.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: loads vessel centerlines on demand from a mapped binary vessel graph file.
+// Date: 2012/11/05
+
+#ifndef __ivanMappedVesselCenterlineLoader_hxx
+#define __ivanMappedVesselCenterlineLoader_hxx
+
+#include "ivanMappedVesselCenterlineLoader.h"
+#include "ivanCompressedVesselCenterline.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+void MappedVesselCenterlineLoader<TCenterline>::SetMappedGraph( const MappedVesselGraph * graph )
+{
+  if( m_MappedGraph.GetPointer() == graph )
+    return;
+    
+  // Resident centerlines were read from the previous graph
+  this->ReleaseCenterlines();
+  
+  this->m_Mutex.Lock();
+  m_MappedGraph = graph;
+  this->m_Mutex.Unlock();
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void MappedVesselCenterlineLoader<TCenterline>::AddBranch( BranchNodeType * branch, NodeIndex node )
+{
+  if( !branch )
+    return;
+    
+  branch->SetCenterlineLoader( this );
+  
+  this->m_Mutex.Lock();
+  m_BranchNodes[branch] = node;
+  this->m_Mutex.Unlock();
+}
+
+
+template <class TCenterline>
+typename MappedVesselCenterlineLoader<TCenterline>::CenterlinePointer 
+MappedVesselCenterlineLoader<TCenterline>::CreateCenterline( NodeIndex node ) const
+{
+  CenterlinePointer centerline = CenterlineType::New();
+  
+  if( m_MappedGraph.IsNull() || !m_MappedGraph->IsOpen() || node >= m_MappedGraph->GetNumberOfNodes() )
+    return centerline;
+    
+  const unsigned int dimension = SectionType::Dimension;
+    
+  const bool readCurveMetrics = m_MappedGraph->GetCurveMetrics() && 
+    m_MappedGraph->GetHeader().CurveMetricsSize == CurveMetricsTraitsType::GetSize();
+  const bool readSectionMetrics = m_MappedGraph->GetSectionMetrics() && 
+    m_MappedGraph->GetHeader().SectionMetricsSize == SectionMetricsTraitsType::GetSize();
+    
+  const unsigned int numberOfSections = m_MappedGraph->GetNumberOfSections( node );
+  const unsigned long first = m_MappedGraph->GetSectionOffset( node );
+  const unsigned long last = first + numberOfSections;
+  
+  const double *centers = m_MappedGraph->GetCenters();
+  const double *normals = m_MappedGraph->GetNormals();
+  const double *radii = m_MappedGraph->GetRadii();
+  const double *scales = m_MappedGraph->GetScales();
+  const double *arclengths = m_MappedGraph->GetArclengths();
+  
+  // Compressed sections are decoded to columns of the branch only
+  std::vector<double> decodedColumns;
+  unsigned long columnsOffset = 0;
+  
+  if( m_MappedGraph->HasCompressedSections() && numberOfSections )
+  {
+    CompressedVesselCenterline::Pointer compressedCenterline = CompressedVesselCenterline::New();
+    compressedCenterline->SetBuffer( m_MappedGraph->GetCompressedSections( node ), 
+      m_MappedGraph->GetCompressedSectionsSize( node ) );
+      
+    if( compressedCenterline->GetDimension() != dimension || 
+      compressedCenterline->GetNumberOfSections() != numberOfSections )
+    {
+      itkExceptionMacro( "Wrong compressed sections of node " << node << "." );
+    }
+    
+    decodedColumns.resize( numberOfSections * ( 2 * dimension + 3 ) );
+    
+    double *decodedCenters = &decodedColumns[0];
+    double *decodedNormals = decodedCenters + numberOfSections * dimension;
+    double *decodedRadii = decodedNormals + numberOfSections * dimension;
+    double *decodedScales = decodedRadii + numberOfSections;
+    double *decodedArclengths = decodedScales + numberOfSections;
+    
+    compressedCenterline->Decode( decodedCenters, decodedNormals, decodedRadii, decodedScales, 
+      decodedArclengths );
+      
+    centers = decodedCenters;
+    normals = decodedNormals;
+    radii = decodedRadii;
+    scales = decodedScales;
+    arclengths = decodedArclengths;
+    
+    columnsOffset = first;
+  }
+  
+  centerline->reserve( numberOfSections );
+  
+  for( unsigned long s=first; s<last; ++s )
+  {
+    const unsigned long c = s - columnsOffset;
+    
+    typename SectionType::Pointer section = SectionType::New();
+    
+    typename SectionType::PointType center;
+    typename SectionType::VectorType normal;
+    
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      center[d] = centers[ c * dimension + d ];
+      normal[d] = normals[ c * dimension + d ];
+    }
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( radii[c] );
+    section->SetScale( scales[c] );
+    section->SetArclength( arclengths[c] );
+    
+    if( readCurveMetrics )
+      CurveMetricsTraitsType::Read( m_MappedGraph->GetCurveMetrics() + s * CurveMetricsTraitsType::GetSize(), 
+        section->GetCurveMetrics() );
+        
+    if( readSectionMetrics )
+      SectionMetricsTraitsType::Read( m_MappedGraph->GetSectionMetrics() + s * SectionMetricsTraitsType::GetSize(),
+        section->GetSectionMetrics() );
+    
+    centerline->push_back( section );
+  }
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+typename MappedVesselCenterlineLoader<TCenterline>::CenterlinePointer 
+MappedVesselCenterlineLoader<TCenterline>::LoadCenterline( const BranchNodeType * branch )
+{
+  typename std::map<const BranchNodeType*,NodeIndex>::const_iterator it = m_BranchNodes.find( branch );
+  
+  if( it == m_BranchNodes.end() )
+    return CenterlineType::New();
+    
+  return this->CreateCenterline( it->second );
+}
+
+
+template <class TCenterline>
+void MappedVesselCenterlineLoader<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "MappedGraph: " << m_MappedGraph.GetPointer() << std::endl;
+  os << indent << "NumberOfBranches: " << m_BranchNodes.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
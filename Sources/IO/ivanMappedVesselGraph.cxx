@@ -0,0 +1,423 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedVesselGraph.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: read-only view of a memory mapped binary vessel graph file.
+// Date: 2012/11/05
+
+
+#include "ivanMappedVesselGraph.h"
+#include "ivanCompressedVesselCenterline.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace ivan
+{
+
+namespace
+{
+  /** Product of two sizes read from a file, which returns false if it does not fit in 64 bits, 
+    * so that corrupt counts cannot wrap around to sizes that pass the checks. */
+  inline bool MultiplySizes( vxl_uint_64 a, vxl_uint_64 b, vxl_uint_64 & product )
+  {
+    if( b != 0 && a > ~vxl_uint_64( 0 ) / b )
+      return false;
+      
+    product = a * b;
+    return true;
+  }
+}
+
+
+MappedVesselGraph::MappedVesselGraph() :
+  m_Data( 0 ),
+  m_DataSize( 0 ),
+  m_FileHandle( 0 ),
+  m_MappingHandle( 0 )
+{
+  memset( &m_Header, 0, sizeof(m_Header) );
+  this->Close();
+}
+
+
+MappedVesselGraph::~MappedVesselGraph()
+{
+  this->Close();
+}
+
+
+void MappedVesselGraph::Open( const std::string & fileName )
+{
+  this->Close();
+  
+#ifdef _WIN32
+  HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL );
+  
+  if( file == INVALID_HANDLE_VALUE )
+    itkExceptionMacro( "Could not open " << fileName << "." );
+    
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx( file, &fileSize );
+  
+  HANDLE mapping = fileSize.QuadPart ? CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+  const void *data = mapping ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+  
+  if( !data )
+  {
+    if( mapping )
+      CloseHandle( mapping );
+    CloseHandle( file );
+    itkExceptionMacro( "Could not map " << fileName << "." );
+  }
+  
+  m_FileHandle = file;
+  m_MappingHandle = mapping;
+  m_DataSize = fileSize.QuadPart;
+  m_Data = static_cast<const char*>( data );
+#else
+  int file = open( fileName.c_str(), O_RDONLY );
+  
+  if( file < 0 )
+    itkExceptionMacro( "Could not open " << fileName << "." );
+    
+  struct stat fileStatus;
+  void *data = MAP_FAILED;
+  
+  if( fstat( file, &fileStatus ) == 0 && fileStatus.st_size > 0 )
+    data = mmap( 0, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+  
+  // The mapping keeps the file open
+  close( file );
+  
+  if( data == MAP_FAILED )
+    itkExceptionMacro( "Could not map " << fileName << "." );
+    
+  m_DataSize = fileStatus.st_size;
+  m_Data = static_cast<const char*>( data );
+#endif
+
+  m_FileName = fileName;
+  
+  try
+  {
+    // Fixed part of the header
+    const unsigned int columnsOffset = reinterpret_cast<const char*>( m_Header.Columns ) - 
+      reinterpret_cast<const char*>( &m_Header );
+    
+    if( m_DataSize < columnsOffset )
+      itkExceptionMacro( "File " << fileName << " is too short." );
+      
+    memcpy( &m_Header, m_Data, columnsOffset );
+    
+    if( strncmp( m_Header.Magic, FormatType::GetMagic(), sizeof(m_Header.Magic) ) != 0 )
+      itkExceptionMacro( "File " << fileName << " is not a vessel graph file." );
+      
+    if( m_Header.ByteOrderMark != FormatType::ByteOrderMark )
+      itkExceptionMacro( "File " << fileName << " was written with another byte order." );
+      
+    if( m_Header.MajorVersion != FormatType::MajorVersion )
+      itkExceptionMacro( "File " << fileName << " has version " << m_Header.MajorVersion << "." 
+        << m_Header.MinorVersion << ", but version " << FormatType::MajorVersion << " is supported." );
+    
+    // Columns of later minor versions are ignored, and those of earlier ones are empty
+    if( m_Header.NumberOfColumns > ( m_DataSize - columnsOffset ) / sizeof(VesselGraphBinaryColumn) )
+      itkExceptionMacro( "File " << fileName << " is too short." );
+      
+    const vxl_uint_64 numberOfColumns = 
+      std::min<vxl_uint_64>( m_Header.NumberOfColumns, FormatType::NumberOfColumns );
+    
+    memcpy( m_Header.Columns, m_Data + columnsOffset, numberOfColumns * sizeof(VesselGraphBinaryColumn) );
+    
+    const vxl_uint_64 numberOfNodes = m_Header.NumberOfNodes;
+    const vxl_uint_64 numberOfLinks = m_Header.NumberOfLinks;
+    const vxl_uint_64 numberOfSections = m_Header.NumberOfSections;
+    const vxl_uint_64 dimension = m_Header.Dimension;
+    
+    if( numberOfNodes >= 0xffffffffu || numberOfLinks >= 0xffffffffu || 
+      m_Header.NumberOfNodeTypes >= 0xffffffffu )
+      itkExceptionMacro( "File " << fileName << " has too many nodes." );
+      
+    // Compressed files have no uncompressed section columns
+    const bool compressed = m_Header.NumberOfColumns > FormatType::CompressedSectionOffsetsColumn &&
+      m_Header.Columns[FormatType::CompressedSectionOffsetsColumn].Size != 0;
+    const vxl_uint_64 numberOfUncompressedSections = compressed ? 0 : numberOfSections;
+    
+    vxl_uint_64 numberOfSectionValues;
+    
+    if( !MultiplySizes( numberOfUncompressedSections, dimension, numberOfSectionValues ) )
+      itkExceptionMacro( "File " << fileName << " has too many sections." );
+    
+    m_NodeIds = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::NodeIdsColumn, numberOfNodes, 4 ) );
+    m_NodeTypes = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::NodeTypesColumn, numberOfNodes, 4 ) );
+    m_Masks = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::MasksColumn, numberOfNodes, 4 ) );
+    m_DepthLevels = reinterpret_cast<const vxl_int_32*>( 
+      this->GetColumn( FormatType::DepthLevelsColumn, numberOfNodes, 4 ) );
+    m_Flags = reinterpret_cast<const vxl_uint_8*>( 
+      this->GetColumn( FormatType::FlagsColumn, numberOfNodes, 1 ) );
+    m_NameOffsets = reinterpret_cast<const vxl_uint_64*>( 
+      this->GetColumn( FormatType::NameOffsetsColumn, numberOfNodes + 1, 8 ) );
+    m_NodeTypeNameOffsets = reinterpret_cast<const vxl_uint_64*>( 
+      this->GetColumn( FormatType::NodeTypeNameOffsetsColumn, m_Header.NumberOfNodeTypes + 1, 8 ) );
+    m_ChildOffsets = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::ChildOffsetsColumn, numberOfNodes + 1, 4 ) );
+    m_Children = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::ChildrenColumn, numberOfLinks, 4 ) );
+    m_ParentOffsets = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::ParentOffsetsColumn, numberOfNodes + 1, 4 ) );
+    m_Parents = reinterpret_cast<const vxl_uint_32*>( 
+      this->GetColumn( FormatType::ParentsColumn, numberOfLinks, 4 ) );
+    m_SectionOffsets = reinterpret_cast<const vxl_uint_64*>( 
+      this->GetColumn( FormatType::SectionOffsetsColumn, numberOfNodes + 1, 8 ) );
+    m_Centers = reinterpret_cast<const double*>( 
+      this->GetColumn( FormatType::CentersColumn, numberOfSectionValues, 8 ) );
+    m_Normals = reinterpret_cast<const double*>( 
+      this->GetColumn( FormatType::NormalsColumn, numberOfSectionValues, 8 ) );
+    m_Radii = reinterpret_cast<const double*>( 
+      this->GetColumn( FormatType::RadiiColumn, numberOfUncompressedSections, 8 ) );
+    m_Scales = reinterpret_cast<const double*>( 
+      this->GetColumn( FormatType::ScalesColumn, numberOfUncompressedSections, 8 ) );
+    m_Arclengths = reinterpret_cast<const double*>( 
+      this->GetColumn( FormatType::ArclengthsColumn, numberOfUncompressedSections, 8 ) );
+    m_CurveMetrics = 
+      this->GetColumn( FormatType::CurveMetricsColumn, numberOfSections, m_Header.CurveMetricsSize );
+    m_SectionMetrics = 
+      this->GetColumn( FormatType::SectionMetricsColumn, numberOfSections, m_Header.SectionMetricsSize );
+    
+    // The variable size columns are checked against the offsets
+    this->CheckOffsets( m_NameOffsets, numberOfNodes + 1, 
+      m_Header.Columns[FormatType::NamesColumn].Size );
+    m_Names = this->GetColumn( FormatType::NamesColumn, 
+      m_Header.Columns[FormatType::NamesColumn].Size, 1 );
+    
+    this->CheckOffsets( m_NodeTypeNameOffsets, m_Header.NumberOfNodeTypes + 1, 
+      m_Header.Columns[FormatType::NodeTypeNamesColumn].Size );
+    m_NodeTypeNames = this->GetColumn( FormatType::NodeTypeNamesColumn, 
+      m_Header.Columns[FormatType::NodeTypeNamesColumn].Size, 1 );
+    
+    this->CheckOffsets( m_ChildOffsets, numberOfNodes + 1, numberOfLinks );
+    this->CheckOffsets( m_ParentOffsets, numberOfNodes + 1, numberOfLinks );
+    this->CheckOffsets( m_SectionOffsets, numberOfNodes + 1, numberOfSections );
+    
+    if( compressed )
+    {
+      m_CompressedSectionOffsets = reinterpret_cast<const vxl_uint_64*>( 
+        this->GetColumn( FormatType::CompressedSectionOffsetsColumn, numberOfNodes + 1, 8 ) );
+      this->CheckOffsets( m_CompressedSectionOffsets, numberOfNodes + 1, 
+        m_Header.Columns[FormatType::CompressedSectionsColumn].Size );
+      m_CompressedSections = reinterpret_cast<const unsigned char*>( this->GetColumn( 
+        FormatType::CompressedSectionsColumn, m_Header.Columns[FormatType::CompressedSectionsColumn].Size, 1 ) );
+    }
+    
+    // Node indices must be valid, so traversals cannot leave the arrays
+    for( vxl_uint_64 i=0; i<numberOfLinks; ++i )
+    {
+      if( m_Children[i] >= numberOfNodes || m_Parents[i] >= numberOfNodes )
+        itkExceptionMacro( "File " << fileName << " has links to missing nodes." );
+    }
+    
+    for( vxl_uint_64 i=0; i<numberOfNodes; ++i )
+    {
+      if( m_NodeTypes[i] >= m_Header.NumberOfNodeTypes )
+        itkExceptionMacro( "File " << fileName << " has nodes of unknown type." );
+    }
+  }
+  catch( ... )
+  {
+    this->Close();
+    throw;
+  }
+  
+  this->Modified();
+}
+
+
+const char * MappedVesselGraph::GetColumn( unsigned int column, vxl_uint_64 numberOfElements, 
+  vxl_uint_64 elementSize ) const
+{
+  vxl_uint_64 size;
+  
+  if( !MultiplySizes( numberOfElements, elementSize, size ) )
+    itkExceptionMacro( "File " << m_FileName << " has a wrong column " << column << "." );
+  
+  if( column >= m_Header.NumberOfColumns || size == 0 )
+  {
+    // Required columns must be present
+    if( size != 0 && column < FormatType::CurveMetricsColumn )
+      itkExceptionMacro( "File " << m_FileName << " misses column " << column << "." );
+    return 0;
+  }
+  
+  const VesselGraphBinaryColumn & info = m_Header.Columns[column];
+  
+  if( info.Size != size || info.Offset % FormatType::ColumnAlignment != 0 || 
+    info.Offset > m_DataSize || info.Size > m_DataSize - info.Offset )
+  {
+    itkExceptionMacro( "File " << m_FileName << " has a wrong column " << column << "." );
+  }
+  
+  return m_Data + info.Offset;
+}
+
+
+template <class TOffset>
+void MappedVesselGraph::CheckOffsets( const TOffset * offsets, vxl_uint_64 numberOfOffsets, 
+  vxl_uint_64 size ) const
+{
+  if( !offsets )
+    return;
+    
+  if( offsets[0] != 0 || offsets[numberOfOffsets-1] != size )
+    itkExceptionMacro( "File " << m_FileName << " has wrong offsets." );
+    
+  for( vxl_uint_64 i=1; i<numberOfOffsets; ++i )
+  {
+    if( offsets[i] < offsets[i-1] )
+      itkExceptionMacro( "File " << m_FileName << " has wrong offsets." );
+  }
+}
+
+
+void MappedVesselGraph::Close()
+{
+  if( m_Data )
+  {
+#ifdef _WIN32
+    UnmapViewOfFile( m_Data );
+    CloseHandle( m_MappingHandle );
+    CloseHandle( m_FileHandle );
+#else
+    munmap( const_cast<char*>( m_Data ), m_DataSize );
+#endif
+  }
+  
+  m_Data = 0;
+  m_DataSize = 0;
+  m_FileHandle = 0;
+  m_MappingHandle = 0;
+  
+  m_NodeIds = m_NodeTypes = m_Masks = 0;
+  m_DepthLevels = 0;
+  m_Flags = 0;
+  m_NameOffsets = m_NodeTypeNameOffsets = m_SectionOffsets = 0;
+  m_Names = m_NodeTypeNames = 0;
+  m_ChildOffsets = m_Children = m_ParentOffsets = m_Parents = 0;
+  m_Centers = m_Normals = m_Radii = m_Scales = m_Arclengths = 0;
+  m_CurveMetrics = m_SectionMetrics = 0;
+  m_CompressedSectionOffsets = 0;
+  m_CompressedSections = 0;
+  
+  memset( &m_Header, 0, sizeof(m_Header) );
+}
+
+
+std::string MappedVesselGraph::GetNodeTypeName( unsigned int nodeType ) const
+{
+  return std::string( m_NodeTypeNames + m_NodeTypeNameOffsets[nodeType], 
+    m_NodeTypeNameOffsets[nodeType+1] - m_NodeTypeNameOffsets[nodeType] );
+}
+
+
+double MappedVesselGraph::ComputeBranchLength( NodeIndex node ) const
+{
+  const unsigned int dimension = m_Header.Dimension;
+  
+  const double *centers = m_Centers;
+  vxl_uint_64 first = m_SectionOffsets[node];
+  vxl_uint_64 last = m_SectionOffsets[node+1];
+  
+  std::vector<double> decodedCenters;
+  
+  if( this->HasCompressedSections() )
+  {
+    if( last - first < 2 )
+      return 0.0;
+      
+    CompressedVesselCenterline::Pointer compressedCenterline = CompressedVesselCenterline::New();
+    compressedCenterline->SetBuffer( this->GetCompressedSections( node ), 
+      this->GetCompressedSectionsSize( node ) );
+    
+    const unsigned int numberOfSections = compressedCenterline->GetNumberOfSections();
+    
+    if( compressedCenterline->GetDimension() != dimension || numberOfSections != last - first )
+      itkExceptionMacro( "File " << m_FileName << " has wrong compressed sections." );
+      
+    decodedCenters.resize( static_cast<size_t>( numberOfSections ) * dimension );
+    std::vector<double> normals( decodedCenters.size() ), scalars( 3 * numberOfSections );
+    compressedCenterline->Decode( &decodedCenters[0], &normals[0], &scalars[0], 
+      &scalars[numberOfSections], &scalars[2*numberOfSections] );
+      
+    centers = &decodedCenters[0];
+    last -= first;
+    first = 0;
+  }
+  
+  double length = 0.0;
+  
+  for( vxl_uint_64 s = first + 1; s < last; ++s )
+  {
+    double squaredDistance = 0.0;
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      const double delta = centers[ s * dimension + d ] - centers[ ( s - 1 ) * dimension + d ];
+      squaredDistance += delta * delta;
+    }
+    length += std::sqrt( squaredDistance );
+  }
+    
+  return length;
+}
+
+
+void MappedVesselGraph::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Version: " << m_Header.MajorVersion << "." << m_Header.MinorVersion << std::endl;
+  os << indent << "Dimension: " << m_Header.Dimension << std::endl;
+  os << indent << "NumberOfNodes: " << m_Header.NumberOfNodes << std::endl;
+  os << indent << "NumberOfLinks: " << m_Header.NumberOfLinks << std::endl;
+  os << indent << "TotalNumberOfSections: " << m_Header.NumberOfSections << std::endl;
+  os << indent << "NumberOfNodeTypes: " << m_Header.NumberOfNodeTypes << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,240 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedVesselGraph.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: read-only view of a memory mapped binary vessel graph file.
+// Date: 2012/11/05
+
+
+#ifndef __ivanMappedVesselGraph_h
+#define __ivanMappedVesselGraph_h
+
+#include "ivanVesselGraphBinaryFormat.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class MappedVesselGraph
+ *  \brief Read-only view of a binary vessel graph file mapped in memory.
+ *
+ * MappedVesselGraph maps a file written by VesselGraphBinaryWriter and accesses its columns 
+ * in place, without copying or creating any object, so opening a graph only costs the mapping 
+ * and the validation of the header. The pages of the file are read by the system as they are 
+ * accessed. The accessors follow those of FrozenVesselGraph: nodes are referenced by their 
+ * index in depth-first preorder, children and parents are in compressed sparse row form, and 
+ * the sections of all the branches are in single arrays indexed through GetSectionOffset().
+ *
+ * The pointers returned are valid until Close() is called or the object is destroyed. Open()
+ * throws an exception if the file cannot be mapped or is not a valid graph file, including 
+ * files written with another byte order.
+ *
+ * VesselGraphBinaryReader builds a VesselGraph from the view.
+ *
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT MappedVesselGraph : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedVesselGraph               Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef VesselGraphBinaryFormat         FormatType;
+  typedef VesselGraphBinaryHeader         HeaderType;
+  
+  /** Index of a node in the arrays. */
+  typedef unsigned int                    NodeIndex;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MappedVesselGraph, itk::Object );
+  
+  /** Map the file and check its header. */
+  void Open( const std::string & fileName );
+  
+  /** Unmap the file. */
+  void Close();
+  
+  bool IsOpen() const
+    { return m_Data != 0; }
+    
+  const std::string & GetFileName() const
+    { return m_FileName; }
+    
+  const HeaderType & GetHeader() const
+    { return m_Header; }
+  
+  unsigned int GetDimension() const
+    { return m_Header.Dimension; }
+  
+  unsigned int GetNumberOfNodes() const
+    { return m_Header.NumberOfNodes; }
+  unsigned long GetNumberOfLinks() const
+    { return m_Header.NumberOfLinks; }
+  unsigned long GetTotalNumberOfSections() const
+    { return m_Header.NumberOfSections; }
+    
+  vxl_uint_32 GetNodeId( NodeIndex node ) const
+    { return m_NodeIds[node]; }
+  vxl_uint_32 GetMask( NodeIndex node ) const
+    { return m_Masks[node]; }
+  int GetDepthLevel( NodeIndex node ) const
+    { return m_DepthLevels[node]; }
+  std::string GetName( NodeIndex node ) const
+    { return std::string( m_Names + m_NameOffsets[node], m_NameOffsets[node+1] - m_NameOffsets[node] ); }
+  bool IsBranch( NodeIndex node ) const
+    { return ( m_Flags[node] & FormatType::BranchFlag ) != 0; }
+    
+  /** Index of the class of the node in the node type table, and class name. */
+  unsigned int GetNodeType( NodeIndex node ) const
+    { return m_NodeTypes[node]; }
+  unsigned int GetNumberOfNodeTypes() const
+    { return m_Header.NumberOfNodeTypes; }
+  std::string GetNodeTypeName( unsigned int nodeType ) const;
+  
+  unsigned int GetNumberOfChildren( NodeIndex node ) const
+    { return m_ChildOffsets[node+1] - m_ChildOffsets[node]; }
+  NodeIndex GetChild( NodeIndex node, unsigned int pos ) const
+    { return m_Children[ m_ChildOffsets[node] + pos ]; }
+    
+  unsigned int GetNumberOfParents( NodeIndex node ) const
+    { return m_ParentOffsets[node+1] - m_ParentOffsets[node]; }
+  NodeIndex GetParent( NodeIndex node, unsigned int pos ) const
+    { return m_Parents[ m_ParentOffsets[node] + pos ]; }
+    
+  /** Sections of the branches. Other nodes have no sections. */
+  unsigned int GetNumberOfSections( NodeIndex node ) const
+    { return m_SectionOffsets[node+1] - m_SectionOffsets[node]; }
+  unsigned long GetSectionOffset( NodeIndex node ) const
+    { return m_SectionOffsets[node]; }
+    
+  /** Section columns, indexed by section. Centers and normals have Dimension values per 
+    * section, and metrics the number of bytes given in the header, or NULL if the file has 
+    * no metrics. */
+  const double * GetCenters() const
+    { return m_Centers; }
+  const double * GetNormals() const
+    { return m_Normals; }
+  const double * GetRadii() const
+    { return m_Radii; }
+  const double * GetScales() const
+    { return m_Scales; }
+  const double * GetArclengths() const
+    { return m_Arclengths; }
+  const char * GetCurveMetrics() const
+    { return m_CurveMetrics; }
+  const char * GetSectionMetrics() const
+    { return m_SectionMetrics; }
+    
+  /** Whether the sections are stored compressed. The center, normal, radius, scale and 
+    * arclength columns are then NULL, and the sections of each branch are decoded from its 
+    * CompressedVesselCenterline buffer. */
+  bool HasCompressedSections() const
+    { return m_CompressedSectionOffsets != 0; }
+  const unsigned char * GetCompressedSections( NodeIndex node ) const
+    { return m_CompressedSections + m_CompressedSectionOffsets[node]; }
+  unsigned long GetCompressedSectionsSize( NodeIndex node ) const
+    { return m_CompressedSectionOffsets[node+1] - m_CompressedSectionOffsets[node]; }
+    
+  /** Length of the polyline joining the section centers of a branch. Compressed sections are
+    * decoded first. */
+  double ComputeBranchLength( NodeIndex node ) const;
+		
+protected:
+
+  MappedVesselGraph();
+  ~MappedVesselGraph();
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Get a column checking that it holds the given number of elements of the given size. 
+    * Returns NULL for empty or missing columns. */
+  const char * GetColumn( unsigned int column, vxl_uint_64 numberOfElements, 
+    vxl_uint_64 elementSize ) const;
+    
+  /** Check that an offsets column is non-decreasing and ends at the given size. */
+  template <class TOffset>
+  void CheckOffsets( const TOffset * offsets, vxl_uint_64 numberOfOffsets, vxl_uint_64 size ) const;
+
+private:
+
+  MappedVesselGraph(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string           m_FileName;
+  HeaderType            m_Header;
+  
+  /** The mapping, and its handles on Windows. */
+  const char            *m_Data;
+  vxl_uint_64           m_DataSize;
+  void                  *m_FileHandle;
+  void                  *m_MappingHandle;
+  
+  /** Columns in the mapped file. */
+  const vxl_uint_32     *m_NodeIds;
+  const vxl_uint_32     *m_NodeTypes;
+  const vxl_uint_32     *m_Masks;
+  const vxl_int_32      *m_DepthLevels;
+  const vxl_uint_8      *m_Flags;
+  const vxl_uint_64     *m_NameOffsets;
+  const char            *m_Names;
+  const vxl_uint_64     *m_NodeTypeNameOffsets;
+  const char            *m_NodeTypeNames;
+  const vxl_uint_32     *m_ChildOffsets;
+  const vxl_uint_32     *m_Children;
+  const vxl_uint_32     *m_ParentOffsets;
+  const vxl_uint_32     *m_Parents;
+  const vxl_uint_64     *m_SectionOffsets;
+  const double          *m_Centers;
+  const double          *m_Normals;
+  const double          *m_Radii;
+  const double          *m_Scales;
+  const double          *m_Arclengths;
+  const char            *m_CurveMetrics;
+  const char            *m_SectionMetrics;
+  const vxl_uint_64     *m_CompressedSectionOffsets;
+  const unsigned char   *m_CompressedSections;
+};
+
+} // end namespace ivan
+
+#endif
@@ -22,41 +22,66 @@ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
 SUCH DAMAGE.
 
 ==========================================================================*/
-// File: ivanVesselGraphCountNodeVisitor.h
+// File: ivanVesselCenterlineXMLReader.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: reads vessel centerlines from XML files with a stream parser.
+// Date: 2012/11/05
 
-#ifndef __ivanVesselGraphCountNodeVisitor_h
-#define __ivanVesselGraphCountNodeVisitor_h
 
+#ifndef __ivanVesselCenterlineXMLReader_h
+#define __ivanVesselCenterlineXMLReader_h
 
-#include "ivanVesselNodeVisitor.h"
-#include "ivanGraphNodeVisitorDispatcher.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkNumericTraits.h"
+
+#include <map>
+#include <string>
+#include <vector>
 
 
 namespace ivan
 {
   
-/** \class 
- *  \brief 
+/** \class VesselCenterlineXMLReader
+ *  \brief Reads a VesselGraph from an XML file written by VesselCenterlineXMLWriter.
+ *
+ * The file is parsed with a stream (SAX) parser in chunks of BufferSize bytes, and every 
+ * Section element is added to the centerline of its branch as soon as it is parsed, so the 
+ * document is never held in memory, and the memory used besides the graph itself does not 
+ * depend on the size of the file.
  *
- * 
+ * Nodes are created from prototypes registered by class name. VesselNode and the 
+ * VesselBranchNode and VesselBifurcationNode of the centerline type are registered by 
+ * default, and RegisterNodePrototype() adds other classes. Read() throws an exception if the
+ * document is not well formed or does not describe a graph of the section dimension, or has
+ * nodes of an unregistered class. Unknown elements and attributes are ignored.
  *
+ * \sa VesselCenterlineXMLWriter
  * \ingroup 
  */
  
-template <class TNode>
-class ITK_EXPORT GraphCountNodeVisitor : public GraphNodeVisitor
+template <class TCenterline>
+class ITK_EXPORT VesselCenterlineXMLReader : public itk::Object
 {
 public:
 
   /** Standard class typedefs. */
-  typedef GraphCountNodeVisitor     Self;
-  typedef GraphNodeVisitor          Superclass;
-  typedef itk::SmartPointer<Self>        Pointer;
-  typedef itk::SmartPointer<const Self>  ConstPointer;
+  typedef VesselCenterlineXMLReader       Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
   
-  typedef TNode     NodeType;
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef typename VesselGraphType::Pointer     VesselGraphPointer;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
   
 public:
 
@@ -64,39 +89,81 @@ public:
   itkNewMacro( Self );
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro( GraphCountNodeVisitor, GraphNodeVisitor );
-  
-  /** Reset the visitor. Useful to reuse the visitor if it accumulates state during 
-    * a traversal and we plan to reuse it. */
-  virtual void Reset() 
-    { m_Count = 0; }
-    
-  itkGetConstMacro( Count, unsigned int );
-    
-  /** Increment the counter for this node type only. */
-  void Apply( NodeType * node );
+  itkTypeMacro( VesselCenterlineXMLReader, itk::Object );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Number of bytes read from the file and parsed at once. Default is 64 KB. */
+  itkSetClampMacro( BufferSize, unsigned int, 1024, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( BufferSize, unsigned int );
+  
+  /** Register a node used to create the nodes of its class. */
+  void RegisterNodePrototype( const GraphNode * node );
+  
+  /** Read the graph from the file. */
+  void Read();
+  
+  /** Graph read by the last call to Read(). */
+  VesselGraphType * GetOutput()
+    { return m_Output.GetPointer(); }
 	
 protected:
 
-  GraphCountNodeVisitor();
-  ~GraphCountNodeVisitor();
+  VesselCenterlineXMLReader();
+  ~VesselCenterlineXMLReader() {}
   
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Parser callbacks. */
+  static void StartElementCallback( void * reader, const char * name, const char ** attributes );
+  static void EndElementCallback( void * reader, const char * name );
+  
+  void StartElement( const char * name, const char ** attributes );
+  void EndElement( const char * name );
+  
+  void StartNode( const char ** attributes );
+  void StartSection( const char ** attributes );
+  void StartNodeLink( const char ** attributes );
+  
+  /** Get an attribute, or NULL if it is missing. */
+  static const char * GetAttribute( const char ** attributes, const char * name );
+  
+  /** Parse the values of an attribute separated by spaces. Returns the number parsed. */
+  static unsigned int ParseValues( const char * text, double * values, unsigned int numberOfValues );
+  
+  /** Record the first error found by the callbacks, which must not throw. */
+  void SetError( const std::string & message );
 
 private:
 
-  GraphCountNodeVisitor(const Self&); //purposely not implemented
+  VesselCenterlineXMLReader(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
 protected:
 
-  unsigned int m_Count;
+  std::string                                     m_FileName;
+  unsigned int                                    m_BufferSize;
+  VesselGraphPointer                              m_Output;
+  
+  std::map<std::string,GraphNode::ConstPointer>   m_NodePrototypes;
+  
+  /** Parsing state. */
+  std::vector<GraphNode::Pointer>   m_Nodes;
+  std::vector<int>                  m_DepthLevels;
+  std::vector<GraphNode*>           m_OpenNodes;
+  CenterlineType                    *m_Centerline;
+  bool                              m_InsideGraph;
+  std::string                       m_Error;
+  
+  /** Parser being run, to report the line of the errors. */
+  void                              *m_Parser;
 };
 
 } // end namespace ivan
 
 #if ITK_TEMPLATE_TXX
-# include "ivanGraphCountNodeVisitor.hxx"
+# include "ivanVesselCenterlineXMLReader.hxx"
 #endif
 
 #endif
@@ -0,0 +1,408 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineXMLReader.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: reads vessel centerlines from XML files with a stream parser.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselCenterlineXMLReader_hxx
+#define __ivanVesselCenterlineXMLReader_hxx
+
+#include "ivanVesselCenterlineXMLReader.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselNode.h"
+
+#if ITK_VERSION_MAJOR < 4
+ #include "expat.h"
+#else
+ #include "itk_expat.h"
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselCenterlineXMLReader<TCenterline>::VesselCenterlineXMLReader() :
+  m_BufferSize( 1 << 16 ),
+  m_Centerline( 0 ),
+  m_InsideGraph( false ),
+  m_Parser( 0 )
+{
+  VesselNode::Pointer node = VesselNode::New();
+  this->RegisterNodePrototype( node );
+  
+  typename BranchNodeType::Pointer branch = BranchNodeType::New();
+  this->RegisterNodePrototype( branch );
+  
+  typename VesselBifurcationNode<TCenterline>::Pointer bifurcation = 
+    VesselBifurcationNode<TCenterline>::New();
+  this->RegisterNodePrototype( bifurcation );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::RegisterNodePrototype( const GraphNode * node )
+{
+  if( !node )
+    return;
+    
+  m_NodePrototypes[ node->GetNameOfClass() ] = node;
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::Read()
+{
+  std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << "." );
+    
+  m_Output = VesselGraphType::New();
+  m_Nodes.clear();
+  m_DepthLevels.clear();
+  m_OpenNodes.clear();
+  m_Centerline = 0;
+  m_InsideGraph = false;
+  m_Error.clear();
+  
+  XML_Parser parser = XML_ParserCreate( 0 );
+  XML_SetUserData( parser, this );
+  XML_SetElementHandler( parser, &Self::StartElementCallback, &Self::EndElementCallback );
+  m_Parser = parser;
+  
+  std::vector<char> buffer( m_BufferSize );
+  bool done = false;
+  
+  while( !done && m_Error.empty() )
+  {
+    file.read( &buffer[0], buffer.size() );
+    const std::streamsize size = file.gcount();
+    done = size < (std::streamsize)buffer.size();
+    
+    if( !XML_Parse( parser, &buffer[0], (int)size, done ) )
+    {
+      std::ostringstream message;
+      message << XML_ErrorString( XML_GetErrorCode( parser ) ) << " at line " 
+        << XML_GetCurrentLineNumber( parser );
+      this->SetError( message.str() );
+    }
+  }
+  
+  XML_ParserFree( parser );
+  m_Parser = 0;
+  m_OpenNodes.clear();
+  m_Centerline = 0;
+  
+  std::vector<GraphNode::Pointer> nodes;
+  nodes.swap( m_Nodes );
+  
+  if( !m_Error.empty() )
+  {
+    m_Output = VesselGraphType::New();
+    itkExceptionMacro( "Could not read " << m_FileName << ": " << m_Error << "." );
+  }
+  
+  // AddChild() overwrites the depth level, so restore it once all the nodes are linked
+  for( unsigned int n=0; n<nodes.size(); ++n )
+    nodes[n]->SetDepthLevel( m_DepthLevels[n] );
+  
+  if( !nodes.empty() )
+  {
+    VesselNode *root = dynamic_cast<VesselNode*>( nodes[0].GetPointer() );
+    
+    if( !root )
+      itkExceptionMacro( "Root node is not a vessel node." );
+      
+    m_Output->SetRootNode( root );
+  }
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::StartElementCallback( void * reader, const char * name, 
+  const char ** attributes )
+{
+  static_cast<Self*>( reader )->StartElement( name, attributes );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::EndElementCallback( void * reader, const char * name )
+{
+  static_cast<Self*>( reader )->EndElement( name );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::StartElement( const char * name, const char ** attributes )
+{
+  if( !m_Error.empty() )
+    return;
+    
+  if( !strcmp( name, "VesselGraph" ) )
+  {
+    const char *version = GetAttribute( attributes, "version" );
+    const char *dimension = GetAttribute( attributes, "dimension" );
+    
+    if( version && atoi( version ) != 1 )
+      this->SetError( std::string( "unsupported version " ) + version );
+    else if( dimension && (unsigned int)atoi( dimension ) != SectionType::Dimension )
+      this->SetError( std::string( "wrong dimension " ) + dimension );
+    
+    m_InsideGraph = true;
+  }
+  else if( !m_InsideGraph )
+    return;
+  else if( !strcmp( name, "Node" ) )
+    this->StartNode( attributes );
+  else if( !strcmp( name, "NodeLink" ) )
+    this->StartNodeLink( attributes );
+  else if( !strcmp( name, "Centerline" ) )
+  {
+    BranchNodeType *branch = m_OpenNodes.empty() ? 0 : dynamic_cast<BranchNodeType*>( m_OpenNodes.back() );
+    
+    if( branch )
+    {
+      CenterlinePointer centerline = CenterlineType::New();
+      branch->SetCenterline( centerline );
+      m_Centerline = centerline;
+    }
+  }
+  else if( !strcmp( name, "Section" ) )
+    this->StartSection( attributes );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::EndElement( const char * name )
+{
+  if( !m_Error.empty() )
+    return;
+    
+  if( !strcmp( name, "VesselGraph" ) )
+    m_InsideGraph = false;
+  else if( !strcmp( name, "Node" ) && !m_OpenNodes.empty() )
+    m_OpenNodes.pop_back();
+  else if( !strcmp( name, "Centerline" ) )
+    m_Centerline = 0;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::StartNode( const char ** attributes )
+{
+  const char *value = GetAttribute( attributes, "type" );
+  const std::string type = value ? value : "VesselNode";
+  
+  typename std::map<std::string,GraphNode::ConstPointer>::const_iterator it = 
+    m_NodePrototypes.find( type );
+    
+  if( it == m_NodePrototypes.end() )
+  {
+    this->SetError( std::string( "no prototype registered for nodes of class " ) + type );
+    return;
+  }
+  
+  itk::LightObject::Pointer object = it->second->CreateAnother();
+  GraphNode::Pointer node = dynamic_cast<GraphNode*>( object.GetPointer() );
+  
+  if( node.IsNull() )
+  {
+    this->SetError( std::string( "could not create node of class " ) + type );
+    return;
+  }
+  
+  if( ( value = GetAttribute( attributes, "id" ) ) )
+    node->SetNodeId( strtoul( value, 0, 10 ) );
+  if( ( value = GetAttribute( attributes, "mask" ) ) )
+    node->SetMask( strtoul( value, 0, 10 ) );
+  if( ( value = GetAttribute( attributes, "name" ) ) )
+  {
+    std::string name = value;
+    node->SetName( name );
+  }
+  
+  value = GetAttribute( attributes, "depth" );
+  
+  if( !m_OpenNodes.empty() )
+    m_OpenNodes.back()->AddChild( node );
+  else if( !m_Nodes.empty() )
+  {
+    this->SetError( "more than one root node" );
+    return;
+  }
+  
+  m_DepthLevels.push_back( value ? atoi( value ) : node->GetDepthLevel() );
+  m_Nodes.push_back( node );
+  m_OpenNodes.push_back( node );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::StartNodeLink( const char ** attributes )
+{
+  const char *value = GetAttribute( attributes, "index" );
+  const unsigned long index = value ? strtoul( value, 0, 10 ) : m_Nodes.size();
+  
+  if( index >= m_Nodes.size() || m_OpenNodes.empty() )
+  {
+    this->SetError( "wrong node link" );
+    return;
+  }
+  
+  m_OpenNodes.back()->AddChild( m_Nodes[index] );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::StartSection( const char ** attributes )
+{
+  if( !m_Centerline )
+    return;
+    
+  const unsigned int dimension = SectionType::Dimension;
+  
+  typename SectionType::Pointer section = SectionType::New();
+  
+  double values[SectionType::Dimension];
+  const char *value;
+  
+  if( ( value = GetAttribute( attributes, "center" ) ) )
+  {
+    if( ParseValues( value, values, dimension ) != dimension )
+    {
+      this->SetError( "wrong section center" );
+      return;
+    }
+    
+    typename SectionType::PointType center;
+    for( unsigned int d=0; d<dimension; ++d )
+      center[d] = values[d];
+    section->SetCenter( center );
+  }
+  
+  if( ( value = GetAttribute( attributes, "normal" ) ) )
+  {
+    if( ParseValues( value, values, dimension ) != dimension )
+    {
+      this->SetError( "wrong section normal" );
+      return;
+    }
+    
+    typename SectionType::VectorType normal;
+    for( unsigned int d=0; d<dimension; ++d )
+      normal[d] = values[d];
+    section->SetNormal( normal );
+  }
+  
+  if( ( value = GetAttribute( attributes, "radius" ) ) )
+    section->SetRadius( strtod( value, 0 ) );
+  if( ( value = GetAttribute( attributes, "scale" ) ) )
+    section->SetScale( strtod( value, 0 ) );
+  if( ( value = GetAttribute( attributes, "arclength" ) ) )
+    section->SetArclength( strtod( value, 0 ) );
+  
+  m_Centerline->push_back( section );
+}
+
+
+template <class TCenterline>
+const char * VesselCenterlineXMLReader<TCenterline>::GetAttribute( const char ** attributes, 
+  const char * name )
+{
+  for( unsigned int i=0; attributes[i]; i += 2 )
+  {
+    if( !strcmp( attributes[i], name ) )
+      return attributes[i+1];
+  }
+  
+  return 0;
+}
+
+
+template <class TCenterline>
+unsigned int VesselCenterlineXMLReader<TCenterline>::ParseValues( const char * text, double * values, 
+  unsigned int numberOfValues )
+{
+  unsigned int count = 0;
+  
+  while( count < numberOfValues )
+  {
+    char *end;
+    values[count] = strtod( text, &end );
+    
+    if( end == text )
+      break;
+      
+    text = end;
+    ++count;
+  }
+  
+  return count;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::SetError( const std::string & message )
+{
+  if( !m_Error.empty() )
+    return;
+    
+  m_Error = message;
+  
+  if( m_Parser )
+  {
+    std::ostringstream line;
+    line << " at line " << XML_GetCurrentLineNumber( static_cast<XML_Parser>( m_Parser ) );
+    
+    // Errors of the parser itself already give the line
+    if( message.find( " at line " ) == std::string::npos )
+      m_Error += line.str();
+  }
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLReader<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "BufferSize: " << m_BufferSize << std::endl;
+  os << indent << "Output: " << m_Output.GetPointer() << std::endl;
+  os << indent << "NumberOfNodePrototypes: " << m_NodePrototypes.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,161 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineXMLWriter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes vessel centerlines to XML files.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselCenterlineXMLWriter_h
+#define __ivanVesselCenterlineXMLWriter_h
+
+#include "ivanGraphNodeVisitor.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkNumericTraits.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+
+namespace ivan
+{
+  
+/** \class VesselCenterlineXMLWriter
+ *  \brief Writes the centerlines of a VesselGraph to an XML file.
+ *
+ * This visitor writes every node it visits as a Node element, with its identifier, class 
+ * name, mask, depth level and name, and the centerline of branches as a Centerline element 
+ * with one Section element per section. Children are nested in their parent. A node reached 
+ * again through another parent is written as a NodeLink element with the index of the Node 
+ * element written for it, in document order. The section type must provide the accessors of 
+ * CircularVesselSection.
+ *
+ *   <VesselGraph version="1" dimension="3">
+ *     <Node id="1" type="VesselBranchNode" mask="4294967295" depth="0" name="">
+ *       <Centerline>
+ *         <Section center="0 0 0" normal="0 0 1" radius="1" scale="1" arclength="0"/>
+ *       </Centerline>
+ *       <Node ...>
+ *     </Node>
+ *   </VesselGraph>
+ *
+ * The document is formatted in a buffer of BufferSize bytes which is written to the file 
+ * whenever it fills, so the memory used does not depend on the size of the graph. Values are 
+ * written with 17 significant digits, so they are read back exactly. Write() throws an 
+ * exception if the file cannot be written.
+ *
+ * \sa VesselCenterlineXMLReader
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselCenterlineXMLWriter : public GraphNodeVisitor
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselCenterlineXMLWriter       Self;
+  typedef GraphNodeVisitor                Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselCenterlineXMLWriter, GraphNodeVisitor );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Size of the output buffer in bytes. Default is 1 MB. */
+  itkSetClampMacro( BufferSize, unsigned int, 1024, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( BufferSize, unsigned int );
+  
+  /** Write the graph to the file. */
+  void Write( const VesselGraphType * graph );
+  
+  virtual void Reset();
+  
+  /** Write the node, and schedule its children unless it was written before. */
+  virtual void Visit( GraphNode * node );
+  
+  /** Close the element of the node. */
+  virtual void Leave( GraphNode * node );
+	
+protected:
+
+  VesselCenterlineXMLWriter();
+  ~VesselCenterlineXMLWriter() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  void WriteIndent();
+  void WriteValue( double value );
+  void WriteValue( unsigned long value );
+  void WriteEscaped( const std::string & text );
+  
+  /** Write the buffer to the file if it is full, or always if forced. */
+  void Flush( bool force = false );
+
+private:
+
+  VesselCenterlineXMLWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string                     m_FileName;
+  unsigned int                    m_BufferSize;
+  
+  std::ofstream                   m_File;
+  std::string                     m_Buffer;
+  
+  /** Index of the Node element of every written node. */
+  std::map<const GraphNode*,unsigned long>  m_WrittenNodes;
+  
+  /** For each node open in the path, whether it was written as a Node element. */
+  std::vector<bool>               m_OpenElements;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselCenterlineXMLWriter.hxx"
+#endif
+
+#endif
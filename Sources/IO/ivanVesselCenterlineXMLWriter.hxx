@@ -22,49 +22,236 @@ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
 SUCH DAMAGE.
 
 ==========================================================================*/
-// File: ivanGraphCountNodeVisitor.hxx
+// File: ivanVesselCenterlineXMLWriter.hxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description:
+// Description: writes vessel centerlines to XML files.
+// Date: 2012/11/05
 
+#ifndef __ivanVesselCenterlineXMLWriter_hxx
+#define __ivanVesselCenterlineXMLWriter_hxx
 
-#ifndef __ivanGraphCountNodeVisitor_hxx
-#define __ivanGraphCountNodeVisitor_hxx
+#include "ivanVesselCenterlineXMLWriter.h"
+
+#include <cstdio>
 
-#include "ivanGraphCountNodeVisitor.h"
 
 namespace ivan
 {
   
-template <class TNode>
-GraphCountNodeVisitor<TNode>::GraphCountNodeVisitor() :
-  m_Count(0)
+template <class TCenterline>
+VesselCenterlineXMLWriter<TCenterline>::VesselCenterlineXMLWriter() :
+  m_BufferSize( 1 << 20 )
 {
-  this->AddDispatcher<Self,TNode>();
+
 }
 
 
-template <class TNode>
-GraphCountNodeVisitor<TNode>::~GraphCountNodeVisitor()
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::Reset()
 {
+  m_WrittenNodes.clear();
+  m_OpenElements.clear();
+  m_Buffer.clear();
+}
 
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::Write( const VesselGraphType * graph )
+{
+  if( m_FileName.empty() )
+    itkExceptionMacro( "No file name given." );
+    
+  this->Reset();
+  m_Buffer.reserve( m_BufferSize + 1024 );
+  
+  m_File.open( m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  
+  if( !m_File )
+    itkExceptionMacro( "Could not open " << m_FileName << " for writing." );
+    
+  m_Buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<VesselGraph version=\"1\" dimension=\"";
+  this->WriteValue( (unsigned long)SectionType::Dimension );
+  m_Buffer += "\">\n";
+  
+  // The traversal only writes nodes of the graph, so the const cast is safe
+  if( graph && graph->GetRootNode().IsNotNull() )
+    const_cast<VesselNode*>( graph->GetRootNode().GetPointer() )->Accept( this );
+  
+  m_Buffer += "</VesselGraph>\n";
+  
+  this->Flush( true );
+  
+  const bool failed = !m_File;
+  m_File.close();
+  
+  this->Reset();
+  
+  if( failed )
+    itkExceptionMacro( "Could not write " << m_FileName << "." );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::Visit( GraphNode * node )
+{
+  this->WriteIndent();
+  
+  typename std::map<const GraphNode*,unsigned long>::const_iterator it = m_WrittenNodes.find( node );
+  
+  if( it != m_WrittenNodes.end() )
+  {
+    m_Buffer += "<NodeLink index=\"";
+    this->WriteValue( it->second );
+    m_Buffer += "\"/>\n";
+    m_OpenElements.push_back( false );
+    this->Flush();
+    return;
+  }
+  
+  const unsigned long index = m_WrittenNodes.size();
+  m_WrittenNodes[node] = index;
+  
+  m_Buffer += "<Node id=\"";
+  this->WriteValue( (unsigned long)node->GetNodeId() );
+  m_Buffer += "\" type=\"";
+  m_Buffer += node->GetNameOfClass();
+  m_Buffer += "\" mask=\"";
+  this->WriteValue( (unsigned long)node->GetMask() );
+  m_Buffer += "\" depth=\"";
+  this->WriteValue( (double)node->GetDepthLevel() );
+  m_Buffer += "\" name=\"";
+  this->WriteEscaped( node->GetName() );
+  m_Buffer += "\">\n";
+  
+  m_OpenElements.push_back( true );
+  
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+  
+  if( branch && branch->GetCenterline().IsNotNull() )
+  {
+    const CenterlineType *centerline = branch->GetCenterline();
+    
+    m_Buffer.append( 2 * m_OpenElements.size() + 2, ' ' );
+    m_Buffer += "<Centerline>\n";
+    
+    for( unsigned int i=0; i<centerline->size(); ++i )
+    {
+      const SectionType *section = centerline->at(i);
+      
+      m_Buffer.append( 2 * m_OpenElements.size() + 4, ' ' );
+      m_Buffer += "<Section center=\"";
+      for( unsigned int d=0; d<SectionType::Dimension; ++d )
+      {
+        if( d )
+          m_Buffer += ' ';
+        this->WriteValue( section->GetCenter()[d] );
+      }
+      m_Buffer += "\" normal=\"";
+      for( unsigned int d=0; d<SectionType::Dimension; ++d )
+      {
+        if( d )
+          m_Buffer += ' ';
+        this->WriteValue( section->GetNormal()[d] );
+      }
+      m_Buffer += "\" radius=\"";
+      this->WriteValue( section->GetRadius() );
+      m_Buffer += "\" scale=\"";
+      this->WriteValue( section->GetScale() );
+      m_Buffer += "\" arclength=\"";
+      this->WriteValue( section->GetArclength() );
+      m_Buffer += "\"/>\n";
+      
+      this->Flush();
+    }
+    
+    m_Buffer.append( 2 * m_OpenElements.size() + 2, ' ' );
+    m_Buffer += "</Centerline>\n";
+  }
+  
+  this->Flush();
+  
+  this->Traverse( node );
 }
 
 
-template <class TNode>
-void GraphCountNodeVisitor<TNode>::Apply( NodeType * node )
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::Leave( GraphNode * node )
 {
-  ++m_Count;
+  if( m_OpenElements.empty() )
+    return;
+    
+  const bool isNodeElement = m_OpenElements.back();
+  m_OpenElements.pop_back();
   
-  this->Traverse( node ); // continue with traversal
+  if( isNodeElement )
+  {
+    this->WriteIndent();
+    m_Buffer += "</Node>\n";
+    this->Flush();
+  }
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::WriteIndent()
+{
+  m_Buffer.append( 2 * m_OpenElements.size() + 2, ' ' );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::WriteValue( double value )
+{
+  char text[32];
+  sprintf( text, "%.17g", value );
+  m_Buffer += text;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::WriteValue( unsigned long value )
+{
+  char text[32];
+  sprintf( text, "%lu", value );
+  m_Buffer += text;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::WriteEscaped( const std::string & text )
+{
+  for( unsigned int i=0; i<text.size(); ++i )
+  {
+    switch( text[i] )
+    {
+      case '&': m_Buffer += "&amp;"; break;
+      case '<': m_Buffer += "&lt;"; break;
+      case '>': m_Buffer += "&gt;"; break;
+      case '"': m_Buffer += "&quot;"; break;
+      default: m_Buffer += text[i];
+    }
+  }
+}
+
+
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::Flush( bool force )
+{
+  if( m_Buffer.size() < m_BufferSize && !force )
+    return;
+    
+  m_File.write( m_Buffer.data(), m_Buffer.size() );
+  m_Buffer.clear();
 }
 
 
-template <class TNode>
-void GraphCountNodeVisitor<TNode>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+template <class TCenterline>
+void VesselCenterlineXMLWriter<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
-  os << indent << "Count: " << m_Count << std::endl;
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "BufferSize: " << m_BufferSize << std::endl;
 }
 
 } // end namespace ivan
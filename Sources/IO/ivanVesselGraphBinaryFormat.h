@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryFormat.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: layout of the binary vessel graph files.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphBinaryFormat_h
+#define __ivanVesselGraphBinaryFormat_h
+
+#include "vxl_config.h"
+
+
+namespace ivan
+{
+
+/** \class VesselGraphBinaryFormat
+ *  \brief Layout of the binary vessel graph files.
+ *
+ * A file starts with a VesselGraphBinaryHeader followed by a number of columns, each a 
+ * contiguous array of one value per node, link or section. The header stores the byte offset 
+ * and size of every column, and columns start at multiples of 8 bytes, so a memory mapped file 
+ * can be accessed in place (see MappedVesselGraph). Nodes are stored in depth-first preorder, 
+ * with the root at index 0, as in FrozenVesselGraph.
+ *
+ * Values are stored in the byte order of the machine that wrote the file, recorded by the 
+ * byte order mark. Node classes are stored by name in a table, since node type identifiers 
+ * are assigned at run time. Sections store center, normal, radius, scale and arclength. Curve 
+ * and section metrics are stored only for the metrics types that specialize 
+ * VesselSectionMetricsBinaryTraits, with the sizes recorded in the header.
+ *
+ * Since version 1.1, the sections may be stored compressed instead (see 
+ * CompressedVesselCenterline), one buffer per branch located through the compressed section 
+ * offsets. The center, normal, radius, scale and arclength columns are then empty. Metrics 
+ * are not compressed.
+ *
+ * The version is increased when the layout changes. Readers reject files with a different
+ * major version, and ignore columns they do not know from later minor versions.
+ *
+ * \ingroup 
+ */
+ 
+struct VesselGraphBinaryFormat
+{
+  /** Columns of the file. The types are those stored for each element. */
+  enum ColumnType
+  {
+    NodeIdsColumn = 0,          // vxl_uint_32 per node
+    NodeTypesColumn,            // vxl_uint_32 per node, index in the node type table
+    MasksColumn,                // vxl_uint_32 per node
+    DepthLevelsColumn,          // vxl_int_32 per node
+    FlagsColumn,                // vxl_uint_8 per node, see NodeFlags
+    NameOffsetsColumn,          // vxl_uint_64 per node plus one, offsets in NamesColumn
+    NamesColumn,                // characters of the node names, not terminated
+    NodeTypeNameOffsetsColumn,  // vxl_uint_64 per node type plus one
+    NodeTypeNamesColumn,        // characters of the node class names
+    ChildOffsetsColumn,         // vxl_uint_32 per node plus one, offsets in ChildrenColumn
+    ChildrenColumn,             // vxl_uint_32 per link, node index
+    ParentOffsetsColumn,        // vxl_uint_32 per node plus one, offsets in ParentsColumn
+    ParentsColumn,              // vxl_uint_32 per link, node index
+    SectionOffsetsColumn,       // vxl_uint_64 per node plus one, first section of each node
+    CentersColumn,              // double per section and dimension
+    NormalsColumn,              // double per section and dimension
+    RadiiColumn,                // double per section
+    ScalesColumn,               // double per section
+    ArclengthsColumn,           // double per section
+    CurveMetricsColumn,         // CurveMetricsSize bytes per section
+    SectionMetricsColumn,       // SectionMetricsSize bytes per section
+    CompressedSectionOffsetsColumn, // vxl_uint_64 per node plus one, offsets in CompressedSectionsColumn
+    CompressedSectionsColumn,   // CompressedVesselCenterline buffers of the branches
+    NumberOfColumns
+  };
+  
+  enum NodeFlags
+  {
+    BranchFlag = 1              // the node has a centerline
+  };
+  
+  /** "IVANVGB" followed by a zero. */
+  static const char * GetMagic()
+    { return "IVANVGB"; }
+    
+  static const vxl_uint_32 MajorVersion = 1;
+  static const vxl_uint_32 MinorVersion = 1;
+  
+  static const vxl_uint_32 ByteOrderMark = 0x01020304;
+  
+  /** Columns are aligned to this number of bytes. */
+  static const vxl_uint_64 ColumnAlignment = 8;
+};
+
+
+/** Position of a column in the file. */
+struct VesselGraphBinaryColumn
+{
+  vxl_uint_64   Offset;
+  vxl_uint_64   Size;
+};
+
+
+/** Header at the start of the file. All the members have their natural alignment, so the 
+  * struct has no padding. */
+struct VesselGraphBinaryHeader
+{
+  char          Magic[8];
+  vxl_uint_32   MajorVersion;
+  vxl_uint_32   MinorVersion;
+  vxl_uint_32   ByteOrderMark;
+  vxl_uint_32   Dimension;
+  vxl_uint_32   CurveMetricsSize;
+  vxl_uint_32   SectionMetricsSize;
+  vxl_uint_64   NumberOfNodes;
+  vxl_uint_64   NumberOfLinks;
+  vxl_uint_64   NumberOfSections;
+  vxl_uint_64   NumberOfNodeTypes;
+  vxl_uint_64   NumberOfColumns;
+  
+  VesselGraphBinaryColumn  Columns[VesselGraphBinaryFormat::NumberOfColumns];
+};
+
+
+
+/** \class VesselSectionMetricsBinaryTraits
+ *  \brief Serialization of section metrics in binary vessel graph files.
+ *
+ * Metrics structs may have virtual functions, so they are not stored as raw bytes. By default 
+ * no bytes are stored. Specialize this class to store the members of a metrics type.
+ */
+template <class TMetrics>
+struct VesselSectionMetricsBinaryTraits
+{
+  /** Number of bytes stored per section. */
+  static unsigned int GetSize()
+    { return 0; }
+    
+  static void Write( const TMetrics & metrics, char * buffer ) {}
+  static void Read( const char * buffer, TMetrics & metrics ) {}
+};
+
+} // end namespace ivan
+
+#endif
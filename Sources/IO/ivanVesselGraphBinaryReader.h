@@ -0,0 +1,156 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryReader.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: reads vessel graphs in the binary vessel graph format.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphBinaryReader_h
+#define __ivanVesselGraphBinaryReader_h
+
+#include "ivanMappedVesselGraph.h"
+#include "ivanMappedVesselCenterlineLoader.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <map>
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphBinaryReader
+ *  \brief Reads a VesselGraph from a binary vessel graph file.
+ *
+ * The file is mapped with MappedVesselGraph and a new VesselGraph is built from its columns. 
+ * Algorithms that only read the graph can use MappedVesselGraph directly and avoid creating 
+ * the nodes and sections.
+ *
+ * Nodes are created from prototypes registered by class name. VesselNode and the 
+ * VesselBranchNode and VesselBifurcationNode of the centerline type are registered by 
+ * default, and RegisterNodePrototype() adds other classes. Read() throws an exception if the 
+ * file has nodes of an unregistered class, or its dimension is not that of the sections. 
+ * Metrics are read if their size matches that of VesselSectionMetricsBinaryTraits, and are 
+ * left with their default values otherwise.
+ *
+ * With LazyCenterlines on, the branches are given a MappedVesselCenterlineLoader instead of 
+ * their centerlines, so opening a graph only creates the nodes, and the centerlines are read 
+ * from the file when accessed. At most MaximumNumberOfResidentCenterlines are then kept in 
+ * memory by const access (see VesselCenterlineLoader). The file stays mapped while any of the 
+ * branches exists.
+ *
+ * \sa VesselGraphBinaryWriter
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselGraphBinaryReader : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphBinaryReader         Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef typename VesselGraphType::Pointer     VesselGraphPointer;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  
+  typedef VesselGraphBinaryFormat               FormatType;
+  
+  typedef MappedVesselCenterlineLoader<TCenterline>   CenterlineLoaderType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphBinaryReader, itk::Object );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Load the centerlines on demand. Default is off. */
+  itkSetMacro( LazyCenterlines, bool );
+  itkGetConstMacro( LazyCenterlines, bool );
+  itkBooleanMacro( LazyCenterlines );
+  
+  /** Maximum number of resident centerlines with LazyCenterlines on. Zero means no limit. 
+    * Default is 256. */
+  itkSetMacro( MaximumNumberOfResidentCenterlines, unsigned long );
+  itkGetConstMacro( MaximumNumberOfResidentCenterlines, unsigned long );
+  
+  /** Register a node used to create the nodes of its class. */
+  void RegisterNodePrototype( const GraphNode * node );
+  
+  /** Read the graph from the file. */
+  void Read();
+  
+  /** Graph read by the last call to Read(). */
+  VesselGraphType * GetOutput()
+    { return m_Output.GetPointer(); }
+		
+protected:
+
+  VesselGraphBinaryReader();
+  ~VesselGraphBinaryReader() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  VesselGraphBinaryReader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string                                     m_FileName;
+  bool                                            m_LazyCenterlines;
+  unsigned long                                   m_MaximumNumberOfResidentCenterlines;
+  VesselGraphPointer                              m_Output;
+  
+  std::map<std::string,GraphNode::ConstPointer>   m_NodePrototypes;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphBinaryReader.hxx"
+#endif
+
+#endif
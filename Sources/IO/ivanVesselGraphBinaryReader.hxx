@@ -0,0 +1,171 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryReader.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: reads vessel graphs in the binary vessel graph format.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphBinaryReader_hxx
+#define __ivanVesselGraphBinaryReader_hxx
+
+#include "ivanVesselGraphBinaryReader.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselNode.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraphBinaryReader<TCenterline>::VesselGraphBinaryReader() :
+  m_LazyCenterlines( false ),
+  m_MaximumNumberOfResidentCenterlines( 256 )
+{
+  VesselNode::Pointer node = VesselNode::New();
+  this->RegisterNodePrototype( node );
+  
+  typename BranchNodeType::Pointer branch = BranchNodeType::New();
+  this->RegisterNodePrototype( branch );
+  
+  typename VesselBifurcationNode<TCenterline>::Pointer bifurcation = 
+    VesselBifurcationNode<TCenterline>::New();
+  this->RegisterNodePrototype( bifurcation );
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryReader<TCenterline>::RegisterNodePrototype( const GraphNode * node )
+{
+  if( !node )
+    return;
+    
+  m_NodePrototypes[ node->GetNameOfClass() ] = node;
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryReader<TCenterline>::Read()
+{
+  MappedVesselGraph::Pointer mappedGraph = MappedVesselGraph::New();
+  mappedGraph->Open( m_FileName );
+  
+  m_Output = VesselGraphType::New();
+  
+  const unsigned int numberOfNodes = mappedGraph->GetNumberOfNodes();
+  const unsigned int dimension = SectionType::Dimension;
+  
+  if( !numberOfNodes )
+    return;
+    
+  if( mappedGraph->GetDimension() != dimension )
+    itkExceptionMacro( "File " << m_FileName << " has dimension " << mappedGraph->GetDimension() 
+      << " instead of " << dimension << "." );
+      
+  // Prototypes of the node types of the file
+  std::vector<const GraphNode*> prototypes( mappedGraph->GetNumberOfNodeTypes() );
+  
+  for( unsigned int i=0; i<prototypes.size(); ++i )
+  {
+    const std::string name = mappedGraph->GetNodeTypeName( i );
+    typename std::map<std::string,GraphNode::ConstPointer>::const_iterator it = m_NodePrototypes.find( name );
+    
+    if( it == m_NodePrototypes.end() )
+      itkExceptionMacro( "No prototype registered for nodes of class " << name << "." );
+      
+    prototypes[i] = it->second;
+  }
+  
+  typename CenterlineLoaderType::Pointer loader = CenterlineLoaderType::New();
+  loader->SetMappedGraph( mappedGraph );
+  loader->SetMaximumNumberOfResidentCenterlines( m_MaximumNumberOfResidentCenterlines );
+  
+  std::vector<GraphNode::Pointer> nodes( numberOfNodes );
+  
+  for( unsigned int n=0; n<numberOfNodes; ++n )
+  {
+    itk::LightObject::Pointer object = prototypes[ mappedGraph->GetNodeType( n ) ]->CreateAnother();
+    GraphNode *node = dynamic_cast<GraphNode*>( object.GetPointer() );
+    
+    if( !node )
+      itkExceptionMacro( "Could not create node of class " 
+        << mappedGraph->GetNodeTypeName( mappedGraph->GetNodeType( n ) ) << "." );
+        
+    node->SetNodeId( mappedGraph->GetNodeId( n ) );
+    node->SetMask( mappedGraph->GetMask( n ) );
+    
+    std::string name = mappedGraph->GetName( n );
+    node->SetName( name );
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && mappedGraph->IsBranch( n ) )
+    {
+      if( m_LazyCenterlines )
+        loader->AddBranch( branch, n );
+      else
+        branch->SetCenterline( loader->CreateCenterline( n ) );
+    }
+    
+    nodes[n] = node;
+  }
+  
+  for( unsigned int n=0; n<numberOfNodes; ++n )
+  {
+    for( unsigned int i=0; i<mappedGraph->GetNumberOfChildren( n ); ++i )
+      nodes[n]->AddChild( nodes[ mappedGraph->GetChild( n, i ) ] );
+  }
+  
+  // AddChild() overwrites the depth level, so restore it once all the nodes are linked
+  for( unsigned int n=0; n<numberOfNodes; ++n )
+    nodes[n]->SetDepthLevel( mappedGraph->GetDepthLevel( n ) );
+    
+  VesselNode *root = dynamic_cast<VesselNode*>( nodes[0].GetPointer() );
+  
+  if( !root )
+    itkExceptionMacro( "Root node is not a vessel node." );
+    
+  m_Output->SetRootNode( root );
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryReader<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "LazyCenterlines: " << m_LazyCenterlines << std::endl;
+  os << indent << "MaximumNumberOfResidentCenterlines: " << m_MaximumNumberOfResidentCenterlines 
+    << std::endl;
+  os << indent << "Output: " << m_Output.GetPointer() << std::endl;
+  os << indent << "NumberOfNodePrototypes: " << m_NodePrototypes.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
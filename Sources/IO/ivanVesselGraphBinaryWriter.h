@@ -0,0 +1,160 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryWriter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes vessel graphs in the binary vessel graph format.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphBinaryWriter_h
+#define __ivanVesselGraphBinaryWriter_h
+
+#include "ivanVesselGraphBinaryFormat.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <fstream>
+#include <string>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphBinaryWriter
+ *  \brief Writes a VesselGraph in the binary vessel graph format.
+ *
+ * The graph is frozen (see FrozenVesselGraph) and its arrays are written column by column 
+ * with the layout described in VesselGraphBinaryFormat, so the file can be mapped and read in
+ * place by MappedVesselGraph. The section type must provide the accessors of 
+ * CircularVesselSection. Data of node classes other than that of GraphNode and the 
+ * centerlines of branches is not written.
+ *
+ * With CompressSections on, the sections of every branch are stored as a 
+ * CompressedVesselCenterline, with centers and arclengths quantized to CompressionPrecision.
+ * This makes files several times smaller, for archival or transfer, at the cost of decoding 
+ * the sections when they are read.
+ *
+ * Write() throws an exception if the file cannot be written.
+ *
+ * \sa VesselGraphBinaryReader
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselGraphBinaryWriter : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphBinaryWriter         Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef FrozenVesselGraph<TCenterline>        FrozenVesselGraphType;
+  
+  typedef VesselGraphBinaryFormat               FormatType;
+  typedef VesselGraphBinaryHeader               HeaderType;
+  
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::CurveMetricsType>    CurveMetricsTraitsType;
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::SectionMetricsType>  SectionMetricsTraitsType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphBinaryWriter, itk::Object );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  itkSetConstObjectMacro( Input, VesselGraphType );
+  itkGetConstObjectMacro( Input, VesselGraphType );
+  
+  /** Store the sections compressed. Default is off. */
+  itkSetMacro( CompressSections, bool );
+  itkGetConstMacro( CompressSections, bool );
+  itkBooleanMacro( CompressSections );
+  
+  /** Quantization step of the compressed centers and arclengths. Default is 0.001, a micron 
+    * for graphs in millimetres. */
+  itkSetMacro( CompressionPrecision, double );
+  itkGetConstMacro( CompressionPrecision, double );
+  
+  /** Write the input graph to the file. */
+  void Write();
+		
+protected:
+
+  VesselGraphBinaryWriter();
+  ~VesselGraphBinaryWriter() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Write the padding up to the start of the column, and set its position in the header. */
+  void StartColumn( std::ofstream & file, HeaderType & header, unsigned int column, 
+    vxl_uint_64 size );
+    
+  /** Write the compressed sections of every branch and their offsets. */
+  void WriteCompressedSections( std::ofstream & file, HeaderType & header, 
+    const FrozenVesselGraphType * graph );
+    
+  /** Write the values of a section accessor for all the sections. */
+  template <class TFunctor>
+  void WriteSectionColumn( std::ofstream & file, const FrozenVesselGraphType * graph, 
+    TFunctor functor );
+
+private:
+
+  VesselGraphBinaryWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string                               m_FileName;
+  typename VesselGraphType::ConstPointer    m_Input;
+  bool                                      m_CompressSections;
+  double                                    m_CompressionPrecision;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphBinaryWriter.hxx"
+#endif
+
+#endif
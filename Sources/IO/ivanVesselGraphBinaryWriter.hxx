@@ -0,0 +1,378 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryWriter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes vessel graphs in the binary vessel graph format.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphBinaryWriter_hxx
+#define __ivanVesselGraphBinaryWriter_hxx
+
+#include "ivanVesselGraphBinaryWriter.h"
+#include "ivanCompressedVesselCenterline.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+
+namespace ivan
+{
+
+/** Writes the center, normal or scalars of a section. */
+template <class TSection>
+struct VesselGraphBinaryCenterWriter
+{
+  void operator()( std::ofstream & file, const TSection * section ) const
+    {
+      for( unsigned int d=0; d<TSection::Dimension; ++d )
+      {
+        const double value = section->GetCenter()[d];
+        file.write( reinterpret_cast<const char*>( &value ), sizeof(double) );
+      }
+    }
+};
+
+template <class TSection>
+struct VesselGraphBinaryNormalWriter
+{
+  void operator()( std::ofstream & file, const TSection * section ) const
+    {
+      for( unsigned int d=0; d<TSection::Dimension; ++d )
+      {
+        const double value = section->GetNormal()[d];
+        file.write( reinterpret_cast<const char*>( &value ), sizeof(double) );
+      }
+    }
+};
+
+template <class TSection>
+struct VesselGraphBinaryScalarWriter
+{
+  typedef double (TSection::*GetterType)() const;
+  
+  VesselGraphBinaryScalarWriter( GetterType getter ) : m_Getter( getter ) {}
+  
+  void operator()( std::ofstream & file, const TSection * section ) const
+    {
+      const double value = (section->*m_Getter)();
+      file.write( reinterpret_cast<const char*>( &value ), sizeof(double) );
+    }
+    
+  GetterType m_Getter;
+};
+
+template <class TSection>
+struct VesselGraphBinaryMetricsWriter
+{
+  typedef typename TSection::CurveMetricsType     CurveMetricsType;
+  typedef typename TSection::SectionMetricsType   SectionMetricsType;
+  
+  VesselGraphBinaryMetricsWriter( bool curveMetrics ) : m_CurveMetrics( curveMetrics ) {}
+  
+  void operator()( std::ofstream & file, const TSection * section ) const
+    {
+      std::vector<char> buffer;
+      
+      if( m_CurveMetrics )
+      {
+        buffer.resize( VesselSectionMetricsBinaryTraits<CurveMetricsType>::GetSize() );
+        VesselSectionMetricsBinaryTraits<CurveMetricsType>::Write( section->GetCurveMetrics(), &buffer[0] );
+      }
+      else
+      {
+        buffer.resize( VesselSectionMetricsBinaryTraits<SectionMetricsType>::GetSize() );
+        VesselSectionMetricsBinaryTraits<SectionMetricsType>::Write( section->GetSectionMetrics(), &buffer[0] );
+      }
+      
+      file.write( &buffer[0], buffer.size() );
+    }
+    
+  bool m_CurveMetrics;
+};
+
+
+template <class TCenterline>
+VesselGraphBinaryWriter<TCenterline>::VesselGraphBinaryWriter() :
+  m_CompressSections( false ),
+  m_CompressionPrecision( 0.001 )
+{
+
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryWriter<TCenterline>::Write()
+{
+  if( m_FileName.empty() )
+    itkExceptionMacro( "No file name given." );
+    
+  typename FrozenVesselGraphType::Pointer graph = FrozenVesselGraphType::New();
+  graph->Freeze( m_Input );
+  
+  const vxl_uint_64 numberOfNodes = graph->GetNumberOfNodes();
+  const vxl_uint_64 numberOfSections = graph->GetTotalNumberOfSections();
+  
+  // Table of node classes, in order of appearance
+  std::map<GraphNode::NodeTypeIdentifier,vxl_uint_32> nodeTypes;
+  std::vector<std::string> nodeTypeNames;
+  
+  std::vector<vxl_uint_32> nodeIds( numberOfNodes ), nodeTypeColumn( numberOfNodes ), 
+    masks( numberOfNodes ), childOffsets( numberOfNodes + 1 ), parentOffsets( numberOfNodes + 1 ),
+    children, parents;
+  std::vector<vxl_int_32> depthLevels( numberOfNodes );
+  std::vector<vxl_uint_8> flags( numberOfNodes );
+  std::vector<vxl_uint_64> nameOffsets( numberOfNodes + 1 ), sectionOffsets( numberOfNodes + 1 ),
+    nodeTypeNameOffsets( 1, 0 );
+  std::string names, nodeTypeNamesBlob;
+  
+  childOffsets[0] = parentOffsets[0] = 0;
+  nameOffsets[0] = sectionOffsets[0] = 0;
+  
+  for( unsigned int n=0; n<numberOfNodes; ++n )
+  {
+    const GraphNode::NodeTypeIdentifier nodeTypeId = graph->GetNodeTypeId( n );
+    
+    if( nodeTypes.find( nodeTypeId ) == nodeTypes.end() )
+    {
+      nodeTypes[nodeTypeId] = nodeTypeNames.size();
+      nodeTypeNames.push_back( graph->GetNodePrototype( nodeTypeId )->GetNameOfClass() );
+      nodeTypeNamesBlob += nodeTypeNames.back();
+      nodeTypeNameOffsets.push_back( nodeTypeNamesBlob.size() );
+    }
+    
+    nodeIds[n] = graph->GetNodeId( n );
+    nodeTypeColumn[n] = nodeTypes[nodeTypeId];
+    masks[n] = graph->GetMask( n );
+    depthLevels[n] = graph->GetDepthLevel( n );
+    flags[n] = graph->IsBranch( n ) ? FormatType::BranchFlag : 0;
+    
+    names += graph->GetName( n );
+    nameOffsets[n+1] = names.size();
+    
+    for( unsigned int i=0; i<graph->GetNumberOfChildren( n ); ++i )
+      children.push_back( graph->GetChild( n, i ) );
+    childOffsets[n+1] = children.size();
+      
+    for( unsigned int i=0; i<graph->GetNumberOfParents( n ); ++i )
+      parents.push_back( graph->GetParent( n, i ) );
+    parentOffsets[n+1] = parents.size();
+    
+    sectionOffsets[n+1] = sectionOffsets[n] + graph->GetNumberOfSections( n );
+  }
+  
+  HeaderType header;
+  memset( &header, 0, sizeof(header) );
+  
+  strncpy( header.Magic, FormatType::GetMagic(), sizeof(header.Magic) );
+  header.MajorVersion = FormatType::MajorVersion;
+  header.MinorVersion = FormatType::MinorVersion;
+  header.ByteOrderMark = FormatType::ByteOrderMark;
+  header.Dimension = SectionType::Dimension;
+  header.CurveMetricsSize = CurveMetricsTraitsType::GetSize();
+  header.SectionMetricsSize = SectionMetricsTraitsType::GetSize();
+  header.NumberOfNodes = numberOfNodes;
+  header.NumberOfLinks = children.size();
+  header.NumberOfSections = numberOfSections;
+  header.NumberOfNodeTypes = nodeTypeNames.size();
+  header.NumberOfColumns = FormatType::NumberOfColumns;
+  
+  std::ofstream file( m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << " for writing." );
+    
+  // The header is written again at the end, with the column positions
+  file.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+  
+#define ivanWriteColumnMacro( column, vector ) \
+  this->StartColumn( file, header, FormatType::column, vector.size() * sizeof(vector[0]) ); \
+  if( !vector.empty() ) \
+    file.write( reinterpret_cast<const char*>( &vector[0] ), vector.size() * sizeof(vector[0]) );
+  
+  ivanWriteColumnMacro( NodeIdsColumn, nodeIds );
+  ivanWriteColumnMacro( NodeTypesColumn, nodeTypeColumn );
+  ivanWriteColumnMacro( MasksColumn, masks );
+  ivanWriteColumnMacro( DepthLevelsColumn, depthLevels );
+  ivanWriteColumnMacro( FlagsColumn, flags );
+  ivanWriteColumnMacro( NameOffsetsColumn, nameOffsets );
+  ivanWriteColumnMacro( NamesColumn, names );
+  ivanWriteColumnMacro( NodeTypeNameOffsetsColumn, nodeTypeNameOffsets );
+  ivanWriteColumnMacro( NodeTypeNamesColumn, nodeTypeNamesBlob );
+  ivanWriteColumnMacro( ChildOffsetsColumn, childOffsets );
+  ivanWriteColumnMacro( ChildrenColumn, children );
+  ivanWriteColumnMacro( ParentOffsetsColumn, parentOffsets );
+  ivanWriteColumnMacro( ParentsColumn, parents );
+  ivanWriteColumnMacro( SectionOffsetsColumn, sectionOffsets );
+  
+#undef ivanWriteColumnMacro
+  
+  // Section columns are written directly from the sections
+  typedef VesselGraphBinaryScalarWriter<SectionType>  ScalarWriterType;
+  
+  if( m_CompressSections )
+    this->WriteCompressedSections( file, header, graph );
+  else
+  {
+    this->StartColumn( file, header, FormatType::CentersColumn, 
+      numberOfSections * SectionType::Dimension * sizeof(double) );
+    this->WriteSectionColumn( file, graph, VesselGraphBinaryCenterWriter<SectionType>() );
+  
+    this->StartColumn( file, header, FormatType::NormalsColumn, 
+      numberOfSections * SectionType::Dimension * sizeof(double) );
+    this->WriteSectionColumn( file, graph, VesselGraphBinaryNormalWriter<SectionType>() );
+  
+    this->StartColumn( file, header, FormatType::RadiiColumn, numberOfSections * sizeof(double) );
+    this->WriteSectionColumn( file, graph, ScalarWriterType( &SectionType::GetRadius ) );
+  
+    this->StartColumn( file, header, FormatType::ScalesColumn, numberOfSections * sizeof(double) );
+    this->WriteSectionColumn( file, graph, ScalarWriterType( &SectionType::GetScale ) );
+  
+    this->StartColumn( file, header, FormatType::ArclengthsColumn, numberOfSections * sizeof(double) );
+    this->WriteSectionColumn( file, graph, ScalarWriterType( &SectionType::GetArclength ) );
+  }
+  
+  this->StartColumn( file, header, FormatType::CurveMetricsColumn, 
+    numberOfSections * header.CurveMetricsSize );
+  if( header.CurveMetricsSize )
+    this->WriteSectionColumn( file, graph, VesselGraphBinaryMetricsWriter<SectionType>( true ) );
+    
+  this->StartColumn( file, header, FormatType::SectionMetricsColumn, 
+    numberOfSections * header.SectionMetricsSize );
+  if( header.SectionMetricsSize )
+    this->WriteSectionColumn( file, graph, VesselGraphBinaryMetricsWriter<SectionType>( false ) );
+  
+  file.seekp( 0 );
+  file.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+  
+  if( !file )
+    itkExceptionMacro( "Could not write " << m_FileName << "." );
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryWriter<TCenterline>::StartColumn( std::ofstream & file, HeaderType & header, 
+  unsigned int column, vxl_uint_64 size )
+{
+  static const char padding[FormatType::ColumnAlignment] = { 0 };
+  
+  const vxl_uint_64 position = file.tellp();
+  const vxl_uint_64 paddingSize = ( FormatType::ColumnAlignment - 
+    position % FormatType::ColumnAlignment ) % FormatType::ColumnAlignment;
+    
+  file.write( padding, paddingSize );
+  
+  header.Columns[column].Offset = position + paddingSize;
+  header.Columns[column].Size = size;
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryWriter<TCenterline>::WriteCompressedSections( std::ofstream & file, 
+  HeaderType & header, const FrozenVesselGraphType * graph )
+{
+  const unsigned int dimension = SectionType::Dimension;
+  
+  std::vector<vxl_uint_64> offsets( graph->GetNumberOfNodes() + 1, 0 );
+  std::vector<double> centers, normals, radii, scales, arclengths;
+  
+  CompressedVesselCenterline::Pointer compressedCenterline = CompressedVesselCenterline::New();
+  compressedCenterline->SetPrecision( m_CompressionPrecision );
+  
+  // The buffers are written one at a time, and the size of the column set at the end
+  this->StartColumn( file, header, FormatType::CompressedSectionsColumn, 0 );
+  
+  for( unsigned int n=0; n<graph->GetNumberOfNodes(); ++n )
+  {
+    const unsigned int numberOfSections = graph->GetNumberOfSections( n );
+    
+    offsets[n+1] = offsets[n];
+    
+    if( !numberOfSections )
+      continue;
+    
+    centers.resize( numberOfSections * dimension );
+    normals.resize( numberOfSections * dimension );
+    radii.resize( numberOfSections );
+    scales.resize( numberOfSections );
+    arclengths.resize( numberOfSections );
+    
+    for( unsigned int i=0; i<numberOfSections; ++i )
+    {
+      const SectionType *section = graph->GetSection( n, i );
+      
+      for( unsigned int d=0; d<dimension; ++d )
+      {
+        centers[ i * dimension + d ] = section->GetCenter()[d];
+        normals[ i * dimension + d ] = section->GetNormal()[d];
+      }
+      radii[i] = section->GetRadius();
+      scales[i] = section->GetScale();
+      arclengths[i] = section->GetArclength();
+    }
+    
+    compressedCenterline->Encode( dimension, numberOfSections, &centers[0], &normals[0], 
+      &radii[0], &scales[0], &arclengths[0] );
+      
+    const CompressedVesselCenterline::BufferType & buffer = compressedCenterline->GetBuffer();
+    file.write( reinterpret_cast<const char*>( &buffer[0] ), buffer.size() );
+    offsets[n+1] += buffer.size();
+  }
+  
+  header.Columns[FormatType::CompressedSectionsColumn].Size = offsets.back();
+  
+  this->StartColumn( file, header, FormatType::CompressedSectionOffsetsColumn, 
+    offsets.size() * sizeof(vxl_uint_64) );
+  file.write( reinterpret_cast<const char*>( &offsets[0] ), offsets.size() * sizeof(vxl_uint_64) );
+}
+
+
+template <class TCenterline>
+template <class TFunctor>
+void VesselGraphBinaryWriter<TCenterline>::WriteSectionColumn( std::ofstream & file, 
+  const FrozenVesselGraphType * graph, TFunctor functor )
+{
+  for( unsigned int n=0; n<graph->GetNumberOfNodes(); ++n )
+  {
+    for( unsigned int i=0; i<graph->GetNumberOfSections( n ); ++i )
+      functor( file, graph->GetSection( n, i ) );
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphBinaryWriter<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Input: " << m_Input.GetPointer() << std::endl;
+  os << indent << "CompressSections: " << m_CompressSections << std::endl;
+  os << indent << "CompressionPrecision: " << m_CompressionPrecision << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,208 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarFormat.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: layout of the columnar vessel graph files.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphColumnarFormat_h
+#define __ivanVesselGraphColumnarFormat_h
+
+#include "ivanLocalCurveMetrics.h"
+
+#include "vxl_config.h"
+
+
+namespace ivan
+{
+
+/** \class VesselGraphColumnarFormat
+ *  \brief Layout of the columnar vessel graph files.
+ *
+ * The file stores tables of named, typed columns for analysis tools outside IVAN, much like 
+ * an Arrow IPC stream. It starts with a VesselGraphColumnarHeader followed by the tables. 
+ * Every table has a VesselGraphColumnarTableHeader and its name, then a 
+ * VesselGraphColumnarColumnHeader and the name of every column, and then its rows in batches. 
+ * Every batch starts with its number of rows as a vxl_uint_64, followed by the values of each 
+ * column for the rows of the batch, with the components of a row contiguous. Names are not 
+ * terminated. Headers, batches and the values of each column start at multiples of 8 bytes.
+ *
+ * A table can be read with numpy by reading the headers and then, for every batch and column, 
+ * an array of rows times components values of the column type, so no parsing is needed per 
+ * row. Values are stored in the byte order of the machine that wrote the file, recorded by 
+ * the byte order mark.
+ *
+ * VesselGraphColumnarWriter writes a "branches" table, with a row per branch, and a 
+ * "sections" table, with a row per section ordered by branch as in FrozenVesselGraph. 
+ * Missing identifiers, such as the parent of the root, are stored as NullNodeId.
+ *
+ * The version is increased when the layout changes. Readers reject files with a different 
+ * major version. New columns do not change the version, since they are found by name.
+ *
+ * \ingroup 
+ */
+ 
+struct VesselGraphColumnarFormat
+{
+  /** Types of the column values. */
+  enum ValueType
+  {
+    UInt8Type = 0,
+    Int32Type,
+    UInt32Type,
+    UInt64Type,
+    Float64Type,
+    NumberOfValueTypes
+  };
+  
+  /** "IVANVGC" followed by a zero. */
+  static const char * GetMagic()
+    { return "IVANVGC"; }
+    
+  static const vxl_uint_32 MajorVersion = 1;
+  static const vxl_uint_32 MinorVersion = 0;
+  
+  static const vxl_uint_32 ByteOrderMark = 0x01020304;
+  
+  /** Headers, batches and columns are aligned to this number of bytes. */
+  static const vxl_uint_64 Alignment = 8;
+  
+  /** Identifier stored when there is no node. */
+  static const vxl_uint_32 NullNodeId = 0xFFFFFFFF;
+  
+  /** Size in bytes of a value of the given type, or 0 if the type is unknown. */
+  static unsigned int GetValueSize( vxl_uint_32 valueType )
+    {
+      switch( valueType )
+      {
+        case UInt8Type:   return 1;
+        case Int32Type:   return 4;
+        case UInt32Type:  return 4;
+        case UInt64Type:  return 8;
+        case Float64Type: return 8;
+        default:          return 0;
+      }
+    }
+};
+
+
+/** Header at the start of the file. */
+struct VesselGraphColumnarHeader
+{
+  char          Magic[8];
+  vxl_uint_32   MajorVersion;
+  vxl_uint_32   MinorVersion;
+  vxl_uint_32   ByteOrderMark;
+  vxl_uint_32   NumberOfTables;
+};
+
+
+/** Header at the start of a table, followed by its name. */
+struct VesselGraphColumnarTableHeader
+{
+  vxl_uint_64   NumberOfRows;
+  vxl_uint_64   NumberOfBatches;
+  vxl_uint_32   NumberOfColumns;
+  vxl_uint_32   NameLength;
+};
+
+
+/** Header of a column in the table header, followed by its name. */
+struct VesselGraphColumnarColumnHeader
+{
+  vxl_uint_32   ValueType;
+  vxl_uint_32   NumberOfComponents;
+  vxl_uint_32   NameLength;
+  vxl_uint_32   Reserved;
+};
+
+
+
+/** \class VesselSectionMetricsColumnTraits
+ *  \brief Columns of the section metrics in columnar vessel graph files.
+ *
+ * Every metrics column is stored as doubles. By default a metrics type has no columns. 
+ * Specialize this class to export the members of a metrics type.
+ */
+template <class TMetrics>
+struct VesselSectionMetricsColumnTraits
+{
+  static unsigned int GetNumberOfColumns()
+    { return 0; }
+  
+  static const char * GetColumnName( unsigned int column )
+    { return ""; }
+  static unsigned int GetNumberOfComponents( unsigned int column )
+    { return 0; }
+  
+  /** Write the components of a column for the given metrics. */
+  static void GetValues( const TMetrics & metrics, unsigned int column, double * values ) {}
+};
+
+
+/** Curvature, torsion, and the normal and binormal of the curve. The tangent is the section 
+  * normal, which is already exported. */
+template <unsigned int VDimension>
+struct VesselSectionMetricsColumnTraits< LocalCurveMetrics<VDimension> >
+{
+  typedef LocalCurveMetrics<VDimension>   MetricsType;
+  
+  static unsigned int GetNumberOfColumns()
+    { return 4; }
+  
+  static const char * GetColumnName( unsigned int column )
+    {
+      static const char * names[] = { "Curvature", "Torsion", "CurveNormal", "CurveBinormal" };
+      return names[column];
+    }
+  static unsigned int GetNumberOfComponents( unsigned int column )
+    { return ( column < 2 ) ? 1 : VDimension; }
+  
+  static void GetValues( const MetricsType & metrics, unsigned int column, double * values )
+    {
+      switch( column )
+      {
+        case 0:
+          values[0] = metrics.GetCurvature();
+          break;
+        case 1:
+          values[0] = metrics.GetTorsion();
+          break;
+        case 2:
+          for( unsigned int d=0; d<VDimension; ++d )
+            values[d] = metrics.GetNormal()[d];
+          break;
+        default:
+          for( unsigned int d=0; d<VDimension; ++d )
+            values[d] = metrics.GetBinormal()[d];
+          break;
+      }
+    }
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,186 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarReader.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: reads the tables of columnar vessel graph files.
+// Date: 2012/11/05
+
+#include "ivanVesselGraphColumnarReader.h"
+
+#include <fstream>
+#include <cstring>
+
+
+namespace ivan
+{
+
+namespace
+{
+
+/** Skip the padding up to the next aligned position. */
+void SkipPadding( std::ifstream & file )
+{
+  const vxl_uint_64 position = file.tellg();
+  
+  file.seekg( ( VesselGraphColumnarFormat::Alignment - position % 
+    VesselGraphColumnarFormat::Alignment ) % VesselGraphColumnarFormat::Alignment, std::ios::cur );
+}
+
+} // end anonymous namespace
+
+
+void VesselGraphColumnarReader::Read()
+{
+  m_Tables.clear();
+  
+  std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << " for reading." );
+  
+  VesselGraphColumnarHeader header;
+  file.read( reinterpret_cast<char*>( &header ), sizeof(header) );
+  
+  if( !file || strncmp( header.Magic, FormatType::GetMagic(), sizeof(header.Magic) ) )
+    itkExceptionMacro( m_FileName << " is not a columnar vessel graph file." );
+    
+  if( header.MajorVersion != FormatType::MajorVersion )
+    itkExceptionMacro( "Unsupported version " << header.MajorVersion << "." << header.MinorVersion );
+    
+  if( header.ByteOrderMark != FormatType::ByteOrderMark )
+    itkExceptionMacro( m_FileName << " was written with a different byte order." );
+  
+  m_Tables.resize( header.NumberOfTables );
+  
+  for( unsigned int t=0; t<m_Tables.size(); ++t )
+  {
+    Table & table = m_Tables[t];
+    
+    VesselGraphColumnarTableHeader tableHeader;
+    file.read( reinterpret_cast<char*>( &tableHeader ), sizeof(tableHeader) );
+    
+    table.Name.resize( tableHeader.NameLength );
+    if( tableHeader.NameLength )
+      file.read( &table.Name[0], tableHeader.NameLength );
+    
+    table.NumberOfRows = tableHeader.NumberOfRows;
+    table.Columns.resize( tableHeader.NumberOfColumns );
+    
+    for( unsigned int c=0; c<table.Columns.size(); ++c )
+    {
+      VesselGraphColumnarColumnHeader columnHeader;
+      file.read( reinterpret_cast<char*>( &columnHeader ), sizeof(columnHeader) );
+      
+      if( !file || !FormatType::GetValueSize( columnHeader.ValueType ) )
+        itkExceptionMacro( "Corrupt header of table " << t << " in " << m_FileName );
+      
+      Column & column = table.Columns[c];
+      column.ValueType = columnHeader.ValueType;
+      column.NumberOfComponents = columnHeader.NumberOfComponents;
+      
+      column.Name.resize( columnHeader.NameLength );
+      if( columnHeader.NameLength )
+        file.read( &column.Name[0], columnHeader.NameLength );
+      
+      column.Values.reserve( table.NumberOfRows * column.NumberOfComponents * 
+        FormatType::GetValueSize( column.ValueType ) );
+    }
+    
+    SkipPadding( file );
+    
+    vxl_uint_64 numberOfRows = 0;
+    
+    for( vxl_uint_64 b=0; b<tableHeader.NumberOfBatches; ++b )
+    {
+      vxl_uint_64 batchRows = 0;
+      file.read( reinterpret_cast<char*>( &batchRows ), sizeof(batchRows) );
+      
+      numberOfRows += batchRows;
+      
+      if( !file || numberOfRows > table.NumberOfRows )
+        itkExceptionMacro( "Corrupt batch " << b << " of table " << table.Name << " in " << m_FileName );
+      
+      for( unsigned int c=0; c<table.Columns.size(); ++c )
+      {
+        Column & column = table.Columns[c];
+        
+        const std::size_t size = batchRows * column.NumberOfComponents * 
+          FormatType::GetValueSize( column.ValueType );
+        const std::size_t start = column.Values.size();
+        
+        column.Values.resize( start + size );
+        
+        if( size )
+          file.read( &column.Values[start], size );
+        
+        SkipPadding( file );
+      }
+    }
+    
+    if( !file || numberOfRows != table.NumberOfRows )
+      itkExceptionMacro( "Could not read table " << table.Name << " in " << m_FileName );
+  }
+}
+
+
+int VesselGraphColumnarReader::FindTable( const std::string & name ) const
+{
+  for( unsigned int t=0; t<m_Tables.size(); ++t )
+  {
+    if( m_Tables[t].Name == name )
+      return t;
+  }
+  
+  return -1;
+}
+
+
+int VesselGraphColumnarReader::FindColumn( unsigned int table, const std::string & name ) const
+{
+  for( unsigned int c=0; c<m_Tables[table].Columns.size(); ++c )
+  {
+    if( m_Tables[table].Columns[c].Name == name )
+      return c;
+  }
+  
+  return -1;
+}
+
+
+void VesselGraphColumnarReader::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "NumberOfTables: " << m_Tables.size() << std::endl;
+  
+  for( unsigned int t=0; t<m_Tables.size(); ++t )
+  {
+    os << indent << "Table " << m_Tables[t].Name << ": " << m_Tables[t].NumberOfRows 
+      << " rows, " << m_Tables[t].Columns.size() << " columns" << std::endl;
+  }
+}
+
+} // end namespace ivan
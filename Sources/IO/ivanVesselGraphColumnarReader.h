@@ -0,0 +1,153 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarReader.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: reads the tables of columnar vessel graph files.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphColumnarReader_h
+#define __ivanVesselGraphColumnarReader_h
+
+#include "ivanVesselGraphColumnarFormat.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphColumnarReader
+ *  \brief Reads the tables of a columnar vessel graph file into memory.
+ *
+ * The batches of every column are concatenated, so a column is a contiguous array of rows 
+ * times components values. The tables are not converted back into a graph, they are meant to 
+ * be used directly or to check the output of VesselGraphColumnarWriter.
+ *
+ * Read() throws an exception if the file cannot be read or has a different major version or 
+ * byte order.
+ *
+ * \sa VesselGraphColumnarWriter
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT VesselGraphColumnarReader : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphColumnarReader       Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef VesselGraphColumnarFormat       FormatType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphColumnarReader, itk::Object );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Read all the tables of the file. */
+  void Read();
+  
+  unsigned int GetNumberOfTables() const
+    { return m_Tables.size(); }
+  
+  /** Index of the table with the given name, or -1 if there is none. */
+  int FindTable( const std::string & name ) const;
+  
+  const std::string & GetTableName( unsigned int table ) const
+    { return m_Tables[table].Name; }
+  vxl_uint_64 GetNumberOfRows( unsigned int table ) const
+    { return m_Tables[table].NumberOfRows; }
+  unsigned int GetNumberOfColumns( unsigned int table ) const
+    { return m_Tables[table].Columns.size(); }
+  
+  /** Index of the column of a table with the given name, or -1 if there is none. */
+  int FindColumn( unsigned int table, const std::string & name ) const;
+  
+  const std::string & GetColumnName( unsigned int table, unsigned int column ) const
+    { return m_Tables[table].Columns[column].Name; }
+  vxl_uint_32 GetValueType( unsigned int table, unsigned int column ) const
+    { return m_Tables[table].Columns[column].ValueType; }
+  unsigned int GetNumberOfComponents( unsigned int table, unsigned int column ) const
+    { return m_Tables[table].Columns[column].NumberOfComponents; }
+  
+  /** Values of a column, which must be of the given type. */
+  template <class TValue>
+  const TValue * GetColumnValues( unsigned int table, unsigned int column ) const
+    {
+      const std::vector<char> & values = m_Tables[table].Columns[column].Values;
+      return values.empty() ? 0 : reinterpret_cast<const TValue*>( &values[0] );
+    }
+		
+protected:
+
+  struct Column
+  {
+    std::string         Name;
+    vxl_uint_32         ValueType;
+    vxl_uint_32         NumberOfComponents;
+    std::vector<char>   Values;
+  };
+  
+  struct Table
+  {
+    std::string           Name;
+    vxl_uint_64           NumberOfRows;
+    std::vector<Column>   Columns;
+  };
+
+  VesselGraphColumnarReader() {}
+  ~VesselGraphColumnarReader() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  VesselGraphColumnarReader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string           m_FileName;
+  std::vector<Table>    m_Tables;
+};
+
+} // end namespace ivan
+
+#endif
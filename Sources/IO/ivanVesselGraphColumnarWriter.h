@@ -0,0 +1,181 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarWriter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes vessel graphs as tables of columns.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphColumnarWriter_h
+#define __ivanVesselGraphColumnarWriter_h
+
+#include "ivanVesselGraphColumnarFormat.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkNumericTraits.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphColumnarWriter
+ *  \brief Writes a VesselGraph as branch and section tables for analysis tools.
+ *
+ * The graph is frozen (see FrozenVesselGraph) and written in the layout described in 
+ * VesselGraphColumnarFormat, so it can be loaded as arrays, for instance into numpy or pandas,
+ * instead of being parsed from text output. The section type must provide the accessors of 
+ * CircularVesselSection.
+ *
+ * The "branches" table has the columns NodeId, ParentId (first parent node of any class), 
+ * ParentBranchId (nearest ancestor branch), DepthLevel, Mask, FirstSection (row in the 
+ * sections table), NumberOfSections and Length. The "sections" table has the columns 
+ * BranchId, SectionIndex, Center, Normal, Radius, Scale and Arclength, followed by the 
+ * columns of the curve and section metrics given by VesselSectionMetricsColumnTraits, such 
+ * as those of LocalCurveMetrics.
+ *
+ * Rows are gathered in column buffers and written BatchSize rows at a time, so memory 
+ * does not grow with the size of the graph and every column is written with a single call 
+ * per batch.
+ *
+ * Write() throws an exception if the file cannot be written.
+ *
+ * \sa VesselGraphColumnarReader, VesselGraphBinaryWriter
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselGraphColumnarWriter : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphColumnarWriter       Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef FrozenVesselGraph<TCenterline>        FrozenVesselGraphType;
+  typedef typename FrozenVesselGraphType::NodeIndex  NodeIndex;
+  
+  typedef VesselGraphColumnarFormat             FormatType;
+  
+  typedef VesselSectionMetricsColumnTraits
+    <typename SectionType::CurveMetricsType>    CurveMetricsTraitsType;
+  typedef VesselSectionMetricsColumnTraits
+    <typename SectionType::SectionMetricsType>  SectionMetricsTraitsType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphColumnarWriter, itk::Object );
+  
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  itkSetConstObjectMacro( Input, VesselGraphType );
+  itkGetConstObjectMacro( Input, VesselGraphType );
+  
+  /** Maximum number of rows of a batch. Default is 65536. */
+  itkSetClampMacro( BatchSize, unsigned long, 1, itk::NumericTraits<unsigned long>::max() );
+  itkGetConstMacro( BatchSize, unsigned long );
+  
+  /** Write the input graph to the file. */
+  void Write();
+		
+protected:
+
+  /** Values of a column for the rows of the current batch. */
+  struct Column
+  {
+    Column( const std::string & name, vxl_uint_32 valueType, vxl_uint_32 numberOfComponents ) :
+      Name( name ), ValueType( valueType ), NumberOfComponents( numberOfComponents ) {}
+    
+    template <class TValue>
+    void Append( TValue value )
+      {
+        const char *bytes = reinterpret_cast<const char*>( &value );
+        Buffer.insert( Buffer.end(), bytes, bytes + sizeof(TValue) );
+      }
+    
+    std::string         Name;
+    vxl_uint_32         ValueType;
+    vxl_uint_32         NumberOfComponents;
+    std::vector<char>   Buffer;
+  };
+  
+  typedef std::vector<Column>   ColumnContainerType;
+
+  VesselGraphColumnarWriter();
+  ~VesselGraphColumnarWriter() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  void WriteBranchTable( std::ofstream & file, const FrozenVesselGraphType * graph );
+  void WriteSectionTable( std::ofstream & file, const FrozenVesselGraphType * graph );
+  
+  /** Write the header of a table with the given columns. */
+  void WriteTableHeader( std::ofstream & file, const std::string & name, 
+    const ColumnContainerType & columns, vxl_uint_64 numberOfRows );
+  
+  /** Write the buffered rows of the columns as a batch and clear the buffers. */
+  void WriteBatch( std::ofstream & file, ColumnContainerType & columns, vxl_uint_64 numberOfRows );
+  
+  /** Write zeros up to the next aligned position. */
+  void WritePadding( std::ofstream & file );
+
+private:
+
+  VesselGraphColumnarWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string                               m_FileName;
+  typename VesselGraphType::ConstPointer    m_Input;
+  unsigned long                             m_BatchSize;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphColumnarWriter.hxx"
+#endif
+
+#endif
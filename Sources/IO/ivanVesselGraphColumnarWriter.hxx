@@ -0,0 +1,322 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarWriter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes vessel graphs as tables of columns.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphColumnarWriter_hxx
+#define __ivanVesselGraphColumnarWriter_hxx
+
+#include "ivanVesselGraphColumnarWriter.h"
+
+#include <cstring>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraphColumnarWriter<TCenterline>::VesselGraphColumnarWriter() :
+  m_BatchSize( 65536 )
+{
+
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::Write()
+{
+  if( m_FileName.empty() )
+    itkExceptionMacro( "No file name given." );
+    
+  if( m_Input.IsNull() )
+    itkExceptionMacro( "No input graph given." );
+  
+  typename FrozenVesselGraphType::Pointer graph = FrozenVesselGraphType::New();
+  graph->Freeze( m_Input );
+  
+  std::ofstream file( m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << m_FileName << " for writing." );
+  
+  VesselGraphColumnarHeader header;
+  memset( &header, 0, sizeof(header) );
+  
+  strncpy( header.Magic, FormatType::GetMagic(), sizeof(header.Magic) );
+  header.MajorVersion = FormatType::MajorVersion;
+  header.MinorVersion = FormatType::MinorVersion;
+  header.ByteOrderMark = FormatType::ByteOrderMark;
+  header.NumberOfTables = 2;
+  
+  file.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+  
+  this->WriteBranchTable( file, graph );
+  this->WriteSectionTable( file, graph );
+  
+  if( !file )
+    itkExceptionMacro( "Could not write " << m_FileName << "." );
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::WriteBranchTable( std::ofstream & file, 
+  const FrozenVesselGraphType * graph )
+{
+  enum { NodeId = 0, ParentId, ParentBranchId, DepthLevel, Mask, FirstSection, NumberOfSections,
+    Length };
+  
+  ColumnContainerType columns;
+  columns.push_back( Column( "NodeId", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "ParentId", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "ParentBranchId", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "DepthLevel", FormatType::Int32Type, 1 ) );
+  columns.push_back( Column( "Mask", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "FirstSection", FormatType::UInt64Type, 1 ) );
+  columns.push_back( Column( "NumberOfSections", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "Length", FormatType::Float64Type, 1 ) );
+  
+  vxl_uint_64 numberOfBranches = 0;
+  
+  for( NodeIndex n=0; n<graph->GetNumberOfNodes(); ++n )
+  {
+    if( graph->IsBranch( n ) )
+      ++numberOfBranches;
+  }
+  
+  this->WriteTableHeader( file, "branches", columns, numberOfBranches );
+  
+  vxl_uint_64 rows = 0;
+  
+  for( NodeIndex n=0; n<graph->GetNumberOfNodes(); ++n )
+  {
+    if( !graph->IsBranch( n ) )
+      continue;
+    
+    vxl_uint_32 parentId = FormatType::NullNodeId;
+    vxl_uint_32 parentBranchId = FormatType::NullNodeId;
+    
+    if( graph->GetNumberOfParents( n ) )
+    {
+      NodeIndex parent = graph->GetParent( n, 0 );
+      parentId = graph->GetNodeId( parent );
+      
+      // Follow the first parents up to a branch
+      while( !graph->IsBranch( parent ) && graph->GetNumberOfParents( parent ) )
+        parent = graph->GetParent( parent, 0 );
+      
+      if( graph->IsBranch( parent ) )
+        parentBranchId = graph->GetNodeId( parent );
+    }
+    
+    columns[NodeId].Append( (vxl_uint_32)graph->GetNodeId( n ) );
+    columns[ParentId].Append( parentId );
+    columns[ParentBranchId].Append( parentBranchId );
+    columns[DepthLevel].Append( (vxl_int_32)graph->GetDepthLevel( n ) );
+    columns[Mask].Append( (vxl_uint_32)graph->GetMask( n ) );
+    columns[FirstSection].Append( (vxl_uint_64)graph->GetSectionOffset( n ) );
+    columns[NumberOfSections].Append( (vxl_uint_32)graph->GetNumberOfSections( n ) );
+    columns[Length].Append( graph->ComputeBranchLength( n ) );
+    
+    if( ++rows == m_BatchSize )
+    {
+      this->WriteBatch( file, columns, rows );
+      rows = 0;
+    }
+  }
+  
+  if( rows )
+    this->WriteBatch( file, columns, rows );
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::WriteSectionTable( std::ofstream & file, 
+  const FrozenVesselGraphType * graph )
+{
+  const unsigned int dimension = SectionType::Dimension;
+  
+  enum { BranchId = 0, SectionIndex, Center, Normal, Radius, Scale, Arclength, FirstMetrics };
+  
+  ColumnContainerType columns;
+  columns.push_back( Column( "BranchId", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "SectionIndex", FormatType::UInt32Type, 1 ) );
+  columns.push_back( Column( "Center", FormatType::Float64Type, dimension ) );
+  columns.push_back( Column( "Normal", FormatType::Float64Type, dimension ) );
+  columns.push_back( Column( "Radius", FormatType::Float64Type, 1 ) );
+  columns.push_back( Column( "Scale", FormatType::Float64Type, 1 ) );
+  columns.push_back( Column( "Arclength", FormatType::Float64Type, 1 ) );
+  
+  const unsigned int numberOfCurveMetrics = CurveMetricsTraitsType::GetNumberOfColumns();
+  const unsigned int numberOfSectionMetrics = SectionMetricsTraitsType::GetNumberOfColumns();
+  
+  for( unsigned int c=0; c<numberOfCurveMetrics; ++c )
+  {
+    columns.push_back( Column( CurveMetricsTraitsType::GetColumnName( c ), 
+      FormatType::Float64Type, CurveMetricsTraitsType::GetNumberOfComponents( c ) ) );
+  }
+  
+  for( unsigned int c=0; c<numberOfSectionMetrics; ++c )
+  {
+    columns.push_back( Column( SectionMetricsTraitsType::GetColumnName( c ), 
+      FormatType::Float64Type, SectionMetricsTraitsType::GetNumberOfComponents( c ) ) );
+  }
+  
+  this->WriteTableHeader( file, "sections", columns, graph->GetTotalNumberOfSections() );
+  
+  std::vector<double> values;
+  vxl_uint_64 rows = 0;
+  
+  for( NodeIndex n=0; n<graph->GetNumberOfNodes(); ++n )
+  {
+    const vxl_uint_32 branchId = graph->GetNodeId( n );
+    
+    for( unsigned int i=0; i<graph->GetNumberOfSections( n ); ++i )
+    {
+      const SectionType *section = graph->GetSection( n, i );
+      
+      columns[BranchId].Append( branchId );
+      columns[SectionIndex].Append( (vxl_uint_32)i );
+      
+      for( unsigned int d=0; d<dimension; ++d )
+      {
+        columns[Center].Append( (double)section->GetCenter()[d] );
+        columns[Normal].Append( (double)section->GetNormal()[d] );
+      }
+      
+      columns[Radius].Append( (double)section->GetRadius() );
+      columns[Scale].Append( (double)section->GetScale() );
+      columns[Arclength].Append( (double)section->GetArclength() );
+      
+      unsigned int column = FirstMetrics;
+      
+      for( unsigned int c=0; c<numberOfCurveMetrics; ++c, ++column )
+      {
+        values.resize( columns[column].NumberOfComponents );
+        CurveMetricsTraitsType::GetValues( section->GetCurveMetrics(), c, &values[0] );
+        
+        for( unsigned int k=0; k<values.size(); ++k )
+          columns[column].Append( values[k] );
+      }
+      
+      for( unsigned int c=0; c<numberOfSectionMetrics; ++c, ++column )
+      {
+        values.resize( columns[column].NumberOfComponents );
+        SectionMetricsTraitsType::GetValues( section->GetSectionMetrics(), c, &values[0] );
+        
+        for( unsigned int k=0; k<values.size(); ++k )
+          columns[column].Append( values[k] );
+      }
+      
+      if( ++rows == m_BatchSize )
+      {
+        this->WriteBatch( file, columns, rows );
+        rows = 0;
+      }
+    }
+  }
+  
+  if( rows )
+    this->WriteBatch( file, columns, rows );
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::WriteTableHeader( std::ofstream & file, 
+  const std::string & name, const ColumnContainerType & columns, vxl_uint_64 numberOfRows )
+{
+  VesselGraphColumnarTableHeader tableHeader;
+  memset( &tableHeader, 0, sizeof(tableHeader) );
+  
+  tableHeader.NumberOfRows = numberOfRows;
+  tableHeader.NumberOfBatches = ( numberOfRows + m_BatchSize - 1 ) / m_BatchSize;
+  tableHeader.NumberOfColumns = columns.size();
+  tableHeader.NameLength = name.size();
+  
+  file.write( reinterpret_cast<const char*>( &tableHeader ), sizeof(tableHeader) );
+  file.write( name.data(), name.size() );
+  
+  for( unsigned int c=0; c<columns.size(); ++c )
+  {
+    VesselGraphColumnarColumnHeader columnHeader;
+    memset( &columnHeader, 0, sizeof(columnHeader) );
+    
+    columnHeader.ValueType = columns[c].ValueType;
+    columnHeader.NumberOfComponents = columns[c].NumberOfComponents;
+    columnHeader.NameLength = columns[c].Name.size();
+    
+    file.write( reinterpret_cast<const char*>( &columnHeader ), sizeof(columnHeader) );
+    file.write( columns[c].Name.data(), columns[c].Name.size() );
+  }
+  
+  this->WritePadding( file );
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::WriteBatch( std::ofstream & file, 
+  ColumnContainerType & columns, vxl_uint_64 numberOfRows )
+{
+  file.write( reinterpret_cast<const char*>( &numberOfRows ), sizeof(numberOfRows) );
+  
+  for( unsigned int c=0; c<columns.size(); ++c )
+  {
+    if( !columns[c].Buffer.empty() )
+      file.write( &columns[c].Buffer[0], columns[c].Buffer.size() );
+    
+    this->WritePadding( file );
+    
+    // Keep the capacity for the next batch
+    columns[c].Buffer.clear();
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::WritePadding( std::ofstream & file )
+{
+  static const char padding[FormatType::Alignment] = { 0 };
+  
+  const vxl_uint_64 position = file.tellp();
+  
+  file.write( padding, ( FormatType::Alignment - position % FormatType::Alignment ) % 
+    FormatType::Alignment );
+}
+
+
+template <class TCenterline>
+void VesselGraphColumnarWriter<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "Input: " << m_Input.GetPointer() << std::endl;
+  os << indent << "BatchSize: " << m_BatchSize << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
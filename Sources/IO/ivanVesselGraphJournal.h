@@ -0,0 +1,273 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphJournal.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: append-only journal of the edits of a vessel graph saved in the binary format.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphJournal_h
+#define __ivanVesselGraphJournal_h
+
+#include "ivanVesselGraphJournalFormat.h"
+#include "ivanVesselGraphBinaryFormat.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphJournal
+ *  \brief Saves the edits of a vessel graph incrementally in an append-only journal.
+ *
+ * Saving the whole graph after every edit of an interactive session takes time in proportion
+ * to the graph. Instead, the graph is written once as a snapshot in the binary vessel graph 
+ * format (see VesselGraphBinaryWriter), and each edit is then appended as a record to the 
+ * journal file (see VesselGraphJournalFormat), so a save takes time in proportion to the edit. 
+ * Every CompactionInterval records the journal is compacted: the graph is written as a new 
+ * snapshot and the journal is emptied.
+ *
+ * Create() starts a session with a graph. The edits are applied to the graph by the caller, 
+ * and then recorded with AppendInsertNode(), AppendRemoveNode(), AppendLinkNodes(), 
+ * AppendUnlinkNodes() and AppendUpdateSections(). The records are flushed to the file before 
+ * returning. Recover() reads the snapshot and replays the journal, for instance after a crash,
+ * and continues the session with the recovered graph. A record torn by the crash and anything 
+ * after it is discarded.
+ *
+ * A new snapshot is written to a temporary file and renamed over the previous one before the 
+ * journal is emptied. A journal left by a crash in between holds the checksum of the previous
+ * snapshot, and is discarded on recovery since the new snapshot already has its edits.
+ *
+ * Nodes are identified by GraphNode::GetNodeId(), which must be unique, and are created on
+ * replay from prototypes registered by class name, as in VesselGraphBinaryReader. Removing a 
+ * node unlinks it from its parents and children, and removing the root is not supported.
+ * Methods throw an exception if the files cannot be written or read, or a record refers to a 
+ * node that does not exist.
+ *
+ * \sa VesselGraphBinaryWriter, VesselGraphBinaryReader
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselGraphJournal : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphJournal              Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef typename VesselGraphType::Pointer     VesselGraphPointer;
+  typedef typename VesselGraphType::NodeListType  NodeListType;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  
+  typedef VesselGraphJournalFormat              FormatType;
+  typedef VesselGraphJournalHeader              HeaderType;
+  typedef VesselGraphJournalRecordHeader        RecordHeaderType;
+  
+  typedef GraphNode::NodeIdentifier             NodeIdentifier;
+  
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::CurveMetricsType>    CurveMetricsTraitsType;
+  typedef VesselSectionMetricsBinaryTraits
+    <typename SectionType::SectionMetricsType>  SectionMetricsTraitsType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+  
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphJournal, itk::Object );
+  
+  /** Name of the journal file. */
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+  
+  /** Name of the snapshot file, in the binary vessel graph format. */
+  itkSetStringMacro( SnapshotFileName );
+  itkGetStringMacro( SnapshotFileName );
+  
+  /** Number of records after which the journal is compacted. Zero means never. Default is 1000. */
+  itkSetMacro( CompactionInterval, unsigned long );
+  itkGetConstMacro( CompactionInterval, unsigned long );
+  
+  /** Register a node used to create the nodes of its class on replay. */
+  void RegisterNodePrototype( const GraphNode * node );
+  
+  /** Start a session with the given graph, writing it as the snapshot with an empty journal. */
+  void Create( VesselGraphType * graph );
+  
+  /** Read the snapshot and replay the journal, and continue the session with the graph. */
+  void Recover();
+  
+  /** Graph of the session. */
+  VesselGraphType * GetGraph()
+    { return m_Graph.GetPointer(); }
+    
+  /** Record the insertion of a node with its parents, and its centerline if it is a branch. */
+  void AppendInsertNode( const GraphNode * node );
+  
+  /** Record the removal of a node. */
+  void AppendRemoveNode( NodeIdentifier nodeId );
+  
+  /** Record a link from a parent to a child, at the given position of the children. */
+  void AppendLinkNodes( NodeIdentifier parentId, NodeIdentifier childId, unsigned int position );
+  
+  /** Record the removal of the link from a parent to a child. */
+  void AppendUnlinkNodes( NodeIdentifier parentId, NodeIdentifier childId );
+  
+  /** Record that numberOfRemovedSections sections from first in the centerline of the branch 
+    * were replaced by the numberOfInsertedSections sections from first of its current centerline.
+    * Sections modified in place are recorded with the same number of removed and inserted 
+    * sections. */
+  void AppendUpdateSections( const BranchNodeType * branch, unsigned int first, 
+    unsigned int numberOfRemovedSections, unsigned int numberOfInsertedSections );
+    
+  /** Write the graph as a new snapshot and empty the journal. */
+  void Compact();
+  
+  /** Close the journal file. */
+  void Close();
+  
+  /** Number of records in the journal. */
+  itkGetConstMacro( NumberOfRecords, unsigned long );
+  
+  /** Number of records replayed and bytes discarded by the last call to Recover(). */
+  itkGetConstMacro( NumberOfReplayedRecords, unsigned long );
+  itkGetConstMacro( NumberOfDiscardedBytes, unsigned long );
+  
+  /** Number of compactions since the session was started. */
+  itkGetConstMacro( NumberOfCompactions, unsigned long );
+		
+protected:
+
+  VesselGraphJournal();
+  ~VesselGraphJournal() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Payload of a record. */
+  typedef std::vector<char>   BufferType;
+  
+  template <class T>
+  static void WriteValue( BufferType & buffer, const T & value )
+    {
+      const char *bytes = reinterpret_cast<const char*>( &value );
+      buffer.insert( buffer.end(), bytes, bytes + sizeof(T) );
+    }
+    
+  static void WriteString( BufferType & buffer, const std::string & value );
+  
+  static void WriteSections( BufferType & buffer, const CenterlineType * centerline, 
+    unsigned int first, unsigned int numberOfSections );
+  
+  /** Read a value at the position, which is moved past it. Throws if the payload is too short. */
+  template <class T>
+  void ReadValue( const BufferType & buffer, vxl_uint_64 & position, T & value ) const
+    {
+      if( position + sizeof(T) > buffer.size() )
+        itkExceptionMacro( "Record shorter than its contents in " << m_FileName << "." );
+        
+      memcpy( &value, &buffer[position], sizeof(T) );
+      position += sizeof(T);
+    }
+    
+  void ReadString( const BufferType & buffer, vxl_uint_64 & position, std::string & value ) const;
+  
+  void ReadSections( const BufferType & buffer, vxl_uint_64 & position, 
+    std::vector<typename SectionType::Pointer> & sections ) const;
+    
+  /** Append a record to the journal and compact it if it has CompactionInterval records. */
+  void AppendRecord( vxl_uint_32 type, const BufferType & payload );
+  
+  /** Apply a record to the graph, looking the nodes up in m_Nodes. */
+  void ApplyRecord( vxl_uint_32 type, const BufferType & payload );
+  
+  /** Node of the session with the given identifier. Throws if there is none. */
+  GraphNode * GetNode( NodeIdentifier nodeId ) const;
+  
+  /** Header of a journal for the snapshot with the given checksum. */
+  HeaderType CreateHeader( vxl_uint_64 snapshotChecksum ) const;
+  
+  /** Write the graph to the snapshot file through a temporary file, returning its checksum. */
+  vxl_uint_64 WriteSnapshot();
+  
+  /** Checksum of the contents of a file. */
+  vxl_uint_64 ComputeFileChecksum( const std::string & fileName ) const;
+  
+  /** Write a journal with the given header and records, and keep it open for appending. */
+  void RewriteJournal( const HeaderType & header, const char * records, vxl_uint_64 size );
+
+private:
+
+  VesselGraphJournal(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string                                     m_FileName;
+  std::string                                     m_SnapshotFileName;
+  unsigned long                                   m_CompactionInterval;
+  
+  VesselGraphPointer                              m_Graph;
+  std::ofstream                                   m_File;
+  
+  /** Nodes of the recovered graph by identifier, during replay. */
+  std::map<NodeIdentifier,GraphNode::Pointer>     m_Nodes;
+  
+  std::map<std::string,GraphNode::ConstPointer>   m_NodePrototypes;
+  
+  unsigned long                                   m_NumberOfRecords;
+  unsigned long                                   m_NumberOfReplayedRecords;
+  unsigned long                                   m_NumberOfDiscardedBytes;
+  unsigned long                                   m_NumberOfCompactions;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphJournal.hxx"
+#endif
+
+#endif
@@ -0,0 +1,808 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphJournal.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: append-only journal of the edits of a vessel graph saved in the binary format.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphJournal_hxx
+#define __ivanVesselGraphJournal_hxx
+
+#include "ivanVesselGraphJournal.h"
+#include "ivanVesselGraphBinaryReader.h"
+#include "ivanVesselGraphBinaryWriter.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselNode.h"
+
+#include <cstdio>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraphJournal<TCenterline>::VesselGraphJournal() :
+  m_CompactionInterval( 1000 ),
+  m_NumberOfRecords( 0 ),
+  m_NumberOfReplayedRecords( 0 ),
+  m_NumberOfDiscardedBytes( 0 ),
+  m_NumberOfCompactions( 0 )
+{
+  VesselNode::Pointer node = VesselNode::New();
+  this->RegisterNodePrototype( node );
+  
+  typename BranchNodeType::Pointer branch = BranchNodeType::New();
+  this->RegisterNodePrototype( branch );
+  
+  typename VesselBifurcationNode<TCenterline>::Pointer bifurcation = 
+    VesselBifurcationNode<TCenterline>::New();
+  this->RegisterNodePrototype( bifurcation );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::RegisterNodePrototype( const GraphNode * node )
+{
+  if( !node )
+    return;
+    
+  m_NodePrototypes[ node->GetNameOfClass() ] = node;
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::Create( VesselGraphType * graph )
+{
+  if( !graph )
+    itkExceptionMacro( "No graph to create the journal for." );
+    
+  this->Close();
+  
+  m_Graph = graph;
+  m_NumberOfRecords = 0;
+  m_NumberOfReplayedRecords = 0;
+  m_NumberOfDiscardedBytes = 0;
+  m_NumberOfCompactions = 0;
+  
+  const vxl_uint_64 snapshotChecksum = this->WriteSnapshot();
+  this->RewriteJournal( this->CreateHeader( snapshotChecksum ), 0, 0 );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::Recover()
+{
+  this->Close();
+  
+  m_NumberOfRecords = 0;
+  m_NumberOfReplayedRecords = 0;
+  m_NumberOfDiscardedBytes = 0;
+  m_NumberOfCompactions = 0;
+  
+  typedef VesselGraphBinaryReader<TCenterline> ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( m_SnapshotFileName );
+  
+  typename std::map<std::string,GraphNode::ConstPointer>::const_iterator it;
+  for( it = m_NodePrototypes.begin(); it != m_NodePrototypes.end(); ++it )
+    reader->RegisterNodePrototype( it->second );
+    
+  reader->Read();
+  m_Graph = reader->GetOutput();
+  
+  const HeaderType snapshotHeader = this->CreateHeader( this->ComputeFileChecksum( m_SnapshotFileName ) );
+  
+  // A missing journal has no edits
+  std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+  {
+    this->RewriteJournal( snapshotHeader, 0, 0 );
+    return;
+  }
+  
+  BufferType contents;
+  file.seekg( 0, std::ios::end );
+  contents.resize( static_cast<std::size_t>( file.tellg() ) );
+  file.seekg( 0, std::ios::beg );
+  
+  if( !contents.empty() )
+    file.read( &contents[0], contents.size() );
+    
+  if( !file )
+    itkExceptionMacro( "Could not read " << m_FileName << "." );
+    
+  file.close();
+  
+  HeaderType header;
+  
+  if( contents.size() < sizeof(HeaderType) )
+    itkExceptionMacro( "File " << m_FileName << " is too short to be a vessel graph journal." );
+    
+  memcpy( &header, &contents[0], sizeof(HeaderType) );
+  
+  if( memcmp( header.Magic, FormatType::GetMagic(), sizeof(header.Magic) ) )
+    itkExceptionMacro( "File " << m_FileName << " is not a vessel graph journal." );
+    
+  if( header.ByteOrderMark != FormatType::ByteOrderMark )
+    itkExceptionMacro( "File " << m_FileName << " was written with a different byte order." );
+    
+  if( header.MajorVersion != FormatType::MajorVersion )
+    itkExceptionMacro( "File " << m_FileName << " has major version " << header.MajorVersion 
+      << " instead of " << FormatType::MajorVersion << "." );
+        
+  const char *records = contents.size() > sizeof(HeaderType) ? &contents[ sizeof(HeaderType) ] : 0;
+  const vxl_uint_64 size = contents.size() - sizeof(HeaderType);
+  
+  // The journal of a previous snapshot, left by a crash during compaction
+  if( header.SnapshotChecksum != snapshotHeader.SnapshotChecksum )
+  {
+    m_NumberOfDiscardedBytes = size;
+    this->RewriteJournal( snapshotHeader, 0, 0 );
+    return;
+  }
+  
+  if( header.Dimension != snapshotHeader.Dimension || 
+      header.CurveMetricsSize != snapshotHeader.CurveMetricsSize ||
+      header.SectionMetricsSize != snapshotHeader.SectionMetricsSize )
+    itkExceptionMacro( "File " << m_FileName << " was written for a different section type." );
+    
+  const NodeListType & nodes = m_Graph->GetNodes();
+  
+  for( unsigned int i=0; i<nodes.size(); ++i )
+    m_Nodes[ nodes[i]->GetNodeId() ] = nodes[i];
+    
+  // Replay up to the first torn record
+  vxl_uint_64 position = 0;
+  BufferType payload;
+  
+  while( position + sizeof(RecordHeaderType) <= size )
+  {
+    RecordHeaderType recordHeader;
+    memcpy( &recordHeader, records + position, sizeof(RecordHeaderType) );
+    
+    if( recordHeader.Size > size - position - sizeof(RecordHeaderType) )
+      break;
+      
+    const char *data = records + position + sizeof(RecordHeaderType);
+    
+    if( FormatType::ComputeChecksum( data, recordHeader.Size ) != recordHeader.Checksum )
+      break;
+      
+    payload.assign( data, data + recordHeader.Size );
+    
+    try
+    {
+      this->ApplyRecord( recordHeader.Type, payload );
+    }
+    catch( ... )
+    {
+      m_Nodes.clear();
+      throw;
+    }
+    
+    position += sizeof(RecordHeaderType) + recordHeader.Size;
+    ++m_NumberOfReplayedRecords;
+  }
+  
+  m_Nodes.clear();
+  m_Graph->Modified();
+  m_NumberOfRecords = m_NumberOfReplayedRecords;
+  
+  if( position < size )
+  {
+    m_NumberOfDiscardedBytes = size - position;
+    this->RewriteJournal( header, records, position );
+  }
+  else
+  {
+    m_File.open( m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::app );
+    
+    if( !m_File )
+      itkExceptionMacro( "Could not open " << m_FileName << " for appending." );
+  }
+  
+  if( m_CompactionInterval && m_NumberOfRecords >= m_CompactionInterval )
+    this->Compact();
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendInsertNode( const GraphNode * node )
+{
+  if( !node )
+    itkExceptionMacro( "No node to record." );
+    
+  BufferType payload;
+  WriteValue( payload, static_cast<vxl_uint_32>( node->GetNodeId() ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( node->GetMask() ) );
+  WriteString( payload, node->GetNameOfClass() );
+  WriteString( payload, node->GetName() );
+  
+  WriteValue( payload, static_cast<vxl_uint_32>( node->GetNumberOfParents() ) );
+  
+  for( unsigned int i=0; i<node->GetNumberOfParents(); ++i )
+  {
+    const GraphNode *parent = node->GetParent( i );
+    WriteValue( payload, static_cast<vxl_uint_32>( parent->GetNodeId() ) );
+    WriteValue( payload, static_cast<vxl_uint_32>( parent->GetChildPosition( node ) ) );
+  }
+  
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+  typename CenterlineType::ConstPointer centerline;
+  
+  if( branch )
+    centerline = branch->GetCenterline();
+    
+  const unsigned int numberOfSections = centerline.IsNotNull() ? centerline->size() : 0;
+  
+  WriteValue( payload, static_cast<vxl_uint_32>( numberOfSections ) );
+  WriteSections( payload, centerline, 0, numberOfSections );
+  
+  this->AppendRecord( FormatType::InsertNodeRecord, payload );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendRemoveNode( NodeIdentifier nodeId )
+{
+  BufferType payload;
+  WriteValue( payload, static_cast<vxl_uint_32>( nodeId ) );
+  
+  this->AppendRecord( FormatType::RemoveNodeRecord, payload );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendLinkNodes( NodeIdentifier parentId, NodeIdentifier childId, 
+  unsigned int position )
+{
+  BufferType payload;
+  WriteValue( payload, static_cast<vxl_uint_32>( parentId ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( childId ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( position ) );
+  
+  this->AppendRecord( FormatType::LinkNodesRecord, payload );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendUnlinkNodes( NodeIdentifier parentId, NodeIdentifier childId )
+{
+  BufferType payload;
+  WriteValue( payload, static_cast<vxl_uint_32>( parentId ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( childId ) );
+  
+  this->AppendRecord( FormatType::UnlinkNodesRecord, payload );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendUpdateSections( const BranchNodeType * branch, unsigned int first, 
+  unsigned int numberOfRemovedSections, unsigned int numberOfInsertedSections )
+{
+  if( !branch )
+    itkExceptionMacro( "No branch to record." );
+    
+  typename CenterlineType::ConstPointer centerline = branch->GetCenterline();
+  
+  if( numberOfInsertedSections && 
+      ( centerline.IsNull() || first + numberOfInsertedSections > centerline->size() ) )
+    itkExceptionMacro( "Inserted sections past the end of the centerline of node " 
+      << branch->GetNodeId() << "." );
+      
+  BufferType payload;
+  WriteValue( payload, static_cast<vxl_uint_32>( branch->GetNodeId() ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( first ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( numberOfRemovedSections ) );
+  WriteValue( payload, static_cast<vxl_uint_32>( numberOfInsertedSections ) );
+  WriteSections( payload, centerline, first, numberOfInsertedSections );
+  
+  this->AppendRecord( FormatType::UpdateSectionsRecord, payload );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::Compact()
+{
+  if( m_Graph.IsNull() )
+    itkExceptionMacro( "No graph to compact the journal of." );
+    
+  this->Close();
+  
+  // The journal is emptied only once the new snapshot is in place, so a crash in between 
+  // leaves a journal that does not match the snapshot and is discarded on recovery
+  const vxl_uint_64 snapshotChecksum = this->WriteSnapshot();
+  this->RewriteJournal( this->CreateHeader( snapshotChecksum ), 0, 0 );
+  
+  m_NumberOfRecords = 0;
+  ++m_NumberOfCompactions;
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::Close()
+{
+  if( m_File.is_open() )
+    m_File.close();
+    
+  m_File.clear();
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::WriteString( BufferType & buffer, const std::string & value )
+{
+  WriteValue( buffer, static_cast<vxl_uint_32>( value.size() ) );
+  buffer.insert( buffer.end(), value.begin(), value.end() );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::WriteSections( BufferType & buffer, const CenterlineType * centerline, 
+  unsigned int first, unsigned int numberOfSections )
+{
+  const unsigned int dimension = SectionType::Dimension;
+  std::vector<char> metrics;
+  
+  for( unsigned int s=first; s<first+numberOfSections; ++s )
+  {
+    const SectionType *section = centerline->ElementAt( s );
+    
+    for( unsigned int d=0; d<dimension; ++d )
+      WriteValue( buffer, static_cast<double>( section->GetCenter()[d] ) );
+    for( unsigned int d=0; d<dimension; ++d )
+      WriteValue( buffer, static_cast<double>( section->GetNormal()[d] ) );
+      
+    WriteValue( buffer, static_cast<double>( section->GetRadius() ) );
+    WriteValue( buffer, static_cast<double>( section->GetScale() ) );
+    WriteValue( buffer, static_cast<double>( section->GetArclength() ) );
+    
+    if( CurveMetricsTraitsType::GetSize() )
+    {
+      metrics.resize( CurveMetricsTraitsType::GetSize() );
+      CurveMetricsTraitsType::Write( section->GetCurveMetrics(), &metrics[0] );
+      buffer.insert( buffer.end(), metrics.begin(), metrics.end() );
+    }
+    
+    if( SectionMetricsTraitsType::GetSize() )
+    {
+      metrics.resize( SectionMetricsTraitsType::GetSize() );
+      SectionMetricsTraitsType::Write( section->GetSectionMetrics(), &metrics[0] );
+      buffer.insert( buffer.end(), metrics.begin(), metrics.end() );
+    }
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::ReadString( const BufferType & buffer, vxl_uint_64 & position, 
+  std::string & value ) const
+{
+  vxl_uint_32 length;
+  this->ReadValue( buffer, position, length );
+  
+  if( position + length > buffer.size() )
+    itkExceptionMacro( "Record shorter than its contents in " << m_FileName << "." );
+    
+  value.assign( buffer.begin() + position, buffer.begin() + position + length );
+  position += length;
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::ReadSections( const BufferType & buffer, vxl_uint_64 & position, 
+  std::vector<typename SectionType::Pointer> & sections ) const
+{
+  const unsigned int dimension = SectionType::Dimension;
+  
+  vxl_uint_32 numberOfSections;
+  this->ReadValue( buffer, position, numberOfSections );
+  
+  const vxl_uint_64 sectionSize = ( 2 * dimension + 3 ) * sizeof(double) + 
+    CurveMetricsTraitsType::GetSize() + SectionMetricsTraitsType::GetSize();
+    
+  if( position + numberOfSections * sectionSize > buffer.size() )
+    itkExceptionMacro( "Record shorter than its contents in " << m_FileName << "." );
+    
+  sections.clear();
+  sections.reserve( numberOfSections );
+  
+  for( unsigned int s=0; s<numberOfSections; ++s )
+  {
+    typename SectionType::Pointer section = SectionType::New();
+    
+    typename SectionType::PointType center;
+    typename SectionType::VectorType normal;
+    double value;
+    
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      this->ReadValue( buffer, position, value );
+      center[d] = value;
+    }
+    
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      this->ReadValue( buffer, position, value );
+      normal[d] = value;
+    }
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    
+    this->ReadValue( buffer, position, value );
+    section->SetRadius( value );
+    this->ReadValue( buffer, position, value );
+    section->SetScale( value );
+    this->ReadValue( buffer, position, value );
+    section->SetArclength( value );
+    
+    if( CurveMetricsTraitsType::GetSize() )
+    {
+      CurveMetricsTraitsType::Read( &buffer[position], section->GetCurveMetrics() );
+      position += CurveMetricsTraitsType::GetSize();
+    }
+    
+    if( SectionMetricsTraitsType::GetSize() )
+    {
+      SectionMetricsTraitsType::Read( &buffer[position], section->GetSectionMetrics() );
+      position += SectionMetricsTraitsType::GetSize();
+    }
+    
+    sections.push_back( section );
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::AppendRecord( vxl_uint_32 type, const BufferType & payload )
+{
+  if( !m_File.is_open() )
+    itkExceptionMacro( "Journal " << m_FileName << " is not open." );
+    
+  RecordHeaderType recordHeader;
+  recordHeader.Type = type;
+  recordHeader.Reserved = 0;
+  recordHeader.Size = payload.size();
+  recordHeader.Checksum = FormatType::ComputeChecksum( payload.empty() ? 0 : &payload[0], payload.size() );
+  
+  m_File.write( reinterpret_cast<const char*>( &recordHeader ), sizeof(RecordHeaderType) );
+  
+  if( !payload.empty() )
+    m_File.write( &payload[0], payload.size() );
+    
+  m_File.flush();
+  
+  if( !m_File )
+    itkExceptionMacro( "Could not write to " << m_FileName << "." );
+    
+  ++m_NumberOfRecords;
+  
+  if( m_CompactionInterval && m_NumberOfRecords >= m_CompactionInterval && m_Graph.IsNotNull() )
+    this->Compact();
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::ApplyRecord( vxl_uint_32 type, const BufferType & payload )
+{
+  vxl_uint_64 position = 0;
+  vxl_uint_32 nodeId;
+  
+  switch( type )
+  {
+    case FormatType::InsertNodeRecord:
+    {
+      vxl_uint_32 mask;
+      std::string className;
+      std::string name;
+      
+      this->ReadValue( payload, position, nodeId );
+      this->ReadValue( payload, position, mask );
+      this->ReadString( payload, position, className );
+      this->ReadString( payload, position, name );
+      
+      if( m_Nodes.count( nodeId ) )
+        itkExceptionMacro( "Node " << nodeId << " inserted twice in " << m_FileName << "." );
+        
+      typename std::map<std::string,GraphNode::ConstPointer>::const_iterator it = 
+        m_NodePrototypes.find( className );
+        
+      if( it == m_NodePrototypes.end() )
+        itkExceptionMacro( "No prototype registered for nodes of class " << className << "." );
+        
+      itk::LightObject::Pointer object = it->second->CreateAnother();
+      GraphNode::Pointer node = dynamic_cast<GraphNode*>( object.GetPointer() );
+      
+      if( node.IsNull() )
+        itkExceptionMacro( "Could not create node of class " << className << "." );
+        
+      node->SetNodeId( nodeId );
+      node->SetMask( mask );
+      node->SetName( name );
+      
+      vxl_uint_32 numberOfParents;
+      this->ReadValue( payload, position, numberOfParents );
+      
+      for( unsigned int i=0; i<numberOfParents; ++i )
+      {
+        vxl_uint_32 parentId;
+        vxl_uint_32 childPosition;
+        this->ReadValue( payload, position, parentId );
+        this->ReadValue( payload, position, childPosition );
+        
+        GraphNode *parent = this->GetNode( parentId );
+        
+        if( childPosition < parent->GetNumberOfChildren() )
+          parent->InsertChild( childPosition, node );
+        else
+          parent->AddChild( node );
+      }
+      
+      std::vector<typename SectionType::Pointer> sections;
+      this->ReadSections( payload, position, sections );
+      
+      BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node.GetPointer() );
+      
+      if( branch && !sections.empty() )
+      {
+        CenterlinePointer centerline = CenterlineType::New();
+        centerline->CastToSTLContainer().assign( sections.begin(), sections.end() );
+        branch->SetCenterline( centerline );
+      }
+      
+      if( !numberOfParents && m_Graph->GetRootNode().IsNull() )
+      {
+        VesselNode *root = dynamic_cast<VesselNode*>( node.GetPointer() );
+        
+        if( !root )
+          itkExceptionMacro( "Root node is not a vessel node." );
+          
+        m_Graph->SetRootNode( root );
+      }
+      
+      m_Nodes[ nodeId ] = node;
+      break;
+    }
+    
+    case FormatType::RemoveNodeRecord:
+    {
+      this->ReadValue( payload, position, nodeId );
+      
+      GraphNode::Pointer node = this->GetNode( nodeId );
+      
+      if( node.GetPointer() == m_Graph->GetRootNode().GetPointer() )
+        itkExceptionMacro( "Removal of the root node " << nodeId << " in " << m_FileName << "." );
+        
+      while( node->GetNumberOfParents() )
+      {
+        GraphNode *parent = node->GetParent( 0 );
+        parent->RemoveChild( node.GetPointer() );
+        node->RemoveParent( parent );
+      }
+      
+      for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+        node->GetChild( i )->RemoveParent( node.GetPointer() );
+        
+      node->RemoveAllChildren();
+      m_Nodes.erase( nodeId );
+      break;
+    }
+    
+    case FormatType::LinkNodesRecord:
+    case FormatType::UnlinkNodesRecord:
+    {
+      vxl_uint_32 parentId;
+      this->ReadValue( payload, position, parentId );
+      this->ReadValue( payload, position, nodeId );
+      
+      GraphNode *parent = this->GetNode( parentId );
+      GraphNode *child = this->GetNode( nodeId );
+      
+      if( type == FormatType::UnlinkNodesRecord )
+      {
+        parent->RemoveChild( child );
+        child->RemoveParent( parent );
+        break;
+      }
+      
+      vxl_uint_32 childPosition;
+      this->ReadValue( payload, position, childPosition );
+      
+      if( childPosition < parent->GetNumberOfChildren() )
+        parent->InsertChild( childPosition, child );
+      else
+        parent->AddChild( child );
+      break;
+    }
+    
+    case FormatType::UpdateSectionsRecord:
+    {
+      vxl_uint_32 first;
+      vxl_uint_32 numberOfRemovedSections;
+      
+      this->ReadValue( payload, position, nodeId );
+      this->ReadValue( payload, position, first );
+      this->ReadValue( payload, position, numberOfRemovedSections );
+      
+      std::vector<typename SectionType::Pointer> sections;
+      this->ReadSections( payload, position, sections );
+      
+      BranchNodeType *branch = dynamic_cast<BranchNodeType*>( this->GetNode( nodeId ) );
+      
+      if( !branch )
+        itkExceptionMacro( "Sections updated in node " << nodeId << ", which is not a branch." );
+        
+      if( branch->GetCenterline().IsNull() )
+      {
+        CenterlinePointer centerline = CenterlineType::New();
+        branch->SetCenterline( centerline );
+      }
+      
+      CenterlineType *centerline = branch->GetWritableCenterline();
+      
+      if( first + numberOfRemovedSections > centerline->size() )
+        itkExceptionMacro( "Sections removed past the end of the centerline of node " << nodeId << "." );
+        
+      typename CenterlineType::STLContainerType & container = centerline->CastToSTLContainer();
+      container.erase( container.begin() + first, container.begin() + first + numberOfRemovedSections );
+      container.insert( container.begin() + first, sections.begin(), sections.end() );
+      
+      // Sections after a change of length have moved too
+      centerline->MarkModifiedSections( first, ( sections.size() == numberOfRemovedSections ) ? 
+        first + numberOfRemovedSections : centerline->size() );
+      centerline->Modified();
+      break;
+    }
+    
+    default:
+      itkExceptionMacro( "Unknown record type " << type << " in " << m_FileName << "." );
+  }
+}
+
+
+template <class TCenterline>
+GraphNode * VesselGraphJournal<TCenterline>::GetNode( NodeIdentifier nodeId ) const
+{
+  typename std::map<NodeIdentifier,GraphNode::Pointer>::const_iterator it = m_Nodes.find( nodeId );
+  
+  if( it == m_Nodes.end() )
+    itkExceptionMacro( "Record of unknown node " << nodeId << " in " << m_FileName << "." );
+    
+  return it->second;
+}
+
+
+template <class TCenterline>
+typename VesselGraphJournal<TCenterline>::HeaderType 
+VesselGraphJournal<TCenterline>::CreateHeader( vxl_uint_64 snapshotChecksum ) const
+{
+  HeaderType header;
+  memset( &header, 0, sizeof(HeaderType) );
+  memcpy( header.Magic, FormatType::GetMagic(), sizeof(header.Magic) );
+  
+  header.MajorVersion = FormatType::MajorVersion;
+  header.MinorVersion = FormatType::MinorVersion;
+  header.ByteOrderMark = FormatType::ByteOrderMark;
+  header.Dimension = SectionType::Dimension;
+  header.CurveMetricsSize = CurveMetricsTraitsType::GetSize();
+  header.SectionMetricsSize = SectionMetricsTraitsType::GetSize();
+  header.SnapshotChecksum = snapshotChecksum;
+  
+  return header;
+}
+
+
+template <class TCenterline>
+vxl_uint_64 VesselGraphJournal<TCenterline>::WriteSnapshot()
+{
+  const std::string temporaryFileName = m_SnapshotFileName + ".tmp";
+  
+  typedef VesselGraphBinaryWriter<TCenterline> WriterType;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( temporaryFileName );
+  writer->SetInput( m_Graph );
+  writer->Write();
+  
+  const vxl_uint_64 checksum = this->ComputeFileChecksum( temporaryFileName );
+  
+  // rename() does not replace an existing file on every platform
+  if( std::rename( temporaryFileName.c_str(), m_SnapshotFileName.c_str() ) )
+  {
+    std::remove( m_SnapshotFileName.c_str() );
+    
+    if( std::rename( temporaryFileName.c_str(), m_SnapshotFileName.c_str() ) )
+      itkExceptionMacro( "Could not rename " << temporaryFileName << " to " << m_SnapshotFileName << "." );
+  }
+  
+  return checksum;
+}
+
+
+template <class TCenterline>
+vxl_uint_64 VesselGraphJournal<TCenterline>::ComputeFileChecksum( const std::string & fileName ) const
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << fileName << "." );
+    
+  vxl_uint_64 checksum = FormatType::GetChecksumBasis();
+  std::vector<char> buffer( 1 << 16 );
+  
+  while( file )
+  {
+    file.read( &buffer[0], buffer.size() );
+    checksum = FormatType::ComputeChecksum( &buffer[0], file.gcount(), checksum );
+  }
+  
+  return checksum;
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::RewriteJournal( const HeaderType & header, const char * records, 
+  vxl_uint_64 size )
+{
+  this->Close();
+  
+  m_File.open( m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  
+  if( !m_File )
+    itkExceptionMacro( "Could not open " << m_FileName << " for writing." );
+    
+  m_File.write( reinterpret_cast<const char*>( &header ), sizeof(HeaderType) );
+  
+  if( size )
+    m_File.write( records, size );
+    
+  m_File.flush();
+  
+  if( !m_File )
+    itkExceptionMacro( "Could not write to " << m_FileName << "." );
+}
+
+
+template <class TCenterline>
+void VesselGraphJournal<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "SnapshotFileName: " << m_SnapshotFileName << std::endl;
+  os << indent << "CompactionInterval: " << m_CompactionInterval << std::endl;
+  os << indent << "Graph: " << m_Graph.GetPointer() << std::endl;
+  os << indent << "NumberOfNodePrototypes: " << m_NodePrototypes.size() << std::endl;
+  os << indent << "NumberOfRecords: " << m_NumberOfRecords << std::endl;
+  os << indent << "NumberOfReplayedRecords: " << m_NumberOfReplayedRecords << std::endl;
+  os << indent << "NumberOfDiscardedBytes: " << m_NumberOfDiscardedBytes << std::endl;
+  os << indent << "NumberOfCompactions: " << m_NumberOfCompactions << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,134 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphJournalFormat.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: layout of the edit journals of binary vessel graph files.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphJournalFormat_h
+#define __ivanVesselGraphJournalFormat_h
+
+#include "vxl_config.h"
+
+
+namespace ivan
+{
+
+/** \class VesselGraphJournalFormat
+ *  \brief Layout of the edit journals of binary vessel graph files.
+ *
+ * A journal starts with a VesselGraphJournalHeader followed by records of the edits applied to 
+ * the graph of a snapshot file, in the order they were made. Each record is a 
+ * VesselGraphJournalRecordHeader followed by its payload. The checksum of the payload detects 
+ * a record torn by a crash while it was written, and replay stops there. The header records 
+ * the checksum of the snapshot file the journal applies to, so that the journal of a previous 
+ * snapshot is not replayed on a newer one.
+ *
+ * Payloads store 32 bit integers, and strings and section lists as a 32 bit count followed by
+ * the characters or the sections. Node identifiers are those of GraphNode::GetNodeId(), so 
+ * they must be unique in the graph. Sections store center, normal, radius, scale and 
+ * arclength as doubles, followed by the bytes of VesselSectionMetricsBinaryTraits.
+ *
+ *  - InsertNodeRecord: node id, mask, class name, name, number of parents, parent id and 
+ *    position in its children per parent, and number of sections and the sections.
+ *  - RemoveNodeRecord: node id.
+ *  - LinkNodesRecord: parent id, child id and position in the children of the parent.
+ *  - UnlinkNodesRecord: parent id and child id.
+ *  - UpdateSectionsRecord: node id, first section, number of removed sections, and number of
+ *    inserted sections and the sections.
+ *
+ * As in VesselGraphBinaryFormat, values are stored in the byte order of the machine that 
+ * wrote the journal.
+ *
+ * \ingroup 
+ */
+ 
+struct VesselGraphJournalFormat
+{
+  enum RecordType
+  {
+    InsertNodeRecord = 1,
+    RemoveNodeRecord,
+    LinkNodesRecord,
+    UnlinkNodesRecord,
+    UpdateSectionsRecord
+  };
+  
+  /** "IVANVGJ" followed by a zero. */
+  static const char * GetMagic()
+    { return "IVANVGJ"; }
+    
+  static const vxl_uint_32 MajorVersion = 1;
+  static const vxl_uint_32 MinorVersion = 0;
+  
+  static const vxl_uint_32 ByteOrderMark = 0x01020304;
+  
+  /** 64 bit FNV-1a hash of the bytes, continuing the given hash. */
+  static vxl_uint_64 ComputeChecksum( const char * data, vxl_uint_64 size, 
+    vxl_uint_64 checksum = GetChecksumBasis() )
+    {
+      const vxl_uint_64 prime = ( static_cast<vxl_uint_64>( 0x100 ) << 32 ) | 0x1b3;
+      
+      for( vxl_uint_64 i=0; i<size; ++i )
+      {
+        checksum ^= static_cast<unsigned char>( data[i] );
+        checksum *= prime;
+      }
+      
+      return checksum;
+    }
+    
+  static vxl_uint_64 GetChecksumBasis()
+    { return ( static_cast<vxl_uint_64>( 0xcbf29ce4 ) << 32 ) | 0x84222325; }
+};
+
+
+/** Header at the start of the journal. */
+struct VesselGraphJournalHeader
+{
+  char          Magic[8];
+  vxl_uint_32   MajorVersion;
+  vxl_uint_32   MinorVersion;
+  vxl_uint_32   ByteOrderMark;
+  vxl_uint_32   Dimension;
+  vxl_uint_32   CurveMetricsSize;
+  vxl_uint_32   SectionMetricsSize;
+  vxl_uint_64   SnapshotChecksum;
+};
+
+
+/** Header of each record. */
+struct VesselGraphJournalRecordHeader
+{
+  vxl_uint_32   Type;
+  vxl_uint_32   Reserved;
+  vxl_uint_64   Size;
+  vxl_uint_64   Checksum;
+};
+
+} // end namespace ivan
+
+#endif
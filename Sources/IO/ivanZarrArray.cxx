@@ -0,0 +1,525 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanZarrArray.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: chunked array in the Zarr directory format.
+// Date: 2012/11/05
+
+#include "ivanZarrArray.h"
+
+#include "itk_zlib.h"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cmath>
+#include <limits>
+
+
+namespace ivan
+{
+
+namespace
+{
+
+/** Text of the value of a key in a JSON object, or an empty string if the key is not found. 
+  * Nested objects are not distinguished, but keys of the .zarray metadata are unique. */
+std::string FindJsonValue( const std::string & text, const std::string & key )
+{
+  std::string quotedKey = "\"" + key + "\"";
+  std::string::size_type position = text.find( quotedKey );
+  
+  while( position != std::string::npos )
+  {
+    std::string::size_type colon = text.find_first_not_of( " \t\r\n", position + quotedKey.size() );
+    
+    if( colon != std::string::npos && text[colon] == ':' )
+    {
+      std::string::size_type start = text.find_first_not_of( " \t\r\n", colon + 1 );
+      
+      if( start == std::string::npos )
+        return std::string();
+        
+      std::string::size_type end = start;
+      
+      if( text[start] == '"' )
+      {
+        end = text.find( '"', start + 1 );
+        
+        if( end == std::string::npos )
+          return std::string();
+          
+        return text.substr( start, end - start + 1 );
+      }
+      else if( text[start] == '[' || text[start] == '{' )
+      {
+        char open = text[start];
+        char close = ( open == '[' ) ? ']' : '}';
+        int depth = 0;
+        
+        for( ; end < text.size(); ++end )
+        {
+          if( text[end] == open )
+            ++depth;
+          else if( text[end] == close && --depth == 0 )
+            break;
+        }
+        
+        if( end == text.size() )
+          return std::string();
+          
+        return text.substr( start, end - start + 1 );
+      }
+      
+      end = text.find_first_of( ",}] \t\r\n", start );
+      
+      return text.substr( start, end - start );
+    }
+    
+    position = text.find( quotedKey, position + quotedKey.size() );
+  }
+  
+  return std::string();
+}
+
+
+std::string UnquoteJsonString( const std::string & value )
+{
+  if( value.size() < 2 || value[0] != '"' )
+    return value;
+    
+  return value.substr( 1, value.size() - 2 );
+}
+
+
+/** Parse a JSON array of integers. */
+bool ParseJsonShape( const std::string & value, ZarrArray::ShapeType & shape )
+{
+  shape.clear();
+  
+  if( value.size() < 2 || value[0] != '[' )
+    return false;
+  
+  std::string values = value.substr( 1, value.size() - 2 );
+  std::replace( values.begin(), values.end(), ',', ' ' );
+  
+  std::istringstream stream( values );
+  unsigned long extent;
+  
+  while( stream >> extent )
+    shape.push_back( extent );
+    
+  return !shape.empty() && stream.eof();
+}
+
+
+/** Reverse the bytes of each element of a buffer. */
+void SwapBytes( char * buffer, unsigned long numberOfElements, unsigned int elementSize )
+{
+  for( unsigned long i=0; i < numberOfElements; ++i, buffer += elementSize )
+    std::reverse( buffer, buffer + elementSize );
+}
+
+
+bool IsBigEndianSystem()
+{
+  const unsigned short one = 1;
+  
+  return *reinterpret_cast<const unsigned char*>( &one ) == 0;
+}
+
+} // end anonymous namespace
+
+
+ZarrArray::ZarrArray() :
+  m_ElementSize( 0 ),
+  m_ElementIsInteger( false ),
+  m_ElementIsSigned( false ),
+  m_BigEndian( false ),
+  m_CompressionLevel( 0 ),
+  m_FillValue( 0.0 ),
+  m_DimensionSeparator( '.' )
+{
+}
+
+
+void ZarrArray::Open( const std::string & path )
+{
+  std::string metadataFileName = path + "/.zarray";
+  std::ifstream file( metadataFileName.c_str() );
+  
+  if( !file )
+    itkExceptionMacro( "Could not open " << metadataFileName << "." );
+    
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string text = buffer.str();
+  
+  if( FindJsonValue( text, "zarr_format" ) != "2" )
+    itkExceptionMacro( "Array " << path << " is not a Zarr version 2 array." );
+  
+  ShapeType shape, chunkShape;
+  
+  if( !ParseJsonShape( FindJsonValue( text, "shape" ), shape ) ||
+    !ParseJsonShape( FindJsonValue( text, "chunks" ), chunkShape ) || shape.size() != chunkShape.size() )
+  {
+    itkExceptionMacro( "Array " << path << " has a wrong shape or chunk shape." );
+  }
+  
+  for( unsigned int i=0; i < chunkShape.size(); ++i )
+  {
+    if( chunkShape[i] == 0 )
+      itkExceptionMacro( "Array " << path << " has a wrong chunk shape." );
+  }
+  
+  // Zarr gives the slowest axis first
+  
+  m_Shape.assign( shape.rbegin(), shape.rend() );
+  m_ChunkShape.assign( chunkShape.rbegin(), chunkShape.rend() );
+  
+  std::string dataType = UnquoteJsonString( FindJsonValue( text, "dtype" ) );
+  
+  if( dataType.size() < 3 || ( dataType[0] != '<' && dataType[0] != '>' && dataType[0] != '|' ) )
+    itkExceptionMacro( "Data type " << dataType << " of " << path << " is not supported." );
+    
+  std::istringstream elementSize( dataType.substr( 2 ) );
+  
+  if( !( elementSize >> m_ElementSize ) || ( m_ElementSize != 1 && m_ElementSize != 2 && 
+    m_ElementSize != 4 && m_ElementSize != 8 ) )
+  {
+    itkExceptionMacro( "Data type " << dataType << " of " << path << " is not supported." );
+  }
+  
+  switch( dataType[1] )
+  {
+    case 'i':
+      m_ElementIsInteger = true;
+      m_ElementIsSigned = true;
+      break;
+    case 'u':
+      m_ElementIsInteger = true;
+      m_ElementIsSigned = false;
+      break;
+    case 'f':
+      m_ElementIsInteger = false;
+      m_ElementIsSigned = true;
+      if( m_ElementSize < 4 )
+        itkExceptionMacro( "Data type " << dataType << " of " << path << " is not supported." );
+      break;
+    default:
+      itkExceptionMacro( "Data type " << dataType << " of " << path << " is not supported." );
+  }
+  
+  m_BigEndian = ( dataType[0] == '>' );
+  
+  std::string order = UnquoteJsonString( FindJsonValue( text, "order" ) );
+  
+  if( order != "C" )
+    itkExceptionMacro( "Array " << path << " has order " << order << ", only C order is supported." );
+    
+  std::string filters = FindJsonValue( text, "filters" );
+  
+  if( !filters.empty() && filters != "null" && filters != "[]" )
+    itkExceptionMacro( "Array " << path << " has filters, which are not supported." );
+    
+  std::string compressor = FindJsonValue( text, "compressor" );
+  
+  if( compressor.empty() || compressor == "null" )
+  {
+    m_CompressionLevel = 0;
+  }
+  else
+  {
+    std::string compressorId = UnquoteJsonString( FindJsonValue( compressor, "id" ) );
+    
+    if( compressorId != "zlib" )
+      itkExceptionMacro( "Compressor " << compressorId << " of " << path << " is not supported." );
+      
+    std::istringstream level( FindJsonValue( compressor, "level" ) );
+    
+    if( !( level >> m_CompressionLevel ) || m_CompressionLevel <= 0 )
+      m_CompressionLevel = Z_DEFAULT_COMPRESSION;
+  }
+  
+  std::string fillValue = UnquoteJsonString( FindJsonValue( text, "fill_value" ) );
+  
+  if( fillValue == "NaN" )
+    m_FillValue = std::numeric_limits<double>::quiet_NaN();
+  else if( fillValue == "Infinity" )
+    m_FillValue = std::numeric_limits<double>::infinity();
+  else if( fillValue == "-Infinity" )
+    m_FillValue = -std::numeric_limits<double>::infinity();
+  else
+  {
+    std::istringstream value( fillValue );
+    
+    if( !( value >> m_FillValue ) )
+      m_FillValue = 0.0;
+  }
+  
+  std::string separator = UnquoteJsonString( FindJsonValue( text, "dimension_separator" ) );
+  m_DimensionSeparator = ( separator == "/" ) ? '/' : '.';
+  
+  m_Path = path;
+  
+  this->ComputeNumberOfChunks();
+  this->Modified();
+}
+
+
+void ZarrArray::Create( const std::string & path, const ShapeType & shape, const ShapeType & chunkShape,
+  unsigned int elementSize, bool integer, bool isSigned, int compressionLevel, double fillValue )
+{
+  if( shape.empty() || shape.size() != chunkShape.size() || 
+    std::find( chunkShape.begin(), chunkShape.end(), 0ul ) != chunkShape.end() )
+  {
+    itkExceptionMacro( "Wrong shape or chunk shape." );
+  }
+  
+  if( !itksys::SystemTools::MakeDirectory( path.c_str() ) )
+    itkExceptionMacro( "Could not create directory " << path << "." );
+    
+  m_Path = path;
+  m_Shape = shape;
+  m_ChunkShape = chunkShape;
+  m_ElementSize = elementSize;
+  m_ElementIsInteger = integer;
+  m_ElementIsSigned = isSigned;
+  m_BigEndian = IsBigEndianSystem();
+  m_CompressionLevel = compressionLevel;
+  m_FillValue = fillValue;
+  m_DimensionSeparator = '.';
+  
+  std::ostringstream metadata;
+  
+  metadata << "{\n  \"chunks\": [";
+  
+  for( unsigned int i=chunkShape.size(); i > 0; --i )
+    metadata << chunkShape[i-1] << ( i > 1 ? ", " : "" );
+    
+  metadata << "],\n  \"compressor\": ";
+  
+  if( compressionLevel > 0 )
+    metadata << "{\"id\": \"zlib\", \"level\": " << compressionLevel << "}";
+  else
+    metadata << "null";
+    
+  metadata << ",\n  \"dtype\": \"" << ( elementSize == 1 ? '|' : ( m_BigEndian ? '>' : '<' ) ) << 
+    ( integer ? ( isSigned ? 'i' : 'u' ) : 'f' ) << elementSize << "\",\n";
+  
+  if( fillValue != fillValue )
+    metadata << "  \"fill_value\": \"NaN\",\n";
+  else if( integer )
+    metadata << "  \"fill_value\": " << static_cast<long>( fillValue ) << ",\n";
+  else
+    metadata << "  \"fill_value\": " << fillValue << ",\n";
+    
+  metadata << "  \"filters\": null,\n  \"order\": \"C\",\n  \"shape\": [";
+  
+  for( unsigned int i=shape.size(); i > 0; --i )
+    metadata << shape[i-1] << ( i > 1 ? ", " : "" );
+    
+  metadata << "],\n  \"zarr_format\": 2\n}\n";
+  
+  std::string metadataFileName = path + "/.zarray";
+  std::ofstream file( metadataFileName.c_str() );
+  file << metadata.str();
+  
+  if( !file )
+    itkExceptionMacro( "Could not write " << metadataFileName << "." );
+  
+  this->ComputeNumberOfChunks();
+  this->Modified();
+}
+
+
+void ZarrArray::ComputeNumberOfChunks()
+{
+  m_NumberOfChunksPerAxis.resize( m_Shape.size() );
+  
+  for( unsigned int i=0; i < m_Shape.size(); ++i )
+    m_NumberOfChunksPerAxis[i] = ( m_Shape[i] + m_ChunkShape[i] - 1 ) / m_ChunkShape[i];
+}
+
+
+unsigned long ZarrArray::GetNumberOfChunks() const
+{
+  unsigned long numberOfChunks = 1;
+  
+  for( unsigned int i=0; i < m_NumberOfChunksPerAxis.size(); ++i )
+    numberOfChunks *= m_NumberOfChunksPerAxis[i];
+    
+  return m_NumberOfChunksPerAxis.empty() ? 0 : numberOfChunks;
+}
+
+
+unsigned long ZarrArray::GetNumberOfElementsPerChunk() const
+{
+  unsigned long numberOfElements = 1;
+  
+  for( unsigned int i=0; i < m_ChunkShape.size(); ++i )
+    numberOfElements *= m_ChunkShape[i];
+    
+  return m_ChunkShape.empty() ? 0 : numberOfElements;
+}
+
+
+unsigned long ZarrArray::GetChunkNumber( const ShapeType & chunkIndex ) const
+{
+  unsigned long chunk = 0;
+  
+  for( unsigned int i=m_NumberOfChunksPerAxis.size(); i > 0; --i )
+    chunk = chunk * m_NumberOfChunksPerAxis[i-1] + chunkIndex[i-1];
+    
+  return chunk;
+}
+
+
+ZarrArray::ShapeType ZarrArray::GetChunkIndex( unsigned long chunk ) const
+{
+  ShapeType chunkIndex( m_NumberOfChunksPerAxis.size() );
+  
+  for( unsigned int i=0; i < m_NumberOfChunksPerAxis.size(); ++i )
+  {
+    chunkIndex[i] = chunk % m_NumberOfChunksPerAxis[i];
+    chunk /= m_NumberOfChunksPerAxis[i];
+  }
+  
+  return chunkIndex;
+}
+
+
+std::string ZarrArray::GetChunkFileName( unsigned long chunk ) const
+{
+  ShapeType chunkIndex = this->GetChunkIndex( chunk );
+  
+  // Zarr names the chunks with the slowest axis first
+  
+  std::ostringstream fileName;
+  fileName << m_Path << "/";
+  
+  for( unsigned int i=chunkIndex.size(); i > 0; --i )
+    fileName << chunkIndex[i-1] << ( i > 1 ? std::string( 1, m_DimensionSeparator ) : std::string() );
+    
+  return fileName.str();
+}
+
+
+bool ZarrArray::ReadChunk( unsigned long chunk, void * buffer ) const
+{
+  std::string fileName = this->GetChunkFileName( chunk );
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  
+  if( !file )
+    return false;
+    
+  std::vector<char> data( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+  
+  unsigned long length = this->GetNumberOfElementsPerChunk() * m_ElementSize;
+  
+  if( m_CompressionLevel == 0 )
+  {
+    if( data.size() != length )
+      itkExceptionMacro( "Chunk " << fileName << " has a wrong size." );
+      
+    std::copy( data.begin(), data.end(), static_cast<char*>( buffer ) );
+  }
+  else
+  {
+    uLongf size = length;
+    
+    if( data.empty() || uncompress( static_cast<Bytef*>( buffer ), &size, 
+      reinterpret_cast<const Bytef*>( &data[0] ), data.size() ) != Z_OK || size != length )
+    {
+      itkExceptionMacro( "Could not inflate chunk " << fileName << "." );
+    }
+  }
+  
+  if( m_ElementSize > 1 && m_BigEndian != IsBigEndianSystem() )
+    SwapBytes( static_cast<char*>( buffer ), this->GetNumberOfElementsPerChunk(), m_ElementSize );
+    
+  return true;
+}
+
+
+void ZarrArray::WriteChunk( unsigned long chunk, const void * buffer ) const
+{
+  std::string fileName = this->GetChunkFileName( chunk );
+  
+  if( m_DimensionSeparator == '/' )
+    itksys::SystemTools::MakeDirectory( itksys::SystemTools::GetFilenamePath( fileName ).c_str() );
+  
+  unsigned long length = this->GetNumberOfElementsPerChunk() * m_ElementSize;
+  const char * data = static_cast<const char*>( buffer );
+  
+  std::vector<char> swapped;
+  
+  if( m_ElementSize > 1 && m_BigEndian != IsBigEndianSystem() )
+  {
+    swapped.assign( data, data + length );
+    SwapBytes( &swapped[0], this->GetNumberOfElementsPerChunk(), m_ElementSize );
+    data = &swapped[0];
+  }
+  
+  std::vector<Bytef> compressed;
+  
+  if( m_CompressionLevel != 0 )
+  {
+    uLongf size = compressBound( length );
+    compressed.resize( size );
+    
+    if( compress2( &compressed[0], &size, reinterpret_cast<const Bytef*>( data ), length, 
+      m_CompressionLevel ) != Z_OK )
+    {
+      itkExceptionMacro( "Could not compress chunk " << fileName << "." );
+    }
+    
+    data = reinterpret_cast<const char*>( &compressed[0] );
+    length = size;
+  }
+  
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  file.write( data, length );
+  
+  if( !file )
+    itkExceptionMacro( "Could not write chunk " << fileName << "." );
+}
+
+
+void ZarrArray::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Path: " << m_Path << std::endl;
+  os << indent << "Dimension: " << m_Shape.size() << std::endl;
+  os << indent << "NumberOfChunks: " << this->GetNumberOfChunks() << std::endl;
+  os << indent << "ElementSize: " << m_ElementSize << std::endl;
+  os << indent << "CompressionLevel: " << m_CompressionLevel << std::endl;
+  os << indent << "FillValue: " << m_FillValue << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,174 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanZarrArray.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: chunked array in the Zarr directory format.
+// Date: 2012/11/05
+
+
+#ifndef __ivanZarrArray_h
+#define __ivanZarrArray_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <string>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class ZarrArray
+ *  \brief Chunked array stored in the Zarr (version 2) directory format.
+ *
+ * The array is a directory with the metadata in a .zarray file and each chunk in a separate 
+ * file named after its chunk indices, such as 2.0.1. Chunks are compressed independently, so
+ * a region is read by decompressing only the chunks that overlap it. Chunks that were never 
+ * written have no file and take the fill value.
+ *
+ * Arrays of scalar numbers in C order are supported, with no filters and either no compressor
+ * or the zlib compressor of numcodecs. Zarr gives the shape with the slowest axis first, which
+ * is reversed here, so shapes and chunk indices are in ITK order, with x first. Chunks are 
+ * numbered in raster order with x fastest. Chunks are converted to the native byte order.
+ *
+ * ReadChunk() and WriteChunk() keep no state and may be called concurrently from several 
+ * threads for different chunks.
+ *
+ * \sa ChunkCache
+ * \ingroup 
+ */
+ 
+class ITK_EXPORT ZarrArray : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ZarrArray                       Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef std::vector<unsigned long>      ShapeType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ZarrArray, itk::Object );
+  
+  /** Read the metadata of an existing array. Throws an exception if it is not supported. */
+  void Open( const std::string & path );
+  
+  /** Create a new array, writing its metadata. The element type is given as its size in 
+    * bytes and whether it is integer and signed. A compression level of 0 stores the chunks
+    * uncompressed. */
+  void Create( const std::string & path, const ShapeType & shape, const ShapeType & chunkShape,
+    unsigned int elementSize, bool integer, bool isSigned, int compressionLevel = 1, 
+    double fillValue = 0.0 );
+  
+  const std::string & GetPath() const
+    { return m_Path; }
+  
+  unsigned int GetDimension() const
+    { return m_Shape.size(); }
+  const ShapeType & GetShape() const
+    { return m_Shape; }
+  const ShapeType & GetChunkShape() const
+    { return m_ChunkShape; }
+  
+  /** Number of chunks along each axis and in total. */
+  const ShapeType & GetNumberOfChunksPerAxis() const
+    { return m_NumberOfChunksPerAxis; }
+  unsigned long GetNumberOfChunks() const;
+  
+  unsigned long GetNumberOfElementsPerChunk() const;
+  
+  unsigned int GetElementSize() const
+    { return m_ElementSize; }
+  bool GetElementIsInteger() const
+    { return m_ElementIsInteger; }
+  bool GetElementIsSigned() const
+    { return m_ElementIsSigned; }
+  
+  int GetCompressionLevel() const
+    { return m_CompressionLevel; }
+  double GetFillValue() const
+    { return m_FillValue; }
+  
+  /** Chunk number of the given chunk indices, and the other way round. */
+  unsigned long GetChunkNumber( const ShapeType & chunkIndex ) const;
+  ShapeType GetChunkIndex( unsigned long chunk ) const;
+  
+  /** Read a chunk into a buffer of GetNumberOfElementsPerChunk() elements. Returns false, 
+    * leaving the buffer unchanged, if the chunk was never written. Throws an exception if 
+    * the chunk file is corrupt. */
+  bool ReadChunk( unsigned long chunk, void * buffer ) const;
+  
+  /** Write a chunk from a buffer of GetNumberOfElementsPerChunk() elements. */
+  void WriteChunk( unsigned long chunk, const void * buffer ) const;
+		
+protected:
+
+  ZarrArray();
+  ~ZarrArray() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  std::string GetChunkFileName( unsigned long chunk ) const;
+  
+  void ComputeNumberOfChunks();
+
+private:
+
+  ZarrArray(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::string     m_Path;
+  
+  ShapeType       m_Shape;
+  ShapeType       m_ChunkShape;
+  ShapeType       m_NumberOfChunksPerAxis;
+  
+  unsigned int    m_ElementSize;
+  bool            m_ElementIsInteger;
+  bool            m_ElementIsSigned;
+  bool            m_BigEndian;
+  
+  int             m_CompressionLevel;
+  double          m_FillValue;
+  
+  /** Separator of the chunk indices in the chunk file names. */
+  char            m_DimensionSeparator;
+};
+
+} // end namespace ivan
+
+#endif
@@ -44,6 +44,7 @@ SUCH DAMAGE.
 
 #include "itkInPlaceImageFilter.h"
 #include "itkNumericTraits.h"
+#include "itkPhiloxRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -52,6 +53,10 @@ namespace itk
  *
  * \brief Alter an image with additive gaussian white noise.
  *
+ * The noise of every pixel is drawn from a counter based generator keyed on the Seed 
+ * and the linear index of the pixel in the largest possible region, so the output 
+ * only depends on the Seed, and not on the number of threads or the streaming.
+ *
  * \author Gaetan Lehmann
  *
  * \ingroup IntensityImageFilters  Multithreaded
@@ -95,6 +100,9 @@ public:
   itkGetConstMacro(StandardDeviation, double);
   itkSetMacro(StandardDeviation, double);
   
+  itkGetConstMacro(Seed, unsigned int);
+  itkSetMacro(Seed, unsigned int);
+  
 
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
@@ -123,6 +131,7 @@ private:
   
   double m_Mean;
   double m_StandardDeviation;
+  unsigned int m_Seed;
 
 };
 
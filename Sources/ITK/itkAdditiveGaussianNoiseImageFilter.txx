@@ -20,7 +20,6 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkProgressReporter.h"
-#include "itkThreadSafeMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -31,6 +30,7 @@ AdditiveGaussianNoiseImageFilter<TInputImage, TOutputImage>
 {
   m_Mean = 0.0;
   m_StandardDeviation = 1.0;
+  m_Seed = 0;
 }
 
 
@@ -43,9 +43,28 @@ AdditiveGaussianNoiseImageFilter<TInputImage, TOutputImage>
   InputImageConstPointer  inputPtr = this->GetInput();
   OutputImagePointer outputPtr = this->GetOutput(0);
   
-  // create a random generator per thread
-  typename Statistics::ThreadSafeMersenneTwisterRandomVariateGenerator::Pointer rand = Statistics::ThreadSafeMersenneTwisterRandomVariateGenerator::New();
-  rand->Initialize();
+  // the generator is stateless, the noise of each pixel is keyed on its linear index
+  typedef Statistics::PhiloxRandomVariateGenerator  RandomGeneratorType;
+  typedef RandomGeneratorType::CounterType          CounterType;
+  
+  const RandomGeneratorType rand( m_Seed );
+  RandomGeneratorType::NormalBlockType normals;
+  CounterType currentBlock = 0;
+  bool blockValid = false;
+  
+  // strides of the largest possible region, independent of the requested region
+  typedef typename OutputImageType::IndexType  IndexType;
+  const OutputImageRegionType & largestRegion = outputPtr->GetLargestPossibleRegion();
+  const unsigned int ImageDimension = OutputImageType::ImageDimension;
+  
+  CounterType strides[ImageDimension];
+  strides[0] = 1;
+  for( unsigned int d=1; d<ImageDimension; ++d )
+    strides[d] = strides[d-1] * largestRegion.GetSize()[d-1];
+  
+  const unsigned long rowLength = outputRegionForThread.GetSize()[0];
+  unsigned long positionInRow = 0;
+  CounterType linearIndex = 0;
   
   // Define the portion of the input to walk for this thread, using
   // the CallCopyOutputRegionToInputRegion method allows for the input
@@ -64,12 +83,34 @@ AdditiveGaussianNoiseImageFilter<TInputImage, TOutputImage>
 
   while( !inputIt.IsAtEnd() ) 
     {
-    double out = inputIt.Get() + rand->GetNormalVariate( m_Mean, m_StandardDeviation * m_StandardDeviation );
+    if( positionInRow == 0 )
+      {
+      const IndexType & index = outputIt.GetIndex();
+      linearIndex = 0;
+      for( unsigned int d=0; d<ImageDimension; ++d )
+        linearIndex += ( index[d] - largestRegion.GetIndex()[d] ) * strides[d];
+      }
+    
+    // every counter yields four normal variates for four consecutive pixels
+    const CounterType block = linearIndex >> 2;
+    if( !blockValid || block != currentBlock )
+      {
+      rand.GenerateNormal( block, normals );
+      currentBlock = block;
+      blockValid = true;
+      }
+    
+    double out = inputIt.Get() + m_Mean + m_StandardDeviation * normals.Value[linearIndex & 3];
     out = std::min( (double)NumericTraits<OutputImagePixelType>::max(), out );
     out = std::max( (double)NumericTraits<OutputImagePixelType>::NonpositiveMin(), out );
     outputIt.Set( (OutputImagePixelType) out  );
     ++inputIt;
     ++outputIt;
+    ++linearIndex;
+    if( ++positionInRow == rowLength )
+      {
+      positionInRow = 0;
+      }
     progress.CompletedPixel();  // potential exception thrown here
     }
 }
@@ -86,6 +127,7 @@ AdditiveGaussianNoiseImageFilter<TInputImage, TOutputImage>
     os << indent << "StandardDeviation: " 
        << static_cast<typename NumericTraits<double>::PrintType>(m_StandardDeviation)
        << std::endl;
+    os << indent << "Seed: " << m_Seed << std::endl;
 }
 
 } /* namespace itk */
@@ -44,6 +44,7 @@ SUCH DAMAGE.
 
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
+#include "itkGaussianDerivativeOperator.h"
 
 namespace itk
 {
@@ -65,6 +66,13 @@ namespace itk
  * When the Gaussian kernel is small, this filter tends to run faster than
  * itk::RecursiveGaussianImageFilter.
  *
+ * The output is computed by one-dimensional passes along each axis over pieces
+ * of the output requested region (see SetInternalNumberOfStreamDivisions()), 
+ * keeping only the intermediate results of the current piece. Each pass is 
+ * split between the threads of the filter (see ivan::SeparableLineConvolution).
+ * The previous implementation, a mini-pipeline of NeighborhoodOperatorImageFilters
+ * and a StreamingImageFilter, is still available with UseNeighborhoodFiltersOn().
+ *
  * \author Iivan Macia, VICOMTech, Spain, http://www.vicomtech.org
  *
  * This implementation was taken from the Insight Journal paper:
@@ -108,6 +116,9 @@ public:
   typedef typename TInputImage::PixelType          InputPixelType;
   typedef typename TInputImage::InternalPixelType  InputInternalPixelType;
 
+  /** Type of the pixel used for the kernels and the accumulation. */
+  typedef typename NumericTraits< OutputPixelType >::RealType RealOutputPixelType;
+
   /** Extract some information from the image types.  Dimensionality
    * of the two images is assumed to be the same. */
   itkStaticConstMacro(ImageDimension, unsigned int,
@@ -119,6 +130,10 @@ public:
   /** Array for storing desired order of derivatives */
   typedef FixedArray< unsigned int, itkGetStaticConstMacro(ImageDimension) > OrderArrayType;
 
+  /** Type of the one-dimensional operators applied along each axis. */
+  typedef GaussianDerivativeOperator< RealOutputPixelType,
+                                      itkGetStaticConstMacro(ImageDimension) > OperatorType;
+
   /** Order of derivatives in each dimension. Sets the derivative order
    * independently for each dimension, but see also
    * SetOrder(const unsigned int v). The default is 1 in each dimension. */
@@ -157,6 +172,13 @@ public:
   itkSetMacro(InternalNumberOfStreamDivisions, unsigned int);
   itkGetConstMacro(InternalNumberOfStreamDivisions, unsigned int);
 
+  /** Set/Get whether the derivatives are computed by the internal mini-pipeline
+   * of NeighborhoodOperatorImageFilters instead of the native separable passes.
+   * The results are the same, this is kept for comparison. Default is off. */
+  itkSetMacro(UseNeighborhoodFilters, bool);
+  itkGetConstMacro(UseNeighborhoodFilters, bool);
+  itkBooleanMacro(UseNeighborhoodFilters);
+
   /** Convenience Set methods for setting all dimensional parameters
    *  to the same values.
    */
@@ -217,6 +239,7 @@ protected:
     m_UseImageSpacing = true;
     m_NormalizeAcrossScale = false;
     m_InternalNumberOfStreamDivisions = ImageDimension * ImageDimension;
+    m_UseNeighborhoodFilters = false;
   }
 
   virtual ~DiscreteGaussianDerivativeImageFilter() {}
@@ -232,12 +255,22 @@ protected:
   throw( InvalidRequestedRegionError );
 
   /** Standard pipeline method. While this class does not implement a
-   * ThreadedGenerateData(), its GenerateData() delegates all
-   * calculations to an NeighborhoodOperatorImageFilter.  Since the
-   * NeighborhoodOperatorImageFilter is multithreaded, this filter is
-   * multithreaded by default. */
+   * ThreadedGenerateData(), the separable passes of GenerateData() are 
+   * split between the threads of the filter's MultiThreader, so this 
+   * filter is multithreaded by default. */
   void GenerateData();
 
+  /** Set up the operator for the given direction from the parameters of 
+   * the filter. */
+  void SetUpOperator(OperatorType & oper, unsigned int direction) const;
+
+  /** Compute the output with separable passes along each axis. */
+  void GenerateDataWithSeparablePasses();
+
+  /** Compute the output with the mini-pipeline of 
+   * NeighborhoodOperatorImageFilters. */
+  void GenerateDataWithNeighborhoodFilters();
+
 private:
 
   DiscreteGaussianDerivativeImageFilter(const Self &); //purposely not
@@ -270,6 +303,9 @@ private:
   /** Number of pieces to divide the input on the internal composite
   pipeline. The upstream pipeline will not be effected. */
   unsigned int m_InternalNumberOfStreamDivisions;
+
+  /** Flag to use the mini-pipeline of NeighborhoodOperatorImageFilters. */
+  bool m_UseNeighborhoodFilters;
 };
 } // end namespace itk
 
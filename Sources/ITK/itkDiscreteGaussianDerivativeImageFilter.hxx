@@ -48,6 +48,9 @@ SUCH DAMAGE.
 #include "itkImageRegionIterator.h"
 #include "itkProgressAccumulator.h"
 #include "itkStreamingImageFilter.h"
+#include "ivanSeparableLineConvolution.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -132,6 +135,38 @@ throw( InvalidRequestedRegionError )
     }
 }
 
+template< class TInputImage, class TOutputImage >
+void
+DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
+::SetUpOperator(OperatorType & oper, unsigned int direction) const
+{
+  oper.SetDirection(direction);
+  oper.SetOrder(m_Order[direction]);
+  if ( m_UseImageSpacing == true )
+    {
+    if ( this->GetInput()->GetSpacing()[direction] == 0.0 )
+      {
+      itkExceptionMacro(<< "Pixel spacing cannot be zero");
+      }
+    else
+      {
+      // convert the variance from physical units to pixels
+      double s = this->GetInput()->GetSpacing()[direction];
+      s = s * s;
+      oper.SetVariance(m_Variance[direction] / s);
+      }
+    }
+  else
+    {
+    oper.SetVariance(m_Variance[direction]);
+    }
+
+  oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+  oper.SetMaximumError(m_MaximumError[direction]);
+  oper.SetNormalizeAcrossScale(m_NormalizeAcrossScale);
+  oper.CreateDirectional();
+}
+
 template< class TInputImage, class TOutputImage >
 void
 DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
@@ -142,14 +177,145 @@ DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
   output->SetBufferedRegion( output->GetRequestedRegion() );
   output->Allocate();
 
+  if ( m_UseNeighborhoodFilters )
+    {
+    this->GenerateDataWithNeighborhoodFilters();
+    }
+  else
+    {
+    this->GenerateDataWithSeparablePasses();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
+::GenerateDataWithSeparablePasses()
+{
+  typedef ivan::SeparableLineConvolution< ImageDimension, RealOutputPixelType > ConvolutionType;
+  typedef typename ConvolutionType::KernelType                                 KernelType;
+  typedef typename TOutputImage::RegionType                                    RegionType;
+
+  const InputImageType *input = this->GetInput();
+  OutputImageType      *output = this->GetOutput();
+
+  // Copy the coefficients of the operators, which are directional, to 
+  // one-dimensional kernels
+  std::vector< KernelType >        kernels( ImageDimension );
+  typename RegionType::SizeType    radius;
+
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    OperatorType oper;
+    this->SetUpOperator(oper, i);
+
+    radius[i] = oper.GetRadius(i);
+    kernels[i].resize( oper.Size() );
+
+    for ( unsigned int k = 0; k < oper.Size(); ++k )
+      {
+      kernels[i][k] = oper[k];
+      }
+    }
+
+  const RegionType inputRegion = input->GetBufferedRegion();
+  const RegionType outputRegion = output->GetRequestedRegion();
+
+  // The output requested region is divided in pieces along the last axis, 
+  // and each piece is obtained by a pass along each axis, starting with the
+  // first axis, whose pixels are contiguous. The result of each pass covers 
+  // the piece padded by the radius of the remaining axes.
+  const unsigned int      lastAxis = ImageDimension - 1;
+  const unsigned long     lastSize = outputRegion.GetSize()[lastAxis];
+  const unsigned long     numberOfPieces = std::max( 1ul,
+    std::min( static_cast< unsigned long >( m_InternalNumberOfStreamDivisions ), lastSize ) );
+
+  // Intermediate results, stored as output pixels as in the mini-pipeline
+  std::vector< OutputPixelType > buffers[2];
+
+  MultiThreader *threader = this->GetMultiThreader();
+  const unsigned int numberOfThreads = this->GetNumberOfThreads();
+
+  for ( unsigned long piece = 0; piece < numberOfPieces; ++piece )
+    {
+    RegionType pieceRegion = outputRegion;
+    pieceRegion.SetIndex( lastAxis, outputRegion.GetIndex()[lastAxis] + 
+      static_cast< long >( lastSize * piece / numberOfPieces ) );
+    pieceRegion.SetSize( lastAxis, lastSize * ( piece + 1 ) / numberOfPieces - 
+      lastSize * piece / numberOfPieces );
+
+    RegionType previousRegion;
+
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      RegionType passRegion = pieceRegion;
+
+      typename RegionType::SizeType passRadius;
+      for ( unsigned int a = 0; a < ImageDimension; ++a )
+        {
+        passRadius[a] = ( a > d ) ? radius[a] : 0;
+        }
+
+      passRegion.PadByRadius(passRadius);
+      passRegion.Crop(inputRegion);
+
+      std::vector< OutputPixelType > & current = buffers[d % 2];
+      std::vector< OutputPixelType > & previous = buffers[( d + 1 ) % 2];
+
+      if ( d < lastAxis )
+        {
+        current.resize( passRegion.GetNumberOfPixels() );
+        }
+
+      if ( d == 0 && d == lastAxis )
+        {
+        ConvolutionType::Convolve( ConvolutionType::GetImageView(input, inputRegion),
+                                   ConvolutionType::GetImageView(output, passRegion),
+                                   d, kernels[d], threader, numberOfThreads );
+        }
+      else if ( d == 0 )
+        {
+        ConvolutionType::Convolve( ConvolutionType::GetImageView(input, inputRegion),
+                                   ConvolutionType::GetArrayView(&current[0], passRegion),
+                                   d, kernels[d], threader, numberOfThreads );
+        }
+      else if ( d == lastAxis )
+        {
+        ConvolutionType::Convolve( ConvolutionType::GetArrayView(
+                                     static_cast< const OutputPixelType * >( &previous[0] ), previousRegion ),
+                                   ConvolutionType::GetImageView(output, passRegion),
+                                   d, kernels[d], threader, numberOfThreads );
+        }
+      else
+        {
+        ConvolutionType::Convolve( ConvolutionType::GetArrayView(
+                                     static_cast< const OutputPixelType * >( &previous[0] ), previousRegion ),
+                                   ConvolutionType::GetArrayView(&current[0], passRegion),
+                                   d, kernels[d], threader, numberOfThreads );
+        }
+
+      previousRegion = passRegion;
+
+      this->UpdateProgress( static_cast< float >( piece * ImageDimension + d + 1 ) /
+                            static_cast< float >( numberOfPieces * ImageDimension ) );
+      }
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
+::GenerateDataWithNeighborhoodFilters()
+{
+  typename TOutputImage::Pointer output = this->GetOutput();
+
   // Create an internal image to protect the input image's metdata
   // (e.g. RequestedRegion). The StreamingImageFilter changes the
   // requested region as poart of its normal provessing.
   typename TInputImage::Pointer localInput = TInputImage::New();
   localInput->Graft( this->GetInput() );
 
-  // Type of the pixel to use for intermediate results
-  typedef typename NumericTraits< OutputPixelType >::RealType RealOutputPixelType;
+  // Type of the image to use for intermediate results
   typedef Image< OutputPixelType, ImageDimension >            RealOutputImageType;
 
   // Type definition for the internal neighborhood filter
@@ -176,7 +342,6 @@ DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
   typedef typename StreamingFilterType::Pointer    StreamingFilterPointer;
 
   // Create a series of operators
-  typedef GaussianDerivativeOperator< RealOutputPixelType, ImageDimension > OperatorType;
   std::vector< OperatorType > oper;
   oper.resize(ImageDimension);
 
@@ -195,31 +360,7 @@ DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
     unsigned int reverse_i = ImageDimension - i - 1;
 
     // Set up the operator for this dimension
-    oper[reverse_i].SetDirection(i);
-    oper[reverse_i].SetOrder(m_Order[i]);
-    if ( m_UseImageSpacing == true )
-      {
-      if ( localInput->GetSpacing()[i] == 0.0 )
-        {
-        itkExceptionMacro(<< "Pixel spacing cannot be zero");
-        }
-      else
-        {
-        // convert the variance from physical units to pixels
-        double s = localInput->GetSpacing()[i];
-        s = s * s;
-        oper[reverse_i].SetVariance(m_Variance[i] / s);
-        }
-      }
-    else
-      {
-      oper[reverse_i].SetVariance(m_Variance[i]);
-      }
-
-    oper[reverse_i].SetMaximumKernelWidth(m_MaximumKernelWidth);
-    oper[reverse_i].SetMaximumError(m_MaximumError[i]);
-    oper[reverse_i].SetNormalizeAcrossScale(m_NormalizeAcrossScale);
-    oper[reverse_i].CreateDirectional();
+    this->SetUpOperator(oper[reverse_i], i);
     }
 
   // Create a chain of filters
@@ -332,6 +473,7 @@ DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
   os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
   os << indent << "InternalNumberOfStreamDivisions: " << m_InternalNumberOfStreamDivisions << std::endl;
   os << indent << "NormalizeAcrossScale: " << m_NormalizeAcrossScale << std::endl;
+  os << indent << "UseNeighborhoodFilters: " << m_UseNeighborhoodFilters << std::endl;
 }
 
 } // end namespace itk
@@ -44,6 +44,7 @@ SUCH DAMAGE.
 
 #include "itkDiscreteGaussianDerivativeImageFunction.h"
 #include "itkNeighborhoodOperatorImageFilter.h"
+#include "ivanNeighborhoodInnerProduct.h"
 
 namespace itk
 {
@@ -198,11 +199,15 @@ typename DiscreteGaussianDerivativeImageFunction< TInputImage, TOutput >::Output
 DiscreteGaussianDerivativeImageFunction< TInputImage, TOutput >
 ::EvaluateAtIndex(const IndexType & index) const
 {
-  OutputType derivative;
+  typedef ivan::NeighborhoodInnerProduct< InputImageType, TOutput > InnerProductType;
 
-  m_OperatorImageFunction->SetOperator(m_DerivativeKernel);
-  derivative = m_OperatorImageFunction->EvaluateAtIndex(index);
+  // Gather the neighborhood in contiguous memory on the stack and compute the inner product there
+  typename InnerProductType::ScratchBufferType buffer( m_DerivativeKernel.Size() );
+  InnerProductType::Gather( this->GetInputImage(), index, m_DerivativeKernel.GetRadius(), 
+    buffer.GetDataPointer() );
 
+  OutputType derivative = static_cast< OutputType >( 
+    InnerProductType::InnerProduct( m_DerivativeKernel, buffer ) );
 
   return derivative;
 }
@@ -44,6 +44,7 @@ SUCH DAMAGE.
 
 #include "itkDiscreteGradientMagnitudeGaussianImageFunction.h"
 #include "itkNeighborhoodOperatorImageFilter.h"
+#include "ivanNeighborhoodInnerProduct.h"
 
 namespace itk
 {
@@ -221,10 +222,16 @@ DiscreteGradientMagnitudeGaussianImageFunction< TInputImage, TOutput >
   OutputType gradientMagnitude = itk::NumericTraits< OutputType >::Zero;
   OutputType temp;
 
+  typedef ivan::NeighborhoodInnerProduct< InputImageType, TOutput > InnerProductType;
+
+  // All the kernels have the same radius, so the neighborhood is gathered only once
+  typename InnerProductType::ScratchBufferType buffer( m_KernelArray[0].Size() );
+  InnerProductType::Gather( this->GetInputImage(), index, m_KernelArray[0].GetRadius(), 
+    buffer.GetDataPointer() );
+
   for ( unsigned int i = 0; i < m_KernelArray.Size(); ++i )
     {
-    m_OperatorImageFunction->SetOperator(m_KernelArray[i]);
-    temp = m_OperatorImageFunction->EvaluateAtIndex(index);
+    temp = static_cast< OutputType >( InnerProductType::InnerProduct( m_KernelArray[i], buffer ) );
     if ( m_UseImageSpacing )
       {
       gradientMagnitude += vnl_math_sqr(temp / this->GetInputImage()->GetSpacing()[i]);
@@ -43,7 +43,7 @@ SUCH DAMAGE.
 #define __itkDiscreteHessianGaussianImageFunction_hxx
 
 #include "itkDiscreteHessianGaussianImageFunction.h"
-#include "itkNeighborhoodOperatorImageFilter.h"
+#include <vector>
 
 namespace itk
 {
@@ -142,40 +142,28 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
       }
     }
 
-  // Now precompute the N-dimensional kernel. This fastest as we don't
+  // Now precompute the N-dimensional kernels. This is fastest as we don't
   // have to perform N convolutions for each point we calculate but
-  // only one.
+  // only one. Since the operators are separable, each kernel is the outer
+  // product of the one-dimensional operators, padded to the maximum radius.
+  // Coefficients are reversed, since a kernel obtained by correlating an
+  // impulse with an operator is the reversed operator
+  const unsigned int kernelSize = 2 * maxRadius + 1;
 
-  typedef itk::Image< TOutput, itkGetStaticConstMacro(ImageDimension2) > KernelImageType;
-  typename KernelImageType::Pointer kernelImage = KernelImageType::New();
+  FixedArray< std::vector< TOutput >, 3 * itkGetStaticConstMacro(ImageDimension2) > paddedOperators;
 
-  typedef typename KernelImageType::RegionType RegionType;
-  RegionType region;
-
-  typename RegionType::SizeType size;
-  size.Fill(4 * maxRadius + 1);
-  region.SetSize(size);
-
-  kernelImage->SetRegions(region);
-  kernelImage->Allocate();
-  kernelImage->FillBuffer(itk::NumericTraits< TOutput >::Zero);
-
-  // Initially the kernel image will be an impulse at the center
-  typename KernelImageType::IndexType centerIndex;
-  centerIndex.Fill(2 * maxRadius);   // include also boundaries
+  for ( idx = 0; idx < m_OperatorArray.Size(); ++idx )
+    {
+    const unsigned int direction = idx % itkGetStaticConstMacro(ImageDimension2);
+    const int operatorRadius = m_OperatorArray[idx].GetRadius()[direction];
 
-  // Create an image region to be used later that does not include boundaries
-  RegionType kernelRegion;
-  size.Fill(2 * maxRadius + 1);
-  typename RegionType::IndexType origin;
-  origin.Fill(maxRadius);
-  kernelRegion.SetSize(size);
-  kernelRegion.SetIndex(origin);
+    paddedOperators[idx].assign( kernelSize, NumericTraits< TOutput >::Zero );
 
-  // Now create an image filter to perform sucessive convolutions
-  typedef itk::NeighborhoodOperatorImageFilter< KernelImageType, KernelImageType >
-  NeighborhoodFilterType;
-  typename NeighborhoodFilterType::Pointer convolutionFilter = NeighborhoodFilterType::New();
+    for ( int k = -operatorRadius; k <= operatorRadius; ++k )
+      {
+      paddedOperators[idx][maxRadius + k] = m_OperatorArray[idx][operatorRadius - k];
+      }
+    }
 
   // Array that stores the current order for each direction
   typedef FixedArray< unsigned int, itkGetStaticConstMacro(ImageDimension2) > OrderArrayType;
@@ -185,7 +173,7 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
   // The order of calculation in the 3D case is: dxx, dxy, dxz, dyy,
   // dyz, dzz
 
-  unsigned int opidx; // current operator index in m_OperatorArray
+  FixedArray< const TOutput *, itkGetStaticConstMacro(ImageDimension2) > kernels;
   unsigned int kernelidx = 0;
 
   for ( unsigned int i = 0; i < itkGetStaticConstMacro(ImageDimension2); ++i )
@@ -196,33 +184,29 @@ DiscreteHessianGaussianImageFunction< TInputImage, TOutput >
       ++orderArray[i];
       ++orderArray[j];
 
-      // Reset kernel image
-      kernelImage->FillBuffer(itk::NumericTraits< TOutput >::Zero);
-      kernelImage->SetPixel(centerIndex, itk::NumericTraits< TOutput >::One);
-
       for ( unsigned int direction = 0; direction < itkGetStaticConstMacro(ImageDimension2); ++direction )
         {
-        opidx = itkGetStaticConstMacro(ImageDimension2) * orderArray[direction] + direction;
-        convolutionFilter->SetInput(kernelImage);
-        convolutionFilter->SetOperator(m_OperatorArray[opidx]);
-        convolutionFilter->Update();
-        kernelImage = convolutionFilter->GetOutput();
-        kernelImage->DisconnectPipeline();
+        kernels[direction] = &paddedOperators[itkGetStaticConstMacro(ImageDimension2) *
+                                              orderArray[direction] + direction][0];
         }
 
       // Set the size of the current kernel
       m_KernelArray[kernelidx].SetRadius(maxRadius);
 
-      // Copy kernel image to neighborhood. Do not copy boundaries.
-      ImageRegionConstIterator< KernelImageType > it(kernelImage, kernelRegion);
-      it.GoToBegin();
-      idx = 0;
-
-      while ( !it.IsAtEnd() )
+      // The first direction varies fastest in the neighborhood. The products are taken in
+      // the same order as the successive convolutions of an impulse with the operators
+      for ( idx = 0; idx < m_KernelArray[kernelidx].Size(); ++idx )
         {
-        m_KernelArray[kernelidx][idx] = it.Get();
-        ++idx;
-        ++it;
+        TOutput      value = NumericTraits< TOutput >::One;
+        unsigned int offset = idx;
+
+        for ( unsigned int direction = 0; direction < itkGetStaticConstMacro(ImageDimension2); ++direction )
+          {
+          value *= kernels[direction][offset % kernelSize];
+          offset /= kernelSize;
+          }
+
+        m_KernelArray[kernelidx][idx] = value;
         }
       kernelidx++;
       }
@@ -45,6 +45,8 @@ SUCH DAMAGE.
 #include "itkGaussianOperator.h"
 #include "itkDerivativeOperator.h"
 
+#include "ivanGaussianKernelCache.h"
+
 namespace itk
 {
 /**
@@ -187,7 +189,8 @@ protected:
    * where k>=2. */
   static double ModifiedBesselI(int, double);
 
-  /** Calculates operator coefficients. */
+  /** Calculates operator coefficients. If the GaussianKernelCache is enabled, the coefficients 
+    * are taken from the cache when already computed with the same parameters. */
   CoefficientVector GenerateCoefficients();
 
   /** Arranges coefficients spatially in the memory buffer. */
@@ -198,6 +201,9 @@ private:
   /* methods for generations of the coeeficients for a gaussian
    * operator of 0-order respecting the remaining parameters */
   CoefficientVector GenerateGaussianCoefficients() const;
+  
+  /** Computes the operator coefficients without using the cache. */
+  CoefficientVector ComputeCoefficients();
 
   /** For compatibility with itkWarningMacro */
   const char * GetNameOfClass() const
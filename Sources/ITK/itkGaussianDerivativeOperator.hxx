@@ -98,6 +98,39 @@ typename GaussianDerivativeOperator< TPixel, VDimension, TAllocator >
 ::CoefficientVector
 GaussianDerivativeOperator< TPixel, VDimension, TAllocator >
 ::GenerateCoefficients()
+{
+  ivan::GaussianKernelCache::Pointer cache = ivan::GaussianKernelCache::GetInstance();
+
+  if ( !cache->GetEnabled() )
+    {
+    return this->ComputeCoefficients();
+    }
+
+  // The coefficients do not depend on the direction of the operator
+  ivan::GaussianKernelCache::ParameterVectorType parameters;
+    parameters.push_back( m_Variance );
+    parameters.push_back( m_Order );
+    parameters.push_back( m_Spacing );
+    parameters.push_back( m_MaximumError );
+    parameters.push_back( m_MaximumKernelWidth );
+    parameters.push_back( m_NormalizeAcrossScale );
+
+  CoefficientVector coeff;
+
+  if ( !cache->Find( "itk::GaussianDerivativeOperator", parameters, coeff ) )
+    {
+    coeff = this->ComputeCoefficients();
+    cache->Insert( "itk::GaussianDerivativeOperator", parameters, coeff );
+    }
+
+  return coeff;
+}
+
+template< class TPixel, unsigned int VDimension, class TAllocator >
+typename GaussianDerivativeOperator< TPixel, VDimension, TAllocator >
+::CoefficientVector
+GaussianDerivativeOperator< TPixel, VDimension, TAllocator >
+::ComputeCoefficients()
 {
 
   // compute gaussian kernel of 0-order
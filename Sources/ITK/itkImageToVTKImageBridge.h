@@ -0,0 +1,119 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: itkImageToVTKImageBridge.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: wraps the buffer of an ITK image as a vtkImageData without copying it
+// Date: 2012/11/05
+
+
+#ifndef __itkImageToVTKImageBridge_h
+#define __itkImageToVTKImageBridge_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkPixelTraits.h"
+
+#include "vtkImageData.h"
+
+namespace itk
+{
+
+/** \class ImageToVTKImageBridge
+ * \brief Wraps the pixel buffer of an itk::Image as the scalars of a vtkImageData.
+ *
+ * Unlike ImageToVTKImageFilter there is no exporter/importer pipeline and no copy: the
+ * scalars of the output point to the ITK buffer through SetVoidArray. The pixel container
+ * of the ITK image is registered by the scalars array and released when the array is 
+ * deleted, so the output can outlive both the bridge and the ITK image, and stays valid if
+ * the source of the image allocates a new buffer when it is updated again. Call Update() 
+ * again to point the output at the new buffer.
+ *
+ * The input must be up to date before calling Update(), the source of the ITK image 
+ * is not updated by the bridge. As with the exporter, the image direction is ignored.
+ *
+ * \ingroup   ITKVtkGlue
+ */
+template <class TInputImage>
+class ITK_EXPORT ImageToVTKImageBridge : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageToVTKImageBridge     Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageToVTKImageBridge, Object);
+
+  /** Some typedefs. */
+  typedef TInputImage                                  InputImageType;
+  typedef typename InputImageType::ConstPointer        InputImageConstPointer;
+  typedef typename InputImageType::PixelType           PixelType;
+  typedef typename PixelTraits<PixelType>::ValueType   ComponentType;
+  typedef typename InputImageType::PixelContainer      PixelContainerType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
+
+  /** Set the input in the form of an itk::Image. */
+  void SetInput( const InputImageType *image );
+  const InputImageType * GetInput() const
+    { return m_Input.GetPointer(); }
+
+  /** Get the output in the form of a vtkImage, valid after Update(). */
+  vtkImageData * GetOutput() const
+    { return m_Output; }
+
+  /** Point the output at the current buffer of the input. */
+  void Update();
+
+protected:
+  ImageToVTKImageBridge();
+  virtual ~ImageToVTKImageBridge();
+  
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+  
+  /** Releases the reference to the pixel container taken by a scalars array. */
+  static void ReleaseImageCallback( vtkObject *caller, unsigned long eventId, 
+    void *clientData, void *callData );
+
+private:
+  ImageToVTKImageBridge(const Self&); //purposely not implemented
+  void operator=(const Self&);        //purposely not implemented
+
+  InputImageConstPointer    m_Input;
+  vtkImageData             *m_Output;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageToVTKImageBridge.hxx"
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: itkImageToVTKImageBridge.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: wraps the buffer of an ITK image as a vtkImageData without copying it
+// Date: 2012/11/05
+
+
+#ifndef __itkImageToVTKImageBridge_hxx
+#define __itkImageToVTKImageBridge_hxx
+
+#include "itkImageToVTKImageBridge.h"
+
+#include "vtkDataArray.h"
+#include "vtkPointData.h"
+#include "vtkCallbackCommand.h"
+#include "vtkTypeTraits.h"
+
+namespace itk
+{
+
+/**
+ * Constructor
+ */
+template <class TInputImage>
+ImageToVTKImageBridge<TInputImage>
+::ImageToVTKImageBridge()
+{
+  m_Output = vtkImageData::New();
+}
+
+/**
+ * Destructor
+ */
+template <class TInputImage>
+ImageToVTKImageBridge<TInputImage>
+::~ImageToVTKImageBridge()
+{
+  if( m_Output )
+    {
+    m_Output->Delete();
+    m_Output = 0;
+    }
+}
+
+/**
+ * Set an itk::Image as input
+ */
+template <class TInputImage>
+void
+ImageToVTKImageBridge<TInputImage>
+::SetInput( const InputImageType * inputImage )
+{
+  if( m_Input != inputImage )
+    {
+    m_Input = inputImage;
+    this->Modified();
+    }
+}
+
+/**
+ * Wrap the buffer of the input
+ */
+template <class TInputImage>
+void
+ImageToVTKImageBridge<TInputImage>
+::Update()
+{
+  if( m_Input.IsNull() )
+    {
+    itkExceptionMacro( "No input image set." );
+    }
+  
+  const typename InputImageType::RegionType & region = m_Input->GetBufferedRegion();
+  const typename InputImageType::SpacingType & spacing = m_Input->GetSpacing();
+  const typename InputImageType::PointType & origin = m_Input->GetOrigin();
+  
+  int extent[6] = { 0, 0, 0, 0, 0, 0 };
+  double vtkSpacing[3] = { 1.0, 1.0, 1.0 };
+  double vtkOrigin[3] = { 0.0, 0.0, 0.0 };
+  
+  for( unsigned int i=0; i<ImageDimension && i<3; ++i )
+    {
+    extent[2*i] = region.GetIndex()[i];
+    extent[2*i+1] = region.GetIndex()[i] + region.GetSize()[i] - 1;
+    vtkSpacing[i] = spacing[i];
+    vtkOrigin[i] = origin[i];
+    }
+  
+  const unsigned int numberOfComponents = PixelTraits<PixelType>::Dimension;
+  const vtkIdType numberOfPixels = region.GetNumberOfPixels();
+  
+  // The container is not modified, but its buffer accessor is not const
+  PixelContainerType *pixelContainer = 
+    const_cast<PixelContainerType *>( m_Input->GetPixelContainer() );
+  
+  if( !pixelContainer )
+    {
+    itkExceptionMacro( "The input image has no pixel container." );
+    }
+  
+  vtkDataArray *scalars = vtkDataArray::CreateDataArray( vtkTypeTraits<ComponentType>::VTKTypeID() );
+  scalars->SetNumberOfComponents( numberOfComponents );
+  
+  // save = 1, the array never frees the ITK buffer
+  scalars->SetVoidArray( pixelContainer->GetBufferPointer(), 
+    numberOfPixels * numberOfComponents, 1 );
+  
+  // The array keeps the buffer alive. The image is not held, since its source may replace 
+  // the container when it is updated again
+  pixelContainer->Register();
+  
+  vtkCallbackCommand *releaseCommand = vtkCallbackCommand::New();
+  releaseCommand->SetCallback( Self::ReleaseImageCallback );
+  releaseCommand->SetClientData( pixelContainer );
+  scalars->AddObserver( vtkCommand::DeleteEvent, releaseCommand );
+  releaseCommand->Delete();
+  
+  m_Output->SetExtent( extent );
+  m_Output->SetSpacing( vtkSpacing );
+  m_Output->SetOrigin( vtkOrigin );
+  m_Output->GetPointData()->SetScalars( scalars );
+  
+  scalars->Delete();
+}
+
+/**
+ * Release the pixel container when the wrapping array is deleted
+ */
+template <class TInputImage>
+void
+ImageToVTKImageBridge<TInputImage>
+::ReleaseImageCallback( vtkObject *, unsigned long, void *clientData, void * )
+{
+  static_cast<PixelContainerType *>( clientData )->UnRegister();
+}
+
+template <class TInputImage>
+void
+ImageToVTKImageBridge<TInputImage>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Input: " << m_Input.GetPointer() << std::endl;
+  os << indent << "Output: " << m_Output << std::endl;
+}
+
+} // end namespace itk
+
+#endif
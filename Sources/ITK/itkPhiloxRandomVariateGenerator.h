@@ -0,0 +1,150 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+
+#ifndef __itkPhiloxRandomVariateGenerator_h
+#define __itkPhiloxRandomVariateGenerator_h
+
+#include "vxl_config.h"
+#include "vnl/vnl_math.h"
+#include "vcl_cmath.h"
+
+namespace itk {
+namespace Statistics {
+
+/** \class PhiloxRandomVariateGenerator
+ * \brief Counter based random variate generator (Philox4x32-10).
+ *
+ * Instead of advancing an internal state, every block of four 32 bit random numbers 
+ * is a pure function of a key (the seed) and a counter, as described in Salmon et al., 
+ * "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11. Any thread can therefore 
+ * generate the numbers of any counter without synchronization, and the sequence 
+ * does not depend on how the work is split.
+ *
+ * The class has no mutable state other than the key, so a single const instance 
+ * can be shared by all threads.
+ *
+ * \ingroup Statistics
+ */
+class PhiloxRandomVariateGenerator
+{
+public:
+
+  typedef vxl_uint_32    IntegerType;
+  typedef vxl_uint_64    CounterType;
+  
+  /** Block of random numbers produced for a single counter. */
+  struct BlockType
+  {
+    IntegerType Value[4];
+  };
+  
+  /** Block of normal variates produced for a single counter. */
+  struct NormalBlockType
+  {
+    double Value[4];
+  };
+
+public:
+
+  PhiloxRandomVariateGenerator( IntegerType seed = 0 )
+    { this->SetSeed( seed ); }
+  
+  void SetSeed( IntegerType seed )
+    { m_Key[0] = seed; m_Key[1] = 0; }
+  IntegerType GetSeed() const
+    { return m_Key[0]; }
+  
+  /** Four uniformly distributed 32 bit integers for the given counter. */
+  inline void Generate( CounterType counter, BlockType & block ) const;
+  
+  /** Four normal variates of zero mean and unit variance for the given counter, 
+    * computed as two Box-Muller pairs. */
+  inline void GenerateNormal( CounterType counter, NormalBlockType & block ) const;
+  
+  /** Map a 32 bit integer to a double in the open interval (0,1). */
+  static double ToOpenUnitInterval( IntegerType value )
+    { return ( (double)value + 0.5 ) * ( 1.0 / 4294967296.0 ); }
+
+private:
+
+  IntegerType m_Key[2];
+};
+
+
+inline void PhiloxRandomVariateGenerator::Generate( CounterType counter, BlockType & block ) const
+{
+  const IntegerType M0 = 0xD2511F53U;
+  const IntegerType M1 = 0xCD9E8D57U;
+  const IntegerType W0 = 0x9E3779B9U;
+  const IntegerType W1 = 0xBB67AE85U;
+  
+  IntegerType c0 = (IntegerType)( counter & 0xFFFFFFFFU );
+  IntegerType c1 = (IntegerType)( counter >> 32 );
+  IntegerType c2 = 0;
+  IntegerType c3 = 0;
+  
+  IntegerType k0 = m_Key[0];
+  IntegerType k1 = m_Key[1];
+  
+  for( unsigned int round=0; round<10; ++round )
+  {
+    const CounterType product0 = (CounterType)M0 * c0;
+    const CounterType product1 = (CounterType)M1 * c2;
+    
+    c0 = (IntegerType)( product1 >> 32 ) ^ c1 ^ k0;
+    c1 = (IntegerType)product1;
+    c2 = (IntegerType)( product0 >> 32 ) ^ c3 ^ k1;
+    c3 = (IntegerType)product0;
+    
+    k0 += W0;
+    k1 += W1;
+  }
+  
+  block.Value[0] = c0;
+  block.Value[1] = c1;
+  block.Value[2] = c2;
+  block.Value[3] = c3;
+}
+
+
+inline void PhiloxRandomVariateGenerator::GenerateNormal( CounterType counter, NormalBlockType & block ) const
+{
+  BlockType uniform;
+  this->Generate( counter, uniform );
+  
+  for( unsigned int i=0; i<4; i+=2 )
+  {
+    const double radius = vcl_sqrt( -2.0 * vcl_log( ToOpenUnitInterval( uniform.Value[i] ) ) );
+    const double angle = 2.0 * vnl_math::pi * ToOpenUnitInterval( uniform.Value[i+1] );
+    
+    block.Value[i] = radius * vcl_cos( angle );
+    block.Value[i+1] = radius * vcl_sin( angle );
+  }
+}
+
+} // end namespace Statistics
+} // end namespace itk
+
+#endif
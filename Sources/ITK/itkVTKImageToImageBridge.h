@@ -0,0 +1,157 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: itkVTKImageToImageBridge.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: wraps the scalars of a vtkImageData as the buffer of an ITK image without copying them
+// Date: 2012/11/05
+
+
+#ifndef __itkVTKImageToImageBridge_h
+#define __itkVTKImageToImageBridge_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImportImageContainer.h"
+#include "itkPixelTraits.h"
+
+#include "vtkImageData.h"
+#include "vtkDataArray.h"
+
+namespace itk
+{
+
+/** \class VTKDataArrayImageContainer
+ * \brief Pixel container of an itk::Image that points to the memory of a vtkDataArray.
+ *
+ * The container registers the array and releases it when destroyed, so the array 
+ * lives as long as any image uses the container.
+ *
+ * \ingroup   ITKVtkGlue
+ */
+template <class TImage>
+class ITK_EXPORT VTKDataArrayImageContainer : public TImage::PixelContainer
+{
+public:
+  /** Standard class typedefs. */
+  typedef VTKDataArrayImageContainer        Self;
+  typedef typename TImage::PixelContainer   Superclass;
+  typedef SmartPointer<Self>                Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VTKDataArrayImageContainer, ImportImageContainer);
+  
+  typedef typename Superclass::ElementIdentifier  ElementIdentifier;
+  typedef typename Superclass::Element            Element;
+  
+  /** Point the container at the memory of the array, which is registered. */
+  void SetDataArray( vtkDataArray *array, ElementIdentifier numberOfPixels );
+  
+protected:
+  VTKDataArrayImageContainer() : m_DataArray( 0 ) {};
+  virtual ~VTKDataArrayImageContainer();
+
+private:
+  VTKDataArrayImageContainer(const Self&); //purposely not implemented
+  void operator=(const Self&);             //purposely not implemented
+  
+  vtkDataArray   *m_DataArray;
+};
+
+
+/** \class VTKImageToImageBridge
+ * \brief Wraps the scalars of a vtkImageData as the buffer of an itk::Image.
+ *
+ * Unlike VTKImageToImageFilter there is no exporter/importer pipeline and no copy. The 
+ * pixel container of the output keeps a reference to the scalars array, so the output 
+ * can outlive both the bridge and the vtkImageData. The scalar type and number of 
+ * components of the VTK image must match the pixel type, otherwise Update() throws.
+ *
+ * The input must be up to date before calling Update().
+ *
+ * \ingroup   ITKVtkGlue
+ */
+template <class TOutputImage>
+class ITK_EXPORT VTKImageToImageBridge : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef VTKImageToImageBridge     Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VTKImageToImageBridge, Object);
+
+  /** Some typedefs. */
+  typedef TOutputImage                                 OutputImageType;
+  typedef typename OutputImageType::Pointer            OutputImagePointer;
+  typedef typename OutputImageType::PixelType          PixelType;
+  typedef typename PixelTraits<PixelType>::ValueType   ComponentType;
+  
+  typedef VTKDataArrayImageContainer<OutputImageType>  PixelContainerType;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, OutputImageType::ImageDimension );
+
+  /** Set the input in the form of a vtkImageData. */
+  void SetInput( vtkImageData *image );
+  vtkImageData * GetInput() const
+    { return m_Input; }
+
+  /** Get the output in the form of an itk::Image, valid after Update(). */
+  OutputImageType * GetOutput() const
+    { return m_Output.GetPointer(); }
+
+  /** Point the output at the current scalars of the input. */
+  void Update();
+
+protected:
+  VTKImageToImageBridge();
+  virtual ~VTKImageToImageBridge();
+  
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+private:
+  VTKImageToImageBridge(const Self&); //purposely not implemented
+  void operator=(const Self&);        //purposely not implemented
+
+  vtkImageData        *m_Input;
+  OutputImagePointer   m_Output;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkVTKImageToImageBridge.hxx"
+#endif
+
+#endif
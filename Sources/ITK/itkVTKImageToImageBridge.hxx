@@ -0,0 +1,204 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: itkVTKImageToImageBridge.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: wraps the scalars of a vtkImageData as the buffer of an ITK image without copying them
+// Date: 2012/11/05
+
+
+#ifndef __itkVTKImageToImageBridge_hxx
+#define __itkVTKImageToImageBridge_hxx
+
+#include "itkVTKImageToImageBridge.h"
+
+#include "vtkPointData.h"
+#include "vtkTypeTraits.h"
+
+namespace itk
+{
+
+template <class TImage>
+VTKDataArrayImageContainer<TImage>
+::~VTKDataArrayImageContainer()
+{
+  if( m_DataArray )
+    {
+    m_DataArray->UnRegister( 0 );
+    m_DataArray = 0;
+    }
+}
+
+template <class TImage>
+void
+VTKDataArrayImageContainer<TImage>
+::SetDataArray( vtkDataArray *array, ElementIdentifier numberOfPixels )
+{
+  if( array )
+    {
+    array->Register( 0 );
+    }
+  if( m_DataArray )
+    {
+    m_DataArray->UnRegister( 0 );
+    }
+  m_DataArray = array;
+  
+  // the container never frees the VTK memory
+  this->SetImportPointer( array ? static_cast<Element *>( array->GetVoidPointer( 0 ) ) : 0, 
+    numberOfPixels, false );
+}
+
+
+/**
+ * Constructor
+ */
+template <class TOutputImage>
+VTKImageToImageBridge<TOutputImage>
+::VTKImageToImageBridge() : 
+  m_Input( 0 )
+{
+}
+
+/**
+ * Destructor
+ */
+template <class TOutputImage>
+VTKImageToImageBridge<TOutputImage>
+::~VTKImageToImageBridge()
+{
+  this->SetInput( 0 );
+}
+
+/**
+ * Set a vtkImageData as input
+ */
+template <class TOutputImage>
+void
+VTKImageToImageBridge<TOutputImage>
+::SetInput( vtkImageData *image )
+{
+  if( m_Input == image )
+    {
+    return;
+    }
+  if( image )
+    {
+    image->Register( 0 );
+    }
+  if( m_Input )
+    {
+    m_Input->UnRegister( 0 );
+    }
+  m_Input = image;
+  this->Modified();
+}
+
+/**
+ * Wrap the scalars of the input
+ */
+template <class TOutputImage>
+void
+VTKImageToImageBridge<TOutputImage>
+::Update()
+{
+  if( !m_Input )
+    {
+    itkExceptionMacro( "No input image set." );
+    }
+  
+  vtkDataArray *scalars = m_Input->GetPointData()->GetScalars();
+  
+  if( !scalars )
+    {
+    itkExceptionMacro( "Input image has no scalars." );
+    }
+  
+  if( scalars->GetDataType() != vtkTypeTraits<ComponentType>::VTKTypeID() || 
+      scalars->GetNumberOfComponents() != (int)PixelTraits<PixelType>::Dimension )
+    {
+    itkExceptionMacro( "Scalar type " << scalars->GetDataTypeAsString() << " with " 
+      << scalars->GetNumberOfComponents() << " components does not match the output pixel type." );
+    }
+  
+  int extent[6];
+  m_Input->GetExtent( extent );
+  
+  const double *spacing = m_Input->GetSpacing();
+  const double *origin = m_Input->GetOrigin();
+  
+  typename OutputImageType::RegionType region;
+  typename OutputImageType::SpacingType outputSpacing;
+  typename OutputImageType::PointType outputOrigin;
+  
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+    if( i < 3 )
+      {
+      region.SetIndex( i, extent[2*i] );
+      region.SetSize( i, extent[2*i+1] - extent[2*i] + 1 );
+      outputSpacing[i] = spacing[i];
+      outputOrigin[i] = origin[i];
+      }
+    else
+      {
+      region.SetIndex( i, 0 );
+      region.SetSize( i, 1 );
+      outputSpacing[i] = 1.0;
+      outputOrigin[i] = 0.0;
+      }
+    }
+  
+  // Dimensions of the VTK image that the output can not represent must be flat
+  for( unsigned int i=ImageDimension; i<3; ++i )
+    {
+    if( extent[2*i+1] != extent[2*i] )
+      {
+      itkExceptionMacro( "Input image has more dimensions than the output." );
+      }
+    }
+  
+  typename PixelContainerType::Pointer container = PixelContainerType::New();
+  container->SetDataArray( scalars, region.GetNumberOfPixels() );
+  
+  m_Output = OutputImageType::New();
+  m_Output->SetRegions( region );
+  m_Output->SetSpacing( outputSpacing );
+  m_Output->SetOrigin( outputOrigin );
+  m_Output->SetPixelContainer( container );
+}
+
+template <class TOutputImage>
+void
+VTKImageToImageBridge<TOutputImage>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Input: " << m_Input << std::endl;
+  os << indent << "Output: " << m_Output.GetPointer() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,48 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanModelingTemplateTypes.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: centerline types with compiled specializations in ivanModeling
+// Date: 2012/11/05
+
+#ifndef __ivanModelingTemplateTypes_h
+#define __ivanModelingTemplateTypes_h
+
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselCenterline.h"
+
+namespace ivan
+{
+namespace Templates
+{
+
+/** Centerline of circular sections with compiled specializations (see ivanExplicitInstantiation.h). */
+typedef CircularVesselSection<3>                                 CircularVesselSection3;
+typedef VesselCenterline<unsigned int,CircularVesselSection3>    CircularVesselCenterline3;
+
+} // end namespace Templates
+} // end namespace ivan
+
+#endif
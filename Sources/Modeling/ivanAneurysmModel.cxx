@@ -34,7 +34,9 @@ SUCH DAMAGE.
 namespace ivan
 {
 
-AneurysmModel::AneurysmModel()
+AneurysmModel::AneurysmModel() :
+  m_ReferenceRadius( 0.0 ),
+  m_MaximumRadius( 0.0 )
 {
 
 }
@@ -49,7 +51,9 @@ AneurysmModel::~AneurysmModel()
 void AneurysmModel::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
-
+  
+  os << indent << "ReferenceRadius: " << m_ReferenceRadius << std::endl;
+  os << indent << "MaximumRadius: " << m_MaximumRadius << std::endl;
 }
 
 } // end namespace ivan
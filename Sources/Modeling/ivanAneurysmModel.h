@@ -38,8 +38,10 @@ namespace ivan
 {
 
 /** \class AneurysmModel
- *  \brief Model describing a vessel stenosis, that is, a narrowing of the vessel.
+ *  \brief Model describing a vessel aneurysm, that is, a dilation of the vessel.
  * 
+ * The dilation is described by the maximum radius in the affected region and the reference 
+ * radius of the healthy vessel around it (see VesselFeatureDetector).
  *
  * \ingroup 
  */
@@ -71,6 +73,18 @@ public:
   static std::string GetFeatureTypeStatic()
     { return "Aneurysm"; }
   
+  /** Set/Get the radius of the healthy vessel around the aneurysm. */
+  itkSetMacro( ReferenceRadius, double );
+  itkGetConstMacro( ReferenceRadius, double );
+  
+  /** Set/Get the maximum radius in the aneurysm. */
+  itkSetMacro( MaximumRadius, double );
+  itkGetConstMacro( MaximumRadius, double );
+  
+  /** Get the dilation ratio, that is, the maximum radius relative to the reference radius. */
+  double GetDilationRatio() const
+    { return ( m_ReferenceRadius > 0.0 ) ? m_MaximumRadius / m_ReferenceRadius : 0.0; }
+  
 protected:
   
   AneurysmModel();
@@ -85,7 +99,8 @@ private:
 
 protected:
 
-
+  double    m_ReferenceRadius;
+  double    m_MaximumRadius;
 };
 
 } // end namespace ivan
@@ -108,6 +108,9 @@ public:
   RadialContourPointer GetThrombusContour() const
     { return m_ThrombusContour; }
   
+  /** Copy all the data of the given section, including copies of the contours. */
+  virtual void DeepCopy( const typename Superclass::Self * section );
+  
 protected:
   
   AorticAneurysmVesselSection();
@@ -53,6 +53,39 @@ AorticAneurysmVesselSection<VDimension>::~AorticAneurysmVesselSection()
 }
 
 
+template <unsigned int VDimension>
+void AorticAneurysmVesselSection<VDimension>::DeepCopy( const typename Superclass::Self * section )
+{
+  Superclass::DeepCopy( section );
+  
+  const Self *aneurysmSection = dynamic_cast<const Self*>( section );
+  
+  if( aneurysmSection )
+  {
+    m_Center2 = aneurysmSection->m_Center2;
+    m_AneurysmCenter = aneurysmSection->m_AneurysmCenter;
+    m_MaxAneurysmDiameter = aneurysmSection->m_MaxAneurysmDiameter;
+    
+    // The contours are not shared with the original section
+    const RadialContourType *contours[2] = 
+      { aneurysmSection->m_LumenContour, aneurysmSection->m_ThrombusContour };
+    RadialContourPointer copies[2] = { RadialContourType::New(), RadialContourType::New() };
+    
+    for( unsigned int c=0; c<2; ++c )
+    {
+      copies[c]->SetContourId( contours[c]->GetContourId() );
+      copies[c]->SetNumberOfElements( contours[c]->GetNumberOfElements() );
+      
+      for( unsigned int i=0; i<contours[c]->GetNumberOfElements(); ++i )
+        copies[c]->SetPoint( i, contours[c]->GetPoint(i) );
+    }
+    
+    m_LumenContour = copies[0];
+    m_ThrombusContour = copies[1];
+  }
+}
+
+
 template <unsigned int VDimension>
 void AorticAneurysmVesselSection<VDimension>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
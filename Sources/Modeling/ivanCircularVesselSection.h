@@ -31,6 +31,7 @@ SUCH DAMAGE.
 #ifndef __ivanCircularVesselSection_h
 #define __ivanCircularVesselSection_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanVesselSection.h"
 
 #include "itkPoint.h"
@@ -102,6 +103,9 @@ public:
   
   itkSetMacro( Arclength, double );
   itkGetConstMacro( Arclength, double );
+  
+  /** Copy all the data of the given section. */
+  virtual void DeepCopy( const typename Superclass::Self * section );
     
 protected:
   
@@ -134,6 +138,17 @@ protected:
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_CircularVesselSection(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT CircularVesselSection< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef CircularVesselSection< ITK_TEMPLATE_1 x > \
+                                                  CircularVesselSection##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanCircularVesselSection+-.h"
+#endif
+
 #if ITK_TEMPLATE_TXX
 # include "ivanCircularVesselSection.hxx"
 #endif
@@ -43,7 +43,7 @@ CircularVesselSection<VDimension,TCurveMetrics,TSectionMetrics>::CircularVesselS
   m_Scale(0.0),
   m_Arclength(0.0)
 {
-
+  m_Normal.Fill( 0.0 );
 }
 
 
@@ -54,6 +54,24 @@ CircularVesselSection<VDimension,TCurveMetrics,TSectionMetrics>::~CircularVessel
 }
 
 
+template <unsigned int VDimension, class TCurveMetrics, class TSectionMetrics>
+void CircularVesselSection<VDimension,TCurveMetrics,TSectionMetrics>::DeepCopy
+  ( const typename Superclass::Self * section )
+{
+  Superclass::DeepCopy( section );
+  
+  const Self *circularSection = dynamic_cast<const Self*>( section );
+  
+  if( circularSection )
+  {
+    m_Normal = circularSection->m_Normal;
+    m_Radius = circularSection->m_Radius;
+    m_Scale = circularSection->m_Scale;
+    m_Arclength = circularSection->m_Arclength;
+  }
+}
+
+
 template <unsigned int VDimension, class TCurveMetrics, class TSectionMetrics>
 void CircularVesselSection<VDimension,TCurveMetrics,TSectionMetrics>::PrintSelf
   ( std::ostream& os, itk::Indent indent ) const
@@ -33,7 +33,7 @@ SUCH DAMAGE.
 
 #include "ivanGraphNodeVisitor.h"
 
-#include <list>
+#include <vector>
 
 namespace ivan
 {
@@ -44,6 +44,10 @@ namespace ivan
  * This visitor collects nodes of the given type, which is the template
  * parameter.
  *
+ * Collect() takes the nodes of a whole graph from the lists cached by the graph instead of
+ * visiting it, as long as all the children are traversed. Nodes whose mask does not match 
+ * the traversal mask are skipped in both cases.
+ *
  * \ingroup 
  */
 
@@ -63,7 +67,7 @@ public:
   typedef TNode                       NodeType;
   typedef typename NodeType::Pointer  NodePointer;
     
-  typedef std::list<NodePointer>      NodeContainer;
+  typedef std::vector<NodePointer>    NodeContainer;
   
 public:
 
@@ -78,15 +82,19 @@ public:
   virtual void Reset() 
     { m_Nodes.clear(); }
   
-  /** Start visiting given node. */
+  /** Collect the node if it is of the given type and continue with the traversal. */
 	virtual void Visit( GraphNode *node );
 	
+	/** Collect the nodes of the given graph, starting from its root node. */
+	template <class TGraph>
+	void Collect( TGraph *graph );
+	
 	NodeContainer & GetNodeContainer()
 	  { return m_Nodes; }
   const NodeContainer & GetNodeContainer() const
 	  { return m_Nodes; }
 	  
-	void GetNumberOfNodes() const
+	unsigned long GetNumberOfNodes() const
 	  { return m_Nodes.size(); }
 		
 protected:
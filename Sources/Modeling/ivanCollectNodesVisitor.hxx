@@ -36,9 +36,6 @@ SUCH DAMAGE.
 namespace ivan
 {
 
-namespace Vessel
-{
-
 template <class TNode>
 CollectNodesVisitor<TNode>::CollectNodesVisitor()
 {
@@ -54,21 +51,50 @@ CollectNodesVisitor<TNode>::~CollectNodesVisitor()
 
 
 template <class TNode>
-void CollectNodesVisitor<TNode>::Visit( GraphNode & node )
+void CollectNodesVisitor<TNode>::Visit( GraphNode * node )
+{
+  TNode *typedNode = dynamic_cast<TNode*>( node );
+  
+  if( typedNode )
+    m_Nodes.push_back( typedNode );
+  
+  // Nodes derived from the collected type have their own type identifiers, so the dispatcher
+  // table is bypassed
+  this->Traverse( node ); // continue with traversal
+}
+
+
+template <class TNode>
+template <class TGraph>
+void CollectNodesVisitor<TNode>::Collect( TGraph * graph )
 {
-  if( dynamic_cast<TNode*>( &node ) )
-    m_Nodes.push_back( &node );
+  if( !graph || graph->GetRootNode().IsNull() )
+    return;
     
-  Superclass::Visit( node );
+  if( this->GetTraversalMode() != Superclass::TraverseAllChildren )
+  {
+    graph->GetRootNode()->Accept( this );
+    return;
+  }
+  
+  const std::vector<TNode*> & nodes = graph->template GetNodesOfType<TNode>();
+  
+  m_Nodes.reserve( m_Nodes.size() + nodes.size() );
+  
+  for( unsigned int i=0; i<nodes.size(); ++i )
+  {
+    if( this->IsValidMask( nodes[i] ) )
+      m_Nodes.push_back( nodes[i] );
+  }
 }
 	
 
-template <class TMetricsCalculator>
-void CollectNodesVisitor<TMetricsCalculator>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+template <class TNode>
+void CollectNodesVisitor<TNode>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
-  
+  os << indent << "NumberOfNodes: " << m_Nodes.size() << std::endl;
 }
 
 } // end namespace ivan
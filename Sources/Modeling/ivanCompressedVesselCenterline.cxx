@@ -0,0 +1,461 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCompressedVesselCenterline.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compact encoding of the sections of a vessel centerline.
+// Date: 2012/11/05
+
+#include "ivanCompressedVesselCenterline.h"
+
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace ivan
+{
+
+/** Version byte of the buffers, and flag of the deflated ones. */
+static const unsigned char CompressedVesselCenterlineVersion = 1;
+static const unsigned char CompressedVesselCenterlineDeflated = 1;
+
+/** Code of the zero normal, outside of the range of the mapping. */
+static const vxl_int_16 CompressedVesselCenterlineZeroNormal = -32768;
+
+
+CompressedVesselCenterline::CompressedVesselCenterline() :
+  m_Precision( 0.001 ),
+  m_Deflate( true ),
+  m_Dimension( 0 ),
+  m_NumberOfSections( 0 ),
+  m_EncodedPrecision( 0.0 )
+{
+
+}
+
+
+void CompressedVesselCenterline::Encode( unsigned int dimension, unsigned int numberOfSections, 
+  const double * centers, const double * normals, const double * radii, const double * scales, 
+  const double * arclengths )
+{
+  if( m_Precision <= 0.0 )
+    itkExceptionMacro( "Precision must be positive." );
+    
+  BufferType columns;
+  columns.reserve( numberOfSections * ( 3 * dimension + 8 ) );
+  
+  // Centers, as differences of the quantized components
+  std::vector<vxl_int_64> previous( dimension, 0 );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      const vxl_int_64 value = Quantize( centers[ i * dimension + d ], m_Precision );
+      WriteInteger( columns, value - previous[d] );
+      previous[d] = value;
+    }
+  }
+  
+  // Normals
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    vxl_int_16 code[3];
+    unsigned int numberOfCodes = dimension;
+    
+    if( dimension == 3 )
+    {
+      EncodeOctahedral( normals + i * dimension, code );
+      numberOfCodes = 2;
+    }
+    
+    for( unsigned int c=0; c<numberOfCodes; ++c )
+    {
+      vxl_int_16 value;
+      
+      if( dimension == 3 )
+        value = code[c];
+      else
+      {
+        const double component = std::max( -1.0, std::min( 1.0, normals[ i * dimension + c ] ) );
+        value = (vxl_int_16)Quantize( component * 32767.0, 1.0 );
+      }
+        
+      const vxl_uint_16 bits = value;
+      columns.push_back( bits & 0xff );
+      columns.push_back( bits >> 8 );
+    }
+  }
+  
+  // Radii and scales
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const vxl_uint_16 radius = EncodeHalf( radii[i] );
+    columns.push_back( radius & 0xff );
+    columns.push_back( radius >> 8 );
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const vxl_uint_16 scale = EncodeHalf( scales[i] );
+    columns.push_back( scale & 0xff );
+    columns.push_back( scale >> 8 );
+  }
+  
+  // Arclengths, as differences
+  vxl_int_64 previousArclength = 0;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const vxl_int_64 value = Quantize( arclengths[i], m_Precision );
+    WriteInteger( columns, value - previousArclength );
+    previousArclength = value;
+  }
+  
+  // Header
+  m_Buffer.clear();
+  m_Buffer.push_back( CompressedVesselCenterlineVersion );
+  m_Buffer.push_back( m_Deflate ? CompressedVesselCenterlineDeflated : 0 );
+  WriteInteger( m_Buffer, dimension );
+  WriteInteger( m_Buffer, numberOfSections );
+  
+  const unsigned char *precision = reinterpret_cast<const unsigned char*>( &m_Precision );
+  m_Buffer.insert( m_Buffer.end(), precision, precision + sizeof(double) );
+  
+  WriteInteger( m_Buffer, columns.size() );
+  
+  if( m_Deflate && !columns.empty() )
+  {
+    uLongf size = compressBound( columns.size() );
+    const unsigned long start = m_Buffer.size();
+    m_Buffer.resize( start + size );
+    
+    if( compress2( &m_Buffer[start], &size, &columns[0], columns.size(), Z_BEST_COMPRESSION ) != Z_OK )
+      itkExceptionMacro( "Could not deflate the sections." );
+      
+    m_Buffer.resize( start + size );
+  }
+  else
+    m_Buffer.insert( m_Buffer.end(), columns.begin(), columns.end() );
+    
+  m_Dimension = dimension;
+  m_NumberOfSections = numberOfSections;
+  m_EncodedPrecision = m_Precision;
+  
+  this->Modified();
+}
+
+
+void CompressedVesselCenterline::SetBuffer( const unsigned char * data, unsigned long size )
+{
+  const unsigned char *end = data + size;
+  vxl_int_64 dimension, numberOfSections;
+  
+  if( size < 2 || data[0] != CompressedVesselCenterlineVersion )
+    itkExceptionMacro( "Wrong compressed centerline." );
+    
+  const unsigned char *position = data + 2;
+  
+  if( !ReadInteger( position, end, dimension ) || !ReadInteger( position, end, numberOfSections ) ||
+    dimension < 1 || numberOfSections < 0 || numberOfSections > 0xffffffffLL || 
+    end - position < (long)sizeof(double) )
+  {
+    itkExceptionMacro( "Wrong compressed centerline." );
+  }
+  
+  m_Buffer.assign( data, end );
+  m_Dimension = dimension;
+  m_NumberOfSections = numberOfSections;
+  memcpy( &m_EncodedPrecision, position, sizeof(double) );
+  
+  this->Modified();
+}
+
+
+void CompressedVesselCenterline::Decode( double * centers, double * normals, double * radii, 
+  double * scales, double * arclengths ) const
+{
+  if( m_Buffer.empty() )
+    return;
+    
+  const unsigned char *position = &m_Buffer[0] + 2;
+  const unsigned char *end = &m_Buffer[0] + m_Buffer.size();
+  vxl_int_64 value, columnsSize;
+  
+  // Header, checked by SetBuffer() or written by Encode()
+  ReadInteger( position, end, value );
+  ReadInteger( position, end, value );
+  position += sizeof(double);
+  
+  if( !ReadInteger( position, end, columnsSize ) || columnsSize < 0 )
+    itkExceptionMacro( "Wrong compressed centerline." );
+    
+  BufferType columns;
+  
+  if( m_Buffer[1] & CompressedVesselCenterlineDeflated )
+  {
+    columns.resize( columnsSize );
+    uLongf size = columnsSize;
+    
+    if( columnsSize && ( uncompress( &columns[0], &size, position, end - position ) != Z_OK || 
+      size != (uLongf)columnsSize ) )
+    {
+      itkExceptionMacro( "Could not inflate the compressed centerline." );
+    }
+    
+    if( columnsSize )
+      position = &columns[0];
+    end = position + columnsSize;
+  }
+  else if( end - position != columnsSize )
+    itkExceptionMacro( "Wrong compressed centerline." );
+  
+  const unsigned int dimension = m_Dimension;
+  const unsigned int numberOfSections = m_NumberOfSections;
+  const double precision = m_EncodedPrecision;
+  
+  std::vector<vxl_int_64> previous( dimension, 0 );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    for( unsigned int d=0; d<dimension; ++d )
+    {
+      if( !ReadInteger( position, end, value ) )
+        itkExceptionMacro( "Wrong compressed centerline." );
+        
+      previous[d] += value;
+      centers[ i * dimension + d ] = previous[d] * precision;
+    }
+  }
+  
+  const unsigned int numberOfCodes = ( dimension == 3 ) ? 2 : dimension;
+  
+  if( end - position < (long)( numberOfSections * ( 2 * numberOfCodes + 4 ) ) )
+    itkExceptionMacro( "Wrong compressed centerline." );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    vxl_int_16 code[3];
+    
+    for( unsigned int c=0; c<numberOfCodes; ++c )
+    {
+      code[c] = (vxl_int_16)(vxl_uint_16)( position[0] | ( position[1] << 8 ) );
+      position += 2;
+    }
+    
+    if( dimension == 3 )
+      DecodeOctahedral( code, normals + i * dimension );
+    else
+    {
+      for( unsigned int d=0; d<dimension; ++d )
+        normals[ i * dimension + d ] = code[d] / 32767.0;
+    }
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i, position += 2 )
+    radii[i] = DecodeHalf( position[0] | ( position[1] << 8 ) );
+    
+  for( unsigned int i=0; i<numberOfSections; ++i, position += 2 )
+    scales[i] = DecodeHalf( position[0] | ( position[1] << 8 ) );
+    
+  vxl_int_64 previousArclength = 0;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    if( !ReadInteger( position, end, value ) )
+      itkExceptionMacro( "Wrong compressed centerline." );
+      
+    previousArclength += value;
+    arclengths[i] = previousArclength * precision;
+  }
+}
+
+
+vxl_uint_16 CompressedVesselCenterline::EncodeHalf( double value )
+{
+  const vxl_uint_16 sign = ( value < 0.0 ) ? 0x8000 : 0;
+  double magnitude = std::fabs( value );
+  
+  if( magnitude != magnitude )
+    return 0x7e00;
+  if( magnitude >= 65520.0 )
+    return sign | 0x7c00;
+  if( magnitude < 5.9604644775390625e-8 * 0.5 )
+    return sign;
+    
+  int exponent;
+  const double mantissa = std::frexp( magnitude, &exponent ); // magnitude = mantissa * 2^exponent
+  
+  if( exponent < -13 )
+  {
+    // Subnormal, in units of 2^-24
+    return sign | (vxl_uint_16)std::floor( magnitude * 16777216.0 + 0.5 );
+  }
+  
+  // 11 significant bits, rounded to nearest. Rounding may carry into the exponent
+  unsigned int significand = (unsigned int)std::floor( mantissa * 2048.0 + 0.5 );
+  
+  if( significand == 2048 )
+  {
+    significand = 1024;
+    ++exponent;
+  }
+  
+  if( exponent + 14 > 30 )
+    return sign | 0x7c00;
+    
+  return sign | (vxl_uint_16)( ( ( exponent + 14 ) << 10 ) | ( significand & 0x3ff ) );
+}
+
+
+double CompressedVesselCenterline::DecodeHalf( vxl_uint_16 half )
+{
+  const double sign = ( half & 0x8000 ) ? -1.0 : 1.0;
+  const int exponent = ( half >> 10 ) & 0x1f;
+  const int significand = half & 0x3ff;
+  
+  if( exponent == 0 )
+    return sign * std::ldexp( (double)significand, -24 );
+  if( exponent == 31 )
+    return significand ? std::sqrt( -1.0 ) : sign * HUGE_VAL;
+    
+  return sign * std::ldexp( (double)( significand | 0x400 ), exponent - 25 );
+}
+
+
+void CompressedVesselCenterline::EncodeOctahedral( const double * normal, vxl_int_16 * code )
+{
+  const double sum = std::fabs( normal[0] ) + std::fabs( normal[1] ) + std::fabs( normal[2] );
+  
+  if( sum == 0.0 )
+  {
+    code[0] = code[1] = CompressedVesselCenterlineZeroNormal;
+    return;
+  }
+  
+  double u = normal[0] / sum;
+  double v = normal[1] / sum;
+  
+  // The lower half is folded over the diagonals
+  if( normal[2] < 0.0 )
+  {
+    const double foldedU = ( 1.0 - std::fabs( v ) ) * ( u >= 0.0 ? 1.0 : -1.0 );
+    const double foldedV = ( 1.0 - std::fabs( u ) ) * ( v >= 0.0 ? 1.0 : -1.0 );
+    u = foldedU;
+    v = foldedV;
+  }
+  
+  code[0] = (vxl_int_16)Quantize( u * 32767.0, 1.0 );
+  code[1] = (vxl_int_16)Quantize( v * 32767.0, 1.0 );
+}
+
+
+void CompressedVesselCenterline::DecodeOctahedral( const vxl_int_16 * code, double * normal )
+{
+  if( code[0] == CompressedVesselCenterlineZeroNormal )
+  {
+    normal[0] = normal[1] = normal[2] = 0.0;
+    return;
+  }
+  
+  double x = code[0] / 32767.0;
+  double y = code[1] / 32767.0;
+  const double z = 1.0 - std::fabs( x ) - std::fabs( y );
+  
+  if( z < 0.0 )
+  {
+    const double unfoldedX = ( 1.0 - std::fabs( y ) ) * ( x >= 0.0 ? 1.0 : -1.0 );
+    const double unfoldedY = ( 1.0 - std::fabs( x ) ) * ( y >= 0.0 ? 1.0 : -1.0 );
+    x = unfoldedX;
+    y = unfoldedY;
+  }
+  
+  const double norm = std::sqrt( x * x + y * y + z * z );
+  
+  normal[0] = x / norm;
+  normal[1] = y / norm;
+  normal[2] = z / norm;
+}
+
+
+void CompressedVesselCenterline::WriteInteger( BufferType & buffer, vxl_int_64 value )
+{
+  vxl_uint_64 bits = ( (vxl_uint_64)value << 1 ) ^ (vxl_uint_64)( value >> 63 );
+  
+  while( bits >= 0x80 )
+  {
+    buffer.push_back( (unsigned char)( bits | 0x80 ) );
+    bits >>= 7;
+  }
+  
+  buffer.push_back( (unsigned char)bits );
+}
+
+
+bool CompressedVesselCenterline::ReadInteger( const unsigned char *& data, const unsigned char * end, 
+  vxl_int_64 & value )
+{
+  vxl_uint_64 bits = 0;
+  unsigned int shift = 0;
+  
+  while( data < end && shift < 64 )
+  {
+    const unsigned char byte = *data++;
+    bits |= (vxl_uint_64)( byte & 0x7f ) << shift;
+    
+    if( !( byte & 0x80 ) )
+    {
+      value = (vxl_int_64)( bits >> 1 ) ^ -(vxl_int_64)( bits & 1 );
+      return true;
+    }
+    
+    shift += 7;
+  }
+  
+  return false;
+}
+
+
+vxl_int_64 CompressedVesselCenterline::Quantize( double value, double precision )
+{
+  return (vxl_int_64)std::floor( value / precision + 0.5 );
+}
+
+
+void CompressedVesselCenterline::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Precision: " << m_Precision << std::endl;
+  os << indent << "Deflate: " << m_Deflate << std::endl;
+  os << indent << "Dimension: " << m_Dimension << std::endl;
+  os << indent << "NumberOfSections: " << m_NumberOfSections << std::endl;
+  os << indent << "EncodedPrecision: " << m_EncodedPrecision << std::endl;
+  os << indent << "BufferSize: " << m_Buffer.size() << std::endl;
+}
+
+} // end namespace ivan
@@ -0,0 +1,236 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCompressedVesselCenterline.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compact encoding of the sections of a vessel centerline.
+// Date: 2012/11/05
+
+#ifndef __ivanCompressedVesselCenterline_h
+#define __ivanCompressedVesselCenterline_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include "vxl_config.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class CompressedVesselCenterline
+ *  \brief Compact encoding of the sections of a centerline, for archival and transfer.
+ *
+ * The center, normal, radius, scale and arclength of the sections are stored in a byte 
+ * buffer, column by column:
+ *
+ * - Centers and arclengths are quantized to multiples of Precision, and the differences 
+ *   between consecutive sections are stored as variable length integers, which take one or 
+ *   two bytes per component for sections closer than a few hundred steps.
+ * - Normals of 3D sections are stored with the octahedral mapping in two 16 bit integers, 
+ *   and other normals as one 16 bit integer per component.
+ * - Radii and scales are stored as 16 bit floating point numbers, with a relative error 
+ *   below 0.05%.
+ *
+ * With Deflate on, the encoded columns are further compressed with zlib. A 3D section then 
+ * takes 10 to 16 bytes on smooth centerlines, instead of the 72 bytes of its doubles. The 
+ * buffer has a small header with the dimension, number of sections and precision, so it can 
+ * be written to a file and given back with SetBuffer().
+ *
+ * Curve and section metrics are not stored. Curve metrics can be computed again from the 
+ * decompressed centerline.
+ *
+ * \sa PackedVesselCenterline
+ * \ingroup 
+ */
+
+class ITK_EXPORT CompressedVesselCenterline : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef CompressedVesselCenterline        Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  typedef std::vector<unsigned char>        BufferType;
+     
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CompressedVesselCenterline, itk::Object );
+  
+  /** Quantization step of the centers and arclengths, used by the next Encode() or 
+    * Compress(). Default is 0.001, a micron for centerlines in millimetres. */
+  itkSetMacro( Precision, double );
+  itkGetConstMacro( Precision, double );
+  
+  /** Compress the encoded columns with zlib. Default is on. */
+  itkSetMacro( Deflate, bool );
+  itkGetConstMacro( Deflate, bool );
+  itkBooleanMacro( Deflate );
+  
+  unsigned int GetDimension() const
+    { return m_Dimension; }
+  unsigned int GetNumberOfSections() const
+    { return m_NumberOfSections; }
+    
+  /** Encoded data. */
+  const BufferType & GetBuffer() const
+    { return m_Buffer; }
+  unsigned long GetBufferSize() const
+    { return m_Buffer.size(); }
+    
+  /** Set data encoded by another centerline. Throws an exception if the header is wrong. */
+  void SetBuffer( const unsigned char * data, unsigned long size );
+  
+  /** Encode the sections given by columns. Centers and normals have dimension values per 
+    * section. */
+  void Encode( unsigned int dimension, unsigned int numberOfSections, const double * centers, 
+    const double * normals, const double * radii, const double * scales, const double * arclengths );
+    
+  /** Decode the sections into columns sized as those given to Encode(). Throws an exception 
+    * if the buffer is corrupt. */
+  void Decode( double * centers, double * normals, double * radii, double * scales, 
+    double * arclengths ) const;
+  
+  /** Encode the sections of a centerline. Works with VesselCenterline and 
+    * PackedVesselCenterline. */
+  template <class TCenterline>
+  void Compress( const TCenterline * centerline )
+    {
+      const unsigned int dimension = TCenterline::SectionType::Dimension;
+      const unsigned int numberOfSections = centerline->size();
+      
+      std::vector<double> centers( numberOfSections * dimension ), normals( centers.size() ),
+        radii( numberOfSections ), scales( numberOfSections ), arclengths( numberOfSections );
+      
+      for( unsigned int i=0; i<numberOfSections; ++i )
+      {
+        for( unsigned int d=0; d<dimension; ++d )
+        {
+          centers[ i * dimension + d ] = centerline->at(i)->GetCenter()[d];
+          normals[ i * dimension + d ] = centerline->at(i)->GetNormal()[d];
+        }
+        radii[i] = centerline->at(i)->GetRadius();
+        scales[i] = centerline->at(i)->GetScale();
+        arclengths[i] = centerline->at(i)->GetArclength();
+      }
+      
+      this->Encode( dimension, numberOfSections, numberOfSections ? &centers[0] : 0, 
+        numberOfSections ? &normals[0] : 0, numberOfSections ? &radii[0] : 0, 
+        numberOfSections ? &scales[0] : 0, numberOfSections ? &arclengths[0] : 0 );
+    }
+  
+  /** Decode the sections into a centerline of section objects, creating new sections. */
+  template <class TCenterline>
+  void Decompress( TCenterline * centerline ) const
+    {
+      typedef typename TCenterline::SectionType  SectionType;
+      const unsigned int dimension = SectionType::Dimension;
+      
+      if( m_NumberOfSections && m_Dimension != dimension )
+        itkExceptionMacro( "Sections of dimension " << m_Dimension << " cannot be decompressed "
+          "into sections of dimension " << dimension << "." );
+          
+      std::vector<double> centers( m_NumberOfSections * dimension + 1 ), normals( centers.size() ),
+        radii( m_NumberOfSections + 1 ), scales( radii.size() ), arclengths( radii.size() );
+      
+      this->Decode( &centers[0], &normals[0], &radii[0], &scales[0], &arclengths[0] );
+      
+      centerline->clear();
+      centerline->reserve( m_NumberOfSections );
+      
+      for( unsigned int i=0; i<m_NumberOfSections; ++i )
+      {
+        typename SectionType::PointType center;
+        typename SectionType::VectorType normal;
+        for( unsigned int d=0; d<dimension; ++d )
+        {
+          center[d] = centers[ i * dimension + d ];
+          normal[d] = normals[ i * dimension + d ];
+        }
+        
+        typename TCenterline::SectionPointer section = SectionType::New();
+        section->SetCenter( center );
+        section->SetNormal( normal );
+        section->SetRadius( radii[i] );
+        section->SetScale( scales[i] );
+        section->SetArclength( arclengths[i] );
+        centerline->push_back( section );
+      }
+      
+      centerline->Modified();
+    }
+    
+  /** Conversion of a value to a 16 bit floating point number and back. */
+  static vxl_uint_16 EncodeHalf( double value );
+  static double DecodeHalf( vxl_uint_16 half );
+  
+  /** Octahedral mapping of a 3D unit vector to two 16 bit integers and back. Zero vectors
+    * are kept. */
+  static void EncodeOctahedral( const double * normal, vxl_int_16 * code );
+  static void DecodeOctahedral( const vxl_int_16 * code, double * normal );
+    
+protected:
+  
+  CompressedVesselCenterline();
+  ~CompressedVesselCenterline() {}
+    
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Zigzag variable length encoding of signed integers. */
+  static void WriteInteger( BufferType & buffer, vxl_int_64 value );
+  static bool ReadInteger( const unsigned char *& data, const unsigned char * end, vxl_int_64 & value );
+  
+  static vxl_int_64 Quantize( double value, double precision );
+
+private:
+
+  CompressedVesselCenterline(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+  
+protected:
+
+  double          m_Precision;
+  bool            m_Deflate;
+  
+  /** Values of the encoded data. */
+  unsigned int    m_Dimension;
+  unsigned int    m_NumberOfSections;
+  double          m_EncodedPrecision;
+  
+  BufferType      m_Buffer;
+};
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,202 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanConcurrentVesselGraphBuilder.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: builds a vessel graph from nodes created by several threads.
+// Date: 2012/11/05
+
+
+#ifndef __ivanConcurrentVesselGraphBuilder_h
+#define __ivanConcurrentVesselGraphBuilder_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanAtomicCounter.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class ConcurrentVesselGraphBuilder
+ *  \brief Builds a VesselGraph from nodes created concurrently by several threads.
+ *
+ * The nodes of a VesselGraph are not thread-safe: AddChild() and AddParent() modify the link
+ * containers of both nodes, and a node index is updated on every link. Threads that add their
+ * branches to a shared graph need a global lock, or may corrupt it. This builder lets each 
+ * thread work on its own ThreadBuffer instead, where it appends its nodes together with the
+ * identifier of their parent, and the sections of the branch it is tracking. Nothing is 
+ * shared between buffers but the identifier counter, which is incremented atomically, so 
+ * threads never wait for each other. Commit() then links all the nodes in a single thread.
+ *
+ * Identifiers are allocated from 1, 0 being the root VesselNode created by Commit(). A node
+ * can only be given the identifier of an existing node as its parent, so parents have smaller
+ * identifiers than their children. Commit() links the nodes in identifier order, so the 
+ * children of a node are in the order their identifiers were allocated, and depth levels are
+ * right. Identifiers depend on the thread scheduling; callers that need reproducible ones
+ * should renumber the output.
+ *
+ * SetNumberOfThreads() creates the buffers and must be called before the threads start. Each
+ * buffer must only be used by one thread at a time. Nodes and centerlines added to a buffer
+ * belong to it until Commit(), and may be modified freely by its thread. After Commit() the 
+ * buffers are empty and the builder may be used again.
+ *
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT ConcurrentVesselGraphBuilder : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ConcurrentVesselGraphBuilder    Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  typedef typename CenterlineType::SectionType  SectionType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef typename VesselGraphType::Pointer     VesselGraphPointer;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  typedef typename BranchNodeType::Pointer      BranchNodePointer;
+  
+  typedef GraphNode::NodeIdentifier             NodeIdentifier;
+  
+  /** Node added to a buffer and the identifier of its parent. */
+  struct NodeRecord
+  {
+    GraphNode::Pointer  Node;
+    NodeIdentifier      ParentId;
+  };
+  
+  /** Nodes added by one thread. */
+  class ThreadBuffer
+  {
+  public:
+    
+    /** Add a node below the node with the given identifier, and give it a new identifier, 
+      * which is returned. */
+    NodeIdentifier AddNode( GraphNode * node, NodeIdentifier parentId );
+    
+    /** Add a new branch with an empty centerline, which becomes the current branch. */
+    BranchNodeType * AddBranch( NodeIdentifier parentId );
+    
+    /** Append a section to the centerline of the current branch. */
+    void AddSection( SectionType * section )
+      { m_CurrentCenterline->push_back( section ); }
+    
+    /** Current branch, the last one added with AddBranch(). */
+    BranchNodeType * GetCurrentBranch() const
+      { return m_CurrentBranch; }
+    
+    unsigned int GetNumberOfNodes() const
+      { return m_Nodes.size(); }
+    
+  private:
+    
+    friend class ConcurrentVesselGraphBuilder;
+    
+    ThreadBuffer() : m_Builder( 0 ), m_CurrentBranch( 0 ), m_CurrentCenterline( 0 ) {}
+    
+    ConcurrentVesselGraphBuilder  *m_Builder;
+    std::vector<NodeRecord>       m_Nodes;
+    BranchNodeType                *m_CurrentBranch;
+    CenterlineType                *m_CurrentCenterline;
+    
+    /** Keeps the buffers of different threads in different cache lines. */
+    char                          m_Padding[64];
+  };
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ConcurrentVesselGraphBuilder, itk::Object );
+  
+  /** Create one buffer per thread, discarding the nodes not committed. */
+  void SetNumberOfThreads( unsigned int numberOfThreads );
+  unsigned int GetNumberOfThreads() const
+    { return m_Buffers.size(); }
+  
+  /** Buffer of the given thread. */
+  ThreadBuffer * GetThreadBuffer( unsigned int threadId )
+    { return &m_Buffers[threadId]; }
+  
+  /** Allocate a new node identifier. May be called concurrently from any thread. */
+  NodeIdentifier AllocateNodeId()
+    { return static_cast<NodeIdentifier>( m_NextNodeId.FetchAndAdd( 1 ) ); }
+  
+  /** Number of identifiers allocated, plus one for the root. */
+  NodeIdentifier GetNumberOfNodeIds() const
+    { return static_cast<NodeIdentifier>( m_NextNodeId.GetValue() ); }
+  
+  /** Link the nodes of all the buffers into a new graph and empty the buffers. This must be
+    * called when no thread is adding nodes. Throws an exception if a parent is unknown. */
+  void Commit();
+  
+  /** Graph produced by the last call to Commit(). */
+  VesselGraphType * GetOutput()
+    { return m_Output; }
+		
+protected:
+
+  ConcurrentVesselGraphBuilder();
+  ~ConcurrentVesselGraphBuilder() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  ConcurrentVesselGraphBuilder(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  std::vector<ThreadBuffer>   m_Buffers;
+  
+  AtomicCounter               m_NextNodeId;
+  
+  VesselGraphPointer          m_Output;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanConcurrentVesselGraphBuilder.hxx"
+#endif
+
+#endif
@@ -0,0 +1,156 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanConcurrentVesselGraphBuilder.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: builds a vessel graph from nodes created by several threads.
+// Date: 2012/11/05
+
+#ifndef __ivanConcurrentVesselGraphBuilder_hxx
+#define __ivanConcurrentVesselGraphBuilder_hxx
+
+#include "ivanConcurrentVesselGraphBuilder.h"
+#include "ivanVesselNode.h"
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+ConcurrentVesselGraphBuilder<TCenterline>::ConcurrentVesselGraphBuilder() :
+  m_NextNodeId( 1 )
+{
+  this->SetNumberOfThreads( 1 );
+}
+
+
+template <class TCenterline>
+typename ConcurrentVesselGraphBuilder<TCenterline>::NodeIdentifier
+ConcurrentVesselGraphBuilder<TCenterline>::ThreadBuffer::AddNode( GraphNode * node, NodeIdentifier parentId )
+{
+  NodeRecord record;
+  record.Node = node;
+  record.ParentId = parentId;
+  
+  const NodeIdentifier nodeId = m_Builder->AllocateNodeId();
+  node->SetNodeId( nodeId );
+  
+  m_Nodes.push_back( record );
+  
+  return nodeId;
+}
+
+
+template <class TCenterline>
+typename ConcurrentVesselGraphBuilder<TCenterline>::BranchNodeType *
+ConcurrentVesselGraphBuilder<TCenterline>::ThreadBuffer::AddBranch( NodeIdentifier parentId )
+{
+  BranchNodePointer branch = BranchNodeType::New();
+  
+  this->AddNode( branch, parentId );
+  
+  m_CurrentBranch = branch;
+  m_CurrentCenterline = branch->GetCenterline();
+  
+  return branch;
+}
+
+
+template <class TCenterline>
+void ConcurrentVesselGraphBuilder<TCenterline>::SetNumberOfThreads( unsigned int numberOfThreads )
+{
+  m_Buffers.assign( std::max( numberOfThreads, 1u ), ThreadBuffer() );
+  
+  for( unsigned int i=0; i < m_Buffers.size(); ++i )
+    m_Buffers[i].m_Builder = this;
+    
+  m_NextNodeId.SetValue( 1 );
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void ConcurrentVesselGraphBuilder<TCenterline>::Commit()
+{
+  const NodeIdentifier numberOfNodeIds = this->GetNumberOfNodeIds();
+  
+  // Nodes by identifier. Identifiers allocated but not given to a node are left empty
+  
+  std::vector<GraphNode::Pointer> nodes( numberOfNodeIds );
+  std::vector<NodeIdentifier> parentIds( numberOfNodeIds, 0 );
+  
+  VesselNode::Pointer rootNode = VesselNode::New();
+  rootNode->SetNodeId( 0 );
+  nodes[0] = rootNode.GetPointer();
+  
+  for( unsigned int i=0; i < m_Buffers.size(); ++i )
+  {
+    const std::vector<NodeRecord> & records = m_Buffers[i].m_Nodes;
+    
+    for( unsigned int j=0; j < records.size(); ++j )
+    {
+      const NodeIdentifier nodeId = records[j].Node->GetNodeId();
+      nodes[nodeId] = records[j].Node;
+      parentIds[nodeId] = records[j].ParentId;
+    }
+  }
+  
+  for( NodeIdentifier nodeId = 1; nodeId < numberOfNodeIds; ++nodeId )
+  {
+    if( nodes[nodeId].IsNull() )
+      continue;
+      
+    const NodeIdentifier parentId = parentIds[nodeId];
+    
+    if( parentId >= nodeId || nodes[parentId].IsNull() )
+    {
+      this->SetNumberOfThreads( m_Buffers.size() );
+      itkExceptionMacro( "Node " << nodeId << " has an unknown parent " << parentId << "." );
+    }
+    
+    nodes[parentId]->AddChild( nodes[nodeId] );
+  }
+  
+  // The node index, if any, is built once for the whole graph
+  
+  m_Output = VesselGraphType::New();
+  m_Output->SetRootNode( rootNode );
+  
+  this->SetNumberOfThreads( m_Buffers.size() );
+}
+
+
+template <class TCenterline>
+void ConcurrentVesselGraphBuilder<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfThreads: " << m_Buffers.size() << std::endl;
+  os << indent << "NumberOfNodeIds: " << this->GetNumberOfNodeIds() << std::endl;
+  os << indent << "Output: " << m_Output.GetPointer() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanConcurrentVesselGraphBuilder_hxx
@@ -0,0 +1,255 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraph.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compact read-only snapshot of a vessel graph
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraph_h
+#define __ivanFrozenVesselGraph_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkNumericTraits.h"
+
+#include <vector>
+#include <string>
+#include <utility>
+
+
+namespace ivan
+{
+  
+/** \class FrozenVesselGraph
+ *  \brief Read-only compact snapshot of a VesselGraph.
+ *
+ * FrozenVesselGraph stores the nodes reachable from the root of a VesselGraph in contiguous 
+ * arrays, in depth-first order, with the root at index 0. Node identifiers, node type 
+ * identifiers, masks, depth levels and names are stored per node. Children and parents are 
+ * stored in compressed sparse row form, as offsets into an array of node indices, and the 
+ * sections of all the branches in a single array, also indexed by offsets per node. Nodes 
+ * reachable through several parents are stored once.
+ *
+ * Read-only algorithms such as counting, searching by identifier or computing branch metrics 
+ * run on the arrays without touching the nodes, so they avoid pointer chasing and reference 
+ * counting. The sections are shared with the original graph, not copied.
+ *
+ * The sections of a branch are taken from its centerline at the given LevelOfDetail, so a 
+ * coarse snapshot can be frozen for display once VesselGraphCenterlineSimplifier has been run.
+ *
+ * Thaw() builds a new VesselGraph from the snapshot. Nodes are created from the classes of the 
+ * frozen nodes, and branches get new centerlines with the shared sections. Other data specific 
+ * to a node class is not kept. The parents of a node are ordered by their index.
+ *
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT FrozenVesselGraph : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef FrozenVesselGraph               Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  
+  typedef typename CenterlineType::SectionType  SectionType;
+  typedef typename SectionType::Pointer         SectionPointer;
+  typedef typename SectionType::CenterPointType CenterPointType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  
+  typedef GraphNode::NodeIdentifier             NodeIdentifier;
+  typedef GraphNode::NodeMaskType               NodeMaskType;
+  typedef GraphNode::NodeTypeIdentifier         NodeTypeIdentifier;
+  
+  /** Index of a node in the arrays. */
+  typedef unsigned int                          NodeIndex;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrozenVesselGraph, itk::Object );
+  
+  /** Index returned when a node is not found. */
+  static NodeIndex GetNullNodeIndex()
+    { return itk::NumericTraits<NodeIndex>::max(); }
+  
+  /** Set/Get the level of detail of the centerlines of the branches that are frozen. Default 
+    * is 0, the full resolution centerlines. 
+    * \sa VesselBranchNode::GetLevelOfDetailCenterline() */
+  itkSetMacro( LevelOfDetail, unsigned int );
+  itkGetConstMacro( LevelOfDetail, unsigned int );
+  
+  /** Build the snapshot from the given graph. */
+  void Freeze( const VesselGraphType * graph );
+  
+  /** Build a new graph from the snapshot. */
+  typename VesselGraphType::Pointer Thaw() const;
+  
+  /** Remove all the nodes. */
+  void Clear();
+  
+  unsigned int GetNumberOfNodes() const
+    { return m_NodeIds.size(); }
+    
+  NodeIdentifier GetNodeId( NodeIndex node ) const
+    { return m_NodeIds[node]; }
+  NodeTypeIdentifier GetNodeTypeId( NodeIndex node ) const
+    { return m_NodeTypeIds[node]; }
+  NodeMaskType GetMask( NodeIndex node ) const
+    { return m_Masks[node]; }
+  int GetDepthLevel( NodeIndex node ) const
+    { return m_DepthLevels[node]; }
+  const std::string & GetName( NodeIndex node ) const
+    { return m_Names[node]; }
+    
+  unsigned int GetNumberOfChildren( NodeIndex node ) const
+    { return m_ChildOffsets[node+1] - m_ChildOffsets[node]; }
+  NodeIndex GetChild( NodeIndex node, unsigned int pos ) const
+    { return m_Children[ m_ChildOffsets[node] + pos ]; }
+    
+  unsigned int GetNumberOfParents( NodeIndex node ) const
+    { return m_ParentOffsets[node+1] - m_ParentOffsets[node]; }
+  NodeIndex GetParent( NodeIndex node, unsigned int pos ) const
+    { return m_Parents[ m_ParentOffsets[node] + pos ]; }
+    
+  /** An empty node of the given type, created from a node of the frozen graph, or NULL if there 
+    * are none. */
+  const GraphNode * GetNodePrototype( NodeTypeIdentifier nodeTypeId ) const
+    { return nodeTypeId < m_NodePrototypes.size() ? m_NodePrototypes[nodeTypeId].GetPointer() : 0; }
+    
+  /** Returns true if the node is a branch with a centerline. */
+  bool IsBranch( NodeIndex node ) const
+    { return m_IsBranch[node]; }
+    
+  /** Sections of the branches. Other nodes have no sections. */
+  unsigned int GetNumberOfSections( NodeIndex node ) const
+    { return m_SectionOffsets[node+1] - m_SectionOffsets[node]; }
+  const SectionType * GetSection( NodeIndex node, unsigned int pos ) const
+    { return m_Sections[ m_SectionOffsets[node] + pos ]; }
+  const CenterPointType & GetSectionCenter( NodeIndex node, unsigned int pos ) const
+    { return m_SectionCenters[ m_SectionOffsets[node] + pos ]; }
+    
+  /** Index of the first section of a node in the array of all the sections, so algorithms 
+    * can keep their results per section in arrays of GetTotalNumberOfSections() elements. */
+  unsigned long GetSectionOffset( NodeIndex node ) const
+    { return m_SectionOffsets[node]; }
+    
+  /** Writable access to a section, to store results computed on the arrays. The sections 
+    * are shared with the original graph, which is modified too. */
+  SectionType * GetWritableSection( NodeIndex node, unsigned int pos )
+    { return m_Sections[ m_SectionOffsets[node] + pos ]; }
+  
+  /** Total number of sections of all the branches. */
+  unsigned long GetTotalNumberOfSections() const
+    { return m_Sections.size(); }
+    
+  /** Get the first node with the given identifier in depth-first order, or the null index. */
+  NodeIndex FindNodeById( NodeIdentifier id ) const;
+  
+  /** Count the nodes of the given type whose mask matches the given mask. */
+  unsigned int CountNodes( NodeTypeIdentifier nodeTypeId, 
+    NodeMaskType mask = itk::NumericTraits<NodeMaskType>::max() ) const;
+    
+  /** Length of the polyline joining the section centers of a branch. */
+  double ComputeBranchLength( NodeIndex node ) const;
+		
+protected:
+
+  FrozenVesselGraph() : m_LevelOfDetail(0) {}
+  ~FrozenVesselGraph() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  FrozenVesselGraph(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  unsigned int                      m_LevelOfDetail;
+  
+  /** Per node arrays. */
+  std::vector<NodeIdentifier>       m_NodeIds;
+  std::vector<NodeTypeIdentifier>   m_NodeTypeIds;
+  std::vector<NodeMaskType>         m_Masks;
+  std::vector<int>                  m_DepthLevels;
+  std::vector<std::string>          m_Names;
+  std::vector<bool>                 m_IsBranch;
+  
+  /** Children and parents in compressed sparse row form. */
+  std::vector<unsigned int>         m_ChildOffsets;
+  std::vector<NodeIndex>            m_Children;
+  std::vector<unsigned int>         m_ParentOffsets;
+  std::vector<NodeIndex>            m_Parents;
+  
+  /** Sections of all the branches. */
+  std::vector<unsigned long>        m_SectionOffsets;
+  std::vector<SectionPointer>       m_Sections;
+  std::vector<CenterPointType>      m_SectionCenters;
+  
+  /** Pairs of node identifier and index sorted by identifier, for searching. */
+  std::vector< std::pair<NodeIdentifier,NodeIndex> >   m_SortedNodeIds;
+  
+  /** An empty node of every frozen node type, used to create the nodes when thawing. */
+  std::vector<GraphNode::ConstPointer>  m_NodePrototypes;
+};
+
+
+/** Order branches of a frozen graph by decreasing number of sections, used to schedule the 
+  * longest branches first when they are distributed among threads. */
+template <class TFrozenGraph>
+struct FrozenBranchLongerThan
+{
+  FrozenBranchLongerThan( const TFrozenGraph *graph ) : Graph( graph ) {}
+  
+  bool operator()( typename TFrozenGraph::NodeIndex a, typename TFrozenGraph::NodeIndex b ) const
+    { return Graph->GetNumberOfSections( a ) > Graph->GetNumberOfSections( b ); }
+  
+  const TFrozenGraph *Graph;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanFrozenVesselGraph.hxx"
+#endif
+
+#endif
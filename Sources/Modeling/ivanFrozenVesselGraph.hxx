@@ -0,0 +1,320 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraph.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compact read-only snapshot of a vessel graph
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraph_hxx
+#define __ivanFrozenVesselGraph_hxx
+
+#include "ivanFrozenVesselGraph.h"
+
+#include <algorithm>
+#include <map>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+void FrozenVesselGraph<TCenterline>::Clear()
+{
+  m_NodeIds.clear();
+  m_NodeTypeIds.clear();
+  m_Masks.clear();
+  m_DepthLevels.clear();
+  m_Names.clear();
+  m_IsBranch.clear();
+  m_ChildOffsets.clear();
+  m_Children.clear();
+  m_ParentOffsets.clear();
+  m_Parents.clear();
+  m_SectionOffsets.clear();
+  m_Sections.clear();
+  m_SectionCenters.clear();
+  m_SortedNodeIds.clear();
+  m_NodePrototypes.clear();
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraph<TCenterline>::Freeze( const VesselGraphType *graph )
+{
+  this->Clear();
+  
+  m_ChildOffsets.push_back( 0 );
+  m_SectionOffsets.push_back( 0 );
+  
+  if( !graph || graph->GetRootNode().IsNull() )
+    return;
+    
+  // Assign indices in depth-first preorder. Nodes with several parents are only taken once
+  typedef std::map<const GraphNode*,NodeIndex>  IndexMapType;
+  
+  IndexMapType nodeIndices;
+  std::vector<const GraphNode*> nodes;
+  std::vector<const GraphNode*> pendingNodes;
+  
+  pendingNodes.push_back( graph->GetRootNode().GetPointer() );
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !nodeIndices.insert( std::make_pair( node, (NodeIndex)nodes.size() ) ).second )
+      continue;
+      
+    nodes.push_back( node );
+    
+    // Push in reverse so the first child is taken first
+    for( unsigned int i = node->GetNumberOfChildren(); i > 0; --i )
+    {
+      const GraphNode *child = node->GetChild( i-1 );
+      if( child && nodeIndices.find( child ) == nodeIndices.end() )
+        pendingNodes.push_back( child );
+    }
+  }
+  
+  const unsigned int numberOfNodes = nodes.size();
+  
+  m_NodeIds.reserve( numberOfNodes );
+  m_NodeTypeIds.reserve( numberOfNodes );
+  m_Masks.reserve( numberOfNodes );
+  m_DepthLevels.reserve( numberOfNodes );
+  m_Names.reserve( numberOfNodes );
+  m_IsBranch.reserve( numberOfNodes );
+  m_ChildOffsets.reserve( numberOfNodes + 1 );
+  m_SectionOffsets.reserve( numberOfNodes + 1 );
+  m_SortedNodeIds.reserve( numberOfNodes );
+  
+  std::vector<unsigned int> numberOfParents( numberOfNodes, 0 );
+  
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+  {
+    const GraphNode *node = nodes[n];
+    const NodeTypeIdentifier nodeTypeId = node->GetNodeTypeId();
+    
+    m_NodeIds.push_back( node->GetNodeId() );
+    m_NodeTypeIds.push_back( nodeTypeId );
+    m_Masks.push_back( node->GetMask() );
+    m_DepthLevels.push_back( node->GetDepthLevel() );
+    m_Names.push_back( node->GetName() );
+    m_SortedNodeIds.push_back( std::make_pair( node->GetNodeId(), n ) );
+    
+    if( nodeTypeId >= m_NodePrototypes.size() )
+      m_NodePrototypes.resize( nodeTypeId + 1 );
+    if( m_NodePrototypes[nodeTypeId].IsNull() )
+    {
+      // An empty node of the same type, so the frozen graph does not keep the frozen nodes, 
+      // and their links and centerlines, alive
+      itk::LightObject::Pointer prototype = node->CreateAnother();
+      m_NodePrototypes[nodeTypeId] = dynamic_cast<const GraphNode*>( prototype.GetPointer() );
+      
+      if( m_NodePrototypes[nodeTypeId].IsNull() )
+        itkExceptionMacro( "Could not create node of type " << nodeTypeId << "." );
+    }
+    
+    for( unsigned int i = 0; i < node->GetNumberOfChildren(); ++i )
+    {
+      const GraphNode *child = node->GetChild( i );
+      if( !child )
+        continue;
+        
+      const NodeIndex childIndex = nodeIndices[child];
+      m_Children.push_back( childIndex );
+      ++numberOfParents[childIndex];
+    }
+    m_ChildOffsets.push_back( m_Children.size() );
+    
+    const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+    const bool isBranch = branch && branch->GetCenterline().IsNotNull();
+    
+    m_IsBranch.push_back( isBranch );
+    
+    if( isBranch )
+    {
+      typename CenterlineType::ConstPointer centerline = 
+        branch->GetLevelOfDetailCenterline( m_LevelOfDetail );
+      for( unsigned int i = 0; i < centerline->size(); ++i )
+      {
+        SectionPointer section = centerline->at(i);
+        m_Sections.push_back( section );
+        m_SectionCenters.push_back( section->GetCenter() );
+      }
+    }
+    m_SectionOffsets.push_back( m_Sections.size() );
+  }
+  
+  // Build the parents from the children. Parents are visited in index order, so each list 
+  // is sorted by parent index
+  m_ParentOffsets.resize( numberOfNodes + 1 );
+  m_ParentOffsets[0] = 0;
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+    m_ParentOffsets[n+1] = m_ParentOffsets[n] + numberOfParents[n];
+    
+  m_Parents.resize( m_Children.size() );
+  std::vector<unsigned int> nextParent( m_ParentOffsets.begin(), m_ParentOffsets.end() - 1 );
+  
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+  {
+    for( unsigned int c = m_ChildOffsets[n]; c < m_ChildOffsets[n+1]; ++c )
+      m_Parents[ nextParent[ m_Children[c] ]++ ] = n;
+  }
+  
+  // Stable sort so the first node in preorder is found for repeated identifiers
+  std::stable_sort( m_SortedNodeIds.begin(), m_SortedNodeIds.end() );
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+typename FrozenVesselGraph<TCenterline>::VesselGraphType::Pointer 
+FrozenVesselGraph<TCenterline>::Thaw() const
+{
+  typename VesselGraphType::Pointer graph = VesselGraphType::New();
+  
+  const unsigned int numberOfNodes = this->GetNumberOfNodes();
+  
+  if( !numberOfNodes )
+    return graph;
+    
+  std::vector<GraphNode::Pointer> nodes( numberOfNodes );
+  
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+  {
+    itk::LightObject::Pointer object = m_NodePrototypes[ m_NodeTypeIds[n] ]->CreateAnother();
+    GraphNode *node = dynamic_cast<GraphNode*>( object.GetPointer() );
+    
+    if( !node )
+      itkExceptionMacro( "Could not create node of type " << m_NodeTypeIds[n] << "." );
+      
+    node->SetNodeId( m_NodeIds[n] );
+    node->SetMask( m_Masks[n] );
+    
+    std::string name = m_Names[n];
+    node->SetName( name );
+    
+    if( m_IsBranch[n] )
+    {
+      BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+      
+      if( branch )
+      {
+        CenterlinePointer centerline = CenterlineType::New();
+        centerline->reserve( this->GetNumberOfSections( n ) );
+        for( unsigned long s = m_SectionOffsets[n]; s < m_SectionOffsets[n+1]; ++s )
+          centerline->push_back( m_Sections[s] );
+        branch->SetCenterline( centerline );
+      }
+    }
+    
+    nodes[n] = node;
+  }
+  
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+  {
+    for( unsigned int c = m_ChildOffsets[n]; c < m_ChildOffsets[n+1]; ++c )
+      nodes[n]->AddChild( nodes[ m_Children[c] ] );
+  }
+  
+  // AddChild() overwrites the depth level, so restore it once all the nodes are linked
+  for( NodeIndex n = 0; n < numberOfNodes; ++n )
+    nodes[n]->SetDepthLevel( m_DepthLevels[n] );
+    
+  VesselNode *root = dynamic_cast<VesselNode*>( nodes[0].GetPointer() );
+  
+  if( !root )
+    itkExceptionMacro( "Root node is not a vessel node." );
+    
+  graph->SetRootNode( root );
+  
+  return graph;
+}
+
+
+template <class TCenterline>
+typename FrozenVesselGraph<TCenterline>::NodeIndex 
+FrozenVesselGraph<TCenterline>::FindNodeById( NodeIdentifier id ) const
+{
+  typedef typename std::vector< std::pair<NodeIdentifier,NodeIndex> >::const_iterator  IteratorType;
+  
+  IteratorType it = std::lower_bound( m_SortedNodeIds.begin(), m_SortedNodeIds.end(),
+    std::make_pair( id, (NodeIndex)0 ) );
+    
+  if( it == m_SortedNodeIds.end() || it->first != id )
+    return GetNullNodeIndex();
+    
+  return it->second;
+}
+
+
+template <class TCenterline>
+unsigned int FrozenVesselGraph<TCenterline>::CountNodes( NodeTypeIdentifier nodeTypeId, 
+  NodeMaskType mask ) const
+{
+  unsigned int count = 0;
+  
+  for( NodeIndex n = 0; n < m_NodeTypeIds.size(); ++n )
+  {
+    if( m_NodeTypeIds[n] == nodeTypeId && ( m_Masks[n] & mask ) )
+      ++count;
+  }
+  
+  return count;
+}
+
+
+template <class TCenterline>
+double FrozenVesselGraph<TCenterline>::ComputeBranchLength( NodeIndex node ) const
+{
+  double length = 0.0;
+  
+  for( unsigned long s = m_SectionOffsets[node] + 1; s < m_SectionOffsets[node+1]; ++s )
+    length += m_SectionCenters[s].EuclideanDistanceTo( m_SectionCenters[s-1] );
+    
+  return length;
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraph<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "LevelOfDetail: " << m_LevelOfDetail << std::endl;
+  os << indent << "NumberOfNodes: " << this->GetNumberOfNodes() << std::endl;
+  os << indent << "NumberOfLinks: " << m_Children.size() << std::endl;
+  os << indent << "TotalNumberOfSections: " << this->GetTotalNumberOfSections() << std::endl;
+  os << indent << "NumberOfNodeTypes: " << m_NodePrototypes.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
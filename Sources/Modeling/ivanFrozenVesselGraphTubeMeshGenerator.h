@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphTubeMeshGenerator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: generates indexed triangle strip tube meshes for the branches of a frozen vessel graph
+// Date: 2012/11/05
+
+
+#ifndef __ivanFrozenVesselGraphTubeMeshGenerator_h
+#define __ivanFrozenVesselGraphTubeMeshGenerator_h
+
+#include "ivanFrozenVesselGraph.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class FrozenVesselGraphTubeMeshGenerator
+ *  \brief Generates a tube mesh around every branch of a FrozenVesselGraph.
+ *
+ * For every section a ring of NumberOfContourPoints vertices is placed on the plane given by 
+ * the section center and normal, at the section radius. The ring frame is propagated from 
+ * section to section by projecting the previous one on the new plane, so the tube does not 
+ * twist. If a section has no normal, the direction between its neighbour centers is used.
+ * The NumberOfContourPoints controls the level of detail.
+ *
+ * Consecutive rings are joined with a triangle strip of 2 * ( NumberOfContourPoints + 1 ) 
+ * indices, and strips are separated by the RestartIndex, so the whole mesh can be drawn with a 
+ * single indexed draw call using primitive restart. Vertices, vertex normals and indices are 
+ * stored in flat arrays ready to be uploaded as vertex and index buffers. The ranges of every 
+ * branch are known before meshing, so branches are meshed in parallel, longest first, and 
+ * every thread writes its own ranges.
+ *
+ * Subclasses can override GetContourRadius() to follow a radial contour instead of the 
+ * circular radius of the sections. The section type must provide GetCenter(), GetNormal() 
+ * and GetRadius(), as CircularVesselSection does, and be 3D.
+ *
+ * \ingroup 
+ */
+
+template <class TCenterline>
+class ITK_EXPORT FrozenVesselGraphTubeMeshGenerator : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef FrozenVesselGraphTubeMeshGenerator  Self;
+  typedef itk::Object                         Superclass;
+  typedef itk::SmartPointer<Self>             Pointer;
+  typedef itk::SmartPointer<const Self>       ConstPointer;
+ 
+  typedef TCenterline                              CenterlineType;
+  typedef FrozenVesselGraph<CenterlineType>        FrozenGraphType;
+  typedef typename FrozenGraphType::Pointer        FrozenGraphPointer;
+  typedef typename FrozenGraphType::NodeIndex      NodeIndex;
+  typedef typename FrozenGraphType::SectionType    SectionType;
+  
+  typedef float           CoordinateType;
+  typedef unsigned int    IndexType;
+  
+  typedef std::vector<CoordinateType>   CoordinateContainerType;
+  typedef std::vector<IndexType>        IndexContainerType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrozenVesselGraphTubeMeshGenerator, itk::Object );
+  
+  /** Set/Get the frozen graph. */
+  void SetFrozenGraph( FrozenGraphType *graph )
+    { m_FrozenGraph = graph; this->Modified(); }
+  FrozenGraphType * GetFrozenGraph()
+    { return m_FrozenGraph; }
+  
+  /** Set/Get the number of vertices of every ring. Default is 16. */
+  itkSetClampMacro( NumberOfContourPoints, unsigned int, 3, 1024 );
+  itkGetConstMacro( NumberOfContourPoints, unsigned int );
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Index separating the triangle strips. */
+  static IndexType GetRestartIndex()
+    { return itk::NumericTraits<IndexType>::max(); }
+  
+  /** Generate the mesh of all the branches. */
+  void Generate();
+  
+  /** Vertex coordinates and normals, three per vertex. */
+  const CoordinateContainerType & GetVertices() const
+    { return m_Vertices; }
+  const CoordinateContainerType & GetNormals() const
+    { return m_Normals; }
+  
+  /** Triangle strip indices of all the branches, separated by the restart index. */
+  const IndexContainerType & GetIndices() const
+    { return m_Indices; }
+  
+  unsigned long GetNumberOfVertices() const
+    { return m_Vertices.size() / 3; }
+  
+  /** First vertex and index of a branch, and number of them. Nodes that are not branches 
+    * have no vertices. */
+  unsigned long GetVertexOffset( NodeIndex node ) const
+    { return m_VertexOffsets[node]; }
+  unsigned long GetNumberOfVertices( NodeIndex node ) const
+    { return m_VertexOffsets[node+1] - m_VertexOffsets[node]; }
+  unsigned long GetIndexOffset( NodeIndex node ) const
+    { return m_IndexOffsets[node]; }
+  unsigned long GetNumberOfIndices( NodeIndex node ) const
+    { return m_IndexOffsets[node+1] - m_IndexOffsets[node]; }
+		
+protected:
+
+  FrozenVesselGraphTubeMeshGenerator();
+  ~FrozenVesselGraphTubeMeshGenerator() {}
+  
+  /** Radius of the contour point at the given angle. By default the section radius. */
+  virtual double GetContourRadius( const SectionType *section, unsigned int point, double angle ) const
+    { return section->GetRadius(); }
+  
+  /** Mesh a branch into its ranges of the arrays. */
+  void GenerateBranch( NodeIndex node );
+  
+  /** Mesh the branches taken from the shared counter until there are no more. */
+  void ThreadedGenerate();
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE GenerateThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  FrozenVesselGraphTubeMeshGenerator(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  FrozenGraphPointer              m_FrozenGraph;
+  
+  unsigned int                    m_NumberOfContourPoints;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  std::vector<NodeIndex>          m_Branches;
+  unsigned int                    m_NextBranch;
+  itk::SimpleFastMutexLock        m_BranchMutex;
+  
+  /** Unit circle, shared by all the rings. */
+  std::vector<double>             m_Cosines;
+  std::vector<double>             m_Sines;
+  
+  CoordinateContainerType         m_Vertices;
+  CoordinateContainerType         m_Normals;
+  IndexContainerType              m_Indices;
+  
+  std::vector<unsigned long>      m_VertexOffsets;
+  std::vector<unsigned long>      m_IndexOffsets;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanFrozenVesselGraphTubeMeshGenerator.hxx"
+#endif
+
+#endif
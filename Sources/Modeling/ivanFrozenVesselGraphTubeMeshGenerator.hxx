@@ -0,0 +1,286 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphTubeMeshGenerator.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: generates indexed triangle strip tube meshes for the branches of a frozen vessel graph
+// Date: 2012/11/05
+
+
+#ifndef __ivanFrozenVesselGraphTubeMeshGenerator_hxx
+#define __ivanFrozenVesselGraphTubeMeshGenerator_hxx
+
+#include "ivanFrozenVesselGraphTubeMeshGenerator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+FrozenVesselGraphTubeMeshGenerator<TCenterline>::FrozenVesselGraphTubeMeshGenerator() :
+  m_NumberOfContourPoints( 16 ),
+  m_NextBranch( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphTubeMeshGenerator<TCenterline>::Generate()
+{
+  if( m_FrozenGraph.IsNull() )
+    itkExceptionMacro( "Frozen graph not set." );
+    
+  if( SectionType::Dimension != 3 )
+    itkExceptionMacro( "Tube meshes can only be generated for 3D sections." );
+  
+  const unsigned int numberOfNodes = m_FrozenGraph->GetNumberOfNodes();
+  const unsigned int ringSize = m_NumberOfContourPoints;
+  const unsigned int stripSize = 2 * ( ringSize + 1 ) + 1; // including the restart index
+  
+  m_Cosines.resize( ringSize );
+  m_Sines.resize( ringSize );
+  
+  for( unsigned int k=0; k<ringSize; ++k )
+  {
+    const double angle = 2.0 * vnl_math::pi * k / ringSize;
+    m_Cosines[k] = std::cos( angle );
+    m_Sines[k] = std::sin( angle );
+  }
+  
+  // Ranges of every branch, known in advance so branches can be meshed in any order
+  m_VertexOffsets.assign( numberOfNodes + 1, 0 );
+  m_IndexOffsets.assign( numberOfNodes + 1, 0 );
+  m_Branches.clear();
+  
+  for( NodeIndex n=0; n<numberOfNodes; ++n )
+  {
+    unsigned long numberOfSections = 0;
+    
+    if( m_FrozenGraph->IsBranch( n ) )
+      numberOfSections = m_FrozenGraph->GetNumberOfSections( n );
+      
+    // A single section gives no tube
+    if( numberOfSections < 2 )
+      numberOfSections = 0;
+    else
+      m_Branches.push_back( n );
+    
+    m_VertexOffsets[n+1] = m_VertexOffsets[n] + numberOfSections * ringSize;
+    m_IndexOffsets[n+1] = m_IndexOffsets[n] + 
+      ( numberOfSections ? ( numberOfSections - 1 ) * stripSize : 0 );
+  }
+  
+  m_Vertices.resize( 3 * m_VertexOffsets[numberOfNodes] );
+  m_Normals.resize( 3 * m_VertexOffsets[numberOfNodes] );
+  m_Indices.resize( m_IndexOffsets[numberOfNodes] );
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), 
+    FrozenBranchLongerThan<FrozenGraphType>( m_FrozenGraph ) );
+  
+  m_NextBranch = 0;
+  
+  if( m_Branches.size() > 1 )
+  {
+    m_Threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, (int)m_Branches.size() ) );
+    m_Threader->SetSingleMethod( this->GenerateThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedGenerate();
+  }
+  
+  m_Branches.clear();
+}
+
+
+template <class TCenterline>
+ITK_THREAD_RETURN_TYPE
+FrozenVesselGraphTubeMeshGenerator<TCenterline>::GenerateThreaderCallback( void *arg )
+{
+  Self *generator = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  generator->ThreadedGenerate();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphTubeMeshGenerator<TCenterline>::ThreadedGenerate()
+{
+  NodeIndex node;
+  bool found;
+  
+  while( true )
+  {
+    m_BranchMutex.Lock();
+    found = ( m_NextBranch < m_Branches.size() );
+    if( found )
+      node = m_Branches[ m_NextBranch++ ];
+    m_BranchMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    this->GenerateBranch( node );
+  }
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphTubeMeshGenerator<TCenterline>::GenerateBranch( NodeIndex node )
+{
+  const unsigned int size = m_FrozenGraph->GetNumberOfSections( node );
+  const unsigned int ringSize = m_NumberOfContourPoints;
+  
+  const unsigned long vertexOffset = m_VertexOffsets[node];
+  CoordinateType *vertices = &m_Vertices[ 3 * vertexOffset ];
+  CoordinateType *normals = &m_Normals[ 3 * vertexOffset ];
+  
+  double u[3] = { 0.0, 0.0, 0.0 }; // ring frame, propagated along the branch
+  double v[3];
+  
+  for( unsigned int i=0; i<size; ++i )
+  {
+    const SectionType *section = m_FrozenGraph->GetSection( node, i );
+    const typename FrozenGraphType::CenterPointType & center = m_FrozenGraph->GetSectionCenter( node, i );
+    
+    // Plane normal, or the direction between the neighbour centers if there is none
+    double n[3];
+    for( unsigned int d=0; d<3; ++d )
+      n[d] = section->GetNormal()[d];
+    
+    double norm = std::sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    
+    if( norm < 1e-12 )
+    {
+      const typename FrozenGraphType::CenterPointType & next = 
+        m_FrozenGraph->GetSectionCenter( node, vnl_math_min( i + 1, size - 1 ) );
+      const typename FrozenGraphType::CenterPointType & previous = 
+        m_FrozenGraph->GetSectionCenter( node, i > 0 ? i - 1 : 0 );
+      
+      for( unsigned int d=0; d<3; ++d )
+        n[d] = next[d] - previous[d];
+        
+      norm = std::sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    }
+    
+    if( norm < 1e-12 )
+    {
+      n[0] = 0.0; n[1] = 0.0; n[2] = 1.0;
+      norm = 1.0;
+    }
+    
+    for( unsigned int d=0; d<3; ++d )
+      n[d] /= norm;
+    
+    // Project the previous frame vector on the new plane, or start from the axis 
+    // least aligned with the normal
+    double dot = u[0] * n[0] + u[1] * n[1] + u[2] * n[2];
+    for( unsigned int d=0; d<3; ++d )
+      u[d] -= dot * n[d];
+      
+    norm = std::sqrt( u[0] * u[0] + u[1] * u[1] + u[2] * u[2] );
+    
+    if( norm < 1e-6 )
+    {
+      unsigned int axis = 0;
+      for( unsigned int d=1; d<3; ++d )
+      {
+        if( vcl_abs( n[d] ) < vcl_abs( n[axis] ) )
+          axis = d;
+      }
+      
+      u[0] = 0.0; u[1] = 0.0; u[2] = 0.0;
+      u[axis] = 1.0;
+      
+      dot = n[axis];
+      for( unsigned int d=0; d<3; ++d )
+        u[d] -= dot * n[d];
+        
+      norm = std::sqrt( u[0] * u[0] + u[1] * u[1] + u[2] * u[2] );
+    }
+    
+    for( unsigned int d=0; d<3; ++d )
+      u[d] /= norm;
+      
+    v[0] = n[1] * u[2] - n[2] * u[1];
+    v[1] = n[2] * u[0] - n[0] * u[2];
+    v[2] = n[0] * u[1] - n[1] * u[0];
+    
+    for( unsigned int k=0; k<ringSize; ++k )
+    {
+      const double radius = this->GetContourRadius( section, k, 2.0 * vnl_math::pi * k / ringSize );
+      
+      for( unsigned int d=0; d<3; ++d )
+      {
+        const double radial = m_Cosines[k] * u[d] + m_Sines[k] * v[d];
+        *vertices++ = static_cast<CoordinateType>( center[d] + radius * radial );
+        *normals++ = static_cast<CoordinateType>( radial );
+      }
+    }
+  }
+  
+  // One strip between every pair of consecutive rings, closed by repeating the first pair
+  IndexType *indices = &m_Indices[ m_IndexOffsets[node] ];
+  
+  for( unsigned int i=0; i+1<size; ++i )
+  {
+    const IndexType ring = static_cast<IndexType>( vertexOffset + i * ringSize );
+    const IndexType nextRing = ring + ringSize;
+    
+    for( unsigned int k=0; k<=ringSize; ++k )
+    {
+      const unsigned int point = ( k < ringSize ) ? k : 0;
+      *indices++ = ring + point;
+      *indices++ = nextRing + point;
+    }
+    
+    *indices++ = GetRestartIndex();
+  }
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphTubeMeshGenerator<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfContourPoints: " << m_NumberOfContourPoints << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfVertices: " << this->GetNumberOfVertices() << std::endl;
+  os << indent << "NumberOfIndices: " << m_Indices.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanLinearPropertyInterpolator.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: linear interpolation of section properties
 // Date: 2009/02/06
 
 
@@ -33,6 +33,7 @@ SUCH DAMAGE.
 
 #include "itkArray.h"
 #include "itkVector.h"
+#include "itkPoint.h"
 #include "itkCovariantVector.h"
 
 
@@ -55,26 +56,28 @@ public:
 
   typedef LinearPropertyInterpolator   Self;
   
-  T Interpolate( const T & value1, const T & value2, double pos1, double pos2, double pos )
+  T Interpolate( const T & value1, const T & value2, double pos1, double pos2, double pos ) const
     {
-      return static_cast<T>( value1 + ( ( pos - pos1 ) / ( pos2 - pos1 ) )( value2 - value1 ) ); 
+      return static_cast<T>( value1 + ( ( pos - pos1 ) / ( pos2 - pos1 ) ) * ( value2 - value1 ) ); 
     }
 };
 
 // Specialization for itk::Array
-template <class T,unsigned int VDimension>
-class ITK_EXPORT LinearPropertyInterpolator<itk::Array<T,VDimension> >
+template <class T>
+class ITK_EXPORT LinearPropertyInterpolator<itk::Array<T> >
 {
+public:
+
   typedef LinearPropertyInterpolator   Self;
-  typedef itk::Array<T,VDimension>     ArrayType;
+  typedef itk::Array<T>                ArrayType;
   
   ArrayType Interpolate( const ArrayType & vec1, const ArrayType & vec2, double pos1, 
-    double pos2, double pos )
+    double pos2, double pos ) const
     {
       double multi = ( pos - pos1 ) / ( pos2 - pos1 );
-      ArrayType vec;
+      ArrayType vec( vec1.Size() );
       
-      for( unsigned int i=0; i<VDimension; ++i )
+      for( unsigned int i=0; i<vec1.Size(); ++i )
         vec[i] = vec1[i] + multi * ( vec2[i] - vec1[i] );
         
       return vec; 
@@ -86,11 +89,13 @@ class ITK_EXPORT LinearPropertyInterpolator<itk::Array<T,VDimension> >
 template <class T,unsigned int VDimension>
 class ITK_EXPORT LinearPropertyInterpolator<itk::Vector<T,VDimension> >
 {
+public:
+
   typedef LinearPropertyInterpolator   Self;
   typedef itk::Vector<T,VDimension>    VectorType;
   
   VectorType Interpolate( const VectorType & vec1, const VectorType & vec2, double pos1, 
-    double pos2, double pos )
+    double pos2, double pos ) const
     {
       double multi = ( pos - pos1 ) / ( pos2 - pos1 );
       VectorType vec;
@@ -106,10 +111,12 @@ class ITK_EXPORT LinearPropertyInterpolator<itk::Vector<T,VDimension> >
 template <class T,unsigned int VDimension>
 class ITK_EXPORT LinearPropertyInterpolator<itk::CovariantVector<T,VDimension> >
 {
+public:
+
   typedef LinearPropertyInterpolator            Self;
   typedef itk::CovariantVector<T,VDimension>    VectorType;
   
-  VectorType Interpolate( const VectorType & vec1, const VectorType & vec2, double pos1, double pos2, double pos )
+  VectorType Interpolate( const VectorType & vec1, const VectorType & vec2, double pos1, double pos2, double pos ) const
     {
       double multi = ( pos - pos1 ) / ( pos2 - pos1 );
       VectorType vec;
@@ -121,6 +128,28 @@ class ITK_EXPORT LinearPropertyInterpolator<itk::CovariantVector<T,VDimension> >
     }
 };
 
+// Specialization for itk::Point
+template <class T,unsigned int VDimension>
+class ITK_EXPORT LinearPropertyInterpolator<itk::Point<T,VDimension> >
+{
+public:
+
+  typedef LinearPropertyInterpolator   Self;
+  typedef itk::Point<T,VDimension>     PointType;
+  
+  PointType Interpolate( const PointType & point1, const PointType & point2, double pos1, 
+    double pos2, double pos ) const
+    {
+      double multi = ( pos - pos1 ) / ( pos2 - pos1 );
+      PointType point;
+      
+      for( unsigned int i=0; i<VDimension; ++i )
+        point[i] = point1[i] + multi * ( point2[i] - point1[i] );
+        
+      return point; 
+    }
+};
+
 } // end namespace ivan
 
 #endif
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanLinearVesselCenterlineInterpolator.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: linear interpolation of centerline sections by arclength
 // Date: 2009/02/06
 
 
@@ -32,11 +32,15 @@ SUCH DAMAGE.
 #define __ivanLinearVesselCenterlineInterpolator_h
 
 #include "ivanVesselCenterlineAlgorithm.h"
+#include "ivanLinearPropertyInterpolator.h"
+#include "ivanVesselCommon.h"
+
+#include <vector>
 
 
 namespace ivan
 {
-
+  
 /** \class LinearVesselCenterlineInterpolator
  *  \brief Linear interpolation of vessel sections.
  *
@@ -45,19 +49,39 @@ namespace ivan
  * or specializations may interpolate the whole section as well. This is useful for 
  * example if we have a ray-casted section.
  *
+ * Positions along the centerline are given by arclength. The interpolator keeps an arclength
+ * index of the centerline set with SetCenterline(), the prefix sums of the distances between
+ * consecutive centers, and finds the sections around an arclength by binary search. 
+ * EvaluateCenter(), EvaluateNormal(), EvaluateRadius(), EvaluateProperty() and 
+ * GetSectionRange(), which gives the start and end indexes of a VesselRegion, are then 
+ * logarithmic in the number of sections.
+ *
+ * The index is rebuilt when the centerline is Modified(), recomputed from the first marked
+ * section when sections are marked with MarkModifiedSections(), and extended when sections are
+ * appended. Queries update the index if needed, so call UpdateArclengthIndex() after editing 
+ * the centerline before querying the same interpolator from several threads.
+ *
+ * Evaluate() resamples a centerline every SamplingDistance along its arclength, interpolating
+ * center, normal, radius and scale, and keeps the last section. If SamplingDistance is zero, 
+ * the sections are kept at the input centers. It uses an index of its own and is thread safe.
+ * Process() resamples the centerline in place, reusing its section objects, and 
+ * ComputeSamples() gives the resampled values for VesselGraphCenterlineResampler, as in 
+ * BSplineVesselCenterlineInterpolator.
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
  * \ingroup
  *
  */
 
-
 template <class TCenterline> 
 class ITK_EXPORT LinearVesselCenterlineInterpolator 
   : public VesselCenterlineAlgorithm<TCenterline>
 {
 public:
 
-  typedef LinearVesselCenterlineInterpolator   Self;
-  typedef VesselCenterlineAlgorithm            Superclass;
+  typedef LinearVesselCenterlineInterpolator        Self;
+  typedef VesselCenterlineAlgorithm<TCenterline>    Superclass;
   
   typedef itk::SmartPointer<Self>                   Pointer;
   typedef itk::SmartPointer<const Self>             ConstPointer;
@@ -70,7 +94,11 @@ public:
   typedef typename CenterlineType::ConstPointer     CenterlineConstPointer;
   
   typedef typename CenterlineType::SectionType      SectionType;
-  typedef typename CenterlineType::PointType        PointType;
+  typedef typename SectionType::PointType           PointType;
+  typedef typename SectionType::VectorType          VectorType;
+  
+  /** Arclength of every section, the first being zero. */
+  typedef std::vector<double>                       ArclengthContainerType;
 
 public:
 
@@ -80,14 +108,97 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( LinearVesselCenterlineInterpolator, VesselCenterlineAlgorithm );
   
-  /* Evaluate a new section at the specified input position. */
-  CenterlinePointer Evaluate( CenterlineConstPointer input ) = 0;
+  /** Set/Get the distance between the sections created by Evaluate(). Default is 1. */
+  itkSetMacro( SamplingDistance, double );
+  itkGetConstMacro( SamplingDistance, double );
+  
+  /* Resample the input centerline every SamplingDistance. */
+  virtual OutputType Evaluate( const InputType & input ) const;
+  
+  /** Resample the centerline in place and return it. */
+  virtual CenterlinePointer Process( CenterlineType * centerline ) const;
+  
+  /** Values of a resampled section. */
+  struct SampleType
+  {
+    PointType     Center;
+    VectorType    Normal;
+    double        Radius;
+    double        Scale;
+    double        Arclength;
+  };
+  
+  typedef std::vector<SampleType>   SampleContainer;
+  
+  /** Compute the resampled sections of the centerline. */
+  void ComputeSamples( const CenterlineType * centerline, SampleContainer & samples ) const;
+  
+  /** Set/Get the centerline queried by arclength. */
+  void SetCenterline( const CenterlineType *centerline );
+  const CenterlineType * GetCenterline() const
+    { return m_Centerline; }
+  
+  /** Bring the arclength index up to date with the edits of the centerline. */
+  void UpdateArclengthIndex() const;
+  
+  /** Arclengths of the sections of the centerline. */
+  const ArclengthContainerType & GetArclengths() const
+    { this->UpdateArclengthIndex(); return m_Arclengths; }
+  
+  /** Length of the centerline. */
+  double GetLength() const
+    { this->UpdateArclengthIndex(); return m_Arclengths.empty() ? 0.0 : m_Arclengths.back(); }
+  
+  /** Index of the section starting the segment that contains the given arclength, and 
+    * position in the segment between 0 and 1. Arclengths outside the centerline are clamped. */
+  PointIdType FindSegment( double arclength, double & fraction ) const
+    { this->UpdateArclengthIndex(); return FindSegment( m_Arclengths, arclength, fraction ); }
+  
+  /** Interpolated values at the given arclength. Normals are normalized. */
+  PointType EvaluateCenter( double arclength ) const;
+  VectorType EvaluateNormal( double arclength ) const;
+  double EvaluateRadius( double arclength ) const;
+  
+  /** Interpolate any property of the sections at the given arclength. The getter is called 
+    * with the sections around the arclength and returns the property, which is interpolated by
+    * LinearPropertyInterpolator. */
+  template <class TProperty, class TGetter>
+  TProperty EvaluateProperty( double arclength, TGetter getter ) const
+    {
+      double fraction;
+      const PointIdType first = this->FindSegment( arclength, fraction );
+      
+      if( fraction == 0.0 )
+        return getter( m_Centerline->at( first ) );
+      
+      LinearPropertyInterpolator<TProperty> interpolator;
+      return interpolator.Interpolate( getter( m_Centerline->at( first ) ), 
+        getter( m_Centerline->at( first + 1 ) ), 0.0, 1.0, fraction );
+    }
+  
+  /** Indexes of the first and last sections (inclusive) whose arclength is in [start,end], as 
+    * used by VesselRegion. If there is none, first is greater than last. */
+  void GetSectionRange( double start, double end, PointIdType & first, PointIdType & last ) const;
+  
+  /** Compute the arclengths of the sections of a centerline from the given section, keeping 
+    * the previous ones. */
+  static void ComputeArclengths( const CenterlineType * centerline, unsigned int first, 
+    ArclengthContainerType & arclengths );
+  
+  /** Binary search of an arclength in a container of arclengths. */
+  static PointIdType FindSegment( const ArclengthContainerType & arclengths, double arclength, 
+    double & fraction );
     
 protected:
   
   LinearVesselCenterlineInterpolator();
   ~LinearVesselCenterlineInterpolator();
   
+  /** Write the samples in the centerline, reusing its sections. */
+  void WriteSamples( const SampleContainer & samples, CenterlineType * centerline ) const;
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
 private:
 
   LinearVesselCenterlineInterpolator( const Self & other );
@@ -95,7 +206,15 @@ private:
   
 protected:
 
+  double                  m_SamplingDistance;
+  
+  CenterlineConstPointer  m_Centerline;
   
+  /** Arclength index and the state of the centerline it corresponds to. */
+  mutable ArclengthContainerType  m_Arclengths;
+  mutable unsigned long           m_IndexedMTime;
+  mutable unsigned int            m_IndexedModifiedBegin;
+  mutable unsigned int            m_IndexedModifiedEnd;
 };
 
 } // end namespace ivan
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanLinearVesselCenterlineInterpolator.hxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: linear interpolation of centerline sections by arclength
 // Date: 2009/02/06
 
 #ifndef __ivanLinearVesselCenterlineInterpolator_hxx
@@ -32,12 +32,19 @@ SUCH DAMAGE.
 
 #include "ivanLinearVesselCenterlineInterpolator.h"
 
+#include <algorithm>
+#include <cmath>
+
 
 namespace ivan
 {
 
 template <class TCenterline>
-LinearVesselCenterlineInterpolator<TCenterline>::LinearVesselCenterlineInterpolator()
+LinearVesselCenterlineInterpolator<TCenterline>::LinearVesselCenterlineInterpolator() :
+  m_SamplingDistance( 1.0 ),
+  m_IndexedMTime( 0 ),
+  m_IndexedModifiedBegin( 0 ),
+  m_IndexedModifiedEnd( 0 )
 {
 
 }
@@ -51,19 +58,310 @@ LinearVesselCenterlineInterpolator<TCenterline>::~LinearVesselCenterlineInterpol
 
 
 template <class TCenterline>
-LinearVesselCenterlineInterpolator<TCenterline>::CenterlinePointer 
-LinearVesselCenterlineInterpolator<TCenterline>::Evaluate( CenterlineConstPointer input )
+typename LinearVesselCenterlineInterpolator<TCenterline>::OutputType 
+LinearVesselCenterlineInterpolator<TCenterline>::Evaluate( const InputType & input ) const
 {
+  CenterlinePointer output = CenterlineType::New();
+  
+  if( input.IsNull() )
+    return output;
   
+  SampleContainer samples;
+  this->ComputeSamples( input, samples );
+  this->WriteSamples( samples, output );
   
+  return output;
 }
 
+
+template <class TCenterline>
+typename LinearVesselCenterlineInterpolator<TCenterline>::CenterlinePointer 
+LinearVesselCenterlineInterpolator<TCenterline>::Process( CenterlineType * centerline ) const
+{
+  SampleContainer samples;
+  this->ComputeSamples( centerline, samples );
+  this->WriteSamples( samples, centerline );
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::ComputeSamples
+  ( const CenterlineType * centerline, SampleContainer & samples ) const
+{
+  samples.clear();
+  
+  if( !centerline->size() )
+    return;
+  
+  ArclengthContainerType arclengths;
+  ComputeArclengths( centerline, 0, arclengths );
+  
+  // Sample positions along the arclength, including the last section
+  const double length = arclengths.back();
+  std::vector<double> positions;
+  
+  if( this->m_SamplingDistance > 0.0 )
+  {
+    const unsigned int numberOfSteps = static_cast<unsigned int>( length / this->m_SamplingDistance );
+    
+    positions.reserve( numberOfSteps + 2 );
+    
+    for( unsigned int k=0; k<=numberOfSteps; ++k )
+      positions.push_back( k * this->m_SamplingDistance );
+      
+    if( length - positions.back() > 1e-6 * this->m_SamplingDistance )
+      positions.push_back( length );
+  }
+  else
+  {
+    positions = arclengths;
+  }
+  
+  samples.resize( positions.size() );
+  
+  LinearPropertyInterpolator<PointType> centerInterpolator;
+  LinearPropertyInterpolator<VectorType> normalInterpolator;
+  LinearPropertyInterpolator<double> valueInterpolator;
+  
+  double fraction;
+  
+  for( unsigned int i=0; i<positions.size(); ++i )
+  {
+    const PointIdType first = FindSegment( arclengths, positions[i], fraction );
+    
+    const SectionType *section = centerline->at( first );
+    const SectionType *nextSection = centerline->at( fraction > 0.0 ? first + 1 : first );
+    
+    SampleType & sample = samples[i];
+    
+    sample.Center = centerInterpolator.Interpolate( section->GetCenter(), 
+      nextSection->GetCenter(), 0.0, 1.0, fraction );
+    sample.Normal = normalInterpolator.Interpolate( section->GetNormal(), 
+      nextSection->GetNormal(), 0.0, 1.0, fraction );
+    
+    if( sample.Normal.GetNorm() > 0.0 )
+      sample.Normal.Normalize();
+    
+    sample.Radius = valueInterpolator.Interpolate( section->GetRadius(), 
+      nextSection->GetRadius(), 0.0, 1.0, fraction );
+    sample.Scale = valueInterpolator.Interpolate( section->GetScale(), 
+      nextSection->GetScale(), 0.0, 1.0, fraction );
+    sample.Arclength = positions[i];
+  }
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::WriteSamples
+  ( const SampleContainer & samples, CenterlineType * centerline ) const
+{
+  const unsigned int numberOfReusedSections = std::min
+    ( (unsigned int)samples.size(), (unsigned int)centerline->size() );
+    
+  centerline->resize( samples.size() );
+  
+  PointType center;
+  VectorType normal;
+  
+  for( unsigned int i=0; i<samples.size(); ++i )
+  {
+    if( i >= numberOfReusedSections )
+      centerline->at(i) = SectionType::New();
+    
+    SectionType *section = centerline->at(i);
+    
+    center = samples[i].Center;
+    normal = samples[i].Normal;
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( samples[i].Radius );
+    section->SetScale( samples[i].Scale );
+    section->SetArclength( samples[i].Arclength );
+  }
+  
+  centerline->Modified();
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::SetCenterline( const CenterlineType *centerline )
+{
+  if( m_Centerline.GetPointer() == centerline )
+    return;
+  
+  m_Centerline = centerline;
+  m_Arclengths.clear();
+  m_IndexedMTime = 0;
+  m_IndexedModifiedBegin = m_IndexedModifiedEnd = 0;
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::UpdateArclengthIndex() const
+{
+  if( m_Centerline.IsNull() )
+  {
+    m_Arclengths.clear();
+    return;
+  }
+  
+  const unsigned int numberOfSections = m_Centerline->size();
+  
+  // Appended sections only need their own arclengths, and removed ones none
+  unsigned int first = std::min( (unsigned int)m_Arclengths.size(), numberOfSections );
+  
+  if( m_Centerline->GetMTime() != m_IndexedMTime )
+  {
+    first = 0;
+  }
+  else if( m_Centerline->HasModifiedSections() && 
+    ( m_Centerline->GetModifiedSectionsBegin() != m_IndexedModifiedBegin || 
+    m_Centerline->GetModifiedSectionsEnd() != m_IndexedModifiedEnd ) )
+  {
+    first = std::min( first, m_Centerline->GetModifiedSectionsBegin() );
+  }
+  else if( first == numberOfSections && m_Arclengths.size() == numberOfSections )
+  {
+    return;
+  }
+  
+  ComputeArclengths( m_Centerline, first, m_Arclengths );
+  
+  m_IndexedMTime = m_Centerline->GetMTime();
+  m_IndexedModifiedBegin = m_Centerline->GetModifiedSectionsBegin();
+  m_IndexedModifiedEnd = m_Centerline->GetModifiedSectionsEnd();
+}
+
+
+template <class TCenterline>
+typename LinearVesselCenterlineInterpolator<TCenterline>::PointType 
+LinearVesselCenterlineInterpolator<TCenterline>::EvaluateCenter( double arclength ) const
+{
+  double fraction;
+  const PointIdType first = this->FindSegment( arclength, fraction );
+  
+  if( fraction == 0.0 )
+    return m_Centerline->at( first )->GetCenter();
+  
+  LinearPropertyInterpolator<PointType> interpolator;
+  return interpolator.Interpolate( m_Centerline->at( first )->GetCenter(), 
+    m_Centerline->at( first + 1 )->GetCenter(), 0.0, 1.0, fraction );
+}
+
+
+template <class TCenterline>
+typename LinearVesselCenterlineInterpolator<TCenterline>::VectorType 
+LinearVesselCenterlineInterpolator<TCenterline>::EvaluateNormal( double arclength ) const
+{
+  double fraction;
+  const PointIdType first = this->FindSegment( arclength, fraction );
+  
+  if( fraction == 0.0 )
+    return m_Centerline->at( first )->GetNormal();
+  
+  LinearPropertyInterpolator<VectorType> interpolator;
+  VectorType normal = interpolator.Interpolate( m_Centerline->at( first )->GetNormal(), 
+    m_Centerline->at( first + 1 )->GetNormal(), 0.0, 1.0, fraction );
+  
+  if( normal.GetNorm() > 0.0 )
+    normal.Normalize();
+  
+  return normal;
+}
+
+
+template <class TCenterline>
+double LinearVesselCenterlineInterpolator<TCenterline>::EvaluateRadius( double arclength ) const
+{
+  double fraction;
+  const PointIdType first = this->FindSegment( arclength, fraction );
+  
+  if( fraction == 0.0 )
+    return m_Centerline->at( first )->GetRadius();
+  
+  LinearPropertyInterpolator<double> interpolator;
+  return interpolator.Interpolate( m_Centerline->at( first )->GetRadius(), 
+    m_Centerline->at( first + 1 )->GetRadius(), 0.0, 1.0, fraction );
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::GetSectionRange( double start, double end, 
+  PointIdType & first, PointIdType & last ) const
+{
+  this->UpdateArclengthIndex();
+  
+  first = std::lower_bound( m_Arclengths.begin(), m_Arclengths.end(), start ) - m_Arclengths.begin();
+  last = std::upper_bound( m_Arclengths.begin(), m_Arclengths.end(), end ) - m_Arclengths.begin();
+  
+  // The range is empty if no section is before the end
+  if( last == 0 )
+    first = 1;
+  else
+    --last;
+}
+
+
+template <class TCenterline>
+void LinearVesselCenterlineInterpolator<TCenterline>::ComputeArclengths
+  ( const CenterlineType * centerline, unsigned int first, ArclengthContainerType & arclengths )
+{
+  const unsigned int numberOfSections = centerline->size();
+  
+  arclengths.resize( numberOfSections );
+  
+  for( unsigned int i=first; i<numberOfSections; ++i )
+  {
+    if( i == 0 )
+      arclengths[i] = 0.0;
+    else
+      arclengths[i] = arclengths[i-1] + 
+        centerline->at(i)->GetCenter().EuclideanDistanceTo( centerline->at(i-1)->GetCenter() );
+  }
+}
+
+
+template <class TCenterline>
+PointIdType LinearVesselCenterlineInterpolator<TCenterline>::FindSegment
+  ( const ArclengthContainerType & arclengths, double arclength, double & fraction )
+{
+  fraction = 0.0;
+  
+  if( arclengths.size() < 2 || arclength <= arclengths.front() )
+    return 0;
+  
+  const PointIdType last = arclengths.size() - 1;
+  
+  if( arclength >= arclengths.back() )
+    return last;
+  
+  // First section with a greater arclength ends the segment
+  const PointIdType end = 
+    std::upper_bound( arclengths.begin(), arclengths.end(), arclength ) - arclengths.begin();
+  const PointIdType first = end - 1;
+  
+  const double length = arclengths[end] - arclengths[first];
+  
+  if( length > 0.0 )
+    fraction = ( arclength - arclengths[first] ) / length;
+  
+  return first;
+}
+
+
 template <class TCenterline>
 void LinearVesselCenterlineInterpolator<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
-  
+  os << indent << "SamplingDistance: " << m_SamplingDistance << std::endl;
+  os << indent << "Centerline: " << m_Centerline.GetPointer() << std::endl;
+  os << indent << "NumberOfIndexedSections: " << m_Arclengths.size() << std::endl;
 }
 
 } // end namespace ivan
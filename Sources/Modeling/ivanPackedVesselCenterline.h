@@ -0,0 +1,142 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPackedVesselCenterline.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: centerline with contiguous section storage
+// Date: 2012/11/05
+
+
+#ifndef __ivanPackedVesselCenterline_h
+#define __ivanPackedVesselCenterline_h
+
+#include "ivanPackedVesselSection.h"
+
+#include "itkVectorContainer.h"
+
+
+namespace ivan
+{
+  
+/** \class PackedVesselCenterline
+ *  \brief Centerline that stores its sections contiguously by value.
+ *
+ * PackedVesselCenterline is an alternative to VesselCenterline for long centerlines. It is an
+ * itk::VectorContainer of PackedVesselSection values instead of section smart pointers, so 
+ * sections take no separate allocations and are iterated in order in memory. It has the same
+ * interface as VesselCenterline, and at(i)->GetCenter() and similar calls compile for both.
+ *
+ * Pack() and Unpack() convert from and to centerlines of section objects.
+ *
+ * \ingroup 
+ */
+
+template <class TElementIdentifier, class TPackedSection = PackedVesselSection<3> >
+class ITK_EXPORT PackedVesselCenterline 
+  : public itk::VectorContainer<TElementIdentifier, TPackedSection>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PackedVesselCenterline            Self;
+  typedef itk::VectorContainer
+    <TElementIdentifier, TPackedSection>    Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  typedef TPackedSection                    SectionType;
+     
+public:
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( PackedVesselCenterline, VectorContainer );
+  
+  unsigned int GetNumberOfCenterlinePoints() const
+    { return this->size(); }
+  unsigned int GetNumberOfSections() const
+    { return this->size(); }
+    
+  SectionType * GetFirstSection()
+    { return this->size() ? &this->front() : 0; }
+  const SectionType * GetFirstSection() const
+    { return this->size() ? &this->front() : 0; }
+      
+  SectionType * GetLastSection()
+    { return this->size() ? &this->back() : 0; }
+  const SectionType * GetLastSection() const
+    { return this->size() ? &this->back() : 0; }
+    
+  /** Compute centerline metrics. This sets the arclength of every section as the length of 
+    * the polyline joining the centers up to it. */
+  virtual void ComputeMetrics();
+  
+  /** Copy the sections of a centerline of section objects. */
+  template <class TCenterline>
+  void Pack( const TCenterline * centerline )
+    {
+      this->resize( centerline->size() );
+      for( unsigned int i=0; i<centerline->size(); ++i )
+        this->at(i).CopyFrom( centerline->at(i).GetPointer() );
+      this->Modified();
+    }
+  
+  /** Copy the sections to a centerline of section objects, creating new sections. */
+  template <class TCenterline>
+  void Unpack( TCenterline * centerline ) const
+    {
+      centerline->clear();
+      centerline->reserve( this->size() );
+      for( unsigned int i=0; i<this->size(); ++i )
+      {
+        typename TCenterline::SectionPointer section = TCenterline::SectionType::New();
+        this->at(i).CopyTo( section.GetPointer() );
+        centerline->push_back( section );
+      }
+      centerline->Modified();
+    }
+    
+protected:
+  
+  PackedVesselCenterline() {}
+  ~PackedVesselCenterline() {}
+    
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  PackedVesselCenterline(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanPackedVesselCenterline.hxx"
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPackedVesselCenterline.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: centerline with contiguous section storage
+// Date: 2012/11/05
+
+#ifndef __ivanPackedVesselCenterline_hxx
+#define __ivanPackedVesselCenterline_hxx
+
+#include "ivanPackedVesselCenterline.h"
+
+
+namespace ivan
+{
+
+template <class TElementIdentifier, class TPackedSection>
+void
+PackedVesselCenterline<TElementIdentifier, TPackedSection>
+::ComputeMetrics()
+{
+  double arclength = 0.0;
+  
+  for( unsigned int i=0; i<this->size(); ++i )
+  {
+    if( i > 0 )
+      arclength += this->at(i).GetCenter().EuclideanDistanceTo( this->at(i-1).GetCenter() );
+    this->at(i).SetArclength( arclength );
+  }
+  
+  this->Modified();
+}
+
+
+template <class TElementIdentifier, class TPackedSection>
+void PackedVesselCenterline<TElementIdentifier, TPackedSection>::PrintSelf
+  ( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Sections:" << std::endl;
+  itk::Indent indent2 = indent.GetNextIndent();
+  for( unsigned int i=0; i<this->size(); ++i )
+  {
+    os << indent2 << "[" << i << "]: " << std::endl;
+    this->at(i).Print( os, indent2 );
+  }
+}
+
+} // end namespace ivan
+
+#endif // __ivanPackedVesselCenterline_hxx
@@ -0,0 +1,166 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPackedVesselSection.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: circular vessel section stored by value
+// Date: 2012/11/05
+
+
+#ifndef __ivanPackedVesselSection_h
+#define __ivanPackedVesselSection_h
+
+#include "itkPoint.h"
+#include "itkVector.h"
+#include "itkIndent.h"
+
+
+namespace ivan
+{
+  
+/** \class PackedVesselSection
+ *  \brief Value type with the data of a CircularVesselSection.
+ *
+ * PackedVesselSection holds the center, normal, radius, scale and arclength of a circular
+ * section as plain members, without the reference count, mutex, modified time and vtable of 
+ * an itk::Object. It is meant to be stored by value in a PackedVesselCenterline.
+ *
+ * The accessors have the same names as those of CircularVesselSection, and operator->() 
+ * returns the section itself, so code written as centerline->at(i)->GetCenter() works with 
+ * both centerline types. Code that keeps SectionType::Pointer objects does not.
+ *
+ * Curve and section metrics are not stored.
+ *
+ * \ingroup 
+ */
+
+template <unsigned int VDimension=3>
+class PackedVesselSection
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PackedVesselSection      Self;
+  
+  typedef double                   PointValueType;
+  typedef itk::Point
+    <PointValueType, VDimension>   PointType;
+  typedef itk::Vector
+    <PointValueType, VDimension>   VectorType;
+  typedef PointType                CenterPointType;
+    
+  itkStaticConstMacro( Dimension, unsigned int, VDimension );
+     
+public:
+
+  PackedVesselSection() :
+    m_Radius( 0.0 ),
+    m_Scale( 0.0 ),
+    m_Arclength( 0.0 )
+    {
+      m_Center.Fill( 0.0 );
+      m_Normal.Fill( 0.0 );
+    }
+    
+  /** Proxy access, so the section can be used as a section pointer. */
+  Self * operator->()
+    { return this; }
+  const Self * operator->() const
+    { return this; }
+  
+  void SetCenter( const PointType & center )
+    { m_Center = center; }
+  const PointType & GetCenter() const
+    { return m_Center; }
+  
+  void SetNormal( const VectorType & normal )
+    { m_Normal = normal; }
+  const VectorType & GetNormal() const
+    { return m_Normal; }
+  
+  void SetRadius( double radius )
+    { m_Radius = radius; }
+  double GetRadius() const
+    { return m_Radius; }
+  
+  void SetScale( double scale )
+    { m_Scale = scale; }
+  double GetScale() const
+    { return m_Scale; }
+  
+  void SetArclength( double arclength )
+    { m_Arclength = arclength; }
+  double GetArclength() const
+    { return m_Arclength; }
+    
+  /** Copy the data from a section object. */
+  template <class TSection>
+  void CopyFrom( const TSection * section )
+    {
+      m_Center = section->GetCenter();
+      m_Normal = section->GetNormal();
+      m_Radius = section->GetRadius();
+      m_Scale = section->GetScale();
+      m_Arclength = section->GetArclength();
+    }
+  
+  /** Copy the data to a section object. */
+  template <class TSection>
+  void CopyTo( TSection * section ) const
+    {
+      PointType center = m_Center;
+      VectorType normal = m_Normal;
+      section->SetCenter( center );
+      section->SetNormal( normal );
+      section->SetRadius( m_Radius );
+      section->SetScale( m_Scale );
+      section->SetArclength( m_Arclength );
+    }
+    
+  void Print( std::ostream& os, itk::Indent indent = 0 ) const
+    {
+      os << indent << "Center: " << m_Center << std::endl;
+      os << indent << "Normal: " << m_Normal << std::endl;
+      os << indent << "Radius: " << m_Radius << std::endl;
+      os << indent << "Scale: " << m_Scale << std::endl;
+      os << indent << "Arclength: " << m_Arclength << std::endl;
+    }
+
+protected:
+
+  PointType   m_Center;
+  
+  VectorType  m_Normal;
+  
+  double      m_Radius;
+  
+  double      m_Scale;
+  
+  double      m_Arclength;
+};
+
+} // end namespace ivan
+
+#endif
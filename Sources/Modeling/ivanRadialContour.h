@@ -82,7 +82,6 @@ public:
   
 public:
   
-  itkNewMacro( RadialContour );
   itkTypeMacro( RadialContour, itk::Object );
   
   itkSetMacro( ContourId, ContourIdentifier );
@@ -93,8 +92,8 @@ public:
   virtual const PointType & GetPoint( ContourIdentifier id ) const = 0;
   
   /** Return the closest point in the contour given the angle. */
-  virtual PointType & GetPointByAngle( AngleType id ) = 0;
-  virtual const PointType & GetPointByAngle( AngleType id ) const = 0;
+  virtual PointType & GetPointByAngle( AngleValueType angle ) = 0;
+  virtual const PointType & GetPointByAngle( AngleValueType angle ) const = 0;
 
 protected:
   
@@ -109,8 +108,6 @@ protected:
   unsigned int      m_ContourId;  
 };
 
-} // end namespace Vessel
-
 } // end namespace ivan
 
 #if ITK_TEMPLATE_TXX
@@ -29,13 +29,15 @@ SUCH DAMAGE.
 
 
 #include "ivanSearchByIdNodeVisitor.h"
+#include "ivanGraphNodeIndex.h"
 
 
 namespace ivan
 {
   
 SearchByIdNodeVisitor::SearchByIdNodeVisitor() :
-  m_NodeId(0)
+  m_NodeId(0),
+  m_UseNodeIndex( true )
 {
   this->AddDispatcher<Self,GraphNode>();
 }
@@ -49,6 +51,31 @@ SearchByIdNodeVisitor::~SearchByIdNodeVisitor()
 
 void SearchByIdNodeVisitor::Apply( GraphNode * node )
 {
+  // The start node begins a new search
+  if( this->GetNodePath().size() == 1 )
+  {
+    m_Node = 0;
+    
+    const GraphNodeIndex *index = node->GetNodeIndex();
+    
+    // The index holds all the descendants of an indexed node, so a miss is final
+    if( m_UseNodeIndex && index && this->GetTraversalMode() == TraverseAllChildren )
+    {
+      GraphNode *found = index->FindNode( m_NodeId, node );
+      
+      if( !found )
+        return;
+      
+      if( this->IsValidMask( found ) )
+      {
+        m_Node = found;
+        return;
+      }
+    }
+  }
+  else if( m_Node.IsNotNull() )
+    return; // already found
+  
   if( node->GetNodeId() == m_NodeId )
     m_Node = node;
   else
@@ -61,8 +88,10 @@ void SearchByIdNodeVisitor::PrintSelf( std::ostream& os, itk::Indent indent ) co
   Superclass::PrintSelf( os, indent );
   
   os << indent << "NodeId: " << m_NodeId << std::endl;
+  os << indent << "UseNodeIndex: " << m_UseNodeIndex << std::endl;
   os << indent << "Node: " << m_Node.GetPointer() << std::endl;
-  m_Node->Print( os, indent.GetNextIndent() );
+  if( m_Node.IsNotNull() )
+    m_Node->Print( os, indent.GetNextIndent() );
 }
 
 } // end namespace ivan
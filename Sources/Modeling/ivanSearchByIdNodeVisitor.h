@@ -38,10 +38,12 @@ SUCH DAMAGE.
 namespace ivan
 {
   
-/** \class 
- *  \brief 
+/** \class SearchByIdNodeVisitor
+ *  \brief Search the node with a given identifier.
  *
- * 
+ * The search finishes at the first node found in depth-first order. If the start node 
+ * belongs to a GraphNodeIndex and all the children are traversed, the node is taken from the
+ * index instead of visiting the graph. Otherwise the graph is visited as usual.
  *
  * \ingroup 
  */
@@ -64,12 +66,19 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( SearchByIdNodeVisitor, GraphNodeVisitor );
   
-  itkGetConstMacro( Node, const GraphNode * );
+  /** Found node, or NULL if not found. */
+  GraphNode * GetNode() const
+    { return m_Node.GetPointer(); }
   
   itkSetMacro( NodeId, GraphNode::NodeIdentifier );
   itkGetConstMacro( NodeId, GraphNode::NodeIdentifier );
+  
+  /** Use the index of the graph if available. Default is on. */
+  itkSetMacro( UseNodeIndex, bool );
+  itkGetConstMacro( UseNodeIndex, bool );
+  itkBooleanMacro( UseNodeIndex );
     
-  /** Increment the counter for this node type only. */
+  /** Check the identifier of the node. */
   void Apply( GraphNode * node );
 	
 protected:
@@ -89,6 +98,8 @@ protected:
   GraphNode::Pointer           m_Node;
    
   GraphNode::NodeIdentifier    m_NodeId;
+  
+  bool                         m_UseNodeIndex;
 };
 
 } // end namespace ivan
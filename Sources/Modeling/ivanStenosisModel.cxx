@@ -34,7 +34,9 @@ SUCH DAMAGE.
 namespace ivan
 {
 
-StenosisModel::StenosisModel()
+StenosisModel::StenosisModel() :
+  m_ReferenceRadius( 0.0 ),
+  m_MinimumRadius( 0.0 )
 {
 
 }
@@ -49,7 +51,9 @@ StenosisModel::~StenosisModel()
 void StenosisModel::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
-
+  
+  os << indent << "ReferenceRadius: " << m_ReferenceRadius << std::endl;
+  os << indent << "MinimumRadius: " << m_MinimumRadius << std::endl;
 }
 
 } // end namespace ivan
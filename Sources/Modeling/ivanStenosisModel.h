@@ -40,6 +40,8 @@ namespace ivan
 /** \class StenosisModel
  *  \brief Model describing a vessel stenosis, that is, a narrowing of the vessel.
  * 
+ * The narrowing is described by the minimum radius in the affected region and the reference 
+ * radius of the healthy vessel around it (see VesselFeatureDetector).
  *
  * \ingroup 
  */
@@ -71,6 +73,18 @@ public:
   static std::string GetFeatureTypeStatic()
     { return "Stenosis"; }
   
+  /** Set/Get the radius of the healthy vessel around the stenosis. */
+  itkSetMacro( ReferenceRadius, double );
+  itkGetConstMacro( ReferenceRadius, double );
+  
+  /** Set/Get the minimum radius in the stenosis. */
+  itkSetMacro( MinimumRadius, double );
+  itkGetConstMacro( MinimumRadius, double );
+  
+  /** Get the degree of stenosis, that is, the relative reduction of the radius, in [0,1]. */
+  double GetDegree() const
+    { return ( m_ReferenceRadius > 0.0 ) ? 1.0 - m_MinimumRadius / m_ReferenceRadius : 0.0; }
+  
 protected:
   
   StenosisModel();
@@ -85,7 +99,8 @@ private:
 
 protected:
 
-
+  double    m_ReferenceRadius;
+  double    m_MinimumRadius;
 };
 
 } // end namespace ivan
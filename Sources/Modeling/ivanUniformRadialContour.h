@@ -33,6 +33,8 @@ SUCH DAMAGE.
 
 #include "ivanRadialContour.h"
 
+#include "itkObjectFactory.h"
+
 #include <deque>
 
 namespace ivan
@@ -55,12 +57,12 @@ namespace ivan
  */
 
 template <class TPoint, typename TAngle=AngularValueInRadians<double> >
-class ITK_EXPORT UniformRadialContour
+class ITK_EXPORT UniformRadialContour : public RadialContour<TPoint,TAngle>
 {
 public:
 
-  typedef UniformRadialContour   Self;
-  typedef RadialContour             Superclass;
+  typedef UniformRadialContour                Self;
+  typedef RadialContour<TPoint,TAngle>        Superclass;
   typedef itk::SmartPointer<Self>        Pointer;
   typedef itk::SmartPointer<const Self>  ConstPointer;
   
@@ -80,8 +82,20 @@ public:
 
 public:
   
-  itkNewMacro( UniformRadialContour );
-  itkTypeMacro( UniformRadialContour, RadialContourBase );
+  itkNewMacro( Self );
+  itkTypeMacro( UniformRadialContour, RadialContour );
+  
+  /** Set the number of elements, equally spaced in angle starting at zero. */
+  void SetNumberOfElements( unsigned int numberOfElements );
+  unsigned int GetNumberOfElements() const
+    { return m_Elements.size(); }
+  
+  /** Angle between consecutive elements. */
+  itkGetConstMacro( SamplingValue, AngleValueType );
+  
+  /** Set the point at the given container index. */
+  void SetPoint( ContourIdentifier id, const PointType & point )
+    { m_Elements[id] = point; }
   
   /** Return the point at the given container index. */
   virtual PointType & GetPoint( ContourIdentifier id )
@@ -90,8 +104,10 @@ public:
     { return m_Elements[id]; }
   
   /** Return the closest point in the contour given the angle. */
-  virtual PointType & GetPointByAngle( AngleType id );
-  virtual const PointType & GetPointByAngle( AngleType id );
+  virtual PointType & GetPointByAngle( AngleValueType angle )
+    { return m_Elements[ this->GetIdByAngle( angle ) ]; }
+  virtual const PointType & GetPointByAngle( AngleValueType angle ) const
+    { return m_Elements[ this->GetIdByAngle( angle ) ]; }
   
 protected:
   
@@ -99,6 +115,9 @@ protected:
   ~UniformRadialContour();
   
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Index of the element nearest to the given angle. */
+  ContourIdentifier GetIdByAngle( AngleValueType angle ) const;
     
 protected:
   
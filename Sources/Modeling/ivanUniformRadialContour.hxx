@@ -35,6 +35,8 @@ SUCH DAMAGE.
 
 #include "itkNumericTraits.h"
 
+#include <cmath>
+
 
 namespace ivan
 {
@@ -47,19 +49,47 @@ UniformRadialContour<TPoint,TAngle>::UniformRadialContour() :
 }
 
 
-template <class TPoint,TAngle>
-UniformRadialContour<TPoint>::~UniformRadialContour()
+template <class TPoint, typename TAngle>
+UniformRadialContour<TPoint,TAngle>::~UniformRadialContour()
 {
 
 }
 
 
-template <class TPoint,TAngle>
-void UniformRadialContour<TPoint>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+template <class TPoint, typename TAngle>
+void UniformRadialContour<TPoint,TAngle>::SetNumberOfElements( unsigned int numberOfElements )
+{
+  m_Elements.resize( numberOfElements );
+  m_SamplingValue = numberOfElements ? 
+    static_cast<AngleValueType>( AngleType::FullTurn / numberOfElements ) : 
+    itk::NumericTraits<AngleValueType>::Zero;
+  
+  this->Modified();
+}
+
+
+template <class TPoint, typename TAngle>
+typename UniformRadialContour<TPoint,TAngle>::ContourIdentifier 
+UniformRadialContour<TPoint,TAngle>::GetIdByAngle( AngleValueType angle ) const
+{
+  const long numberOfElements = m_Elements.size();
+  
+  long id = static_cast<long>( std::floor( angle / m_SamplingValue + 0.5 ) ) % numberOfElements;
+  
+  if( id < 0 )
+    id += numberOfElements;
+  
+  return id;
+}
+
+
+template <class TPoint, typename TAngle>
+void UniformRadialContour<TPoint,TAngle>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
   os << indent << "SamplingValue: " << m_SamplingValue << std::endl;
+  os << indent << "NumberOfElements: " << m_Elements.size() << std::endl;
 }
 
 } // end namespace ivan
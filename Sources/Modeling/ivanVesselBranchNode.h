@@ -31,9 +31,13 @@ SUCH DAMAGE.
 #ifndef __ivanVesselBranchNode_h
 #define __ivanVesselBranchNode_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanVesselNode.h"
 #include "ivanVesselCommon.h"
 #include "ivanVesselCenterline.h"
+#include "ivanVesselCenterlineLoader.h"
+
+#include <vector>
 
 
 namespace ivan
@@ -64,6 +68,11 @@ public:
   
   typedef typename CenterlineType::SectionType   SectionType;
   typedef typename SectionType::Pointer          SectionPointer;
+  
+  typedef VesselCenterlineLoader<TCenterline>    CenterlineLoaderType;
+  
+  /** Simplified centerlines, from finer to coarser. */
+  typedef std::vector<CenterlineConstPointer>    LevelOfDetailContainer;
     
   //itkStaticConstMacro( Dimension, unsigned int, VDimension );
           
@@ -79,14 +88,88 @@ public:
   itkSetMacro( Order, int );
   itkGetConstMacro( Order, int );
   
-  /** Set a new centerline, for example after interpolating. */
+  /** Get the centerline. If it is loaded on demand, both versions request it from the loader,
+    * which may release it later, so they are meant for reading it. Changes to a centerline 
+    * loaded on demand must be made through GetWritableCenterline() or GetWritableSection(), 
+    * which pin it in memory, or they may be lost when it is released. Since the non-const 
+    * version lets the caller modify the centerline and its sections in place, if they are 
+    * shared with a snapshot of the graph they are first replaced by copies, so reads should 
+    * use the const version. */
   CenterlinePointer GetCenterline()
-    { return m_Centerline; }
+    { 
+      if( m_CenterlineLoader.IsNotNull() )
+        return const_cast<CenterlineType*>( m_CenterlineLoader->RequestCenterline( this ).GetPointer() );
+      if( m_SharedCenterline )
+        this->UnshareCenterline();
+      return m_Centerline; 
+    }
   CenterlineConstPointer GetCenterline() const
-    { return m_Centerline; }
+    { 
+      if( m_CenterlineLoader.IsNotNull() )
+        return m_CenterlineLoader->RequestCenterline( this );
+      return m_Centerline; 
+    }
    
-  virtual void SetCenterline( CenterlineType *centerline )
-    { m_Centerline = centerline; }
+  /** Set a new centerline, for example after interpolating. */
+  virtual void SetCenterline( CenterlineType *centerline );
+    
+  /** Load the centerline on demand from the given loader. The current centerline is released. 
+    * \sa VesselCenterlineLoader */
+  void SetCenterlineLoader( CenterlineLoaderType *loader );
+  CenterlineLoaderType * GetCenterlineLoader() const
+    { return m_CenterlineLoader; }
+    
+  /** Whether the centerline is in memory. Always true if it is not loaded on demand. */
+  bool IsCenterlineResident() const
+    { return m_Centerline.IsNotNull(); }
+    
+  /** Get the centerline for modification. If the centerline is also referenced elsewhere, 
+    * for example by a snapshot of the graph, it is first replaced by a copy that shares the 
+    * sections, so other owners do not see the changes. */
+  CenterlineType * GetWritableCenterline();
+  
+  /** Get a section for modification. The centerline and then the section are copied first if
+    * they are also referenced elsewhere. The copy is created with CreateAnother() and filled 
+    * with DeepCopy(), so every section type must override DeepCopy() to copy its own members.
+    * The section is marked as modified in the centerline. */
+  SectionType * GetWritableSection( unsigned int pos );
+  
+  /** Set/Get data attached by the filter that tracked the branch, such as the parameters it 
+    * was tracked with, so that it can be reused when tracking again. 
+    * \sa MultiSeedVesselTrackerFilter::SetReuseUnchangedBranches() */
+  void SetTrackingMemo( itk::LightObject *memo )
+    { m_TrackingMemo = memo; }
+  itk::LightObject * GetTrackingMemo() const
+    { return m_TrackingMemo; }
+  
+  /** Copy the order and tracking memo and share the centerline of the given node, if it is a 
+    * branch. */
+  virtual void CopyInformation( const GraphNode * node );
+  
+  /** Set/Get the simplified centerlines of the branch, from finer to coarser, which usually 
+    * share their sections with the centerline. They are removed when a new or writable 
+    * centerline is set or requested, but not when the centerline is modified through the 
+    * non-const GetCenterline(). 
+    * \sa VesselGraphCenterlineSimplifier */
+  void SetLevelsOfDetail( const LevelOfDetailContainer & levels )
+    { m_LevelsOfDetail = levels; }
+  const LevelOfDetailContainer & GetLevelsOfDetail() const
+    { return m_LevelsOfDetail; }
+  unsigned int GetNumberOfLevelsOfDetail() const
+    { return m_LevelsOfDetail.size(); }
+  void RemoveLevelsOfDetail()
+    { m_LevelsOfDetail.clear(); }
+    
+  /** Get the centerline at the given level of detail. Level 0 is the centerline itself, and 
+    * levels beyond the coarsest available return the coarsest. */
+  CenterlineConstPointer GetLevelOfDetailCenterline( unsigned int level ) const
+    {
+      if( level == 0 || m_LevelsOfDetail.empty() )
+        return this->GetCenterline();
+      if( level > m_LevelsOfDetail.size() )
+        level = m_LevelsOfDetail.size();
+      return m_LevelsOfDetail[level-1];
+    }
   
   /** Return the number of (centerline) points. */
   void GetNumberOfPoints() const
@@ -102,15 +185,36 @@ protected:
   ~VesselBranchNode();
     
   void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Load the centerline for modification and stop using the loader. */
+  void PinCenterline();
+  
+  /** Replace the centerline by a copy, copying also the sections referenced elsewhere. */
+  void UnshareCenterline();
+  
+  /** Copy of the section of the same type. */
+  SectionPointer CopySection( const SectionType *section ) const;
 
 private:
 
   VesselBranchNode(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
+  friend class VesselCenterlineLoader<TCenterline>;
+
 protected:
 
-  CenterlinePointer     m_Centerline;
+  /** Mutable, since the loader sets and releases it from const access. */
+  mutable CenterlinePointer                 m_Centerline;
+  typename CenterlineLoaderType::Pointer    m_CenterlineLoader;
+  
+  /** Whether the centerline, or some of its sections, may be shared with a snapshot. Mutable,
+    * since the original branch is set when a snapshot copies it. */
+  mutable bool                              m_SharedCenterline;
+  
+  itk::LightObject::Pointer                 m_TrackingMemo;
+  
+  LevelOfDetailContainer                    m_LevelsOfDetail;
   
   /** Strahler order of branch. We use a signed integer for convenience, since 
     * in analysis of vessel trees, arteries take positive order numbers and 
@@ -120,6 +224,17 @@ protected:
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_VesselBranchNode(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT VesselBranchNode< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef VesselBranchNode< ITK_TEMPLATE_1 x > \
+                                                  VesselBranchNode##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanVesselBranchNode+-.h"
+#endif
+
 #if ITK_TEMPLATE_TXX
 # include "ivanVesselBranchNode.hxx"
 #endif
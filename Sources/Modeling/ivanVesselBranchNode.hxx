@@ -40,6 +40,7 @@ namespace ivan
 
 template <class TCenterline>
 VesselBranchNode<TCenterline>::VesselBranchNode() :
+  m_SharedCenterline(false),
   m_Order(0)
 {
   m_Centerline = CenterlineType::New();
@@ -49,7 +50,161 @@ VesselBranchNode<TCenterline>::VesselBranchNode() :
 template <class TCenterline>
 VesselBranchNode<TCenterline>::~VesselBranchNode()
 {
+  if( m_CenterlineLoader.IsNotNull() )
+    m_CenterlineLoader->RemoveBranch( this );
+}
+
+
+template <class TCenterline>
+void VesselBranchNode<TCenterline>::SetCenterline( CenterlineType *centerline )
+{
+  if( m_CenterlineLoader.IsNotNull() )
+  {
+    m_CenterlineLoader->RemoveBranch( this );
+    m_CenterlineLoader = 0;
+  }
+  
+  m_Centerline = centerline;
+  m_SharedCenterline = false;
+  m_LevelsOfDetail.clear();
+}
+
+
+template <class TCenterline>
+void VesselBranchNode<TCenterline>::SetCenterlineLoader( CenterlineLoaderType *loader )
+{
+  if( m_CenterlineLoader.GetPointer() == loader )
+    return;
+    
+  if( m_CenterlineLoader.IsNotNull() )
+    m_CenterlineLoader->RemoveBranch( this );
+    
+  m_CenterlineLoader = loader;
+  
+  if( loader )
+    m_Centerline = 0;
+    
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselBranchNode<TCenterline>::PinCenterline()
+{
+  // Keep the loader alive until it returns
+  typename CenterlineLoaderType::Pointer loader = m_CenterlineLoader;
+  m_CenterlineLoader = 0;
+  
+  loader->PinCenterline( this );
+}
+
+
+template <class TCenterline>
+typename VesselBranchNode<TCenterline>::CenterlineType * 
+VesselBranchNode<TCenterline>::GetWritableCenterline()
+{
+  if( m_CenterlineLoader.IsNotNull() )
+    this->PinCenterline();
+    
+  // The simplified centerlines would not follow the changes
+  m_LevelsOfDetail.clear();
+    
+  if( m_Centerline.IsNotNull() && m_Centerline->GetReferenceCount() > 1 )
+  {
+    CenterlinePointer centerline = CenterlineType::New();
+    centerline->reserve( m_Centerline->size() );
+    for( unsigned int i=0; i<m_Centerline->size(); ++i )
+      centerline->push_back( m_Centerline->at(i) );
+      
+    m_Centerline = centerline;
+    this->Modified();
+  }
+  
+  return m_Centerline;
+}
+
+
+template <class TCenterline>
+typename VesselBranchNode<TCenterline>::SectionType * 
+VesselBranchNode<TCenterline>::GetWritableSection( unsigned int pos )
+{
+  CenterlineType *centerline = this->GetWritableCenterline();
+  
+  SectionPointer & section = centerline->at( pos );
+  
+  if( section.IsNotNull() && section->GetReferenceCount() > 1 )
+    section = this->CopySection( section );
+  
+  centerline->MarkModifiedSections( pos, pos + 1 );
+  
+  return section;
+}
+
+
+template <class TCenterline>
+void VesselBranchNode<TCenterline>::UnshareCenterline()
+{
+  m_SharedCenterline = false;
+  
+  if( m_Centerline.IsNull() )
+    return;
+  
+  // If the centerline itself is shared, so are all its sections
+  const bool sharedSections = ( m_Centerline->GetReferenceCount() > 1 );
+  
+  CenterlinePointer centerline = CenterlineType::New();
+  centerline->reserve( m_Centerline->size() );
+  
+  for( unsigned int i=0; i<m_Centerline->size(); ++i )
+  {
+    const SectionPointer & section = m_Centerline->at(i);
+    
+    if( section.IsNotNull() && ( sharedSections || section->GetReferenceCount() > 1 ) )
+      centerline->push_back( this->CopySection( section ) );
+    else
+      centerline->push_back( section );
+  }
+  
+  m_Centerline = centerline;
+  this->Modified();
+}
+
+
+template <class TCenterline>
+typename VesselBranchNode<TCenterline>::SectionPointer
+VesselBranchNode<TCenterline>::CopySection( const SectionType *section ) const
+{
+  // Keep the section type, so the members of subclasses are copied too
+  itk::LightObject::Pointer object = section->CreateAnother();
+  SectionPointer copy = dynamic_cast<SectionType*>( object.GetPointer() );
+  
+  if( copy.IsNull() )
+    itkExceptionMacro( "Could not copy section of type " << section->GetNameOfClass() << "." );
+    
+  copy->DeepCopy( section );
+  return copy;
+}
+
 
+template <class TCenterline>
+void VesselBranchNode<TCenterline>::CopyInformation( const GraphNode * node )
+{
+  Superclass::CopyInformation( node );
+  
+  const Self *branch = dynamic_cast<const Self*>( node );
+  
+  if( branch )
+  {
+    m_Order = branch->m_Order;
+    m_TrackingMemo = branch->m_TrackingMemo;
+    
+    // Shared until one of the owners asks for a writable centerline
+    this->SetCenterline( const_cast<CenterlineType*>( branch->GetCenterline().GetPointer() ) );
+    m_LevelsOfDetail = branch->m_LevelsOfDetail;
+    
+    m_SharedCenterline = true;
+    branch->m_SharedCenterline = true;
+  }
 }
 
 
@@ -60,8 +215,11 @@ void VesselBranchNode<TCenterline>::PrintSelf
   Superclass::PrintSelf( os, indent );
     
   os << indent << "Order: " << m_Order << std::endl;
+  os << indent << "NumberOfLevelsOfDetail: " << m_LevelsOfDetail.size() << std::endl;
+  os << indent << "CenterlineLoader: " << m_CenterlineLoader.GetPointer() << std::endl;
   os << indent << "Centerline: " << m_Centerline.GetPointer() << std::endl;
-  m_Centerline->Print( os, indent.GetNextIndent() );
+  if( m_Centerline.IsNotNull() )
+    m_Centerline->Print( os, indent.GetNextIndent() );
 }
 
 } // end namespace ivan
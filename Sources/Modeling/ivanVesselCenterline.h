@@ -32,8 +32,14 @@ SUCH DAMAGE.
 #define __ivanVesselCenterline_h
 
 
+#include "ivanExplicitInstantiation.h"
 #include "itkVectorContainer.h"
 
+#include "ivanArenaAllocator.h"
+#include "ivanPublishedArray.h"
+
+#include <algorithm>
+
 
 namespace ivan
 {
@@ -41,6 +47,11 @@ namespace ivan
 /** \class VesselCenterline
  *  \brief 
  *
+ * The container is not safe to read while another thread modifies it. A writer that is read
+ * concurrently, such as a tracker rendered by a viewer, calls PublishSections() whenever the
+ * sections are consistent, and readers iterate GetPublishedSections() without locks. The 
+ * published sections are not modified until the next publication, but the sections themselves 
+ * are shared, so writers should only publish completed sections.
  *
  * \ingroup 
  */
@@ -61,6 +72,9 @@ public:
   
   typedef TVesselSection                    SectionType;
   typedef typename TVesselSection::Pointer  SectionPointer;
+  
+  typedef PublishedArray<SectionPointer>        PublishedSectionsType;
+  typedef typename PublishedSectionsType::View  PublishedSectionsView;
      
 public:
 
@@ -70,6 +84,10 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( VesselCenterline, VectorContainer );
   
+  /** Centerlines are taken from the active ArenaAllocator, if any. The section pointers 
+    * are stored on the heap. */
+  ivanArenaAllocationMacro();
+  
   unsigned int GetNumberOfCenterlinePoints() const
     { return this->size(); }
   unsigned int GetNumberOfSections() const
@@ -109,6 +127,54 @@ public:
     
   /** Compute centerline metrics. */
   virtual void ComputeMetrics();
+  
+  /** Mark the sections in [first,last) as modified, so algorithms that keep data derived 
+    * from the sections, such as LocalCurveMetricsCalculator, update only what depends on them.
+    * Marks accumulate in a single range until ClearModifiedSections(). Sections appended at 
+    * the end need not be marked, since those algorithms detect them from the size. */
+  void MarkModifiedSections( unsigned int first, unsigned int last )
+    {
+      if( first >= last )
+        return;
+      if( !this->HasModifiedSections() )
+      {
+        m_ModifiedSectionsBegin = first;
+        m_ModifiedSectionsEnd = last;
+      }
+      else
+      {
+        m_ModifiedSectionsBegin = std::min( m_ModifiedSectionsBegin, first );
+        m_ModifiedSectionsEnd = std::max( m_ModifiedSectionsEnd, last );
+      }
+    }
+    
+  bool HasModifiedSections() const
+    { return m_ModifiedSectionsBegin < m_ModifiedSectionsEnd; }
+  unsigned int GetModifiedSectionsBegin() const
+    { return m_ModifiedSectionsBegin; }
+  unsigned int GetModifiedSectionsEnd() const
+    { return m_ModifiedSectionsEnd; }
+    
+  void ClearModifiedSections()
+    { m_ModifiedSectionsBegin = m_ModifiedSectionsEnd = 0; }
+    
+  /** Publish the current sections to the readers of GetPublishedSections(). Only the writer
+    * of the centerline may call it. Appended sections are published in place when the reserved
+    * capacity allows it. */
+  void PublishSections()
+    {
+      typename Superclass::STLContainerType & sections = this->CastToSTLContainer();
+      m_PublishedSections.Publish( sections.begin(), sections.end(), sections.capacity() );
+    }
+    
+  /** Sections of the last call to PublishSections(), which may be read from any thread while 
+    * the centerline is modified. The view stays valid until ReclaimPublishedSections(). */
+  PublishedSectionsView GetPublishedSections() const
+    { return m_PublishedSections.GetView(); }
+    
+  /** Free the storage of previous publications, once no reader holds a view of them. */
+  void ReclaimPublishedSections()
+    { m_PublishedSections.ReclaimRetiredBlocks(); }
     
 protected:
   
@@ -124,10 +190,27 @@ private:
 
 protected:
 
+  /** Range of modified sections. */
+  unsigned int    m_ModifiedSectionsBegin;
+  unsigned int    m_ModifiedSectionsEnd;
+  
+  /** Sections published to concurrent readers. */
+  PublishedSectionsType   m_PublishedSections;
 };
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_VesselCenterline(_, EXPORT, x, y) namespace ivan { \
+  _(2(class EXPORT VesselCenterline< ITK_TEMPLATE_2 x >)) \
+  namespace Templates { typedef VesselCenterline< ITK_TEMPLATE_2 x > \
+                                                  VesselCenterline##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanVesselCenterline+-.h"
+#endif
+
 #if ITK_TEMPLATE_TXX
 # include "ivanVesselCenterline.hxx"
 #endif
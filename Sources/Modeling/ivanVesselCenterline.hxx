@@ -38,7 +38,9 @@ namespace ivan
 {
 
 template <class TElementIdentifier, class TVesselSection>
-VesselCenterline<TElementIdentifier, TVesselSection>::VesselCenterline()
+VesselCenterline<TElementIdentifier, TVesselSection>::VesselCenterline() :
+  m_ModifiedSectionsBegin( 0 ),
+  m_ModifiedSectionsEnd( 0 )
 {
 
 }
@@ -37,26 +37,34 @@ SUCH DAMAGE.
 namespace ivan
 {
   
-/** \class Vessel centerline interpolator
- *  \brief Base class for interpolating centerlines.
+/** \class VesselCenterlineAlgorithm
+ *  \brief Base class for algorithms that process centerlines.
  *
  * This is the base class for interpolating centerlines consisting of sections 
  * stored in a container. The class interpolates only the section centerline point 
  * and normal but subclasses or specializations may interpolate the whole section 
  * as well. This is useful for example if we have a ray-casted section.
  *
+ * Evaluate() returns a new centerline. Process() is used when the algorithm is applied to 
+ * the centerline of a branch, and may modify it in place to avoid reallocating the sections. 
+ * Both must be thread safe, so that several branches can be processed concurrently.
+ *
+ * \sa VesselGraphCenterlineProcessor
+ *
  * \ingroup 
  */
 
 
 template <class TCenterline> 
-class ITK_EXPORT VesselCenterlineAlgorithm : public FunctionBase 
+class ITK_EXPORT VesselCenterlineAlgorithm : public itk::FunctionBase 
   <typename TCenterline::ConstPointer, typename TCenterline::Pointer>
 {
 public:
 
   typedef VesselCenterlineAlgorithm        Self;
-  typedef FunctionBase                     Superclass;
+  typedef itk::FunctionBase
+    <typename TCenterline::ConstPointer, 
+    typename TCenterline::Pointer>        Superclass;
   
   typedef itk::SmartPointer<Self>               Pointer;
   typedef itk::SmartPointer<const Self>         ConstPointer;
@@ -69,18 +77,20 @@ public:
   typedef typename CenterlineType::ConstPointer     CenterlineConstPointer;
   
   typedef typename CenterlineType::SectionType      SectionType;
-  typedef typename CenterlineType::PointType        PointType;
+  typedef typename SectionType::PointType           PointType;
         
 public:
-
-  /** Method for creation through the object factory. */
-  itkNewMacro( Self );
   
   /** Run-time type information (and related methods). */
   itkTypeMacro( VesselCenterlineAlgorithm, FunctionBase );
   
-  /* Evaluate a new section at the specified input position. */
-  CenterlinePointer Evaluate( CenterlineConstPointer input ) = 0;
+  /* Compute a new centerline from the input centerline. */
+  virtual OutputType Evaluate( const InputType & input ) const = 0;
+  
+  /** Process the centerline of a branch and return the centerline that replaces it. By default
+    * this is the result of Evaluate(). Subclasses may modify it in place and return it. */
+  virtual CenterlinePointer Process( CenterlineType * centerline ) const
+    { return this->Evaluate( centerline ); }
     
 protected:
   
@@ -91,7 +101,7 @@ protected:
 
 private:
 
-  VesselCenterlineInterpolator( const Self & other );
+  VesselCenterlineAlgorithm( const Self & other );
   Self & operator = ( const Self & other );
   
 protected:
@@ -79,6 +79,14 @@ public:
   
   /** Start visiting given node. */
 	virtual void Visit( VesselBranchNode *node );
+	
+	/** Visitors for parallel traversal share the algorithm, which must be thread safe. */
+	virtual GraphNodeVisitor::Pointer CreateTaskVisitor() const
+	  {
+	    Pointer taskVisitor = Self::New();
+	    taskVisitor->SetCenterlineAlgorithm( m_Algorithm );
+	    return taskVisitor.GetPointer();
+	  }
 		
 protected:
 
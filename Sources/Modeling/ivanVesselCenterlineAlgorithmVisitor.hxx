@@ -53,7 +53,7 @@ VesselCenterlineAlgorithmVisitor<TMeasurementInterpolator>::~VesselCenterlineAlg
 template <class TMeasurementInterpolator>
 void VesselCenterlineAlgorithmVisitor<TMeasurementInterpolator>::Visit( VesselBranchNode *node )
 {
-  node->SetCenterline( m_Interpolator->Evaluate( node->GetCenterline() ) );
+  node->SetCenterline( m_Algorithm->Process( node->GetCenterline() ) );
 }
 	
 
@@ -0,0 +1,158 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineLoader.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: loads the centerlines of vessel branches on demand.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselCenterlineLoader_h
+#define __ivanVesselCenterlineLoader_h
+
+#include "itkObject.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <list>
+#include <map>
+
+
+namespace ivan
+{
+
+template <class TCenterline> class VesselBranchNode;
+  
+/** \class VesselCenterlineLoader
+ *  \brief Base class for loading the centerlines of vessel branches on demand.
+ *
+ * A VesselBranchNode given a loader with SetCenterlineLoader() does not keep its centerline 
+ * in memory. The first call to its const GetCenterline() asks the loader, which creates the 
+ * centerline with LoadCenterline() and keeps it resident in the branch. At most 
+ * MaximumNumberOfResidentCenterlines are resident at the same time: when a new centerline 
+ * is loaded, the least recently used ones are released, except those still referenced 
+ * elsewhere, and are loaded again on their next access.
+ *
+ * A centerline obtained through the non-const GetCenterline() or GetWritableCenterline() may
+ * be modified, so it is loaded and the branch stops using the loader: it stays resident and 
+ * does not count against the maximum. Read-only clients such as viewers and metrics visitors
+ * should use a const branch to stay within the memory budget.
+ *
+ * All the methods are thread safe.
+ *
+ * \sa MappedVesselCenterlineLoader
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselCenterlineLoader : public itk::Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselCenterlineLoader          Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                             CenterlineType;
+  typedef typename CenterlineType::Pointer        CenterlinePointer;
+  typedef typename CenterlineType::ConstPointer   CenterlineConstPointer;
+  
+  typedef VesselBranchNode<TCenterline>           BranchNodeType;
+  
+public:
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselCenterlineLoader, itk::Object );
+  
+  /** Maximum number of centerlines resident at the same time. Zero means no limit. Default
+    * is 256. */
+  itkSetMacro( MaximumNumberOfResidentCenterlines, unsigned long );
+  itkGetConstMacro( MaximumNumberOfResidentCenterlines, unsigned long );
+  
+  unsigned long GetNumberOfResidentCenterlines() const;
+  
+  /** Get the centerline of the branch for reading, loading it if it is not resident. */
+  CenterlineConstPointer RequestCenterline( const BranchNodeType * branch );
+  
+  /** Get the centerline of the branch for modification, loading it if it is not resident. 
+    * The loader stops managing the branch, which must then drop its loader. */
+  CenterlinePointer PinCenterline( BranchNodeType * branch );
+  
+  /** Stop managing the branch. Called by the branch when it is destroyed or given another 
+    * centerline or loader. */
+  void RemoveBranch( const BranchNodeType * branch );
+  
+  /** Release all the resident centerlines not referenced elsewhere. */
+  void ReleaseCenterlines();
+  
+protected:
+
+  VesselCenterlineLoader();
+  ~VesselCenterlineLoader() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Create the centerline of the branch. Called with the mutex locked. */
+  virtual CenterlinePointer LoadCenterline( const BranchNodeType * branch ) = 0;
+  
+  /** Called with the mutex locked when the loader stops managing a branch. */
+  virtual void ForgetBranch( const BranchNodeType * ) {}
+  
+  /** Load the centerline if needed and make it the most recently used. Called with the mutex 
+    * locked, which is unlocked if the loader throws. */
+  void MakeResident( const BranchNodeType * branch );
+  
+  /** Release the least recently used centerlines above the maximum. */
+  void ReleaseLeastRecentlyUsed();
+  
+  /** Release the centerline if only the branch references it. */
+  bool ReleaseCenterline( typename std::list<const BranchNodeType*>::iterator it );
+
+private:
+
+  VesselCenterlineLoader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  typedef std::list<const BranchNodeType*>                          BranchListType;
+  typedef std::map<const BranchNodeType*,
+    typename BranchListType::iterator>                              BranchPositionMapType;
+
+  unsigned long                     m_MaximumNumberOfResidentCenterlines;
+  
+  /** Branches with a resident centerline, the most recently used first. */
+  BranchListType                    m_ResidentBranches;
+  BranchPositionMapType             m_ResidentPositions;
+  
+  mutable itk::SimpleFastMutexLock  m_Mutex;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselCenterlineLoader.hxx"
+#endif
+
+#endif
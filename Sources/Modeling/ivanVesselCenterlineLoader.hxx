@@ -0,0 +1,216 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineLoader.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: loads the centerlines of vessel branches on demand.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselCenterlineLoader_hxx
+#define __ivanVesselCenterlineLoader_hxx
+
+#include "ivanVesselCenterlineLoader.h"
+#include "ivanVesselBranchNode.h"
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselCenterlineLoader<TCenterline>::VesselCenterlineLoader() :
+  m_MaximumNumberOfResidentCenterlines( 256 )
+{
+
+}
+
+
+template <class TCenterline>
+unsigned long VesselCenterlineLoader<TCenterline>::GetNumberOfResidentCenterlines() const
+{
+  m_Mutex.Lock();
+  const unsigned long numberOfCenterlines = m_ResidentPositions.size();
+  m_Mutex.Unlock();
+  
+  return numberOfCenterlines;
+}
+
+
+template <class TCenterline>
+typename VesselCenterlineLoader<TCenterline>::CenterlineConstPointer
+VesselCenterlineLoader<TCenterline>::RequestCenterline( const BranchNodeType * branch )
+{
+  m_Mutex.Lock();
+  
+  this->MakeResident( branch );
+  
+  // Referenced here, so it is not released below
+  CenterlineConstPointer centerline = branch->m_Centerline.GetPointer();
+  this->ReleaseLeastRecentlyUsed();
+  
+  m_Mutex.Unlock();
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+typename VesselCenterlineLoader<TCenterline>::CenterlinePointer
+VesselCenterlineLoader<TCenterline>::PinCenterline( BranchNodeType * branch )
+{
+  m_Mutex.Lock();
+  
+  this->MakeResident( branch );
+  
+  CenterlinePointer centerline = branch->m_Centerline;
+  
+  typename BranchPositionMapType::iterator it = m_ResidentPositions.find( branch );
+  m_ResidentBranches.erase( it->second );
+  m_ResidentPositions.erase( it );
+  this->ForgetBranch( branch );
+  
+  m_Mutex.Unlock();
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineLoader<TCenterline>::RemoveBranch( const BranchNodeType * branch )
+{
+  m_Mutex.Lock();
+  
+  typename BranchPositionMapType::iterator it = m_ResidentPositions.find( branch );
+  
+  if( it != m_ResidentPositions.end() )
+  {
+    m_ResidentBranches.erase( it->second );
+    m_ResidentPositions.erase( it );
+  }
+  
+  this->ForgetBranch( branch );
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineLoader<TCenterline>::ReleaseCenterlines()
+{
+  m_Mutex.Lock();
+  
+  typename BranchListType::iterator it = m_ResidentBranches.begin();
+  
+  while( it != m_ResidentBranches.end() )
+  {
+    typename BranchListType::iterator next = it;
+    ++next;
+    this->ReleaseCenterline( it );
+    it = next;
+  }
+  
+  m_Mutex.Unlock();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineLoader<TCenterline>::MakeResident( const BranchNodeType * branch )
+{
+  typename BranchPositionMapType::iterator it = m_ResidentPositions.find( branch );
+  
+  if( it != m_ResidentPositions.end() )
+  {
+    m_ResidentBranches.splice( m_ResidentBranches.begin(), m_ResidentBranches, it->second );
+    return;
+  }
+  
+  if( branch->m_Centerline.IsNull() )
+  {
+    // Loaders may throw, for example on a corrupt file
+    try
+    {
+      branch->m_Centerline = this->LoadCenterline( branch );
+    }
+    catch( ... )
+    {
+      m_Mutex.Unlock();
+      throw;
+    }
+  }
+    
+  m_ResidentBranches.push_front( branch );
+  m_ResidentPositions[branch] = m_ResidentBranches.begin();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineLoader<TCenterline>::ReleaseLeastRecentlyUsed()
+{
+  if( !m_MaximumNumberOfResidentCenterlines )
+    return;
+    
+  // Centerlines in use are skipped, so look at each branch at most once. The candidate is 
+  // always the one before it
+  typename BranchListType::iterator it = m_ResidentBranches.end();
+  
+  while( m_ResidentPositions.size() > m_MaximumNumberOfResidentCenterlines && 
+    it != m_ResidentBranches.begin() )
+  {
+    typename BranchListType::iterator candidate = it;
+    --candidate;
+    
+    if( !this->ReleaseCenterline( candidate ) )
+      it = candidate;
+  }
+}
+
+
+template <class TCenterline>
+bool VesselCenterlineLoader<TCenterline>::ReleaseCenterline( typename BranchListType::iterator it )
+{
+  const BranchNodeType *branch = *it;
+  
+  if( branch->m_Centerline.IsNotNull() && branch->m_Centerline->GetReferenceCount() > 1 )
+    return false;
+    
+  branch->m_Centerline = 0;
+  m_ResidentPositions.erase( branch );
+  m_ResidentBranches.erase( it );
+  
+  return true;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineLoader<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "MaximumNumberOfResidentCenterlines: " << m_MaximumNumberOfResidentCenterlines 
+    << std::endl;
+  os << indent << "NumberOfResidentCenterlines: " << m_ResidentPositions.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -31,6 +31,8 @@ SUCH DAMAGE.
 #ifndef __ivanVesselCenterlineMetricsCalculator_h
 #define __ivanVesselCenterlineMetricsCalculator_h
 
+#include "itkObject.h"
+
 
 namespace ivan
 {
@@ -69,9 +71,6 @@ public:
   
 public:
 
-	/** Method for creation through the object factory. */
-  itkNewMacro( Self );
-
   /** Run-time type information (and related methods). */
   itkTypeMacro( VesselCenterlineMetricsCalculator, itk::Object );
   
@@ -80,11 +79,13 @@ public:
 	
 	virtual void SetCenterline( CenterlineType * centerline )
 	  { m_Centerline = centerline; }
+	CenterlineType * GetCenterline()
+	  { return m_Centerline; }
 		
 protected:
 
-  VesselCenterlineMetricsCalculator() : m_VesselBranch(0) {};
-  ~VesselCenterlineMetricsCalculator() {};
+  VesselCenterlineMetricsCalculator();
+  ~VesselCenterlineMetricsCalculator();
   
   void PrintSelf(std::ostream& os, itk::Indent indent) const;
 
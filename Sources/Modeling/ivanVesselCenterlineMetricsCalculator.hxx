@@ -37,8 +37,7 @@ namespace ivan
 {
 
 template <class TSection>
-VesselCenterlineMetricsCalculator<TSection>::VesselCenterlineMetricsCalculator() :
-  m_VesselBranch(0)
+VesselCenterlineMetricsCalculator<TSection>::VesselCenterlineMetricsCalculator()
 {
 
 }
@@ -56,7 +55,7 @@ void VesselCenterlineMetricsCalculator<TSection>::PrintSelf( std::ostream& os, i
 {
   Superclass::PrintSelf( os, indent );
   
-  os << indent << "Centerline: " << m_Centerline << std::endl;
+  os << indent << "Centerline: " << m_Centerline.GetPointer() << std::endl;
 }
 
 } // end namespace ivan
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanVesselCenterlineSmoother.h
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: moving average smoothing of centerline sections
 // Date: 2009/02/06
 
 
@@ -33,17 +33,26 @@ SUCH DAMAGE.
 
 #include "ivanVesselCenterlineAlgorithm.h"
 
+#include "vnl/vnl_math.h"
+
 
 namespace ivan
 {
   
 /** \class VesselCenterlineSmoother
- *  \brief Linear interpolation of vessel sections.
+ *  \brief Moving average smoothing of vessel sections.
+ *
+ * This class smooths the centers and normals of the sections of a centerline with a moving 
+ * average of 2*WindowRadius+1 sections, repeated NumberOfIterations times. The window is 
+ * shrunk symmetrically near the ends, so the first and last centers are kept. Normals are 
+ * renormalized after averaging. 
  *
- * This class interpolates centerlines consisting of sections stored in a container. 
- * The class interpolates only the section centerline point and normal but subclasses 
- * or specializations may interpolate the whole section as well. This is useful for 
- * example if we have a ray-casted section.
+ * Smoothing is done with a running sum, so the cost is linear in the number of sections and
+ * does not depend on the window size. Process() smooths the centerline in place, keeping only 
+ * the original values of the last WindowRadius+1 sections, and does not create any section. 
+ * Evaluate() copies the center, normal, radius and scale of the sections first.
+ *
+ * The section type must provide Get/SetCenter() and Get/SetNormal(), as CircularVesselSection.
  *
  * \ingroup
  *
@@ -56,8 +65,8 @@ class ITK_EXPORT VesselCenterlineSmoother
 {
 public:
 
-  typedef VesselCenterlineSmoother   Self;
-  typedef VesselCenterlineAlgorithm            Superclass;
+  typedef VesselCenterlineSmoother                  Self;
+  typedef VesselCenterlineAlgorithm<TCenterline>    Superclass;
   
   typedef itk::SmartPointer<Self>                   Pointer;
   typedef itk::SmartPointer<const Self>             ConstPointer;
@@ -70,7 +79,8 @@ public:
   typedef typename CenterlineType::ConstPointer     CenterlineConstPointer;
   
   typedef typename CenterlineType::SectionType      SectionType;
-  typedef typename CenterlineType::PointType        PointType;
+  typedef typename SectionType::PointType           PointType;
+  typedef typename SectionType::VectorType          VectorType;
 
 public:
 
@@ -80,14 +90,48 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( VesselCenterlineSmoother, VesselCenterlineAlgorithm );
   
-  /* Evaluate a new section at the specified input position. */
-  CenterlinePointer Evaluate( CenterlineConstPointer input ) = 0;
+  /** Set/Get the half size of the averaging window in sections. Default is 2. */
+  itkSetMacro( WindowRadius, unsigned int );
+  itkGetConstMacro( WindowRadius, unsigned int );
+  
+  /** Set/Get the number of times the average is applied. Default is 1. */
+  itkSetMacro( NumberOfIterations, unsigned int );
+  itkGetConstMacro( NumberOfIterations, unsigned int );
+  
+  /** Set/Get if normals are smoothed too. Default is true. */
+  itkSetMacro( SmoothNormals, bool );
+  itkGetConstMacro( SmoothNormals, bool );
+  itkBooleanMacro( SmoothNormals );
+  
+  /* Return a smoothed copy of the input centerline. */
+  virtual OutputType Evaluate( const InputType & input ) const;
+  
+  /** Smooth the centerline in place and return it. */
+  virtual CenterlinePointer Process( CenterlineType * centerline ) const;
     
 protected:
   
   VesselCenterlineSmoother();
   ~VesselCenterlineSmoother();
   
+  /** Apply one pass of the moving average to the centers, or to the normals. */
+  void AverageValues( CenterlineType * centerline, bool normals ) const;
+  
+  /** Get/Set the value being averaged. Centers are handled as vectors from the origin. */
+  VectorType GetValue( const SectionType * section, bool normals ) const
+    { return normals ? section->GetNormal() : section->GetCenter().GetVectorFromOrigin(); }
+    
+  void SetValue( SectionType * section, VectorType & value, bool normals ) const;
+  
+  /** Half size of the window at the given section, shrunk near the ends. */
+  unsigned int GetWindowRadius( unsigned int index, unsigned int numberOfSections ) const
+    { 
+      return vnl_math_min( this->m_WindowRadius, 
+        vnl_math_min( index, numberOfSections - 1 - index ) ); 
+    }
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
 private:
 
   VesselCenterlineSmoother( const Self & other );
@@ -95,7 +139,9 @@ private:
   
 protected:
 
-  
+  unsigned int    m_WindowRadius;
+  unsigned int    m_NumberOfIterations;
+  bool            m_SmoothNormals;
 };
 
 } // end namespace ivan
@@ -24,7 +24,7 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanVesselCenterlineSmoother.hxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: 
+// Description: moving average smoothing of centerline sections
 // Date: 2009/02/06
 
 #ifndef __ivanVesselCenterlineSmoother_hxx
@@ -32,12 +32,17 @@ SUCH DAMAGE.
 
 #include "ivanVesselCenterlineSmoother.h"
 
+#include <vector>
+
 
 namespace ivan
 {
 
 template <class TCenterline>
-VesselCenterlineSmoother<TCenterline>::VesselCenterlineSmoother()
+VesselCenterlineSmoother<TCenterline>::VesselCenterlineSmoother() :
+  m_WindowRadius( 2 ),
+  m_NumberOfIterations( 1 ),
+  m_SmoothNormals( true )
 {
 
 }
@@ -51,19 +56,142 @@ VesselCenterlineSmoother<TCenterline>::~VesselCenterlineSmoother()
 
 
 template <class TCenterline>
-VesselCenterlineSmoother<TCenterline>::CenterlinePointer 
-VesselCenterlineSmoother<TCenterline>::Evaluate( CenterlineConstPointer input )
+typename VesselCenterlineSmoother<TCenterline>::OutputType 
+VesselCenterlineSmoother<TCenterline>::Evaluate( const InputType & input ) const
+{
+  CenterlinePointer output = CenterlineType::New();
+  output->Reserve( input->size() );
+  
+  for( unsigned int i=0; i<input->size(); ++i )
+  {
+    const SectionType *inputSection = input->at(i);
+    
+    typename SectionType::Pointer section = SectionType::New();
+    
+    PointType center = inputSection->GetCenter();
+    VectorType normal = inputSection->GetNormal();
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( inputSection->GetRadius() );
+    section->SetScale( inputSection->GetScale() );
+    
+    output->at(i) = section;
+  }
+  
+  return this->Process( output );
+}
+
+
+template <class TCenterline>
+typename VesselCenterlineSmoother<TCenterline>::CenterlinePointer 
+VesselCenterlineSmoother<TCenterline>::Process( CenterlineType * centerline ) const
+{
+  for( unsigned int k=0; k<this->m_NumberOfIterations; ++k )
+  {
+    this->AverageValues( centerline, false );
+    
+    if( this->m_SmoothNormals )
+      this->AverageValues( centerline, true );
+  }
+  
+  return centerline;
+}
+
+
+template <class TCenterline>
+void 
+VesselCenterlineSmoother<TCenterline>::AverageValues( CenterlineType * centerline, bool normals ) const
 {
+  const unsigned int numberOfSections = centerline->size();
+  
+  if( numberOfSections < 3 || this->m_WindowRadius == 0 )
+    return;
   
+  // Original values of the sections [i-WindowRadius,i], which have already been overwritten.
+  // Sections after i still hold their original values.
+  const unsigned int bufferSize = this->m_WindowRadius + 1;
+  std::vector<VectorType> originals( bufferSize );
   
+  // Sum over the window [i-radius,i+radius] of the current section
+  VectorType sum = this->GetValue( centerline->at(0), normals );
+  VectorType value;
+  
+  unsigned int radius = 0;
+  unsigned int nextRadius;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    SectionType *section = centerline->at(i);
+    
+    originals[ i % bufferSize ] = this->GetValue( section, normals );
+    
+    value = sum / static_cast<double>( 2 * radius + 1 );
+    this->SetValue( section, value, normals );
+        
+    if( i + 1 == numberOfSections )
+      break;
+    
+    // Slide the window to the next section. Its radius changes at most by one
+    nextRadius = this->GetWindowRadius( i + 1, numberOfSections );
+    
+    if( nextRadius > radius )
+    {
+      sum += this->GetValue( centerline->at( i + radius + 1 ), normals );
+      sum += this->GetValue( centerline->at( i + radius + 2 ), normals );
+    }
+    else if( nextRadius == radius )
+    {
+      sum -= originals[ ( i - radius ) % bufferSize ];
+      sum += this->GetValue( centerline->at( i + radius + 1 ), normals );
+    }
+    else
+    {
+      sum -= originals[ ( i - radius ) % bufferSize ];
+      sum -= originals[ ( i - radius + 1 ) % bufferSize ];
+    }
+    
+    radius = nextRadius;
+  }
+}
+
+
+template <class TCenterline>
+void 
+VesselCenterlineSmoother<TCenterline>::SetValue( SectionType * section, VectorType & value, 
+  bool normals ) const
+{
+  if( normals )
+  {
+    // Keep the original normal if the average vanishes
+    const double norm = value.GetNorm();
+    
+    if( norm > 0.0 )
+    {
+      value /= norm;
+      section->SetNormal( value );
+    }
+  }
+  else
+  {
+    PointType center;
+    
+    for( unsigned int k=0; k<PointType::PointDimension; ++k )
+      center[k] = value[k];
+    
+    section->SetCenter( center );
+  }
 }
 
+
 template <class TCenterline>
 void VesselCenterlineSmoother<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
   
-  
+  os << indent << "WindowRadius: " << m_WindowRadius << std::endl;
+  os << indent << "NumberOfIterations: " << m_NumberOfIterations << std::endl;
+  os << indent << "SmoothNormals: " << m_SmoothNormals << std::endl;
 }
 
 } // end namespace ivan
@@ -0,0 +1,261 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineSpatialIndex.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: bounding volume hierarchy over vessel centerline segments.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselCenterlineSpatialIndex_h
+#define __ivanVesselCenterlineSpatialIndex_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkNumericTraits.h"
+
+#include <vector>
+#include <map>
+
+
+namespace ivan
+{
+
+template <class TIndex> struct SegmentsWithinDistanceFunctor;
+template <class TIndex> struct NearestSegmentFunctor;
+  
+/** \class VesselCenterlineSpatialIndex
+ *  \brief Bounding volume hierarchy over the centerline segments of vessel branches.
+ *
+ * Each pair of consecutive sections of a branch defines a segment, and the vessel around it is
+ * taken as a capsule whose radius varies linearly between the radii of the two sections. 
+ * Single section branches give a sphere. The capsules are stored in an axis-aligned bounding 
+ * box hierarchy, so queries only test the capsules near the query point. The section type 
+ * must provide GetCenter() and GetRadius(), as CircularVesselSection does.
+ *
+ * The distance of a point to a capsule is measured from its surface, so it is negative 
+ * inside. FindSegmentsWithinDistance() with zero distance finds the capsules containing a 
+ * point, for example to find the branch of a voxel, and FindNearestSegment() serves for 
+ * picking.
+ *
+ * The index can be built from a VesselGraph or branch by branch. AppendSections() indexes
+ * the sections added to a branch since it was last indexed, which lets a tracker check for 
+ * collisions with the vessels tracked so far (see CollisionVesselTrackerEndCondition). New 
+ * segments are tested linearly until they fill a leaf, and then the queries insert them as a
+ * batch with a hierarchy of its own. A batch that is not smaller than half the previous one is
+ * merged with it, so there are at most log2(n) batches, every segment is rebuilt log2(n) times
+ * at most, and both appending and querying stay logarithmic. The index stores copies of the 
+ * centers and radii, so it must be rebuilt after editing sections.
+ *
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselCenterlineSpatialIndex : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselCenterlineSpatialIndex    Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::SectionType  SectionType;
+  typedef typename SectionType::PointType       PointType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  
+  itkStaticConstMacro( Dimension, unsigned int, PointType::PointDimension );
+  
+  /** A segment found by a query. The section index is that of the first section of the 
+    * segment, and the parameter is the position of the closest point along the segment, 
+    * from 0 to 1. */
+  struct SegmentHit
+  {
+    const BranchNodeType  *Branch;
+    unsigned int          SectionIndex;
+    double                Parameter;
+    double                Distance;
+  };
+  
+  typedef std::vector<SegmentHit>   SegmentHitContainer;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselCenterlineSpatialIndex, itk::Object );
+  
+  /** Maximum number of segments in a leaf of the hierarchy. Default is 4. */
+  itkSetClampMacro( MaximumLeafSize, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( MaximumLeafSize, unsigned int );
+  
+  /** Remove all the segments. */
+  void Clear();
+  
+  /** Index all the branches of the graph, removing the previous segments. */
+  void Build( const VesselGraphType * graph );
+  
+  /** Index the sections of the branch that are not indexed yet. If the branch has fewer 
+    * sections than were indexed, its centerline was replaced, and it is indexed again. */
+  void AppendSections( const BranchNodeType * branch );
+  
+  /** Remove the segments of the branch. */
+  void RemoveSections( const BranchNodeType * branch );
+  
+  /** Rebuild a single hierarchy with all the segments, which is the fastest to query. The
+    * segments appended since are inserted in batches by the queries. */
+  void Update();
+  
+  unsigned long GetNumberOfSegments() const
+    { return m_Segments.size(); }
+  
+  /** Number of hierarchies the segments are inserted in. */
+  unsigned long GetNumberOfBatches() const
+    { return m_Batches.size(); }
+  
+  /** Get the segments whose capsule surface is within the given distance of the point. If 
+    * a branch is excluded, its segments are not reported. Returns the number of hits. */
+  unsigned int FindSegmentsWithinDistance( const PointType & point, double distance, 
+    SegmentHitContainer & hits, const BranchNodeType * excludedBranch = 0 );
+  
+  /** Get the segment whose capsule surface is closest to the point. Returns false if there
+    * are no segments. */
+  bool FindNearestSegment( const PointType & point, SegmentHit & hit, 
+    const BranchNodeType * excludedBranch = 0 );
+  
+  /** Get a branch that contains the point, or NULL. */
+  const BranchNodeType * FindContainingBranch( const PointType & point, 
+    const BranchNodeType * excludedBranch = 0 );
+		
+protected:
+
+  VesselCenterlineSpatialIndex();
+  ~VesselCenterlineSpatialIndex() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  template <class TIndex> friend struct SegmentsWithinDistanceFunctor;
+  template <class TIndex> friend struct NearestSegmentFunctor;
+  
+  /** Capsule between two section centers. */
+  struct Segment
+  {
+    PointType             Start;
+    PointType             End;
+    double                StartRadius;
+    double                EndRadius;
+    const BranchNodeType  *Branch;
+    unsigned int          SectionIndex;
+  };
+  
+  /** Node of the hierarchy. Leaves hold a range of the ordered segments, and inner nodes have
+    * their first child right after them. */
+  struct HierarchyNode
+  {
+    double         Minimum[Dimension];
+    double         Maximum[Dimension];
+    unsigned long  First;
+    unsigned long  Count;
+    unsigned long  SecondChild;
+  };
+  
+  /** Hierarchy over a contiguous range of the ordered segments, which holds the segments 
+    * with the same range of indices. Its nodes go from its root to the root of the next 
+    * batch. */
+  struct HierarchyBatch
+  {
+    unsigned long  RootNode;
+    unsigned long  FirstSegment;
+    unsigned long  NumberOfSegments;
+  };
+  
+  void AddSegment( const BranchNodeType * branch, unsigned int sectionIndex );
+  
+  /** Build a batch with the segments appended since the last one, merging the last batches
+    * while they are not smaller than half the previous one. */
+  void InsertPendingSegments();
+  
+  /** Remove the batches from the one containing the segment, whose segments become pending
+    * again. */
+  void RemoveBatches( unsigned long segmentIndex );
+  
+  /** Build the subtree of the ordered segments in [first,first+count). */
+  void BuildNode( unsigned long first, unsigned long count );
+  
+  void ComputeBounds( const Segment & segment, double minimum[], double maximum[] ) const;
+  
+  double ComputeBoxDistance( const HierarchyNode & node, const PointType & point ) const;
+  
+  /** Signed distance from the capsule surface, and parameter of the closest axis point. */
+  double ComputeSegmentDistance( const Segment & segment, const PointType & point, 
+    double & parameter ) const;
+    
+  /** Call the functor on every segment that might be within the distance, which the functor 
+    * may reduce. */
+  template <class TFunctor>
+  void VisitSegments( const PointType & point, TFunctor & functor );
+
+private:
+
+  VesselCenterlineSpatialIndex(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  unsigned int                  m_MaximumLeafSize;
+  
+  std::vector<Segment>          m_Segments;
+  
+  /** Segment indices ordered by the hierarchy. Only the first m_NumberOfHierarchySegments 
+    * are in the batches, the rest are appended later. */
+  std::vector<unsigned long>    m_SegmentOrder;
+  unsigned long                 m_NumberOfHierarchySegments;
+  
+  std::vector<HierarchyNode>    m_Nodes;
+  std::vector<HierarchyBatch>   m_Batches;
+  
+  /** Number of sections already indexed for each branch. */
+  std::map<const BranchNodeType*,unsigned int>  m_IndexedSections;
+  
+  /** Sphere segment of the branches indexed with a single section. */
+  std::map<const BranchNodeType*,unsigned long> m_SphereSegments;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselCenterlineSpatialIndex.hxx"
+#endif
+
+#endif
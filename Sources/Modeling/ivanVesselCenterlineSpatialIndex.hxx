@@ -0,0 +1,618 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineSpatialIndex.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: bounding volume hierarchy over vessel centerline segments.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselCenterlineSpatialIndex_hxx
+#define __ivanVesselCenterlineSpatialIndex_hxx
+
+#include "ivanVesselCenterlineSpatialIndex.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <set>
+
+
+namespace ivan
+{
+
+/** Order segment indices by the center of their bounds along an axis. */
+template <class TSegment>
+struct SegmentCenterLess
+{
+  SegmentCenterLess( const std::vector<TSegment> & segments, unsigned int axis ) :
+    m_Segments( segments ), m_Axis( axis ) {}
+    
+  bool operator()( unsigned long a, unsigned long b ) const
+    {
+      return ( m_Segments[a].Start[m_Axis] + m_Segments[a].End[m_Axis] ) < 
+        ( m_Segments[b].Start[m_Axis] + m_Segments[b].End[m_Axis] );
+    }
+  
+  const std::vector<TSegment> & m_Segments;
+  unsigned int                  m_Axis;
+};
+
+
+template <class TCenterline>
+VesselCenterlineSpatialIndex<TCenterline>::VesselCenterlineSpatialIndex() :
+  m_MaximumLeafSize( 4 ),
+  m_NumberOfHierarchySegments( 0 )
+{
+
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::Clear()
+{
+  m_Segments.clear();
+  m_SegmentOrder.clear();
+  m_Nodes.clear();
+  m_Batches.clear();
+  m_IndexedSections.clear();
+  m_SphereSegments.clear();
+  m_NumberOfHierarchySegments = 0;
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::Build( const VesselGraphType * graph )
+{
+  this->Clear();
+  
+  if( !graph || graph->GetRootNode().IsNull() )
+    return;
+    
+  // Collect the branches with a depth-first traversal. Nodes with several parents are 
+  // only taken once
+  std::vector<const GraphNode*> pendingNodes( 1, graph->GetRootNode().GetPointer() );
+  std::set<const GraphNode*> visitedNodes;
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !node || !visitedNodes.insert( node ).second )
+      continue;
+      
+    const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+    
+    if( branch )
+      this->AppendSections( branch );
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+  
+  this->Update();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::AppendSections( const BranchNodeType * branch )
+{
+  if( !branch || branch->GetCenterline().IsNull() )
+    return;
+    
+  const unsigned int numberOfSections = branch->GetCenterline()->size();
+  
+  if( numberOfSections < m_IndexedSections[branch] )
+    this->RemoveSections( branch );
+    
+  unsigned int & numberOfIndexedSections = m_IndexedSections[branch];
+  
+  if( numberOfSections == numberOfIndexedSections )
+    return;
+    
+  if( numberOfIndexedSections == 0 && numberOfSections == 1 )
+  {
+    // A single section is indexed as a sphere until the next section arrives
+    m_SphereSegments[branch] = m_Segments.size();
+    this->AddSegment( branch, 0 );
+    numberOfIndexedSections = 1;
+    this->Modified();
+    return;
+  }
+  
+  unsigned int firstSegment = numberOfIndexedSections > 0 ? numberOfIndexedSections - 1 : 0;
+  
+  typename std::map<const BranchNodeType*,unsigned long>::iterator sphere = 
+    m_SphereSegments.find( branch );
+    
+  if( sphere != m_SphereSegments.end() )
+  {
+    // Turn the sphere into the first segment
+    Segment & segment = m_Segments[sphere->second];
+    const SectionType *section = branch->GetCenterline()->at(1);
+    segment.End = section->GetCenter();
+    segment.EndRadius = section->GetRadius();
+    
+    // Its bounds grow, so the batch containing it must be rebuilt
+    if( sphere->second < m_NumberOfHierarchySegments )
+      this->RemoveBatches( sphere->second );
+      
+    m_SphereSegments.erase( sphere );
+    firstSegment = 1;
+  }
+  
+  for( unsigned int i=firstSegment; i+1<numberOfSections; ++i )
+    this->AddSegment( branch, i );
+    
+  numberOfIndexedSections = numberOfSections;
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::RemoveSections( const BranchNodeType * branch )
+{
+  if( m_IndexedSections.erase( branch ) == 0 )
+    return;
+    
+  m_SphereSegments.erase( branch );
+  
+  // Compact the segments, keeping track of where the remaining spheres go
+  std::vector<unsigned long> newIndices( m_Segments.size() );
+  unsigned long numberOfSegments = 0;
+  
+  for( unsigned long i=0; i<m_Segments.size(); ++i )
+  {
+    newIndices[i] = numberOfSegments;
+    
+    if( m_Segments[i].Branch != branch )
+      m_Segments[numberOfSegments++] = m_Segments[i];
+  }
+  
+  m_Segments.resize( numberOfSegments );
+  
+  typename std::map<const BranchNodeType*,unsigned long>::iterator it;
+  for( it = m_SphereSegments.begin(); it != m_SphereSegments.end(); ++it )
+    it->second = newIndices[it->second];
+    
+  // Inserted again by the next query
+  m_SegmentOrder.resize( numberOfSegments );
+  for( unsigned long i=0; i<numberOfSegments; ++i )
+    m_SegmentOrder[i] = i;
+    
+  m_Nodes.clear();
+  m_Batches.clear();
+  m_NumberOfHierarchySegments = 0;
+  
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::AddSegment( const BranchNodeType * branch, 
+  unsigned int sectionIndex )
+{
+  const CenterlineType *centerline = branch->GetCenterline();
+  const SectionType *start = centerline->at( sectionIndex );
+  const SectionType *end = 
+    sectionIndex + 1 < centerline->size() ? centerline->at( sectionIndex + 1 ).GetPointer() : start;
+  
+  Segment segment;
+  segment.Start = start->GetCenter();
+  segment.End = end->GetCenter();
+  segment.StartRadius = start->GetRadius();
+  segment.EndRadius = end->GetRadius();
+  segment.Branch = branch;
+  segment.SectionIndex = sectionIndex;
+  
+  m_SegmentOrder.push_back( m_Segments.size() );
+  m_Segments.push_back( segment );
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::Update()
+{
+  m_Nodes.clear();
+  m_Batches.clear();
+  
+  m_SegmentOrder.resize( m_Segments.size() );
+  for( unsigned long i=0; i<m_Segments.size(); ++i )
+    m_SegmentOrder[i] = i;
+    
+  m_NumberOfHierarchySegments = 0;
+  
+  if( m_Segments.size() )
+  {
+    m_Nodes.reserve( 2 * m_Segments.size() / m_MaximumLeafSize + 1 );
+    this->InsertPendingSegments();
+  }
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::InsertPendingSegments()
+{
+  const unsigned long numberOfPendingSegments = m_Segments.size() - m_NumberOfHierarchySegments;
+  
+  if( numberOfPendingSegments == 0 )
+    return;
+    
+  // Appended segments are at the end of the order, with indices equal to their positions, so 
+  // every batch holds a contiguous range of both
+  HierarchyBatch batch;
+  batch.RootNode = m_Nodes.size();
+  batch.FirstSegment = m_NumberOfHierarchySegments;
+  batch.NumberOfSegments = numberOfPendingSegments;
+  
+  while( !m_Batches.empty() && 2 * batch.NumberOfSegments >= m_Batches.back().NumberOfSegments )
+  {
+    // The nodes of the last batch are the last ones, so they are replaced by the merged batch
+    batch.RootNode = m_Batches.back().RootNode;
+    batch.FirstSegment = m_Batches.back().FirstSegment;
+    batch.NumberOfSegments += m_Batches.back().NumberOfSegments;
+    m_Batches.pop_back();
+  }
+  
+  m_Nodes.resize( batch.RootNode );
+  this->BuildNode( batch.FirstSegment, batch.NumberOfSegments );
+  
+  m_Batches.push_back( batch );
+  m_NumberOfHierarchySegments = m_Segments.size();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::RemoveBatches( unsigned long segmentIndex )
+{
+  while( !m_Batches.empty() && m_Batches.back().FirstSegment > segmentIndex )
+    m_Batches.pop_back();
+    
+  if( m_Batches.empty() )
+  {
+    m_Nodes.clear();
+    m_NumberOfHierarchySegments = 0;
+    return;
+  }
+  
+  m_Nodes.resize( m_Batches.back().RootNode );
+  m_NumberOfHierarchySegments = m_Batches.back().FirstSegment;
+  m_Batches.pop_back();
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::BuildNode( unsigned long first, unsigned long count )
+{
+  const unsigned long nodeIndex = m_Nodes.size();
+  m_Nodes.push_back( HierarchyNode() );
+  
+  HierarchyNode node;
+  node.First = first;
+  node.Count = count;
+  node.SecondChild = 0;
+  
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    node.Minimum[d] = itk::NumericTraits<double>::max();
+    node.Maximum[d] = -itk::NumericTraits<double>::max();
+  }
+  
+  double centerMinimum[Dimension];
+  double centerMaximum[Dimension];
+  
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    centerMinimum[d] = itk::NumericTraits<double>::max();
+    centerMaximum[d] = -itk::NumericTraits<double>::max();
+  }
+  
+  for( unsigned long i=first; i<first+count; ++i )
+  {
+    const Segment & segment = m_Segments[ m_SegmentOrder[i] ];
+    
+    double minimum[Dimension];
+    double maximum[Dimension];
+    this->ComputeBounds( segment, minimum, maximum );
+    
+    for( unsigned int d=0; d<Dimension; ++d )
+    {
+      node.Minimum[d] = std::min( node.Minimum[d], minimum[d] );
+      node.Maximum[d] = std::max( node.Maximum[d], maximum[d] );
+      
+      const double center = 0.5 * ( segment.Start[d] + segment.End[d] );
+      centerMinimum[d] = std::min( centerMinimum[d], center );
+      centerMaximum[d] = std::max( centerMaximum[d], center );
+    }
+  }
+  
+  if( count > m_MaximumLeafSize )
+  {
+    // Median split along the axis where the segment centers spread the most
+    unsigned int axis = 0;
+    for( unsigned int d=1; d<Dimension; ++d )
+    {
+      if( centerMaximum[d] - centerMinimum[d] > centerMaximum[axis] - centerMinimum[axis] )
+        axis = d;
+    }
+    
+    const unsigned long half = count / 2;
+    std::nth_element( m_SegmentOrder.begin() + first, m_SegmentOrder.begin() + first + half, 
+      m_SegmentOrder.begin() + first + count, SegmentCenterLess<Segment>( m_Segments, axis ) );
+    
+    node.Count = 0;
+    this->BuildNode( first, half );
+    node.SecondChild = m_Nodes.size();
+    this->BuildNode( first + half, count - half );
+  }
+  
+  m_Nodes[nodeIndex] = node;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::ComputeBounds( const Segment & segment, 
+  double minimum[], double maximum[] ) const
+{
+  // The radius varies linearly, so the extremes are at the ends
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    minimum[d] = std::min( segment.Start[d] - segment.StartRadius, segment.End[d] - segment.EndRadius );
+    maximum[d] = std::max( segment.Start[d] + segment.StartRadius, segment.End[d] + segment.EndRadius );
+  }
+}
+
+
+template <class TCenterline>
+double VesselCenterlineSpatialIndex<TCenterline>::ComputeBoxDistance( const HierarchyNode & node, 
+  const PointType & point ) const
+{
+  double squaredDistance = 0.0;
+  
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    double delta = 0.0;
+    if( point[d] < node.Minimum[d] )
+      delta = node.Minimum[d] - point[d];
+    else if( point[d] > node.Maximum[d] )
+      delta = point[d] - node.Maximum[d];
+    squaredDistance += delta * delta;
+  }
+  
+  return vcl_sqrt( squaredDistance );
+}
+
+
+template <class TCenterline>
+double VesselCenterlineSpatialIndex<TCenterline>::ComputeSegmentDistance( const Segment & segment, 
+  const PointType & point, double & parameter ) const
+{
+  typename PointType::VectorType axis = segment.End - segment.Start;
+  const double squaredLength = axis.GetSquaredNorm();
+  
+  parameter = 0.0;
+  if( squaredLength > 0.0 )
+  {
+    parameter = ( ( point - segment.Start ) * axis ) / squaredLength;
+    parameter = std::max( 0.0, std::min( 1.0, parameter ) );
+  }
+  
+  PointType closest = segment.Start + axis * parameter;
+  const double radius = segment.StartRadius + parameter * ( segment.EndRadius - segment.StartRadius );
+  
+  return point.EuclideanDistanceTo( closest ) - radius;
+}
+
+
+template <class TCenterline>
+template <class TFunctor>
+void VesselCenterlineSpatialIndex<TCenterline>::VisitSegments( const PointType & point, 
+  TFunctor & functor )
+{
+  // Insert the segments outside the hierarchy once they fill a leaf, so at most a leaf is 
+  // tested one by one
+  if( m_Segments.size() - m_NumberOfHierarchySegments > m_MaximumLeafSize )
+    this->InsertPendingSegments();
+    
+  for( unsigned long i=m_NumberOfHierarchySegments; i<m_Segments.size(); ++i )
+    functor( m_Segments[i] );
+    
+  std::vector<unsigned long> pendingNodes;
+  
+  for( unsigned long i=0; i<m_Batches.size(); ++i )
+    pendingNodes.push_back( m_Batches[i].RootNode );
+  
+  while( !pendingNodes.empty() )
+  {
+    const HierarchyNode & node = m_Nodes[ pendingNodes.back() ];
+    const unsigned long nodeIndex = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( this->ComputeBoxDistance( node, point ) > functor.GetMaximumDistance() )
+      continue;
+      
+    if( node.Count )
+    {
+      for( unsigned long i=node.First; i<node.First+node.Count; ++i )
+        functor( m_Segments[ m_SegmentOrder[i] ] );
+    }
+    else
+    {
+      pendingNodes.push_back( node.SecondChild );
+      pendingNodes.push_back( nodeIndex + 1 );
+    }
+  }
+}
+
+
+/** Collects the segments within a distance. */
+template <class TIndex>
+struct SegmentsWithinDistanceFunctor
+{
+  typedef typename TIndex::SegmentHit  SegmentHit;
+  
+  template <class TSegment>
+  void operator()( const TSegment & segment )
+    {
+      if( segment.Branch == ExcludedBranch )
+        return;
+        
+      SegmentHit hit;
+      hit.Distance = Index->ComputeSegmentDistance( segment, *Point, hit.Parameter );
+      
+      if( hit.Distance <= MaximumDistance )
+      {
+        hit.Branch = segment.Branch;
+        hit.SectionIndex = segment.SectionIndex;
+        Hits->push_back( hit );
+      }
+    }
+    
+  double GetMaximumDistance() const
+    { return MaximumDistance; }
+  
+  const TIndex                             *Index;
+  const typename TIndex::PointType         *Point;
+  const typename TIndex::BranchNodeType    *ExcludedBranch;
+  double                                   MaximumDistance;
+  typename TIndex::SegmentHitContainer     *Hits;
+};
+
+
+/** Keeps the nearest segment, shrinking the search distance. */
+template <class TIndex>
+struct NearestSegmentFunctor
+{
+  typedef typename TIndex::SegmentHit  SegmentHit;
+  
+  template <class TSegment>
+  void operator()( const TSegment & segment )
+    {
+      if( segment.Branch == ExcludedBranch )
+        return;
+      
+      double parameter;
+      const double distance = Index->ComputeSegmentDistance( segment, *Point, parameter );
+      
+      if( !Found || distance < Hit.Distance )
+      {
+        Found = true;
+        Hit.Branch = segment.Branch;
+        Hit.SectionIndex = segment.SectionIndex;
+        Hit.Parameter = parameter;
+        Hit.Distance = distance;
+      }
+    }
+    
+  double GetMaximumDistance() const
+    { return Found ? Hit.Distance : itk::NumericTraits<double>::max(); }
+  
+  const TIndex                             *Index;
+  const typename TIndex::PointType         *Point;
+  const typename TIndex::BranchNodeType    *ExcludedBranch;
+  bool                                     Found;
+  SegmentHit                               Hit;
+};
+
+
+template <class TCenterline>
+unsigned int VesselCenterlineSpatialIndex<TCenterline>::FindSegmentsWithinDistance( 
+  const PointType & point, double distance, SegmentHitContainer & hits, 
+  const BranchNodeType * excludedBranch )
+{
+  hits.clear();
+  
+  SegmentsWithinDistanceFunctor<Self> functor;
+  functor.Index = this;
+  functor.Point = &point;
+  functor.ExcludedBranch = excludedBranch;
+  functor.MaximumDistance = distance;
+  functor.Hits = &hits;
+  
+  this->VisitSegments( point, functor );
+  
+  return hits.size();
+}
+
+
+template <class TCenterline>
+bool VesselCenterlineSpatialIndex<TCenterline>::FindNearestSegment( const PointType & point, 
+  SegmentHit & hit, const BranchNodeType * excludedBranch )
+{
+  NearestSegmentFunctor<Self> functor;
+  functor.Index = this;
+  functor.Point = &point;
+  functor.ExcludedBranch = excludedBranch;
+  functor.Found = false;
+  
+  this->VisitSegments( point, functor );
+  
+  if( functor.Found )
+    hit = functor.Hit;
+    
+  return functor.Found;
+}
+
+
+template <class TCenterline>
+const typename VesselCenterlineSpatialIndex<TCenterline>::BranchNodeType * 
+VesselCenterlineSpatialIndex<TCenterline>::FindContainingBranch( const PointType & point, 
+  const BranchNodeType * excludedBranch )
+{
+  SegmentHitContainer hits;
+  
+  if( !this->FindSegmentsWithinDistance( point, 0.0, hits, excludedBranch ) )
+    return 0;
+    
+  // Take the branch whose axis is deepest inside
+  unsigned int deepest = 0;
+  for( unsigned int i=1; i<hits.size(); ++i )
+  {
+    if( hits[i].Distance < hits[deepest].Distance )
+      deepest = i;
+  }
+  
+  return hits[deepest].Branch;
+}
+
+
+template <class TCenterline>
+void VesselCenterlineSpatialIndex<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "MaximumLeafSize: " << m_MaximumLeafSize << std::endl;
+  os << indent << "NumberOfSegments: " << m_Segments.size() << std::endl;
+  os << indent << "NumberOfHierarchySegments: " << m_NumberOfHierarchySegments << std::endl;
+  os << indent << "NumberOfHierarchyNodes: " << m_Nodes.size() << std::endl;
+  os << indent << "NumberOfHierarchyBatches: " << m_Batches.size() << std::endl;
+  os << indent << "NumberOfBranches: " << m_IndexedSections.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,244 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselFeatureDetector.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: detect stenosis and aneurysm candidates along the branches of a graph
+// Date: 2012/11/05
+
+#ifndef __ivanVesselFeatureDetector_h
+#define __ivanVesselFeatureDetector_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselFeatureNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselFeatureDetector
+ *  \brief Detect stenosis and aneurysm candidates along the branches of a VesselGraph.
+ *
+ * The radius of every section is compared with a reference radius of the healthy vessel, 
+ * computed over a sliding window of ReferenceWindowLength in arclength centered at the 
+ * section. By default the reference is the median radius in the window, computed in 
+ * O(n log w) per branch for windows of w sections, which is not affected by features shorter 
+ * than half the window. The maximum, for stenoses, and the minimum, for aneurysms, can be used
+ * instead, computed with monotonic deques in linear time, when features are further apart 
+ * than the window, since otherwise the healthy vessel next to an aneurysm is taken for a 
+ * stenosis and the other way round.
+ *
+ * Runs of consecutive sections whose radius is below (1 - StenosisThreshold) times the 
+ * reference are stenosis candidates, and runs above AneurysmThreshold times the reference are 
+ * aneurysm candidates, if they have at least MinimumNumberOfSections sections. Each candidate
+ * gives a VesselFeatureNode whose feature region is the section range in the branch, with a 
+ * StenosisModel or an AneurysmModel holding the extreme and reference radii. The features are
+ * given in the order of the branches in a depth-first traversal, and along every branch.
+ * If AttachFeatureNodes is on, they are also added as children of their branch.
+ *
+ * Branches are processed in parallel, taken from a shared counter, longest first. Branches 
+ * must have node ids for the feature regions to be meaningful.
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
+ * \sa StenosisModel
+ * \sa AneurysmModel
+ *
+ * \ingroup 
+ */
+
+template <class TCenterline>
+class ITK_EXPORT VesselFeatureDetector : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselFeatureDetector             Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+ 
+  typedef TCenterline                                 CenterlineType;
+  typedef typename CenterlineType::SectionType        SectionType;
+  typedef VesselGraph<CenterlineType>                 VesselGraphType;
+  typedef VesselBranchNode<CenterlineType>            BranchNodeType;
+  
+  typedef std::vector<VesselFeatureNode::Pointer>     FeatureNodeContainerType;
+  
+  /** Statistic of the radius in the window used as reference. */
+  typedef enum { MaximumReference, MinimumReference, MedianReference }  ReferenceType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselFeatureDetector, itk::Object );
+  
+  /** Set/Get the length in arclength of the window of the reference radius. Default is 20.0. */
+  itkSetMacro( ReferenceWindowLength, double );
+  itkGetConstMacro( ReferenceWindowLength, double );
+  
+  /** Set/Get the reference of stenoses and aneurysms. Default is MedianReference for both. */
+  itkSetMacro( StenosisReference, ReferenceType );
+  itkGetConstMacro( StenosisReference, ReferenceType );
+  itkSetMacro( AneurysmReference, ReferenceType );
+  itkGetConstMacro( AneurysmReference, ReferenceType );
+  
+  /** Set/Get the minimum relative reduction of the radius of stenoses. Default is 0.5. */
+  itkSetMacro( StenosisThreshold, double );
+  itkGetConstMacro( StenosisThreshold, double );
+  
+  /** Set/Get the minimum ratio of the radius of aneurysms to the reference. Default is 1.5. */
+  itkSetMacro( AneurysmThreshold, double );
+  itkGetConstMacro( AneurysmThreshold, double );
+  
+  /** Flags for detecting stenoses and aneurysms. Default is true for both. */
+  itkSetMacro( DetectStenoses, bool );
+  itkGetConstMacro( DetectStenoses, bool );
+  itkBooleanMacro( DetectStenoses );
+  itkSetMacro( DetectAneurysms, bool );
+  itkGetConstMacro( DetectAneurysms, bool );
+  itkBooleanMacro( DetectAneurysms );
+  
+  /** Set/Get the minimum number of sections of a candidate. Default is 1. */
+  itkSetClampMacro( MinimumNumberOfSections, unsigned int, 1, 
+    itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( MinimumNumberOfSections, unsigned int );
+  
+  /** Flag for adding the feature nodes as children of their branch. Default is false. */
+  itkSetMacro( AttachFeatureNodes, bool );
+  itkGetConstMacro( AttachFeatureNodes, bool );
+  itkBooleanMacro( AttachFeatureNodes );
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Detect the features of all the branches of the graph. */
+  void Detect( VesselGraphType *graph )
+    { this->Detect( graph->GetRootNode() ); }
+  
+  /** Detect the features of all the branches reachable from the given node. */
+  void Detect( GraphNode *root );
+  
+  /** Get the feature nodes found by the last call to Detect(). */
+  const FeatureNodeContainerType & GetFeatureNodes() const
+    { return m_FeatureNodes; }
+  
+  /** Get the number of stenoses and aneurysms found by the last call to Detect(). */
+  itkGetConstMacro( NumberOfStenoses, unsigned int );
+  itkGetConstMacro( NumberOfAneurysms, unsigned int );
+  
+  /** Compute the reference of every value over the window of the given length centered at 
+    * its position. Positions must be non-decreasing. */
+  static void ComputeReference( const std::vector<double> & positions, 
+    const std::vector<double> & values, double windowLength, ReferenceType reference, 
+    std::vector<double> & referenceValues );
+		
+protected:
+
+  VesselFeatureDetector();
+  ~VesselFeatureDetector() {}
+  
+  /** Candidate found in a branch. */
+  struct Candidate
+  {
+    bool          Stenosis;
+    unsigned int  FirstSection;
+    unsigned int  LastSection;
+    double        ExtremeRadius;
+    double        ReferenceRadius;
+  };
+  
+  typedef std::vector<Candidate>   CandidateContainerType;
+  
+  /** Detect the candidates of a branch. */
+  void DetectBranch( unsigned int branch );
+  
+  /** Append the runs of sections where the ratio of the radius to the reference passes the 
+    * threshold, from below if stenosis is true or from above otherwise. */
+  void FindCandidates( const std::vector<double> & radii, const std::vector<double> & reference,
+    bool stenosis, CandidateContainerType & candidates ) const;
+  
+  /** Create the feature node of a candidate. */
+  VesselFeatureNode::Pointer CreateFeatureNode( const BranchNodeType *branch, 
+    const Candidate & candidate ) const;
+  
+  /** Detect the branches taken from the shared counter until there are no more. */
+  void ThreadedDetect();
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DetectThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  VesselFeatureDetector(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  double                          m_ReferenceWindowLength;
+  ReferenceType                   m_StenosisReference;
+  ReferenceType                   m_AneurysmReference;
+  double                          m_StenosisThreshold;
+  double                          m_AneurysmThreshold;
+  bool                            m_DetectStenoses;
+  bool                            m_DetectAneurysms;
+  unsigned int                    m_MinimumNumberOfSections;
+  bool                            m_AttachFeatureNodes;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  /** State of the current detection. */
+  std::vector<BranchNodeType*>          m_Branches;
+  std::vector<CandidateContainerType>   m_Candidates;
+  unsigned int                          m_NextBranch;
+  itk::SimpleFastMutexLock              m_BranchMutex;
+  
+  FeatureNodeContainerType        m_FeatureNodes;
+  unsigned int                    m_NumberOfStenoses;
+  unsigned int                    m_NumberOfAneurysms;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselFeatureDetector.hxx"
+#endif
+
+#endif
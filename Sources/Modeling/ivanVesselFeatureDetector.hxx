@@ -0,0 +1,442 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselFeatureDetector.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: detect stenosis and aneurysm candidates along the branches of a graph
+// Date: 2012/11/05
+
+#ifndef __ivanVesselFeatureDetector_hxx
+#define __ivanVesselFeatureDetector_hxx
+
+#include "ivanVesselFeatureDetector.h"
+#include "ivanVesselGraphCenterlineProcessor.h"
+#include "ivanStenosisModel.h"
+#include "ivanAneurysmModel.h"
+
+#include <vnl/vnl_math.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <sstream>
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselFeatureDetector<TCenterline>::VesselFeatureDetector() :
+  m_ReferenceWindowLength( 20.0 ),
+  m_StenosisReference( MedianReference ),
+  m_AneurysmReference( MedianReference ),
+  m_StenosisThreshold( 0.5 ),
+  m_AneurysmThreshold( 1.5 ),
+  m_DetectStenoses( true ),
+  m_DetectAneurysms( true ),
+  m_MinimumNumberOfSections( 1 ),
+  m_AttachFeatureNodes( false ),
+  m_NextBranch( 0 ),
+  m_NumberOfStenoses( 0 ),
+  m_NumberOfAneurysms( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::Detect( GraphNode *root )
+{
+  m_Branches.clear();
+  m_FeatureNodes.clear();
+  m_NumberOfStenoses = 0;
+  m_NumberOfAneurysms = 0;
+  
+  if( !root )
+    return;
+  
+  // Collect the branches with a depth-first traversal. Nodes with several parents
+  // are only taken once
+  std::vector<GraphNode*> pendingNodes;
+  std::set<GraphNode*> visitedNodes;
+  
+  pendingNodes.push_back( root );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !visitedNodes.insert( node ).second )
+      continue;
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && branch->GetCenterline().IsNotNull() )
+      m_Branches.push_back( branch );
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+  
+  // Threads take the longest branches first, the results are kept in traversal order
+  std::vector<BranchNodeType*> traversalBranches( m_Branches );
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), VesselBranchLongerThan<BranchNodeType>() );
+  
+  m_Candidates.clear();
+  m_Candidates.resize( m_Branches.size() );
+  m_NextBranch = 0;
+  
+  if( m_Branches.size() > 1 )
+  {
+    m_Threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, (int)m_Branches.size() ) );
+    m_Threader->SetSingleMethod( this->DetectThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedDetect();
+  }
+  
+  // Create the nodes serially, since they change the graph
+  std::map<BranchNodeType*,unsigned int> branchIndices;
+  
+  for( unsigned int i=0; i<m_Branches.size(); ++i )
+    branchIndices[ m_Branches[i] ] = i;
+  
+  for( unsigned int i=0; i<traversalBranches.size(); ++i )
+  {
+    BranchNodeType *branch = traversalBranches[i];
+    const CandidateContainerType & candidates = m_Candidates[ branchIndices[branch] ];
+    
+    for( unsigned int c=0; c<candidates.size(); ++c )
+    {
+      VesselFeatureNode::Pointer featureNode = this->CreateFeatureNode( branch, candidates[c] );
+      
+      if( candidates[c].Stenosis )
+        ++m_NumberOfStenoses;
+      else
+        ++m_NumberOfAneurysms;
+      
+      if( m_AttachFeatureNodes )
+        branch->AddChild( featureNode );
+      
+      m_FeatureNodes.push_back( featureNode );
+    }
+  }
+  
+  m_Branches.clear();
+  m_Candidates.clear();
+}
+
+
+template <class TCenterline>
+ITK_THREAD_RETURN_TYPE
+VesselFeatureDetector<TCenterline>::DetectThreaderCallback( void *arg )
+{
+  Self *detector = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  detector->ThreadedDetect();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::ThreadedDetect()
+{
+  unsigned int branch;
+  bool found;
+  
+  while( true )
+  {
+    m_BranchMutex.Lock();
+    found = ( m_NextBranch < m_Branches.size() );
+    if( found )
+      branch = m_NextBranch++;
+    m_BranchMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    this->DetectBranch( branch );
+  }
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::DetectBranch( unsigned int branch )
+{
+  const CenterlineType *centerline = m_Branches[branch]->GetCenterline();
+  const unsigned int numberOfSections = centerline->size();
+  
+  if( !numberOfSections )
+    return;
+  
+  std::vector<double> arclengths( numberOfSections, 0.0 );
+  std::vector<double> radii( numberOfSections );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const SectionType *section = centerline->at(i);
+    
+    radii[i] = section->GetRadius();
+    
+    if( i > 0 )
+    {
+      arclengths[i] = arclengths[i-1] + 
+        section->GetCenter().EuclideanDistanceTo( centerline->at(i-1)->GetCenter() );
+    }
+  }
+  
+  CandidateContainerType & candidates = m_Candidates[branch];
+  std::vector<double> reference;
+  
+  if( m_DetectStenoses )
+  {
+    this->ComputeReference( arclengths, radii, m_ReferenceWindowLength, m_StenosisReference, 
+      reference );
+    this->FindCandidates( radii, reference, true, candidates );
+  }
+  
+  if( m_DetectAneurysms )
+  {
+    // Reuse the reference if it is the same statistic
+    if( !m_DetectStenoses || m_AneurysmReference != m_StenosisReference )
+    {
+      this->ComputeReference( arclengths, radii, m_ReferenceWindowLength, m_AneurysmReference, 
+        reference );
+    }
+    
+    this->FindCandidates( radii, reference, false, candidates );
+  }
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::ComputeReference( const std::vector<double> & positions, 
+  const std::vector<double> & values, double windowLength, ReferenceType reference, 
+  std::vector<double> & referenceValues )
+{
+  const unsigned int numberOfValues = values.size();
+  const double halfLength = 0.5 * windowLength;
+  
+  referenceValues.resize( numberOfValues );
+  
+  // Window [first,last) for the value at i, both ends only move forward
+  unsigned int first = 0, last = 0;
+  
+  if( reference == MedianReference )
+  {
+    // Lower and upper halves of the window, the lower one keeps the extra value
+    std::multiset<double> lower, upper;
+    
+    for( unsigned int i=0; i<numberOfValues; ++i )
+    {
+      while( last < numberOfValues && positions[last] <= positions[i] + halfLength )
+      {
+        if( lower.empty() || values[last] <= *lower.rbegin() )
+          lower.insert( values[last] );
+        else
+          upper.insert( values[last] );
+        
+        ++last;
+      }
+      
+      while( positions[first] < positions[i] - halfLength )
+      {
+        // Equal values are interchangeable, so a copy is always found in the lower half if the 
+        // value is not larger than its maximum
+        if( values[first] <= *lower.rbegin() )
+          lower.erase( lower.find( values[first] ) );
+        else
+          upper.erase( upper.find( values[first] ) );
+        
+        ++first;
+        
+        if( lower.empty() && !upper.empty() )
+        {
+          lower.insert( *upper.begin() );
+          upper.erase( upper.begin() );
+        }
+      }
+      
+      while( lower.size() > upper.size() + 1 )
+      {
+        upper.insert( *lower.rbegin() );
+        lower.erase( --lower.end() );
+      }
+      
+      while( upper.size() > lower.size() )
+      {
+        lower.insert( *upper.begin() );
+        upper.erase( upper.begin() );
+      }
+      
+      referenceValues[i] = ( lower.size() > upper.size() ) ? 
+        *lower.rbegin() : 0.5 * ( *lower.rbegin() + *upper.begin() );
+    }
+    
+    return;
+  }
+  
+  // Monotonic deque of the indices in the window, whose values decrease for the maximum, or 
+  // increase for the minimum, so the front is the reference
+  const bool maximum = ( reference == MaximumReference );
+  std::deque<unsigned int> window;
+  
+  for( unsigned int i=0; i<numberOfValues; ++i )
+  {
+    while( last < numberOfValues && positions[last] <= positions[i] + halfLength )
+    {
+      while( !window.empty() && ( maximum ? values[ window.back() ] <= values[last] : 
+                                            values[ window.back() ] >= values[last] ) )
+        window.pop_back();
+      
+      window.push_back( last++ );
+    }
+    
+    while( positions[ window.front() ] < positions[i] - halfLength )
+      window.pop_front();
+    
+    referenceValues[i] = values[ window.front() ];
+  }
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::FindCandidates( const std::vector<double> & radii, 
+  const std::vector<double> & reference, bool stenosis, CandidateContainerType & candidates ) const
+{
+  const unsigned int numberOfSections = radii.size();
+  
+  unsigned int i = 0;
+  
+  while( i < numberOfSections )
+  {
+    // Find the next run of sections passing the threshold
+    unsigned int runEnd = i;
+    
+    while( runEnd < numberOfSections && 
+           ( stenosis ? radii[runEnd] <= ( 1.0 - m_StenosisThreshold ) * reference[runEnd] :
+                        radii[runEnd] >= m_AneurysmThreshold * reference[runEnd] ) &&
+           reference[runEnd] > 0.0 )
+      ++runEnd;
+    
+    if( runEnd == i )
+    {
+      ++i;
+      continue;
+    }
+    
+    if( runEnd - i >= m_MinimumNumberOfSections )
+    {
+      Candidate candidate;
+      candidate.Stenosis = stenosis;
+      candidate.FirstSection = i;
+      candidate.LastSection = runEnd - 1;
+      
+      // The reference at the extreme section
+      unsigned int extreme = i;
+      
+      for( unsigned int j=i+1; j<runEnd; ++j )
+      {
+        if( stenosis ? radii[j] < radii[extreme] : radii[j] > radii[extreme] )
+          extreme = j;
+      }
+      
+      candidate.ExtremeRadius = radii[extreme];
+      candidate.ReferenceRadius = reference[extreme];
+      
+      candidates.push_back( candidate );
+    }
+    
+    i = runEnd;
+  }
+}
+
+
+template <class TCenterline>
+VesselFeatureNode::Pointer VesselFeatureDetector<TCenterline>::CreateFeatureNode
+  ( const BranchNodeType *branch, const Candidate & candidate ) const
+{
+  VesselFeatureNode::Pointer featureNode = VesselFeatureNode::New();
+  
+  VesselRegion region;
+  region.Insert( branch->GetNodeId(), candidate.FirstSection, candidate.LastSection );
+  featureNode->SetFeatureRegion( region );
+  
+  std::ostringstream description;
+  
+  if( candidate.Stenosis )
+  {
+    StenosisModel::Pointer model = StenosisModel::New();
+    model->SetReferenceRadius( candidate.ReferenceRadius );
+    model->SetMinimumRadius( candidate.ExtremeRadius );
+    featureNode->SetFeatureModel( model );
+    
+    description << "Stenosis of " << vnl_math_rnd( 100.0 * model->GetDegree() ) << "%";
+  }
+  else
+  {
+    AneurysmModel::Pointer model = AneurysmModel::New();
+    model->SetReferenceRadius( candidate.ReferenceRadius );
+    model->SetMaximumRadius( candidate.ExtremeRadius );
+    featureNode->SetFeatureModel( model );
+    
+    description << "Aneurysm of " << model->GetDilationRatio() << " times the reference radius";
+  }
+  
+  featureNode->SetDescription( description.str() );
+  
+  return featureNode;
+}
+
+
+template <class TCenterline>
+void VesselFeatureDetector<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "ReferenceWindowLength: " << m_ReferenceWindowLength << std::endl;
+  os << indent << "StenosisReference: " << m_StenosisReference << std::endl;
+  os << indent << "AneurysmReference: " << m_AneurysmReference << std::endl;
+  os << indent << "StenosisThreshold: " << m_StenosisThreshold << std::endl;
+  os << indent << "AneurysmThreshold: " << m_AneurysmThreshold << std::endl;
+  os << indent << "DetectStenoses: " << m_DetectStenoses << std::endl;
+  os << indent << "DetectAneurysms: " << m_DetectAneurysms << std::endl;
+  os << indent << "MinimumNumberOfSections: " << m_MinimumNumberOfSections << std::endl;
+  os << indent << "AttachFeatureNodes: " << m_AttachFeatureNodes << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfStenoses: " << m_NumberOfStenoses << std::endl;
+  os << indent << "NumberOfAneurysms: " << m_NumberOfAneurysms << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -46,6 +46,21 @@ VesselFeatureNode::~VesselFeatureNode()
 }
 
 
+void VesselFeatureNode::CopyInformation( const GraphNode * node )
+{
+  Superclass::CopyInformation( node );
+  
+  const Self *featureNode = dynamic_cast<const Self*>( node );
+  
+  if( featureNode )
+  {
+    m_FeatureModel = featureNode->m_FeatureModel;
+    m_FeatureRegion = featureNode->m_FeatureRegion;
+    m_Description = featureNode->m_Description;
+  }
+}
+
+
 void VesselFeatureNode::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
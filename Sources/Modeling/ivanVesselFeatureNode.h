@@ -103,6 +103,10 @@ public:
     { return m_FeatureModel; }
   const VesselFeatureModel * GetFeatureModel() const
     { return m_FeatureModel; }
+    
+  /** Copy the region and description and share the feature model of the given node, if it 
+    * is a feature node. */
+  virtual void CopyInformation( const GraphNode * node );
       
 protected:
   
@@ -30,8 +30,19 @@ SUCH DAMAGE.
 #ifndef __ivanVesselGraph_h
 #define __ivanVesselGraph_h
 
+#include "ivanExplicitInstantiation.h"
 #include "ivanVesselDataObject.h"
 #include "ivanVesselBranchNode.h"
+#include "ivanGraphNodeIndex.h"
+#include "ivanArenaAllocator.h"
+#include "ivanSearchByIdNodeVisitor.h"
+
+#include "itkSimpleFastMutexLock.h"
+#include "itkTimeStamp.h"
+
+#include <map>
+#include <string>
+#include <vector>
 
 namespace ivan
 {
@@ -42,6 +53,27 @@ namespace ivan
  * VesselGraph represents a VesselObject whose branches are organized in
  * the form of a graph. The graph has a single root VesselNode. 
  *
+ * Optionally, the graph keeps a GraphNodeIndex of its nodes by identifier, which the nodes
+ * update themselves on structural edits. FindNodeById() then takes constant time instead of
+ * visiting the graph. 
+ *
+ * The graph also owns an ArenaAllocator. Nodes, centerlines and sections created inside an
+ * ArenaAllocator::Scope on GetArena() take their memory from it, and the memory is released in 
+ * bulk once the graph and all those objects have been destroyed. 
+ *
+ * CreateSnapshot() copies the nodes of the graph but shares the centerlines and sections with 
+ * it. Editing a branch through VesselBranchNode::GetWritableCenterline() or 
+ * GetWritableSection() copies only the touched centerline and sections, so snapshots for undo
+ * or what-if simulations cost in proportion to the nodes and the edits. The non-const 
+ * VesselBranchNode::GetCenterline() copies the whole centerline of a shared branch, since it 
+ * allows changing any section in place.
+ *
+ * GetNodes() and GetNodesOfType() return flat lists of the nodes that are cached by the graph, 
+ * so that collecting the nodes of a type does not visit the graph every time. The lists are 
+ * rebuilt once the graph or its node index have been modified. With the node index on they 
+ * follow the structural edits of the nodes. Without it, Modified() has to be called on the 
+ * graph after editing its structure.
+ *
  * \ingroup 
  *
  * 
@@ -67,6 +99,8 @@ public:
   
   typedef VesselBranchNode<TCenterline>         BranchNodeType;
   typedef typename BranchNodeType::Pointer      BranchNodePointer;
+  
+  typedef std::vector<GraphNode*>               NodeListType;
        
 public:
 
@@ -81,22 +115,100 @@ public:
     { return true; }
   
   virtual void SetRootNode( VesselNode *node )
-    { m_RootNode = node; }
+    { 
+      m_RootNode = node; 
+      if( m_NodeIndex.IsNotNull() )
+        m_NodeIndex->Build( node );
+      this->Modified();
+    }
   
   VesselNode::Pointer GetRootNode() 
     { return m_RootNode; }
   VesselNode::ConstPointer GetRootNode() const
     { return m_RootNode; }
+    
+  /** Keep an index of the nodes by identifier. Default is off. */
+  virtual void SetUseNodeIndex( bool useNodeIndex )
+    {
+      if( useNodeIndex == m_NodeIndex.IsNotNull() )
+        return;
+        
+      if( useNodeIndex )
+      {
+        m_NodeIndex = GraphNodeIndex::New();
+        m_NodeIndex->Build( m_RootNode );
+      }
+      else
+      {
+        m_NodeIndex->Clear();
+        m_NodeIndex = 0;
+      }
+      this->Modified();
+    }
+  bool GetUseNodeIndex() const
+    { return m_NodeIndex.IsNotNull(); }
+  itkBooleanMacro( UseNodeIndex );
+  
+  /** Arena for the nodes, centerlines and sections of this graph. It is created when first
+    * requested. */
+  ArenaAllocator * GetArena()
+    {
+      if( m_Arena.IsNull() )
+        m_Arena = ArenaAllocator::New();
+      return m_Arena;
+    }
+  
+  /** Get the index of the nodes, or NULL if not used. */
+  const GraphNodeIndex * GetNodeIndex() const
+    { return m_NodeIndex; }
+  
+  /** Create a new graph with copies of the nodes of this one, sharing their centerlines. 
+    * Shared nodes are copied once. */
+  Pointer CreateSnapshot() const;
+  
+  /** Get a node with the given identifier, or NULL if not found. */
+  GraphNode * FindNodeById( GraphNode::NodeIdentifier id ) const
+    {
+      if( m_RootNode.IsNull() )
+        return 0;
+        
+      if( m_NodeIndex.IsNotNull() )
+        return m_NodeIndex->FindNode( id );
+        
+      SearchByIdNodeVisitor::Pointer visitor = SearchByIdNodeVisitor::New();
+      visitor->SetNodeId( id );
+      m_RootNode->Accept( visitor );
+      
+      return visitor->GetNode();
+    }
+    
+  /** Get the nodes reachable from the root node, each once and in depth-first order. The list 
+    * is cached and stays valid until the structure of the graph is modified. */
+  const NodeListType & GetNodes() const;
+  
+  /** Get the cached nodes that are of the given type, in the same order as GetNodes(). The 
+    * list of every requested type is cached too, and stays valid until the structure of the 
+    * graph is modified. */
+  template <class TNode>
+  const std::vector<TNode*> & GetNodesOfType() const;
   		
 protected:
   
   VesselGraph() {}
-  ~VesselGraph() {}
+  ~VesselGraph();
+  
+  /** Rebuild the cached node list if the graph or its node index have been modified since it 
+    * was built. It must be called with the cache mutex locked. */
+  void UpdateNodeCache() const;
+  
+  /** Delete the cached lists of every node type. */
+  void ClearNodeTypeCaches() const;
     
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const
     {
       Superclass::PrintSelf( os, indent );
       
+      os << indent << "UseNodeIndex: " << this->GetUseNodeIndex() << std::endl;
       os << indent << "RootNode: " << m_RootNode.GetPointer() << std::endl;
       if( m_RootNode.IsNotNull() )
         m_RootNode->Print( os, indent.GetNextIndent() );  
@@ -110,8 +222,46 @@ private:
 protected:
 
   VesselNode::Pointer   m_RootNode;
+  
+  GraphNodeIndex::Pointer   m_NodeIndex;
+  
+  ArenaAllocator::Pointer   m_Arena;
+  
+  /** Cached list of the nodes of a single type. */
+  struct NodeTypeCacheBase
+  {
+    virtual ~NodeTypeCacheBase() {}
+  };
+  
+  template <class TNode>
+  struct NodeTypeCache : public NodeTypeCacheBase
+  {
+    std::vector<TNode*>  Nodes;
+  };
+  
+  typedef std::map<std::string,NodeTypeCacheBase*>  NodeTypeCacheMapType;
+  
+  mutable NodeListType                m_CachedNodes;
+  mutable NodeTypeCacheMapType        m_NodeTypeCaches;
+  mutable itk::TimeStamp              m_NodeCacheBuildTime;
+  mutable itk::SimpleFastMutexLock    m_NodeCacheMutex;
 };
 
 } // end namespace ivan
 
+// Define instantiation macro for this template.
+#define ITK_TEMPLATE_VesselGraph(_, EXPORT, x, y) namespace ivan { \
+  _(1(class EXPORT VesselGraph< ITK_TEMPLATE_1 x >)) \
+  namespace Templates { typedef VesselGraph< ITK_TEMPLATE_1 x > \
+                                                  VesselGraph##y; } \
+  }
+
+#if IVAN_TEMPLATE_EXPLICIT
+# include "Templates/ivanVesselGraph+-.h"
+#endif
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraph.hxx"
+#endif
+
 #endif
@@ -0,0 +1,207 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraph.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: vessel graph snapshots
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraph_hxx
+#define __ivanVesselGraph_hxx
+
+#include "ivanVesselGraph.h"
+
+#include <map>
+#include <set>
+#include <typeinfo>
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraph<TCenterline>::~VesselGraph()
+{
+  this->ClearNodeTypeCaches();
+}
+
+
+template <class TCenterline>
+const typename VesselGraph<TCenterline>::NodeListType &
+VesselGraph<TCenterline>::GetNodes() const
+{
+  m_NodeCacheMutex.Lock();
+  this->UpdateNodeCache();
+  m_NodeCacheMutex.Unlock();
+  
+  return m_CachedNodes;
+}
+
+
+template <class TCenterline>
+template <class TNode>
+const std::vector<TNode*> & 
+VesselGraph<TCenterline>::GetNodesOfType() const
+{
+  typedef NodeTypeCache<TNode>  CacheType;
+  
+  m_NodeCacheMutex.Lock();
+  this->UpdateNodeCache();
+  
+  // Filter the flat list the first time the type is requested since it was built
+  NodeTypeCacheBase *&entry = m_NodeTypeCaches[ typeid( TNode ).name() ];
+  
+  if( !entry )
+  {
+    CacheType *newCache = new CacheType;
+    
+    for( unsigned int i=0; i<m_CachedNodes.size(); ++i )
+    {
+      TNode *node = dynamic_cast<TNode*>( m_CachedNodes[i] );
+      if( node )
+        newCache->Nodes.push_back( node );
+    }
+    
+    entry = newCache;
+  }
+  
+  CacheType *cache = static_cast<CacheType*>( entry );
+  
+  m_NodeCacheMutex.Unlock();
+  
+  return cache->Nodes;
+}
+
+
+template <class TCenterline>
+void VesselGraph<TCenterline>::UpdateNodeCache() const
+{
+  const unsigned long buildTime = m_NodeCacheBuildTime.GetMTime();
+  
+  if( buildTime > 0 && this->GetMTime() <= buildTime && 
+    ( m_NodeIndex.IsNull() || m_NodeIndex->GetMTime() <= buildTime ) )
+    return;
+    
+  this->ClearNodeTypeCaches();
+  m_CachedNodes.clear();
+  
+  // Collect the nodes in depth-first order. Nodes with several parents are collected once
+  std::set<const GraphNode*> visitedNodes;
+  std::vector<GraphNode*> pendingNodes;
+  
+  if( m_RootNode.IsNotNull() )
+    pendingNodes.push_back( m_RootNode.GetPointer() );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !node || !visitedNodes.insert( node ).second )
+      continue;
+      
+    m_CachedNodes.push_back( node );
+    
+    for( unsigned int i = node->GetNumberOfChildren(); i > 0; --i )
+      pendingNodes.push_back( node->GetChild( i-1 ) );
+  }
+  
+  m_NodeCacheBuildTime.Modified();
+}
+
+
+template <class TCenterline>
+void VesselGraph<TCenterline>::ClearNodeTypeCaches() const
+{
+  for( typename NodeTypeCacheMapType::iterator it = m_NodeTypeCaches.begin(); 
+    it != m_NodeTypeCaches.end(); ++it )
+    delete it->second;
+    
+  m_NodeTypeCaches.clear();
+}
+
+
+template <class TCenterline>
+typename VesselGraph<TCenterline>::Pointer 
+VesselGraph<TCenterline>::CreateSnapshot() const
+{
+  Pointer snapshot = Self::New();
+  
+  if( m_RootNode.IsNull() )
+    return snapshot;
+    
+  // Copy the nodes in depth-first order. Nodes with several parents are copied once
+  typedef std::map<const GraphNode*,GraphNode::Pointer>  NodeMapType;
+  
+  NodeMapType copies;
+  std::vector<const GraphNode*> nodes;
+  std::vector<const GraphNode*> pendingNodes( 1, m_RootNode.GetPointer() );
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !node || copies.find( node ) != copies.end() )
+      continue;
+      
+    itk::LightObject::Pointer object = node->CreateAnother();
+    GraphNode::Pointer copy = dynamic_cast<GraphNode*>( object.GetPointer() );
+    
+    if( copy.IsNull() )
+      itkExceptionMacro( "Could not copy node " << node->GetNodeId() << "." );
+      
+    copy->CopyInformation( node );
+    copies[node] = copy;
+    nodes.push_back( node );
+    
+    for( unsigned int i = node->GetNumberOfChildren(); i > 0; --i )
+      pendingNodes.push_back( node->GetChild( i-1 ) );
+  }
+  
+  // Link the copies. AddChild() overwrites the depth level, so restore it afterwards
+  for( unsigned int n=0; n<nodes.size(); ++n )
+  {
+    GraphNode *copy = copies[ nodes[n] ];
+    
+    for( unsigned int i=0; i<nodes[n]->GetNumberOfChildren(); ++i )
+    {
+      if( nodes[n]->GetChild(i) )
+        copy->AddChild( copies[ nodes[n]->GetChild(i) ] );
+    }
+  }
+  
+  for( unsigned int n=0; n<nodes.size(); ++n )
+    copies[ nodes[n] ]->SetDepthLevel( nodes[n]->GetDepthLevel() );
+    
+  snapshot->SetRootNode( dynamic_cast<VesselNode*>( copies[ m_RootNode.GetPointer() ].GetPointer() ) );
+  snapshot->SetUseNodeIndex( this->GetUseNodeIndex() );
+  
+  return snapshot;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraph_hxx
@@ -0,0 +1,128 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineAlgorithmFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: apply a centerline algorithm to the requested branches of a graph in a pipeline
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineAlgorithmFilter_h
+#define __ivanVesselGraphCenterlineAlgorithmFilter_h
+
+#include "ivanVesselDataObjectToVesselDataObjectFilter.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphCenterlineAlgorithmFilter
+ *  \brief Apply a centerline algorithm to the requested branches of a VesselGraph.
+ *
+ * The output is a snapshot of the input graph, which shares its centerlines, where the 
+ * centerline of every branch in the requested region of the output is replaced by the result
+ * of the Evaluate() method of the algorithm. The other branches keep the centerlines of the 
+ * input, and are not part of the buffered region of the output. Branches are processed whole,
+ * even if only a range of their sections is requested.
+ *
+ * The requested region is propagated to the input, so the filters upstream only generate the 
+ * requested branches too. With the default request, the whole graph is processed.
+ *
+ * \sa VesselGraphCenterlineProcessor
+ *
+ * \ingroup 
+ */
+
+template <class TCenterlineAlgorithm>
+class ITK_EXPORT VesselGraphCenterlineAlgorithmFilter : 
+  public VesselDataObjectToVesselDataObjectFilter
+  < VesselGraph<typename TCenterlineAlgorithm::CenterlineType>, 
+  VesselGraph<typename TCenterlineAlgorithm::CenterlineType> >
+{
+
+public:
+
+  typedef TCenterlineAlgorithm                        AlgorithmType;
+  typedef typename AlgorithmType::ConstPointer        AlgorithmConstPointer;
+  
+  typedef typename AlgorithmType::CenterlineType      CenterlineType;
+  typedef VesselGraph<CenterlineType>                 VesselGraphType;
+  typedef VesselBranchNode<CenterlineType>            BranchNodeType;
+
+  /** Standard class typedefs. */
+  typedef VesselGraphCenterlineAlgorithmFilter      Self;
+  typedef VesselDataObjectToVesselDataObjectFilter
+    <VesselGraphType,VesselGraphType>               Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+  
+  typedef typename Superclass::InputVesselType      InputVesselType;
+  typedef typename Superclass::OutputVesselType     OutputVesselType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphCenterlineAlgorithmFilter, VesselDataObjectToVesselDataObjectFilter );
+  
+  /** Set/Get the algorithm applied to every requested branch. */
+  void SetCenterlineAlgorithm( const AlgorithmType *algorithm )
+    { m_Algorithm = algorithm; this->Modified(); }
+  const AlgorithmType * GetCenterlineAlgorithm() const
+    { return m_Algorithm; }
+  
+  /** Get the number of branches processed by the last update. */
+  itkGetConstMacro( NumberOfProcessedBranches, unsigned int );
+		
+protected:
+
+  VesselGraphCenterlineAlgorithmFilter();
+  ~VesselGraphCenterlineAlgorithmFilter() {}
+  
+  void GenerateData();
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  VesselGraphCenterlineAlgorithmFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  AlgorithmConstPointer           m_Algorithm;
+  
+  unsigned int                    m_NumberOfProcessedBranches;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphCenterlineAlgorithmFilter.hxx"
+#endif
+
+#endif
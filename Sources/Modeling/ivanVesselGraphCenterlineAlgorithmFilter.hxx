@@ -0,0 +1,113 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineAlgorithmFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: apply a centerline algorithm to the requested branches of a graph in a pipeline
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineAlgorithmFilter_hxx
+#define __ivanVesselGraphCenterlineAlgorithmFilter_hxx
+
+#include "ivanVesselGraphCenterlineAlgorithmFilter.h"
+
+#include <set>
+#include <vector>
+
+
+namespace ivan
+{
+
+template <class TCenterlineAlgorithm>
+VesselGraphCenterlineAlgorithmFilter<TCenterlineAlgorithm>::VesselGraphCenterlineAlgorithmFilter() :
+  m_NumberOfProcessedBranches( 0 )
+{
+
+}
+
+
+template <class TCenterlineAlgorithm>
+void VesselGraphCenterlineAlgorithmFilter<TCenterlineAlgorithm>::GenerateData()
+{
+  if( m_Algorithm.IsNull() )
+    itkExceptionMacro( "Centerline algorithm not set." );
+  
+  const InputVesselType *input = this->GetInput();
+  OutputVesselType *output = this->GetOutput();
+  
+  m_NumberOfProcessedBranches = 0;
+  
+  // Share the centerlines of the input. The nodes are handed to the output without the index
+  // of the snapshot
+  typename VesselGraphType::Pointer snapshot = input->CreateSnapshot();
+  snapshot->SetUseNodeIndex( false );
+  
+  output->SetRootNode( snapshot->GetRootNode() );
+  output->SetUseNodeIndex( input->GetUseNodeIndex() );
+  
+  if( output->GetRootNode().IsNull() )
+    return;
+  
+  const bool wholeGraph = output->IsRequestedRegionWhole();
+  const VesselRegion & requestedRegion = output->GetRequestedRegion();
+  
+  // Visit the nodes depth-first. Nodes with several parents are only processed once
+  std::vector<GraphNode*> pendingNodes( 1, output->GetRootNode().GetPointer() );
+  std::set<GraphNode*> visitedNodes;
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !visitedNodes.insert( node ).second )
+      continue;
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && branch->GetCenterline().IsNotNull() && 
+      ( wholeGraph || requestedRegion.ContainsBranch( branch->GetNodeId() ) ) )
+    {
+      branch->SetCenterline( m_Algorithm->Evaluate( branch->GetCenterline().GetPointer() ) );
+      ++m_NumberOfProcessedBranches;
+    }
+    
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+}
+
+
+template <class TCenterlineAlgorithm>
+void VesselGraphCenterlineAlgorithmFilter<TCenterlineAlgorithm>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "CenterlineAlgorithm: " << m_Algorithm.GetPointer() << std::endl;
+  os << indent << "NumberOfProcessedBranches: " << m_NumberOfProcessedBranches << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraphCenterlineAlgorithmFilter_hxx
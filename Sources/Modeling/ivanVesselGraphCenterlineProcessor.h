@@ -0,0 +1,150 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineProcessor.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: apply a centerline algorithm to all the branches of a graph in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineProcessor_h
+#define __ivanVesselGraphCenterlineProcessor_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanTaskPool.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphCenterlineProcessor
+ *  \brief Apply a centerline algorithm to all the branches of a VesselGraph in parallel.
+ *
+ * The branches reachable from the root are collected first and sorted by decreasing number of 
+ * sections. Threads then take the next branch from a shared counter, so long branches start 
+ * first and the load stays balanced. Every branch is replaced by the result of the Process() 
+ * method of the algorithm, which may smooth or resample it in place. The algorithm is shared 
+ * by all the threads, so its Process() method must be thread safe, as it is for 
+ * VesselCenterlineSmoother and BSplineVesselCenterlineInterpolator.
+ *
+ * This does the same as VesselCenterlineAlgorithmVisitor, which visits the branches serially.
+ * VesselGraphCenterlineResampler resamples the branches without creating sections in the threads.
+ *
+ * \ingroup 
+ */
+
+template <class TCenterlineAlgorithm>
+class ITK_EXPORT VesselGraphCenterlineProcessor : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphCenterlineProcessor    Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+ 
+  typedef TCenterlineAlgorithm                        AlgorithmType;
+  typedef typename AlgorithmType::ConstPointer        AlgorithmConstPointer;
+  
+  typedef typename AlgorithmType::CenterlineType      CenterlineType;
+  typedef VesselGraph<CenterlineType>                 VesselGraphType;
+  typedef VesselBranchNode<CenterlineType>            BranchNodeType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphCenterlineProcessor, itk::Object );
+  
+  /** Set/Get the algorithm applied to every branch. */
+  void SetCenterlineAlgorithm( const AlgorithmType *algorithm )
+    { m_Algorithm = algorithm; this->Modified(); }
+  const AlgorithmType * GetCenterlineAlgorithm() const
+    { return m_Algorithm; }
+  
+  /** Set/Get the maximum number of threads of the TaskPool used. Default is the global 
+    * default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Process all the branches of the graph. */
+  void Process( VesselGraphType *graph )
+    { this->Process( graph->GetRootNode() ); }
+  
+  /** Process all the branches reachable from the given node. */
+  void Process( GraphNode *root );
+  
+  /** Get the number of branches and sections processed by the last call to Process(). */
+  itkGetConstMacro( NumberOfProcessedBranches, unsigned int );
+  itkGetConstMacro( NumberOfProcessedSections, unsigned long );
+		
+protected:
+
+  VesselGraphCenterlineProcessor();
+  ~VesselGraphCenterlineProcessor() {}
+  
+  /** Loop of Process() over the collected branches, longest first. */
+  struct ProcessBranchesFunction : public TaskPool::RangeFunction
+  {
+    Self  *Processor;
+    
+    virtual void Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int threadId );
+  };
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  VesselGraphCenterlineProcessor(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  AlgorithmConstPointer           m_Algorithm;
+  
+  int                             m_NumberOfThreads;
+  
+  std::vector<BranchNodeType*>    m_Branches;
+
+  unsigned int                    m_NumberOfProcessedBranches;
+  unsigned long                   m_NumberOfProcessedSections;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphCenterlineProcessor.hxx"
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineProcessor.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: apply a centerline algorithm to all the branches of a graph in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineProcessor_hxx
+#define __ivanVesselGraphCenterlineProcessor_hxx
+
+#include "ivanVesselGraphCenterlineProcessor.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <set>
+
+
+namespace ivan
+{
+
+/** Order branches by decreasing number of sections. */
+template <class TBranchNode>
+struct VesselBranchLongerThan
+{
+  bool operator()( const TBranchNode *a, const TBranchNode *b ) const
+    { return a->GetCenterline()->size() > b->GetCenterline()->size(); }
+};
+
+
+template <class TCenterlineAlgorithm>
+VesselGraphCenterlineProcessor<TCenterlineAlgorithm>::VesselGraphCenterlineProcessor() :
+  m_NumberOfProcessedBranches( 0 ),
+  m_NumberOfProcessedSections( 0 )
+{
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+
+template <class TCenterlineAlgorithm>
+void VesselGraphCenterlineProcessor<TCenterlineAlgorithm>::Process( GraphNode *root )
+{
+  if( m_Algorithm.IsNull() )
+    itkExceptionMacro( "Centerline algorithm not set." );
+  
+  m_Branches.clear();
+  m_NumberOfProcessedBranches = 0;
+  m_NumberOfProcessedSections = 0;
+  
+  if( !root )
+    return;
+  
+  // Collect the branches with a depth-first traversal. Nodes with several parents
+  // are only taken once
+  std::vector<GraphNode*> pendingNodes;
+  std::set<GraphNode*> visitedNodes;
+  
+  pendingNodes.push_back( root );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !visitedNodes.insert( node ).second )
+      continue;
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && branch->GetCenterline().IsNotNull() )
+    {
+      m_Branches.push_back( branch );
+      m_NumberOfProcessedSections += branch->GetCenterline()->size();
+    }
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), VesselBranchLongerThan<BranchNodeType>() );
+  
+  // One branch per chunk, so the threads that finish a short branch take the next one
+  ProcessBranchesFunction function;
+  function.Processor = this;
+  
+  TaskPool::GetInstance()->ParallelFor( 0, m_Branches.size(), &function, 1, m_NumberOfThreads );
+
+  m_NumberOfProcessedBranches = m_Branches.size();
+  m_Branches.clear();
+}
+
+
+template <class TCenterlineAlgorithm>
+void VesselGraphCenterlineProcessor<TCenterlineAlgorithm>::ProcessBranchesFunction
+::Execute( TaskPool::IndexValueType begin, TaskPool::IndexValueType end, unsigned int )
+{
+  for( TaskPool::IndexValueType i = begin; i < end; ++i )
+  {
+    BranchNodeType *branch = this->Processor->m_Branches[i];
+    branch->SetCenterline( this->Processor->m_Algorithm->Process( branch->GetCenterline() ) );
+  }
+}
+
+
+template <class TCenterlineAlgorithm>
+void VesselGraphCenterlineProcessor<TCenterlineAlgorithm>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "CenterlineAlgorithm: " << m_Algorithm.GetPointer() << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfProcessedBranches: " << m_NumberOfProcessedBranches << std::endl;
+  os << indent << "NumberOfProcessedSections: " << m_NumberOfProcessedSections << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraphCenterlineProcessor_hxx
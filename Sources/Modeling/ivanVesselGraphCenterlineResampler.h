@@ -0,0 +1,181 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineResampler.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: resample all the branches of a graph at uniform arclength in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineResampler_h
+#define __ivanVesselGraphCenterlineResampler_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphCenterlineResampler
+ *  \brief Resample all the branches of a VesselGraph at uniform arclength in parallel.
+ *
+ * The interpolator, LinearVesselCenterlineInterpolator or BSplineVesselCenterlineInterpolator,
+ * computes the resampled values of a branch with its ComputeSamples() method, every 
+ * SamplingDistance of the interpolator. This is done in three passes:
+ *
+ * 1. Threads take branches from a shared counter, longest first, and compute their samples.
+ * 2. The sections exceeding the current number of sections of every branch are created at 
+ *    once, in a single thread. When resampling a graph they are taken from its arena, so they
+ *    lie contiguously in its chunks. 
+ * 3. Threads write the samples in the sections of every branch, reusing its own sections and 
+ *    then the ones created for it.
+ *
+ * No section is created or destroyed in the threads, so they do not contend on the allocator,
+ * and branches never reallocate their sections. The interpolator is shared by all the 
+ * threads, so its ComputeSamples() method must be thread safe.
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
+ * \sa VesselGraphCenterlineProcessor
+ *
+ * \ingroup 
+ */
+
+template <class TInterpolator>
+class ITK_EXPORT VesselGraphCenterlineResampler : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphCenterlineResampler    Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+ 
+  typedef TInterpolator                               InterpolatorType;
+  typedef typename InterpolatorType::ConstPointer     InterpolatorConstPointer;
+  typedef typename InterpolatorType::SampleContainer  SampleContainer;
+  
+  typedef typename InterpolatorType::CenterlineType   CenterlineType;
+  typedef typename CenterlineType::SectionType        SectionType;
+  typedef typename CenterlineType::SectionPointer     SectionPointer;
+  typedef VesselGraph<CenterlineType>                 VesselGraphType;
+  typedef VesselBranchNode<CenterlineType>            BranchNodeType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphCenterlineResampler, itk::Object );
+  
+  /** Set/Get the interpolator, which sets the sampling distance. */
+  void SetInterpolator( const InterpolatorType *interpolator )
+    { m_Interpolator = interpolator; this->Modified(); }
+  const InterpolatorType * GetInterpolator() const
+    { return m_Interpolator; }
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Resample all the branches of the graph, creating the new sections in its arena. */
+  void Resample( VesselGraphType *graph );
+  
+  /** Resample all the branches reachable from the given node. New sections are taken from the
+    * active arena, if any. */
+  void Resample( GraphNode *root );
+  
+  /** Get the number of branches resampled, and of sections written and created, by the last 
+    * call to Resample(). */
+  itkGetConstMacro( NumberOfResampledBranches, unsigned int );
+  itkGetConstMacro( NumberOfResampledSections, unsigned long );
+  itkGetConstMacro( NumberOfCreatedSections, unsigned long );
+		
+protected:
+
+  VesselGraphCenterlineResampler();
+  ~VesselGraphCenterlineResampler() {}
+  
+  typedef enum { ComputeSamplesPass, WriteSamplesPass }  PassType;
+  
+  /** Run a pass on all the branches, in parallel if there are several. */
+  void ExecutePass( PassType pass );
+  
+  /** Run the current pass on the branches taken from the shared counter until there are no 
+    * more. */
+  void ThreadedExecutePass();
+  
+  /** Write the samples of a branch in its sections. */
+  void WriteSamples( unsigned int branch );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ResampleThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  VesselGraphCenterlineResampler(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  InterpolatorConstPointer        m_Interpolator;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  /** State of the current resampling. */
+  std::vector<BranchNodeType*>    m_Branches;
+  std::vector<SampleContainer>    m_Samples;
+  PassType                        m_Pass;
+  unsigned int                    m_NextBranch;
+  itk::SimpleFastMutexLock        m_BranchMutex;
+  
+  /** Sections created for all the branches, and first one of every branch. */
+  std::vector<SectionPointer>     m_CreatedSections;
+  std::vector<unsigned long>      m_FirstCreatedSections;
+  
+  unsigned int                    m_NumberOfResampledBranches;
+  unsigned long                   m_NumberOfResampledSections;
+  unsigned long                   m_NumberOfCreatedSections;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphCenterlineResampler.hxx"
+#endif
+
+#endif
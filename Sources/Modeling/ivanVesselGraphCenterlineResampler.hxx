@@ -0,0 +1,250 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineResampler.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: resample all the branches of a graph at uniform arclength in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineResampler_hxx
+#define __ivanVesselGraphCenterlineResampler_hxx
+
+#include "ivanVesselGraphCenterlineResampler.h"
+#include "ivanVesselGraphCenterlineProcessor.h"
+#include "ivanArenaAllocator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <set>
+
+
+namespace ivan
+{
+
+template <class TInterpolator>
+VesselGraphCenterlineResampler<TInterpolator>::VesselGraphCenterlineResampler() :
+  m_Pass( ComputeSamplesPass ),
+  m_NextBranch( 0 ),
+  m_NumberOfResampledBranches( 0 ),
+  m_NumberOfResampledSections( 0 ),
+  m_NumberOfCreatedSections( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::Resample( VesselGraphType *graph )
+{
+  ArenaAllocator::Scope scope( graph->GetArena() );
+  
+  this->Resample( graph->GetRootNode() );
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::Resample( GraphNode *root )
+{
+  if( m_Interpolator.IsNull() )
+    itkExceptionMacro( "Interpolator not set." );
+  
+  m_Branches.clear();
+  m_NumberOfResampledBranches = 0;
+  m_NumberOfResampledSections = 0;
+  m_NumberOfCreatedSections = 0;
+  
+  if( !root )
+    return;
+  
+  // Collect the branches with a depth-first traversal. Nodes with several parents
+  // are only taken once
+  std::vector<GraphNode*> pendingNodes;
+  std::set<GraphNode*> visitedNodes;
+  
+  pendingNodes.push_back( root );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !visitedNodes.insert( node ).second )
+      continue;
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && branch->GetCenterline().IsNotNull() )
+      m_Branches.push_back( branch );
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), VesselBranchLongerThan<BranchNodeType>() );
+  
+  m_Samples.resize( m_Branches.size() );
+  
+  this->ExecutePass( ComputeSamplesPass );
+  
+  // Create the missing sections of all the branches together
+  m_FirstCreatedSections.resize( m_Branches.size() );
+  
+  for( unsigned int i=0; i<m_Branches.size(); ++i )
+  {
+    const unsigned long numberOfSections = m_Branches[i]->GetCenterline()->size();
+    
+    m_FirstCreatedSections[i] = m_NumberOfCreatedSections;
+    m_NumberOfResampledSections += m_Samples[i].size();
+    
+    if( m_Samples[i].size() > numberOfSections )
+      m_NumberOfCreatedSections += m_Samples[i].size() - numberOfSections;
+  }
+  
+  m_CreatedSections.resize( m_NumberOfCreatedSections );
+  
+  for( unsigned long i=0; i<m_NumberOfCreatedSections; ++i )
+    m_CreatedSections[i] = SectionType::New();
+  
+  this->ExecutePass( WriteSamplesPass );
+  
+  m_NumberOfResampledBranches = m_Branches.size();
+  
+  m_Branches.clear();
+  m_Samples.clear();
+  m_CreatedSections.clear();
+  m_FirstCreatedSections.clear();
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::ExecutePass( PassType pass )
+{
+  m_Pass = pass;
+  m_NextBranch = 0;
+  
+  if( m_Branches.size() > 1 )
+  {
+    m_Threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, (int)m_Branches.size() ) );
+    m_Threader->SetSingleMethod( this->ResampleThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedExecutePass();
+  }
+}
+
+
+template <class TInterpolator>
+ITK_THREAD_RETURN_TYPE
+VesselGraphCenterlineResampler<TInterpolator>::ResampleThreaderCallback( void *arg )
+{
+  Self *resampler = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  resampler->ThreadedExecutePass();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::ThreadedExecutePass()
+{
+  unsigned int branch;
+  bool found;
+  
+  while( true )
+  {
+    m_BranchMutex.Lock();
+    found = ( m_NextBranch < m_Branches.size() );
+    if( found )
+      branch = m_NextBranch++;
+    m_BranchMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    if( m_Pass == ComputeSamplesPass )
+      m_Interpolator->ComputeSamples( m_Branches[branch]->GetCenterline(), m_Samples[branch] );
+    else
+      this->WriteSamples( branch );
+  }
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::WriteSamples( unsigned int branch )
+{
+  CenterlineType *centerline = m_Branches[branch]->GetCenterline();
+  const SampleContainer & samples = m_Samples[branch];
+  
+  const unsigned int numberOfReusedSections = vnl_math_min
+    ( (unsigned int)samples.size(), (unsigned int)centerline->size() );
+  
+  centerline->resize( samples.size() );
+  
+  typename SectionType::PointType center;
+  typename SectionType::VectorType normal;
+  
+  for( unsigned int i=0; i<samples.size(); ++i )
+  {
+    if( i >= numberOfReusedSections )
+    {
+      centerline->at(i) = 
+        m_CreatedSections[ m_FirstCreatedSections[branch] + i - numberOfReusedSections ];
+    }
+    
+    SectionType *section = centerline->at(i);
+    
+    center = samples[i].Center;
+    normal = samples[i].Normal;
+    
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( samples[i].Radius );
+    section->SetScale( samples[i].Scale );
+    section->SetArclength( samples[i].Arclength );
+  }
+  
+  centerline->Modified();
+}
+
+
+template <class TInterpolator>
+void VesselGraphCenterlineResampler<TInterpolator>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Interpolator: " << m_Interpolator.GetPointer() << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfResampledBranches: " << m_NumberOfResampledBranches << std::endl;
+  os << indent << "NumberOfResampledSections: " << m_NumberOfResampledSections << std::endl;
+  os << indent << "NumberOfCreatedSections: " << m_NumberOfCreatedSections << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraphCenterlineResampler_hxx
@@ -0,0 +1,195 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineSimplifier.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compute simplified centerlines of all the branches of a graph in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineSimplifier_h
+#define __ivanVesselGraphCenterlineSimplifier_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphCenterlineSimplifier
+ *  \brief Compute levels of detail of all the branches of a VesselGraph in parallel.
+ *
+ * Every branch gets NumberOfLevels simplified centerlines, which are stored in the branch 
+ * alongside its centerline with VesselBranchNode::SetLevelsOfDetail(), so that viewers, the 
+ * FrozenVesselGraph and the tube mesh generator can take a coarser level without further 
+ * computation. The simplified centerlines share the sections of the centerline.
+ *
+ * Every level is computed from the full resolution centerline with the Douglas-Peucker 
+ * algorithm in 3-D. A section is dropped if both its center lies within the tolerance from
+ * the segment joining the kept sections around it and its radius differs less than the 
+ * tolerance from the one interpolated along that segment. The tolerance is relative to the 
+ * radius of the section, Tolerance times ToleranceFactor^(level-1) times the radius, but never
+ * less than MinimumTolerance. Thin vessels are then simplified less than thick ones, and 
+ * stenoses and aneurysms are kept. The first and last sections are always kept, so the 
+ * branches still meet at their bifurcations.
+ *
+ * Threads take branches from a shared counter, longest first, and compute the sections kept 
+ * at every level. The centerlines are then created in a single thread. 
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
+ * \sa VesselGraphCenterlineResampler
+ *
+ * \ingroup 
+ */
+
+template <class TCenterline>
+class ITK_EXPORT VesselGraphCenterlineSimplifier : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphCenterlineSimplifier   Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+ 
+  typedef TCenterline                                 CenterlineType;
+  typedef typename CenterlineType::Pointer            CenterlinePointer;
+  typedef typename CenterlineType::SectionType        SectionType;
+  typedef VesselGraph<CenterlineType>                 VesselGraphType;
+  typedef VesselBranchNode<CenterlineType>            BranchNodeType;
+  
+  /** Positions of the kept sections in the centerline, in increasing order. */
+  typedef std::vector<unsigned int>                   SectionIndexContainer;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphCenterlineSimplifier, itk::Object );
+  
+  /** Set/Get the number of simplified levels. Default is 3. */
+  itkSetMacro( NumberOfLevels, unsigned int );
+  itkGetConstMacro( NumberOfLevels, unsigned int );
+  
+  /** Set/Get the tolerance of the finest level, relative to the radius. Default is 0.25. */
+  itkSetMacro( Tolerance, double );
+  itkGetConstMacro( Tolerance, double );
+  
+  /** Set/Get the factor applied to the tolerance from a level to the next. Default is 4. */
+  itkSetMacro( ToleranceFactor, double );
+  itkGetConstMacro( ToleranceFactor, double );
+  
+  /** Set/Get the minimum tolerance, in physical units. Default is 0. */
+  itkSetMacro( MinimumTolerance, double );
+  itkGetConstMacro( MinimumTolerance, double );
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Relative tolerance of the given level, starting at 1. */
+  double GetLevelTolerance( unsigned int level ) const;
+  
+  /** Simplify all the branches of the graph, creating the centerlines in its arena. */
+  void Simplify( VesselGraphType *graph );
+  
+  /** Simplify all the branches reachable from the given node. New centerlines are taken from 
+    * the active arena, if any. */
+  void Simplify( GraphNode *root );
+  
+  /** Compute the positions of the sections of the centerline kept with the given relative and 
+    * minimum tolerances. */
+  static void SimplifyCenterline( const CenterlineType *centerline, double tolerance, 
+    double minimumTolerance, SectionIndexContainer & keptSections );
+  
+  /** Get the number of branches simplified, and of sections of their centerlines, by the last 
+    * call to Simplify(). */
+  itkGetConstMacro( NumberOfSimplifiedBranches, unsigned int );
+  itkGetConstMacro( NumberOfSections, unsigned long );
+  
+  /** Get the number of sections kept at the given level, starting at 1, by the last call to 
+    * Simplify(). */
+  unsigned long GetNumberOfKeptSections( unsigned int level ) const
+    { return level > 0 && level <= m_NumberOfKeptSections.size() ? m_NumberOfKeptSections[level-1] : 0; }
+		
+protected:
+
+  VesselGraphCenterlineSimplifier();
+  ~VesselGraphCenterlineSimplifier() {}
+  
+  /** Compute the kept sections of the branches taken from the shared counter until there are 
+    * no more. */
+  void ThreadedSimplify();
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE SimplifyThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  VesselGraphCenterlineSimplifier(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  unsigned int                    m_NumberOfLevels;
+  double                          m_Tolerance;
+  double                          m_ToleranceFactor;
+  double                          m_MinimumTolerance;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  /** State of the current simplification. The kept sections are stored per branch and 
+    * level. */
+  std::vector<BranchNodeType*>                m_Branches;
+  std::vector<SectionIndexContainer>          m_KeptSections;
+  unsigned int                                m_NextBranch;
+  itk::SimpleFastMutexLock                    m_BranchMutex;
+  
+  unsigned int                    m_NumberOfSimplifiedBranches;
+  unsigned long                   m_NumberOfSections;
+  std::vector<unsigned long>      m_NumberOfKeptSections;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphCenterlineSimplifier.hxx"
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineSimplifier.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compute simplified centerlines of all the branches of a graph in parallel
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphCenterlineSimplifier_hxx
+#define __ivanVesselGraphCenterlineSimplifier_hxx
+
+#include "ivanVesselGraphCenterlineSimplifier.h"
+#include "ivanVesselGraphCenterlineProcessor.h"
+#include "ivanArenaAllocator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraphCenterlineSimplifier<TCenterline>::VesselGraphCenterlineSimplifier() :
+  m_NumberOfLevels( 3 ),
+  m_Tolerance( 0.25 ),
+  m_ToleranceFactor( 4.0 ),
+  m_MinimumTolerance( 0.0 ),
+  m_NextBranch( 0 ),
+  m_NumberOfSimplifiedBranches( 0 ),
+  m_NumberOfSections( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TCenterline>
+double VesselGraphCenterlineSimplifier<TCenterline>::GetLevelTolerance( unsigned int level ) const
+{
+  return m_Tolerance * std::pow( m_ToleranceFactor, (double)level - 1.0 );
+}
+
+
+template <class TCenterline>
+void VesselGraphCenterlineSimplifier<TCenterline>::Simplify( VesselGraphType *graph )
+{
+  ArenaAllocator::Scope scope( graph->GetArena() );
+  
+  this->Simplify( graph->GetRootNode() );
+}
+
+
+template <class TCenterline>
+void VesselGraphCenterlineSimplifier<TCenterline>::Simplify( GraphNode *root )
+{
+  m_Branches.clear();
+  m_NumberOfSimplifiedBranches = 0;
+  m_NumberOfSections = 0;
+  m_NumberOfKeptSections.assign( m_NumberOfLevels, 0 );
+  
+  if( !root )
+    return;
+  
+  // Collect the branches with a depth-first traversal. Nodes with several parents
+  // are only taken once
+  std::vector<GraphNode*> pendingNodes;
+  std::set<GraphNode*> visitedNodes;
+  
+  pendingNodes.push_back( root );
+  
+  while( !pendingNodes.empty() )
+  {
+    GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !visitedNodes.insert( node ).second )
+      continue;
+    
+    BranchNodeType *branch = dynamic_cast<BranchNodeType*>( node );
+    
+    if( branch && branch->GetCenterline().IsNotNull() )
+      m_Branches.push_back( branch );
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), VesselBranchLongerThan<BranchNodeType>() );
+  
+  m_KeptSections.resize( m_Branches.size() * m_NumberOfLevels );
+  m_NextBranch = 0;
+  
+  if( m_Branches.size() > 1 )
+  {
+    m_Threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, (int)m_Branches.size() ) );
+    m_Threader->SetSingleMethod( this->SimplifyThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedSimplify();
+  }
+  
+  // Create the simplified centerlines in this thread, so the threads do not contend on the
+  // allocator
+  for( unsigned int i=0; i<m_Branches.size(); ++i )
+  {
+    const CenterlineType *centerline = m_Branches[i]->GetCenterline();
+    typename BranchNodeType::LevelOfDetailContainer levels( m_NumberOfLevels );
+    
+    for( unsigned int level=0; level<m_NumberOfLevels; ++level )
+    {
+      const SectionIndexContainer & keptSections = m_KeptSections[ i * m_NumberOfLevels + level ];
+      
+      CenterlinePointer simplified = CenterlineType::New();
+      simplified->reserve( keptSections.size() );
+      for( unsigned int k=0; k<keptSections.size(); ++k )
+        simplified->push_back( centerline->at( keptSections[k] ) );
+        
+      levels[level] = simplified.GetPointer();
+      m_NumberOfKeptSections[level] += keptSections.size();
+    }
+    
+    m_Branches[i]->SetLevelsOfDetail( levels );
+    m_NumberOfSections += centerline->size();
+  }
+  
+  m_NumberOfSimplifiedBranches = m_Branches.size();
+  
+  m_Branches.clear();
+  m_KeptSections.clear();
+}
+
+
+template <class TCenterline>
+ITK_THREAD_RETURN_TYPE
+VesselGraphCenterlineSimplifier<TCenterline>::SimplifyThreaderCallback( void *arg )
+{
+  Self *simplifier = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  simplifier->ThreadedSimplify();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TCenterline>
+void VesselGraphCenterlineSimplifier<TCenterline>::ThreadedSimplify()
+{
+  unsigned int branch;
+  bool found;
+  
+  while( true )
+  {
+    m_BranchMutex.Lock();
+    found = ( m_NextBranch < m_Branches.size() );
+    if( found )
+      branch = m_NextBranch++;
+    m_BranchMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    const CenterlineType *centerline = m_Branches[branch]->GetCenterline();
+    
+    for( unsigned int level=0; level<m_NumberOfLevels; ++level )
+    {
+      this->SimplifyCenterline( centerline, this->GetLevelTolerance( level + 1 ), m_MinimumTolerance, 
+        m_KeptSections[ branch * m_NumberOfLevels + level ] );
+    }
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphCenterlineSimplifier<TCenterline>::SimplifyCenterline( const CenterlineType *centerline, 
+  double tolerance, double minimumTolerance, SectionIndexContainer & keptSections )
+{
+  keptSections.clear();
+  
+  const unsigned int numberOfSections = centerline->size();
+  
+  if( numberOfSections <= 2 )
+  {
+    for( unsigned int i=0; i<numberOfSections; ++i )
+      keptSections.push_back( i );
+    return;
+  }
+  
+  std::vector<bool> kept( numberOfSections, false );
+  kept[0] = kept[numberOfSections-1] = true;
+  
+  // Split the segments with an explicit stack, since branches may have many sections
+  typedef std::pair<unsigned int,unsigned int>  SegmentType;
+  std::vector<SegmentType> pendingSegments( 1, SegmentType( 0, numberOfSections - 1 ) );
+  
+  while( !pendingSegments.empty() )
+  {
+    const SegmentType segment = pendingSegments.back();
+    pendingSegments.pop_back();
+    
+    if( segment.second - segment.first < 2 )
+      continue;
+    
+    const SectionType *first = centerline->at( segment.first );
+    const SectionType *last = centerline->at( segment.second );
+    
+    const typename SectionType::VectorType chord = last->GetCenter() - first->GetCenter();
+    const double chordSquaredLength = chord.GetSquaredNorm();
+    
+    // Section that exceeds its tolerance by the largest ratio
+    double maximumRatio = 1.0;
+    unsigned int farthest = segment.first;
+    
+    for( unsigned int i = segment.first + 1; i < segment.second; ++i )
+    {
+      const SectionType *section = centerline->at(i);
+      const typename SectionType::VectorType offset = section->GetCenter() - first->GetCenter();
+      
+      double t = 0.0;
+      if( chordSquaredLength > 0.0 )
+        t = vnl_math_max( 0.0, vnl_math_min( 1.0, ( offset * chord ) / chordSquaredLength ) );
+      
+      const double distance = ( offset - chord * t ).GetNorm();
+      const double radiusError = vnl_math_abs( section->GetRadius() - 
+        ( ( 1.0 - t ) * first->GetRadius() + t * last->GetRadius() ) );
+        
+      const double sectionTolerance = vnl_math_max( minimumTolerance, tolerance * section->GetRadius() );
+      const double deviation = vnl_math_max( distance, radiusError );
+      
+      // Sections with no tolerance are kept unless they lie exactly on the segment
+      double ratio;
+      if( sectionTolerance > 0.0 )
+        ratio = deviation / sectionTolerance;
+      else
+        ratio = deviation > 0.0 ? itk::NumericTraits<double>::max() : 0.0;
+      
+      if( ratio > maximumRatio )
+      {
+        maximumRatio = ratio;
+        farthest = i;
+      }
+    }
+    
+    if( farthest != segment.first )
+    {
+      kept[farthest] = true;
+      pendingSegments.push_back( SegmentType( segment.first, farthest ) );
+      pendingSegments.push_back( SegmentType( farthest, segment.second ) );
+    }
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    if( kept[i] )
+      keptSections.push_back( i );
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphCenterlineSimplifier<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "NumberOfLevels: " << m_NumberOfLevels << std::endl;
+  os << indent << "Tolerance: " << m_Tolerance << std::endl;
+  os << indent << "ToleranceFactor: " << m_ToleranceFactor << std::endl;
+  os << indent << "MinimumTolerance: " << m_MinimumTolerance << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfSimplifiedBranches: " << m_NumberOfSimplifiedBranches << std::endl;
+  os << indent << "NumberOfSections: " << m_NumberOfSections << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraphCenterlineSimplifier_hxx
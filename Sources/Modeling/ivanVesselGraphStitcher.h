@@ -0,0 +1,220 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphStitcher.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: joins the branches of vessel graphs tracked over neighbouring regions.
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselGraphStitcher_h
+#define __ivanVesselGraphStitcher_h
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselCenterlineSpatialIndex.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <vector>
+#include <map>
+
+
+namespace ivan
+{
+  
+/** \class VesselGraphStitcher
+ *  \brief Joins the branches of several vessel graphs that continue each other.
+ *
+ * This class merges graphs tracked separately over neighbouring regions of an image, for 
+ * example the slabs of a distributed tracking, where a vessel that crosses a slab boundary is
+ * tracked in pieces. The ends of the pieces overlap or touch, since each region is tracked up
+ * to some distance past its boundary.
+ *
+ * The end of a branch is linked to the end of a branch of another graph if each end is within
+ * Tolerance of the capsules of the other branch (see VesselCenterlineSpatialIndex), and each is
+ * the best match of the other. Branches of the same graph are never linked. Linked branches are
+ * concatenated, reversing them as needed, and the sections of each piece that overlap the next
+ * one are dropped, so the stitched centerline follows the first piece up to the start of the 
+ * next. Closed chains are cut at an arbitrary link.
+ *
+ * The output is a new VesselGraph whose root is a VesselNode with id 0, with one 
+ * VesselBranchNode per stitched chain of branches, numbered from 1. The other nodes of the 
+ * inputs, such as bifurcations, are copied and numbered after the chains, and the links of the
+ * inputs are kept between the chains and the copies: a chain takes the parents of its first 
+ * piece, which is chosen where possible to start at the first section of its branch, and the
+ * children of all its pieces. The roots of the inputs are replaced by the root of the output.
+ * Chains are oriented and linked so that no cycles are created, and chains without parents 
+ * are children of the root. The output centerlines share the sections of the inputs, so these
+ * must not be modified while the output is in use.
+ *
+ * \ingroup 
+ */
+ 
+template <class TCenterline>
+class ITK_EXPORT VesselGraphStitcher : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VesselGraphStitcher             Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef TCenterline                           CenterlineType;
+  typedef typename CenterlineType::Pointer      CenterlinePointer;
+  typedef typename CenterlineType::SectionType  SectionType;
+  typedef typename SectionType::PointType       PointType;
+  
+  typedef VesselGraph<TCenterline>              VesselGraphType;
+  typedef typename VesselGraphType::Pointer     VesselGraphPointer;
+  typedef typename VesselGraphType::ConstPointer  VesselGraphConstPointer;
+  typedef VesselBranchNode<TCenterline>         BranchNodeType;
+  typedef typename BranchNodeType::Pointer      BranchNodePointer;
+  
+  typedef VesselCenterlineSpatialIndex<TCenterline>  SpatialIndexType;
+       
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VesselGraphStitcher, itk::Object );
+  
+  /** Add a graph to stitch. */
+  void AddGraph( const VesselGraphType * graph );
+  
+  /** Remove all the graphs. */
+  void ClearGraphs();
+  
+  unsigned int GetNumberOfGraphs() const
+    { return m_Graphs.size(); }
+  
+  /** Maximum distance of a branch end from the capsules of the branch it continues. Default 
+    * is 1.0. */
+  itkSetMacro( Tolerance, double );
+  itkGetConstMacro( Tolerance, double );
+  
+  /** Stitch the graphs. */
+  void Update();
+  
+  /** Graph produced by the last call to Update(). */
+  VesselGraphType * GetOutput()
+    { return m_Output; }
+  
+  /** Number of links joined in the last call to Update(). */
+  itkGetConstMacro( NumberOfStitches, unsigned int );
+		
+protected:
+
+  VesselGraphStitcher();
+  ~VesselGraphStitcher() {}
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+  
+  /** Branch of one of the graphs. Each end may be linked to an end of another piece, given as
+    * 2 * piece + end, where end is 0 for the first section and 1 for the last. Cut is the 
+    * section of this piece nearest to the linked end. */
+  struct Piece
+  {
+    const BranchNodeType  *Branch;
+    unsigned int          Graph;
+    int                   Link[2];
+    unsigned int          Cut[2];
+  };
+  
+  /** Best match of a piece end. */
+  struct Candidate
+  {
+    int           End;
+    unsigned int  Cut;
+    double        Distance;
+  };
+  
+  /** Collect the branches of the graphs with sections, and index them. */
+  void CollectPieces();
+  
+  /** Find the best match of the given end, where end is 2 * piece + 0 or 1. */
+  Candidate FindCandidate( int end );
+  
+  /** Free end of the chain that contains the given piece, from which the chain is appended.
+    * For closed chains, the end where the chain is cut. */
+  int FindChainStart( unsigned int piece ) const;
+  
+  /** Append the sections of the chain starting at the given end to the centerline, marking 
+    * its pieces as taken by the given chain. */
+  void AppendChain( int end, CenterlineType * centerline, int chain );
+  
+  /** Link the output nodes as the nodes of the given input graph are linked. */
+  void LinkGraph( const VesselGraphType * graph );
+  
+  /** Output node of an input node: the chain of a piece, the output root for the roots of 
+    * the inputs, or a copy of any other node, created on first use. */
+  GraphNode * GetOutputNode( const GraphNode * node );
+  
+  /** Returns true if the first node is an ancestor of the second, or the same node. */
+  bool IsAncestor( const GraphNode * ancestor, const GraphNode * node ) const;
+  
+  const PointType & GetEndPoint( int end ) const;
+
+private:
+
+  VesselGraphStitcher(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  double                                m_Tolerance;
+  
+  std::vector<VesselGraphConstPointer>  m_Graphs;
+  
+  std::vector<Piece>                    m_Pieces;
+  std::map<const BranchNodeType*,unsigned int>  m_PieceOfBranch;
+  
+  typename SpatialIndexType::Pointer    m_SpatialIndex;
+  
+  /** Chain of every piece, -1 until taken, and the output branch and first piece of every chain. */
+  std::vector<int>                      m_PieceChains;
+  std::vector<BranchNodePointer>        m_Chains;
+  std::vector<unsigned int>             m_ChainStarts;
+  
+  /** Copies of the other input nodes, and the identifier of the next one. */
+  std::map<const GraphNode*,GraphNode::Pointer>  m_NodeCopies;
+  unsigned int                          m_NextNodeId;
+  
+  VesselGraphPointer                    m_Output;
+  unsigned int                          m_NumberOfStitches;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanVesselGraphStitcher.hxx"
+#endif
+
+#endif
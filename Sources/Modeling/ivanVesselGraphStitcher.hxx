@@ -0,0 +1,472 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphStitcher.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: joins the branches of vessel graphs tracked over neighbouring regions.
+// Date: 2012/11/05
+
+#ifndef __ivanVesselGraphStitcher_hxx
+#define __ivanVesselGraphStitcher_hxx
+
+#include "ivanVesselGraphStitcher.h"
+#include "ivanVesselNode.h"
+
+#include "itkNumericTraits.h"
+
+#include <set>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+VesselGraphStitcher<TCenterline>::VesselGraphStitcher() :
+  m_Tolerance( 1.0 ),
+  m_NextNodeId( 0 ),
+  m_NumberOfStitches( 0 )
+{
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::AddGraph( const VesselGraphType * graph )
+{
+  if( !graph )
+    return;
+    
+  m_Graphs.push_back( graph );
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::ClearGraphs()
+{
+  m_Graphs.clear();
+  this->Modified();
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::CollectPieces()
+{
+  m_Pieces.clear();
+  m_PieceOfBranch.clear();
+  
+  m_SpatialIndex = SpatialIndexType::New();
+  
+  for( unsigned int g=0; g<m_Graphs.size(); ++g )
+  {
+    if( m_Graphs[g]->GetRootNode().IsNull() )
+      continue;
+      
+    // Depth-first traversal, taking nodes with several parents once
+    std::vector<const GraphNode*> pendingNodes( 1, m_Graphs[g]->GetRootNode().GetPointer() );
+    std::set<const GraphNode*> visitedNodes;
+    
+    while( !pendingNodes.empty() )
+    {
+      const GraphNode *node = pendingNodes.back();
+      pendingNodes.pop_back();
+      
+      if( !node || !visitedNodes.insert( node ).second )
+        continue;
+        
+      const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+      
+      if( branch && branch->GetCenterline().IsNotNull() && !branch->GetCenterline()->empty() &&
+        m_PieceOfBranch.find( branch ) == m_PieceOfBranch.end() )
+      {
+        Piece piece;
+        piece.Branch = branch;
+        piece.Graph = g;
+        piece.Link[0] = piece.Link[1] = -1;
+        piece.Cut[0] = piece.Cut[1] = 0;
+        
+        m_PieceOfBranch[branch] = m_Pieces.size();
+        m_Pieces.push_back( piece );
+        
+        m_SpatialIndex->AppendSections( branch );
+      }
+        
+      // Children in reverse, so branches are taken in graph order
+      for( unsigned int i=node->GetNumberOfChildren(); i>0; --i )
+        pendingNodes.push_back( node->GetChild(i-1) );
+    }
+  }
+  
+  m_SpatialIndex->Update();
+}
+
+
+template <class TCenterline>
+const typename VesselGraphStitcher<TCenterline>::PointType & 
+VesselGraphStitcher<TCenterline>::GetEndPoint( int end ) const
+{
+  const BranchNodeType *branch = m_Pieces[end/2].Branch;
+  
+  if( end % 2 )
+    return branch->GetCenterline()->GetLastSection()->GetCenter();
+  else
+    return branch->GetCenterline()->GetFirstSection()->GetCenter();
+}
+
+
+template <class TCenterline>
+typename VesselGraphStitcher<TCenterline>::Candidate 
+VesselGraphStitcher<TCenterline>::FindCandidate( int end )
+{
+  const Piece & piece = m_Pieces[end/2];
+  
+  Candidate candidate;
+  candidate.End = -1;
+  candidate.Cut = 0;
+  candidate.Distance = itk::NumericTraits<double>::max();
+  
+  typename SpatialIndexType::SegmentHitContainer hits;
+  m_SpatialIndex->FindSegmentsWithinDistance( this->GetEndPoint( end ), m_Tolerance, hits, 
+    piece.Branch );
+    
+  // Smallest distance of the end to each other branch near it
+  std::map<unsigned int,double> endDistances;
+  
+  for( unsigned int i=0; i<hits.size(); ++i )
+  {
+    const unsigned int other = m_PieceOfBranch[ hits[i].Branch ];
+    
+    if( m_Pieces[other].Graph == piece.Graph )
+      continue;
+      
+    typename std::map<unsigned int,double>::iterator it = endDistances.find( other );
+    
+    if( it == endDistances.end() )
+      endDistances[other] = hits[i].Distance;
+    else
+      it->second = std::min( it->second, hits[i].Distance );
+  }
+    
+  typename SpatialIndexType::SegmentHitContainer otherHits;
+  
+  for( typename std::map<unsigned int,double>::const_iterator it = endDistances.begin();
+    it != endDistances.end(); ++it )
+  {
+    // The end of the other branch must also be near this branch
+    for( int otherEnd = 2 * it->first; otherEnd < 2 * static_cast<int>( it->first ) + 2; ++otherEnd )
+    {
+      otherHits.clear();
+      m_SpatialIndex->FindSegmentsWithinDistance( this->GetEndPoint( otherEnd ), m_Tolerance, 
+        otherHits, m_Pieces[it->first].Branch );
+        
+      for( unsigned int i=0; i<otherHits.size(); ++i )
+      {
+        const double distance = it->second + otherHits[i].Distance;
+        
+        if( otherHits[i].Branch != piece.Branch || distance >= candidate.Distance )
+          continue;
+        
+        candidate.End = otherEnd;
+        candidate.Distance = distance;
+        candidate.Cut = otherHits[i].SectionIndex + ( otherHits[i].Parameter > 0.5 ? 1 : 0 );
+      }
+    }
+  }
+  
+  return candidate;
+}
+
+
+template <class TCenterline>
+int VesselGraphStitcher<TCenterline>::FindChainStart( unsigned int piece ) const
+{
+  // Walk back to the free end of the chain, or around a closed chain back to this piece
+  int start = 2 * piece;
+  
+  for( unsigned int steps=0; steps<m_Pieces.size(); ++steps )
+  {
+    const int previous = m_Pieces[start/2].Link[start%2];
+    
+    if( previous < 0 )
+      break;
+      
+    if( static_cast<unsigned int>( previous / 2 ) == piece )
+      return start;
+    
+    start = previous ^ 1;
+  }
+  
+  if( start % 2 == 0 )
+    return start;
+    
+  // The chain would start at the last section of a branch, so start from the other free end 
+  // if that is the first section of a branch, which is usually where its parent is
+  int finish = start;
+  
+  for( unsigned int steps=0; steps<m_Pieces.size(); ++steps )
+  {
+    const int next = m_Pieces[finish/2].Link[ 1 - finish % 2 ];
+    
+    if( next < 0 )
+      break;
+      
+    finish = next;
+  }
+  
+  finish ^= 1;
+  
+  return ( finish % 2 == 0 ) ? finish : start;
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::AppendChain( int end, CenterlineType * centerline, 
+  int chain )
+{
+  while( end >= 0 && m_PieceChains[end/2] < 0 )
+  {
+    Piece & piece = m_Pieces[end/2];
+    m_PieceChains[end/2] = chain;
+    
+    typename CenterlineType::ConstPointer pieceCenterline = piece.Branch->GetCenterline();
+    const int numberOfSections = pieceCenterline->size();
+    
+    // Continue with the piece linked to the other end, if not taken yet
+    const int otherEnd = end ^ 1;
+    int next = piece.Link[ otherEnd % 2 ];
+    
+    if( next >= 0 && m_PieceChains[next/2] >= 0 )
+      next = -1;
+    
+    // Sections from this end, up to the section nearest to the next piece
+    if( end % 2 == 0 )
+    {
+      const int last = ( next >= 0 ) ? static_cast<int>( piece.Cut[1] ) : numberOfSections;
+      
+      for( int i=0; i<last; ++i )
+        centerline->push_back( pieceCenterline->ElementAt(i) );
+    }
+    else
+    {
+      const int first = ( next >= 0 ) ? static_cast<int>( piece.Cut[0] ) : -1;
+      
+      for( int i=numberOfSections-1; i>first; --i )
+        centerline->push_back( pieceCenterline->ElementAt(i) );
+    }
+    
+    if( next >= 0 )
+      ++m_NumberOfStitches;
+      
+    end = next;
+  }
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::Update()
+{
+  m_NumberOfStitches = 0;
+  
+  this->CollectPieces();
+  
+  // Link the ends that are the best match of each other
+  const int numberOfEnds = 2 * m_Pieces.size();
+  std::vector<Candidate> candidates( numberOfEnds );
+  
+  for( int end=0; end<numberOfEnds; ++end )
+    candidates[end] = this->FindCandidate( end );
+    
+  for( int end=0; end<numberOfEnds; ++end )
+  {
+    const int other = candidates[end].End;
+    
+    if( other < 0 || candidates[other].End != end )
+      continue;
+      
+    m_Pieces[end/2].Link[end%2] = other;
+    m_Pieces[end/2].Cut[end%2] = candidates[end].Cut;
+  }
+  
+  m_Output = VesselGraphType::New();
+  
+  VesselNode::Pointer rootNode = VesselNode::New();
+  rootNode->SetNodeId( 0 );
+  m_Output->SetRootNode( rootNode );
+  
+  m_PieceChains.assign( m_Pieces.size(), -1 );
+  m_Chains.clear();
+  m_ChainStarts.clear();
+  m_NodeCopies.clear();
+  
+  for( unsigned int i=0; i<m_Pieces.size(); ++i )
+  {
+    if( m_PieceChains[i] >= 0 )
+      continue;
+      
+    const int start = this->FindChainStart( i );
+    
+    CenterlinePointer centerline = CenterlineType::New();
+    this->AppendChain( start, centerline, m_Chains.size() );
+    
+    BranchNodePointer branch = BranchNodeType::New();
+    branch->SetCenterline( centerline );
+    branch->SetNodeId( m_Chains.size() + 1 );
+    
+    m_Chains.push_back( branch );
+    m_ChainStarts.push_back( start / 2 );
+  }
+  
+  // The other nodes are numbered after the chains
+  m_NextNodeId = m_Chains.size() + 1;
+  
+  for( unsigned int g=0; g<m_Graphs.size(); ++g )
+    this->LinkGraph( m_Graphs[g] );
+  
+  for( unsigned int c=0; c<m_Chains.size(); ++c )
+  {
+    if( m_Chains[c]->GetNumberOfParents() == 0 )
+      rootNode->AddChild( m_Chains[c] );
+  }
+  
+  m_Chains.clear();
+  m_NodeCopies.clear();
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::LinkGraph( const VesselGraphType * graph )
+{
+  if( graph->GetRootNode().IsNull() )
+    return;
+    
+  std::vector<const GraphNode*> pendingNodes( 1, graph->GetRootNode().GetPointer() );
+  std::set<const GraphNode*> visitedNodes;
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( !node || !visitedNodes.insert( node ).second )
+      continue;
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+    {
+      const GraphNode *child = node->GetChild(i);
+      
+      if( !child )
+        continue;
+        
+      // Only the first piece of a chain keeps its parents, the others continue it
+      typename std::map<const BranchNodeType*,unsigned int>::const_iterator pieceIt = 
+        m_PieceOfBranch.find( dynamic_cast<const BranchNodeType*>( child ) );
+        
+      if( pieceIt != m_PieceOfBranch.end() && 
+        m_ChainStarts[ m_PieceChains[ pieceIt->second ] ] != pieceIt->second )
+        continue;
+      
+      GraphNode *outputParent = this->GetOutputNode( node );
+      GraphNode *outputChild = this->GetOutputNode( child );
+      
+      if( !this->IsAncestor( outputChild, outputParent ) )
+        outputParent->AddChild( outputChild );
+    }
+    
+    // Children in reverse, so nodes are taken in graph order
+    for( unsigned int i=node->GetNumberOfChildren(); i>0; --i )
+      pendingNodes.push_back( node->GetChild(i-1) );
+  }
+}
+
+
+template <class TCenterline>
+GraphNode * VesselGraphStitcher<TCenterline>::GetOutputNode( const GraphNode * node )
+{
+  typename std::map<const BranchNodeType*,unsigned int>::const_iterator pieceIt = 
+    m_PieceOfBranch.find( dynamic_cast<const BranchNodeType*>( node ) );
+  
+  if( pieceIt != m_PieceOfBranch.end() )
+    return m_Chains[ m_PieceChains[ pieceIt->second ] ];
+    
+  if( node->GetNumberOfParents() == 0 )
+    return m_Output->GetRootNode().GetPointer();
+  
+  typename std::map<const GraphNode*,GraphNode::Pointer>::const_iterator copyIt = 
+    m_NodeCopies.find( node );
+    
+  if( copyIt != m_NodeCopies.end() )
+    return copyIt->second;
+    
+  itk::LightObject::Pointer object = node->CreateAnother();
+  GraphNode::Pointer copy = dynamic_cast<GraphNode*>( object.GetPointer() );
+  
+  if( copy.IsNull() )
+    itkExceptionMacro( "Could not copy node " << node->GetNodeId() << "." );
+    
+  copy->CopyInformation( node );
+  copy->SetNodeId( m_NextNodeId++ );
+  m_NodeCopies[node] = copy;
+  
+  return copy;
+}
+
+
+template <class TCenterline>
+bool VesselGraphStitcher<TCenterline>::IsAncestor( const GraphNode * ancestor, 
+  const GraphNode * node ) const
+{
+  std::vector<const GraphNode*> pendingNodes( 1, node );
+  std::set<const GraphNode*> visitedNodes;
+  
+  while( !pendingNodes.empty() )
+  {
+    const GraphNode *current = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    if( current == ancestor )
+      return true;
+      
+    if( !visitedNodes.insert( current ).second )
+      continue;
+      
+    for( unsigned int i=0; i<current->GetNumberOfParents(); ++i )
+      pendingNodes.push_back( current->GetParent(i) );
+  }
+  
+  return false;
+}
+
+
+template <class TCenterline>
+void VesselGraphStitcher<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Tolerance: " << m_Tolerance << std::endl;
+  os << indent << "NumberOfGraphs: " << m_Graphs.size() << std::endl;
+  os << indent << "NumberOfStitches: " << m_NumberOfStitches << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselGraphStitcher_hxx
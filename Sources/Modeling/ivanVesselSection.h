@@ -34,6 +34,7 @@ SUCH DAMAGE.
 #include "itkObject.h"
 
 #include "ivanNullVesselSectionStruct.h"
+#include "ivanArenaAllocator.h"
 
 
 namespace ivan
@@ -85,6 +86,9 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( VesselSection, itk::Object );
   
+  /** Sections are taken from the active ArenaAllocator, if any. */
+  ivanArenaAllocationMacro();
+  
   CurveMetricsType & GetCurveMetrics()
     { return m_CurveMetrics; }
   const CurveMetricsType & GetCurveMetrics() const
@@ -97,6 +101,15 @@ public:
     
   itkSetMacro( Center, CenterPointType & );
   itkGetConstMacro( Center, const CenterPointType & );
+  
+  /** Copy all the data of the given section. Subclasses copy their own members too. */
+  virtual void DeepCopy( const Self * section )
+    {
+      m_Center = section->m_Center;
+      m_CurveMetrics = section->m_CurveMetrics;
+      m_SectionMetrics = section->m_SectionMetrics;
+      this->Modified();
+    }
     
 protected:
   
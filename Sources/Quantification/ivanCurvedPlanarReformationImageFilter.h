@@ -0,0 +1,237 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCurvedPlanarReformationImageFilter.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: resamples an image on the planes of the sections of a vessel centerline.
+// Date: 2012/11/05
+
+#ifndef __ivanCurvedPlanarReformationImageFilter_h
+#define __ivanCurvedPlanarReformationImageFilter_h
+
+#include "ivanBrickedImageBuffer.h"
+
+#include "itkImageToImageFilter.h"
+#include "itkInterpolateImageFunction.h"
+#include "itkNumericTraits.h"
+#include "itkPoint.h"
+#include "itkVector.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class CurvedPlanarReformationImageFilter
+ *  \brief Resamples a 3D image on the planes of the sections of a vessel centerline.
+ *
+ * Every slice of the output is a plane of PlaneSize x PlaneSize pixels of PlaneSpacing, 
+ * centered at a point of the centerline and orthogonal to its normal. In CrossSectionStackMode 
+ * there is one slice per section. In StraightenedMode the centerline is resampled every 
+ * SliceSpacing along its length, interpolating linearly the centers and normals, so the output 
+ * is a straightened volume of the vessel. The in-plane axes are propagated from slice to slice 
+ * by parallel transport, so they do not twist around the vessel. The frame of every slice can 
+ * be queried to map positions back to the input.
+ *
+ * The output is split across threads by slices. All the threads share a single interpolator, 
+ * so it must be reentrant, as the linear one used by default is. With UseBrickedImage on, the
+ * image is sampled instead by linear interpolation from a BrickedImageBuffer, which keeps the
+ * neighbours of the oblique planes in a few contiguous bricks. A bricked copy can be shared 
+ * with other filters with SetBrickedImage(). Samples are computed a row at a time: the 
+ * continuous indices of a row are obtained by increments from its first one, instead of 
+ * transforming every point. Samples outside the image take DefaultPixelValue.
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
+ * \ingroup 
+ */
+
+template <class TInputImage, class TCenterline, class TOutputImage = TInputImage>
+class ITK_EXPORT CurvedPlanarReformationImageFilter : 
+  public itk::ImageToImageFilter<TInputImage,TOutputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef CurvedPlanarReformationImageFilter                 Self;
+  typedef itk::ImageToImageFilter<TInputImage,TOutputImage>  Superclass;
+  typedef itk::SmartPointer<Self>                            Pointer;
+  typedef itk::SmartPointer<const Self>                      ConstPointer;
+  
+  typedef TInputImage                                InputImageType;
+  typedef typename InputImageType::ConstPointer      InputImageConstPointer;
+  typedef TOutputImage                               OutputImageType;
+  typedef typename OutputImageType::PixelType        OutputPixelType;
+  typedef typename OutputImageType::RegionType       OutputImageRegionType;
+  
+  typedef TCenterline                                CenterlineType;
+  typedef typename CenterlineType::ConstPointer      CenterlineConstPointer;
+  typedef typename CenterlineType::SectionType       SectionType;
+  
+  /** Image dimension = 3. */
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
+  
+  typedef itk::Point<double,itkGetStaticConstMacro(ImageDimension)>    PointType;
+  typedef itk::Vector<double,itkGetStaticConstMacro(ImageDimension)>   VectorType;
+  
+  typedef itk::InterpolateImageFunction<InputImageType,double>  InterpolatorType;
+  typedef typename InterpolatorType::Pointer                    InterpolatorPointer;
+  typedef typename InterpolatorType::ContinuousIndexType        ContinuousIndexType;
+  
+  typedef BrickedImageBuffer<InputImageType>         BrickedImageType;
+  typedef typename BrickedImageType::Pointer         BrickedImagePointer;
+  
+  typedef enum { CrossSectionStackMode, StraightenedMode }  ReformationModeType;
+
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CurvedPlanarReformationImageFilter, itk::ImageToImageFilter );
+  
+  /** Set/Get the centerline, for instance that of a VesselBranchNode. */
+  void SetCenterline( const CenterlineType *centerline )
+    { m_Centerline = centerline; this->Modified(); }
+  const CenterlineType * GetCenterline() const
+    { return m_Centerline; }
+  
+  /** Set/Get the mode. Default is CrossSectionStackMode. */
+  itkSetMacro( ReformationMode, ReformationModeType );
+  itkGetConstMacro( ReformationMode, ReformationModeType );
+  
+  /** Set/Get the number of pixels of each side of the planes. Default is 64. */
+  itkSetClampMacro( PlaneSize, unsigned long, 1, itk::NumericTraits<unsigned long>::max() );
+  itkGetConstMacro( PlaneSize, unsigned long );
+  
+  /** Set/Get the spacing of the pixels in the planes. Zero, the default, uses the smallest 
+    * spacing of the input. */
+  itkSetMacro( PlaneSpacing, double );
+  itkGetConstMacro( PlaneSpacing, double );
+  
+  /** Set/Get the distance between slices in StraightenedMode. Zero, the default, uses the 
+    * plane spacing. */
+  itkSetMacro( SliceSpacing, double );
+  itkGetConstMacro( SliceSpacing, double );
+  
+  /** Set/Get the interpolator shared by all the threads. Default is linear. */
+  itkSetObjectMacro( Interpolator, InterpolatorType );
+  itkGetObjectMacro( Interpolator, InterpolatorType );
+  
+  /** Set/Get the flag for sampling from a bricked copy of the input. Off by default. */
+  itkSetMacro( UseBrickedImage, bool );
+  itkGetConstMacro( UseBrickedImage, bool );
+  itkBooleanMacro( UseBrickedImage );
+  
+  /** Set/Get the bricked copy of the input. If it is not a copy of the current input, it is 
+    * updated before sampling. */
+  itkSetObjectMacro( BrickedImage, BrickedImageType );
+  itkGetObjectMacro( BrickedImage, BrickedImageType );
+  
+  /** Set/Get the value of the samples outside the input. Default is zero. */
+  itkSetMacro( DefaultPixelValue, OutputPixelType );
+  itkGetConstMacro( DefaultPixelValue, OutputPixelType );
+  
+  /** Number of slices of the output, computed when the output information is generated. */
+  unsigned long GetNumberOfSlices() const
+    { return m_SliceCenters.size(); }
+  
+  /** Center of a slice, and its in-plane axes (0 and 1) and normal (2), in physical space. 
+    * The pixel (i,j) of the slice is at center + ( i - (PlaneSize-1)/2 ) * PlaneSpacing * axis0 
+    * + ( j - (PlaneSize-1)/2 ) * PlaneSpacing * axis1. */
+  const PointType & GetSliceCenter( unsigned long slice ) const
+    { return m_SliceCenters[slice]; }
+  const VectorType & GetSliceAxis( unsigned long slice, unsigned int axis ) const
+    { return m_SliceAxes[slice][axis]; }
+		
+protected:
+
+  CurvedPlanarReformationImageFilter();
+  ~CurvedPlanarReformationImageFilter() {}
+  
+  /** The output geometry is given by the planes, not by the input. */
+  virtual void GenerateOutputInformation();
+  
+  /** The planes may cross the whole input. */
+  virtual void GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError );
+  
+  /** Set the input to the shared interpolator and copy the bricks if needed. */
+  virtual void BeforeThreadedGenerateData();
+  
+  /** Sample the slices of the given region. */
+  virtual void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, 
+    int threadId );
+  
+  /** Compute the center and axes of every slice from the centerline. */
+  void ComputeSliceFrames();
+  
+  /** Spacing of the pixels in the planes, resolving the default. */
+  double GetEffectivePlaneSpacing() const;
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  CurvedPlanarReformationImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  /** Axes of the frame of a slice. */
+  struct SliceAxes
+  {
+    VectorType & operator[]( unsigned int axis )
+      { return Axes[axis]; }
+    const VectorType & operator[]( unsigned int axis ) const
+      { return Axes[axis]; }
+    
+    VectorType  Axes[3];
+  };
+
+  CenterlineConstPointer      m_Centerline;
+  ReformationModeType         m_ReformationMode;
+  
+  unsigned long               m_PlaneSize;
+  double                      m_PlaneSpacing;
+  double                      m_SliceSpacing;
+  
+  InterpolatorPointer         m_Interpolator;
+  bool                        m_UseBrickedImage;
+  BrickedImagePointer         m_BrickedImage;
+  OutputPixelType             m_DefaultPixelValue;
+  
+  std::vector<PointType>      m_SliceCenters;
+  std::vector<SliceAxes>      m_SliceAxes;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanCurvedPlanarReformationImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,396 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCurvedPlanarReformationImageFilter.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: resamples an image on the planes of the sections of a vessel centerline.
+// Date: 2012/11/05
+
+#ifndef __ivanCurvedPlanarReformationImageFilter_hxx
+#define __ivanCurvedPlanarReformationImageFilter_hxx
+
+#include "ivanCurvedPlanarReformationImageFilter.h"
+
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkImageRegionIterator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::CurvedPlanarReformationImageFilter() :
+  m_ReformationMode( CrossSectionStackMode ),
+  m_PlaneSize( 64 ),
+  m_PlaneSpacing( 0.0 ),
+  m_SliceSpacing( 0.0 ),
+  m_UseBrickedImage( false ),
+  m_DefaultPixelValue( itk::NumericTraits<OutputPixelType>::Zero )
+{
+  m_Interpolator = itk::LinearInterpolateImageFunction<InputImageType,double>::New();
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+double
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::GetEffectivePlaneSpacing() const
+{
+  if( m_PlaneSpacing > 0.0 )
+    return m_PlaneSpacing;
+  
+  const typename InputImageType::SpacingType & spacing = this->GetInput()->GetSpacing();
+  
+  double minSpacing = spacing[0];
+  for( unsigned int d=1; d<ImageDimension; ++d )
+    minSpacing = vnl_math_min( minSpacing, (double)spacing[d] );
+  
+  return minSpacing;
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::GenerateOutputInformation()
+{
+  if( !this->GetInput() )
+    itkExceptionMacro( "No input image given." );
+  
+  if( m_Centerline.IsNull() || m_Centerline->empty() )
+    itkExceptionMacro( "No centerline given, or the centerline has no sections." );
+  
+  this->ComputeSliceFrames();
+  
+  const double planeSpacing = this->GetEffectivePlaneSpacing();
+  
+  typename OutputImageType::SizeType size;
+  size[0] = size[1] = m_PlaneSize;
+  size[2] = m_SliceCenters.size();
+  
+  typename OutputImageType::IndexType index;
+  index.Fill( 0 );
+  
+  OutputImageRegionType region;
+  region.SetSize( size );
+  region.SetIndex( index );
+  
+  typename OutputImageType::SpacingType spacing;
+  spacing[0] = spacing[1] = planeSpacing;
+  spacing[2] = 1.0;
+  
+  if( m_ReformationMode == StraightenedMode )
+    spacing[2] = ( m_SliceSpacing > 0.0 ) ? m_SliceSpacing : planeSpacing;
+  
+  // The pixel at the center of the plane is at the centerline
+  typename OutputImageType::PointType origin;
+  origin[0] = origin[1] = -0.5 * ( m_PlaneSize - 1.0 ) * planeSpacing;
+  origin[2] = 0.0;
+  
+  typename OutputImageType::DirectionType direction;
+  direction.SetIdentity();
+  
+  OutputImageType *output = this->GetOutput();
+  output->SetLargestPossibleRegion( region );
+  output->SetSpacing( spacing );
+  output->SetOrigin( origin );
+  output->SetDirection( direction );
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::GenerateInputRequestedRegion() throw( itk::InvalidRequestedRegionError )
+{
+  Superclass::GenerateInputRequestedRegion();
+  
+  InputImageType *input = const_cast<InputImageType*>( this->GetInput() );
+  
+  if( input )
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::ComputeSliceFrames()
+{
+  const CenterlineType *centerline = m_Centerline;
+  
+  // Centers and unit normals of the sections, with consecutive normals in the same sense
+  std::vector<PointType> centers( centerline->size() );
+  std::vector<VectorType> normals( centerline->size() );
+  
+  for( unsigned int i=0; i<centerline->size(); ++i )
+  {
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      centers[i][d] = centerline->at(i)->GetCenter()[d];
+      normals[i][d] = centerline->at(i)->GetNormal()[d];
+    }
+    
+    if( normals[i].GetNorm() > 0.0 )
+      normals[i].Normalize();
+    else if( i > 0 )
+      normals[i] = normals[i-1];
+    
+    if( i > 0 && normals[i] * normals[i-1] < 0.0 )
+      normals[i] = -normals[i];
+  }
+  
+  // A section without normal at the start takes the first valid one, or the z axis
+  unsigned int firstValid = 0;
+  while( firstValid < normals.size() && normals[firstValid].GetNorm() == 0.0 )
+    ++firstValid;
+  
+  for( unsigned int i=0; i<firstValid; ++i )
+  {
+    if( firstValid < normals.size() )
+      normals[i] = normals[firstValid];
+    else
+    {
+      normals[i].Fill( 0.0 );
+      normals[i][2] = 1.0;
+    }
+  }
+  
+  m_SliceCenters.clear();
+  std::vector<VectorType> sliceNormals;
+  
+  if( m_ReformationMode == StraightenedMode && centers.size() > 1 )
+  {
+    const double sliceSpacing = ( m_SliceSpacing > 0.0 ) ? m_SliceSpacing : 
+      this->GetEffectivePlaneSpacing();
+    
+    std::vector<double> distances( centers.size(), 0.0 );
+    for( unsigned int i=1; i<centers.size(); ++i )
+      distances[i] = distances[i-1] + centers[i].EuclideanDistanceTo( centers[i-1] );
+    
+    const unsigned long numberOfSlices = 
+      static_cast<unsigned long>( std::floor( distances.back() / sliceSpacing ) ) + 1;
+    
+    unsigned int segment = 0;
+    
+    for( unsigned long k=0; k<numberOfSlices; ++k )
+    {
+      const double position = k * sliceSpacing;
+      
+      while( segment + 2 < centers.size() && distances[segment+1] < position )
+        ++segment;
+      
+      const double length = distances[segment+1] - distances[segment];
+      const double t = ( length > 0.0 ) ? 
+        vnl_math_min( 1.0, ( position - distances[segment] ) / length ) : 0.0;
+      
+      PointType center;
+      VectorType normal;
+      
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        center[d] = ( 1.0 - t ) * centers[segment][d] + t * centers[segment+1][d];
+        normal[d] = ( 1.0 - t ) * normals[segment][d] + t * normals[segment+1][d];
+      }
+      
+      if( normal.GetNorm() > 0.0 )
+        normal.Normalize();
+      else
+        normal = normals[segment];
+      
+      m_SliceCenters.push_back( center );
+      sliceNormals.push_back( normal );
+    }
+  }
+  else
+  {
+    m_SliceCenters = centers;
+    sliceNormals = normals;
+  }
+  
+  // Parallel transport of the in-plane axes, starting from the image axis most orthogonal to 
+  // the first normal
+  m_SliceAxes.resize( m_SliceCenters.size() );
+  
+  VectorType axis0;
+  axis0.Fill( 0.0 );
+  
+  for( unsigned long k=0; k<m_SliceCenters.size(); ++k )
+  {
+    const VectorType & normal = sliceNormals[k];
+    
+    axis0 = axis0 - normal * ( axis0 * normal );
+    
+    if( axis0.GetNorm() < 1e-6 )
+    {
+      unsigned int smallest = 0;
+      for( unsigned int d=1; d<ImageDimension; ++d )
+      {
+        if( std::fabs( normal[d] ) < std::fabs( normal[smallest] ) )
+          smallest = d;
+      }
+      
+      axis0.Fill( 0.0 );
+      axis0[smallest] = 1.0;
+      axis0 = axis0 - normal * ( axis0 * normal );
+    }
+    
+    axis0.Normalize();
+    
+    m_SliceAxes[k][0] = axis0;
+    m_SliceAxes[k][1] = itk::CrossProduct( normal, axis0 );
+    m_SliceAxes[k][2] = normal;
+  }
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  if( m_Interpolator.IsNull() )
+    itkExceptionMacro( "No interpolator given." );
+  
+  const InputImageType *input = this->GetInput();
+  
+  // The interpolator also tells whether samples are inside the image in bricked mode
+  m_Interpolator->SetInputImage( input );
+  
+  if( m_UseBrickedImage )
+  {
+    if( m_BrickedImage.IsNull() )
+      m_BrickedImage = BrickedImageType::New();
+    
+    if( !m_BrickedImage->IsCopyOf( input ) )
+      m_BrickedImage->CopyImage( input );
+  }
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, int threadId )
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *output = this->GetOutput();
+  
+  const double planeSpacing = this->GetEffectivePlaneSpacing();
+  const double halfSize = 0.5 * ( m_PlaneSize - 1.0 );
+  
+  const typename OutputImageType::IndexType & start = outputRegionForThread.GetIndex();
+  const typename OutputImageType::SizeType & size = outputRegionForThread.GetSize();
+  
+  const bool bricked = m_UseBrickedImage && m_BrickedImage.IsNotNull();
+  
+  std::vector<ContinuousIndexType> rowIndices( size[0] );
+  
+  itk::ImageRegionIterator<OutputImageType> it( output, outputRegionForThread );
+  it.GoToBegin();
+  
+  for( unsigned long k=0; k<size[2]; ++k )
+  {
+    const unsigned long slice = start[2] + k;
+    const PointType & center = m_SliceCenters[slice];
+    const SliceAxes & axes = m_SliceAxes[slice];
+    
+    // The plane is an affine map of the pixel indices, and so are the continuous indices
+    typename InputImageType::PointType point, point0, point1;
+    ContinuousIndexType origin, index0, index1;
+    
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      point[d] = center[d] - halfSize * planeSpacing * ( axes[0][d] + axes[1][d] );
+      point0[d] = point[d] + planeSpacing * axes[0][d];
+      point1[d] = point[d] + planeSpacing * axes[1][d];
+    }
+    
+    input->TransformPhysicalPointToContinuousIndex( point, origin );
+    input->TransformPhysicalPointToContinuousIndex( point0, index0 );
+    input->TransformPhysicalPointToContinuousIndex( point1, index1 );
+    
+    VectorType step0, step1;
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      step0[d] = index0[d] - origin[d];
+      step1[d] = index1[d] - origin[d];
+    }
+    
+    for( unsigned long j=0; j<size[1]; ++j )
+    {
+      const double row = start[1] + j;
+      
+      // Continuous indices of the whole row first, then the samples
+      for( unsigned long i=0; i<size[0]; ++i )
+      {
+        const double column = start[0] + i;
+        
+        for( unsigned int d=0; d<ImageDimension; ++d )
+          rowIndices[i][d] = origin[d] + column * step0[d] + row * step1[d];
+      }
+      
+      for( unsigned long i=0; i<size[0]; ++i, ++it )
+      {
+        if( !m_Interpolator->IsInsideBuffer( rowIndices[i] ) )
+          it.Set( m_DefaultPixelValue );
+        else if( bricked )
+          it.Set( static_cast<OutputPixelType>( 
+            m_BrickedImage->EvaluateLinearAtContinuousIndex( rowIndices[i] ) ) );
+        else
+          it.Set( static_cast<OutputPixelType>( 
+            m_Interpolator->EvaluateAtContinuousIndex( rowIndices[i] ) ) );
+      }
+    }
+  }
+}
+
+
+template <class TInputImage, class TCenterline, class TOutputImage>
+void
+CurvedPlanarReformationImageFilter<TInputImage,TCenterline,TOutputImage>
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Centerline: " << m_Centerline.GetPointer() << std::endl;
+  os << indent << "ReformationMode: " << m_ReformationMode << std::endl;
+  os << indent << "PlaneSize: " << m_PlaneSize << std::endl;
+  os << indent << "PlaneSpacing: " << m_PlaneSpacing << std::endl;
+  os << indent << "SliceSpacing: " << m_SliceSpacing << std::endl;
+  os << indent << "Interpolator: " << m_Interpolator.GetPointer() << std::endl;
+  os << indent << "UseBrickedImage: " << m_UseBrickedImage << std::endl;
+  os << indent << "BrickedImage: " << m_BrickedImage.GetPointer() << std::endl;
+  os << indent << "DefaultPixelValue: " << m_DefaultPixelValue << std::endl;
+  os << indent << "NumberOfSlices: " << m_SliceCenters.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
@@ -0,0 +1,216 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphCurveMetricsCalculator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Computes curve metrics and tortuosity for all the branches of a frozen graph at once.
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraphCurveMetricsCalculator_h
+#define __ivanFrozenVesselGraphCurveMetricsCalculator_h
+
+#include "ivanFrozenVesselGraph.h"
+#include "ivanLocalCurveMetrics.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class FrozenVesselGraphCurveMetricsCalculator
+ *  \brief Computes curve metrics and tortuosity for all the branches of a FrozenVesselGraph.
+ *
+ * VesselCenterlineMetricsCalculatorVisitor applies a calculator branch by branch, accessing 
+ * every section through its smart pointer. This class works instead on the contiguous array 
+ * of section centers of a FrozenVesselGraph. The centers of a branch are copied into one array 
+ * per coordinate, and every quantity is then computed in simple loops over those arrays: the 
+ * arclength as a prefix sum of the segment lengths, and the first, second and third derivatives 
+ * with respect to the arclength by non-uniform three point finite differences. From these the 
+ * curvature, the torsion (3D only) and the Frenet frame are obtained for every section.
+ *
+ * For every branch two tortuosity indices are computed as well: the distance metric, which 
+ * is the ratio between the length and the distance between the end points, and the sum of 
+ * angles metric, which is the total turning angle between consecutive segments divided by the 
+ * length.
+ *
+ * Results are kept in arrays indexed like the sections of the frozen graph. If 
+ * WriteCurveMetrics is on (default) they are also stored in the curve metrics of the sections, 
+ * which must be of type LocalCurveMetrics, and thus in the original graph, since the sections 
+ * are shared.
+ *
+ * Branches are distributed among threads from a shared counter, longest first, as in 
+ * VesselGraphCenterlineProcessor. Every branch writes its own range of the arrays, so no 
+ * further synchronization is needed.
+ *
+ * \ingroup 
+ */
+
+template <class TCenterline>
+class ITK_EXPORT FrozenVesselGraphCurveMetricsCalculator : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef FrozenVesselGraphCurveMetricsCalculator  Self;
+  typedef itk::Object                              Superclass;
+  typedef itk::SmartPointer<Self>                  Pointer;
+  typedef itk::SmartPointer<const Self>            ConstPointer;
+ 
+  typedef TCenterline                              CenterlineType;
+  typedef FrozenVesselGraph<CenterlineType>        FrozenGraphType;
+  typedef typename FrozenGraphType::Pointer        FrozenGraphPointer;
+  typedef typename FrozenGraphType::NodeIndex      NodeIndex;
+  
+  typedef typename FrozenGraphType::SectionType    SectionType;
+  typedef typename SectionType::CurveMetricsType   CurveMetricsType;
+  typedef typename CurveMetricsType::VectorType    VectorType;
+  
+  itkStaticConstMacro( Dimension, unsigned int, SectionType::Dimension );
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrozenVesselGraphCurveMetricsCalculator, itk::Object );
+  
+  /** Set/Get the frozen graph. */
+  void SetFrozenGraph( FrozenGraphType *graph )
+    { m_FrozenGraph = graph; this->Modified(); }
+  FrozenGraphType * GetFrozenGraph()
+    { return m_FrozenGraph; }
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Store the results in the curve metrics of the sections. Default is on. */
+  itkSetMacro( WriteCurveMetrics, bool );
+  itkGetConstMacro( WriteCurveMetrics, bool );
+  itkBooleanMacro( WriteCurveMetrics );
+  
+  /** Compute the metrics of all the branches of the frozen graph. */
+  void Compute();
+  
+  /** Per section results. */
+  double GetArcLength( NodeIndex node, unsigned int pos ) const
+    { return m_ArcLengths[ m_FrozenGraph->GetSectionOffset( node ) + pos ]; }
+  double GetCurvature( NodeIndex node, unsigned int pos ) const
+    { return m_Curvatures[ m_FrozenGraph->GetSectionOffset( node ) + pos ]; }
+  double GetTorsion( NodeIndex node, unsigned int pos ) const
+    { return m_Torsions[ m_FrozenGraph->GetSectionOffset( node ) + pos ]; }
+  VectorType GetTangent( NodeIndex node, unsigned int pos ) const;
+  
+  /** Per node results. Nodes that are not branches have zero values. */
+  double GetBranchLength( NodeIndex node ) const
+    { return m_BranchLengths[node]; }
+  double GetDistanceMetric( NodeIndex node ) const
+    { return m_DistanceMetrics[node]; }
+  double GetSumOfAnglesMetric( NodeIndex node ) const
+    { return m_SumOfAnglesMetrics[node]; }
+  
+  /** Get the number of branches and sections processed by the last call to Compute(). */
+  itkGetConstMacro( NumberOfProcessedBranches, unsigned int );
+  itkGetConstMacro( NumberOfProcessedSections, unsigned long );
+		
+protected:
+
+  FrozenVesselGraphCurveMetricsCalculator();
+  ~FrozenVesselGraphCurveMetricsCalculator() {}
+  
+  /** Arrays used by a thread to compute a branch, reused from branch to branch. */
+  struct BranchBuffers
+  {
+    std::vector<double>   Coordinates[Dimension];
+    std::vector<double>   FirstDerivatives[Dimension];
+    std::vector<double>   SecondDerivatives[Dimension];
+    std::vector<double>   ThirdDerivatives[Dimension];
+    std::vector<double>   SegmentLengths;
+    std::vector<double>   FirstDerivativeWeights[3];
+    std::vector<double>   SecondDerivativeWeights[3];
+  };
+  
+  /** Compute the metrics of a branch. */
+  void ComputeBranch( NodeIndex node, BranchBuffers & buffers );
+  
+  /** Apply the finite difference weights to an array, copying the values at the ends. */
+  static void ApplyWeights( const std::vector<double> * weights, const double *values, 
+    double *result, unsigned int size );
+  
+  /** Compute the branches taken from the shared counter until there are no more. */
+  void ThreadedCompute();
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  FrozenVesselGraphCurveMetricsCalculator(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  FrozenGraphPointer              m_FrozenGraph;
+  
+  bool                            m_WriteCurveMetrics;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  std::vector<NodeIndex>          m_Branches;
+  unsigned int                    m_NextBranch;
+  itk::SimpleFastMutexLock        m_BranchMutex;
+  
+  /** Per section results. */
+  std::vector<double>             m_ArcLengths;
+  std::vector<double>             m_Curvatures;
+  std::vector<double>             m_Torsions;
+  std::vector<double>             m_Tangents[Dimension];
+  
+  /** Per node results. */
+  std::vector<double>             m_BranchLengths;
+  std::vector<double>             m_DistanceMetrics;
+  std::vector<double>             m_SumOfAnglesMetrics;
+  
+  unsigned int                    m_NumberOfProcessedBranches;
+  unsigned long                   m_NumberOfProcessedSections;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanFrozenVesselGraphCurveMetricsCalculator.hxx"
+#endif
+
+#endif
@@ -0,0 +1,404 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphCurveMetricsCalculator.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Computes curve metrics and tortuosity for all the branches of a frozen graph at once.
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraphCurveMetricsCalculator_hxx
+#define __ivanFrozenVesselGraphCurveMetricsCalculator_hxx
+
+#include "ivanFrozenVesselGraphCurveMetricsCalculator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+FrozenVesselGraphCurveMetricsCalculator<TCenterline>::FrozenVesselGraphCurveMetricsCalculator() :
+  m_WriteCurveMetrics( true ),
+  m_NextBranch( 0 ),
+  m_NumberOfProcessedBranches( 0 ),
+  m_NumberOfProcessedSections( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TCenterline>
+typename FrozenVesselGraphCurveMetricsCalculator<TCenterline>::VectorType
+FrozenVesselGraphCurveMetricsCalculator<TCenterline>::GetTangent( NodeIndex node, unsigned int pos ) const
+{
+  const unsigned long s = m_FrozenGraph->GetSectionOffset( node ) + pos;
+  
+  VectorType tangent;
+  for( unsigned int d=0; d<Dimension; ++d )
+    tangent[d] = m_Tangents[d][s];
+    
+  return tangent;
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphCurveMetricsCalculator<TCenterline>::Compute()
+{
+  if( m_FrozenGraph.IsNull() )
+    itkExceptionMacro( "Frozen graph not set." );
+  
+  const unsigned int numberOfNodes = m_FrozenGraph->GetNumberOfNodes();
+  const unsigned long numberOfSections = m_FrozenGraph->GetTotalNumberOfSections();
+  
+  m_ArcLengths.assign( numberOfSections, 0.0 );
+  m_Curvatures.assign( numberOfSections, 0.0 );
+  m_Torsions.assign( numberOfSections, 0.0 );
+  for( unsigned int d=0; d<Dimension; ++d )
+    m_Tangents[d].assign( numberOfSections, 0.0 );
+    
+  m_BranchLengths.assign( numberOfNodes, 0.0 );
+  m_DistanceMetrics.assign( numberOfNodes, 0.0 );
+  m_SumOfAnglesMetrics.assign( numberOfNodes, 0.0 );
+  
+  m_Branches.clear();
+  m_NumberOfProcessedSections = 0;
+  
+  for( NodeIndex n=0; n<numberOfNodes; ++n )
+  {
+    if( m_FrozenGraph->IsBranch( n ) && m_FrozenGraph->GetNumberOfSections( n ) )
+    {
+      m_Branches.push_back( n );
+      m_NumberOfProcessedSections += m_FrozenGraph->GetNumberOfSections( n );
+    }
+  }
+  
+  std::stable_sort( m_Branches.begin(), m_Branches.end(), 
+    FrozenBranchLongerThan<FrozenGraphType>( m_FrozenGraph ) );
+  
+  m_NextBranch = 0;
+  
+  if( m_Branches.size() > 1 )
+  {
+    m_Threader->SetNumberOfThreads( vnl_math_min( m_NumberOfThreads, (int)m_Branches.size() ) );
+    m_Threader->SetSingleMethod( this->ComputeThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedCompute();
+  }
+  
+  m_NumberOfProcessedBranches = m_Branches.size();
+  m_Branches.clear();
+}
+
+
+template <class TCenterline>
+ITK_THREAD_RETURN_TYPE
+FrozenVesselGraphCurveMetricsCalculator<TCenterline>::ComputeThreaderCallback( void *arg )
+{
+  Self *calculator = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  calculator->ThreadedCompute();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphCurveMetricsCalculator<TCenterline>::ThreadedCompute()
+{
+  BranchBuffers buffers;
+  NodeIndex node;
+  bool found;
+  
+  while( true )
+  {
+    m_BranchMutex.Lock();
+    found = ( m_NextBranch < m_Branches.size() );
+    if( found )
+      node = m_Branches[ m_NextBranch++ ];
+    m_BranchMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    this->ComputeBranch( node, buffers );
+  }
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphCurveMetricsCalculator<TCenterline>::ApplyWeights
+  ( const std::vector<double> * weights, const double *values, double *result, unsigned int size )
+{
+  const double *previousWeights = &weights[0][0];
+  const double *currentWeights = &weights[1][0];
+  const double *nextWeights = &weights[2][0];
+  
+  for( unsigned int i=1; i+1<size; ++i )
+    result[i] = previousWeights[i] * values[i-1] + currentWeights[i] * values[i] + 
+      nextWeights[i] * values[i+1];
+    
+  result[0] = result[1];
+  result[size-1] = result[size-2];
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphCurveMetricsCalculator<TCenterline>::ComputeBranch
+  ( NodeIndex node, BranchBuffers & buffers )
+{
+  const unsigned int size = m_FrozenGraph->GetNumberOfSections( node );
+  const unsigned long offset = m_FrozenGraph->GetSectionOffset( node );
+  
+  // Copy the centers into one array per coordinate
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    buffers.Coordinates[d].resize( size );
+    buffers.FirstDerivatives[d].assign( size, 0.0 );
+    buffers.SecondDerivatives[d].assign( size, 0.0 );
+    buffers.ThirdDerivatives[d].assign( size, 0.0 );
+  }
+  
+  for( unsigned int i=0; i<size; ++i )
+  {
+    const typename FrozenGraphType::CenterPointType & center = m_FrozenGraph->GetSectionCenter( node, i );
+    for( unsigned int d=0; d<Dimension; ++d )
+      buffers.Coordinates[d][i] = center[d];
+  }
+  
+  // Segment lengths and arclength
+  buffers.SegmentLengths.assign( size, 0.0 );
+  double *segmentLengths = &buffers.SegmentLengths[0];
+  
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    const double *coordinates = &buffers.Coordinates[d][0];
+    for( unsigned int i=0; i+1<size; ++i )
+    {
+      const double delta = coordinates[i+1] - coordinates[i];
+      segmentLengths[i] += delta * delta;
+    }
+  }
+  
+  for( unsigned int i=0; i+1<size; ++i )
+    segmentLengths[i] = std::sqrt( segmentLengths[i] );
+    
+  double *arcLengths = &m_ArcLengths[offset];
+  arcLengths[0] = 0.0;
+  for( unsigned int i=1; i<size; ++i )
+    arcLengths[i] = arcLengths[i-1] + segmentLengths[i-1];
+    
+  const double length = arcLengths[size-1];
+  m_BranchLengths[node] = length;
+  
+  // Distance metric
+  double chordSquaredLength = 0.0;
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    const double delta = buffers.Coordinates[d][size-1] - buffers.Coordinates[d][0];
+    chordSquaredLength += delta * delta;
+  }
+  
+  m_DistanceMetrics[node] = ( chordSquaredLength > 0.0 ) ? length / std::sqrt( chordSquaredLength ) : 0.0;
+  
+  if( size == 2 )
+  {
+    // A single segment, straight
+    for( unsigned int d=0; d<Dimension; ++d )
+    {
+      const double tangent = ( length > 0.0 ) ? 
+        ( buffers.Coordinates[d][1] - buffers.Coordinates[d][0] ) / length : 0.0;
+      m_Tangents[d][offset] = m_Tangents[d][offset+1] = tangent;
+    }
+  }
+  else if( size > 2 )
+  {
+    // Weights of the non-uniform three point finite differences
+    for( unsigned int k=0; k<3; ++k )
+    {
+      buffers.FirstDerivativeWeights[k].assign( size, 0.0 );
+      buffers.SecondDerivativeWeights[k].assign( size, 0.0 );
+    }
+    
+    for( unsigned int i=1; i+1<size; ++i )
+    {
+      const double h0 = segmentLengths[i-1];
+      const double h1 = segmentLengths[i];
+      
+      if( h0 <= 0.0 || h1 <= 0.0 )
+        continue;
+        
+      buffers.FirstDerivativeWeights[0][i] = -h1 / ( h0 * ( h0 + h1 ) );
+      buffers.FirstDerivativeWeights[1][i] = ( h1 - h0 ) / ( h0 * h1 );
+      buffers.FirstDerivativeWeights[2][i] = h0 / ( h1 * ( h0 + h1 ) );
+      
+      buffers.SecondDerivativeWeights[0][i] = 2.0 / ( h0 * ( h0 + h1 ) );
+      buffers.SecondDerivativeWeights[1][i] = -2.0 / ( h0 * h1 );
+      buffers.SecondDerivativeWeights[2][i] = 2.0 / ( h1 * ( h0 + h1 ) );
+    }
+    
+    for( unsigned int d=0; d<Dimension; ++d )
+    {
+      ApplyWeights( buffers.FirstDerivativeWeights, &buffers.Coordinates[d][0], 
+        &buffers.FirstDerivatives[d][0], size );
+      ApplyWeights( buffers.SecondDerivativeWeights, &buffers.Coordinates[d][0], 
+        &buffers.SecondDerivatives[d][0], size );
+      ApplyWeights( buffers.FirstDerivativeWeights, &buffers.SecondDerivatives[d][0], 
+        &buffers.ThirdDerivatives[d][0], size );
+        
+      // The third derivative next to the ends uses copied second derivatives, take it 
+      // from the nearest section that does not
+      if( size > 4 )
+      {
+        double *thirdDerivatives = &buffers.ThirdDerivatives[d][0];
+        thirdDerivatives[0] = thirdDerivatives[1] = thirdDerivatives[2];
+        thirdDerivatives[size-1] = thirdDerivatives[size-2] = thirdDerivatives[size-3];
+      }
+    }
+    
+    // Curvature, torsion and tangent
+    double *curvatures = &m_Curvatures[offset];
+    double *torsions = &m_Torsions[offset];
+    
+    for( unsigned int i=0; i<size; ++i )
+    {
+      double d1SquaredNorm = 0.0;
+      double d2SquaredNorm = 0.0;
+      double dot12 = 0.0;
+      
+      for( unsigned int d=0; d<Dimension; ++d )
+      {
+        const double d1 = buffers.FirstDerivatives[d][i];
+        const double d2 = buffers.SecondDerivatives[d][i];
+        d1SquaredNorm += d1 * d1;
+        d2SquaredNorm += d2 * d2;
+        dot12 += d1 * d2;
+      }
+      
+      const double d1Norm = std::sqrt( d1SquaredNorm );
+      const double crossSquaredNorm = vnl_math_max( 0.0, d1SquaredNorm * d2SquaredNorm - dot12 * dot12 );
+      
+      curvatures[i] = ( d1Norm > 0.0 ) ? std::sqrt( crossSquaredNorm ) / ( d1SquaredNorm * d1Norm ) : 0.0;
+      
+      for( unsigned int d=0; d<Dimension; ++d )
+        m_Tangents[d][offset+i] = ( d1Norm > 0.0 ) ? buffers.FirstDerivatives[d][i] / d1Norm : 0.0;
+        
+      if( Dimension == 3 && crossSquaredNorm > 0.0 )
+      {
+        // Indices written so they are valid for all dimensions, only used in 3D
+        const unsigned int x = 0, y = 1 % Dimension, z = 2 % Dimension;
+        
+        const std::vector<double> * d1 = buffers.FirstDerivatives;
+        const std::vector<double> * d2 = buffers.SecondDerivatives;
+        const std::vector<double> * d3 = buffers.ThirdDerivatives;
+        
+        const double determinant = 
+          d1[x][i] * ( d2[y][i] * d3[z][i] - d2[z][i] * d3[y][i] ) -
+          d1[y][i] * ( d2[x][i] * d3[z][i] - d2[z][i] * d3[x][i] ) +
+          d1[z][i] * ( d2[x][i] * d3[y][i] - d2[y][i] * d3[x][i] );
+          
+        torsions[i] = determinant / crossSquaredNorm;
+      }
+    }
+    
+    // Sum of angles metric
+    double totalAngle = 0.0;
+    
+    for( unsigned int i=1; i+1<size; ++i )
+    {
+      double uSquaredNorm = 0.0;
+      double vSquaredNorm = 0.0;
+      double dot = 0.0;
+      
+      for( unsigned int d=0; d<Dimension; ++d )
+      {
+        const double u = buffers.Coordinates[d][i] - buffers.Coordinates[d][i-1];
+        const double v = buffers.Coordinates[d][i+1] - buffers.Coordinates[d][i];
+        uSquaredNorm += u * u;
+        vSquaredNorm += v * v;
+        dot += u * v;
+      }
+      
+      const double cross = std::sqrt( vnl_math_max( 0.0, uSquaredNorm * vSquaredNorm - dot * dot ) );
+      totalAngle += std::atan2( cross, dot );
+    }
+    
+    m_SumOfAnglesMetrics[node] = ( length > 0.0 ) ? totalAngle / length : 0.0;
+  }
+  
+  if( !m_WriteCurveMetrics )
+    return;
+  
+  // Store in the sections
+  for( unsigned int i=0; i<size; ++i )
+  {
+    CurveMetricsType & metrics = m_FrozenGraph->GetWritableSection( node, i )->GetCurveMetrics();
+    
+    VectorType tangent, normal;
+    double tangentDot = 0.0;
+    
+    for( unsigned int d=0; d<Dimension; ++d )
+    {
+      tangent[d] = m_Tangents[d][offset+i];
+      tangentDot += buffers.SecondDerivatives[d][i] * tangent[d];
+    }
+    
+    for( unsigned int d=0; d<Dimension; ++d )
+      normal[d] = buffers.SecondDerivatives[d][i] - tangentDot * tangent[d];
+      
+    const double normalNorm = normal.GetNorm();
+    if( normalNorm > 0.0 )
+      normal /= normalNorm;
+    
+    metrics.SetTangent( tangent );
+    metrics.SetNormal( normal );
+    metrics.CalculateBinormal();
+    metrics.SetCurvature( m_Curvatures[offset+i] );
+    metrics.SetTorsion( m_Torsions[offset+i] );
+  }
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphCurveMetricsCalculator<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FrozenGraph: " << m_FrozenGraph.GetPointer() << std::endl;
+  os << indent << "WriteCurveMetrics: " << m_WriteCurveMetrics << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfProcessedBranches: " << m_NumberOfProcessedBranches << std::endl;
+  os << indent << "NumberOfProcessedSections: " << m_NumberOfProcessedSections << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanFrozenVesselGraphCurveMetricsCalculator_hxx
@@ -0,0 +1,237 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphQuantifier.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Per branch and whole tree measurements of a frozen graph in one parallel pass.
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraphQuantifier_h
+#define __ivanFrozenVesselGraphQuantifier_h
+
+#include "ivanFrozenVesselGraph.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class FrozenVesselGraphQuantifier
+ *  \brief Per branch and whole tree measurements of a FrozenVesselGraph.
+ *
+ * For every branch this computes the length, the volume, the mean radius and the 
+ * tortuosity, given by the distance metric (length divided by the distance between the end 
+ * points). The volume is the sum of the truncated cones between consecutive sections, so the 
+ * sections must have a radius, as CircularVesselSection does. For every bifurcation node 
+ * (VesselBifurcationNode) the bifurcation angle is computed as the largest angle between the 
+ * initial directions of its child branches. The direction of a branch is taken from its first 
+ * section to the section BifurcationDirectionOffset positions after it, or the last one.
+ *
+ * The whole tree measurements are the total length and volume, the mean and maximum 
+ * tortuosity of the branches, the mean and maximum bifurcation angle and a histogram of the 
+ * radius of all the sections, with NumberOfRadiusBins bins between RadiusHistogramMinimum and 
+ * RadiusHistogramMaximum. Values outside the range go to the first or last bin.
+ *
+ * All of them are computed in a single parallel pass over the nodes. Threads take nodes 
+ * from a shared counter, store the per node results in arrays indexed by node, every thread 
+ * accumulating the tree measurements in its own partial result, and the partial results are 
+ * merged at the end. Since nodes are assigned to threads dynamically, sums may differ in the 
+ * last bits from run to run.
+ *
+ * \ingroup 
+ */
+
+template <class TCenterline>
+class ITK_EXPORT FrozenVesselGraphQuantifier : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef FrozenVesselGraphQuantifier       Self;
+  typedef itk::Object                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+ 
+  typedef TCenterline                             CenterlineType;
+  typedef FrozenVesselGraph<CenterlineType>       FrozenGraphType;
+  typedef typename FrozenGraphType::ConstPointer  FrozenGraphConstPointer;
+  typedef typename FrozenGraphType::NodeIndex     NodeIndex;
+  typedef typename FrozenGraphType::SectionType   SectionType;
+  
+  typedef std::vector<unsigned long>              HistogramType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FrozenVesselGraphQuantifier, itk::Object );
+  
+  /** Set/Get the frozen graph. */
+  void SetFrozenGraph( const FrozenGraphType *graph )
+    { m_FrozenGraph = graph; this->Modified(); }
+  const FrozenGraphType * GetFrozenGraph() const
+    { return m_FrozenGraph; }
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Set/Get the histogram of radius. Default is 20 bins in [0,10]. */
+  itkSetClampMacro( NumberOfRadiusBins, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfRadiusBins, unsigned int );
+  itkSetMacro( RadiusHistogramMinimum, double );
+  itkGetConstMacro( RadiusHistogramMinimum, double );
+  itkSetMacro( RadiusHistogramMaximum, double );
+  itkGetConstMacro( RadiusHistogramMaximum, double );
+  
+  /** Set/Get the offset of the section used for the direction of a branch. Default is 3. */
+  itkSetClampMacro( BifurcationDirectionOffset, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( BifurcationDirectionOffset, unsigned int );
+  
+  /** Compute all the measurements. */
+  void Compute();
+  
+  /** Per branch results. Nodes that are not branches have zero values. */
+  double GetBranchLength( NodeIndex node ) const
+    { return m_BranchLengths[node]; }
+  double GetBranchVolume( NodeIndex node ) const
+    { return m_BranchVolumes[node]; }
+  double GetBranchMeanRadius( NodeIndex node ) const
+    { return m_BranchMeanRadii[node]; }
+  double GetBranchTortuosity( NodeIndex node ) const
+    { return m_BranchTortuosities[node]; }
+    
+  /** Per bifurcation results in radians. Other nodes have zero values. */
+  double GetBifurcationAngle( NodeIndex node ) const
+    { return m_BifurcationAngles[node]; }
+  
+  /** Whole tree results. */
+  unsigned int GetNumberOfBranches() const
+    { return m_Total.NumberOfBranches; }
+  unsigned int GetNumberOfBifurcations() const
+    { return m_Total.NumberOfBifurcations; }
+  double GetTotalLength() const
+    { return m_Total.Length; }
+  double GetTotalVolume() const
+    { return m_Total.Volume; }
+  double GetMeanTortuosity() const
+    { return m_Total.NumberOfBranches ? m_Total.TortuositySum / m_Total.NumberOfBranches : 0.0; }
+  double GetMaximumTortuosity() const
+    { return m_Total.MaximumTortuosity; }
+  double GetMeanBifurcationAngle() const
+    { return m_Total.NumberOfBifurcations ? m_Total.BifurcationAngleSum / m_Total.NumberOfBifurcations : 0.0; }
+  double GetMaximumBifurcationAngle() const
+    { return m_Total.MaximumBifurcationAngle; }
+  const HistogramType & GetRadiusHistogram() const
+    { return m_Total.RadiusHistogram; }
+		
+protected:
+
+  FrozenVesselGraphQuantifier();
+  ~FrozenVesselGraphQuantifier() {}
+  
+  /** Tree measurements accumulated by every thread. */
+  struct PartialResult
+  {
+    PartialResult() : NumberOfBranches(0), NumberOfBifurcations(0), Length(0.0), Volume(0.0),
+      TortuositySum(0.0), MaximumTortuosity(0.0), BifurcationAngleSum(0.0), 
+      MaximumBifurcationAngle(0.0) {}
+    
+    void Merge( const PartialResult & other );
+    
+    unsigned int    NumberOfBranches;
+    unsigned int    NumberOfBifurcations;
+    double          Length;
+    double          Volume;
+    double          TortuositySum;
+    double          MaximumTortuosity;
+    double          BifurcationAngleSum;
+    double          MaximumBifurcationAngle;
+    HistogramType   RadiusHistogram;
+  };
+  
+  /** Measure a branch or a bifurcation. */
+  void ComputeBranch( NodeIndex node, PartialResult & result );
+  void ComputeBifurcation( NodeIndex node, PartialResult & result );
+  
+  /** Compute the nodes taken from the shared counter until there are no more. */
+  void ThreadedCompute( int threadId );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeThreaderCallback( void *arg );
+  
+  void PrintSelf(std::ostream& os, itk::Indent indent) const;
+
+private:
+
+  FrozenVesselGraphQuantifier(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  FrozenGraphConstPointer         m_FrozenGraph;
+  
+  unsigned int                    m_NumberOfRadiusBins;
+  double                          m_RadiusHistogramMinimum;
+  double                          m_RadiusHistogramMaximum;
+  unsigned int                    m_BifurcationDirectionOffset;
+  
+  itk::MultiThreader::Pointer     m_Threader;
+  int                             m_NumberOfThreads;
+  
+  /** Nodes to compute, and whether every node type is a bifurcation. */
+  std::vector<NodeIndex>          m_Nodes;
+  std::vector<bool>               m_IsBifurcationType;
+  unsigned int                    m_NextNode;
+  itk::SimpleFastMutexLock        m_NodeMutex;
+  
+  /** Per node results. */
+  std::vector<double>             m_BranchLengths;
+  std::vector<double>             m_BranchVolumes;
+  std::vector<double>             m_BranchMeanRadii;
+  std::vector<double>             m_BranchTortuosities;
+  std::vector<double>             m_BifurcationAngles;
+  
+  /** Partial results of every thread, and their merge. */
+  std::vector<PartialResult>      m_PartialResults;
+  PartialResult                   m_Total;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanFrozenVesselGraphQuantifier.hxx"
+#endif
+
+#endif
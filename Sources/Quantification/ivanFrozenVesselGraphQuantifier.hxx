@@ -0,0 +1,312 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphQuantifier.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: Per branch and whole tree measurements of a frozen graph in one parallel pass.
+// Date: 2012/11/05
+
+#ifndef __ivanFrozenVesselGraphQuantifier_hxx
+#define __ivanFrozenVesselGraphQuantifier_hxx
+
+#include "ivanFrozenVesselGraphQuantifier.h"
+#include "ivanVesselBifurcationNode.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TCenterline>
+FrozenVesselGraphQuantifier<TCenterline>::FrozenVesselGraphQuantifier() :
+  m_NumberOfRadiusBins( 20 ),
+  m_RadiusHistogramMinimum( 0.0 ),
+  m_RadiusHistogramMaximum( 10.0 ),
+  m_BifurcationDirectionOffset( 3 ),
+  m_NextNode( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+  
+  m_Total.RadiusHistogram.assign( m_NumberOfRadiusBins, 0 );
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::PartialResult::Merge( const PartialResult & other )
+{
+  NumberOfBranches += other.NumberOfBranches;
+  NumberOfBifurcations += other.NumberOfBifurcations;
+  Length += other.Length;
+  Volume += other.Volume;
+  TortuositySum += other.TortuositySum;
+  MaximumTortuosity = vnl_math_max( MaximumTortuosity, other.MaximumTortuosity );
+  BifurcationAngleSum += other.BifurcationAngleSum;
+  MaximumBifurcationAngle = vnl_math_max( MaximumBifurcationAngle, other.MaximumBifurcationAngle );
+  
+  for( unsigned int b=0; b<RadiusHistogram.size(); ++b )
+    RadiusHistogram[b] += other.RadiusHistogram[b];
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::Compute()
+{
+  if( m_FrozenGraph.IsNull() )
+    itkExceptionMacro( "Frozen graph not set." );
+    
+  if( m_RadiusHistogramMaximum <= m_RadiusHistogramMinimum )
+    itkExceptionMacro( "Invalid radius histogram range." );
+  
+  const unsigned int numberOfNodes = m_FrozenGraph->GetNumberOfNodes();
+  
+  m_BranchLengths.assign( numberOfNodes, 0.0 );
+  m_BranchVolumes.assign( numberOfNodes, 0.0 );
+  m_BranchMeanRadii.assign( numberOfNodes, 0.0 );
+  m_BranchTortuosities.assign( numberOfNodes, 0.0 );
+  m_BifurcationAngles.assign( numberOfNodes, 0.0 );
+  
+  // Find out which node types are bifurcations from the prototypes
+  m_IsBifurcationType.clear();
+  m_Nodes.clear();
+  
+  for( NodeIndex n=0; n<numberOfNodes; ++n )
+  {
+    const GraphNode::NodeTypeIdentifier typeId = m_FrozenGraph->GetNodeTypeId( n );
+    
+    if( typeId >= m_IsBifurcationType.size() )
+    {
+      const unsigned int first = m_IsBifurcationType.size();
+      m_IsBifurcationType.resize( typeId + 1, false );
+      
+      for( unsigned int t=first; t<=typeId; ++t )
+        m_IsBifurcationType[t] = 
+          ( dynamic_cast<const VesselBifurcationNode<TCenterline>*>( m_FrozenGraph->GetNodePrototype( t ) ) != 0 );
+    }
+    
+    if( m_FrozenGraph->IsBranch( n ) || m_IsBifurcationType[typeId] )
+      m_Nodes.push_back( n );
+  }
+  
+  const int numberOfThreads = m_Nodes.size() > 1 ? 
+    vnl_math_min( m_NumberOfThreads, (int)m_Nodes.size() ) : 1;
+  
+  m_PartialResults.assign( numberOfThreads, PartialResult() );
+  for( int t=0; t<numberOfThreads; ++t )
+    m_PartialResults[t].RadiusHistogram.assign( m_NumberOfRadiusBins, 0 );
+  
+  m_NextNode = 0;
+  
+  if( numberOfThreads > 1 )
+  {
+    m_Threader->SetNumberOfThreads( numberOfThreads );
+    m_Threader->SetSingleMethod( this->ComputeThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedCompute( 0 );
+  }
+  
+  // Merge the partial results
+  m_Total = PartialResult();
+  m_Total.RadiusHistogram.assign( m_NumberOfRadiusBins, 0 );
+  
+  for( int t=0; t<numberOfThreads; ++t )
+    m_Total.Merge( m_PartialResults[t] );
+    
+  m_PartialResults.clear();
+  m_Nodes.clear();
+}
+
+
+template <class TCenterline>
+ITK_THREAD_RETURN_TYPE
+FrozenVesselGraphQuantifier<TCenterline>::ComputeThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+  Self *quantifier = (Self *)(info->UserData);
+  
+  quantifier->ThreadedCompute( info->ThreadID );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::ThreadedCompute( int threadId )
+{
+  PartialResult & result = m_PartialResults[threadId];
+  NodeIndex node;
+  bool found;
+  
+  while( true )
+  {
+    m_NodeMutex.Lock();
+    found = ( m_NextNode < m_Nodes.size() );
+    if( found )
+      node = m_Nodes[ m_NextNode++ ];
+    m_NodeMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    if( m_FrozenGraph->IsBranch( node ) )
+      this->ComputeBranch( node, result );
+    else
+      this->ComputeBifurcation( node, result );
+  }
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::ComputeBranch( NodeIndex node, PartialResult & result )
+{
+  const unsigned int size = m_FrozenGraph->GetNumberOfSections( node );
+  
+  if( !size )
+    return;
+    
+  const double binWidth = ( m_RadiusHistogramMaximum - m_RadiusHistogramMinimum ) / m_NumberOfRadiusBins;
+  
+  double length = 0.0;
+  double volume = 0.0;
+  double radiusSum = 0.0;
+  double previousRadius = 0.0;
+  
+  for( unsigned int i=0; i<size; ++i )
+  {
+    const double radius = m_FrozenGraph->GetSection( node, i )->GetRadius();
+    
+    if( i > 0 )
+    {
+      const double height = m_FrozenGraph->GetSectionCenter( node, i ).
+        EuclideanDistanceTo( m_FrozenGraph->GetSectionCenter( node, i - 1 ) );
+      
+      length += height;
+      volume += vnl_math::pi * height * 
+        ( previousRadius * previousRadius + previousRadius * radius + radius * radius ) / 3.0;
+    }
+    
+    radiusSum += radius;
+    previousRadius = radius;
+    
+    int bin = (int)std::floor( ( radius - m_RadiusHistogramMinimum ) / binWidth );
+    bin = vnl_math_max( 0, vnl_math_min( bin, (int)m_NumberOfRadiusBins - 1 ) );
+    ++result.RadiusHistogram[bin];
+  }
+  
+  const double chord = m_FrozenGraph->GetSectionCenter( node, 0 ).
+    EuclideanDistanceTo( m_FrozenGraph->GetSectionCenter( node, size - 1 ) );
+  const double tortuosity = ( chord > 0.0 ) ? length / chord : 0.0;
+  
+  m_BranchLengths[node] = length;
+  m_BranchVolumes[node] = volume;
+  m_BranchMeanRadii[node] = radiusSum / size;
+  m_BranchTortuosities[node] = tortuosity;
+  
+  ++result.NumberOfBranches;
+  result.Length += length;
+  result.Volume += volume;
+  result.TortuositySum += tortuosity;
+  result.MaximumTortuosity = vnl_math_max( result.MaximumTortuosity, tortuosity );
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::ComputeBifurcation( NodeIndex node, PartialResult & result )
+{
+  typedef typename FrozenGraphType::CenterPointType   CenterPointType;
+  typedef typename CenterPointType::VectorType        DirectionType;
+  
+  // Initial directions of the child branches
+  std::vector<DirectionType> directions;
+  
+  for( unsigned int c=0; c<m_FrozenGraph->GetNumberOfChildren( node ); ++c )
+  {
+    const NodeIndex child = m_FrozenGraph->GetChild( node, c );
+    const unsigned int size = m_FrozenGraph->GetNumberOfSections( child );
+    
+    if( !m_FrozenGraph->IsBranch( child ) || size < 2 )
+      continue;
+      
+    const unsigned int pos = vnl_math_min( m_BifurcationDirectionOffset, size - 1 );
+    
+    DirectionType direction = 
+      m_FrozenGraph->GetSectionCenter( child, pos ) - m_FrozenGraph->GetSectionCenter( child, 0 );
+    
+    const double norm = direction.GetNorm();
+    if( norm > 0.0 )
+      directions.push_back( direction / norm );
+  }
+  
+  if( directions.size() < 2 )
+    return;
+  
+  double angle = 0.0;
+  
+  for( unsigned int i=0; i<directions.size(); ++i )
+  {
+    for( unsigned int j=i+1; j<directions.size(); ++j )
+    {
+      const double cosine = vnl_math_max( -1.0, vnl_math_min( 1.0, directions[i] * directions[j] ) );
+      angle = vnl_math_max( angle, std::acos( cosine ) );
+    }
+  }
+  
+  m_BifurcationAngles[node] = angle;
+  
+  ++result.NumberOfBifurcations;
+  result.BifurcationAngleSum += angle;
+  result.MaximumBifurcationAngle = vnl_math_max( result.MaximumBifurcationAngle, angle );
+}
+
+
+template <class TCenterline>
+void FrozenVesselGraphQuantifier<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "FrozenGraph: " << m_FrozenGraph.GetPointer() << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfRadiusBins: " << m_NumberOfRadiusBins << std::endl;
+  os << indent << "RadiusHistogramMinimum: " << m_RadiusHistogramMinimum << std::endl;
+  os << indent << "RadiusHistogramMaximum: " << m_RadiusHistogramMaximum << std::endl;
+  os << indent << "BifurcationDirectionOffset: " << m_BifurcationDirectionOffset << std::endl;
+  os << indent << "NumberOfBranches: " << this->GetNumberOfBranches() << std::endl;
+  os << indent << "NumberOfBifurcations: " << this->GetNumberOfBifurcations() << std::endl;
+  os << indent << "TotalLength: " << this->GetTotalLength() << std::endl;
+  os << indent << "TotalVolume: " << this->GetTotalVolume() << std::endl;
+  os << indent << "MeanTortuosity: " << this->GetMeanTortuosity() << std::endl;
+  os << indent << "MaximumTortuosity: " << this->GetMaximumTortuosity() << std::endl;
+  os << indent << "MeanBifurcationAngle: " << this->GetMeanBifurcationAngle() << std::endl;
+  os << indent << "MaximumBifurcationAngle: " << this->GetMaximumBifurcationAngle() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif // __ivanFrozenVesselGraphQuantifier_hxx
@@ -31,7 +31,9 @@ SUCH DAMAGE.
 #ifndef __ivanLocalCurveMetrics_h
 #define __ivanLocalCurveMetrics_h
 
-#include "ivanVesselSectionStruct.h"
+#include "itkMatrix.h"
+#include "itkVector.h"
+#include "itkIndent.h"
 
 
 namespace ivan
@@ -41,25 +43,22 @@ namespace ivan
  *  \brief Standard local metrics for the centerline curve at every point.
  *
  * This struct-like class is intended to be used as template parameter for
- * the vessel section.
+ * the vessel section. It stores the Frenet frame, curvature and torsion of the 
+ * centerline at the section, as computed by LocalCurveMetricsCalculator.
  *
  * \ingroup 
  */
 
 template <unsigned int VDimension>
-class ITK_EXPORT LocalCurveMetrics : public VesselSectionStruct
+class ITK_EXPORT LocalCurveMetrics
 {
 public:
 
   typedef LocalCurveMetrics    Self;
-  typedef VesselSectionStruct  Superclass;
   
   typedef itk::Matrix<double, VDimension, VDimension>  MatrixType;
   typedef itk::Vector<double, VDimension>              VectorType;
   
-  typedef vnl_matrix_fixed<double, VDimension, VDimension>  VnlMatrixType;
-  typedef vnl_vector_fixed<double, VDimension>              VnlVectorType;
-  
 public:
   
   /** This object is exceptionally created on the stack. */
@@ -73,9 +72,11 @@ public:
   Self & operator = ( const Self & other );
     
   void SetReferenceFrame( const MatrixType & rf )
-    { m_ReferenceFrame = rf );
-  itkGetMacro( ReferenceFrame, MatrixType & );
-  itkGetConstMacro( ReferenceFrame, MatrixType & );
+    { m_ReferenceFrame = rf; }
+  MatrixType & GetReferenceFrame()
+    { return m_ReferenceFrame; }
+  const MatrixType & GetReferenceFrame() const
+    { return m_ReferenceFrame; }
   
   /** Set/Get the tangent to the curve. This IS the section normal!!!! */
   void SetTangent( const VectorType & tangent );  
@@ -92,11 +93,27 @@ public:
     * after setting the tangent and normal vectors. */
   VectorType GetBinormal() const;
   
-  itkSetMacro( Curvature, double );
-  itkGetConstMacro( Curvature, double );
+  void SetCurvature( double curvature )
+    { m_Curvature = curvature; }
+  double GetCurvature() const
+    { return m_Curvature; }
+    
+  void SetTorsion( double torsion )
+    { m_Torsion = torsion; }
+  double GetTorsion() const
+    { return m_Torsion; }
     
-  itkSetMacro( Torsion, double );
-  itkGetConstMacro( Torsion, double );
+  /** Interpolate linearly struct properties between two sections, given their absolute 
+    * position along the curve (by arc-length) and the position of the current section. 
+    * The reference frame is taken from the nearest section. */
+  friend void InterpolateSection( const Self & struct1, 
+    const Self & struct2, double pos1, double pos2, double pos, Self & result )
+    {
+      const double t = ( pos2 != pos1 ) ? ( pos - pos1 ) / ( pos2 - pos1 ) : 0.0;
+      result.m_Curvature = ( 1.0 - t ) * struct1.m_Curvature + t * struct2.m_Curvature;
+      result.m_Torsion = ( 1.0 - t ) * struct1.m_Torsion + t * struct2.m_Torsion;
+      result.m_ReferenceFrame = ( t < 0.5 ) ? struct1.m_ReferenceFrame : struct2.m_ReferenceFrame;
+    }
     
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
   
@@ -116,7 +133,7 @@ private:
 } // end namespace ivan
 
 #if ITK_TEMPLATE_TXX
-# include "itkLocalCurveMetrics.hxx"
+# include "ivanLocalCurveMetrics.hxx"
 #endif
 
 #endif
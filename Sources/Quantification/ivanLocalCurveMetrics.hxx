@@ -56,9 +56,9 @@ LocalCurveMetrics<VDimension>::~LocalCurveMetrics()
 template <unsigned int VDimension>
 LocalCurveMetrics<VDimension>::LocalCurveMetrics( const Self & other )
 {
-  this->m_ReferenceFrame = other->GetReferenceFrame();
-  this->m_Curvature      = other->GetCurvature();
-  this->m_Torsion        = other->GetTorsion();
+  this->m_ReferenceFrame = other.GetReferenceFrame();
+  this->m_Curvature      = other.GetCurvature();
+  this->m_Torsion        = other.GetTorsion();
 }
 
 
@@ -66,14 +66,15 @@ template <unsigned int VDimension>
 LocalCurveMetrics<VDimension> & 
 LocalCurveMetrics<VDimension>::operator =( const Self & other )
 {
-  this->m_ReferenceFrame = other->GetReferenceFrame();
-  this->m_Curvature      = other->GetCurvature();
-  this->m_Torsion        = other->GetTorsion();
+  this->m_ReferenceFrame = other.GetReferenceFrame();
+  this->m_Curvature      = other.GetCurvature();
+  this->m_Torsion        = other.GetTorsion();
   
   return (*this);
 }
 
 
+template <unsigned int VDimension>
 void LocalCurveMetrics<VDimension>::SetTangent( const VectorType & tangent )
 { 
   for( unsigned int i=0; i<VDimension; ++i )
@@ -81,7 +82,8 @@ void LocalCurveMetrics<VDimension>::SetTangent( const VectorType & tangent )
 }
 
 
-LocalCurveMetrics<VDimension>::VectorType 
+template <unsigned int VDimension>
+typename LocalCurveMetrics<VDimension>::VectorType 
 LocalCurveMetrics<VDimension>::GetTangent() const
 {
   VectorType tangent;
@@ -92,14 +94,16 @@ LocalCurveMetrics<VDimension>::GetTangent() const
 }
 
 
+template <unsigned int VDimension>
 void LocalCurveMetrics<VDimension>::SetNormal( const VectorType & normal )
 { 
   for( unsigned int i=0; i<VDimension; ++i )
-    this->m_ReferenceFrame[i][0] = tangent[i];
+    this->m_ReferenceFrame[i][1] = normal[i];
 }
 
 
-LocalCurveMetrics<VDimension>::VectorType
+template <unsigned int VDimension>
+typename LocalCurveMetrics<VDimension>::VectorType
 LocalCurveMetrics<VDimension>::GetNormal() const
 {
   VectorType normal;
@@ -110,26 +114,34 @@ LocalCurveMetrics<VDimension>::GetNormal() const
 }
   
 
+template <unsigned int VDimension>
 void LocalCurveMetrics<VDimension>::CalculateBinormal()
 {
-  if( VDimension < 3 )
+  if( VDimension != 3 )
     return;
   
   // Calculate cross-product of first two columns and store in third
-  this->m_ReferenceFrame.GetVnlMatrix().set_column( 2, 
-    vnl_cross_3d( 
-      this->m_ReferenceFrame.GetVnlMatrix().get_column(0),
-      this->m_ReferenceFrame.GetVnlMatrix().get_column(1),      
-    )
-  );
+  for( unsigned int i=0; i<3; ++i )
+  {
+    const unsigned int j = ( i + 1 ) % 3;
+    const unsigned int k = ( i + 2 ) % 3;
+    
+    this->m_ReferenceFrame[i][2] = this->m_ReferenceFrame[j][0] * this->m_ReferenceFrame[k][1] - 
+      this->m_ReferenceFrame[k][0] * this->m_ReferenceFrame[j][1];
+  }
 }
 
 
-LocalCurveMetrics<VDimension>::VectorType
+template <unsigned int VDimension>
+typename LocalCurveMetrics<VDimension>::VectorType
 LocalCurveMetrics<VDimension>::GetBinormal() const
 {
-  assert( VDimension >= 3 );
   VectorType binormal;
+  binormal.Fill( 0.0 );
+  
+  if( VDimension < 3 )
+    return binormal;
+    
   for( unsigned int i=0; i<VDimension; ++i )
     binormal[i] = m_ReferenceFrame[i][2];
   
@@ -140,8 +152,6 @@ LocalCurveMetrics<VDimension>::GetBinormal() const
 template <unsigned int VDimension>
 void LocalCurveMetrics<VDimension>::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
-  Superclass::PrintSelf( os, indent );
-  
   os << indent << "ReferenceFrame: " << m_ReferenceFrame << std::endl;
   os << indent << "Curvature: " << m_Curvature << std::endl;
   os << indent << "Torsion: " << m_Torsion << std::endl;  
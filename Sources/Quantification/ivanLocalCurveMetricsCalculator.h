@@ -35,8 +35,6 @@ SUCH DAMAGE.
 #include "ivanVesselCenterlineMetricsCalculator.h"
 #include "ivanLocalCurveMetrics.h"
 
-#include "itkConceptChecking.h"
-
 
 namespace ivan
 {
@@ -45,7 +43,19 @@ namespace ivan
 /** \class LocalCurveMetricsCalculator
  *  \brief Calculates curve metrics of type LocalCurveMetrics.
  *
- * For this class to work, Section
+ * For this class to work, the CurveMetricsType of the centerline sections must be 
+ * LocalCurveMetrics<Dimension>. 
+ *
+ * The derivatives of the curve at every section are estimated by fitting a local 
+ * polynomial (up to cubic) by least squares to a window of 2*StencilRadius+1 centers, 
+ * parameterized by the chord length relative to the section. The window is shifted 
+ * at both ends of the centerline so it always has the same number of points.
+ *
+ * Since every section only depends on the centers inside its window, the metrics can 
+ * be updated incrementally. ComputeModified() recomputes only the sections appended 
+ * since the last computation and those whose window reaches a range marked with 
+ * VesselCenterline::MarkModifiedSections(), which is then cleared. Compute() 
+ * recomputes the whole centerline.
  * 
  * \ingroup
  *
@@ -57,23 +67,22 @@ class ITK_EXPORT LocalCurveMetricsCalculator : public VesselCenterlineMetricsCal
 public:
 
   /** Standard class typedefs. */
-  typedef LocalCurveMetricsCalculator            Self;
-  typedef VesselCenterlineMetricsCalculator      Superclass;
-  typedef itk::SmartPointer<Self>                Pointer;
-  typedef itk::SmartPointer<const Self>          ConstPointer;
+  typedef LocalCurveMetricsCalculator                    Self;
+  typedef VesselCenterlineMetricsCalculator<TCenterline> Superclass;
+  typedef itk::SmartPointer<Self>                        Pointer;
+  typedef itk::SmartPointer<const Self>                  ConstPointer;
  
   typedef typename Superclass::CenterlineType    CenterlineType;
-  typedef typename Superclass::Pointer           CenterlinePointer;
+  typedef typename Superclass::CenterlinePointer CenterlinePointer;
   
   typedef typename Superclass::SectionType       SectionType;
   typedef typename Superclass::SectionPointer    SectionPointer;
-    
-#ifdef ITK_USE_CONCEPT_CHECKING
-  /** Begin concept checking */
-  itkConceptMacro( CurveMetricsTypeCheck,
-      ( Concept::SameType<typename SectionType::CurveMetricsType, LocalCurveMetrics> ) );
-  /** End concept checking */
-#endif
+  
+  typedef typename SectionType::CurveMetricsType CurveMetricsType;
+  typedef typename SectionType::PointType        PointType;
+  typedef typename CurveMetricsType::VectorType  VectorType;
+  
+  itkStaticConstMacro( Dimension, unsigned int, SectionType::Dimension );
     
 public:
 
@@ -83,13 +92,37 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( LocalCurveMetricsCalculator, VesselCenterlineMetricsCalculator );
   
-  /** Compute calculations on current branch. */
+  /** Set the centerline. The next ComputeModified() will compute all its sections. */
+  virtual void SetCenterline( CenterlineType * centerline );
+  
+  /** Set/Get the number of neighbours at each side of a section used to estimate 
+    * the derivatives. Changing it requires calling Compute() again. */
+  itkSetClampMacro( StencilRadius, unsigned int, 2, 16 );
+  itkGetConstMacro( StencilRadius, unsigned int );
+  
+  /** Compute calculations on all the sections of the current centerline. */
 	virtual void Compute();
+	
+	/** Compute calculations only on the sections affected by the sections appended 
+	  * or marked as modified in the centerline since the last computation. */
+	virtual void ComputeModified();
+	
+	/** Compute calculations on the sections in [first,last). */
+	virtual void ComputeRange( unsigned int first, unsigned int last );
+	
+	/** Number of sections of the centerline already computed. */
+	itkGetConstMacro( NumberOfComputedSections, unsigned int );
+	
+	/** Number of sections evaluated by the last computation. Mostly useful for testing. */
+	itkGetConstMacro( NumberOfEvaluatedSections, unsigned int );
 			
 protected:
 
-  LocalCurveMetricsCalculator() : m_VesselBranch(0) {};
-  ~LocalCurveMetricsCalculator() {};
+  LocalCurveMetricsCalculator();
+  ~LocalCurveMetricsCalculator();
+  
+  /** Compute the metrics of a single section. */
+  void ComputeSection( unsigned int index );
   
   void PrintSelf(std::ostream& os, itk::Indent indent) const;
 
@@ -100,6 +133,11 @@ private:
 
 protected:
 
+  unsigned int  m_StencilRadius;
+  
+  unsigned int  m_NumberOfComputedSections;
+  
+  unsigned int  m_NumberOfEvaluatedSections;
 };
 
 } // end namespace ivan
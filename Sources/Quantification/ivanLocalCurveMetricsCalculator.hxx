@@ -27,47 +27,267 @@ SUCH DAMAGE.
 // Description: 
 // Date: 2009/02/06
 
+
 #ifndef __ivanLocalCurveMetricsCalculator_hxx
 #define __ivanLocalCurveMetricsCalculator_hxx
 
 #include "ivanLocalCurveMetricsCalculator.h"
 
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+#include "vnl/algo/vnl_svd.h"
+
+#include <algorithm>
+#include <cmath>
+
 
 namespace ivan
 {
 
-template <class TSection>
-LocalCurveMetricsCalculator<TSection>::LocalCurveMetricsCalculator()
+template <class TCenterline>
+LocalCurveMetricsCalculator<TCenterline>::LocalCurveMetricsCalculator() :
+  m_StencilRadius(2),
+  m_NumberOfComputedSections(0),
+  m_NumberOfEvaluatedSections(0)
 {
 
 }
 
 
-template <class TSection>
-LocalCurveMetricsCalculator<TSection>::~LocalCurveMetricsCalculator()
+template <class TCenterline>
+LocalCurveMetricsCalculator<TCenterline>::~LocalCurveMetricsCalculator()
 {
 
 }
 
 
-template <class TSection>
-void LocalCurveMetricsCalculator<TSection>::operator()
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::SetCenterline( CenterlineType * centerline )
+{
+  Superclass::SetCenterline( centerline );
+  m_NumberOfComputedSections = 0;
+  m_NumberOfEvaluatedSections = 0;
+}
+
+
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::Compute()
 {
-  if( this->m_Centerline->IsNull() )
+  if( this->m_Centerline.IsNull() )
   {
     itkWarningMacro( "Cannot compute metrics. Please, set centerline first." );
     return; 
   }
   
-  CurveMetricsType & metrics = 
+  m_NumberOfEvaluatedSections = 0;
+  this->ComputeRange( 0, this->m_Centerline->size() );
+  this->m_Centerline->ClearModifiedSections();
+  m_NumberOfComputedSections = this->m_Centerline->size();
 }
 
 
-template <class TSection>
-void LocalCurveMetricsCalculator<TSection>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::ComputeModified()
 {
-  Superclass::PrintSelf( os, indent );
+  if( this->m_Centerline.IsNull() )
+  {
+    itkWarningMacro( "Cannot compute metrics. Please, set centerline first." );
+    return; 
+  }
+  
+  const unsigned int size = this->m_Centerline->size();
+  
+  // Sections may have been removed, start over
+  if( m_NumberOfComputedSections > size )
+  {
+    this->Compute();
+    return;
+  }
+  
+  // A section depends on the centers in [i-2r,i+2r] in the worst case, because windows
+  // are shifted at the ends of the centerline
+  const unsigned int reach = 2 * m_StencilRadius;
+  
+  unsigned int first = size;
+  unsigned int last = size;
+  
+  if( m_NumberOfComputedSections < size )
+  {
+    first = ( m_NumberOfComputedSections > reach ) ? m_NumberOfComputedSections - reach : 0;
+    last = size;
+  }
+  
+  if( this->m_Centerline->HasModifiedSections() )
+  {
+    const unsigned int modifiedBegin = this->m_Centerline->GetModifiedSectionsBegin();
+    const unsigned int modifiedEnd = this->m_Centerline->GetModifiedSectionsEnd();
+    
+    const unsigned int begin = ( modifiedBegin > reach ) ? modifiedBegin - reach : 0;
+    const unsigned int end = std::min( modifiedEnd + reach, size );
+    
+    if( first == last )
+    {
+      first = begin;
+      last = end;
+    }
+    else
+    {
+      // Both ranges are merged, the computed sections in between are few at most
+      first = std::min( first, begin );
+      last = std::max( last, end );
+    }
+  }
+  
+  m_NumberOfEvaluatedSections = 0;
+  this->ComputeRange( first, last );
+  this->m_Centerline->ClearModifiedSections();
+  m_NumberOfComputedSections = size;
+}
+
 
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::ComputeRange( unsigned int first, unsigned int last )
+{
+  if( this->m_Centerline.IsNull() )
+  {
+    itkWarningMacro( "Cannot compute metrics. Please, set centerline first." );
+    return; 
+  }
+  
+  last = std::min( last, (unsigned int)this->m_Centerline->size() );
+  
+  for( unsigned int i=first; i<last; ++i )
+    this->ComputeSection( i );
+  
+  if( last > first )
+    m_NumberOfEvaluatedSections += last - first;
+}
+
+
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::ComputeSection( unsigned int index )
+{
+  const unsigned int size = this->m_Centerline->size();
+  
+  CurveMetricsType & metrics = this->m_Centerline->at( index )->GetCurveMetrics();
+  
+  if( size < 3 )
+  {
+    metrics.SetCurvature( 0.0 );
+    metrics.SetTorsion( 0.0 );
+    return;
+  }
+  
+  // Window of 2r+1 points centered at the section, shifted at the ends
+  const unsigned int windowSize = std::min( 2 * m_StencilRadius + 1, size );
+  
+  unsigned int windowBegin = ( index > m_StencilRadius ) ? index - m_StencilRadius : 0;
+  if( windowBegin + windowSize > size )
+    windowBegin = size - windowSize;
+    
+  const unsigned int offset = index - windowBegin;
+  
+  // Parameterize the window by chord length, relative to the section
+  vnl_vector<double> parameters( windowSize, 0.0 );
+  
+  for( unsigned int j=offset+1; j<windowSize; ++j )
+    parameters[j] = parameters[j-1] + this->m_Centerline->at( windowBegin + j )->GetCenter().
+      EuclideanDistanceTo( this->m_Centerline->at( windowBegin + j - 1 )->GetCenter() );
+  
+  for( int j=int(offset)-1; j>=0; --j )
+    parameters[j] = parameters[j+1] - this->m_Centerline->at( windowBegin + j )->GetCenter().
+      EuclideanDistanceTo( this->m_Centerline->at( windowBegin + j + 1 )->GetCenter() );
+    
+  // Local polynomial fit of degree up to 3
+  const unsigned int degree = std::min( 3u, windowSize - 1 );
+  
+  vnl_matrix<double> design( windowSize, degree + 1 );
+  vnl_matrix<double> values( windowSize, Dimension );
+  
+  for( unsigned int j=0; j<windowSize; ++j )
+  {
+    double power = 1.0;
+    for( unsigned int k=0; k<=degree; ++k )
+    {
+      design( j, k ) = power;
+      power *= parameters[j];
+    }
+    
+    const PointType & center = this->m_Centerline->at( windowBegin + j )->GetCenter();
+    for( unsigned int d=0; d<Dimension; ++d )
+      values( j, d ) = center[d];
+  }
+  
+  vnl_svd<double> svd( design );
+  vnl_matrix<double> coefficients = svd.solve( values );
+  
+  // Derivatives at the section, where the parameter is zero
+  VectorType d1, d2, d3;
+  d3.Fill( 0.0 );
+  
+  for( unsigned int d=0; d<Dimension; ++d )
+  {
+    d1[d] = coefficients( 1, d );
+    d2[d] = 2.0 * coefficients( 2, d );
+    if( degree > 2 )
+      d3[d] = 6.0 * coefficients( 3, d );
+  }
+  
+  const double d1SquaredNorm = d1.GetSquaredNorm();
+  const double d1Norm = std::sqrt( d1SquaredNorm );
+  
+  if( d1Norm <= 0.0 )
+  {
+    metrics.SetCurvature( 0.0 );
+    metrics.SetTorsion( 0.0 );
+    return;
+  }
+  
+  const double dot12 = d1 * d2;
+  const double crossSquaredNorm = 
+    std::max( 0.0, d1SquaredNorm * d2.GetSquaredNorm() - dot12 * dot12 );
+  
+  metrics.SetCurvature( std::sqrt( crossSquaredNorm ) / ( d1SquaredNorm * d1Norm ) );
+  
+  // Frenet frame
+  VectorType tangent = d1 / d1Norm;
+  VectorType normal = d2 - tangent * ( d2 * tangent );
+  
+  const double normalNorm = normal.GetNorm();
+  if( normalNorm > 0.0 )
+    normal /= normalNorm;
+  else
+    normal.Fill( 0.0 );
+  
+  metrics.SetTangent( tangent );
+  metrics.SetNormal( normal );
+  metrics.CalculateBinormal();
+  
+  // Torsion only makes sense in 3D
+  double torsion = 0.0;
+  
+  if( Dimension == 3 && crossSquaredNorm > 0.0 )
+  {
+    const double determinant = 
+      d1[0] * ( d2[1] * d3[2] - d2[2] * d3[1] ) -
+      d1[1] * ( d2[0] * d3[2] - d2[2] * d3[0] ) +
+      d1[2] * ( d2[0] * d3[1] - d2[1] * d3[0] );
+    
+    torsion = determinant / crossSquaredNorm;
+  }
+  
+  metrics.SetTorsion( torsion );
+}
+
+
+template <class TCenterline>
+void LocalCurveMetricsCalculator<TCenterline>::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "StencilRadius: " << m_StencilRadius << std::endl;
+  os << indent << "NumberOfComputedSections: " << m_NumberOfComputedSections << std::endl;
+  os << indent << "NumberOfEvaluatedSections: " << m_NumberOfEvaluatedSections << std::endl;
 }
 
 } // end namespace ivan
@@ -0,0 +1,234 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRayCastingRadialContourEstimator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: estimates the lumen contour of every section of a centerline by casting rays.
+// Date: 2012/11/05
+
+#ifndef __ivanRayCastingRadialContourEstimator_h
+#define __ivanRayCastingRadialContourEstimator_h
+
+#include "ivanUniformRadialContour.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkVector.h"
+
+#include <vector>
+
+
+namespace ivan
+{
+  
+/** \class RayCastingRadialContourEstimator
+ *  \brief Estimates the lumen contour of every section of a centerline by casting rays.
+ *
+ * For every section, NumberOfRays rays equally spaced in angle are cast in the plane of the 
+ * section from its center, up to MaximumRadius, and the image is sampled every StepLength 
+ * along them. The distance to the lumen boundary along each ray is stored in a 
+ * UniformRadialContour, whose first element is along the first in-plane axis. The in-plane axes 
+ * are propagated from section to section by parallel transport, so the contours of consecutive 
+ * sections are aligned.
+ *
+ * With HalfMaximumEdge the boundary is where the profile first falls below the mean of its 
+ * value at the center and its minimum, interpolated between samples. With MaximumGradientEdge 
+ * it is the position of the steepest descent of the profile, refined with a parabola. Rays 
+ * that find no boundary before MaximumRadius or the end of the image take their last sample.
+ *
+ * All the rays of a section are traced together. Ray origins and steps are kept in 
+ * continuous index space as arrays per dimension (structure of arrays), so the positions of 
+ * all the rays at a step are computed by one loop that the compiler vectorizes, as in 
+ * CircleSampler, and the samples of a step are interpolated linearly from the image buffer in
+ * another loop over the rays. Sections are distributed among threads from a shared counter.
+ *
+ * The section type must provide the accessors of CircularVesselSection.
+ *
+ * \sa CircleSampler
+ * \ingroup 
+ */
+
+template <class TImage, class TCenterline>
+class ITK_EXPORT RayCastingRadialContourEstimator : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef RayCastingRadialContourEstimator    Self;
+  typedef itk::Object                         Superclass;
+  typedef itk::SmartPointer<Self>             Pointer;
+  typedef itk::SmartPointer<const Self>       ConstPointer;
+  
+  typedef TImage                                  ImageType;
+  typedef typename ImageType::ConstPointer        ImageConstPointer;
+  
+  typedef TCenterline                             CenterlineType;
+  typedef typename CenterlineType::ConstPointer   CenterlineConstPointer;
+  typedef typename CenterlineType::SectionType    SectionType;
+  
+  /** Contours store the distance from the center along every ray. */
+  typedef UniformRadialContour<double>            ContourType;
+  typedef typename ContourType::Pointer           ContourPointer;
+  
+  itkStaticConstMacro( ImageDimension, unsigned int, ImageType::ImageDimension );
+  
+  typedef itk::Vector<double,itkGetStaticConstMacro(ImageDimension)>   VectorType;
+  
+  typedef enum { HalfMaximumEdge, MaximumGradientEdge }  EdgeDetectionType;
+  
+public:
+
+	/** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RayCastingRadialContourEstimator, itk::Object );
+  
+  /** Set/Get the image. */
+  itkSetConstObjectMacro( Image, ImageType );
+  itkGetConstObjectMacro( Image, ImageType );
+  
+  /** Set/Get the centerline, for instance that of a VesselBranchNode. */
+  void SetCenterline( const CenterlineType *centerline )
+    { m_Centerline = centerline; this->Modified(); }
+  const CenterlineType * GetCenterline() const
+    { return m_Centerline; }
+  
+  /** Set/Get the number of rays per section. Default is 32. */
+  itkSetClampMacro( NumberOfRays, unsigned int, 1, itk::NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfRays, unsigned int );
+  
+  /** Set/Get the length of the rays. Default is 10. */
+  itkSetMacro( MaximumRadius, double );
+  itkGetConstMacro( MaximumRadius, double );
+  
+  /** Set/Get the distance between samples along the rays. Zero, the default, uses half the 
+    * smallest spacing of the image. */
+  itkSetMacro( StepLength, double );
+  itkGetConstMacro( StepLength, double );
+  
+  /** Set/Get the edge detection criterion. Default is HalfMaximumEdge. */
+  itkSetMacro( EdgeDetection, EdgeDetectionType );
+  itkGetConstMacro( EdgeDetection, EdgeDetectionType );
+  
+  /** Set/Get the number of threads. Default is the global default of the MultiThreader. */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, int );
+  
+  /** Estimate the contours of all the sections. */
+  void Compute();
+  
+  /** Results of the last computation, one per section. */
+  unsigned int GetNumberOfContours() const
+    { return m_Contours.size(); }
+  ContourType * GetContour( unsigned int section ) const
+    { return m_Contours[section]; }
+  
+  /** Mean distance to the boundary of the rays of a section. */
+  double GetMeanRadius( unsigned int section ) const
+    { return m_MeanRadii[section]; }
+		
+protected:
+
+  RayCastingRadialContourEstimator();
+  ~RayCastingRadialContourEstimator() {}
+  
+  /** Scratch arrays of a thread. */
+  struct RayBuffers
+  {
+    std::vector<double>   Steps;      // per dimension and ray, index space
+    std::vector<double>   Positions;  // per dimension and ray, index space
+    std::vector<double>   Profiles;   // per step and ray
+    std::vector<unsigned int>  Lengths;   // per ray, number of samples inside the image
+  };
+  
+  /** Compute the in-plane axes of every section by parallel transport. */
+  void ComputeSectionAxes();
+  
+  /** Cast the rays of a section and store its contour. */
+  void ComputeSection( unsigned int section, RayBuffers & buffers );
+  
+  /** Distance to the boundary along a ray given its profile. */
+  double DetectEdge( const double *profile, unsigned int stride, unsigned int length ) const;
+  
+  /** Linear interpolation of the image buffer at a continuous index inside the buffer. */
+  double EvaluateLinear( const double *cindex ) const;
+  
+  /** Compute the sections taken from the shared counter until there are no more. */
+  void ThreadedCompute( int threadId );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ComputeThreaderCallback( void *arg );
+  
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  RayCastingRadialContourEstimator(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+protected:
+
+  ImageConstPointer             m_Image;
+  CenterlineConstPointer        m_Centerline;
+  
+  unsigned int                  m_NumberOfRays;
+  double                        m_MaximumRadius;
+  double                        m_StepLength;
+  EdgeDetectionType             m_EdgeDetection;
+  
+  itk::MultiThreader::Pointer   m_Threader;
+  int                           m_NumberOfThreads;
+  
+  /** State of the computation. */
+  double                        m_EffectiveStepLength;
+  unsigned int                  m_NumberOfSteps;
+  std::vector<double>           m_Cosines;
+  std::vector<double>           m_Sines;
+  std::vector<VectorType>       m_FirstAxes;
+  std::vector<VectorType>       m_SecondAxes;
+  unsigned int                  m_NextSection;
+  itk::SimpleFastMutexLock      m_SectionMutex;
+  
+  /** Bounds of the buffer in index space and strides of its pixels. */
+  long                          m_BufferStart[ImageDimension];
+  long                          m_BufferEnd[ImageDimension];
+  unsigned long                 m_BufferStrides[ImageDimension];
+  
+  /** Results. */
+  std::vector<ContourPointer>   m_Contours;
+  std::vector<double>           m_MeanRadii;
+};
+
+} // end namespace ivan
+
+#if ITK_TEMPLATE_TXX
+# include "ivanRayCastingRadialContourEstimator.hxx"
+#endif
+
+#endif
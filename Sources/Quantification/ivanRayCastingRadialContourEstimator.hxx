@@ -0,0 +1,445 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRayCastingRadialContourEstimator.hxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: estimates the lumen contour of every section of a centerline by casting rays.
+// Date: 2012/11/05
+
+#ifndef __ivanRayCastingRadialContourEstimator_hxx
+#define __ivanRayCastingRadialContourEstimator_hxx
+
+#include "ivanRayCastingRadialContourEstimator.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+
+namespace ivan
+{
+
+template <class TImage, class TCenterline>
+RayCastingRadialContourEstimator<TImage,TCenterline>::RayCastingRadialContourEstimator() :
+  m_NumberOfRays( 32 ),
+  m_MaximumRadius( 10.0 ),
+  m_StepLength( 0.0 ),
+  m_EdgeDetection( HalfMaximumEdge ),
+  m_EffectiveStepLength( 0.0 ),
+  m_NumberOfSteps( 0 ),
+  m_NextSection( 0 )
+{
+  m_Threader = itk::MultiThreader::New();
+  m_NumberOfThreads = m_Threader->GetNumberOfThreads();
+}
+
+
+template <class TImage, class TCenterline>
+void RayCastingRadialContourEstimator<TImage,TCenterline>::Compute()
+{
+  if( m_Image.IsNull() )
+    itkExceptionMacro( "Image not set." );
+  
+  if( m_Centerline.IsNull() )
+    itkExceptionMacro( "Centerline not set." );
+  
+  if( m_MaximumRadius <= 0.0 )
+    itkExceptionMacro( "The maximum radius must be positive." );
+  
+  m_EffectiveStepLength = m_StepLength;
+  
+  if( m_EffectiveStepLength <= 0.0 )
+  {
+    double minSpacing = m_Image->GetSpacing()[0];
+    for( unsigned int d=1; d<ImageDimension; ++d )
+      minSpacing = vnl_math_min( minSpacing, (double)m_Image->GetSpacing()[d] );
+    
+    m_EffectiveStepLength = 0.5 * minSpacing;
+  }
+  
+  m_NumberOfSteps = static_cast<unsigned int>( std::floor( m_MaximumRadius / m_EffectiveStepLength ) ) + 1;
+  
+  m_Cosines.resize( m_NumberOfRays );
+  m_Sines.resize( m_NumberOfRays );
+  
+  for( unsigned int r=0; r<m_NumberOfRays; ++r )
+  {
+    const double angle = 2.0 * vnl_math::pi * r / m_NumberOfRays;
+    m_Cosines[r] = std::cos( angle );
+    m_Sines[r] = std::sin( angle );
+  }
+  
+  const typename ImageType::RegionType & bufferedRegion = m_Image->GetBufferedRegion();
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    m_BufferStart[d] = bufferedRegion.GetIndex()[d];
+    m_BufferEnd[d] = m_BufferStart[d] + static_cast<long>( bufferedRegion.GetSize()[d] ) - 1;
+    m_BufferStrides[d] = m_Image->GetOffsetTable()[d];
+  }
+  
+  this->ComputeSectionAxes();
+  
+  const unsigned int numberOfSections = m_Centerline->size();
+  
+  m_Contours.assign( numberOfSections, ContourPointer() );
+  m_MeanRadii.assign( numberOfSections, 0.0 );
+  
+  const int numberOfThreads = numberOfSections > 1 ? 
+    vnl_math_min( m_NumberOfThreads, (int)numberOfSections ) : 1;
+  
+  m_NextSection = 0;
+  
+  if( numberOfThreads > 1 )
+  {
+    m_Threader->SetNumberOfThreads( numberOfThreads );
+    m_Threader->SetSingleMethod( this->ComputeThreaderCallback, this );
+    m_Threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedCompute( 0 );
+  }
+  
+  m_FirstAxes.clear();
+  m_SecondAxes.clear();
+}
+
+
+template <class TImage, class TCenterline>
+ITK_THREAD_RETURN_TYPE
+RayCastingRadialContourEstimator<TImage,TCenterline>::ComputeThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+  Self *estimator = (Self *)(info->UserData);
+  
+  estimator->ThreadedCompute( info->ThreadID );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TImage, class TCenterline>
+void RayCastingRadialContourEstimator<TImage,TCenterline>::ThreadedCompute( int threadId )
+{
+  RayBuffers buffers;
+  unsigned int section;
+  bool found;
+  
+  while( true )
+  {
+    m_SectionMutex.Lock();
+    found = ( m_NextSection < m_Centerline->size() );
+    if( found )
+      section = m_NextSection++;
+    m_SectionMutex.Unlock();
+    
+    if( !found )
+      break;
+    
+    this->ComputeSection( section, buffers );
+  }
+}
+
+
+template <class TImage, class TCenterline>
+void RayCastingRadialContourEstimator<TImage,TCenterline>::ComputeSectionAxes()
+{
+  const unsigned int numberOfSections = m_Centerline->size();
+  
+  m_FirstAxes.resize( numberOfSections );
+  m_SecondAxes.resize( numberOfSections );
+  
+  VectorType axis0, previousNormal;
+  axis0.Fill( 0.0 );
+  previousNormal.Fill( 0.0 );
+  previousNormal[ImageDimension-1] = 1.0;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    VectorType normal;
+    for( unsigned int d=0; d<ImageDimension; ++d )
+      normal[d] = m_Centerline->at(i)->GetNormal()[d];
+    
+    if( normal.GetNorm() > 0.0 )
+      normal.Normalize();
+    else
+      normal = previousNormal;
+    
+    // Parallel transport of the first axis, starting from the image axis most orthogonal to 
+    // the first normal
+    axis0 = axis0 - normal * ( axis0 * normal );
+    
+    if( axis0.GetNorm() < 1e-6 )
+    {
+      unsigned int smallest = 0;
+      for( unsigned int d=1; d<ImageDimension; ++d )
+      {
+        if( std::fabs( normal[d] ) < std::fabs( normal[smallest] ) )
+          smallest = d;
+      }
+      
+      axis0.Fill( 0.0 );
+      axis0[smallest] = 1.0;
+      axis0 = axis0 - normal * ( axis0 * normal );
+    }
+    
+    axis0.Normalize();
+    
+    m_FirstAxes[i] = axis0;
+    m_SecondAxes[i] = itk::CrossProduct( normal, axis0 );
+    
+    previousNormal = normal;
+  }
+}
+
+
+template <class TImage, class TCenterline>
+void RayCastingRadialContourEstimator<TImage,TCenterline>::ComputeSection( unsigned int section, 
+  RayBuffers & buffers )
+{
+  const unsigned int numberOfRays = m_NumberOfRays;
+  const unsigned int numberOfSteps = m_NumberOfSteps;
+  const double step = m_EffectiveStepLength;
+  
+  // The rays are straight lines in index space too, so only the center and one step along 
+  // each in-plane axis are transformed
+  typename ImageType::PointType center, point0, point1;
+  itk::ContinuousIndex<double,ImageDimension> origin, index0, index1;
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    center[d] = m_Centerline->at( section )->GetCenter()[d];
+    point0[d] = center[d] + step * m_FirstAxes[section][d];
+    point1[d] = center[d] + step * m_SecondAxes[section][d];
+  }
+  
+  m_Image->TransformPhysicalPointToContinuousIndex( center, origin );
+  m_Image->TransformPhysicalPointToContinuousIndex( point0, index0 );
+  m_Image->TransformPhysicalPointToContinuousIndex( point1, index1 );
+  
+  buffers.Steps.resize( ImageDimension * numberOfRays );
+  buffers.Positions.resize( ImageDimension * numberOfRays );
+  buffers.Profiles.resize( numberOfSteps * numberOfRays );
+  buffers.Lengths.assign( numberOfRays, numberOfSteps );
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    const double step0 = index0[d] - origin[d];
+    const double step1 = index1[d] - origin[d];
+    double *steps = &buffers.Steps[ d * numberOfRays ];
+    
+    for( unsigned int r=0; r<numberOfRays; ++r )
+      steps[r] = m_Cosines[r] * step0 + m_Sines[r] * step1;
+  }
+  
+  double cindex[ImageDimension];
+  
+  for( unsigned int s=0; s<numberOfSteps; ++s )
+  {
+    // Positions of all the rays at this step
+    for( unsigned int d=0; d<ImageDimension; ++d )
+    {
+      const double start = origin[d];
+      const double *steps = &buffers.Steps[ d * numberOfRays ];
+      double *positions = &buffers.Positions[ d * numberOfRays ];
+      
+      for( unsigned int r=0; r<numberOfRays; ++r )
+        positions[r] = start + s * steps[r];
+    }
+    
+    double *profile = &buffers.Profiles[ s * numberOfRays ];
+    
+    for( unsigned int r=0; r<numberOfRays; ++r )
+    {
+      profile[r] = 0.0;
+      
+      // The ray already left the image
+      if( buffers.Lengths[r] < numberOfSteps )
+        continue;
+      
+      bool inside = true;
+      
+      for( unsigned int d=0; d<ImageDimension; ++d )
+      {
+        cindex[d] = buffers.Positions[ d * numberOfRays + r ];
+        
+        if( cindex[d] < m_BufferStart[d] || cindex[d] > m_BufferEnd[d] )
+          inside = false;
+      }
+      
+      if( inside )
+        profile[r] = this->EvaluateLinear( cindex );
+      else
+        buffers.Lengths[r] = s;
+    }
+  }
+  
+  ContourPointer contour = ContourType::New();
+  contour->SetContourId( section );
+  contour->SetNumberOfElements( numberOfRays );
+  
+  double radiusSum = 0.0;
+  
+  for( unsigned int r=0; r<numberOfRays; ++r )
+  {
+    const double radius = this->DetectEdge( &buffers.Profiles[r], numberOfRays, buffers.Lengths[r] );
+    
+    contour->SetPoint( r, radius );
+    radiusSum += radius;
+  }
+  
+  m_Contours[section] = contour;
+  m_MeanRadii[section] = radiusSum / numberOfRays;
+}
+
+
+template <class TImage, class TCenterline>
+double RayCastingRadialContourEstimator<TImage,TCenterline>::DetectEdge( const double *profile, 
+  unsigned int stride, unsigned int length ) const
+{
+  const double step = m_EffectiveStepLength;
+  
+  if( length < 2 )
+    return 0.0;
+  
+  if( m_EdgeDetection == HalfMaximumEdge )
+  {
+    double minimum = profile[0];
+    for( unsigned int s=1; s<length; ++s )
+      minimum = vnl_math_min( minimum, profile[ s * stride ] );
+    
+    const double threshold = 0.5 * ( profile[0] + minimum );
+    
+    for( unsigned int s=1; s<length; ++s )
+    {
+      const double previous = profile[ ( s - 1 ) * stride ];
+      const double current = profile[ s * stride ];
+      
+      if( current < threshold )
+        return ( s - 1 + ( previous - threshold ) / ( previous - current ) ) * step;
+    }
+    
+    return ( length - 1 ) * step;
+  }
+  
+  // Steepest descent by central differences
+  double steepest = 0.0;
+  unsigned int edge = 0;
+  
+  for( unsigned int s=1; s+1<length; ++s )
+  {
+    const double gradient = profile[ ( s + 1 ) * stride ] - profile[ ( s - 1 ) * stride ];
+    
+    if( gradient < steepest )
+    {
+      steepest = gradient;
+      edge = s;
+    }
+  }
+  
+  if( !edge )
+    return ( length - 1 ) * step;
+  
+  double offset = 0.0;
+  
+  if( edge >= 2 && edge + 2 < length )
+  {
+    const double previous = profile[ edge * stride ] - profile[ ( edge - 2 ) * stride ];
+    const double next = profile[ ( edge + 2 ) * stride ] - profile[ edge * stride ];
+    const double denominator = previous - 2.0 * steepest + next;
+    
+    if( denominator != 0.0 )
+      offset = vnl_math_max( -0.5, vnl_math_min( 0.5, 0.5 * ( previous - next ) / denominator ) );
+  }
+  
+  return ( edge + offset ) * step;
+}
+
+
+template <class TImage, class TCenterline>
+double RayCastingRadialContourEstimator<TImage,TCenterline>::EvaluateLinear( const double *cindex ) const
+{
+  const typename ImageType::PixelType *buffer = m_Image->GetBufferPointer();
+  
+  unsigned long baseOffset = 0;
+  double fractions[ImageDimension];
+  
+  for( unsigned int d=0; d<ImageDimension; ++d )
+  {
+    long base = static_cast<long>( std::floor( cindex[d] ) );
+    
+    // The last index has no upper neighbour
+    if( base >= m_BufferEnd[d] )
+      base = m_BufferEnd[d];
+    
+    fractions[d] = cindex[d] - base;
+    baseOffset += ( base - m_BufferStart[d] ) * m_BufferStrides[d];
+  }
+  
+  double value = 0.0;
+  
+  for( unsigned int corner=0; corner < ( 1u << ImageDimension ); ++corner )
+  {
+    double weight = 1.0;
+    unsigned long offset = baseOffset;
+    
+    for( unsigned int d=0; d<ImageDimension && weight > 0.0; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        weight *= fractions[d];
+        offset += m_BufferStrides[d];
+      }
+      else
+        weight *= 1.0 - fractions[d];
+    }
+    
+    if( weight > 0.0 )
+      value += weight * buffer[offset];
+  }
+  
+  return value;
+}
+
+
+template <class TImage, class TCenterline>
+void RayCastingRadialContourEstimator<TImage,TCenterline>::PrintSelf( std::ostream& os, 
+  itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  
+  os << indent << "Image: " << m_Image.GetPointer() << std::endl;
+  os << indent << "Centerline: " << m_Centerline.GetPointer() << std::endl;
+  os << indent << "NumberOfRays: " << m_NumberOfRays << std::endl;
+  os << indent << "MaximumRadius: " << m_MaximumRadius << std::endl;
+  os << indent << "StepLength: " << m_StepLength << std::endl;
+  os << indent << "EdgeDetection: " << m_EdgeDetection << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfContours: " << m_Contours.size() << std::endl;
+}
+
+} // end namespace ivan
+
+#endif
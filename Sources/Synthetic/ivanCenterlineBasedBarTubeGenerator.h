@@ -34,10 +34,15 @@ SUCH DAMAGE.
 
 #include "ivanCircularBarTubeGenerator.h"
 
+#include "ivanImageRegionTileScheduler.h"
+
 #include "itkGaussianSpatialFunction.h"
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkVectorContainer.h"
 #include "itkImageFileWriter.h"
+#include "itkMultiThreader.h"
+
+#include "vnl/vnl_math.h"
 
 //#define DISTANCE_TOL_FACTOR 4.0 // this means exp(-16/2) = exp(-8) = 0.000335462628 for the min Gaussian value for this tolerance
 //#define DISTANCE_TOL_FACTOR 3.0 // this means exp(-9/2) = exp(-4.5) = 0.011 for the min Gaussian value for this tolerance
@@ -62,6 +67,9 @@ public:
     
   typedef itk::VectorContainer<unsigned int,PointType>  PointContainerType;
   typedef typename PointContainerType::Pointer          PointContainerPointer;
+  
+  typedef ImageRegionTileScheduler<3>                   TileSchedulerType;
+  typedef typename TileSchedulerType::RegionType        RegionType;
 
 public:
 
@@ -76,6 +84,13 @@ public:
     { return m_Centerline; }
   const PointContainerType * GetCenterline() const 
     { return m_Centerline; }  
+    
+  /** Set/Get the number of threads used to draw the image. Default is the global default 
+    * of the MultiThreader. */
+  void SetNumberOfThreads( int numberOfThreads )
+    { m_NumberOfThreads = vnl_math_max( 1, vnl_math_min( numberOfThreads, ITK_MAX_THREADS ) ); }
+  int GetNumberOfThreads() const
+    { return m_NumberOfThreads; }
 
   virtual ImagePointer Create();
   
@@ -84,28 +99,46 @@ protected:
   /** Create and allocate the image with the appropiate dimensions, spacing... */
   virtual ImagePointer CreateEmptyImage();
   
-  /** Actually draw/fill the image from the centerline, once the image structure is created. */
+  /** Actually draw/fill the image from the centerline, once the image structure is created. 
+    * The image is divided in tiles that the threads take dynamically, since the tube only 
+    * covers part of the image. */
   void DrawFromCenterline( ImagePointer emptyImage );
   
-  unsigned int GetClosestCenterlinePoint( const PointType & point, double & distance );
+  /** Draw the tiles taken from the scheduler until there are no more. */
+  void ThreadedDrawFromCenterline();
+  
+  /** Draw a single tile. */
+  void DrawTile( const RegionType & tile );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DrawThreaderCallback( void *arg );
+  
+  unsigned int GetClosestCenterlinePoint( const PointType & point, double & distance ) const;
 
 protected:
 
   PointContainerPointer   m_Centerline;
+  
+  int                     m_NumberOfThreads;
+  
+  /** Image and tiles being drawn. */
+  ImageType                           *m_DrawImage;
+  typename TileSchedulerType::Pointer  m_TileScheduler;
 };
 
 
 template <class TPixel>
-CenterlineBasedBarTubeGenerator<TPixel>::CenterlineBasedBarTubeGenerator()
+CenterlineBasedBarTubeGenerator<TPixel>::CenterlineBasedBarTubeGenerator() :
+  m_DrawImage( 0 )
 {
- 
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 
 template <class TPixel>
 unsigned int 
 CenterlineBasedBarTubeGenerator<TPixel>
-::GetClosestCenterlinePoint( const PointType & point, double & distance )
+::GetClosestCenterlinePoint( const PointType & point, double & distance ) const
 {
   double sqrDist = itk::NumericTraits<double>::max();
   double current;
@@ -174,73 +207,78 @@ template <class TPixel>
 void
 CenterlineBasedBarTubeGenerator<TPixel>::DrawFromCenterline( ImagePointer emptyImage )
 {
-  // typedef itk::GaussianSpatialFunction<double, 1>   GaussianFunctionType;
-  // typedef typename GaussianFunctionType::InputType  GaussianFunctionPositionType;
-  // typename GaussianFunctionType::Pointer gaussian = GaussianFunctionType::New();
-   
-  // GaussianFunctionType::ArrayType sigma;
-  // sigma.Fill( this->m_Sigma );
-
-  // GaussianFunctionType::ArrayType mean;
-  // mean.Fill( 0.0 );
-   
-  // gaussian->SetSigma( sigma );
-  // gaussian->SetMean( mean );
-  // gaussian->SetNormalized( this->m_Normalize );
+  if( m_TileScheduler.IsNull() )
+    m_TileScheduler = TileSchedulerType::New();
   
-  // double rescaleFactor = 1.0;
-  // double value;
+  m_TileScheduler->SetRegion( emptyImage->GetRequestedRegion() );
+  m_TileScheduler->SetTileSize( 16 );
+  m_TileScheduler->Initialize();
   
-  // typename GaussianFunctionType::InputType gaussianPoint; // this is a 1-D point representing the distance
+  m_DrawImage = emptyImage;
   
-  // if( this->m_Rescale && !this->m_Normalize )
-  // {
-    // // Compute rescaling factor from central value of the Gaussian 
-    // gaussianPoint[0] = 0.0;
-    // value = gaussian->Evaluate( gaussianPoint );
-    
-    // rescaleFactor = this->m_MaxValue / value;
-  // }   
+  const int numberOfThreads = 
+    vnl_math_min( m_NumberOfThreads, (int)m_TileScheduler->GetNumberOfTiles() );
+  
+  if( numberOfThreads > 1 )
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    threader->SetSingleMethod( this->DrawThreaderCallback, this );
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedDrawFromCenterline();
+  }
+  
+  m_DrawImage = 0;
+}
+
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE
+CenterlineBasedBarTubeGenerator<TPixel>::DrawThreaderCallback( void *arg )
+{
+  Self *generator = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  generator->ThreadedDrawFromCenterline();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TPixel>
+void
+CenterlineBasedBarTubeGenerator<TPixel>::ThreadedDrawFromCenterline()
+{
+  RegionType tile;
   
+  while( m_TileScheduler->GetNextTile( tile ) )
+    this->DrawTile( tile );
+}
+
+
+template <class TPixel>
+void
+CenterlineBasedBarTubeGenerator<TPixel>::DrawTile( const RegionType & tile )
+{
   typedef itk::ImageRegionIteratorWithIndex<ImageType> IteratorType;
   
-  IteratorType outputIt( emptyImage, emptyImage->GetRequestedRegion() );
+  IteratorType outputIt( m_DrawImage, tile );
   outputIt.GoToBegin();
   
   PointType point;
   double    distance;
-  unsigned int z = 0;
    
   while( !outputIt.IsAtEnd() )
   {
-    emptyImage->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
+    m_DrawImage->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
     //point[2] -= this->m_Offset;  // REMOVE!! otherwise the centerline is not centered.
 
-    //if( outputIt.GetIndex()[0] == 133 && outputIt.GetIndex()[1] == 150 && outputIt.GetIndex()[2] == 0 )
-      //std::cout << outputIt.GetIndex();
-    
-    if( outputIt.GetIndex()[2] > z )
-    {
-      z = outputIt.GetIndex()[2];
-	
-      std::cout << "Z = " << z << std::endl;
-	
-    }
-
     if( this->GetClosestCenterlinePoint( point, distance ) < m_Centerline->size() )
     {
-      //if( distance < DISTANCE_TOL_FACTOR * this->m_TubeRadius )
-	  if( distance < this->m_TubeRadius )
-      {
-        // gaussianPoint[0] = distance;
-        // value = gaussian->Evaluate( gaussianPoint );
-        // value *= rescaleFactor;
-        
-        // // Set the pixel value to the function value
-        // outputIt.Set( (PixelType) value );  
+      if( distance < this->m_TubeRadius )
         outputIt.Set( (PixelType) this->m_MaxValue );		
-	
-      }   
     }
     
     ++outputIt; 
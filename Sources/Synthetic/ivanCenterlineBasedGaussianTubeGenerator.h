@@ -34,10 +34,17 @@ SUCH DAMAGE.
 
 #include "ivanCircularGaussianTubeGenerator.h"
 
+#include "ivanImageRegionTileScheduler.h"
+
 #include "itkGaussianSpatialFunction.h"
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkVectorContainer.h"
 #include "itkImageFileWriter.h"
+#include "itkMultiThreader.h"
+
+#include "vnl/vnl_math.h"
+
+#include <vector>
 
 //#define DISTANCE_TOL_FACTOR 4.0 // this means exp(-16/2) = exp(-8) = 0.000335462628 for the min Gaussian value for this tolerance
 #define DISTANCE_TOL_FACTOR 3.0 // this means exp(-9/2) = exp(-4.5) = 0.011 for the min Gaussian value for this tolerance
@@ -62,6 +69,21 @@ public:
     
   typedef itk::VectorContainer<unsigned int,PointType>  PointContainerType;
   typedef typename PointContainerType::Pointer          PointContainerPointer;
+  
+  typedef itk::GaussianSpatialFunction<double, 1>       GaussianFunctionType;
+  typedef typename GaussianFunctionType::Pointer        GaussianFunctionPointer;
+  
+  typedef ImageRegionTileScheduler<3>                   TileSchedulerType;
+  typedef typename TileSchedulerType::RegionType        RegionType;
+  
+  /** How the value of a voxel is computed from the centerline and the image. Every voxel takes
+    * a single value from the centerline, so the segments do not add up at their joints. */
+  enum AccumulationType
+  {
+    NearestPointAccumulation,   // value at the distance to the closest centerline point
+    MaximumAccumulation,        // value at the distance to the closest segment
+    SumAccumulation             // as MaximumAccumulation, added to the value in the image
+  };
 
 public:
 
@@ -76,36 +98,94 @@ public:
     { return m_Centerline; }
   const PointContainerType * GetCenterline() const 
     { return m_Centerline; }  
+    
+  /** Set/Get the number of threads used to draw the image. Default is the global default 
+    * of the MultiThreader. */
+  void SetNumberOfThreads( int numberOfThreads )
+    { m_NumberOfThreads = vnl_math_max( 1, vnl_math_min( numberOfThreads, ITK_MAX_THREADS ) ); }
+  int GetNumberOfThreads() const
+    { return m_NumberOfThreads; }
+    
+  /** Set/Get how the value of a voxel is computed. With SumAccumulation the tube is added to 
+    * the image, so the tubes of several centerlines drawn with Draw() into the same image add 
+    * up where they overlap. Default is NearestPointAccumulation, where the distance is measured
+    * to the closest centerline point rather than to the polyline. */
+  void SetAccumulation( AccumulationType accumulation )
+    { m_Accumulation = accumulation; }
+  AccumulationType GetAccumulation() const
+    { return m_Accumulation; }
 
   virtual ImagePointer Create();
   
+  /** Draw the tube into an existing image instead of creating a new one. */
+  void Draw( ImageType *image )
+    { this->DrawFromCenterline( image ); }
+  
 protected:
   
   /** Create and allocate the image with the appropiate dimensions, spacing... */
   virtual ImagePointer CreateEmptyImage();
   
-  /** Actually draw/fill the image from the centerline, once the image structure is created. */
+  /** Actually draw/fill the image from the centerline, once the image structure is created. 
+    * Every segment between consecutive centerline points only affects the voxels closer than 
+    * DISTANCE_TOL_FACTOR * sigma to it, a capsule, so only those voxels are evaluated, and the 
+    * cost depends on the volume of the tube rather than on the volume of the image. The image 
+    * is divided in tiles that the threads take dynamically, and every tile draws the segments 
+    * whose capsule bounding box overlaps it. */
   void DrawFromCenterline( ImagePointer emptyImage );
   
-  unsigned int GetClosestCenterlinePoint( const PointType & point, double & distance );
+  /** Compute the segments and the image region each one may affect. */
+  void ComputeSegments( const ImageType *image );
+  
+  /** Draw the tiles taken from the scheduler until there are no more. Every thread uses 
+    * its own Gaussian function. */
+  void ThreadedDrawFromCenterline();
+  
+  /** Draw a single tile. Subclasses may override this with a closed form for their shape. */
+  virtual void DrawTile( const RegionType & tile, const GaussianFunctionType *gaussian );
+  
+  /** Create the Gaussian function for the distance to the centerline. */
+  GaussianFunctionPointer CreateGaussianFunction() const;
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DrawThreaderCallback( void *arg );
+  
+  unsigned int GetClosestCenterlinePoint( const PointType & point, double & distance ) const;
 
 protected:
 
   PointContainerPointer   m_Centerline;
+  
+  int                     m_NumberOfThreads;
+  
+  AccumulationType        m_Accumulation;
+  
+  /** Image and tiles being drawn, and the factor applied to the Gaussian values. */
+  ImageType                           *m_DrawImage;
+  typename TileSchedulerType::Pointer  m_TileScheduler;
+  double                               m_RescaleFactor;
+  
+  /** End points of the segments in image space, and the image region they may affect. */
+  std::vector<PointType>               m_SegmentStarts;
+  std::vector<PointType>               m_SegmentEnds;
+  std::vector<RegionType>              m_SegmentRegions;
 };
 
 
 template <class TPixel>
-CenterlineBasedGaussianTubeGenerator<TPixel>::CenterlineBasedGaussianTubeGenerator()
+CenterlineBasedGaussianTubeGenerator<TPixel>::CenterlineBasedGaussianTubeGenerator() :
+  m_Accumulation( NearestPointAccumulation ),
+  m_DrawImage( 0 ),
+  m_RescaleFactor( 1.0 )
 {
- 
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 
 template <class TPixel>
 unsigned int 
 CenterlineBasedGaussianTubeGenerator<TPixel>
-::GetClosestCenterlinePoint( const PointType & point, double & distance )
+::GetClosestCenterlinePoint( const PointType & point, double & distance ) const
 {
   double sqrDist = itk::NumericTraits<double>::max();
   double current;
@@ -171,75 +251,261 @@ CenterlineBasedGaussianTubeGenerator<TPixel>::CreateEmptyImage()
 
 
 template <class TPixel>
-void
-CenterlineBasedGaussianTubeGenerator<TPixel>::DrawFromCenterline( ImagePointer emptyImage )
+typename CenterlineBasedGaussianTubeGenerator<TPixel>::GaussianFunctionPointer
+CenterlineBasedGaussianTubeGenerator<TPixel>::CreateGaussianFunction() const
 {
-  typedef itk::GaussianSpatialFunction<double, 1>   GaussianFunctionType;
-  typedef typename GaussianFunctionType::InputType  GaussianFunctionPositionType;
-  typename GaussianFunctionType::Pointer gaussian = GaussianFunctionType::New();
+  GaussianFunctionPointer gaussian = GaussianFunctionType::New();
    
-  GaussianFunctionType::ArrayType sigma;
+  typename GaussianFunctionType::ArrayType sigma;
   sigma.Fill( this->m_Sigma );
 
-  GaussianFunctionType::ArrayType mean;
+  typename GaussianFunctionType::ArrayType mean;
   mean.Fill( 0.0 );
    
   gaussian->SetSigma( sigma );
   gaussian->SetMean( mean );
   gaussian->SetNormalized( this->m_Normalize );
   
-  double rescaleFactor = 1.0;
-  double value;
-  
-  typename GaussianFunctionType::InputType gaussianPoint; // this is a 1-D point representing the distance
+  return gaussian;
+}
+
+
+template <class TPixel>
+void
+CenterlineBasedGaussianTubeGenerator<TPixel>::DrawFromCenterline( ImagePointer emptyImage )
+{
+  m_RescaleFactor = 1.0;
   
   if( this->m_Rescale && !this->m_Normalize )
   {
     // Compute rescaling factor from central value of the Gaussian 
+    typename GaussianFunctionType::InputType gaussianPoint;
     gaussianPoint[0] = 0.0;
-    value = gaussian->Evaluate( gaussianPoint );
     
-    rescaleFactor = this->m_MaxValue / value;
-  }   
+    m_RescaleFactor = this->m_MaxValue / this->CreateGaussianFunction()->Evaluate( gaussianPoint );
+  }
   
-  typedef itk::ImageRegionIteratorWithIndex<ImageType> IteratorType;
+  this->ComputeSegments( emptyImage );
   
-  IteratorType outputIt( emptyImage, emptyImage->GetRequestedRegion() );
-  outputIt.GoToBegin();
+  if( m_TileScheduler.IsNull() )
+    m_TileScheduler = TileSchedulerType::New();
   
-  PointType point;
-  double    distance;
-  unsigned int z = 0;
-   
-  while( !outputIt.IsAtEnd() )
+  m_TileScheduler->SetRegion( emptyImage->GetRequestedRegion() );
+  m_TileScheduler->SetTileSize( 16 );
+  m_TileScheduler->Initialize();
+  
+  m_DrawImage = emptyImage;
+  
+  const int numberOfThreads = 
+    vnl_math_min( m_NumberOfThreads, (int)m_TileScheduler->GetNumberOfTiles() );
+  
+  if( numberOfThreads > 1 )
   {
-    emptyImage->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
-    point[2] -= this->m_Offset;
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    threader->SetSingleMethod( this->DrawThreaderCallback, this );
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedDrawFromCenterline();
+  }
+  
+  m_DrawImage = 0;
+  m_SegmentStarts.clear();
+  m_SegmentEnds.clear();
+  m_SegmentRegions.clear();
+}
 
-    //if( outputIt.GetIndex()[0] == 133 && outputIt.GetIndex()[1] == 150 && outputIt.GetIndex()[2] == 0 )
-      //std::cout << outputIt.GetIndex();
+
+template <class TPixel>
+void
+CenterlineBasedGaussianTubeGenerator<TPixel>::ComputeSegments( const ImageType *image )
+{
+  m_SegmentStarts.clear();
+  m_SegmentEnds.clear();
+  m_SegmentRegions.clear();
+  
+  if( m_Centerline.IsNull() || m_Centerline->size() == 0 )
+    return;
+    
+  const double supportRadius = DISTANCE_TOL_FACTOR * this->m_Sigma;
+  const RegionType & imageRegion = image->GetRequestedRegion();
+  
+  // A single point is drawn as a degenerate segment
+  const unsigned int numberOfSegments = 
+    vnl_math_max( 1u, (unsigned int)m_Centerline->size() - 1 );
+  
+  for( unsigned int i=0; i<numberOfSegments; ++i )
+  {
+    // The image is shifted by the offset in Z with respect to the centerline
+    PointType start = m_Centerline->at( i );
+    PointType end = m_Centerline->at( vnl_math_min( i + 1, (unsigned int)m_Centerline->size() - 1 ) );
+    start[2] += this->m_Offset;
+    end[2] += this->m_Offset;
+    
+    // Bounding box of the capsule
+    PointType lower, upper;
+    for( unsigned int dim=0; dim<3; ++dim )
+    {
+      lower[dim] = vnl_math_min( start[dim], end[dim] ) - supportRadius;
+      upper[dim] = vnl_math_max( start[dim], end[dim] ) + supportRadius;
+    }
+    
+    itk::ContinuousIndex<double,3> lowerIndex, upperIndex;
+    image->TransformPhysicalPointToContinuousIndex( lower, lowerIndex );
+    image->TransformPhysicalPointToContinuousIndex( upper, upperIndex );
     
-    if( outputIt.GetIndex()[2] > z )
+    IndexType index;
+    typename RegionType::SizeType size;
+    
+    for( unsigned int dim=0; dim<3; ++dim )
     {
-      z = outputIt.GetIndex()[2];
-      std::cout << "Z = " << z << std::endl;
+      const long first = (long)vcl_ceil( vnl_math_min( lowerIndex[dim], upperIndex[dim] ) );
+      const long last = (long)vcl_floor( vnl_math_max( lowerIndex[dim], upperIndex[dim] ) );
+      
+      index[dim] = first;
+      size[dim] = ( last >= first ) ? last - first + 1 : 0;
     }
+    
+    RegionType region( index, size );
+    
+    if( !region.Crop( imageRegion ) )
+      continue;
+      
+    m_SegmentStarts.push_back( start );
+    m_SegmentEnds.push_back( end );
+    m_SegmentRegions.push_back( region );
+  }
+}
+
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE
+CenterlineBasedGaussianTubeGenerator<TPixel>::DrawThreaderCallback( void *arg )
+{
+  Self *generator = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  generator->ThreadedDrawFromCenterline();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 
-    if( this->GetClosestCenterlinePoint( point, distance ) < m_Centerline->size() )
+template <class TPixel>
+void
+CenterlineBasedGaussianTubeGenerator<TPixel>::ThreadedDrawFromCenterline()
+{
+  GaussianFunctionPointer gaussian = this->CreateGaussianFunction();
+  
+  RegionType tile;
+  
+  while( m_TileScheduler->GetNextTile( tile ) )
+    this->DrawTile( tile, gaussian );
+}
+
+
+template <class TPixel>
+void
+CenterlineBasedGaussianTubeGenerator<TPixel>::DrawTile
+  ( const RegionType & tile, const GaussianFunctionType *gaussian )
+{
+  const double supportRadius = DISTANCE_TOL_FACTOR * this->m_Sigma;
+  const double squaredSupportRadius = supportRadius * supportRadius;
+  
+  const IndexType & tileIndex = tile.GetIndex();
+  const typename RegionType::SizeType & tileSize = tile.GetSize();
+  
+  // The closest distance of every voxel of the tile over all the segments
+  std::vector<double> squaredDistances( tile.GetNumberOfPixels(), squaredSupportRadius );
+  bool drawn = false;
+  
+  const bool nearestPoint = ( m_Accumulation == NearestPointAccumulation );
+  
+  typename GaussianFunctionType::InputType gaussianPoint; // this is a 1-D point representing the distance
+  
+  PointType point;
+  IndexType index;
+  
+  for( unsigned int s=0; s<m_SegmentRegions.size(); ++s )
+  {
+    RegionType region = m_SegmentRegions[s];
+    
+    if( !region.Crop( tile ) )
+      continue;
+      
+    const PointType & start = m_SegmentStarts[s];
+    const typename PointType::VectorType segment = m_SegmentEnds[s] - start;
+    const double squaredLength = segment.GetSquaredNorm();
+    
+    const IndexType & regionIndex = region.GetIndex();
+    const typename RegionType::SizeType & regionSize = region.GetSize();
+    
+    for( unsigned long z=0; z<regionSize[2]; ++z )
     {
-      if( distance < DISTANCE_TOL_FACTOR * this->m_Sigma )
+      index[2] = regionIndex[2] + z;
+      
+      for( unsigned long y=0; y<regionSize[1]; ++y )
       {
-        gaussianPoint[0] = distance;
-        value = gaussian->Evaluate( gaussianPoint );
-        value *= rescaleFactor;
+        index[1] = regionIndex[1] + y;
+        
+        unsigned long pos = ( ( index[2] - tileIndex[2] ) * tileSize[1] + ( index[1] - tileIndex[1] ) ) * 
+          tileSize[0] + ( regionIndex[0] - tileIndex[0] );
         
-        // Set the pixel value to the function value
-        outputIt.Set( (PixelType) value );        
-      }   
+        for( unsigned long x=0; x<regionSize[0]; ++x, ++pos )
+        {
+          index[0] = regionIndex[0] + x;
+          m_DrawImage->TransformIndexToPhysicalPoint( index, point );
+          
+          // Distance to the segment, or to its closest end point, since every centerline point
+          // is the end of a segment
+          const typename PointType::VectorType relative = point - start;
+          
+          double squaredDistance;
+          
+          if( nearestPoint )
+          {
+            squaredDistance = vnl_math_min( relative.GetSquaredNorm(), 
+              ( relative - segment ).GetSquaredNorm() );
+          }
+          else
+          {
+            double t = ( squaredLength > 0.0 ) ? ( relative * segment ) / squaredLength : 0.0;
+            t = vnl_math_max( 0.0, vnl_math_min( 1.0, t ) );
+            
+            squaredDistance = ( relative - segment * t ).GetSquaredNorm();
+          }
+          
+          if( squaredDistance < squaredDistances[pos] )
+          {
+            squaredDistances[pos] = squaredDistance;
+            drawn = true;
+          }
+        }
+      }
     }
+  }
+  
+  if( !drawn )
+    return;
+  
+  typedef itk::ImageRegionIterator<ImageType> IteratorType;
+  
+  IteratorType outputIt( m_DrawImage, tile );
+  
+  for( unsigned long pos=0; !outputIt.IsAtEnd(); ++outputIt, ++pos )
+  {
+    if( squaredDistances[pos] >= squaredSupportRadius )
+      continue;
     
-    ++outputIt; 
-  }  
+    gaussianPoint[0] = vcl_sqrt( squaredDistances[pos] );
+    double value = m_RescaleFactor * gaussian->Evaluate( gaussianPoint );
+    
+    if( m_Accumulation == SumAccumulation )
+      value += outputIt.Get();
+      
+    outputIt.Set( (PixelType) value );
+  }
 }
 
 
@@ -49,6 +49,9 @@ public:
   typedef itk::Image<PixelType,3>       ImageType;
   typedef typename ImageType::Pointer   ImagePointer;
   
+  typedef typename Superclass::SectionImageType     SectionImageType;
+  typedef typename Superclass::SectionImagePointer  SectionImagePointer;
+  
 public:
 
   CircularBarStraightTubeSinuosidalRadiusGenerator();
@@ -69,7 +72,7 @@ public:
   void SetMaxRadius( double maxRadius )
     { this->SetTubeRadius( maxRadius ); }
   double GetMaxRadius() const 
-    { return this->GetSigma(); }
+    { return this->GetRadius(); }
 
 protected: 
   
@@ -125,16 +128,7 @@ CircularBarStraightTubeSinuosidalRadiusGenerator<TPixel>::Create()
   
   // Create Bar section
   
-  typedef CircularBarSectionGenerator<TPixel>    SectionGeneratorType;
-  typedef typename SectionGeneratorType::ImageType    SectionImageType;
-    
-  SectionGeneratorType sectionGenerator;
-  sectionGenerator.SetImageSize( this->m_SectionImageSize );
-  sectionGenerator.SetImageSpacing( this->m_ImageSpacing );
-  //sectionGenerator.SetSigma( this->m_Sigma );
-  sectionGenerator.SetMaxValue( this->m_MaxValue );
-  
-  typename SectionImageType::Pointer sectionImage;
+  SectionImagePointer sectionImage;
   
   typedef itk::ImageRegionConstIterator<SectionImageType>  ConstIteratorType;
   typedef itk::ImageRegionIterator<ImageType>              IteratorType;
@@ -160,9 +154,7 @@ CircularBarStraightTubeSinuosidalRadiusGenerator<TPixel>::Create()
     double angle = vnl_math::pi * sinPos;         
     double sinValue = minRadius + ( maxRadius - minRadius ) * sin( angle );
     
-    sectionGenerator.SetRadius( sinValue );
-        
-    sectionImage = sectionGenerator.Create();
+    sectionImage = this->CreateSectionImage( sinValue );
 
     ConstIteratorType inputIt( sectionImage, sectionImage->GetRequestedRegion() );
     IteratorType outputIt;
@@ -47,6 +47,9 @@ public:
   typedef itk::Image<PixelType,3>       ImageType;
   typedef typename ImageType::Pointer   ImagePointer;
   
+  typedef itk::Image<PixelType,2>               SectionImageType;
+  typedef typename SectionImageType::Pointer    SectionImagePointer;
+  
 public:
 
   CircularBarTubeGenerator();
@@ -87,6 +90,10 @@ public:
   ImagePointer Create();
 
 protected: 
+
+  /** Create the image of a section of the given radius. Subclasses may override this to 
+    * change the profile of the tube. */
+  virtual SectionImagePointer CreateSectionImage( double radius );
   
   /** Image size for the section (same for width and depth). */
   unsigned long    m_SectionImageSize;
@@ -157,17 +164,9 @@ CircularBarTubeGenerator<TPixel>::Create()
   tubeImage->Allocate();
   tubeImage->FillBuffer(0);
   
-  // Crate Gaussian section
-  
-  typedef CircularBarSectionGenerator<TPixel>      SectionGeneratorType;
-  typedef typename SectionGeneratorType::ImageType  SectionImageType;
-    
-  SectionGeneratorType sectionGenerator;
-  sectionGenerator.SetImageSize( this->m_SectionImageSize );
-  sectionGenerator.SetRadius( this->m_TubeRadius );
-  sectionGenerator.SetMaxValue( this->m_MaxValue );
+  // Create bar section
   
-  typename SectionImageType::Pointer sectionImage = sectionGenerator.Create();
+  SectionImagePointer sectionImage = this->CreateSectionImage( this->m_TubeRadius );
   
   typedef itk::ImageRegionConstIterator<SectionImageType>  ConstIteratorType;
   typedef itk::ImageRegionIterator<ImageType>              IteratorType;
@@ -199,6 +198,22 @@ CircularBarTubeGenerator<TPixel>::Create()
   return tubeImage;    
 }
 
+
+template <class TPixel>
+typename CircularBarTubeGenerator<TPixel>::SectionImagePointer
+CircularBarTubeGenerator<TPixel>::CreateSectionImage( double radius )
+{
+  typedef CircularBarSectionGenerator<TPixel>      SectionGeneratorType;
+    
+  SectionGeneratorType sectionGenerator;
+  sectionGenerator.SetImageSize( this->m_SectionImageSize );
+  sectionGenerator.SetImageSpacing( this->m_ImageSpacing );
+  sectionGenerator.SetRadius( radius );
+  sectionGenerator.SetMaxValue( this->m_MaxValue );
+  
+  return sectionGenerator.Create();
+}
+
 } // end namespace ivan
 
 #endif // __ivanCircularBarTubeGenerator_h_
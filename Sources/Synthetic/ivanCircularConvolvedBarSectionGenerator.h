@@ -0,0 +1,183 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircularConvolvedBarSectionGenerator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: creates a Bar section image convolved with a Gaussian from its tabulated profile
+// Date: 2012/11/05
+
+
+#ifndef __ivanCircularConvolvedBarSectionGenerator_h_
+#define __ivanCircularConvolvedBarSectionGenerator_h_
+
+#include "ivanConvolvedBarProfileTable.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+
+namespace ivan
+{
+
+/** \class CircularConvolvedBarSectionGenerator
+ *  \brief Creates the section of a bar tube convolved with a Gaussian.
+ *
+ * Every pixel takes the value of the convolved profile at its distance to the center, from a
+ * ConvolvedBarProfileTable. The table is only rebuilt when the radius or sigma change. The 
+ * image is the same as a CircularBarSectionGenerator section filtered with a Gaussian of 
+ * the given sigma, except for the discretization of the filter.
+ */
+template <class TPixel>
+class CircularConvolvedBarSectionGenerator
+{
+public:
+
+  typedef TPixel                        PixelType;
+  typedef itk::Image<PixelType,2>       ImageType;
+  typedef typename ImageType::Pointer   ImagePointer;
+  typedef typename ImageType::PointType PointType;
+
+public:
+
+  CircularConvolvedBarSectionGenerator();
+  ~CircularConvolvedBarSectionGenerator() {};
+  
+  void SetImageSize( unsigned long size )
+    { m_ImageSize = size; }
+  unsigned long GetImageSize() const
+    { return m_ImageSize; }
+    
+  void SetImageSpacing( double spacing )
+    { m_ImageSpacing = spacing; }
+  double GetImageSpacing() const
+    { return m_ImageSpacing; }
+  
+  void SetRadius( double tubeRadius )
+    { m_Radius = tubeRadius; }
+  double GetRadius() const
+    { return m_Radius; }
+    
+  /** Standard deviation of the Gaussian, in physical units. Default is 0.7. */
+  void SetSigma( double sigma )
+    { m_Sigma = sigma; }
+  double GetSigma() const
+    { return m_Sigma; }
+    
+  void SetMaxValue( PixelType value )
+    { m_MaxValue = value; }
+  PixelType GetMaxValue() const
+    { return m_MaxValue; }
+    
+  const ConvolvedBarProfileTable & GetProfileTable() const
+    { return m_ProfileTable; }
+
+  ImagePointer Create();
+
+private: 
+  
+  /** Image size in pixels (same for height and width). */
+  unsigned long   m_ImageSize;
+  
+  /** Image spacing. */
+  double          m_ImageSpacing;
+  
+  /** Radius of the bar before convolution. */
+  double          m_Radius;
+  
+  /** Standard deviation of the Gaussian. */
+  double          m_Sigma;
+  
+  /** Maximum intensity value, which is the value of the bar before convolution. Default value 
+    * is 255. */
+  PixelType       m_MaxValue;
+  
+  ConvolvedBarProfileTable  m_ProfileTable;
+};
+
+
+template <class TPixel>
+CircularConvolvedBarSectionGenerator<TPixel>::CircularConvolvedBarSectionGenerator() :
+  m_ImageSize( 50 ),
+  m_ImageSpacing( 1.0 ),
+  m_Radius( 2.0 ),
+  m_Sigma( 0.7 ),
+  m_MaxValue( 255.0 )
+{
+
+}
+
+
+template <class TPixel>
+typename CircularConvolvedBarSectionGenerator<TPixel>::ImagePointer
+CircularConvolvedBarSectionGenerator<TPixel>::Create()
+{
+  if( m_ProfileTable.GetRadius() != m_Radius || m_ProfileTable.GetSigma() != m_Sigma )
+    m_ProfileTable.Build( m_Radius, m_Sigma );
+    
+  ImagePointer sectionImage = ImageType::New();
+    
+  typename ImageType::SpacingType spacing;
+  spacing.Fill( this->m_ImageSpacing );
+  sectionImage->SetSpacing( spacing );
+  
+  typename ImageType::RegionType region;
+    
+  typename ImageType::RegionType::SizeType size;    
+  size.Fill( this->m_ImageSize );
+  region.SetSize( size );
+  
+  typename ImageType::RegionType::IndexType index;    
+  index.Fill(0);
+  region.SetIndex( index );
+  
+  sectionImage->SetRegions( region );
+  sectionImage->Allocate();
+  
+  typedef itk::ImageRegionIteratorWithIndex<ImageType>   IteratorType;
+  
+  IteratorType it( sectionImage, sectionImage->GetRequestedRegion() );
+  it.GoToBegin();
+  
+  const double center = ( this->m_ImageSize - 1 ) * this->m_ImageSpacing / 2.0;
+  
+  typename ImageType::IndexType currentIndex;
+  double dx, dy;
+  
+  while( !it.IsAtEnd() )
+  {
+    currentIndex = it.GetIndex();
+    dx = currentIndex[0] * this->m_ImageSpacing - center;
+    dy = currentIndex[1] * this->m_ImageSpacing - center;
+    
+    it.Set( static_cast<PixelType>( this->m_MaxValue * m_ProfileTable.Evaluate( std::sqrt( dx * dx + dy * dy ) ) ) );
+          
+    ++it; 
+  }
+      
+  return sectionImage;
+}
+
+} // end namespace ivan
+
+#endif // __ivanCircularConvolvedBarSectionGenerator_h_
@@ -0,0 +1,97 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircularConvolvedBarStraightTubeSinusoidalRadiusGenerator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: creates a straight tube with bar profile convolved with a Gaussian 
+// and with radius following a sinusoid.
+// Date: 2012/11/05
+
+
+#ifndef __ivanCircularConvolvedBarStraightTubeSinusoidalRadiusGenerator_h_
+#define __ivanCircularConvolvedBarStraightTubeSinusoidalRadiusGenerator_h_
+
+#include "ivanCircularBarStraightTubeSinusoidalRadiusGenerator.h"
+#include "ivanCircularConvolvedBarSectionGenerator.h"
+
+namespace ivan
+{
+
+/** \class CircularConvolvedBarStraightTubeSinusoidalRadiusGenerator
+ *  \brief Creates a bar tube of sinusoidal radius convolved with a Gaussian point spread function.
+ *
+ * Every slice is drawn from the convolved profile of its own radius, which neglects the blur 
+ * along the tube axis. This is accurate as long as the radius varies slowly compared to sigma,
+ * that is, for semi-periods of several sigmas.
+ */
+template <class TPixel>
+class CircularConvolvedBarStraightTubeSinusoidalRadiusGenerator : 
+  public CircularBarStraightTubeSinuosidalRadiusGenerator<TPixel>
+{
+public:
+
+  typedef CircularConvolvedBarStraightTubeSinusoidalRadiusGenerator<TPixel>   Self;
+  typedef CircularBarStraightTubeSinuosidalRadiusGenerator<TPixel>            Superclass;
+
+  typedef TPixel                        PixelType;
+  typedef itk::Image<PixelType,3>       ImageType;
+  typedef typename ImageType::Pointer   ImagePointer;
+  
+  typedef typename Superclass::SectionImageType     SectionImageType;
+  typedef typename Superclass::SectionImagePointer  SectionImagePointer;
+  
+public:
+
+  CircularConvolvedBarStraightTubeSinusoidalRadiusGenerator() :
+    m_Sigma( 0.7 )
+    {}
+  ~CircularConvolvedBarStraightTubeSinusoidalRadiusGenerator() {};
+  
+  /** Standard deviation of the Gaussian, in physical units. Default is 0.7. */
+  void SetSigma( double sigma )
+    { m_Sigma = sigma; }
+  double GetSigma() const
+    { return m_Sigma; }
+
+protected: 
+
+  virtual SectionImagePointer CreateSectionImage( double radius )
+    {
+      m_SectionGenerator.SetImageSize( this->m_SectionImageSize );
+      m_SectionGenerator.SetImageSpacing( this->m_ImageSpacing );
+      m_SectionGenerator.SetRadius( radius );
+      m_SectionGenerator.SetSigma( m_Sigma );
+      m_SectionGenerator.SetMaxValue( this->m_MaxValue );
+      
+      return m_SectionGenerator.Create();
+    }
+  
+  double    m_Sigma;
+  
+  CircularConvolvedBarSectionGenerator<TPixel>   m_SectionGenerator;
+};
+
+} // end namespace ivan
+
+#endif // __ivanCircularConvolvedBarStraightTubeSinusoidalRadiusGenerator_h_
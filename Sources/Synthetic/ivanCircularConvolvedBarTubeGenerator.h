@@ -0,0 +1,96 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircularConvolvedBarTubeGenerator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: creates a straight tube with bar profile convolved with a Gaussian
+// Date: 2012/11/05
+
+
+#ifndef __ivanCircularConvolvedBarTubeGenerator_h_
+#define __ivanCircularConvolvedBarTubeGenerator_h_
+
+#include "ivanCircularBarTubeGenerator.h"
+#include "ivanCircularConvolvedBarSectionGenerator.h"
+
+namespace ivan
+{
+
+/** \class CircularConvolvedBarTubeGenerator
+ *  \brief Creates a bar tube convolved with a Gaussian point spread function.
+ *
+ * The convolution of an infinite cylinder with a 3-D Gaussian is the convolution of its 
+ * section with a 2-D Gaussian, so the slices are drawn from the tabulated convolved profile
+ * instead of filtering the whole volume. 
+ */
+template <class TPixel>
+class CircularConvolvedBarTubeGenerator : public CircularBarTubeGenerator<TPixel>
+{
+public:
+
+  typedef CircularConvolvedBarTubeGenerator<TPixel>   Self;
+  typedef CircularBarTubeGenerator<TPixel>            Superclass;
+
+  typedef TPixel                        PixelType;
+  typedef itk::Image<PixelType,3>       ImageType;
+  typedef typename ImageType::Pointer   ImagePointer;
+  
+  typedef typename Superclass::SectionImageType     SectionImageType;
+  typedef typename Superclass::SectionImagePointer  SectionImagePointer;
+  
+public:
+
+  CircularConvolvedBarTubeGenerator() :
+    m_Sigma( 0.7 )
+    {}
+  ~CircularConvolvedBarTubeGenerator() {};
+  
+  /** Standard deviation of the Gaussian, in physical units. Default is 0.7. */
+  void SetSigma( double sigma )
+    { m_Sigma = sigma; }
+  double GetSigma() const
+    { return m_Sigma; }
+
+protected: 
+
+  virtual SectionImagePointer CreateSectionImage( double radius )
+    {
+      m_SectionGenerator.SetImageSize( this->m_SectionImageSize );
+      m_SectionGenerator.SetImageSpacing( this->m_ImageSpacing );
+      m_SectionGenerator.SetRadius( radius );
+      m_SectionGenerator.SetSigma( m_Sigma );
+      m_SectionGenerator.SetMaxValue( this->m_MaxValue );
+      
+      return m_SectionGenerator.Create();
+    }
+  
+  double    m_Sigma;
+  
+  /** Kept between sections, so its table is only rebuilt when the radius changes. */
+  CircularConvolvedBarSectionGenerator<TPixel>   m_SectionGenerator;
+};
+
+} // end namespace ivan
+
+#endif // __ivanCircularConvolvedBarTubeGenerator_h_
@@ -87,6 +87,10 @@ protected:
   
   /** Computes where the center of the toroid should be located depending on the calculated image area. */
   virtual void ComputeCenter( const ImageType *image );
+  
+  /** The helix is not a circle, so it is always drawn from the centerline. */
+  virtual bool IsAnalyticProfileSupported() const
+    { return false; }
     
 protected:
 
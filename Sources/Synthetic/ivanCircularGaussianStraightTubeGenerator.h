@@ -33,6 +33,11 @@ SUCH DAMAGE.
 
 #include "ivanCircularGaussianTubeGenerator.h"
 
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <vector>
+
 namespace ivan
 {
 
@@ -56,14 +61,33 @@ public:
   ~CircularGaussianStraightTubeGenerator() {};
   
   virtual ImagePointer Create();
+  
+  /** Sample the Gaussian section in closed form as the product of two 1D profiles instead of 
+    * smoothing a discrete pulse. If Rescale is on the peak is MaxValue, otherwise the section 
+    * approximately sums to 1 like the discrete kernel. Default is off. */
+  void SetAnalyticProfile( bool analytic )
+    { this->m_AnalyticProfile = analytic; }
+  void AnalyticProfileOn()
+    { this->SetAnalyticProfile( true ); }
+  void AnalyticProfileOff()
+    { this->SetAnalyticProfile( false ); }
+  bool GetAnalyticProfile() const
+    { return this->m_AnalyticProfile; }
 
 protected: 
   
+  /** Write the closed form section into the first slice of the image. */
+  void CreateAnalyticSection( ImageType *image ) const;
+  
+protected:
+  
+  bool    m_AnalyticProfile;
 };
 
 
 template <class TPixel>
-CircularGaussianStraightTubeGenerator<TPixel>::CircularGaussianStraightTubeGenerator()
+CircularGaussianStraightTubeGenerator<TPixel>::CircularGaussianStraightTubeGenerator() :
+  m_AnalyticProfile( false )
 {
   
 }
@@ -104,6 +128,20 @@ CircularGaussianStraightTubeGenerator<TPixel>::Create()
   tubeImage->Allocate();
   tubeImage->FillBuffer(0);
   
+  const unsigned long sliceSize = size[0] * size[1];
+  PixelType *buffer = tubeImage->GetBufferPointer();
+  
+  if( m_AnalyticProfile )
+  {
+    this->CreateAnalyticSection( tubeImage );
+    
+    // The tube is straight so every slice is a copy of the first one
+    for( unsigned long z=1; z < this->m_Height; ++z )
+      std::copy( buffer, buffer + sliceSize, buffer + z * sliceSize );
+    
+    return tubeImage;
+  }
+  
   // Create Gaussian section
   
   typedef CircularGaussianSectionGenerator<TPixel>    SectionGeneratorType;
@@ -125,28 +163,63 @@ CircularGaussianStraightTubeGenerator<TPixel>::Create()
   ConstIteratorType inputIt( sectionImage, sectionImage->GetRequestedRegion() );
   IteratorType outputIt;
   
-  size[2] = 1; // copy a single slice each time
+  size[2] = 1; // copy the first slice from the section...
   region.SetSize( size );
   
-  for( unsigned long z=0; z < this->m_Height; ++z )
+  outputIt = IteratorType( tubeImage, region );
+  
+  inputIt.GoToBegin();
+  outputIt.GoToBegin();
+  
+  while( !inputIt.IsAtEnd() && !outputIt.IsAtEnd() )
   {
-    index[2] = z; // current slice
-    region.SetIndex( index );
-    
-    outputIt = IteratorType( tubeImage, region );
-    
-    inputIt.GoToBegin();
-    outputIt.GoToBegin();
+    outputIt.Set( inputIt.Get() );
+    ++inputIt;
+    ++outputIt;
+  }
+  
+  // ...and replicate it in memory to the rest of slices
+  for( unsigned long z=1; z < this->m_Height; ++z )
+    std::copy( buffer, buffer + sliceSize, buffer + z * sliceSize );
+  
+  return tubeImage;    
+}
+
+
+template <class TPixel>
+void CircularGaussianStraightTubeGenerator<TPixel>::CreateAnalyticSection( ImageType *image ) const
+{
+  const typename ImageType::RegionType::SizeType & size = image->GetLargestPossibleRegion().GetSize();
+  const double spacing = this->m_ImageSpacing;
+  const double exponentFactor = -0.5 / ( this->m_Sigma * this->m_Sigma );
+  
+  // Same center as the pulse of the discrete section generator
+  std::vector<double> profiles[2];
+  
+  for( unsigned int dim=0; dim<2; ++dim )
+  {
+    profiles[dim].resize( size[dim] );
+    const long center = ( size[dim] - 1 ) / 2;
     
-    while( !inputIt.IsAtEnd() )
+    for( unsigned long i=0; i<size[dim]; ++i )
     {
-      outputIt.Set( inputIt.Get() );
-      ++inputIt;
-      ++outputIt;
+      const double distance = ( (long)i - center ) * spacing;
+      profiles[dim][i] = vcl_exp( exponentFactor * distance * distance );
     }
   }
   
-  return tubeImage;    
+  const double amplitude = this->m_Rescale ? (double)this->m_MaxValue : 
+    spacing * spacing / ( 2.0 * vnl_math::pi * this->m_Sigma * this->m_Sigma );
+  
+  PixelType *pixel = image->GetBufferPointer();
+  
+  for( unsigned long j=0; j<size[1]; ++j )
+  {
+    const double rowFactor = amplitude * profiles[1][j];
+    
+    for( unsigned long i=0; i<size[0]; ++i, ++pixel )
+      *pixel = (PixelType)( rowFactor * profiles[0][i] );
+  }
 }
 
 } // end namespace ivan
@@ -133,6 +133,18 @@ public:
   bool GetAlwaysImageAreaFullCircle() const
     { return this->m_AlwaysImageAreaFullCircle; }
     
+  /** Compute the distance of every voxel to the circle in closed form, row by row, instead of 
+    * measuring it to the sampled centerline. The result is independent of the number of 
+    * points. Default is off. Ignored by subclasses whose centerline is not a circle. */
+  void SetAnalyticProfile( bool analytic )
+    { this->m_AnalyticProfile = analytic; }
+  void AnalyticProfileOn()
+    { this->SetAnalyticProfile( true ); }
+  void AnalyticProfileOff()
+    { this->SetAnalyticProfile( false ); }
+  bool GetAnalyticProfile() const
+    { return this->m_AnalyticProfile; }
+    
   virtual double GetTotalWidth() const
     //{ return ( 2.0 * this->m_Radius + 6.0 * this->m_Sigma ); } // with this would be enough but we left here some more margin
     { return ( 2.0 * this->m_Radius + 8.0 * this->m_Sigma ); }
@@ -166,6 +178,14 @@ protected:
   
   /** Computes where the center of the toroid should be located depending on the calculated image area. */
   virtual void ComputeCenter( const ImageType *image );
+  
+  /** Draw a tile in closed form if AnalyticProfile is on. */
+  virtual void DrawTile( const typename Superclass::RegionType & tile, 
+    const typename Superclass::GaussianFunctionType *gaussian );
+  
+  /** Returns true if the centerline is the circle the closed form assumes. */
+  virtual bool IsAnalyticProfileSupported() const
+    { return true; }
     
 protected:
   
@@ -201,6 +221,9 @@ protected:
   
   /** Force the image area to cover the full torus circle even if the angles don't. */
   bool             m_AlwaysImageAreaFullCircle;  
+  
+  /** Compute the profile in closed form. */
+  bool             m_AnalyticProfile;
 };
 
 
@@ -215,7 +238,8 @@ CircularGaussianToroidGenerator<TPixel>::CircularGaussianToroidGenerator() :
   m_ImageArea( FullCircle ),
   m_Modified( true ),
   m_AutoComputeNumberOfPoints( false ),
-  m_AlwaysImageAreaFullCircle( false )
+  m_AlwaysImageAreaFullCircle( false ),
+  m_AnalyticProfile( false )
 {
   m_Center.Fill( 0.0 );
 }
@@ -496,6 +520,112 @@ void CircularGaussianToroidGenerator<TPixel>::ComputeCenter( const ImageType *im
     image->GetLargestPossibleRegion().GetSize()[this->m_Direction] * image->GetSpacing()[this->m_Direction];
 }
 
+template <class TPixel>
+void CircularGaussianToroidGenerator<TPixel>::DrawTile( const typename Superclass::RegionType & tile,
+  const typename Superclass::GaussianFunctionType *gaussian )
+{
+  if( !this->m_AnalyticProfile || !this->IsAnalyticProfileSupported() )
+  {
+    Superclass::DrawTile( tile, gaussian );
+    return;
+  }
+  
+  const double supportRadius = DISTANCE_TOL_FACTOR * this->m_Sigma;
+  const double squaredSupportRadius = supportRadius * supportRadius;
+  const double exponentFactor = -0.5 / ( this->m_Sigma * this->m_Sigma );
+  
+  // Peak value, including normalization and rescaling
+  typename Superclass::GaussianFunctionType::InputType origin;
+  origin[0] = 0.0;
+  const double amplitude = this->m_RescaleFactor * gaussian->Evaluate( origin );
+  
+  const unsigned int circleXDir = ( this->m_Direction + 1 ) % 3;
+  const unsigned int circleYDir = ( this->m_Direction + 2 ) % 3;
+  
+  // The image is shifted by the offset in Z with respect to the centerline
+  PointType center = this->m_Center;
+  center[2] += this->m_Offset;
+  
+  // Arc end points, used when the angle of a voxel is outside the arc
+  const bool fullCircle = ( vcl_abs( this->m_AngleInterval ) >= 2.0 * vnl_math::pi );
+  const double arcStart = vnl_math_min( this->m_StartAngle, this->m_StartAngle + this->m_AngleInterval );
+  const double arcInterval = vcl_abs( this->m_AngleInterval );
+  
+  PointType arcEnds[2];
+  for( unsigned int e=0; e<2; ++e )
+  {
+    const double angle = arcStart + e * arcInterval;
+    arcEnds[e] = center;
+    arcEnds[e][circleXDir] += this->m_Radius * vcl_cos( angle );
+    arcEnds[e][circleYDir] += this->m_Radius * vcl_sin( angle );
+  }
+  
+  ImageType *image = this->m_DrawImage;
+  const double rowSpacing = image->GetSpacing()[0];
+  
+  const IndexType & tileIndex = tile.GetIndex();
+  const typename Superclass::RegionType::SizeType & tileSize = tile.GetSize();
+  
+  IndexType rowIndex = tileIndex;
+  PointType rowStart;
+  
+  for( unsigned long z=0; z<tileSize[2]; ++z )
+  {
+    rowIndex[2] = tileIndex[2] + z;
+    
+    for( unsigned long y=0; y<tileSize[1]; ++y )
+    {
+      rowIndex[1] = tileIndex[1] + y;
+      
+      image->TransformIndexToPhysicalPoint( rowIndex, rowStart );
+      PixelType *row = image->GetBufferPointer() + image->ComputeOffset( rowIndex );
+      
+      PointType point = rowStart;
+      
+      for( unsigned long x=0; x<tileSize[0]; ++x )
+      {
+        point[0] = rowStart[0] + x * rowSpacing;
+        
+        const double u = point[circleXDir] - center[circleXDir];
+        const double v = point[circleYDir] - center[circleYDir];
+        const double w = point[this->m_Direction] - center[this->m_Direction];
+        
+        double squaredDistance;
+        
+        bool insideArc = fullCircle;
+        
+        if( !insideArc )
+        {
+          double angle = vcl_atan2( v, u ) - arcStart;
+          angle -= 2.0 * vnl_math::pi * vcl_floor( angle / ( 2.0 * vnl_math::pi ) );
+          insideArc = ( angle <= arcInterval );
+        }
+        
+        if( insideArc )
+        {
+          const double radial = vcl_sqrt( u * u + v * v ) - this->m_Radius;
+          squaredDistance = radial * radial + w * w;
+        }
+        else
+        {
+          squaredDistance = vnl_math_min( point.SquaredEuclideanDistanceTo( arcEnds[0] ),
+            point.SquaredEuclideanDistanceTo( arcEnds[1] ) );
+        }
+        
+        if( squaredDistance < squaredSupportRadius )
+        {
+          double value = amplitude * vcl_exp( exponentFactor * squaredDistance );
+          
+          if( this->m_Accumulation == Superclass::SumAccumulation )
+            value += row[x];
+            
+          row[x] = (PixelType)value;
+        }
+      }
+    }
+  }
+}
+
 } // end namespace ivan
 
 #endif // __CenterlineBasedGaussianTubeGenerator_h_
@@ -0,0 +1,186 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanConvolvedBarProfileTable.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tabulated radial profile of a disk convolved with a Gaussian
+// Date: 2012/11/05
+
+
+#ifndef __ivanConvolvedBarProfileTable_h_
+#define __ivanConvolvedBarProfileTable_h_
+
+#include "vnl/vnl_math.h"
+
+#include <vector>
+#include <cmath>
+
+namespace ivan
+{
+
+/** \class ConvolvedBarProfileTable
+ *  \brief Radial profile of a disk of unit height convolved with an isotropic Gaussian.
+ *
+ * The convolution of a disk of radius R with a 2-D Gaussian of standard deviation sigma only
+ * depends on the distance r to the center of the disk, and equals
+ *
+ *   f(r) = \int_0^{R/sigma} s exp( -( r/sigma - s )^2 / 2 ) I0e( s r/sigma ) ds
+ *
+ * where I0e(x) = exp(-x) I0(x) is the exponentially scaled modified Bessel function of order 
+ * zero. The profile is tabulated once by Build() every SamplingStep times sigma, and 
+ * Evaluate() interpolates the table linearly. It is also the profile of an infinite cylinder 
+ * convolved with a 3-D Gaussian, so bar tubes blurred by a Gaussian point spread function can 
+ * be drawn directly, without filtering the whole volume.
+ */
+class ConvolvedBarProfileTable
+{
+public:
+
+  ConvolvedBarProfileTable() :
+    m_SamplingStep( 0.01 ),
+    m_Radius( 0.0 ),
+    m_Sigma( 0.0 ),
+    m_InverseStep( 0.0 )
+    {}
+  ~ConvolvedBarProfileTable() {};
+  
+  /** Set/Get the distance between the samples of the table, relative to sigma. Default is 
+    * 0.01. */
+  void SetSamplingStep( double step )
+    { m_SamplingStep = step; }
+  double GetSamplingStep() const
+    { return m_SamplingStep; }
+    
+  double GetRadius() const
+    { return m_Radius; }
+  double GetSigma() const
+    { return m_Sigma; }
+    
+  unsigned int GetNumberOfSamples() const
+    { return m_Samples.size(); }
+  
+  /** Tabulate the profile for the given radius and sigma, up to the distance where it falls 
+    * below 1e-8. A non positive sigma gives the profile of the disk itself. */
+  void Build( double radius, double sigma )
+    {
+      m_Radius = radius;
+      m_Sigma = sigma;
+      m_Samples.clear();
+      
+      if( sigma <= 0.0 || radius <= 0.0 )
+        return;
+        
+      const double radiusOverSigma = radius / sigma;
+      
+      // exp(-6.1^2/2) is below 1e-8
+      const unsigned int numberOfSamples = 
+        (unsigned int)std::ceil( ( radiusOverSigma + 6.1 ) / m_SamplingStep ) + 1;
+      
+      m_Samples.resize( numberOfSamples + 1 );
+      for( unsigned int i=0; i<numberOfSamples; ++i )
+        m_Samples[i] = ComputeProfile( i * m_SamplingStep, radiusOverSigma );
+      
+      // Trailing zero, so that Evaluate() interpolates without checking the last sample
+      m_Samples[numberOfSamples] = 0.0;
+      
+      m_InverseStep = 1.0 / ( m_SamplingStep * sigma );
+    }
+    
+  /** Value of the profile at the given distance from the center, between 0 and 1. */
+  double Evaluate( double distance ) const
+    {
+      if( m_Samples.empty() )
+        return distance <= m_Radius ? 1.0 : 0.0;
+        
+      const double position = distance * m_InverseStep;
+      const unsigned int sample = (unsigned int)position;
+      
+      if( sample + 1 >= m_Samples.size() )
+        return 0.0;
+        
+      const double weight = position - sample;
+      return ( 1.0 - weight ) * m_Samples[sample] + weight * m_Samples[sample+1];
+    }
+    
+  /** Compute the profile at the given distance, both relative to sigma, by Simpson 
+    * integration over the part of the disk where the integrand is not negligible. */
+  static double ComputeProfile( double distanceOverSigma, double radiusOverSigma )
+    {
+      const double first = vnl_math_max( 0.0, distanceOverSigma - 8.0 );
+      const double last = vnl_math_min( radiusOverSigma, distanceOverSigma + 8.0 );
+      
+      if( last <= first )
+        return 0.0;
+        
+      unsigned int numberOfIntervals = (unsigned int)std::ceil( ( last - first ) / 0.05 );
+      numberOfIntervals = vnl_math_max( 16u, numberOfIntervals + numberOfIntervals % 2 );
+      
+      const double step = ( last - first ) / numberOfIntervals;
+      
+      double sum = 0.0;
+      for( unsigned int i=0; i<=numberOfIntervals; ++i )
+      {
+        const double s = first + i * step;
+        const double d = distanceOverSigma - s;
+        const double value = s * std::exp( -0.5 * d * d ) * ScaledBesselI0( s * distanceOverSigma );
+        
+        if( i == 0 || i == numberOfIntervals )
+          sum += value;
+        else
+          sum += ( i % 2 ) ? 4.0 * value : 2.0 * value;
+      }
+      
+      return vnl_math_min( 1.0, sum * step / 3.0 );
+    }
+  
+  /** Exponentially scaled modified Bessel function of order zero, exp(-x) I0(x), for x >= 0.
+    * Polynomial approximations 9.8.1 and 9.8.2 of Abramowitz and Stegun. */
+  static double ScaledBesselI0( double x )
+    {
+      if( x < 3.75 )
+      {
+        const double t = ( x / 3.75 ) * ( x / 3.75 );
+        return std::exp( -x ) * ( 1.0 + t * ( 3.5156229 + t * ( 3.0899424 + t * ( 1.2067492 + 
+          t * ( 0.2659732 + t * ( 0.0360768 + t * 0.0045813 ) ) ) ) ) );
+      }
+      
+      const double t = 3.75 / x;
+      return ( 0.39894228 + t * ( 0.01328592 + t * ( 0.00225319 + t * ( -0.00157565 + 
+        t * ( 0.00916281 + t * ( -0.02057706 + t * ( 0.02635537 + t * ( -0.01647633 + 
+        t * 0.00392377 ) ) ) ) ) ) ) ) / std::sqrt( x );
+    }
+
+protected:
+
+  double                m_SamplingStep;
+  double                m_Radius;
+  double                m_Sigma;
+  double                m_InverseStep;
+  
+  std::vector<double>   m_Samples;
+};
+
+} // end namespace ivan
+
+#endif // __ivanConvolvedBarProfileTable_h_
@@ -40,6 +40,7 @@ SUCH DAMAGE.
 #include "itkImageRegionIterator.h"
 #include "itkNeighborhoodIterator.h"
 #include "itkImageFileWriter.h"
+#include "itkVectorContainer.h"
 
 
 namespace ivan
@@ -56,6 +57,9 @@ public:
   typedef typename ImageType::Pointer    ImagePointer;
   typedef typename ImageType::PointType  PointType;
   typedef typename ImageType::IndexType  IndexType;
+  
+  typedef itk::VectorContainer<unsigned int,PointType>  PointContainerType;
+  typedef typename PointContainerType::Pointer          PointContainerPointer;
 
 public:
 
@@ -73,6 +77,11 @@ public:
     { return m_RadiusOfCurvature; }  
   
   ImagePointer Create();
+  
+  /** Get the centers of the Gaussian balls drawn by the last Create(), one per slice. This is 
+    * the ground truth centerline of the tube. */
+  const PointContainerType * GetCenterline() const
+    { return m_Centerline; }
 
 protected:
 
@@ -87,6 +96,8 @@ protected:
   
   /** Alternatively the radius of curvature can be provided directly. */
   double   m_RadiusOfCurvature;
+  
+  PointContainerPointer   m_Centerline;
 };
 
 
@@ -209,6 +220,9 @@ CurvedCircularGaussianTubeGenerator<TPixel>::Create()
   double currentXOffset;
   
   PointType centerPoint;
+  
+  this->m_Centerline = PointContainerType::New();
+  this->m_Centerline->Reserve( size[2] );
     
   for( unsigned long z=0; z < size[2]; ++z )
   {
@@ -227,6 +241,7 @@ CurvedCircularGaussianTubeGenerator<TPixel>::Create()
     centerPoint[2] = z * spacing[2];
       
     this->CopyGaussianBall( tubeImage, ballImage, centerPoint );
+    this->m_Centerline->SetElement( z, centerPoint );
     
     /*outputIt = IteratorType( tubeImage, region );
     
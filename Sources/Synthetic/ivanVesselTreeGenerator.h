@@ -0,0 +1,782 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTreeGenerator.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: creates a random bifurcating vessel tree image and its ground-truth graph
+// Date: 2012/11/05
+
+
+#ifndef __ivanVesselTreeGenerator_h_
+#define __ivanVesselTreeGenerator_h_
+
+#include "ivanImageRegionTileScheduler.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
+#include "itkThreadSafeMersenneTwisterRandomVariateGenerator.h"
+
+#include "vnl/vnl_math.h"
+#include "vnl/vnl_vector_fixed.h"
+#include "vnl/vnl_cross.h"
+
+#include <deque>
+#include <vector>
+#include <cmath>
+
+namespace ivan
+{
+
+/** \class VesselTreeGenerator
+ *  \brief Creates a random bifurcating vessel tree and its ground-truth graph.
+ *
+ * The tree grows from a root branch starting at the origin along the Z axis. Every branch 
+ * ends in a bifurcation into two child branches whose radii follow Murray's law, 
+ * r^g = r1^g + r2^g with exponent g (3 by default), the ratio r2/r1 being drawn uniformly 
+ * between MinimumAsymmetry and 1. The branching angles are the ones that minimize the 
+ * pumping and volume cost for these radii,
+ *
+ *   cos( theta1 ) = ( r^4 + r1^4 - r2^4 ) / ( 2 r^2 r1^2 ),
+ *
+ * so the thinner child deviates more, and the bifurcation plane is rotated randomly around 
+ * the parent branch. Branches have length LengthToRadiusRatio times their radius, and are 
+ * bent sideways by a random sinusoidal displacement of amplitude Tortuosity times their 
+ * length that vanishes at their ends. Growth stops after Depth generations, when radii drop 
+ * under MinimumRadius, or when MaximumNumberOfBranches are created, generation by generation.
+ *
+ * The image covers the tree plus a margin. Each centerline segment is drawn as a bar of the 
+ * interpolated radius around the segment (a capsule with conical side), so every segment 
+ * only affects the voxels of its bounding box. Segments are binned into tiles of the image 
+ * that the threads draw independently, and Gaussian noise can be added with a generator per 
+ * tile, so the image does not depend on the number of threads. Trees of 10^5 branches are 
+ * drawn in a few seconds on a workstation, limited by the size of the image.
+ *
+ * The graph returned by GetGraph() has one VesselBranchNode per branch, with sections every 
+ * SectionSpacing along its centerline, and one VesselBifurcationNode between each parent 
+ * and its two children. Node identifiers are given in breadth-first order, starting at 1.
+ * The graph and the image are created with the same random numbers for a given Seed.
+ *
+ * \sa CenterlineBasedBarTubeGenerator
+ */
+template <class TPixel>
+class VesselTreeGenerator
+{
+public:
+
+  typedef VesselTreeGenerator<TPixel>    Self;
+
+  typedef TPixel                         PixelType;
+  typedef itk::Image<PixelType,3>        ImageType;
+  typedef typename ImageType::Pointer    ImagePointer;
+  typedef typename ImageType::PointType  PointType;
+  typedef typename ImageType::IndexType  IndexType;
+  typedef typename ImageType::RegionType RegionType;
+  
+  typedef CircularVesselSection<3>                          SectionType;
+  typedef VesselCenterline<unsigned int,SectionType>        CenterlineType;
+  typedef VesselGraph<CenterlineType>                       GraphType;
+  typedef typename GraphType::Pointer                       GraphPointer;
+  typedef VesselBranchNode<CenterlineType>                  BranchNodeType;
+  typedef VesselBifurcationNode<CenterlineType>             BifurcationNodeType;
+  
+  typedef ImageRegionTileScheduler<3>                       TileSchedulerType;
+  
+  typedef itk::Statistics::ThreadSafeMersenneTwisterRandomVariateGenerator  RandomGeneratorType;
+  
+  typedef vnl_vector_fixed<double,3>     VectorType;
+  
+  /** Centerline segment drawn as a bar around it, with its bounding box. */
+  struct Segment
+  {
+    VectorType  Start;
+    VectorType  End;
+    double      StartRadius;
+    double      EndRadius;
+    VectorType  LowerBound;
+    VectorType  UpperBound;
+  };
+  
+  /** Branch waiting to be grown from the end of its parent. */
+  struct PendingBranch
+  {
+    VectorType     Start;
+    VectorType     Direction;
+    double         Radius;
+    unsigned int   Generation;
+    GraphNode     *Parent;
+  };
+  
+  typedef std::vector<Segment>                        SegmentContainerType;
+  typedef std::vector< std::vector<unsigned int> >    TileSegmentContainerType;
+
+public:
+
+  VesselTreeGenerator();
+  ~VesselTreeGenerator() {};
+  
+  /** Set/Get the number of generations of branches, the root being the first one. */
+  void SetDepth( unsigned int depth )
+    { m_Depth = depth; }
+  unsigned int GetDepth() const
+    { return m_Depth; }
+  
+  void SetRootRadius( double radius )
+    { m_RootRadius = radius; }
+  double GetRootRadius() const
+    { return m_RootRadius; }
+  
+  /** Branches are not grown under this radius. */
+  void SetMinimumRadius( double radius )
+    { m_MinimumRadius = radius; }
+  double GetMinimumRadius() const
+    { return m_MinimumRadius; }
+  
+  /** Set/Get the exponent of Murray's law. Default is 3. */
+  void SetMurrayExponent( double exponent )
+    { m_MurrayExponent = exponent; }
+  double GetMurrayExponent() const
+    { return m_MurrayExponent; }
+  
+  /** Set/Get the minimum ratio between the radii of the children. 1 gives symmetric trees. */
+  void SetMinimumAsymmetry( double asymmetry )
+    { m_MinimumAsymmetry = asymmetry; }
+  double GetMinimumAsymmetry() const
+    { return m_MinimumAsymmetry; }
+  
+  /** Set/Get the length of the branches relative to their radius. */
+  void SetLengthToRadiusRatio( double ratio )
+    { m_LengthToRadiusRatio = ratio; }
+  double GetLengthToRadiusRatio() const
+    { return m_LengthToRadiusRatio; }
+  
+  /** Set/Get the amplitude of the sideways displacement relative to the branch length. */
+  void SetTortuosity( double tortuosity )
+    { m_Tortuosity = tortuosity; }
+  double GetTortuosity() const
+    { return m_Tortuosity; }
+  
+  void SetMaximumNumberOfBranches( unsigned long numberOfBranches )
+    { m_MaximumNumberOfBranches = numberOfBranches; }
+  unsigned long GetMaximumNumberOfBranches() const
+    { return m_MaximumNumberOfBranches; }
+  
+  /** Set/Get the distance between the sections of the centerlines. */
+  void SetSectionSpacing( double spacing )
+    { m_SectionSpacing = spacing; }
+  double GetSectionSpacing() const
+    { return m_SectionSpacing; }
+  
+  void SetImageSpacing( double spacing )
+    { m_ImageSpacing = spacing; }
+  double GetImageSpacing() const
+    { return m_ImageSpacing; }
+  
+  /** Set/Get the distance between the tree and the image boundary. */
+  void SetMargin( double margin )
+    { m_Margin = margin; }
+  double GetMargin() const
+    { return m_Margin; }
+  
+  void SetMaxValue( double value )
+    { m_MaxValue = value; }
+  double GetMaxValue() const
+    { return m_MaxValue; }
+  
+  void SetBackgroundValue( double value )
+    { m_BackgroundValue = value; }
+  double GetBackgroundValue() const
+    { return m_BackgroundValue; }
+  
+  /** Set/Get the standard deviation of the additive Gaussian noise. Default is 0, no noise. */
+  void SetNoiseStandardDeviation( double sigma )
+    { m_NoiseStandardDeviation = sigma; }
+  double GetNoiseStandardDeviation() const
+    { return m_NoiseStandardDeviation; }
+  
+  void SetSeed( unsigned int seed )
+    { m_Seed = seed; }
+  unsigned int GetSeed() const
+    { return m_Seed; }
+  
+  /** Set/Get the number of threads used to draw the image. Default is the global default 
+    * of the MultiThreader. */
+  void SetNumberOfThreads( int numberOfThreads )
+    { m_NumberOfThreads = vnl_math_max( 1, vnl_math_min( numberOfThreads, ITK_MAX_THREADS ) ); }
+  int GetNumberOfThreads() const
+    { return m_NumberOfThreads; }
+  
+  /** Grow a new tree, and create its image. */
+  virtual ImagePointer Create();
+  
+  /** Grow a new tree without creating its image. */
+  void CreateGraph();
+  
+  /** Get the ground-truth graph of the last tree. */
+  GraphType * GetGraph() 
+    { return m_Graph; }
+  const GraphType * GetGraph() const 
+    { return m_Graph; }
+    
+  unsigned long GetNumberOfBranches() const
+    { return m_NumberOfBranches; }
+  unsigned long GetNumberOfSegments() const
+    { return m_Segments.size(); }
+  
+protected:
+
+  /** Create the branch of the given radius and length from the given start and direction,
+    * adding its segments. Return the end point and the direction at the end. */
+  typename BranchNodeType::Pointer CreateBranch( const VectorType & start, 
+    const VectorType & direction, double radius, VectorType & end, VectorType & endDirection );
+  
+  /** Create and allocate the image covering the segments. */
+  ImagePointer CreateEmptyImage();
+  
+  /** Bin the segments into the tiles of the image. */
+  void BinSegments();
+  
+  /** Draw the tiles taken from the scheduler until there are no more. */
+  void ThreadedDraw();
+  
+  /** Draw a single tile. */
+  void DrawTile( const RegionType & tile );
+  
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DrawThreaderCallback( void *arg );
+  
+  /** Get the tile containing the given index. */
+  unsigned long GetTileNumber( const IndexType & index ) const;
+  
+  static double SquaredDistanceToSegment( const VectorType & point, const Segment & segment, 
+    double & t );
+
+protected:
+
+  unsigned int    m_Depth;
+  double          m_RootRadius;
+  double          m_MinimumRadius;
+  double          m_MurrayExponent;
+  double          m_MinimumAsymmetry;
+  double          m_LengthToRadiusRatio;
+  double          m_Tortuosity;
+  unsigned long   m_MaximumNumberOfBranches;
+  double          m_SectionSpacing;
+  
+  double          m_ImageSpacing;
+  double          m_Margin;
+  double          m_MaxValue;
+  double          m_BackgroundValue;
+  double          m_NoiseStandardDeviation;
+  
+  unsigned int    m_Seed;
+  int             m_NumberOfThreads;
+  
+  GraphPointer    m_Graph;
+  unsigned long   m_NumberOfBranches;
+  
+  RandomGeneratorType::Pointer  m_RandomGenerator;
+  
+  SegmentContainerType          m_Segments;
+  
+  /** Image and tiles being drawn. */
+  ImageType                           *m_DrawImage;
+  typename TileSchedulerType::Pointer  m_TileScheduler;
+  unsigned long                        m_TileSize;
+  IndexType                            m_NumberOfTiles;
+  TileSegmentContainerType             m_TileSegments;
+};
+
+
+template <class TPixel>
+VesselTreeGenerator<TPixel>::VesselTreeGenerator() :
+  m_Depth( 5 ),
+  m_RootRadius( 4.0 ),
+  m_MinimumRadius( 0.5 ),
+  m_MurrayExponent( 3.0 ),
+  m_MinimumAsymmetry( 0.6 ),
+  m_LengthToRadiusRatio( 10.0 ),
+  m_Tortuosity( 0.05 ),
+  m_MaximumNumberOfBranches( itk::NumericTraits<unsigned long>::max() ),
+  m_SectionSpacing( 0.5 ),
+  m_ImageSpacing( 1.0 ),
+  m_Margin( 5.0 ),
+  m_MaxValue( 255.0 ),
+  m_BackgroundValue( 0.0 ),
+  m_NoiseStandardDeviation( 0.0 ),
+  m_Seed( 1 ),
+  m_NumberOfBranches( 0 ),
+  m_DrawImage( 0 ),
+  m_TileSize( 16 )
+{
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_NumberOfTiles.Fill( 0 );
+}
+
+
+template <class TPixel>
+typename VesselTreeGenerator<TPixel>::BranchNodeType::Pointer
+VesselTreeGenerator<TPixel>::CreateBranch( const VectorType & start, const VectorType & direction,
+  double radius, VectorType & end, VectorType & endDirection )
+{
+  const double length = m_LengthToRadiusRatio * radius;
+  
+  const unsigned int numberOfSegments = 
+    vnl_math_max( 1, (int)std::ceil( length / m_SectionSpacing ) );
+  
+  // Sideways displacement along a random direction perpendicular to the branch, with a 
+  // random second harmonic
+  VectorType reference( 1.0, 0.0, 0.0 );
+  
+  if( std::fabs( direction[0] ) > 0.9 )
+    reference = VectorType( 0.0, 1.0, 0.0 );
+  
+  VectorType u = vnl_cross_3d( direction, reference ).normalize();
+  VectorType v = vnl_cross_3d( direction, u );
+  
+  const double phase = m_RandomGenerator->GetUniformVariate( 0.0, 2.0 * vnl_math::pi );
+  const VectorType sideways = std::cos( phase ) * u + std::sin( phase ) * v;
+  const VectorType perpendicular = vnl_cross_3d( direction, sideways );
+  
+  const double amplitude = m_Tortuosity * length;
+  const double harmonic = m_RandomGenerator->GetUniformVariate( -0.5, 0.5 );
+  
+  typename CenterlineType::Pointer centerline = CenterlineType::New();
+  centerline->reserve( numberOfSegments + 1 );
+  
+  std::vector<VectorType> centers( numberOfSegments + 1 );
+  
+  for( unsigned int i=0; i<=numberOfSegments; ++i )
+  {
+    const double s = (double)i / numberOfSegments;
+    
+    centers[i] = start + ( s * length ) * direction + 
+      ( amplitude * std::sin( vnl_math::pi * s ) ) * sideways + 
+      ( amplitude * harmonic * std::sin( 2.0 * vnl_math::pi * s ) ) * perpendicular;
+  }
+  
+  double arclength = 0.0;
+  
+  for( unsigned int i=0; i<=numberOfSegments; ++i )
+  {
+    const VectorType & previous = centers[ i > 0 ? i-1 : 0 ];
+    const VectorType & next = centers[ i < numberOfSegments ? i+1 : numberOfSegments ];
+    
+    VectorType tangent = next - previous;
+    tangent.normalize();
+    
+    if( i > 0 )
+      arclength += ( centers[i] - centers[i-1] ).magnitude();
+    
+    typename SectionType::PointType center;
+    typename SectionType::VectorType normal;
+    
+    for( unsigned int dim=0; dim<3; ++dim )
+    {
+      center[dim] = centers[i][dim];
+      normal[dim] = tangent[dim];
+    }
+    
+    typename SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( radius );
+    section->SetScale( radius );
+    section->SetArclength( arclength );
+    
+    centerline->push_back( section );
+    
+    if( i == numberOfSegments )
+      endDirection = tangent;
+  }
+  
+  for( unsigned int i=0; i<numberOfSegments; ++i )
+  {
+    Segment segment;
+    segment.Start = centers[i];
+    segment.End = centers[i+1];
+    segment.StartRadius = radius;
+    segment.EndRadius = radius;
+    
+    for( unsigned int dim=0; dim<3; ++dim )
+    {
+      segment.LowerBound[dim] = vnl_math_min( segment.Start[dim], segment.End[dim] ) - radius;
+      segment.UpperBound[dim] = vnl_math_max( segment.Start[dim], segment.End[dim] ) + radius;
+    }
+    
+    m_Segments.push_back( segment );
+  }
+  
+  end = centers[numberOfSegments];
+  
+  typename BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+template <class TPixel>
+void
+VesselTreeGenerator<TPixel>::CreateGraph()
+{
+  m_RandomGenerator = RandomGeneratorType::New();
+  m_RandomGenerator->Initialize( m_Seed );
+  
+  m_Segments.clear();
+  m_Graph = GraphType::New();
+  m_NumberOfBranches = 0;
+  
+  VesselIdType nodeId = 1;
+  
+  std::deque<PendingBranch> pendingBranches;
+  
+  PendingBranch root;
+  root.Start.fill( 0.0 );
+  root.Direction = VectorType( 0.0, 0.0, 1.0 );
+  root.Radius = m_RootRadius;
+  root.Generation = 1;
+  root.Parent = 0;
+  
+  if( m_Depth > 0 && m_MaximumNumberOfBranches > 0 )
+    pendingBranches.push_back( root );
+  
+  // Breadth-first, so a limit on the number of branches truncates the last generation
+  while( !pendingBranches.empty() )
+  {
+    const PendingBranch pending = pendingBranches.front();
+    pendingBranches.pop_front();
+    
+    VectorType end, direction;
+    
+    typename BranchNodeType::Pointer branch = 
+      this->CreateBranch( pending.Start, pending.Direction, pending.Radius, end, direction );
+    branch->SetNodeId( nodeId++ );
+    ++m_NumberOfBranches;
+    
+    if( pending.Parent )
+      pending.Parent->AddChild( branch.GetPointer() );
+    else
+      m_Graph->SetRootNode( branch.GetPointer() );
+    
+    if( pending.Generation >= m_Depth || 
+        m_NumberOfBranches + pendingBranches.size() + 2 > m_MaximumNumberOfBranches )
+      continue;
+    
+    // Murray's law with a random ratio between the children
+    const double asymmetry = m_RandomGenerator->GetUniformVariate( m_MinimumAsymmetry, 1.0 );
+    const double radius1 = pending.Radius / 
+      std::pow( 1.0 + std::pow( asymmetry, m_MurrayExponent ), 1.0 / m_MurrayExponent );
+    const double radius2 = asymmetry * radius1;
+    
+    if( radius2 < m_MinimumRadius )
+      continue;
+    
+    const double r04 = std::pow( pending.Radius, 4.0 );
+    const double r14 = std::pow( radius1, 4.0 );
+    const double r24 = std::pow( radius2, 4.0 );
+    
+    const double cosAngle1 = vnl_math_max( -1.0, vnl_math_min( 1.0, 
+      ( r04 + r14 - r24 ) / ( 2.0 * pending.Radius * pending.Radius * radius1 * radius1 ) ) );
+    const double cosAngle2 = vnl_math_max( -1.0, vnl_math_min( 1.0, 
+      ( r04 + r24 - r14 ) / ( 2.0 * pending.Radius * pending.Radius * radius2 * radius2 ) ) );
+    
+    // Random bifurcation plane containing the parent direction
+    VectorType reference( 1.0, 0.0, 0.0 );
+    
+    if( std::fabs( direction[0] ) > 0.9 )
+      reference = VectorType( 0.0, 1.0, 0.0 );
+    
+    VectorType u = vnl_cross_3d( direction, reference ).normalize();
+    VectorType v = vnl_cross_3d( direction, u );
+    
+    const double azimuth = m_RandomGenerator->GetUniformVariate( 0.0, 2.0 * vnl_math::pi );
+    const VectorType w = std::cos( azimuth ) * u + std::sin( azimuth ) * v;
+    
+    typename BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+    bifurcation->SetNodeId( nodeId++ );
+    branch->AddChild( bifurcation.GetPointer() );
+    
+    PendingBranch child;
+    child.Start = end;
+    child.Generation = pending.Generation + 1;
+    child.Parent = bifurcation.GetPointer();
+    
+    child.Radius = radius1;
+    child.Direction = cosAngle1 * direction + std::sqrt( 1.0 - cosAngle1 * cosAngle1 ) * w;
+    child.Direction.normalize();
+    pendingBranches.push_back( child );
+    
+    child.Radius = radius2;
+    child.Direction = cosAngle2 * direction - std::sqrt( 1.0 - cosAngle2 * cosAngle2 ) * w;
+    child.Direction.normalize();
+    pendingBranches.push_back( child );
+  }
+}
+
+
+template <class TPixel>
+typename VesselTreeGenerator<TPixel>::ImagePointer
+VesselTreeGenerator<TPixel>::CreateEmptyImage()
+{
+  VectorType lowerBound, upperBound;
+  lowerBound.fill( 0.0 );
+  upperBound.fill( 0.0 );
+  
+  for( unsigned int i=0; i<m_Segments.size(); ++i )
+  {
+    for( unsigned int dim=0; dim<3; ++dim )
+    {
+      lowerBound[dim] = vnl_math_min( lowerBound[dim], m_Segments[i].LowerBound[dim] );
+      upperBound[dim] = vnl_math_max( upperBound[dim], m_Segments[i].UpperBound[dim] );
+    }
+  }
+  
+  ImagePointer image = ImageType::New();
+  
+  typename ImageType::SpacingType spacing;
+  spacing.Fill( m_ImageSpacing );
+  image->SetSpacing( spacing );
+  
+  typename ImageType::PointType origin;
+  typename ImageType::SizeType size;
+  
+  for( unsigned int dim=0; dim<3; ++dim )
+  {
+    origin[dim] = m_ImageSpacing * std::floor( ( lowerBound[dim] - m_Margin ) / m_ImageSpacing );
+    size[dim] = 1 + (unsigned long)std::ceil( ( upperBound[dim] + m_Margin - origin[dim] ) / m_ImageSpacing );
+  }
+  
+  image->SetOrigin( origin );
+  
+  IndexType index;
+  index.Fill( 0 );
+  
+  RegionType region;
+  region.SetSize( size );
+  region.SetIndex( index );
+  
+  image->SetRegions( region );
+  image->Allocate();
+    
+  return image;
+}
+
+
+template <class TPixel>
+unsigned long
+VesselTreeGenerator<TPixel>::GetTileNumber( const IndexType & index ) const
+{
+  return ( index[2] / m_TileSize * m_NumberOfTiles[1] + index[1] / m_TileSize ) * 
+    m_NumberOfTiles[0] + index[0] / m_TileSize;
+}
+
+
+template <class TPixel>
+void
+VesselTreeGenerator<TPixel>::BinSegments()
+{
+  const typename ImageType::SizeType & size = m_DrawImage->GetBufferedRegion().GetSize();
+  
+  for( unsigned int dim=0; dim<3; ++dim )
+    m_NumberOfTiles[dim] = ( size[dim] + m_TileSize - 1 ) / m_TileSize;
+  
+  m_TileSegments.clear();
+  m_TileSegments.resize( m_NumberOfTiles[0] * m_NumberOfTiles[1] * m_NumberOfTiles[2] );
+  
+  const PointType & origin = m_DrawImage->GetOrigin();
+  
+  for( unsigned int i=0; i<m_Segments.size(); ++i )
+  {
+    IndexType first, last;
+    
+    for( unsigned int dim=0; dim<3; ++dim )
+    {
+      const long lower = (long)std::floor( ( m_Segments[i].LowerBound[dim] - origin[dim] ) / m_ImageSpacing );
+      const long upper = (long)std::ceil( ( m_Segments[i].UpperBound[dim] - origin[dim] ) / m_ImageSpacing );
+      
+      first[dim] = vnl_math_max( 0L, lower ) / m_TileSize;
+      last[dim] = vnl_math_min( (long)size[dim] - 1, upper ) / m_TileSize;
+    }
+    
+    IndexType tile;
+    
+    for( tile[2] = first[2]; tile[2] <= last[2]; ++tile[2] )
+      for( tile[1] = first[1]; tile[1] <= last[1]; ++tile[1] )
+        for( tile[0] = first[0]; tile[0] <= last[0]; ++tile[0] )
+          m_TileSegments[ ( tile[2] * m_NumberOfTiles[1] + tile[1] ) * m_NumberOfTiles[0] + tile[0] ].push_back( i );
+  }
+}
+
+
+template <class TPixel>
+double
+VesselTreeGenerator<TPixel>::SquaredDistanceToSegment( const VectorType & point, 
+  const Segment & segment, double & t )
+{
+  const VectorType axis = segment.End - segment.Start;
+  const double squaredLength = axis.squared_magnitude();
+  
+  t = ( squaredLength > 0.0 ) ? dot_product( point - segment.Start, axis ) / squaredLength : 0.0;
+  t = vnl_math_max( 0.0, vnl_math_min( 1.0, t ) );
+  
+  return ( point - ( segment.Start + t * axis ) ).squared_magnitude();
+}
+
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE
+VesselTreeGenerator<TPixel>::DrawThreaderCallback( void *arg )
+{
+  Self *generator = (Self *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  generator->ThreadedDraw();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TPixel>
+void
+VesselTreeGenerator<TPixel>::ThreadedDraw()
+{
+  RegionType tile;
+  
+  while( m_TileScheduler->GetNextTile( tile ) )
+    this->DrawTile( tile );
+}
+
+
+template <class TPixel>
+void
+VesselTreeGenerator<TPixel>::DrawTile( const RegionType & tile )
+{
+  typedef itk::ImageRegionIteratorWithIndex<ImageType> IteratorType;
+  
+  const unsigned long tileNumber = this->GetTileNumber( tile.GetIndex() );
+  const std::vector<unsigned int> & segments = m_TileSegments[tileNumber];
+  
+  // The noise of each tile only depends on the seed and the tile
+  RandomGeneratorType::Pointer noiseGenerator;
+  
+  if( m_NoiseStandardDeviation > 0.0 )
+  {
+    noiseGenerator = RandomGeneratorType::New();
+    noiseGenerator->Initialize( m_Seed + 1 + tileNumber );
+  }
+  
+  const double minimum = itk::NumericTraits<PixelType>::NonpositiveMin();
+  const double maximum = itk::NumericTraits<PixelType>::max();
+  const double variance = m_NoiseStandardDeviation * m_NoiseStandardDeviation;
+  
+  IteratorType outputIt( m_DrawImage, tile );
+  
+  PointType  point;
+  VectorType position;
+  double     t;
+  
+  for( outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt )
+  {
+    m_DrawImage->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
+    
+    for( unsigned int dim=0; dim<3; ++dim )
+      position[dim] = point[dim];
+    
+    double value = m_BackgroundValue;
+    
+    for( unsigned int i=0; i<segments.size(); ++i )
+    {
+      const Segment & segment = m_Segments[segments[i]];
+      
+      if( position[0] < segment.LowerBound[0] || position[0] > segment.UpperBound[0] ||
+          position[1] < segment.LowerBound[1] || position[1] > segment.UpperBound[1] ||
+          position[2] < segment.LowerBound[2] || position[2] > segment.UpperBound[2] )
+        continue;
+      
+      const double squaredDistance = SquaredDistanceToSegment( position, segment, t );
+      const double radius = segment.StartRadius + t * ( segment.EndRadius - segment.StartRadius );
+      
+      if( squaredDistance <= radius * radius )
+      {
+        value = m_MaxValue;
+        break;
+      }
+    }
+    
+    if( noiseGenerator.IsNotNull() )
+      value = noiseGenerator->GetNormalVariate( value, variance );
+    
+    outputIt.Set( static_cast<PixelType>( vnl_math_max( minimum, vnl_math_min( maximum, value ) ) ) );
+  }
+}
+
+
+template <class TPixel>
+typename VesselTreeGenerator<TPixel>::ImagePointer
+VesselTreeGenerator<TPixel>::Create()
+{
+  this->CreateGraph();
+  
+  ImagePointer image = this->CreateEmptyImage();
+  
+  m_DrawImage = image;
+  this->BinSegments();
+  
+  if( m_TileScheduler.IsNull() )
+    m_TileScheduler = TileSchedulerType::New();
+  
+  m_TileScheduler->SetRegion( image->GetBufferedRegion() );
+  m_TileScheduler->SetTileSize( m_TileSize );
+  m_TileScheduler->Initialize();
+  
+  const int numberOfThreads = 
+    vnl_math_min( m_NumberOfThreads, (int)m_TileScheduler->GetNumberOfTiles() );
+  
+  if( numberOfThreads > 1 )
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    threader->SetSingleMethod( this->DrawThreaderCallback, this );
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    this->ThreadedDraw();
+  }
+  
+  m_DrawImage = 0;
+  m_TileSegments.clear();
+  
+  return image;
+}
+
+} // end namespace ivan
+
+#endif // __ivanVesselTreeGenerator_h_
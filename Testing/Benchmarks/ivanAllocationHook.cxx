@@ -0,0 +1,284 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAllocationHook.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: counters of the heap allocations of a benchmark executable
+// Date: 2012/11/05
+//
+// Replaces the global operator new and delete of the executable it is linked in. Each block 
+// is allocated with malloc() with a header that keeps its size, so that deletions can be 
+// counted in bytes. Counters are updated with atomic operations, so any thread can allocate.
+// This is meant for the benchmarks only: the extra header changes the memory footprint 
+// slightly and the atomic operations serialize heavily allocating threads.
+
+#include "ivanAllocationHook.h"
+
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+
+#if defined( _WIN32 )
+# include <windows.h>
+# include <psapi.h>
+# include <intrin.h>
+# pragma comment( lib, "psapi.lib" )
+#else
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+#if __cplusplus >= 201103L
+# define IVAN_NEW_THROW_SPEC
+# define IVAN_NO_THROW_SPEC noexcept
+#else
+# define IVAN_NEW_THROW_SPEC throw( std::bad_alloc )
+# define IVAN_NO_THROW_SPEC throw()
+#endif
+
+
+namespace
+{
+
+/** Size of the header before each block, which keeps the alignment of malloc(). */
+const std::size_t HeaderSize = 16;
+
+volatile long long NumberOfAllocations = 0;
+volatile long long NumberOfDeallocations = 0;
+volatile long long AllocatedBytes = 0;
+volatile long long LiveBytes = 0;
+volatile long long PeakLiveBytes = 0;
+
+
+inline long long AtomicAdd( volatile long long *value, long long increment )
+{
+#if defined( _WIN32 )
+  return _InterlockedExchangeAdd64( value, increment ) + increment;
+#else
+  return __sync_add_and_fetch( value, increment );
+#endif
+}
+
+
+inline bool AtomicCompareAndSwap( volatile long long *value, long long expected, long long desired )
+{
+#if defined( _WIN32 )
+  return _InterlockedCompareExchange64( value, desired, expected ) == expected;
+#else
+  return __sync_bool_compare_and_swap( value, expected, desired );
+#endif
+}
+
+
+inline long long AtomicLoad( volatile long long *value )
+{
+  return AtomicAdd( value, 0 );
+}
+
+
+void * Allocate( std::size_t size )
+{
+  char *block = static_cast<char*>( std::malloc( size + HeaderSize ) );
+  
+  if( !block )
+    return 0;
+  
+  *reinterpret_cast<std::size_t*>( block ) = size;
+  
+  AtomicAdd( &NumberOfAllocations, 1 );
+  AtomicAdd( &AllocatedBytes, size );
+  
+  const long long liveBytes = AtomicAdd( &LiveBytes, size );
+  long long peakLiveBytes = AtomicLoad( &PeakLiveBytes );
+  
+  while( liveBytes > peakLiveBytes && 
+         !AtomicCompareAndSwap( &PeakLiveBytes, peakLiveBytes, liveBytes ) )
+    peakLiveBytes = AtomicLoad( &PeakLiveBytes );
+  
+  return block + HeaderSize;
+}
+
+
+void * AllocateOrThrow( std::size_t size )
+{
+  void *pointer = Allocate( size );
+  
+  while( !pointer )
+  {
+    std::new_handler handler = std::set_new_handler( 0 );
+    std::set_new_handler( handler );
+    
+    if( !handler )
+      throw std::bad_alloc();
+    
+    handler();
+    pointer = Allocate( size );
+  }
+  
+  return pointer;
+}
+
+
+void Deallocate( void *pointer )
+{
+  if( !pointer )
+    return;
+  
+  char *block = static_cast<char*>( pointer ) - HeaderSize;
+  const long long size = static_cast<long long>( *reinterpret_cast<std::size_t*>( block ) );
+  
+  AtomicAdd( &NumberOfDeallocations, 1 );
+  AtomicAdd( &LiveBytes, -size );
+  
+  std::free( block );
+}
+
+} // end anonymous namespace
+
+
+void * operator new( std::size_t size ) IVAN_NEW_THROW_SPEC
+{
+  return AllocateOrThrow( size );
+}
+
+
+void * operator new[]( std::size_t size ) IVAN_NEW_THROW_SPEC
+{
+  return AllocateOrThrow( size );
+}
+
+
+void * operator new( std::size_t size, const std::nothrow_t & ) IVAN_NO_THROW_SPEC
+{
+  return Allocate( size );
+}
+
+
+void * operator new[]( std::size_t size, const std::nothrow_t & ) IVAN_NO_THROW_SPEC
+{
+  return Allocate( size );
+}
+
+
+void operator delete( void *pointer ) IVAN_NO_THROW_SPEC
+{
+  Deallocate( pointer );
+}
+
+
+void operator delete[]( void *pointer ) IVAN_NO_THROW_SPEC
+{
+  Deallocate( pointer );
+}
+
+
+void operator delete( void *pointer, const std::nothrow_t & ) IVAN_NO_THROW_SPEC
+{
+  Deallocate( pointer );
+}
+
+
+void operator delete[]( void *pointer, const std::nothrow_t & ) IVAN_NO_THROW_SPEC
+{
+  Deallocate( pointer );
+}
+
+
+namespace ivan
+{
+
+AllocationCounters GetAllocationCounters()
+{
+  AllocationCounters counters;
+  counters.NumberOfAllocations = AtomicLoad( &NumberOfAllocations );
+  counters.NumberOfDeallocations = AtomicLoad( &NumberOfDeallocations );
+  counters.AllocatedBytes = AtomicLoad( &AllocatedBytes );
+  counters.LiveBytes = AtomicLoad( &LiveBytes );
+  counters.PeakLiveBytes = AtomicLoad( &PeakLiveBytes );
+  
+  return counters;
+}
+
+
+void ResetAllocationCounters()
+{
+  // Not atomic as a whole, so counts of other threads may be split around the reset
+  AtomicAdd( &NumberOfAllocations, -AtomicLoad( &NumberOfAllocations ) );
+  AtomicAdd( &NumberOfDeallocations, -AtomicLoad( &NumberOfDeallocations ) );
+  AtomicAdd( &AllocatedBytes, -AtomicLoad( &AllocatedBytes ) );
+  
+  long long peakLiveBytes = AtomicLoad( &PeakLiveBytes );
+  
+  while( !AtomicCompareAndSwap( &PeakLiveBytes, peakLiveBytes, AtomicLoad( &LiveBytes ) ) )
+    peakLiveBytes = AtomicLoad( &PeakLiveBytes );
+}
+
+
+unsigned long long GetPeakResidentSetSize()
+{
+#if defined( _WIN32 )
+  PROCESS_MEMORY_COUNTERS counters;
+  if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    return counters.PeakWorkingSetSize;
+  return 0;
+#else
+  struct rusage usage;
+  if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+    return 0;
+# if defined( __APPLE__ )
+  return usage.ru_maxrss; // in bytes
+# else
+  return 1024ULL * usage.ru_maxrss; // in kilobytes
+# endif
+#endif
+}
+
+
+unsigned long long GetResidentSetSize()
+{
+#if defined( _WIN32 )
+  PROCESS_MEMORY_COUNTERS counters;
+  if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    return counters.WorkingSetSize;
+  return 0;
+#elif defined( __linux__ )
+  unsigned long long size = 0, resident = 0;
+  
+  FILE *file = std::fopen( "/proc/self/statm", "r" );
+  
+  if( !file )
+    return 0;
+  
+  if( std::fscanf( file, "%llu %llu", &size, &resident ) != 2 )
+    resident = 0;
+  
+  std::fclose( file );
+  
+  return resident * sysconf( _SC_PAGESIZE );
+#else
+  return 0;
+#endif
+}
+
+} // end namespace ivan
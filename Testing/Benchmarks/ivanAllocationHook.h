@@ -0,0 +1,65 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAllocationHook.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: counters of the heap allocations of a benchmark executable
+// Date: 2012/11/05
+
+#ifndef __ivanAllocationHook_h
+#define __ivanAllocationHook_h
+
+namespace ivan
+{
+
+/** Heap allocation counters kept by the replacement global operator new and delete of 
+  * ivanAllocationHook.cxx, which must be linked in the executable. Allocations and bytes are
+  * counted since the last call to ResetAllocationCounters(). LiveBytes are the bytes 
+  * allocated and not released yet, since the start of the program, and PeakLiveBytes is the 
+  * maximum of LiveBytes since the last reset. Only allocations through operator new are 
+  * seen, not those made with malloc(). */
+struct AllocationCounters
+{
+  unsigned long long   NumberOfAllocations;
+  unsigned long long   NumberOfDeallocations;
+  unsigned long long   AllocatedBytes;
+  long long            LiveBytes;
+  long long            PeakLiveBytes;
+};
+
+/** Get the current values of the counters. Can be called from any thread. */
+AllocationCounters GetAllocationCounters();
+
+/** Set the counts to zero and the peak to the current live bytes. */
+void ResetAllocationCounters();
+
+/** Get the peak resident set size of the process in bytes, or zero where it is not known. */
+unsigned long long GetPeakResidentSetSize();
+
+/** Get the current resident set size of the process in bytes, or zero where it is not known. */
+unsigned long long GetResidentSetSize();
+
+} // end namespace ivan
+
+#endif
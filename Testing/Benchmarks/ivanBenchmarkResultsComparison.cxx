@@ -0,0 +1,226 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBenchmarkResultsComparison.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares benchmark results with a baseline and fails on throughput regressions
+// Date: 2012/11/05
+//
+// Compares the results of a benchmark run with a stored baseline. Results are matched by the 
+// given key fields, and a result regresses if its metric is worse than the baseline by more 
+// than the relative tolerance. The metric is a throughput by default, so lower values are 
+// worse, unless LowerIsBetter is given (e.g. for times). Results missing from the current run 
+// also fail the comparison, while new results are only reported. Returns EXIT_FAILURE if 
+// anything failed.
+//
+// The JSON files are the ones written by the benchmarks, with one result object per line.
+//
+// Usage: CompareBenchmarkResults Baseline.json Current.json Metric KeyField1[,KeyField2...] 
+//        [Tolerance=0.1] [LowerIsBetter]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+typedef std::map<std::string,std::string>   FieldMapType;
+typedef std::map<std::string,double>        ResultMapType;
+
+
+/** Parse the "name": value pairs of a line. String values are stored without the quotes. */
+FieldMapType ParseFields( const std::string & line )
+{
+  FieldMapType fields;
+  std::string::size_type pos = 0;
+  
+  while( ( pos = line.find( '"', pos ) ) != std::string::npos )
+  {
+    const std::string::size_type nameEnd = line.find( '"', pos + 1 );
+    
+    if( nameEnd == std::string::npos )
+      break;
+      
+    const std::string name = line.substr( pos + 1, nameEnd - pos - 1 );
+    
+    pos = line.find_first_not_of( " \t", nameEnd + 1 );
+    
+    if( pos == std::string::npos || line[pos] != ':' )
+    {
+      pos = nameEnd + 1;
+      continue;
+    }
+    
+    pos = line.find_first_not_of( " \t", pos + 1 );
+    
+    if( pos == std::string::npos )
+      break;
+      
+    std::string::size_type valueEnd;
+    
+    if( line[pos] == '"' )
+    {
+      valueEnd = line.find( '"', pos + 1 );
+      
+      if( valueEnd == std::string::npos )
+        break;
+        
+      fields[name] = line.substr( pos + 1, valueEnd - pos - 1 );
+      pos = valueEnd + 1;
+    }
+    else
+    {
+      valueEnd = line.find_first_of( ",} \t", pos );
+      fields[name] = line.substr( pos, valueEnd == std::string::npos ? std::string::npos : valueEnd - pos );
+      pos = valueEnd;
+    }
+  }
+  
+  return fields;
+}
+
+
+/** Read the metric of every result that has all the key fields, indexed by the key. */
+bool ReadResults( const char *fileName, const std::string & metric, 
+  const std::vector<std::string> & keyFields, ResultMapType & results )
+{
+  std::ifstream filein( fileName );
+  
+  if( !filein.is_open() )
+    return false;
+  
+  std::string line;
+  
+  while( std::getline( filein, line ) )
+  {
+    FieldMapType fields = ParseFields( line );
+    
+    if( fields.find( metric ) == fields.end() )
+      continue;
+    
+    std::string key;
+    bool hasKey = true;
+    
+    for( unsigned int i=0; i<keyFields.size() && hasKey; ++i )
+    {
+      FieldMapType::const_iterator it = fields.find( keyFields[i] );
+      
+      if( it == fields.end() )
+        hasKey = false;
+      else
+        key += ( i > 0 ? ", " : "" ) + it->second;
+    }
+    
+    if( hasKey )
+      results[key] = atof( fields[metric].c_str() );
+  }
+  
+  return true;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 5 )
+  {
+    std::cerr << "Usage: " << argv[0] << " Baseline.json Current.json Metric KeyField1[,KeyField2...] "
+      "[Tolerance=0.1] [LowerIsBetter]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::string metric = argv[3];
+  const double tolerance = ( argc > 5 ) ? atof( argv[5] ) : 0.1;
+  const bool lowerIsBetter = ( argc > 6 ) && std::string( argv[6] ) == "LowerIsBetter";
+  
+  std::vector<std::string> keyFields;
+  std::istringstream keyStream( argv[4] );
+  std::string keyField;
+  
+  while( std::getline( keyStream, keyField, ',' ) )
+    keyFields.push_back( keyField );
+  
+  ResultMapType baselineResults, currentResults;
+  
+  if( !ReadResults( argv[1], metric, keyFields, baselineResults ) )
+  {
+    std::cerr << "Could not read the baseline " << argv[1] << ". Build the PerformanceBaselines "
+      "target to store the current results as baseline." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !ReadResults( argv[2], metric, keyFields, currentResults ) )
+  {
+    std::cerr << "Could not read the results " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  unsigned int numberOfFailures = 0;
+  
+  for( ResultMapType::const_iterator it = baselineResults.begin(); it != baselineResults.end(); ++it )
+  {
+    ResultMapType::const_iterator current = currentResults.find( it->first );
+    
+    if( current == currentResults.end() )
+    {
+      std::cout << it->first << ": MISSING" << std::endl;
+      ++numberOfFailures;
+      continue;
+    }
+    
+    // Relative change, positive when the current result is better
+    double change = 0.0;
+    
+    if( it->second != 0.0 )
+    {
+      change = lowerIsBetter ? ( it->second - current->second ) / it->second 
+        : ( current->second - it->second ) / it->second;
+    }
+    
+    const bool regressed = ( change < -tolerance );
+    
+    std::cout << it->first << ": " << metric << " " << it->second << " -> " << current->second 
+              << " (" << 100.0 * change << "%)" << ( regressed ? " REGRESSION" : "" ) << std::endl;
+      
+    if( regressed )
+      ++numberOfFailures;
+  }
+  
+  for( ResultMapType::const_iterator it = currentResults.begin(); it != currentResults.end(); ++it )
+  {
+    if( baselineResults.find( it->first ) == baselineResults.end() )
+      std::cout << it->first << ": NEW " << metric << " " << it->second << std::endl;
+  }
+  
+  if( numberOfFailures > 0 )
+  {
+    std::cerr << numberOfFailures << " results regressed beyond " << 100.0 * tolerance 
+              << "% or are missing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
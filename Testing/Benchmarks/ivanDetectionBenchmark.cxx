@@ -0,0 +1,568 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDetectionBenchmark.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: throughput and thread scaling benchmark of the vesselness image functions
+// Date: 2012/11/05
+//
+// Measures the dense evaluation throughput (voxels per second) of the vesselness image functions 
+// and its scaling with the number of threads, on a straight Gaussian tube phantom of fixed size.
+// Each configuration is run several times and the fastest run is kept. Results are written as 
+// JSON so that they can be compared across releases.
+//
+// The ring-sampling functions are also evaluated at scattered pseudo-random voxels of a larger 
+// phantom, which does not fit in the cache, with several sample prefetch distances.
+//
+// The multiscale Frangi filter is run with the recursive derivative filters at every scale and with
+// the scale-space cascade. The speedup of the cascade results is relative to the recursive filters
+// with the same number of threads.
+//
+// Where hardware performance counters are available (perf_event on Linux), each result also has
+// the instructions and the last level cache misses per evaluated voxel, and the instructions per
+// cycle, of its fastest run.
+//
+// Usage: BenchmarkDetection OutputFileName.json [ImageSize=64] [Sigma=2.0] [MaximumNumberOfThreads]
+//   [Repetitions=3] [ScatteredImageSize=192]
+
+#include "ivanConfigure.h"
+
+#include "ivanCircularGaussianStraightTubeGenerator.h"
+#include "ivanImageFunctionBasedImageFilter.h"
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+#include "ivanOffsetMedialnessImageFunctionInitializer.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+
+#include "ivanHardwareCounters.h"
+
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanSatoVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanPolarProfileVesselnessImageFunction.h"
+#include "ivanOffsetMedialnessImageFunction.h"
+#include "ivanCircularSectionFluxImageFunction.h"
+#include "ivanNonLinearSteerableFluxImageFunction.h"
+
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+typedef float                      PixelType;
+typedef itk::Image<PixelType,3>    ImageType;
+
+
+struct BenchmarkSettings
+{
+  double                     Sigma;
+  unsigned int               Repetitions;
+  std::vector<unsigned int>  NumberOfThreads;
+};
+
+
+struct BenchmarkResult
+{
+  std::string    Function;
+  unsigned int   NumberOfThreads;
+  unsigned long  NumberOfVoxels;
+  double         Time;
+  double         VoxelsPerSecond;
+  double         Speedup;
+  bool           HasCounters;
+  double         Counters[ivan::HardwareCounters::NumberOfCounters];
+};
+
+
+/** Keep the counters of the last run in the result. */
+void SetCounters( const ivan::HardwareCounters & counters, BenchmarkResult & result )
+{
+  result.HasCounters = counters.IsAnyAvailable();
+  
+  for( unsigned int i=0; i<ivan::HardwareCounters::NumberOfCounters; ++i )
+    result.Counters[i] = counters.GetValue( static_cast<ivan::HardwareCounters::CounterType>( i ) );
+}
+
+
+/** Gives the fixed benchmark scale to an initializer, since ImageFunctionBasedImageFilter 
+  * initializes the functions without scale. */
+template <class TInitializer>
+class FixedScaleInitializer : public TInitializer
+{
+public:
+
+  typedef FixedScaleInitializer            Self;
+  typedef TInitializer                     Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  
+  typedef typename Superclass::ImageFunctionType   ImageFunctionType;
+  typedef typename Superclass::ImageType           ImageType;
+  
+  itkNewMacro( Self );
+  
+  void SetScale( double scale )
+    { m_Scale = scale; }
+  
+  virtual void Initialize( ImageFunctionType *imageFunction, const ImageType *image = 0, double = 0.0 )
+    { Superclass::Initialize( imageFunction, image, m_Scale ); }
+  
+protected:
+
+  FixedScaleInitializer() : m_Scale( 1.0 ) {}
+  
+  double m_Scale;
+};
+
+
+/** The polar profile vesselness has no generic initializer. The sphere radius covers the tube. */
+template <class TImageFunction, class TImage>
+class PolarProfileVesselnessInitializer : public ivan::ImageFunctionInitializerBase<TImageFunction,TImage>
+{
+public:
+
+  typedef PolarProfileVesselnessInitializer                       Self;
+  typedef ivan::ImageFunctionInitializerBase<TImageFunction,TImage>   Superclass;
+  typedef itk::SmartPointer<Self>                                 Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual void Initialize( TImageFunction *imageFunction, const TImage *image = 0, double scale = 0.0 )
+    {
+      imageFunction->SetInputImage( image );
+      imageFunction->SetRadius( 2.0 * scale );
+      imageFunction->SetRadialResolution( 5 );
+      imageFunction->SetSigma( scale );
+      imageFunction->Initialize();
+    }
+};
+
+
+template <class TImageFunction>
+void RunBenchmark( const std::string & name, ImageType *input,
+  ivan::ImageFunctionInitializerBase<TImageFunction,ImageType> *initializer, 
+  const BenchmarkSettings & settings, std::vector<BenchmarkResult> & results )
+{
+  typedef ivan::ImageFunctionBasedImageFilter<ImageType,ImageType,TImageFunction>  FilterType;
+  
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetImageFunctionInitializer( initializer );
+  filter->SetThreshold( -itk::NumericTraits<PixelType>::max() ); // evaluate all the voxels
+  
+  double singleThreadTime = 0.0;
+  
+  // Opened before the runs so that the worker threads are counted
+  ivan::HardwareCounters counters;
+  
+  for( unsigned int i=0; i<settings.NumberOfThreads.size(); ++i )
+  {
+    filter->SetNumberOfThreads( settings.NumberOfThreads[i] );
+    
+    double bestTime = itk::NumericTraits<double>::max();
+    BenchmarkResult result;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      filter->Modified();
+      
+      itk::TimeProbe probe;
+      counters.Start();
+      probe.Start();
+      filter->Update();
+      probe.Stop();
+      counters.Stop();
+      
+      if( probe.GetMeanTime() < bestTime )
+      {
+        bestTime = probe.GetMeanTime();
+        SetCounters( counters, result );
+      }
+    }
+    
+    if( i == 0 )
+      singleThreadTime = bestTime;
+    
+    result.Function = name;
+    result.NumberOfThreads = settings.NumberOfThreads[i];
+    result.NumberOfVoxels = filter->GetNumberOfEvaluatedPixels();
+    result.Time = bestTime;
+    result.VoxelsPerSecond = ( bestTime > 0.0 ) ? result.NumberOfVoxels / bestTime : 0.0;
+    result.Speedup = ( bestTime > 0.0 ) ? singleThreadTime / bestTime : 0.0;
+    
+    std::cout << name << ", " << result.NumberOfThreads << " threads: " 
+              << result.VoxelsPerSecond << " voxels/s" << std::endl;
+    
+    results.push_back( result );
+  }
+}
+
+
+/** Runs the multiscale Frangi filter over four scales from half to twice the sigma of the tube, 
+  * without and with the scale-space cascade. */
+void RunMultiscaleBenchmark( ImageType *input, const BenchmarkSettings & settings, 
+  std::vector<BenchmarkResult> & results )
+{
+  typedef itk::Image<double,3>   OutputImageType;
+  typedef ivan::MultiscaleHessianVesselnessMeasuresImageFilter<ImageType,OutputImageType>  FilterType;
+  typedef ivan::FrangiVesselnessImageFunction<ImageType,double>                           FrangiFunctionType;
+  
+  const unsigned int numberOfScales = 4;
+  
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetScales( numberOfScales, 0.5 * settings.Sigma, 2.0 * settings.Sigma );
+  filter->SetDoNotComputeZeroPixels( false );
+  filter->AddMeasure( FrangiFunctionType::New() );
+  
+  ivan::HardwareCounters counters;
+  
+  std::vector<double> recursiveTimes;
+  
+  for( unsigned int c=0; c<2; ++c )
+  {
+    const bool cascade = ( c == 1 );
+    filter->SetScaleSpaceCascade( cascade );
+    
+    for( unsigned int i=0; i<settings.NumberOfThreads.size(); ++i )
+    {
+      filter->SetNumberOfThreads( settings.NumberOfThreads[i] );
+      
+      double bestTime = itk::NumericTraits<double>::max();
+      BenchmarkResult result;
+      
+      for( unsigned int j=0; j<settings.Repetitions; ++j )
+      {
+        filter->Modified();
+        
+        itk::TimeProbe probe;
+        counters.Start();
+        probe.Start();
+        filter->Update();
+        probe.Stop();
+        counters.Stop();
+        
+        if( probe.GetMeanTime() < bestTime )
+        {
+          bestTime = probe.GetMeanTime();
+          SetCounters( counters, result );
+        }
+      }
+      
+      if( !cascade )
+        recursiveTimes.push_back( bestTime );
+      
+      result.Function = cascade ? "MultiscaleFrangi/Cascade" : "MultiscaleFrangi/Recursive";
+      result.NumberOfThreads = settings.NumberOfThreads[i];
+      result.NumberOfVoxels = numberOfScales * input->GetBufferedRegion().GetNumberOfPixels();
+      result.Time = bestTime;
+      result.VoxelsPerSecond = ( bestTime > 0.0 ) ? result.NumberOfVoxels / bestTime : 0.0;
+      result.Speedup = ( bestTime > 0.0 ) ? 
+        ( cascade ? recursiveTimes[i] : recursiveTimes[0] ) / bestTime : 0.0;
+      
+      std::cout << result.Function << ", " << result.NumberOfThreads << " threads: " 
+                << result.VoxelsPerSecond << " voxels/s, speedup " << result.Speedup << std::endl;
+      
+      results.push_back( result );
+    }
+  }
+}
+
+
+/** Evaluates the function at pseudo-random voxels with each of the prefetch distances, always
+  * with the same sequence of voxels. Single threaded. */
+template <class TImageFunction>
+void RunScatteredBenchmark( const std::string & name, ImageType *input,
+  ivan::ImageFunctionInitializerBase<TImageFunction,ImageType> *initializer, 
+  const std::vector<unsigned int> & prefetchDistances, unsigned long numberOfEvaluations,
+  const BenchmarkSettings & settings, std::vector<BenchmarkResult> & results )
+{
+  typename TImageFunction::Pointer function = TImageFunction::New();
+  initializer->Initialize( function, input );
+  
+  const ImageType::RegionType region = input->GetBufferedRegion();
+  
+  double noPrefetchTime = 0.0;
+  
+  ivan::HardwareCounters counters;
+  
+  for( unsigned int i=0; i<prefetchDistances.size(); ++i )
+  {
+    function->SetPrefetchDistance( prefetchDistances[i] );
+    
+    double bestTime = itk::NumericTraits<double>::max();
+    double sum = 0.0;
+    BenchmarkResult result;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      unsigned long seed = 12345;
+      ImageType::IndexType index;
+      
+      itk::TimeProbe probe;
+      counters.Start();
+      probe.Start();
+      
+      for( unsigned long k=0; k<numberOfEvaluations; ++k )
+      {
+        for( unsigned int d=0; d<ImageType::ImageDimension; ++d )
+        {
+          seed = seed * 1103515245UL + 12345UL;
+          index[d] = region.GetIndex()[d] + ( ( seed >> 16 ) & 0x7fff ) % region.GetSize()[d];
+        }
+        
+        sum += function->EvaluateAtIndex( index );
+      }
+      
+      probe.Stop();
+      counters.Stop();
+      
+      if( probe.GetMeanTime() < bestTime )
+      {
+        bestTime = probe.GetMeanTime();
+        SetCounters( counters, result );
+      }
+    }
+    
+    if( i == 0 )
+      noPrefetchTime = bestTime;
+    
+    std::ostringstream resultName;
+    resultName << name << "/Scattered/Prefetch" << prefetchDistances[i];
+    
+    result.Function = resultName.str();
+    result.NumberOfThreads = 1;
+    result.NumberOfVoxels = numberOfEvaluations;
+    result.Time = bestTime;
+    result.VoxelsPerSecond = ( bestTime > 0.0 ) ? numberOfEvaluations / bestTime : 0.0;
+    result.Speedup = ( bestTime > 0.0 ) ? noPrefetchTime / bestTime : 0.0;
+    
+    // The sum is printed so that the evaluations are not optimized away
+    std::cout << result.Function << ": " << result.VoxelsPerSecond << " voxels/s (checksum " 
+              << sum << ")" << std::endl;
+    
+    results.push_back( result );
+  }
+}
+
+
+void WriteResults( std::ostream & os, const ImageType *input, const BenchmarkSettings & settings, 
+  const std::vector<BenchmarkResult> & results )
+{
+  const ImageType::SizeType size = input->GetLargestPossibleRegion().GetSize();
+  
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"detection\"," << std::endl;
+  os << "  \"version\": \"" << IVAN_VERSION_STRING << "\"," << std::endl;
+  os << "  \"imageSize\": [" << size[0] << ", " << size[1] << ", " << size[2] << "]," << std::endl;
+  os << "  \"sigma\": " << settings.Sigma << "," << std::endl;
+  os << "  \"repetitions\": " << settings.Repetitions << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  
+  for( unsigned int i=0; i<results.size(); ++i )
+  {
+    os << "    { \"function\": \"" << results[i].Function << "\""
+       << ", \"threads\": " << results[i].NumberOfThreads
+       << ", \"voxels\": " << results[i].NumberOfVoxels
+       << ", \"time\": " << results[i].Time
+       << ", \"voxelsPerSecond\": " << results[i].VoxelsPerSecond
+       << ", \"speedup\": " << results[i].Speedup;
+    
+    if( results[i].HasCounters )
+    {
+      typedef ivan::HardwareCounters  CountersType;
+      
+      for( unsigned int j=0; j<CountersType::NumberOfCounters; ++j )
+        os << ", \"" << CountersType::GetName( static_cast<CountersType::CounterType>( j ) ) 
+           << "\": " << results[i].Counters[j];
+      
+      const double voxels = vnl_math_max( results[i].NumberOfVoxels, 1UL );
+      const double cycles = results[i].Counters[CountersType::Cycles];
+      
+      os << ", \"instructionsPerVoxel\": " << results[i].Counters[CountersType::Instructions] / voxels
+         << ", \"llcMissesPerVoxel\": " << results[i].Counters[CountersType::LastLevelCacheMisses] / voxels
+         << ", \"instructionsPerCycle\": " 
+         << ( ( cycles > 0.0 ) ? results[i].Counters[CountersType::Instructions] / cycles : 0.0 );
+    }
+    
+    os << " }" 
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << std::endl;
+  }
+  
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputFileName.json [ImageSize=64] [Sigma=2.0] [MaximumNumberOfThreads] [Repetitions=3] [ScatteredImageSize=192]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const unsigned long imageSize = ( argc > 2 ) ? atoi( argv[2] ) : 64;
+  
+  BenchmarkSettings settings;
+  settings.Sigma = ( argc > 3 ) ? atof( argv[3] ) : 2.0;
+  settings.Repetitions = ( argc > 5 ) ? vnl_math_max( atoi( argv[5] ), 1 ) : 3;
+  
+  const unsigned long scatteredImageSize = ( argc > 6 ) ? atoi( argv[6] ) : 192;
+  
+  const unsigned int maximumNumberOfThreads = ( argc > 4 ) ? vnl_math_max( atoi( argv[4] ), 1 ) :
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  
+  // Powers of two up to the maximum, and the maximum itself
+  for( unsigned int threads = 1; threads < maximumNumberOfThreads; threads *= 2 )
+    settings.NumberOfThreads.push_back( threads );
+    
+  settings.NumberOfThreads.push_back( maximumNumberOfThreads );
+  
+  // Create the phantom, with an odd section size so the tube is centered
+  
+  typedef ivan::CircularGaussianStraightTubeGenerator<PixelType>  GeneratorType;
+  
+  GeneratorType generator;
+  generator.SetSigma( settings.Sigma );
+  generator.SetHeight( imageSize );
+  generator.SetImageSpacing( 1.0 );
+  generator.SetRescale( true );
+  generator.SetMaxValue( 255.0 );
+  generator.SetSectionImageSize( ( imageSize % 2 == 0 ) ? imageSize + 1 : imageSize );
+  
+  ImageType::Pointer input = generator.Create();
+  
+  const double radius = vcl_sqrt( 3.0 ) * settings.Sigma;
+  
+  std::vector<BenchmarkResult> results;
+  
+  try
+  {
+    typedef ivan::FrangiVesselnessImageFunction<ImageType,double>          FrangiFunctionType;
+    typedef ivan::SatoVesselnessImageFunction<ImageType,double>            SatoFunctionType;
+    typedef ivan::CircularSectionFluxImageFunction<ImageType,double>       CircularFluxFunctionType;
+    typedef ivan::NonLinearSteerableFluxImageFunction<ImageType,double>    SteerableFluxFunctionType;
+    typedef ivan::PolarProfileVesselnessImageFunction<ImageType,double>    PolarProfileFunctionType;
+    typedef ivan::OffsetMedialnessImageFunction<ImageType,double>          MedialnessFunctionType;
+    
+    typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>         GradientFunctionType;
+    typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>              EigenvalueFunctorType;
+    typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+      <ImageType,GradientFunctionType,EigenvalueFunctorType,double>        OOFFunctionType;
+    
+    typedef FixedScaleInitializer<ivan::ScaleSpaceImageFunctionInitializer
+      <FrangiFunctionType,ImageType> >                    FrangiInitializerType;
+    typedef FixedScaleInitializer<ivan::ScaleSpaceImageFunctionInitializer
+      <SatoFunctionType,ImageType> >                      SatoInitializerType;
+    typedef FixedScaleInitializer<ivan::ScaleSpaceImageFunctionInitializer
+      <CircularFluxFunctionType,ImageType> >              CircularFluxInitializerType;
+    typedef FixedScaleInitializer<ivan::ScaleSpaceImageFunctionInitializer
+      <SteerableFluxFunctionType,ImageType> >             SteerableFluxInitializerType;
+    typedef FixedScaleInitializer<PolarProfileVesselnessInitializer
+      <PolarProfileFunctionType,ImageType> >              PolarProfileInitializerType;
+    typedef FixedScaleInitializer<ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+      <OOFFunctionType,ImageType> >                       OOFInitializerType;
+    typedef ivan::OffsetMedialnessImageFunctionInitializer<ImageType>  MedialnessInitializerType;
+    
+    FrangiInitializerType::Pointer frangiInitializer = FrangiInitializerType::New();
+    frangiInitializer->SetScale( settings.Sigma );
+    RunBenchmark<FrangiFunctionType>( "Frangi", input, frangiInitializer, settings, results );
+    
+    SatoInitializerType::Pointer satoInitializer = SatoInitializerType::New();
+    satoInitializer->SetScale( settings.Sigma );
+    RunBenchmark<SatoFunctionType>( "Sato", input, satoInitializer, settings, results );
+    
+    // OOF is initialized with the radius of the sphere
+    OOFInitializerType::Pointer oofInitializer = OOFInitializerType::New();
+    oofInitializer->SetScale( radius );
+    RunBenchmark<OOFFunctionType>( "OptimallyOrientedFlux", input, oofInitializer, settings, results );
+    
+    PolarProfileInitializerType::Pointer polarProfileInitializer = PolarProfileInitializerType::New();
+    polarProfileInitializer->SetScale( settings.Sigma );
+    RunBenchmark<PolarProfileFunctionType>( "PolarProfile", input, polarProfileInitializer, settings, results );
+    
+    MedialnessInitializerType::Pointer medialnessInitializer = MedialnessInitializerType::New();
+    medialnessInitializer->SetScaleSelectionMethod( MedialnessInitializerType::IgnoreScale );
+    medialnessInitializer->SetGradientSigma( 1.0 );
+    medialnessInitializer->SetHessianSigma( settings.Sigma );
+    medialnessInitializer->SetRadius( radius );
+    RunBenchmark<MedialnessFunctionType>( "OffsetMedialness", input, medialnessInitializer, settings, results );
+    
+    CircularFluxInitializerType::Pointer circularFluxInitializer = CircularFluxInitializerType::New();
+    circularFluxInitializer->SetScale( settings.Sigma );
+    RunBenchmark<CircularFluxFunctionType>( "CircularSectionFlux", input, circularFluxInitializer, settings, results );
+    
+    SteerableFluxInitializerType::Pointer steerableFluxInitializer = SteerableFluxInitializerType::New();
+    steerableFluxInitializer->SetScale( settings.Sigma );
+    RunBenchmark<SteerableFluxFunctionType>( "NonLinearSteerableFlux", input, steerableFluxInitializer, settings, results );
+    
+    RunMultiscaleBenchmark( input, settings, results );
+    
+    // Scattered evaluation on a phantom larger than the last level cache
+    if( scatteredImageSize > 0 )
+    {
+      generator.SetHeight( scatteredImageSize );
+      generator.SetSectionImageSize( ( scatteredImageSize % 2 == 0 ) ? scatteredImageSize + 1 : 
+        scatteredImageSize );
+      
+      ImageType::Pointer scatteredInput = generator.Create();
+      
+      std::vector<unsigned int> prefetchDistances;
+      prefetchDistances.push_back( 0 );
+      prefetchDistances.push_back( 2 );
+      prefetchDistances.push_back( 4 );
+      prefetchDistances.push_back( 8 );
+      
+      const unsigned long numberOfEvaluations = 100000;
+      
+      RunScatteredBenchmark<CircularFluxFunctionType>( "CircularSectionFlux", scatteredInput, 
+        circularFluxInitializer, prefetchDistances, numberOfEvaluations, settings, results );
+      RunScatteredBenchmark<MedialnessFunctionType>( "OffsetMedialness", scatteredInput, 
+        medialnessInitializer, prefetchDistances, numberOfEvaluations, settings, results );
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::ofstream fileout( argv[1] );
+  
+  if( !fileout.is_open() )
+  {
+    std::cerr << "Could not open " << argv[1] << " for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  WriteResults( fileout, input, settings, results );
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,444 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGraphBenchmark.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: micro-benchmarks of graph construction, visiting, searching, snapshots and teardown
+// Date: 2012/11/05
+//
+// Micro-benchmarks of the graph operations: construction with heap and arena allocation, 
+// visitor dispatch, search by identifier, traversal of deep chains and upwards through the 
+// parents, snapshots, freezing and teardown. Each operation is run on trees with the given 
+// fanout and on chains, whose depth equals the number of nodes, for sizes growing by factors 
+// of ten up to the given number of nodes (10^7 is a reasonable maximum on a workstation). Each 
+// measurement is the fastest of several repetitions, and is reported also per item (node, 
+// query or step) so that sizes can be compared. Results are written as JSON.
+//
+// Usage: BenchmarkGraph OutputFileName.json [NumberOfNodes=100000] [Fanout=4] [Repetitions=3]
+
+#include "ivanConfigure.h"
+
+#include "ivanVesselGraph.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanGraphCountNodeVisitor.h"
+#include "ivanGraphCountNodeVisitor2.h"
+#include "ivanArenaAllocator.h"
+
+#include "itkTimeProbe.h"
+#include "itkNumericTraits.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+typedef ivan::CircularVesselSection<3>                              VesselSectionType;
+typedef ivan::VesselCenterline<unsigned int, VesselSectionType>     CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                           VesselGraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>                     FrozenVesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>                      BranchNodeType;
+
+typedef std::vector<ivan::GraphNode::Pointer>                       NodeContainerType;
+
+
+struct BenchmarkSettings
+{
+  unsigned int   NumberOfNodes;
+  unsigned int   Fanout;
+  unsigned int   Repetitions;
+};
+
+
+struct BenchmarkResult
+{
+  std::string    Operation;
+  std::string    Shape;
+  unsigned int   NumberOfNodes;
+  unsigned int   NumberOfItems;
+  double         Time;
+  double         TimePerItem;
+};
+
+
+/** Keeps the fastest of several timed runs of an operation. */
+class BestTime
+{
+public:
+  BestTime() : m_Time( itk::NumericTraits<double>::max() ) {}
+  
+  void Start()
+    { m_Probe = itk::TimeProbe(); m_Probe.Start(); }
+  void Stop()
+    { 
+      m_Probe.Stop(); 
+      m_Time = vnl_math_min( m_Time, static_cast<double>( m_Probe.GetMeanTime() ) ); 
+    }
+    
+  double GetTime() const
+    { return m_Time; }
+    
+private:
+  itk::TimeProbe   m_Probe;
+  double           m_Time;
+};
+
+
+/** Create the nodes, numbered from 1 in breadth-first order, and link each one to its parent. 
+  * A fanout of 1 gives a chain. */
+void BuildGraph( VesselGraphType *graph, unsigned int numberOfNodes, unsigned int fanout, 
+  bool useArena, NodeContainerType & nodes )
+{
+  nodes.clear();
+  nodes.reserve( numberOfNodes );
+  
+  {
+    ivan::ArenaAllocator::Scope scope( useArena ? graph->GetArena() : 0 );
+    
+    for( unsigned int i=0; i<numberOfNodes; ++i )
+    {
+      BranchNodeType::Pointer node = BranchNodeType::New();
+      node->SetNodeId( i+1 );
+      nodes.push_back( node.GetPointer() );
+    }
+  }
+  
+  graph->SetRootNode( static_cast<ivan::VesselNode*>( nodes[0].GetPointer() ) );
+  
+  for( unsigned int i=1; i<numberOfNodes; ++i )
+    nodes[(i-1)/fanout]->AddChild( nodes[i] );
+}
+
+
+/** Collect the nodes reachable from the root, every node after its parents. */
+void CollectNodes( VesselGraphType *graph, NodeContainerType & nodes )
+{
+  nodes.clear();
+  
+  std::vector<ivan::GraphNode*> pendingNodes( 1, graph->GetRootNode().GetPointer() );
+  
+  while( !pendingNodes.empty() )
+  {
+    ivan::GraphNode *node = pendingNodes.back();
+    pendingNodes.pop_back();
+    
+    nodes.push_back( node );
+    
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+      pendingNodes.push_back( node->GetChild(i) );
+  }
+}
+
+
+/** Release the graph and then its nodes, parents first. Each node is released while its 
+  * children are still held by the container, so that destroying deep chains does not 
+  * recurse through the whole chain. */
+void ReleaseGraph( VesselGraphType::Pointer & graph, NodeContainerType & nodes )
+{
+  graph = 0;
+  
+  for( unsigned int i=0; i<nodes.size(); ++i )
+    nodes[i] = 0;
+    
+  nodes.clear();
+}
+
+
+void AddResult( std::vector<BenchmarkResult> & results, const std::string & operation, 
+  const std::string & shape, unsigned int numberOfNodes, unsigned int numberOfItems, double time )
+{
+  BenchmarkResult result;
+  result.Operation = operation;
+  result.Shape = shape;
+  result.NumberOfNodes = numberOfNodes;
+  result.NumberOfItems = numberOfItems;
+  result.Time = time;
+  result.TimePerItem = ( numberOfItems > 0 ) ? time / numberOfItems : 0.0;
+  
+  std::cout << operation << ", " << shape << ", " << numberOfNodes << " nodes: " 
+            << 1e9 * result.TimePerItem << " ns per item" << std::endl;
+  
+  results.push_back( result );
+}
+
+
+void RunBenchmark( const std::string & shape, unsigned int numberOfNodes, unsigned int fanout,
+  const BenchmarkSettings & settings, std::vector<BenchmarkResult> & results )
+{
+  VesselGraphType::Pointer graph;
+  NodeContainerType nodes;
+  
+  // Construction and teardown with heap and arena allocation
+  for( unsigned int useArena=0; useArena<2; ++useArena )
+  {
+    BestTime buildTime, teardownTime;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      graph = VesselGraphType::New();
+      
+      buildTime.Start();
+      BuildGraph( graph, numberOfNodes, fanout, useArena, nodes );
+      buildTime.Stop();
+      
+      teardownTime.Start();
+      ReleaseGraph( graph, nodes );
+      teardownTime.Stop();
+    }
+    
+    AddResult( results, useArena ? "BuildArena" : "BuildHeap", shape, numberOfNodes, 
+      numberOfNodes, buildTime.GetTime() );
+    AddResult( results, useArena ? "TeardownArena" : "TeardownHeap", shape, numberOfNodes, 
+      numberOfNodes, teardownTime.GetTime() );
+  }
+  
+  graph = VesselGraphType::New();
+  BuildGraph( graph, numberOfNodes, fanout, false, nodes );
+  
+  // Visitor dispatch through the dispatcher table and through dynamic_cast<>
+  {
+    typedef ivan::GraphCountNodeVisitor<BranchNodeType>   TableVisitorType;
+    typedef ivan::GraphCountNodeVisitor2<BranchNodeType>  CastVisitorType;
+    
+    TableVisitorType::Pointer tableVisitor = TableVisitorType::New();
+    CastVisitorType::Pointer castVisitor = CastVisitorType::New();
+    
+    BestTime tableTime, castTime;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      tableVisitor->Reset();
+      tableTime.Start();
+      graph->GetRootNode()->Accept( tableVisitor );
+      tableTime.Stop();
+      
+      castVisitor->Reset();
+      castTime.Start();
+      graph->GetRootNode()->Accept( castVisitor );
+      castTime.Stop();
+    }
+    
+    AddResult( results, "VisitDispatcherTable", shape, numberOfNodes, tableVisitor->GetCount(), 
+      tableTime.GetTime() );
+    AddResult( results, "VisitDynamicCast", shape, numberOfNodes, castVisitor->GetCount(), 
+      castTime.GetTime() );
+  }
+  
+  // Upwards traversal, following the first parent from every leaf and visiting the parents 
+  // of the last node
+  {
+    typedef ivan::GraphCountNodeVisitor<BranchNodeType>   VisitorType;
+    
+    VisitorType::Pointer visitor = VisitorType::New();
+    visitor->SetTraversalMode( VisitorType::TraverseAllParents );
+    
+    BestTime walkTime, visitTime;
+    unsigned int numberOfSteps = 0;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      numberOfSteps = 0;
+      
+      walkTime.Start();
+      for( unsigned int i=0; i<nodes.size(); ++i )
+      {
+        if( nodes[i]->GetNumberOfChildren() > 0 )
+          continue;
+        
+        for( const ivan::GraphNode *node = nodes[i]; node->GetNumberOfParents() > 0; 
+          node = node->GetParent() )
+          ++numberOfSteps;
+      }
+      walkTime.Stop();
+      
+      visitor->Reset();
+      visitTime.Start();
+      nodes.back()->Accept( visitor );
+      visitTime.Stop();
+    }
+    
+    AddResult( results, "WalkParents", shape, numberOfNodes, numberOfSteps, walkTime.GetTime() );
+    AddResult( results, "VisitParents", shape, numberOfNodes, visitor->GetCount(), 
+      visitTime.GetTime() );
+  }
+  
+  // Search by identifier. Searches visiting the graph are linear, so they are run for a few 
+  // identifiers only
+  {
+    const unsigned int numberOfVisitorQueries = vnl_math_min( numberOfNodes, 16u );
+    const unsigned int numberOfIndexQueries = vnl_math_min( numberOfNodes, 100000u );
+    
+    BestTime visitorTime, buildIndexTime, indexTime, freezeTime, frozenTime;
+    unsigned int numberOfFound = 0;
+    
+    FrozenVesselGraphType::Pointer frozenGraph = FrozenVesselGraphType::New();
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      graph->SetUseNodeIndex( false );
+      
+      visitorTime.Start();
+      for( unsigned int q=0; q<numberOfVisitorQueries; ++q )
+        numberOfFound += ( graph->FindNodeById( 1 + ( q * ( numberOfNodes / numberOfVisitorQueries ) ) ) != 0 );
+      visitorTime.Stop();
+      
+      buildIndexTime.Start();
+      graph->SetUseNodeIndex( true );
+      buildIndexTime.Stop();
+      
+      indexTime.Start();
+      for( unsigned int q=0; q<numberOfIndexQueries; ++q )
+        numberOfFound += ( graph->FindNodeById( 1 + ( q * ( numberOfNodes / numberOfIndexQueries ) ) ) != 0 );
+      indexTime.Stop();
+      
+      freezeTime.Start();
+      frozenGraph->Freeze( graph );
+      freezeTime.Stop();
+      
+      frozenTime.Start();
+      for( unsigned int q=0; q<numberOfIndexQueries; ++q )
+      {
+        numberOfFound += ( frozenGraph->FindNodeById( 1 + ( q * ( numberOfNodes / numberOfIndexQueries ) ) ) 
+          != FrozenVesselGraphType::GetNullNodeIndex() );
+      }
+      frozenTime.Stop();
+    }
+    
+    graph->SetUseNodeIndex( false );
+    
+    if( numberOfFound != settings.Repetitions * ( numberOfVisitorQueries + 2 * numberOfIndexQueries ) )
+      itkGenericExceptionMacro( "Search by identifier missed some nodes." );
+    
+    AddResult( results, "FindByIdVisitor", shape, numberOfNodes, numberOfVisitorQueries, 
+      visitorTime.GetTime() );
+    AddResult( results, "BuildNodeIndex", shape, numberOfNodes, numberOfNodes, 
+      buildIndexTime.GetTime() );
+    AddResult( results, "FindByIdNodeIndex", shape, numberOfNodes, numberOfIndexQueries, 
+      indexTime.GetTime() );
+    AddResult( results, "Freeze", shape, numberOfNodes, numberOfNodes, freezeTime.GetTime() );
+    AddResult( results, "FindByIdFrozen", shape, numberOfNodes, numberOfIndexQueries, 
+      frozenTime.GetTime() );
+  }
+  
+  // Snapshots and their teardown
+  {
+    BestTime snapshotTime, teardownTime;
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      snapshotTime.Start();
+      VesselGraphType::Pointer snapshot = graph->CreateSnapshot();
+      snapshotTime.Stop();
+      
+      NodeContainerType snapshotNodes;
+      CollectNodes( snapshot, snapshotNodes );
+      
+      teardownTime.Start();
+      ReleaseGraph( snapshot, snapshotNodes );
+      teardownTime.Stop();
+    }
+    
+    AddResult( results, "Snapshot", shape, numberOfNodes, numberOfNodes, snapshotTime.GetTime() );
+    AddResult( results, "TeardownSnapshot", shape, numberOfNodes, numberOfNodes, 
+      teardownTime.GetTime() );
+  }
+  
+  ReleaseGraph( graph, nodes );
+}
+
+
+void WriteResults( std::ostream & os, const BenchmarkSettings & settings, 
+  const std::vector<BenchmarkResult> & results )
+{
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"graph\"," << std::endl;
+  os << "  \"version\": \"" << IVAN_VERSION_STRING << "\"," << std::endl;
+  os << "  \"fanout\": " << settings.Fanout << "," << std::endl;
+  os << "  \"repetitions\": " << settings.Repetitions << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  
+  for( unsigned int i=0; i<results.size(); ++i )
+  {
+    os << "    { \"operation\": \"" << results[i].Operation << "\""
+       << ", \"shape\": \"" << results[i].Shape << "\""
+       << ", \"nodes\": " << results[i].NumberOfNodes
+       << ", \"items\": " << results[i].NumberOfItems
+       << ", \"time\": " << results[i].Time
+       << ", \"timePerItem\": " << results[i].TimePerItem << " }" 
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << std::endl;
+  }
+  
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputFileName.json [NumberOfNodes=100000] [Fanout=4] "
+      "[Repetitions=3]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  BenchmarkSettings settings;
+  settings.NumberOfNodes = ( argc > 2 ) ? vnl_math_max( atoi( argv[2] ), 1 ) : 100000;
+  settings.Fanout = ( argc > 3 ) ? vnl_math_max( atoi( argv[3] ), 2 ) : 4;
+  settings.Repetitions = ( argc > 4 ) ? vnl_math_max( atoi( argv[4] ), 1 ) : 3;
+  
+  std::vector<BenchmarkResult> results;
+  
+  try
+  {
+    for( unsigned int numberOfNodes = vnl_math_min( settings.NumberOfNodes, 1000u ); ; 
+      numberOfNodes = vnl_math_min( 10 * numberOfNodes, settings.NumberOfNodes ) )
+    {
+      RunBenchmark( "Tree", numberOfNodes, settings.Fanout, settings, results );
+      RunBenchmark( "Chain", numberOfNodes, 1, settings, results );
+      
+      if( numberOfNodes == settings.NumberOfNodes )
+        break;
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::ofstream fileout( argv[1] );
+  
+  if( !fileout.is_open() )
+  {
+    std::cerr << "Could not open " << argv[1] << " for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  WriteResults( fileout, settings, results );
+  
+  return EXIT_SUCCESS;
+}
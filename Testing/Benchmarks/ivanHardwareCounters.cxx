@@ -0,0 +1,194 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHardwareCounters.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: hardware performance counters of the benchmark runs
+// Date: 2012/11/05
+
+#include "ivanHardwareCounters.h"
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace ivan
+{
+
+#if defined( __linux__ )
+
+namespace
+{
+/** Open a counter of the calling thread, inherited by the threads it creates. Returns -1 if the
+  * counter is not supported or not allowed. */
+int OpenCounter( unsigned int type, unsigned long long config )
+{
+  struct perf_event_attr attributes;
+  memset( &attributes, 0, sizeof( attributes ) );
+  
+  attributes.size = sizeof( attributes );
+  attributes.type = type;
+  attributes.config = config;
+  attributes.disabled = 1;
+  attributes.inherit = 1;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  
+  return static_cast<int>( syscall( __NR_perf_event_open, &attributes, 0, -1, -1, 0 ) );
+}
+}
+
+
+HardwareCounters::HardwareCounters()
+{
+  m_FileDescriptors[Cycles] = OpenCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+  m_FileDescriptors[Instructions] = OpenCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS );
+  m_FileDescriptors[LastLevelCacheMisses] = OpenCounter( PERF_TYPE_HW_CACHE, 
+    PERF_COUNT_HW_CACHE_LL | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | 
+    ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) );
+  m_FileDescriptors[BranchMisses] = OpenCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES );
+  
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+    m_Values[i] = 0.0;
+}
+
+
+HardwareCounters::~HardwareCounters()
+{
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+  {
+    if( m_FileDescriptors[i] >= 0 )
+      close( m_FileDescriptors[i] );
+  }
+}
+
+
+void
+HardwareCounters::Start()
+{
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+  {
+    if( m_FileDescriptors[i] >= 0 )
+    {
+      ioctl( m_FileDescriptors[i], PERF_EVENT_IOC_RESET, 0 );
+      ioctl( m_FileDescriptors[i], PERF_EVENT_IOC_ENABLE, 0 );
+    }
+  }
+}
+
+
+void
+HardwareCounters::Stop()
+{
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+  {
+    m_Values[i] = 0.0;
+    
+    if( m_FileDescriptors[i] < 0 )
+      continue;
+    
+    ioctl( m_FileDescriptors[i], PERF_EVENT_IOC_DISABLE, 0 );
+    
+    // Value, time enabled and time running. When the counters are multiplexed, the value is 
+    // extrapolated to the whole time enabled.
+    unsigned long long data[3];
+    
+    if( read( m_FileDescriptors[i], data, sizeof( data ) ) != sizeof( data ) )
+      continue;
+    
+    m_Values[i] = static_cast<double>( data[0] );
+    
+    if( data[2] > 0 && data[2] < data[1] )
+      m_Values[i] *= static_cast<double>( data[1] ) / static_cast<double>( data[2] );
+  }
+}
+
+#else
+
+HardwareCounters::HardwareCounters()
+{
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+  {
+    m_FileDescriptors[i] = -1;
+    m_Values[i] = 0.0;
+  }
+}
+
+
+HardwareCounters::~HardwareCounters()
+{
+}
+
+
+void
+HardwareCounters::Start()
+{
+}
+
+
+void
+HardwareCounters::Stop()
+{
+}
+
+#endif
+
+
+bool
+HardwareCounters::IsAnyAvailable() const
+{
+  for( unsigned int i=0; i<NumberOfCounters; ++i )
+  {
+    if( this->IsAvailable( static_cast<CounterType>( i ) ) )
+      return true;
+  }
+  
+  return false;
+}
+
+
+const char *
+HardwareCounters::GetName( CounterType counter )
+{
+  switch( counter )
+  {
+    case Cycles:
+      return "cycles";
+    case Instructions:
+      return "instructions";
+    case LastLevelCacheMisses:
+      return "llcMisses";
+    case BranchMisses:
+      return "branchMisses";
+    default:
+      return "";
+  }
+}
+
+} // end namespace ivan
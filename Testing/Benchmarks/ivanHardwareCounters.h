@@ -0,0 +1,90 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHardwareCounters.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: hardware performance counters of the benchmark runs
+// Date: 2012/11/05
+
+#ifndef __ivanHardwareCounters_h
+#define __ivanHardwareCounters_h
+
+namespace ivan
+{
+
+/** \class HardwareCounters
+ * \brief Hardware performance counters of a section of a benchmark, with its worker threads.
+ *
+ * Counts the core cycles, retired instructions, last level cache misses and branch misses of
+ * the calling thread, and of the threads it creates while counting, between Start() and 
+ * Stop(). The counters are opened when the object is created, so ITK's worker threads, which 
+ * are created on each run, are counted as long as they are joined before Stop(). Only user
+ * space is counted. Counts are scaled when the kernel multiplexes the counters.
+ *
+ * The counters are read with perf_event on Linux. Elsewhere, or when the kernel does not allow
+ * them (see /proc/sys/kernel/perf_event_paranoid), no counter is available and the benchmarks 
+ * just report their times.
+ */
+class HardwareCounters
+{
+public:
+  
+  typedef enum { Cycles = 0, Instructions, LastLevelCacheMisses, BranchMisses, 
+    NumberOfCounters } CounterType;
+  
+  HardwareCounters();
+  ~HardwareCounters();
+  
+  /** Whether the counter could be opened. */
+  bool IsAvailable( CounterType counter ) const
+    { return m_FileDescriptors[counter] >= 0; }
+  
+  /** Whether any counter could be opened. */
+  bool IsAnyAvailable() const;
+  
+  /** Set the counters to zero and start counting. */
+  void Start();
+  
+  /** Stop counting and read the counters. */
+  void Stop();
+  
+  /** Count of the last Start() and Stop(), zero if the counter is not available. */
+  double GetValue( CounterType counter ) const
+    { return m_Values[counter]; }
+  
+  /** Name of a counter in the benchmark results, such as "llcMisses". */
+  static const char * GetName( CounterType counter );
+  
+private:
+  
+  HardwareCounters( const HardwareCounters& ); // purposely not implemented
+  void operator=( const HardwareCounters& ); // purposely not implemented
+  
+  int     m_FileDescriptors[NumberOfCounters];
+  double  m_Values[NumberOfCounters];
+};
+
+} // end namespace ivan
+
+#endif
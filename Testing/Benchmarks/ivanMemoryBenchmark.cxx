@@ -0,0 +1,613 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMemoryBenchmark.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: heap and resident memory of the detection filters, trackers and graphs
+// Date: 2012/11/05
+//
+// Memory counterpart of the throughput benchmarks. The heap is measured by the allocation hook
+// linked in this executable (ivanAllocationHook.cxx), which counts the allocations, allocated 
+// bytes and peak live bytes of each measured operation, and the process peak resident set 
+// size is reported after each of them. Since the resident peak never decreases, operations
+// are run from the expected smallest to the largest, and the heap peak is the number to 
+// compare between configurations.
+//
+// - Multiscale detection filters, default and memory-lean settings, for several numbers of 
+//   scales on a straight Gaussian tube phantom. Reported also per scale and per voxel.
+// - Trackers on a toroid phantom. Reported also per 1000 tracked sections.
+// - Graphs of branch nodes with sections stored as objects and packed contiguously, and 
+//   their frozen copies, for sizes growing by factors of ten. Reported also per 1000 nodes.
+//
+// Results are written as JSON.
+//
+// Usage: BenchmarkMemory OutputFileName.json [ImageSize=64] [Sigma=2.0] [NumberOfNodes=100000]
+//   [SectionsPerBranch=10]
+
+#include "ivanConfigure.h"
+
+#include "ivanAllocationHook.h"
+
+#include "ivanCircularGaussianStraightTubeGenerator.h"
+#include "ivanCircularGaussianToroidGenerator.h"
+#include "ivanMultiscaleMedialnessImageFilter.h"
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+#include "ivanMultiscaleOptimallyOrientedFluxImageFilter.h"
+
+#include "ivanVesselGraph.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanPackedVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselnessRidgeSearchVesselTrackerFilter.h"
+#include "ivanOptimizedVesselnessBasedSearchVesselTrackerFilter.h"
+#include "ivanImage3DPlaneFunctionToCostFunctionAdaptor.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkMultiScaleHessianBasedMeasureImageFilter.h"
+#include "itkHessianToObjectnessMeasureImageFilter.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNormalVariateGenerator.h"
+#include "itkOnePlusOneEvolutionaryOptimizer.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                       PixelType;
+typedef itk::Image<PixelType,Dimension>             ImageType;
+typedef ImageType::PointType                        PointType;
+
+typedef ivan::CircularVesselSection<Dimension>                      VesselSectionType;
+typedef ivan::VesselCenterline<unsigned int, VesselSectionType>     CenterlineType;
+typedef ivan::PackedVesselCenterline<unsigned int>                  PackedCenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                           VesselGraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>                     FrozenVesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>                      BranchNodeType;
+typedef ivan::VesselSectionEstimator<CenterlineType>                SectionEstimatorType;
+
+typedef itk::LinearInterpolateImageFunction<ImageType>              VesselnessInterpolatorType;
+
+
+struct BenchmarkSettings
+{
+  unsigned int   ImageSize;
+  double         Sigma;
+  unsigned int   NumberOfNodes;
+  unsigned int   SectionsPerBranch;
+};
+
+
+struct BenchmarkResult
+{
+  std::string          Category;
+  std::string          Name;
+  std::string          Mode;
+  std::string          Unit;
+  unsigned long        NumberOfUnits;
+  unsigned long long   NumberOfAllocations;
+  unsigned long long   AllocatedBytes;
+  long long            PeakBytes;
+  long long            RetainedBytes;
+  unsigned long long   PeakResidentSetSize;
+};
+
+
+/** Measures the heap used by an operation from Start() to Stop(). */
+class MemoryProbe
+{
+public:
+
+  void Start()
+    {
+      ivan::ResetAllocationCounters();
+      m_Start = ivan::GetAllocationCounters();
+    }
+    
+  void Stop()
+    { m_Stop = ivan::GetAllocationCounters(); }
+  
+  /** Fill the measurements of the result. */
+  void GetResult( BenchmarkResult & result ) const
+    {
+      result.NumberOfAllocations = m_Stop.NumberOfAllocations;
+      result.AllocatedBytes = m_Stop.AllocatedBytes;
+      result.PeakBytes = m_Stop.PeakLiveBytes - m_Start.LiveBytes;
+      result.RetainedBytes = m_Stop.LiveBytes - m_Start.LiveBytes;
+      result.PeakResidentSetSize = ivan::GetPeakResidentSetSize();
+    }
+  
+private:
+
+  ivan::AllocationCounters  m_Start;
+  ivan::AllocationCounters  m_Stop;
+};
+
+
+void AddResult( std::vector<BenchmarkResult> & results, const std::string & category, 
+  const std::string & name, const std::string & mode, const std::string & unit, 
+  unsigned long numberOfUnits, const MemoryProbe & probe )
+{
+  BenchmarkResult result;
+  result.Category = category;
+  result.Name = name;
+  result.Mode = mode;
+  result.Unit = unit;
+  result.NumberOfUnits = numberOfUnits;
+  probe.GetResult( result );
+  
+  std::cout << category << ", " << name << ", " << mode << ": " << result.NumberOfAllocations 
+            << " allocations, peak " << result.PeakBytes << " bytes for " << numberOfUnits << " " 
+            << unit << std::endl;
+  
+  results.push_back( result );
+}
+
+
+/** Run a multiscale filter with the given numbers of scales, with default and lean settings. 
+  * The lean settings are the ones of the base class and the ones set by setLean. */
+template <class TFilter>
+void RunDetectionBenchmark( const std::string & name, ImageType *input, 
+  const BenchmarkSettings & settings, void (*setLean)( TFilter * ), 
+  std::vector<BenchmarkResult> & results )
+{
+  const unsigned int numbersOfScales[] = { 1, 2, 4 };
+  
+  for( unsigned int lean=0; lean<2; ++lean )
+  {
+    for( unsigned int i=0; i<sizeof( numbersOfScales ) / sizeof( unsigned int ); ++i )
+    {
+      MemoryProbe probe;
+      probe.Start();
+      
+      {
+        typename TFilter::Pointer filter = TFilter::New();
+        filter->SetInput( input );
+        filter->SetScales( numbersOfScales[i], settings.Sigma, 2.0 * settings.Sigma );
+        
+        if( lean )
+        {
+          filter->ReleaseScaleFiltersDataOn();
+          setLean( filter );
+        }
+        
+        filter->Update();
+      }
+      
+      probe.Stop();
+      
+      std::ostringstream mode;
+      mode << ( lean ? "Lean" : "Default" ) << "/Scales" << numbersOfScales[i];
+      
+      AddResult( results, "detection", name, mode.str(), "scales", numbersOfScales[i], probe );
+    }
+  }
+}
+
+
+template <class TFilter>
+void SetNoLeanOptions( TFilter * )
+{
+}
+
+
+void SetMedialnessLeanOptions( ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType> *filter )
+{
+  filter->StoreScaleIndicesOn();
+  filter->EncodeNormalsOn();
+  filter->ReleaseHessianBetweenScalesOn();
+}
+
+
+/** Single scale objectness, rescaled to [0,255] as in the tracker tests. */
+ImageType::Pointer ComputeVesselness( ImageType *image, double sigma )
+{
+  typedef itk::SymmetricSecondRankTensor<PixelType,Dimension>  HessianPixelType;
+  typedef itk::Image<HessianPixelType,Dimension>               HessianImageType;
+  
+  typedef itk::HessianToObjectnessMeasureImageFilter
+    <HessianImageType,ImageType>                               ObjectnessFilterType;
+  typedef itk::MultiScaleHessianBasedMeasureImageFilter
+    <ImageType,HessianImageType,ImageType>                     MultiscaleFilterType;
+  typedef itk::RescaleIntensityImageFilter<ImageType,ImageType>  RescalerType;
+  
+  ObjectnessFilterType::Pointer objectnessFilter = ObjectnessFilterType::New();
+  objectnessFilter->SetScaleObjectnessMeasure( false );
+  objectnessFilter->SetBrightObject( true );
+  objectnessFilter->SetAlpha( 0.5 );
+  objectnessFilter->SetBeta( 0.5 );
+  objectnessFilter->SetGamma( 5.0 );
+  
+  MultiscaleFilterType::Pointer multiscaleFilter = MultiscaleFilterType::New();
+  multiscaleFilter->SetInput( image );
+  multiscaleFilter->SetHessianToMeasureFilter( objectnessFilter );
+  multiscaleFilter->SetSigmaStepMethodToLogarithmic();
+  multiscaleFilter->SetNumberOfSigmaSteps( 1 );
+  multiscaleFilter->SetSigmaMinimum( sigma );
+  multiscaleFilter->SetSigmaMaximum( sigma );
+  
+  RescalerType::Pointer rescaler = RescalerType::New();
+  rescaler->SetInput( multiscaleFilter->GetOutput() );
+  rescaler->SetOutputMinimum( 0.0 );
+  rescaler->SetOutputMaximum( 255.0 );
+  rescaler->Update();
+  
+  ImageType::Pointer vesselness = rescaler->GetOutput();
+  vesselness->DisconnectPipeline();
+  
+  return vesselness;
+}
+
+
+/** Track the toroid both ways from a point of its centerline. */
+template <class TTracker>
+void RunTrackingBenchmark( const std::string & name, TTracker *tracker, ImageType *image,
+  const PointType & startingPoint, const BenchmarkSettings & settings, 
+  std::vector<BenchmarkResult> & results )
+{
+  typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+    <ImageType,CenterlineType>                            EstimatorType;
+  typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+  
+  EstimatorType::Pointer estimator = EstimatorType::New();
+  estimator->SetImage( image );
+  estimator->SetScale( settings.Sigma );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( 50 );
+  
+  tracker->SetInput( image );
+  tracker->SetStartingPoint( startingPoint );
+  tracker->SetInitialStepSize( 1.0 );
+  tracker->SetBidirectional( true );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  tracker->SetSectionEstimator( estimator.GetPointer() );
+  
+  MemoryProbe probe;
+  probe.Start();
+  tracker->Update();
+  probe.Stop();
+  
+  unsigned long numberOfSections = 0;
+  
+  if( tracker->GetOutput()->GetRootNode().IsNotNull() )
+  {
+    numberOfSections = static_cast<BranchNodeType*>
+      ( tracker->GetOutput()->GetRootNode().GetPointer() )->GetCenterline()->Size();
+  }
+  
+  AddResult( results, "tracking", name, "FixedScaleHessian", "sections", numberOfSections, probe );
+}
+
+
+/** Release the graph and then its nodes, parents first, so that deep subtrees are not 
+  * destroyed recursively. */
+void ReleaseGraph( VesselGraphType::Pointer & graph, std::vector<ivan::GraphNode::Pointer> & nodes )
+{
+  graph = 0;
+  
+  for( unsigned int i=0; i<nodes.size(); ++i )
+    nodes[i] = 0;
+    
+  nodes.clear();
+}
+
+
+/** Create the centerline of a branch. */
+CenterlineType::Pointer CreateCenterline( unsigned int numberOfSections )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  centerline->reserve( numberOfSections );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    VesselSectionType::PointType center;
+    center.Fill( 0.0 );
+    center[2] = i;
+    
+    VesselSectionType::Pointer section = VesselSectionType::New();
+    section->SetCenter( center );
+    section->SetRadius( 1.0 );
+    
+    centerline->push_back( section );
+  }
+  
+  return centerline;
+}
+
+
+void RunGraphBenchmark( unsigned int numberOfNodes, const BenchmarkSettings & settings,
+  std::vector<BenchmarkResult> & results )
+{
+  std::vector<ivan::GraphNode::Pointer> nodes;
+  
+  // Graph of branch nodes with a fanout of two, without sections
+  {
+    MemoryProbe probe;
+    probe.Start();
+    
+    {
+      VesselGraphType::Pointer graph = VesselGraphType::New();
+      nodes.reserve( numberOfNodes );
+      
+      for( unsigned int i=0; i<numberOfNodes; ++i )
+      {
+        BranchNodeType::Pointer node = BranchNodeType::New();
+        node->SetNodeId( i+1 );
+        nodes.push_back( node.GetPointer() );
+        
+        if( i > 0 )
+          nodes[(i-1)/2]->AddChild( node.GetPointer() );
+      }
+      
+      graph->SetRootNode( static_cast<ivan::VesselNode*>( nodes[0].GetPointer() ) );
+      
+      probe.Stop();
+      
+      ReleaseGraph( graph, nodes );
+    }
+    
+    AddResult( results, "graph", "VesselGraph", "Nodes", "nodes", numberOfNodes, probe );
+  }
+  
+  // Sections per branch as objects and packed
+  const unsigned long numberOfSections = (unsigned long)numberOfNodes * settings.SectionsPerBranch;
+  
+  {
+    std::vector<CenterlineType::Pointer> centerlines;
+    
+    MemoryProbe probe;
+    probe.Start();
+    
+    centerlines.reserve( numberOfNodes );
+    
+    for( unsigned int i=0; i<numberOfNodes; ++i )
+      centerlines.push_back( CreateCenterline( settings.SectionsPerBranch ) );
+    
+    probe.Stop();
+    
+    AddResult( results, "graph", "VesselCenterline", "Sections", "sections", numberOfSections, probe );
+    
+    std::vector<PackedCenterlineType::Pointer> packedCenterlines;
+    
+    probe.Start();
+    
+    packedCenterlines.reserve( numberOfNodes );
+    
+    for( unsigned int i=0; i<numberOfNodes; ++i )
+    {
+      PackedCenterlineType::Pointer packedCenterline = PackedCenterlineType::New();
+      packedCenterline->Pack( centerlines[i].GetPointer() );
+      packedCenterlines.push_back( packedCenterline );
+    }
+    
+    probe.Stop();
+    
+    AddResult( results, "graph", "PackedVesselCenterline", "Sections", "sections", numberOfSections, probe );
+  }
+  
+  // Frozen copy of a graph with sections
+  {
+    VesselGraphType::Pointer graph = VesselGraphType::New();
+    
+    for( unsigned int i=0; i<numberOfNodes; ++i )
+    {
+      BranchNodeType::Pointer node = BranchNodeType::New();
+      node->SetNodeId( i+1 );
+      node->SetCenterline( CreateCenterline( settings.SectionsPerBranch ) );
+      nodes.push_back( node.GetPointer() );
+      
+      if( i > 0 )
+        nodes[(i-1)/2]->AddChild( node.GetPointer() );
+    }
+    
+    graph->SetRootNode( static_cast<ivan::VesselNode*>( nodes[0].GetPointer() ) );
+    
+    MemoryProbe probe;
+    probe.Start();
+    
+    FrozenVesselGraphType::Pointer frozenGraph = FrozenVesselGraphType::New();
+    frozenGraph->Freeze( graph );
+    
+    probe.Stop();
+    
+    AddResult( results, "graph", "FrozenVesselGraph", "Nodes", "nodes", numberOfNodes, probe );
+    
+    frozenGraph = 0;
+    ReleaseGraph( graph, nodes );
+  }
+}
+
+
+void WriteResults( std::ostream & os, const BenchmarkSettings & settings, 
+  const std::vector<BenchmarkResult> & results )
+{
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"memory\"," << std::endl;
+  os << "  \"version\": \"" << IVAN_VERSION_STRING << "\"," << std::endl;
+  os << "  \"imageSize\": " << settings.ImageSize << "," << std::endl;
+  os << "  \"sigma\": " << settings.Sigma << "," << std::endl;
+  os << "  \"sectionsPerBranch\": " << settings.SectionsPerBranch << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  
+  for( unsigned int i=0; i<results.size(); ++i )
+  {
+    const BenchmarkResult & result = results[i];
+    
+    // Per scale for the filters, and per thousand sections or nodes for the rest
+    const double units = ( result.Unit == "scales" ) ? result.NumberOfUnits : 
+      result.NumberOfUnits / 1000.0;
+    
+    os << "    { \"category\": \"" << result.Category << "\""
+       << ", \"name\": \"" << result.Name << "\""
+       << ", \"mode\": \"" << result.Mode << "\""
+       << ", \"unit\": \"" << result.Unit << "\""
+       << ", \"units\": " << result.NumberOfUnits
+       << ", \"allocations\": " << result.NumberOfAllocations
+       << ", \"allocatedBytes\": " << result.AllocatedBytes
+       << ", \"peakBytes\": " << result.PeakBytes
+       << ", \"retainedBytes\": " << result.RetainedBytes
+       << ", \"allocationsPerUnit\": " << ( units > 0.0 ? result.NumberOfAllocations / units : 0.0 )
+       << ", \"peakBytesPerUnit\": " << ( units > 0.0 ? result.PeakBytes / units : 0.0 )
+       << ", \"peakResidentSetSize\": " << result.PeakResidentSetSize << " }" 
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << std::endl;
+  }
+  
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputFileName.json [ImageSize=64] [Sigma=2.0] "
+              << "[NumberOfNodes=100000] [SectionsPerBranch=10]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  BenchmarkSettings settings;
+  settings.ImageSize = ( argc > 2 ) ? vnl_math_max( atoi( argv[2] ), 8 ) : 64;
+  settings.Sigma = ( argc > 3 ) ? atof( argv[3] ) : 2.0;
+  settings.NumberOfNodes = ( argc > 4 ) ? vnl_math_max( atoi( argv[4] ), 1 ) : 100000;
+  settings.SectionsPerBranch = ( argc > 5 ) ? vnl_math_max( atoi( argv[5] ), 1 ) : 10;
+  
+  typedef ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType>                MedialnessFilterType;
+  typedef ivan::MultiscaleHessianVesselnessMeasuresImageFilter<ImageType,ImageType> HessianFilterType;
+  typedef ivan::MultiscaleOptimallyOrientedFluxImageFilter<ImageType,ImageType>     OOFFilterType;
+  
+  typedef ivan::VesselnessRidgeSearchVesselTrackerFilter
+    <ImageType,VesselGraphType,VesselnessInterpolatorType>      RidgeSearchTrackerType;
+  
+  typedef ivan::Image3DPlaneFunctionToCostFunctionAdaptor<ImageType>  VesselnessCostFunctionType;
+  typedef ivan::OptimizedVesselnessBasedSearchVesselTrackerFilter
+    <ImageType,VesselGraphType,VesselnessInterpolatorType,
+    VesselnessCostFunctionType>                                 OptimizedSearchTrackerType;
+  
+  typedef itk::Statistics::NormalVariateGenerator  NormalGeneratorType;
+  typedef itk::OnePlusOneEvolutionaryOptimizer     OptimizerType;
+  
+  std::vector<BenchmarkResult> results;
+  
+  try
+  {
+    // Graphs first, from the smallest, since they need the least memory
+    for( unsigned int numberOfNodes = 1000; numberOfNodes <= settings.NumberOfNodes; numberOfNodes *= 10 )
+      RunGraphBenchmark( numberOfNodes, settings, results );
+    
+    // Trackers
+    {
+      typedef ivan::CircularGaussianToroidGenerator<PixelType>  ToroidGeneratorType;
+      
+      ToroidGeneratorType toroidGenerator;
+      toroidGenerator.SetSigma( settings.Sigma );
+      toroidGenerator.SetRadius( 20.0 );
+      toroidGenerator.SetImageSpacing( 1.0 );
+      toroidGenerator.SetMaxValue( 255.0 );
+      toroidGenerator.SetAutoComputeNumberOfPoints( true );
+      
+      ImageType::Pointer toroid = toroidGenerator.Create();
+      ImageType::Pointer vesselness = ComputeVesselness( toroid, settings.Sigma );
+      
+      const PointType startingPoint = toroidGenerator.GetCenterline()->ElementAt( 0 );
+      
+      VesselnessInterpolatorType::Pointer vesselnessFunction = VesselnessInterpolatorType::New();
+      vesselnessFunction->SetInputImage( vesselness );
+      
+      RidgeSearchTrackerType::Pointer ridgeSearchTracker = RidgeSearchTrackerType::New();
+      ridgeSearchTracker->SetVesselnessImageFunction( vesselnessFunction );
+      ridgeSearchTracker->SetRadialResolution( 3 );
+      ridgeSearchTracker->SetAngularResolution( 8 );
+      ridgeSearchTracker->SetMaximumSearchDistance( 1.5 * settings.Sigma );
+      
+      RunTrackingBenchmark( "VesselnessRidgeSearch", ridgeSearchTracker.GetPointer(), toroid,
+        startingPoint, settings, results );
+      
+      NormalGeneratorType::Pointer normalGenerator = NormalGeneratorType::New();
+      normalGenerator->Initialize( 12345 );
+      
+      OptimizerType::Pointer optimizer = OptimizerType::New();
+      optimizer->MaximizeOn();
+      optimizer->SetNormalVariateGenerator( normalGenerator );
+      optimizer->SetEpsilon( 1.0 );
+      optimizer->SetMaximumIteration( 100 );
+      
+      OptimizedSearchTrackerType::Pointer optimizedSearchTracker = OptimizedSearchTrackerType::New();
+      optimizedSearchTracker->SetVesselnessImageFunction( vesselnessFunction );
+      optimizedSearchTracker->SetOptimizer( optimizer );
+      
+      RunTrackingBenchmark( "OptimizedVesselnessBasedSearch", optimizedSearchTracker.GetPointer(), 
+        toroid, startingPoint, settings, results );
+    }
+    
+    // Detection filters, with an odd section size so the tube is centered
+    {
+      typedef ivan::CircularGaussianStraightTubeGenerator<PixelType>  GeneratorType;
+      
+      GeneratorType generator;
+      generator.SetSigma( settings.Sigma );
+      generator.SetHeight( settings.ImageSize );
+      generator.SetImageSpacing( 1.0 );
+      generator.SetRescale( true );
+      generator.SetMaxValue( 255.0 );
+      generator.SetSectionImageSize( ( settings.ImageSize % 2 == 0 ) ? 
+        settings.ImageSize + 1 : settings.ImageSize );
+      
+      ImageType::Pointer input = generator.Create();
+      
+      RunDetectionBenchmark<MedialnessFilterType>( "MultiscaleMedialness", input, settings, 
+        &SetMedialnessLeanOptions, results );
+      RunDetectionBenchmark<HessianFilterType>( "MultiscaleHessianVesselnessMeasures", input, 
+        settings, &SetNoLeanOptions<HessianFilterType>, results );
+      RunDetectionBenchmark<OOFFilterType>( "MultiscaleOptimallyOrientedFlux", input, settings, 
+        &SetNoLeanOptions<OOFFilterType>, results );
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::ofstream fileout( argv[1] );
+  
+  if( !fileout.is_open() )
+  {
+    std::cerr << "Could not open " << argv[1] << " for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  WriteResults( fileout, settings, results );
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,900 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanParameterSweepBenchmark.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: accuracy versus speed sweep of the sampling and kernel parameters of the image functions
+// Date: 2012/11/05
+//
+// Sweeps the parameters that trade accuracy for speed in the detection image functions, on straight 
+// Gaussian tube phantoms whose smoothed profile, and so the expected response of each function, is 
+// known in closed form. For each configuration it reports the evaluation throughput, and the RMS 
+// and maximum errors with respect to the analytic values at the voxels of a cross-section around 
+// the axis, relative to the largest analytic value. The configurations that are not beaten in both
+// error and throughput by another configuration of the same function form its Pareto front. The 
+// fastest configuration whose RMS error is within the required error is marked as selected.
+//
+// The swept parameters are:
+//   DiscreteHessianGaussian, DiscreteGradientGaussian: MaximumError and MaximumKernelWidth
+//   CircularSectionFlux: RadialResolution, evaluated in the exact section plane
+//   OptimallyOrientedFlux: sphere Decimation and UseQuadratureWeights, compared as the flux matrix
+//   MultiscaleSato: NumberOfScales and InterpolateSelectedScale, compared as the selected scale at 
+//     the axis of tubes with several deviations, which is the deviation itself for normalized 
+//     second derivatives
+//
+// The angular resolution of the ridge search tracker is not swept here, since it is measured
+// against the ground truth centerline by BenchmarkTracking. The sweep is not part of the 
+// performance check. Results are written as JSON.
+//
+// Usage: BenchmarkParameterSweep OutputFileName.json [Sigma=2.0] [RequiredError=0.02] [Repetitions=3]
+
+#include "ivanConfigure.h"
+
+#include "ivanCircularGaussianStraightTubeGenerator.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanCircularSectionFluxImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanSatoVesselnessImageFunction.h"
+#include "ivanMultiscaleImageFunction.h"
+
+#include "itkImage.h"
+#include "itkRealTimeClock.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+typedef float                                  PixelType;
+typedef itk::Image<PixelType,3>                ImageType;
+typedef ImageType::IndexType                   IndexType;
+typedef ImageType::PointType                   PointType;
+typedef std::vector<IndexType>                 IndexContainerType;
+typedef std::pair<std::string,double>          ParameterType;
+typedef std::vector<ParameterType>             ParameterContainerType;
+
+
+struct SweepSettings
+{
+  double         Sigma;
+  double         RequiredError;
+  unsigned int   Repetitions;
+  double         MinimumRepetitionTime;
+};
+
+
+struct SweepResult
+{
+  std::string              Function;
+  ParameterContainerType   Parameters;
+  unsigned long            NumberOfEvaluations;
+  double                   Time;
+  double                   EvaluationsPerSecond;
+  double                   RMSError;
+  double                   MaximumError;
+  bool                     Pareto;
+  bool                     Selected;
+};
+
+
+/** Straight tube along z with a Gaussian section of the given deviation and peak amplitude, 
+  * and the closed form values of the tube smoothed with a Gaussian of a given scale, with the
+  * derivatives normalized across scale as the image functions do. */
+class AnalyticTube
+{
+public:
+
+  AnalyticTube() : m_Amplitude( 0.0 ), m_Deviation( 1.0 ), m_CenterX( 0.0 ), m_CenterY( 0.0 ) {}
+  
+  AnalyticTube( double amplitude, double deviation, double centerX, double centerY ) :
+    m_Amplitude( amplitude ), m_Deviation( deviation ), m_CenterX( centerX ), m_CenterY( centerY ) {}
+  
+  double GetDeviation() const
+    { return m_Deviation; }
+  
+  /** Smoothed intensity, and its x and y derivatives of first and second order (xx, xy, yy). */
+  void Evaluate( double scale, double x, double y, double & value, double gradient[2], 
+    double hessian[3] ) const
+    {
+      const double variance = m_Deviation * m_Deviation + scale * scale;
+      const double dx = x - m_CenterX;
+      const double dy = y - m_CenterY;
+      
+      value = m_Amplitude * m_Deviation * m_Deviation / variance * 
+        vcl_exp( -( dx * dx + dy * dy ) / ( 2.0 * variance ) );
+      
+      gradient[0] = -scale * value * dx / variance;
+      gradient[1] = -scale * value * dy / variance;
+      
+      const double factor = scale * scale * value / ( variance * variance );
+      
+      hessian[0] = factor * ( dx * dx - variance );
+      hessian[1] = factor * dx * dy;
+      hessian[2] = factor * ( dy * dy - variance );
+    }
+  
+  /** Normalized gradient in x and y. The derivative in z is zero. */
+  void EvaluateGradient( double scale, double x, double y, double gradient[2] ) const
+    {
+      double value, hessian[3];
+      this->Evaluate( scale, x, y, value, gradient, hessian );
+    }
+  
+  /** Mean inward flux of the normalized gradient through the circle of the given radius in the 
+    * section plane. The integrand is periodic, so the uniform rule converges fast. */
+  double EvaluateCircularFlux( double scale, double radius, const PointType & point ) const
+    {
+      const unsigned int numberOfSamples = 1024;
+      double flux = 0.0, gradient[2];
+      
+      for( unsigned int i=0; i<numberOfSamples; ++i )
+      {
+        const double angle = 2.0 * vnl_math::pi * i / numberOfSamples;
+        const double c = vcl_cos( angle ), s = vcl_sin( angle );
+        
+        this->EvaluateGradient( scale, point[0] + radius * c, point[1] + radius * s, gradient );
+        flux -= gradient[0] * c + gradient[1] * s;
+      }
+      
+      return flux / numberOfSamples;
+    }
+  
+  /** Mean over the sphere of the given radius of the normalized gradient times the normal, 
+    * g_i n_j for i <= j in the order of the flux matrix, integrated on a fine latitude-longitude 
+    * grid. Components with i = 2 are zero. */
+  void EvaluateOrientedFlux( double scale, double radius, const PointType & point, double flux[6] ) const
+    {
+      const unsigned int numberOfPolarSamples = 256;
+      const unsigned int numberOfAzimuthalSamples = 512;
+      const double polarStep = vnl_math::pi / numberOfPolarSamples;
+      const double azimuthalStep = 2.0 * vnl_math::pi / numberOfAzimuthalSamples;
+      
+      std::fill( flux, flux + 6, 0.0 );
+      
+      double gradient[2];
+      
+      for( unsigned int i=0; i<numberOfPolarSamples; ++i )
+      {
+        const double polar = ( i + 0.5 ) * polarStep;
+        const double sinPolar = vcl_sin( polar ), cosPolar = vcl_cos( polar );
+        const double weight = sinPolar * polarStep * azimuthalStep / ( 4.0 * vnl_math::pi );
+        
+        for( unsigned int j=0; j<numberOfAzimuthalSamples; ++j )
+        {
+          const double azimuth = j * azimuthalStep;
+          const double normal[3] = 
+            { sinPolar * vcl_cos( azimuth ), sinPolar * vcl_sin( azimuth ), cosPolar };
+          
+          this->EvaluateGradient( scale, point[0] + radius * normal[0], point[1] + radius * normal[1], 
+            gradient );
+          
+          flux[0] += weight * gradient[0] * normal[0];
+          flux[1] += weight * gradient[0] * normal[1];
+          flux[2] += weight * gradient[0] * normal[2];
+          flux[3] += weight * gradient[1] * normal[1];
+          flux[4] += weight * gradient[1] * normal[2];
+        }
+      }
+    }
+  
+private:
+
+  double m_Amplitude;
+  double m_Deviation;
+  double m_CenterX;
+  double m_CenterY;
+};
+
+
+/** A tube phantom, its analytic description and the voxels where the functions are compared. */
+struct Phantom
+{
+  ImageType::Pointer    Image;
+  AnalyticTube          Tube;
+  IndexType             AxisIndex;
+  IndexContainerType    Indices;
+};
+
+
+/** Creates a tube of the given deviation, with room around it for the kernels of the given scale.
+  * The voxels are those of the middle section within twice the deviation from the axis. */
+Phantom CreatePhantom( double deviation, double scale )
+{
+  typedef ivan::CircularGaussianStraightTubeGenerator<PixelType>  GeneratorType;
+  
+  const double amplitude = 255.0;
+  
+  const unsigned long sectionImageSize = 2 * static_cast<unsigned long>( vcl_ceil( 12.0 * scale ) ) + 1;
+  const unsigned long height = 2 * static_cast<unsigned long>( vcl_ceil( 8.0 * scale ) ) + 1;
+  
+  GeneratorType generator;
+  generator.SetSigma( deviation );
+  generator.SetHeight( height );
+  generator.SetImageSpacing( 1.0 );
+  generator.SetSectionImageSize( sectionImageSize );
+  generator.SetRescale( true );
+  generator.SetMaxValue( amplitude );
+  generator.AnalyticProfileOn();
+  
+  Phantom phantom;
+  phantom.Image = generator.Create();
+  
+  // The generator centers the section at the middle voxel
+  phantom.AxisIndex[0] = ( sectionImageSize - 1 ) / 2;
+  phantom.AxisIndex[1] = ( sectionImageSize - 1 ) / 2;
+  phantom.AxisIndex[2] = height / 2;
+  
+  PointType center;
+  phantom.Image->TransformIndexToPhysicalPoint( phantom.AxisIndex, center );
+  
+  phantom.Tube = AnalyticTube( amplitude, deviation, center[0], center[1] );
+  
+  const long radius = static_cast<long>( vcl_ceil( 2.0 * deviation ) );
+  
+  IndexType index = phantom.AxisIndex;
+  
+  for( long y = -radius; y <= radius; ++y )
+  {
+    for( long x = -radius; x <= radius; ++x )
+    {
+      index[0] = phantom.AxisIndex[0] + x;
+      index[1] = phantom.AxisIndex[1] + y;
+      phantom.Indices.push_back( index );
+    }
+  }
+  
+  return phantom;
+}
+
+
+/** Measures the evaluations per second of an evaluator, which returns a value of each evaluation 
+  * for the checksum. Each repetition loops over the indices until the minimum repetition time has
+  * passed, and the fastest repetition is kept. */
+template <class TEvaluator>
+void MeasureThroughput( const TEvaluator & evaluator, const IndexContainerType & indices, 
+  const SweepSettings & settings, SweepResult & result )
+{
+  itk::RealTimeClock::Pointer clock = itk::RealTimeClock::New();
+  
+  double checksum = 0.0;
+  
+  result.EvaluationsPerSecond = 0.0;
+  
+  for( unsigned int j=0; j<settings.Repetitions; ++j )
+  {
+    unsigned long evaluations = 0;
+    double time = 0.0;
+    
+    const double start = clock->GetTimeStamp();
+    
+    do
+    {
+      for( unsigned int i=0; i<indices.size(); ++i )
+        checksum += evaluator( indices[i] );
+      
+      evaluations += indices.size();
+      time = clock->GetTimeStamp() - start;
+    }
+    while( time < settings.MinimumRepetitionTime );
+    
+    if( time > 0.0 && evaluations / time > result.EvaluationsPerSecond )
+    {
+      result.NumberOfEvaluations = evaluations;
+      result.Time = time;
+      result.EvaluationsPerSecond = evaluations / time;
+    }
+  }
+  
+  // The checksum is printed so that the evaluations are not optimized away
+  std::cout << result.Function << " [";
+  
+  for( unsigned int i=0; i<result.Parameters.size(); ++i )
+    std::cout << ( i ? ", " : "" ) << result.Parameters[i].first << " " << result.Parameters[i].second;
+  
+  std::cout << "]: " << result.EvaluationsPerSecond << " evaluations/s, RMS error " << result.RMSError 
+            << ", maximum error " << result.MaximumError << " (checksum " << checksum << ")" << std::endl;
+}
+
+
+/** Accumulates the squared errors of the points and the largest analytic norm. */
+class ErrorAccumulator
+{
+public:
+
+  ErrorAccumulator() : m_SumOfSquares( 0.0 ), m_MaximumSquare( 0.0 ), m_MaximumNormSquare( 0.0 ),
+    m_NumberOfPoints( 0 ) {}
+  
+  void Add( double squaredError, double squaredNorm )
+    {
+      m_SumOfSquares += squaredError;
+      m_MaximumSquare = vnl_math_max( m_MaximumSquare, squaredError );
+      m_MaximumNormSquare = vnl_math_max( m_MaximumNormSquare, squaredNorm );
+      ++m_NumberOfPoints;
+    }
+  
+  /** Store the errors relative to the largest analytic norm. */
+  void GetErrors( SweepResult & result ) const
+    {
+      const double norm = ( m_MaximumNormSquare > 0.0 ) ? vcl_sqrt( m_MaximumNormSquare ) : 1.0;
+      
+      result.RMSError = m_NumberOfPoints ? vcl_sqrt( m_SumOfSquares / m_NumberOfPoints ) / norm : 0.0;
+      result.MaximumError = vcl_sqrt( m_MaximumSquare ) / norm;
+    }
+  
+private:
+
+  double          m_SumOfSquares;
+  double          m_MaximumSquare;
+  double          m_MaximumNormSquare;
+  unsigned long   m_NumberOfPoints;
+};
+
+
+SweepResult CreateResult( const std::string & function, const ParameterContainerType & parameters )
+{
+  SweepResult result;
+  result.Function = function;
+  result.Parameters = parameters;
+  result.NumberOfEvaluations = 0;
+  result.Time = 0.0;
+  result.EvaluationsPerSecond = 0.0;
+  result.RMSError = 0.0;
+  result.MaximumError = 0.0;
+  result.Pareto = false;
+  result.Selected = false;
+  
+  return result;
+}
+
+
+ParameterContainerType KernelParameters( double maximumError, unsigned int maximumKernelWidth )
+{
+  ParameterContainerType parameters;
+  parameters.push_back( ParameterType( "maximumError", maximumError ) );
+  parameters.push_back( ParameterType( "maximumKernelWidth", maximumKernelWidth ) );
+  
+  return parameters;
+}
+
+
+const double MaximumErrors[] = { 0.1, 0.03, 0.01, 0.003, 0.001, 0.0001 };
+const unsigned int MaximumKernelWidths[] = { 8, 16, 32, 64 };
+
+const unsigned int NumberOfMaximumErrors = sizeof( MaximumErrors ) / sizeof( double );
+const unsigned int NumberOfMaximumKernelWidths = sizeof( MaximumKernelWidths ) / sizeof( unsigned int );
+
+
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>   HessianFunctionType;
+
+struct HessianEvaluator
+{
+  const HessianFunctionType *Function;
+  
+  double operator()( const IndexType & index ) const
+    { return this->Function->EvaluateAtIndex( index )[0]; }
+};
+
+
+void SweepHessian( const Phantom & phantom, const SweepSettings & settings, 
+  std::vector<SweepResult> & results )
+{
+  for( unsigned int e=0; e<NumberOfMaximumErrors; ++e )
+  {
+    for( unsigned int w=0; w<NumberOfMaximumKernelWidths; ++w )
+    {
+      HessianFunctionType::Pointer function = HessianFunctionType::New();
+      function->SetInputImage( phantom.Image );
+      function->SetSigma( settings.Sigma );
+      function->NormalizeAcrossScaleOn();
+      function->UseImageSpacingOn();
+      function->SetMaximumError( MaximumErrors[e] );
+      function->SetMaximumKernelWidth( MaximumKernelWidths[w] );
+      function->Initialize();
+      
+      SweepResult result = CreateResult( "DiscreteHessianGaussian", 
+        KernelParameters( MaximumErrors[e], MaximumKernelWidths[w] ) );
+      
+      // Frobenius norm, the z derivatives of the tube are zero
+      ErrorAccumulator errors;
+      
+      for( unsigned int i=0; i<phantom.Indices.size(); ++i )
+      {
+        PointType point;
+        phantom.Image->TransformIndexToPhysicalPoint( phantom.Indices[i], point );
+        
+        double value, gradient[2], expected[3];
+        phantom.Tube.Evaluate( settings.Sigma, point[0], point[1], value, gradient, expected );
+        
+        const HessianFunctionType::OutputType hessian = function->EvaluateAtIndex( phantom.Indices[i] );
+        
+        const double differences[6] = { hessian[0] - expected[0], hessian[1] - expected[1], hessian[2], 
+          hessian[3] - expected[2], hessian[4], hessian[5] };
+        
+        errors.Add( differences[0] * differences[0] + 2.0 * differences[1] * differences[1] +
+          2.0 * differences[2] * differences[2] + differences[3] * differences[3] + 
+          2.0 * differences[4] * differences[4] + differences[5] * differences[5],
+          expected[0] * expected[0] + 2.0 * expected[1] * expected[1] + expected[2] * expected[2] );
+      }
+      
+      errors.GetErrors( result );
+      
+      HessianEvaluator evaluator;
+      evaluator.Function = function;
+      MeasureThroughput( evaluator, phantom.Indices, settings, result );
+      
+      results.push_back( result );
+    }
+  }
+}
+
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>   GradientFunctionType;
+
+struct GradientEvaluator
+{
+  const GradientFunctionType *Function;
+  
+  double operator()( const IndexType & index ) const
+    { return this->Function->EvaluateAtIndex( index )[0]; }
+};
+
+
+void SweepGradient( const Phantom & phantom, const SweepSettings & settings, 
+  std::vector<SweepResult> & results )
+{
+  for( unsigned int e=0; e<NumberOfMaximumErrors; ++e )
+  {
+    for( unsigned int w=0; w<NumberOfMaximumKernelWidths; ++w )
+    {
+      GradientFunctionType::Pointer function = GradientFunctionType::New();
+      function->SetInputImage( phantom.Image );
+      function->SetSigma( settings.Sigma );
+      function->NormalizeAcrossScaleOn();
+      function->UseImageSpacingOn();
+      function->SetMaximumError( MaximumErrors[e] );
+      function->SetMaximumKernelWidth( MaximumKernelWidths[w] );
+      function->Initialize();
+      
+      SweepResult result = CreateResult( "DiscreteGradientGaussian", 
+        KernelParameters( MaximumErrors[e], MaximumKernelWidths[w] ) );
+      
+      ErrorAccumulator errors;
+      
+      for( unsigned int i=0; i<phantom.Indices.size(); ++i )
+      {
+        PointType point;
+        phantom.Image->TransformIndexToPhysicalPoint( phantom.Indices[i], point );
+        
+        double expected[2];
+        phantom.Tube.EvaluateGradient( settings.Sigma, point[0], point[1], expected );
+        
+        const GradientFunctionType::OutputType gradient = function->EvaluateAtIndex( phantom.Indices[i] );
+        
+        const double differences[3] = 
+          { gradient[0] - expected[0], gradient[1] - expected[1], gradient[2] };
+        
+        errors.Add( differences[0] * differences[0] + differences[1] * differences[1] + 
+          differences[2] * differences[2], expected[0] * expected[0] + expected[1] * expected[1] );
+      }
+      
+      errors.GetErrors( result );
+      
+      GradientEvaluator evaluator;
+      evaluator.Function = function;
+      MeasureThroughput( evaluator, phantom.Indices, settings, result );
+      
+      results.push_back( result );
+    }
+  }
+}
+
+
+typedef ivan::CircularSectionFluxImageFunction<ImageType,double>   CircularFluxFunctionType;
+
+/** Evaluates the flux in the section plane of the tube, so that the error is the one of the 
+  * circle sampling and not of the estimated orientation. */
+struct CircularFluxEvaluator
+{
+  const CircularFluxFunctionType         *Function;
+  const ImageType                        *Image;
+  CircularFluxFunctionType::VectorType    FirstBaseVector;
+  CircularFluxFunctionType::VectorType    SecondBaseVector;
+  
+  double operator()( const IndexType & index ) const
+    {
+      PointType point;
+      this->Image->TransformIndexToPhysicalPoint( index, point );
+      return this->Function->EvaluateInSection( point, this->FirstBaseVector, this->SecondBaseVector );
+    }
+};
+
+
+void SweepCircularSectionFlux( const Phantom & phantom, const SweepSettings & settings, 
+  std::vector<SweepResult> & results )
+{
+  const unsigned int radialResolutions[] = { 4, 6, 8, 12, 16, 24, 32 };
+  
+  for( unsigned int r=0; r < sizeof( radialResolutions ) / sizeof( unsigned int ); ++r )
+  {
+    CircularFluxFunctionType::Pointer function = CircularFluxFunctionType::New();
+    function->SetInputImage( phantom.Image );
+    function->SetSigma( settings.Sigma );
+    function->SetRadialResolution( radialResolutions[r] );
+    function->Initialize();
+    
+    ParameterContainerType parameters;
+    parameters.push_back( ParameterType( "radialResolution", radialResolutions[r] ) );
+    
+    SweepResult result = CreateResult( "CircularSectionFlux", parameters );
+    
+    CircularFluxEvaluator evaluator;
+    evaluator.Function = function;
+    evaluator.Image = phantom.Image;
+    evaluator.FirstBaseVector.Fill( 0.0 );
+    evaluator.FirstBaseVector[0] = 1.0;
+    evaluator.SecondBaseVector.Fill( 0.0 );
+    evaluator.SecondBaseVector[1] = 1.0;
+    
+    const double radius = function->GetRadiusFactor() * settings.Sigma;
+    
+    ErrorAccumulator errors;
+    
+    for( unsigned int i=0; i<phantom.Indices.size(); ++i )
+    {
+      PointType point;
+      phantom.Image->TransformIndexToPhysicalPoint( phantom.Indices[i], point );
+      
+      const double expected = phantom.Tube.EvaluateCircularFlux( settings.Sigma, radius, point );
+      const double difference = evaluator( phantom.Indices[i] ) - expected;
+      
+      errors.Add( difference * difference, expected * expected );
+    }
+    
+    errors.GetErrors( result );
+    
+    MeasureThroughput( evaluator, phantom.Indices, settings, result );
+    
+    results.push_back( result );
+  }
+}
+
+
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>                  EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>            OOFFunctionType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <OOFFunctionType,ImageType>                                              OOFInitializerType;
+
+struct OrientedFluxEvaluator
+{
+  const OOFFunctionType *Function;
+  
+  double operator()( const IndexType & index ) const
+    { return this->Function->EvaluateFluxMatrixAtIndex( index )[0]; }
+};
+
+
+void SweepOrientedFlux( const Phantom & phantom, const SweepSettings & settings, 
+  std::vector<SweepResult> & results )
+{
+  // Sphere radius and gradient scale of the OOF initializer
+  const double radius = vcl_sqrt( 3.0 ) * settings.Sigma;
+  const double gradientSigma = 1.0;
+  
+  // The analytic flux does not depend on the configuration
+  std::vector<double> expectedFlux( 6 * phantom.Indices.size() );
+  
+  for( unsigned int i=0; i<phantom.Indices.size(); ++i )
+  {
+    PointType point;
+    phantom.Image->TransformIndexToPhysicalPoint( phantom.Indices[i], point );
+    phantom.Tube.EvaluateOrientedFlux( gradientSigma, radius, point, &expectedFlux[6*i] );
+  }
+  
+  OOFInitializerType::Pointer initializer = OOFInitializerType::New();
+  
+  for( unsigned int decimation = 0; decimation <= 4; ++decimation )
+  {
+    for( unsigned int weights = 0; weights < 2; ++weights )
+    {
+      OOFFunctionType::Pointer function = OOFFunctionType::New();
+      function->SetDecimation( decimation );
+      function->SetUseQuadratureWeights( weights != 0 );
+      initializer->Initialize( function, phantom.Image, radius );
+      
+      ParameterContainerType parameters;
+      parameters.push_back( ParameterType( "decimation", decimation ) );
+      parameters.push_back( ParameterType( "useQuadratureWeights", weights ) );
+      
+      SweepResult result = CreateResult( "OptimallyOrientedFlux", parameters );
+      
+      // The flux matrix is a sum over the sphere points with weights of mean one
+      const double numberOfPoints = function->GetNumberOfSpherePoints();
+      
+      ErrorAccumulator errors;
+      
+      for( unsigned int i=0; i<phantom.Indices.size(); ++i )
+      {
+        const OOFFunctionType::FluxMatrixType flux = 
+          function->EvaluateFluxMatrixAtIndex( phantom.Indices[i] );
+        const double *expected = &expectedFlux[6*i];
+        
+        double squaredError = 0.0, squaredNorm = 0.0;
+        
+        for( unsigned int k=0; k<6; ++k )
+        {
+          const double difference = flux[k] / numberOfPoints - expected[k];
+          squaredError += difference * difference;
+          squaredNorm += expected[k] * expected[k];
+        }
+        
+        errors.Add( squaredError, squaredNorm );
+      }
+      
+      errors.GetErrors( result );
+      
+      OrientedFluxEvaluator evaluator;
+      evaluator.Function = function;
+      MeasureThroughput( evaluator, phantom.Indices, settings, result );
+      
+      results.push_back( result );
+    }
+  }
+}
+
+
+typedef ivan::SatoVesselnessImageFunction<ImageType,double>                      SatoFunctionType;
+typedef ivan::MultiscaleImageFunction<SatoFunctionType,ImageType,double>         MultiscaleFunctionType;
+typedef ivan::ScaleSpaceImageFunctionInitializer<SatoFunctionType,ImageType>     ScaledInitializerType;
+
+struct MultiscaleEvaluator
+{
+  const MultiscaleFunctionType *Function;
+  
+  double operator()( const IndexType & index ) const
+    {
+      double scale;
+      const double value = this->Function->EvaluateAtIndexAndSelectScale( index, scale );
+      return value + scale;
+    }
+};
+
+
+/** The scales of all the configurations span from half to twice the sigma. The selected scale is
+  * compared at the axis of the tubes, and the throughput is measured on the first one. */
+void SweepMultiscale( const std::vector<Phantom> & phantoms, const SweepSettings & settings, 
+  std::vector<SweepResult> & results )
+{
+  const unsigned int numbersOfScales[] = { 2, 3, 4, 6, 8, 12, 16 };
+  
+  for( unsigned int n=0; n < sizeof( numbersOfScales ) / sizeof( unsigned int ); ++n )
+  {
+    for( unsigned int interpolate = 0; interpolate < 2; ++interpolate )
+    {
+      ParameterContainerType parameters;
+      parameters.push_back( ParameterType( "numberOfScales", numbersOfScales[n] ) );
+      parameters.push_back( ParameterType( "interpolateSelectedScale", interpolate ) );
+      
+      SweepResult result = CreateResult( "MultiscaleSato", parameters );
+      
+      ErrorAccumulator errors;
+      MultiscaleFunctionType::Pointer throughputFunction;
+      
+      for( unsigned int p=0; p<phantoms.size(); ++p )
+      {
+        MultiscaleFunctionType::Pointer function = MultiscaleFunctionType::New();
+        function->SetInputImage( phantoms[p].Image );
+        function->SetScaledImageFunctionInitializer( ScaledInitializerType::New() );
+        function->SetScaleStepMethod( MultiscaleFunctionType::LogarithmicScaleSteps );
+        function->SetMinimumScale( 0.5 * settings.Sigma );
+        function->SetMaximumScale( 2.0 * settings.Sigma );
+        function->SetNumberOfScales( numbersOfScales[n] );
+        function->SetInterpolateSelectedScale( interpolate != 0 );
+        function->Initialize();
+        
+        double scale;
+        function->EvaluateAtIndexAndSelectScale( phantoms[p].AxisIndex, scale );
+        
+        // Relative to each deviation, so the largest norm is one
+        const double deviation = phantoms[p].Tube.GetDeviation();
+        const double difference = ( scale - deviation ) / deviation;
+        
+        errors.Add( difference * difference, 1.0 );
+        
+        if( p == 0 )
+          throughputFunction = function;
+      }
+      
+      errors.GetErrors( result );
+      
+      MultiscaleEvaluator evaluator;
+      evaluator.Function = throughputFunction;
+      MeasureThroughput( evaluator, phantoms[0].Indices, settings, result );
+      
+      results.push_back( result );
+    }
+  }
+}
+
+
+/** Marks the Pareto front and the selected configuration of the results of a function. */
+void SelectConfigurations( std::vector<SweepResult> & results, unsigned int begin, 
+  const SweepSettings & settings )
+{
+  int selected = -1;
+  
+  for( unsigned int i=begin; i<results.size(); ++i )
+  {
+    results[i].Pareto = true;
+    
+    for( unsigned int j=begin; j<results.size() && results[i].Pareto; ++j )
+    {
+      const bool noWorse = results[j].RMSError <= results[i].RMSError && 
+        results[j].EvaluationsPerSecond >= results[i].EvaluationsPerSecond;
+      const bool better = results[j].RMSError < results[i].RMSError || 
+        results[j].EvaluationsPerSecond > results[i].EvaluationsPerSecond;
+      
+      if( noWorse && better )
+        results[i].Pareto = false;
+    }
+    
+    if( results[i].RMSError <= settings.RequiredError && 
+        ( selected < 0 || results[i].EvaluationsPerSecond > results[selected].EvaluationsPerSecond ) )
+      selected = i;
+  }
+  
+  if( selected >= 0 )
+    results[selected].Selected = true;
+  
+  std::cout << "Pareto front of " << results[begin].Function << ":" << std::endl;
+  
+  for( unsigned int i=begin; i<results.size(); ++i )
+  {
+    if( !results[i].Pareto )
+      continue;
+    
+    std::cout << "  [";
+    
+    for( unsigned int k=0; k<results[i].Parameters.size(); ++k )
+      std::cout << ( k ? ", " : "" ) << results[i].Parameters[k].first << " " << results[i].Parameters[k].second;
+    
+    std::cout << "]: " << results[i].EvaluationsPerSecond << " evaluations/s, RMS error " 
+              << results[i].RMSError << ( results[i].Selected ? " (selected)" : "" ) << std::endl;
+  }
+  
+  if( selected < 0 )
+    std::cout << "  No configuration within the required error " << settings.RequiredError << std::endl;
+}
+
+
+void WriteResults( std::ostream & os, const SweepSettings & settings, 
+  const std::vector<SweepResult> & results )
+{
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"parameterSweep\"," << std::endl;
+  os << "  \"version\": \"" << IVAN_VERSION_STRING << "\"," << std::endl;
+  os << "  \"sigma\": " << settings.Sigma << "," << std::endl;
+  os << "  \"requiredError\": " << settings.RequiredError << "," << std::endl;
+  os << "  \"repetitions\": " << settings.Repetitions << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  
+  for( unsigned int i=0; i<results.size(); ++i )
+  {
+    os << "    { \"function\": \"" << results[i].Function << "\", \"parameters\": { ";
+    
+    for( unsigned int k=0; k<results[i].Parameters.size(); ++k )
+      os << ( k ? ", " : "" ) << "\"" << results[i].Parameters[k].first << "\": " 
+         << results[i].Parameters[k].second;
+    
+    os << " }"
+       << ", \"evaluations\": " << results[i].NumberOfEvaluations
+       << ", \"time\": " << results[i].Time
+       << ", \"evaluationsPerSecond\": " << results[i].EvaluationsPerSecond
+       << ", \"rmsError\": " << results[i].RMSError
+       << ", \"maximumError\": " << results[i].MaximumError
+       << ", \"pareto\": " << ( results[i].Pareto ? "true" : "false" )
+       << ", \"selected\": " << ( results[i].Selected ? "true" : "false" ) << " }"
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << std::endl;
+  }
+  
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputFileName.json [Sigma=2.0] [RequiredError=0.02] [Repetitions=3]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  SweepSettings settings;
+  settings.Sigma = ( argc > 2 ) ? atof( argv[2] ) : 2.0;
+  settings.RequiredError = ( argc > 3 ) ? atof( argv[3] ) : 0.02;
+  settings.Repetitions = ( argc > 4 ) ? vnl_math_max( atoi( argv[4] ), 1 ) : 3;
+  settings.MinimumRepetitionTime = 0.05;
+  
+  // Small maximum errors truncate the kernels at the narrow maximum widths on purpose
+  itk::Object::GlobalWarningDisplayOff();
+  
+  std::vector<SweepResult> results;
+  
+  try
+  {
+    const Phantom phantom = CreatePhantom( settings.Sigma, settings.Sigma );
+    
+    unsigned int begin = results.size();
+    SweepHessian( phantom, settings, results );
+    SelectConfigurations( results, begin, settings );
+    
+    begin = results.size();
+    SweepGradient( phantom, settings, results );
+    SelectConfigurations( results, begin, settings );
+    
+    begin = results.size();
+    SweepCircularSectionFlux( phantom, settings, results );
+    SelectConfigurations( results, begin, settings );
+    
+    begin = results.size();
+    SweepOrientedFlux( phantom, settings, results );
+    SelectConfigurations( results, begin, settings );
+    
+    // Tubes with deviations inside the scale range, with room for the largest scale
+    std::vector<Phantom> phantoms;
+    phantoms.push_back( phantom );
+    phantoms.push_back( CreatePhantom( 0.75 * settings.Sigma, 2.0 * settings.Sigma ) );
+    phantoms.push_back( CreatePhantom( 1.25 * settings.Sigma, 2.0 * settings.Sigma ) );
+    phantoms.push_back( CreatePhantom( 1.5 * settings.Sigma, 2.0 * settings.Sigma ) );
+    
+    begin = results.size();
+    SweepMultiscale( phantoms, settings, results );
+    SelectConfigurations( results, begin, settings );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::ofstream fileout( argv[1] );
+  
+  if( !fileout.is_open() )
+  {
+    std::cerr << "Could not open " << argv[1] << " for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  WriteResults( fileout, settings, results );
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,515 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTrackingBenchmark.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: speed and centerline accuracy benchmark of the vessel trackers on synthetic phantoms
+// Date: 2012/11/05
+//
+// End-to-end tracking benchmark. Each tracker is run with each section estimator on the toroid,
+// helix and curved tube phantoms, whose centerlines are known. For every combination it reports 
+// the tracked sections per second and mean latency per step, together with the distance from 
+// the tracked centers to the ground truth centerline, so that speed can not be gained silently 
+// at the expense of accuracy. Each combination is run several times and the fastest run is kept.
+// Results are written as JSON.
+//
+// Usage: BenchmarkTracking OutputFileName.json [Sigma=2.0] [Repetitions=3]
+
+#include "ivanConfigure.h"
+
+#include "ivanCircularGaussianToroidGenerator.h"
+#include "ivanCircularGaussianHelixGenerator.h"
+#include "ivanCurvedCircularGaussianTubeGenerator.h"
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselnessRidgeSearchVesselTrackerFilter.h"
+#include "ivanOptimizedVesselnessBasedSearchVesselTrackerFilter.h"
+#include "ivanImage3DPlaneFunctionToCostFunctionAdaptor.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+#include "ivanFixedScaleOOFBasedVesselSectionEstimator.h"
+#include "ivanMultiscaleAdaptiveHessianBasedVesselSectionEstimator.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+#include "ivanOffsetMedialnessImageFunction.h"
+#include "ivanOffsetMedialnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkVectorContainer.h"
+#include "itkMultiScaleHessianBasedMeasureImageFilter.h"
+#include "itkHessianToObjectnessMeasureImageFilter.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNormalVariateGenerator.h"
+#include "itkOnePlusOneEvolutionaryOptimizer.h"
+#include "itkTimeProbe.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                       PixelType;
+typedef itk::Image<PixelType,Dimension>             ImageType;
+typedef ImageType::PointType                        PointType;
+typedef itk::VectorContainer<unsigned int,PointType>  PointContainerType;
+
+typedef ivan::CircularVesselSection<Dimension>                      VesselSectionType;
+typedef ivan::VesselCenterline<unsigned int, VesselSectionType>     CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                           VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>                      BranchNodeType;
+typedef ivan::VesselSectionEstimator<CenterlineType>                SectionEstimatorType;
+
+typedef itk::LinearInterpolateImageFunction<ImageType>              VesselnessInterpolatorType;
+
+
+/** A phantom with its ground truth centerline and vesselness image. */
+struct Phantom
+{
+  std::string                         Name;
+  ImageType::Pointer                  Image;
+  ImageType::Pointer                  Vesselness;
+  PointContainerType::ConstPointer    Centerline;
+};
+
+
+struct BenchmarkSettings
+{
+  double         Sigma;
+  unsigned int   Repetitions;
+};
+
+
+struct BenchmarkResult
+{
+  std::string    Tracker;
+  std::string    SectionEstimator;
+  std::string    Phantom;
+  unsigned int   NumberOfSections;
+  double         Time;
+  double         SectionsPerSecond;
+  double         StepLatency;
+  double         MeanError;
+  double         RMSError;
+  double         MaximumError;
+};
+
+
+/** Distance from a point to the polyline joining the centerline points. */
+double GetDistanceToCenterline( const PointContainerType *centerline, const PointType & point )
+{
+  double minimumSquaredDistance = itk::NumericTraits<double>::max();
+  
+  for( unsigned int i=0; i + 1 < centerline->Size(); ++i )
+  {
+    const PointType & a = centerline->ElementAt(i);
+    const PointType & b = centerline->ElementAt(i+1);
+    
+    const PointType::VectorType segment = b - a;
+    const PointType::VectorType relative = point - a;
+    
+    const double squaredLength = segment.GetSquaredNorm();
+    
+    double t = ( squaredLength > 0.0 ) ? ( relative * segment ) / squaredLength : 0.0;
+    t = vnl_math_max( 0.0, vnl_math_min( 1.0, t ) );
+    
+    minimumSquaredDistance = vnl_math_min( minimumSquaredDistance, 
+      ( relative - segment * t ).GetSquaredNorm() );
+  }
+  
+  return vcl_sqrt( minimumSquaredDistance );
+}
+
+
+double GetCenterlineLength( const PointContainerType *centerline )
+{
+  double length = 0.0;
+  
+  for( unsigned int i=0; i + 1 < centerline->Size(); ++i )
+    length += centerline->ElementAt(i).EuclideanDistanceTo( centerline->ElementAt(i+1) );
+    
+  return length;
+}
+
+
+/** Single scale objectness, rescaled to [0,255] as in the tracker tests. */
+ImageType::Pointer ComputeVesselness( ImageType *image, double sigma )
+{
+  typedef itk::SymmetricSecondRankTensor<PixelType,Dimension>  HessianPixelType;
+  typedef itk::Image<HessianPixelType,Dimension>               HessianImageType;
+  
+  typedef itk::HessianToObjectnessMeasureImageFilter
+    <HessianImageType,ImageType>                               ObjectnessFilterType;
+  typedef itk::MultiScaleHessianBasedMeasureImageFilter
+    <ImageType,HessianImageType,ImageType>                     MultiscaleFilterType;
+  typedef itk::RescaleIntensityImageFilter<ImageType,ImageType>  RescalerType;
+  
+  ObjectnessFilterType::Pointer objectnessFilter = ObjectnessFilterType::New();
+  objectnessFilter->SetScaleObjectnessMeasure( false );
+  objectnessFilter->SetBrightObject( true );
+  objectnessFilter->SetAlpha( 0.5 );
+  objectnessFilter->SetBeta( 0.5 );
+  objectnessFilter->SetGamma( 5.0 );
+  
+  MultiscaleFilterType::Pointer multiscaleFilter = MultiscaleFilterType::New();
+  multiscaleFilter->SetInput( image );
+  multiscaleFilter->SetHessianToMeasureFilter( objectnessFilter );
+  multiscaleFilter->SetSigmaStepMethodToLogarithmic();
+  multiscaleFilter->SetNumberOfSigmaSteps( 1 );
+  multiscaleFilter->SetSigmaMinimum( sigma );
+  multiscaleFilter->SetSigmaMaximum( sigma );
+  
+  RescalerType::Pointer rescaler = RescalerType::New();
+  rescaler->SetInput( multiscaleFilter->GetOutput() );
+  rescaler->SetOutputMinimum( 0.0 );
+  rescaler->SetOutputMaximum( 255.0 );
+  rescaler->Update();
+  
+  ImageType::Pointer vesselness = rescaler->GetOutput();
+  vesselness->DisconnectPipeline();
+  
+  return vesselness;
+}
+
+
+void CreatePhantoms( double sigma, std::vector<Phantom> & phantoms )
+{
+  typedef ivan::CircularGaussianToroidGenerator<PixelType>       ToroidGeneratorType;
+  typedef ivan::CircularGaussianHelixGenerator<PixelType>        HelixGeneratorType;
+  typedef ivan::CurvedCircularGaussianTubeGenerator<PixelType>   CurvedTubeGeneratorType;
+  
+  Phantom toroid;
+  toroid.Name = "toroid";
+  
+  ToroidGeneratorType toroidGenerator;
+  toroidGenerator.SetSigma( sigma );
+  toroidGenerator.SetRadius( 20.0 );
+  toroidGenerator.SetImageSpacing( 1.0 );
+  toroidGenerator.SetMaxValue( 255.0 );
+  toroidGenerator.SetAutoComputeNumberOfPoints( true );
+  toroid.Image = toroidGenerator.Create();
+  toroid.Centerline = toroidGenerator.GetCenterline();
+  phantoms.push_back( toroid );
+  
+  Phantom helix;
+  helix.Name = "helix";
+  
+  HelixGeneratorType helixGenerator;
+  helixGenerator.SetSigma( sigma );
+  helixGenerator.SetRadius( 20.0 );
+  helixGenerator.SetImageSpacing( 1.0 );
+  helixGenerator.SetMaxValue( 255.0 );
+  helixGenerator.SetAutoComputeNumberOfPoints( true );
+  helix.Image = helixGenerator.Create();
+  helix.Centerline = helixGenerator.GetCenterline();
+  phantoms.push_back( helix );
+  
+  Phantom curvedTube;
+  curvedTube.Name = "curved";
+  
+  const unsigned long height = 80;
+  unsigned long sectionImageSize = static_cast<unsigned long>( 10.0 * sigma ) + height / 4;
+  if( sectionImageSize % 2 == 0 )
+    sectionImageSize += 1;
+  
+  CurvedTubeGeneratorType curvedTubeGenerator;
+  curvedTubeGenerator.SetSigma( sigma );
+  curvedTubeGenerator.SetHeight( height );
+  curvedTubeGenerator.SetImageSpacing( 1.0 );
+  curvedTubeGenerator.SetSectionImageSize( sectionImageSize );
+  curvedTubeGenerator.SetMaxValue( 255.0 );
+  curvedTubeGenerator.SetMaxXOffset( 0.2 * height );
+  curvedTube.Image = curvedTubeGenerator.Create();
+  curvedTube.Centerline = curvedTubeGenerator.GetCenterline();
+  phantoms.push_back( curvedTube );
+  
+  for( unsigned int i=0; i<phantoms.size(); ++i )
+    phantoms[i].Vesselness = ComputeVesselness( phantoms[i].Image, sigma );
+}
+
+
+SectionEstimatorType::Pointer CreateSectionEstimator( const std::string & name, ImageType *image, 
+  double sigma )
+{
+  typedef ivan::OffsetMedialnessImageFunction<ImageType,double>              MetricFunctionType;
+  typedef ivan::OffsetMedialnessImageFunctionInitializer<ImageType,double>   MetricFunctionInitializerType;
+  typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>             VectorFieldType;
+  
+  if( name == "FixedScaleHessian" )
+  {
+    typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+      <ImageType,CenterlineType>                                             EstimatorType;
+    
+    EstimatorType::Pointer estimator = EstimatorType::New();
+    estimator->SetImage( image );
+    estimator->SetScale( sigma );
+    
+    return estimator.GetPointer();
+  }
+  else if( name == "FixedScaleOOF" )
+  {
+    typedef ivan::FixedScaleOOFBasedVesselSectionEstimator
+      <ImageType,VectorFieldType,CenterlineType>                             EstimatorType;
+    
+    EstimatorType::Pointer estimator = EstimatorType::New();
+    estimator->SetImage( image );
+    estimator->SetRadius( vcl_sqrt( 2.0 ) * sigma );
+    estimator->SetGradientSigma( 1.0 );
+    estimator->Initialize();
+    
+    return estimator.GetPointer();
+  }
+  else if( name == "MultiscaleAdaptiveHessian" )
+  {
+    typedef ivan::MultiscaleAdaptiveHessianBasedVesselSectionEstimator
+      <ImageType,MetricFunctionType,CenterlineType>                          EstimatorType;
+    
+    EstimatorType::Pointer estimator = EstimatorType::New();
+    estimator->SetImage( image );
+    estimator->SetMetricFunctionInitializer( MetricFunctionInitializerType::New() );
+    estimator->SetScaleStepMethod( EstimatorType::LogarithmicScaleSteps );
+    estimator->SetNumberOfScales( 4 );
+    estimator->SetMinimumScale( 0.5 * sigma );
+    estimator->SetMaximumScale( 2.0 * sigma );
+    estimator->Initialize();
+    
+    return estimator.GetPointer();
+  }
+  else if( name == "MultiscaleAdaptiveOOF" )
+  {
+    typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+      <ImageType,MetricFunctionType,VectorFieldType,CenterlineType>          EstimatorType;
+    
+    EstimatorType::Pointer estimator = EstimatorType::New();
+    estimator->SetImage( image );
+    estimator->SetMetricFunctionInitializer( MetricFunctionInitializerType::New() );
+    estimator->SetScaleStepMethod( EstimatorType::LogarithmicScaleSteps );
+    estimator->SetNumberOfScales( 4 );
+    estimator->SetMinimumScale( sigma );
+    estimator->SetMaximumScale( 3.0 * sigma );
+    estimator->Initialize();
+    
+    return estimator.GetPointer();
+  }
+  
+  itkGenericExceptionMacro( "Unknown section estimator: " << name );
+}
+
+
+/** Run the tracker, which has its vesselness function set, with every section estimator. */
+template <class TTracker>
+void RunBenchmark( const std::string & trackerName, TTracker *tracker, const Phantom & phantom,
+  const BenchmarkSettings & settings, std::vector<BenchmarkResult> & results )
+{
+  const char *estimatorNames[] = 
+    { "FixedScaleHessian", "FixedScaleOOF", "MultiscaleAdaptiveHessian", "MultiscaleAdaptiveOOF" };
+  
+  // Track both ways from the middle of the centerline, each direction covering a bit less 
+  // than half of it, so that the tracker does not leave the vessel or overlap on the toroid
+  const PointType startingPoint = phantom.Centerline->ElementAt( phantom.Centerline->Size() / 2 );
+  const double stepSize = 1.0;
+  
+  typedef ivan::MaxIterationsVesselTrackerEndCondition  EndConditionType;
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( static_cast<unsigned int>
+    ( 0.45 * GetCenterlineLength( phantom.Centerline ) / stepSize ) );
+  
+  tracker->SetInput( phantom.Image );
+  tracker->SetStartingPoint( startingPoint );
+  tracker->SetInitialStepSize( stepSize );
+  tracker->SetBidirectional( true );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  for( unsigned int e=0; e < sizeof( estimatorNames ) / sizeof( const char * ); ++e )
+  {
+    SectionEstimatorType::Pointer estimator = 
+      CreateSectionEstimator( estimatorNames[e], phantom.Image, settings.Sigma );
+    tracker->SetSectionEstimator( estimator );
+    
+    double bestTime = itk::NumericTraits<double>::max();
+    
+    for( unsigned int j=0; j<settings.Repetitions; ++j )
+    {
+      tracker->Modified();
+      
+      itk::TimeProbe probe;
+      probe.Start();
+      tracker->Update();
+      probe.Stop();
+      
+      bestTime = vnl_math_min( bestTime, static_cast<double>( probe.GetMeanTime() ) );
+    }
+    
+    BranchNodeType::Pointer branch = static_cast<BranchNodeType*>
+      ( tracker->GetOutput()->GetRootNode().GetPointer() );
+    CenterlineType::Pointer centerline = branch->GetCenterline();
+    
+    BenchmarkResult result;
+    result.Tracker = trackerName;
+    result.SectionEstimator = estimatorNames[e];
+    result.Phantom = phantom.Name;
+    result.NumberOfSections = centerline->Size();
+    result.Time = bestTime;
+    result.SectionsPerSecond = ( bestTime > 0.0 ) ? result.NumberOfSections / bestTime : 0.0;
+    result.StepLatency = ( result.NumberOfSections > 0 ) ? bestTime / result.NumberOfSections : 0.0;
+    result.MeanError = 0.0;
+    result.RMSError = 0.0;
+    result.MaximumError = 0.0;
+    
+    for( unsigned int i=0; i<centerline->Size(); ++i )
+    {
+      const double error = GetDistanceToCenterline( phantom.Centerline, centerline->at(i)->GetCenter() );
+      
+      result.MeanError += error;
+      result.RMSError += error * error;
+      result.MaximumError = vnl_math_max( result.MaximumError, error );
+    }
+    
+    if( result.NumberOfSections > 0 )
+    {
+      result.MeanError /= result.NumberOfSections;
+      result.RMSError = vcl_sqrt( result.RMSError / result.NumberOfSections );
+    }
+    
+    std::cout << trackerName << ", " << estimatorNames[e] << ", " << phantom.Name << ": "
+              << result.SectionsPerSecond << " sections/s, mean error " << result.MeanError << std::endl;
+    
+    results.push_back( result );
+  }
+}
+
+
+void WriteResults( std::ostream & os, const BenchmarkSettings & settings, 
+  const std::vector<BenchmarkResult> & results )
+{
+  os << "{" << std::endl;
+  os << "  \"benchmark\": \"tracking\"," << std::endl;
+  os << "  \"version\": \"" << IVAN_VERSION_STRING << "\"," << std::endl;
+  os << "  \"sigma\": " << settings.Sigma << "," << std::endl;
+  os << "  \"repetitions\": " << settings.Repetitions << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  
+  for( unsigned int i=0; i<results.size(); ++i )
+  {
+    os << "    { \"tracker\": \"" << results[i].Tracker << "\""
+       << ", \"sectionEstimator\": \"" << results[i].SectionEstimator << "\""
+       << ", \"phantom\": \"" << results[i].Phantom << "\""
+       << ", \"sections\": " << results[i].NumberOfSections
+       << ", \"time\": " << results[i].Time
+       << ", \"sectionsPerSecond\": " << results[i].SectionsPerSecond
+       << ", \"stepLatency\": " << results[i].StepLatency
+       << ", \"meanError\": " << results[i].MeanError
+       << ", \"rmsError\": " << results[i].RMSError
+       << ", \"maximumError\": " << results[i].MaximumError << " }" 
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << std::endl;
+  }
+  
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputFileName.json [Sigma=2.0] [Repetitions=3]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  BenchmarkSettings settings;
+  settings.Sigma = ( argc > 2 ) ? atof( argv[2] ) : 2.0;
+  settings.Repetitions = ( argc > 3 ) ? vnl_math_max( atoi( argv[3] ), 1 ) : 3;
+  
+  typedef ivan::VesselnessRidgeSearchVesselTrackerFilter
+    <ImageType,VesselGraphType,VesselnessInterpolatorType>      RidgeSearchTrackerType;
+  
+  typedef ivan::Image3DPlaneFunctionToCostFunctionAdaptor<ImageType>  VesselnessCostFunctionType;
+  typedef ivan::OptimizedVesselnessBasedSearchVesselTrackerFilter
+    <ImageType,VesselGraphType,VesselnessInterpolatorType,
+    VesselnessCostFunctionType>                                 OptimizedSearchTrackerType;
+  
+  typedef itk::Statistics::NormalVariateGenerator  NormalGeneratorType;
+  typedef itk::OnePlusOneEvolutionaryOptimizer     OptimizerType;
+  
+  std::vector<BenchmarkResult> results;
+  
+  try
+  {
+    std::vector<Phantom> phantoms;
+    CreatePhantoms( settings.Sigma, phantoms );
+    
+    for( unsigned int i=0; i<phantoms.size(); ++i )
+    {
+      VesselnessInterpolatorType::Pointer vesselness = VesselnessInterpolatorType::New();
+      vesselness->SetInputImage( phantoms[i].Vesselness );
+      
+      RidgeSearchTrackerType::Pointer ridgeSearchTracker = RidgeSearchTrackerType::New();
+      ridgeSearchTracker->SetVesselnessImageFunction( vesselness );
+      ridgeSearchTracker->SetRadialResolution( 3 );
+      ridgeSearchTracker->SetAngularResolution( 8 );
+      ridgeSearchTracker->SetMaximumSearchDistance( 1.5 * settings.Sigma );
+      
+      RunBenchmark( "VesselnessRidgeSearch", ridgeSearchTracker.GetPointer(), phantoms[i], 
+        settings, results );
+      
+      // Fixed seed so that every run follows the same optimization path
+      NormalGeneratorType::Pointer normalGenerator = NormalGeneratorType::New();
+      normalGenerator->Initialize( 12345 );
+      
+      OptimizerType::Pointer optimizer = OptimizerType::New();
+      optimizer->MaximizeOn();
+      optimizer->SetNormalVariateGenerator( normalGenerator );
+      optimizer->SetEpsilon( 1.0 );
+      optimizer->SetMaximumIteration( 100 );
+      
+      OptimizedSearchTrackerType::Pointer optimizedSearchTracker = OptimizedSearchTrackerType::New();
+      optimizedSearchTracker->SetVesselnessImageFunction( vesselness );
+      optimizedSearchTracker->SetOptimizer( optimizer );
+      
+      RunBenchmark( "OptimizedVesselnessBasedSearch", optimizedSearchTracker.GetPointer(), phantoms[i], 
+        settings, results );
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::ofstream fileout( argv[1] );
+  
+  if( !fileout.is_open() )
+  {
+    std::cerr << "Could not open " << argv[1] << " for writing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  WriteResults( fileout, settings, results );
+  
+  return EXIT_SUCCESS;
+}
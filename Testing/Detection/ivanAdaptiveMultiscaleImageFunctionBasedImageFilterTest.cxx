@@ -0,0 +1,161 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAdaptiveMultiscaleImageFunctionBasedImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the adaptive multiscale evaluation of Frangi's vesselness with the evaluation at every pixel.
+
+#include "ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.h"
+#include "ivanMultiscaleImageFunction.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>                   VesselnessFunctionType;
+typedef ivan::MultiscaleImageFunction<VesselnessFunctionType,ImageType,double>  MultiscaleFunctionType;
+
+typedef ivan::AdaptiveMultiscaleImageFunctionBasedImageFilter
+  <ImageType,ImageType,MultiscaleFunctionType>                                  FilterType;
+
+
+/** Sets up the scales of the multiscale function created by the filter for each thread. */
+class MultiscaleFunctionInitializer : 
+  public ivan::ImageFunctionInitializerBase<MultiscaleFunctionType,ImageType>
+{
+public:
+
+  typedef MultiscaleFunctionInitializer                                         Self;
+  typedef ivan::ImageFunctionInitializerBase<MultiscaleFunctionType,ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                               Pointer;
+
+  itkNewMacro( Self );
+
+  virtual void Initialize( MultiscaleFunctionType *imageFunction, const ImageType *image = 0, double scale = 0.0 )
+    {
+      typedef ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType>  ScaledInitializerType;
+      
+      imageFunction->SetInputImage( image );
+      imageFunction->SetScaledImageFunctionInitializer( ScaledInitializerType::New() );
+      imageFunction->SetMinimumScale( 1.0 );
+      imageFunction->SetMaximumScale( 4.0 );
+      imageFunction->SetNumberOfScales( 4 );
+      imageFunction->Initialize();
+    }
+};
+
+
+ImageType::Pointer ComputeVesselness( ImageType *image, bool adaptive, double & evaluationRatio )
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetImageFunctionInitializer( MultiscaleFunctionInitializer::New() );
+  filter->SetThreshold( -1.0 );
+  filter->SetAdaptiveEvaluation( adaptive );
+  filter->SetRefinementThreshold( 1e-3 );
+  filter->Update();
+  
+  evaluationRatio = filter->GetEvaluationRatio();
+  
+  return filter->GetOutput();
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum difference relative to the maximum response
+  const double tolerance = ( argc > 1 ) ? atof( argv[1] ) : 0.01;
+  
+  // Synthetic tube of gaussian section oblique to the axes
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 40 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 14.0;
+    const double dy = it.GetIndex()[1] - 19.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  double denseRatio, adaptiveRatio;
+  ImageType::Pointer reference = ComputeVesselness( image, false, denseRatio );
+  ImageType::Pointer output = ComputeVesselness( image, true, adaptiveRatio );
+  
+  double maxError = 0.0, maxValue = 0.0;
+  
+  itk::ImageRegionConstIterator<ImageType> rit( reference, region );
+  itk::ImageRegionConstIterator<ImageType> oit( output, region );
+  
+  for( rit.GoToBegin(), oit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++oit )
+  {
+    maxValue = std::max( maxValue, (double)std::fabs( rit.Get() ) );
+    maxError = std::max( maxError, (double)std::fabs( rit.Get() - oit.Get() ) );
+  }
+  
+  const double relativeError = ( maxValue > 0.0 ) ? maxError / maxValue : 0.0;
+  
+  std::cout << "Evaluation ratio: " << adaptiveRatio << " Relative error: " << relativeError << std::endl;
+  
+  if( maxValue <= 0.0 )
+  {
+    std::cerr << "No response on the tube" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( relativeError > tolerance )
+  {
+    std::cerr << "Adaptive evaluation differs from the evaluation at every pixel" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( adaptiveRatio >= 1.0 )
+  {
+    std::cerr << "Adaptive evaluation did not save any evaluation" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
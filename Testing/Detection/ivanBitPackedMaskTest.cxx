@@ -0,0 +1,191 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBitPackedMaskTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the pixels, count and runs of a packed mask against the mask image and its
+//   run-length encoding.
+// Date: 2012/11/05
+
+#include "ivanBitPackedMask.h"
+#include "ivanMaskRunLengthEncoding.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+
+
+typedef itk::Image<short,3>                           MaskImageType;
+typedef ivan::BitPackedMask<3>                        PackedMaskType;
+typedef ivan::MaskRunLengthEncoding<MaskImageType>    EncodingType;
+
+
+bool SameRuns( const EncodingType::RunContainerType & runs, const EncodingType::RunContainerType & expectedRuns )
+{
+  if( runs.size() != expectedRuns.size() )
+  {
+    std::cerr << "There are " << runs.size() << " runs, expected " << expectedRuns.size() << std::endl;
+    return false;
+  }
+  
+  for( unsigned int i=0; i<runs.size(); ++i )
+  {
+    if( runs[i].Index != expectedRuns[i].Index || runs[i].Length != expectedRuns[i].Length )
+    {
+      std::cerr << "Run " << i << " at " << runs[i].Index << " of length " << runs[i].Length 
+        << ", expected at " << expectedRuns[i].Index << " of length " << expectedRuns[i].Length << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  // Lines of 150 pixels, not a multiple of the word, from a negative start
+  MaskImageType::IndexType start;
+  start[0] = -70; start[1] = 3; start[2] = -2;
+  
+  MaskImageType::SizeType size;
+  size[0] = 150; size[1] = 20; size[2] = 10;
+  
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( MaskImageType::RegionType( start, size ) );
+  mask->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<MaskImageType> it( mask, mask->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const MaskImageType::IndexType index = it.GetIndex();
+    
+    // Long runs that fill whole words, empty lines and scattered pixels
+    bool inside;
+    
+    if( index[1] < 8 )
+      inside = ( index[0] >= -60 && index[0] < 75 );
+    else if( index[1] < 12 )
+      inside = false;
+    else
+      inside = ( ( index[0] * index[0] + 3 * index[1] + index[2] ) % 5 + 5 ) % 5 < 2;
+    
+    it.Set( inside ? -3 : 0 );
+  }
+  
+  PackedMaskType::Pointer packedMask = PackedMaskType::New();
+  packedMask->PackNonZeroPixels( mask.GetPointer(), mask->GetBufferedRegion(), 4 );
+  
+  // Same pixels as the image
+  unsigned long numberOfPixels = 0;
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const bool inside = ( it.Get() != 0 );
+    
+    if( packedMask->GetPixel( it.GetIndex() ) != inside )
+    {
+      std::cerr << "Pixel " << it.GetIndex() << " is wrong in the packed mask" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( inside )
+      ++numberOfPixels;
+  }
+  
+  if( packedMask->GetNumberOfPixels() != numberOfPixels || packedMask->IsEmpty() )
+  {
+    std::cerr << "Number of pixels is " << packedMask->GetNumberOfPixels() << ", expected " 
+      << numberOfPixels << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The runs built from the words are the runs of the image
+  EncodingType::Pointer imageEncoding = EncodingType::New();
+  imageEncoding->SetMaskImage( mask );
+  imageEncoding->Initialize();
+  
+  EncodingType::Pointer packedEncoding = EncodingType::New();
+  packedEncoding->SetPackedMask( packedMask );
+  packedEncoding->Initialize();
+  
+  if( !SameRuns( packedEncoding->GetRuns(), imageEncoding->GetRuns() ) || 
+      packedEncoding->GetBoundingBox() != imageEncoding->GetBoundingBox() )
+  {
+    std::cerr << "Wrong runs of the packed mask" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Regions that start and end inside words
+  MaskImageType::IndexType clipStart;
+  clipStart[0] = -65; clipStart[1] = 5; clipStart[2] = 0;
+  
+  MaskImageType::SizeType clipSize;
+  clipSize[0] = 131; clipSize[1] = 12; clipSize[2] = 5;
+  
+  const MaskImageType::RegionType clipRegions[] = 
+    { MaskImageType::RegionType( clipStart, clipSize ), MaskImageType::RegionType( start, clipSize ) };
+  
+  for( unsigned int i=0; i<2; ++i )
+  {
+    EncodingType::RunContainerType clippedRuns;
+    packedMask->GetRunsInRegion( clipRegions[i], clippedRuns );
+    
+    EncodingType::RunContainerType expectedRuns;
+    imageEncoding->GetRunsInRegion( clipRegions[i], expectedRuns );
+    
+    if( !SameRuns( clippedRuns, expectedRuns ) )
+    {
+      std::cerr << "Wrong runs clipped to " << clipRegions[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Packing with a single thread gives the same mask, and cleared pixels are out of the mask
+  PackedMaskType::Pointer serialMask = PackedMaskType::New();
+  serialMask->PackNonZeroPixels( mask.GetPointer(), mask->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( serialMask->GetPixel( it.GetIndex() ) != packedMask->GetPixel( it.GetIndex() ) )
+    {
+      std::cerr << "Pixel " << it.GetIndex() << " differs with one thread" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    serialMask->SetPixel( it.GetIndex(), false );
+  }
+  
+  if( !serialMask->IsEmpty() || serialMask->GetNumberOfPixels() != 0 )
+  {
+    std::cerr << "The cleared mask is not empty" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBrickedImageBufferTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that neighborhoods gathered from the bricked copy of an image, and the 
+//   functions evaluated with it, are the same as those computed from the image.
+
+#include "ivanBrickedImageBuffer.h"
+#include "ivanNeighborhoodInnerProduct.h"
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                            PixelType;
+typedef itk::Image<PixelType,Dimension>                  ImageType;
+typedef ivan::BrickedImageBuffer<ImageType,8>            BrickedImageType;
+typedef ivan::NeighborhoodInnerProduct<ImageType,double> InnerProductType;
+
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType>  HessianFunctionType;
+
+
+int main( int, char ** )
+{
+  // Size not multiple of the brick size, and a start index other than zero
+  ImageType::IndexType start;
+  start[0] = -3;
+  start[1] = 2;
+  start[2] = 5;
+  
+  ImageType::SizeType size;
+  size[0] = 21;
+  size[1] = 13;
+  size[2] = 18;
+  
+  ImageType::RegionType region( start, size );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    it.Set( 100.0 * sin( 0.3 * index[0] ) * cos( 0.2 * index[1] ) + 7.0 * index[2] );
+  }
+  
+  BrickedImageType::Pointer bricked = BrickedImageType::New();
+  bricked->CopyImage( image );
+  
+  if( !bricked->IsCopyOf( image ) || bricked->GetNumberOfBricks() != 3 * 2 * 3 )
+  {
+    std::cerr << "Wrong bricked copy, " << bricked->GetNumberOfBricks() << " bricks" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Every pixel
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( bricked->GetPixel( it.GetIndex() ) != it.Get() )
+    {
+      std::cerr << "Wrong pixel at " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Neighborhoods inside, across the bricks and beyond the boundary
+  ImageType::SizeType radius;
+  radius.Fill( 4 );
+  
+  InnerProductType::BufferType expected, gathered;
+  ImageType::IndexType index;
+  
+  for( index[2] = start[2] - 2; index[2] < start[2] + (long)size[2] + 2; index[2] += 3 )
+  {
+    for( index[1] = start[1] - 2; index[1] < start[1] + (long)size[1] + 2; index[1] += 3 )
+    {
+      for( index[0] = start[0] - 2; index[0] < start[0] + (long)size[0] + 2; index[0] += 3 )
+      {
+        InnerProductType::Gather( image, index, radius, expected );
+        bricked->Gather( index, radius, gathered );
+        
+        if( expected != gathered )
+        {
+          std::cerr << "Wrong neighborhood at " << index << std::endl;
+          return EXIT_FAILURE;
+        }
+        
+        // Scratch buffers on the stack, as used by the image functions
+        ImageType::RegionType neighborhoodRegion;
+        
+        for( unsigned int d=0; d<Dimension; ++d )
+        {
+          neighborhoodRegion.SetIndex( d, index[d] - (long)radius[d] );
+          neighborhoodRegion.SetSize( d, 2 * radius[d] + 1 );
+        }
+        
+        InnerProductType::ScratchBufferType scratch( expected.size() );
+        InnerProductType::GatherRegion( image, bricked, neighborhoodRegion, scratch.GetDataPointer() );
+        
+        if( !scratch.IsStoredInBuffer() || 
+          !std::equal( expected.begin(), expected.end(), scratch.GetDataPointer() ) )
+        {
+          std::cerr << "Wrong scratch neighborhood at " << index << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  
+  // Linear interpolation
+  typedef itk::LinearInterpolateImageFunction<ImageType,double> InterpolatorType;
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( image );
+  
+  BrickedImageType::ContinuousIndexType cindex;
+  
+  for( unsigned int i=0; i<50; ++i )
+  {
+    cindex[0] = start[0] + 0.37 * i;
+    cindex[1] = start[1] + 0.23 * i;
+    cindex[2] = start[2] + 0.31 * i;
+    
+    InterpolatorType::ContinuousIndexType interpolatorIndex;
+    for( unsigned int d=0; d<Dimension; ++d )
+      interpolatorIndex[d] = cindex[d];
+    
+    const double value = bricked->EvaluateLinearAtContinuousIndex( cindex );
+    const double expectedValue = interpolator->EvaluateAtContinuousIndex( interpolatorIndex );
+    
+    if( fabs( value - expectedValue ) > 1e-6 * ( 1.0 + fabs( expectedValue ) ) )
+    {
+      std::cerr << "Interpolated value is " << value << ", expected " << expectedValue << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The Hessian function gives the same values with and without the bricked copy
+  HessianFunctionType::Pointer hessian[2];
+  
+  for( unsigned int f=0; f<2; ++f )
+  {
+    hessian[f] = HessianFunctionType::New();
+    hessian[f]->SetInputImage( image );
+    hessian[f]->SetSigma( 1.5 );
+    hessian[f]->SetUseSeparableEvaluation( f == 1 );
+    hessian[f]->SetBrickedImage( bricked );
+    hessian[f]->Initialize();
+  }
+  
+  HessianFunctionType::Pointer reference = HessianFunctionType::New();
+  reference->SetInputImage( image );
+  reference->SetSigma( 1.5 );
+  reference->Initialize();
+  
+  for( index[2] = start[2]; index[2] < start[2] + (long)size[2]; index[2] += 5 )
+  {
+    for( index[1] = start[1]; index[1] < start[1] + (long)size[1]; index[1] += 4 )
+    {
+      for( index[0] = start[0]; index[0] < start[0] + (long)size[0]; index[0] += 4 )
+      {
+        const HessianFunctionType::OutputType expectedHessian = reference->EvaluateAtIndex( index );
+        
+        for( unsigned int f=0; f<2; ++f )
+        {
+          const HessianFunctionType::OutputType value = hessian[f]->EvaluateAtIndex( index );
+          
+          for( unsigned int i=0; i<value.Size(); ++i )
+          {
+            if( fabs( value[i] - expectedHessian[i] ) > 1e-3 * ( 1.0 + fabs( expectedHessian[i] ) ) )
+            {
+              std::cerr << "Hessian of function " << f << " at " << index << " is " << value 
+                << ", expected " << expectedHessian << std::endl;
+              return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  }
+  
+  // A modified image is not read from the outdated copy
+  image->Modified();
+  
+  if( bricked->IsCopyOf( image ) )
+  {
+    std::cerr << "Outdated copy not detected" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
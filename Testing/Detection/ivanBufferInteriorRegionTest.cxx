@@ -0,0 +1,184 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBufferInteriorRegionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the samples around the centers of the interior region of a buffer, with
+//   their margins, are inside the buffer.
+// Date: 2012/11/05
+
+#include "ivanBufferInteriorRegion.h"
+
+#include "itkImage.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<float,3>                                    ImageType;
+  typedef ivan::BufferInteriorRegion<ImageType>                  InteriorType;
+  typedef itk::LinearInterpolateImageFunction<ImageType,double>  InterpolatorType;
+  
+  // Anisotropic, rotated image with a non-zero buffered region start
+  ImageType::IndexType start;
+  start[0] = 2; start[1] = -3; start[2] = 5;
+  
+  ImageType::SizeType size;
+  size[0] = 40; size[1] = 30; size[2] = 25;
+  
+  ImageType::RegionType region( start, size );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5; spacing[1] = 0.75; spacing[2] = 1.5;
+  
+  ImageType::PointType origin;
+  origin[0] = -3.0; origin[1] = 1.0; origin[2] = 2.0;
+  
+  const double angle = 0.3;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0,0) = cos( angle ); direction(0,1) = -sin( angle );
+  direction(1,0) = sin( angle ); direction(1,1) = cos( angle );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->SetDirection( direction );
+  image->Allocate();
+  
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( image );
+  
+  InteriorType interior;
+  
+  interior.Compute( 1.0, 0.0 );
+  
+  if( !interior.IsEmpty() )
+  {
+    std::cerr << "The interior without image is not empty" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  interior.SetImage( image );
+  
+  srand( 1 );
+  
+  unsigned int numberOfInteriorCenters = 0;
+  
+  for( unsigned int t=0; t < 100000; ++t )
+  {
+    const double radius = 0.5 + 5.0 * rand() / RAND_MAX;
+    const double margin = t % 3;
+    
+    interior.Compute( radius, margin );
+    
+    // Centers over the whole buffer and a bit outside
+    InteriorType::ContinuousIndexType center;
+    
+    for( unsigned int k=0; k < 3; ++k )
+      center[k] = start[k] - 2.0 + ( size[k] + 3.0 ) * rand() / RAND_MAX;
+    
+    if( !interior.IsInside( center ) )
+      continue;
+    
+    ++numberOfInteriorCenters;
+    
+    InteriorType::PointType centerPoint;
+    image->TransformContinuousIndexToPhysicalPoint( center, centerPoint );
+    
+    if( !interior.IsInside( centerPoint ) )
+    {
+      std::cerr << "Center " << center << " is inside as an index but not as a point" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Random sample in the ball of the radius
+    double displacement[3];
+    double norm = 0.0;
+    
+    for( unsigned int k=0; k < 3; ++k )
+    {
+      displacement[k] = 2.0 * rand() / RAND_MAX - 1.0;
+      norm += displacement[k] * displacement[k];
+    }
+    
+    const double distance = radius * rand() / RAND_MAX / std::sqrt( norm );
+    
+    InteriorType::PointType samplePoint;
+    
+    for( unsigned int k=0; k < 3; ++k )
+      samplePoint[k] = centerPoint[k] + distance * displacement[k];
+    
+    InteriorType::ContinuousIndexType sample;
+    image->TransformPhysicalPointToContinuousIndex( samplePoint, sample );
+    
+    if( !interpolator->IsInsideBuffer( samplePoint ) )
+    {
+      std::cerr << "Sample " << sample << " of interior center " << center << " is outside" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int k=0; k < 3; ++k )
+    {
+      if( sample[k] - margin < start[k] || sample[k] + margin > start[k] + size[k] - 1.0 )
+      {
+        std::cerr << "The margin " << margin << " of sample " << sample << " of interior center " 
+          << center << " is outside" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  std::cout << "Interior centers: " << numberOfInteriorCenters << std::endl;
+  
+  // The interior is not much smaller than needed
+  ImageType::IndexType middle;
+  
+  for( unsigned int k=0; k < 3; ++k )
+    middle[k] = start[k] + size[k] / 2;
+  
+  interior.Compute( 5.0, 1.0 );
+  
+  if( !numberOfInteriorCenters || !interior.IsInside( middle ) )
+  {
+    std::cerr << "The interior is too small" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Spheres larger than the image have no interior
+  interior.Compute( 100.0, 0.0 );
+  
+  if( !interior.IsEmpty() || interior.IsInside( middle ) )
+  {
+    std::cerr << "The interior of a large radius is not empty" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
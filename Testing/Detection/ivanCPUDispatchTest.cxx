@@ -0,0 +1,334 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCPUDispatchTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the tile convolution kernels of each available instruction set.
+
+#include "ivanCPUDispatch.h"
+#include "ivanSeparableLineConvolution.h"
+#include "ivanPixelRowConverter.h"
+#include "ivanHalfFloat.h"
+
+#include "vcl_cmath.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+
+void ConvolveTile( const double *tile, unsigned long length, const double *kernel, 
+  unsigned int kernelSize, double *result )
+{
+  ivan::CPUDispatch::GetKernels().ConvolveTileDouble( tile, length, kernel, kernelSize, result );
+}
+
+
+void ConvolveTile( const float *tile, unsigned long length, const float *kernel, 
+  unsigned int kernelSize, float *result )
+{
+  ivan::CPUDispatch::GetKernels().ConvolveTileFloat( tile, length, kernel, kernelSize, result );
+}
+
+
+/** Conversion of a row of short pixels with the active kernels. */
+template <class TValue>
+bool CompareConversion()
+{
+  // Extremes of short, and a length that is not a multiple of the register width
+  const unsigned long length = 67;
+  
+  std::vector<short> row( length );
+  
+  for( unsigned long i=0; i<length; ++i )
+    row[i] = static_cast<short>( static_cast<long>( ( i * 7919 ) % 65536 ) - 32768 );
+  row[0] = -32768;
+  row[1] = 32767;
+  
+  std::vector<TValue> result( length + 1, static_cast<TValue>( -1 ) );
+  ivan::PixelRowConverter<short,TValue>::Convert( &row[0], length, &result[0] );
+  
+  for( unsigned long i=0; i<length; ++i )
+  {
+    if( result[i] != static_cast<TValue>( row[i] ) )
+    {
+      std::cerr << ivan::CPUDispatch::GetActiveInstructionSetName() << " conversion gives " 
+        << result[i] << " at " << i << ", expected " << row[i] << std::endl;
+      return false;
+    }
+  }
+  
+  if( result[length] != static_cast<TValue>( -1 ) )
+  {
+    std::cerr << ivan::CPUDispatch::GetActiveInstructionSetName() << " conversion writes past the row" << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+/** Conversion of half-precision values with the active kernels, against the single values. */
+bool CompareHalfConversion()
+{
+  typedef ivan::HalfFloat   HalfType;
+  
+  // Every half value, widened; NaNs only have to stay NaNs
+  const unsigned long numberOfHalves = 65536;
+  
+  std::vector<HalfType> halves( numberOfHalves );
+  std::vector<float> widened( numberOfHalves + 1, -1.0f );
+  
+  for( unsigned long i=0; i<numberOfHalves; ++i )
+    halves[i] = HalfType::FromBits( static_cast<HalfType::BitsType>( i ) );
+  
+  HalfType::ConvertToFloat( &halves[0], numberOfHalves, &widened[0] );
+  
+  for( unsigned long i=0; i<numberOfHalves; ++i )
+  {
+    const float expected = HalfType::ToFloat( static_cast<HalfType::BitsType>( i ) );
+    
+    if( ( expected == expected ) ? ( widened[i] != expected ) : ( widened[i] == widened[i] ) )
+    {
+      std::cerr << ivan::CPUDispatch::GetActiveInstructionSetName() << " widens half " << i 
+        << " to " << widened[i] << ", expected " << expected << std::endl;
+      return false;
+    }
+  }
+  
+  // Floats around the ranges of the normal and subnormal halves, ties included
+  std::vector<float> values;
+  
+  for( unsigned long i=0; i<100000; ++i )
+  {
+    const float magnitude = static_cast<float>( vcl_pow( 2.0, -30.0 + 48.0 * i / 100000.0 ) );
+    values.push_back( ( i % 2 ) ? -magnitude : magnitude );
+  }
+  
+  for( int e=-26; e<17; ++e )
+  {
+    const double unit = vcl_pow( 2.0, static_cast<double>( e ) );
+    values.push_back( static_cast<float>( unit * ( 1.0 + 1.0 / 2048.0 ) ) );
+    values.push_back( static_cast<float>( unit * ( 1.0 + 3.0 / 2048.0 ) ) );
+  }
+  
+  values.push_back( 0.0f );
+  values.push_back( 65504.0f );
+  values.push_back( 65519.0f );
+  values.push_back( 65520.0f );
+  values.push_back( -1e30f );
+  
+  std::vector<HalfType> narrowed( values.size() + 1, HalfType::FromBits( 0x1234 ) );
+  HalfType::ConvertFromFloat( &values[0], values.size(), &narrowed[0] );
+  
+  for( unsigned long i=0; i<values.size(); ++i )
+  {
+    if( narrowed[i].GetBits() != HalfType::ToBits( values[i] ) )
+    {
+      std::cerr << ivan::CPUDispatch::GetActiveInstructionSetName() << " narrows " << values[i] 
+        << " to half " << narrowed[i].GetBits() << ", expected " << HalfType::ToBits( values[i] ) << std::endl;
+      return false;
+    }
+  }
+  
+  if( widened[numberOfHalves] != -1.0f || narrowed[values.size()].GetBits() != 0x1234 )
+  {
+    std::cerr << ivan::CPUDispatch::GetActiveInstructionSetName() << " half conversion writes past the row" << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+template <class TValue>
+bool CompareKernels(ivan::CPUDispatch::InstructionSetType instructionSet, double tolerance )
+{
+  typedef ivan::CPUDispatch   DispatchType;
+  
+  const unsigned int width = DispatchType::TileWidth;
+  const unsigned long length = 37;
+  const unsigned int kernelSize = 9;
+  
+  std::vector<TValue> tile( ( length + kernelSize - 1 ) * width );
+  std::vector<TValue> kernel( kernelSize );
+  
+  for( unsigned int i=0; i<tile.size(); ++i )
+    tile[i] = static_cast<TValue>( vcl_sin( 0.37 * i ) + 0.01 * ( i % 7 ) );
+  for( unsigned int k=0; k<kernelSize; ++k )
+    kernel[k] = static_cast<TValue>( vcl_exp( -0.1 * ( k - 4.0 ) * ( k - 4.0 ) ) );
+  
+  std::vector<TValue> expected( length * width ), result( length * width );
+  
+  // Reference sums in double precision
+  for( unsigned long i=0; i<length; ++i )
+  {
+    for( unsigned int b=0; b<width; ++b )
+    {
+      double sum = 0.0;
+      for( unsigned int k=0; k<kernelSize; ++k )
+        sum += static_cast<double>( kernel[k] ) * static_cast<double>( tile[ ( i + k ) * width + b ] );
+      expected[ i * width + b ] = static_cast<TValue>( sum );
+    }
+  }
+  
+  DispatchType::SetMaximumInstructionSet( instructionSet );
+  
+  if( DispatchType::GetActiveInstructionSet() != instructionSet )
+  {
+    std::cerr << DispatchType::GetInstructionSetName( instructionSet ) << " is available but "
+      << DispatchType::GetActiveInstructionSetName() << " is active" << std::endl;
+    return false;
+  }
+  
+  ConvolveTile( &tile[0], length, &kernel[0], kernelSize, &result[0] );
+  
+  for( unsigned int i=0; i<result.size(); ++i )
+  {
+    if( vcl_fabs( static_cast<double>( result[i] - expected[i] ) ) > tolerance )
+    {
+      std::cerr << DispatchType::GetActiveInstructionSetName() << " kernel gives " << result[i] 
+        << " at " << i << ", expected " << expected[i] << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::CPUDispatch   DispatchType;
+  
+  std::cout << "Active instruction set: " << DispatchType::GetActiveInstructionSetName() << std::endl;
+  
+  DispatchType::InstructionSetType initial = DispatchType::GetActiveInstructionSet();
+  DispatchType::InstructionSetType initialMaximum = DispatchType::GetMaximumInstructionSet();
+  
+  if( !DispatchType::IsSupported( initial ) || !DispatchType::IsCompiled( initial ) )
+  {
+    std::cerr << "The active instruction set is not available" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( int set = DispatchType::Generic; set < DispatchType::NumberOfInstructionSets; ++set )
+  {
+    DispatchType::InstructionSetType instructionSet = static_cast<DispatchType::InstructionSetType>( set );
+    
+    std::cout << DispatchType::GetInstructionSetName( instructionSet ) << ": " 
+      << ( DispatchType::IsSupported( instructionSet ) ? "supported" : "not supported" ) << ", "
+      << ( DispatchType::IsCompiled( instructionSet ) ? "compiled" : "not compiled" ) << std::endl;
+    
+    if( !DispatchType::IsSupported( instructionSet ) || !DispatchType::IsCompiled( instructionSet ) )
+      continue;
+    
+    // Fused multiply-adds and the order of the sums may change the last bits
+    if( !CompareKernels<double>( instructionSet, 1e-12 ) || !CompareKernels<float>( instructionSet, 1e-4 ) )
+      return EXIT_FAILURE;
+    
+    // Short pixels are exactly representable in float and double
+    if( !CompareConversion<double>() || !CompareConversion<float>() )
+      return EXIT_FAILURE;
+    
+    if( !CompareHalfConversion() )
+      return EXIT_FAILURE;
+  }
+  
+  // The initial selection is restored with the initial maximum
+  DispatchType::SetMaximumInstructionSet( initialMaximum );
+  
+  if( DispatchType::GetActiveInstructionSet() != initial )
+  {
+    std::cerr << "Selection is not restored, " << DispatchType::GetActiveInstructionSetName() << " is active" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Rounding of single values to nearest even, and the limits of the half range
+  const float roundingValues[] = { 1.0f, 1.0f + 1.0f / 2048.0f, 1.0f + 3.0f / 2048.0f, -2.0f, 
+    65504.0f, 65520.0f, 5.9604645e-8f, 2.9802322e-8f, 6.1035156e-5f };
+  const unsigned short roundingBits[] = { 0x3c00, 0x3c00, 0x3c02, 0xc000, 
+    0x7bff, 0x7c00, 0x0001, 0x0000, 0x0400 };
+  
+  for( unsigned int i=0; i<9; ++i )
+  {
+    if( ivan::HalfFloat::ToBits( roundingValues[i] ) != roundingBits[i] )
+    {
+      std::cerr << "Half of " << roundingValues[i] << " is " << ivan::HalfFloat::ToBits( roundingValues[i] ) 
+        << ", expected " << roundingBits[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A strided convolution pass givesthe same result as the direct sums
+  typedef ivan::SeparableLineConvolution<2,float>   ConvolutionType;
+  
+  const unsigned long sizeX = 21, sizeY = 13;
+  std::vector<float> source( sizeX * sizeY ), destination( sizeX * sizeY );
+  
+  for( unsigned int i=0; i<source.size(); ++i )
+    source[i] = static_cast<float>( vcl_cos( 0.21 * i ) );
+  
+  ConvolutionType::KernelType kernel( 3 );
+  kernel[0] = 0.25f;
+  kernel[1] = 0.5f;
+  kernel[2] = 0.25f;
+  
+  ConvolutionType::BufferView<const float> sourceView;
+  ConvolutionType::BufferView<float> destinationView;
+  
+  sourceView.Pointer = &source[0];
+  destinationView.Pointer = &destination[0];
+  
+  sourceView.Index[0] = destinationView.Index[0] = 0;
+  sourceView.Index[1] = destinationView.Index[1] = 0;
+  sourceView.Size[0] = destinationView.Size[0] = sizeX;
+  sourceView.Size[1] = destinationView.Size[1] = sizeY;
+  sourceView.Stride[0] = destinationView.Stride[0] = 1;
+  sourceView.Stride[1] = destinationView.Stride[1] = sizeX;
+  
+  ConvolutionType::Convolve( sourceView, destinationView, 1, kernel, 0, 
+    ConvolutionType::GetNumberOfUnits( destinationView, 1 ) );
+  
+  for( unsigned long y=0; y<sizeY; ++y )
+  {
+    const unsigned long previous = ( y > 0 ) ? y - 1 : 0;
+    const unsigned long next = ( y + 1 < sizeY ) ? y + 1 : sizeY - 1;
+    
+    for( unsigned long x=0; x<sizeX; ++x )
+    {
+      const float expected = 0.25f * source[ previous * sizeX + x ] + 0.5f * source[ y * sizeX + x ] + 
+        0.25f * source[ next * sizeX + x ];
+      
+      if( vcl_fabs( destination[ y * sizeX + x ] - expected ) > 1e-5 )
+      {
+        std::cerr << "Strided convolution gives " << destination[ y * sizeX + x ] << " at (" 
+          << x << "," << y << "), expected " << expected << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
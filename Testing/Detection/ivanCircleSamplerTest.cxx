@@ -0,0 +1,153 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCircleSamplerTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares circle samples with per-point transforms and inside buffer tests.
+
+#include "ivanCircleSampler.h"
+
+#include "itkImage.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkVector.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<float,3>                                    ImageType;
+  typedef ivan::CircleSampler<ImageType>                         SamplerType;
+  typedef itk::LinearInterpolateImageFunction<ImageType,double>  InterpolatorType;
+  typedef itk::Vector<double,3>                                  VectorType;
+  
+  // Anisotropic, rotated image with a non-zero buffered region start
+  ImageType::IndexType start;
+  start[0] = 2; start[1] = -3; start[2] = 5;
+  
+  ImageType::SizeType size;
+  size[0] = 20; size[1] = 15; size[2] = 10;
+  
+  ImageType::RegionType region( start, size );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5; spacing[1] = 0.75; spacing[2] = 1.5;
+  
+  ImageType::PointType origin;
+  origin[0] = -3.0; origin[1] = 1.0; origin[2] = 2.0;
+  
+  const double angle = 0.3;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0,0) = cos( angle ); direction(0,1) = -sin( angle );
+  direction(1,0) = sin( angle ); direction(1,1) = cos( angle );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->SetDirection( direction );
+  image->Allocate();
+  
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( image );
+  
+  SamplerType sampler;
+  sampler.SetImage( image );
+  
+  // Center near the border so that part of the circles fall outside
+  ImageType::IndexType centerIndex;
+  centerIndex[0] = start[0] + 2; centerIndex[1] = start[1] + 7; centerIndex[2] = start[2] + 5;
+  
+  SamplerType::PointType center;
+  image->TransformIndexToPhysicalPoint( centerIndex, center );
+  
+  VectorType firstBaseVector, secondBaseVector;
+  firstBaseVector[0] = 1.0; firstBaseVector[1] = 0.0; firstBaseVector[2] = 0.0;
+  secondBaseVector[0] = 0.0; secondBaseVector[1] = 0.6; secondBaseVector[2] = 0.8;
+  
+  const double tolerance = 1e-9;
+  const unsigned int numberOfSamples[] = { 7, 24, 200 }; // the last one exceeds the stack capacity
+  
+  for( unsigned int n=0; n<3; ++n )
+  {
+    sampler.SetNumberOfSamples( numberOfSamples[n] );
+    
+    for( double radius = 0.5; radius < 6.0; radius += 1.25 )
+    {
+      SamplerType::SampleSet samples( numberOfSamples[n] );
+      sampler.Sample( center, radius, firstBaseVector, secondBaseVector, samples );
+      
+      unsigned int numberOfInsideSamples = 0;
+      
+      for( unsigned int i=0; i<numberOfSamples[n]; ++i )
+      {
+        SamplerType::PointType point, expectedPoint;
+        SamplerType::ContinuousIndexType cindex, expectedIndex;
+        
+        for( unsigned int k=0; k<3; ++k )
+          expectedPoint[k] = center[k] + radius * ( sampler.GetCosArray()[i] * firstBaseVector[k] + 
+            sampler.GetSinArray()[i] * secondBaseVector[k] );
+          
+        image->TransformPhysicalPointToContinuousIndex( expectedPoint, expectedIndex );
+        
+        samples.GetPoint( i, point );
+        samples.GetContinuousIndex( i, cindex );
+        
+        for( unsigned int k=0; k<3; ++k )
+        {
+          if( std::fabs( point[k] - expectedPoint[k] ) > tolerance || 
+              std::fabs( cindex[k] - expectedIndex[k] ) > tolerance )
+          {
+            std::cerr << "Sample " << i << " of " << numberOfSamples[n] << " at radius " << radius 
+              << " is " << point << " / " << cindex << ", expected " << expectedPoint 
+              << " / " << expectedIndex << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+        
+        if( samples.IsInside( i ) != interpolator->IsInsideBuffer( expectedPoint ) )
+        {
+          std::cerr << "Inside flag of sample " << i << " at " << expectedPoint << " is " 
+            << samples.IsInside( i ) << ", expected " << !samples.IsInside( i ) << std::endl;
+          return EXIT_FAILURE;
+        }
+        
+        if( samples.IsInside( i ) )
+          ++numberOfInsideSamples;
+      }
+      
+      if( numberOfInsideSamples != samples.GetNumberOfInsideSamples() )
+      {
+        std::cerr << "Number of inside samples is " << samples.GetNumberOfInsideSamples() 
+          << ", expected " << numberOfInsideSamples << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteDerivativeCacheTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests storage, retrieval and eviction of values in the derivative cache, and the
+//   accuracy of the half-precision storage.
+
+#include "ivanDiscreteDerivativeCache.h"
+
+#include "ivanFrangiVesselnessImageFunction.h"
+
+#include "itkSymmetricSecondRankTensor.h"
+#include "itkImage.h"
+
+#include "vcl_cmath.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+
+int main( int argc, char ** argv )
+{
+  const unsigned int Dimension = 3;
+  
+  typedef itk::SymmetricSecondRankTensor<double,Dimension>      TensorType;
+  typedef ivan::DiscreteDerivativeCache<TensorType,Dimension>   CacheType;
+  
+  CacheType::Pointer cache = CacheType::New();
+  cache->SetMaximumNumberOfEntries( 10 );
+  
+  CacheType::IndexType index;
+  TensorType value, foundValue;
+  
+  // Store values at two different scales
+  for( unsigned int i=0; i<5; ++i )
+  {
+    index.Fill( i );
+    value.Fill( i );
+    cache->Insert( 1.0, index, value );
+    value.Fill( 10 * i );
+    cache->Insert( 2.0, index, value );
+  }
+  
+  index.Fill( 3 );
+  
+  if( !cache->Find( 1.0, index, foundValue ) || foundValue[0] != 3.0 )
+  {
+    std::cerr << "Value at scale 1.0 not found or wrong" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !cache->Find( 2.0, index, foundValue ) || foundValue[0] != 30.0 )
+  {
+    std::cerr << "Value at scale 2.0 not found or wrong" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( cache->Find( 3.0, index, foundValue ) )
+  {
+    std::cerr << "Found value at a scale that was never stored" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Adding a new value must evict the oldest one (index 0 at scale 1.0)
+  index.Fill( 100 );
+  cache->Insert( 1.0, index, value );
+  
+  index.Fill( 0 );
+  
+  if( cache->GetNumberOfEntries() != 10 || cache->Find( 1.0, index, foundValue ) )
+  {
+    std::cerr << "Oldest value was not evicted" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  cache->Print( std::cout );
+  
+  cache->Clear();
+  
+  if( cache->GetNumberOfEntries() )
+  {
+    std::cerr << "Cache was not cleared" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Half-precision storage of Hessians of tubes with random orientations and contrasts
+  typedef itk::Image<float,Dimension>                                         ImageType;
+  typedef ivan::FrangiVesselnessImageFunction<ImageType,double>               VesselnessFunctionType;
+  typedef VesselnessFunctionType::EigenValuesArrayType                        EigenValuesArrayType;
+  
+  VesselnessFunctionType::Pointer vesselness = VesselnessFunctionType::New();
+  
+  const unsigned int numberOfTensors = 1000;
+  
+  std::vector<TensorType> tensors( numberOfTensors );
+  
+  cache->SetMaximumNumberOfEntries( 0 );
+  
+  for( unsigned int n=0; n<numberOfTensors; ++n )
+  {
+    // Eigenvalues of a bright tube, with noise, in a random orthonormal basis
+    const double contrast = 0.1 + 100.0 * rand() / RAND_MAX;
+    double eigenValues[3];
+    eigenValues[0] = contrast * ( 0.1 * rand() / RAND_MAX - 0.05 );
+    eigenValues[1] = -contrast * ( 0.5 + 0.5 * rand() / RAND_MAX );
+    eigenValues[2] = -contrast * ( 0.5 + 0.5 * rand() / RAND_MAX );
+    
+    double axis[3];
+    double norm = 0.0;
+    for( unsigned int i=0; i<3; ++i )
+    {
+      axis[i] = static_cast<double>( rand() ) / RAND_MAX - 0.5;
+      norm += axis[i] * axis[i];
+    }
+    
+    // Householder reflection of the axis, orthogonal and symmetric
+    double basis[3][3];
+    for( unsigned int i=0; i<3; ++i )
+    {
+      for( unsigned int j=0; j<3; ++j )
+        basis[i][j] = ( i == j ? 1.0 : 0.0 ) - 2.0 * axis[i] * axis[j] / norm;
+    }
+    
+    for( unsigned int i=0; i<3; ++i )
+    {
+      for( unsigned int j=i; j<3; ++j )
+      {
+        double sum = 0.0;
+        for( unsigned int k=0; k<3; ++k )
+          sum += basis[i][k] * eigenValues[k] * basis[j][k];
+        tensors[n]( i, j ) = sum;
+      }
+    }
+  }
+  
+  unsigned long fullMemorySize = 0;
+  
+  for( unsigned int storage=0; storage<2; ++storage )
+  {
+    cache->SetHalfPrecisionStorage( storage == 1 );
+    
+    for( unsigned int n=0; n<numberOfTensors; ++n )
+    {
+      index.Fill( n );
+      cache->Insert( 1.0, index, tensors[n] );
+    }
+    
+    if( storage == 0 )
+      fullMemorySize = cache->GetMemorySize();
+  }
+  
+  std::cout << "Memory of " << numberOfTensors << " tensors: " << fullMemorySize << " bytes in double, " 
+            << cache->GetMemorySize() << " bytes in half precision" << std::endl;
+  
+  if( cache->GetNumberOfEntries() != numberOfTensors || !cache->GetHalfPrecisionStorage() ||
+      cache->GetMemorySize() >= fullMemorySize )
+  {
+    std::cerr << "Wrong number of entries or memory in half-precision storage" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  double maximumVesselnessDelta = 0.0;
+  
+  for( unsigned int n=0; n<numberOfTensors; ++n )
+  {
+    index.Fill( n );
+    
+    if( !cache->Find( 1.0, index, foundValue ) )
+    {
+      std::cerr << "Half-precision value not found" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<TensorType::InternalDimension; ++i )
+    {
+      const double error = vcl_fabs( foundValue[i] - tensors[n][i] );
+      
+      if( error > ivan::HalfFloat::GetMaximumRelativeError() * vcl_fabs( tensors[n][i] ) + 1e-7 )
+      {
+        std::cerr << "Half-precision component " << foundValue[i] << " of " << tensors[n][i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    EigenValuesArrayType eigenValues, foundEigenValues;
+    tensors[n].ComputeEigenValues( eigenValues );
+    foundValue.ComputeEigenValues( foundEigenValues );
+    
+    const double delta = vcl_fabs( vesselness->EvaluateVesselnessFromEigenValues( eigenValues ) - 
+      vesselness->EvaluateVesselnessFromEigenValues( foundEigenValues ) );
+    if( delta > maximumVesselnessDelta )
+      maximumVesselnessDelta = delta;
+  }
+  
+  std::cout << "Maximum vesselness difference: " << maximumVesselnessDelta << std::endl;
+  
+  // Vesselness is between 0 and 1
+  if( maximumVesselnessDelta > 1e-2 )
+  {
+    std::cerr << "Half-precision storage changes vesselness by " << maximumVesselnessDelta << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  cache->SetHalfPrecisionStorage( false );
+  
+  if( cache->GetNumberOfEntries() )
+  {
+    std::cerr << "Cache was not cleared when changing the storage" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGaussianFixedRadiusKernelsTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the Hessian and gradient functions give the same values with and without
+//   the evaluation specialized for small kernel radii, inside and near the image boundary.
+// Date: 2012/11/05
+
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRealTimeClock.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,float,double>   HessianFunctionType;
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType,double>        GradientFunctionType;
+typedef HessianFunctionType::BrickedImageType                                BrickedImageType;
+
+
+template <class TFunction>
+typename TFunction::Pointer CreateFunction( ImageType *image, double sigma, bool fixedRadius )
+{
+  typename TFunction::Pointer function = TFunction::New();
+  function->SetInputImage( image );
+  function->SetSigma( sigma );
+  function->SetUseFixedRadiusKernels( fixedRadius );
+  function->Initialize();
+  
+  return function;
+}
+
+
+// Returns the maximum difference between the functions at indices inside and around the
+// image, relative to the maximum absolute value of the reference
+template <class TFunction>
+double ComputeRelativeDifference( const TFunction *reference, const TFunction *function, 
+  const ImageType *image )
+{
+  const ImageType::RegionType & region = image->GetBufferedRegion();
+  
+  double maxDifference = 0.0, maxValue = 0.0;
+  
+  ImageType::IndexType index;
+  
+  for( index[2] = -1; index[2] < (long)region.GetSize()[2] + 1; index[2] += 2 )
+    for( index[1] = -1; index[1] < (long)region.GetSize()[1] + 1; index[1] += 2 )
+      for( index[0] = -1; index[0] < (long)region.GetSize()[0] + 1; index[0] += 2 )
+      {
+        typename TFunction::OutputType expected = reference->EvaluateAtIndex( index );
+        typename TFunction::OutputType value = function->EvaluateAtIndex( index );
+        
+        for( unsigned int i=0; i<expected.Size(); ++i )
+        {
+          maxValue = vnl_math_max( maxValue, (double)vnl_math_abs( expected[i] ) );
+          maxDifference = vnl_math_max( maxDifference, (double)vnl_math_abs( expected[i] - value[i] ) );
+        }
+      }
+  
+  return ( maxValue > 0.0 ) ? maxDifference / maxValue : maxDifference;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::SizeType size;
+  size[0] = 24;
+  size[1] = 21;
+  size[2] = 19;
+  
+  ImageType::RegionType region;
+  region.SetSize( size );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.25;
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetSpacing( spacing );
+  image->Allocate();
+  
+  // A tube along z and some texture, so that all the components are non-zero
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    const double dx = index[0] - 11.3, dy = index[1] - 9.6;
+    
+    it.Set( 200.0 * exp( -( dx * dx + dy * dy ) / 8.0 ) + 10.0 * sin( 0.7 * index[0] + 0.3 * index[2] ) * 
+      cos( 0.5 * index[1] ) );
+  }
+  
+  BrickedImageType::Pointer bricked = BrickedImageType::New();
+  bricked->CopyImage( image );
+  
+  const double tolerance = 1e-5;
+  
+  // Kernel radii from 1 to above MaximumFixedKernelRadius
+  const double sigmas[] = { 0.4, 0.7, 1.0, 1.5, 2.0, 3.0 };
+  
+  for( unsigned int s = 0; s < 6; ++s )
+  {
+    for( unsigned int separable = 0; separable < 2; ++separable )
+    {
+      HessianFunctionType::Pointer reference = CreateFunction<HessianFunctionType>( image, sigmas[s], false );
+      reference->SetUseSeparableEvaluation( separable != 0 );
+      
+      HessianFunctionType::Pointer function = CreateFunction<HessianFunctionType>( image, sigmas[s], true );
+      function->SetUseSeparableEvaluation( separable != 0 );
+      
+      double difference = ComputeRelativeDifference<HessianFunctionType>( reference, function, image );
+      
+      // The bricked copy goes through the same code
+      function->SetBrickedImage( bricked );
+      difference = vnl_math_max( difference, 
+        ComputeRelativeDifference<HessianFunctionType>( reference, function, image ) );
+      
+      std::cout << "Hessian, sigma " << sigmas[s] << ( separable ? ", separable" : "" ) 
+                << ": relative difference " << difference << std::endl;
+      
+      if( difference > tolerance )
+      {
+        std::cerr << "Wrong fixed radius Hessian" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    GradientFunctionType::Pointer reference = CreateFunction<GradientFunctionType>( image, sigmas[s], false );
+    GradientFunctionType::Pointer function = CreateFunction<GradientFunctionType>( image, sigmas[s], true );
+    
+    double difference = ComputeRelativeDifference<GradientFunctionType>( reference, function, image );
+    
+    function->SetBrickedImage( bricked );
+    difference = vnl_math_max( difference, 
+      ComputeRelativeDifference<GradientFunctionType>( reference, function, image ) );
+    
+    std::cout << "Gradient, sigma " << sigmas[s] << ": relative difference " << difference << std::endl;
+    
+    if( difference > tolerance )
+    {
+      std::cerr << "Wrong fixed radius gradient" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Time of the separable Hessian at a small scale
+  HessianFunctionType::Pointer generic = CreateFunction<HessianFunctionType>( image, 1.0, false );
+  generic->UseSeparableEvaluationOn();
+  HessianFunctionType::Pointer fixedRadius = CreateFunction<HessianFunctionType>( image, 1.0, true );
+  fixedRadius->UseSeparableEvaluationOn();
+  
+  HessianFunctionType * functions[] = { generic, fixedRadius };
+  const char * names[] = { "generic", "fixed radius" };
+  
+  itk::RealTimeClock::Pointer clock = itk::RealTimeClock::New();
+  
+  for( unsigned int f = 0; f < 2; ++f )
+  {
+    const double start = clock->GetTimeStamp();
+    double sum = 0.0;
+    
+    ImageType::IndexType index;
+    
+    for( unsigned int repetition = 0; repetition < 5; ++repetition )
+      for( index[2] = 0; index[2] < (long)size[2]; ++index[2] )
+        for( index[1] = 0; index[1] < (long)size[1]; ++index[1] )
+          for( index[0] = 0; index[0] < (long)size[0]; ++index[0] )
+            sum += functions[f]->EvaluateAtIndex( index )[0];
+    
+    std::cout << "Separable Hessian at sigma 1, " << names[f] << ": " 
+              << 1e9 * ( clock->GetTimeStamp() - start ) / ( 5 * region.GetNumberOfPixels() ) 
+              << " ns per index (" << sum << ")" << std::endl;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGaussianJetImageFunctionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the Gaussian jet against the separate Hessian and gradient functions.
+
+#include "ivanDiscreteGaussianJetImageFunction.h"
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::DiscreteGaussianJetImageFunction<ImageType,double>        JetFunctionType;
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>    HessianFunctionType;
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType,double>   GradientFunctionType;
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum differences with respect to the separate functions, relative to the maximum 
+  // absolute value of the hessian and gradient
+  const double hessianTolerance = ( argc > 1 ) ? atof( argv[1] ) : 1e-8;
+  const double gradientTolerance = ( argc > 2 ) ? atof( argv[2] ) : 1e-4;
+  
+  // Synthetic tube of gaussian section oblique to the axes, over a constant background
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 3.0;
+  const double background = 10.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 11.0;
+    const double dy = it.GetIndex()[1] - 15.5;
+    it.Set( background + 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  const double sigmas[2] = { 1.0, 2.5 };
+  
+  for( unsigned int s=0; s<2; ++s )
+  {
+    for( unsigned int linear=0; linear<2; ++linear )
+    {
+      JetFunctionType::Pointer jetFunction = JetFunctionType::New();
+      jetFunction->SetInputImage( image );
+      jetFunction->SetSigma( sigmas[s] );
+      jetFunction->SetInterpolationMode( linear ? JetFunctionType::LinearInterpolation 
+        : JetFunctionType::NearestNeighbourInterpolation );
+      jetFunction->Initialize();
+      
+      HessianFunctionType::Pointer hessianFunction = HessianFunctionType::New();
+      hessianFunction->SetInputImage( image );
+      hessianFunction->SetSigma( sigmas[s] );
+      hessianFunction->SetInterpolationMode( linear ? HessianFunctionType::LinearInterpolation 
+        : HessianFunctionType::NearestNeighbourInterpolation );
+      hessianFunction->Initialize();
+      
+      GradientFunctionType::Pointer gradientFunction = GradientFunctionType::New();
+      gradientFunction->SetInputImage( image );
+      gradientFunction->SetSigma( sigmas[s] );
+      gradientFunction->SetInterpolationMode( linear ? GradientFunctionType::LinearInterpolation 
+        : GradientFunctionType::NearestNeighbourInterpolation );
+      gradientFunction->Initialize();
+      
+      double maxHessianError = 0.0, maxHessian = 0.0;
+      double maxGradientError = 0.0, maxGradient = 0.0;
+      double minValue = itk::NumericTraits<double>::max();
+      
+      JetFunctionType::ContinuousIndexType cindex;
+      
+      for( cindex[2] = 0.0; cindex[2] < 31.0; cindex[2] += 2.7 )
+        for( cindex[1] = 0.25; cindex[1] < 31.0; cindex[1] += 3.0 )
+          for( cindex[0] = 0.5; cindex[0] < 31.0; cindex[0] += 1.9 )
+          {
+            JetFunctionType::OutputType jet = jetFunction->EvaluateAtContinuousIndex( cindex );
+            HessianFunctionType::OutputType hessian = hessianFunction->EvaluateAtContinuousIndex( cindex );
+            GradientFunctionType::OutputType gradient = gradientFunction->EvaluateAtContinuousIndex( cindex );
+            
+            for( unsigned int i=0; i<hessian.Size(); ++i )
+            {
+              maxHessian = std::max( maxHessian, std::fabs( hessian[i] ) );
+              maxHessianError = std::max( maxHessianError, std::fabs( hessian[i] - jet.Hessian[i] ) );
+            }
+            
+            for( unsigned int i=0; i<Dimension; ++i )
+            {
+              maxGradient = std::max( maxGradient, std::fabs( gradient[i] ) );
+              maxGradientError = std::max( maxGradientError, std::fabs( gradient[i] - jet.Gradient[i] ) );
+            }
+            
+            minValue = std::min( minValue, static_cast<double>( jet.Value ) );
+          }
+      
+      const double hessianError = maxHessianError / maxHessian;
+      const double gradientError = maxGradientError / maxGradient;
+      
+      std::cout << "Sigma: " << sigmas[s] << " Linear: " << linear << " Hessian error: " << hessianError 
+        << " Gradient error: " << gradientError << " Minimum value: " << minValue << std::endl;
+      
+      if( hessianError > hessianTolerance || gradientError > gradientTolerance )
+      {
+        std::cerr << "Jet differs from the separate hessian and gradient functions" << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      // The smoothed image is never below the background
+      if( minValue < background - 1e-2 )
+      {
+        std::cerr << "Smoothed value below the background" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
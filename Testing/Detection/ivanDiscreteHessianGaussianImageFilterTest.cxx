@@ -0,0 +1,164 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteHessianGaussianImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the Hessian image computed by the tree of separable passes against the Hessian function.
+
+#include "ivanDiscreteHessianGaussianImageFilter.h"
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::DiscreteHessianGaussianImageFilter<ImageType>              FilterType;
+typedef FilterType::OutputImageType                                       HessianImageType;
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>     FunctionType;
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum difference relative to the maximum absolute value of the hessian
+  const double tolerance = ( argc > 1 ) ? atof( argv[1] ) : 1e-8;
+  
+  // Synthetic tube of gaussian section oblique to the axes, with anisotropic spacing
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 30;
+  size[1] = 26;
+  size[2] = 22;
+  region.SetSize( size );
+  image->SetRegions( region );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.5;
+  image->SetSpacing( spacing );
+  image->Allocate();
+  
+  const double tubeSigma = 3.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 11.0;
+    const double dy = it.GetIndex()[1] - 12.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  const double sigmas[2] = { 1.0, 2.5 };
+  const unsigned int threads[2] = { 1, 4 };
+  
+  for( unsigned int s=0; s<2; ++s )
+  {
+    FunctionType::Pointer function = FunctionType::New();
+    function->SetInputImage( image );
+    function->SetSigma( sigmas[s] );
+    function->SetUseSeparableEvaluation( true );
+    function->Initialize();
+    
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( image );
+    filter->SetSigma( sigmas[s] );
+    filter->SetNumberOfThreads( threads[s] );
+    
+    try
+    {
+      filter->Update();
+    }
+    catch( itk::ExceptionObject & err )
+    {
+      std::cerr << "ExceptionObject caught !" << std::endl;
+      std::cerr << err << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    double maxError = 0.0, maxValue = 0.0;
+    
+    itk::ImageRegionConstIteratorWithIndex<HessianImageType> hit( filter->GetOutput(), region );
+    
+    for( hit.GoToBegin(); !hit.IsAtEnd(); ++hit )
+    {
+      FunctionType::OutputType referenceHessian = function->EvaluateAtIndex( hit.GetIndex() );
+      HessianImageType::PixelType hessian = hit.Get();
+      
+      for( unsigned int i=0; i<hessian.Size(); ++i )
+      {
+        maxValue = std::max( maxValue, std::fabs( referenceHessian[i] ) );
+        maxError = std::max( maxError, std::fabs( referenceHessian[i] - hessian[i] ) );
+      }
+    }
+    
+    const double relativeError = maxError / maxValue;
+    
+    std::cout << "Sigma: " << sigmas[s] << " Relative error: " << relativeError << std::endl;
+    
+    if( relativeError > tolerance )
+    {
+      std::cerr << "Hessian image differs from the Hessian function" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The N-dimensional kernels are only built when the separable evaluation is turned off
+    maxError = 0.0;
+    FunctionType::Pointer kernelFunction = FunctionType::New();
+    kernelFunction->SetInputImage( image );
+    kernelFunction->SetSigma( sigmas[s] );
+    kernelFunction->SetUseSeparableEvaluation( true );
+    kernelFunction->Initialize();
+    kernelFunction->SetUseSeparableEvaluation( false );
+    
+    for( hit.GoToBegin(); !hit.IsAtEnd(); ++hit )
+    {
+      FunctionType::OutputType referenceHessian = function->EvaluateAtIndex( hit.GetIndex() );
+      FunctionType::OutputType hessian = kernelFunction->EvaluateAtIndex( hit.GetIndex() );
+      
+      for( unsigned int i=0; i<hessian.Size(); ++i )
+        maxError = std::max( maxError, std::fabs( referenceHessian[i] - hessian[i] ) );
+    }
+    
+    if( maxError / maxValue > tolerance )
+    {
+      std::cerr << "Hessian of the N-dimensional kernels differs from the separable Hessian" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteHessianGaussianInterpolationTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the interpolated kernels of the Hessian against the interpolation of the hessians at the corners.
+
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>   FunctionType;
+
+
+FunctionType::Pointer CreateFunction( ImageType *image, double sigma, bool useCache )
+{
+  FunctionType::Pointer function = FunctionType::New();
+  function->SetInputImage( image );
+  function->SetSigma( sigma );
+  function->SetInterpolationMode( FunctionType::LinearInterpolation );
+  
+  // With a cache the hessians of the corners are computed and interpolated
+  if( useCache )
+    function->SetDerivativeCache( FunctionType::DerivativeCacheType::New() );
+  
+  function->Initialize();
+  
+  return function;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum difference of the interpolated kernels with respect to interpolating the corners,
+  // relative to the maximum absolute value of the hessian
+  const double tolerance = ( argc > 1 ) ? atof( argv[1] ) : 1e-8;
+  
+  // Synthetic tube of gaussian section oblique to the axes
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 3.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 11.0;
+    const double dy = it.GetIndex()[1] - 15.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  const double sigmas[2] = { 1.0, 2.5 };
+  
+  for( unsigned int s=0; s<2; ++s )
+  {
+    FunctionType::Pointer reference = CreateFunction( image, sigmas[s], true );
+    FunctionType::Pointer function = CreateFunction( image, sigmas[s], false );
+    
+    double maxError = 0.0, maxValue = 0.0;
+    
+    // Points on and off the grid, some of them near the boundaries
+    FunctionType::ContinuousIndexType cindex;
+    
+    for( cindex[2] = 0.0; cindex[2] < 31.0; cindex[2] += 2.7 )
+      for( cindex[1] = 0.25; cindex[1] < 31.0; cindex[1] += 3.0 )
+        for( cindex[0] = 0.5; cindex[0] < 31.0; cindex[0] += 1.9 )
+        {
+          FunctionType::OutputType referenceHessian = reference->EvaluateAtContinuousIndex( cindex );
+          FunctionType::OutputType hessian = function->EvaluateAtContinuousIndex( cindex );
+          
+          for( unsigned int i=0; i<hessian.Size(); ++i )
+          {
+            maxValue = std::max( maxValue, std::fabs( referenceHessian[i] ) );
+            maxError = std::max( maxError, std::fabs( referenceHessian[i] - hessian[i] ) );
+          }
+        }
+    
+    const double relativeError = maxError / maxValue;
+    
+    std::cout << "Sigma: " << sigmas[s] << " Relative error: " << relativeError << std::endl;
+    
+    if( relativeError > tolerance )
+    {
+      std::cerr << "Interpolated kernels differ from the interpolation of the corners" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
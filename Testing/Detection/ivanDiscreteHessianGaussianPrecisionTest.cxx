@@ -0,0 +1,141 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteHessianGaussianPrecisionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: bounds the accuracy loss of the float Hessian paths with respect to double precision.
+
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>         DoubleFunctionType;
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,float>          FloatFunctionType;
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,float,double>   MixedFunctionType;
+
+
+template <class TFunction>
+typename TFunction::Pointer CreateFunction( ImageType *image, double sigma, bool separable )
+{
+  typename TFunction::Pointer function = TFunction::New();
+  function->SetInputImage( image );
+  function->SetSigma( sigma );
+  function->SetUseSeparableEvaluation( separable );
+  function->Initialize();
+  
+  return function;
+}
+
+
+// Returns the maximum difference of the given function with respect to the double 
+// function, relative to the maximum absolute value of the double Hessian
+template <class TFunction>
+double ComputeRelativeError( ImageType *image, double sigma, bool separable )
+{
+  DoubleFunctionType::Pointer reference = CreateFunction<DoubleFunctionType>( image, sigma, separable );
+  typename TFunction::Pointer function = CreateFunction<TFunction>( image, sigma, separable );
+  
+  double maxError = 0.0, maxValue = 0.0;
+  
+  ImageType::IndexType index;
+  
+  for( index[2] = 4; index[2] < 28; index[2] += 3 )
+    for( index[1] = 4; index[1] < 28; index[1] += 3 )
+      for( index[0] = 4; index[0] < 28; index[0] += 3 )
+      {
+        DoubleFunctionType::OutputType referenceHessian = reference->EvaluateAtIndex( index );
+        typename TFunction::OutputType hessian = function->EvaluateAtIndex( index );
+        
+        for( unsigned int i=0; i<referenceHessian.Size(); ++i )
+        {
+          maxValue = std::max( maxValue, std::fabs( referenceHessian[i] ) );
+          maxError = std::max( maxError, std::fabs( referenceHessian[i] - hessian[i] ) );
+        }
+      }
+  
+  return maxError / maxValue;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum errors relative to the double path, for float and float with double accumulators
+  const double floatTolerance = ( argc > 1 ) ? atof( argv[1] ) : 1e-3;
+  const double mixedTolerance = ( argc > 2 ) ? atof( argv[2] ) : 1e-4;
+  
+  // Synthetic tube of gaussian section along the z axis, with an offset so that 
+  // the accumulation of large values is exercised
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 3.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 15.5;
+    const double dy = it.GetIndex()[1] - 15.5;
+    it.Set( 1000.0 + 500.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  const double sigmas[3] = { 1.0, 2.0, 4.0 };
+  
+  for( unsigned int s=0; s<3; ++s )
+  {
+    for( unsigned int separable=0; separable<2; ++separable )
+    {
+      const double floatError = ComputeRelativeError<FloatFunctionType>( image, sigmas[s], separable );
+      const double mixedError = ComputeRelativeError<MixedFunctionType>( image, sigmas[s], separable );
+      
+      std::cout << "Sigma: " << sigmas[s] << " Separable: " << separable 
+        << " Float error: " << floatError << " Mixed error: " << mixedError << std::endl;
+      
+      if( floatError > floatTolerance || mixedError > mixedTolerance )
+      {
+        std::cerr << "Relative error with respect to double precision exceeds tolerance" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
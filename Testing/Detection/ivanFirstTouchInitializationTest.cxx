@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFirstTouchInitializationTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the parallel first-touch fill writes the whole buffer and that the 
+//   output of the image function filter does not change with first-touch initialization and 
+//   thread affinity, in sparse and dynamic scheduling modes.
+
+#include "ivanFirstTouchImageFiller.h"
+#include "ivanThreadAffinity.h"
+#include "ivanImageFunctionBasedImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>     VesselnessFunctionType;
+
+typedef ivan::ImageFunctionBasedImageFilter
+  <ImageType,ImageType,VesselnessFunctionType>                    FilterType;
+
+
+/** Initializes the vesselness at the scale of the tube. */
+class TubeScaleInitializer : 
+  public ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType>
+{
+public:
+
+  typedef TubeScaleInitializer                                                      Self;
+  typedef ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType> Superclass;
+  typedef itk::SmartPointer<Self>                                                   Pointer;
+
+  itkNewMacro( Self );
+
+  virtual void Initialize( VesselnessFunctionType *imageFunction, const ImageType *image = 0, double = 0.0 )
+    { Superclass::Initialize( imageFunction, image, 2.0 ); }
+};
+
+
+int main( int, char ** )
+{
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 37; size[1] = 29; size[2] = 23; // not divisible by the number of threads
+  region.SetSize( size );
+  
+  // Parallel fill
+  ImageType::Pointer filled = ImageType::New();
+  filled->SetRegions( region );
+  filled->Allocate();
+  
+  ivan::FirstTouchImageFiller<ImageType>::Fill( filled, 7.0, 5, true );
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( filled, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( it.Get() != 7.0 )
+    {
+      std::cerr << "Pixel not filled at " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  std::cout << "Thread affinity supported: " << ivan::ScopedThreadAffinity::IsSupported() << std::endl;
+  
+  // Synthetic tube of gaussian section along the z axis
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  const double centerX = 18.0, centerY = 14.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> iit( image, region );
+  
+  for( iit.GoToBegin(); !iit.IsAtEnd(); ++iit )
+  {
+    const double dx = iit.GetIndex()[0] - centerX;
+    const double dy = iit.GetIndex()[1] - centerY;
+    iit.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  for( unsigned int mode=0; mode < 2; ++mode )
+  {
+    FilterType::Pointer referenceFilter = FilterType::New();
+    FilterType::Pointer firstTouchFilter = FilterType::New();
+    
+    FilterType *filters[2] = { referenceFilter, firstTouchFilter };
+    
+    for( unsigned int f=0; f < 2; ++f )
+    {
+      filters[f]->SetInput( image );
+      filters[f]->SetImageFunctionInitializer( TubeScaleInitializer::New() );
+      filters[f]->SetThreshold( 1.0 );
+      filters[f]->SetNumberOfThreads( 4 );
+      filters[f]->SetSparseEvaluation( mode == 0 );
+      filters[f]->SetDynamicScheduling( mode == 1 );
+      filters[f]->SetTileSize( 8 );
+    }
+    
+    firstTouchFilter->FirstTouchInitializationOn();
+    firstTouchFilter->ThreadAffinityOn();
+    
+    try
+    {
+      referenceFilter->Update();
+      firstTouchFilter->Update();
+    }
+    catch( itk::ExceptionObject & err )
+    {
+      std::cerr << "ExceptionObject caught !" << std::endl;
+      std::cerr << err << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const ImageType *referenceOutput = referenceFilter->GetOutput();
+    const ImageType *firstTouchOutput = firstTouchFilter->GetOutput();
+    
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+      if( referenceOutput->GetPixel( it.GetIndex() ) != firstTouchOutput->GetPixel( it.GetIndex() ) )
+      {
+        std::cerr << "Outputs differ at " << it.GetIndex() << ( mode == 0 ? " in sparse mode" : 
+          " with dynamic scheduling" ) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
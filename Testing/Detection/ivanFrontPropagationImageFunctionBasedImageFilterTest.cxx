@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrontPropagationImageFunctionBasedImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the front propagated from a seed on a tube evaluates Frangi's vesselness only
+//   around the tube, and that the accepted responses are those of the function.
+
+#include "ivanFrontPropagationImageFunctionBasedImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>     VesselnessFunctionType;
+
+typedef ivan::FrontPropagationImageFunctionBasedImageFilter
+  <ImageType,ImageType,VesselnessFunctionType>                    FilterType;
+
+
+/** Initializes the vesselness at the scale of the tube, since the filter initializes the 
+  * function without scale. */
+class TubeScaleInitializer : 
+  public ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType>
+{
+public:
+
+  typedef TubeScaleInitializer                                                      Self;
+  typedef ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType> Superclass;
+  typedef itk::SmartPointer<Self>                                                   Pointer;
+
+  itkNewMacro( Self );
+
+  virtual void Initialize( VesselnessFunctionType *imageFunction, const ImageType *image = 0, double = 0.0 )
+    { Superclass::Initialize( imageFunction, image, 2.0 ); }
+};
+
+
+int main( int argc, char ** argv )
+{
+  // Fraction of the maximum response on the centerline below which the front stops
+  const double relativeThreshold = ( argc > 1 ) ? atof( argv[1] ) : 0.1;
+  
+  // Synthetic tube of gaussian section along the z axis
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 48 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  const double centerX = 20.0, centerY = 27.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - centerX;
+    const double dy = it.GetIndex()[1] - centerY;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  // Reference function, evaluated at the centerline to set the threshold
+  VesselnessFunctionType::Pointer function = VesselnessFunctionType::New();
+  TubeScaleInitializer::New()->Initialize( function, image );
+  
+  ImageType::IndexType seed;
+  seed[0] = static_cast<long>( centerX );
+  seed[1] = static_cast<long>( centerY );
+  seed[2] = 24;
+  
+  const double threshold = relativeThreshold * function->EvaluateAtIndex( seed );
+  
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetImageFunctionInitializer( TubeScaleInitializer::New() );
+  filter->AddSeed( seed );
+  filter->SetResponseThreshold( threshold );
+  
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    std::cerr << "ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const FilterType::AcceptedPixelContainerType & accepted = filter->GetAcceptedPixels();
+  
+  std::cout << "Accepted pixels: " << accepted.size() << " Evaluated fraction: " 
+    << filter->GetEvaluatedFraction() << std::endl;
+  
+  // The accepted responses are those of the function, and above the threshold
+  for( unsigned int i=0; i<accepted.size(); ++i )
+  {
+    const double response = function->EvaluateAtIndex( accepted[i].first );
+    
+    if( std::fabs( response - accepted[i].second ) > 1e-10 * std::max( 1.0, std::fabs( response ) ) ||
+        accepted[i].second < threshold || 
+        std::fabs( filter->GetOutput()->GetPixel( accepted[i].first ) - response ) > 1e-5 * std::fabs( response ) )
+    {
+      std::cerr << "Wrong response at " << accepted[i].first << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The whole centerline is reached from the seed
+  ImageType::IndexType index = seed;
+  
+  for( index[2] = 0; index[2] < static_cast<long>( size[2] ); ++index[2] )
+  {
+    if( filter->GetOutput()->GetPixel( index ) <= 0.0 )
+    {
+      std::cerr << "Centerline pixel " << index << " not reached" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Only a neighbourhood of the tube is evaluated
+  if( filter->GetEvaluatedFraction() > 0.2 )
+  {
+    std::cerr << "Too many evaluated pixels" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
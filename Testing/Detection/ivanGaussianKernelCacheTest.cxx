@@ -0,0 +1,129 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianKernelCacheTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests storage, retrieval and persistence of kernels in the Gaussian kernel cache.
+
+#include "ivanGaussianKernelCache.h"
+#include "ivanGaussianDerivativeOperator.h"
+
+#include <iostream>
+#include <cstdio>
+
+
+int main( int argc, char ** argv )
+{
+  const unsigned int Dimension = 3;
+  
+  typedef ivan::GaussianDerivativeOperator<double,Dimension>  OperatorType;
+  typedef ivan::GaussianKernelCache                           CacheType;
+  
+  const char * fileName = ( argc > 1 ) ? argv[1] : "GaussianKernelCache.dat";
+  
+  CacheType::Pointer cache = CacheType::GetInstance();
+  cache->Clear();
+  
+  // Reference kernel, computed with the cache disabled
+  OperatorType referenceOperator;
+  referenceOperator.SetVariance( 4.0 );
+  referenceOperator.SetOrder( 2 );
+  referenceOperator.SetDirection( 0 );
+  referenceOperator.CreateDirectional();
+  
+  if( cache->GetNumberOfKernels() )
+  {
+    std::cerr << "Kernel stored while the cache was disabled" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  cache->EnabledOn();
+  
+  // First operator computes and stores the kernel, second one retrieves it
+  for( unsigned int i=0; i<2; ++i )
+  {
+    OperatorType op;
+    op.SetVariance( 4.0 );
+    op.SetOrder( 2 );
+    op.SetDirection( 0 );
+    op.CreateDirectional();
+    
+    if( op.Size() != referenceOperator.Size() )
+    {
+      std::cerr << "Cached kernel size differs from reference" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int j=0; j<op.Size(); ++j )
+    {
+      if( op[j] != referenceOperator[j] )
+      {
+        std::cerr << "Cached kernel coefficients differ from reference" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  if( cache->GetNumberOfKernels() != 1 )
+  {
+    std::cerr << "Expected 1 kernel in cache, found " << cache->GetNumberOfKernels() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Round trip through the persistent file
+  if( !cache->Save( fileName ) )
+  {
+    std::cerr << "Could not save cache to " << fileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  cache->Clear();
+  
+  if( !cache->Load( fileName ) || cache->GetNumberOfKernels() != 1 )
+  {
+    std::cerr << "Could not load cache from " << fileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  OperatorType::CoefficientVector coefficients;
+  CacheType::ParameterVectorType parameters;
+  
+  // A kernel with different parameters must not be found
+  parameters.push_back( 1.0 );
+  
+  if( cache->Find( "ivan::GaussianDerivativeOperator", parameters, coefficients ) )
+  {
+    std::cerr << "Found kernel that was never stored" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  cache->Print( std::cout );
+  
+  cache->Clear();
+  cache->EnabledOff();
+  
+  std::remove( fileName );
+  
+  return EXIT_SUCCESS;
+}
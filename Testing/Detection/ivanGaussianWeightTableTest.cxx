@@ -0,0 +1,83 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGaussianWeightTableTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the tabulated Gaussian weights against vcl_exp.
+
+#include "ivanGaussianWeightTable.h"
+
+#include "vcl_cmath.h"
+
+#include <iostream>
+#include <cstdlib>
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::GaussianWeightTable   TableType;
+  
+  const unsigned int numberOfValues = 10000;
+  const double maximumValue = 10.0;
+  
+  // Allow for rounding on top of the truncation error of the polynomial
+  const double tolerance = TableType::GetMaximumRelativeError() + 1e-12;
+  
+  double values[numberOfValues];
+  double weights[numberOfValues];
+  
+  for( unsigned int i=0; i<numberOfValues; ++i )
+  {
+    // Use signed values, the weight must be symmetric
+    values[i] = ( i % 2 ? -1.0 : 1.0 ) * maximumValue * i / static_cast<double>( numberOfValues - 1 );
+    
+    const double expected = vcl_exp( -0.5 * values[i] * values[i] );
+    const double weight = TableType::Evaluate( values[i] );
+    
+    if( vcl_fabs( weight - expected ) > tolerance * expected )
+    {
+      std::cerr << "Weight for " << values[i] << " is " << weight << ", expected " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  TableType::Evaluate( values, weights, numberOfValues );
+  
+  for( unsigned int i=0; i<numberOfValues; ++i )
+  {
+    if( weights[i] != TableType::Evaluate( values[i] ) )
+    {
+      std::cerr << "Array evaluation differs from single evaluation at " << values[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( TableType::Evaluate( 0.0 ) != 1.0 )
+  {
+    std::cerr << "Weight at zero is not one" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
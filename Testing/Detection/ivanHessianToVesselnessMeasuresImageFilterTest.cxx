@@ -0,0 +1,157 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHessianToVesselnessMeasuresImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the whole-image Hessian-based measures against the point-wise measures.
+
+#include "ivanHessianToVesselnessMeasuresImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanSatoVesselnessImageFunction.h"
+#include "ivanFilterByEigenValuesVesselnessImageFunction.h"
+
+#include "itkImage.h"
+#include "itkHessianRecursiveGaussianImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int Dimension = 3;
+  
+  typedef itk::Image<float,Dimension>    ImageType;
+  typedef itk::Image<double,Dimension>   OutputImageType;
+  
+  typedef itk::HessianRecursiveGaussianImageFilter<ImageType>    HessianFilterType;
+  typedef HessianFilterType::OutputImageType                     TensorImageType;
+  
+  typedef ivan::HessianToVesselnessMeasuresImageFilter
+    <TensorImageType,OutputImageType>                            MeasuresFilterType;
+  typedef ivan::FrangiVesselnessImageFunction<ImageType,double>  FrangiFunctionType;
+  typedef ivan::SatoVesselnessImageFunction<ImageType,double>    SatoFunctionType;
+  typedef ivan::FilterByEigenValuesVesselnessImageFunction
+    <ImageType,double>                                           FilterFunctionType;
+
+  // Synthetic bright tube along z with a Gaussian profile
+  ImageType::SizeType size;
+  size.Fill( 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 12.0;
+    const double dy = it.GetIndex()[1] - 12.0;
+    it.Set( 100.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  HessianFilterType::Pointer hessianFilter = HessianFilterType::New();
+  hessianFilter->SetInput( image );
+  hessianFilter->SetSigma( tubeSigma );
+  hessianFilter->SetNormalizeAcrossScale( true );
+  
+  FrangiFunctionType::Pointer frangi = FrangiFunctionType::New();
+  SatoFunctionType::Pointer sato = SatoFunctionType::New();
+  FilterFunctionType::Pointer filter = FilterFunctionType::New();
+  filter->SetOutputValue( 1.0 );
+
+  MeasuresFilterType::Pointer measuresFilter = MeasuresFilterType::New();
+  measuresFilter->SetInput( hessianFilter->GetOutput() );
+  measuresFilter->AddMeasure( frangi );
+  measuresFilter->AddMeasure( sato );
+  measuresFilter->AddMeasure( filter );
+
+  try
+  {
+    measuresFilter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  // Compare with the point-wise measures using the iterative eigen-analysis. The filter 
+  // evaluates the measures by component, without branches
+  const double tolerance = 1e-4;
+  
+  itk::ImageRegionConstIterator<TensorImageType> tensorIt( hessianFilter->GetOutput(), 
+    hessianFilter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator<OutputImageType> frangiIt( measuresFilter->GetOutput( 0 ), 
+    hessianFilter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator<OutputImageType> satoIt( measuresFilter->GetOutput( 1 ), 
+    hessianFilter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator<OutputImageType> filterIt( measuresFilter->GetOutput( 2 ), 
+    hessianFilter->GetOutput()->GetBufferedRegion() );
+
+  MeasuresFilterType::MeasureEigenValuesArrayType eigenValues;
+  
+  for( tensorIt.GoToBegin(), frangiIt.GoToBegin(), satoIt.GoToBegin(), filterIt.GoToBegin(); 
+    !tensorIt.IsAtEnd(); ++tensorIt, ++frangiIt, ++satoIt, ++filterIt )
+  {
+    tensorIt.Get().ComputeEigenValues( eigenValues );
+    
+    const double expectedFrangi = frangi->EvaluateVesselnessFromEigenValues( eigenValues );
+    const double expectedSato = sato->EvaluateVesselnessFromEigenValues( eigenValues );
+    
+    if( std::fabs( frangiIt.Get() - expectedFrangi ) > tolerance * std::max( 1.0, std::fabs( expectedFrangi ) ) ||
+        std::fabs( satoIt.Get() - expectedSato ) > tolerance * std::max( 1.0, std::fabs( expectedSato ) ) )
+    {
+      std::cerr << "Measures at " << tensorIt.GetIndex() << " are " << frangiIt.Get() << " / " << satoIt.Get()
+        << ", expected " << expectedFrangi << " / " << expectedSato << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( filterIt.Get() != filter->EvaluateVesselnessFromEigenValues( eigenValues ) )
+    {
+      std::cerr << "Eigenvalue filter at " << tensorIt.GetIndex() << " is " << filterIt.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The tube must be detected
+  OutputImageType::IndexType center, background;
+  center[0] = 12; center[1] = 12; center[2] = 12;
+  background[0] = 2; background[1] = 2; background[2] = 12;
+  
+  if( measuresFilter->GetOutput( 0 )->GetPixel( center ) <= measuresFilter->GetOutput( 0 )->GetPixel( background ) )
+  {
+    std::cerr << "Frangi vesselness at the tube center " << measuresFilter->GetOutput( 0 )->GetPixel( center ) 
+      << " is not above the background " << measuresFilter->GetOutput( 0 )->GetPixel( background ) << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
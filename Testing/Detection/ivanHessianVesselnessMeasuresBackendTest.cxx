@@ -0,0 +1,272 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanHessianVesselnessMeasuresBackendTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the batch stages of the CPU backend against the pointwise evaluation.
+
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+#include "ivanHessianVesselnessMeasuresBackend.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanSatoVesselnessImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image<float,Dimension>    ImageType;
+typedef itk::Image<double,Dimension>   OutputImageType;
+
+typedef ivan::MultiscaleHessianVesselnessMeasuresImageFilter
+  <ImageType,OutputImageType>                                  MultiscaleFilterType;
+typedef MultiscaleFilterType::BackendType                      BackendType;
+typedef MultiscaleFilterType::MeasureFunctionType              MeasureFunctionType;
+typedef MultiscaleFilterType::TensorScalePixelType             TensorType;
+typedef MultiscaleFilterType::EigenValuesArrayType             EigenValuesArrayType;
+typedef MultiscaleFilterType::MeasureEigenValuesArrayType      MeasureEigenValuesArrayType;
+typedef MultiscaleFilterType::MeasureEigenValueType            MeasureEigenValueType;
+typedef MultiscaleFilterType::MeasureOutputType                MeasureOutputType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>  FrangiFunctionType;
+typedef ivan::SatoVesselnessImageFunction<ImageType,double>    SatoFunctionType;
+
+
+/** CPU backend that counts the values computed, used with a single thread. */
+class CountingBackend : public BackendType
+{
+public:
+  
+  typedef CountingBackend                  Self;
+  typedef BackendType                      Superclass;
+  typedef itk::SmartPointer<Self>          Pointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( CountingBackend, HessianVesselnessMeasuresBackend );
+  
+  virtual void ComputeEigenValues( const TensorType * tensors, unsigned long numberOfTensors,
+    EigenValuesArrayType * eigenValues ) const
+    {
+      m_NumberOfEigenValues += numberOfTensors;
+      Superclass::ComputeEigenValues( tensors, numberOfTensors, eigenValues );
+    }
+  
+  virtual void EvaluateMeasure( const MeasureFunctionType * measure, 
+    const MeasureEigenValueType * const * eigenValues, unsigned long numberOfValues, 
+    MeasureOutputType * vesselness ) const
+    {
+      m_NumberOfMeasureValues += numberOfValues;
+      Superclass::EvaluateMeasure( measure, eigenValues, numberOfValues, vesselness );
+    }
+  
+  mutable unsigned long m_NumberOfEigenValues;
+  mutable unsigned long m_NumberOfMeasureValues;
+  
+protected:
+  
+  CountingBackend() : m_NumberOfEigenValues( 0 ), m_NumberOfMeasureValues( 0 ) {}
+};
+
+
+int main( int, char ** )
+{
+  BackendType::Pointer backend = BackendType::New();
+  
+  FrangiFunctionType::Pointer frangi = FrangiFunctionType::New();
+  SatoFunctionType::Pointer sato = SatoFunctionType::New();
+  
+  std::vector<const MeasureFunctionType *> measures;
+  measures.push_back( frangi.GetPointer() );
+  measures.push_back( sato.GetPointer() );
+  
+  // Symmetric tensors with eigenvalues of both signs and magnitudes, including zero ones
+  const unsigned long numberOfTensors = 257;
+  
+  std::vector<TensorType> tensors( numberOfTensors );
+  
+  srand( 7 );
+  
+  for( unsigned long k=0; k<numberOfTensors; ++k )
+  {
+    for( unsigned int i=0; i<TensorType::InternalDimension; ++i )
+      tensors[k][i] = ( k % 16 == 0 ) ? 0.0 : 20.0 * rand() / RAND_MAX - 10.0;
+  }
+  
+  // Batch eigen-analysis against the tensors one by one
+  std::vector<EigenValuesArrayType> eigenValues( numberOfTensors );
+  backend->ComputeEigenValues( &tensors[0], numberOfTensors, &eigenValues[0] );
+  
+  for( unsigned long k=0; k<numberOfTensors; ++k )
+  {
+    EigenValuesArrayType expectedEigenValues;
+    tensors[k].ComputeEigenValues( expectedEigenValues );
+    
+    for( unsigned int i=0; i<Dimension; ++i )
+    {
+      if( std::fabs( eigenValues[k][i] - expectedEigenValues[i] ) > 1e-6 * ( 1.0 + std::fabs( expectedEigenValues[i] ) ) )
+      {
+        std::cerr << "Eigenvalues of tensor " << k << " are " << eigenValues[k] << ", expected " 
+          << expectedEigenValues << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // Batch measures against the sets of eigenvalues one by one
+  std::vector<MeasureEigenValueType> measureEigenValues( Dimension * numberOfTensors );
+  const MeasureEigenValueType *measureEigenValueComponents[Dimension];
+  
+  for( unsigned int i=0; i<Dimension; ++i )
+  {
+    for( unsigned long k=0; k<numberOfTensors; ++k )
+      measureEigenValues[ i * numberOfTensors + k ] = eigenValues[k][i];
+      
+    measureEigenValueComponents[i] = &measureEigenValues[ i * numberOfTensors ];
+  }
+  
+  std::vector<MeasureOutputType> values( numberOfTensors );
+  
+  for( unsigned int m=0; m<measures.size(); ++m )
+  {
+    backend->EvaluateMeasure( measures[m], measureEigenValueComponents, numberOfTensors, &values[0] );
+    
+    for( unsigned long k=0; k<numberOfTensors; ++k )
+    {
+      MeasureEigenValuesArrayType measureEigenValuesArray;
+      
+      for( unsigned int i=0; i<Dimension; ++i )
+        measureEigenValuesArray[i] = eigenValues[k][i];
+      
+      const MeasureOutputType expectedValue = measures[m]->EvaluateVesselnessFromEigenValues( measureEigenValuesArray );
+      
+      if( std::fabs( values[k] - expectedValue ) > 1e-6 * ( 1.0 + std::fabs( expectedValue ) ) )
+      {
+        std::cerr << measures[m]->GetNameOfClass() << " of " << eigenValues[k] << " is " << values[k] 
+          << " in batch, expected " << expectedValue << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // Empty batches do not touch the buffers
+  backend->ComputeEigenValues( 0, 0, 0 );
+  backend->EvaluateMeasure( frangi, measureEigenValueComponents, 0, 0 );
+  
+  // The filter computes every pixel of every scale through the backend it is given
+  ImageType::SizeType size;
+  size.Fill( 16 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 8.0;
+    const double dy = it.GetIndex()[1] - 8.0;
+    it.Set( 100.0 * exp( -0.5 * ( dx * dx + dy * dy ) / 4.0 ) );
+  }
+  
+  const unsigned int numberOfScales = 2;
+  
+  MultiscaleFilterType::Pointer cpuFilter = MultiscaleFilterType::New();
+  cpuFilter->SetInput( image );
+  cpuFilter->SetScales( numberOfScales, 1.0, 2.0 );
+  cpuFilter->SetDoNotComputeZeroPixels( false );
+  cpuFilter->AddMeasure( frangi );
+  cpuFilter->AddMeasure( sato );
+  
+  CountingBackend::Pointer countingBackend = CountingBackend::New();
+  
+  MultiscaleFilterType::Pointer countingFilter = MultiscaleFilterType::New();
+  countingFilter->SetInput( image );
+  countingFilter->SetScales( numberOfScales, 1.0, 2.0 );
+  countingFilter->SetDoNotComputeZeroPixels( false );
+  countingFilter->SetNumberOfThreads( 1 );
+  countingFilter->SetBackend( countingBackend );
+  countingFilter->AddMeasure( frangi );
+  countingFilter->AddMeasure( sato );
+  
+  try
+  {
+    cpuFilter->Update();
+    countingFilter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  const ImageType::RegionType region = image->GetBufferedRegion();
+  const unsigned long numberOfPixels = region.GetNumberOfPixels();
+  
+  if( countingBackend->m_NumberOfEigenValues != numberOfScales * numberOfPixels ||
+    countingBackend->m_NumberOfMeasureValues != numberOfScales * measures.size() * numberOfPixels )
+  {
+    std::cerr << "The backend computed " << countingBackend->m_NumberOfEigenValues << " eigenvalues and " 
+      << countingBackend->m_NumberOfMeasureValues << " measure values" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int m=0; m<measures.size(); ++m )
+  {
+    itk::ImageRegionConstIterator<OutputImageType> cpuIt( cpuFilter->GetMeasureOutput( m ), region );
+    itk::ImageRegionConstIterator<OutputImageType> countingIt( countingFilter->GetMeasureOutput( m ), region );
+    
+    for( cpuIt.GoToBegin(), countingIt.GoToBegin(); !cpuIt.IsAtEnd(); ++cpuIt, ++countingIt )
+    {
+      if( cpuIt.Get() != countingIt.Get() )
+      {
+        std::cerr << "Measure " << m << " differs between backends" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // A filter without backend cannot run
+  countingFilter->SetBackend( 0 );
+  
+  try
+  {
+    countingFilter->Update();
+    
+    std::cerr << "The filter ran without backend" << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch( itk::ExceptionObject & )
+  {
+  }
+  
+  return EXIT_SUCCESS;
+}
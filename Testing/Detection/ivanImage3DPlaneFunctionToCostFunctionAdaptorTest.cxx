@@ -0,0 +1,194 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImage3DPlaneFunctionToCostFunctionAdaptorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the values of the plane cost function adaptor and the hits, misses and 
+//   invalidation of its value cache.
+
+#include "ivanImage3DPlaneFunctionToCostFunctionAdaptor.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                                     PixelType;
+typedef itk::Image<PixelType,Dimension>                           ImageType;
+
+typedef itk::LinearInterpolateImageFunction<ImageType,double>     InterpolatorType;
+typedef ivan::Image3DPlaneFunctionToCostFunctionAdaptor<ImageType> CostFunctionType;
+
+
+bool CheckCounters( const CostFunctionType *costFunction, unsigned long evaluations, 
+  unsigned long hits, const char *step )
+{
+  if( costFunction->GetNumberOfEvaluations() != evaluations || 
+    costFunction->GetNumberOfCacheHits() != hits )
+  {
+    std::cerr << step << ": expected " << evaluations << " evaluations and " << hits 
+      << " cache hits, got " << costFunction->GetNumberOfEvaluations() << " and " 
+      << costFunction->GetNumberOfCacheHits() << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Linear image, interpolated exactly
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 20 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    it.Set( it.GetIndex()[0] + 2.0 * it.GetIndex()[1] + 3.0 * it.GetIndex()[2] );
+  
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( image );
+  
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetImageFunction( interpolator );
+  
+  CostFunctionType::PointType center;
+  center.Fill( 10.0 );
+  costFunction->SetPlaneCenter( center );
+  
+  CostFunctionType::VectorType normal;
+  normal.Fill( 0.0 );
+  normal[2] = 1.0;
+  costFunction->SetPlaneNormal( normal );
+  
+  CostFunctionType::ParametersType parameters( 2 );
+  parameters[0] = 1.5;
+  parameters[1] = -0.5;
+  
+  // Value of the plane point
+  const double value = costFunction->GetValue( parameters );
+  
+  CostFunctionType::PointType point = center;
+  
+  for( unsigned int i=0; i<Dimension; ++i )
+    point[i] += parameters[0] * costFunction->GetPlaneFirstBaseVector()[i] + 
+      parameters[1] * costFunction->GetPlaneSecondBaseVector()[i];
+  
+  const double expectedValue = point[0] + 2.0 * point[1] + 3.0 * point[2];
+  
+  if( std::fabs( value - expectedValue ) > 1e-4 )
+  {
+    std::cerr << "Value " << value << " differs from the expected " << expectedValue << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !CheckCounters( costFunction, 1, 0, "First query" ) )
+    return EXIT_FAILURE;
+  
+  // Same parameters hit the cache and give the same value
+  if( costFunction->GetValue( parameters ) != value || 
+    !CheckCounters( costFunction, 1, 1, "Repeated query" ) )
+    return EXIT_FAILURE;
+  
+  // Close parameters only hit the cache with a tolerance
+  CostFunctionType::ParametersType closeParameters = parameters;
+  closeParameters[0] += 0.01;
+  
+  costFunction->GetValue( closeParameters );
+  
+  if( !CheckCounters( costFunction, 2, 1, "Close query without tolerance" ) )
+    return EXIT_FAILURE;
+  
+  costFunction->SetCacheTolerance( 0.1 );
+  costFunction->GetValue( parameters );
+  costFunction->GetValue( closeParameters );
+  
+  if( !CheckCounters( costFunction, 3, 2, "Close query with tolerance" ) )
+    return EXIT_FAILURE;
+  
+  // Least recently used values are discarded
+  costFunction->SetCacheSize( 2 );
+  costFunction->ResetCounters();
+  
+  CostFunctionType::ParametersType otherParameters( 2 );
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    otherParameters[0] = i;
+    otherParameters[1] = i;
+    costFunction->GetValue( otherParameters );
+  }
+  
+  otherParameters[0] = 2.0;
+  otherParameters[1] = 2.0;
+  costFunction->GetValue( otherParameters );
+  
+  otherParameters[0] = 0.0;
+  otherParameters[1] = 0.0;
+  costFunction->GetValue( otherParameters );
+  
+  if( !CheckCounters( costFunction, 4, 1, "Least recently used" ) )
+    return EXIT_FAILURE;
+  
+  // Moving the plane or modifying the image function clears the cache
+  costFunction->ResetCounters();
+  costFunction->GetValue( parameters );
+  
+  center[0] += 1.0;
+  costFunction->SetPlaneCenter( center );
+  
+  if( std::fabs( costFunction->GetValue( parameters ) - ( value + 1.0 ) ) > 1e-4 || 
+    !CheckCounters( costFunction, 2, 0, "Moved plane" ) )
+    return EXIT_FAILURE;
+  
+  interpolator->Modified();
+  costFunction->GetValue( parameters );
+  
+  if( !CheckCounters( costFunction, 3, 0, "Modified image function" ) )
+    return EXIT_FAILURE;
+  
+  // Disabled cache
+  costFunction->SetCacheSize( 0 );
+  costFunction->GetValue( parameters );
+  costFunction->GetValue( parameters );
+  
+  if( !CheckCounters( costFunction, 5, 0, "Disabled cache" ) )
+    return EXIT_FAILURE;
+  
+  std::cout << "Test passed." << std::endl;
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageFunctionEvaluatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the static evaluation policies of the whole-image filters give the same
+//   multiscale vesselness as the virtual interface, and reports the time of each.
+// Date: 2012/11/05
+
+#include "ivanImageFunctionBasedImageFilter.h"
+#include "ivanAdaptiveMultiscaleImageFunctionBasedImageFilter.h"
+#include "ivanImageFunctionEvaluator.h"
+#include "ivanMultiscaleImageFunction.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>                   VesselnessFunctionType;
+typedef ivan::MultiscaleImageFunction<VesselnessFunctionType,ImageType,double>  MultiscaleFunctionType;
+
+
+/** Sets up the scales of the multiscale function created by the filter for each thread. */
+class MultiscaleFunctionInitializer : 
+  public ivan::ImageFunctionInitializerBase<MultiscaleFunctionType,ImageType>
+{
+public:
+
+  typedef MultiscaleFunctionInitializer                                         Self;
+  typedef ivan::ImageFunctionInitializerBase<MultiscaleFunctionType,ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                               Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual void Initialize( MultiscaleFunctionType *imageFunction, const ImageType *image = 0, double = 0.0 )
+    {
+      typedef ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType>  ScaledInitializerType;
+      
+      imageFunction->SetInputImage( image );
+      imageFunction->SetScaledImageFunctionInitializer( ScaledInitializerType::New() );
+      imageFunction->SetMinimumScale( 1.0 );
+      imageFunction->SetMaximumScale( 4.0 );
+      imageFunction->SetNumberOfScales( 4 );
+      imageFunction->Initialize();
+    }
+};
+
+
+/** Output of the filter, and the time of its update. */
+template <class TFilter>
+ImageType::Pointer ComputeVesselness( ImageType *image, const char *name )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetImageFunctionInitializer( MultiscaleFunctionInitializer::New() );
+  filter->SetThreshold( -1.0 );
+  filter->SetNumberOfThreads( 1 );
+  
+  itk::TimeProbe probe;
+  probe.Start();
+  filter->Update();
+  probe.Stop();
+  
+  std::cout << name << ": " << probe.GetTotal() << " s" << std::endl;
+  
+  return filter->GetOutput();
+}
+
+
+bool Compare( const ImageType *reference, const ImageType *output, const char *name )
+{
+  itk::ImageRegionConstIterator<ImageType> rit( reference, reference->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<ImageType> oit( output, output->GetLargestPossibleRegion() );
+  
+  for( rit.GoToBegin(), oit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++oit )
+  {
+    // The same operations, up to the contraction of the inlined code in fused multiply-adds
+    if( std::fabs( rit.Get() - oit.Get() ) > 1e-6 * ( 1.0 + std::fabs( rit.Get() ) ) )
+    {
+      std::cerr << name << " gives " << oit.Get() << " at " << oit.GetIndex() << ", expected " 
+                << rit.Get() << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  // Synthetic tube of gaussian section oblique to the axes
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 11.0;
+    const double dy = it.GetIndex()[1] - 15.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  typedef ivan::ScaledImageFunctionEvaluator<VesselnessFunctionType>      ScaledEvaluatorType;
+  typedef ivan::EigenValueVesselnessEvaluator<VesselnessFunctionType>     EigenValueEvaluatorType;
+  
+  typedef ivan::ImageFunctionBasedImageFilter
+    <ImageType,ImageType,MultiscaleFunctionType>                          VirtualFilterType;
+  typedef ivan::ImageFunctionBasedImageFilter<ImageType,ImageType,MultiscaleFunctionType,
+    ivan::StaticMultiscaleImageFunctionEvaluator<MultiscaleFunctionType,ScaledEvaluatorType> >
+                                                                          ScaledFilterType;
+  typedef ivan::ImageFunctionBasedImageFilter<ImageType,ImageType,MultiscaleFunctionType,
+    ivan::StaticMultiscaleImageFunctionEvaluator<MultiscaleFunctionType,EigenValueEvaluatorType> >
+                                                                          EigenValueFilterType;
+  
+  typedef ivan::AdaptiveMultiscaleImageFunctionBasedImageFilter
+    <ImageType,ImageType,MultiscaleFunctionType>                          VirtualAdaptiveFilterType;
+  typedef ivan::AdaptiveMultiscaleImageFunctionBasedImageFilter
+    <ImageType,ImageType,MultiscaleFunctionType,EigenValueEvaluatorType>  EigenValueAdaptiveFilterType;
+  
+  try
+  {
+    ImageType::Pointer reference = ComputeVesselness<VirtualFilterType>( image, "Virtual" );
+    ImageType::Pointer scaled = ComputeVesselness<ScaledFilterType>( image, "Static scaled functions" );
+    ImageType::Pointer eigenValue = ComputeVesselness<EigenValueFilterType>( image, "Static eigenvalue measure" );
+    
+    ImageType::Pointer adaptiveReference = ComputeVesselness<VirtualAdaptiveFilterType>( image, "Adaptive virtual" );
+    ImageType::Pointer adaptiveEigenValue = 
+      ComputeVesselness<EigenValueAdaptiveFilterType>( image, "Adaptive static eigenvalue measure" );
+    
+    if( !Compare( reference, scaled, "Static scaled function evaluation" ) || 
+        !Compare( reference, eigenValue, "Static eigenvalue evaluation" ) ||
+        !Compare( adaptiveReference, adaptiveEigenValue, "Static adaptive evaluation" ) )
+      return EXIT_FAILURE;
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    std::cerr << "ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
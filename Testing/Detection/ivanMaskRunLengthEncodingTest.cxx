@@ -0,0 +1,182 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMaskRunLengthEncodingTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the runs and bounding box of a mask against a pixel by pixel scan.
+
+#include "ivanMaskRunLengthEncoding.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<unsigned char,3>                   MaskImageType;
+  typedef ivan::MaskRunLengthEncoding<MaskImageType>    EncodingType;
+  
+  // Mask with a non-zero buffered region start, containing a ball and a single pixel 
+  MaskImageType::IndexType start;
+  start[0] = -4; start[1] = 2; start[2] = 1;
+  
+  MaskImageType::SizeType size;
+  size[0] = 25; size[1] = 20; size[2] = 15;
+  
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( MaskImageType::RegionType( start, size ) );
+  mask->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<MaskImageType> it( mask, mask->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const MaskImageType::IndexType index = it.GetIndex();
+    
+    const double dx = index[0] - 5.0;
+    const double dy = index[1] - 10.0;
+    const double dz = index[2] - 7.0;
+    
+    const bool inside = ( dx * dx + dy * dy + dz * dz <= 16.0 ) || 
+      ( index[0] == 18 && index[1] == 4 && index[2] == 3 );
+    
+    it.Set( inside ? 255 : 0 );
+  }
+  
+  EncodingType::Pointer encoding = EncodingType::New();
+  encoding->SetMaskImage( mask );
+  encoding->Initialize();
+  
+  // Expected number of pixels and bounding box
+  unsigned long numberOfPixels = 0;
+  
+  MaskImageType::IndexType minimumIndex, maximumIndex;
+  minimumIndex.Fill( 1000 );
+  maximumIndex.Fill( -1000 );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( !it.Get() )
+      continue;
+    
+    ++numberOfPixels;
+    
+    for( unsigned int i=0; i<3; ++i )
+    {
+      if( it.GetIndex()[i] < minimumIndex[i] )
+        minimumIndex[i] = it.GetIndex()[i];
+      if( it.GetIndex()[i] > maximumIndex[i] )
+        maximumIndex[i] = it.GetIndex()[i];
+    }
+  }
+  
+  if( encoding->GetNumberOfPixels() != numberOfPixels )
+  {
+    std::cerr << "Number of pixels is " << encoding->GetNumberOfPixels() << ", expected " 
+      << numberOfPixels << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const EncodingType::RegionType boundingBox = encoding->GetBoundingBox();
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    if( boundingBox.GetIndex()[i] != minimumIndex[i] || 
+        boundingBox.GetIndex()[i] + static_cast<long>( boundingBox.GetSize()[i] ) - 1 != maximumIndex[i] )
+    {
+      std::cerr << "Bounding box is " << boundingBox << ", expected from " << minimumIndex 
+        << " to " << maximumIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Every pixel of the runs must be in the mask
+  const EncodingType::RunContainerType & runs = encoding->GetRuns();
+  
+  for( EncodingType::RunContainerType::const_iterator rit = runs.begin(); rit != runs.end(); ++rit )
+  {
+    MaskImageType::IndexType index = rit->Index;
+    
+    for( unsigned long k=0; k<rit->Length; ++k, ++index[0] )
+    {
+      if( !mask->GetPixel( index ) )
+      {
+        std::cerr << "Pixel " << index << " of a run is outside the mask" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // Runs clipped to a region that cuts the ball
+  MaskImageType::IndexType clipStart;
+  clipStart[0] = 4; clipStart[1] = 8; clipStart[2] = 0;
+  
+  MaskImageType::SizeType clipSize;
+  clipSize[0] = 10; clipSize[1] = 4; clipSize[2] = 9;
+  
+  MaskImageType::RegionType clipRegion( clipStart, clipSize );
+  clipRegion.Crop( mask->GetBufferedRegion() );
+  
+  EncodingType::RunContainerType clippedRuns;
+  encoding->GetRunsInRegion( clipRegion, clippedRuns );
+  
+  unsigned long clippedPixels = 0;
+  
+  for( EncodingType::RunContainerType::const_iterator rit = clippedRuns.begin(); rit != clippedRuns.end(); ++rit )
+  {
+    MaskImageType::IndexType lastIndex = rit->Index;
+    lastIndex[0] += rit->Length - 1;
+    
+    if( !clipRegion.IsInside( rit->Index ) || !clipRegion.IsInside( lastIndex ) )
+    {
+      std::cerr << "Clipped run at " << rit->Index << " is outside " << clipRegion << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    clippedPixels += rit->Length;
+  }
+  
+  unsigned long expectedClippedPixels = 0;
+  
+  itk::ImageRegionConstIteratorWithIndex<MaskImageType> clipIt( mask, clipRegion );
+  
+  for( clipIt.GoToBegin(); !clipIt.IsAtEnd(); ++clipIt )
+  {
+    if( clipIt.Get() )
+      ++expectedClippedPixels;
+  }
+  
+  if( clippedPixels != expectedClippedPixels )
+  {
+    std::cerr << "Clipped runs have " << clippedPixels << " pixels, expected " 
+      << expectedClippedPixels << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleFusedScalesTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the fused slab mode filters each scale once per slab from a padded crop of
+//   the input, so that the work does not grow with the number of slabs, and that it matches the
+//   scale-by-scale execution.
+// Date: 2012/11/05
+
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionSplitter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image<float,Dimension>    ImageType;
+typedef itk::Image<double,Dimension>   OutputImageType;
+
+typedef ivan::MultiscaleHessianVesselnessMeasuresImageFilter
+  <ImageType,OutputImageType>                                  MultiscaleFilterType;
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>  FrangiFunctionType;
+
+const unsigned int NumberOfScales = 2;
+const double MinimumScale = 1.0;
+const double MaximumScale = 2.0;
+
+
+/** Run the filter on the image, returning null if an exception is thrown. */
+MultiscaleFilterType::Pointer RunFilter( ImageType *image, bool fused, unsigned int numberOfSlabs )
+{
+  MultiscaleFilterType::Pointer filter = MultiscaleFilterType::New();
+  filter->SetInput( image );
+  filter->SetScales( NumberOfScales, MinimumScale, MaximumScale );
+  filter->SetDoNotComputeZeroPixels( false );
+  filter->AddMeasure( FrangiFunctionType::New() );
+  filter->SetFusedScales( fused );
+  filter->SetNumberOfSlabs( numberOfSlabs );
+  
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return 0;
+  }
+  
+  return filter;
+}
+
+
+/** Pixels of the slabs padded by the kernel radius of the scale, as computed by the filter. */
+unsigned long GetPaddedSlabsPixels( const ImageType::RegionType & region, unsigned int numberOfSlabs, 
+  double scale, double kernelRadiusFactor )
+{
+  typedef itk::ImageRegionSplitter<Dimension>  SplitterType;
+  SplitterType::Pointer splitter = SplitterType::New();
+  
+  const unsigned int numberOfSplits = splitter->GetNumberOfSplits( region, numberOfSlabs );
+  
+  ImageType::RegionType::SizeType padding;
+  padding.Fill( static_cast<ImageType::RegionType::SizeValueType>( ceil( kernelRadiusFactor * scale ) ) );
+  
+  unsigned long pixels = 0;
+  
+  for( unsigned int i=0; i<numberOfSplits; ++i )
+  {
+    ImageType::RegionType slab = splitter->GetSplit( i, numberOfSplits, region );
+    slab.PadByRadius( padding );
+    slab.Crop( region );
+    pixels += slab.GetNumberOfPixels();
+  }
+  
+  return pixels;
+}
+
+
+int main( int, char ** )
+{
+  // Synthetic bright tube along z with a Gaussian profile, long along the slab direction
+  ImageType::SizeType size;
+  size[0] = 24;
+  size[1] = 24;
+  size[2] = 96;
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 12.0;
+    const double dy = it.GetIndex()[1] - 12.0;
+    it.Set( 100.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  const ImageType::RegionType region = image->GetBufferedRegion();
+  
+  MultiscaleFilterType::Pointer reference = RunFilter( image, false, 1 );
+  
+  if( reference.IsNull() )
+    return EXIT_FAILURE;
+  
+  double maximum = 0.0;
+  
+  itk::ImageRegionConstIterator<OutputImageType> rit( reference->GetMeasureOutput( 0 ), region );
+  
+  for( rit.GoToBegin(); !rit.IsAtEnd(); ++rit )
+    maximum = std::max( maximum, rit.Get() );
+  
+  const unsigned int numberOfSlabs[] = { 1, 6, 12 };
+  std::vector<unsigned long> totalPixels;
+  
+  for( unsigned int n=0; n<3; ++n )
+  {
+    MultiscaleFilterType::Pointer fused = RunFilter( image, true, numberOfSlabs[n] );
+    
+    if( fused.IsNull() )
+      return EXIT_FAILURE;
+    
+    // Each scale is filtered once per slab, in the slab padded by the kernel radius
+    const MultiscaleFilterType::ScaleStatisticsContainerType & statistics = fused->GetScaleStatistics();
+    unsigned long pixels = 0;
+    
+    for( unsigned int s=0; s<statistics.size(); ++s )
+    {
+      const unsigned long bound = GetPaddedSlabsPixels( region, numberOfSlabs[n], statistics[s].Scale, 
+        fused->GetKernelRadiusFactor() );
+      
+      std::cout << numberOfSlabs[n] << " slabs, scale " << statistics[s].Scale << ": " 
+        << statistics[s].NumberOfScaleFiltersPixels << " pixels filtered (bound " << bound << "), " 
+        << statistics[s].ScaleFiltersTime << " s" << std::endl;
+      
+      if( statistics[s].NumberOfScaleFiltersPixels == 0 || statistics[s].NumberOfScaleFiltersPixels > bound )
+      {
+        std::cerr << "Wrong number of pixels filtered at scale " << statistics[s].Scale << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      pixels += statistics[s].NumberOfScaleFiltersPixels;
+    }
+    
+    totalPixels.push_back( pixels );
+    
+    // The values only differ from the scale-by-scale execution by the tail of the kernels
+    itk::ImageRegionConstIterator<OutputImageType> fit( fused->GetMeasureOutput( 0 ), region );
+    
+    for( rit.GoToBegin(), fit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++fit )
+    {
+      if( std::fabs( fit.Get() - rit.Get() ) > 1e-2 * maximum )
+      {
+        std::cerr << "Fused measure with " << numberOfSlabs[n] << " slabs is " << fit.Get() 
+          << ", expected " << rit.Get() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // Twelve times the slabs do not give anything close to twelve times the work
+  if( totalPixels[0] != NumberOfScales * region.GetNumberOfPixels() || 
+    totalPixels[1] > 3 * totalPixels[0] || totalPixels[2] > 4 * totalPixels[0] )
+  {
+    std::cerr << "The work grows with the number of slabs: " << totalPixels[0] << ", " 
+      << totalPixels[1] << ", " << totalPixels[2] << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
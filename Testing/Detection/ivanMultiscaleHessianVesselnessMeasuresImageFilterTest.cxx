@@ -0,0 +1,237 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleHessianVesselnessMeasuresImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the multiscale measures against the maximum of single scale measures.
+
+#include "ivanMultiscaleHessianVesselnessMeasuresImageFilter.h"
+#include "ivanHessianToVesselnessMeasuresImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanSatoVesselnessImageFunction.h"
+
+#include "itkImage.h"
+#include "itkHessianRecursiveGaussianImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkCommand.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+
+unsigned int numberOfCompletedScales = 0;
+
+void OnScaleCompleted( itk::Object *, const itk::EventObject &, void * )
+{
+  ++numberOfCompletedScales;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  const unsigned int Dimension = 3;
+  
+  typedef itk::Image<float,Dimension>    ImageType;
+  typedef itk::Image<double,Dimension>   OutputImageType;
+  
+  typedef itk::HessianRecursiveGaussianImageFilter<ImageType>    HessianFilterType;
+  typedef HessianFilterType::OutputImageType                     TensorImageType;
+  
+  typedef ivan::MultiscaleHessianVesselnessMeasuresImageFilter
+    <ImageType,OutputImageType>                                  MultiscaleFilterType;
+  typedef ivan::HessianToVesselnessMeasuresImageFilter
+    <TensorImageType,OutputImageType>                            MeasuresFilterType;
+  typedef ivan::FrangiVesselnessImageFunction<ImageType,double>  FrangiFunctionType;
+  typedef ivan::SatoVesselnessImageFunction<ImageType,double>    SatoFunctionType;
+  
+  // Synthetic bright tube along z with a Gaussian profile
+  ImageType::SizeType size;
+  size.Fill( 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 12.0;
+    const double dy = it.GetIndex()[1] - 12.0;
+    it.Set( 100.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  FrangiFunctionType::Pointer frangi = FrangiFunctionType::New();
+  SatoFunctionType::Pointer sato = SatoFunctionType::New();
+  
+  const unsigned int numberOfScales = 3;
+  const double minimumScale = 1.0;
+  const double maximumScale = 3.0;
+  
+  MultiscaleFilterType::Pointer multiscaleFilter = MultiscaleFilterType::New();
+  multiscaleFilter->SetInput( image );
+  multiscaleFilter->SetScales( numberOfScales, minimumScale, maximumScale );
+  multiscaleFilter->SetDoNotComputeZeroPixels( false );
+  multiscaleFilter->AddMeasure( frangi );
+  multiscaleFilter->AddMeasure( sato );
+  
+  itk::CStyleCommand::Pointer scaleCommand = itk::CStyleCommand::New();
+  scaleCommand->SetCallback( &OnScaleCompleted );
+  multiscaleFilter->AddObserver( ivan::ScaleCompletedEvent(), scaleCommand );
+  
+  try
+  {
+    multiscaleFilter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  // One event and one set of statistics per scale
+  const MultiscaleFilterType::ScaleStatisticsContainerType & statistics = multiscaleFilter->GetScaleStatistics();
+  
+  if( numberOfCompletedScales != numberOfScales || statistics.size() != numberOfScales )
+  {
+    std::cerr << numberOfCompletedScales << " scale events and " << statistics.size() 
+      << " scale statistics, expected " << numberOfScales << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int s=0; s<numberOfScales; ++s )
+  {
+    if( statistics[s].ScaleFiltersTime < 0.0 || statistics[s].ComputeTime < 0.0 ||
+      std::fabs( statistics[s].Scale - ( minimumScale + s * ( maximumScale - minimumScale ) / ( numberOfScales - 1 ) ) ) > 1e-9 )
+    {
+      std::cerr << "Wrong statistics of scale " << s << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Compute the maximum over scales of each measure separately
+  const ImageType::RegionType region = image->GetBufferedRegion();
+  const unsigned long numberOfPixels = region.GetNumberOfPixels();
+  
+  std::vector<double> expectedFrangi( numberOfPixels, 0.0 );
+  std::vector<double> expectedSato( numberOfPixels, 0.0 );
+  std::vector<double> expectedScales( numberOfPixels, 0.0 );
+  
+  for( unsigned int s=0; s<numberOfScales; ++s )
+  {
+    const double scale = minimumScale + s * ( maximumScale - minimumScale ) / ( numberOfScales - 1 );
+    
+    HessianFilterType::Pointer hessianFilter = HessianFilterType::New();
+    hessianFilter->SetInput( image );
+    hessianFilter->SetSigma( scale );
+    hessianFilter->SetNormalizeAcrossScale( true );
+    
+    MeasuresFilterType::Pointer measuresFilter = MeasuresFilterType::New();
+    measuresFilter->SetInput( hessianFilter->GetOutput() );
+    measuresFilter->AddMeasure( frangi );
+    measuresFilter->AddMeasure( sato );
+    measuresFilter->Update();
+    
+    itk::ImageRegionConstIterator<OutputImageType> frangiIt( measuresFilter->GetOutput( 0 ), region );
+    itk::ImageRegionConstIterator<OutputImageType> satoIt( measuresFilter->GetOutput( 1 ), region );
+    
+    unsigned long i = 0;
+    
+    for( frangiIt.GoToBegin(), satoIt.GoToBegin(); !frangiIt.IsAtEnd(); ++frangiIt, ++satoIt, ++i )
+    {
+      if( frangiIt.Get() > expectedFrangi[i] )
+      {
+        expectedFrangi[i] = frangiIt.Get();
+        expectedScales[i] = scale;
+      }
+      
+      if( satoIt.Get() > expectedSato[i] )
+        expectedSato[i] = satoIt.Get();
+    }
+  }
+  
+  const double tolerance = 1e-4;
+  
+  itk::ImageRegionConstIterator<OutputImageType> frangiIt( multiscaleFilter->GetMeasureOutput( 0 ), region );
+  itk::ImageRegionConstIterator<OutputImageType> satoIt( multiscaleFilter->GetMeasureOutput( 1 ), region );
+  itk::ImageRegionConstIterator<MultiscaleFilterType::ScaleImageType> scalesIt( 
+    multiscaleFilter->GetOutputScales(), region );
+  
+  unsigned long i = 0;
+  
+  for( frangiIt.GoToBegin(), satoIt.GoToBegin(), scalesIt.GoToBegin(); !frangiIt.IsAtEnd(); 
+    ++frangiIt, ++satoIt, ++scalesIt, ++i )
+  {
+    if( std::fabs( frangiIt.Get() - expectedFrangi[i] ) > tolerance * std::max( 1.0, expectedFrangi[i] ) ||
+        std::fabs( satoIt.Get() - expectedSato[i] ) > tolerance * std::max( 1.0, expectedSato[i] ) )
+    {
+      std::cerr << "Measures at " << frangiIt.GetIndex() << " are " << frangiIt.Get() << " / " << satoIt.Get()
+        << ", expected " << expectedFrangi[i] << " / " << expectedSato[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( expectedFrangi[i] > tolerance && scalesIt.Get() != expectedScales[i] )
+    {
+      std::cerr << "Scale at " << frangiIt.GetIndex() << " is " << scalesIt.Get() 
+        << ", expected " << expectedScales[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The peak memory includes the Hessian at the largest region, which is released on request
+  const unsigned long hessianMemorySize = numberOfPixels * sizeof( MultiscaleFilterType::TensorScalePixelType );
+  
+  if( multiscaleFilter->GetPeakMemorySize() < hessianMemorySize )
+  {
+    std::cerr << "Peak memory " << multiscaleFilter->GetPeakMemorySize() << " does not include the Hessian" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  multiscaleFilter->ReleaseScaleFiltersDataOn();
+  multiscaleFilter->Modified();
+  
+  try
+  {
+    multiscaleFilter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  if( multiscaleFilter->GetMemorySize() + hessianMemorySize > multiscaleFilter->GetPeakMemorySize() )
+  {
+    std::cerr << "Scale filters hold " << multiscaleFilter->GetMemorySize() << " bytes after release, peak was "
+      << multiscaleFilter->GetPeakMemorySize() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleIncrementalUpdateTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that an incremental update of the medialness after local changes of the 
+//   input or the mask only computes and filters the affected regions and matches a complete 
+//   execution.
+
+#include "ivanMultiscaleMedialnessImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                                          ImageType;
+typedef ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType>  FilterType;
+
+
+/** Update the filter, returning false if an exception is thrown. */
+bool UpdateFilter( FilterType *filter )
+{
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+/** Compare the output of the incremental filter with a complete execution on the same input and
+  * mask. Pixels in the updated regions must be the same, the others may differ by the tail of
+  * the recursive gaussian kernels. */
+bool CompareWithCompleteExecution( FilterType *incremental, ImageType *image, ImageType *mask )
+{
+  FilterType::Pointer complete = FilterType::New();
+  complete->SetInput( image );
+  complete->SetMaskImage( mask );
+  complete->SetScales( 2, 1.0, 2.0 );
+  complete->SetDoNotComputeZeroPixels( false );
+  
+  if( !UpdateFilter( complete ) )
+    return false;
+  
+  const FilterType::RegionContainerType & updatedRegions = incremental->GetUpdatedRegions();
+  
+  itk::ImageRegionConstIterator<ImageType> cit( complete->GetOutput(), complete->GetOutput()->GetBufferedRegion() );
+  
+  double maximum = 0.0;
+  
+  for( cit.GoToBegin(); !cit.IsAtEnd(); ++cit )
+    maximum = std::max( maximum, std::fabs( static_cast<double>( cit.Get() ) ) );
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( incremental->GetOutput(), 
+    incremental->GetOutput()->GetBufferedRegion() );
+  
+  for( it.GoToBegin(), cit.GoToBegin(); !it.IsAtEnd(); ++it, ++cit )
+  {
+    bool updated = false;
+    
+    for( unsigned int i=0; i < updatedRegions.size(); ++i )
+      updated = updated || updatedRegions[i].IsInside( it.GetIndex() );
+    
+    const double tolerance = ( updated ? 1e-4 : 1e-2 ) * maximum;
+    
+    if( std::fabs( it.Get() - cit.Get() ) > tolerance )
+    {
+      std::cerr << "Medialness at " << it.GetIndex() << ( updated ? " (updated)" : "" ) << " is " 
+        << it.Get() << ", expected " << cit.Get() << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+/** Check that the scale filters of an incremental update only computed the updated regions padded
+  * by the support of the scale filters and of the gaussian kernels at each scale. */
+bool CheckFilteredPixels( FilterType *filter )
+{
+  const FilterType::RegionContainerType & updatedRegions = filter->GetUpdatedRegions();
+  const FilterType::ScaleStatisticsContainerType & statistics = filter->GetScaleStatistics();
+  const ImageType::RegionType largestRegion = filter->GetInput()->GetLargestPossibleRegion();
+  
+  for( unsigned int s=0; s<statistics.size(); ++s )
+  {
+    const double scale = statistics[s].Scale;
+    
+    ImageType::RegionType::SizeType padding;
+    padding.Fill( static_cast<ImageType::RegionType::SizeValueType>( 
+      ceil( filter->GetRadiusFactor() * scale ) + 1 + ceil( filter->GetKernelRadiusFactor() * scale ) ) );
+    
+    unsigned long bound = 0;
+    
+    for( unsigned int i=0; i < updatedRegions.size(); ++i )
+    {
+      ImageType::RegionType region = updatedRegions[i];
+      region.PadByRadius( padding );
+      region.Crop( largestRegion );
+      bound += region.GetNumberOfPixels();
+    }
+    
+    std::cout << "Scale " << scale << ": " << statistics[s].NumberOfScaleFiltersPixels 
+      << " pixels filtered, bound " << bound << std::endl;
+    
+    if( statistics[s].NumberOfScaleFiltersPixels > bound || 
+      statistics[s].NumberOfScaleFiltersPixels >= largestRegion.GetNumberOfPixels() )
+    {
+      std::cerr << "Scale " << scale << " filtered " << statistics[s].NumberOfScaleFiltersPixels 
+        << " pixels, more than the padded updated regions" << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  // Synthetic dark tube along x with a Gaussian profile
+  ImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 24;
+  size[2] = 24;
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+  mask->FillBuffer( 1.0 );
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dy = it.GetIndex()[1] - 12.0;
+    const double dz = it.GetIndex()[2] - 12.0;
+    it.Set( 100.0 - 80.0 * exp( -0.5 * ( dy * dy + dz * dz ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetMaskImage( mask );
+  filter->SetScales( 2, 1.0, 2.0 );
+  filter->SetDoNotComputeZeroPixels( false );
+  filter->IncrementalUpdateOn();
+  
+  if( !UpdateFilter( filter ) )
+    return EXIT_FAILURE;
+  
+  const unsigned long numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  
+  if( filter->GetUpdatedRegions().size() != 1 || 
+    filter->GetUpdatedRegions()[0] != filter->GetOutput()->GetRequestedRegion() )
+  {
+    std::cerr << "The first execution must compute the whole output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Darken a small box far from the tube, which only affects its neighbourhood
+  ImageType::IndexType index;
+  
+  for( index[0] = 52; index[0] < 55; ++index[0] )
+    for( index[1] = 4; index[1] < 7; ++index[1] )
+      for( index[2] = 4; index[2] < 7; ++index[2] )
+        image->SetPixel( index, 20.0 );
+  
+  image->Modified();
+  
+  if( !UpdateFilter( filter ) )
+    return EXIT_FAILURE;
+  
+  std::cout << "Updated regions after editing the input: " << filter->GetUpdatedRegions().size() << std::endl;
+  
+  if( filter->GetUpdatedRegions().size() != 1 || 
+    filter->GetUpdatedRegions()[0].GetNumberOfPixels() >= numberOfPixels / 2 )
+  {
+    std::cerr << "Wrong regions updated after editing the input" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !CheckFilteredPixels( filter ) || !CompareWithCompleteExecution( filter, image, mask ) )
+    return EXIT_FAILURE;
+  
+  // Nothing to compute if the values did not change
+  image->Modified();
+  
+  if( !UpdateFilter( filter ) )
+    return EXIT_FAILURE;
+  
+  if( !filter->GetUpdatedRegions().empty() )
+  {
+    std::cerr << "Regions updated without changes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Remove a part of the tube from the mask
+  for( index[0] = 5; index[0] < 9; ++index[0] )
+    for( index[1] = 10; index[1] < 15; ++index[1] )
+      for( index[2] = 10; index[2] < 15; ++index[2] )
+        mask->SetPixel( index, 0.0 );
+  
+  mask->Modified();
+  
+  if( !UpdateFilter( filter ) )
+    return EXIT_FAILURE;
+  
+  if( filter->GetUpdatedRegions().size() != 1 || 
+    filter->GetUpdatedRegions()[0].GetNumberOfPixels() >= numberOfPixels / 2 )
+  {
+    std::cerr << "Wrong regions updated after editing the mask" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  index[0] = 6;  index[1] = 12;  index[2] = 12;
+  
+  if( filter->GetOutput()->GetPixel( index ) != 0.0 )
+  {
+    std::cerr << "Medialness computed outside the mask" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !CheckFilteredPixels( filter ) || !CompareWithCompleteExecution( filter, image, mask ) )
+    return EXIT_FAILURE;
+  
+  // A change of the parameters computes everything again
+  filter->ClearScales();
+  filter->SetScales( 3, 1.0, 2.0 );
+  
+  if( !UpdateFilter( filter ) )
+    return EXIT_FAILURE;
+  
+  if( filter->GetUpdatedRegions().size() != 1 || 
+    filter->GetUpdatedRegions()[0] != filter->GetOutput()->GetRequestedRegion() )
+  {
+    std::cerr << "A change of the parameters must compute the whole output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
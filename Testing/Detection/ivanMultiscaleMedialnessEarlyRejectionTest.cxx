@@ -0,0 +1,136 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleMedialnessEarlyRejectionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the early rejection of pixels and the scale ordering do not change 
+// the medialness outputs.
+
+#include "ivanMultiscaleMedialnessImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<float,3>                                          ImageType;
+  typedef ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType>  FilterType;
+  
+  // Synthetic dark tube along z with a Gaussian profile over a modulated background
+  ImageType::SizeType size;
+  size.Fill( 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 12.0;
+    const double dy = it.GetIndex()[1] - 12.0;
+    it.Set( 100.0 - 80.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) + 
+      5.0 * sin( 0.7 * it.GetIndex()[2] + 0.3 * it.GetIndex()[0] ) );
+  }
+  
+  // Without rejection, with rejection, with the local bound and with the scales ordered by a coarse pass
+  const unsigned int numberOfFilters = 4;
+  FilterType::Pointer filters[numberOfFilters];
+  
+  for( unsigned int f=0; f<numberOfFilters; ++f )
+  {
+    filters[f] = FilterType::New();
+    filters[f]->SetInput( image );
+    filters[f]->SetScales( 3, 1.0, 3.0 );
+    filters[f]->SetDoNotComputeZeroPixels( false );
+    filters[f]->FilterByEigenValuesOn();
+    filters[f]->SetOutputThreshold( 1.0 );
+    filters[f]->SetEarlyRejection( f > 0 );
+    filters[f]->SetLocalRejectionBound( f > 1 );
+    filters[f]->SetOrderScalesByCoarsePass( f > 2 );
+    
+    try
+    {
+      filters[f]->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The outputs must be the same with and without rejection
+  itk::ImageRegionConstIterator<ImageType> it0( filters[0]->GetOutput(), filters[0]->GetOutput()->GetBufferedRegion() );
+  
+  for( unsigned int f=1; f<numberOfFilters; ++f )
+  {
+    itk::ImageRegionConstIterator<ImageType> it1( filters[f]->GetOutput(), filters[f]->GetOutput()->GetBufferedRegion() );
+    
+    for( it0.GoToBegin(), it1.GoToBegin(); !it0.IsAtEnd(); ++it0, ++it1 )
+    {
+      if( it0.Get() != it1.Get() )
+      {
+        std::cerr << "Medialness of filter " << f << " is " << it1.Get() << ", expected " << it0.Get() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // The rejected pixels are not computed, and the local bound rejects at least the same pixels
+  const FilterType::ScaleStatisticsContainerType & statistics0 = filters[0]->GetScaleStatistics();
+  const FilterType::ScaleStatisticsContainerType & statistics1 = filters[1]->GetScaleStatistics();
+  const FilterType::ScaleStatisticsContainerType & statistics2 = filters[2]->GetScaleStatistics();
+  
+  for( unsigned int s=0; s<statistics0.size(); ++s )
+  {
+    if( statistics0[s].NumberOfBoundSkippedPixels != 0 || 
+      statistics1[s].NumberOfProcessedPixels > statistics0[s].NumberOfProcessedPixels ||
+      statistics1[s].NumberOfProcessedPixels + statistics1[s].NumberOfBoundSkippedPixels +
+      statistics1[s].NumberOfEigenValueSkippedPixels != statistics0[s].NumberOfProcessedPixels +
+      statistics0[s].NumberOfEigenValueSkippedPixels )
+    {
+      std::cerr << "Wrong pixel counts at scale " << statistics0[s].Scale << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( statistics2[s].NumberOfProcessedPixels > statistics1[s].NumberOfProcessedPixels )
+    {
+      std::cerr << "Local bound computes " << statistics2[s].NumberOfProcessedPixels << " pixels at scale " 
+        << statistics2[s].Scale << ", global bound " << statistics1[s].NumberOfProcessedPixels << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleMedialnessNormalEncodingTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the angular error of the octahedral encoding of the medialness normals.
+
+#include "ivanMultiscaleMedialnessImageFilter.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<float,3>                                          ImageType;
+  typedef ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType>  FilterType;
+  
+  FilterType::VectorPixelType normal, decodedNormal;
+  FilterType::EncodedNormalPixelType encodedNormal;
+  
+  const double maximumError = 1e-4;
+  
+  // Normals on a latitude-longitude grid, including the poles and the equator
+  const unsigned int steps = 90;
+  
+  for( unsigned int i=0; i<=steps; ++i )
+  {
+    const double theta = vnl_math::pi * i / steps;
+    
+    for( unsigned int j=0; j<2*steps; ++j )
+    {
+      const double phi = vnl_math::pi * j / steps;
+      
+      normal[0] = sin( theta ) * cos( phi );
+      normal[1] = sin( theta ) * sin( phi );
+      normal[2] = cos( theta );
+      
+      FilterType::EncodeNormal( normal, encodedNormal );
+      FilterType::DecodeNormal( encodedNormal, decodedNormal );
+      
+      double dot = normal * decodedNormal;
+      
+      if( dot > 1.0 )
+        dot = 1.0;
+      
+      if( std::fabs( decodedNormal.GetNorm() - 1.0 ) > 1e-6 || acos( dot ) > maximumError )
+      {
+        std::cerr << "Normal " << normal << " decoded as " << decodedNormal << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -47,7 +47,7 @@ int main( int argc, const char *argv[] )
   if( argc < 6 )
   {
     std::cerr << "Usage: " << argv[0] << "InputImage TestMode(0-1) OutputImage NumScales MinScale MaxScale [ScaleIsRadius] [FixedRadiusOrSigma] [GradientSigma=1.0]"
-      "[SymmetryCoefficient(0.0-1.0)=0.5] [Rescale=1]" << std::endl;
+      "[SymmetryCoefficient(0.0-1.0)=0.5] [Rescale=1] [ScaleSearchMethod(0-2)=0] [UseGradientImage=0] [InitializationThreads=1]" << std::endl;
     return EXIT_FAILURE;
   }
 
@@ -117,13 +117,27 @@ int main( int argc, const char *argv[] )
     initializer->SetSymmetryCoefficient( atof( argv[10] ) );
   else
     initializer->SetSymmetryCoefficient( 0.5 );
+  
+  if( argc > 13 )
+    initializer->SetUseGradientImage( atoi( argv[13] ) );
  
   multiscaleMedialness->SetScaledImageFunctionInitializer( initializer );
    
   multiscaleMedialness->SetNumberOfScales( atoi( argv[4] ) );
   multiscaleMedialness->SetMinimumScale( atoi( argv[5] ) );
   multiscaleMedialness->SetMaximumScale( atoi( argv[6] ) );
+  
+  if( argc > 12 )
+    multiscaleMedialness->SetScaleSearchMethod
+      ( static_cast<MultiscaleMedialnessFunctionType::ScaleSearchMethodType>( atoi( argv[12] ) ) );
+  
+  if( argc > 14 )
+    multiscaleMedialness->SetNumberOfInitializationThreads( atoi( argv[14] ) );
+    
   multiscaleMedialness->Initialize();
+  
+  if( initializer->GetUseGradientImage() )
+    std::cout << "Gradient image memory: " << initializer->GetGradientImageMemorySize() << " bytes" << std::endl;
 
   bool testMode = atoi( argv[2] );
   
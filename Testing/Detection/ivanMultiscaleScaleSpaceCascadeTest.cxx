@@ -0,0 +1,257 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleScaleSpaceCascadeTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the derivatives of the scale-space cascade match those of the recursive 
+//   gaussian filters at every scale, and that the threaded derivative pass does not depend on the
+//   number of threads.
+// Date: 2012/11/05
+
+#include "ivanMultiscaleAnalysisImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image<float,Dimension>    ImageType;
+typedef itk::Image<double,Dimension>   OutputImageType;
+
+
+/** Multiscale filter that allocates all the scale filters and keeps a copy of the derivative 
+  * images, in the given region, at each scale. */
+class DerivativesRecorder : public ivan::MultiscaleAnalysisImageFilter<ImageType,OutputImageType>
+{
+public:
+
+  typedef DerivativesRecorder                                          Self;
+  typedef ivan::MultiscaleAnalysisImageFilter<ImageType,OutputImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                      Pointer;
+  
+  typedef std::vector<double>                                          ValueContainerType;
+  typedef std::map<ScalePixelType,ValueContainerType>                  ScaleValuesMapType;
+  
+  itkNewMacro( Self );
+  
+  void SetRecordedRegion( const OutputImageRegionType & region )
+    { m_RecordedRegion = region; }
+  
+  /** Gradient magnitude, gradient, hessian and laplacian of each pixel of the recorded region. */
+  const ScaleValuesMapType & GetValues() const
+    { return m_Values; }
+  
+protected:
+
+  DerivativesRecorder()
+    {
+      this->m_GradientMagnitudeGaussian = GradientMagnitudeFilterType::New();
+      this->m_GradientMagnitudeGaussian->SetNormalizeAcrossScale( true );
+      this->m_GradientGaussian = GradientFilterType::New();
+      this->m_GradientGaussian->SetNormalizeAcrossScale( true );
+      this->m_HessianGaussian = HessianFilterType::New();
+      this->m_HessianGaussian->SetNormalizeAcrossScale( true );
+      this->m_LaplacianGaussian = LaplacianFilterType::New();
+      this->m_LaplacianGaussian->SetNormalizeAcrossScale( true );
+    }
+  
+  virtual void GenerateDataAtScale( const ScalePixelType currentScale )
+    {
+      ValueContainerType & values = m_Values[currentScale];
+      values.clear();
+      
+      itk::ImageRegionConstIteratorWithIndex<ScaleImageType> it( this->GetGradientMagnitudeImage(), 
+        m_RecordedRegion );
+      
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+        const ScaleImageType::IndexType index = it.GetIndex();
+        
+        values.push_back( it.Get() );
+        
+        const VectorScalePixelType gradient = this->GetGradientImage()->GetPixel( index );
+        const TensorScalePixelType hessian = this->GetHessianImage()->GetPixel( index );
+        
+        for( unsigned int i=0; i<Dimension; ++i )
+          values.push_back( gradient[i] );
+        
+        for( unsigned int i=0; i<Dimension; ++i )
+          for( unsigned int j=i; j<Dimension; ++j )
+            values.push_back( hessian( i, j ) );
+        
+        values.push_back( this->GetLaplacianImage()->GetPixel( index ) );
+      }
+    }
+  
+  OutputImageRegionType    m_RecordedRegion;
+  ScaleValuesMapType       m_Values;
+};
+
+
+/** Number of values recorded per pixel. */
+const unsigned int NumberOfValues = 2 + Dimension + Dimension * ( Dimension + 1 ) / 2;
+
+
+/** Run the recorder on the image, returning null if an exception is thrown. */
+DerivativesRecorder::Pointer RunRecorder( ImageType *image, const ImageType::RegionType & recordedRegion,
+  bool cascade, unsigned int numberOfThreads )
+{
+  DerivativesRecorder::Pointer recorder = DerivativesRecorder::New();
+  recorder->SetInput( image );
+  recorder->SetScales( 3, 2.0, 4.0 );
+  recorder->SetDoNotComputeZeroPixels( false );
+  recorder->SetScaleSpaceCascade( cascade );
+  recorder->SetNumberOfThreads( numberOfThreads );
+  recorder->SetRecordedRegion( recordedRegion );
+  
+  try
+  {
+    recorder->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return 0;
+  }
+  
+  return recorder;
+}
+
+
+int main( int, char ** )
+{
+  // Synthetic bright tube along z with a Gaussian profile, slightly off the grid
+  ImageType::SizeType size;
+  size[0] = 32;
+  size[1] = 32;
+  size[2] = 12;
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 15.7;
+    const double dy = it.GetIndex()[1] - 16.2;
+    it.Set( 100.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  // The central differences of the cascade are one-sided at the border of the image
+  const unsigned int border = 4;
+  
+  ImageType::IndexType recordedIndex;
+  recordedIndex.Fill( 0 );
+  recordedIndex[0] = border;
+  recordedIndex[1] = border;
+  
+  ImageType::SizeType recordedSize = size;
+  recordedSize[0] -= 2 * border;
+  recordedSize[1] -= 2 * border;
+  
+  const ImageType::RegionType recordedRegion( recordedIndex, recordedSize );
+  
+  DerivativesRecorder::Pointer reference = RunRecorder( image, recordedRegion, false, 1 );
+  DerivativesRecorder::Pointer serialCascade = RunRecorder( image, recordedRegion, true, 1 );
+  DerivativesRecorder::Pointer threadedCascade = RunRecorder( image, recordedRegion, true, 4 );
+  
+  if( reference.IsNull() || serialCascade.IsNull() || threadedCascade.IsNull() )
+    return EXIT_FAILURE;
+  
+  if( reference->GetValues().size() != 3 || serialCascade->GetValues().size() != 3 || 
+    threadedCascade->GetValues().size() != 3 )
+  {
+    std::cerr << "Not all the scales were computed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  DerivativesRecorder::ScaleValuesMapType::const_iterator rit = reference->GetValues().begin();
+  DerivativesRecorder::ScaleValuesMapType::const_iterator sit = serialCascade->GetValues().begin();
+  DerivativesRecorder::ScaleValuesMapType::const_iterator tit = threadedCascade->GetValues().begin();
+  
+  for( ; rit != reference->GetValues().end(); ++rit, ++sit, ++tit )
+  {
+    const DerivativesRecorder::ValueContainerType & referenceValues = rit->second;
+    const DerivativesRecorder::ValueContainerType & cascadeValues = sit->second;
+    
+    if( sit->first != rit->first || tit->first != rit->first || 
+      cascadeValues.size() != referenceValues.size() || tit->second.size() != referenceValues.size() )
+    {
+      std::cerr << "Wrong scales or number of values at scale " << rit->first << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The threads write disjoint lines, so the values do not depend on their number
+    if( tit->second != cascadeValues )
+    {
+      std::cerr << "The threaded cascade differs from the serial one at scale " << rit->first << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Each derivative is compared relative to its largest magnitude in the region. The central 
+    // differences add a relative error of the order of 1 / ( 3 sigma^2 ), with the sigma of the
+    // smoothed tube, to that of the recursive filters
+    std::vector<double> maximum( NumberOfValues, 0.0 );
+    
+    for( unsigned int k=0; k<referenceValues.size(); ++k )
+      maximum[k % NumberOfValues] = std::max( maximum[k % NumberOfValues], std::fabs( referenceValues[k] ) );
+    
+    std::vector<double> maximumError( NumberOfValues, 0.0 );
+    
+    for( unsigned int k=0; k<referenceValues.size(); ++k )
+    {
+      maximumError[k % NumberOfValues] = std::max( maximumError[k % NumberOfValues], 
+        std::fabs( cascadeValues[k] - referenceValues[k] ) );
+    }
+    
+    for( unsigned int v=0; v<NumberOfValues; ++v )
+    {
+      std::cout << "Scale " << rit->first << ", derivative " << v << ": maximum " << maximum[v] 
+        << ", error " << maximumError[v] << std::endl;
+      
+      // Derivatives along the tube are zero up to the rounding of both methods
+      if( maximumError[v] > 0.08 * maximum[v] + 1e-3 )
+      {
+        std::cerr << "The cascade derivative " << v << " differs from the recursive filters by " 
+          << maximumError[v] << " at scale " << rit->first << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
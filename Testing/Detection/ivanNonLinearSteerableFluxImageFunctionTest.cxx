@@ -43,7 +43,7 @@ int main( int argc, const char *argv[] )
 {
   if( argc < 2 )
   {
-    std::cerr << "Usage: " << argv[0] << "InputImage TestMode(0-1) [OutputImage] [Sigma] [Rescale=1]" << std::endl;
+    std::cerr << "Usage: " << argv[0] << "InputImage TestMode(0-1) [OutputImage] [Sigma] [Rescale=1] [UseGradientImage=0]" << std::endl;
     return EXIT_FAILURE;
   }
 
@@ -77,6 +77,9 @@ int main( int argc, const char *argv[] )
     vesselness->SetSigma( atof( argv[4] ) );
   else
     vesselness->SetSigma( 2.0 );
+  
+  if( argc > 6 )
+    vesselness->SetUseGradientImage( atoi( argv[6] ) );
 
   vesselness->Initialize();
     
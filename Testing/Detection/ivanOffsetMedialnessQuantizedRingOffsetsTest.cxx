@@ -0,0 +1,153 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanOffsetMedialnessQuantizedRingOffsetsTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the offset medialness computed with quantized ring offsets with the
+// exact circle sampling.
+
+#include "ivanOffsetMedialnessImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char *argv[] )
+{
+  typedef itk::Image<float,3>                                    ImageType;
+  typedef ivan::OffsetMedialnessImageFunction<ImageType,double>  MedialnessFunctionType;
+  
+  // Synthetic bright tube along z with a Gaussian profile
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 16.0;
+    const double dy = it.GetIndex()[1] - 16.0;
+    it.Set( 20.0 + 80.0 * exp( -0.5 * ( dx * dx + dy * dy ) / ( tubeSigma * tubeSigma ) ) );
+  }
+  
+  // Exact and quantized functions
+  MedialnessFunctionType::Pointer medialness[2];
+  
+  for( unsigned int f=0; f<2; ++f )
+  {
+    medialness[f] = MedialnessFunctionType::New();
+    medialness[f]->SetInputImage( image );
+    medialness[f]->SetSigma( 2.0 );
+    medialness[f]->SetRadius( 3.5 );
+    medialness[f]->SetRadialResolution( 16 );
+    medialness[f]->SetGradientSigma( 1.0 );
+    medialness[f]->UseGradientImageOn();
+    medialness[f]->SetUseQuantizedRingOffsets( f == 1 );
+    
+    try
+    {
+      medialness[f]->Initialize();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( medialness[0]->GetNumberOfRingDirections() != 0 || medialness[1]->GetNumberOfRingDirections() != 
+    medialness[1]->GetRingDirectionResolution() * medialness[1]->GetRingDirectionResolution() )
+  {
+    std::cerr << "Wrong number of ring directions" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Values along the centerline must be close, and the maximum of each section must be at the centerline
+  ImageType::IndexType index;
+  
+  for( index[2] = 8; index[2] < 24; index[2] += 4 )
+  {
+    for( unsigned int f=0; f<2; ++f )
+    {
+      double maximum = -1.0;
+      ImageType::IndexType maximumIndex;
+      
+      for( index[1] = 12; index[1] <= 20; ++index[1] )
+      {
+        for( index[0] = 12; index[0] <= 20; ++index[0] )
+        {
+          const double value = medialness[f]->EvaluateAtIndex( index );
+          
+          if( value > maximum )
+          {
+            maximum = value;
+            maximumIndex = index;
+          }
+        }
+      }
+      
+      if( maximumIndex[0] != 16 || maximumIndex[1] != 16 )
+      {
+        std::cerr << "Maximum of function " << f << " at " << maximumIndex << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    index[0] = 16;
+    index[1] = 16;
+    
+    const double exact = medialness[0]->EvaluateAtIndex( index );
+    const double quantized = medialness[1]->EvaluateAtIndex( index );
+    
+    if( exact <= 0.0 || fabs( quantized - exact ) > 0.1 * exact )
+    {
+      std::cerr << "Quantized medialness is " << quantized << ", exact " << exact << " at " << index << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Outdated tables are not used
+  medialness[0]->SetRadius( 3.0 );
+  medialness[1]->SetRadius( 3.0 );
+  
+  index.Fill( 16 );
+  
+  if( medialness[0]->EvaluateAtIndex( index ) != medialness[1]->EvaluateAtIndex( index ) )
+  {
+    std::cerr << "Outdated ring offsets were used" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
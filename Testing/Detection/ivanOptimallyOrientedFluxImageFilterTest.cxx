@@ -0,0 +1,126 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanOptimallyOrientedFluxImageFilterTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests optimally oriented flux measure (Law & Chung 2008) computed for the whole image with the FFT.
+// Date: 2012/11/05
+
+
+#include "ivanOptimallyOrientedFluxImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkMinimumMaximumImageCalculator.h"
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 4 )
+  {
+    std::cerr << "Usage: " << argv[0] << " InputImage OutputFileName Radius [Sigma=1.0]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  typedef float       PixelType;
+  const unsigned int Dimension = 3;
+  typedef itk::Image<PixelType,Dimension>       ImageType;
+  typedef itk::Image<double,Dimension>          OutputImageType;
+  
+  typedef itk::ImageFileReader<ImageType>  ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  
+  typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+  typedef ivan::OptimallyOrientedFluxImageFilter
+    <ImageType,OutputImageType,EigenvalueFunctorType>                FilterType;
+  
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetRadius( atof( argv[3] ) );
+  filter->SetMaximumRadius( 2.0 * filter->GetRadius() );
+  filter->NormalizeAcrossScaleOn();
+  
+  if( argc > 4 )
+    filter->SetSigma( atof( argv[4] ) );
+    
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  // Vessels must give some positive response
+  typedef itk::MinimumMaximumImageCalculator<OutputImageType>  CalculatorType;
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetImage( filter->GetOutput() );
+  calculator->ComputeMaximum();
+  
+  std::cout << "Maximum response: " << calculator->GetMaximum() << std::endl;
+  
+  if( calculator->GetMaximum() <= 0.0 )
+  {
+    std::cerr << "No positive response found" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Running again at a larger radius, up to the maximum, reuses the spectrum of the input
+  filter->SetRadius( filter->GetMaximumRadius() );
+  
+  typedef itk::RescaleIntensityImageFilter<OutputImageType,ImageType>  RescaleFilterType;
+  RescaleFilterType::Pointer rescaleFilter = RescaleFilterType::New();
+  rescaleFilter->SetInput( filter->GetOutput() );
+  rescaleFilter->SetOutputMinimum( 0.0 );
+  rescaleFilter->SetOutputMaximum( 255.0 );
+  
+  typedef itk::ImageFileWriter<ImageType>  WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( rescaleFilter->GetOutput() );
+  writer->SetFileName( argv[2] );
+  
+  try
+  {
+    writer->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  if( filter->GetNumberOfSpectrumComputations() != 1 )
+  {
+    std::cerr << "Spectrum computed " << filter->GetNumberOfSpectrumComputations() 
+      << " times for two radii" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPerformanceProfileTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the statistics of the performance profile recorded concurrently from 
+//   several threads into several profiles, which are merged when they are read.
+
+#include "ivanPerformanceProfile.h"
+
+#include "itkMultiThreader.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+typedef ivan::PerformanceProfile    ProfileType;
+
+const unsigned int NumberOfThreads = 4;
+const unsigned int NumberOfCallsPerThread = 1000;
+
+// More than the profiles cached by each thread
+const unsigned int NumberOfProfiles = 6;
+
+
+struct ThreadData
+{
+  ProfileType::Pointer      Profiles[NumberOfProfiles];
+  ProfileType::ProbeIdType  TimedProbe;
+  ProfileType::ProbeIdType  CountedProbe;
+};
+
+
+ITK_THREAD_RETURN_TYPE RecordCalls( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *threadInfo = 
+    static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  ThreadData *data = static_cast<ThreadData *>( threadInfo->UserData );
+  
+  // One call in a hundred takes a second, the rest a millisecond. The profiles alternate, 
+  // so the thread caches are replaced all the time
+  for( unsigned int i=0; i<NumberOfCallsPerThread; ++i )
+  {
+    for( unsigned int p=0; p<NumberOfProfiles; ++p )
+    {
+      data->Profiles[p]->Record( data->TimedProbe, ( i % 100 == 99 ) ? 1.0 : 1e-3 );
+      data->Profiles[p]->Increment( data->CountedProbe, 2 );
+    }
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+bool CheckProfile( const ProfileType *profile, unsigned long numberOfCalls, 
+  ProfileType::ProbeIdType timedProbe, ProfileType::ProbeIdType countedProbe )
+{
+  const double slowCalls = numberOfCalls / 100;
+  const double totalTime = slowCalls * 1.0 + ( numberOfCalls - slowCalls ) * 1e-3;
+  
+  if( profile->GetCount( timedProbe ) != numberOfCalls ||
+      profile->GetCount( countedProbe ) != 2 * numberOfCalls ||
+      std::fabs( profile->GetTotalTime( timedProbe ) - totalTime ) > 1e-6 * totalTime ||
+      std::fabs( profile->GetMeanTime( timedProbe ) - totalTime / numberOfCalls ) > 1e-9 ||
+      profile->GetTotalTime( countedProbe ) != 0.0 )
+  {
+    std::cerr << "Wrong statistics: count " << profile->GetCount( timedProbe ) 
+      << " total " << profile->GetTotalTime( timedProbe ) << " expected " << numberOfCalls
+      << " and " << totalTime << std::endl;
+    return false;
+  }
+  
+  // The histogram is accurate to about 9%
+  const double p50 = profile->GetPercentileTime( timedProbe, 0.5 );
+  const double p99 = profile->GetPercentileTime( timedProbe, 0.99 );
+  const double p100 = profile->GetPercentileTime( timedProbe, 1.0 );
+  
+  if( std::fabs( p50 - 1e-3 ) > 0.1e-3 || std::fabs( p99 - 1e-3 ) > 0.1e-3 || 
+      std::fabs( p100 - 1.0 ) > 0.1 )
+  {
+    std::cerr << "Wrong percentiles: p50 " << p50 << " p99 " << p99 << " p100 " << p100 << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ThreadData data;
+  
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    data.Profiles[p] = ProfileType::New();
+    data.TimedProbe = data.Profiles[p]->RegisterProbe( "Search" );
+    data.CountedProbe = data.Profiles[p]->RegisterProbe( "Evaluations" );
+  }
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( RecordCalls, &data );
+  threader->SingleMethodExecute();
+  
+  const unsigned long numberOfCalls = threader->GetNumberOfThreads() * NumberOfCallsPerThread;
+  
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    if( !CheckProfile( data.Profiles[p], numberOfCalls, data.TimedProbe, data.CountedProbe ) )
+    {
+      std::cerr << "Profile " << p << " after the first run" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Reset clears the statistics of every thread, and the same threads record again
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    data.Profiles[p]->Reset();
+    
+    if( data.Profiles[p]->GetCount( data.TimedProbe ) != 0 || 
+        data.Profiles[p]->GetCount( data.CountedProbe ) != 0 ||
+        data.Profiles[p]->GetPercentileTime( data.TimedProbe, 0.99 ) != 0.0 )
+    {
+      std::cerr << "Wrong reset of profile " << p << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  threader->SingleMethodExecute();
+  
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    if( !CheckProfile( data.Profiles[p], numberOfCalls, data.TimedProbe, data.CountedProbe ) )
+    {
+      std::cerr << "Profile " << p << " after the reset" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // New profiles, possibly at the addresses of the released ones, start empty, and a probe 
+  // registered after the threads recorded is counted too
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    data.Profiles[p] = 0;
+    data.Profiles[p] = ProfileType::New();
+    data.Profiles[p]->RegisterProbe( "Other" );
+    data.TimedProbe = data.Profiles[p]->RegisterProbe( "Search" );
+    data.CountedProbe = data.Profiles[p]->RegisterProbe( "Evaluations" );
+  }
+  
+  threader->SingleMethodExecute();
+  
+  for( unsigned int p=0; p<NumberOfProfiles; ++p )
+  {
+    if( !CheckProfile( data.Profiles[p], numberOfCalls, data.TimedProbe, data.CountedProbe ) ||
+        data.Profiles[p]->GetCount( 0 ) != 0 )
+    {
+      std::cerr << "Profile " << p << " after replacing the profiles" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Calls from the main thread are merged with those of the threads
+  data.Profiles[0]->Record( data.TimedProbe, 1e-3 );
+  
+  if( data.Profiles[0]->GetCount( data.TimedProbe ) != numberOfCalls + 1 )
+  {
+    std::cerr << "Call of the main thread not merged" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPerformanceProfileTraceTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the trace of the performance profile recorded from several threads, 
+//   its ring buffer and its Chrome trace output.
+
+#include "ivanPerformanceProfile.h"
+
+#include "itkMultiThreader.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+
+
+typedef ivan::PerformanceProfile    ProfileType;
+
+const unsigned int NumberOfThreads = 4;
+const unsigned int NumberOfCallsPerThread = 100;
+const unsigned int TraceCapacity = 256;
+
+
+struct ThreadData
+{
+  ProfileType              *Profile;
+  ProfileType::ProbeIdType  FirstProbe;
+  ProfileType::ProbeIdType  SecondProbe;
+};
+
+
+ITK_THREAD_RETURN_TYPE RecordCalls( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *threadInfo = 
+    static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  ThreadData *data = static_cast<ThreadData *>( threadInfo->UserData );
+  
+  for( unsigned int i=0; i<NumberOfCallsPerThread; ++i )
+  {
+    ProfileType::ScopedTimer timer( data->Profile, 
+      ( i % 2 ) ? data->SecondProbe : data->FirstProbe );
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+unsigned int CountOccurrences( const std::string & text, const std::string & pattern )
+{
+  unsigned int count = 0;
+  
+  for( std::string::size_type pos = text.find( pattern ); pos != std::string::npos; 
+       pos = text.find( pattern, pos + pattern.size() ) )
+    ++count;
+  
+  return count;
+}
+
+
+int main( int, char ** )
+{
+  ProfileType::Pointer profile = ProfileType::New();
+  
+  ThreadData data;
+  data.Profile = profile;
+  data.FirstProbe = profile->RegisterProbe( "Search" );
+  data.SecondProbe = profile->RegisterProbe( "Scale \"2\"" );
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( RecordCalls, &data );
+  
+  // The trace is disabled by default
+  threader->SingleMethodExecute();
+  
+  if( profile->GetNumberOfTraceEvents() != 0 || 
+      profile->GetCount( data.FirstProbe ) + profile->GetCount( data.SecondProbe ) != 
+        threader->GetNumberOfThreads() * NumberOfCallsPerThread )
+  {
+    std::cerr << "Wrong disabled trace" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // With more calls than the capacity, only the last ones are kept
+  profile->SetTraceCapacity( TraceCapacity );
+  profile->Reset();
+  threader->SingleMethodExecute();
+  
+  const unsigned long numberOfCalls = threader->GetNumberOfThreads() * NumberOfCallsPerThread;
+  
+  std::cout << "Calls: " << numberOfCalls << ", events: " << profile->GetNumberOfTraceEvents()
+            << ", dropped: " << profile->GetNumberOfDroppedTraceEvents() << std::endl;
+  
+  if( profile->GetNumberOfTraceEvents() != TraceCapacity || 
+      profile->GetNumberOfDroppedTraceEvents() != numberOfCalls - TraceCapacity )
+  {
+    std::cerr << "Wrong number of events" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned long i=0; i<profile->GetNumberOfTraceEvents(); ++i )
+  {
+    const ProfileType::TraceEvent & event = profile->GetTraceEvent( i );
+    
+    if( event.EndTime < event.StartTime || 
+        ( event.ProbeId != data.FirstProbe && event.ProbeId != data.SecondProbe ) )
+    {
+      std::cerr << "Wrong event " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A complete event per call kept, and the names of the process and the threads
+  std::ostringstream trace;
+  profile->WriteTrace( trace, 2, "Test" );
+  
+  const std::string text = trace.str();
+  const unsigned int numberOfThreadNames = CountOccurrences( text, "\"thread_name\"" );
+  
+  if( CountOccurrences( text, "\"ph\": \"X\"" ) != TraceCapacity || 
+      CountOccurrences( text, "\"process_name\"" ) != 1 ||
+      numberOfThreadNames < 1 || numberOfThreadNames > threader->GetNumberOfThreads() ||
+      CountOccurrences( text, "\"pid\": 2," ) != 1 + numberOfThreadNames + TraceCapacity ||
+      text.find( "\"Scale \\\"2\\\"\"" ) == std::string::npos ||
+      text.find( "\"traceEvents\"" ) == std::string::npos )
+  {
+    std::cerr << "Wrong trace output" << std::endl << text << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Resetting the profile clears the trace but keeps its capacity
+  profile->Reset();
+  
+  if( profile->GetNumberOfTraceEvents() != 0 || profile->GetTraceCapacity() != TraceCapacity )
+  {
+    std::cerr << "Wrong reset" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanResponseImageFunctionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the response function reproduces a linear response field, in dense and 
+//   sparse images, that it is zero outside the response buffer and that the scale weighting 
+//   attenuates the responses obtained at other scales.
+
+#include "ivanResponseImageFunction.h"
+#include "ivanResponseImageFunctionInitializer.h"
+#include "ivanSparseBlockedImage.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef short                                             InputPixelType;
+typedef float                                             PixelType;
+typedef itk::Image<InputPixelType,Dimension>              InputImageType;
+typedef itk::Image<PixelType,Dimension>                   ImageType;
+typedef ivan::SparseBlockedImage<PixelType,Dimension,8>   SparseImageType;
+
+typedef ivan::ResponseImageFunction<InputImageType,ImageType>             FunctionType;
+typedef ivan::ResponseImageFunction<InputImageType,SparseImageType>       SparseFunctionType;
+typedef ivan::ResponseImageFunctionInitializer<FunctionType,InputImageType> InitializerType;
+
+
+double LinearResponse( const ImageType::PointType & point )
+{
+  return 1.0 + 2.0 * point[0] + 3.0 * point[1] - 0.5 * point[2];
+}
+
+
+int main( int, char ** )
+{
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 20; size[1] = 17; size[2] = 12;
+  region.SetSize( size );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5; spacing[1] = 0.7; spacing[2] = 1.2;
+  
+  ImageType::PointType origin;
+  origin[0] = -3.0; origin[1] = 1.0; origin[2] = 2.0;
+  
+  // Input image of the tracker, with the geometry of the responses
+  InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions( region );
+  input->SetSpacing( spacing );
+  input->SetOrigin( origin );
+  input->Allocate();
+  input->FillBuffer( 0 );
+  
+  // Linear response, reproduced exactly by linear interpolation, and constant scale
+  ImageType::Pointer response = ImageType::New();
+  response->SetRegions( region );
+  response->SetSpacing( spacing );
+  response->SetOrigin( origin );
+  response->Allocate();
+  
+  ImageType::Pointer scales = ImageType::New();
+  scales->SetRegions( region );
+  scales->SetSpacing( spacing );
+  scales->SetOrigin( origin );
+  scales->Allocate();
+  scales->FillBuffer( 2.0 );
+  
+  SparseImageType::Pointer sparseResponse = SparseImageType::New();
+  sparseResponse->SetRegions( region );
+  sparseResponse->SetSpacing( spacing );
+  sparseResponse->SetOrigin( origin );
+  sparseResponse->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( response, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    response->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    it.Set( LinearResponse( point ) );
+    sparseResponse->SetPixel( it.GetIndex(), it.Get() );
+  }
+  
+  FunctionType::Pointer function = FunctionType::New();
+  function->SetResponseImage( response );
+  function->SetScaleImage( scales );
+  
+  InitializerType::New()->Initialize( function, input, 2.0 );
+  
+  SparseFunctionType::Pointer sparseFunction = SparseFunctionType::New();
+  sparseFunction->SetResponseImage( sparseResponse );
+  sparseFunction->SetInputImage( input );
+  
+  // Interpolation inside the buffer
+  for( unsigned int i=0; i<200; ++i )
+  {
+    ImageType::PointType point;
+    
+    for( unsigned int d=0; d<Dimension; ++d )
+      point[d] = origin[d] + ( size[d] - 1 ) * spacing[d] * ( ( 37 * i + 11 * d ) % 101 ) / 100.0;
+    
+    const double expected = LinearResponse( point );
+    
+    if( !function->IsInsideBuffer( point ) ||
+        std::fabs( function->Evaluate( point ) - expected ) > 1e-4 * std::max( 1.0, std::fabs( expected ) ) ||
+        std::fabs( sparseFunction->Evaluate( point ) - expected ) > 1e-4 * std::max( 1.0, std::fabs( expected ) ) )
+    {
+      std::cerr << "Wrong response at " << point << ": " << function->Evaluate( point ) << " "
+        << sparseFunction->Evaluate( point ) << " expected " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Evaluation at the indices of the input image
+  InputImageType::IndexType index;
+  index[0] = 7; index[1] = 3; index[2] = 9;
+  
+  ImageType::PointType indexPoint;
+  input->TransformIndexToPhysicalPoint( index, indexPoint );
+  
+  if( std::fabs( function->EvaluateAtIndex( index ) - LinearResponse( indexPoint ) ) > 1e-4 )
+  {
+    std::cerr << "Wrong response at index " << index << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Outside the buffer
+  ImageType::PointType outsidePoint = origin;
+  outsidePoint[1] -= spacing[1];
+  
+  if( function->IsInsideBuffer( outsidePoint ) || function->Evaluate( outsidePoint ) != 0.0 )
+  {
+    std::cerr << "Point outside the buffer not detected" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Scale weighting, no effect at the scale of the responses
+  ImageType::PointType point;
+  point[0] = 1.1; point[1] = 6.3; point[2] = 9.0;
+  
+  const double value = function->Evaluate( point );
+  const double tolerance = 0.5;
+  
+  function->SetScaleTolerance( tolerance );
+  
+  if( std::fabs( function->Evaluate( point ) - value ) > 1e-10 * std::fabs( value ) ||
+      std::fabs( function->EvaluateScale( point ) - 2.0 ) > 1e-6 )
+  {
+    std::cerr << "Wrong weighting at the scale of the response" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  InitializerType::New()->Initialize( function, input, 4.0 );
+  
+  const double logRatio = std::log( 0.5 );
+  const double expected = value * std::exp( -logRatio * logRatio / ( 2.0 * tolerance * tolerance ) );
+  
+  if( std::fabs( function->Evaluate( point ) - expected ) > 1e-10 * std::fabs( expected ) )
+  {
+    std::cerr << "Wrong weighting at other scale: " << function->Evaluate( point ) 
+      << " expected " << expected << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
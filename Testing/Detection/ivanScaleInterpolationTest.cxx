@@ -0,0 +1,122 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleInterpolationTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the refined scale of the maximum of a tube response across a few logarithmic
+//   scales is more accurate than the one of many discrete scales.
+// Date: 2012/11/05
+
+#include "ivanScaleInterpolation.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+
+/** Normalized second derivative at the center of a Gaussian cross-section of the given 
+  * deviation, which has its maximum at the scale equal to the deviation. */
+double TubeResponse( double scale, double deviation )
+{
+  const double variance = deviation * deviation + scale * scale;
+  return scale * scale / ( variance * variance );
+}
+
+
+/** Maximum relative error of the selected scale for tubes with deviations in the given range,
+  * which is inside the second and penultimate scales so that the maximum can be refined. */
+double ScaleError( unsigned int numberOfScales, double minimumScale, double maximumScale, bool interpolate,
+  double minimumDeviation, double maximumDeviation )
+{
+  std::vector<double> scales( numberOfScales ), values( numberOfScales );
+  
+  const double step = ( vcl_log( maximumScale ) - vcl_log( minimumScale ) ) / ( numberOfScales - 1 );
+  
+  for( unsigned int i=0; i < numberOfScales; ++i )
+    scales[i] = vcl_exp( vcl_log( minimumScale ) + step * i );
+  
+  double maximumError = 0.0;
+  
+  for( double deviation = minimumDeviation; deviation < maximumDeviation; deviation *= 1.01 )
+  {
+    unsigned int idx = 0;
+    
+    for( unsigned int i=0; i < numberOfScales; ++i )
+    {
+      values[i] = TubeResponse( scales[i], deviation );
+      
+      if( values[i] > values[idx] )
+        idx = i;
+    }
+    
+    double scale = scales[idx];
+    
+    if( interpolate && idx > 0 && idx + 1 < numberOfScales )
+      scale = ivan::ScaleInterpolation::InterpolateMaximum( scales[idx-1], scales[idx], scales[idx+1], 
+        values[idx-1], values[idx], values[idx+1], true );
+    
+    const double error = vcl_abs( scale - deviation ) / deviation;
+    
+    if( error > maximumError )
+      maximumError = error;
+  }
+  
+  return maximumError;
+}
+
+
+int main( int, char ** )
+{
+  // The vertex of a parabola is found exactly with uneven steps
+  const double vertex = ivan::ScaleInterpolation::InterpolateMaximum( 1.0, 2.0, 4.0,
+    -( 1.0 - 2.5 ) * ( 1.0 - 2.5 ), -( 2.0 - 2.5 ) * ( 2.0 - 2.5 ), -( 4.0 - 2.5 ) * ( 4.0 - 2.5 ), false );
+  
+  if( vcl_abs( vertex - 2.5 ) > 1e-12 )
+  {
+    std::cerr << "Wrong vertex of the parabola: " << vertex << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A scale that is not a maximum, or a flat response, is not refined
+  if( ivan::ScaleInterpolation::InterpolateMaximum( 1.0, 2.0, 3.0, 1.0, 0.5, 0.2, true ) != 2.0 ||
+      ivan::ScaleInterpolation::InterpolateMaximum( 1.0, 2.0, 3.0, 0.0, 0.0, 0.0, true ) != 2.0 )
+  {
+    std::cerr << "Refined scale that is not a maximum" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const double discreteError = ScaleError( 16, 0.5, 8.0, false, 1.0, 4.0 );
+  const double interpolatedError = ScaleError( 6, 0.5, 8.0, true, 1.0, 4.0 );
+  
+  std::cout << "Maximum relative scale error with 16 discrete scales: " << discreteError 
+            << ", with 6 interpolated scales: " << interpolatedError << std::endl;
+  
+  if( interpolatedError > discreteError )
+  {
+    std::cerr << "The interpolated scale is less accurate" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanScaleSpacePyramidTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the level selection of the scale-space pyramid and that the Hessian of a 
+//   tube evaluated at a large scale on the selected level matches the analytical one.
+
+#include "ivanScaleSpacePyramid.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef ivan::ScaleSpacePyramid<ImageType>                              PyramidType;
+typedef ivan::DiscreteHessianGaussianImageFunction<ImageType,double>    HessianFunctionType;
+typedef ivan::ScaleSpaceImageFunctionInitializer
+  <HessianFunctionType,ImageType>                                       InitializerType;
+
+
+int main( int argc, char ** argv )
+{
+  const double scale = ( argc > 1 ) ? atof( argv[1] ) : 16.0;
+  
+  // Synthetic tube of gaussian section along the z axis
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 96; size[1] = 96; size[2] = 24;
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double amplitude = 100.0;
+  const double tubeSigma = 4.0;
+  const double centerX = 47.3, centerY = 48.6;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - centerX;
+    const double dy = it.GetIndex()[1] - centerY;
+    it.Set( amplitude * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  PyramidType::Pointer pyramid = PyramidType::New();
+  pyramid->SetInput( image );
+  
+  // Small scales are evaluated on the input
+  if( pyramid->GetLevelForScale( 2.0 ) != 0 || pyramid->GetLevel( 0 ) != image.GetPointer() )
+  {
+    std::cerr << "Small scales must use the input" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const unsigned int level = pyramid->GetLevelForScale( scale );
+  const double residualSigma = pyramid->GetResidualSigma( scale, level );
+  const double factor = PyramidType::GetShrinkFactor( level );
+  
+  std::cout << "Level: " << level << " Residual sigma: " << residualSigma << std::endl;
+  
+  if( level == 0 || residualSigma < pyramid->GetMinimumSigmaInPixels() * factor ||
+      residualSigma >= 2.0 * pyramid->GetMinimumSigmaInPixels() * factor )
+  {
+    std::cerr << "Wrong level for scale " << scale << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Hessian at the centerline on the selected level
+  HessianFunctionType::Pointer hessianFunction = HessianFunctionType::New();
+  hessianFunction->SetInterpolationMode( HessianFunctionType::LinearInterpolation );
+  hessianFunction->SetMaximumKernelWidth( 64 );
+  
+  InitializerType::Pointer initializer = InitializerType::New();
+  initializer->SetPyramid( pyramid );
+  
+  try
+  {
+    initializer->Initialize( hessianFunction, image, scale );
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    std::cerr << "ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( hessianFunction->GetInputImage() != pyramid->GetLevel( level ) )
+  {
+    std::cerr << "The function is not initialized with the level" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  ImageType::PointType point;
+  point[0] = centerX;
+  point[1] = centerY;
+  point[2] = 0.5 * ( size[2] - 1 );
+  
+  const HessianFunctionType::TensorType hessian = hessianFunction->Evaluate( point );
+  
+  // Second derivative of the tube smoothed at the scale, normalized with the residual sigma
+  const double variance = tubeSigma * tubeSigma + scale * scale;
+  const double expected = - residualSigma * residualSigma * 
+    amplitude * tubeSigma * tubeSigma / ( variance * variance );
+  
+  std::cout << "Hessian: " << hessian << " Expected xx and yy: " << expected << std::endl;
+  
+  if( std::fabs( hessian(0,0) - expected ) > 0.05 * std::fabs( expected ) ||
+      std::fabs( hessian(1,1) - expected ) > 0.05 * std::fabs( expected ) ||
+      std::fabs( hessian(2,2) ) > 0.05 * std::fabs( expected ) ||
+      std::fabs( hessian(0,1) ) > 0.05 * std::fabs( expected ) )
+  {
+    std::cerr << "Wrong Hessian on the pyramid level" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  std::cout << "Pyramid memory: " << pyramid->GetMemorySize() << std::endl;
+  
+  return EXIT_SUCCESS;
+}
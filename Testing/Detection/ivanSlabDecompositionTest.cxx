@@ -0,0 +1,113 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSlabDecompositionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the slabs cover the region without overlapping, that their sizes are 
+//   balanced, and that the padded slabs are cropped to the region.
+
+#include "ivanSlabDecomposition.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+
+int main( int, char ** )
+{
+  typedef ivan::SlabDecomposition<3>    DecompositionType;
+  typedef DecompositionType::RegionType RegionType;
+  
+  RegionType::IndexType index;
+  index[0] = 3; index[1] = -2; index[2] = 5;
+  
+  RegionType::SizeType size;
+  size[0] = 10; size[1] = 12; size[2] = 23;
+  
+  const RegionType region( index, size );
+  
+  DecompositionType::Pointer decomposition = DecompositionType::New();
+  decomposition->SetRegion( region );
+  decomposition->SetRequestedNumberOfSlabs( 4 );
+  decomposition->SetHaloRadius( 2 );
+  decomposition->Initialize();
+  
+  if( decomposition->GetNumberOfSlabs() != 4 )
+  {
+    std::cerr << "Wrong number of slabs: " << decomposition->GetNumberOfSlabs() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  long nextIndex = index[2];
+  unsigned long numberOfPixels = 0;
+  
+  for( unsigned int i=0; i<decomposition->GetNumberOfSlabs(); ++i )
+  {
+    const RegionType slab = decomposition->GetSlab( i );
+    
+    if( slab.GetIndex()[2] != nextIndex || slab.GetSize()[2] < 5 || slab.GetSize()[2] > 6 ||
+      slab.GetIndex()[0] != index[0] || slab.GetSize()[0] != size[0] ||
+      slab.GetIndex()[1] != index[1] || slab.GetSize()[1] != size[1] )
+    {
+      std::cerr << "Wrong slab " << i << ": " << slab << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    nextIndex += slab.GetSize()[2];
+    numberOfPixels += slab.GetNumberOfPixels();
+    
+    // The halo only grows the slab inside the region
+    const RegionType paddedSlab = decomposition->GetPaddedSlab( i );
+    
+    const long expectedBegin = std::max( slab.GetIndex()[2] - 2, index[2] );
+    const long expectedEnd = std::min( static_cast<long>( slab.GetIndex()[2] + slab.GetSize()[2] + 2 ), 
+      static_cast<long>( index[2] + size[2] ) );
+    
+    if( !region.IsInside( paddedSlab ) || !paddedSlab.IsInside( slab ) || 
+      paddedSlab.GetIndex()[2] != expectedBegin || 
+      paddedSlab.GetIndex()[2] + static_cast<long>( paddedSlab.GetSize()[2] ) != expectedEnd )
+    {
+      std::cerr << "Wrong padded slab " << i << ": " << paddedSlab << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( numberOfPixels != region.GetNumberOfPixels() )
+  {
+    std::cerr << "Slabs do not cover the region" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // More slabs than pixels along the slab dimension
+  decomposition->SetRequestedNumberOfSlabs( 40 );
+  decomposition->Initialize();
+  
+  if( decomposition->GetNumberOfSlabs() != size[2] )
+  {
+    std::cerr << "Wrong number of slabs for a thin region: " << decomposition->GetNumberOfSlabs() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
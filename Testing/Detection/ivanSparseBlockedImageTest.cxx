@@ -0,0 +1,296 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSparseBlockedImageTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that pixels read back from the sparse blocked image are those that were set, 
+//   that only the blocks with pixels other than the background are allocated, and that the sparse
+//   output of the front propagation is read as the dense one by the linear interpolator. The 
+//   pixels of the same blocks are also set concurrently from several threads.
+
+#include "ivanSparseBlockedImage.h"
+#include "ivanFrontPropagationImageFunctionBasedImageFilter.h"
+#include "ivanFrangiVesselnessImageFunction.h"
+#include "ivanScaleSpaceImageFunctionInitializer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkMultiThreader.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+typedef ivan::SparseBlockedImage<PixelType,Dimension,8>   SparseImageType;
+
+typedef ivan::FrangiVesselnessImageFunction<ImageType,double>     VesselnessFunctionType;
+
+typedef ivan::FrontPropagationImageFunctionBasedImageFilter
+  <ImageType,ImageType,VesselnessFunctionType>                    DenseFilterType;
+typedef ivan::FrontPropagationImageFunctionBasedImageFilter
+  <ImageType,SparseImageType,VesselnessFunctionType>              SparseFilterType;
+
+typedef itk::LinearInterpolateImageFunction<ImageType,double>       DenseInterpolatorType;
+typedef itk::LinearInterpolateImageFunction<SparseImageType,double> SparseInterpolatorType;
+
+
+/** Initializes the vesselness at the scale of the tube. */
+class TubeScaleInitializer : 
+  public ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType>
+{
+public:
+
+  typedef TubeScaleInitializer                                                      Self;
+  typedef ivan::ScaleSpaceImageFunctionInitializer<VesselnessFunctionType,ImageType> Superclass;
+  typedef itk::SmartPointer<Self>                                                   Pointer;
+
+  itkNewMacro( Self );
+
+  virtual void Initialize( VesselnessFunctionType *imageFunction, const ImageType *image = 0, double = 0.0 )
+    { Superclass::Initialize( imageFunction, image, 2.0 ); }
+};
+
+
+// Value set at every pixel by the threads
+PixelType GetPixelValue( const SparseImageType::IndexType & index )
+{
+  return 1.0 + index[0] + 64 * ( index[1] + 64 * index[2] );
+}
+
+
+// Each thread sets every NumberOfThreads-th column, so all the threads write in every block
+ITK_THREAD_RETURN_TYPE SetPixelsThreaderCallback( void *arg )
+{
+  const unsigned int threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const unsigned int numberOfThreads = 
+    ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  
+  SparseImageType *image = 
+    (SparseImageType *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  const SparseImageType::SizeType & size = image->GetBufferedRegion().GetSize();
+  SparseImageType::IndexType index;
+  
+  for( index[2] = 0; index[2] < (long)size[2]; ++index[2] )
+    for( index[1] = 0; index[1] < (long)size[1]; ++index[1] )
+      for( index[0] = threadId; index[0] < (long)size[0]; index[0] += numberOfThreads )
+        image->SetPixel( index, GetPixelValue( index ) );
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 45; size[1] = 38; size[2] = 20; // not multiples of the block size
+  region.SetSize( size );
+  
+  // Set and get
+  SparseImageType::Pointer sparse = SparseImageType::New();
+  sparse->SetRegions( region );
+  sparse->Allocate();
+  sparse->FillBuffer( 0.0 );
+  
+  if( sparse->GetNumberOfBlocks() != 6 * 5 * 3 || sparse->GetNumberOfAllocatedBlocks() != 0 )
+  {
+    std::cerr << "Wrong number of blocks" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  ImageType::IndexType index;
+  index[0] = 44; index[1] = 37; index[2] = 19;
+  sparse->SetPixel( index, 3.0 );
+  index[0] = 40; index[1] = 33; index[2] = 17; // same block
+  sparse->SetPixel( index, 2.0 );
+  index[0] = 3; index[1] = 4; index[2] = 5;
+  sparse->SetPixel( index, 0.0 ); // background, not allocated
+  
+  index[0] = 44; index[1] = 37; index[2] = 19;
+  
+  if( sparse->GetNumberOfAllocatedBlocks() != 1 || sparse->GetPixel( index ) != 3.0 )
+  {
+    std::cerr << "Wrong pixel or allocation" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  index[0] = 40; index[1] = 33; index[2] = 17;
+  
+  if( sparse->GetPixel( index ) != 2.0 )
+  {
+    std::cerr << "Wrong pixel in a shared block" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  index[0] = 41;
+  
+  if( sparse->GetPixel( index ) != 0.0 )
+  {
+    std::cerr << "Pixels of a new block are not the background" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Synthetic tube of gaussian section along the z axis, thresholded by front propagation
+  ImageType::Pointer image = ImageType::New();
+  size.Fill( 48 );
+  region.SetSize( size );
+  image->SetRegions( region );
+  image->Allocate();
+  
+  const double tubeSigma = 2.0;
+  const double centerX = 20.0, centerY = 27.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - centerX;
+    const double dy = it.GetIndex()[1] - centerY;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) );
+  }
+  
+  VesselnessFunctionType::Pointer function = VesselnessFunctionType::New();
+  TubeScaleInitializer::New()->Initialize( function, image );
+  
+  ImageType::IndexType seed;
+  seed[0] = static_cast<long>( centerX );
+  seed[1] = static_cast<long>( centerY );
+  seed[2] = 24;
+  
+  const double threshold = 0.1 * function->EvaluateAtIndex( seed );
+  
+  DenseFilterType::Pointer denseFilter = DenseFilterType::New();
+  denseFilter->SetInput( image );
+  denseFilter->SetImageFunctionInitializer( TubeScaleInitializer::New() );
+  denseFilter->AddSeed( seed );
+  denseFilter->SetResponseThreshold( threshold );
+  
+  SparseFilterType::Pointer sparseFilter = SparseFilterType::New();
+  sparseFilter->SetInput( image );
+  sparseFilter->SetImageFunctionInitializer( TubeScaleInitializer::New() );
+  sparseFilter->AddSeed( seed );
+  sparseFilter->SetResponseThreshold( threshold );
+  
+  try
+  {
+    denseFilter->Update();
+    sparseFilter->Update();
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    std::cerr << "ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const ImageType *denseOutput = denseFilter->GetOutput();
+  const SparseImageType *sparseOutput = sparseFilter->GetOutput();
+  
+  const unsigned long denseMemory = region.GetNumberOfPixels() * sizeof( PixelType );
+  
+  std::cout << "Allocated blocks: " << sparseOutput->GetNumberOfAllocatedBlocks() << " of " 
+    << sparseOutput->GetNumberOfBlocks() << " Memory: " << sparseOutput->GetMemorySize() 
+    << " (dense " << denseMemory << ")" << std::endl;
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( denseOutput->GetPixel( it.GetIndex() ) != sparseOutput->GetPixel( it.GetIndex() ) )
+    {
+      std::cerr << "Sparse and dense outputs differ at " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The tube only goes through the blocks of a column along z
+  if( sparseOutput->GetMemorySize() > denseMemory / 4 )
+  {
+    std::cerr << "Too many allocated blocks" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Interpolation reads the sparse image as the dense one
+  DenseInterpolatorType::Pointer denseInterpolator = DenseInterpolatorType::New();
+  denseInterpolator->SetInputImage( denseOutput );
+  
+  SparseInterpolatorType::Pointer sparseInterpolator = SparseInterpolatorType::New();
+  sparseInterpolator->SetInputImage( sparseOutput );
+  
+  DenseInterpolatorType::ContinuousIndexType continuousIndex;
+  
+  for( double x = centerX - 4.0; x <= centerX + 4.0; x += 0.37 )
+  {
+    continuousIndex[0] = x;
+    continuousIndex[1] = centerY + 0.25;
+    continuousIndex[2] = 11.6;
+    
+    const double denseValue = denseInterpolator->EvaluateAtContinuousIndex( continuousIndex );
+    const double sparseValue = sparseInterpolator->EvaluateAtContinuousIndex( continuousIndex );
+    
+    if( std::fabs( denseValue - sparseValue ) > 1e-10 * std::max( 1.0, std::fabs( denseValue ) ) )
+    {
+      std::cerr << "Interpolated values differ at " << continuousIndex << ": " << denseValue 
+        << " " << sparseValue << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Concurrent writes in the same blocks, which must not be lost when the blocks are allocated
+  SparseImageType::Pointer concurrent = SparseImageType::New();
+  concurrent->SetRegions( region );
+  concurrent->Allocate();
+  concurrent->FillBuffer( 0.0 );
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( 8 );
+  threader->SetSingleMethod( SetPixelsThreaderCallback, concurrent.GetPointer() );
+  threader->SingleMethodExecute();
+  
+  if( concurrent->GetNumberOfAllocatedBlocks() != concurrent->GetNumberOfBlocks() )
+  {
+    std::cerr << "Allocated " << concurrent->GetNumberOfAllocatedBlocks() << " of " 
+      << concurrent->GetNumberOfBlocks() << " blocks concurrently" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( index[2] = 0; index[2] < (long)size[2]; ++index[2] )
+    for( index[1] = 0; index[1] < (long)size[1]; ++index[1] )
+      for( index[0] = 0; index[0] < (long)size[0]; ++index[0] )
+      {
+        if( concurrent->GetPixel( index ) != GetPixelValue( index ) )
+        {
+          std::cerr << "Pixel set concurrently lost at " << index << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSphereGridQuadratureTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the quadrature weights of the sphere grid are the normalized areas of 
+//   the Voronoi cells of the points, and that they make the sphere integrals converge with the 
+//   decimation, unlike equal weights.
+
+#include "ivanSphereGridBasedImageFunction.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                                 PixelType;
+typedef itk::Image<PixelType,Dimension>                       ImageType;
+typedef ivan::SphereGridBasedImageFunction<ImageType,double>  FunctionType;
+
+
+/** Mean of exp( 2x + y ) over the unit sphere with the weights of the function, which is 
+  * sinh( sqrt(5) ) / sqrt(5) for exact integration. */
+double ComputeMean( const FunctionType *function )
+{
+  const unsigned int numberOfPoints = function->GetNumberOfSpherePoints();
+  const FunctionType::SphereTableType & normals = function->GetSphereNormalTable();
+  const FunctionType::SphereTableType & weights = function->GetSphereWeightTable();
+  
+  double sum = 0.0;
+  
+  for( unsigned int i=0; i<numberOfPoints; ++i )
+    sum += weights[i] * std::exp( 2.0 * normals[i] + normals[numberOfPoints + i] );
+  
+  return sum / numberOfPoints;
+}
+
+
+int main( int, char ** )
+{
+  const double expected = std::sinh( std::sqrt( 5.0 ) ) / std::sqrt( 5.0 );
+  
+  FunctionType::Pointer function = FunctionType::New();
+  function->SetRadius( 2.0 );
+  
+  for( unsigned int decimation = 2; decimation <= 3; ++decimation )
+  {
+    function->SetDecimation( decimation );
+    
+    function->UseQuadratureWeightsOff();
+    function->Initialize();
+    
+    const double equalWeightsError = std::fabs( ComputeMean( function ) - expected );
+    
+    function->UseQuadratureWeightsOn();
+    function->Initialize();
+    
+    const double quadratureError = std::fabs( ComputeMean( function ) - expected );
+    
+    const unsigned int numberOfPoints = function->GetNumberOfSpherePoints();
+    const FunctionType::SphereTableType & weights = function->GetSphereWeightTable();
+    
+    double sum = 0.0, minimum = weights[0], maximum = weights[0];
+    
+    for( unsigned int i=0; i<numberOfPoints; ++i )
+    {
+      sum += weights[i];
+      minimum = std::min( minimum, weights[i] );
+      maximum = std::max( maximum, weights[i] );
+    }
+    
+    std::cout << "Decimation: " << decimation << " Points: " << numberOfPoints 
+      << " Weights: [" << minimum << ", " << maximum << "] Error with equal weights: " 
+      << equalWeightsError << " with quadrature weights: " << quadratureError << std::endl;
+    
+    // The icosahedron vertices have the smallest cells
+    if( std::fabs( sum - numberOfPoints ) > 1e-8 * numberOfPoints || minimum > 0.95 || maximum < 1.02 )
+    {
+      std::cerr << "Wrong weights" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( quadratureError > 0.5 * equalWeightsError )
+    {
+      std::cerr << "Quadrature weights do not improve the integral" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // At decimation 3 the weighted integral is an order of magnitude better
+  if( std::fabs( ComputeMean( function ) - expected ) > 1e-5 )
+  {
+    std::cerr << "Weighted integral does not converge" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSphereSamplingTableCacheTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the sphere-based functions share the sampling tables of the cache,
+//   and that the shared tables match a table built on its own.
+
+#include "ivanSphereGridBasedImageFunction.h"
+#include "ivanSphereSamplingTableCache.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                                 PixelType;
+typedef itk::Image<PixelType,Dimension>                       ImageType;
+typedef ivan::SphereGridBasedImageFunction<ImageType,double>  FunctionType;
+typedef ivan::SphereSamplingTableCache                        CacheType;
+typedef ivan::SphereSamplingTable                             TableType;
+
+
+int main( int, char ** )
+{
+  CacheType::Pointer cache = CacheType::GetInstance();
+  cache->Clear();
+  
+  if( cache.GetPointer() != CacheType::GetInstance().GetPointer() )
+  {
+    std::cerr << "The cache is not a single instance" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  FunctionType::Pointer firstFunction = FunctionType::New();
+  firstFunction->SetRadius( 2.0 );
+  firstFunction->SetDecimation( 2 );
+  firstFunction->UseQuadratureWeightsOn();
+  firstFunction->Initialize();
+  
+  FunctionType::Pointer secondFunction = FunctionType::New();
+  secondFunction->SetRadius( 3.0 );
+  secondFunction->SetDecimation( 2 );
+  secondFunction->Initialize();
+  
+  FunctionType::Pointer thirdFunction = FunctionType::New();
+  thirdFunction->SetDecimation( 1 );
+  thirdFunction->Initialize();
+  
+  std::cout << "Tables: " << cache->GetNumberOfTables() << std::endl;
+  
+  if( cache->GetNumberOfTables() != 2 || 
+      firstFunction->GetSphereSamplingTable() != secondFunction->GetSphereSamplingTable() ||
+      firstFunction->GetSphereSamplingTable() == thirdFunction->GetSphereSamplingTable() ||
+      &firstFunction->GetSphereNormalTable() != &secondFunction->GetSphereNormalTable() )
+  {
+    std::cerr << "The functions do not share the tables" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The weights are shared too, but each function chooses its own
+  const FunctionType::SphereTableType & quadratureWeights = firstFunction->GetSphereWeightTable();
+  const FunctionType::SphereTableType & uniformWeights = secondFunction->GetSphereWeightTable();
+  
+  if( &quadratureWeights != &firstFunction->GetSphereSamplingTable()->GetWeightTable() ||
+      &uniformWeights != &secondFunction->GetSphereSamplingTable()->GetUniformWeightTable() )
+  {
+    std::cerr << "Wrong weight tables" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The offsets depend on the radius of each function
+  const unsigned int numberOfPoints = firstFunction->GetNumberOfSpherePoints();
+  const FunctionType::SphereTableType & normals = firstFunction->GetSphereNormalTable();
+  const FunctionType::SphereTableType & firstOffsets = firstFunction->GetSphereOffsetTable();
+  const FunctionType::SphereTableType & secondOffsets = secondFunction->GetSphereOffsetTable();
+  
+  if( numberOfPoints != secondFunction->GetNumberOfSpherePoints() ||
+      normals.size() != Dimension * numberOfPoints || firstOffsets.size() != normals.size() )
+  {
+    std::cerr << "Wrong table sizes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<normals.size(); ++i )
+  {
+    if( std::fabs( firstOffsets[i] - 2.0 * normals[i] ) > 1e-12 || 
+        std::fabs( secondOffsets[i] - 3.0 * normals[i] ) > 1e-12 )
+    {
+      std::cerr << "Wrong offsets" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // The cached table is the same as one built on its own
+  TableType::Pointer table = CacheType::BuildTable( 2 );
+  
+  if( table->GetNormalTable() != normals || table->GetWeightTable() != quadratureWeights )
+  {
+    std::cerr << "The cached table differs from a new one" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Clearing the cache keeps the tables in use alive
+  cache->Clear();
+  
+  if( cache->GetNumberOfTables() != 0 || firstFunction->GetSphereSamplingTable()->GetNumberOfPoints() != numberOfPoints )
+  {
+    std::cerr << "Wrong clear" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSymmetricEigenSolverTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the closed-form 3D eigen-analysis with the iterative solver.
+
+#include "ivanSymmetricEigenSolver.h"
+
+#include "itkSymmetricSecondRankTensor.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+typedef itk::SymmetricSecondRankTensor<double,3>    TensorType;
+typedef ivan::SymmetricEigenSolver<TensorType>      SolverType;
+
+
+// Checks that the closed-form solution satisfies A v = lambda v with orthonormal vectors, 
+// and that eigenvalues match those of the iterative solver
+bool CheckTensor( const TensorType & tensor, double tolerance )
+{
+  SolverType::EigenValuesArrayType    eigenValues, referenceEigenValues;
+  SolverType::EigenVectorsMatrixType  eigenVectors, referenceEigenVectors;
+  
+  SolverType::ComputeEigenAnalysis( tensor, eigenValues, eigenVectors );
+  tensor.ComputeEigenAnalysis( referenceEigenValues, referenceEigenVectors );
+  
+  double norm = 0.0;
+  for( unsigned int i=0; i<6; ++i )
+    norm = std::max( norm, std::fabs( tensor[i] ) );
+  
+  const double maxError = tolerance * std::max( norm, 1.0 );
+  
+  for( unsigned int k=0; k<3; ++k )
+  {
+    if( std::fabs( eigenValues[k] - referenceEigenValues[k] ) > maxError )
+    {
+      std::cerr << "Eigenvalue " << k << " is " << eigenValues[k] << ", expected " 
+        << referenceEigenValues[k] << " for tensor " << tensor << std::endl;
+      return false;
+    }
+    
+    if( k && eigenValues[k] < eigenValues[k-1] )
+    {
+      std::cerr << "Eigenvalues not in ascending order for tensor " << tensor << std::endl;
+      return false;
+    }
+    
+    for( unsigned int i=0; i<3; ++i )
+    {
+      double product = 0.0;
+      for( unsigned int j=0; j<3; ++j )
+        product += tensor( i, j ) * eigenVectors( k, j );
+      
+      if( std::fabs( product - eigenValues[k] * eigenVectors( k, i ) ) > maxError )
+      {
+        std::cerr << "Eigenvector " << k << " is not an eigenvector of tensor " << tensor << std::endl;
+        return false;
+      }
+    }
+    
+    for( unsigned int l=0; l<3; ++l )
+    {
+      double dot = 0.0;
+      for( unsigned int j=0; j<3; ++j )
+        dot += eigenVectors( k, j ) * eigenVectors( l, j );
+      
+      if( std::fabs( dot - ( k == l ? 1.0 : 0.0 ) ) > tolerance )
+      {
+        std::cerr << "Eigenvectors are not orthonormal for tensor " << tensor << std::endl;
+        return false;
+      }
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  const double tolerance = 1e-6;
+  TensorType tensor;
+  
+  // Zero, isotropic and diagonal tensors with repeated eigenvalues
+  tensor.Fill( 0.0 );
+  if( !CheckTensor( tensor, tolerance ) )
+    return EXIT_FAILURE;
+  
+  tensor.SetIdentity();
+  tensor *= 3.0;
+  if( !CheckTensor( tensor, tolerance ) )
+    return EXIT_FAILURE;
+  
+  tensor( 2, 2 ) = 1.0;
+  if( !CheckTensor( tensor, tolerance ) )
+    return EXIT_FAILURE;
+  
+  tensor( 0, 0 ) = 1.0;
+  if( !CheckTensor( tensor, tolerance ) )
+    return EXIT_FAILURE;
+  
+  // Ideal tube along an oblique direction: two equal negative eigenvalues
+  const double direction[3] = { 1.0 / std::sqrt( 3.0 ), 1.0 / std::sqrt( 3.0 ), 1.0 / std::sqrt( 3.0 ) };
+  
+  for( unsigned int i=0; i<3; ++i )
+    for( unsigned int j=i; j<3; ++j )
+      tensor( i, j ) = -2.0 * ( ( i == j ? 1.0 : 0.0 ) - direction[i] * direction[j] );
+  
+  if( !CheckTensor( tensor, tolerance ) )
+    return EXIT_FAILURE;
+  
+  // Random tensors over several orders of magnitude
+  srand( 1 );
+  
+  for( unsigned int n=0; n<10000; ++n )
+  {
+    const double magnitude = std::pow( 10.0, static_cast<int>( n % 7 ) - 3 );
+    
+    for( unsigned int i=0; i<6; ++i )
+      tensor[i] = magnitude * ( static_cast<double>( rand() ) / RAND_MAX - 0.5 );
+    
+    if( !CheckTensor( tensor, tolerance ) )
+      return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
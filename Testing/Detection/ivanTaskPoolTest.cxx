@@ -0,0 +1,254 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTaskPoolTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the parallel loops of the task pool visit each index once, with valid thread
+//   ids, that nested loops run serially and that exceptions reach the caller.
+// Date: 2012/11/05
+
+#include "ivanTaskPool.h"
+
+#include "itkRealTimeClock.h"
+#include "itkMacro.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+
+typedef ivan::TaskPool                  PoolType;
+typedef PoolType::IndexValueType        IndexValueType;
+
+
+/** Counts the visits of each index and sums the indices per thread. */
+class CountFunction : public PoolType::RangeFunction
+{
+public:
+
+  CountFunction( IndexValueType size, unsigned int numberOfThreads ) :
+    Visits( size, 0 ), Sums( numberOfThreads, 0.0 ), InvalidThreadIds( 0 ) {}
+  
+  virtual void Execute( IndexValueType begin, IndexValueType end, unsigned int threadId )
+    {
+      if( threadId >= Sums.size() )
+      {
+        ++InvalidThreadIds;
+        return;
+      }
+  
+      for( IndexValueType i = begin; i < end; ++i )
+      {
+        ++Visits[i];
+        Sums[threadId] += i;
+      }
+    }
+  
+  std::vector<unsigned int>   Visits;
+  std::vector<double>         Sums;
+  unsigned int                InvalidThreadIds;
+};
+
+
+/** Runs a loop inside each chunk. */
+class NestedFunction : public PoolType::RangeFunction
+{
+public:
+
+  NestedFunction( IndexValueType size, unsigned int numberOfThreads ) :
+    Inner( size * size, numberOfThreads ), Size( size ) {}
+  
+  virtual void Execute( IndexValueType begin, IndexValueType end, unsigned int )
+    {
+      for( IndexValueType i = begin; i < end; ++i )
+      {
+        // Each inner loop writes its own row, so the serial runs do not race
+        RowFunction row( &Inner, i * Size );
+        PoolType::GetInstance()->ParallelFor( 0, Size, &row, 1 );
+      }
+    }
+  
+  class RowFunction : public PoolType::RangeFunction
+  {
+  public:
+  
+    RowFunction( CountFunction *count, IndexValueType offset ) : Count( count ), Offset( offset ) {}
+  
+    virtual void Execute( IndexValueType begin, IndexValueType end, unsigned int )
+      {
+        for( IndexValueType i = begin; i < end; ++i )
+          ++Count->Visits[Offset + i];
+      }
+  
+    CountFunction   *Count;
+    IndexValueType   Offset;
+  };
+  
+  CountFunction    Inner;
+  IndexValueType   Size;
+};
+
+
+/** Fails at one index. */
+class FailingFunction : public PoolType::RangeFunction
+{
+public:
+
+  virtual void Execute( IndexValueType begin, IndexValueType end, unsigned int )
+    {
+      if( begin <= 7 && 7 < end )
+        itkGenericExceptionMacro( << "Failure at index 7" );
+    }
+};
+
+
+bool CheckCount( const CountFunction & count )
+{
+  double sum = 0.0;
+  
+  for( unsigned int i=0; i<count.Sums.size(); ++i )
+    sum += count.Sums[i];
+  
+  const double size = count.Visits.size();
+  
+  for( unsigned int i=0; i<count.Visits.size(); ++i )
+  {
+    if( count.Visits[i] != 1 )
+      return false;
+  }
+  
+  return count.InvalidThreadIds == 0 && sum == size * ( size - 1 ) / 2;
+}
+
+
+int main( int, char ** )
+{
+  PoolType::Pointer pool = PoolType::GetInstance();
+  pool->SetNumberOfThreads( 4 );
+  
+  if( pool.GetPointer() != PoolType::GetInstance().GetPointer() )
+  {
+    std::cerr << "The pool is not a single instance" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Automatic and explicit grain sizes, and fewer threads than the pool
+  const IndexValueType sizes[] = { 1, 3, 1000, 100003 };
+  const IndexValueType grainSizes[] = { 0, 1, 64 };
+  const unsigned int maximumNumberOfThreads[] = { 0, 2 };
+  
+  for( unsigned int i=0; i<4; ++i )
+  {
+    for( unsigned int j=0; j<3; ++j )
+    {
+      for( unsigned int k=0; k<2; ++k )
+      {
+        CountFunction count( sizes[i], pool->GetNumberOfThreads() );
+        pool->ParallelFor( 0, sizes[i], &count, grainSizes[j], maximumNumberOfThreads[k] );
+  
+        if( !CheckCount( count ) )
+        {
+          std::cerr << "Wrong loop of " << sizes[i] << " indices, grain " << grainSizes[j]
+                    << ", threads " << maximumNumberOfThreads[k] << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  
+  // Many small loops, as issued by a tracker
+  const unsigned int numberOfLoops = 10000;
+  const unsigned long parallelLoops = pool->GetNumberOfParallelLoops();
+  
+  itk::RealTimeClock::Pointer clock = itk::RealTimeClock::New();
+  const double start = clock->GetTimeStamp();
+  
+  CountFunction smallCount( 4 * numberOfLoops, pool->GetNumberOfThreads() );
+  
+  for( unsigned int i=0; i<numberOfLoops; ++i )
+    pool->ParallelFor( 4 * i, 4 * i + 4, &smallCount, 1 );
+  
+  std::cout << "Mean time of a loop of 4 indices: "
+            << 1e6 * ( clock->GetTimeStamp() - start ) / numberOfLoops << " us" << std::endl;
+  
+  if( !CheckCount( smallCount ) || pool->GetNumberOfParallelLoops() != parallelLoops + numberOfLoops )
+  {
+    std::cerr << "Wrong small loops" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Nested loops run serially in the threads of the outer one
+  const unsigned long serialLoops = pool->GetNumberOfSerialLoops();
+  
+  NestedFunction nested( 50, pool->GetNumberOfThreads() );
+  pool->ParallelFor( 0, 50, &nested, 1 );
+  
+  for( unsigned int i=0; i<nested.Inner.Visits.size(); ++i )
+  {
+    if( nested.Inner.Visits[i] != 1 )
+    {
+      std::cerr << "Wrong nested loop" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( pool->GetNumberOfSerialLoops() != serialLoops + 50 )
+  {
+    std::cerr << "Nested loops not run serially" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The exception of a chunk is thrown by the loop, and the pool is still usable
+  bool caught = false;
+  
+  try
+  {
+    FailingFunction failing;
+    pool->ParallelFor( 0, 1000, &failing, 1 );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cout << "Caught: " << excpt.GetDescription() << std::endl;
+    caught = true;
+  }
+  
+  if( !caught )
+  {
+    std::cerr << "The exception of the loop was not thrown" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  pool->SetNumberOfThreads( 2 );
+  
+  CountFunction count( 1000, 2 );
+  pool->ParallelFor( 0, 1000, &count );
+  
+  if( !CheckCount( count ) )
+  {
+    std::cerr << "Wrong loop after changing the number of threads" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCollisionVesselTrackerEndConditionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the end condition that stops tracking inside already tracked vessels.
+
+#include "ivanCollisionVesselTrackerEndCondition.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+
+typedef ivan::CollisionVesselTrackerEndCondition<CenterlineType>  EndConditionType;
+
+
+void AddSection( BranchNodeType * branch, double x, double y, double z, double radius )
+{
+  SectionType::PointType center;
+  center[0] = x;
+  center[1] = y;
+  center[2] = z;
+  
+  SectionType::Pointer section = SectionType::New();
+  section->SetCenter( center );
+  section->SetRadius( radius );
+  branch->GetCenterline()->push_back( section );
+}
+
+
+int main( int argc, char ** argv )
+{
+  // A trunk along x tracked from a first seed
+  BranchNodeType::Pointer trunk = BranchNodeType::New();
+  for( unsigned int i=0; i<=40; ++i )
+    AddSection( trunk, i, 0.0, 0.0, 2.0 );
+  
+  EndConditionType::SpatialIndexType::Pointer index = EndConditionType::SpatialIndexType::New();
+  index->AppendSections( trunk );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetSpatialIndex( index );
+  
+  ivan::VesselTrackerStepState state;
+  endCondition->SetStepState( &state );
+  
+  // A second seed tracked along y towards the trunk
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  state.Valid = true;
+  state.Branch = branch;
+  
+  unsigned int step = 0;
+  for( ; step <= 20; ++step )
+  {
+    AddSection( branch, 20.0, 20.0 - step, 0.0, 1.0 );
+    
+    state.SectionIndex = step;
+    state.Position[0] = 20.0;
+    state.Position[1] = 20.0 - step;
+    state.Position[2] = 0.0;
+    
+    if( endCondition->Finished() )
+      break;
+  }
+  
+  // The surface of the trunk is at y=2
+  if( step != 18 || endCondition->GetCollisionBranch() != trunk.GetPointer() )
+  {
+    std::cerr << "Collision at step " << step << " instead of 18" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The tracked sections were appended, and the tracked branch itself is not a collision
+  if( index->GetNumberOfSegments() != 40 + 18 )
+  {
+    std::cerr << "Tracked sections not appended: " << index->GetNumberOfSegments() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A branch detected at the bifurcation starts inside its parent
+  BranchNodeType::Pointer child = BranchNodeType::New();
+  state.Branch = child;
+  
+  for( step = 0; step < endCondition->GetNumberOfIgnoredSections(); ++step )
+  {
+    AddSection( child, 20.0, 0.0, step, 1.0 );
+    
+    state.SectionIndex = step;
+    state.Position[0] = 20.0;
+    state.Position[1] = 0.0;
+    state.Position[2] = step;
+    
+    if( endCondition->Finished() )
+    {
+      std::cerr << "Collision checked at ignored section " << step << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Now it reaches the second branch
+  state.SectionIndex = step;
+  state.Position[1] = 16.0;
+  state.Position[2] = 0.5;
+  
+  if( !endCondition->Finished() || endCondition->GetCollisionBranch() != branch.GetPointer() )
+  {
+    std::cerr << "Collision with the second branch not found" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  endCondition->Reset();
+  
+  if( endCondition->GetCollisionBranch() )
+  {
+    std::cerr << "Collision branch not reset" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A thick vessel along x at z=40, with a branch that leaves it along z from its bifurcation
+  BranchNodeType::Pointer thickVessel = BranchNodeType::New();
+  for( unsigned int i=0; i<=40; ++i )
+    AddSection( thickVessel, i, 0.0, 40.0, 8.0 );
+  
+  index->AppendSections( thickVessel );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  BranchNodeType::Pointer thinBranch = BranchNodeType::New();
+  
+  thickVessel->AddChild( bifurcation );
+  bifurcation->AddChild( thinBranch );
+  
+  state.Branch = thinBranch;
+  
+  // Still inside the parent after the ignored sections, which must not stop the branch
+  for( step = 0; step <= 10; ++step )
+  {
+    AddSection( thinBranch, 30.0, 0.0, 40.0 + step, 1.0 );
+    
+    state.SectionIndex = step;
+    state.Position[0] = 30.0;
+    state.Position[1] = 0.0;
+    state.Position[2] = 40.0 + step;
+    
+    if( endCondition->Finished() )
+    {
+      std::cerr << "Collision with the parent branch at section " << step << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Other branches still stop it
+  state.SectionIndex = step;
+  state.Position[2] = 1.0;
+  
+  if( !endCondition->Finished() || endCondition->GetCollisionBranch() != trunk.GetPointer() )
+  {
+    std::cerr << "Collision with the trunk not found from the child branch" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Without ignoring the ancestors, the parent is a collision
+  endCondition->IgnoreAncestorBranchesOff();
+  state.Position[2] = 45.0;
+  
+  if( !endCondition->Finished() || endCondition->GetCollisionBranch() != thickVessel.GetPointer() )
+  {
+    std::cerr << "Collision with the parent branch not found" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
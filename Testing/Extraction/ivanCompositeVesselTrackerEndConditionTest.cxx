@@ -0,0 +1,137 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCompositeVesselTrackerEndConditionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests ordering and short-circuit of composite end conditions, and the mask end condition.
+
+#include "ivanCompositeVesselTrackerEndCondition.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanMaskVesselTrackerEndCondition.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+
+
+int main( int argc, char ** argv )
+{
+  typedef itk::Image<unsigned char,3>                        MaskImageType;
+  
+  typedef ivan::CompositeVesselTrackerEndCondition           CompositeEndConditionType;
+  typedef ivan::MaxIterationsVesselTrackerEndCondition       MaxIterationsEndConditionType;
+  typedef ivan::MaskVesselTrackerEndCondition<MaskImageType> MaskEndConditionType;
+  
+  // Mask of 10x10x10 voxels, with the upper half in x set
+  MaskImageType::RegionType region;
+  region.SetSize( 0, 10 );
+  region.SetSize( 1, 10 );
+  region.SetSize( 2, 10 );
+  
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( region );
+  mask->Allocate();
+  mask->FillBuffer( 0 );
+  
+  MaskImageType::IndexType index;
+  
+  for( index[2] = 0; index[2] < 10; ++index[2] )
+    for( index[1] = 0; index[1] < 10; ++index[1] )
+      for( index[0] = 5; index[0] < 10; ++index[0] )
+        mask->SetPixel( index, 255 );
+  
+  MaxIterationsEndConditionType::Pointer maxIterations = MaxIterationsEndConditionType::New();
+  maxIterations->SetMaxIterations( 4 );
+  
+  MaskEndConditionType::Pointer maskEndCondition = MaskEndConditionType::New();
+  maskEndCondition->SetMaskImage( mask );
+  
+  CompositeEndConditionType::Pointer endCondition = CompositeEndConditionType::New();
+  endCondition->AddEndCondition( maskEndCondition );
+  endCondition->AddEndCondition( maxIterations );
+  
+  // The counter is cheaper than the mask lookup
+  if( endCondition->GetEndCondition( 0 ) != maxIterations.GetPointer() )
+  {
+    std::cerr << "End conditions not sorted by evaluation cost" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // This is what the tracker does when the end condition is set
+  ivan::VesselTrackerStepState state;
+  endCondition->SetStepState( &state );
+  
+  if( maskEndCondition->GetStepState() != &state )
+  {
+    std::cerr << "Step state not forwarded to the end conditions" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Inside the mask the maximum number of iterations finishes
+  state.Valid = true;
+  state.Position[0] = 7.0;
+  state.Position[1] = state.Position[2] = 5.0;
+  
+  for( unsigned int i=1; i<4; ++i )
+  {
+    if( endCondition->Finished() )
+    {
+      std::cerr << "Finished at iteration " << i << " inside the mask" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( !endCondition->Finished() || endCondition->GetFinishedEndCondition() != maxIterations.GetPointer() )
+  {
+    std::cerr << "Maximum number of iterations not reached" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // After a reset, leaving the mask finishes
+  endCondition->Reset();
+  
+  if( endCondition->Finished() )
+  {
+    std::cerr << "Finished inside the mask after reset" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  state.Position[0] = 2.0;
+  
+  if( !endCondition->Finished() || endCondition->GetFinishedEndCondition() != maskEndCondition.GetPointer() )
+  {
+    std::cerr << "Not finished outside the mask" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  state.Position[0] = 20.0;
+  
+  if( !maskEndCondition->Finished() )
+  {
+    std::cerr << "Not finished outside the mask buffer" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCylindricalOffsetMedialnessVesselSectionFitCostFunctionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that the cylindrical medialness cost evaluated over several sections by
+//   several threads gives the same values as the serial evaluation, and that it is the mean
+//   medialness of the sections inside the image.
+
+#include "ivanCylindricalOffsetMedialnessVesselSectionFitCostFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+typedef float                                  PixelType;
+typedef itk::Image<PixelType,3>                ImageType;
+
+typedef ivan::CylindricalOffsetMedialnessVesselSectionFitCostFunction
+  <ImageType>                                  CostFunctionType;
+typedef CostFunctionType::MedialnessFunctionType   MedialnessFunctionType;
+
+
+// Tube of sigma 2 along z, centered at x=y=16
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 32 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 16.0;
+    const double dy = it.GetIndex()[1] - 16.0;
+    
+    it.Set( 1000.0 * std::exp( -( dx * dx + dy * dy ) / 8.0 ) );
+  }
+  
+  return image;
+}
+
+
+CostFunctionType::Pointer CreateCostFunction( ImageType *image, unsigned int numberOfSections,
+  unsigned int numberOfThreads )
+{
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetImage( image );
+  costFunction->SetNumberOfSections( numberOfSections );
+  costFunction->SetSectionSpacing( 1.0 );
+  costFunction->SetNumberOfThreads( numberOfThreads );
+  costFunction->Initialize();
+  
+  // Close to the bottom of the image, so that the lowest sections are out of it
+  CostFunctionType::PointType center;
+  center[0] = 16.0;
+  center[1] = 16.0;
+  center[2] = 3.0;
+  costFunction->SetSectionCenter( center );
+  
+  return costFunction;
+}
+
+
+// Mean medialness of the sections inside the image, computed here one by one
+double ComputeReferenceValue( const CostFunctionType *costFunction, 
+  const CostFunctionType::ParametersType & parameters )
+{
+  const MedialnessFunctionType *medialnessFunction = costFunction->GetMedialnessFunction();
+  const unsigned int numberOfSections = costFunction->GetNumberOfSections();
+  
+  MedialnessFunctionType::VectorType normal;
+  normal[0] = parameters[0];
+  normal[1] = parameters[1];
+  normal[2] = std::sqrt( 1.0 - parameters[0] * parameters[0] - parameters[1] * parameters[1] );
+  
+  double sum = 0.0;
+  unsigned int numberOfValues = 0;
+  
+  for( unsigned int k=0; k<numberOfSections; ++k )
+  {
+    const double offset = ( k - 0.5 * ( numberOfSections - 1.0 ) ) * 
+      costFunction->GetSectionSpacing();
+    
+    MedialnessFunctionType::PointType center;
+    
+    for( unsigned int i=0; i<3; ++i )
+      center[i] = costFunction->GetSectionCenter()[i] + offset * normal[i];
+    
+    if( numberOfSections > 1 && !medialnessFunction->IsInsideBuffer( center ) )
+      continue;
+    
+    sum += medialnessFunction->Evaluate( center );
+    ++numberOfValues;
+  }
+  
+  return sum / numberOfValues;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  const unsigned int numberOfSections = 9;
+  
+  CostFunctionType::Pointer serialCostFunction;
+  CostFunctionType::Pointer parallelCostFunction;
+  CostFunctionType::Pointer oversubscribedCostFunction;
+  CostFunctionType::Pointer singleSectionCostFunction;
+  
+  try
+  {
+    serialCostFunction = CreateCostFunction( image, numberOfSections, 1 );
+    parallelCostFunction = CreateCostFunction( image, numberOfSections, 4 );
+    oversubscribedCostFunction = CreateCostFunction( image, numberOfSections, 16 );
+    singleSectionCostFunction = CreateCostFunction( image, 1, 4 );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Normals around the tube axis and radii around the tube sigma
+  const double normals[][2] = { { 0.0, 0.0 }, { 0.3, 0.1 }, { -0.2, 0.4 }, { 0.5, -0.5 } };
+  const double radii[] = { 1.5, 2.0, 3.0 };
+  
+  CostFunctionType::ParametersType parameters( 3 );
+  
+  for( unsigned int i=0; i<4; ++i )
+  {
+    for( unsigned int j=0; j<3; ++j )
+    {
+      parameters[0] = normals[i][0];
+      parameters[1] = normals[i][1];
+      parameters[2] = radii[j];
+      
+      const double serialValue = serialCostFunction->GetValue( parameters );
+      const double parallelValue = parallelCostFunction->GetValue( parameters );
+      const double oversubscribedValue = oversubscribedCostFunction->GetValue( parameters );
+      const double tolerance = 1e-12 * std::fabs( serialValue );
+      
+      if( serialValue == 0.0 ||
+        std::fabs( parallelValue - serialValue ) > tolerance ||
+        std::fabs( oversubscribedValue - serialValue ) > tolerance )
+      {
+        std::cerr << "Parallel values " << parallelValue << " and " << oversubscribedValue 
+          << " differ from the serial value " << serialValue << " for parameters " 
+          << parameters << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      const double referenceValue = ComputeReferenceValue( parallelCostFunction, parameters );
+      
+      if( std::fabs( parallelValue - referenceValue ) > tolerance )
+      {
+        std::cerr << "Value " << parallelValue << " is not the mean medialness " 
+          << referenceValue << " of the sections in the image for parameters " << parameters
+          << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      // A single section is evaluated at the center
+      const double singleValue = singleSectionCostFunction->GetValue( parameters );
+      const double singleReferenceValue = 
+        ComputeReferenceValue( singleSectionCostFunction, parameters );
+      
+      if( std::fabs( singleValue - singleReferenceValue ) > 1e-12 * std::fabs( singleValue ) )
+      {
+        std::cerr << "Single section value " << singleValue << " instead of " 
+          << singleReferenceValue << " for parameters " << parameters << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
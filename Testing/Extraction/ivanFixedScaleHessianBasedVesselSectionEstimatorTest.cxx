@@ -48,7 +48,7 @@ int main( int argc, const char *argv[] )
   if( argc < 5 )
   {
     std::cerr << "Usage: " << argv[0] << "InputImage OutputTextFile Scale SeedCoord_x SeedCoord_y SeedCoord_z "
-      "[SeedCoordIsPhysical=0] [InvertDirection=0] [MaxIterations]" << std::endl;
+      "[SeedCoordIsPhysical=0] [InvertDirection=0] [MaxIterations] [Bidirectional=0] [AdaptiveStepSize=0] [SpeculativeTurn=0]" << std::endl;
     return EXIT_FAILURE;
   }
 
@@ -145,6 +145,21 @@ int main( int argc, const char *argv[] )
     invertDirection = (bool)atoi( argv[8] );
 
   vesselTracker->SetInvertDirection( invertDirection );
+  
+  // Track in both directions if desired
+  
+  if( argc > 10 )
+    vesselTracker->SetBidirectional( (bool)atoi( argv[10] ) );
+  
+  // Adapt the step size to the radius and curvature if desired
+  
+  if( argc > 11 )
+    vesselTracker->SetAdaptiveStepSize( (bool)atoi( argv[11] ) );
+  
+  // Estimate the next section while the current one is finished if desired
+  
+  if( argc > 12 )
+    vesselTracker->SetSpeculativeTurn( (bool)atoi( argv[12] ) );
 
 
   // Set the end condition
@@ -220,6 +235,69 @@ int main( int argc, const char *argv[] )
 
   std::cout << "Number of computed sections: " << vesselBranch->GetCenterline()->Size() << std::endl;
   
+  if( vesselTracker->GetSpeculativeTurn() )
+  {
+    std::cout << "Speculative sections kept: " << vesselTracker->GetNumberOfSpeculativeHits() 
+      << " discarded: " << vesselTracker->GetNumberOfSpeculativeMisses() << std::endl;
+    
+    // Track again without speculation. The kept sections were estimated within 
+    // SpeculationTolerance of the final centers, so they must be close to the serial ones
+    SectionEstimatorType::Pointer serialSectionEstimator = SectionEstimatorType::New();
+    serialSectionEstimator->SetImage( reader->GetOutput() );
+    serialSectionEstimator->SetScale( scale );
+    
+    EndConditionType::Pointer serialEndCondition = EndConditionType::New();
+    serialEndCondition->SetMaxIterations( maxIterations );
+    
+    VesselTrackerType::Pointer serialVesselTracker = VesselTrackerType::New();
+    serialVesselTracker->SetInput( reader->GetOutput() );
+    serialVesselTracker->SetSectionEstimator( serialSectionEstimator );
+    serialVesselTracker->SetEndCondition( serialEndCondition.GetPointer() );
+    serialVesselTracker->SetInvertDirection( vesselTracker->GetInvertDirection() );
+    serialVesselTracker->SetBidirectional( vesselTracker->GetBidirectional() );
+    serialVesselTracker->SetAdaptiveStepSize( vesselTracker->GetAdaptiveStepSize() );
+    serialVesselTracker->SetStartingPoint( startingPoint );
+    
+    try
+    {
+      serialVesselTracker->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+      return EXIT_FAILURE;
+    }
+    
+    const CenterlineType *serialCenterline = static_cast<BranchNodeType*>
+      ( serialVesselTracker->GetOutput()->GetRootNode().GetPointer() )->GetCenterline();
+    const CenterlineType *speculativeCenterline = vesselBranch->GetCenterline();
+    
+    if( serialCenterline->Size() != speculativeCenterline->Size() )
+    {
+      std::cerr << "Speculative tracking computed " << speculativeCenterline->Size() 
+        << " sections instead of " << serialCenterline->Size() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<serialCenterline->Size(); ++i )
+    {
+      const VesselSectionType *serialSection = serialCenterline->at(i);
+      const VesselSectionType *speculativeSection = speculativeCenterline->at(i);
+      
+      const double centerDistance = 
+        serialSection->GetCenter().EuclideanDistanceTo( speculativeSection->GetCenter() );
+      const double normalCosine = serialSection->GetNormal() * speculativeSection->GetNormal();
+      
+      if( centerDistance > 0.5 || normalCosine < 0.99 ||
+        vcl_abs( serialSection->GetRadius() - speculativeSection->GetRadius() ) > 0.1 )
+      {
+        std::cerr << "Speculative section " << i << " differs from the serial one: center distance "
+          << centerDistance << " normal cosine " << normalCosine << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
   std::ofstream fileout;
   fileout.open( argv[2] );
   fileout << "Index Center(x y z) Normal (x y z) Scale" << std::endl;
@@ -0,0 +1,190 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageBasedVesselSectionFitCostFunctionDerivativeTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the finite-difference derivative of the section fit cost functions against 
+// analytic derivatives and a reference finite-difference evaluation.
+
+#include "ivanImageBasedVesselSectionFitCostFunction.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+
+typedef itk::Image<float,3>   ImageType;
+
+
+/** Sum of the cubes of the parameters, for which central differences with step h give 
+  * 3 p^2 + h^2, so the step used for each parameter can be recovered. */
+class CubicCostFunction : public ivan::ImageBasedVesselSectionFitCostFunction<ImageType>
+{
+public:
+  
+  typedef CubicCostFunction                                        Self;
+  typedef ivan::ImageBasedVesselSectionFitCostFunction<ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                  Pointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( CubicCostFunction, ImageBasedVesselSectionFitCostFunction );
+  
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+    {
+      MeasureType value = 0.0;
+      
+      for( unsigned int i=0; i<parameters.GetSize(); ++i )
+        value += parameters[i] * parameters[i] * parameters[i];
+        
+      return value;
+    }
+  
+  virtual unsigned int GetNumberOfParameters() const
+    { return 3; }
+};
+
+
+/** Smooth cost with coupled parameters of different magnitudes: two normal components and a 
+  * radius. */
+class SmoothCostFunction : public ivan::ImageBasedVesselSectionFitCostFunction<ImageType>
+{
+public:
+  
+  typedef SmoothCostFunction                                       Self;
+  typedef ivan::ImageBasedVesselSectionFitCostFunction<ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                  Pointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( SmoothCostFunction, ImageBasedVesselSectionFitCostFunction );
+  
+  virtual MeasureType GetValue( const ParametersType & p ) const
+    { return sin( 3.0 * p[0] ) * cos( p[1] ) + exp( -0.1 * p[2] ) * p[0] * p[1] + log( p[2] ); }
+  
+  void GetAnalyticDerivative( const ParametersType & p, DerivativeType & derivative ) const
+    {
+      derivative.SetSize( 3 );
+      derivative[0] = 3.0 * cos( 3.0 * p[0] ) * cos( p[1] ) + exp( -0.1 * p[2] ) * p[1];
+      derivative[1] = -sin( 3.0 * p[0] ) * sin( p[1] ) + exp( -0.1 * p[2] ) * p[0];
+      derivative[2] = -0.1 * exp( -0.1 * p[2] ) * p[0] * p[1] + 1.0 / p[2];
+    }
+  
+  virtual unsigned int GetNumberOfParameters() const
+    { return 3; }
+};
+
+
+int main( int, char ** )
+{
+  typedef CubicCostFunction::ParametersType   ParametersType;
+  typedef CubicCostFunction::DerivativeType   DerivativeType;
+  typedef CubicCostFunction::ScalesType       ScalesType;
+  
+  ParametersType parameters( 3 );
+  parameters[0] = 0.3;
+  parameters[1] = -0.8;
+  parameters[2] = 25.0;
+  
+  // The step is scaled by the magnitude of each parameter, at least 1
+  CubicCostFunction::Pointer cubic = CubicCostFunction::New();
+  
+  DerivativeType derivative;
+  cubic->GetDerivative( parameters, derivative );
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    const double step = cubic->GetDerivativeStepLength() * std::max( 1.0, std::fabs( parameters[i] ) );
+    const double expected = 3.0 * parameters[i] * parameters[i] + step * step;
+    
+    if( derivative.GetSize() != 3 || std::fabs( derivative[i] - expected ) > 1e-9 * std::max( 1.0, expected ) )
+    {
+      std::cerr << "Derivative " << i << " is " << derivative[i] << ", expected " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Scales given per parameter replace the magnitudes
+  ScalesType scales( 3 );
+  scales[0] = 0.5;
+  scales[1] = 2.0;
+  scales[2] = 10.0;
+  
+  cubic->SetDerivativeStepLength( 0.02 );
+  cubic->SetDerivativeStepScales( scales );
+  cubic->GetDerivative( parameters, derivative );
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    const double step = 0.02 * scales[i];
+    const double expected = 3.0 * parameters[i] * parameters[i] + step * step;
+    
+    if( std::fabs( derivative[i] - expected ) > 1e-9 * std::max( 1.0, expected ) )
+    {
+      std::cerr << "Derivative " << i << " with scales is " << derivative[i] << ", expected " 
+        << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Smooth cost against the analytic derivative and a reference with a much smaller step
+  SmoothCostFunction::Pointer smooth = SmoothCostFunction::New();
+  
+  DerivativeType analyticDerivative;
+  smooth->GetAnalyticDerivative( parameters, analyticDerivative );
+  
+  double value;
+  smooth->GetValueAndDerivative( parameters, value, derivative );
+  
+  if( value != smooth->GetValue( parameters ) )
+  {
+    std::cerr << "GetValueAndDerivative() gives value " << value << ", expected " 
+      << smooth->GetValue( parameters ) << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    const double referenceStep = 1e-5 * std::max( 1.0, std::fabs( parameters[i] ) );
+    
+    ParametersType forwardParameters = parameters;
+    ParametersType backwardParameters = parameters;
+    forwardParameters[i] += referenceStep;
+    backwardParameters[i] -= referenceStep;
+    
+    const double reference = ( smooth->GetValue( forwardParameters ) - 
+      smooth->GetValue( backwardParameters ) ) / ( 2.0 * referenceStep );
+    
+    if( std::fabs( reference - analyticDerivative[i] ) > 1e-6 ||
+        std::fabs( derivative[i] - reference ) > 2e-3 * std::max( 1.0, std::fabs( reference ) ) )
+    {
+      std::cerr << "Derivative " << i << " is " << derivative[i] << ", reference " << reference 
+        << ", analytic " << analyticDerivative[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageToCircleFitCostFunctionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the derivative of the circle fit cost function with respect to the radius 
+//   against the analytic derivative of a Gaussian blob and finite differences of the value, with
+//   the gradient of a B-spline interpolator and with the forward difference of a linear one.
+
+#include "ivanImageToCircleFitCostFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,2>                               ImageType;
+typedef ivan::ImageToCircleFitCostFunction<ImageType>     CostFunctionType;
+
+typedef itk::LinearInterpolateImageFunction
+  <ImageType, CostFunctionType::CoordinateRepresentationType>   LinearInterpolatorType;
+
+const double blobSigma = 6.0;
+const double blobPeak = 1000.0;
+
+
+// Gaussian blob centered in a 64x64 image
+ImageType::Pointer CreateBlobImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 64 );
+  region.SetSize( 1, 64 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 32.0;
+    const double dy = it.GetIndex()[1] - 32.0;
+    
+    it.Set( blobPeak * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * blobSigma * blobSigma ) ) );
+  }
+  
+  return image;
+}
+
+
+// Value and derivative of the cost at the given radius
+double GetValueAndDerivative( const CostFunctionType *costFunction, double radius, 
+  double & derivative )
+{
+  CostFunctionType::ParametersType parameters( 1 );
+  parameters[0] = radius;
+  
+  CostFunctionType::MeasureType value;
+  CostFunctionType::DerivativeType gradient;
+  costFunction->GetValueAndDerivative( parameters, value, gradient );
+  
+  derivative = gradient[0];
+  return value;
+}
+
+
+double GetValue( const CostFunctionType *costFunction, double radius )
+{
+  CostFunctionType::ParametersType parameters( 1 );
+  parameters[0] = radius;
+  
+  return costFunction->GetValue( parameters );
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateBlobImage();
+  
+  CostFunctionType::PointType center;
+  center[0] = 32.0;
+  center[1] = 32.0;
+  
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetImage( image );
+  costFunction->SetCenter( center );
+  costFunction->SetInterpolator( CostFunctionType::BSplineInterpolatorType::New() );
+  
+  try
+  {
+    costFunction->Initialize();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The maximum of the radial derivative of the blob, at one sigma
+  const double maxDerivative = blobPeak / blobSigma * std::exp( -0.5 );
+  const double step = 1e-4;
+  
+  // With the B-spline interpolator, the derivative is the gradient of the interpolated image, 
+  // so it must match the derivative of the blob and the central difference of the value. The
+  // radius-scaled differences used before would be several times larger
+  for( double radius = 2.0; radius < 15.0; radius += 1.5 )
+  {
+    double derivative;
+    const unsigned long interpolations = costFunction->GetNumberOfInterpolations();
+    const double value = GetValueAndDerivative( costFunction, radius, derivative );
+    
+    if( costFunction->GetNumberOfInterpolations() - interpolations != 
+      CostFunctionType::GetNumberOfSamples( radius ) )
+    {
+      std::cerr << "The value and derivative did not take one interpolation per sample" 
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const double expectedValue = 
+      blobPeak * std::exp( -radius * radius / ( 2.0 * blobSigma * blobSigma ) );
+    const double expectedDerivative = -radius / ( blobSigma * blobSigma ) * expectedValue;
+    
+    if( std::fabs( value - GetValue( costFunction, radius ) ) > 1e-6 * blobPeak ||
+      std::fabs( value - expectedValue ) > 1e-2 * blobPeak ||
+      std::fabs( derivative - expectedDerivative ) > 1e-2 * maxDerivative )
+    {
+      std::cerr << "Wrong value or derivative at radius " << radius << ": " << value << ", " 
+        << derivative << " instead of " << expectedValue << ", " << expectedDerivative 
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The central difference samples the same angles if the number of samples does not change
+    if( CostFunctionType::GetNumberOfSamples( radius - step ) != 
+        CostFunctionType::GetNumberOfSamples( radius + step ) )
+      continue;
+    
+    const double difference = ( GetValue( costFunction, radius + step ) - 
+      GetValue( costFunction, radius - step ) ) / ( 2.0 * step );
+    
+    if( std::fabs( derivative - difference ) > 1e-3 * maxDerivative )
+    {
+      std::cerr << "Derivative at radius " << radius << " is " << derivative 
+        << ", central difference is " << difference << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // With other interpolators, the derivative is the forward difference of the value with a
+  // relative increment of DerivativeDelta
+  const double derivativeDelta = 1e-3;
+  
+  costFunction->SetInterpolator( LinearInterpolatorType::New() );
+  costFunction->SetDerivativeDelta( derivativeDelta );
+  
+  try
+  {
+    costFunction->Initialize();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( double radius = 2.0; radius < 15.0; radius += 0.7 )
+  {
+    const double forwardRadius = radius * ( 1.0 + derivativeDelta );
+    
+    if( CostFunctionType::GetNumberOfSamples( radius ) != 
+        CostFunctionType::GetNumberOfSamples( forwardRadius ) )
+      continue;
+    
+    double derivative;
+    const double value = GetValueAndDerivative( costFunction, radius, derivative );
+    
+    const double difference = ( GetValue( costFunction, forwardRadius ) - value ) / 
+      ( forwardRadius - radius );
+    
+    if( std::fabs( derivative - difference ) > 1e-6 * maxDerivative ||
+      std::fabs( derivative ) > 2.0 * maxDerivative )
+    {
+      std::cerr << "Forward difference derivative at radius " << radius << " is " << derivative 
+        << " instead of " << difference << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Radii out of the valid range give zero value and derivative
+  double derivative;
+  
+  if( GetValueAndDerivative( costFunction, 0.25, derivative ) != 0.0 || derivative != 0.0 ||
+    GetValueAndDerivative( costFunction, 40.0, derivative ) != 0.0 || derivative != 0.0 )
+  {
+    std::cerr << "Invalid radii must give zero value and derivative" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
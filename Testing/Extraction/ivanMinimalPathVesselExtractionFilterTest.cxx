@@ -0,0 +1,195 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMinimalPathVesselExtractionFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the MinimalPathVesselExtractionFilter class on a synthetic L-shaped tube. 
+//   The path between both ends must stay on the tube axis and get the radius of the scale image.
+
+#include "ivanMinimalPathVesselExtractionFilter.h"
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                               ImageType;
+
+typedef ivan::CircularVesselSection<3>                    VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>                       CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                 VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>            BranchNodeType;
+
+typedef ivan::MinimalPathVesselExtractionFilter
+  <ImageType, VesselGraphType>                            MinimalPathFilterType;
+
+
+// Distance to the axis of the tube, from (5,10,20) to (30,10,20) and then to (30,32,20)
+double DistanceToAxis( const ImageType::PointType & point )
+{
+  const double dz = point[2] - 20.0;
+  
+  const double x = std::min( std::max( point[0], 5.0 ), 30.0 );
+  const double d1 = std::sqrt( ( point[0] - x ) * ( point[0] - x ) + 
+    ( point[1] - 10.0 ) * ( point[1] - 10.0 ) + dz * dz );
+  
+  const double y = std::min( std::max( point[1], 10.0 ), 32.0 );
+  const double d2 = std::sqrt( ( point[0] - 30.0 ) * ( point[0] - 30.0 ) + 
+    ( point[1] - y ) * ( point[1] - y ) + dz * dz );
+  
+  return std::min( d1, d2 );
+}
+
+
+int main( int, char ** )
+{
+  // Response of a tube of scale 1.5 in a 40x40x40 image of 1 mm voxels
+  ImageType::RegionType region;
+  region.SetSize( 0, 40 );
+  region.SetSize( 1, 40 );
+  region.SetSize( 2, 40 );
+  
+  ImageType::Pointer response = ImageType::New();
+  response->SetRegions( region );
+  response->Allocate();
+  
+  ImageType::Pointer scales = ImageType::New();
+  scales->SetRegions( region );
+  scales->Allocate();
+  scales->FillBuffer( 1.5f );
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( response, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    response->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    
+    const double distance = DistanceToAxis( point );
+    it.Set( std::exp( -distance * distance / ( 2.0 * 1.5 * 1.5 ) ) );
+  }
+  
+  MinimalPathFilterType::InputImagePointType startPoint, endPoint;
+  startPoint[0] = 5.0;  startPoint[1] = 10.0;  startPoint[2] = 20.0;
+  endPoint[0] = 30.0;   endPoint[1] = 32.0;    endPoint[2] = 20.0;
+  
+  MinimalPathFilterType::Pointer filter = MinimalPathFilterType::New();
+  filter->SetInput( response );
+  filter->SetScaleImage( scales );
+  filter->SetStartPoint( startPoint );
+  filter->SetEndPoint( endPoint );
+  filter->SetRegionMargin( 5.0 );
+  
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( filter->GetOutput()->GetRootNode().GetPointer() );
+  
+  if( !branch || branch->GetCenterline()->size() < 2 )
+  {
+    std::cerr << "No path extracted" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const CenterlineType *centerline = branch->GetCenterline();
+  
+  std::cout << "Sections: " << centerline->size() << ", cost: " << filter->GetPathCost() 
+    << ", accepted pixels: " << filter->GetNumberOfAcceptedPixels() << " of " 
+    << filter->GetProcessedRegion().GetNumberOfPixels() << std::endl;
+  
+  // The processed region spans the seeds and the margin only
+  if( filter->GetProcessedRegion().GetSize()[0] != 36 || filter->GetProcessedRegion().GetSize()[2] != 11 ||
+      filter->GetNumberOfAcceptedPixels() >= filter->GetProcessedRegion().GetNumberOfPixels() )
+  {
+    std::cerr << "Wrong processed region: " << filter->GetProcessedRegion() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( centerline->at(0)->GetCenter().EuclideanDistanceTo( startPoint ) > 1e-6 ||
+      centerline->at( centerline->size() - 1 )->GetCenter().EuclideanDistanceTo( endPoint ) > 1e-6 )
+  {
+    std::cerr << "The path does not join the seeds" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  double length = 0.0;
+  
+  for( unsigned int i=0; i < centerline->size(); ++i )
+  {
+    const VesselSectionType *section = centerline->at(i);
+    
+    // Smoothing cuts the corner by about one pixel
+    if( DistanceToAxis( section->GetCenter() ) > 1.5 )
+    {
+      std::cerr << "Section " << i << " off the axis: " << section->GetCenter() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( std::fabs( section->GetNormal().GetNorm() - 1.0 ) > 1e-6 ||
+        std::fabs( section->GetRadius() - 1.5 * std::sqrt( 3.0 ) ) > 1e-4 || section->GetScale() != 1.5 )
+    {
+      std::cerr << "Wrong normal or radius at section " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( i > 0 )
+      length += section->GetCenter().EuclideanDistanceTo( centerline->at(i-1)->GetCenter() );
+  }
+  
+  // The axis is 47 mm long, the path cuts the corner a bit
+  if( length < 44.0 || length > 52.0 )
+  {
+    std::cerr << "Wrong path length: " << length << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Seeds outside the image are rejected
+  endPoint[0] = 50.0;
+  filter->SetEndPoint( endPoint );
+  
+  try
+  {
+    filter->Update();
+    std::cerr << "No exception with a seed outside the image" << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch( itk::ExceptionObject & )
+  {
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,456 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiSeedVesselTrackerFilterRecursiveTrackingTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks a synthetic vessel with two side branches, one of them with a side branch 
+//   of its own. Checks that the tracker detects the branch candidates, and that the multi-seed 
+//   filter tracks them recursively, attaches them under their parent through a bifurcation, and 
+//   respects the maximum depth and number of detected branches. The components are those of
+//   ivanVesselnessRidgeSearchVesselTrackerFilterPoolTest.cxx.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanVesselnessRidgeSearchVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType>     BifurcationNodeType;
+
+typedef ivan::MultiSeedVesselTrackerFilter
+  <ImageType, VesselGraphType>                          MultiSeedTrackerType;
+typedef MultiSeedTrackerType::TrackerFactoryType        TrackerFactoryBaseType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>     GradientFunctionType;
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>    VesselnessFunctionType;
+
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <VesselnessFunctionType,ImageType>                               VesselnessFunctionInitializerType;
+
+typedef ivan::VesselnessRidgeSearchVesselTrackerFilter
+  <ImageType, VesselGraphType, VesselnessFunctionType>             VesselTrackerType;
+
+typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+  <ImageType,VesselnessFunctionType,GradientFunctionType,CenterlineType>  SectionEstimatorType;
+
+typedef VesselTrackerType::DirectionType                           DirectionType;
+
+
+/** Straight tube of constant radius between two points. */
+struct Tube
+{
+  double  Start[Dimension];
+  double  End[Dimension];
+  double  Radius;
+};
+
+// The main vessel runs along z. The first side branch leaves it along x and has a side branch
+// along y, and the second side branch leaves it along y. Branches are perpendicular to their 
+// parent, so the ring of the parent section plane crosses them.
+const unsigned int NumberOfTubes = 4;
+
+const Tube Tubes[NumberOfTubes] = 
+{
+  { { 20.0, 20.0,  4.0 }, { 20.0, 20.0, 76.0 }, 3.0 },
+  { { 20.0, 20.0, 30.0 }, { 64.0, 20.0, 30.0 }, 2.5 },
+  { { 20.0, 20.0, 50.0 }, { 20.0, 64.0, 50.0 }, 2.5 },
+  { { 44.0, 20.0, 30.0 }, { 44.0, 62.0, 30.0 }, 2.5 }
+};
+
+const double BranchSearchRadius = 6.0;
+
+
+double SquaredDistanceToTube( const ImageType::IndexType & index, const Tube & tube )
+{
+  double axis[Dimension], offset[Dimension];
+  double length = 0.0, t = 0.0;
+  
+  for( unsigned int dim=0; dim < Dimension; ++dim )
+  {
+    axis[dim] = tube.End[dim] - tube.Start[dim];
+    offset[dim] = index[dim] - tube.Start[dim];
+    length += axis[dim] * axis[dim];
+    t += axis[dim] * offset[dim];
+  }
+  
+  t = std::max( 0.0, std::min( 1.0, t / length ) );
+  
+  double distance = 0.0;
+  
+  for( unsigned int dim=0; dim < Dimension; ++dim )
+  {
+    const double d = offset[dim] - t * axis[dim];
+    distance += d * d;
+  }
+  
+  return distance;
+}
+
+
+ImageType::Pointer CreateBranchingImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 72 );
+  region.SetSize( 1, 72 );
+  region.SetSize( 2, 80 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    bool inside = false;
+    
+    for( unsigned int i=0; i < NumberOfTubes && !inside; ++i )
+      inside = SquaredDistanceToTube( it.GetIndex(), Tubes[i] ) <= Tubes[i].Radius * Tubes[i].Radius;
+    
+    it.Set( inside ? 1000.0 : 0.0 );
+  }
+  
+  return image;
+}
+
+
+/** Point where the ring of radius BranchSearchRadius around the axis of the parent crosses the
+  * axis of the given branch, and direction of the branch. */
+void GetExpectedCandidate( unsigned int tube, ImageType::PointType & point, DirectionType & direction )
+{
+  double length = 0.0;
+  
+  for( unsigned int dim=0; dim < Dimension; ++dim )
+  {
+    direction[dim] = Tubes[tube].End[dim] - Tubes[tube].Start[dim];
+    length += direction[dim] * direction[dim];
+  }
+  
+  length = std::sqrt( length );
+  
+  for( unsigned int dim=0; dim < Dimension; ++dim )
+  {
+    direction[dim] /= length;
+    point[dim] = Tubes[tube].Start[dim] + BranchSearchRadius * direction[dim];
+  }
+}
+
+
+// Creates a ridge search tracker with its own estimator and end condition for each seed. The 
+// main vessel is tracked from the seed along +z
+class TrackerFactory : public TrackerFactoryBaseType
+{
+public:
+
+  typedef TrackerFactory                  Self;
+  typedef TrackerFactoryBaseType          Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual Superclass::TrackerPointer CreateTracker( unsigned int seed )
+    {
+      VesselTrackerType::Pointer tracker = VesselTrackerType::New();
+      
+      VesselnessFunctionInitializerType::Pointer initializer = VesselnessFunctionInitializerType::New();
+      tracker->SetVesselnessFunctionInitializer( initializer );
+      
+      SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+      sectionEstimator->SetImage( m_Image );
+      sectionEstimator->SetMetricFunctionInitializer( initializer );
+      sectionEstimator->SetScaleStepMethod( SectionEstimatorType::EquispacedScaleSteps );
+      sectionEstimator->SetNumberOfScales( 5 );
+      sectionEstimator->SetMinimumScale( 1.0 );
+      sectionEstimator->SetMaximumScale( 5.0 );
+      sectionEstimator->Initialize();
+      
+      tracker->SetSectionEstimator( sectionEstimator );
+      
+      // The branches end well inside the image
+      EndConditionType::Pointer endCondition = EndConditionType::New();
+      endCondition->SetMaxIterations( ( seed == 0 ) ? 50 : 30 );
+      tracker->SetEndCondition( endCondition.GetPointer() );
+      
+      tracker->SetRadialResolution( 5 );
+      tracker->SetAngularResolution( 16 );
+      tracker->SetMaximumSearchDistance( 1.0 );
+      tracker->SetBranchSearchRadius( BranchSearchRadius );
+      tracker->SetBranchVesselnessRatio( 0.3 );
+      
+      // The multi-seed filter sets the direction of the detected branches
+      if( seed == 0 )
+      {
+        DirectionType direction;
+        direction.Fill( 0.0 );
+        direction[2] = 1.0;
+        tracker->SetInitialDirection( direction );
+      }
+      
+      return tracker.GetPointer();
+    }
+
+  ImageType::Pointer  m_Image;
+};
+
+
+ImageType::PointType GetSeed()
+{
+  ImageType::PointType seed;
+  seed[0] = 20.0;  seed[1] = 20.0;  seed[2] = 10.0;
+  
+  return seed;
+}
+
+
+MultiSeedTrackerType::Pointer TrackRecursively( ImageType *image, TrackerFactory *factory, 
+  bool recursive, unsigned int maximumDepth, unsigned int maximumNumberOfBranches )
+{
+  MultiSeedTrackerType::Pointer tracker = MultiSeedTrackerType::New();
+  tracker->SetInput( image );
+  tracker->SetTrackerFactory( factory );
+  tracker->AddSeed( GetSeed() );
+  tracker->SetNumberOfThreads( 1 );
+  tracker->SetRecursiveTracking( recursive );
+  tracker->SetMaximumBranchDepth( maximumDepth );
+  tracker->SetMaximumNumberOfBranches( maximumNumberOfBranches );
+  tracker->Update();
+  
+  return tracker;
+}
+
+
+/** Get the branch under the given child bifurcation of the parent, checking that it starts at
+  * the candidate of the given tube and is tracked along it. */
+const BranchNodeType * GetChildBranch( const BranchNodeType *parent, unsigned int position, 
+  unsigned int tube )
+{
+  if( !parent || position >= parent->GetNumberOfChildren() )
+    return 0;
+  
+  const BifurcationNodeType *bifurcation = 
+    dynamic_cast<const BifurcationNodeType*>( parent->GetChild( position ) );
+  
+  if( !bifurcation || bifurcation->GetNumberOfChildren() != 1 )
+    return 0;
+  
+  const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( bifurcation->GetChild(0) );
+  
+  if( !branch || branch->GetCenterline()->Size() < 2 )
+    return 0;
+  
+  ImageType::PointType expectedPoint;
+  DirectionType expectedDirection;
+  GetExpectedCandidate( tube, expectedPoint, expectedDirection );
+  
+  CenterlineType::ConstPointer centerline = branch->GetCenterline();
+  const VesselSectionType *first = centerline->ElementAt( 0 );
+  const VesselSectionType *last = centerline->ElementAt( centerline->Size() - 1 );
+  
+  double distance = 0.0, advance = 0.0;
+  
+  for( unsigned int dim=0; dim < Dimension; ++dim )
+  {
+    const double d = first->GetCenter()[dim] - expectedPoint[dim];
+    distance += d * d;
+    advance += ( last->GetCenter()[dim] - first->GetCenter()[dim] ) * 
+      expectedDirection[dim];
+  }
+  
+  if( std::sqrt( distance ) > Tubes[tube].Radius + 1.5 || advance < 10.0 )
+  {
+    std::cerr << "The branch of tube " << tube << " goes from " << first->GetCenter() 
+      << " to " << last->GetCenter() << std::endl;
+    return 0;
+  }
+  
+  return branch;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateBranchingImage();
+  
+  TrackerFactory::Pointer factory = TrackerFactory::New();
+  factory->m_Image = image;
+  
+  // The tracker of the main vessel detects the two side branches, in tracking order
+  
+  VesselTrackerType::Pointer tracker = 
+    dynamic_cast<VesselTrackerType*>( factory->CreateTracker( 0 ).GetPointer() );
+  tracker->SetInput( image );
+  tracker->SetStartingPoint( GetSeed() );
+  tracker->DetectBranchesOn();
+  
+  try
+  {
+    tracker->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  const VesselTrackerType::BranchCandidateContainerType & candidates = tracker->GetBranchCandidates();
+  
+  if( candidates.size() != 2 )
+  {
+    std::cerr << "Expected 2 branch candidates, got " << candidates.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int c=0; c < candidates.size(); ++c )
+  {
+    ImageType::PointType expectedPoint;
+    DirectionType expectedDirection;
+    GetExpectedCandidate( c + 1, expectedPoint, expectedDirection );
+    
+    double dotProduct = 0.0;
+    
+    for( unsigned int dim=0; dim < Dimension; ++dim )
+      dotProduct += candidates[c].Direction[dim] * expectedDirection[dim];
+    
+    std::cout << "Candidate " << c << ": " << candidates[c].Point << " towards " 
+      << candidates[c].Direction << std::endl;
+    
+    if( candidates[c].Point.EuclideanDistanceTo( expectedPoint ) > Tubes[c+1].Radius + 1.5 || 
+      dotProduct < 0.8 )
+    {
+      std::cerr << "Candidate " << c << " is not on tube " << c + 1 << ", expected " 
+        << expectedPoint << " towards " << expectedDirection << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  try
+  {
+    // All the branches
+    MultiSeedTrackerType::Pointer multiSeedTracker = TrackRecursively( image, factory, true, 2, 100 );
+    
+    const BranchNodeType *mainBranch = multiSeedTracker->GetSeedBranch( 0 );
+    const BranchNodeType *firstBranch = GetChildBranch( mainBranch, 0, 1 );
+    const BranchNodeType *secondBranch = GetChildBranch( mainBranch, 1, 2 );
+    const BranchNodeType *nestedBranch = GetChildBranch( firstBranch, 0, 3 );
+    
+    if( multiSeedTracker->GetNumberOfDetectedBranches() != 3 || 
+      multiSeedTracker->GetOutput()->GetRootNode()->GetNumberOfChildren() != 1 ||
+      !mainBranch || mainBranch->GetNumberOfChildren() != 2 || !firstBranch || !secondBranch || !nestedBranch ||
+      firstBranch->GetNumberOfChildren() != 1 || secondBranch->GetNumberOfChildren() != 0 || 
+      nestedBranch->GetNumberOfChildren() != 0 )
+    {
+      std::cerr << "Wrong tree with depth 2: " << multiSeedTracker->GetNumberOfDetectedBranches() 
+        << " detected branches" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Ids follow the order of detection, with the bifurcation before its branch
+    if( mainBranch->GetNodeId() != 1 || firstBranch->GetNodeId() != 3 || 
+      secondBranch->GetNodeId() != 5 || nestedBranch->GetNodeId() != 7 )
+    {
+      std::cerr << "Wrong ids " << mainBranch->GetNodeId() << ", " << firstBranch->GetNodeId() 
+        << ", " << secondBranch->GetNodeId() << ", " << nestedBranch->GetNodeId() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The branches of depth 1 do not detect their own branches
+    multiSeedTracker = TrackRecursively( image, factory, true, 1, 100 );
+    
+    mainBranch = multiSeedTracker->GetSeedBranch( 0 );
+    firstBranch = GetChildBranch( mainBranch, 0, 1 );
+    secondBranch = GetChildBranch( mainBranch, 1, 2 );
+    
+    if( multiSeedTracker->GetNumberOfDetectedBranches() != 2 || !mainBranch || 
+      mainBranch->GetNumberOfChildren() != 2 || 
+      !firstBranch || !secondBranch || firstBranch->GetNumberOfChildren() != 0 )
+    {
+      std::cerr << "Wrong tree with depth 1: " << multiSeedTracker->GetNumberOfDetectedBranches() 
+        << " detected branches" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Only the first candidate is tracked
+    multiSeedTracker = TrackRecursively( image, factory, true, 2, 1 );
+    
+    mainBranch = multiSeedTracker->GetSeedBranch( 0 );
+    firstBranch = GetChildBranch( mainBranch, 0, 1 );
+    
+    if( multiSeedTracker->GetNumberOfDetectedBranches() != 1 || !mainBranch || 
+      mainBranch->GetNumberOfChildren() != 1 || 
+      !firstBranch || firstBranch->GetNumberOfChildren() != 0 )
+    {
+      std::cerr << "Wrong tree with 1 branch: " << multiSeedTracker->GetNumberOfDetectedBranches() 
+        << " detected branches" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // No branches without recursive tracking
+    multiSeedTracker = TrackRecursively( image, factory, false, 2, 100 );
+    
+    mainBranch = multiSeedTracker->GetSeedBranch( 0 );
+    
+    if( multiSeedTracker->GetNumberOfDetectedBranches() != 0 || !mainBranch || 
+      mainBranch->GetNumberOfChildren() != 0 )
+    {
+      std::cerr << "Branches tracked without recursive tracking" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
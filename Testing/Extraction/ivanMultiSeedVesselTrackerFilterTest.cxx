@@ -0,0 +1,397 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiSeedVesselTrackerFilterTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests the MultiSeedVesselTrackerFilter class. Several seeds along a tube are
+//   tracked with one and with several threads, and interleaving several trackers per thread, 
+//   and the resulting graphs must be the same. Then the seeds are tracked again reusing the 
+//   previous branches, and with a different end condition, and the results must be the same as 
+//   when tracking from scratch.
+
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+
+#include "itkImageFileReader.h"
+
+#include <sstream>
+
+
+typedef short           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::MultiSeedVesselTrackerFilter
+  <ImageType, VesselGraphType>                          MultiSeedTrackerType;
+typedef MultiSeedTrackerType::TrackerType               VesselTrackerType;
+typedef MultiSeedTrackerType::TrackerFactoryType        TrackerFactoryBaseType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+
+
+// Creates a tracker with its own estimator and end condition for each seed
+class TrackerFactory : public TrackerFactoryBaseType
+{
+public:
+
+  typedef TrackerFactory                  Self;
+  typedef TrackerFactoryBaseType          Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual Superclass::TrackerPointer CreateTracker( unsigned int )
+    {
+      Superclass::TrackerPointer tracker = VesselTrackerType::New();
+      
+      SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+      sectionEstimator->SetImage( m_Image );
+      sectionEstimator->SetScale( m_Scale );
+      tracker->SetSectionEstimator( sectionEstimator );
+      
+      EndConditionType::Pointer endCondition = EndConditionType::New();
+      endCondition->SetMaxIterations( m_MaxIterations );
+      tracker->SetEndCondition( endCondition.GetPointer() );
+      
+      // Only used when the trackers are interleaved
+      tracker->SetPrefetchRadius( 4 );
+      
+      return tracker;
+    }
+
+  virtual std::string GetSectionParametersKey( unsigned int )
+    {
+      std::ostringstream key;
+      key << "Scale=" << m_Scale;
+      return key.str();
+    }
+    
+  virtual std::string GetEndConditionParametersKey( unsigned int )
+    {
+      std::ostringstream key;
+      key << "MaxIterations=" << m_MaxIterations;
+      return key.str();
+    }
+
+  ImageType::Pointer  m_Image;
+  double              m_Scale;
+  unsigned int        m_MaxIterations;
+};
+
+
+// Track all the seeds with the given number of threads and interleaved trackers per thread
+VesselGraphType::Pointer TrackSeeds( ImageType *image, TrackerFactory *factory, 
+  const MultiSeedTrackerType::SeedContainerType & seeds, unsigned int numberOfThreads,
+  unsigned int numberOfInterleavedTrackers = 1 )
+{
+  MultiSeedTrackerType::Pointer tracker = MultiSeedTrackerType::New();
+  tracker->SetInput( image );
+  tracker->SetTrackerFactory( factory );
+  tracker->SetSeeds( seeds );
+  tracker->SetNumberOfThreads( numberOfThreads );
+  tracker->SetNumberOfInterleavedTrackers( numberOfInterleavedTrackers );
+  tracker->Update();
+  
+  VesselGraphType::Pointer graph = tracker->GetOutput();
+  graph->DisconnectPipeline();
+  
+  return graph;
+}
+
+
+// Check that both graphs have the same branches with the same section centers
+bool SameBranches( const VesselGraphType *graph, const VesselGraphType *reference )
+{
+  if( graph->GetRootNode()->GetNumberOfChildren() != reference->GetRootNode()->GetNumberOfChildren() )
+    return false;
+  
+  for( unsigned int i=0; i < reference->GetRootNode()->GetNumberOfChildren(); ++i )
+  {
+    const BranchNodeType *branch = 
+      dynamic_cast<const BranchNodeType*>( graph->GetRootNode()->GetChild(i) );
+    const BranchNodeType *referenceBranch = 
+      dynamic_cast<const BranchNodeType*>( reference->GetRootNode()->GetChild(i) );
+    
+    if( !branch || !referenceBranch || branch->GetNodeId() != referenceBranch->GetNodeId() ||
+        branch->GetCenterline()->size() != referenceBranch->GetCenterline()->size() )
+      return false;
+    
+    for( unsigned int j=0; j < referenceBranch->GetCenterline()->size(); ++j )
+    {
+      for( unsigned int dim=0; dim < Dimension; ++dim )
+      {
+        if( branch->GetCenterline()->at(j)->GetCenter()[dim] != 
+            referenceBranch->GetCenterline()->at(j)->GetCenter()[dim] )
+          return false;
+      }
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, const char *argv[] )
+{
+  if( argc < 7 )
+  {
+    std::cerr << "Usage: " << argv[0] << "InputImage Scale SeedCoord_x SeedCoord_y SeedCoord_z "
+      "NumberOfSeeds [SeedStep_z=5] [MaxIterations=10] [NumberOfThreads=4]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  typedef itk::ImageFileReader<ImageType>  ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+
+  try
+  {
+    reader->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  ImageType::Pointer image = reader->GetOutput();
+  
+  TrackerFactory::Pointer factory = TrackerFactory::New();
+  factory->m_Image = image;
+  factory->m_Scale = atof( argv[2] );
+  factory->m_MaxIterations = ( argc > 8 ) ? atoi( argv[8] ) : 10;
+  
+  // Seeds along the z direction
+  
+  const unsigned int numberOfSeeds = atoi( argv[6] );
+  const int seedStep = ( argc > 7 ) ? atoi( argv[7] ) : 5;
+  const unsigned int numberOfThreads = ( argc > 9 ) ? atoi( argv[9] ) : 4;
+  
+  MultiSeedTrackerType::SeedContainerType seeds;
+  ImageType::IndexType index;
+  ImageType::PointType point;
+  
+  for( unsigned int i=0; i < numberOfSeeds; ++i )
+  {
+    index[0] = atoi( argv[3] );
+    index[1] = atoi( argv[4] );
+    index[2] = atoi( argv[5] ) + i * seedStep;
+    
+    image->TransformIndexToPhysicalPoint( index, point );
+    seeds.push_back( point );
+  }
+  
+  VesselGraphType::Pointer serialGraph, parallelGraph, interleavedGraph;
+  
+  try
+  {
+    serialGraph      = TrackSeeds( image, factory, seeds, 1 );
+    parallelGraph    = TrackSeeds( image, factory, seeds, numberOfThreads );
+    interleavedGraph = TrackSeeds( image, factory, seeds, 2, 3 );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  // Check that there is one branch per seed with the expected id and the same centerline
+  
+  typedef CenterlineType::SectionType  SectionType;
+  
+  if( serialGraph->GetRootNode()->GetNumberOfChildren() != numberOfSeeds ||
+      parallelGraph->GetRootNode()->GetNumberOfChildren() != numberOfSeeds ||
+      interleavedGraph->GetRootNode()->GetNumberOfChildren() != numberOfSeeds )
+  {
+    std::cerr << "Expected " << numberOfSeeds << " branches, got " 
+      << serialGraph->GetRootNode()->GetNumberOfChildren() << ", " 
+      << parallelGraph->GetRootNode()->GetNumberOfChildren() << " and " 
+      << interleavedGraph->GetRootNode()->GetNumberOfChildren() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i < numberOfSeeds; ++i )
+  {
+    const BranchNodeType *interleavedBranch = 
+      dynamic_cast<const BranchNodeType*>( interleavedGraph->GetRootNode()->GetChild(i) );
+    const BranchNodeType *referenceBranch = 
+      dynamic_cast<const BranchNodeType*>( serialGraph->GetRootNode()->GetChild(i) );
+    
+    if( !interleavedBranch || !referenceBranch || interleavedBranch->GetNodeId() != i + 1 ||
+        interleavedBranch->GetCenterline()->size() != referenceBranch->GetCenterline()->size() )
+    {
+      std::cerr << "Wrong interleaved branch for seed " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int j=0; j < referenceBranch->GetCenterline()->size(); ++j )
+    {
+      for( unsigned int dim=0; dim < Dimension; ++dim )
+      {
+        if( interleavedBranch->GetCenterline()->at(j)->GetCenter()[dim] != 
+            referenceBranch->GetCenterline()->at(j)->GetCenter()[dim] )
+        {
+          std::cerr << "Different interleaved section center for seed " << i << " at section " 
+            << j << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  
+  for( unsigned int i=0; i < numberOfSeeds; ++i )
+  {
+    const BranchNodeType *serialBranch = 
+      dynamic_cast<const BranchNodeType*>( serialGraph->GetRootNode()->GetChild(i) );
+    const BranchNodeType *parallelBranch = 
+      dynamic_cast<const BranchNodeType*>( parallelGraph->GetRootNode()->GetChild(i) );
+    
+    if( !serialBranch || !parallelBranch || serialBranch->GetNodeId() != i + 1 || 
+        parallelBranch->GetNodeId() != i + 1 )
+    {
+      std::cerr << "Wrong branch for seed " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const CenterlineType *serialCenterline   = serialBranch->GetCenterline();
+    const CenterlineType *parallelCenterline = parallelBranch->GetCenterline();
+    
+    if( serialCenterline->size() != parallelCenterline->size() )
+    {
+      std::cerr << "Different number of sections for seed " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int j=0; j < serialCenterline->size(); ++j )
+    {
+      for( unsigned int dim=0; dim < Dimension; ++dim )
+      {
+        if( serialCenterline->at(j)->GetCenter()[dim] != parallelCenterline->at(j)->GetCenter()[dim] )
+        {
+          std::cerr << "Different section center for seed " << i << " at section " << j << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+    
+    std::cout << "Seed " << i << ": " << serialCenterline->size() << " sections" << std::endl;
+  }
+  
+  // Track again with the same parameters. All the branches must be reused, sharing the 
+  // centerlines, and then resumed when only the end condition changes
+  
+  MultiSeedTrackerType::Pointer reuseTracker = MultiSeedTrackerType::New();
+  reuseTracker->SetInput( image );
+  reuseTracker->SetTrackerFactory( factory );
+  reuseTracker->SetSeeds( seeds );
+  reuseTracker->SetNumberOfThreads( numberOfThreads );
+  reuseTracker->SetReuseUnchangedBranches( true );
+  
+  const unsigned int maxIterations = factory->m_MaxIterations;
+  
+  try
+  {
+    reuseTracker->Update();
+    
+    VesselGraphType::Pointer firstGraph = reuseTracker->GetOutput();
+    ivan::VesselNode::Pointer firstRoot = firstGraph->GetRootNode();
+    
+    if( !SameBranches( firstGraph, serialGraph ) || reuseTracker->GetNumberOfReusedBranches() != 0 )
+    {
+      std::cerr << "Wrong branches when tracking with memos" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    reuseTracker->Modified();
+    reuseTracker->Update();
+    
+    if( reuseTracker->GetNumberOfReusedBranches() != numberOfSeeds || 
+        !SameBranches( reuseTracker->GetOutput(), serialGraph ) )
+    {
+      std::cerr << "Expected " << numberOfSeeds << " reused branches, got " 
+        << reuseTracker->GetNumberOfReusedBranches() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i < numberOfSeeds; ++i )
+    {
+      const BranchNodeType *firstBranch = 
+        dynamic_cast<const BranchNodeType*>( firstRoot->GetChild(i) );
+      
+      if( reuseTracker->GetSeedBranch(i)->GetCenterline().GetPointer() != 
+          firstBranch->GetCenterline().GetPointer() )
+      {
+        std::cerr << "The centerline of reused branch " << i << " is not shared" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // Shorter and then longer branches than the first ones
+    const unsigned int resumedMaxIterations[2] = { maxIterations / 2, 2 * maxIterations };
+    
+    for( unsigned int k=0; k < 2; ++k )
+    {
+      factory->m_MaxIterations = resumedMaxIterations[k];
+      
+      reuseTracker->Modified();
+      reuseTracker->Update();
+      
+      VesselGraphType::Pointer referenceGraph = TrackSeeds( image, factory, seeds, 1 );
+      
+      if( reuseTracker->GetNumberOfResumedBranches() != numberOfSeeds ||
+          !SameBranches( reuseTracker->GetOutput(), referenceGraph ) )
+      {
+        std::cerr << "Wrong resumed branches with MaxIterations " << resumedMaxIterations[k] 
+          << ", resumed " << reuseTracker->GetNumberOfResumedBranches() << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      std::cout << "Resumed with MaxIterations " << resumedMaxIterations[k] << ": " 
+        << reuseTracker->GetSeedBranch(0)->GetCenterline()->size() << " sections" << std::endl;
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,334 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMultiscaleLazyInitializationTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that MultiscaleImageFunction and MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+//   give the same results with LazyInitialization on and off, including the first evaluation at 
+//   each scale. The lazy objects insert their scaled functions in a ScaledImageFunctionCache, so 
+//   that the test also checks when they are created.
+
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselCenterline.h"
+#include "ivanMultiscaleImageFunction.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <vector>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>     GradientFunctionType;
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>    VesselnessFunctionType;
+
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <VesselnessFunctionType,ImageType>                               VesselnessFunctionInitializerType;
+
+typedef ivan::MultiscaleImageFunction
+  <VesselnessFunctionType,ImageType,double>                        MultiscaleFunctionType;
+
+typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+  <ImageType,VesselnessFunctionType,GradientFunctionType,CenterlineType>  SectionEstimatorType;
+
+typedef MultiscaleFunctionType::PointType                          PointType;
+typedef MultiscaleFunctionType::PointContainerType                 PointContainerType;
+
+
+const unsigned int NumberOfScales = 5;
+
+
+// Tube along x, centered at y=z=16, with a radius growing from 2 to 4 so several scales are used
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 64 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 32 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double radius = 2.0 + 2.0 * index[0] / 63.0;
+    const double dy = index[1] - 16.0;
+    const double dz = index[2] - 16.0;
+    
+    it.Set( ( dy * dy + dz * dz <= radius * radius ) ? 1000.0 : 0.0 );
+  }
+  
+  return image;
+}
+
+
+// Points along the tube, some of them off its axis
+PointContainerType CreatePoints()
+{
+  PointContainerType points;
+  
+  for( unsigned int i=0; i<15; ++i )
+  {
+    PointType point;
+    point[0] = 4.0 + 4.0 * i;
+    point[1] = 16.0 + 0.5 * ( (int)( i % 3 ) - 1 );
+    point[2] = 16.0 + ( ( i % 2 ) ? 1.0 : 0.0 );
+    
+    points.push_back( point );
+  }
+  
+  return points;
+}
+
+
+MultiscaleFunctionType::Pointer CreateMultiscaleFunction( ImageType *image, bool lazy, bool goldenSection, 
+  MultiscaleFunctionType::ScaledImageFunctionCacheType *cache )
+{
+  MultiscaleFunctionType::Pointer function = MultiscaleFunctionType::New();
+  function->SetInputImage( image );
+  function->SetScaledImageFunctionInitializer( VesselnessFunctionInitializerType::New() );
+  function->SetNumberOfScales( NumberOfScales );
+  function->SetMinimumScale( 1.0 );
+  function->SetMaximumScale( 5.0 );
+  function->SetLazyInitialization( lazy );
+  function->SetScaledImageFunctionCache( cache );
+  
+  if( goldenSection )
+    function->SetScaleSearchMethodToGoldenSection();
+  
+  function->Initialize();
+  
+  return function;
+}
+
+
+SectionEstimatorType::Pointer CreateSectionEstimator( ImageType *image, bool lazy, 
+  SectionEstimatorType::ScaledImageFunctionCacheType *cache )
+{
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetMetricFunctionInitializer( VesselnessFunctionInitializerType::New() );
+  sectionEstimator->SetScaleStepMethod( SectionEstimatorType::EquispacedScaleSteps );
+  sectionEstimator->SetNumberOfScales( NumberOfScales );
+  sectionEstimator->SetMinimumScale( 1.0 );
+  sectionEstimator->SetMaximumScale( 5.0 );
+  sectionEstimator->SetLazyInitialization( lazy );
+  sectionEstimator->SetScaledImageFunctionCache( cache );
+  sectionEstimator->Initialize();
+  
+  return sectionEstimator;
+}
+
+
+// Sections at the points, estimated with the given estimator
+CenterlineType::Pointer EstimateSections( SectionEstimatorType *sectionEstimator )
+{
+  const PointContainerType points = CreatePoints();
+  
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<points.size(); ++i )
+  {
+    VesselSectionType::PointType center = points[i];
+    
+    VesselSectionType::Pointer section = VesselSectionType::New();
+    section->SetCenter( center );
+    
+    centerline->push_back( section );
+  }
+  
+  sectionEstimator->SetCenterline( centerline );
+  sectionEstimator->Compute();
+  
+  return centerline;
+}
+
+
+// Compares each point as it is evaluated, so that the first evaluation of the lazy function at 
+// each scale is compared too
+bool CompareEvaluations( const MultiscaleFunctionType *eager, const MultiscaleFunctionType *lazy, 
+  const char *label )
+{
+  const PointContainerType points = CreatePoints();
+  
+  for( unsigned int i=0; i<points.size(); ++i )
+  {
+    double eagerScale, lazyScale;
+    const double eagerValue = eager->EvaluateAndSelectScale( points[i], eagerScale );
+    const double lazyValue = lazy->EvaluateAndSelectScale( points[i], lazyScale );
+    
+    if( eagerValue != lazyValue || eagerScale != lazyScale )
+    {
+      std::cerr << label << ": point " << points[i] << " gives " << lazyValue << " at scale " 
+        << lazyScale << " instead of " << eagerValue << " at scale " << eagerScale << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  const PointContainerType points = CreatePoints();
+  
+  try
+  {
+    // Exhaustive search. The first evaluation creates the functions of all the scales
+    
+    MultiscaleFunctionType::ScaledImageFunctionCacheType::Pointer cache = 
+      MultiscaleFunctionType::ScaledImageFunctionCacheType::New();
+    
+    MultiscaleFunctionType::Pointer eagerFunction = CreateMultiscaleFunction( image, false, false, 0 );
+    MultiscaleFunctionType::Pointer lazyFunction = CreateMultiscaleFunction( image, true, false, cache );
+    
+    if( cache->GetNumberOfFunctions() != 0 )
+    {
+      std::cerr << "Lazy function created " << cache->GetNumberOfFunctions() 
+        << " scaled functions in Initialize()" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !CompareEvaluations( eagerFunction, lazyFunction, "Exhaustive search" ) )
+      return EXIT_FAILURE;
+    
+    if( cache->GetNumberOfFunctions() != NumberOfScales )
+    {
+      std::cerr << "Lazy function created " << cache->GetNumberOfFunctions() << " scaled functions"
+        << " instead of " << NumberOfScales << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Golden section search. Each point may evaluate some scales for the first time
+    
+    cache = MultiscaleFunctionType::ScaledImageFunctionCacheType::New();
+    
+    eagerFunction = CreateMultiscaleFunction( image, false, true, 0 );
+    lazyFunction = CreateMultiscaleFunction( image, true, true, cache );
+    
+    if( !CompareEvaluations( eagerFunction, lazyFunction, "Golden section search" ) )
+      return EXIT_FAILURE;
+    
+    std::cout << "Golden section search created " << cache->GetNumberOfFunctions() 
+      << " scaled functions" << std::endl;
+    
+    // Batch evaluation, with all the scales created in the first call
+    
+    eagerFunction = CreateMultiscaleFunction( image, false, false, 0 );
+    lazyFunction = CreateMultiscaleFunction( image, true, false, 0 );
+    
+    std::vector<double> eagerValues( points.size() ), lazyValues( points.size() );
+    std::vector<double> eagerScales( points.size() ), lazyScales( points.size() );
+    
+    eagerFunction->EvaluateBatch( points, &eagerValues[0], &eagerScales[0] );
+    lazyFunction->EvaluateBatch( points, &lazyValues[0], &lazyScales[0] );
+    
+    for( unsigned int i=0; i<points.size(); ++i )
+    {
+      if( eagerValues[i] != lazyValues[i] || eagerScales[i] != lazyScales[i] )
+      {
+        std::cerr << "Batch evaluation: point " << points[i] << " gives " << lazyValues[i] 
+          << " at scale " << lazyScales[i] << " instead of " << eagerValues[i] << " at scale " 
+          << eagerScales[i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // Section estimator. The scaled functions are only created for the scales selected at the 
+    // sections, the first time each of them is selected
+    
+    SectionEstimatorType::ScaledImageFunctionCacheType::Pointer estimatorCache = 
+      SectionEstimatorType::ScaledImageFunctionCacheType::New();
+    
+    SectionEstimatorType::Pointer eagerEstimator = CreateSectionEstimator( image, false, 0 );
+    SectionEstimatorType::Pointer lazyEstimator = CreateSectionEstimator( image, true, estimatorCache );
+    
+    if( estimatorCache->GetNumberOfFunctions() != 0 )
+    {
+      std::cerr << "Lazy estimator created " << estimatorCache->GetNumberOfFunctions() 
+        << " scaled functions in Initialize()" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    CenterlineType::Pointer eagerCenterline = EstimateSections( eagerEstimator );
+    CenterlineType::Pointer lazyCenterline = EstimateSections( lazyEstimator );
+    
+    if( estimatorCache->GetNumberOfFunctions() == 0 || 
+      estimatorCache->GetNumberOfFunctions() > NumberOfScales )
+    {
+      std::cerr << "Lazy estimator created " << estimatorCache->GetNumberOfFunctions() 
+        << " scaled functions" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<eagerCenterline->size(); ++i )
+    {
+      const VesselSectionType *eagerSection = eagerCenterline->at(i);
+      const VesselSectionType *lazySection = lazyCenterline->at(i);
+      
+      if( eagerSection->GetCenter() != lazySection->GetCenter() || 
+        eagerSection->GetNormal() != lazySection->GetNormal() ||
+        eagerSection->GetScale() != lazySection->GetScale() ||
+        eagerSection->GetRadius() != lazySection->GetRadius() )
+      {
+        std::cerr << "Section " << i << " differs: center " << lazySection->GetCenter() 
+          << " normal " << lazySection->GetNormal() << " scale " << lazySection->GetScale() 
+          << " instead of " << eagerSection->GetCenter() << " normal " << eagerSection->GetNormal() 
+          << " scale " << eagerSection->GetScale() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanOptimizedVesselSectionEstimatorWarmStartTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: estimates the sections of a Gaussian tube with OptimizedVesselSectionEstimator, 
+//   the OffsetMedialnessVesselSectionFitCostFunction and the ParallelPatternSearchOptimizer, with
+//   WarmStart on and off. The warm-started sections must converge to the same normals and radii 
+//   as the cold-started ones within tolerance, with no more iterations, and the initial step of 
+//   the optimizer must be restored.
+
+#include "ivanOffsetMedialnessVesselSectionFitCostFunction.h"
+#include "ivanOptimizedVesselSectionEstimator.h"
+#include "ivanParallelPatternSearchOptimizer.h"
+#include "ivanCircularGaussianStraightTubeGenerator.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+#define MAX_SEARCH_RADIUS 10.0
+
+
+typedef short    PixelType;
+
+typedef ivan::CircularGaussianStraightTubeGenerator<PixelType>   TubeGeneratorType;
+typedef TubeGeneratorType::ImageType                             TubeImageType;
+
+typedef ivan::CircularVesselSection<>            VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>              CenterlineType;
+typedef VesselSectionType::CenterPointType       CenterPointType;
+
+typedef ivan::OffsetMedialnessVesselSectionFitCostFunction<TubeImageType>  CostFunctionType;
+typedef ivan::ParallelPatternSearchOptimizer                               OptimizerType;
+
+typedef ivan::OptimizedVesselSectionEstimator
+  <CostFunctionType, OptimizerType, CenterlineType>                        SectionEstimatorType;
+
+
+const unsigned int NumberOfSections = 10;
+
+const double InitialStepLength = 0.5;
+
+
+// Sections along the tube axis, which is the z axis through the center of the image, with some 
+// of the centers off the axis so that the solutions change from one section to the next. All the
+// sections start from the same wrong normal and radius
+CenterlineType::Pointer CreateCenterline( const TubeImageType *tubeImage, double sigma )
+{
+  const TubeImageType::RegionType::SizeType size = tubeImage->GetLargestPossibleRegion().GetSize();
+  
+  VesselSectionType::VectorType initialNormal;
+  initialNormal[0] = 0.3;
+  initialNormal[1] = 0.2;
+  initialNormal[2] = 0.0;
+  initialNormal[2] = std::sqrt( 1.0 - initialNormal.GetSquaredNorm() );
+  
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<NumberOfSections; ++i )
+  {
+    TubeImageType::IndexType index;
+    index[0] = size[0] / 2;
+    index[1] = size[1] / 2;
+    index[2] = size[2] / 2 - NumberOfSections / 2 + i;
+    
+    CenterPointType center;
+    tubeImage->TransformIndexToPhysicalPoint( index, center );
+    center[0] += 0.3 * ( (int)( i % 3 ) - 1 );
+    
+    VesselSectionType::Pointer section = VesselSectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( initialNormal );
+    section->SetRadius( 1.5 * sigma );
+    section->SetScale( 1.0 );
+    
+    centerline->push_back( section );
+  }
+  
+  return centerline;
+}
+
+
+SectionEstimatorType::Pointer CreateSectionEstimator( TubeImageType *tubeImage, bool warmStart )
+{
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->MaximizeOn();
+  optimizer->SetInitialStepLength( InitialStepLength );
+  optimizer->SetMinimumStepLength( 1e-3 );
+  optimizer->SetMaximumNumberOfIterations( 1000 );
+  
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetImage( tubeImage );
+  costFunction->GetMedialnessFunction()->SetSymmetryCoefficient( 0.5 );
+  costFunction->SetMaxRadius( MAX_SEARCH_RADIUS );
+  costFunction->Initialize();
+  
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetCostFunction( costFunction );
+  sectionEstimator->SetOptimizer( optimizer );
+  sectionEstimator->SetWarmStart( warmStart );
+  
+  return sectionEstimator;
+}
+
+
+int main( int, char ** )
+{
+  TubeGeneratorType tubeGenerator;
+  tubeGenerator.SetSigma( 2.0 );
+  tubeGenerator.SetHeight( 30 );
+  tubeGenerator.SetMaxValue( 255.0 );
+  tubeGenerator.SetImageSpacing( 1.0 );
+  tubeGenerator.SetSectionImageSize( 21 );
+  
+  TubeImageType::Pointer tubeImage;
+  
+  try
+  {
+    tubeImage = tubeGenerator.Create();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  CenterlineType::Pointer coldCenterline = CreateCenterline( tubeImage, tubeGenerator.GetSigma() );
+  CenterlineType::Pointer warmCenterline = CreateCenterline( tubeImage, tubeGenerator.GetSigma() );
+  
+  SectionEstimatorType::Pointer coldEstimator = CreateSectionEstimator( tubeImage, false );
+  SectionEstimatorType::Pointer warmEstimator = CreateSectionEstimator( tubeImage, true );
+  
+  coldEstimator->SetCenterline( coldCenterline );
+  warmEstimator->SetCenterline( warmCenterline );
+  
+  try
+  {
+    coldEstimator->Compute();
+    warmEstimator->Compute();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  std::cout << "Optimizer iterations: " << coldEstimator->GetTotalNumberOfIterations() << " cold, " 
+    << warmEstimator->GetTotalNumberOfIterations() << " warm" << std::endl;
+  
+  if( coldEstimator->GetNumberOfComputedSections() != NumberOfSections || 
+    warmEstimator->GetNumberOfComputedSections() != NumberOfSections )
+  {
+    std::cerr << "Not all the sections were computed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<NumberOfSections; ++i )
+  {
+    const VesselSectionType *coldSection = coldCenterline->at(i);
+    const VesselSectionType *warmSection = warmCenterline->at(i);
+    
+    const double normalCosine = coldSection->GetNormal() * warmSection->GetNormal();
+    
+    if( coldSection->GetRadius() <= 0.0 || normalCosine < 0.995 ||
+      std::fabs( coldSection->GetRadius() - warmSection->GetRadius() ) > 0.1 )
+    {
+      std::cerr << "Warm-started section " << i << " has normal " << warmSection->GetNormal() 
+        << " and radius " << warmSection->GetRadius() << " instead of " << coldSection->GetNormal() 
+        << " and " << coldSection->GetRadius() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Warm-started sections start near their optimum with a smaller step
+  if( warmEstimator->GetTotalNumberOfIterations() > coldEstimator->GetTotalNumberOfIterations() )
+  {
+    std::cerr << "Warm start needed more iterations than cold start" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( warmEstimator->GetOptimizer()->GetInitialStepLength() != InitialStepLength )
+  {
+    std::cerr << "The initial step was not restored: " 
+      << warmEstimator->GetOptimizer()->GetInitialStepLength() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
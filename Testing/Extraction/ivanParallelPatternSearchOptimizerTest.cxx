@@ -0,0 +1,132 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanParallelPatternSearchOptimizerTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests the ParallelPatternSearchOptimizer class. A quadratic cost function is
+//   minimized evaluating the pattern with one and with several threads, and the results must be 
+//   the same and close to the minimum.
+
+
+#include "ivanParallelPatternSearchOptimizer.h"
+#include "ivanBatchSingleValuedCostFunction.h"
+
+#include <cmath>
+#include <cstdlib>
+
+
+/** Anisotropic quadratic with minimum at (1,-2,0.5). */
+class QuadraticCostFunction : public ivan::BatchSingleValuedCostFunction
+{
+public:
+  
+  typedef QuadraticCostFunction                 Self;
+  typedef ivan::BatchSingleValuedCostFunction   Superclass;
+  typedef itk::SmartPointer<Self>               Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+    {
+      const double x = parameters[0] - 1.0;
+      const double y = parameters[1] + 2.0;
+      const double z = parameters[2] - 0.5;
+      
+      return x * x + 4.0 * y * y + 2.0 * z * z;
+    }
+  
+  virtual void GetDerivative( const ParametersType & itkNotUsed( parameters ), 
+    DerivativeType & itkNotUsed( derivative ) ) const
+    {}
+  
+  virtual unsigned int GetNumberOfParameters() const
+    { return 3; }
+};
+
+
+int main( int argc, const char *argv[] )
+{
+  unsigned int numberOfThreads = 4;
+  
+  if( argc > 1 )
+    numberOfThreads = atoi( argv[1] );
+  
+  typedef ivan::ParallelPatternSearchOptimizer  OptimizerType;
+  
+  QuadraticCostFunction::Pointer costFunction = QuadraticCostFunction::New();
+  
+  OptimizerType::ParametersType initialPosition( 3 );
+  initialPosition.Fill( 0.0 );
+  
+  OptimizerType::ParametersType positions[2];
+  unsigned long numberOfEvaluations[2];
+  
+  for( unsigned int run=0; run < 2; ++run )
+  {
+    costFunction->SetNumberOfThreads( run == 0 ? 1 : numberOfThreads );
+    
+    OptimizerType::Pointer optimizer = OptimizerType::New();
+    optimizer->SetCostFunction( costFunction );
+    optimizer->SetInitialPosition( initialPosition );
+    optimizer->SetInitialStepLength( 1.0 );
+    optimizer->SetMinimumStepLength( 1e-4 );
+    optimizer->SetMaximumNumberOfIterations( 1000 );
+    
+    try
+    {
+      optimizer->StartOptimization();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    positions[run] = optimizer->GetCurrentPosition();
+    numberOfEvaluations[run] = optimizer->GetNumberOfEvaluations();
+    
+    std::cout << "Threads: " << costFunction->GetNumberOfThreads() << " Position: " << positions[run] 
+      << " Value: " << optimizer->GetCurrentValue() << " Evaluations: " << numberOfEvaluations[run] 
+      << " (" << optimizer->GetStopConditionDescription() << ")" << std::endl;
+  }
+  
+  if( positions[0] != positions[1] || numberOfEvaluations[0] != numberOfEvaluations[1] )
+  {
+    std::cerr << "Results depend on the number of threads." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const double expected[3] = { 1.0, -2.0, 0.5 };
+  
+  for( unsigned int i=0; i < 3; ++i )
+  {
+    if( std::fabs( positions[0][i] - expected[i] ) > 1e-3 )
+    {
+      std::cerr << "Minimum not found." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRegionVesselTrackerEndConditionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the region end condition and the exits it records.
+
+#include "ivanRegionVesselTrackerEndCondition.h"
+
+#include "itkImage.h"
+
+#include <iostream>
+
+
+int main( int argc, char ** argv )
+{
+  typedef itk::Image<float,3>                                  ImageType;
+  typedef ivan::RegionVesselTrackerEndCondition<ImageType>     EndConditionType;
+  
+  // Image of 100x100x100 voxels of 0.5 mm, only the geometry is used
+  ImageType::RegionType largestRegion;
+  largestRegion.SetSize( 0, 100 );
+  largestRegion.SetSize( 1, 100 );
+  largestRegion.SetSize( 2, 100 );
+  
+  ImageType::SpacingType spacing;
+  spacing.Fill( 0.5 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( largestRegion );
+  image->SetSpacing( spacing );
+  
+  // Slab of z indices [40,60), that is z in [19.75,29.75) mm
+  ImageType::RegionType slab = largestRegion;
+  slab.SetIndex( 2, 40 );
+  slab.SetSize( 2, 20 );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetImage( image );
+  endCondition->SetRegion( slab );
+  
+  ivan::VesselTrackerStepState state;
+  endCondition->SetStepState( &state );
+  
+  // Track along z from the middle of the slab
+  state.Valid = true;
+  state.Position[0] = state.Position[1] = 10.0;
+  
+  for( double z = 25.0; z < 29.7; z += 1.0 )
+  {
+    state.Position[2] = z;
+    
+    if( endCondition->Finished() )
+    {
+      std::cerr << "Finished inside the slab at z=" << z << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  state.Position[2] = 30.0;
+  
+  if( !endCondition->Finished() || endCondition->GetExits().size() != 1 )
+  {
+    std::cerr << "No exit at z=30" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const EndConditionType::Exit & exit = endCondition->GetExits()[0];
+  
+  if( exit.Position[2] != 30.0 || exit.Direction[2] < 0.999 )
+  {
+    std::cerr << "Wrong exit: " << exit.Position << " " << exit.Direction << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The opposite direction of a bidirectional tracking adds a second exit
+  endCondition->Reset();
+  
+  for( double z = 25.0; z > 18.0; z -= 1.0 )
+  {
+    state.Position[2] = z;
+    
+    if( endCondition->Finished() != ( z < 19.75 ) )
+    {
+      std::cerr << "Wrong result at z=" << z << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( endCondition->GetExits().size() != 2 || endCondition->GetExits()[1].Direction[2] > -0.999 )
+  {
+    std::cerr << "Wrong exit in the opposite direction" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Starting outside gives no exit
+  endCondition->Reset();
+  endCondition->ClearExits();
+  state.Position[2] = 5.0;
+  
+  if( !endCondition->Finished() || !endCondition->GetExits().empty() )
+  {
+    std::cerr << "Wrong result outside the slab" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
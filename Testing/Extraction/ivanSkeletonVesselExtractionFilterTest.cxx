@@ -0,0 +1,286 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanSkeletonVesselExtractionFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the SkeletonVesselExtractionFilter class on a synthetic Y-shaped vessel. 
+//   The tree must have three branches on the axes joined at a bifurcation, for any number of threads.
+
+#include "ivanSkeletonVesselExtractionFilter.h"
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                               ImageType;
+
+typedef ivan::CircularVesselSection<3>                    VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>                       CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                 VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>            BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType>       BifurcationNodeType;
+
+typedef ivan::SkeletonVesselExtractionFilter
+  <ImageType, VesselGraphType>                            SkeletonFilterType;
+
+typedef SkeletonFilterType::NormalImageType               NormalImageType;
+typedef SkeletonFilterType::ScaleImageType                ScaleImageType;
+
+
+// Segments of the axes of the trunk and the two branches
+const double Segments[3][2][3] = 
+{
+  { { 4.0, 20.3, 20.2 },  { 20.0, 20.3, 20.2 } },
+  { { 20.0, 20.3, 20.2 }, { 35.0, 8.3, 20.2 } },
+  { { 20.0, 20.3, 20.2 }, { 35.0, 32.3, 30.7 } }
+};
+
+
+// Distance to the nearest axis, and direction of that axis
+double DistanceToAxes( const ImageType::PointType & point, NormalImageType::PixelType * direction = 0 )
+{
+  double minimumDistance = 1e9;
+  
+  for( unsigned int s=0; s < 3; ++s )
+  {
+    double axis[3], length2 = 0.0, t = 0.0;
+    
+    for( unsigned int d=0; d < 3; ++d )
+    {
+      axis[d] = Segments[s][1][d] - Segments[s][0][d];
+      length2 += axis[d] * axis[d];
+      t += ( point[d] - Segments[s][0][d] ) * axis[d];
+    }
+    
+    t = std::min( std::max( t / length2, 0.0 ), 1.0 );
+    
+    double distance = 0.0;
+    
+    for( unsigned int d=0; d < 3; ++d )
+    {
+      const double difference = point[d] - Segments[s][0][d] - t * axis[d];
+      distance += difference * difference;
+    }
+    
+    distance = std::sqrt( distance );
+    
+    if( distance < minimumDistance )
+    {
+      minimumDistance = distance;
+      
+      if( direction )
+      {
+        for( unsigned int d=0; d < 3; ++d )
+          (*direction)[d] = axis[d] / std::sqrt( length2 );
+      }
+    }
+  }
+  
+  return minimumDistance;
+}
+
+
+int main( int, char ** )
+{
+  // Medialness and normals of a vessel of scale 1.5 in a 40x40x40 image of 1 mm voxels
+  ImageType::RegionType region;
+  region.SetSize( 0, 40 );
+  region.SetSize( 1, 40 );
+  region.SetSize( 2, 40 );
+  
+  ImageType::Pointer medialness = ImageType::New();
+  medialness->SetRegions( region );
+  medialness->Allocate();
+  
+  NormalImageType::Pointer normals = NormalImageType::New();
+  normals->SetRegions( region );
+  normals->Allocate();
+  
+  ScaleImageType::Pointer scales = ScaleImageType::New();
+  scales->SetRegions( region );
+  scales->Allocate();
+  scales->FillBuffer( 1.5 );
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( medialness, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    medialness->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    
+    NormalImageType::PixelType direction;
+    const double distance = DistanceToAxes( point, &direction );
+    
+    it.Set( std::exp( -distance * distance / ( 2.0 * 1.5 * 1.5 ) ) );
+    normals->SetPixel( it.GetIndex(), direction );
+  }
+  
+  SkeletonFilterType::Pointer filter = SkeletonFilterType::New();
+  filter->SetInput( medialness );
+  filter->SetNormalImage( normals );
+  filter->SetScaleImage( scales );
+  filter->SetLowerThreshold( 0.3 );
+  filter->SetNumberOfThreads( 1 );
+  
+  std::vector<ImageType::PointType> centers;
+  
+  for( unsigned int run=0; run < 2; ++run )
+  { 
+    // The second run uses several slabs
+    if( run == 1 )
+      filter->SetNumberOfThreads( 4 );
+    
+    try
+    {
+      filter->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    std::cout << "Threads: " << filter->GetNumberOfThreads() << ", ridge pixels: " 
+      << filter->GetNumberOfRidgePixels() << ", branches: " << filter->GetNumberOfBranches() 
+      << ", bifurcations: " << filter->GetNumberOfBifurcations() << std::endl;
+    
+    if( filter->GetNumberOfBranches() != 3 || filter->GetNumberOfBifurcations() != 1 )
+    {
+      std::cerr << "Wrong number of branches or bifurcations" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Root, first branch, bifurcation and the two other branches
+    const ivan::VesselNode *rootNode = filter->GetOutput()->GetRootNode();
+    
+    if( rootNode->GetNumberOfChildren() != 1 )
+    {
+      std::cerr << "Wrong number of trees: " << rootNode->GetNumberOfChildren() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    std::vector<const BranchNodeType *> branches;
+    branches.push_back( dynamic_cast<const BranchNodeType*>( rootNode->GetChild(0) ) );
+    
+    const BifurcationNodeType *bifurcation = ( branches[0] && branches[0]->GetNumberOfChildren() == 1 ) ?
+      dynamic_cast<const BifurcationNodeType*>( branches[0]->GetChild(0) ) : 0;
+    
+    if( !bifurcation || bifurcation->GetNumberOfChildren() != 2 )
+    {
+      std::cerr << "No bifurcation after the first branch" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    branches.push_back( dynamic_cast<const BranchNodeType*>( bifurcation->GetChild(0) ) );
+    branches.push_back( dynamic_cast<const BranchNodeType*>( bifurcation->GetChild(1) ) );
+    
+    std::vector<ImageType::PointType> runCenters;
+    
+    for( unsigned int b=0; b < branches.size(); ++b )
+    {
+      const CenterlineType *centerline = branches[b] ? branches[b]->GetCenterline() : 0;
+      
+      if( !centerline || centerline->size() < 5 )
+      {
+        std::cerr << "Branch " << b << " too short" << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      for( unsigned int i=0; i < centerline->size(); ++i )
+      {
+        const VesselSectionType *section = centerline->at(i);
+        
+        // The ridge goes a bit past the ends of the axes, where the response decays
+        const bool isEnd = ( i < 2 || i + 2 >= centerline->size() );
+        
+        if( DistanceToAxes( section->GetCenter() ) > ( isEnd ? 2.5 : 1.0 ) )
+        {
+          std::cerr << "Section " << i << " of branch " << b << " off the axes: " 
+            << section->GetCenter() << std::endl;
+          return EXIT_FAILURE;
+        }
+        
+        if( std::fabs( section->GetNormal().GetNorm() - 1.0 ) > 1e-6 ||
+            std::fabs( section->GetRadius() - 1.5 * std::sqrt( 3.0 ) ) > 1e-4 || section->GetScale() != 1.5 )
+        {
+          std::cerr << "Wrong normal or radius at section " << i << " of branch " << b << std::endl;
+          return EXIT_FAILURE;
+        }
+        
+        // Normals are oriented along the branch
+        if( i > 0 )
+        {
+          const VesselSectionType::VectorType step = section->GetCenter() - centerline->at(i-1)->GetCenter();
+          
+          if( step * section->GetNormal() < 0.0 )
+          {
+            std::cerr << "Normal against the branch at section " << i << " of branch " << b << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+        
+        runCenters.push_back( section->GetCenter() );
+      }
+    }
+    
+    // Branches share the section of the bifurcation, which is near the junction of the axes
+    const CenterlineType *trunk = branches[0]->GetCenterline();
+    const ImageType::PointType bifurcationCenter = trunk->at( trunk->size() - 1 )->GetCenter();
+    
+    if( branches[1]->GetCenterline()->at(0)->GetCenter() != bifurcationCenter ||
+        branches[2]->GetCenterline()->at(0)->GetCenter() != bifurcationCenter )
+    {
+      std::cerr << "Branches not joined at the bifurcation" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    ImageType::PointType junction;
+    junction[0] = 20.0;  junction[1] = 20.3;  junction[2] = 20.2;
+    
+    if( bifurcationCenter.EuclideanDistanceTo( junction ) > 1.5 )
+    {
+      std::cerr << "Bifurcation far from the junction: " << bifurcationCenter << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The same tree for any number of threads
+    if( run == 0 )
+    {
+      centers = runCenters;
+    }
+    else if( runCenters != centers )
+    {
+      std::cerr << "Different trees with one and four threads" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanStudyPipelineTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: checks that the study pipeline keeps the thread, concurrency and memory limits of its
+//   stages, and that a failed study skips the remaining stages.
+// Date: 2012/11/05
+
+#include "ivanStudyPipeline.h"
+
+#include "itkRealTimeClock.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkMacro.h"
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+
+typedef ivan::StudyPipeline   PipelineType;
+
+const unsigned int NumberOfThreads = 4;
+const unsigned int NumberOfStudies = 12;
+const unsigned long StudyMemory = 100;
+const unsigned long MemoryBudget = 250;
+
+
+/** Concurrency seen by the stages. */
+struct StageMonitor
+{
+  itk::SimpleFastMutexLock  Mutex;
+  unsigned int              BusyThreads;
+  unsigned int              PeakBusyThreads;
+  unsigned int              StudiesInFlight;
+  unsigned int              PeakStudiesInFlight;
+  unsigned int              NumberOfExports;
+  
+  StageMonitor() : BusyThreads( 0 ), PeakBusyThreads( 0 ), StudiesInFlight( 0 ),
+    PeakStudiesInFlight( 0 ), NumberOfExports( 0 ) {}
+};
+
+
+/** Stage that works for a while, recording its concurrency. */
+class TestStage : public PipelineType::Stage
+{
+public:
+
+  typedef TestStage                       Self;
+  typedef PipelineType::Stage             Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  void SetMonitor( StageMonitor *monitor )
+    { m_Monitor = monitor; }
+  
+  void SetFirst( bool first )
+    { m_First = first; }
+  
+  void SetLast( bool last )
+    { m_Last = last; }
+  
+  unsigned int GetPeakConcurrency() const
+    { return m_PeakConcurrency; }
+  
+  virtual void Process( PipelineType::Study *study )
+    {
+      m_Monitor->Mutex.Lock();
+      ++m_Concurrency;
+      m_PeakConcurrency = vnl_math_max( m_PeakConcurrency, m_Concurrency );
+      m_Monitor->BusyThreads += this->GetNumberOfThreads();
+      m_Monitor->PeakBusyThreads = vnl_math_max( m_Monitor->PeakBusyThreads, m_Monitor->BusyThreads );
+  
+      if( m_First )
+      {
+        ++m_Monitor->StudiesInFlight;
+        m_Monitor->PeakStudiesInFlight =
+          vnl_math_max( m_Monitor->PeakStudiesInFlight, m_Monitor->StudiesInFlight );
+      }
+  
+      m_Monitor->Mutex.Unlock();
+  
+      // Stands for the filters of the stage
+      itk::RealTimeClock::Pointer clock = itk::RealTimeClock::New();
+      const double start = clock->GetTimeStamp();
+  
+      while( clock->GetTimeStamp() - start < 0.002 )
+        ;
+  
+      const bool broken = ( std::string( study->GetName() ) == "Broken" ) && !m_First && !m_Last;
+  
+      m_Monitor->Mutex.Lock();
+      --m_Concurrency;
+      m_Monitor->BusyThreads -= this->GetNumberOfThreads();
+  
+      if( m_Last || broken )
+        --m_Monitor->StudiesInFlight;
+  
+      if( m_Last )
+        ++m_Monitor->NumberOfExports;
+  
+      m_Monitor->Mutex.Unlock();
+  
+      if( broken )
+        itkGenericExceptionMacro( << "Broken study" );
+    }
+
+protected:
+
+  TestStage() : m_Monitor( 0 ), m_First( false ), m_Last( false ), m_Concurrency( 0 ),
+    m_PeakConcurrency( 0 ) {}
+
+private:
+
+  StageMonitor   *m_Monitor;
+  bool            m_First;
+  bool            m_Last;
+  unsigned int    m_Concurrency;
+  unsigned int    m_PeakConcurrency;
+};
+
+
+int main( int, char ** )
+{
+  StageMonitor monitor;
+  
+  TestStage::Pointer readStage = TestStage::New();
+  readStage->SetName( "Read" );
+  readStage->SetMaximumConcurrency( 1 );
+  readStage->SetMonitor( &monitor );
+  readStage->SetFirst( true );
+  
+  TestStage::Pointer detectStage = TestStage::New();
+  detectStage->SetName( "Detect" );
+  detectStage->SetNumberOfThreads( 3 );
+  detectStage->SetMonitor( &monitor );
+  
+  TestStage::Pointer exportStage = TestStage::New();
+  exportStage->SetName( "Export" );
+  exportStage->SetMonitor( &monitor );
+  exportStage->SetLast( true );
+  
+  PipelineType::Pointer pipeline = PipelineType::New();
+  pipeline->AddStage( readStage );
+  pipeline->AddStage( detectStage );
+  pipeline->AddStage( exportStage );
+  pipeline->SetNumberOfThreads( NumberOfThreads );
+  pipeline->SetMemoryBudget( MemoryBudget );
+  pipeline->SetMaximumNumberOfQueuedStudies( 2 );
+  
+  std::vector<PipelineType::Study::Pointer> studies;
+  
+  for( unsigned int i=0; i<NumberOfStudies; ++i )
+  {
+    PipelineType::Study::Pointer study = PipelineType::Study::New();
+  
+    std::ostringstream name;
+    name << "Study" << i;
+    study->SetName( ( i == 5 ) ? std::string( "Broken" ) : name.str() );
+    study->SetMemoryEstimate( StudyMemory );
+  
+    pipeline->Submit( study );
+    studies.push_back( study );
+  }
+  
+  pipeline->Wait();
+  
+  std::cout << "Finished: " << pipeline->GetNumberOfFinishedStudies()
+            << ", failed: " << pipeline->GetNumberOfFailedStudies()
+            << ", peak threads: " << pipeline->GetPeakNumberOfBusyThreads()
+            << ", peak memory: " << pipeline->GetPeakReservedMemory()
+            << ", peak studies in flight: " << monitor.PeakStudiesInFlight << std::endl;
+  
+  if( pipeline->GetNumberOfFinishedStudies() != NumberOfStudies ||
+      pipeline->GetNumberOfFailedStudies() != 1 || monitor.NumberOfExports != NumberOfStudies - 1 )
+  {
+    std::cerr << "Wrong number of studies" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The thread pool, the concurrency of the stages and the memory budget are kept
+  if( monitor.PeakBusyThreads > NumberOfThreads || pipeline->GetPeakNumberOfBusyThreads() > NumberOfThreads ||
+      readStage->GetPeakConcurrency() > 1 || detectStage->GetPeakConcurrency() > 1 ||
+      pipeline->GetPeakReservedMemory() > MemoryBudget ||
+      monitor.PeakStudiesInFlight > MemoryBudget / StudyMemory || pipeline->GetReservedMemory() != 0 )
+  {
+    std::cerr << "Limits exceeded" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<NumberOfStudies; ++i )
+  {
+    const bool broken = ( i == 5 );
+  
+    if( studies[i]->GetFailed() != broken ||
+        studies[i]->GetNumberOfCompletedStages() != ( broken ? 1u : 3u ) ||
+        studies[i]->GetLatency() < studies[i]->GetQueueTime() )
+    {
+      std::cerr << "Wrong study " << studies[i]->GetName() << ": "
+                << studies[i]->GetErrorDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A study larger than the budget runs alone
+  PipelineType::Study::Pointer largeStudy = PipelineType::Study::New();
+  largeStudy->SetName( "Large" );
+  largeStudy->SetMemoryEstimate( 2 * MemoryBudget );
+  pipeline->Submit( largeStudy );
+  pipeline->Stop();
+  
+  if( largeStudy->GetNumberOfCompletedStages() != 3 || largeStudy->GetFailed() )
+  {
+    std::cerr << "The large study was not processed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
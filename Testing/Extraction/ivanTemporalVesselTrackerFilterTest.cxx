@@ -0,0 +1,221 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanTemporalVesselTrackerFilterTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests the TemporalVesselTrackerFilter class. A synthetic tube is tracked in a 
+//   first phase and then displaced one pixel in the second one. The branch tracked in the 
+//   second phase from the first one must follow the displaced tube.
+
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanTemporalVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::MultiSeedVesselTrackerFilter
+  <ImageType, VesselGraphType>                          MultiSeedTrackerType;
+typedef ivan::TemporalVesselTrackerFilter
+  <ImageType, VesselGraphType>                          TemporalTrackerType;
+typedef MultiSeedTrackerType::TrackerType               VesselTrackerType;
+typedef MultiSeedTrackerType::TrackerFactoryType        TrackerFactoryBaseType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+
+
+// Creates a tracker with its own estimator and end condition for each seed
+class TrackerFactory : public TrackerFactoryBaseType
+{
+public:
+
+  typedef TrackerFactory                  Self;
+  typedef TrackerFactoryBaseType          Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual Superclass::TrackerPointer CreateTracker( unsigned int )
+    {
+      Superclass::TrackerPointer tracker = VesselTrackerType::New();
+      
+      SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+      sectionEstimator->SetImage( m_Image );
+      sectionEstimator->SetScale( 2.0 );
+      tracker->SetSectionEstimator( sectionEstimator );
+      
+      EndConditionType::Pointer endCondition = EndConditionType::New();
+      endCondition->SetMaxIterations( 20 );
+      tracker->SetEndCondition( endCondition.GetPointer() );
+      
+      return tracker;
+    }
+
+  ImageType::Pointer  m_Image;
+};
+
+
+// Tube of sigma 2 along x, centered at the given y and z
+ImageType::Pointer CreateTubeImage( double centerY, double centerZ )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 48 );
+  region.SetSize( 1, 24 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dy = index[1] - centerY;
+    const double dz = index[2] - centerZ;
+    
+    it.Set( 1000.0 * std::exp( -( dy * dy + dz * dz ) / 8.0 ) );
+  }
+  
+  return image;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer previousImage = CreateTubeImage( 12.0, 12.0 );
+  ImageType::Pointer currentImage = CreateTubeImage( 13.0, 12.0 );
+  
+  // Track the first phase from a single seed
+  
+  TrackerFactory::Pointer previousFactory = TrackerFactory::New();
+  previousFactory->m_Image = previousImage;
+  
+  ImageType::PointType seed;
+  seed[0] = 10.0;  seed[1] = 12.0;  seed[2] = 12.0;
+  
+  MultiSeedTrackerType::Pointer previousTracker = MultiSeedTrackerType::New();
+  previousTracker->SetInput( previousImage );
+  previousTracker->SetTrackerFactory( previousFactory );
+  previousTracker->AddSeed( seed );
+  previousTracker->SetNumberOfThreads( 1 );
+  
+  // Track the second phase from the first one
+  
+  TrackerFactory::Pointer currentFactory = TrackerFactory::New();
+  currentFactory->m_Image = currentImage;
+  
+  TemporalTrackerType::Pointer temporalTracker = TemporalTrackerType::New();
+  temporalTracker->SetInput( currentImage );
+  temporalTracker->SetTrackerFactory( currentFactory );
+  temporalTracker->SetRegistrationRadius( 2.0 );
+  temporalTracker->SetCorridorDistance( 2.0 );
+  temporalTracker->SetNumberOfThreads( 1 );
+  
+  try
+  {
+    previousTracker->Update();
+    
+    temporalTracker->SetPreviousVesselGraph( previousTracker->GetOutput() );
+    temporalTracker->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  VesselGraphType::Pointer graph = temporalTracker->GetOutput();
+  
+  if( temporalTracker->GetNumberOfPriorBranches() != 1 || 
+      graph->GetRootNode()->GetNumberOfChildren() != 1 )
+  {
+    std::cerr << "Expected one branch, got " << temporalTracker->GetNumberOfPriorBranches() 
+      << " prior and " << graph->GetRootNode()->GetNumberOfChildren() << " tracked" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The translation along the tube is not observable, only check the other components
+  const TemporalTrackerType::DisplacementType & displacement = 
+    temporalTracker->GetBranchDisplacement(0);
+  
+  std::cout << "Displacement: " << displacement << std::endl;
+  
+  if( std::fabs( displacement[1] - 1.0 ) > 0.5 || std::fabs( displacement[2] ) > 0.5 )
+  {
+    std::cerr << "Wrong displacement" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( graph->GetRootNode()->GetChild(0) );
+  
+  if( !branch || branch->GetCenterline()->size() < 2 )
+  {
+    std::cerr << "Wrong tracked branch" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i < branch->GetCenterline()->size(); ++i )
+  {
+    const VesselSectionType::PointType & center = branch->GetCenterline()->at(i)->GetCenter();
+    
+    if( std::fabs( center[1] - 13.0 ) > 0.5 || std::fabs( center[2] - 12.0 ) > 0.5 )
+    {
+      std::cerr << "Section " << i << " at " << center << " is outside the displaced tube" 
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  std::cout << "Tracked " << branch->GetCenterline()->size() << " sections" << std::endl;
+  
+  return EXIT_SUCCESS;
+}
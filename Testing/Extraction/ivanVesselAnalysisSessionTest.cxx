@@ -0,0 +1,181 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselAnalysisSessionTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the lazily built and memory budgeted data of an analysis session.
+
+#include "ivanVesselAnalysisSession.h"
+#include "ivanDiscreteHessianGaussianImageFunction.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int argc, char ** argv )
+{
+  typedef itk::Image<float,3>                         ImageType;
+  typedef ivan::CircularVesselSection<3>              SectionType;
+  typedef ivan::VesselCenterline
+    <unsigned int, SectionType>                       CenterlineType;
+  
+  typedef ivan::VesselAnalysisSession<ImageType,CenterlineType>   SessionType;
+  typedef ivan::DiscreteHessianGaussianImageFunction<ImageType>   HessianFunctionType;
+  
+  // Synthetic bright tube along z
+  ImageType::SizeType size;
+  size.Fill( 20 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetBufferedRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 10.0;
+    const double dy = it.GetIndex()[1] - 10.0;
+    it.Set( 100.0 * std::exp( -0.5 * ( dx * dx + dy * dy ) / 4.0 ) );
+  }
+  
+  SessionType::Pointer session = SessionType::New();
+  session->SetImage( image );
+  
+  try
+  {
+    // Repeated requests get the same derivative image
+    SessionType::HessianImageConstPointer hessian1 = session->GetHessianImage( 1.0 );
+    SessionType::HessianImageConstPointer hessian1Again = session->GetHessianImage( 1.0 );
+    
+    if( hessian1 != hessian1Again || session->GetNumberOfHits() != 1 || session->GetNumberOfMisses() != 1 )
+    {
+      std::cerr << "Hessian image was computed again" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const unsigned long hessianSize = size[0] * size[1] * size[2] * sizeof( SessionType::HessianImageType::PixelType );
+    
+    if( session->GetMemorySize() != hessianSize )
+    {
+      std::cerr << "Memory size is " << session->GetMemorySize() << ", expected " << hessianSize << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // With a budget of one Hessian image the least recently used one is released
+    session->SetMemoryBudget( hessianSize );
+    session->GetHessianImage( 2.0 );
+    
+    if( session->GetNumberOfDerivativeImages() != 1 || session->GetMemorySize() > hessianSize )
+    {
+      std::cerr << "Memory budget not met, " << session->GetNumberOfDerivativeImages() << " images use "
+        << session->GetMemorySize() << " bytes" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The evicted image is still valid for the request that holds it
+    if( hessian1->GetBufferedRegion() != image->GetBufferedRegion() )
+    {
+      std::cerr << "Evicted image was released while in use" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    session->SetMemoryBudget( 0 );
+    session->GetGradientImage( 2.0 );
+    
+    if( session->GetNumberOfDerivativeImages() != 2 )
+    {
+      std::cerr << "Gradient image not kept" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Shared objects are created once by name, and their type is checked
+    typedef ivan::ScaledImageFunctionCache<HessianFunctionType>   FunctionCacheType;
+    
+    FunctionCacheType *functionCache = session->GetScaledImageFunctionCache<HessianFunctionType>();
+    
+    if( !functionCache || functionCache != session->GetScaledImageFunctionCache<HessianFunctionType>() )
+    {
+      std::cerr << "Scaled image function cache is not shared" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    typedef HessianFunctionType::DerivativeCacheType   DerivativeCacheType;
+    
+    session->GetSharedObject<DerivativeCacheType>( "HessianValues" );
+    
+    bool caught = false;
+    
+    try
+    {
+      session->GetSharedObject<FunctionCacheType>( "HessianValues" );
+    }
+    catch( itk::ExceptionObject & )
+    {
+      caught = true;
+    }
+    
+    if( !caught || session->GetNumberOfSharedObjects() != 2 )
+    {
+      std::cerr << "Shared object of the wrong type was returned" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The pyramid and the spatial index are created once
+    if( session->GetPyramid() != session->GetPyramid() || session->GetPyramid()->GetInput() != image ||
+      session->GetSpatialIndex() != session->GetSpatialIndex() || !session->GetSpatialIndexMutex() )
+    {
+      std::cerr << "Pyramid or spatial index not kept" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Another image releases everything
+    ImageType::Pointer otherImage = ImageType::New();
+    otherImage->SetRegions( size );
+    otherImage->Allocate();
+    otherImage->FillBuffer( 0.0 );
+    
+    session->SetImage( otherImage );
+    
+    if( session->GetNumberOfDerivativeImages() || session->GetNumberOfSharedObjects() || 
+      session->GetMemorySize() || session->GetNumberOfMisses() )
+    {
+      std::cerr << "Data of the previous image was kept" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,319 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselSectionEstimatorComputeAllTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: estimates the sections of a centerline on a curved tube with ComputeAll() and 
+//   ComputeRange() from 1 to several threads, and checks that they are the same as those of a 
+//   serial Compute(). FixedScaleHessianBasedVesselSectionEstimator distributes the sections among
+//   the threads, and MultiscaleAdaptiveOOFBasedVesselSectionEstimator, which does not support it,
+//   falls back to Compute().
+
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselCenterline.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                                       FixedScaleEstimatorType;
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>     GradientFunctionType;
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>    VesselnessFunctionType;
+
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <VesselnessFunctionType,ImageType>                               VesselnessFunctionInitializerType;
+
+typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+  <ImageType,VesselnessFunctionType,GradientFunctionType,CenterlineType>  AdaptiveEstimatorType;
+
+
+const unsigned int NumberOfSections = 15;
+
+
+// Center of the tube at the given z. The tube bends in x so the normals change along it
+void GetTubeCenter( double z, double & x, double & y )
+{
+  x = 24.0 + 4.0 * std::sin( vnl_math::pi * z / 24.0 );
+  y = 24.0;
+}
+
+
+// Gaussian tube of sigma 2.5
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 48 );
+  region.SetSize( 1, 48 );
+  region.SetSize( 2, 48 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    double x, y;
+    GetTubeCenter( index[2], x, y );
+    
+    const double dx = index[0] - x;
+    const double dy = index[1] - y;
+    
+    it.Set( 1000.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * 2.5 * 2.5 ) ) );
+  }
+  
+  return image;
+}
+
+
+// Sections along the tube, slightly off its axis as the centers of a tracked centerline
+CenterlineType::Pointer CreateCenterline()
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  centerline->reserve( NumberOfSections );
+  
+  for( unsigned int i=0; i<NumberOfSections; ++i )
+  {
+    VesselSectionType::PointType center;
+    center[2] = 5.0 + 2.5 * i;
+    
+    double x, y;
+    GetTubeCenter( center[2], x, y );
+    
+    center[0] = x + 0.4 * ( (int)( i % 3 ) - 1 );
+    center[1] = y + ( ( i % 2 ) ? 0.3 : -0.3 );
+    
+    VesselSectionType::VectorType normal;
+    normal.Fill( 0.0 );
+    normal[2] = 1.0;
+    
+    VesselSectionType::Pointer section = VesselSectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( 0.0 );
+    section->SetScale( 0.0 );
+    
+    centerline->push_back( section );
+  }
+  
+  return centerline;
+}
+
+
+bool CompareCenterlines( const CenterlineType *reference, const CenterlineType *centerline, 
+  const char *label )
+{
+  for( unsigned int i=0; i<NumberOfSections; ++i )
+  {
+    const VesselSectionType *referenceSection = reference->at(i);
+    const VesselSectionType *section = centerline->at(i);
+    
+    double normalDifference = 0.0;
+    
+    for( unsigned int dim=0; dim < Dimension; ++dim )
+    {
+      normalDifference = std::max( normalDifference, 
+        std::abs( referenceSection->GetNormal()[dim] - section->GetNormal()[dim] ) );
+    }
+    
+    if( normalDifference > 1e-9 || 
+      std::abs( referenceSection->GetRadius() - section->GetRadius() ) > 1e-9 ||
+      std::abs( referenceSection->GetScale() - section->GetScale() ) > 1e-9 )
+    {
+      std::cerr << label << ": section " << i << " has normal " << section->GetNormal() 
+        << " radius " << section->GetRadius() << " scale " << section->GetScale() 
+        << " instead of " << referenceSection->GetNormal() << " radius " 
+        << referenceSection->GetRadius() << " scale " << referenceSection->GetScale() << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+FixedScaleEstimatorType::Pointer CreateFixedScaleEstimator( ImageType *image )
+{
+  FixedScaleEstimatorType::Pointer estimator = FixedScaleEstimatorType::New();
+  estimator->SetImage( image );
+  estimator->SetScale( 2.5 );
+  
+  return estimator;
+}
+
+
+AdaptiveEstimatorType::Pointer CreateAdaptiveEstimator( ImageType *image )
+{
+  VesselnessFunctionInitializerType::Pointer initializer = VesselnessFunctionInitializerType::New();
+  
+  AdaptiveEstimatorType::Pointer estimator = AdaptiveEstimatorType::New();
+  estimator->SetImage( image );
+  estimator->SetMetricFunctionInitializer( initializer );
+  estimator->SetScaleStepMethod( AdaptiveEstimatorType::EquispacedScaleSteps );
+  estimator->SetNumberOfScales( 5 );
+  estimator->SetMinimumScale( 1.0 );
+  estimator->SetMaximumScale( 5.0 );
+  estimator->Initialize();
+  
+  return estimator;
+}
+
+
+// Serial estimation of the given range, with the same convention of the null range as Compute()
+template <class TEstimator>
+CenterlineType::Pointer ComputeSerially( TEstimator *estimator, unsigned int first, unsigned int last )
+{
+  CenterlineType::Pointer centerline = CreateCenterline();
+  
+  estimator->SetCenterline( centerline );
+  estimator->SetSectionRange( first, last );
+  estimator->Compute();
+  
+  return centerline;
+}
+
+
+template <class TEstimator>
+bool CheckComputedRange( TEstimator *estimator, unsigned int numberOfSections, const char *label )
+{
+  if( estimator->GetInterrupted() || estimator->GetNumberOfComputedSections() != numberOfSections )
+  {
+    std::cerr << label << ": " << estimator->GetNumberOfComputedSections() << " sections computed"
+      << " instead of " << numberOfSections << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  try
+  {
+    // Sections distributed among the threads. The same estimator is reused for every number of
+    // threads, so the copies of the Hessian function of the threads are created again
+    
+    CenterlineType::Pointer reference = 
+      ComputeSerially( CreateFixedScaleEstimator( image ).GetPointer(), 0, NumberOfSections - 1 );
+    
+    for( unsigned int i=0; i<NumberOfSections; ++i )
+    {
+      if( reference->at(i)->GetNormal().GetNorm() < 0.99 || reference->at(i)->GetRadius() <= 0.0 )
+      {
+        std::cerr << "Serial section " << i << " was not estimated" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    FixedScaleEstimatorType::Pointer fixedScaleEstimator = CreateFixedScaleEstimator( image );
+    
+    // The last number of threads is larger than the number of sections
+    const unsigned int numberOfThreads[] = { 1, 2, 3, 4, 20 };
+    
+    for( unsigned int t=0; t < sizeof( numberOfThreads ) / sizeof( unsigned int ); ++t )
+    {
+      CenterlineType::Pointer centerline = CreateCenterline();
+      
+      fixedScaleEstimator->SetCenterline( centerline );
+      fixedScaleEstimator->SetNumberOfThreads( numberOfThreads[t] );
+      fixedScaleEstimator->ComputeAll();
+      
+      std::cout << "FixedScale ComputeAll() with " << numberOfThreads[t] << " threads" << std::endl;
+      
+      if( !CheckComputedRange( fixedScaleEstimator.GetPointer(), NumberOfSections, "FixedScale ComputeAll()" ) ||
+        !CompareCenterlines( reference, centerline, "FixedScale ComputeAll()" ) )
+        return EXIT_FAILURE;
+    }
+    
+    // Part of the centerline. The sections outside the range keep their initial values, and the
+    // first one of the range keeps the sign of the normal of the previous section
+    
+    CenterlineType::Pointer rangeReference = 
+      ComputeSerially( CreateFixedScaleEstimator( image ).GetPointer(), 3, 9 );
+    CenterlineType::Pointer rangeCenterline = CreateCenterline();
+    
+    fixedScaleEstimator->SetCenterline( rangeCenterline );
+    fixedScaleEstimator->SetNumberOfThreads( 3 );
+    fixedScaleEstimator->ComputeRange( 3, 9 );
+    
+    if( !CheckComputedRange( fixedScaleEstimator.GetPointer(), 7, "FixedScale ComputeRange()" ) ||
+      !CompareCenterlines( rangeReference, rangeCenterline, "FixedScale ComputeRange()" ) )
+      return EXIT_FAILURE;
+    
+    // The scale search of the adaptive estimator depends on the previous section, so it falls 
+    // back to Compute() whatever the number of threads. Each run needs its own estimator since the
+    // scale search keeps state across sections
+    
+    CenterlineType::Pointer adaptiveReference = 
+      ComputeSerially( CreateAdaptiveEstimator( image ).GetPointer(), 0, NumberOfSections - 1 );
+    
+    AdaptiveEstimatorType::Pointer adaptiveEstimator = CreateAdaptiveEstimator( image );
+    CenterlineType::Pointer adaptiveCenterline = CreateCenterline();
+    
+    adaptiveEstimator->SetCenterline( adaptiveCenterline );
+    adaptiveEstimator->SetNumberOfThreads( 4 );
+    adaptiveEstimator->ComputeAll();
+    
+    if( !CheckComputedRange( adaptiveEstimator.GetPointer(), NumberOfSections, "Adaptive ComputeAll()" ) ||
+      !CompareCenterlines( adaptiveReference, adaptiveCenterline, "Adaptive ComputeAll()" ) )
+      return EXIT_FAILURE;
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselSeedDetectorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the VesselSeedDetector class on two synthetic vessels of different scales.
+//   Seeds must be at the maxima of the response, ranked, and outside the existing vessels.
+
+#include "ivanVesselSeedDetector.h"
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                               ImageType;
+
+typedef ivan::CircularVesselSection<3>                    VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>                       CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>                 VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>            BranchNodeType;
+
+typedef ivan::VesselSeedDetector<ImageType, CenterlineType>   SeedDetectorType;
+
+typedef SeedDetectorType::ScaleImageType                  ScaleImageType;
+typedef SeedDetectorType::NormalImageType                 NormalImageType;
+
+
+int main( int, char ** )
+{
+  // Two vessels along x in a 40x40x20 image, a thin one of scale 1 at y=10 and a wide one of 
+  // scale 6 at y=28, whose response peaks every 10 pixels from x=5
+  ImageType::RegionType region;
+  region.SetSize( 0, 40 );
+  region.SetSize( 1, 40 );
+  region.SetSize( 2, 20 );
+  
+  ImageType::Pointer vesselness = ImageType::New();
+  vesselness->SetRegions( region );
+  vesselness->Allocate();
+  
+  ScaleImageType::Pointer scales = ScaleImageType::New();
+  scales->SetRegions( region );
+  scales->Allocate();
+  
+  NormalImageType::Pointer normals = NormalImageType::New();
+  normals->SetRegions( region );
+  normals->Allocate();
+  
+  NormalImageType::PixelType direction;
+  direction[0] = 2.0;  direction[1] = 0.0;  direction[2] = 0.0;
+  normals->FillBuffer( direction );
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( vesselness, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double modulation = 0.8 + 0.2 * std::cos( 2.0 * vnl_math::pi * ( index[0] - 5.0 ) / 10.0 );
+    const double dz = index[2] - 10.0;
+    const double thinDistance2 = ( index[1] - 10.0 ) * ( index[1] - 10.0 ) + dz * dz;
+    const double wideDistance2 = ( index[1] - 28.0 ) * ( index[1] - 28.0 ) + dz * dz;
+    
+    it.Set( modulation * std::max( 0.5 * std::exp( -thinDistance2 / 2.0 ), 
+      std::exp( -wideDistance2 / ( 2.0 * 36.0 ) ) ) );
+    scales->SetPixel( index, ( index[1] < 19 ) ? 1.0 : 6.0 );
+  }
+  
+  SeedDetectorType::Pointer detector = SeedDetectorType::New();
+  detector->SetInput( vesselness );
+  detector->SetScaleImage( scales );
+  detector->SetNormalImage( normals );
+  detector->SetLowerThreshold( 0.2 );
+  detector->SetNumberOfThreads( 1 );
+  
+  SeedDetectorType::PointContainerType serialSeeds;
+  
+  for( unsigned int run=0; run < 2; ++run )
+  {
+    // The second run uses several threads and smaller tiles
+    if( run == 1 )
+    {
+      detector->SetNumberOfThreads( 4 );
+      detector->SetTileSize( 8 );
+    }
+    
+    try
+    {
+      detector->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const SeedDetectorType::SeedContainerType & seeds = detector->GetSeeds();
+    
+    std::cout << "Threads: " << detector->GetNumberOfThreads() << ", candidates: " 
+      << detector->GetNumberOfCandidates() << ", seeds: " << seeds.size() << std::endl;
+    
+    // One seed in the wide vessel, whose window covers the other maxima, and four in the thin one
+    if( seeds.size() != 5 )
+    {
+      std::cerr << "Wrong number of seeds" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i < seeds.size(); ++i )
+    {
+      const double expectedX = ( i == 0 ) ? 5.0 : 5.0 + 10.0 * ( i - 1 );
+      const double expectedY = ( i == 0 ) ? 28.0 : 10.0;
+      const double expectedScale = ( i == 0 ) ? 6.0 : 1.0;
+      
+      if( seeds[i].Point[0] != expectedX || seeds[i].Point[1] != expectedY || seeds[i].Point[2] != 10.0 ||
+          seeds[i].Scale != expectedScale )
+      {
+        std::cerr << "Wrong seed " << i << ": " << seeds[i].Point << ", scale " << seeds[i].Scale << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      if( seeds[i].Direction[0] != 1.0 || seeds[i].Direction[1] != 0.0 || seeds[i].Direction[2] != 0.0 )
+      {
+        std::cerr << "Wrong direction of seed " << i << ": " << seeds[i].Direction << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      if( i > 0 && seeds[i].Response > seeds[i-1].Response )
+      {
+        std::cerr << "Seeds not ranked by response" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // The same seeds for any number of threads
+    if( run == 0 )
+    {
+      serialSeeds = detector->GetSeedPoints();
+    }
+    else if( detector->GetSeedPoints() != serialSeeds )
+    {
+      std::cerr << "Different seeds with one and four threads" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Limit the number of seeds
+  detector->SetMaximumNumberOfSeeds( 2 );
+  detector->Update();
+  
+  if( detector->GetSeeds().size() != 2 || detector->GetSeeds()[1].Point[1] != 10.0 )
+  {
+    std::cerr << "Wrong seeds with a maximum of two" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Seeds inside vessels already tracked are discarded
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  
+  for( unsigned int i=0; i < 40; ++i )
+  {
+    VesselSectionType::Pointer section = VesselSectionType::New();
+    
+    VesselSectionType::PointType center;
+    center[0] = i;  center[1] = 10.0;  center[2] = 10.0;
+    section->SetCenter( center );
+    section->SetRadius( 2.0 );
+    
+    branch->GetCenterline()->push_back( section );
+  }
+  
+  VesselGraphType::Pointer existingVessels = VesselGraphType::New();
+  existingVessels->SetRootNode( branch );
+  
+  detector->SetMaximumNumberOfSeeds( 0 );
+  detector->SetExistingVessels( existingVessels );
+  detector->Update();
+  
+  if( detector->GetSeeds().size() != 1 || detector->GetSeeds()[0].Point[1] != 28.0 )
+  {
+    std::cerr << "Seeds not discarded by the existing vessels" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
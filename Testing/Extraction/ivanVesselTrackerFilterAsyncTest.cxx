@@ -0,0 +1,230 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTrackerFilterAsyncTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests the asynchronous tracking of VesselTrackerFilter. Tracking is cancelled
+//   while running, and a subclass tracker is released while tracking, whose stages must not 
+//   run once its destructor has started.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itksys/SystemTools.hxx"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::VesselTrackerFilter
+  <ImageType, VesselGraphType>                          VesselTrackerType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+
+
+// Set by the tracker below
+volatile unsigned int numberOfSearches = 0;
+volatile bool         trackerDestroyed = false;
+volatile bool         searchedAfterDestruction = false;
+
+
+/** Tracker with a slow Search() stage, which records whether it is called after the destructor 
+  * of the tracker has started. */
+class SlowVesselTrackerFilter : public VesselTrackerType
+{
+public:
+
+  typedef SlowVesselTrackerFilter         Self;
+  typedef VesselTrackerType               Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( SlowVesselTrackerFilter, VesselTrackerFilter );
+  
+protected:
+
+  SlowVesselTrackerFilter() {}
+  ~SlowVesselTrackerFilter()
+    {
+      this->StopTracking();
+      trackerDestroyed = true;
+    }
+  
+  virtual void Search()
+    {
+      if( trackerDestroyed )
+        searchedAfterDestruction = true;
+        
+      ++numberOfSearches;
+      itksys::SystemTools::Delay( 10 );
+    }
+};
+
+
+// Tube of sigma 2 along x, centered at y=z=12
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 96 );
+  region.SetSize( 1, 24 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dy = index[1] - 12.0;
+    const double dz = index[2] - 12.0;
+    
+    it.Set( 1000.0 * std::exp( -( dy * dy + dz * dz ) / 8.0 ) );
+  }
+  
+  return image;
+}
+
+
+SlowVesselTrackerFilter::Pointer CreateTracker( ImageType *image )
+{
+  SlowVesselTrackerFilter::Pointer tracker = SlowVesselTrackerFilter::New();
+  tracker->SetInput( image );
+  
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetScale( 2.0 );
+  tracker->SetSectionEstimator( sectionEstimator );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( 100000 );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  ImageType::PointType seed;
+  seed[0] = 48.0;  seed[1] = 12.0;  seed[2] = 12.0;
+  tracker->SetStartingPoint( seed );
+  
+  return tracker;
+}
+
+
+// Wait until the tracker has searched the given number of times
+void WaitForSearches( unsigned int searches )
+{
+  while( numberOfSearches < searches )
+    itksys::SystemTools::Delay( 1 );
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  // Cancel a running tracking
+  SlowVesselTrackerFilter::Pointer tracker = CreateTracker( image );
+  
+  try
+  {
+    tracker->StartTracking();
+    WaitForSearches( 3 );
+    
+    if( !tracker->IsTracking() )
+    {
+      std::cerr << "Tracking finished before being cancelled" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    tracker->CancelTracking();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const unsigned int cancelledSearches = numberOfSearches;
+  itksys::SystemTools::Delay( 50 );
+  
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( tracker->GetOutput()->GetRootNode().GetPointer() );
+  
+  if( tracker->IsTracking() || numberOfSearches != cancelledSearches || 
+      !branch || branch->GetCenterline()->empty() )
+  {
+    std::cerr << "Tracking not stopped by CancelTracking(), or sections lost" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Release a subclass tracker while it is tracking
+  tracker = CreateTracker( image );
+  numberOfSearches = 0;
+  trackerDestroyed = false;
+  
+  try
+  {
+    tracker->StartTracking();
+    WaitForSearches( 3 );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  tracker = 0;
+  
+  if( !trackerDestroyed || searchedAfterDestruction )
+  {
+    std::cerr << "Tracker stages called while the tracker was destroyed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
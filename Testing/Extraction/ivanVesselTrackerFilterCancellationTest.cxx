@@ -0,0 +1,295 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTrackerFilterCancellationTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests VesselTrackerFilter when its cancellation token stops the section estimator.
+//   The section the estimator was stopped on must be removed from the branch, so every section
+//   of an interrupted branch is estimated, while a branch cancelled after the section was 
+//   estimated keeps it.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+#include "ivanCancellationToken.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+#include <set>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::VesselTrackerFilter
+  <ImageType, VesselGraphType>                          VesselTrackerType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+
+
+/** Estimator which cancels its token when asked for the given section, either before estimating
+  * it, as an estimator interrupted in the middle of a section, or after. It records the sections
+  * it estimates. */
+class CancellingSectionEstimator : public SectionEstimatorType
+{
+public:
+
+  typedef CancellingSectionEstimator      Self;
+  typedef SectionEstimatorType            Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  
+  typedef std::set<const VesselSectionType*>    SectionSetType;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( CancellingSectionEstimator, FixedScaleHessianBasedVesselSectionEstimator );
+  
+  itkSetMacro( CancelAtCompute, unsigned int );
+  itkSetMacro( EstimateCancelledSection, bool );
+  
+  const SectionSetType & GetEstimatedSections() const
+    { return m_EstimatedSections; }
+  
+  const VesselSectionType * GetCancelledSection() const
+    { return m_CancelledSection; }
+  
+  virtual void Compute()
+    {
+      const VesselSectionType *section = this->GetCenterline()->at( this->m_SectionRange[0] );
+      const bool cancel = ( ++m_NumberOfComputes == m_CancelAtCompute );
+      
+      if( cancel )
+        m_CancelledSection = section;
+      
+      if( cancel && !m_EstimateCancelledSection )
+      {
+        this->GetCancellationToken()->Cancel();
+        this->m_Interrupted = true;
+        return;
+      }
+      
+      Superclass::Compute();
+      m_EstimatedSections.insert( section );
+      
+      if( cancel )
+        this->GetCancellationToken()->Cancel();
+    }
+  
+protected:
+
+  CancellingSectionEstimator() :
+    m_CancelAtCompute( 0 ),
+    m_EstimateCancelledSection( false ),
+    m_NumberOfComputes( 0 ),
+    m_CancelledSection( 0 ) {}
+  ~CancellingSectionEstimator() {}
+  
+  // Every section is estimated by Compute(), without speculation
+  virtual bool SupportsThreadedCompute() const
+    { return false; }
+  
+private:
+
+  unsigned int                m_CancelAtCompute;
+  bool                        m_EstimateCancelledSection;
+  unsigned int                m_NumberOfComputes;
+  const VesselSectionType *   m_CancelledSection;
+  SectionSetType              m_EstimatedSections;
+};
+
+
+// Tube of sigma 2 along x, centered at y=z=12
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 96 );
+  region.SetSize( 1, 24 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dy = index[1] - 12.0;
+    const double dz = index[2] - 12.0;
+    
+    it.Set( 1000.0 * std::exp( -( dy * dy + dz * dz ) / 8.0 ) );
+  }
+  
+  return image;
+}
+
+
+// Tracks the tube with the given section estimator, returns the tracked branch
+const BranchNodeType * Track( ImageType *image, CancellingSectionEstimator *sectionEstimator,
+  VesselTrackerType::Pointer & tracker )
+{
+  tracker = VesselTrackerType::New();
+  tracker->SetInput( image );
+  
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetScale( 2.0 );
+  tracker->SetSectionEstimator( sectionEstimator );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( 50 );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  ivan::CancellationToken::Pointer token = ivan::CancellationToken::New();
+  tracker->SetCancellationToken( token );
+  
+  ImageType::PointType seed;
+  seed[0] = 48.0;  seed[1] = 12.0;  seed[2] = 12.0;
+  tracker->SetStartingPoint( seed );
+  
+  tracker->Update();
+  
+  return dynamic_cast<const BranchNodeType*>( tracker->GetOutput()->GetRootNode().GetPointer() );
+}
+
+
+// Returns true if every section of the branch has been estimated
+bool AllSectionsEstimated( const BranchNodeType *branch, 
+  const CancellingSectionEstimator *sectionEstimator )
+{
+  const CenterlineType *centerline = branch->GetCenterline();
+  
+  for( unsigned int i=0; i<centerline->size(); ++i )
+  {
+    if( !sectionEstimator->GetEstimatedSections().count( centerline->at(i).GetPointer() ) )
+      return false;
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  const unsigned int cancelAtCompute = 5;
+  
+  VesselTrackerType::Pointer tracker;
+  
+  // Section estimator stopped before estimating the section
+  CancellingSectionEstimator::Pointer sectionEstimator = CancellingSectionEstimator::New();
+  sectionEstimator->SetCancelAtCompute( cancelAtCompute );
+  sectionEstimator->SetEstimateCancelledSection( false );
+  
+  const BranchNodeType *branch = 0;
+  
+  try
+  {
+    branch = Track( image, sectionEstimator, tracker );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !branch || !tracker->GetInterrupted() || !sectionEstimator->GetCancelledSection() )
+  {
+    std::cerr << "Tracking not interrupted by the section estimator" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const CenterlineType *centerline = branch->GetCenterline();
+  
+  if( centerline->size() != cancelAtCompute - 1 || 
+      !AllSectionsEstimated( branch, sectionEstimator ) )
+  {
+    std::cerr << "The interrupted branch has " << centerline->size() << " sections, expected " 
+      << cancelAtCompute - 1 << " estimated sections" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<centerline->size(); ++i )
+  {
+    if( centerline->at(i).GetPointer() == sectionEstimator->GetCancelledSection() )
+    {
+      std::cerr << "The section not estimated was kept in the branch" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A new section clears the interruption of the estimator
+  sectionEstimator->SetSection( 0 );
+  
+  if( sectionEstimator->GetInterrupted() )
+  {
+    std::cerr << "The estimator is still interrupted after setting a new section" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Cancelled after the section was estimated, which is kept
+  sectionEstimator = CancellingSectionEstimator::New();
+  sectionEstimator->SetCancelAtCompute( cancelAtCompute );
+  sectionEstimator->SetEstimateCancelledSection( true );
+  
+  try
+  {
+    branch = Track( image, sectionEstimator, tracker );
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !branch || !tracker->GetInterrupted() || branch->GetCenterline()->size() != cancelAtCompute ||
+      !AllSectionsEstimated( branch, sectionEstimator ) || 
+      branch->GetCenterline()->back().GetPointer() != sectionEstimator->GetCancelledSection() )
+  {
+    std::cerr << "The section estimated before cancelling was not kept" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTrackerFilterTrackingRegionTest.cxx
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: tests the input region requested by VesselTrackerFilter. A tube is tracked 
+//   through a pipeline requesting only the region around the starting point, which is grown 
+//   while tracking, and the centerline must be the same as when tracking the whole input.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkCastImageFilter.h"
+#include "itkCommand.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::VesselTrackerFilter
+  <ImageType, VesselGraphType>                          VesselTrackerType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+  
+typedef itk::CastImageFilter<ImageType,ImageType>       CastFilterType;
+
+
+unsigned int numberOfGrownRegions = 0;
+
+void OnTrackingRegionGrown( itk::Object *, const itk::EventObject &, void * )
+{
+  ++numberOfGrownRegions;
+}
+
+
+// Tube of sigma 2 along x, centered at y=z=12
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 96 );
+  region.SetSize( 1, 24 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dy = index[1] - 12.0;
+    const double dz = index[2] - 12.0;
+    
+    it.Set( 1000.0 * std::exp( -( dy * dy + dz * dz ) / 8.0 ) );
+  }
+  
+  return image;
+}
+
+
+// Tracker whose section estimator works on the given image
+VesselTrackerType::Pointer CreateTracker( ImageType *image, unsigned int maxIterations )
+{
+  VesselTrackerType::Pointer tracker = VesselTrackerType::New();
+  
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetScale( 2.0 );
+  tracker->SetSectionEstimator( sectionEstimator );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( maxIterations );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  ImageType::PointType seed;
+  seed[0] = 48.0;  seed[1] = 12.0;  seed[2] = 12.0;
+  tracker->SetStartingPoint( seed );
+  
+  return tracker;
+}
+
+
+const CenterlineType * GetCenterline( VesselTrackerType *tracker )
+{
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( tracker->GetOutput()->GetRootNode().GetPointer() );
+  
+  return branch ? branch->GetCenterline().GetPointer() : 0;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  // The section estimator reads the whole image, the tracker input only provides the region
+  CastFilterType::Pointer cast = CastFilterType::New();
+  cast->SetInput( image );
+  cast->InPlaceOff();
+  
+  VesselTrackerType::Pointer wholeTracker = CreateTracker( image, 30 );
+  wholeTracker->SetInput( image );
+  
+  VesselTrackerType::Pointer regionTracker = CreateTracker( image, 30 );
+  regionTracker->SetInput( cast->GetOutput() );
+  regionTracker->SetTrackingRegionRadius( 8.0 );
+  regionTracker->SetTrackingRegionMargin( 4.0 );
+  
+  itk::CStyleCommand::Pointer growCommand = itk::CStyleCommand::New();
+  growCommand->SetCallback( &OnTrackingRegionGrown );
+  regionTracker->AddObserver( ivan::TrackingRegionGrownEvent(), growCommand );
+  
+  try
+  {
+    wholeTracker->Update();
+    regionTracker->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const ImageType::RegionType & bufferedRegion = cast->GetOutput()->GetBufferedRegion();
+  
+  std::cout << "Buffered region: " << bufferedRegion << "Grown " 
+    << regionTracker->GetNumberOfRegionGrowths() << " times" << std::endl;
+  
+  // 30 steps from the middle of the tube leave the initial region along x
+  if( bufferedRegion == image->GetLargestPossibleRegion() || 
+      regionTracker->GetNumberOfRegionGrowths() == 0 ||
+      numberOfGrownRegions != regionTracker->GetNumberOfRegionGrowths() ||
+      regionTracker->GetReachedRegionBoundary() )
+  {
+    std::cerr << "Wrong tracking region" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const CenterlineType *wholeCenterline = GetCenterline( wholeTracker );
+  const CenterlineType *regionCenterline = GetCenterline( regionTracker );
+  
+  if( !wholeCenterline || !regionCenterline || 
+      wholeCenterline->size() != regionCenterline->size() )
+  {
+    std::cerr << "Different number of sections" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i < wholeCenterline->size(); ++i )
+  {
+    ImageType::PointType center;
+    
+    for( unsigned int dim=0; dim < Dimension; ++dim )
+    {
+      if( wholeCenterline->at(i)->GetCenter()[dim] != regionCenterline->at(i)->GetCenter()[dim] )
+      {
+        std::cerr << "Different section center at section " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      center[dim] = regionCenterline->at(i)->GetCenter()[dim];
+    }
+    
+    ImageType::IndexType index;
+    
+    if( !image->TransformPhysicalPointToIndex( center, index ) || !bufferedRegion.IsInside( index ) )
+    {
+      std::cerr << "Section " << i << " outside the buffered region" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Without updating the pipeline, tracking stops at the boundary of the buffered region
+  VesselTrackerType::Pointer boundaryTracker = CreateTracker( image, 80 );
+  boundaryTracker->SetInput( cast->GetOutput() );
+  boundaryTracker->SetTrackingRegionRadius( 8.0 );
+  boundaryTracker->SetTrackingRegionMargin( 4.0 );
+  
+  try
+  {
+    boundaryTracker->Track();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !boundaryTracker->GetReachedRegionBoundary() || 
+      boundaryTracker->GetNumberOfRegionGrowths() != 0 ||
+      cast->GetOutput()->GetBufferedRegion() != bufferedRegion )
+  {
+    std::cerr << "Tracking did not stop at the buffered region" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
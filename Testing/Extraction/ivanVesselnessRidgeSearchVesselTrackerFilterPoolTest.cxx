@@ -0,0 +1,235 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselnessRidgeSearchVesselTrackerFilterPoolTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks a tube with the multiscale ridge search tracker with and without the pool
+//   of vesselness functions, and checks that the centerlines are the same. The components are 
+//   those of ivanMultiscaleVesselnessRidgeSearchVesselTrackerFilterTest2.cxx.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselnessRidgeSearchVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>     GradientFunctionType;
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>    VesselnessFunctionType;
+
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <VesselnessFunctionType,ImageType>                               VesselnessFunctionInitializerType;
+
+typedef ivan::VesselnessRidgeSearchVesselTrackerFilter
+  <ImageType, VesselGraphType, VesselnessFunctionType>             VesselTrackerType;
+
+typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+  <ImageType,VesselnessFunctionType,GradientFunctionType,CenterlineType>  SectionEstimatorType;
+
+
+enum PoolModeType { NoPool, Pool, EstimatorPool };
+
+
+// Tube along x, centered at y=z=16, with a radius growing from 2 to 4 so several scales are used
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 64 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 32 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double radius = 2.0 + 2.0 * index[0] / 63.0;
+    const double dy = index[1] - 16.0;
+    const double dz = index[2] - 16.0;
+    
+    it.Set( ( dy * dy + dz * dz <= radius * radius ) ? 1000.0 : 0.0 );
+  }
+  
+  return image;
+}
+
+
+VesselTrackerType::Pointer CreateTracker( ImageType *image, PoolModeType poolMode )
+{
+  VesselTrackerType::Pointer tracker = VesselTrackerType::New();
+  tracker->SetInput( image );
+  
+  VesselnessFunctionInitializerType::Pointer initializer = VesselnessFunctionInitializerType::New();
+  tracker->SetVesselnessFunctionInitializer( initializer );
+  
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetMetricFunctionInitializer( initializer );
+  sectionEstimator->SetScaleStepMethod( SectionEstimatorType::EquispacedScaleSteps );
+  sectionEstimator->SetNumberOfScales( 5 );
+  sectionEstimator->SetMinimumScale( 1.0 );
+  sectionEstimator->SetMaximumScale( 5.0 );
+  sectionEstimator->Initialize();
+  
+  tracker->SetSectionEstimator( sectionEstimator );
+  
+  if( poolMode != NoPool )
+    tracker->UseVesselnessFunctionPoolOn();
+  
+  // The metric functions of the estimator are the vesselness of its scales
+  if( poolMode == EstimatorPool )
+  {
+    tracker->SetVesselnessFunctionScales( sectionEstimator->GetScales() );
+    
+    for( unsigned int i=0; i<sectionEstimator->GetScales().size(); ++i )
+    {
+      tracker->GetVesselnessFunctionPool()->Insert( sectionEstimator->GetScales()[i], 
+        sectionEstimator->GetMetricFunctionContainer()[i] );
+    }
+  }
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( 30 );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  ImageType::PointType seed;
+  seed[0] = 32.0;  seed[1] = 16.0;  seed[2] = 16.0;
+  tracker->SetStartingPoint( seed );
+  
+  tracker->SetRadialResolution( 5 );
+  tracker->SetAngularResolution( 8 );
+  tracker->SetMaximumSearchDistance( 1.0 );
+  
+  return tracker;
+}
+
+
+const CenterlineType * GetCenterline( VesselTrackerType *tracker )
+{
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( tracker->GetOutput()->GetRootNode().GetPointer() );
+  
+  return branch ? branch->GetCenterline().GetPointer() : 0;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  VesselTrackerType::Pointer tracker = CreateTracker( image, NoPool );
+  VesselTrackerType::Pointer pooledTracker = CreateTracker( image, Pool );
+  VesselTrackerType::Pointer estimatorPooledTracker = CreateTracker( image, EstimatorPool );
+  
+  try
+  {
+    tracker->Update();
+    pooledTracker->Update();
+    estimatorPooledTracker->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  const CenterlineType *centerline = GetCenterline( tracker );
+  
+  if( !centerline || centerline->Size() < 2 )
+  {
+    std::cerr << "The tube was not tracked" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  VesselTrackerType * pooledTrackers[2] = { pooledTracker, estimatorPooledTracker };
+  const char * poolNames[2] = { "pool", "pool of the estimator" };
+  
+  for( unsigned int t=0; t<2; ++t )
+  {
+    const CenterlineType *pooledCenterline = GetCenterline( pooledTrackers[t] );
+    
+    if( !pooledCenterline || pooledCenterline->Size() != centerline->Size() )
+    {
+      std::cerr << "With the " << poolNames[t] << ", " << ( pooledCenterline ? pooledCenterline->Size() : 0 ) 
+        << " sections were tracked instead of " << centerline->Size() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<centerline->Size(); ++i )
+    {
+      const VesselSectionType *section = centerline->at(i);
+      const VesselSectionType *pooledSection = pooledCenterline->at(i);
+      
+      if( section->GetCenter().EuclideanDistanceTo( pooledSection->GetCenter() ) > 1e-6 ||
+        ( section->GetNormal() - pooledSection->GetNormal() ).GetNorm() > 1e-6 ||
+        std::fabs( section->GetScale() - pooledSection->GetScale() ) > 1e-9 )
+      {
+        std::cerr << "With the " << poolNames[t] << ", section " << i << " is " << pooledSection->GetCenter() 
+          << " " << pooledSection->GetNormal() << " " << pooledSection->GetScale() << ", expected " 
+          << section->GetCenter() << " " << section->GetNormal() << " " << section->GetScale() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // One function per scale of the sections
+    if( pooledTrackers[t]->GetVesselnessFunctionPool()->GetNumberOfFunctions() == 0 )
+    {
+      std::cerr << "The " << poolNames[t] << " is empty" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,261 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselnessRidgeSearchVesselTrackerFilterSampleCacheTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tracks a tube with the ridge search tracker with and without the sample cache, 
+//   with the exhaustive and the coarse to fine searches, and checks that the centerlines are the
+//   same. With a tolerance well below the sample spacing they must be identical, and with the 
+//   default tolerance close. The components are those of 
+//   ivanVesselnessRidgeSearchVesselTrackerFilterPoolTest.cxx.
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanVesselnessRidgeSearchVesselTrackerFilter.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunction.h"
+#include "ivanOptimallyOrientedFluxVesselnessImageFunctionInitializer.h"
+#include "ivanDiscreteGradientGaussianImageFunction.h"
+#include "ivanMultiscaleAdaptiveOOFBasedVesselSectionEstimator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef float           PixelType;
+const unsigned int      Dimension = 3;
+
+typedef itk::Image<PixelType,Dimension>       ImageType;
+
+typedef ivan::CircularVesselSection
+  <Dimension>                                 VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>           CenterlineType;
+
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::MaxIterationsVesselTrackerEndCondition    EndConditionType;
+
+typedef ivan::DiscreteGradientGaussianImageFunction<ImageType>     GradientFunctionType;
+typedef ivan::GeometricMeanTwoNegativeEigenvalueFunctor<>          EigenvalueFunctorType;
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunction
+  <ImageType,GradientFunctionType,EigenvalueFunctorType,double>    VesselnessFunctionType;
+
+typedef ivan::OptimallyOrientedFluxVesselnessImageFunctionInitializer
+  <VesselnessFunctionType,ImageType>                               VesselnessFunctionInitializerType;
+
+typedef ivan::VesselnessRidgeSearchVesselTrackerFilter
+  <ImageType, VesselGraphType, VesselnessFunctionType>             VesselTrackerType;
+
+typedef ivan::MultiscaleAdaptiveOOFBasedVesselSectionEstimator
+  <ImageType,VesselnessFunctionType,GradientFunctionType,CenterlineType>  SectionEstimatorType;
+
+
+// Tube along x, centered at y=z=16, with a radius growing from 2 to 4 so several scales are used
+ImageType::Pointer CreateTubeImage()
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 64 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 32 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double radius = 2.0 + 2.0 * index[0] / 63.0;
+    const double dy = index[1] - 16.0;
+    const double dz = index[2] - 16.0;
+    
+    it.Set( ( dy * dy + dz * dz <= radius * radius ) ? 1000.0 : 0.0 );
+  }
+  
+  return image;
+}
+
+
+VesselTrackerType::Pointer CreateTracker( ImageType *image, bool coarseToFine, bool useSampleCache, 
+  double sampleCacheTolerance )
+{
+  VesselTrackerType::Pointer tracker = VesselTrackerType::New();
+  tracker->SetInput( image );
+  
+  VesselnessFunctionInitializerType::Pointer initializer = VesselnessFunctionInitializerType::New();
+  tracker->SetVesselnessFunctionInitializer( initializer );
+  
+  SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+  sectionEstimator->SetImage( image );
+  sectionEstimator->SetMetricFunctionInitializer( initializer );
+  sectionEstimator->SetScaleStepMethod( SectionEstimatorType::EquispacedScaleSteps );
+  sectionEstimator->SetNumberOfScales( 5 );
+  sectionEstimator->SetMinimumScale( 1.0 );
+  sectionEstimator->SetMaximumScale( 5.0 );
+  sectionEstimator->Initialize();
+  
+  tracker->SetSectionEstimator( sectionEstimator );
+  
+  EndConditionType::Pointer endCondition = EndConditionType::New();
+  endCondition->SetMaxIterations( 30 );
+  tracker->SetEndCondition( endCondition.GetPointer() );
+  
+  ImageType::PointType seed;
+  seed[0] = 32.0;  seed[1] = 16.0;  seed[2] = 16.0;
+  tracker->SetStartingPoint( seed );
+  
+  tracker->SetRadialResolution( 5 );
+  tracker->SetAngularResolution( 8 );
+  tracker->SetMaximumSearchDistance( 1.0 );
+  tracker->SetCoarseToFineSearch( coarseToFine );
+  
+  // The vesselness at the center of every section is evaluated again for the branches, so the 
+  // cache has hits whatever the search
+  tracker->DetectBranchesOn();
+  
+  tracker->SetUseSampleCache( useSampleCache );
+  tracker->SetSampleCacheTolerance( sampleCacheTolerance );
+  
+  return tracker;
+}
+
+
+const CenterlineType * GetCenterline( VesselTrackerType *tracker )
+{
+  const BranchNodeType *branch = 
+    dynamic_cast<const BranchNodeType*>( tracker->GetOutput()->GetRootNode().GetPointer() );
+  
+  return branch ? branch->GetCenterline().GetPointer() : 0;
+}
+
+
+bool CompareCenterlines( VesselTrackerType *referenceTracker, VesselTrackerType *tracker, 
+  double centerTolerance, double normalTolerance, const char *label )
+{
+  const CenterlineType *reference = GetCenterline( referenceTracker );
+  const CenterlineType *centerline = GetCenterline( tracker );
+  
+  if( !centerline || centerline->Size() != reference->Size() )
+  {
+    std::cerr << label << ": " << ( centerline ? centerline->Size() : 0 ) 
+      << " sections were tracked instead of " << reference->Size() << std::endl;
+    return false;
+  }
+  
+  for( unsigned int i=0; i<reference->Size(); ++i )
+  {
+    const VesselSectionType *referenceSection = reference->at(i);
+    const VesselSectionType *section = centerline->at(i);
+    
+    if( referenceSection->GetCenter().EuclideanDistanceTo( section->GetCenter() ) > centerTolerance ||
+      ( referenceSection->GetNormal() - section->GetNormal() ).GetNorm() > normalTolerance )
+    {
+      std::cerr << label << ": section " << i << " is " << section->GetCenter() << " " 
+        << section->GetNormal() << ", expected " << referenceSection->GetCenter() << " "
+        << referenceSection->GetNormal() << std::endl;
+      return false;
+    }
+  }
+  
+  if( tracker->GetBranchCandidates().size() != referenceTracker->GetBranchCandidates().size() )
+  {
+    std::cerr << label << ": " << tracker->GetBranchCandidates().size() << " branch candidates"
+      << " instead of " << referenceTracker->GetBranchCandidates().size() << std::endl;
+    return false;
+  }
+  
+  if( !tracker->GetSampleCache()->GetNumberOfHits() )
+  {
+    std::cerr << label << ": the sample cache was not used" << std::endl;
+    return false;
+  }
+  
+  std::cout << label << ": " << tracker->GetSampleCache()->GetNumberOfHits() << " hits, " 
+    << tracker->GetSampleCache()->GetNumberOfMisses() << " misses" << std::endl;
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::Pointer image = CreateTubeImage();
+  
+  const char * searchNames[2] = { "Exhaustive search", "Coarse to fine search" };
+  
+  for( unsigned int s=0; s<2; ++s )
+  {
+    const bool coarseToFine = ( s == 1 );
+    
+    VesselTrackerType::Pointer tracker = CreateTracker( image, coarseToFine, false, 0.1 );
+    
+    // Cells much smaller than the sample spacing only merge evaluations at the same position
+    VesselTrackerType::Pointer fineCacheTracker = CreateTracker( image, coarseToFine, true, 1e-3 );
+    VesselTrackerType::Pointer cacheTracker = CreateTracker( image, coarseToFine, true, 0.1 );
+    
+    try
+    {
+      tracker->Update();
+      fineCacheTracker->Update();
+      cacheTracker->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+      return EXIT_FAILURE;
+    }
+    
+    const CenterlineType *centerline = GetCenterline( tracker );
+    
+    if( !centerline || centerline->Size() < 2 )
+    {
+      std::cerr << searchNames[s] << ": the tube was not tracked" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( tracker->GetSampleCache()->GetNumberOfHits() || tracker->GetSampleCache()->GetNumberOfMisses() )
+    {
+      std::cerr << searchNames[s] << ": the sample cache was used while off" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !CompareCenterlines( tracker, fineCacheTracker, 1e-6, 1e-6, searchNames[s] ) )
+      return EXIT_FAILURE;
+    
+    // The cached values may come from a sample up to a cell away, so the maxima may move 
+    // slightly, but the tracker must stay on the same centerline
+    if( !CompareCenterlines( tracker, cacheTracker, 0.5, 0.1, searchNames[s] ) )
+      return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
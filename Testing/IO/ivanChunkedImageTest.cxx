@@ -0,0 +1,222 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanChunkedImageTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests reading regions and pixels of Zarr arrays with ChunkedImageSource and ChunkedImage.
+
+#include "ivanChunkedImageSource.h"
+#include "ivanChunkedImage.h"
+
+#include "itkImage.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+typedef itk::Image<float,3>                     ImageType;
+typedef ivan::ChunkedImageSource<ImageType>     SourceType;
+typedef ivan::ChunkedImage<float,3>             ChunkedImageType;
+typedef ivan::ZarrArray                         ArrayType;
+
+const float FillValue = -1.0f;
+
+
+// Value written at a pixel; the first chunk is never written and has the fill value
+float PixelValue( const ImageType::IndexType & index )
+{
+  if( index[0] < 8 && index[1] < 8 && index[2] < 8 )
+    return FillValue;
+    
+  return 0.25f * ( index[0] + 100 * index[1] + 10000 * index[2] );
+}
+
+
+// Write an array of 21x30x17 pixels in chunks of 8x8x8
+bool WriteArray( const std::string & path, int compressionLevel )
+{
+  ArrayType::ShapeType shape( 3 ), chunkShape( 3, 8 );
+  shape[0] = 21;
+  shape[1] = 30;
+  shape[2] = 17;
+  
+  ArrayType::Pointer array = ArrayType::New();
+  
+  try
+  {
+    array->Create( path, shape, chunkShape, sizeof(float), false, true, compressionLevel, FillValue );
+    
+    std::vector<float> buffer( array->GetNumberOfElementsPerChunk() );
+    
+    for( unsigned long chunk=1; chunk < array->GetNumberOfChunks(); ++chunk )
+    {
+      ArrayType::ShapeType chunkIndex = array->GetChunkIndex( chunk );
+      ImageType::IndexType index;
+      
+      // Pixels of the chunks on the border outside the array are written too
+      for( unsigned long i=0; i < buffer.size(); ++i )
+      {
+        index[0] = chunkIndex[0] * 8 + i % 8;
+        index[1] = chunkIndex[1] * 8 + ( i / 8 ) % 8;
+        index[2] = chunkIndex[2] * 8 + i / 64;
+        buffer[i] = PixelValue( index );
+      }
+      
+      array->WriteChunk( chunk, &buffer[0] );
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+// Read a region with the source and the same pixels with a chunked image sharing its cache
+bool CheckArray( const std::string & path )
+{
+  SourceType::Pointer source = SourceType::New();
+  source->SetFileName( path );
+  source->GetChunkCache()->SetMaximumNumberOfChunks( 16 );
+  
+  ImageType::RegionType region;
+  region.SetIndex( 0, 5 );
+  region.SetIndex( 1, 3 );
+  region.SetIndex( 2, 2 );
+  region.SetSize( 0, 10 );
+  region.SetSize( 1, 20 );
+  region.SetSize( 2, 9 );
+  
+  try
+  {
+    source->UpdateOutputInformation();
+    source->GetOutput()->SetRequestedRegion( region );
+    source->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return false;
+  }
+  
+  ImageType *output = source->GetOutput();
+  
+  if( output->GetLargestPossibleRegion().GetSize()[0] != 21 || 
+    output->GetLargestPossibleRegion().GetSize()[1] != 30 ||
+    output->GetLargestPossibleRegion().GetSize()[2] != 17 || output->GetBufferedRegion() != region )
+  {
+    std::cerr << "Wrong regions of " << path << ": " << output->GetBufferedRegion() << std::endl;
+    return false;
+  }
+  
+  // The region touches 2x3x2 chunks
+  if( source->GetChunkCache()->GetNumberOfChunks() != 12 )
+  {
+    std::cerr << "Wrong number of chunks read from " << path << ": " << 
+      source->GetChunkCache()->GetNumberOfChunks() << std::endl;
+    return false;
+  }
+  
+  ChunkedImageType::Pointer chunked = ChunkedImageType::New();
+  chunked->SetChunkCache( source->GetChunkCache() );
+  
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it( output, region );
+  
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    const float value = PixelValue( it.GetIndex() );
+    
+    if( it.Get() != value || chunked->GetPixel( it.GetIndex() ) != value )
+    {
+      std::cerr << "Wrong pixel of " << path << " at " << it.GetIndex() << ": " << it.Get() << 
+        " and " << chunked->GetPixel( it.GetIndex() ) << " instead of " << value << std::endl;
+      return false;
+    }
+  }
+  
+  // Prefetch the last corner, then read it
+  ChunkedImageType::IndexType corner;
+  corner[0] = 20;
+  corner[1] = 29;
+  corner[2] = 16;
+  
+  chunked->Prefetch( corner, 2 );
+  
+  if( chunked->GetPixel( corner ) != PixelValue( corner ) )
+  {
+    std::cerr << "Wrong pixel of " << path << " at " << corner << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::string prefix = argv[1];
+  
+  // Compressed and uncompressed chunks
+  if( !WriteArray( prefix + ".zarr", 1 ) || !CheckArray( prefix + ".zarr" ) )
+    return EXIT_FAILURE;
+  
+  if( !WriteArray( prefix + "Raw.zarr", 0 ) || !CheckArray( prefix + "Raw.zarr" ) )
+    return EXIT_FAILURE;
+  
+  // The element type must match
+  typedef itk::Image<short,3> ShortImageType;
+  ivan::ChunkedImageSource<ShortImageType>::Pointer shortSource = 
+    ivan::ChunkedImageSource<ShortImageType>::New();
+  shortSource->SetFileName( prefix + ".zarr" );
+  
+  bool caught = false;
+  
+  try
+  {
+    shortSource->Update();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    caught = true;
+  }
+  
+  if( !caught )
+  {
+    std::cerr << "Wrong element type not detected." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
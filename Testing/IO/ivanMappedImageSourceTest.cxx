@@ -0,0 +1,212 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanMappedImageSourceTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests mapping MetaImage, NRRD and raw image files with MappedImageSource.
+
+#include "ivanMappedImageSource.h"
+
+#include "itkImage.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+typedef itk::Image<float,3>                     ImageType;
+typedef ivan::MappedImageSource<ImageType>      SourceType;
+
+
+// Check that the mapped image has the geometry and pixels of the original one
+bool CheckImage( const ImageType * image, const ImageType * mapped, const std::string & name )
+{
+  if( mapped->GetLargestPossibleRegion() != image->GetLargestPossibleRegion() ||
+    mapped->GetBufferedRegion() != image->GetLargestPossibleRegion() )
+  {
+    std::cerr << "Wrong region of " << name << ": " << mapped->GetBufferedRegion() << std::endl;
+    return false;
+  }
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    if( vcl_abs( mapped->GetSpacing()[i] - image->GetSpacing()[i] ) > 1e-6 ||
+      vcl_abs( mapped->GetOrigin()[i] - image->GetOrigin()[i] ) > 1e-6 )
+    {
+      std::cerr << "Wrong geometry of " << name << ": " << mapped->GetSpacing() << " " 
+        << mapped->GetOrigin() << std::endl;
+      return false;
+    }
+  }
+  
+  itk::ImageRegionConstIterator<ImageType> it( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<ImageType> mappedIt( mapped, image->GetLargestPossibleRegion() );
+  
+  for( ; !it.IsAtEnd(); ++it, ++mappedIt )
+  {
+    if( it.Get() != mappedIt.Get() )
+    {
+      std::cerr << "Wrong pixel of " << name << " at " << it.GetIndex() << ": " << mappedIt.Get()
+        << " instead of " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::string prefix = argv[1];
+  
+  ImageType::SizeType size;
+  size[0] = 21;
+  size[1] = 30;
+  size[2] = 17;
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 0.7;
+  spacing[2] = 1.1;
+  
+  ImageType::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 5.0;
+  origin[2] = 2.5;
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->Allocate();
+  
+  float *buffer = image->GetBufferPointer();
+  const unsigned long numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+  
+  for( unsigned long i=0; i<numberOfPixels; ++i )
+    buffer[i] = 0.25f * i - 100.0f;
+  
+  // Header and data together and in separate files
+  const char *extensions[] = { ".mha", ".mhd", ".nrrd", ".nhdr" };
+  
+  for( unsigned int i=0; i<4; ++i )
+  {
+    const std::string fileName = prefix + extensions[i];
+    
+    typedef itk::ImageFileWriter<ImageType> WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput( image );
+    writer->SetFileName( fileName );
+    writer->SetUseCompression( false );
+    
+    SourceType::Pointer source = SourceType::New();
+    source->SetFileName( fileName );
+    source->SetAccessPattern( ivan::FileMapping::RandomAccess );
+    
+    try
+    {
+      writer->Update();
+      source->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !CheckImage( image, source->GetOutput(), fileName ) )
+      return EXIT_FAILURE;
+    
+    // Separate data files start at the beginning, so they are always mapped
+    if( i % 2 && !source->GetMapped() )
+    {
+      std::cerr << fileName << " was not mapped." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Raw file with a header of 64 bytes
+  const std::string rawFileName = prefix + ".raw";
+  
+  std::ofstream rawFile( rawFileName.c_str(), std::ios::out | std::ios::binary );
+  const std::string header( 64, 'x' );
+  rawFile.write( header.c_str(), header.size() );
+  rawFile.write( reinterpret_cast<const char*>( buffer ), numberOfPixels * sizeof(float) );
+  rawFile.close();
+  
+  SourceType::Pointer rawSource = SourceType::New();
+  rawSource->SetFileName( rawFileName );
+  rawSource->SetSize( size );
+  rawSource->SetSpacing( spacing );
+  rawSource->SetOrigin( origin );
+  rawSource->SetDataOffset( header.size() );
+  rawSource->Update();
+  
+  if( !CheckImage( image, rawSource->GetOutput(), rawFileName ) || !rawSource->GetMapped() )
+    return EXIT_FAILURE;
+  
+  // Pages are copied on write, so the file does not change
+  ImageType::Pointer mapped = rawSource->GetOutput();
+  mapped->DisconnectPipeline();
+  mapped->GetBufferPointer()[0] = 1000.0f;
+  
+  SourceType::Pointer rawSource2 = SourceType::New();
+  rawSource2->SetFileName( rawFileName );
+  rawSource2->SetSize( size );
+  rawSource2->SetDataOffset( header.size() );
+  rawSource2->Update();
+  
+  if( rawSource2->GetOutput()->GetBufferPointer()[0] != buffer[0] )
+  {
+    std::cerr << "Writing to the mapped image changed the file." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The element type must match
+  typedef itk::Image<short,3> ShortImageType;
+  ivan::MappedImageSource<ShortImageType>::Pointer shortSource = 
+    ivan::MappedImageSource<ShortImageType>::New();
+  shortSource->SetFileName( prefix + ".mhd" );
+  
+  try
+  {
+    shortSource->Update();
+    std::cerr << "Element type mismatch not detected." << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch( itk::ExceptionObject & )
+  {
+  }
+  
+  return EXIT_SUCCESS;
+}
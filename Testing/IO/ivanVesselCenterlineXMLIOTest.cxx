@@ -0,0 +1,161 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineXMLIOTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes a vessel graph to XML and reads it back.
+// Date: 2012/11/05
+
+#include "ivanVesselCenterlineXMLWriter.h"
+#include "ivanVesselCenterlineXMLReader.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // 1 -> 2 -> { 3, 4 } -> 5, where 5 is shared by 3 and 4
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 10, 0.1 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 5, 0.1 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 7, 0.1 );
+  BranchNodeType::Pointer branch5 = CreateTestBranch<BranchNodeType>( 5, 3, 0.1 );
+  
+  // Coordinates without an exact decimal representation
+  BranchNodeType *branches[] = { branch1, branch3, branch4, branch5 };
+  
+  for( unsigned int j=0; j<4; ++j )
+  {
+    for( unsigned int i=0; i<branches[j]->GetCenterline()->size(); ++i )
+    {
+      SectionType::PointType center = branches[j]->GetCenterline()->at(i)->GetCenter();
+      center[2] = 1.0 / 3.0;
+      branches[j]->GetCenterline()->at(i)->SetCenter( center );
+    }
+  }
+  
+  std::string name = "trunk <\"a\" & 'b'>";
+  branch1->SetName( name );
+  branch4->SetMask( 4 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  branch3->AddChild( branch5 );
+  branch4->AddChild( branch5 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  try
+  {
+    ivan::VesselCenterlineXMLWriter<CenterlineType>::Pointer writer = 
+      ivan::VesselCenterlineXMLWriter<CenterlineType>::New();
+    writer->SetFileName( argv[1] );
+    writer->SetBufferSize( 1024 ); // flush several times
+    writer->Write( graph );
+    
+    ivan::VesselCenterlineXMLReader<CenterlineType>::Pointer reader = 
+      ivan::VesselCenterlineXMLReader<CenterlineType>::New();
+    reader->SetFileName( argv[1] );
+    reader->SetBufferSize( 1024 ); // parse in several chunks
+    reader->Read();
+    
+    GraphType *readGraph = reader->GetOutput();
+    
+    BranchNodeType *readBranch1 = dynamic_cast<BranchNodeType*>( readGraph->GetRootNode().GetPointer() );
+    
+    if( !readBranch1 || readBranch1->GetName() != name || readBranch1->GetNumberOfChildren() != 1 ||
+      !dynamic_cast<BifurcationNodeType*>( readBranch1->GetChild(0) ) ||
+      readBranch1->GetChild(0)->GetNumberOfChildren() != 2 )
+    {
+      std::cerr << "Wrong nodes read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    BranchNodeType *readBranch3 = dynamic_cast<BranchNodeType*>( readBranch1->GetChild(0)->GetChild(0) );
+    BranchNodeType *readBranch4 = dynamic_cast<BranchNodeType*>( readBranch1->GetChild(0)->GetChild(1) );
+    
+    if( !readBranch4 || readBranch4->GetNodeId() != 4 || readBranch4->GetMask() != 4 ||
+      readBranch4->GetDepthLevel() != branch4->GetDepthLevel() ||
+      readBranch4->GetCenterline()->size() != 7 )
+    {
+      std::cerr << "Wrong branch 4 read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !readBranch3 || readBranch3->GetNumberOfChildren() != 1 || readBranch4->GetNumberOfChildren() != 1 ||
+      readBranch3->GetChild(0) != readBranch4->GetChild(0) || 
+      readBranch3->GetChild(0)->GetNodeId() != 5 || readBranch3->GetChild(0)->GetNumberOfParents() != 2 )
+    {
+      std::cerr << "Shared branch 5 not read as a single node." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<7; ++i )
+    {
+      const SectionType *section = readBranch4->GetCenterline()->at(i);
+      const SectionType *original = branch4->GetCenterline()->at(i);
+      
+      if( section->GetCenter() != original->GetCenter() || section->GetNormal() != original->GetNormal() ||
+        section->GetRadius() != original->GetRadius() || section->GetScale() != original->GetScale() ||
+        section->GetArclength() != original->GetArclength() )
+      {
+        std::cerr << "Wrong section " << i << " of branch 4 read." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    std::cerr << e << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
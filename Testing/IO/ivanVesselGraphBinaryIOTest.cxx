@@ -0,0 +1,319 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphBinaryIOTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes a vessel graph in the binary format and reads it back.
+// Date: 2012/11/05
+
+#include "ivanVesselGraphBinaryWriter.h"
+#include "ivanVesselGraphBinaryReader.h"
+#include "ivanMappedVesselGraph.h"
+#include "ivanVesselGraphBinaryFormat.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // 1 -> 2 -> { 3, 4 }
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 10 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 5 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 7 );
+  
+  std::string name = "trunk";
+  branch1->SetName( name );
+  branch4->SetMask( 4 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  try
+  {
+    ivan::VesselGraphBinaryWriter<CenterlineType>::Pointer writer = 
+      ivan::VesselGraphBinaryWriter<CenterlineType>::New();
+    writer->SetFileName( argv[1] );
+    writer->SetInput( graph );
+    writer->Write();
+    
+    // Access the file in place
+    ivan::MappedVesselGraph::Pointer mappedGraph = ivan::MappedVesselGraph::New();
+    mappedGraph->Open( argv[1] );
+    
+    if( mappedGraph->GetNumberOfNodes() != 4 || mappedGraph->GetNumberOfLinks() != 3 || 
+      mappedGraph->GetTotalNumberOfSections() != 22 || mappedGraph->GetNumberOfNodeTypes() != 2 ||
+      mappedGraph->GetNodeId( 0 ) != 1 || mappedGraph->GetName( 0 ) != "trunk" ||
+      mappedGraph->GetNumberOfChildren( 1 ) != 2 || mappedGraph->GetParent( 1, 0 ) != 0 ||
+      mappedGraph->GetNodeTypeName( mappedGraph->GetNodeType( 1 ) ) != "VesselBifurcationNode" ||
+      mappedGraph->GetNumberOfSections( 3 ) != 7 || mappedGraph->GetRadii()[ 
+        mappedGraph->GetSectionOffset( 3 ) + 2 ] != branch4->GetCenterline()->at(2)->GetRadius() ||
+      mappedGraph->ComputeBranchLength( 0 ) != 9.0 )
+    {
+      std::cerr << "Wrong mapped graph." << std::endl;
+      mappedGraph->Print( std::cerr );
+      return EXIT_FAILURE;
+    }
+    
+    mappedGraph->Close();
+    
+    ivan::VesselGraphBinaryReader<CenterlineType>::Pointer reader = 
+      ivan::VesselGraphBinaryReader<CenterlineType>::New();
+    reader->SetFileName( argv[1] );
+    reader->Read();
+    
+    GraphType *readGraph = reader->GetOutput();
+    
+    BranchNodeType *readBranch1 = dynamic_cast<BranchNodeType*>( readGraph->GetRootNode().GetPointer() );
+    
+    if( !readBranch1 || readBranch1->GetName() != "trunk" || readBranch1->GetNumberOfChildren() != 1 ||
+      !dynamic_cast<BifurcationNodeType*>( readBranch1->GetChild(0) ) )
+    {
+      std::cerr << "Wrong nodes read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    BranchNodeType *readBranch4 = dynamic_cast<BranchNodeType*>( readBranch1->GetChild(0)->GetChild(1) );
+    
+    if( !readBranch4 || readBranch4->GetNodeId() != 4 || readBranch4->GetMask() != 4 ||
+      readBranch4->GetDepthLevel() != branch4->GetDepthLevel() ||
+      readBranch4->GetCenterline()->size() != 7 )
+    {
+      std::cerr << "Wrong branch 4 read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<7; ++i )
+    {
+      const SectionType *section = readBranch4->GetCenterline()->at(i);
+      const SectionType *original = branch4->GetCenterline()->at(i);
+      
+      if( section->GetCenter() != original->GetCenter() || section->GetNormal() != original->GetNormal() ||
+        section->GetRadius() != original->GetRadius() || section->GetScale() != original->GetScale() ||
+        section->GetArclength() != original->GetArclength() )
+      {
+        std::cerr << "Wrong section " << i << " of branch 4 read." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // Lazy loading, with one resident centerline
+    reader->LazyCenterlinesOn();
+    reader->SetMaximumNumberOfResidentCenterlines( 1 );
+    reader->Read();
+    
+    const GraphType *lazyGraph = reader->GetOutput();
+    const BranchNodeType *lazyBranch1 = dynamic_cast<const BranchNodeType*>( lazyGraph->GetRootNode().GetPointer() );
+    const BranchNodeType *lazyBranch3 = dynamic_cast<const BranchNodeType*>( lazyBranch1->GetChild(0)->GetChild(0) );
+    const BranchNodeType *lazyBranch4 = dynamic_cast<const BranchNodeType*>( lazyBranch1->GetChild(0)->GetChild(1) );
+    
+    if( !lazyBranch3 || !lazyBranch4 || lazyBranch4->IsCenterlineResident() || 
+      !lazyBranch4->GetCenterlineLoader() )
+    {
+      std::cerr << "Centerlines loaded before being accessed." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( lazyBranch4->GetCenterline()->size() != 7 || 
+      lazyBranch4->GetCenterline()->at(2)->GetRadius() != branch4->GetCenterline()->at(2)->GetRadius() ||
+      !lazyBranch4->IsCenterlineResident() )
+    {
+      std::cerr << "Wrong lazy centerline of branch 4." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( lazyBranch3->GetCenterline()->size() != 5 || lazyBranch4->IsCenterlineResident() ||
+      lazyBranch3->GetCenterlineLoader()->GetNumberOfResidentCenterlines() != 1 )
+    {
+      std::cerr << "Least recently used centerline not released." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    {
+      // In use, so kept above the maximum
+      BranchNodeType::CenterlineConstPointer centerline3 = lazyBranch3->GetCenterline();
+      lazyBranch4->GetCenterline();
+      
+      if( !lazyBranch3->IsCenterlineResident() || !lazyBranch4->IsCenterlineResident() )
+      {
+        std::cerr << "Centerline in use released." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // Reading through a non-const branch does not pin the centerline
+    BranchNodeType *nonConstBranch4 = const_cast<BranchNodeType*>( lazyBranch4 );
+    
+    if( nonConstBranch4->GetCenterline()->size() != 7 || !nonConstBranch4->GetCenterlineLoader() )
+    {
+      std::cerr << "Centerline pinned when reading it." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Writable access pins the centerline
+    BranchNodeType *writableBranch3 = const_cast<BranchNodeType*>( lazyBranch3 );
+    writableBranch3->GetWritableCenterline()->pop_back();
+    lazyBranch4->GetCenterline();
+    lazyBranch1->GetCenterline();
+    
+    if( writableBranch3->GetCenterlineLoader() || writableBranch3->GetCenterline()->size() != 4 )
+    {
+      std::cerr << "Writable centerline not pinned." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Compressed sections
+    writer->CompressSectionsOn();
+    writer->SetCompressionPrecision( 0.001 );
+    writer->Write();
+    
+    mappedGraph->Open( argv[1] );
+    
+    if( !mappedGraph->HasCompressedSections() || mappedGraph->GetCenters() || 
+      std::fabs( mappedGraph->ComputeBranchLength( 0 ) - 9.0 ) > 0.01 )
+    {
+      std::cerr << "Wrong compressed mapped graph." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    mappedGraph->Close();
+    
+    reader->LazyCenterlinesOff();
+    reader->Read();
+    
+    BranchNodeType *compressedBranch4 = dynamic_cast<BranchNodeType*>( 
+      reader->GetOutput()->GetRootNode()->GetChild(0)->GetChild(1) );
+    
+    if( !compressedBranch4 || compressedBranch4->GetCenterline()->size() != 7 )
+    {
+      std::cerr << "Wrong compressed branch 4 read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<7; ++i )
+    {
+      const SectionType *section = compressedBranch4->GetCenterline()->at(i);
+      const SectionType *original = branch4->GetCenterline()->at(i);
+      
+      if( section->GetCenter().EuclideanDistanceTo( original->GetCenter() ) > 0.001 || 
+        ( section->GetNormal() - original->GetNormal() ).GetNorm() > 1e-3 ||
+        std::fabs( section->GetRadius() - original->GetRadius() ) > 1e-3 * original->GetRadius() ||
+        std::fabs( section->GetArclength() - original->GetArclength() ) > 0.001 )
+      {
+        std::cerr << "Wrong compressed section " << i << " of branch 4 read." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    
+    // Corrupt files are rejected when opened
+    writer->CompressSectionsOff();
+    writer->Write();
+    
+    const std::string contents = ReadFile( argv[1] );
+    const std::string corruptFileName = std::string( argv[1] ) + ".corrupt";
+    
+    const std::string::size_type truncatedSizes[] = 
+      { 0, 16, sizeof(ivan::VesselGraphBinaryHeader) - 1, contents.size() / 2 };
+    
+    for( unsigned int i=0; i<5; ++i )
+    {
+      std::string corruptContents;
+      
+      if( i < 4 )
+        corruptContents = contents.substr( 0, truncatedSizes[i] );
+      else
+      {
+        // A number of sections whose column sizes wrap around to the right ones
+        vxl_uint_64 numberOfSections;
+        const size_t numberOfSectionsOffset = 
+          offsetof( ivan::VesselGraphBinaryHeader, NumberOfSections );
+        
+        corruptContents = contents;
+        memcpy( &numberOfSections, corruptContents.data() + numberOfSectionsOffset, 
+          sizeof(numberOfSections) );
+        numberOfSections += vxl_uint_64( 1 ) << 61;
+        memcpy( &corruptContents[numberOfSectionsOffset], &numberOfSections, 
+          sizeof(numberOfSections) );
+      }
+      
+      WriteFile( corruptFileName, corruptContents );
+      
+      bool rejected = false;
+      
+      try
+      {
+        mappedGraph->Open( corruptFileName );
+      }
+      catch( itk::ExceptionObject & )
+      {
+        rejected = true;
+      }
+      
+      if( !rejected || mappedGraph->GetNumberOfNodes() != 0 )
+      {
+        std::cerr << "Corrupt file " << i << " was not rejected." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    std::cerr << e << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphColumnarIOTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: writes the tables of a vessel graph in the columnar format and reads them back.
+// Date: 2012/11/05
+
+#include "ivanVesselGraphColumnarWriter.h"
+#include "ivanVesselGraphColumnarReader.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanLocalCurveMetrics.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+
+
+typedef ivan::LocalCurveMetrics<3>                  CurveMetricsType;
+typedef ivan::CircularVesselSection
+  <3, CurveMetricsType>                             SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+typedef ivan::VesselGraphColumnarWriter
+  <CenterlineType>                                  WriterType;
+typedef ivan::VesselGraphColumnarReader             ReaderType;
+typedef ivan::VesselGraphColumnarFormat             FormatType;
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // 1 -> 2 -> { 3, 4 }
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 10 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 5 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 7 );
+  
+  BranchNodeType *branches[] = { branch1, branch3, branch4 };
+  
+  for( unsigned int j=0; j<3; ++j )
+  {
+    for( unsigned int i=0; i<branches[j]->GetCenterline()->size(); ++i )
+    {
+      branches[j]->GetCenterline()->at(i)->GetCurveMetrics().SetCurvature( 
+        0.01 * branches[j]->GetNodeId() * i );
+    }
+  }
+  
+  branch4->SetMask( 4 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  ReaderType::Pointer reader = ReaderType::New();
+  
+  try
+  {
+    // Several batches per table, the last one partial
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( argv[1] );
+    writer->SetInput( graph );
+    writer->SetBatchSize( 4 );
+    writer->Write();
+    
+    reader->SetFileName( argv[1] );
+    reader->Read();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const int branches = reader->FindTable( "branches" );
+  const int sections = reader->FindTable( "sections" );
+  
+  if( branches < 0 || sections < 0 || reader->GetNumberOfRows( branches ) != 3 || 
+    reader->GetNumberOfRows( sections ) != 22 )
+  {
+    std::cerr << "Wrong tables read." << std::endl;
+    reader->Print( std::cerr );
+    return EXIT_FAILURE;
+  }
+  
+  // Branches in depth-first order, skipping the bifurcation
+  const vxl_uint_32 *nodeIds = reader->GetColumnValues<vxl_uint_32>( branches, 
+    reader->FindColumn( branches, "NodeId" ) );
+  const vxl_uint_32 *parentIds = reader->GetColumnValues<vxl_uint_32>( branches, 
+    reader->FindColumn( branches, "ParentId" ) );
+  const vxl_uint_32 *parentBranchIds = reader->GetColumnValues<vxl_uint_32>( branches, 
+    reader->FindColumn( branches, "ParentBranchId" ) );
+  const vxl_uint_32 *masks = reader->GetColumnValues<vxl_uint_32>( branches, 
+    reader->FindColumn( branches, "Mask" ) );
+  const vxl_uint_64 *firstSections = reader->GetColumnValues<vxl_uint_64>( branches, 
+    reader->FindColumn( branches, "FirstSection" ) );
+  const double *lengths = reader->GetColumnValues<double>( branches, 
+    reader->FindColumn( branches, "Length" ) );
+  
+  if( nodeIds[0] != 1 || nodeIds[1] != 3 || nodeIds[2] != 4 || 
+    parentIds[0] != FormatType::NullNodeId || parentIds[2] != 2 ||
+    parentBranchIds[0] != FormatType::NullNodeId || parentBranchIds[2] != 1 || 
+    masks[2] != 4 || firstSections[2] != 15 || lengths[0] != 9.0 )
+  {
+    std::cerr << "Wrong branches table." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const int centerColumn = reader->FindColumn( sections, "Center" );
+  const int curvatureColumn = reader->FindColumn( sections, "Curvature" );
+  
+  if( centerColumn < 0 || curvatureColumn < 0 || 
+    reader->GetNumberOfComponents( sections, centerColumn ) != 3 ||
+    reader->GetValueType( sections, curvatureColumn ) != FormatType::Float64Type )
+  {
+    std::cerr << "Wrong sections columns." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const vxl_uint_32 *branchIds = reader->GetColumnValues<vxl_uint_32>( sections, 
+    reader->FindColumn( sections, "BranchId" ) );
+  const double *centers = reader->GetColumnValues<double>( sections, centerColumn );
+  const double *radii = reader->GetColumnValues<double>( sections, 
+    reader->FindColumn( sections, "Radius" ) );
+  const double *curvatures = reader->GetColumnValues<double>( sections, curvatureColumn );
+  
+  for( unsigned int i=0; i<7; ++i )
+  {
+    const unsigned int row = firstSections[2] + i;
+    const SectionType *original = branch4->GetCenterline()->at(i);
+    
+    if( branchIds[row] != 4 || centers[ 3 * row + 1 ] != original->GetCenter()[1] || 
+      radii[row] != original->GetRadius() || 
+      curvatures[row] != original->GetCurveMetrics().GetCurvature() )
+    {
+      std::cerr << "Wrong section " << i << " of branch 4 read." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
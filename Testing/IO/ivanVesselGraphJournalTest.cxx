@@ -0,0 +1,294 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphJournalTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that a vessel graph is recovered from its snapshot and journal, discarding torn
+//   records and the journal of a previous snapshot.
+// Date: 2012/11/05
+
+#include "ivanVesselGraphJournal.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+#include <string>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+typedef ivan::VesselGraphJournal<CenterlineType>    JournalType;
+
+
+/** Whether both graphs have the same nodes, links and sections, in the same order. */
+bool CompareGraphs( const GraphType * graph, const GraphType * other )
+{
+  const GraphType::NodeListType & nodes = graph->GetNodes();
+  const GraphType::NodeListType & otherNodes = other->GetNodes();
+  
+  if( nodes.size() != otherNodes.size() )
+    return false;
+    
+  for( unsigned int n=0; n<nodes.size(); ++n )
+  {
+    const ivan::GraphNode *node = nodes[n];
+    const ivan::GraphNode *otherNode = otherNodes[n];
+    
+    if( node->GetNodeId() != otherNode->GetNodeId() || node->GetMask() != otherNode->GetMask() ||
+      node->GetName() != otherNode->GetName() || 
+      std::string( node->GetNameOfClass() ) != otherNode->GetNameOfClass() ||
+      node->GetNumberOfChildren() != otherNode->GetNumberOfChildren() )
+      return false;
+      
+    for( unsigned int i=0; i<node->GetNumberOfChildren(); ++i )
+    {
+      if( node->GetChild( i )->GetNodeId() != otherNode->GetChild( i )->GetNodeId() )
+        return false;
+    }
+    
+    const BranchNodeType *branch = dynamic_cast<const BranchNodeType*>( node );
+    const BranchNodeType *otherBranch = dynamic_cast<const BranchNodeType*>( otherNode );
+    
+    if( !branch )
+      continue;
+      
+    if( branch->GetCenterline()->size() != otherBranch->GetCenterline()->size() )
+      return false;
+      
+    for( unsigned int i=0; i<branch->GetCenterline()->size(); ++i )
+    {
+      const SectionType *section = branch->GetCenterline()->at(i);
+      const SectionType *otherSection = otherBranch->GetCenterline()->at(i);
+      
+      if( section->GetCenter() != otherSection->GetCenter() || 
+        section->GetNormal() != otherSection->GetNormal() ||
+        section->GetRadius() != otherSection->GetRadius() || 
+        section->GetArclength() != otherSection->GetArclength() )
+        return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::string snapshotFileName = argv[1];
+  const std::string journalFileName = snapshotFileName + ".journal";
+  
+  // 1 -> 2 -> { 3, 4 }
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 10 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 5 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 7 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  try
+  {
+    JournalType::Pointer journal = JournalType::New();
+    journal->SetFileName( journalFileName );
+    journal->SetSnapshotFileName( snapshotFileName );
+    journal->SetCompactionInterval( 0 );
+    journal->Create( graph );
+    
+    const std::string::size_type emptySize = ReadFile( journalFileName ).size();
+    
+    // Insert a branch between the others
+    BranchNodeType::Pointer branch5 = CreateTestBranch<BranchNodeType>( 5, 3 );
+    std::string name = "new";
+    branch5->SetName( name );
+    branch5->SetMask( 5 );
+    bifurcation2->InsertChild( 1, branch5 );
+    graph->Modified();
+    journal->AppendInsertNode( branch5 );
+    
+    // Extend branch 3 and change a section of branch 4
+    CenterlineType *centerline3 = branch3->GetWritableCenterline();
+    centerline3->push_back( CreateTestBranch<BranchNodeType>( 3, 7 )->GetCenterline()->at(5) );
+    centerline3->push_back( CreateTestBranch<BranchNodeType>( 3, 7 )->GetCenterline()->at(6) );
+    journal->AppendUpdateSections( branch3, 5, 0, 2 );
+    
+    branch4->GetWritableSection( 0 )->SetRadius( 3.0 );
+    journal->AppendUpdateSections( branch4, 0, 1, 1 );
+    
+    // Trim branch 5 to its middle section
+    CenterlineType *centerline5 = branch5->GetWritableCenterline();
+    centerline5->CastToSTLContainer().erase( centerline5->CastToSTLContainer().begin() );
+    centerline5->CastToSTLContainer().pop_back();
+    journal->AppendUpdateSections( branch5, 0, 3, 1 );
+    
+    // Move branch 3 to the front of the children, and remove branch 4
+    bifurcation2->RemoveChild( branch3.GetPointer() );
+    branch3->RemoveParent( bifurcation2.GetPointer() );
+    journal->AppendUnlinkNodes( 2, 3 );
+    bifurcation2->InsertChild( 0, branch3 );
+    journal->AppendLinkNodes( 2, 3, 0 );
+    
+    bifurcation2->RemoveChild( branch4.GetPointer() );
+    branch4->RemoveParent( bifurcation2.GetPointer() );
+    graph->Modified();
+    journal->AppendRemoveNode( 4 );
+    
+    if( journal->GetNumberOfRecords() != 7 || ReadFile( journalFileName ).size() <= emptySize )
+    {
+      std::cerr << "Wrong records appended." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    journal->Close();
+    
+    JournalType::Pointer recovered = JournalType::New();
+    recovered->SetFileName( journalFileName );
+    recovered->SetSnapshotFileName( snapshotFileName );
+    recovered->SetCompactionInterval( 0 );
+    recovered->Recover();
+    
+    if( recovered->GetNumberOfReplayedRecords() != 7 || recovered->GetNumberOfDiscardedBytes() != 0 ||
+      !CompareGraphs( graph, recovered->GetGraph() ) )
+    {
+      std::cerr << "Wrong graph recovered." << std::endl;
+      recovered->Print( std::cerr );
+      return EXIT_FAILURE;
+    }
+    
+    // A record torn by a crash is discarded, and recovery continues the journal
+    const std::string contents = ReadFile( journalFileName );
+    WriteFile( journalFileName, contents + contents.substr( emptySize, 20 ) );
+    
+    recovered->Recover();
+    
+    if( recovered->GetNumberOfReplayedRecords() != 7 || recovered->GetNumberOfDiscardedBytes() != 20 ||
+      ReadFile( journalFileName ) != contents || !CompareGraphs( graph, recovered->GetGraph() ) )
+    {
+      std::cerr << "Torn record not discarded." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // So is a record with a wrong checksum
+    std::string corrupted = contents;
+    corrupted[ corrupted.size() - 1 ] ^= 1;
+    WriteFile( journalFileName, corrupted );
+    
+    recovered->Recover();
+    
+    if( recovered->GetNumberOfReplayedRecords() != 6 || recovered->GetNumberOfDiscardedBytes() == 0 ||
+      recovered->GetGraph()->FindNodeById( 4 ) == 0 )
+    {
+      std::cerr << "Corrupted record not discarded." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    WriteFile( journalFileName, contents );
+    recovered->Recover();
+    
+    // The journal of a previous snapshot is discarded
+    recovered->Compact();
+    
+    if( recovered->GetNumberOfRecords() != 0 || recovered->GetNumberOfCompactions() != 1 ||
+      ReadFile( journalFileName ).size() != emptySize )
+    {
+      std::cerr << "Journal not emptied by the compaction." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    WriteFile( journalFileName, contents );
+    recovered->Recover();
+    
+    if( recovered->GetNumberOfReplayedRecords() != 0 || 
+      recovered->GetNumberOfDiscardedBytes() != contents.size() - emptySize ||
+      !CompareGraphs( graph, recovered->GetGraph() ) )
+    {
+      std::cerr << "Journal of a previous snapshot replayed." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Compaction every three records
+    journal = JournalType::New();
+    journal->SetFileName( journalFileName );
+    journal->SetSnapshotFileName( snapshotFileName );
+    journal->SetCompactionInterval( 3 );
+    journal->Create( graph );
+    
+    for( unsigned int i=0; i<4; ++i )
+    {
+      // The graph is written by the compactions, so its node lists must be up to date
+      bifurcation2->RemoveChild( branch5.GetPointer() );
+      branch5->RemoveParent( bifurcation2.GetPointer() );
+      graph->Modified();
+      journal->AppendUnlinkNodes( 2, 5 );
+      
+      bifurcation2->InsertChild( ( i % 2 ) ? 1 : 0, branch5 );
+      graph->Modified();
+      journal->AppendLinkNodes( 2, 5, ( i % 2 ) ? 1 : 0 );
+    }
+    
+    if( journal->GetNumberOfCompactions() != 2 || journal->GetNumberOfRecords() != 2 )
+    {
+      std::cerr << "Wrong automatic compactions." << std::endl;
+      journal->Print( std::cerr );
+      return EXIT_FAILURE;
+    }
+    
+    journal->Close();
+    recovered->Recover();
+    
+    if( recovered->GetNumberOfReplayedRecords() != 2 || !CompareGraphs( graph, recovered->GetGraph() ) )
+    {
+      std::cerr << "Wrong graph recovered after the compactions." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    std::cerr << e << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanAdditiveGaussianNoiseImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests that the additive Gaussian noise does not depend on the number of threads and 
+//   has the requested statistics.
+
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkAdditiveGaussianNoiseImageFilter.h"
+#include "itkPhiloxRandomVariateGenerator.h"
+
+#include <iostream>
+#include <cmath>
+
+
+const unsigned int Dimension = 3;
+typedef float  PixelType;
+typedef itk::Image<PixelType,Dimension>  ImageType;
+typedef itk::AdditiveGaussianNoiseImageFilter<ImageType,ImageType>  NoiseFilterType;
+
+
+ImageType::Pointer AddNoise( ImageType *input, int numberOfThreads, unsigned int seed )
+{
+  NoiseFilterType::Pointer noiseFilter = NoiseFilterType::New();
+  noiseFilter->SetInput( input );
+  noiseFilter->SetMean( 0.0 );
+  noiseFilter->SetStandardDeviation( 10.0 );
+  noiseFilter->SetSeed( seed );
+  noiseFilter->SetNumberOfThreads( numberOfThreads );
+  noiseFilter->Update();
+  
+  ImageType::Pointer output = noiseFilter->GetOutput();
+  output->DisconnectPipeline();
+  
+  return output;
+}
+
+
+unsigned long CountDifferences( ImageType *image1, ImageType *image2 )
+{
+  typedef itk::ImageRegionConstIterator<ImageType>  IteratorType;
+  
+  IteratorType it1( image1, image1->GetLargestPossibleRegion() );
+  IteratorType it2( image2, image2->GetLargestPossibleRegion() );
+  
+  unsigned long differences = 0;
+  
+  for( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+  {
+    if( it1.Get() != it2.Get() )
+      ++differences;
+  }
+  
+  return differences;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  // Known answer of Philox4x32-10 for a zero key and counter
+  
+  typedef itk::Statistics::PhiloxRandomVariateGenerator  RandomGeneratorType;
+  
+  RandomGeneratorType::BlockType block;
+  RandomGeneratorType( 0 ).Generate( 0, block );
+  
+  if( block.Value[0] != 0x6627e8d5U || block.Value[1] != 0xe169c58dU || 
+      block.Value[2] != 0xbc57ac4cU || block.Value[3] != 0x9b00dbd8U )
+  {
+    std::cerr << "Wrong Philox4x32-10 output for a zero key and counter." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Constant input image, with a row length that is not a multiple of four
+  
+  ImageType::Pointer input = ImageType::New();
+  
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 30;
+  size[2] = 20;
+  
+  ImageType::RegionType region;
+  region.SetSize( size );
+  
+  input->SetRegions( region );
+  input->Allocate();
+  input->FillBuffer( 100.0 );
+  
+  ImageType::Pointer singleThreaded = AddNoise( input, 1, 7 );
+  ImageType::Pointer multiThreaded  = AddNoise( input, 4, 7 );
+  ImageType::Pointer otherSeed      = AddNoise( input, 4, 8 );
+  
+  unsigned long differences = CountDifferences( singleThreaded, multiThreaded );
+  
+  if( differences > 0 )
+  {
+    std::cerr << differences << " pixels differ between 1 and 4 threads." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( CountDifferences( singleThreaded, otherSeed ) == 0 )
+  {
+    std::cerr << "Different seeds give the same noise." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Statistics of the noise
+  
+  typedef itk::ImageRegionConstIterator<ImageType>  IteratorType;
+  IteratorType it( singleThreaded, singleThreaded->GetLargestPossibleRegion() );
+  
+  double sum = 0.0, squaredSum = 0.0;
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double noise = it.Get() - 100.0;
+    sum += noise;
+    squaredSum += noise * noise;
+  }
+  
+  const double numberOfPixels = region.GetNumberOfPixels();
+  const double mean = sum / numberOfPixels;
+  const double sigma = std::sqrt( squaredSum / numberOfPixels - mean * mean );
+  
+  std::cout << "Noise mean: " << mean << " sigma: " << sigma << std::endl;
+  
+  if( std::fabs( mean ) > 0.5 || std::fabs( sigma - 10.0 ) > 0.5 )
+  {
+    std::cerr << "Noise statistics are not the requested ones." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
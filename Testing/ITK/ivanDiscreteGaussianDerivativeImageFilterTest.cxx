@@ -0,0 +1,143 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanDiscreteGaussianDerivativeImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: compares the separable passes of the discrete gaussian derivative filter with the 
+//   mini-pipeline of neighborhood operator filters, for several orders, threads and stream divisions.
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkDiscreteGaussianDerivativeImageFilter.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+
+const unsigned int Dimension = 3;
+
+typedef float                                     PixelType;
+typedef itk::Image<PixelType,Dimension>           ImageType;
+
+typedef itk::DiscreteGaussianDerivativeImageFilter<ImageType,ImageType>   FilterType;
+
+
+ImageType::Pointer ComputeDerivative( ImageType *image, const FilterType::OrderArrayType & order,
+  bool useNeighborhoodFilters, unsigned int numberOfThreads, unsigned int numberOfDivisions )
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetOrder( order );
+  filter->SetVariance( 2.0 );
+  filter->SetMaximumError( 0.005 );
+  filter->SetMaximumKernelWidth( 32 );
+  filter->SetNormalizeAcrossScale( true );
+  filter->SetUseNeighborhoodFilters( useNeighborhoodFilters );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->SetInternalNumberOfStreamDivisions( numberOfDivisions );
+  filter->Update();
+  
+  return filter->GetOutput();
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Maximum difference relative to the maximum absolute value of the derivative
+  const double tolerance = ( argc > 1 ) ? atof( argv[1] ) : 1e-5;
+  
+  // Oblique tube of gaussian section plus a ramp, with anisotropic spacing. The size 
+  // is not a multiple of the tile width so partial tiles are also tested.
+  ImageType::Pointer image = ImageType::New();
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 29;
+  size[2] = 23;
+  region.SetSize( size );
+  image->SetRegions( region );
+  
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.5;
+  image->SetSpacing( spacing );
+  image->Allocate();
+  
+  const double tubeSigma = 3.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double dx = it.GetIndex()[0] - 0.3 * it.GetIndex()[2] - 14.0;
+    const double dy = it.GetIndex()[1] - 13.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / ( 2.0 * tubeSigma * tubeSigma ) ) + 
+      0.5 * it.GetIndex()[2] );
+  }
+  
+  const unsigned int orders[4][Dimension] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 1 }, { 0, 0, 2 } };
+  const unsigned int threads[3] = { 1, 3, 8 };
+  const unsigned int divisions[3] = { 1, 4, 9 };
+  
+  for( unsigned int o=0; o<4; ++o )
+  {
+    FilterType::OrderArrayType order;
+    for( unsigned int d=0; d<Dimension; ++d )
+      order[d] = orders[o][d];
+    
+    ImageType::Pointer reference = ComputeDerivative( image, order, true, 1, 1 );
+    
+    for( unsigned int t=0; t<3; ++t )
+    {
+      ImageType::Pointer output = ComputeDerivative( image, order, false, threads[t], divisions[t] );
+      
+      double maxError = 0.0, maxValue = 0.0;
+      
+      itk::ImageRegionConstIterator<ImageType> rit( reference, region );
+      itk::ImageRegionConstIterator<ImageType> oit( output, region );
+      
+      for( rit.GoToBegin(), oit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++oit )
+      {
+        maxValue = std::max( maxValue, (double)std::fabs( rit.Get() ) );
+        maxError = std::max( maxError, (double)std::fabs( rit.Get() - oit.Get() ) );
+      }
+      
+      const double relativeError = maxError / maxValue;
+      
+      std::cout << "Order: " << order << " Threads: " << threads[t] << " Divisions: " << divisions[t]
+        << " Relative error: " << relativeError << std::endl;
+      
+      if( relativeError > tolerance )
+      {
+        std::cerr << "Separable passes differ from the neighborhood operator filters" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
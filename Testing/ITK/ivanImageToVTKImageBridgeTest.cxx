@@ -0,0 +1,171 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanImageToVTKImageBridgeTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the round trip of an image through the ITK and VTK bridges, with the
+//   source of the ITK image updated again while the VTK image is alive.
+
+#include "itkImage.h"
+#include "itkShiftScaleImageFilter.h"
+#include "itkImageToVTKImageBridge.h"
+#include "itkVTKImageToImageBridge.h"
+
+#include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkDataArray.h"
+
+#include <iostream>
+
+
+const unsigned int Dimension = 3;
+typedef float  PixelType;
+typedef itk::Image<PixelType,Dimension>  ImageType;
+
+typedef itk::ShiftScaleImageFilter<ImageType,ImageType>  ShiftFilterType;
+typedef itk::ImageToVTKImageBridge<ImageType>            ToVTKBridgeType;
+typedef itk::VTKImageToImageBridge<ImageType>            ToITKBridgeType;
+
+
+// Returns true if every scalar of the VTK image has the given value
+bool CheckScalars( vtkImageData *image, double value )
+{
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  
+  if( !scalars || scalars->GetNumberOfTuples() != 10 * 12 * 14 )
+    return false;
+  
+  for( vtkIdType i=0; i<scalars->GetNumberOfTuples(); ++i )
+  {
+    if( scalars->GetTuple1( i ) != value )
+      return false;
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::SizeType size;
+  size[0] = 10;
+  size[1] = 12;
+  size[2] = 14;
+  
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate();
+  input->FillBuffer( 1.0 );
+  
+  ShiftFilterType::Pointer shiftFilter = ShiftFilterType::New();
+  shiftFilter->SetInput( input );
+  shiftFilter->SetShift( 1.0 );
+  
+  ToVTKBridgeType::Pointer toVTKBridge = ToVTKBridgeType::New();
+  
+  vtkImageData *vtkImage = 0;
+  
+  try
+  {
+    shiftFilter->Update();
+    
+    toVTKBridge->SetInput( shiftFilter->GetOutput() );
+    toVTKBridge->Update();
+    
+    // The output of the bridge is replaced at every update, so keep this one
+    vtkImage = vtkImageData::New();
+    vtkImage->ShallowCopy( toVTKBridge->GetOutput() );
+    
+    if( vtkImage->GetPointData()->GetScalars()->GetVoidPointer( 0 ) != 
+      shiftFilter->GetOutput()->GetBufferPointer() )
+    {
+      std::cerr << "The VTK image does not wrap the ITK buffer." << std::endl;
+      vtkImage->Delete();
+      return EXIT_FAILURE;
+    }
+    
+    // Updating the source again gives its output a new buffer, the wrapped one must survive
+    shiftFilter->SetShift( 10.0 );
+    shiftFilter->Update();
+    
+    if( !CheckScalars( vtkImage, 2.0 ) )
+    {
+      std::cerr << "The wrapped buffer changed when the source was updated." << std::endl;
+      vtkImage->Delete();
+      return EXIT_FAILURE;
+    }
+    
+    toVTKBridge->Update();
+    
+    if( !CheckScalars( toVTKBridge->GetOutput(), 11.0 ) )
+    {
+      std::cerr << "The bridge does not wrap the new buffer." << std::endl;
+      vtkImage->Delete();
+      return EXIT_FAILURE;
+    }
+    
+    // Back to ITK from the first VTK image, after the ITK side has been released
+    shiftFilter = 0;
+    toVTKBridge = 0;
+    input = 0;
+    
+    ToITKBridgeType::Pointer toITKBridge = ToITKBridgeType::New();
+    toITKBridge->SetInput( vtkImage );
+    toITKBridge->Update();
+    
+    ImageType::Pointer output = toITKBridge->GetOutput();
+    
+    vtkImage->Delete();
+    vtkImage = 0;
+    toITKBridge = 0;
+    
+    if( output->GetBufferedRegion().GetSize() != size )
+    {
+      std::cerr << "Wrong size after the round trip: " << output->GetBufferedRegion().GetSize() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const PixelType *buffer = output->GetBufferPointer();
+    
+    for( unsigned long i=0; i<output->GetBufferedRegion().GetNumberOfPixels(); ++i )
+    {
+      if( buffer[i] != 2.0 )
+      {
+        std::cerr << "Wrong value after the round trip at pixel " << i << ": " << buffer[i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    
+    if( vtkImage )
+      vtkImage->Delete();
+      
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,332 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanBSplineVesselCenterlineInterpolatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the cubic spline resampling of centerlines. A circular arc must be 
+//   resampled on the circle with tangent normals, and the spline of an unevenly sampled curve 
+//   must match a reference whose second derivatives are obtained by solving the whole system.
+
+#include "ivanBSplineVesselCenterlineInterpolator.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::BSplineVesselCenterlineInterpolator
+  <CenterlineType>                                  InterpolatorType;
+
+
+void AddSection( CenterlineType * centerline, double x, double y, double nx, double ny, 
+  double radius )
+{
+  SectionType::Pointer section = SectionType::New();
+  
+  SectionType::PointType center;
+  center[0] = x;
+  center[1] = y;
+  center[2] = 0.0;
+  section->SetCenter( center );
+  
+  SectionType::VectorType normal;
+  normal[0] = nx;
+  normal[1] = ny;
+  normal[2] = 0.0;
+  normal.Normalize();
+  section->SetNormal( normal );
+  
+  section->SetRadius( radius );
+  section->SetScale( 2.0 * radius );
+  
+  centerline->push_back( section );
+}
+
+
+/** Second derivatives of the natural cubic spline through the values, obtained by Gaussian 
+  * elimination with partial pivoting of the whole system instead of the tridiagonal solve. */
+std::vector<double> SolveSecondDerivatives( const std::vector<double> & t, 
+  const std::vector<double> & values )
+{
+  const unsigned int n = t.size();
+  const unsigned int m = n - 2;
+  
+  std::vector< std::vector<double> > A( m, std::vector<double>( m + 1, 0.0 ) );
+  
+  for( unsigned int r=0; r<m; ++r )
+  {
+    const unsigned int k = r + 1;
+    const double h0 = t[k] - t[k-1];
+    const double h1 = t[k+1] - t[k];
+    
+    if( r > 0 )
+      A[r][r-1] = h0;
+    
+    A[r][r] = 2.0 * ( h0 + h1 );
+    
+    if( r + 1 < m )
+      A[r][r+1] = h1;
+    
+    A[r][m] = 6.0 * ( ( values[k+1] - values[k] ) / h1 - ( values[k] - values[k-1] ) / h0 );
+  }
+  
+  for( unsigned int c=0; c<m; ++c )
+  {
+    unsigned int pivot = c;
+    
+    for( unsigned int r=c+1; r<m; ++r )
+    {
+      if( std::fabs( A[r][c] ) > std::fabs( A[pivot][c] ) )
+        pivot = r;
+    }
+    
+    std::swap( A[c], A[pivot] );
+    
+    for( unsigned int r=c+1; r<m; ++r )
+    {
+      const double factor = A[r][c] / A[c][c];
+      
+      for( unsigned int j=c; j<=m; ++j )
+        A[r][j] -= factor * A[c][j];
+    }
+  }
+  
+  std::vector<double> M( n, 0.0 );
+  
+  for( unsigned int r=m; r>0; --r )
+  {
+    double sum = A[r-1][m];
+    
+    for( unsigned int j=r; j<m; ++j )
+      sum -= A[r-1][j] * M[j+1];
+    
+    M[r] = sum / A[r-1][r-1];
+  }
+  
+  return M;
+}
+
+
+/** Value and derivative of the spline at the given position. */
+double EvaluateSpline( const std::vector<double> & t, const std::vector<double> & values,
+  const std::vector<double> & M, double position, double & derivative )
+{
+  unsigned int k = 0;
+  
+  while( k + 2 < t.size() && position > t[k+1] )
+    ++k;
+  
+  const double h = t[k+1] - t[k];
+  const double A = ( t[k+1] - position ) / h;
+  const double B = 1.0 - A;
+  
+  derivative = ( values[k+1] - values[k] ) / h - ( 3.0 * A * A - 1.0 ) * h * M[k] / 6.0 + 
+    ( 3.0 * B * B - 1.0 ) * h * M[k+1] / 6.0;
+  
+  return A * values[k] + B * values[k+1] + 
+    ( ( A * A * A - A ) * M[k] + ( B * B * B - B ) * M[k+1] ) * h * h / 6.0;
+}
+
+
+int main( int, char ** )
+{
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  
+  // Quarter of a circle of radius 10 around the origin, with normals along the arc
+  const double circleRadius = 10.0;
+  const unsigned int numberOfArcSections = 13;
+  
+  CenterlineType::Pointer arc = CenterlineType::New();
+  
+  for( unsigned int i=0; i<numberOfArcSections; ++i )
+  {
+    const double angle = 0.5 * vnl_math::pi * i / ( numberOfArcSections - 1 );
+    AddSection( arc, circleRadius * std::cos( angle ), circleRadius * std::sin( angle ),
+      -std::sin( angle ), std::cos( angle ), 1.0 );
+  }
+  
+  const double samplingDistance = 0.25;
+  const double chordLength = ( numberOfArcSections - 1 ) * 2.0 * circleRadius * 
+    std::sin( 0.25 * vnl_math::pi / ( numberOfArcSections - 1 ) );
+  
+  interpolator->SetSamplingDistance( samplingDistance );
+  CenterlineType::Pointer resampledArc = interpolator->Evaluate( arc.GetPointer() );
+  
+  unsigned int expectedSize = static_cast<unsigned int>( chordLength / samplingDistance ) + 1;
+  
+  if( chordLength - ( expectedSize - 1 ) * samplingDistance > 1e-6 * samplingDistance )
+    ++expectedSize;
+  
+  if( resampledArc->size() != expectedSize || arc->size() != numberOfArcSections ||
+    std::fabs( resampledArc->GetLastSection()->GetArclength() - chordLength ) > 1e-9 ||
+    resampledArc->GetLastSection()->GetCenter().EuclideanDistanceTo( 
+      arc->GetLastSection()->GetCenter() ) > 1e-9 )
+  {
+    std::cerr << "Resampled arc has " << resampledArc->size() << " sections, expected " 
+      << expectedSize << " ending at the last center" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<resampledArc->size(); ++i )
+  {
+    const SectionType *section = resampledArc->at(i);
+    
+    SectionType::VectorType radial = section->GetCenter().GetVectorFromOrigin();
+    const double distance = radial.GetNorm();
+    radial /= distance;
+    
+    SectionType::VectorType tangent;
+    tangent[0] = -radial[1];
+    tangent[1] = radial[0];
+    tangent[2] = 0.0;
+    
+    // The natural end conditions bend the spline near the ends, where the circle is curved
+    const bool interior = ( i >= resampledArc->size() / 4 && i < 3 * resampledArc->size() / 4 );
+    
+    if( std::fabs( distance - circleRadius ) > ( interior ? 1e-3 : 2e-2 ) ||
+      std::fabs( section->GetNormal().GetNorm() - 1.0 ) > 1e-9 ||
+      section->GetNormal() * tangent < ( interior ? 0.9999 : 0.99 ) ||
+      std::fabs( section->GetRadius() - 1.0 ) > 1e-9 ||
+      std::fabs( section->GetArclength() - 
+        vnl_math_min( i * samplingDistance, chordLength ) ) > 1e-9 )
+    {
+      std::cerr << "Wrong resampled arc section " << i << ": center " << section->GetCenter() 
+        << ", normal " << section->GetNormal() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Unevenly spaced curve, with a repeated center that must be skipped
+  const double x[] = { 0.0, 1.0, 3.0, 3.5, 6.0, 8.0, 8.5, 11.0 };
+  const double y[] = { 0.0, 2.0, -1.0, 0.5, 3.0, 0.0, 1.0, -2.0 };
+  const unsigned int numberOfKnots = 8;
+  const unsigned int repeatedKnot = 3;
+  
+  CenterlineType::Pointer curve = CenterlineType::New();
+  
+  for( unsigned int i=0; i<numberOfKnots; ++i )
+  {
+    AddSection( curve, x[i], y[i], 1.0, 0.0, 1.0 + i );
+    
+    if( i == repeatedKnot )
+      AddSection( curve, x[i], y[i], 1.0, 0.0, 1.0 + i );
+  }
+  
+  std::vector<double> t( numberOfKnots, 0.0 );
+  std::vector<double> xValues( x, x + numberOfKnots );
+  std::vector<double> yValues( y, y + numberOfKnots );
+  std::vector<double> radii( numberOfKnots );
+  
+  for( unsigned int i=0; i<numberOfKnots; ++i )
+  {
+    radii[i] = 1.0 + i;
+    
+    if( i > 0 )
+      t[i] = t[i-1] + std::sqrt( ( x[i] - x[i-1] ) * ( x[i] - x[i-1] ) + 
+        ( y[i] - y[i-1] ) * ( y[i] - y[i-1] ) );
+  }
+  
+  const std::vector<double> Mx = SolveSecondDerivatives( t, xValues );
+  const std::vector<double> My = SolveSecondDerivatives( t, yValues );
+  
+  // Without resampling, the sections are kept at the centers
+  interpolator->SetSamplingDistance( 0.0 );
+  CenterlineType::Pointer knots = interpolator->Evaluate( curve.GetPointer() );
+  
+  if( knots->size() != numberOfKnots )
+  {
+    std::cerr << "The repeated center was not skipped, " << knots->size() << " sections" 
+      << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<numberOfKnots; ++i )
+  {
+    const SectionType *section = knots->at(i);
+    
+    if( std::fabs( section->GetCenter()[0] - x[i] ) > 1e-9 || 
+      std::fabs( section->GetCenter()[1] - y[i] ) > 1e-9 ||
+      std::fabs( section->GetArclength() - t[i] ) > 1e-9 ||
+      std::fabs( section->GetRadius() - radii[i] ) > 1e-9 )
+    {
+      std::cerr << "Section " << i << " is not at the center " << x[i] << ", " << y[i] 
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Resampled in place, the spline and its tangent must match the reference
+  SectionType::Pointer firstSection = curve->at(0);
+  
+  interpolator->SetSamplingDistance( 0.1 );
+  CenterlineType::Pointer resampled = interpolator->Process( curve );
+  
+  if( resampled != curve || curve->at(0) != firstSection || 
+    curve->size() != static_cast<unsigned int>( t.back() / 0.1 ) + 2 )
+  {
+    std::cerr << "The curve was not resampled in place, " << curve->size() << " sections" 
+      << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<curve->size(); ++i )
+  {
+    const SectionType *section = curve->at(i);
+    const double position = section->GetArclength();
+    
+    double dx, dy;
+    const double expectedX = EvaluateSpline( t, xValues, Mx, position, dx );
+    const double expectedY = EvaluateSpline( t, yValues, My, position, dy );
+    
+    double unused;
+    const double expectedRadius = EvaluateSpline( t, radii, 
+      std::vector<double>( numberOfKnots, 0.0 ), position, unused );
+    
+    // Normals are oriented as the input ones, along x
+    const double norm = ( dx < 0.0 ? -1.0 : 1.0 ) * std::sqrt( dx * dx + dy * dy );
+    
+    if( std::fabs( position - vnl_math_min( 0.1 * i, t.back() ) ) > 1e-9 ||
+      std::fabs( section->GetCenter()[0] - expectedX ) > 1e-9 ||
+      std::fabs( section->GetCenter()[1] - expectedY ) > 1e-9 ||
+      std::fabs( section->GetCenter()[2] ) > 1e-9 ||
+      std::fabs( section->GetNormal()[0] - dx / norm ) > 1e-9 ||
+      std::fabs( section->GetNormal()[1] - dy / norm ) > 1e-9 ||
+      std::fabs( section->GetRadius() - expectedRadius ) > 1e-9 )
+    {
+      std::cerr << "Resampled section " << i << " at " << position << " is " 
+        << section->GetCenter() << ", expected " << expectedX << ", " << expectedY << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
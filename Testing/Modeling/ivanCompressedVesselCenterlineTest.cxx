@@ -0,0 +1,155 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCompressedVesselCenterlineTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the compact encoding of centerline sections and its error bounds.
+
+#include "ivanCompressedVesselCenterline.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::CircularVesselSection<3>              SectionType;
+  typedef ivan::VesselCenterline
+    <unsigned int, SectionType>                       CenterlineType;
+  
+  const unsigned int numberOfSections = 200;
+  const double precision = 0.001;
+  
+  // Helix with varying radius and a zero normal at the end
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const double t = 0.1 * i;
+    
+    SectionType::PointType center;
+    center[0] = 10.0 * std::cos( t );
+    center[1] = 10.0 * std::sin( t );
+    center[2] = -50.0 + 0.5 * t;
+    
+    SectionType::VectorType normal;
+    normal[0] = -10.0 * std::sin( t );
+    normal[1] = 10.0 * std::cos( t );
+    normal[2] = -0.5;
+    normal.Normalize();
+    
+    if( i == numberOfSections - 1 )
+      normal.Fill( 0.0 );
+    
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( 2.0 + std::sin( 3.0 * t ) );
+    section->SetScale( 1.5 );
+    section->SetArclength( t * std::sqrt( 100.25 ) );
+    centerline->push_back( section );
+  }
+  
+  ivan::CompressedVesselCenterline::Pointer compressedCenterline = ivan::CompressedVesselCenterline::New();
+  compressedCenterline->SetPrecision( precision );
+  compressedCenterline->Compress( centerline.GetPointer() );
+  
+  const unsigned long uncompressedSize = numberOfSections * 9 * sizeof(double);
+  
+  std::cout << "Compressed " << uncompressedSize << " bytes to " << compressedCenterline->GetBufferSize()
+    << " bytes." << std::endl;
+  
+  if( compressedCenterline->GetNumberOfSections() != numberOfSections || 
+    compressedCenterline->GetDimension() != 3 || compressedCenterline->GetBufferSize() * 4 > uncompressedSize )
+  {
+    std::cerr << "Wrong compressed centerline." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Copy the buffer, as when read from a file
+  ivan::CompressedVesselCenterline::Pointer readCenterline = ivan::CompressedVesselCenterline::New();
+  readCenterline->SetBuffer( &compressedCenterline->GetBuffer()[0], compressedCenterline->GetBufferSize() );
+  
+  CenterlineType::Pointer decompressedCenterline = CenterlineType::New();
+  readCenterline->Decompress( decompressedCenterline.GetPointer() );
+  
+  if( decompressedCenterline->size() != numberOfSections )
+  {
+    std::cerr << "Wrong number of decompressed sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const SectionType *original = centerline->at(i);
+    const SectionType *section = decompressedCenterline->at(i);
+    
+    const double normalError = ( section->GetNormal() - original->GetNormal() ).GetNorm();
+    
+    if( section->GetCenter().EuclideanDistanceTo( original->GetCenter() ) > precision ||
+      normalError > 2e-4 ||
+      std::fabs( section->GetRadius() - original->GetRadius() ) > 5e-4 * original->GetRadius() ||
+      section->GetScale() != original->GetScale() ||
+      std::fabs( section->GetArclength() - original->GetArclength() ) > precision )
+    {
+      std::cerr << "Section " << i << " decompressed with a wrong error." << std::endl;
+      section->Print( std::cerr );
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Codes of values outside the normal range
+  if( ivan::CompressedVesselCenterline::DecodeHalf( ivan::CompressedVesselCenterline::EncodeHalf( 1e-6 ) ) <= 0.0 ||
+    ivan::CompressedVesselCenterline::DecodeHalf( ivan::CompressedVesselCenterline::EncodeHalf( -2.0 ) ) != -2.0 ||
+    ivan::CompressedVesselCenterline::DecodeHalf( ivan::CompressedVesselCenterline::EncodeHalf( 1e6 ) ) < 1e6 )
+  {
+    std::cerr << "Wrong half precision conversion." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Corrupt buffer
+  bool caught = false;
+  
+  try
+  {
+    ivan::CompressedVesselCenterline::BufferType buffer = compressedCenterline->GetBuffer();
+    buffer.resize( buffer.size() / 2 );
+    readCenterline->SetBuffer( &buffer[0], buffer.size() );
+    readCenterline->Decompress( decompressedCenterline.GetPointer() );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    caught = true;
+  }
+  
+  if( !caught )
+  {
+    std::cerr << "Truncated buffer not detected." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
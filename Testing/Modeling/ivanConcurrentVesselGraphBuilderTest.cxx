@@ -0,0 +1,192 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanConcurrentVesselGraphBuilderTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests building a vessel graph from branches added by several threads.
+
+#include "ivanConcurrentVesselGraphBuilder.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkMultiThreader.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+typedef ivan::ConcurrentVesselGraphBuilder<CenterlineType>   BuilderType;
+
+const unsigned int NumberOfThreads = 4;
+const unsigned int BranchesPerThread = 50;
+const unsigned int SectionsPerBranch = 10;
+
+
+// Each thread adds branches below the root, each with a bifurcation and a child branch
+ITK_THREAD_RETURN_TYPE BuildBranches( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)( arg );
+  BuilderType *builder = (BuilderType *)( info->UserData );
+  BuilderType::ThreadBuffer *buffer = builder->GetThreadBuffer( info->ThreadID );
+  
+  for( unsigned int i=0; i < BranchesPerThread; ++i )
+  {
+    for( unsigned int level=0; level < 2; ++level )
+    {
+      ivan::GraphNode::NodeIdentifier parentId = 0;
+      
+      if( level > 0 )
+      {
+        BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+        parentId = buffer->AddNode( bifurcation, buffer->GetCurrentBranch()->GetNodeId() );
+      }
+      
+      buffer->AddBranch( parentId );
+      
+      for( unsigned int j=0; j < SectionsPerBranch; ++j )
+      {
+        SectionType::PointType center;
+        center[0] = info->ThreadID;
+        center[1] = i;
+        center[2] = j;
+        
+        SectionType::Pointer section = SectionType::New();
+        section->SetCenter( center );
+        section->SetRadius( 1.0 + level );
+        buffer->AddSection( section );
+      }
+    }
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+int main( int, char ** )
+{
+  BuilderType::Pointer builder = BuilderType::New();
+  builder->SetNumberOfThreads( NumberOfThreads );
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( BuildBranches, builder.GetPointer() );
+  threader->SingleMethodExecute();
+  
+  // Fewer threads may have been started than requested
+  const unsigned int numberOfThreads = threader->GetNumberOfThreads();
+  const unsigned int numberOfNodes = numberOfThreads * BranchesPerThread * 3;
+  
+  if( builder->GetNumberOfNodeIds() != numberOfNodes + 1 )
+  {
+    std::cerr << "Wrong number of identifiers: " << builder->GetNumberOfNodeIds() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  try
+  {
+    builder->Commit();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  GraphType::Pointer graph = builder->GetOutput();
+  graph->SetUseNodeIndex( true );
+  
+  ivan::VesselNode::Pointer rootNode = graph->GetRootNode();
+  
+  if( rootNode->GetNumberOfChildren() != numberOfThreads * BranchesPerThread )
+  {
+    std::cerr << "Wrong number of root branches: " << rootNode->GetNumberOfChildren() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Identifiers are unique and every node is linked below its parent, in identifier order
+  for( unsigned int id=1; id <= numberOfNodes; ++id )
+  {
+    const ivan::GraphNode *node = graph->FindNodeById( id );
+    
+    if( !node || node->GetNumberOfParents() != 1 || node->GetParent()->GetNodeId() >= id )
+    {
+      std::cerr << "Wrong node " << id << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const BranchNodeType *branch = dynamic_cast<const BranchNodeType *>( node );
+    
+    if( branch && ( branch->GetCenterline()->size() != SectionsPerBranch || 
+      node->GetDepthLevel() != ( node->GetParent() == rootNode.GetPointer() ? 1 : 3 ) ) )
+    {
+      std::cerr << "Wrong branch " << id << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  for( unsigned int i=1; i < rootNode->GetNumberOfChildren(); ++i )
+  {
+    if( rootNode->GetChild( i )->GetNodeId() <= rootNode->GetChild( i - 1 )->GetNodeId() )
+    {
+      std::cerr << "Children not in identifier order." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A parent that was never added
+  BuilderType::ThreadBuffer *buffer = builder->GetThreadBuffer( 0 );
+  buffer->AddBranch( 0 );
+  buffer->AddBranch( 5 );
+  
+  bool caught = false;
+  
+  try
+  {
+    builder->Commit();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    caught = true;
+  }
+  
+  if( !caught )
+  {
+    std::cerr << "Unknown parent not detected." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests freezing a vessel graph into arrays, queries on the arrays and thawing it back.
+
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>     FrozenGraphType;
+
+
+int main( int argc, char ** argv )
+{
+  // 1 -> 2 -> { 3, 4 } -> 5 -> 6, where bifurcation 5 has two parents
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 3, 2.0 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 2, 2.0 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 4, 2.0 );
+  BranchNodeType::Pointer branch6 = CreateTestBranch<BranchNodeType>( 6, 1, 2.0 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  BifurcationNodeType::Pointer bifurcation5 = BifurcationNodeType::New();
+  bifurcation5->SetNodeId( 5 );
+  bifurcation5->SetMask( 2 );
+  
+  std::string name = "confluence";
+  bifurcation5->SetName( name );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  branch3->AddChild( bifurcation5 );
+  branch4->AddChild( bifurcation5 );
+  bifurcation5->AddChild( branch6 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  FrozenGraphType::Pointer frozen = FrozenGraphType::New();
+  frozen->Freeze( graph );
+  
+  // Prototypes are empty nodes of the frozen types, not the nodes of the graph
+  const ivan::GraphNode *branchPrototype = 
+    frozen->GetNodePrototype( BranchNodeType::GetNodeTypeIdStatic() );
+  const BranchNodeType *branchPrototypeNode = dynamic_cast<const BranchNodeType*>( branchPrototype );
+  const ivan::GraphNode *bifurcationPrototype = 
+    frozen->GetNodePrototype( BifurcationNodeType::GetNodeTypeIdStatic() );
+  
+  if( !branchPrototypeNode || branchPrototype == branch1.GetPointer() ||
+    branchPrototype->GetNumberOfChildren() != 0 || branchPrototype->GetNumberOfParents() != 0 ||
+    ( branchPrototypeNode->GetCenterline() && !branchPrototypeNode->GetCenterline()->empty() ) ||
+    !dynamic_cast<const BifurcationNodeType*>( bifurcationPrototype ) ||
+    bifurcationPrototype == bifurcation2.GetPointer() ||
+    bifurcationPrototype->GetNumberOfChildren() != 0 )
+  {
+    std::cerr << "The node prototypes are not empty nodes of the frozen types." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Shared nodes are stored once, in depth-first preorder
+  const ivan::GraphNode::NodeIdentifier expectedIds[] = { 1, 2, 3, 5, 6, 4 };
+  
+  if( frozen->GetNumberOfNodes() != 6 || frozen->GetTotalNumberOfSections() != 10 )
+  {
+    std::cerr << "Frozen " << frozen->GetNumberOfNodes() << " nodes and " 
+      << frozen->GetTotalNumberOfSections() << " sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int n=0; n<6; ++n )
+  {
+    if( frozen->GetNodeId( n ) != expectedIds[n] || frozen->FindNodeById( expectedIds[n] ) != n )
+    {
+      std::cerr << "Wrong node at index " << n << ": " << frozen->GetNodeId( n ) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( frozen->FindNodeById( 7 ) != FrozenGraphType::GetNullNodeIndex() )
+  {
+    std::cerr << "Found a node that does not exist." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const FrozenGraphType::NodeIndex confluence = frozen->FindNodeById( 5 );
+  
+  if( frozen->GetNumberOfParents( confluence ) != 2 || 
+    frozen->GetNodeId( frozen->GetParent( confluence, 0 ) ) != 3 ||
+    frozen->GetNodeId( frozen->GetParent( confluence, 1 ) ) != 4 ||
+    frozen->GetNumberOfChildren( 1 ) != 2 || frozen->GetNumberOfChildren( 4 ) != 0 ||
+    frozen->GetMask( confluence ) != 2 || frozen->GetName( confluence ) != name ||
+    frozen->GetDepthLevel( confluence ) != bifurcation5->GetDepthLevel() )
+  {
+    std::cerr << "Wrong links or data of the shared node." << std::endl;
+    frozen->Print( std::cerr );
+    return EXIT_FAILURE;
+  }
+  
+  if( frozen->CountNodes( BranchNodeType::GetNodeTypeIdStatic() ) != 4 ||
+    frozen->CountNodes( BifurcationNodeType::GetNodeTypeIdStatic() ) != 2 ||
+    frozen->CountNodes( BifurcationNodeType::GetNodeTypeIdStatic(), 2 ) != 1 )
+  {
+    std::cerr << "Wrong node counts." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const FrozenGraphType::NodeIndex longest = frozen->FindNodeById( 4 );
+  
+  if( !frozen->IsBranch( longest ) || frozen->IsBranch( confluence ) ||
+    frozen->GetNumberOfSections( longest ) != 4 || 
+    frozen->GetSection( longest, 2 ) != branch4->GetCenterline()->at(2).GetPointer() ||
+    std::fabs( frozen->ComputeBranchLength( longest ) - 6.0 ) > 1e-9 )
+  {
+    std::cerr << "Wrong sections of branch 4." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Thaw and compare with the original graph
+  GraphType::Pointer thawed = frozen->Thaw();
+  
+  const ivan::GraphNode *root = thawed->GetRootNode();
+  const BranchNodeType *thawedBranch1 = dynamic_cast<const BranchNodeType*>( root );
+  
+  if( !thawedBranch1 || root == branch1.GetPointer() || root->GetNodeId() != 1 ||
+    thawedBranch1->GetCenterline()->size() != 3 ||
+    thawedBranch1->GetCenterline()->at(0) != branch1->GetCenterline()->at(0) )
+  {
+    std::cerr << "Wrong thawed root." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const ivan::GraphNode *thawedBifurcation2 = root->GetChild( 0 );
+  
+  if( !dynamic_cast<const BifurcationNodeType*>( thawedBifurcation2 ) ||
+    thawedBifurcation2->GetNumberOfChildren() != 2 )
+  {
+    std::cerr << "Wrong thawed bifurcation." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const ivan::GraphNode *thawedBifurcation5 = thawedBifurcation2->GetChild( 0 )->GetChild( 0 );
+  
+  if( thawedBifurcation5 != thawedBifurcation2->GetChild( 1 )->GetChild( 0 ) ||
+    thawedBifurcation5->GetNumberOfParents() != 2 || thawedBifurcation5->GetNodeId() != 5 ||
+    thawedBifurcation5->GetMask() != 2 || thawedBifurcation5->GetName() != name ||
+    thawedBifurcation5->GetDepthLevel() != bifurcation5->GetDepthLevel() ||
+    thawedBifurcation5->GetChild( 0 )->GetNodeId() != 6 )
+  {
+    std::cerr << "Wrong thawed shared node." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // An empty graph freezes to an empty snapshot
+  frozen->Freeze( GraphType::New() );
+  
+  if( frozen->GetNumberOfNodes() != 0 || frozen->Thaw()->GetRootNode().IsNotNull() )
+  {
+    std::cerr << "Freezing an empty graph did not clear the snapshot." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphTubeMeshGeneratorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the tube mesh generated for the branches of a frozen graph.
+
+#include "ivanFrozenVesselGraphTubeMeshGenerator.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>     FrozenGraphType;
+typedef ivan::FrozenVesselGraphTubeMeshGenerator
+  <CenterlineType>                                  GeneratorType;
+
+
+/** Straight branch of unit spacing from the origin along the given direction. The section 
+  * normals are only set if requested. */
+BranchNodeType::Pointer CreateBranch( unsigned int id, const SectionType::PointType & origin,
+  const SectionType::VectorType & direction, unsigned int numberOfSections, double radius, bool setNormals )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  SectionType::PointType center = origin;
+  SectionType::VectorType normal = direction;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetRadius( radius );
+    if( setNormals )
+      section->SetNormal( normal );
+    centerline->push_back( section );
+    
+    center += direction;
+  }
+  
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetNodeId( id );
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+/** Check that the vertices of a branch lie on a cylinder around the line from origin along 
+  * the unit direction, and that the normals are unit and radial. */
+bool CheckBranch( const GeneratorType *generator, const FrozenGraphType *frozen, 
+  FrozenGraphType::NodeIndex node, const SectionType::PointType & origin, 
+  const SectionType::VectorType & direction, double radius )
+{
+  const unsigned long offset = generator->GetVertexOffset( node );
+  const unsigned long numberOfVertices = generator->GetNumberOfVertices( node );
+  const unsigned int ringSize = generator->GetNumberOfContourPoints();
+  
+  if( numberOfVertices != frozen->GetNumberOfSections( node ) * ringSize )
+  {
+    std::cerr << "Branch has " << numberOfVertices << " vertices." << std::endl;
+    return false;
+  }
+  
+  for( unsigned long i=0; i<numberOfVertices; ++i )
+  {
+    const float *vertex = &generator->GetVertices()[ 3 * ( offset + i ) ];
+    const float *normal = &generator->GetNormals()[ 3 * ( offset + i ) ];
+    
+    double along = 0.0, normalAlong = 0.0, normalNorm = 0.0;
+    for( unsigned int d=0; d<3; ++d )
+    {
+      along += ( vertex[d] - origin[d] ) * direction[d];
+      normalAlong += normal[d] * direction[d];
+      normalNorm += normal[d] * normal[d];
+    }
+    
+    double distance = 0.0;
+    for( unsigned int d=0; d<3; ++d )
+    {
+      const double radial = vertex[d] - origin[d] - along * direction[d];
+      distance += radial * radial;
+    }
+    distance = std::sqrt( distance );
+    
+    const double expectedAlong = (double)( i / ringSize );
+    
+    if( std::fabs( distance - radius ) > 1e-4 || std::fabs( along - expectedAlong ) > 1e-4 || 
+        std::fabs( normalAlong ) > 1e-4 || std::fabs( normalNorm - 1.0 ) > 1e-4 )
+    {
+      std::cerr << "Wrong vertex " << i << " of node " << node << ": distance " << distance 
+        << " along " << along << " normal along " << normalAlong << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  const double diagonal = std::sqrt( 0.5 );
+  
+  SectionType::PointType origin;
+  origin.Fill( 0.0 );
+  
+  SectionType::VectorType yAxis;
+  yAxis.Fill( 0.0 );
+  yAxis[1] = 1.0;
+  
+  SectionType::VectorType diagonalAxis;
+  diagonalAxis.Fill( 0.0 );
+  diagonalAxis[0] = diagonal;
+  diagonalAxis[1] = diagonal;
+  
+  // Branch 1 -> bifurcation 2 -> branch 3, only branch 1 has section normals
+  BranchNodeType::Pointer branch1 = CreateBranch( 1, origin, yAxis, 6, 2.0, true );
+  
+  SectionType::PointType bifurcationPoint = origin;
+  bifurcationPoint[1] = 5.0;
+  
+  BranchNodeType::Pointer branch3 = CreateBranch( 3, bifurcationPoint, diagonalAxis, 4, 1.0, false );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  FrozenGraphType::Pointer frozen = FrozenGraphType::New();
+  frozen->Freeze( graph );
+  
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->SetFrozenGraph( frozen );
+  generator->SetNumberOfContourPoints( 8 );
+  generator->SetNumberOfThreads( 2 );
+  generator->Generate();
+  
+  const unsigned int stripSize = 2 * ( 8 + 1 ) + 1;
+  
+  if( generator->GetNumberOfVertices() != ( 6 + 4 ) * 8 || 
+      generator->GetIndices().size() != ( 5 + 3 ) * stripSize )
+  {
+    std::cerr << "Generated " << generator->GetNumberOfVertices() << " vertices and " 
+      << generator->GetIndices().size() << " indices." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Every strip ends with the restart index, and the rest index existing vertices
+  for( unsigned long i=0; i<generator->GetIndices().size(); ++i )
+  {
+    const GeneratorType::IndexType index = generator->GetIndices()[i];
+    const bool restart = ( ( i + 1 ) % stripSize == 0 );
+    
+    if( restart != ( index == GeneratorType::GetRestartIndex() ) || 
+        ( !restart && index >= generator->GetNumberOfVertices() ) )
+    {
+      std::cerr << "Wrong index " << index << " at " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( !CheckBranch( generator, frozen, frozen->FindNodeById( 1 ), origin, yAxis, 2.0 ) || 
+      !CheckBranch( generator, frozen, frozen->FindNodeById( 3 ), bifurcationPoint, diagonalAxis, 1.0 ) )
+    return EXIT_FAILURE;
+  
+  if( generator->GetNumberOfVertices( frozen->FindNodeById( 2 ) ) != 0 )
+  {
+    std::cerr << "The bifurcation has vertices." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
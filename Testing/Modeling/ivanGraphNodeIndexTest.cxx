@@ -0,0 +1,167 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGraphNodeIndexTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the hash index of the nodes of a vessel graph under structural edits.
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanSearchByIdNodeVisitor.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+ivan::GraphNode::Pointer CreateNode( unsigned int id, bool branch )
+{
+  ivan::GraphNode::Pointer node;
+  
+  if( branch )
+    node = BranchNodeType::New().GetPointer();
+  else
+    node = BifurcationNodeType::New().GetPointer();
+    
+  node->SetNodeId( id );
+  return node;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // 1 -> 2 -> { 3, 4 }, 4 -> 5
+  ivan::GraphNode::Pointer node1 = CreateNode( 1, true );
+  ivan::GraphNode::Pointer node2 = CreateNode( 2, false );
+  ivan::GraphNode::Pointer node3 = CreateNode( 3, true );
+  ivan::GraphNode::Pointer node4 = CreateNode( 4, true );
+  ivan::GraphNode::Pointer node5 = CreateNode( 5, false );
+  
+  node1->AddChild( node2 );
+  node2->AddChild( node3 );
+  node2->AddChild( node4 );
+  node4->AddChild( node5 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( dynamic_cast<ivan::VesselNode*>( node1.GetPointer() ) );
+  graph->UseNodeIndexOn();
+  
+  if( graph->GetNodeIndex()->GetNumberOfNodes() != 5 || graph->FindNodeById( 5 ) != node5 ||
+    graph->FindNodeById( 7 ) != 0 || node3->GetNodeIndex() != graph->GetNodeIndex() )
+  {
+    std::cerr << "Wrong index after building it." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Nodes added below an indexed node are indexed
+  ivan::GraphNode::Pointer node6 = CreateNode( 6, false );
+  node3->AddChild( node6 );
+  
+  if( graph->FindNodeById( 6 ) != node6 || node3->GetChildById( 6 ) != node6 || 
+    node1->GetChildById( 6 ) != 0 )
+  {
+    std::cerr << "Added node not found." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Changing an identifier updates the index
+  node6->SetNodeId( 60 );
+  
+  if( graph->FindNodeById( 60 ) != node6 || graph->FindNodeById( 6 ) != 0 )
+  {
+    std::cerr << "Wrong index after changing an identifier." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A node with several parents stays until it is removed from all of them
+  node3->AddChild( node5 );
+  node4->RemoveChild( node5 );
+  
+  if( graph->FindNodeById( 5 ) != node5 )
+  {
+    std::cerr << "Shared node removed while still reachable." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  node2->RemoveChild( node3 );
+  
+  if( graph->GetNodeIndex()->GetNumberOfNodes() != 3 || graph->FindNodeById( 3 ) != 0 ||
+    graph->FindNodeById( 5 ) != 0 || graph->FindNodeById( 60 ) != 0 || node5->GetNodeIndex() )
+  {
+    std::cerr << "Removed subtree still indexed." << std::endl;
+    graph->GetNodeIndex()->Print( std::cerr );
+    return EXIT_FAILURE;
+  }
+  
+  // Replacing a child swaps the subtrees
+  node2->ReplaceChild( node4, node3 );
+  
+  if( graph->FindNodeById( 4 ) != 0 || graph->FindNodeById( 5 ) != node5 ||
+    graph->GetNodeIndex()->GetNumberOfNodes() != 5 )
+  {
+    std::cerr << "Wrong index after replacing a child." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The search visitor only returns descendants of the start node
+  ivan::SearchByIdNodeVisitor::Pointer visitor = ivan::SearchByIdNodeVisitor::New();
+  visitor->SetNodeId( 60 );
+  node2->Accept( visitor );
+  
+  if( visitor->GetNode() != node6 )
+  {
+    std::cerr << "Indexed search did not find the node." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  visitor->SetNodeId( 1 );
+  node3->Accept( visitor );
+  
+  if( visitor->GetNode() != 0 )
+  {
+    std::cerr << "Indexed search found an ancestor." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Without the index the graph is visited
+  graph->UseNodeIndexOff();
+  
+  if( node5->GetNodeIndex() || graph->FindNodeById( 5 ) != node5 || graph->FindNodeById( 4 ) != 0 )
+  {
+    std::cerr << "Wrong search without index." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,311 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanGraphNodeTraversalTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the order of the iterative graph traversal, node paths and traversal of long chains.
+
+#include "ivanGraphNode.h"
+#include "ivanGraphNodeVisitor.h"
+#include "ivanGraphCountNodeVisitor.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+
+/** Records the order in which nodes are visited and left. */
+class RecordNodesVisitor : public ivan::GraphNodeVisitor
+{
+public:
+
+  typedef RecordNodesVisitor                Self;
+  typedef ivan::GraphNodeVisitor            Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( RecordNodesVisitor, GraphNodeVisitor );
+  
+  virtual void Visit( ivan::GraphNode * node )
+    {
+      m_Visited.push_back( node->GetNodeId() );
+      
+      if( this->GetNodePath().size() > m_MaximumPathSize )
+        m_MaximumPathSize = this->GetNodePath().size();
+        
+      this->Traverse( node );
+    }
+    
+  virtual void Leave( ivan::GraphNode * node )
+    { m_Left.push_back( node->GetNodeId() ); }
+    
+  std::vector<unsigned int>   m_Visited;
+  std::vector<unsigned int>   m_Left;
+  unsigned int                m_MaximumPathSize;
+  
+protected:
+
+  RecordNodesVisitor() : m_MaximumPathSize( 0 ) {}
+};
+
+
+/** Records the visited nodes of the parallel traversal, separating those visited by the 
+  * task visitors. */
+class RecordTasksVisitor : public ivan::GraphNodeVisitor
+{
+public:
+
+  typedef RecordTasksVisitor                Self;
+  typedef ivan::GraphNodeVisitor            Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( RecordTasksVisitor, GraphNodeVisitor );
+  
+  virtual void Visit( ivan::GraphNode * node )
+    {
+      m_Visited.push_back( node->GetNodeId() );
+      this->Traverse( node );
+    }
+    
+  virtual GraphNodeVisitor::Pointer CreateTaskVisitor() const
+    { return Self::New().GetPointer(); }
+    
+  virtual void MergeTaskVisitor( GraphNodeVisitor * taskVisitor )
+    {
+      const std::vector<unsigned int> & visited = static_cast<Self*>( taskVisitor )->m_Visited;
+      m_TaskVisited.insert( m_TaskVisited.end(), visited.begin(), visited.end() );
+    }
+    
+  std::vector<unsigned int>   m_Visited;
+  std::vector<unsigned int>   m_TaskVisited;
+  
+protected:
+
+  RecordTasksVisitor() {}
+};
+
+
+bool CheckOrder( const std::vector<unsigned int> & order, const unsigned int *expected, 
+  unsigned int size, const char *description )
+{
+  bool ok = ( order.size() == size );
+  
+  for( unsigned int i=0; ok && i<size; ++i )
+    ok = ( order[i] == expected[i] );
+    
+  if( !ok )
+  {
+    std::cerr << "Wrong " << description << " order:";
+    for( unsigned int i=0; i<order.size(); ++i )
+      std::cerr << " " << order[i];
+    std::cerr << std::endl;
+  }
+  
+  return ok;
+}
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::GraphNode   NodeType;
+  
+  // Tree 0 -> ( 1 -> ( 3, 4 ), 2 )
+  std::vector<NodeType::Pointer> nodes;
+  
+  for( unsigned int i=0; i<5; ++i )
+  {
+    nodes.push_back( NodeType::New() );
+    nodes[i]->SetNodeId( i );
+  }
+  
+  nodes[0]->AddChild( nodes[1] );
+  nodes[0]->AddChild( nodes[2] );
+  nodes[1]->AddChild( nodes[3] );
+  nodes[1]->AddChild( nodes[4] );
+  
+  RecordNodesVisitor::Pointer visitor = RecordNodesVisitor::New();
+  nodes[0]->Accept( visitor );
+  
+  const unsigned int visited[] = { 0, 1, 3, 4, 2 };
+  const unsigned int left[] = { 3, 4, 1, 2, 0 };
+  
+  if( !CheckOrder( visitor->m_Visited, visited, 5, "visiting" ) || 
+    !CheckOrder( visitor->m_Left, left, 5, "leaving" ) || visitor->m_MaximumPathSize != 3 ||
+    !visitor->GetNodePath().empty() )
+    return EXIT_FAILURE;
+    
+  // Ascend from a leaf. The current node is at the front of the path
+  visitor = RecordNodesVisitor::New();
+  visitor->SetTraversalMode( RecordNodesVisitor::TraverseAllParents );
+  nodes[4]->Accept( visitor );
+  
+  const unsigned int ascended[] = { 4, 1, 0 };
+  
+  const unsigned int ascendedLeft[] = { 0, 1, 4 };
+  
+  if( !CheckOrder( visitor->m_Visited, ascended, 3, "ascending" ) || 
+    !CheckOrder( visitor->m_Left, ascendedLeft, 3, "ascending leave" ) )
+    return EXIT_FAILURE;
+  
+  // Inactive nodes are skipped with their children, unless traversing through them is enabled
+  // in the All modes
+  nodes[1]->SetMask( 0 );
+  
+  visitor = RecordNodesVisitor::New();
+  nodes[0]->Accept( visitor );
+  
+  const unsigned int visitedDefault[] = { 0, 2 };
+  
+  if( !CheckOrder( visitor->m_Visited, visitedDefault, 2, "visiting with inactive node" ) )
+    return EXIT_FAILURE;
+  
+  visitor = RecordNodesVisitor::New();
+  visitor->TraverseThroughMaskedNodesOn();
+  nodes[0]->Accept( visitor );
+  
+  const unsigned int visitedAll[] = { 0, 3, 4, 2 };
+  
+  if( !CheckOrder( visitor->m_Visited, visitedAll, 4, "visiting through inactive node" ) )
+    return EXIT_FAILURE;
+  
+  visitor = RecordNodesVisitor::New();
+  visitor->SetTraversalMode( RecordNodesVisitor::TraverseActiveChildren );
+  visitor->TraverseThroughMaskedNodesOn();
+  nodes[0]->Accept( visitor );
+  
+  const unsigned int visitedActive[] = { 0, 2 };
+  
+  if( !CheckOrder( visitor->m_Visited, visitedActive, 2, "visiting active nodes" ) )
+    return EXIT_FAILURE;
+  
+  // Count the nodes of a tree with four children per node in parallel
+  const unsigned int treeSize = 20000;
+  std::vector<NodeType::Pointer> tree( treeSize );
+  
+  for( unsigned int i=0; i<treeSize; ++i )
+  {
+    tree[i] = NodeType::New();
+    
+    if( i > 0 )
+      tree[(i-1)/4]->AddChild( tree[i] );
+  }
+  
+  typedef ivan::GraphCountNodeVisitor<NodeType>  CountVisitorType;
+  
+  CountVisitorType::Pointer counter = CountVisitorType::New();
+  counter->SetNumberOfThreads( 4 );
+  counter->SetParallelGrainSize( 100 );
+  tree[0]->Accept( counter );
+  
+  if( counter->GetCount() != treeSize )
+  {
+    std::cerr << "Counted " << counter->GetCount() << " of " << treeSize 
+      << " nodes in parallel." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Give some nodes of the tree a second parent in another subtree. Subtrees reaching them must 
+  // be visited by the main visitor, once per path, as in the serial traversal
+  std::vector<unsigned int> sharedNodes;
+  
+  for( unsigned int i=0; i<treeSize; ++i )
+    tree[i]->SetNodeId( i );
+  
+  for( unsigned int i=treeSize/2; i<treeSize; i+=997 )
+  {
+    tree[i/7]->AddChild( tree[i] );
+    sharedNodes.push_back( i );
+  }
+  
+  RecordTasksVisitor::Pointer serialRecorder = RecordTasksVisitor::New();
+  tree[0]->Accept( serialRecorder );
+  
+  RecordTasksVisitor::Pointer recorder = RecordTasksVisitor::New();
+  recorder->SetNumberOfThreads( 4 );
+  recorder->SetParallelGrainSize( 100 );
+  tree[0]->Accept( recorder );
+  
+  if( recorder->m_TaskVisited.empty() )
+  {
+    std::cerr << "No subtree of the graph was visited in parallel." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  std::vector<unsigned int> serialVisited = serialRecorder->m_Visited;
+  std::vector<unsigned int> parallelVisited = recorder->m_Visited;
+  parallelVisited.insert( parallelVisited.end(), recorder->m_TaskVisited.begin(), 
+    recorder->m_TaskVisited.end() );
+  
+  std::sort( serialVisited.begin(), serialVisited.end() );
+  std::sort( parallelVisited.begin(), parallelVisited.end() );
+  
+  if( parallelVisited != serialVisited )
+  {
+    std::cerr << "Visited " << parallelVisited.size() << " nodes of the acyclic graph in parallel "
+      << "and " << serialVisited.size() << " serially." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  std::sort( recorder->m_TaskVisited.begin(), recorder->m_TaskVisited.end() );
+  
+  for( unsigned int i=0; i<sharedNodes.size(); ++i )
+  {
+    if( std::binary_search( recorder->m_TaskVisited.begin(), recorder->m_TaskVisited.end(), 
+      sharedNodes[i] ) )
+    {
+      std::cerr << "Node " << sharedNodes[i] << " with two parents was visited by a task visitor." 
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A long chain must not exhaust the stack
+  const unsigned int chainLength = 200000;
+  std::vector<NodeType::Pointer> chain( chainLength );
+  
+  for( unsigned int i=0; i<chainLength; ++i )
+  {
+    chain[i] = NodeType::New();
+    chain[i]->SetNodeId( i );
+    
+    if( i > 0 )
+      chain[i-1]->AddChild( chain[i] );
+  }
+  
+  visitor = RecordNodesVisitor::New();
+  chain[0]->Accept( visitor );
+  
+  if( visitor->m_Visited.size() != chainLength || visitor->m_Visited.back() != chainLength - 1 ||
+    visitor->m_Left.front() != chainLength - 1 || visitor->m_MaximumPathSize != chainLength )
+  {
+    std::cerr << "Visited " << visitor->m_Visited.size() << " of " << chainLength 
+      << " nodes of the chain." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
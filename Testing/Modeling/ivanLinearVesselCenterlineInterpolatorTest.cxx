@@ -0,0 +1,197 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanLinearVesselCenterlineInterpolatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests arclength queries on an unevenly sampled centerline, the update of the 
+//   arclength index after edits and the resampling of the centerline.
+
+#include "ivanLinearVesselCenterlineInterpolator.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::LinearVesselCenterlineInterpolator
+  <CenterlineType>                                  InterpolatorType;
+
+
+/** Getter of the scale for EvaluateProperty(). */
+struct ScaleGetter
+{
+  double operator()( const SectionType * section ) const
+    { return section->GetScale(); }
+};
+
+
+void AddSection( CenterlineType * centerline, double x )
+{
+  SectionType::Pointer section = SectionType::New();
+  
+  SectionType::PointType center;
+  center[0] = x;
+  center[1] = 0.0;
+  center[2] = 0.0;
+  section->SetCenter( center );
+  
+  SectionType::VectorType normal;
+  normal[0] = 1.0;
+  normal[1] = 0.0;
+  normal[2] = 0.0;
+  section->SetNormal( normal );
+  
+  section->SetRadius( x + 1.0 );
+  section->SetScale( 2.0 * x );
+  
+  centerline->push_back( section );
+}
+
+
+bool CheckLength( const InterpolatorType * interpolator, double expected )
+{
+  if( std::fabs( interpolator->GetLength() - expected ) > 1e-9 )
+  {
+    std::cerr << "Length is " << interpolator->GetLength() << " instead of " << expected << std::endl;
+    return false;
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  // Sections along x at uneven distances
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  AddSection( centerline, 0.0 );
+  AddSection( centerline, 1.0 );
+  AddSection( centerline, 3.0 );
+  AddSection( centerline, 6.0 );
+  
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetCenterline( centerline );
+  
+  if( !CheckLength( interpolator, 6.0 ) )
+    return EXIT_FAILURE;
+  
+  double fraction;
+  
+  if( interpolator->FindSegment( 2.0, fraction ) != 1 || std::fabs( fraction - 0.5 ) > 1e-9 ||
+    interpolator->FindSegment( -1.0, fraction ) != 0 || fraction != 0.0 ||
+    interpolator->FindSegment( 8.0, fraction ) != 3 || fraction != 0.0 )
+  {
+    std::cerr << "Wrong segments" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Values are linear in x, and so in the arclength
+  for( double arclength = 0.0; arclength <= 6.0; arclength += 0.25 )
+  {
+    if( std::fabs( interpolator->EvaluateCenter( arclength )[0] - arclength ) > 1e-9 ||
+      std::fabs( interpolator->EvaluateRadius( arclength ) - ( arclength + 1.0 ) ) > 1e-9 ||
+      std::fabs( interpolator->EvaluateNormal( arclength )[0] - 1.0 ) > 1e-9 ||
+      std::fabs( interpolator->EvaluateProperty<double>( arclength, ScaleGetter() ) - 
+        2.0 * arclength ) > 1e-9 )
+    {
+      std::cerr << "Wrong values at arclength " << arclength << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  ivan::PointIdType first, last;
+  
+  interpolator->GetSectionRange( 0.5, 3.0, first, last );
+  
+  if( first != 1 || last != 2 )
+  {
+    std::cerr << "Wrong section range [" << first << "," << last << "]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  interpolator->GetSectionRange( 3.5, 5.5, first, last );
+  
+  if( first <= last )
+  {
+    std::cerr << "Section range should be empty" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Appended sections extend the index
+  AddSection( centerline, 10.0 );
+  
+  if( !CheckLength( interpolator, 10.0 ) )
+    return EXIT_FAILURE;
+  
+  // Marked sections are recomputed
+  SectionType::PointType center = centerline->at(3)->GetCenter();
+  center[1] = 4.0;
+  centerline->at(3)->SetCenter( center );
+  centerline->MarkModifiedSections( 3, 4 );
+  
+  if( !CheckLength( interpolator, 3.0 + 5.0 + std::sqrt( 32.0 ) ) )
+    return EXIT_FAILURE;
+  
+  // And everything after a modification of the centerline
+  centerline->ClearModifiedSections();
+  center = centerline->at(0)->GetCenter();
+  center[0] = -2.0;
+  centerline->at(0)->SetCenter( center );
+  centerline->Modified();
+  
+  if( !CheckLength( interpolator, 5.0 + 5.0 + std::sqrt( 32.0 ) ) )
+    return EXIT_FAILURE;
+  
+  // Resampling every half unit, keeping the last section
+  interpolator->SetSamplingDistance( 0.5 );
+  CenterlineType::Pointer resampled = interpolator->Evaluate( centerline.GetPointer() );
+  
+  if( resampled->size() != 33 || 
+    std::fabs( resampled->GetLastSection()->GetArclength() - interpolator->GetLength() ) > 1e-9 )
+  {
+    std::cerr << "Resampled centerline has " << resampled->size() << " sections" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i+1<resampled->size(); ++i )
+  {
+    const SectionType *section = resampled->at(i);
+    const double arclength = 0.5 * i;
+    
+    if( std::fabs( section->GetArclength() - arclength ) > 1e-9 || 
+      std::fabs( section->GetCenter().EuclideanDistanceTo( 
+        interpolator->EvaluateCenter( arclength ) ) ) > 1e-9 ||
+      std::fabs( section->GetRadius() - interpolator->EvaluateRadius( arclength ) ) > 1e-9 )
+    {
+      std::cerr << "Wrong resampled section " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPackedVesselCenterlineTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the contiguous centerline storage and its conversion from and to section objects.
+
+#include "ivanPackedVesselCenterline.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+
+/** Written once for both centerline types through the section proxy. */
+template <class TCenterline>
+double ComputeLength( const TCenterline * centerline )
+{
+  double length = 0.0;
+  
+  for( unsigned int i=1; i<centerline->size(); ++i )
+    length += centerline->at(i)->GetCenter().EuclideanDistanceTo( centerline->at(i-1)->GetCenter() );
+    
+  return length;
+}
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::CircularVesselSection<3>              SectionType;
+  typedef ivan::VesselCenterline
+    <unsigned int, SectionType>                       CenterlineType;
+  typedef ivan::PackedVesselCenterline<unsigned int>  PackedCenterlineType;
+  
+  const unsigned int numberOfSections = 50;
+  
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    
+    SectionType::PointType center;
+    center[0] = 3.0 * i;
+    center[1] = 4.0 * i;
+    center[2] = 0.0;
+    section->SetCenter( center );
+    
+    SectionType::VectorType normal;
+    normal[0] = 0.6;
+    normal[1] = 0.8;
+    normal[2] = 0.0;
+    section->SetNormal( normal );
+    
+    section->SetRadius( 1.0 + i );
+    section->SetScale( 0.5 * i );
+    
+    centerline->push_back( section );
+  }
+  
+  PackedCenterlineType::Pointer packed = PackedCenterlineType::New();
+  packed->Pack( centerline.GetPointer() );
+  
+  if( packed->GetNumberOfSections() != numberOfSections || 
+    &packed->at(1) != &packed->at(0) + 1 || packed->GetLastSection() != &packed->back() )
+  {
+    std::cerr << "Sections are not stored contiguously." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    if( packed->at(i)->GetCenter() != centerline->at(i)->GetCenter() ||
+      packed->at(i)->GetNormal() != centerline->at(i)->GetNormal() ||
+      packed->at(i)->GetRadius() != centerline->at(i)->GetRadius() ||
+      packed->at(i)->GetScale() != centerline->at(i)->GetScale() )
+    {
+      std::cerr << "Wrong packed section " << i << std::endl;
+      packed->at(i).Print( std::cerr );
+      return EXIT_FAILURE;
+    }
+  }
+  
+  const double expectedLength = 5.0 * ( numberOfSections - 1 );
+  
+  if( std::fabs( ComputeLength( centerline.GetPointer() ) - expectedLength ) > 1e-9 ||
+    std::fabs( ComputeLength( packed.GetPointer() ) - expectedLength ) > 1e-9 )
+  {
+    std::cerr << "Wrong length through the section proxy." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  packed->ComputeMetrics();
+  
+  if( std::fabs( packed->GetLastSection()->GetArclength() - expectedLength ) > 1e-9 ||
+    packed->GetFirstSection()->GetArclength() != 0.0 )
+  {
+    std::cerr << "Wrong arclength: " << packed->GetLastSection()->GetArclength() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Unpacking creates new section objects with the same data
+  CenterlineType::Pointer unpacked = CenterlineType::New();
+  packed->Unpack( unpacked.GetPointer() );
+  
+  if( unpacked->size() != numberOfSections || unpacked->at(0) == centerline->at(0) ||
+    unpacked->at(10)->GetCenter() != centerline->at(10)->GetCenter() ||
+    std::fabs( unpacked->at(10)->GetArclength() - 50.0 ) > 1e-9 )
+  {
+    std::cerr << "Wrong unpacked centerline." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
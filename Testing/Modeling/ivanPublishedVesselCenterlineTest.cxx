@@ -0,0 +1,166 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanPublishedVesselCenterlineTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks that threads reading the published sections of a centerline while it is tracked
+//   always see a consistent prefix of the sections.
+// Date: 2012/11/05
+
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkMultiThreader.h"
+
+#include <cstdlib>
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+const unsigned int NumberOfThreads = 4;
+const unsigned int NumberOfSections = 20000;
+
+
+struct TestData
+{
+  CenterlineType::Pointer   Centerline;
+  volatile bool             Finished;
+  unsigned long             NumberOfViews[NumberOfThreads];
+  unsigned long             NumberOfErrors[NumberOfThreads];
+};
+
+
+// Thread 0 tracks the centerline twice, clearing it in between as a bidirectional tracker
+// does, and the others read it. Sections store their index and the pass they were tracked in
+ITK_THREAD_RETURN_TYPE TrackOrRead( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct *info = (itk::MultiThreader::ThreadInfoStruct *)( arg );
+  TestData *data = (TestData *)( info->UserData );
+  CenterlineType *centerline = data->Centerline;
+  
+  if( info->ThreadID == 0 )
+  {
+    for( unsigned int pass=0; pass < 2; ++pass )
+    {
+      centerline->CastToSTLContainer().clear();
+      centerline->PublishSections();
+      
+      for( unsigned int i=0; i < NumberOfSections; ++i )
+      {
+        SectionType::PointType center;
+        center[0] = pass;
+        center[1] = i;
+        center[2] = 0.0;
+        
+        SectionType::Pointer section = SectionType::New();
+        section->SetCenter( center );
+        centerline->push_back( section );
+        centerline->PublishSections();
+      }
+    }
+    
+    data->Finished = true;
+    return ITK_THREAD_RETURN_VALUE;
+  }
+  
+  while( !data->Finished )
+  {
+    CenterlineType::PublishedSectionsView sections = centerline->GetPublishedSections();
+    ++data->NumberOfViews[ info->ThreadID ];
+    
+    if( sections.Empty() )
+      continue;
+      
+    const double pass = sections[0]->GetCenter()[0];
+    
+    for( unsigned long i=0; i < sections.Size(); ++i )
+    {
+      if( sections[i]->GetCenter()[0] != pass || sections[i]->GetCenter()[1] != i )
+        ++data->NumberOfErrors[ info->ThreadID ];
+    }
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+int main( int, char ** )
+{
+  TestData data;
+  data.Centerline = CenterlineType::New();
+  data.Finished = false;
+  
+  for( unsigned int i=0; i < NumberOfThreads; ++i )
+    data.NumberOfViews[i] = data.NumberOfErrors[i] = 0;
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( TrackOrRead, &data );
+  threader->SingleMethodExecute();
+  
+  for( unsigned int i=1; i < threader->GetNumberOfThreads(); ++i )
+  {
+    std::cout << "Thread " << i << " read " << data.NumberOfViews[i] << " views" << std::endl;
+    
+    if( data.NumberOfErrors[i] )
+    {
+      std::cerr << "Thread " << i << " read " << data.NumberOfErrors[i] << " inconsistent sections" 
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  CenterlineType::PublishedSectionsView sections = data.Centerline->GetPublishedSections();
+  
+  if( sections.Size() != NumberOfSections || sections[ NumberOfSections - 1 ]->GetCenter()[0] != 1.0 )
+  {
+    std::cerr << "Wrong published sections: " << sections.Size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Modifications other than appends publish a new copy, and the previous ones stay readable
+  CenterlineType::STLContainerType & container = data.Centerline->CastToSTLContainer();
+  SectionType::Pointer replaced = container[0];
+  container[0] = SectionType::New();
+  data.Centerline->PublishSections();
+  
+  if( sections[0] != replaced || data.Centerline->GetPublishedSections()[0] != container[0] )
+  {
+    std::cerr << "Replaced section published in place" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  data.Centerline->ReclaimPublishedSections();
+  
+  if( data.Centerline->GetPublishedSections().Size() != NumberOfSections )
+  {
+    std::cerr << "Current publication reclaimed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineSmootherTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the sliding window smoothing of centerlines and its parallel application to a graph.
+
+#include "ivanVesselCenterlineSmoother.h"
+#include "ivanVesselGraphCenterlineProcessor.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+int main( int argc, char ** argv )
+{
+  typedef ivan::CircularVesselSection<3>              SectionType;
+  typedef ivan::VesselCenterline
+    <unsigned int, SectionType>                       CenterlineType;
+  typedef ivan::VesselCenterlineSmoother
+    <CenterlineType>                                  SmootherType;
+  typedef ivan::VesselGraphCenterlineProcessor
+    <SmootherType>                                    ProcessorType;
+    
+  typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+  typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+  typedef ivan::VesselGraph<CenterlineType>           GraphType;
+  
+  const unsigned int numberOfSections = 101;
+  const unsigned int windowRadius = 3;
+  
+  // Zig-zag along x, with normals alternating around the x axis
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  std::vector<double> y( numberOfSections );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    
+    y[i] = ( i % 2 ) ? 1.0 : -1.0;
+    
+    SectionType::PointType center;
+    center[0] = i;
+    center[1] = y[i];
+    center[2] = 0.0;
+    section->SetCenter( center );
+    
+    SectionType::VectorType normal;
+    normal[0] = 1.0;
+    normal[1] = y[i];
+    normal[2] = 0.0;
+    normal.Normalize();
+    section->SetNormal( normal );
+    
+    centerline->push_back( section );
+  }
+    
+  SmootherType::Pointer smoother = SmootherType::New();
+  smoother->SetWindowRadius( windowRadius );
+  
+  // The copy must not change the input
+  CenterlineType::Pointer smoothed = smoother->Evaluate( centerline.GetPointer() );
+  
+  if( smoothed->size() != numberOfSections || smoothed->at(1) == centerline->at(1) || 
+    centerline->at(1)->GetCenter()[1] != y[1] )
+  {
+    std::cerr << "Evaluate() did not smooth a copy of the centerline." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The running sum must match the average over the window, shrunk at the ends
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const unsigned int radius = std::min( windowRadius, std::min( i, numberOfSections - 1 - i ) );
+    
+    double expected = 0.0;
+    for( unsigned int j=i-radius; j<=i+radius; ++j )
+      expected += y[j];
+    expected /= 2 * radius + 1;
+    
+    const SectionType *section = smoothed->at(i);
+    
+    if( std::fabs( section->GetCenter()[1] - expected ) > 1e-9 || 
+      std::fabs( section->GetCenter()[0] - i ) > 1e-9 )
+    {
+      std::cerr << "Wrong smoothed center at section " << i << ": " << section->GetCenter() 
+        << ", expected y = " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( std::fabs( section->GetNormal().GetNorm() - 1.0 ) > 1e-9 )
+    {
+      std::cerr << "Smoothed normal at section " << i << " is not unitary." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Smooth two branches of a graph in parallel, in place
+  BranchNodeType::Pointer firstBranch = BranchNodeType::New();
+  firstBranch->SetCenterline( centerline );
+  
+  BranchNodeType::Pointer secondBranch = BranchNodeType::New();
+  secondBranch->SetCenterline( smoother->Evaluate( centerline.GetPointer() ) );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  firstBranch->AddChild( bifurcation );
+  bifurcation->AddChild( secondBranch );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( firstBranch );
+  
+  SectionType::Pointer firstSection = centerline->at(1);
+  
+  ProcessorType::Pointer processor = ProcessorType::New();
+  processor->SetCenterlineAlgorithm( smoother );
+  processor->SetNumberOfThreads( 2 );
+  processor->Process( graph );
+  
+  if( processor->GetNumberOfProcessedBranches() != 2 || 
+    processor->GetNumberOfProcessedSections() != 2 * numberOfSections )
+  {
+    std::cerr << "Processed " << processor->GetNumberOfProcessedBranches() << " branches and "
+      << processor->GetNumberOfProcessedSections() << " sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( firstBranch->GetCenterline() != centerline || centerline->at(1) != firstSection ||
+    std::fabs( centerline->at(50)->GetCenter()[1] - smoothed->at(50)->GetCenter()[1] ) > 1e-9 )
+  {
+    std::cerr << "The first branch was not smoothed in place." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselCenterlineSpatialIndexTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the spatial index over vessel centerline segments.
+// Date: 2012/11/05
+
+#include "ivanVesselCenterlineSpatialIndex.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+typedef ivan::VesselCenterlineSpatialIndex<CenterlineType>  SpatialIndexType;
+
+
+void AddSection( BranchNodeType * branch, double x, double y, double z, double radius )
+{
+  SectionType::PointType center;
+  center[0] = x;
+  center[1] = y;
+  center[2] = z;
+  
+  SectionType::Pointer section = SectionType::New();
+  section->SetCenter( center );
+  section->SetRadius( radius );
+  branch->GetCenterline()->push_back( section );
+}
+
+
+SectionType::PointType MakePoint( double x, double y, double z )
+{
+  SectionType::PointType point;
+  point[0] = x;
+  point[1] = y;
+  point[2] = z;
+  
+  return point;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Branch 1 along x with decreasing radius, branch 3 along y from its end
+  BranchNodeType::Pointer branch1 = BranchNodeType::New();
+  branch1->SetNodeId( 1 );
+  for( unsigned int i=0; i<=50; ++i )
+    AddSection( branch1, i, 0.0, 0.0, 3.0 - i / 50.0 );
+    
+  BranchNodeType::Pointer branch3 = BranchNodeType::New();
+  branch3->SetNodeId( 3 );
+  for( unsigned int i=0; i<=50; ++i )
+    AddSection( branch3, 50.0, i, 0.0, 1.0 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  SpatialIndexType::Pointer index = SpatialIndexType::New();
+  index->Build( graph );
+  
+  if( index->GetNumberOfSegments() != 100 )
+  {
+    std::cerr << "Wrong number of segments: " << index->GetNumberOfSegments() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( index->FindContainingBranch( MakePoint( 10.5, 1.0, 1.0 ) ) != branch1.GetPointer() ||
+    index->FindContainingBranch( MakePoint( 50.0, 30.0, 0.5 ) ) != branch3.GetPointer() ||
+    index->FindContainingBranch( MakePoint( 25.0, 20.0, 0.0 ) ) != 0 )
+  {
+    std::cerr << "Wrong containing branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The radius at x=40.5 is 2.19, so the surface is 0.81 away
+  SpatialIndexType::SegmentHit hit;
+  
+  if( !index->FindNearestSegment( MakePoint( 40.5, 3.0, 0.0 ), hit ) || 
+    hit.Branch != branch1.GetPointer() || hit.SectionIndex != 40 ||
+    vcl_abs( hit.Distance - 0.81 ) > 1e-6 || vcl_abs( hit.Parameter - 0.5 ) > 1e-6 )
+  {
+    std::cerr << "Wrong nearest segment." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  SpatialIndexType::SegmentHitContainer hits;
+  
+  if( index->FindSegmentsWithinDistance( MakePoint( 40.5, 3.0, 0.0 ), 1.0, hits ) != 3 ||
+    index->FindSegmentsWithinDistance( MakePoint( 40.5, 3.0, 0.0 ), 1.0, hits, branch1 ) != 0 )
+  {
+    std::cerr << "Wrong segments within distance." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Near the bifurcation the excluded branch is skipped
+  if( index->FindContainingBranch( MakePoint( 50.0, 0.5, 0.0 ), branch1 ) != branch3.GetPointer() )
+  {
+    std::cerr << "The excluded branch was reported." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Grow a branch section by section as a tracker would
+  BranchNodeType::Pointer branch4 = BranchNodeType::New();
+  branch4->SetNodeId( 4 );
+  bifurcation2->AddChild( branch4 );
+  
+  for( unsigned int i=0; i<=200; ++i )
+  {
+    AddSection( branch4, 60.0 + i, 20.0, 0.0, 0.5 );
+    index->AppendSections( branch4 );
+    
+    // Positions already tracked are found before the hierarchy is rebuilt, both in the last
+    // segments and in the batches inserted before
+    if( index->FindContainingBranch( MakePoint( 60.0 + i, 20.0, 0.25 ) ) != branch4.GetPointer() ||
+      index->FindContainingBranch( MakePoint( 60.0 + i / 2, 20.0, 0.25 ) ) != branch4.GetPointer() )
+    {
+      std::cerr << "Appended section " << i << " not found." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Batches halve in size, so there are at most log2(n) of them
+    if( index->GetNumberOfBatches() > 9 )
+    {
+      std::cerr << "Too many batches: " << index->GetNumberOfBatches() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( index->FindContainingBranch( MakePoint( 10.5, 1.0, 1.0 ) ) != branch1.GetPointer() ||
+    index->FindContainingBranch( MakePoint( 50.0, 30.0, 0.5 ) ) != branch3.GetPointer() )
+  {
+    std::cerr << "Wrong containing branch after appending." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( index->GetNumberOfSegments() != 300 )
+  {
+    std::cerr << "Wrong number of segments after appending: " << index->GetNumberOfSegments() 
+      << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  index->Update();
+  
+  if( !index->FindNearestSegment( MakePoint( 160.2, 22.0, 0.0 ), hit ) || 
+    hit.Branch != branch4.GetPointer() || hit.SectionIndex != 100 ||
+    vcl_abs( hit.Parameter - 0.2 ) > 1e-6 )
+  {
+    std::cerr << "Wrong nearest segment after appending." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( index->GetNumberOfBatches() != 1 )
+  {
+    std::cerr << "The update did not give a single hierarchy." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A single section branch in the hierarchy grows into a segment, so its batch is rebuilt
+  BranchNodeType::Pointer branch5 = BranchNodeType::New();
+  branch5->SetNodeId( 5 );
+  bifurcation2->AddChild( branch5 );
+  
+  AddSection( branch5, 0.0, 30.0, 0.0, 1.0 );
+  index->AppendSections( branch5 );
+  index->Update();
+  
+  AddSection( branch5, 10.0, 30.0, 0.0, 1.0 );
+  index->AppendSections( branch5 );
+  
+  if( index->FindContainingBranch( MakePoint( 5.0, 30.0, 0.5 ) ) != branch5.GetPointer() ||
+    index->FindContainingBranch( MakePoint( 160.0, 20.0, 0.25 ) ) != branch4.GetPointer() )
+  {
+    std::cerr << "Wrong containing branch after growing a sphere." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Removed segments are not found, and the rest are inserted again
+  index->RemoveSections( branch4 );
+  
+  if( index->FindContainingBranch( MakePoint( 160.0, 20.0, 0.25 ) ) != 0 ||
+    index->FindContainingBranch( MakePoint( 10.5, 1.0, 1.0 ) ) != branch1.GetPointer() ||
+    index->FindContainingBranch( MakePoint( 5.0, 30.0, 0.5 ) ) != branch5.GetPointer() )
+  {
+    std::cerr << "Wrong containing branch after removing a branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
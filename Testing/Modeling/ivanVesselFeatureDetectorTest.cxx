@@ -0,0 +1,235 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselFeatureDetectorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the sliding window references and the detection of stenoses and 
+//   aneurysms along the branches of a graph.
+
+#include "ivanVesselFeatureDetector.h"
+#include "ivanStenosisModel.h"
+#include "ivanAneurysmModel.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::VesselFeatureDetector
+  <CenterlineType>                                  DetectorType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+/** Branch along x with sections every 1.0 of the given radii. */
+BranchNodeType::Pointer CreateBranch( unsigned int id, const std::vector<double> & radii )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<radii.size(); ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    
+    SectionType::PointType center;
+    center.Fill( 0.0 );
+    center[0] = i;
+    section->SetCenter( center );
+    section->SetRadius( radii[i] );
+    
+    centerline->push_back( section );
+  }
+  
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetNodeId( id );
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+/** Brute force reference of the window of the given length centered at every value. */
+std::vector<double> ComputeBruteForceReference( const std::vector<double> & positions,
+  const std::vector<double> & values, double windowLength, DetectorType::ReferenceType reference )
+{
+  std::vector<double> referenceValues( values.size() );
+  
+  for( unsigned int i=0; i<values.size(); ++i )
+  {
+    std::vector<double> window;
+    
+    for( unsigned int j=0; j<values.size(); ++j )
+    {
+      if( std::fabs( positions[j] - positions[i] ) <= 0.5 * windowLength )
+        window.push_back( values[j] );
+    }
+    
+    std::sort( window.begin(), window.end() );
+    
+    if( reference == DetectorType::MaximumReference )
+      referenceValues[i] = window.back();
+    else if( reference == DetectorType::MinimumReference )
+      referenceValues[i] = window.front();
+    else if( window.size() % 2 )
+      referenceValues[i] = window[ window.size() / 2 ];
+    else
+      referenceValues[i] = 0.5 * ( window[ window.size() / 2 - 1 ] + window[ window.size() / 2 ] );
+  }
+  
+  return referenceValues;
+}
+
+
+int main( int, char ** )
+{
+  // Sliding window references against brute force, with irregular positions and repeated values
+  std::vector<double> positions, values;
+  double position = 0.0;
+  
+  srand( 7 );
+  
+  for( unsigned int i=0; i<200; ++i )
+  {
+    positions.push_back( position );
+    values.push_back( rand() % 10 );
+    position += 0.25 * ( rand() % 8 );
+  }
+  
+  const DetectorType::ReferenceType references[3] = 
+    { DetectorType::MaximumReference, DetectorType::MinimumReference, DetectorType::MedianReference };
+  
+  for( unsigned int r=0; r<3; ++r )
+  {
+    std::vector<double> referenceValues;
+    DetectorType::ComputeReference( positions, values, 5.0, references[r], referenceValues );
+    
+    if( referenceValues != ComputeBruteForceReference( positions, values, 5.0, references[r] ) )
+    {
+      std::cerr << "Wrong sliding window reference " << r << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Branch 1 of radius 3 with a stenosis in [30,34] and an aneurysm in [70,74], then a healthy
+  // branch 3 of radius 2
+  std::vector<double> radii( 101, 3.0 );
+  
+  for( unsigned int i=30; i<=34; ++i )
+    radii[i] = 1.0;
+  
+  for( unsigned int i=70; i<=74; ++i )
+    radii[i] = 6.0;
+  
+  radii[72] = 6.5;
+  
+  BranchNodeType::Pointer root = CreateBranch( 1, radii );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  bifurcation->SetNodeId( 2 );
+  root->AddChild( bifurcation );
+  bifurcation->AddChild( CreateBranch( 3, std::vector<double>( 50, 2.0 ) ) );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( root );
+  
+  DetectorType::Pointer detector = DetectorType::New();
+  detector->SetReferenceWindowLength( 20.0 );
+  
+  for( int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3 )
+  {
+    detector->SetNumberOfThreads( numberOfThreads );
+    detector->Detect( graph );
+    
+    const DetectorType::FeatureNodeContainerType & features = detector->GetFeatureNodes();
+    
+    if( features.size() != 2 || detector->GetNumberOfStenoses() != 1 || 
+        detector->GetNumberOfAneurysms() != 1 )
+    {
+      std::cerr << "Found " << detector->GetNumberOfStenoses() << " stenoses and " 
+        << detector->GetNumberOfAneurysms() << " aneurysms" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const ivan::StenosisModel *stenosis = 
+      dynamic_cast<const ivan::StenosisModel*>( features[0]->GetFeatureModel() );
+    const ivan::AneurysmModel *aneurysm = 
+      dynamic_cast<const ivan::AneurysmModel*>( features[1]->GetFeatureModel() );
+    
+    if( !stenosis || stenosis->GetMinimumRadius() != 1.0 || stenosis->GetReferenceRadius() != 3.0 ||
+        !aneurysm || aneurysm->GetMaximumRadius() != 6.5 || aneurysm->GetReferenceRadius() != 3.0 )
+    {
+      std::cerr << "Wrong feature models" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    ivan::VesselRegion stenosisRegion, aneurysmRegion;
+    stenosisRegion.Insert( 1, 30, 34 );
+    aneurysmRegion.Insert( 1, 70, 74 );
+    
+    if( !features[0]->GetFeatureRegion().IsInside( stenosisRegion ) || 
+        !stenosisRegion.IsInside( features[0]->GetFeatureRegion() ) ||
+        !features[1]->GetFeatureRegion().IsInside( aneurysmRegion ) || 
+        !aneurysmRegion.IsInside( features[1]->GetFeatureRegion() ) )
+    {
+      std::cerr << "Wrong feature regions" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Stenoses shorter than the minimum number of sections are discarded
+  detector->SetMinimumNumberOfSections( 6 );
+  detector->SetDetectAneurysms( false );
+  detector->Detect( graph );
+  
+  if( !detector->GetFeatureNodes().empty() )
+  {
+    std::cerr << "Short stenosis not discarded" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The nodes are added to the branch
+  detector->SetMinimumNumberOfSections( 1 );
+  detector->SetDetectAneurysms( true );
+  detector->AttachFeatureNodesOn();
+  detector->Detect( graph );
+  
+  if( root->GetNumberOfChildren() != 3 )
+  {
+    std::cerr << "Feature nodes not attached" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
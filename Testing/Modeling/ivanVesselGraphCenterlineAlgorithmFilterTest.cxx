@@ -0,0 +1,202 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineAlgorithmFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the propagation of a requested VesselRegion through a pipeline of two 
+//   centerline filters, which only process the requested branches.
+
+#include "ivanVesselGraphCenterlineAlgorithmFilter.h"
+#include "ivanVesselCenterlineSmoother.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::VesselCenterlineSmoother
+  <CenterlineType>                                  SmootherType;
+typedef ivan::VesselGraphCenterlineAlgorithmFilter
+  <SmootherType>                                    FilterType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+/** Zig-zag branch along x. */
+BranchNodeType::Pointer CreateBranch( unsigned int id )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<21; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    
+    SectionType::PointType center;
+    center[0] = i;
+    center[1] = ( i % 2 ) ? 1.0 : -1.0;
+    center[2] = 0.0;
+    section->SetCenter( center );
+    
+    SectionType::VectorType normal;
+    normal[0] = 1.0;
+    normal[1] = 0.0;
+    normal[2] = 0.0;
+    section->SetNormal( normal );
+    
+    centerline->push_back( section );
+  }
+  
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetNodeId( id );
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+/** Find a branch of the graph by identifier. */
+const BranchNodeType * GetBranch( const GraphType * graph, unsigned int id )
+{
+  return dynamic_cast<const BranchNodeType*>( graph->FindNodeById( id ) );
+}
+
+
+/** Check if the center of section 10 of a branch is still at its original position. */
+bool IsSmoothed( const GraphType * graph, unsigned int id )
+{
+  return std::fabs( GetBranch( graph, id )->GetCenterline()->at(10)->GetCenter()[1] + 1.0 ) > 1e-6;
+}
+
+
+int main( int, char ** )
+{
+  // Branch 1 with children 3 and 4
+  BranchNodeType::Pointer root = CreateBranch( 1 );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  bifurcation->SetNodeId( 2 );
+  root->AddChild( bifurcation );
+  bifurcation->AddChild( CreateBranch( 3 ) );
+  bifurcation->AddChild( CreateBranch( 4 ) );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( root );
+  
+  SmootherType::Pointer smoother = SmootherType::New();
+  smoother->SetWindowRadius( 2 );
+  
+  FilterType::Pointer firstFilter = FilterType::New();
+  firstFilter->SetInput( graph );
+  firstFilter->SetCenterlineAlgorithm( smoother );
+  
+  FilterType::Pointer secondFilter = FilterType::New();
+  secondFilter->SetInput( firstFilter->GetOutput() );
+  secondFilter->SetCenterlineAlgorithm( smoother );
+  
+  // Request only branch 3 at the end of the pipeline
+  ivan::VesselRegion region;
+  region.Insert( 3 );
+  secondFilter->GetOutput()->SetRequestedRegion( region );
+  
+  try
+  {
+    secondFilter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( firstFilter->GetNumberOfProcessedBranches() != 1 || 
+    secondFilter->GetNumberOfProcessedBranches() != 1 )
+  {
+    std::cerr << "Processed " << firstFilter->GetNumberOfProcessedBranches() << " and " 
+      << secondFilter->GetNumberOfProcessedBranches() << " branches" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const GraphType *firstOutput = firstFilter->GetOutput();
+  
+  if( firstOutput->IsBufferedRegionWhole() || 
+    !firstOutput->GetBufferedRegion().ContainsBranch( 3 ) ||
+    firstOutput->GetBufferedRegion().ContainsBranch( 1 ) )
+  {
+    std::cerr << "The request was not propagated upstream" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Only branch 3 is smoothed, and the other branches share the input centerlines
+  if( !IsSmoothed( secondFilter->GetOutput(), 3 ) || IsSmoothed( secondFilter->GetOutput(), 1 ) ||
+    IsSmoothed( secondFilter->GetOutput(), 4 ) || IsSmoothed( graph, 3 ) ||
+    GetBranch( secondFilter->GetOutput(), 1 )->GetCenterline().GetPointer() != root->GetCenterline().GetPointer() )
+  {
+    std::cerr << "Wrong branches smoothed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A request inside the buffered region does not execute the pipeline again
+  ivan::VesselRegion sectionRegion;
+  sectionRegion.Insert( 3, 5, 10 );
+  
+  if( !region.IsInside( sectionRegion ) || sectionRegion.IsInside( region ) )
+  {
+    std::cerr << "Wrong region containment" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  secondFilter->GetOutput()->SetRequestedRegion( sectionRegion );
+  const unsigned long updateTime = secondFilter->GetOutput()->GetUpdateMTime();
+  secondFilter->Update();
+  
+  if( secondFilter->GetOutput()->GetUpdateMTime() != updateTime )
+  {
+    std::cerr << "The pipeline executed again for a buffered request" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The whole graph is processed again when requested
+  secondFilter->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+  secondFilter->Update();
+  
+  if( firstFilter->GetNumberOfProcessedBranches() != 3 || 
+    secondFilter->GetNumberOfProcessedBranches() != 3 ||
+    !firstFilter->GetOutput()->IsBufferedRegionWhole() ||
+    !IsSmoothed( secondFilter->GetOutput(), 1 ) || !IsSmoothed( secondFilter->GetOutput(), 4 ) )
+  {
+    std::cerr << "The whole graph was not processed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineResamplerTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the parallel resampling of the branches of a graph at uniform arclength.
+
+#include "ivanVesselGraphCenterlineResampler.h"
+#include "ivanLinearVesselCenterlineInterpolator.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::LinearVesselCenterlineInterpolator
+  <CenterlineType>                                  InterpolatorType;
+typedef ivan::VesselGraphCenterlineResampler
+  <InterpolatorType>                                ResamplerType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+/** Centerline along the given axis with sections at the given positions. */
+CenterlineType::Pointer CreateCenterline( const std::vector<double> & positions, unsigned int axis )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<positions.size(); ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    
+    SectionType::PointType center;
+    center.Fill( 0.0 );
+    center[axis] = positions[i];
+    section->SetCenter( center );
+    
+    SectionType::VectorType normal;
+    normal.Fill( 0.0 );
+    normal[axis] = 1.0;
+    section->SetNormal( normal );
+    
+    section->SetRadius( 1.0 + positions[i] );
+    
+    centerline->push_back( section );
+  }
+  
+  return centerline;
+}
+
+
+/** Graph of a branch along x with two children along y and z, with irregular spacings. */
+GraphType::Pointer CreateGraph()
+{
+  std::vector<double> positions;
+  
+  // Length 5 in 6 sections
+  positions.push_back( 0.0 );
+  positions.push_back( 0.3 );
+  positions.push_back( 1.5 );
+  positions.push_back( 2.0 );
+  positions.push_back( 4.2 );
+  positions.push_back( 5.0 );
+  
+  BranchNodeType::Pointer root = BranchNodeType::New();
+  root->SetCenterline( CreateCenterline( positions, 0 ) );
+  
+  // Length 10 in 3 sections
+  positions.clear();
+  positions.push_back( 0.0 );
+  positions.push_back( 7.0 );
+  positions.push_back( 10.0 );
+  
+  BranchNodeType::Pointer firstChild = BranchNodeType::New();
+  firstChild->SetCenterline( CreateCenterline( positions, 1 ) );
+  
+  // Length 2 in 21 sections
+  positions.clear();
+  for( unsigned int i=0; i<=20; ++i )
+    positions.push_back( 0.1 * i );
+  
+  BranchNodeType::Pointer secondChild = BranchNodeType::New();
+  secondChild->SetCenterline( CreateCenterline( positions, 2 ) );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  root->AddChild( bifurcation );
+  bifurcation->AddChild( firstChild );
+  bifurcation->AddChild( secondChild );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( root );
+  
+  return graph;
+}
+
+
+/** Check that a resampled centerline has the given length and sections every half unit. */
+bool CheckCenterline( const CenterlineType * centerline, double length, unsigned int axis )
+{
+  const unsigned int numberOfSections = static_cast<unsigned int>( 2.0 * length ) + 1;
+  
+  if( centerline->size() != numberOfSections )
+  {
+    std::cerr << "Resampled centerline has " << centerline->size() << " sections instead of " 
+      << numberOfSections << std::endl;
+    return false;
+  }
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const SectionType *section = centerline->at(i);
+    const double arclength = 0.5 * i;
+    
+    if( std::fabs( section->GetArclength() - arclength ) > 1e-9 || 
+      std::fabs( section->GetCenter()[axis] - arclength ) > 1e-9 ||
+      std::fabs( section->GetNormal()[axis] - 1.0 ) > 1e-9 ||
+      std::fabs( section->GetRadius() - ( 1.0 + arclength ) ) > 1e-9 )
+    {
+      std::cerr << "Wrong resampled section " << i << " along axis " << axis << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSamplingDistance( 0.5 );
+  
+  ResamplerType::Pointer resampler = ResamplerType::New();
+  resampler->SetInterpolator( interpolator );
+  
+  for( unsigned int run=0; run<2; ++run )
+  {
+    resampler->SetNumberOfThreads( ( run == 0 ) ? 1 : 3 );
+    
+    GraphType::Pointer graph = CreateGraph();
+    
+    BranchNodeType *root = dynamic_cast<BranchNodeType*>( graph->GetRootNode().GetPointer() );
+    BranchNodeType *firstChild = dynamic_cast<BranchNodeType*>( root->GetChild(0)->GetChild(0) );
+    BranchNodeType *secondChild = dynamic_cast<BranchNodeType*>( root->GetChild(0)->GetChild(1) );
+    
+    CenterlineType::Pointer rootCenterline = root->GetCenterline();
+    SectionType::Pointer firstSection = rootCenterline->at(0);
+    
+    try
+    {
+      resampler->Resample( graph );
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // 11 + 21 + 5 sections, of which 5 and 18 are new
+    if( resampler->GetNumberOfResampledBranches() != 3 || 
+      resampler->GetNumberOfResampledSections() != 37 ||
+      resampler->GetNumberOfCreatedSections() != 23 )
+    {
+      std::cerr << "Resampled " << resampler->GetNumberOfResampledBranches() << " branches and "
+        << resampler->GetNumberOfResampledSections() << " sections, creating " 
+        << resampler->GetNumberOfCreatedSections() << " in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // Branches are resampled in place
+    if( root->GetCenterline() != rootCenterline || rootCenterline->at(0) != firstSection )
+    {
+      std::cerr << "The centerline was not resampled in place in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !CheckCenterline( root->GetCenterline(), 5.0, 0 ) || 
+      !CheckCenterline( firstChild->GetCenterline(), 10.0, 1 ) ||
+      !CheckCenterline( secondChild->GetCenterline(), 2.0, 2 ) )
+    {
+      std::cerr << "Wrong resampling in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
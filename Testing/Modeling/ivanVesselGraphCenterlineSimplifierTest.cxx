@@ -0,0 +1,296 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphCenterlineSimplifierTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the parallel computation of simplified centerlines of the branches of a graph.
+
+#include "ivanVesselGraphCenterlineSimplifier.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+typedef ivan::VesselGraphCenterlineSimplifier
+  <CenterlineType>                                  SimplifierType;
+typedef ivan::FrozenVesselGraph<CenterlineType>     FrozenGraphType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+void AddSection( CenterlineType *centerline, double x, double y, double radius )
+{
+  SectionType::Pointer section = SectionType::New();
+  
+  SectionType::PointType center;
+  center.Fill( 0.0 );
+  center[0] = x;
+  center[1] = y;
+  section->SetCenter( center );
+  section->SetRadius( radius );
+  
+  centerline->push_back( section );
+}
+
+
+/** Straight branch of 101 sections with a smooth stenosis around section 50. */
+CenterlineType::Pointer CreateStenosis()
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<=100; ++i )
+  {
+    const double d = ( (double)i - 50.0 ) / 5.0;
+    AddSection( centerline, i, 0.0, 2.0 - 1.2 * std::exp( -d * d ) );
+  }
+  
+  return centerline;
+}
+
+
+/** Straight branch of 50 sections with constant radius. */
+CenterlineType::Pointer CreateStraight()
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<50; ++i )
+    AddSection( centerline, 100.0, 0.5 * i, 1.0 );
+  
+  return centerline;
+}
+
+
+/** Quarter of a circle of radius 20 in 80 sections with constant radius. */
+CenterlineType::Pointer CreateArc()
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<80; ++i )
+  {
+    const double angle = 0.5 * vnl_math::pi * i / 79.0;
+    AddSection( centerline, 100.0 + 20.0 * std::sin( angle ), 20.0 - 20.0 * std::cos( angle ), 1.0 );
+  }
+    
+  return centerline;
+}
+
+
+GraphType::Pointer CreateGraph( BranchNodeType::Pointer branches[3] )
+{
+  branches[0] = BranchNodeType::New();
+  branches[0]->SetCenterline( CreateStenosis() );
+  branches[1] = BranchNodeType::New();
+  branches[1]->SetCenterline( CreateStraight() );
+  branches[2] = BranchNodeType::New();
+  branches[2]->SetCenterline( CreateArc() );
+  
+  BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+  branches[0]->AddChild( bifurcation );
+  bifurcation->AddChild( branches[1] );
+  bifurcation->AddChild( branches[2] );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branches[0].GetPointer() );
+  
+  return graph;
+}
+
+
+/** Check that the dropped sections lie within the tolerance of the simplified centerline,
+  * and that the ends are kept. */
+bool CheckLevel( const CenterlineType *centerline, const CenterlineType *simplified, double tolerance )
+{
+  if( simplified->size() < 2 || simplified->at(0) != centerline->at(0) ||
+    simplified->at( simplified->size() - 1 ) != centerline->at( centerline->size() - 1 ) )
+  {
+    std::cerr << "Ends of the branch not kept." << std::endl;
+    return false;
+  }
+  
+  unsigned int k = 0;
+  
+  for( unsigned int i=0; i<centerline->size(); ++i )
+  {
+    if( centerline->at(i) == simplified->at(k) )
+    {
+      ++k;
+      continue;
+    }
+    
+    if( k == 0 || k >= simplified->size() )
+    {
+      std::cerr << "Simplified sections not in order." << std::endl;
+      return false;
+    }
+      
+    const SectionType *first = simplified->at(k-1);
+    const SectionType *last = simplified->at(k);
+    const SectionType *section = centerline->at(i);
+    
+    const SectionType::VectorType chord = last->GetCenter() - first->GetCenter();
+    const SectionType::VectorType offset = section->GetCenter() - first->GetCenter();
+    
+    double t = ( offset * chord ) / chord.GetSquaredNorm();
+    t = vnl_math_max( 0.0, vnl_math_min( 1.0, t ) );
+    
+    const double distance = ( offset - chord * t ).GetNorm();
+    const double radiusError = vnl_math_abs( section->GetRadius() - 
+      ( ( 1.0 - t ) * first->GetRadius() + t * last->GetRadius() ) );
+      
+    if( distance > tolerance * section->GetRadius() + 1e-9 || 
+      radiusError > tolerance * section->GetRadius() + 1e-9 )
+    {
+      std::cerr << "Dropped section " << i << " out of tolerance: " << distance << ", " <<
+        radiusError << "." << std::endl;
+      return false;
+    }
+  }
+  
+  return k == simplified->size();
+}
+
+
+int main( int argc, char ** argv )
+{
+  BranchNodeType::Pointer branches[3];
+  GraphType::Pointer graph = CreateGraph( branches );
+  
+  SimplifierType::Pointer simplifier = SimplifierType::New();
+  simplifier->SetNumberOfLevels( 3 );
+  simplifier->SetTolerance( 0.05 );
+  simplifier->SetToleranceFactor( 4.0 );
+  simplifier->SetNumberOfThreads( 1 );
+  simplifier->Simplify( graph );
+  
+  if( simplifier->GetNumberOfSimplifiedBranches() != 3 || simplifier->GetNumberOfSections() != 231 )
+  {
+    std::cerr << "Wrong number of simplified branches or sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int b=0; b<3; ++b )
+  {
+    if( branches[b]->GetNumberOfLevelsOfDetail() != 3 )
+    {
+      std::cerr << "Wrong number of levels of branch " << b << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int level=1; level<=3; ++level )
+    {
+      if( !CheckLevel( branches[b]->GetCenterline(), branches[b]->GetLevelOfDetailCenterline( level ), 
+        simplifier->GetLevelTolerance( level ) ) )
+      {
+        std::cerr << "Wrong level " << level << " of branch " << b << "." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  // Straight branches of constant radius keep their ends only
+  if( branches[1]->GetLevelOfDetailCenterline( 1 )->size() != 2 )
+  {
+    std::cerr << "Straight branch not simplified." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The narrowest section of the stenosis is kept at the finest level, and the arc needs more
+  // sections at finer levels
+  const CenterlineType *stenosis = branches[0]->GetLevelOfDetailCenterline( 1 );
+  bool narrowestKept = false;
+  
+  for( unsigned int i=0; i<stenosis->size(); ++i )
+    narrowestKept = narrowestKept || stenosis->at(i) == branches[0]->GetCenterline()->at( 50 );
+  
+  if( !narrowestKept || branches[2]->GetLevelOfDetailCenterline( 1 )->size() <= 
+    branches[2]->GetLevelOfDetailCenterline( 3 )->size() )
+  {
+    std::cerr << "Wrong levels of the curved branches." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Level 0 is the centerline itself, and levels beyond the coarsest are clamped
+  if( branches[0]->GetLevelOfDetailCenterline( 0 ) != branches[0]->GetCenterline() ||
+    branches[0]->GetLevelOfDetailCenterline( 10 ) != branches[0]->GetLevelOfDetailCenterline( 3 ) )
+  {
+    std::cerr << "Wrong centerline at level 0 or beyond the coarsest." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The result does not depend on the number of threads
+  BranchNodeType::Pointer parallelBranches[3];
+  GraphType::Pointer parallelGraph = CreateGraph( parallelBranches );
+  
+  SimplifierType::Pointer parallelSimplifier = SimplifierType::New();
+  parallelSimplifier->SetTolerance( 0.05 );
+  parallelSimplifier->SetNumberOfThreads( 4 );
+  parallelSimplifier->Simplify( parallelGraph );
+  
+  for( unsigned int level=1; level<=3; ++level )
+  {
+    if( parallelSimplifier->GetNumberOfKeptSections( level ) != simplifier->GetNumberOfKeptSections( level ) )
+    {
+      std::cerr << "Different number of kept sections with several threads at level " << level << 
+        ": " << parallelSimplifier->GetNumberOfKeptSections( level ) << " instead of " << 
+        simplifier->GetNumberOfKeptSections( level ) << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A frozen graph takes the sections of the requested level
+  FrozenGraphType::Pointer frozen = FrozenGraphType::New();
+  frozen->SetLevelOfDetail( 2 );
+  frozen->Freeze( graph );
+  
+  if( frozen->GetTotalNumberOfSections() != simplifier->GetNumberOfKeptSections( 2 ) )
+  {
+    std::cerr << "Frozen graph did not take the level of detail." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Editing the centerline removes the levels
+  branches[0]->GetWritableSection( 10 )->SetRadius( 3.0 );
+  
+  if( branches[0]->GetNumberOfLevelsOfDetail() != 0 || 
+    branches[0]->GetLevelOfDetailCenterline( 2 ) != branches[0]->GetCenterline() )
+  {
+    std::cerr << "Levels of detail kept after editing the centerline." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphNodeCacheTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the cached lists of the nodes of a vessel graph by node type.
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanCollectNodesVisitor.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+ivan::GraphNode::Pointer CreateNode( unsigned int id, bool branch )
+{
+  ivan::GraphNode::Pointer node;
+  
+  if( branch )
+    node = BranchNodeType::New().GetPointer();
+  else
+    node = BifurcationNodeType::New().GetPointer();
+    
+  node->SetNodeId( id );
+  return node;
+}
+
+
+bool CheckIds( const GraphType::NodeListType & nodes, const unsigned int * ids, unsigned int numberOfIds )
+{
+  if( nodes.size() != numberOfIds )
+    return false;
+    
+  for( unsigned int i=0; i<numberOfIds; ++i )
+  {
+    if( nodes[i]->GetNodeId() != ids[i] )
+      return false;
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // 1 -> 2 -> { 3, 4 }, 3 -> 5, 4 -> 5 
+  ivan::GraphNode::Pointer node1 = CreateNode( 1, true );
+  ivan::GraphNode::Pointer node2 = CreateNode( 2, false );
+  ivan::GraphNode::Pointer node3 = CreateNode( 3, true );
+  ivan::GraphNode::Pointer node4 = CreateNode( 4, true );
+  ivan::GraphNode::Pointer node5 = CreateNode( 5, false );
+  
+  node1->AddChild( node2 );
+  node2->AddChild( node3 );
+  node2->AddChild( node4 );
+  node3->AddChild( node5 );
+  node4->AddChild( node5 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( dynamic_cast<ivan::VesselNode*>( node1.GetPointer() ) );
+  graph->UseNodeIndexOn();
+  
+  // Shared nodes are listed once, in depth-first order
+  const unsigned int allIds[] = { 1, 2, 3, 5, 4 };
+  
+  if( !CheckIds( graph->GetNodes(), allIds, 5 ) )
+  {
+    std::cerr << "Wrong list of nodes." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::vector<BranchNodeType*> & branches = graph->GetNodesOfType<BranchNodeType>();
+  const std::vector<BifurcationNodeType*> & bifurcations = graph->GetNodesOfType<BifurcationNodeType>();
+  
+  if( branches.size() != 3 || branches[0] != node1 || branches[1] != node3 || branches[2] != node4 ||
+    bifurcations.size() != 2 || bifurcations[0] != node2 || bifurcations[1] != node5 )
+  {
+    std::cerr << "Wrong lists of nodes by type." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The lists are not rebuilt while the graph is not modified
+  if( &graph->GetNodesOfType<BranchNodeType>() != &branches )
+  {
+    std::cerr << "List of nodes rebuilt without modifications." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // With the node index the lists follow the structural edits of the nodes
+  ivan::GraphNode::Pointer node6 = CreateNode( 6, true );
+  node5->AddChild( node6 );
+  
+  if( graph->GetNodesOfType<BranchNodeType>().size() != 4 || 
+    graph->GetNodesOfType<BranchNodeType>().back() != node6 )
+  {
+    std::cerr << "Added node not listed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  node3->RemoveChild( node5 );
+  node2->RemoveChild( node4 );
+  
+  const unsigned int remainingIds[] = { 1, 2, 3 };
+  
+  if( !CheckIds( graph->GetNodes(), remainingIds, 3 ) || 
+    graph->GetNodesOfType<BifurcationNodeType>().size() != 1 )
+  {
+    std::cerr << "Removed nodes still listed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Without the index the graph has to be modified explicitly
+  graph->UseNodeIndexOff();
+  node2->AddChild( node4 );
+  
+  if( graph->GetNodes().size() != 3 )
+  {
+    std::cerr << "List of nodes rebuilt without modifications." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  graph->Modified();
+  
+  if( graph->GetNodes().size() != 6 || graph->GetNodesOfType<BranchNodeType>().size() != 4 )
+  {
+    std::cerr << "List of nodes not rebuilt after modifying the graph." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The visitor takes the cached nodes and gets the same nodes as visiting the graph, 
+  // except for the shared ones that are visited once per parent
+  typedef ivan::CollectNodesVisitor<BranchNodeType>  VisitorType;
+  
+  node4->SetMask( 0x2 );
+  
+  VisitorType::Pointer visitor = VisitorType::New();
+  visitor->SetTraversalMask( 0x1 );
+  visitor->Collect( graph.GetPointer() );
+  
+  VisitorType::Pointer traversingVisitor = VisitorType::New();
+  traversingVisitor->SetTraversalMask( 0x1 );
+  graph->GetRootNode()->Accept( traversingVisitor );
+  
+  if( visitor->GetNumberOfNodes() != 3 || traversingVisitor->GetNumberOfNodes() != 3 )
+  {
+    std::cerr << "Wrong number of collected nodes: " << visitor->GetNumberOfNodes() << " and " <<
+      traversingVisitor->GetNumberOfNodes() << "." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<visitor->GetNumberOfNodes(); ++i )
+  {
+    if( visitor->GetNodeContainer()[i] == node4 || 
+      visitor->GetNodeContainer()[i] != traversingVisitor->GetNodeContainer()[i] )
+    {
+      std::cerr << "Wrong collected node at " << i << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
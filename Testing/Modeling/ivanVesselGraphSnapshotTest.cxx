@@ -0,0 +1,207 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphSnapshotTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests that graph snapshots share the centerlines and copy only what is edited.
+
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+
+/** Section with a member of its own, which copies of the section must keep. */
+class LabeledVesselSection : public SectionType
+{
+public:
+  
+  typedef LabeledVesselSection              Self;
+  typedef SectionType                       Superclass;
+  typedef itk::SmartPointer<Self>           Pointer;
+  typedef itk::SmartPointer<const Self>     ConstPointer;
+  
+  itkNewMacro( Self );
+  itkTypeMacro( LabeledVesselSection, CircularVesselSection );
+  
+  itkSetMacro( Label, int );
+  itkGetConstMacro( Label, int );
+  
+  virtual void DeepCopy( const Superclass::Superclass * section )
+    {
+      Superclass::DeepCopy( section );
+      
+      const Self *labeledSection = dynamic_cast<const Self*>( section );
+      
+      if( labeledSection )
+        m_Label = labeledSection->m_Label;
+    }
+
+protected:
+  
+  LabeledVesselSection() : m_Label( 0 ) {}
+  
+  int m_Label;
+};
+
+
+// Read access, which does not copy shared centerlines
+const CenterlineType * ReadCenterline( const BranchNodeType *branch )
+{
+  return branch->GetCenterline();
+}
+
+
+int main( int argc, char ** argv )
+{
+  // 1 -> 2 -> { 3, 4 }
+  BranchNodeType::Pointer branch1 = CreateTestBranch<BranchNodeType>( 1, 10 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 10 );
+  BranchNodeType::Pointer branch4 = CreateTestBranch<BranchNodeType>( 4, 10 );
+  
+  branch1->SetOrder( 1 );
+  branch3->SetOrder( 3 );
+  branch4->SetOrder( 4 );
+  
+  LabeledVesselSection::Pointer labeledSection = LabeledVesselSection::New();
+  labeledSection->SetRadius( 2.0 );
+  labeledSection->SetLabel( 7 );
+  branch3->GetCenterline()->at(2) = labeledSection.GetPointer();
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  GraphType::Pointer snapshot = graph->CreateSnapshot();
+  
+  BranchNodeType *snapshotBranch1 = dynamic_cast<BranchNodeType*>( snapshot->GetRootNode().GetPointer() );
+  
+  if( !snapshotBranch1 || snapshotBranch1 == branch1.GetPointer() || 
+    snapshotBranch1->GetOrder() != 1 || snapshotBranch1->GetNumberOfChildren() != 1 ||
+    snapshotBranch1->GetChild(0)->GetNumberOfChildren() != 2 ||
+    ReadCenterline( snapshotBranch1 ) != ReadCenterline( branch1 ) )
+  {
+    std::cerr << "The snapshot does not copy the nodes and share the centerlines." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  BranchNodeType *snapshotBranch4 = 
+    dynamic_cast<BranchNodeType*>( snapshotBranch1->GetChild(0)->GetChild(1) );
+  
+  if( !snapshotBranch4 || snapshotBranch4->GetNodeId() != 4 || 
+    snapshotBranch4->GetDepthLevel() != branch4->GetDepthLevel() )
+  {
+    std::cerr << "Wrong snapshot of branch 4." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const CenterlineType *centerline4 = ReadCenterline( branch4 );
+  
+  // Edit one section of branch 4 in the snapshot
+  snapshotBranch4->GetWritableSection( 5 )->SetRadius( 3.0 );
+  
+  if( ReadCenterline( branch4 )->at(5)->GetRadius() != 1.5 ||
+    ReadCenterline( snapshotBranch4 )->at(5)->GetRadius() != 3.0 )
+  {
+    std::cerr << "The edit of the snapshot changed the original graph." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Only the touched centerline and section are copied
+  if( ReadCenterline( snapshotBranch4 ) == ReadCenterline( branch4 ) ||
+    ReadCenterline( snapshotBranch4 )->at(4) != ReadCenterline( branch4 )->at(4) ||
+    ReadCenterline( snapshotBranch4 )->at(5) == ReadCenterline( branch4 )->at(5) ||
+    ReadCenterline( snapshotBranch1 ) != ReadCenterline( branch1 ) )
+  {
+    std::cerr << "The edit copied more than the touched centerline and section." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Sections edited again, or no longer shared, are modified in place
+  SectionType *section = snapshotBranch4->GetWritableSection( 5 );
+  
+  if( section != ReadCenterline( snapshotBranch4 )->at(5) ||
+    branch4->GetWritableCenterline() != centerline4 )
+  {
+    std::cerr << "Unshared data was copied." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Copies of sections keep their type and members
+  BranchNodeType *snapshotBranch3 =
+    dynamic_cast<BranchNodeType*>( snapshotBranch1->GetChild(0)->GetChild(0) );
+  
+  const LabeledVesselSection *labeledCopy =
+    dynamic_cast<const LabeledVesselSection*>( snapshotBranch3->GetWritableSection( 2 ) );
+  
+  if( !labeledCopy || labeledCopy == labeledSection.GetPointer() ||
+    labeledCopy->GetLabel() != 7 || labeledCopy->GetRadius() != 2.0 )
+  {
+    std::cerr << "The copy of the section lost its type or members." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The non-const accessor lets sections be modified in place, so the shared ones are copied
+  snapshotBranch3->GetCenterline()->at(0)->SetRadius( 4.0 );
+  
+  if( ReadCenterline( branch3 )->at(0)->GetRadius() != 1.0 ||
+    ReadCenterline( snapshotBranch3 )->at(0)->GetRadius() != 4.0 ||
+    ReadCenterline( snapshotBranch3 )->at(2) != labeledCopy ||
+    ReadCenterline( branch1 ) != ReadCenterline( snapshotBranch1 ) )
+  {
+    std::cerr << "The non-const accessor changed the original graph." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Once unshared, the non-const accessor does not copy again
+  const CenterlineType *centerline3 = ReadCenterline( snapshotBranch3 );
+  
+  if( snapshotBranch3->GetCenterline() != centerline3 )
+  {
+    std::cerr << "The unshared centerline was copied again." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,229 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphStitcherTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests stitching the branches of graphs tracked over neighbouring regions.
+
+#include "ivanVesselGraphStitcher.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+
+typedef ivan::VesselGraphStitcher<CenterlineType>   StitcherType;
+
+
+// Straight branch of sections of radius 1 from (x0,y0) to (x1,y1), along x or y in unit steps
+BranchNodeType::Pointer MakeBranch( int x0, int y0, int x1, int y1 )
+{
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  
+  const int length = std::max( std::abs( x1 - x0 ), std::abs( y1 - y0 ) );
+  
+  for( int i = 0; i <= length; ++i )
+  {
+    SectionType::PointType center;
+    center[0] = x0 + ( x1 - x0 ) * i / length;
+    center[1] = y0 + ( y1 - y0 ) * i / length;
+    center[2] = 0.0;
+    
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetRadius( 1.0 );
+    branch->GetCenterline()->push_back( section );
+  }
+  
+  return branch;
+}
+
+
+GraphType::Pointer MakeGraph( BranchNodeType * branch1, BranchNodeType * branch2 = 0 )
+{
+  ivan::VesselNode::Pointer rootNode = ivan::VesselNode::New();
+  rootNode->SetNodeId( 0 );
+  
+  branch1->SetNodeId( 1 );
+  rootNode->AddChild( branch1 );
+  
+  if( branch2 )
+  {
+    branch2->SetNodeId( 2 );
+    rootNode->AddChild( branch2 );
+  }
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( rootNode );
+  
+  return graph;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // A vessel along x tracked in three pieces: the first two overlap over [50,55], and the 
+  // third one was tracked backwards from x=150 and touches the second at x=100. A parallel 
+  // vessel at y=10 and a piece of the same graph touching the first piece are not stitched.
+  BranchNodeType::Pointer piece1 = MakeBranch( 0, 0, 55, 0 );
+  BranchNodeType::Pointer piece2 = MakeBranch( 50, 0, 100, 0 );
+  BranchNodeType::Pointer piece3 = MakeBranch( 150, 0, 100, 0 );
+  BranchNodeType::Pointer parallel = MakeBranch( 0, 10, 100, 10 );
+  BranchNodeType::Pointer sameGraph = MakeBranch( 0, 0, -20, 0 );
+  
+  StitcherType::Pointer stitcher = StitcherType::New();
+  stitcher->AddGraph( MakeGraph( piece1, sameGraph ) );
+  stitcher->AddGraph( MakeGraph( piece2, parallel ) );
+  stitcher->AddGraph( MakeGraph( piece3 ) );
+  stitcher->SetTolerance( 0.5 );
+  stitcher->Update();
+  
+  GraphType *output = stitcher->GetOutput();
+  
+  if( stitcher->GetNumberOfStitches() != 2 || output->GetRootNode()->GetNumberOfChildren() != 3 )
+  {
+    std::cerr << "Wrong number of stitches: " << stitcher->GetNumberOfStitches() 
+      << ", branches: " << output->GetRootNode()->GetNumberOfChildren() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const BranchNodeType *stitched = 
+    dynamic_cast<const BranchNodeType*>( output->GetRootNode()->GetChild(0) );
+  
+  if( !stitched || stitched->GetNodeId() != 1 || stitched->GetCenterline()->size() != 151 )
+  {
+    std::cerr << "Wrong stitched branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Each position once, in order
+  for( unsigned int i=0; i<stitched->GetCenterline()->size(); ++i )
+  {
+    if( stitched->GetCenterline()->ElementAt(i)->GetCenter()[0] != i )
+    {
+      std::cerr << "Wrong section " << i << ": " 
+        << stitched->GetCenterline()->ElementAt(i)->GetCenter() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A trunk tracked in two pieces, each with a child branch at a bifurcation. The stitched 
+  // trunk keeps both bifurcations, and each bifurcation its child
+  BranchNodeType::Pointer trunk1 = MakeBranch( 0, 0, 55, 0 );
+  BranchNodeType::Pointer trunk2 = MakeBranch( 50, 0, 100, 0 );
+  BranchNodeType::Pointer children[2] = { MakeBranch( 30, 0, 30, 20 ), MakeBranch( 80, 0, 80, -20 ) };
+  BranchNodeType::Pointer trunks[2] = { trunk1, trunk2 };
+  
+  stitcher->ClearGraphs();
+  
+  for( unsigned int i=0; i<2; ++i )
+  {
+    BifurcationNodeType::Pointer bifurcation = BifurcationNodeType::New();
+    bifurcation->SetNodeId( 2 );
+    trunks[i]->AddChild( bifurcation );
+    
+    children[i]->SetNodeId( 3 );
+    bifurcation->AddChild( children[i] );
+    
+    stitcher->AddGraph( MakeGraph( trunks[i] ) );
+  }
+  
+  stitcher->Update();
+  
+  output = stitcher->GetOutput();
+  
+  if( stitcher->GetNumberOfStitches() != 1 || output->GetRootNode()->GetNumberOfChildren() != 1 )
+  {
+    std::cerr << "Wrong stitched trunk: " << stitcher->GetNumberOfStitches() << " stitches, " 
+      << output->GetRootNode()->GetNumberOfChildren() << " root children" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const BranchNodeType *stitchedTrunk = 
+    dynamic_cast<const BranchNodeType*>( output->GetRootNode()->GetChild(0) );
+  
+  if( !stitchedTrunk || stitchedTrunk->GetCenterline()->size() != 101 || 
+    stitchedTrunk->GetNumberOfChildren() != 2 )
+  {
+    std::cerr << "The stitched trunk lost its bifurcations." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  for( unsigned int i=0; i<2; ++i )
+  {
+    const BifurcationNodeType *bifurcation = 
+      dynamic_cast<const BifurcationNodeType*>( stitchedTrunk->GetChild(i) );
+    
+    if( !bifurcation || bifurcation->GetNumberOfParents() != 1 || 
+      bifurcation->GetParent() != stitchedTrunk || bifurcation->GetNumberOfChildren() != 1 )
+    {
+      std::cerr << "Wrong bifurcation " << i << " of the stitched trunk." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const BranchNodeType *child = dynamic_cast<const BranchNodeType*>( bifurcation->GetChild(0) );
+    
+    if( !child || child->GetParent() != bifurcation || child->GetNodeId() != 2 + i ||
+      child->GetCenterline()->size() != 21 || 
+      child->GetCenterline()->GetFirstSection()->GetCenter()[0] != 30.0 + 50.0 * i ||
+      child->GetCenterline()->GetFirstSection()->GetCenter()[1] != 0.0 )
+    {
+      std::cerr << "Wrong child branch of bifurcation " << i << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // A closed square vessel tracked in four pieces gives a single branch, cut at one corner
+  stitcher->ClearGraphs();
+  stitcher->AddGraph( MakeGraph( MakeBranch( 0, 0, 20, 0 ) ) );
+  stitcher->AddGraph( MakeGraph( MakeBranch( 20, 0, 20, 20 ) ) );
+  stitcher->AddGraph( MakeGraph( MakeBranch( 20, 20, 0, 20 ) ) );
+  stitcher->AddGraph( MakeGraph( MakeBranch( 0, 20, 0, 0 ) ) );
+  stitcher->Update();
+  
+  if( stitcher->GetNumberOfStitches() != 3 || 
+    stitcher->GetOutput()->GetRootNode()->GetNumberOfChildren() != 1 ||
+    dynamic_cast<const BranchNodeType*>( stitcher->GetOutput()->GetRootNode()->GetChild(0) )
+      ->GetCenterline()->size() != 81 )
+  {
+    std::cerr << "Closed chain not stitched into one branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
@@ -24,7 +24,8 @@ SUCH DAMAGE.
 ==========================================================================*/
 // File: ivanVesselGraphTest.cxx
 // Author: Iv�n Mac�a (imacia@vicomtech.org)
-// Description: test the correct addition and deletion of nodes
+// Description: test the correct addition and deletion of nodes. Pass "arena" to allocate them
+// from the arena of the graph.
 
 #include "ivanVesselGraph.h"
 #include "ivanGraphCountNodeVisitor.h"
@@ -34,9 +35,31 @@ SUCH DAMAGE.
 #include "ivanVesselSection.h"
 
 #include "itkPoint.h"
+#include "itkMultiThreader.h"
 
 #include <stdlib.h>
 #include <ctime>
+#include <string>
+#include <iostream>
+
+
+// Node created on another thread, which does not see the arena activated by the main thread
+struct OtherThreadNode
+{
+  ivan::VesselNode::Pointer   Node;
+  bool                        ArenaActive;
+};
+
+ITK_THREAD_RETURN_TYPE CreateNodeThreaderCallback( void *arg )
+{
+  OtherThreadNode *result = 
+    (OtherThreadNode *)( ((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData );
+  
+  result->ArenaActive = ( ivan::ArenaAllocator::GetActiveArena() != 0 );
+  result->Node = ivan::VesselNode::New();
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
 
 
 int main( int argc, const char *argv[] )
@@ -52,8 +75,17 @@ int main( int argc, const char *argv[] )
   typedef ivan::VesselBifurcationNode<CenterlineType>  BifurcationNodeType;
   typedef ivan::VesselGraph<CenterlineType>            GraphType;
     
+  const bool useArena = argc > 1 && std::string( argv[1] ) == "arena";
+  
+  GraphType::Pointer graph = GraphType::New();
+  ivan::ArenaAllocator::Pointer arena = useArena ? graph->GetArena() : 0;
+  
   std::vector<VesselNodeType::Pointer> nodes;
   BranchNodeType::Pointer vesselBranch;
+  BifurcationNodeType::Pointer vesselBifurcation;
+
+  // Nodes created from here are taken from the arena, if used
+  ivan::ArenaAllocator::SetActiveArena( arena );
 
   for( unsigned int i=0; i<5; ++i )
   {
@@ -62,16 +94,38 @@ int main( int argc, const char *argv[] )
     nodes.push_back( vesselBranch.GetPointer() );
   }
 
-  BifurcationNodeType::Pointer vesselBifurcation;
-
   for( unsigned int i=5; i<10; ++i )
   {
     vesselBifurcation = BifurcationNodeType::New();
     vesselBifurcation->SetNodeId(i+1);
     nodes.push_back( vesselBifurcation.GetPointer() );
   }
+  
+  // The arena is only active in this thread
+  OtherThreadNode otherThreadNode;
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  const int threadId = threader->SpawnThread( CreateNodeThreaderCallback, &otherThreadNode );
+  threader->TerminateThread( threadId );
+  
+  ivan::ArenaAllocator::SetActiveArena( 0 );
+  
+  if( otherThreadNode.ArenaActive || otherThreadNode.Node.IsNull() )
+  {
+    std::cerr << "The arena is active in another thread." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Branches also create their centerlines, while the node of the other thread uses the heap
+  if( useArena && arena->GetNumberOfLiveAllocations() != nodes.size() + 5 )
+  {
+    std::cerr << "Nodes were not allocated from the arena." << std::endl;
+    arena->Print( std::cerr );
+    return EXIT_FAILURE;
+  }
+  
+  otherThreadNode.Node = 0;
 
-  GraphType::Pointer graph = GraphType::New();
   graph->SetRootNode( nodes[0] );
 
   nodes[0]->AddChild( nodes[1] );
@@ -91,6 +145,19 @@ int main( int argc, const char *argv[] )
   // Print the result
 
   //vesselBranch->Print( std::cout );
+  
+  // Destroying the graph releases all the nodes, and the arena memory with the last reference
+  nodes.clear();
+  vesselBranch = 0;
+  vesselBifurcation = 0;
+  graph = 0;
+  
+  if( useArena && ( arena->GetReferenceCount() != 1 || arena->GetNumberOfLiveAllocations() != 0 ) )
+  {
+    std::cerr << "Nodes still alive after destroying the graph." << std::endl;
+    arena->Print( std::cerr );
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS; 
 }
@@ -0,0 +1,189 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanCurvedPlanarReformationImageFilterTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the cross-section stack and the straightened volume of a straight 
+//   centerline on an image whose values are known on the planes, with one and several threads
+//   and sampling from the bricked copy.
+
+#include "ivanCurvedPlanarReformationImageFilter.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                         ImageType;
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+
+typedef ivan::CurvedPlanarReformationImageFilter
+  <ImageType, CenterlineType>                       ReformationFilterType;
+
+
+/** Check the slices of a reformation along the z axis. The value of the pixel at (i,j) of a 
+  * slice at height z is 1000 z + ( i - c )^2 + ( j - c )^2, c being the center of the plane. */
+bool CheckSlices( const ImageType *output, double firstZ, double sliceStep, double tolerance )
+{
+  const ImageType::SizeType & size = output->GetLargestPossibleRegion().GetSize();
+  const double center = 0.5 * ( size[0] - 1.0 );
+  
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it( output, output->GetLargestPossibleRegion() );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double di = index[0] - center;
+    const double dj = index[1] - center;
+    const double expected = 1000.0 * ( firstZ + sliceStep * index[2] ) + di * di + dj * dj;
+    
+    if( std::fabs( it.Get() - expected ) > tolerance )
+    {
+      std::cerr << "Pixel " << index << " is " << it.Get() << " instead of " << expected << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int, char ** )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 32 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 32 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dx = index[0] - 16.0;
+    const double dy = index[1] - 16.0;
+    
+    it.Set( 1000.0 * index[2] + dx * dx + dy * dy );
+  }
+  
+  // Straight centerline at x=y=16 from z=4 to z=27
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<24; ++i )
+  {
+    SectionType::PointType center;
+    center[0] = 16.0;
+    center[1] = 16.0;
+    center[2] = 4.0 + i;
+    
+    SectionType::VectorType normal;
+    normal[0] = 0.0;
+    normal[1] = 0.0;
+    normal[2] = 1.0;
+    
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    centerline->push_back( section );
+  }
+  
+  ReformationFilterType::Pointer filter = ReformationFilterType::New();
+  filter->SetInput( image );
+  filter->SetCenterline( centerline );
+  filter->SetPlaneSize( 9 );
+  filter->SetPlaneSpacing( 1.0 );
+  
+  for( unsigned int run=0; run < 3; ++run )
+  {
+    // One thread, several threads, and several threads from the bricked copy
+    filter->SetNumberOfThreads( ( run == 0 ) ? 1 : 4 );
+    filter->SetUseBrickedImage( run == 2 );
+    
+    try
+    {
+      filter->Update();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( filter->GetNumberOfSlices() != 24 || 
+      filter->GetOutput()->GetLargestPossibleRegion().GetSize()[2] != 24 ||
+      filter->GetSliceCenter( 3 )[2] != 7.0 || filter->GetSliceAxis( 3, 2 )[2] != 1.0 )
+    {
+      std::cerr << "Wrong cross-section stack in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( !CheckSlices( filter->GetOutput(), 4.0, 1.0, 1e-3 ) )
+    {
+      std::cerr << "Wrong cross-sections in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Straightened volume every half pixel along the centerline
+  filter->SetReformationMode( ReformationFilterType::StraightenedMode );
+  filter->SetSliceSpacing( 0.5 );
+  filter->SetUseBrickedImage( false );
+  
+  try
+  {
+    filter->Update();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( filter->GetNumberOfSlices() != 47 || filter->GetOutput()->GetSpacing()[2] != 0.5 )
+  {
+    std::cerr << "Wrong number of straightened slices " << filter->GetNumberOfSlices() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !CheckSlices( filter->GetOutput(), 4.0, 0.5, 1e-2 ) )
+  {
+    std::cerr << "Wrong straightened volume" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
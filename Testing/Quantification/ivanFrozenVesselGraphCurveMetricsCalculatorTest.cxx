@@ -0,0 +1,236 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphCurveMetricsCalculatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the batch computation of curve metrics and tortuosity on a frozen graph.
+
+#include "ivanFrozenVesselGraphCurveMetricsCalculator.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanLocalCurveMetrics.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "ivanVesselGraphTestingHelper.h"
+
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::LocalCurveMetrics<3>                       CurveMetricsType;
+typedef ivan::CircularVesselSection<3,CurveMetricsType>  SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                            CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>           BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType>      BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>                GraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>          FrozenGraphType;
+typedef ivan::FrozenVesselGraphCurveMetricsCalculator
+  <CenterlineType>                                       CalculatorType;
+
+const double helixRadius = 5.0;
+const double helixPitch = 2.0;
+const double angleStep = vnl_math::pi / 32.0;
+
+
+BranchNodeType::Pointer CreateHelixBranch( unsigned int id, unsigned int numberOfSections )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const double t = i * angleStep;
+    
+    SectionType::Pointer section = SectionType::New();
+    
+    SectionType::PointType center;
+    center[0] = helixRadius * std::cos( t );
+    center[1] = helixRadius * std::sin( t );
+    center[2] = helixPitch * t;
+    section->SetCenter( center );
+    
+    centerline->push_back( section );
+  }
+  
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetNodeId( id );
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+int main( int argc, char ** argv )
+{
+  // Helix 1 -> bifurcation 2 -> { straight 3, helix 4 }
+  BranchNodeType::Pointer branch1 = CreateHelixBranch( 1, 80 );
+  BranchNodeType::Pointer branch3 = CreateTestBranch<BranchNodeType>( 3, 20, 2.0 );
+  BranchNodeType::Pointer branch4 = CreateHelixBranch( 4, 40 );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  FrozenGraphType::Pointer frozen = FrozenGraphType::New();
+  frozen->Freeze( graph );
+  
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetFrozenGraph( frozen );
+  calculator->SetNumberOfThreads( 4 );
+  calculator->Compute();
+  
+  if( calculator->GetNumberOfProcessedBranches() != 3 || 
+      calculator->GetNumberOfProcessedSections() != 140 )
+  {
+    std::cerr << "Processed " << calculator->GetNumberOfProcessedBranches() << " branches and "
+      << calculator->GetNumberOfProcessedSections() << " sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const double expectedCurvature = helixRadius / ( helixRadius * helixRadius + helixPitch * helixPitch );
+  const double expectedTorsion = helixPitch / ( helixRadius * helixRadius + helixPitch * helixPitch );
+  
+  for( FrozenGraphType::NodeIndex n=0; n<frozen->GetNumberOfNodes(); ++n )
+  {
+    if( !frozen->IsBranch( n ) )
+    {
+      if( calculator->GetBranchLength( n ) != 0.0 )
+      {
+        std::cerr << "Length computed for a node that is not a branch." << std::endl;
+        return EXIT_FAILURE;
+      }
+      continue;
+    }
+    
+    const unsigned int numberOfSections = frozen->GetNumberOfSections( n );
+    const double length = frozen->ComputeBranchLength( n );
+    
+    if( std::fabs( calculator->GetBranchLength( n ) - length ) > 1e-9 ||
+        std::fabs( calculator->GetArcLength( n, numberOfSections - 1 ) - length ) > 1e-9 )
+    {
+      std::cerr << "Wrong length of branch " << frozen->GetNodeId( n ) << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const double chord = frozen->GetSectionCenter( n, 0 ).
+      EuclideanDistanceTo( frozen->GetSectionCenter( n, numberOfSections - 1 ) );
+    
+    if( std::fabs( calculator->GetDistanceMetric( n ) - length / chord ) > 1e-9 )
+    {
+      std::cerr << "Wrong distance metric of branch " << frozen->GetNodeId( n ) << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    const bool isHelix = ( frozen->GetNodeId( n ) != 3 );
+    
+    if( !isHelix && ( calculator->GetSumOfAnglesMetric( n ) != 0.0 || 
+      std::fabs( calculator->GetDistanceMetric( n ) - 1.0 ) > 1e-12 ) )
+    {
+      std::cerr << "Straight branch is tortuous." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( isHelix && calculator->GetSumOfAnglesMetric( n ) <= 0.0 )
+    {
+      std::cerr << "Helix branch is not tortuous." << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    for( unsigned int i=0; i<numberOfSections; ++i )
+    {
+      const double curvature = calculator->GetCurvature( n, i );
+      const double torsion = calculator->GetTorsion( n, i );
+      
+      if( isHelix && ( std::fabs( curvature - expectedCurvature ) > 0.01 * expectedCurvature || 
+        std::fabs( torsion - expectedTorsion ) > 0.01 * expectedTorsion ) )
+      {
+        std::cerr << "Wrong metrics at section " << i << " of branch " << frozen->GetNodeId( n ) 
+          << ": curvature " << curvature << " (expected " << expectedCurvature << "), torsion " 
+          << torsion << " (expected " << expectedTorsion << ")" << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      if( !isHelix && ( curvature != 0.0 || torsion != 0.0 ) )
+      {
+        std::cerr << "Straight branch is curved at section " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      if( std::fabs( calculator->GetTangent( n, i ).GetNorm() - 1.0 ) > 1e-9 )
+      {
+        std::cerr << "Tangent is not unitary at section " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      // Results are also in the sections of the original graph
+      const CurveMetricsType & metrics = frozen->GetSection( n, i )->GetCurveMetrics();
+      
+      if( metrics.GetCurvature() != curvature || metrics.GetTorsion() != torsion )
+      {
+        std::cerr << "Metrics not written to section " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  if( branch4->GetCenterline()->at( 10 )->GetCurveMetrics().GetCurvature() == 0.0 )
+  {
+    std::cerr << "Metrics not written to the original graph." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Threads do not change the results
+  CalculatorType::Pointer serialCalculator = CalculatorType::New();
+  serialCalculator->SetFrozenGraph( frozen );
+  serialCalculator->SetNumberOfThreads( 1 );
+  serialCalculator->WriteCurveMetricsOff();
+  serialCalculator->Compute();
+  
+  for( FrozenGraphType::NodeIndex n=0; n<frozen->GetNumberOfNodes(); ++n )
+  {
+    for( unsigned int i=0; i<frozen->GetNumberOfSections( n ); ++i )
+    {
+      if( serialCalculator->GetCurvature( n, i ) != calculator->GetCurvature( n, i ) ||
+          serialCalculator->GetTorsion( n, i ) != calculator->GetTorsion( n, i ) )
+      {
+        std::cerr << "Serial and parallel results differ." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+    
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanFrozenVesselGraphQuantifierTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the per branch and whole tree measurements of a frozen graph.
+
+#include "ivanFrozenVesselGraphQuantifier.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanVesselGraph.h"
+#include "ivanVesselBranchNode.h"
+#include "ivanVesselBifurcationNode.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+  
+typedef ivan::VesselBranchNode<CenterlineType>      BranchNodeType;
+typedef ivan::VesselBifurcationNode<CenterlineType> BifurcationNodeType;
+typedef ivan::VesselGraph<CenterlineType>           GraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>     FrozenGraphType;
+typedef ivan::FrozenVesselGraphQuantifier
+  <CenterlineType>                                  QuantifierType;
+
+
+/** Straight branch of unit spacing from the origin along the given direction. If bent, 
+  * the second half goes along the x axis. */
+BranchNodeType::Pointer CreateBranch( unsigned int id, const SectionType::PointType & origin,
+  double dx, double dy, unsigned int numberOfSections, double radius, bool bent = false )
+{
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  SectionType::PointType center = origin;
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetRadius( radius );
+    centerline->push_back( section );
+    
+    if( bent && i >= numberOfSections / 2 )
+    {
+      center[0] += 1.0;
+    }
+    else
+    {
+      center[0] += dx;
+      center[1] += dy;
+    }
+  }
+  
+  BranchNodeType::Pointer branch = BranchNodeType::New();
+  branch->SetNodeId( id );
+  branch->SetCenterline( centerline );
+  
+  return branch;
+}
+
+
+int main( int argc, char ** argv )
+{
+  const double diagonal = std::sqrt( 0.5 );
+  
+  SectionType::PointType origin;
+  origin.Fill( 0.0 );
+  
+  // Branch 1 -> bifurcation 2 -> { 3, bent 4 }, children start at right angles
+  BranchNodeType::Pointer branch1 = CreateBranch( 1, origin, 0.0, 1.0, 11, 2.0 );
+  
+  SectionType::PointType bifurcationPoint = origin;
+  bifurcationPoint[1] = 10.0;
+  
+  BranchNodeType::Pointer branch3 = CreateBranch( 3, bifurcationPoint, diagonal, diagonal, 9, 1.3 );
+  BranchNodeType::Pointer branch4 = CreateBranch( 4, bifurcationPoint, -diagonal, diagonal, 12, 0.9, true );
+  
+  BifurcationNodeType::Pointer bifurcation2 = BifurcationNodeType::New();
+  bifurcation2->SetNodeId( 2 );
+  
+  branch1->AddChild( bifurcation2 );
+  bifurcation2->AddChild( branch3 );
+  bifurcation2->AddChild( branch4 );
+  
+  GraphType::Pointer graph = GraphType::New();
+  graph->SetRootNode( branch1 );
+  
+  FrozenGraphType::Pointer frozen = FrozenGraphType::New();
+  frozen->Freeze( graph );
+  
+  QuantifierType::Pointer quantifier = QuantifierType::New();
+  quantifier->SetFrozenGraph( frozen );
+  quantifier->SetNumberOfThreads( 4 );
+  quantifier->SetNumberOfRadiusBins( 10 );
+  quantifier->SetRadiusHistogramMinimum( 0.0 );
+  quantifier->SetRadiusHistogramMaximum( 2.0 );
+  quantifier->Compute();
+  
+  if( quantifier->GetNumberOfBranches() != 3 || quantifier->GetNumberOfBifurcations() != 1 )
+  {
+    std::cerr << "Measured " << quantifier->GetNumberOfBranches() << " branches and " 
+      << quantifier->GetNumberOfBifurcations() << " bifurcations." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Straight cylinder
+  const FrozenGraphType::NodeIndex node1 = frozen->FindNodeById( 1 );
+  
+  if( std::fabs( quantifier->GetBranchLength( node1 ) - 10.0 ) > 1e-9 ||
+      std::fabs( quantifier->GetBranchVolume( node1 ) - vnl_math::pi * 4.0 * 10.0 ) > 1e-9 ||
+      std::fabs( quantifier->GetBranchMeanRadius( node1 ) - 2.0 ) > 1e-12 ||
+      std::fabs( quantifier->GetBranchTortuosity( node1 ) - 1.0 ) > 1e-9 )
+  {
+    std::cerr << "Wrong measurements of the straight branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Bent branch is tortuous
+  const FrozenGraphType::NodeIndex node4 = frozen->FindNodeById( 4 );
+  const double chord4 = frozen->GetSectionCenter( node4, 0 ).EuclideanDistanceTo( 
+    frozen->GetSectionCenter( node4, frozen->GetNumberOfSections( node4 ) - 1 ) );
+  
+  if( std::fabs( quantifier->GetBranchTortuosity( node4 ) - 11.0 / chord4 ) > 1e-9 ||
+      quantifier->GetMaximumTortuosity() != quantifier->GetBranchTortuosity( node4 ) )
+  {
+    std::cerr << "Wrong tortuosity of the bent branch." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Whole tree
+  const double expectedLength = 10.0 + 8.0 + 11.0;
+  const double expectedVolume = vnl_math::pi * ( 4.0 * 10.0 + 1.69 * 8.0 + 0.81 * 11.0 );
+  
+  if( std::fabs( quantifier->GetTotalLength() - expectedLength ) > 1e-9 ||
+      std::fabs( quantifier->GetTotalVolume() - expectedVolume ) > 1e-9 )
+  {
+    std::cerr << "Wrong total length " << quantifier->GetTotalLength() << " or volume " 
+      << quantifier->GetTotalVolume() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const double expectedMeanTortuosity = ( 2.0 + 11.0 / chord4 ) / 3.0;
+  
+  if( std::fabs( quantifier->GetMeanTortuosity() - expectedMeanTortuosity ) > 1e-9 )
+  {
+    std::cerr << "Wrong mean tortuosity " << quantifier->GetMeanTortuosity() << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Bifurcation angle
+  const FrozenGraphType::NodeIndex node2 = frozen->FindNodeById( 2 );
+  
+  if( std::fabs( quantifier->GetBifurcationAngle( node2 ) - vnl_math::pi_over_2 ) > 1e-9 ||
+      std::fabs( quantifier->GetMeanBifurcationAngle() - vnl_math::pi_over_2 ) > 1e-9 ||
+      quantifier->GetBifurcationAngle( node1 ) != 0.0 )
+  {
+    std::cerr << "Wrong bifurcation angle " << quantifier->GetBifurcationAngle( node2 ) << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Radius histogram of 0.2 wide bins
+  const QuantifierType::HistogramType & histogram = quantifier->GetRadiusHistogram();
+  
+  if( histogram.size() != 10 || histogram[4] != 12 || histogram[6] != 9 || histogram[9] != 11 )
+  {
+    std::cerr << "Wrong radius histogram." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  unsigned long histogramTotal = 0;
+  for( unsigned int b=0; b<histogram.size(); ++b )
+    histogramTotal += histogram[b];
+    
+  if( histogramTotal != frozen->GetTotalNumberOfSections() )
+  {
+    std::cerr << "Histogram does not count all the sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The serial pass gives the same results
+  QuantifierType::Pointer serialQuantifier = QuantifierType::New();
+  serialQuantifier->SetFrozenGraph( frozen );
+  serialQuantifier->SetNumberOfThreads( 1 );
+  serialQuantifier->SetNumberOfRadiusBins( 10 );
+  serialQuantifier->SetRadiusHistogramMaximum( 2.0 );
+  serialQuantifier->Compute();
+  
+  if( std::fabs( serialQuantifier->GetTotalVolume() - quantifier->GetTotalVolume() ) > 1e-9 ||
+      serialQuantifier->GetRadiusHistogram() != histogram )
+  {
+    std::cerr << "Serial and parallel results differ." << std::endl;
+    return EXIT_FAILURE;
+  }
+    
+  return EXIT_SUCCESS;
+}
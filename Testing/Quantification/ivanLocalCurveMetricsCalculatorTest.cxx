@@ -0,0 +1,229 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanLocalCurveMetricsCalculatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests curvature and torsion on a helix and the incremental update of the metrics.
+
+#include "ivanLocalCurveMetricsCalculator.h"
+#include "ivanLocalCurveMetrics.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef ivan::LocalCurveMetrics<3>                     CurveMetricsType;
+typedef ivan::CircularVesselSection<3,CurveMetricsType>  SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                          CenterlineType;
+typedef ivan::LocalCurveMetricsCalculator
+  <CenterlineType>                                     CalculatorType;
+
+const double helixRadius = 5.0;
+const double helixPitch = 2.0;
+const double angleStep = vnl_math::pi / 32.0;
+
+
+SectionType::PointType HelixPoint( unsigned int i )
+{
+  const double t = i * angleStep;
+  
+  SectionType::PointType center;
+  center[0] = helixRadius * std::cos( t );
+  center[1] = helixRadius * std::sin( t );
+  center[2] = helixPitch * t;
+  
+  return center;
+}
+
+
+void AppendHelixSections( CenterlineType * centerline, unsigned int numberOfSections )
+{
+  const unsigned int first = centerline->size();
+  
+  for( unsigned int i=first; i<first+numberOfSections; ++i )
+  {
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( HelixPoint( i ) );
+    section->SetRadius( 1.0 );
+    centerline->push_back( section );
+  }
+}
+
+
+/** Compare the metrics of two centerlines with the same centers. */
+bool CompareMetrics( const CenterlineType * centerline1, const CenterlineType * centerline2 )
+{
+  for( unsigned int i=0; i<centerline1->size(); ++i )
+  {
+    const CurveMetricsType & metrics1 = centerline1->at(i)->GetCurveMetrics();
+    const CurveMetricsType & metrics2 = centerline2->at(i)->GetCurveMetrics();
+    
+    if( std::fabs( metrics1.GetCurvature() - metrics2.GetCurvature() ) > 1e-9 ||
+        std::fabs( metrics1.GetTorsion() - metrics2.GetTorsion() ) > 1e-9 ||
+        ( metrics1.GetTangent() - metrics2.GetTangent() ).GetNorm() > 1e-9 )
+    {
+      std::cerr << "Metrics differ at section " << i << std::endl;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+
+int main( int argc, char ** argv )
+{
+  const unsigned int numberOfSections = 120;
+  
+  // Expected values for a helix of radius a and pitch b
+  const double expectedCurvature = helixRadius / ( helixRadius * helixRadius + helixPitch * helixPitch );
+  const double expectedTorsion = helixPitch / ( helixRadius * helixRadius + helixPitch * helixPitch );
+    
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  AppendHelixSections( centerline, numberOfSections );
+  
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetStencilRadius( 3 );
+  calculator->SetCenterline( centerline );
+  calculator->Compute();
+  
+  if( calculator->GetNumberOfComputedSections() != numberOfSections )
+  {
+    std::cerr << "Unexpected number of computed sections." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Check values along the helix. Shifted windows at the ends are less accurate
+  const unsigned int stencilRadius = calculator->GetStencilRadius();
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    const CurveMetricsType & metrics = centerline->at(i)->GetCurveMetrics();
+    
+    const double curvatureError = std::fabs( metrics.GetCurvature() - expectedCurvature ) / expectedCurvature;
+    const double torsionError = std::fabs( metrics.GetTorsion() - expectedTorsion ) / expectedTorsion;
+    
+    const bool interior = ( i >= stencilRadius && i < numberOfSections - stencilRadius );
+    const double curvatureTolerance = interior ? 0.01 : 0.05;
+    const double torsionTolerance = interior ? 0.01 : 0.1;
+    
+    if( curvatureError > curvatureTolerance || torsionError > torsionTolerance )
+    {
+      std::cerr << "Wrong metrics at section " << i << ": curvature " << metrics.GetCurvature() 
+        << " (expected " << expectedCurvature << "), torsion " << metrics.GetTorsion() 
+        << " (expected " << expectedTorsion << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    // The Frenet frame must be orthonormal
+    CurveMetricsType::VectorType tangent = metrics.GetTangent();
+    CurveMetricsType::VectorType normal = metrics.GetNormal();
+    CurveMetricsType::VectorType binormal = metrics.GetBinormal();
+    
+    if( std::fabs( tangent.GetNorm() - 1.0 ) > 1e-9 || std::fabs( normal.GetNorm() - 1.0 ) > 1e-9 ||
+        std::fabs( binormal.GetNorm() - 1.0 ) > 1e-9 || std::fabs( tangent * normal ) > 1e-9 )
+    {
+      std::cerr << "Frenet frame is not orthonormal at section " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  // Compute incrementally while appending sections and compare with a full computation
+  CenterlineType::Pointer incrementalCenterline = CenterlineType::New();
+  
+  CalculatorType::Pointer incrementalCalculator = CalculatorType::New();
+  incrementalCalculator->SetStencilRadius( 3 );
+  incrementalCalculator->SetCenterline( incrementalCenterline );
+  
+  const unsigned int chunkSize = 10;
+  
+  for( unsigned int i=0; i<numberOfSections; i+=chunkSize )
+  {
+    AppendHelixSections( incrementalCenterline, chunkSize );
+    incrementalCalculator->ComputeModified();
+    
+    if( i > 0 && incrementalCalculator->GetNumberOfEvaluatedSections() != 
+      chunkSize + 2 * incrementalCalculator->GetStencilRadius() )
+    {
+      std::cerr << "Unexpected number of evaluated sections after appending: " 
+        << incrementalCalculator->GetNumberOfEvaluatedSections() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  
+  if( !CompareMetrics( incrementalCenterline, centerline ) )
+  {
+    std::cerr << "Incremental computation after appending differs from full computation." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Nothing to do when nothing changed
+  incrementalCalculator->ComputeModified();
+  
+  if( incrementalCalculator->GetNumberOfEvaluatedSections() != 0 )
+  {
+    std::cerr << "Sections evaluated without modifications." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Move some sections in the middle and at the ends
+  const unsigned int modified[] = { 0, 57, 58, numberOfSections - 1 };
+  
+  for( unsigned int k=0; k<4; ++k )
+  {
+    SectionType::PointType center;
+    
+    center = incrementalCenterline->at( modified[k] )->GetCenter();
+    center[0] += 0.3;
+    incrementalCenterline->at( modified[k] )->SetCenter( center );
+    
+    center = centerline->at( modified[k] )->GetCenter();
+    center[0] += 0.3;
+    centerline->at( modified[k] )->SetCenter( center );
+    
+    incrementalCenterline->MarkModifiedSections( modified[k], modified[k] + 1 );
+  }
+  
+  incrementalCalculator->ComputeModified();
+  calculator->Compute();
+  
+  if( incrementalCenterline->HasModifiedSections() )
+  {
+    std::cerr << "Modified sections not cleared." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  if( !CompareMetrics( incrementalCenterline, centerline ) )
+  {
+    std::cerr << "Incremental computation after modification differs from full computation." << std::endl;
+    return EXIT_FAILURE;
+  }
+    
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanRayCastingRadialContourEstimatorTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: tests the contours estimated on a synthetic tube of known radius with both edge 
+//   criteria, with one and several threads.
+
+#include "ivanRayCastingRadialContourEstimator.h"
+#include "ivanVesselCenterline.h"
+#include "ivanCircularVesselSection.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+#include <cmath>
+
+
+typedef itk::Image<float,3>                         ImageType;
+
+typedef ivan::CircularVesselSection<3>              SectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, SectionType>                       CenterlineType;
+
+typedef ivan::RayCastingRadialContourEstimator
+  <ImageType, CenterlineType>                       EstimatorType;
+
+
+int main( int, char ** )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, 32 );
+  region.SetSize( 1, 32 );
+  region.SetSize( 2, 24 );
+  
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  
+  // Tube of radius 5 along z at x=y=16 with a linear edge two pixels wide
+  const double radius = 5.0;
+  
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+  
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    
+    const double dx = index[0] - 16.0;
+    const double dy = index[1] - 16.0;
+    const double distance = std::sqrt( dx * dx + dy * dy );
+    
+    double value = 0.5 - 0.5 * ( distance - radius );
+    value = ( value < 0.0 ) ? 0.0 : ( ( value > 1.0 ) ? 1.0 : value );
+    
+    it.Set( 1000.0 * value );
+  }
+  
+  CenterlineType::Pointer centerline = CenterlineType::New();
+  
+  for( unsigned int i=0; i<16; ++i )
+  {
+    SectionType::PointType center;
+    center[0] = 16.0;
+    center[1] = 16.0;
+    center[2] = 4.0 + i;
+    
+    SectionType::VectorType normal;
+    normal[0] = 0.0;
+    normal[1] = 0.0;
+    normal[2] = 1.0;
+    
+    SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    centerline->push_back( section );
+  }
+  
+  EstimatorType::Pointer estimator = EstimatorType::New();
+  estimator->SetImage( image );
+  estimator->SetCenterline( centerline );
+  estimator->SetNumberOfRays( 24 );
+  estimator->SetMaximumRadius( 10.0 );
+  estimator->SetStepLength( 0.25 );
+  
+  std::vector<double> singleThreaded;
+  
+  for( unsigned int run=0; run < 4; ++run )
+  {
+    // Both edge criteria with one thread and several threads
+    estimator->SetEdgeDetection( ( run < 2 ) ? EstimatorType::HalfMaximumEdge : 
+      EstimatorType::MaximumGradientEdge );
+    estimator->SetNumberOfThreads( ( run % 2 == 0 ) ? 1 : 4 );
+    
+    try
+    {
+      estimator->Compute();
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( estimator->GetNumberOfContours() != 16 )
+    {
+      std::cerr << "Wrong number of contours in run " << run << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    if( run % 2 == 0 )
+      singleThreaded.clear();
+    
+    for( unsigned int i=0; i<estimator->GetNumberOfContours(); ++i )
+    {
+      const EstimatorType::ContourType *contour = estimator->GetContour( i );
+      
+      if( contour->GetNumberOfElements() != 24 || contour->GetContourId() != i )
+      {
+        std::cerr << "Wrong contour " << i << " in run " << run << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      // The contour is not exactly circular, since the edge is linear on the voxel grid
+      for( unsigned int r=0; r<contour->GetNumberOfElements(); ++r )
+      {
+        const double estimated = contour->GetPoint( r );
+        
+        if( std::fabs( estimated - radius ) > 0.35 )
+        {
+          std::cerr << "Ray " << r << " of contour " << i << " is " << estimated 
+            << " instead of " << radius << " in run " << run << std::endl;
+          return EXIT_FAILURE;
+        }
+        
+        if( run % 2 == 0 )
+          singleThreaded.push_back( estimated );
+        else if( singleThreaded[ i * 24 + r ] != estimated )
+        {
+          std::cerr << "Threaded result of ray " << r << " of contour " << i 
+            << " differs in run " << run << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+      
+      if( std::fabs( estimator->GetMeanRadius( i ) - radius ) > 0.2 )
+      {
+        std::cerr << "Mean radius of contour " << i << " is " << estimator->GetMeanRadius( i ) 
+          << " in run " << run << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  
+  return EXIT_SUCCESS;
+}
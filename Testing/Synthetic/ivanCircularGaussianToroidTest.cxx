@@ -41,7 +41,7 @@ int main( int argc, char *argv[] )
   if( argc < 4 )
   {
     std::cerr << "Usage: " << std::endl;
-    std::cerr << argv[0] << " OutputFileName Sigma Radius Direction Spacing [StartAngle(grad)] [EndAngle(grad)] [MaxValue] [FullCircle] [NumberOfPts]" 
+    std::cerr << argv[0] << " OutputFileName Sigma Radius Direction Spacing [StartAngle(grad)] [EndAngle(grad)] [MaxValue] [FullCircle] [NumberOfPts] [NumberOfThreads]" 
     << std::endl;
     return EXIT_FAILURE;
   }
@@ -77,6 +77,9 @@ int main( int argc, char *argv[] )
     toroidGenerator.SetNumberOfPoints( atoi( argv[10] ) );
   else
     toroidGenerator.SetAutoComputeNumberOfPoints( true );
+    
+  if( argc > 11 )
+    toroidGenerator.SetNumberOfThreads( atoi( argv[11] ) );
 
   ToroidImageType::Pointer toroidImage;
   
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanConvolvedBarProfileTableTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: checks the tabulated convolved bar profile against its closed-form center value,
+// and the tabulated tube against a bar tube blurred with DiscreteGaussianImageFilter.
+// Date: 2012/11/05
+
+
+#include "ivanConvolvedBarProfileTable.h"
+#include "ivanCircularBarTubeGenerator.h"
+#include "ivanCircularConvolvedBarTubeGenerator.h"
+
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+
+int main( int, char ** )
+{
+  const double radius = 4.0;
+  const double sigma = 1.0;
+  
+  // At the center of the disk the profile is 1 - exp( -R^2 / ( 2 sigma^2 ) )
+  ivan::ConvolvedBarProfileTable table;
+  table.Build( radius, sigma );
+  
+  const double expectedCenterValue = 1.0 - std::exp( -0.5 * radius * radius / ( sigma * sigma ) );
+  
+  if( std::fabs( table.Evaluate( 0.0 ) - expectedCenterValue ) > 1e-5 )
+  {
+    std::cerr << "Profile at the center is " << table.Evaluate( 0.0 ) << ", expected " 
+      << expectedCenterValue << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The interpolated table follows the profile, decreases and vanishes far from the disk
+  double previousValue = 1.0;
+  
+  for( double distance = 0.0; distance < radius + 8.0 * sigma; distance += 0.037 )
+  {
+    const double value = table.Evaluate( distance );
+    const double expectedValue = 
+      ivan::ConvolvedBarProfileTable::ComputeProfile( distance / sigma, radius / sigma );
+    
+    if( std::fabs( value - expectedValue ) > 1e-4 || value > previousValue + 1e-9 || value < 0.0 )
+    {
+      std::cerr << "Profile at " << distance << " is " << value << ", expected " 
+        << expectedValue << std::endl;
+      return EXIT_FAILURE;
+    }
+    
+    previousValue = value;
+  }
+  
+  if( table.Evaluate( radius + 7.0 * sigma ) > 1e-7 )
+  {
+    std::cerr << "Profile does not vanish far from the disk" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Without blur the profile is the disk itself
+  ivan::ConvolvedBarProfileTable diskTable;
+  diskTable.Build( radius, 0.0 );
+  
+  if( diskTable.Evaluate( radius - 0.01 ) != 1.0 || diskTable.Evaluate( radius + 0.01 ) != 0.0 )
+  {
+    std::cerr << "Profile without blur is not the disk" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // The tabulated tube against a bar tube filtered with a Gaussian of the same sigma
+  typedef float    PixelType;
+  
+  typedef ivan::CircularBarTubeGenerator<PixelType>            BarTubeGeneratorType;
+  typedef ivan::CircularConvolvedBarTubeGenerator<PixelType>   ConvolvedTubeGeneratorType;
+  typedef BarTubeGeneratorType::ImageType                      TubeImageType;
+  
+  const double spacing = 0.25;
+  const unsigned long sectionImageSize = 81;
+  const unsigned long height = 40;
+  const PixelType maxValue = 100.0;
+  
+  BarTubeGeneratorType barTubeGenerator;
+  barTubeGenerator.SetTubeRadius( radius );
+  barTubeGenerator.SetHeight( height );
+  barTubeGenerator.SetImageSpacing( spacing );
+  barTubeGenerator.SetSectionImageSize( sectionImageSize );
+  barTubeGenerator.SetMaxValue( maxValue );
+  
+  // The bar section decreases linearly over one pixel beyond its radius, which has the area
+  // of a disk half a pixel larger
+  ConvolvedTubeGeneratorType convolvedTubeGenerator;
+  convolvedTubeGenerator.SetTubeRadius( radius + 0.5 * spacing );
+  convolvedTubeGenerator.SetSigma( sigma );
+  convolvedTubeGenerator.SetHeight( height );
+  convolvedTubeGenerator.SetImageSpacing( spacing );
+  convolvedTubeGenerator.SetSectionImageSize( sectionImageSize );
+  convolvedTubeGenerator.SetMaxValue( maxValue );
+  
+  typedef itk::DiscreteGaussianImageFilter<TubeImageType,TubeImageType>  GaussianFilterType;
+  
+  GaussianFilterType::Pointer gaussian = GaussianFilterType::New();
+  gaussian->SetVariance( sigma * sigma );
+  gaussian->SetMaximumError( 0.001 );
+  
+  TubeImageType::Pointer convolvedTubeImage;
+  
+  try
+  {
+    gaussian->SetInput( barTubeGenerator.Create() );
+    gaussian->Update();
+    
+    convolvedTubeImage = convolvedTubeGenerator.Create();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "EXCEPTION CAUGHT!!! " << excpt.GetDescription();
+    return EXIT_FAILURE;
+  }
+  
+  // Central slice, far from the ends of the tube along the axis
+  TubeImageType::RegionType sliceRegion = convolvedTubeImage->GetBufferedRegion();
+  sliceRegion.SetIndex( 2, height / 2 );
+  sliceRegion.SetSize( 2, 1 );
+  
+  itk::ImageRegionConstIteratorWithIndex<TubeImageType> filteredIt( gaussian->GetOutput(), sliceRegion );
+  itk::ImageRegionConstIteratorWithIndex<TubeImageType> convolvedIt( convolvedTubeImage, sliceRegion );
+  
+  double maximumDifference = 0.0;
+  double sumOfDifferences = 0.0;
+  unsigned long numberOfPixels = 0;
+  
+  for( filteredIt.GoToBegin(), convolvedIt.GoToBegin(); !filteredIt.IsAtEnd(); ++filteredIt, ++convolvedIt )
+  {
+    const double difference = std::fabs( filteredIt.Get() - convolvedIt.Get() );
+    
+    maximumDifference = vnl_math_max( maximumDifference, difference );
+    sumOfDifferences += difference;
+    ++numberOfPixels;
+  }
+  
+  const double meanDifference = sumOfDifferences / numberOfPixels;
+  
+  std::cout << "Maximum difference " << maximumDifference << ", mean difference " << meanDifference << std::endl;
+  
+  if( maximumDifference > 0.03 * maxValue || meanDifference > 0.005 * maxValue )
+  {
+    std::cerr << "The tabulated tube differs from the filtered bar tube" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
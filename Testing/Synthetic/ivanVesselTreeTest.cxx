@@ -0,0 +1,118 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselTreeTest.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: creates a random bifurcating vessel tree image and its ground-truth graph
+// Date: 2012/11/05
+
+
+#include "ivanVesselTreeGenerator.h"
+#include "ivanVesselGraphBinaryWriter.h"
+
+#include "itkImageFileWriter.h"
+#include "itkTimeProbe.h"
+
+
+int main( int argc, char *argv[] )
+{
+  // Verify the number of parameters in the command line
+  if( argc < 3 )
+  {
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << " OutputFileName OutputGraphFileName [Depth=5] [RootRadius=4.0] [MaxBranches] "
+      << "[Tortuosity=0.05] [NoiseSigma=0.0] [Seed=1] [ImageSpacing=1.0] [MaxValue=255]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  typedef unsigned char    PixelType;
+  
+  typedef ivan::VesselTreeGenerator<PixelType>             TreeGeneratorType;
+  typedef TreeGeneratorType::ImageType                     TreeImageType;
+  typedef TreeGeneratorType::CenterlineType                CenterlineType;
+    
+  TreeGeneratorType treeGenerator;
+  
+  if( argc > 3 )
+    treeGenerator.SetDepth( atoi( argv[3] ) );
+  
+  if( argc > 4 )
+    treeGenerator.SetRootRadius( atof( argv[4] ) );
+  
+  if( argc > 5 && atol( argv[5] ) > 0 )
+    treeGenerator.SetMaximumNumberOfBranches( atol( argv[5] ) );
+  
+  if( argc > 6 )
+    treeGenerator.SetTortuosity( atof( argv[6] ) );
+  
+  if( argc > 7 )
+    treeGenerator.SetNoiseStandardDeviation( atof( argv[7] ) );
+  
+  if( argc > 8 )
+    treeGenerator.SetSeed( atoi( argv[8] ) );
+  
+  if( argc > 9 )
+    treeGenerator.SetImageSpacing( atof( argv[9] ) );
+  
+  if( argc > 10 )
+    treeGenerator.SetMaxValue( atof( argv[10] ) );
+  
+  itk::TimeProbe probe;
+  probe.Start();
+  
+  TreeImageType::Pointer treeImage = treeGenerator.Create();
+  
+  probe.Stop();
+  
+  std::cout << "Branches: " << treeGenerator.GetNumberOfBranches() 
+    << " Segments: " << treeGenerator.GetNumberOfSegments()
+    << " Size: " << treeImage->GetLargestPossibleRegion().GetSize() 
+    << " Time: " << probe.GetMeanTime() << " s" << std::endl;
+  
+  typedef itk::ImageFileWriter<TreeImageType>  WriterType;
+  
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[1] );
+  writer->SetInput( treeImage );
+  
+  typedef ivan::VesselGraphBinaryWriter<CenterlineType>  GraphWriterType;
+  
+  GraphWriterType::Pointer graphWriter = GraphWriterType::New();
+  graphWriter->SetFileName( argv[2] );
+  graphWriter->SetInput( treeGenerator.GetGraph() );
+  
+  try
+  {
+    writer->Update();
+    graphWriter->Write();
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "ITK exception caught!!!" << std::endl;
+    std::cerr << excpt.GetDescription() << std::endl;
+    return EXIT_FAILURE; 
+  }
+  
+  return EXIT_SUCCESS;
+}
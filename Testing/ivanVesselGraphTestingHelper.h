@@ -0,0 +1,91 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Ivan Macia Oliver
+Vicomtech Foundation, San Sebastian - Donostia (Spain)
+University of the Basque Country, San Sebastian - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanVesselGraphTestingHelper.h
+// Author: Ivan Macia (imacia@vicomtech.org)
+// Description: fixture factories shared by the vessel graph tests
+// Date: 2013/09/16
+
+
+#ifndef __ivanVesselGraphTestingHelper_h_
+#define __ivanVesselGraphTestingHelper_h_
+
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+
+/** Creates a straight branch along the y axis, at x = id, with normals along y, increasing 
+ *  radii of 1 + 0.1 * i, a scale of 2 and its arclength filled. The sections are spaced 
+ *  by the given distance. */
+template <class TBranchNode>
+typename TBranchNode::Pointer CreateTestBranch( unsigned int id, unsigned int numberOfSections,
+  double spacing = 1.0 )
+{
+  typedef typename TBranchNode::SectionType    SectionType;
+  
+  typename TBranchNode::Pointer branch = TBranchNode::New();
+  branch->SetNodeId( id );
+  
+  for( unsigned int i=0; i<numberOfSections; ++i )
+  {
+    typename SectionType::PointType center;
+    center.Fill( 0.0 );
+    center[0] = id;
+    center[1] = spacing * i;
+    
+    typename SectionType::VectorType normal;
+    normal.Fill( 0.0 );
+    normal[1] = 1.0;
+    
+    typename SectionType::Pointer section = SectionType::New();
+    section->SetCenter( center );
+    section->SetNormal( normal );
+    section->SetRadius( 1.0 + 0.1 * i );
+    section->SetScale( 2.0 );
+    section->SetArclength( spacing * i );
+    branch->GetCenterline()->push_back( section );
+  }
+  
+  return branch;
+}
+
+
+/** Contents of a binary file. */
+inline std::string ReadFile( const std::string & fileName )
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+
+/** Replace a binary file with the given contents. */
+inline void WriteFile( const std::string & fileName, const std::string & contents )
+{
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  file.write( contents.data(), contents.size() );
+}
+
+#endif // __ivanVesselGraphTestingHelper_h_
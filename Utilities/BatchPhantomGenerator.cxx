@@ -0,0 +1,377 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: BatchPhantomGenerator.cxx
+// Author: Ivn Maca (imacia@vicomtech.org)
+// Description: creates all the Gaussian phantoms and noisy versions of a parameter grid in a single 
+//   process. Every phantom is a job, jobs run in parallel and each thread reuses its noise filter, 
+//   buffers and writer for all the noise levels and seeds of the phantom.
+// Date: 2012/11/05
+//
+// The parameter file has one parameter per line followed by its list of values. Lines starting 
+// with # are ignored. Example:
+//
+//   OutputRoot      D:/VolumeData/Phantoms/Phantom
+//   Generator       straight toroid helix
+//   Sigma           1.0 2.0 4.0
+//   Radius          20.0 40.0        (toroid and helix only)
+//   Height          50               (straight tube only)
+//   Spacing         1.0
+//   MaxValue        255.0
+//   NoiseLevel      0 10 25 50       (0-100% of the image standard deviation, 0 writes the phantom)
+//   Seed            1 2 3
+//   NumberOfThreads 8
+//   Compression     1
+//
+// Output file names are OutputRoot_<generator>_S<sigma>[_R<radius>][_NL<level>_Seed<seed>].mha
+
+
+#include "ivanCircularGaussianStraightTubeGenerator.h"
+#include "ivanCircularGaussianToroidGenerator.h"
+#include "ivanCircularGaussianHelixGenerator.h"
+
+#include "itkImageFileWriter.h"
+#include "itkMetaImageIO.h"
+#include "itkStatisticsImageFilter.h"
+#include "itkAdditiveGaussianNoiseImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+
+typedef float  PixelType;
+typedef itk::Image<PixelType,3>  ImageType;
+
+
+/** Values of every parameter in the parameter file. */
+typedef std::map<std::string, std::vector<std::string> >  ParameterMapType;
+
+
+/** A single phantom of the grid. */
+struct PhantomJob
+{
+  std::string  Generator;
+  double       Sigma;
+  double       Radius;
+};
+
+
+/** State shared by all the threads. */
+struct BatchState
+{
+  std::vector<PhantomJob>   Jobs;
+  std::vector<double>       NoiseLevels;
+  std::vector<unsigned int> Seeds;
+  
+  std::string    OutputRoot;
+  unsigned long  Height;
+  double         Spacing;
+  double         MaxValue;
+  bool           Compression;
+  
+  unsigned int              NextJob;
+  unsigned int              NumberOfFailedJobs;
+  itk::SimpleFastMutexLock  Mutex;
+};
+
+
+bool ReadParameters( const char *fileName, ParameterMapType & parameters )
+{
+  std::ifstream filein( fileName );
+  
+  if( !filein.is_open() )
+    return false;
+  
+  std::string line;
+  
+  while( std::getline( filein, line ) )
+  {
+    std::istringstream lineStream( line );
+    std::string name, value;
+    
+    if( !( lineStream >> name ) || name[0] == '#' )
+      continue;
+    
+    std::vector<std::string> & values = parameters[name];
+    values.clear();
+    
+    while( lineStream >> value && value[0] != '(' )
+      values.push_back( value );
+  }
+  
+  return true;
+}
+
+
+template <class T>
+std::vector<T> GetValues( const ParameterMapType & parameters, const std::string & name, T defaultValue )
+{
+  std::vector<T> values;
+  
+  ParameterMapType::const_iterator it = parameters.find( name );
+  
+  if( it != parameters.end() )
+  {
+    for( unsigned int i=0; i<it->second.size(); ++i )
+    {
+      std::istringstream valueStream( it->second[i] );
+      T value;
+      if( valueStream >> value )
+        values.push_back( value );
+    }
+  }
+  
+  if( values.empty() )
+    values.push_back( defaultValue );
+    
+  return values;
+}
+
+
+ImageType::Pointer CreatePhantom( const BatchState & state, const PhantomJob & job )
+{
+  if( job.Generator == "straight" )
+  {
+    typedef ivan::CircularGaussianStraightTubeGenerator<PixelType>  GeneratorType;
+    
+    GeneratorType generator;
+    generator.SetSigma( job.Sigma );
+    generator.SetHeight( state.Height );
+    generator.SetImageSpacing( state.Spacing );
+    generator.SetRescale( true );
+    generator.SetMaxValue( state.MaxValue );
+    
+    unsigned long sectionImageSize = job.Sigma * 10.0 / state.Spacing;
+    if( sectionImageSize % 2 == 0 )
+      sectionImageSize += 1;
+      
+    generator.SetSectionImageSize( sectionImageSize );
+    
+    return generator.Create();
+  }
+  else if( job.Generator == "toroid" || job.Generator == "helix" )
+  {
+    typedef ivan::CircularGaussianToroidGenerator<PixelType>  ToroidGeneratorType;
+    typedef ivan::CircularGaussianHelixGenerator<PixelType>   HelixGeneratorType;
+    
+    ToroidGeneratorType toroidGenerator;
+    HelixGeneratorType helixGenerator;
+    
+    ToroidGeneratorType & generator = ( job.Generator == "helix" ) ? helixGenerator : toroidGenerator;
+    
+    generator.SetSigma( job.Sigma );
+    generator.SetRadius( job.Radius );
+    generator.SetImageSpacing( state.Spacing );
+    generator.SetMaxValue( state.MaxValue );
+    generator.SetAutoComputeNumberOfPoints( true );
+    generator.SetNumberOfThreads( 1 ); // parallelism is across jobs
+    
+    return generator.Create();
+  }
+  
+  itkGenericExceptionMacro( "Unknown generator type: " << job.Generator );
+}
+
+
+std::string GetJobFileName( const BatchState & state, const PhantomJob & job )
+{
+  std::ostringstream fileName;
+  fileName << state.OutputRoot << "_" << job.Generator << "_S" << job.Sigma;
+  
+  if( job.Generator != "straight" )
+    fileName << "_R" << job.Radius;
+    
+  return fileName.str();
+}
+
+
+void ProcessJob( const BatchState & state, const PhantomJob & job )
+{
+  typedef itk::StatisticsImageFilter<ImageType>  StatisticsFilterType;
+  typedef itk::AdditiveGaussianNoiseImageFilter<ImageType,ImageType>  NoiseFilterType;
+  typedef itk::ImageFileWriter<ImageType>  FileWriterType;
+  
+  ImageType::Pointer phantom = CreatePhantom( state, job );
+  
+  const std::string jobFileName = GetJobFileName( state, job );
+  
+  // The writer uses its own MetaImage IO so no IO factory lookup is done per file
+  FileWriterType::Pointer writer = FileWriterType::New();
+  writer->SetImageIO( itk::MetaImageIO::New() );
+  writer->SetUseCompression( state.Compression );
+  
+  // Reference signal for the noise levels, as in GaussianNoiseAdder
+  StatisticsFilterType::Pointer stats = StatisticsFilterType::New();
+  stats->SetInput( phantom );
+  stats->SetNumberOfThreads( 1 );
+  stats->Update();
+  
+  const double sigmaSignal = stats->GetSigma();
+  
+  // The noise filter keeps its output buffer between updates
+  NoiseFilterType::Pointer noiseFilter = NoiseFilterType::New();
+  noiseFilter->SetInput( phantom );
+  noiseFilter->SetNumberOfThreads( 1 );
+  
+  for( unsigned int i=0; i<state.NoiseLevels.size(); ++i )
+  {
+    if( state.NoiseLevels[i] <= 0.0 )
+    {
+      writer->SetInput( phantom );
+      writer->SetFileName( jobFileName + ".mha" );
+      writer->Update();
+      continue;
+    }
+    
+    noiseFilter->SetStandardDeviation( 0.01 * state.NoiseLevels[i] * sigmaSignal );
+    writer->SetInput( noiseFilter->GetOutput() );
+    
+    for( unsigned int j=0; j<state.Seeds.size(); ++j )
+    {
+      noiseFilter->SetSeed( state.Seeds[j] );
+      
+      std::ostringstream fileName;
+      fileName << jobFileName << "_NL" << state.NoiseLevels[i] << "_Seed" << state.Seeds[j] << ".mha";
+      
+      writer->SetFileName( fileName.str() );
+      writer->Update();
+    }
+  }
+}
+
+
+ITK_THREAD_RETURN_TYPE JobThreaderCallback( void *arg )
+{
+  BatchState *state = (BatchState *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  
+  while( true )
+  {
+    state->Mutex.Lock();
+    const unsigned int jobIndex = state->NextJob++;
+    state->Mutex.Unlock();
+    
+    if( jobIndex >= state->Jobs.size() )
+      break;
+      
+    const PhantomJob & job = state->Jobs[jobIndex];
+    
+    try
+    {
+      ProcessJob( *state, job );
+    }
+    catch( itk::ExceptionObject & excpt )
+    {
+      state->Mutex.Lock();
+      std::cerr << "ITK exception caught in " << GetJobFileName( *state, job ) << std::endl;
+      std::cerr << excpt.GetDescription() << std::endl;
+      ++state->NumberOfFailedJobs;
+      state->Mutex.Unlock();
+    }
+  }
+  
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  // Verify the number of parameters in the command line
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << " ParameterFileName [NumberOfThreads]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  ParameterMapType parameters;
+  
+  if( !ReadParameters( argv[1], parameters ) )
+  {
+    std::cerr << "Could not read parameter file " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  BatchState state;
+  state.OutputRoot = GetValues<std::string>( parameters, "OutputRoot", "Phantom" )[0];
+  state.Height = GetValues<unsigned long>( parameters, "Height", 50 )[0];
+  state.Spacing = GetValues<double>( parameters, "Spacing", 1.0 )[0];
+  state.MaxValue = GetValues<double>( parameters, "MaxValue", 255.0 )[0];
+  state.Compression = GetValues<int>( parameters, "Compression", 1 )[0];
+  state.NoiseLevels = GetValues<double>( parameters, "NoiseLevel", 0.0 );
+  state.Seeds = GetValues<unsigned int>( parameters, "Seed", 0 );
+  state.NextJob = 0;
+  state.NumberOfFailedJobs = 0;
+  
+  const std::vector<std::string> generators = GetValues<std::string>( parameters, "Generator", "straight" );
+  const std::vector<double> sigmas = GetValues<double>( parameters, "Sigma", 1.0 );
+  const std::vector<double> radii = GetValues<double>( parameters, "Radius", 20.0 );
+  
+  for( unsigned int g=0; g<generators.size(); ++g )
+  {
+    for( unsigned int s=0; s<sigmas.size(); ++s )
+    {
+      // The radius is not a parameter of the straight tube
+      const unsigned int numberOfRadii = ( generators[g] == "straight" ) ? 1 : radii.size();
+      
+      for( unsigned int r=0; r<numberOfRadii; ++r )
+      {
+        PhantomJob job;
+        job.Generator = generators[g];
+        job.Sigma = sigmas[s];
+        job.Radius = radii[r];
+        state.Jobs.push_back( job );
+      }
+    }
+  }
+  
+  int numberOfThreads = GetValues<int>( parameters, "NumberOfThreads", 
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads() )[0];
+  
+  if( argc > 2 )
+    numberOfThreads = atoi( argv[2] );
+    
+  numberOfThreads = std::max( 1, std::min( numberOfThreads, (int)state.Jobs.size() ) );
+  
+  std::cout << "Generating " << state.Jobs.size() << " phantoms with " << numberOfThreads 
+    << " threads..." << std::endl;
+  
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( JobThreaderCallback, &state );
+  threader->SingleMethodExecute();
+  
+  if( state.NumberOfFailedJobs > 0 )
+  {
+    std::cerr << state.NumberOfFailedJobs << " phantoms failed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  return EXIT_SUCCESS;
+}
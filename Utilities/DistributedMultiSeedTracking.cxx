@@ -0,0 +1,475 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: DistributedMultiSeedTracking.cxx
+// Author: Ivn Maca (imacia@vicomtech.org)
+// Description: multi-seed vessel tracking of a volume divided in slabs among MPI ranks
+// Date: 2012/11/05
+//
+// The volume is divided in slabs along z, one per MPI rank (see ivan::SlabDecomposition), and 
+// each rank tracks the seeds that fall in its slab. Tracking continues Overlap voxels past the 
+// slab, and where a vessel leaves this region the exit point and direction are handed to the
+// rank of the neighbouring slab, which tracks it onwards in that direction only. This goes on in 
+// rounds until no rank hands off any seed, or for MaximumRounds. Hand-off seeds that fall 
+// inside a vessel already tracked by the receiving rank are dropped.
+//
+// Each rank only reads its slab with the overlap and the support of the Hessian at the given 
+// scale, from a streaming reader (MetaImage, NRRD). The graph of every round is written as 
+// OutputPrefix_rank<rank>_round<round>.ivg, so a shared file system is assumed, and rank 0 then
+// reads them all, stitches the pieces of the vessels that cross slab boundaries (see 
+// ivan::VesselGraphStitcher) and writes OutputPrefix.ivg.
+//
+// Seeds are given as a text file with the physical coordinates x y z of a seed per line.
+//
+// Usage: mpirun -np N UtilityDistributedMultiSeedTracking Input.mha Seeds.txt OutputPrefix Scale
+//   [Overlap=5] [MaxIterations=500] [MaximumRounds=8] [NumberOfThreads]
+
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanCompositeVesselTrackerEndCondition.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanRegionVesselTrackerEndCondition.h"
+#include "ivanFixedScaleHessianBasedVesselSectionEstimator.h"
+#include "ivanVesselCenterlineSpatialIndex.h"
+#include "ivanVesselGraphStitcher.h"
+#include "ivanVesselGraphBinaryWriter.h"
+#include "ivanVesselGraphBinaryReader.h"
+#include "ivanSlabDecomposition.h"
+
+#include "itkImageFileReader.h"
+#include "itkMultiThreader.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+typedef float                      PixelType;
+typedef itk::Image<PixelType,3>    ImageType;
+
+typedef ivan::CircularVesselSection<3>                  VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>                     CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::VesselBranchNode<CenterlineType>          BranchNodeType;
+
+typedef ivan::MultiSeedVesselTrackerFilter
+  <ImageType, VesselGraphType>                          MultiSeedTrackerType;
+typedef MultiSeedTrackerType::TrackerType               VesselTrackerType;
+typedef MultiSeedTrackerType::TrackerFactoryType        TrackerFactoryBaseType;
+typedef MultiSeedTrackerType::DirectionType             DirectionType;
+
+typedef ivan::RegionVesselTrackerEndCondition<ImageType>  RegionEndConditionType;
+typedef ivan::FixedScaleHessianBasedVesselSectionEstimator
+  <ImageType,CenterlineType>                            SectionEstimatorType;
+
+typedef ivan::VesselCenterlineSpatialIndex<CenterlineType>  SpatialIndexType;
+typedef ivan::SlabDecomposition<3>                      SlabDecompositionType;
+
+
+/** Seed given or handed off by another rank, which gives the tracking direction. */
+struct Seed
+{
+  ImageType::PointType  Point;
+  DirectionType         Direction;
+  bool                  HandedOff;
+};
+
+/** Doubles sent for each hand-off seed. */
+const int SeedMessageSize = 6;
+
+
+/** Creates the tracker of each seed, stopping at the tracking region of the rank. */
+class TrackerFactory : public TrackerFactoryBaseType
+{
+public:
+
+  typedef TrackerFactory                  Self;
+  typedef TrackerFactoryBaseType          Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual Superclass::TrackerPointer CreateTracker( unsigned int seed )
+    {
+      Superclass::TrackerPointer tracker = VesselTrackerType::New();
+      
+      SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+      sectionEstimator->SetImage( m_Image );
+      sectionEstimator->SetScale( m_Scale );
+      tracker->SetSectionEstimator( sectionEstimator );
+      
+      ivan::MaxIterationsVesselTrackerEndCondition::Pointer maxIterations = 
+        ivan::MaxIterationsVesselTrackerEndCondition::New();
+      maxIterations->SetMaxIterations( m_MaxIterations );
+      
+      RegionEndConditionType::Pointer region = RegionEndConditionType::New();
+      region->SetImage( m_Image );
+      region->SetRegion( m_TrackingRegion );
+      m_RegionEndConditions.push_back( region );
+      
+      ivan::CompositeVesselTrackerEndCondition::Pointer endCondition = 
+        ivan::CompositeVesselTrackerEndCondition::New();
+      endCondition->AddEndCondition( maxIterations );
+      endCondition->AddEndCondition( region );
+      tracker->SetEndCondition( endCondition.GetPointer() );
+      
+      // Seeds handed off are only tracked away from the rank they come from
+      if( m_Seeds[seed].HandedOff )
+        tracker->SetInitialDirection( m_Seeds[seed].Direction );
+      else
+        tracker->SetBidirectional( true );
+      
+      return tracker;
+    }
+
+  ImageType::Pointer                            m_Image;
+  ImageType::RegionType                         m_TrackingRegion;
+  double                                        m_Scale;
+  unsigned int                                  m_MaxIterations;
+  
+  std::vector<Seed>                             m_Seeds;
+  std::vector<RegionEndConditionType::Pointer>  m_RegionEndConditions;
+};
+
+
+std::string GetRoundFileName( const std::string & prefix, int rank, unsigned int round )
+{
+  char suffix[64];
+  sprintf( suffix, "_rank%03d_round%02u.ivg", rank, round );
+  
+  return prefix + suffix;
+}
+
+
+/** Rank of the slab that contains the point, or -1 if it is outside the image. */
+int FindSlabRank( const ImageType * image, const SlabDecompositionType * decomposition, 
+  const ImageType::PointType & point )
+{
+  ImageType::IndexType index;
+  
+  if( !image->TransformPhysicalPointToIndex( point, index ) )
+    return -1;
+  
+  for( unsigned int i=0; i<decomposition->GetNumberOfSlabs(); ++i )
+  {
+    if( decomposition->GetSlab(i).IsInside( index ) )
+      return i;
+  }
+  
+  return -1;
+}
+
+
+/** Track the seeds of one round, returning the graph with one branch per seed. The branches are
+  * added to the spatial index and the exits are sorted by the rank they are handed to. */
+VesselGraphType::Pointer TrackRound( ImageType * image, TrackerFactory * factory, 
+  const SlabDecompositionType * decomposition, int rank, SpatialIndexType * spatialIndex,
+  std::vector< std::vector<double> > & handOffs )
+{
+  if( factory->m_Seeds.empty() )
+  {
+    VesselGraphType::Pointer graph = VesselGraphType::New();
+    ivan::VesselNode::Pointer rootNode = ivan::VesselNode::New();
+    rootNode->SetNodeId( 0 );
+    graph->SetRootNode( rootNode );
+    
+    return graph;
+  }
+  
+  factory->m_RegionEndConditions.clear();
+  
+  MultiSeedTrackerType::Pointer tracker = MultiSeedTrackerType::New();
+  tracker->SetInput( image );
+  tracker->SetTrackerFactory( factory );
+  
+  for( unsigned int i=0; i<factory->m_Seeds.size(); ++i )
+    tracker->AddSeed( factory->m_Seeds[i].Point );
+  
+  tracker->Update();
+  
+  for( unsigned int i=0; i<factory->m_Seeds.size(); ++i )
+    spatialIndex->AppendSections( tracker->GetSeedBranch(i) );
+  
+  for( unsigned int i=0; i<factory->m_RegionEndConditions.size(); ++i )
+  {
+    const RegionEndConditionType::ExitContainerType & exits = 
+      factory->m_RegionEndConditions[i]->GetExits();
+    
+    for( unsigned int j=0; j<exits.size(); ++j )
+    {
+      ImageType::PointType point;
+      
+      for( unsigned int k=0; k<3; ++k )
+        point[k] = exits[j].Position[k];
+        
+      const int destination = FindSlabRank( image, decomposition, point );
+      
+      if( destination < 0 || destination == rank )
+        continue;
+        
+      for( unsigned int k=0; k<3; ++k )
+        handOffs[destination].push_back( point[k] );
+      for( unsigned int k=0; k<3; ++k )
+        handOffs[destination].push_back( exits[j].Direction[k] );
+    }
+  }
+  
+  VesselGraphType::Pointer graph = tracker->GetOutput();
+  graph->DisconnectPipeline();
+  
+  return graph;
+}
+
+
+/** Send the hand-off seeds to their ranks, and return the seeds received. */
+std::vector<Seed> ExchangeHandOffs( const std::vector< std::vector<double> > & handOffs, 
+  int numberOfRanks )
+{
+  std::vector<int> sendCounts( numberOfRanks ), sendOffsets( numberOfRanks );
+  std::vector<int> receiveCounts( numberOfRanks ), receiveOffsets( numberOfRanks );
+  std::vector<double> sendBuffer;
+  
+  for( int i=0; i<numberOfRanks; ++i )
+  {
+    sendCounts[i] = handOffs[i].size();
+    sendOffsets[i] = sendBuffer.size();
+    sendBuffer.insert( sendBuffer.end(), handOffs[i].begin(), handOffs[i].end() );
+  }
+  
+  MPI_Alltoall( &sendCounts[0], 1, MPI_INT, &receiveCounts[0], 1, MPI_INT, MPI_COMM_WORLD );
+  
+  int receiveSize = 0;
+  
+  for( int i=0; i<numberOfRanks; ++i )
+  {
+    receiveOffsets[i] = receiveSize;
+    receiveSize += receiveCounts[i];
+  }
+  
+  // Buffers must not be empty to take their address
+  sendBuffer.push_back( 0.0 );
+  std::vector<double> receiveBuffer( receiveSize + 1 );
+  
+  MPI_Alltoallv( &sendBuffer[0], &sendCounts[0], &sendOffsets[0], MPI_DOUBLE, 
+    &receiveBuffer[0], &receiveCounts[0], &receiveOffsets[0], MPI_DOUBLE, MPI_COMM_WORLD );
+  
+  std::vector<Seed> seeds( receiveSize / SeedMessageSize );
+  
+  for( unsigned int i=0; i<seeds.size(); ++i )
+  {
+    for( unsigned int k=0; k<3; ++k )
+    {
+      seeds[i].Point[k] = receiveBuffer[ SeedMessageSize * i + k ];
+      seeds[i].Direction[k] = receiveBuffer[ SeedMessageSize * i + 3 + k ];
+    }
+    
+    seeds[i].HandedOff = true;
+  }
+  
+  return seeds;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  MPI_Init( &argc, &argv );
+  
+  int rank, numberOfRanks;
+  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  MPI_Comm_size( MPI_COMM_WORLD, &numberOfRanks );
+  
+  if( argc < 5 )
+  {
+    if( rank == 0 )
+    {
+      std::cerr << "Usage: " << argv[0] << " Input.mha Seeds.txt OutputPrefix Scale [Overlap=5] "
+                << "[MaxIterations=500] [MaximumRounds=8] [NumberOfThreads]" << std::endl;
+    }
+    
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  
+  const std::string prefix = argv[3];
+  const double scale = atof( argv[4] );
+  const unsigned int overlap = ( argc > 5 ) ? atoi( argv[5] ) : 5;
+  const unsigned int maxIterations = ( argc > 6 ) ? atoi( argv[6] ) : 500;
+  const unsigned int maximumRounds = ( argc > 7 ) ? std::max( atoi( argv[7] ), 1 ) : 8;
+  
+  if( argc > 8 )
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( std::max( atoi( argv[8] ), 1 ) );
+  
+  typedef itk::ImageFileReader<ImageType>  ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->SetUseStreaming( true );
+  
+  unsigned int numberOfRounds = 0;
+  
+  try
+  {
+    reader->UpdateOutputInformation();
+    
+    ImageType::Pointer image = reader->GetOutput();
+    
+    SlabDecompositionType::Pointer decomposition = SlabDecompositionType::New();
+    decomposition->SetRegion( image->GetLargestPossibleRegion() );
+    decomposition->SetRequestedNumberOfSlabs( numberOfRanks );
+    decomposition->Initialize();
+    
+    // Ranks without a slab still take part in the exchanges
+    const bool hasSlab = rank < static_cast<int>( decomposition->GetNumberOfSlabs() );
+    
+    TrackerFactory::Pointer factory = TrackerFactory::New();
+    factory->m_Scale = scale;
+    factory->m_MaxIterations = maxIterations;
+    
+    if( hasSlab )
+    {
+      decomposition->SetHaloRadius( overlap );
+      factory->m_TrackingRegion = decomposition->GetPaddedSlab( rank );
+      
+      // Read the tracking region with the support of the Hessian at the given scale
+      ImageType::SizeType padding;
+      
+      for( unsigned int i=0; i<3; ++i )
+      {
+        padding[i] = overlap + 
+          static_cast<ImageType::SizeValueType>( std::ceil( 3.0 * scale / image->GetSpacing()[i] ) ) + 1;
+      }
+      
+      decomposition->SetHaloRadius( padding );
+      image->SetRequestedRegion( decomposition->GetPaddedSlab( rank ) );
+      image->Update();
+      image->DisconnectPipeline();
+      
+      factory->m_Image = image;
+      
+      // Take the seeds of this slab
+      std::ifstream seedFile( argv[2] );
+      Seed seed;
+      seed.Direction.Fill( 0.0 );
+      seed.HandedOff = false;
+      
+      while( seedFile >> seed.Point[0] >> seed.Point[1] >> seed.Point[2] )
+      {
+        if( FindSlabRank( image, decomposition, seed.Point ) == rank )
+          factory->m_Seeds.push_back( seed );
+      }
+    }
+    
+    SpatialIndexType::Pointer spatialIndex = SpatialIndexType::New();
+    
+    for( unsigned int round=0; round<maximumRounds; ++round )
+    {
+      std::vector< std::vector<double> > handOffs( numberOfRanks );
+      
+      VesselGraphType::Pointer graph = TrackRound( factory->m_Image, factory, decomposition, rank, 
+        spatialIndex, handOffs );
+      
+      ivan::VesselGraphBinaryWriter<CenterlineType>::Pointer writer = 
+        ivan::VesselGraphBinaryWriter<CenterlineType>::New();
+      writer->SetFileName( GetRoundFileName( prefix, rank, round ) );
+      writer->SetInput( graph );
+      writer->Write();
+      
+      ++numberOfRounds;
+      
+      // Seeds received that are not on a vessel tracked already
+      const std::vector<Seed> receivedSeeds = ExchangeHandOffs( handOffs, numberOfRanks );
+      factory->m_Seeds.clear();
+      
+      for( unsigned int i=0; i<receivedSeeds.size(); ++i )
+      {
+        if( !spatialIndex->FindContainingBranch( receivedSeeds[i].Point ) )
+          factory->m_Seeds.push_back( receivedSeeds[i] );
+      }
+      
+      int numberOfSeeds = factory->m_Seeds.size();
+      int totalNumberOfSeeds = 0;
+      MPI_Allreduce( &numberOfSeeds, &totalNumberOfSeeds, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD );
+      
+      if( !totalNumberOfSeeds )
+        break;
+      
+      if( rank == 0 && round + 1 == maximumRounds )
+        std::cerr << "Seeds left after " << maximumRounds << " rounds: " << totalNumberOfSeeds << std::endl;
+    }
+    
+    MPI_Barrier( MPI_COMM_WORLD );
+    
+    if( rank == 0 )
+    {
+      std::vector<VesselGraphType::Pointer> graphs;
+      
+      ivan::VesselGraphStitcher<CenterlineType>::Pointer stitcher = 
+        ivan::VesselGraphStitcher<CenterlineType>::New();
+      stitcher->SetTolerance( scale );
+      
+      for( int i=0; i<numberOfRanks; ++i )
+      {
+        for( unsigned int round=0; round<numberOfRounds; ++round )
+        {
+          ivan::VesselGraphBinaryReader<CenterlineType>::Pointer graphReader = 
+            ivan::VesselGraphBinaryReader<CenterlineType>::New();
+          graphReader->SetFileName( GetRoundFileName( prefix, i, round ) );
+          graphReader->Read();
+          
+          graphs.push_back( graphReader->GetOutput() );
+          stitcher->AddGraph( graphs.back() );
+        }
+      }
+      
+      stitcher->Update();
+      
+      std::cout << "Stitched " << stitcher->GetNumberOfStitches() << " vessel pieces in " 
+        << numberOfRounds << " rounds" << std::endl;
+      
+      ivan::VesselGraphBinaryWriter<CenterlineType>::Pointer writer = 
+        ivan::VesselGraphBinaryWriter<CenterlineType>::New();
+      writer->SetFileName( prefix + ".ivg" );
+      writer->SetInput( stitcher->GetOutput() );
+      writer->Write();
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "Rank " << rank << ": EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    MPI_Abort( MPI_COMM_WORLD, EXIT_FAILURE );
+    return EXIT_FAILURE;
+  }
+  
+  MPI_Finalize();
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,309 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: DistributedMultiscaleDetection.cxx
+// Author: Ivn Maca (imacia@vicomtech.org)
+// Description: multiscale detection of a volume divided in slabs among MPI ranks
+// Date: 2012/11/05
+//
+// Each rank computes one slab of the output, which the pipeline pads with the halo needed by 
+// the largest scale, so with a streaming reader (MetaImage, NRRD) every rank only reads its 
+// padded slab. Slab sizes differ by one voxel at most (see ivan::SlabDecomposition).
+//
+// Methods:
+//   MultiscaleMedialness   MultiscaleMedialnessImageFilter, writes vesselness, scales and normals
+//   OffsetMedialness       ImageFunctionBasedImageFilter with the offset medialness at the minimum
+//                          scale, writes vesselness
+//
+// Without Gather each rank writes its slabs as OutputPrefix_<output>_rank<rank>.mha, positioned
+// in physical space, so that the volume never needs to fit a single node. With Gather the slabs 
+// are sent to rank 0, which writes OutputPrefix_<output>.mha.
+//
+// Usage: mpirun -np N UtilityDistributedMultiscaleDetection Input.mha OutputPrefix Method 
+//   MinimumScale MaximumScale NumberOfScales [Gather=0] [NumberOfThreads]
+
+#include "ivanMultiscaleMedialnessImageFilter.h"
+#include "ivanImageFunctionBasedImageFilter.h"
+#include "ivanOffsetMedialnessImageFunctionInitializer.h"
+#include "ivanSlabDecomposition.h"
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMultiThreader.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+typedef float                      PixelType;
+typedef itk::Image<PixelType,3>    ImageType;
+
+typedef ivan::SlabDecomposition<3> SlabDecompositionType;
+
+
+/** Largest message, since MPI counts are int. */
+const unsigned long MaximumMessageSize = 1ul << 30;
+
+
+void SendBuffer( const char *buffer, unsigned long size, int destination )
+{
+  for( unsigned long offset = 0; offset < size; offset += MaximumMessageSize )
+  {
+    const int count = static_cast<int>( std::min( MaximumMessageSize, size - offset ) );
+    MPI_Send( const_cast<char *>( buffer + offset ), count, MPI_BYTE, destination, 0, MPI_COMM_WORLD );
+  }
+}
+
+
+void ReceiveBuffer( char *buffer, unsigned long size, int source )
+{
+  for( unsigned long offset = 0; offset < size; offset += MaximumMessageSize )
+  {
+    const int count = static_cast<int>( std::min( MaximumMessageSize, size - offset ) );
+    MPI_Recv( buffer + offset, count, MPI_BYTE, source, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+  }
+}
+
+
+/** Write the slab of the output computed by this rank, or gather all the slabs in rank 0. 
+  * Slabs are along the last dimension, so each one is contiguous in the whole buffer. */
+template <class TImage>
+void WriteOutput( TImage *output, const SlabDecompositionType *decomposition, int rank, 
+  bool gather, const std::string & prefix, const std::string & name )
+{
+  typedef itk::ImageFileWriter<TImage>  WriterType;
+  typename WriterType::Pointer writer = WriterType::New();
+  
+  const int numberOfSlabs = decomposition->GetNumberOfSlabs();
+  
+  if( !gather )
+  {
+    if( rank >= numberOfSlabs )
+      return;
+    
+    // Image with the slab as largest region, so the writer only asks for the slab
+    typename TImage::Pointer slabImage = TImage::New();
+    slabImage->CopyInformation( output );
+    slabImage->SetRegions( decomposition->GetSlab( rank ) );
+    slabImage->SetPixelContainer( output->GetPixelContainer() );
+    
+    char rankString[16];
+    sprintf( rankString, "%03d", rank );
+    
+    writer->SetFileName( prefix + "_" + name + "_rank" + rankString + ".mha" );
+    writer->SetInput( slabImage );
+    writer->Update();
+    return;
+  }
+  
+  const unsigned long pixelSize = sizeof( typename TImage::PixelType );
+  
+  if( rank != 0 )
+  {
+    if( rank < numberOfSlabs )
+    {
+      SendBuffer( reinterpret_cast<const char *>( output->GetBufferPointer() ), 
+        decomposition->GetSlab( rank ).GetNumberOfPixels() * pixelSize, 0 );
+    }
+    
+    return;
+  }
+  
+  typename TImage::Pointer image = TImage::New();
+  image->CopyInformation( output );
+  image->SetRegions( output->GetLargestPossibleRegion() );
+  image->Allocate();
+  
+  char *buffer = reinterpret_cast<char *>( image->GetBufferPointer() );
+  unsigned long offset = 0;
+  
+  for( int r = 0; r < numberOfSlabs; ++r )
+  {
+    const unsigned long size = decomposition->GetSlab( r ).GetNumberOfPixels() * pixelSize;
+    
+    if( r == 0 )
+      memcpy( buffer, output->GetBufferPointer(), size );
+    else
+      ReceiveBuffer( buffer + offset, size, r );
+    
+    offset += size;
+  }
+  
+  writer->SetFileName( prefix + "_" + name + ".mha" );
+  writer->SetInput( image );
+  writer->Update();
+}
+
+
+/** Compute the slab of this rank with the given filter, after its output information is known. */
+template <class TFilter>
+void ComputeSlab( TFilter *filter, SlabDecompositionType *decomposition, int rank, int numberOfRanks )
+{
+  filter->UpdateOutputInformation();
+  
+  decomposition->SetRegion( filter->GetOutput()->GetLargestPossibleRegion() );
+  decomposition->SetRequestedNumberOfSlabs( numberOfRanks );
+  decomposition->Initialize();
+  
+  if( rank == 0 )
+  {
+    std::cout << "Computing " << decomposition->GetNumberOfSlabs() << " slabs of " 
+              << decomposition->GetRegion().GetSize() << std::endl;
+  }
+  
+  // Ranks beyond the number of slabs (thin volumes) have nothing to compute
+  if( rank >= static_cast<int>( decomposition->GetNumberOfSlabs() ) )
+    return;
+  
+  filter->GetOutput()->SetRequestedRegion( decomposition->GetSlab( rank ) );
+  filter->Update();
+}
+
+
+int main( int argc, char *argv[] )
+{
+  MPI_Init( &argc, &argv );
+  
+  int rank, numberOfRanks;
+  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  MPI_Comm_size( MPI_COMM_WORLD, &numberOfRanks );
+  
+  if( argc < 7 )
+  {
+    if( rank == 0 )
+    {
+      std::cerr << "Usage: " << argv[0] << " Input.mha OutputPrefix Method(MultiscaleMedialness|OffsetMedialness) "
+                << "MinimumScale MaximumScale NumberOfScales [Gather=0] [NumberOfThreads]" << std::endl;
+    }
+    
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  
+  const std::string prefix = argv[2];
+  const std::string method = argv[3];
+  const double minimumScale = atof( argv[4] );
+  const double maximumScale = atof( argv[5] );
+  const unsigned int numberOfScales = std::max( atoi( argv[6] ), 1 );
+  const bool gather = ( argc > 7 ) && atoi( argv[7] ) != 0;
+  
+  if( argc > 8 )
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( std::max( atoi( argv[8] ), 1 ) );
+  
+  typedef itk::ImageFileReader<ImageType>  ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->SetUseStreaming( true );
+  
+  SlabDecompositionType::Pointer decomposition = SlabDecompositionType::New();
+  
+  try
+  {
+    if( method == "MultiscaleMedialness" )
+    {
+      typedef ivan::MultiscaleMedialnessImageFilter<ImageType,ImageType>  FilterType;
+      
+      FilterType::Pointer filter = FilterType::New();
+      filter->SetInput( reader->GetOutput() );
+      filter->SetComputeNormals( true );
+      
+      for( unsigned int i=0; i<numberOfScales; ++i )
+      {
+        filter->AddScale( ( numberOfScales > 1 ) ? minimumScale * 
+          std::pow( maximumScale / minimumScale, i / ( numberOfScales - 1.0 ) ) : minimumScale );
+      }
+      
+      ComputeSlab<FilterType>( filter, decomposition, rank, numberOfRanks );
+      
+      WriteOutput<ImageType>( filter->GetOutput(), decomposition, rank, gather, prefix, "Vesselness" );
+      WriteOutput<FilterType::ScaleImageType>( filter->GetOutputScales(), decomposition, rank, gather, 
+        prefix, "Scales" );
+      WriteOutput<FilterType::VectorImageType>( filter->GetOutputNormals(), decomposition, rank, gather, 
+        prefix, "Normals" );
+    }
+    else if( method == "OffsetMedialness" )
+    {
+      typedef ivan::OffsetMedialnessImageFunction<ImageType,double>         FunctionType;
+      typedef ivan::OffsetMedialnessImageFunctionInitializer<ImageType>     InitializerType;
+      typedef ivan::ImageFunctionBasedImageFilter<ImageType,ImageType,FunctionType>  FilterType;
+      
+      const double gradientSigma = 1.0;
+      const double radius = std::sqrt( 3.0 ) * minimumScale;
+      
+      InitializerType::Pointer initializer = InitializerType::New();
+      initializer->SetScaleSelectionMethod( InitializerType::IgnoreScale );
+      initializer->SetGradientSigma( gradientSigma );
+      initializer->SetHessianSigma( minimumScale );
+      initializer->SetRadius( radius );
+      
+      FilterType::Pointer filter = FilterType::New();
+      filter->SetInput( reader->GetOutput() );
+      filter->SetImageFunctionInitializer( initializer );
+      filter->SetThreshold( -itk::NumericTraits<PixelType>::max() );
+      
+      // The halo covers the Hessian kernel and the gradients sampled on the medialness ring
+      reader->UpdateOutputInformation();
+      
+      const ImageType::SpacingType spacing = reader->GetOutput()->GetSpacing();
+      const double support = std::max( 4.0 * minimumScale, radius + 4.0 * gradientSigma );
+      
+      ImageType::SizeType padding;
+      
+      for( unsigned int i=0; i<3; ++i )
+        padding[i] = static_cast<ImageType::SizeValueType>( std::ceil( support / spacing[i] ) ) + 1;
+      
+      filter->SetInputPadding( padding );
+      
+      ComputeSlab<FilterType>( filter, decomposition, rank, numberOfRanks );
+      
+      WriteOutput<ImageType>( filter->GetOutput(), decomposition, rank, gather, prefix, "Vesselness" );
+    }
+    else
+    {
+      if( rank == 0 )
+        std::cerr << "Unknown method " << method << std::endl;
+      
+      MPI_Finalize();
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excpt )
+  {
+    std::cerr << "Rank " << rank << ": EXCEPTION CAUGHT!!! " << excpt.GetDescription() << std::endl;
+    MPI_Abort( MPI_COMM_WORLD, EXIT_FAILURE );
+    return EXIT_FAILURE;
+  }
+  
+  MPI_Finalize();
+  
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,667 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: FusedVesselPipeline.cxx
+// Author: Ivn Maca (imacia@vicomtech.org)
+// Description: detects, tracks and quantifies the vessels of a list of studies in a single process, 
+//   keeping the intermediate images and graphs in memory and running the stages of several 
+//   studies at once on a shared pool of threads.
+// Date: 2012/11/05
+//
+// Every study goes through the stages read, detect, track, quantify and export of an 
+// ivan::StudyPipeline. Detection computes the multiscale medialness and its scales, from which 
+// the seeds are detected. The scales image is given to the section estimators of the trackers,
+// which share the functions initialized at each scale through the VesselAnalysisSession of the
+// study, and stop at the vessels already tracked through its spatial index. The tracked graph is
+// frozen for quantification and written as Output.ivg, and a line of measurements is appended 
+// to the measurements file. Each intermediate is released as soon as the last stage that needs 
+// it is done, so nothing but the input and the results touches the disk.
+//
+// The studies in flight together take at most MemoryBudget, estimated as MemoryPerPixel bytes 
+// for every pixel of their input. The reading stage reads one study at a time, and the threads 
+// of the pool are shared among the other stages, taking the given number of threads each.
+//
+// The parameter file has one parameter per line followed by its list of values. Lines starting 
+// with # are ignored. Example:
+//
+//   Input                 D:/Studies/Study1.mha D:/Studies/Study2.mha
+//   Output                D:/Results/Study1 D:/Results/Study2  (default is the input without extension)
+//   MinimumScale          1.0
+//   MaximumScale          6.0
+//   NumberOfScales        6
+//   SeedThreshold         20.0
+//   MaximumNumberOfSeeds  50          (0 for no limit)
+//   MaxIterations         500
+//   NumberOfThreads       8
+//   DetectionThreads      4
+//   TrackingThreads       4
+//   QuantificationThreads 1
+//   MemoryBudget          8192        (MB for all the studies in flight, 0 for no limit)
+//   MemoryPerPixel        64          (bytes for each input pixel of a study in flight)
+//   Measurements          D:/Results/Measurements.txt
+//   CompressSections      0
+//   WriteVesselness       0           (1 also writes Output_vesselness.mha and Output_scales.mha)
+//
+// Usage: UtilityFusedVesselPipeline ParameterFile
+
+
+#include "ivanStudyPipeline.h"
+#include "ivanVesselAnalysisSession.h"
+#include "ivanMultiscaleMedialnessImageFilter.h"
+#include "ivanVesselSeedDetector.h"
+#include "ivanVesselGraph.h"
+#include "ivanCircularVesselSection.h"
+#include "ivanMultiSeedVesselTrackerFilter.h"
+#include "ivanCompositeVesselTrackerEndCondition.h"
+#include "ivanMaxIterationsVesselTrackerEndCondition.h"
+#include "ivanRegionVesselTrackerEndCondition.h"
+#include "ivanCollisionVesselTrackerEndCondition.h"
+#include "ivanMultiscaleFromImageHessianBasedVesselSectionEstimator.h"
+#include "ivanFrozenVesselGraph.h"
+#include "ivanFrozenVesselGraphQuantifier.h"
+#include "ivanVesselGraphBinaryWriter.h"
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
+#include "itkMultiThreader.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+
+typedef float                      PixelType;
+typedef itk::Image<PixelType,3>    ImageType;
+
+typedef ivan::CircularVesselSection<3>                  VesselSectionType;
+typedef ivan::VesselCenterline
+  <unsigned int, VesselSectionType>                     CenterlineType;
+typedef ivan::VesselGraph<CenterlineType>               VesselGraphType;
+typedef ivan::FrozenVesselGraph<CenterlineType>         FrozenGraphType;
+
+typedef ivan::MultiscaleMedialnessImageFilter
+  <ImageType,ImageType>                                 MedialnessFilterType;
+typedef MedialnessFilterType::ScaleImageType            ScaleImageType;
+typedef ivan::VesselSeedDetector
+  <ImageType,CenterlineType,double>                     SeedDetectorType;
+
+typedef ivan::MultiSeedVesselTrackerFilter
+  <ImageType, VesselGraphType>                          MultiSeedTrackerType;
+typedef MultiSeedTrackerType::TrackerType               VesselTrackerType;
+typedef MultiSeedTrackerType::TrackerFactoryType        TrackerFactoryBaseType;
+typedef MultiSeedTrackerType::SeedContainerType         SeedContainerType;
+
+typedef ivan::MultiscaleFromImageHessianBasedVesselSectionEstimator
+  <ImageType,ScaleImageType,CenterlineType>             SectionEstimatorType;
+typedef SectionEstimatorType::ScaledImageFunctionType   ScaledImageFunctionType;
+typedef ivan::RegionVesselTrackerEndCondition<ImageType>            RegionEndConditionType;
+typedef ivan::CollisionVesselTrackerEndCondition<CenterlineType>    CollisionEndConditionType;
+
+typedef ivan::VesselAnalysisSession<ImageType,CenterlineType>   SessionType;
+typedef ivan::FrozenVesselGraphQuantifier<CenterlineType>       QuantifierType;
+
+typedef ivan::StudyPipeline                             PipelineType;
+
+
+/** Values of every parameter in the parameter file. */
+typedef std::map<std::string, std::vector<std::string> >  ParameterMapType;
+
+
+/** Parameters shared by all the studies. */
+struct PipelineSettings
+{
+  double         MinimumScale;
+  double         MaximumScale;
+  unsigned int   NumberOfScales;
+  double         SeedThreshold;
+  unsigned int   MaximumNumberOfSeeds;
+  unsigned int   MaxIterations;
+  bool           CompressSections;
+  bool           WriteVesselness;
+  std::string    MeasurementsFileName;
+};
+
+
+/** A study and the data its stages pass on to each other. */
+class FusedStudy : public PipelineType::Study
+{
+public:
+
+  typedef FusedStudy                      Self;
+  typedef PipelineType::Study             Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  std::string   InputFileName;
+  std::string   OutputPrefix;
+  
+  ImageType::Pointer          Image;
+  ImageType::Pointer          Vesselness;
+  ScaleImageType::Pointer     Scales;
+  SeedContainerType           Seeds;
+  SessionType::Pointer        Session;
+  VesselGraphType::Pointer    Graph;
+  
+  unsigned int   NumberOfBranches;
+  unsigned int   NumberOfBifurcations;
+  double         TotalLength;
+  double         TotalVolume;
+  double         MeanTortuosity;
+  double         MaximumBifurcationAngle;
+
+protected:
+
+  FusedStudy() : NumberOfBranches( 0 ), NumberOfBifurcations( 0 ), TotalLength( 0.0 ), 
+    TotalVolume( 0.0 ), MeanTortuosity( 0.0 ), MaximumBifurcationAngle( 0.0 ) {}
+};
+
+
+/** Stage of the runner, which gives it the settings and the study of the right type. */
+class FusedStage : public PipelineType::Stage
+{
+public:
+
+  void SetSettings( const PipelineSettings *settings )
+    { m_Settings = settings; }
+  
+  virtual void Process( PipelineType::Study *study )
+    { this->ProcessStudy( static_cast<FusedStudy *>( study ) ); }
+
+protected:
+
+  FusedStage() : m_Settings( 0 ) {}
+  
+  virtual void ProcessStudy( FusedStudy *study ) = 0;
+  
+  const PipelineSettings  *m_Settings;
+};
+
+
+/** Reads the input image. */
+class ReadStage : public FusedStage
+{
+public:
+
+  typedef ReadStage                       Self;
+  typedef FusedStage                      Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+
+protected:
+
+  virtual void ProcessStudy( FusedStudy *study )
+    {
+      typedef itk::ImageFileReader<ImageType>  ReaderType;
+      
+      ReaderType::Pointer reader = ReaderType::New();
+      reader->SetFileName( study->InputFileName );
+      reader->Update();
+      
+      study->Image = reader->GetOutput();
+      study->Image->DisconnectPipeline();
+      
+      study->Session = SessionType::New();
+      study->Session->SetImage( study->Image );
+    }
+};
+
+
+/** Computes the medialness and its scales, and detects the seeds on them. */
+class DetectionStage : public FusedStage
+{
+public:
+
+  typedef DetectionStage                  Self;
+  typedef FusedStage                      Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+
+protected:
+
+  virtual void ProcessStudy( FusedStudy *study )
+    {
+      MedialnessFilterType::Pointer medialnessFilter = MedialnessFilterType::New();
+      medialnessFilter->SetInput( study->Image );
+      medialnessFilter->SetScales( m_Settings->NumberOfScales, m_Settings->MinimumScale, 
+        m_Settings->MaximumScale );
+      medialnessFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+      medialnessFilter->Update();
+      
+      study->Vesselness = medialnessFilter->GetOutput();
+      study->Vesselness->DisconnectPipeline();
+      study->Scales = medialnessFilter->GetOutputScales();
+      study->Scales->DisconnectPipeline();
+      
+      medialnessFilter = 0;
+      
+      if( m_Settings->WriteVesselness )
+      {
+        typedef itk::ImageFileWriter<ImageType>       WriterType;
+        typedef itk::ImageFileWriter<ScaleImageType>  ScaleWriterType;
+        
+        WriterType::Pointer writer = WriterType::New();
+        writer->SetFileName( study->OutputPrefix + "_vesselness.mha" );
+        writer->SetInput( study->Vesselness );
+        writer->Update();
+        
+        ScaleWriterType::Pointer scaleWriter = ScaleWriterType::New();
+        scaleWriter->SetFileName( study->OutputPrefix + "_scales.mha" );
+        scaleWriter->SetInput( study->Scales );
+        scaleWriter->Update();
+      }
+      
+      SeedDetectorType::Pointer seedDetector = SeedDetectorType::New();
+      seedDetector->SetInput( study->Vesselness );
+      seedDetector->SetScaleImage( study->Scales );
+      seedDetector->SetLowerThreshold( m_Settings->SeedThreshold );
+      seedDetector->SetMaximumNumberOfSeeds( m_Settings->MaximumNumberOfSeeds );
+      seedDetector->SetNumberOfThreads( this->GetNumberOfThreads() );
+      seedDetector->Update();
+      
+      study->Seeds = seedDetector->GetSeedPoints();
+      
+      // The scales are kept for the section estimators
+      study->Vesselness = 0;
+    }
+};
+
+
+/** Creates the tracker of each seed on the session of the study. */
+class TrackerFactory : public TrackerFactoryBaseType
+{
+public:
+
+  typedef TrackerFactory                  Self;
+  typedef TrackerFactoryBaseType          Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+  
+  virtual Superclass::TrackerPointer CreateTracker( unsigned int )
+    {
+      Superclass::TrackerPointer tracker = VesselTrackerType::New();
+      
+      // All the trackers share the functions initialized at each scale
+      SectionEstimatorType::Pointer sectionEstimator = SectionEstimatorType::New();
+      sectionEstimator->SetImage( m_Study->Image );
+      sectionEstimator->SetScaleImage( m_Study->Scales );
+      sectionEstimator->SetMinimumScale( m_Settings->MinimumScale );
+      sectionEstimator->SetMaximumScale( m_Settings->MaximumScale );
+      sectionEstimator->SetNumberOfScales( m_Settings->NumberOfScales );
+      sectionEstimator->SetScaleStepMethodToEquispaced();
+      sectionEstimator->SetScaledImageFunctionCache( 
+        m_Study->Session->GetScaledImageFunctionCache<ScaledImageFunctionType>() );
+      tracker->SetSectionEstimator( sectionEstimator );
+      
+      ivan::MaxIterationsVesselTrackerEndCondition::Pointer maxIterations = 
+        ivan::MaxIterationsVesselTrackerEndCondition::New();
+      maxIterations->SetMaxIterations( m_Settings->MaxIterations );
+      
+      RegionEndConditionType::Pointer region = RegionEndConditionType::New();
+      region->SetImage( m_Study->Image );
+      
+      CollisionEndConditionType::Pointer collision = CollisionEndConditionType::New();
+      collision->SetSpatialIndex( m_Study->Session->GetSpatialIndex() );
+      collision->SetMutex( m_Study->Session->GetSpatialIndexMutex() );
+      
+      ivan::CompositeVesselTrackerEndCondition::Pointer endCondition = 
+        ivan::CompositeVesselTrackerEndCondition::New();
+      endCondition->AddEndCondition( maxIterations );
+      endCondition->AddEndCondition( region );
+      endCondition->AddEndCondition( collision );
+      tracker->SetEndCondition( endCondition.GetPointer() );
+      
+      tracker->SetBidirectional( true );
+      
+      return tracker;
+    }
+  
+  FusedStudy               *m_Study;
+  const PipelineSettings   *m_Settings;
+
+protected:
+
+  TrackerFactory() : m_Study( 0 ), m_Settings( 0 ) {}
+};
+
+
+/** Tracks the vessels from the detected seeds. */
+class TrackingStage : public FusedStage
+{
+public:
+
+  typedef TrackingStage                   Self;
+  typedef FusedStage                      Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+
+protected:
+
+  virtual void ProcessStudy( FusedStudy *study )
+    {
+      TrackerFactory::Pointer factory = TrackerFactory::New();
+      factory->m_Study = study;
+      factory->m_Settings = m_Settings;
+      
+      MultiSeedTrackerType::Pointer tracker = MultiSeedTrackerType::New();
+      tracker->SetInput( study->Image );
+      tracker->SetTrackerFactory( factory );
+      tracker->SetSeeds( study->Seeds );
+      tracker->SetNumberOfThreads( this->GetNumberOfThreads() );
+      tracker->Update();
+      
+      study->Graph = tracker->GetOutput();
+      
+      // Nothing but the graph is needed from here on
+      study->Image = 0;
+      study->Scales = 0;
+      study->Seeds.clear();
+      study->Session = 0;
+    }
+};
+
+
+/** Measures the tracked graph on a frozen copy. */
+class QuantificationStage : public FusedStage
+{
+public:
+
+  typedef QuantificationStage             Self;
+  typedef FusedStage                      Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+
+protected:
+
+  virtual void ProcessStudy( FusedStudy *study )
+    {
+      FrozenGraphType::Pointer frozenGraph = FrozenGraphType::New();
+      frozenGraph->Freeze( study->Graph );
+      
+      QuantifierType::Pointer quantifier = QuantifierType::New();
+      quantifier->SetFrozenGraph( frozenGraph );
+      quantifier->SetNumberOfThreads( this->GetNumberOfThreads() );
+      quantifier->Compute();
+      
+      study->NumberOfBranches = quantifier->GetNumberOfBranches();
+      study->NumberOfBifurcations = quantifier->GetNumberOfBifurcations();
+      study->TotalLength = quantifier->GetTotalLength();
+      study->TotalVolume = quantifier->GetTotalVolume();
+      study->MeanTortuosity = quantifier->GetMeanTortuosity();
+      study->MaximumBifurcationAngle = quantifier->GetMaximumBifurcationAngle();
+    }
+};
+
+
+/** Writes the graph and appends the measurements of the study. */
+class ExportStage : public FusedStage
+{
+public:
+
+  typedef ExportStage                     Self;
+  typedef FusedStage                      Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  
+  itkNewMacro( Self );
+
+protected:
+
+  virtual void ProcessStudy( FusedStudy *study )
+    {
+      typedef ivan::VesselGraphBinaryWriter<CenterlineType>  GraphWriterType;
+      
+      GraphWriterType::Pointer writer = GraphWriterType::New();
+      writer->SetFileName( study->OutputPrefix + ".ivg" );
+      writer->SetInput( study->Graph );
+      writer->SetCompressSections( m_Settings->CompressSections );
+      writer->Write();
+      
+      study->Graph = 0;
+      
+      // The stage processes one study at a time, so the lines are not interleaved
+      if( !m_Settings->MeasurementsFileName.empty() )
+      {
+        std::ofstream measurements( m_Settings->MeasurementsFileName.c_str(), std::ios::app );
+        
+        if( !measurements.is_open() )
+          itkGenericExceptionMacro( "Could not open " << m_Settings->MeasurementsFileName );
+        
+        measurements << study->GetName() << "\t" << study->NumberOfBranches << "\t" 
+                     << study->NumberOfBifurcations << "\t" << study->TotalLength << "\t" 
+                     << study->TotalVolume << "\t" << study->MeanTortuosity << "\t" 
+                     << study->MaximumBifurcationAngle << std::endl;
+      }
+    }
+};
+
+
+bool ReadParameters( const char *fileName, ParameterMapType & parameters )
+{
+  std::ifstream filein( fileName );
+  
+  if( !filein.is_open() )
+    return false;
+  
+  std::string line;
+  
+  while( std::getline( filein, line ) )
+  {
+    std::istringstream lineStream( line );
+    std::string name, value;
+    
+    if( !( lineStream >> name ) || name[0] == '#' )
+      continue;
+    
+    std::vector<std::string> & values = parameters[name];
+    values.clear();
+    
+    while( lineStream >> value && value[0] != '(' )
+      values.push_back( value );
+  }
+  
+  return true;
+}
+
+
+template <class T>
+std::vector<T> GetValues( const ParameterMapType & parameters, const std::string & name, T defaultValue )
+{
+  std::vector<T> values;
+  
+  ParameterMapType::const_iterator it = parameters.find( name );
+  
+  if( it != parameters.end() )
+  {
+    for( unsigned int i=0; i<it->second.size(); ++i )
+    {
+      std::istringstream valueStream( it->second[i] );
+      T value;
+      if( valueStream >> value )
+        values.push_back( value );
+    }
+  }
+  
+  if( values.empty() )
+    values.push_back( defaultValue );
+    
+  return values;
+}
+
+
+/** Memory a study takes in the pipeline, from the size in the header of its input. */
+unsigned long EstimateMemory( const std::string & fileName, double memoryPerPixel )
+{
+  itk::ImageIOBase::Pointer imageIO = 
+    itk::ImageIOFactory::CreateImageIO( fileName.c_str(), itk::ImageIOFactory::ReadMode );
+  
+  if( !imageIO )
+    return 0;
+  
+  try
+  {
+    imageIO->SetFileName( fileName );
+    imageIO->ReadImageInformation();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    return 0; // the reading stage reports the error
+  }
+  
+  return static_cast<unsigned long>( memoryPerPixel * imageIO->GetImageSizeInPixels() );
+}
+
+
+int main( int argc, char *argv[] )
+{
+  if( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " ParameterFile" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  ParameterMapType parameters;
+  
+  if( !ReadParameters( argv[1], parameters ) )
+  {
+    std::cerr << "Could not read the parameter file " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  const std::vector<std::string> inputs = GetValues<std::string>( parameters, "Input", "" );
+  const std::vector<std::string> outputs = GetValues<std::string>( parameters, "Output", "" );
+  
+  if( inputs[0].empty() )
+  {
+    std::cerr << "No Input studies given" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  PipelineSettings settings;
+  settings.MinimumScale = GetValues<double>( parameters, "MinimumScale", 1.0 )[0];
+  settings.MaximumScale = GetValues<double>( parameters, "MaximumScale", 6.0 )[0];
+  settings.NumberOfScales = vnl_math_max( GetValues<unsigned int>( parameters, "NumberOfScales", 6 )[0], 2u );
+  settings.SeedThreshold = GetValues<double>( parameters, "SeedThreshold", 20.0 )[0];
+  settings.MaximumNumberOfSeeds = GetValues<unsigned int>( parameters, "MaximumNumberOfSeeds", 50 )[0];
+  settings.MaxIterations = GetValues<unsigned int>( parameters, "MaxIterations", 500 )[0];
+  settings.CompressSections = GetValues<int>( parameters, "CompressSections", 0 )[0] != 0;
+  settings.WriteVesselness = GetValues<int>( parameters, "WriteVesselness", 0 )[0] != 0;
+  settings.MeasurementsFileName = GetValues<std::string>( parameters, "Measurements", "" )[0];
+  
+  const unsigned int numberOfThreads = GetValues<unsigned int>( parameters, "NumberOfThreads",
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads() )[0];
+  const unsigned int stageThreads = vnl_math_max( numberOfThreads / 2, 1u );
+  const double memoryBudget = GetValues<double>( parameters, "MemoryBudget", 0.0 )[0];
+  const double memoryPerPixel = GetValues<double>( parameters, "MemoryPerPixel", 64.0 )[0];
+  
+  if( !settings.MeasurementsFileName.empty() )
+  {
+    std::ofstream measurements( settings.MeasurementsFileName.c_str() );
+    measurements << "Study\tBranches\tBifurcations\tLength\tVolume\tMeanTortuosity\t"
+                 << "MaximumBifurcationAngle" << std::endl;
+  }
+  
+  ReadStage::Pointer readStage = ReadStage::New();
+  readStage->SetName( "Read" );
+  readStage->SetMaximumConcurrency( 1 );
+  
+  DetectionStage::Pointer detectionStage = DetectionStage::New();
+  detectionStage->SetName( "Detect" );
+  detectionStage->SetNumberOfThreads( 
+    GetValues<unsigned int>( parameters, "DetectionThreads", stageThreads )[0] );
+  
+  TrackingStage::Pointer trackingStage = TrackingStage::New();
+  trackingStage->SetName( "Track" );
+  trackingStage->SetNumberOfThreads( 
+    GetValues<unsigned int>( parameters, "TrackingThreads", stageThreads )[0] );
+  
+  QuantificationStage::Pointer quantificationStage = QuantificationStage::New();
+  quantificationStage->SetName( "Quantify" );
+  quantificationStage->SetNumberOfThreads( 
+    GetValues<unsigned int>( parameters, "QuantificationThreads", 1 )[0] );
+  
+  ExportStage::Pointer exportStage = ExportStage::New();
+  exportStage->SetName( "Export" );
+  exportStage->SetMaximumConcurrency( 1 );
+  
+  FusedStage * stages[] = { readStage, detectionStage, trackingStage, quantificationStage, 
+    exportStage };
+  
+  PipelineType::Pointer pipeline = PipelineType::New();
+  pipeline->SetNumberOfThreads( numberOfThreads );
+  pipeline->SetMemoryBudget( static_cast<unsigned long>( memoryBudget * 1024.0 * 1024.0 ) );
+  
+  for( unsigned int i=0; i<5; ++i )
+  {
+    stages[i]->SetSettings( &settings );
+    pipeline->AddStage( stages[i] );
+  }
+  
+  std::vector<FusedStudy::Pointer> studies;
+  
+  for( unsigned int i=0; i<inputs.size(); ++i )
+  {
+    FusedStudy::Pointer study = FusedStudy::New();
+    study->InputFileName = inputs[i];
+    
+    if( i < outputs.size() && !outputs[i].empty() )
+      study->OutputPrefix = outputs[i];
+    else
+      study->OutputPrefix = inputs[i].substr( 0, inputs[i].find_last_of( '.' ) );
+    
+    study->SetName( study->OutputPrefix );
+    study->SetMemoryEstimate( EstimateMemory( inputs[i], memoryPerPixel ) );
+    
+    pipeline->Submit( study );
+    studies.push_back( study );
+  }
+  
+  pipeline->Wait();
+  
+  for( unsigned int i=0; i<studies.size(); ++i )
+  {
+    std::cout << studies[i]->GetName() << ": ";
+    
+    if( studies[i]->GetFailed() )
+      std::cout << "failed, " << studies[i]->GetErrorDescription() << std::endl;
+    else
+      std::cout << studies[i]->NumberOfBranches << " branches in " 
+                << studies[i]->GetLatency() << " s" << std::endl;
+  }
+  
+  std::cout << "Studies: " << pipeline->GetNumberOfFinishedStudies() << ", failed: " 
+            << pipeline->GetNumberOfFailedStudies() << ", peak memory: " 
+            << pipeline->GetPeakReservedMemory() / ( 1024 * 1024 ) << " MB" << std::endl;
+  
+  return ( pipeline->GetNumberOfFailedStudies() > 0 ) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -37,7 +37,8 @@ SUCH DAMAGE.
 #include "itkImageRegionIterator.h"
 
 #include "itkCastImageFilter.h"
-#include "itkImageToVTKImageFilter.h"
+#include "itkImageToVTKImageBridge.h"
+#include "ivanIncrementalCenterlinePolyDataBuilder.h"
 #include "itkMinimumMaximumImageCalculator.h"
 #include "itkGradientMagnitudeRecursiveGaussianImageFilter.h"
 #include "itkHessianRecursiveGaussianImageFilter.h"
@@ -96,7 +97,7 @@ int main( int argc, char *argv[] )
  	typedef itk::ImageFileReader<ImageType>  							  ReaderType;
  	 	
  	// Filter types
- 	typedef itk::ImageToVTKImageFilter<VolumeImageType>			ITKToVTKImageAdapterType;
+ 	typedef itk::ImageToVTKImageBridge<VolumeImageType>			ITKToVTKImageAdapterType;
  	typedef itk::CastImageFilter<ImageType,VolumeImageType>	CastFilterType;
  	typedef itk::MinimumMaximumImageCalculator<ImageType>	  MinMaxCalculatorType;
  	
@@ -326,6 +327,13 @@ int main( int argc, char *argv[] )
 	renderer->AddActor( planeActor );
   renderer->LightFollowCameraOn();
   renderer->TwoSidedLightingOn();
+  
+  // Centerline, appended section by section as a live tracker would feed it
+  ivan::IncrementalCenterlinePolyDataBuilder centerlineBuilder;
+  centerlineBuilder.SetRenderer( renderer );
+  
+  for( unsigned int i=0; i<centers.size(); ++i )
+    centerlineBuilder.AppendSection( centers[i].GetDataPointer(), normals[i].GetDataPointer(), 0.0 );
   	
 	/*PlaneCollectionType::const_iterator it;
 
@@ -0,0 +1,261 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanIncrementalCenterlinePolyDataBuilder.cxx
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: builds the polydata of a centerline incrementally while its sections are tracked
+// Date: 2012/11/05
+
+
+#include "ivanIncrementalCenterlinePolyDataBuilder.h"
+
+#include "vtkPointData.h"
+#include "vtkPolyDataMapper.h"
+#include "vtkActor.h"
+#include "vtkProperty.h"
+#include "vtkAppendPolyData.h"
+
+namespace ivan
+{
+
+IncrementalCenterlinePolyDataBuilder::IncrementalCenterlinePolyDataBuilder( vtkIdType chunkSize ) :
+  m_ChunkSize( chunkSize < 2 ? 2 : chunkSize ),
+  m_Renderer( 0 ),
+  m_NumberOfSections( 0 )
+{
+  m_Color[0] = 0.0;
+  m_Color[1] = 1.0;
+  m_Color[2] = 0.0;
+  
+  m_StrandEnds[0].Valid = false;
+  m_StrandEnds[1].Valid = false;
+}
+
+
+IncrementalCenterlinePolyDataBuilder::~IncrementalCenterlinePolyDataBuilder()
+{
+  this->Clear();
+  
+  if( m_Renderer )
+    m_Renderer->UnRegister( 0 );
+}
+
+
+void IncrementalCenterlinePolyDataBuilder::SetRenderer( vtkRenderer *renderer )
+{
+  if( renderer == m_Renderer )
+    return;
+  
+  for( unsigned int i=0; i<m_Chunks.size(); ++i )
+  {
+    if( m_Renderer )
+      m_Renderer->RemoveActor( m_Chunks[i].Actor );
+    if( renderer )
+      renderer->AddActor( m_Chunks[i].Actor );
+  }
+  
+  if( renderer )
+    renderer->Register( 0 );
+  if( m_Renderer )
+    m_Renderer->UnRegister( 0 );
+    
+  m_Renderer = renderer;
+}
+
+
+void IncrementalCenterlinePolyDataBuilder::SetColor( double r, double g, double b )
+{
+  m_Color[0] = r;
+  m_Color[1] = g;
+  m_Color[2] = b;
+  
+  for( unsigned int i=0; i<m_Chunks.size(); ++i )
+    m_Chunks[i].Actor->GetProperty()->SetColor( m_Color );
+}
+
+
+void IncrementalCenterlinePolyDataBuilder::AppendSection( const double center[3], const double normal[3], 
+  double radius, unsigned int strand )
+{
+  StrandEnd & strandEnd = m_StrandEnds[strand ? 1 : 0];
+  
+  // The second strand starts at the seed, which is the first point of the first one
+  if( !strandEnd.Valid && strand && m_StrandEnds[0].Valid )
+  {
+    strandEnd.Valid = true;
+    strandEnd.ChunkIndex = 0;
+    strandEnd.PointId = 0;
+    m_Chunks[0].Points->GetPoint( 0, strandEnd.Center );
+    m_Chunks[0].Normals->GetTuple( 0, strandEnd.Normal );
+    strandEnd.Radius = m_Chunks[0].Radii->GetValue( 0 );
+  }
+  
+  // Room for the point, and for a copy of the strand end if the line continues from another chunk
+  if( m_Chunks.empty() || m_Chunks.back().Points->GetNumberOfPoints() + 2 > m_ChunkSize )
+    this->AddChunk();
+    
+  Chunk & chunk = m_Chunks.back();
+  const unsigned int chunkIndex = m_Chunks.size() - 1;
+  
+  if( strandEnd.Valid && strandEnd.ChunkIndex != chunkIndex )
+  {
+    strandEnd.PointId = this->InsertPoint( strandEnd.Center, strandEnd.Normal, strandEnd.Radius );
+    strandEnd.ChunkIndex = chunkIndex;
+  }
+  
+  const vtkIdType pointId = this->InsertPoint( center, normal, radius );
+  
+  if( strandEnd.Valid )
+  {
+    vtkIdType line[2] = { strandEnd.PointId, pointId };
+    chunk.Lines->InsertNextCell( 2, line );
+    chunk.Lines->Modified();
+  }
+  
+  strandEnd.Valid = true;
+  strandEnd.ChunkIndex = chunkIndex;
+  strandEnd.PointId = pointId;
+  strandEnd.Radius = radius;
+  
+  for( unsigned int i=0; i<3; ++i )
+  {
+    strandEnd.Center[i] = center[i];
+    strandEnd.Normal[i] = normal[i];
+  }
+  
+  // Only this chunk is modified, the rest keep their cached geometry
+  chunk.PolyData->Modified();
+  
+  ++m_NumberOfSections;
+}
+
+
+void IncrementalCenterlinePolyDataBuilder::Clear()
+{
+  for( unsigned int i=0; i<m_Chunks.size(); ++i )
+  {
+    if( m_Renderer )
+      m_Renderer->RemoveActor( m_Chunks[i].Actor );
+      
+    m_Chunks[i].Actor->Delete();
+    m_Chunks[i].PolyData->Delete();
+    m_Chunks[i].Points->Delete();
+    m_Chunks[i].Lines->Delete();
+    m_Chunks[i].Normals->Delete();
+    m_Chunks[i].Radii->Delete();
+  }
+  
+  m_Chunks.clear();
+  m_NumberOfSections = 0;
+  m_StrandEnds[0].Valid = false;
+  m_StrandEnds[1].Valid = false;
+}
+
+
+vtkPolyData * IncrementalCenterlinePolyDataBuilder::CreateMergedPolyData() const
+{
+  vtkAppendPolyData *append = vtkAppendPolyData::New();
+  
+  for( unsigned int i=0; i<m_Chunks.size(); ++i )
+  {
+#if VTK_MAJOR_VERSION < 6
+    append->AddInput( m_Chunks[i].PolyData );
+#else // VTK_MAJOR_VERSION < 6
+    append->AddInputData( m_Chunks[i].PolyData );
+#endif // VTK_MAJOR_VERSION < 6
+  }
+  
+  append->Update();
+  
+  vtkPolyData *merged = vtkPolyData::New();
+  merged->DeepCopy( append->GetOutput() );
+  
+  append->Delete();
+  
+  return merged;
+}
+
+
+void IncrementalCenterlinePolyDataBuilder::AddChunk()
+{
+  Chunk chunk;
+  
+  chunk.Points = vtkPoints::New();
+  chunk.Points->SetDataTypeToDouble();
+  chunk.Points->Allocate( m_ChunkSize );
+  
+  chunk.Lines = vtkCellArray::New();
+  chunk.Lines->Allocate( chunk.Lines->EstimateSize( m_ChunkSize, 2 ) );
+  
+  chunk.Normals = vtkDoubleArray::New();
+  chunk.Normals->SetName( "Normals" );
+  chunk.Normals->SetNumberOfComponents( 3 );
+  chunk.Normals->Allocate( 3 * m_ChunkSize );
+  
+  chunk.Radii = vtkDoubleArray::New();
+  chunk.Radii->SetName( "Radius" );
+  chunk.Radii->Allocate( m_ChunkSize );
+  
+  chunk.PolyData = vtkPolyData::New();
+  chunk.PolyData->SetPoints( chunk.Points );
+  chunk.PolyData->SetLines( chunk.Lines );
+  chunk.PolyData->GetPointData()->SetNormals( chunk.Normals );
+  chunk.PolyData->GetPointData()->SetScalars( chunk.Radii );
+  
+  vtkPolyDataMapper *mapper = vtkPolyDataMapper::New();
+#if VTK_MAJOR_VERSION < 6
+  mapper->SetInput( chunk.PolyData );
+#else // VTK_MAJOR_VERSION < 6
+  mapper->SetInputData( chunk.PolyData );
+#endif // VTK_MAJOR_VERSION < 6
+  mapper->ScalarVisibilityOff();
+  
+  chunk.Actor = vtkActor::New();
+  chunk.Actor->SetMapper( mapper );
+  chunk.Actor->GetProperty()->SetColor( m_Color );
+  chunk.Actor->GetProperty()->SetLineWidth( 2.0 );
+  mapper->Delete();
+  
+  if( m_Renderer )
+    m_Renderer->AddActor( chunk.Actor );
+  
+  m_Chunks.push_back( chunk );
+}
+
+
+vtkIdType IncrementalCenterlinePolyDataBuilder::InsertPoint( const double center[3], const double normal[3], 
+  double radius )
+{
+  Chunk & chunk = m_Chunks.back();
+  
+  const vtkIdType pointId = chunk.Points->InsertNextPoint( center );
+  chunk.Normals->InsertNextTuple( normal );
+  chunk.Radii->InsertNextValue( radius );
+  
+  chunk.Points->Modified();
+  
+  return pointId;
+}
+
+} // end namespace ivan
@@ -0,0 +1,171 @@
+/*=========================================================================
+
+Image-based Vascular Analysis Toolkit (IVAN)
+
+Copyright (c) 2012, Iván Macía Oliver
+Vicomtech Foundation, San Sebastián - Donostia (Spain)
+University of the Basque Country, San Sebastián - Donostia (Spain)
+
+All rights reserved
+
+See LICENSE file for license details
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+IMPLIED WARRANTIES SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR 
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+SUCH DAMAGE.
+
+==========================================================================*/
+// File: ivanIncrementalCenterlinePolyDataBuilder.h
+// Author: Iv�n Mac�a (imacia@vicomtech.org)
+// Description: builds the polydata of a centerline incrementally while its sections are tracked
+// Date: 2012/11/05
+
+
+#ifndef __ivanIncrementalCenterlinePolyDataBuilder_h_
+#define __ivanIncrementalCenterlinePolyDataBuilder_h_
+
+#include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkRenderer.h"
+
+#include <vector>
+
+class vtkActor;
+
+namespace ivan
+{
+  
+/** \class IncrementalCenterlinePolyDataBuilder
+ *  \brief Builds a centerline polydata as sections arrive from a tracker.
+ *
+ * Each section adds a point, with its normal and radius as point data, and a line cell 
+ * joining it to the previous point of the same strand. The two directions of a 
+ * bidirectional tracking are two strands starting at the seed.
+ *
+ * Points are stored in chunks of ChunkSize points, each one a vtkPolyData with 
+ * preallocated storage and its own actor. Only the last chunk is marked as modified when 
+ * a section is appended, so the mappers of previous chunks keep their cached geometry and 
+ * the rendering cost per new section does not grow with the length of the centerline.
+ *
+ * The builder is not thread safe. Sections tracked asynchronously should be drained from 
+ * the tracker queue on the rendering thread (see AppendQueuedSections()).
+ */
+class IncrementalCenterlinePolyDataBuilder
+{
+public:
+
+  IncrementalCenterlinePolyDataBuilder( vtkIdType chunkSize = 512 );
+  ~IncrementalCenterlinePolyDataBuilder();
+  
+  /** Set the renderer where the actors of the chunks are added. Can be NULL. */
+  void SetRenderer( vtkRenderer *renderer );
+  
+  /** Set the color of the line actors. */
+  void SetColor( double r, double g, double b );
+  
+  /** Append a section to the given strand (0 or 1). */
+  void AppendSection( const double center[3], const double normal[3], double radius, 
+    unsigned int strand = 0 );
+  
+  /** Drain the tracked section queue of a VesselTrackerFilter with StreamSections on, 
+    * appending the sections of the second direction to strand 1. Returns the number of 
+    * appended sections. Sections must provide GetCenter(), GetNormal() and GetRadius(). */
+  template <class TTracker>
+  unsigned int AppendQueuedSections( TTracker *tracker );
+  
+  /** Remove all the sections and actors. */
+  void Clear();
+  
+  /** Number of appended sections. */
+  vtkIdType GetNumberOfSections() const
+    { return m_NumberOfSections; }
+  
+  unsigned int GetNumberOfChunks() const
+    { return m_Chunks.size(); }
+  vtkPolyData * GetChunk( unsigned int i ) const
+    { return m_Chunks[i].PolyData; }
+  
+  /** Build a single polydata with all the chunks, for example for writing. The caller 
+    * owns the returned polydata. */
+  vtkPolyData * CreateMergedPolyData() const;
+
+protected:
+
+  struct Chunk
+  {
+    vtkPolyData      *PolyData;
+    vtkPoints        *Points;
+    vtkCellArray     *Lines;
+    vtkDoubleArray   *Normals;
+    vtkDoubleArray   *Radii;
+    vtkActor         *Actor;
+  };
+  
+  /** Add a new chunk with preallocated storage. */
+  void AddChunk();
+  
+  /** Insert a point in the last chunk, which must have room for it. */
+  vtkIdType InsertPoint( const double center[3], const double normal[3], double radius );
+
+private:
+
+  IncrementalCenterlinePolyDataBuilder( const IncrementalCenterlinePolyDataBuilder & ); //purposely not implemented
+  void operator=( const IncrementalCenterlinePolyDataBuilder & );                      //purposely not implemented
+
+  vtkIdType            m_ChunkSize;
+  std::vector<Chunk>   m_Chunks;
+  vtkRenderer         *m_Renderer;
+  double               m_Color[3];
+  vtkIdType            m_NumberOfSections;
+  
+  /** Last point of each strand, used to continue the line across chunks. */
+  struct StrandEnd
+  {
+    bool         Valid;
+    unsigned int ChunkIndex;
+    vtkIdType    PointId;
+    double       Center[3];
+    double       Normal[3];
+    double       Radius;
+  };
+  
+  StrandEnd   m_StrandEnds[2];
+};
+
+
+template <class TTracker>
+unsigned int IncrementalCenterlinePolyDataBuilder::AppendQueuedSections( TTracker *tracker )
+{
+  typename TTracker::TrackedSection trackedSection;
+  double center[3], normal[3];
+  unsigned int numberOfSections = 0;
+  
+  while( tracker->PopTrackedSection( trackedSection ) )
+  {
+    for( unsigned int i=0; i<3; ++i )
+    {
+      center[i] = trackedSection.Section->GetCenter()[i];
+      normal[i] = trackedSection.Section->GetNormal()[i];
+    }
+    
+    this->AppendSection( center, normal, trackedSection.Section->GetRadius(), 
+      trackedSection.SecondDirection ? 1 : 0 );
+      
+    ++numberOfSections;
+  }
+  
+  return numberOfSections;
+}
+
+} // end namespace ivan
+
+#endif